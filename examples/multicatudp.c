@@ -89,13 +89,14 @@
 #define MAX_SINK_BUFFER 2000000000 /* 2GB */
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d] [-r <rotate>] [-O <rotate offset>] [-R <read-ahead>] [-k <start>] (-m <MTU>] [-l <syslog ident>] <source dir/prefix> <data suffix> <aux suffix> <destination>\n", argv0);
+    fprintf(stdout, "Usage: %s [-d] [-r <rotate>] [-O <rotate offset>] [-R <read-ahead>] [-k <start>] (-m <MTU>] [-l <syslog ident>] [-x <index file>] <source dir/prefix> <data suffix> <aux suffix> <destination>\n", argv0);
     fprintf(stdout, "   -d: force debug log level\n");
     fprintf(stdout, "   -r: rotate interval in 27MHz unit\n");
     fprintf(stdout, "   -O: rotate offset in 27MHz unit\n");
     fprintf(stdout, "   -R: read-ahead in 27MHz unit\n");
     fprintf(stdout, "   -k: start time in 27MHz unit\n");
     fprintf(stdout, "   -m: data packet size\n");
+    fprintf(stdout, "   -x: time index of the data files\n");
     exit(EXIT_FAILURE);
 }
 
@@ -119,6 +120,7 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 int main(int argc, char *argv[])
 {
     const char *syslog_ident = NULL;
+    const char *index_file = NULL;
     const char *dstpath, *dirpath, *data, *aux;
     uint64_t rotate = DEFAULT_ROTATE;
     uint64_t rotate_offset = DEFAULT_ROTATE_OFFSET;
@@ -130,7 +132,7 @@ int main(int argc, char *argv[])
     enum uprobe_log_level loglevel = UPROBE_LOG_LEVEL;
 
     /* parse options */
-    while ((opt = getopt(argc, argv, "r:O:R:k:m:l:i:d")) != -1) {
+    while ((opt = getopt(argc, argv, "r:O:R:k:m:l:i:x:d")) != -1) {
         switch (opt) {
             case 'r':
                 rotate = strtoull(optarg, NULL, 0);
@@ -156,6 +158,9 @@ int main(int argc, char *argv[])
             case 'i':
                 rt_priority = strtol(optarg, NULL, 0);
                 break;
+            case 'x':
+                index_file = optarg;
+                break;
             default:
                 usage(argv[0]);
         }
@@ -298,6 +303,8 @@ int main(int argc, char *argv[])
     uref_msrc_flow_set_aux(flow, aux);
     uref_msrc_flow_set_rotate(flow, rotate);
     uref_msrc_flow_set_offset(flow, rotate_offset);
+    if (index_file != NULL)
+        uref_msrc_flow_set_index(flow, index_file);
     uint64_t now = uclock_now(uclock);
     if (start < 0)
         start += now;
@@ -66,6 +66,7 @@
 #define UPUMP_POOL 10
 #define UPUMP_BLOCKER_POOL 10
 #define READ_SIZE 4096
+#define MAX_PATHS 4
 
 static enum uprobe_log_level loglevel = UPROBE_LOG_DEBUG;
 
@@ -73,10 +74,6 @@ static struct upipe_mgr *udp_sink_mgr;
 static struct upump_mgr *upump_mgr;
 
 static struct upipe *upipe_rtpfb;
-static struct upipe *upipe_rtpfb_sub;
-static struct upipe *upipe_udpsrc;
-static struct upipe *upipe_udpsrc_rtcp;
-static struct upipe *upipe_dup;
 
 struct rtcp_sink {
     struct upipe *dup_sub;
@@ -85,14 +82,27 @@ struct rtcp_sink {
     struct upump *timeout;
 };
 
-static struct rtcp_sink rtcp_sink[2];
+/** network path the stream is received on */
+struct rist_path {
+    /** probe catching the RTCP peers */
+    struct uprobe uprobe_udp;
+    struct upipe *upipe_udpsrc;
+    struct upipe *upipe_udpsrc_rtcp;
+    struct upipe *upipe_rtpfb_sub;
+    struct upipe *upipe_dup;
+    struct rtcp_sink rtcp_sink[2];
+    struct rtcp_sink *last_peer;
+    int udp_fd;
+};
 
-static int udp_fd = -1;
+static struct rist_path paths[MAX_PATHS];
+static unsigned int nb_paths = 0;
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d]  <udp source> <udp dest> <latency>", argv0);
+    fprintf(stdout, "Usage: %s [-d] [-b <udp source>]... <udp source> <udp dest> <latency>", argv0);
     fprintf(stdout, "   -d: more verbose\n");
     fprintf(stdout, "   -q: more quiet\n");
+    fprintf(stdout, "   -b: receive the stream on an additional bonded path\n");
     exit(EXIT_FAILURE);
 }
 
@@ -123,6 +133,20 @@ static void gather_stats(struct upipe *upipe, struct uref *uref)
     unsigned nack_overflow = (repairs && repairs < nacks) ? (nacks - repairs ) * 100 / repairs : 0;
     upipe_notice_va(upipe, "%5u (%3zu) %5u\t%zu repairs %zu NACKS (%u%% too much)\tlost %zu\tduplicates %zu",
             last_output_seqnum, buffers, expected_seqnum, repairs, nacks, nack_overflow, loss, dups);
+
+    if (nb_paths < 2)
+        return;
+
+    for (unsigned int i = 0; i < nb_paths; i++) {
+        size_t packets;
+        uint64_t rtt;
+        if (unlikely(!ubase_check(upipe_rtpfb_output_get_stats(
+                            paths[i].upipe_rtpfb_sub,
+                            &packets, &dups, &loss, &rtt))))
+            continue;
+        upipe_notice_va(upipe, "path %u: %zu packets\tlost %zu\tduplicates %zu\tRTT %"PRIu64" ms",
+                i, packets, loss, dups, rtt * 1000 / UCLOCK_FREQ);
+    }
 }
 
 static void sink_timeout(struct upump *upump)
@@ -137,12 +161,12 @@ static void sink_timeout(struct upump *upump)
     sink->dup_sub = NULL;
 }
 
-static struct rtcp_sink *last_peer;
-
 /** definition of our uprobe */
 static int catch_udp(struct uprobe *uprobe, struct upipe *upipe,
                  int event, va_list args)
 {
+    struct rist_path *path = container_of(uprobe, struct rist_path,
+                                          uprobe_udp);
     const char *uri;
     switch (event) {
     case UPROBE_UDPSRC_NEW_PEER: {
@@ -169,23 +193,23 @@ static int catch_udp(struct uprobe *uprobe, struct upipe *upipe,
         upipe_dbg_va(upipe, "Got new remote: %s:%hu ",
                 inet_ntoa(in->sin_addr), ntohs(in->sin_port));
 
-        const size_t n = sizeof(rtcp_sink) / sizeof(*rtcp_sink);
+        const size_t n = sizeof(path->rtcp_sink) / sizeof(*path->rtcp_sink);
         struct rtcp_sink *sink = NULL;
         ssize_t avail = -1; /* index of the free remote */
         for (size_t i = 0; i < n; i++) {
-            if (!rtcp_sink[i].dup_sub) {
+            if (!path->rtcp_sink[i].dup_sub) {
                 if (!sink) {
                     avail = i;
-                    sink = &rtcp_sink[i];
+                    sink = &path->rtcp_sink[i];
                 }
                 continue;
             }
 
-            if (memcmp(&rtcp_sink[i].addr, in, addr_len))
+            if (memcmp(&path->rtcp_sink[i].addr, in, addr_len))
                 continue;
 
             upipe_dbg_va(upipe, "Remote already existing");
-            sink = &rtcp_sink[i];
+            sink = &path->rtcp_sink[i];
             upump_stop(sink->timeout);
             break;
         }
@@ -195,17 +219,17 @@ static int catch_udp(struct uprobe *uprobe, struct upipe *upipe,
             return UBASE_ERR_NONE;
         }
 
-        if (last_peer) /* restart the timeout for the previous peer we got */
-            upump_restart(last_peer->timeout);
+        if (path->last_peer) /* restart the timeout for the previous peer we got */
+            upump_restart(path->last_peer->timeout);
 
         /* keep the timer for this remote stopped for now,
          * this could be the only one we have */
-        last_peer = sink;
+        path->last_peer = sink;
 
         if (sink->dup_sub)
             return UBASE_ERR_NONE;
 
-        sink->dup_sub = upipe_void_alloc_sub(upipe_dup,
+        sink->dup_sub = upipe_void_alloc_sub(path->upipe_dup,
                 uprobe_pfx_alloc_va(uprobe_use(uprobe), loglevel,
                     "dup %zu", avail));
         assert(sink->dup_sub);
@@ -213,7 +237,7 @@ static int catch_udp(struct uprobe *uprobe, struct upipe *upipe,
         struct upipe *rtcp_sink = upipe_void_alloc_output(sink->dup_sub,
                 udp_sink_mgr, uprobe_pfx_alloc_va(uprobe_use(uprobe), loglevel,
                     "udpsink rtpfb %zu", avail));
-        ubase_assert(upipe_udpsink_set_fd(rtcp_sink, dup(udp_fd)));
+        ubase_assert(upipe_udpsink_set_fd(rtcp_sink, dup(path->udp_fd)));
         upipe_release(rtcp_sink);
 
         sink->addr_len = addr_len;
@@ -245,12 +269,16 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
             break;
         case UPROBE_SOURCE_END:
             if (upipe->mgr->signature == UPIPE_DUP_OUTPUT_SIGNATURE) {
-                const size_t n = sizeof(rtcp_sink) / sizeof(*rtcp_sink);
-                for (size_t i = 0; i < n; i++) {
-                    struct rtcp_sink *sink = &rtcp_sink[i];
-                    if (sink->dup_sub == upipe) {
-                        upump_stop(sink->timeout);
-                        sink->dup_sub = NULL;
+                for (unsigned int j = 0; j < nb_paths; j++) {
+                    struct rist_path *path = &paths[j];
+                    const size_t n =
+                        sizeof(path->rtcp_sink) / sizeof(*path->rtcp_sink);
+                    for (size_t i = 0; i < n; i++) {
+                        struct rtcp_sink *sink = &path->rtcp_sink[i];
+                        if (sink->dup_sub == upipe) {
+                            upump_stop(sink->timeout);
+                            sink->dup_sub = NULL;
+                        }
                     }
                 }
             }
@@ -274,17 +302,104 @@ static void stop(struct upump *upump)
     upump_stop(upump);
     upump_free(upump);
 
-    upipe_release(upipe_udpsrc_rtcp);
-    upipe_release(upipe_udpsrc);
+    for (unsigned int i = 0; i < nb_paths; i++) {
+        upipe_release(paths[i].upipe_udpsrc_rtcp);
+        upipe_release(paths[i].upipe_udpsrc);
+    }
+}
+
+/** @This sets up the reception of the stream on a path: RTP on the port of
+ * the source URI, and RTCP on the next one, both feeding a subpipe of the
+ * rtpfb pipe. */
+static int path_init(struct rist_path *path, unsigned int idx,
+                     const char *srcpath, struct uprobe *logger)
+{
+    /* rtp source */
+    struct upipe_mgr *upipe_udpsrc_mgr = upipe_udpsrc_mgr_alloc();
+    path->upipe_udpsrc = upipe_void_alloc(upipe_udpsrc_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                "udp source %u", idx));
+
+    /* rtcp source */
+    uprobe_init(&path->uprobe_udp, catch_udp,
+            uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                "udp rtcp source %u", idx));
+    path->upipe_udpsrc_rtcp = upipe_void_alloc(upipe_udpsrc_mgr,
+            &path->uprobe_udp);
+    upipe_mgr_release(upipe_udpsrc_mgr);
+
+    struct upipe_mgr *upipe_probe_uref_mgr = upipe_probe_uref_mgr_alloc();
+    struct upipe *upipe_probe_uref = upipe_void_alloc_output(
+            path->upipe_udpsrc, upipe_probe_uref_mgr, uprobe_use(logger));
+    assert(upipe_probe_uref);
+    upipe_mgr_release(upipe_probe_uref_mgr);
+
+    path->upipe_rtpfb_sub = upipe_void_alloc_output_sub(
+            path->upipe_udpsrc_rtcp, upipe_rtpfb,
+            uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                "rtpfb_sub %u", idx));
+    assert(path->upipe_rtpfb_sub);
+    ubase_assert(upipe_set_output(upipe_probe_uref, path->upipe_rtpfb_sub));
+    upipe_release(upipe_probe_uref);
+
+    upipe_rtpfb_output_set_name(path->upipe_rtpfb_sub, "Upipe");
+
+    struct upipe_mgr *dup_mgr = upipe_dup_mgr_alloc();
+    path->upipe_dup = upipe_void_alloc_output(path->upipe_rtpfb_sub, dup_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(logger), loglevel,
+                "dup rtpfb_sub %u", idx));
+    assert(path->upipe_dup);
+    upipe_release(path->upipe_dup);
+    upipe_mgr_release(dup_mgr);
+
+    /* receive RTP */
+    if (!ubase_check(upipe_set_uri(path->upipe_udpsrc, srcpath))) {
+        return EXIT_FAILURE;
+    }
+
+    struct ustring u = ustring_from_str(srcpath);
+    struct uuri_authority authority = uuri_parse_authority(&u);
+    struct ustring settings = uuri_parse_path(&u);
+
+    char port_str[6];
+    snprintf(port_str, sizeof(port_str), "%.*s", (int)authority.port.len,
+            authority.port.at);
+    int port = atoi(port_str);
+
+    if (port & 1) {
+        fprintf(stderr, "RTP port should be even\n");
+        return EXIT_FAILURE;
+    }
+
+    char uri[128];
+    snprintf(uri, sizeof(uri), "%.*s@%.*s:%u%.*s",
+        (int)authority.userinfo.len, authority.userinfo.at,
+        (int)authority.host.len, authority.host.at, port + 1,
+        (int)settings.len, settings.at);
+
+    if (!ubase_check(upipe_set_uri(path->upipe_udpsrc_rtcp, uri))) {
+        return EXIT_FAILURE;
+    }
+
+    upipe_attach_uclock(path->upipe_udpsrc);
+    upipe_attach_uclock(path->upipe_udpsrc_rtcp);
+
+    path->udp_fd = -1;
+    ubase_assert(upipe_udpsrc_get_fd(path->upipe_udpsrc_rtcp, &path->udp_fd));
+    assert(path->udp_fd != -1);
+
+    return EXIT_SUCCESS;
 }
 
 int main(int argc, char *argv[])
 {
-    char *dirpath, *latency, *srcpath;
+    char *dirpath, *latency;
+    const char *srcpaths[MAX_PATHS];
     int opt;
 
     /* parse options */
-    while ((opt = getopt(argc, argv, "qd")) != -1) {
+    nb_paths = 1;
+    while ((opt = getopt(argc, argv, "qdb:")) != -1) {
         switch (opt) {
             case 'd':
                 loglevel--;
@@ -292,6 +407,13 @@ int main(int argc, char *argv[])
             case 'q':
                 loglevel++;
                 break;
+            case 'b':
+                if (nb_paths >= MAX_PATHS) {
+                    fprintf(stderr, "Too many paths\n");
+                    exit(EXIT_FAILURE);
+                }
+                srcpaths[nb_paths++] = optarg;
+                break;
             default:
                 usage(argv[0]);
         }
@@ -299,7 +421,7 @@ int main(int argc, char *argv[])
     if (argc - optind < 3) {
         usage(argv[0]);
     }
-    srcpath = argv[optind++];
+    srcpaths[0] = argv[optind++];
     dirpath = argv[optind++];
     latency = argv[optind++];
 
@@ -336,82 +458,19 @@ int main(int argc, char *argv[])
     logger = uprobe_uclock_alloc(logger, uclock);
     assert(logger != NULL);
 
-    /* rtp source */
-    struct upipe_mgr *upipe_udpsrc_mgr = upipe_udpsrc_mgr_alloc();
-    upipe_udpsrc = upipe_void_alloc(upipe_udpsrc_mgr, uprobe_pfx_alloc(uprobe_use(logger),
-                loglevel, "udp source"));
-
-    /* rtcp source */
-    struct uprobe uprobe_udp;
-    uprobe_init(&uprobe_udp, catch_udp, uprobe_pfx_alloc(uprobe_use(logger),
-                loglevel, "udp rtcp source"));
-    upipe_udpsrc_rtcp = upipe_void_alloc(upipe_udpsrc_mgr, &uprobe_udp);
-    upipe_mgr_release(upipe_udpsrc_mgr);
-
-    struct upipe_mgr *upipe_probe_uref_mgr = upipe_probe_uref_mgr_alloc();
-    struct upipe *upipe_probe_uref = upipe_void_alloc_output(upipe_udpsrc,
-            upipe_probe_uref_mgr, uprobe_use(logger));
-    assert(upipe_probe_uref);
-    upipe_mgr_release(upipe_probe_uref_mgr);
-    upipe_release(upipe_probe_uref);
-
+    /* merges and repairs the stream received on all paths */
     struct upipe_mgr *upipe_rtpfb_mgr = upipe_rtpfb_mgr_alloc();
-    upipe_rtpfb = upipe_void_alloc_output(upipe_probe_uref,
-            upipe_rtpfb_mgr,
+    upipe_rtpfb = upipe_void_alloc(upipe_rtpfb_mgr,
             uprobe_pfx_alloc(uprobe_use(logger), loglevel, "rtpfb"));
     upipe_mgr_release(upipe_rtpfb_mgr);
 
-    upipe_rtpfb_sub = upipe_void_alloc_output_sub(upipe_udpsrc_rtcp, upipe_rtpfb,
-            uprobe_pfx_alloc(uprobe_use(logger), loglevel, "rtpfb_sub"));
-    assert(upipe_rtpfb_sub);
-
-    upipe_rtpfb_output_set_name(upipe_rtpfb_sub, "Upipe");
-
-    struct upipe_mgr *dup_mgr = upipe_dup_mgr_alloc();
-    upipe_dup = upipe_void_chain_output(upipe_rtpfb_sub, dup_mgr,
-            uprobe_pfx_alloc(uprobe_use(logger), loglevel, "dup rtpfb_sub"));
-    assert(upipe_dup);
-    upipe_release(upipe_dup);
-    upipe_mgr_release(dup_mgr);
-
     if (!ubase_check(upipe_set_option(upipe_rtpfb, "latency", latency))) {
         return EXIT_FAILURE;
     }
 
-    /* receive RTP */
-    if (!ubase_check(upipe_set_uri(upipe_udpsrc, srcpath))) {
-        return EXIT_FAILURE;
-    }
-
-    struct ustring u = ustring_from_str(srcpath);
-    struct uuri_authority authority = uuri_parse_authority(&u);
-    struct ustring settings = uuri_parse_path(&u);
-
-    char port_str[6];
-    snprintf(port_str, sizeof(port_str), "%.*s", (int)authority.port.len,
-            authority.port.at);
-    int port = atoi(port_str);
-
-    if (port & 1) {
-        fprintf(stderr, "RTP port should be even\n");
-        return EXIT_FAILURE;
-    }
-
-    char uri[128];
-    snprintf(uri, sizeof(uri), "%.*s@%.*s:%u%.*s",
-        (int)authority.userinfo.len, authority.userinfo.at,
-        (int)authority.host.len, authority.host.at, port + 1,
-        (int)settings.len, settings.at);
-
-    if (!ubase_check(upipe_set_uri(upipe_udpsrc_rtcp, uri))) {
-        return EXIT_FAILURE;
-    }
-
-    upipe_attach_uclock(upipe_udpsrc);
-    upipe_attach_uclock(upipe_udpsrc_rtcp);
-
-    ubase_assert(upipe_udpsrc_get_fd(upipe_udpsrc_rtcp, &udp_fd));
-    assert(udp_fd != -1);
+    for (unsigned int i = 0; i < nb_paths; i++)
+        if (path_init(&paths[i], i, srcpaths[i], logger) != EXIT_SUCCESS)
+            return EXIT_FAILURE;
 
     struct upipe *upipe_udp_sink = upipe_void_chain_output(upipe_rtpfb,
             udp_sink_mgr, uprobe_pfx_alloc(uprobe_use(logger), loglevel,
@@ -432,14 +491,17 @@ int main(int argc, char *argv[])
     /* should never be here for the moment. todo: sighandler.
      * release everything */
     uprobe_clean(&uprobe);
-    uprobe_clean(&uprobe_udp);
     uprobe_release(logger);
 
-    const size_t n = sizeof(rtcp_sink) / sizeof(*rtcp_sink);
-    for (size_t i = 0; i < n; i++) {
-        struct rtcp_sink *sink = &rtcp_sink[i];
-        if (sink->timeout)
-            upump_free(sink->timeout);
+    for (unsigned int j = 0; j < nb_paths; j++) {
+        struct rist_path *path = &paths[j];
+        uprobe_clean(&path->uprobe_udp);
+        const size_t n = sizeof(path->rtcp_sink) / sizeof(*path->rtcp_sink);
+        for (size_t i = 0; i < n; i++) {
+            struct rtcp_sink *sink = &path->rtcp_sink[i];
+            if (sink->timeout)
+                upump_free(sink->timeout);
+        }
     }
 
     upump_mgr_release(upump_mgr);
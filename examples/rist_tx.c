@@ -56,6 +56,7 @@
 #include "upipe-modules/upipe_udp_sink.h"
 #include "upipe-modules/upipe_probe_uref.h"
 #include "upipe-filters/upipe_rtcp_fb_receiver.h"
+#include "upipe-ts/upipe_rtp_fec_enc.h"
 
 #include <stdbool.h>
 #include <stdlib.h>
@@ -76,9 +77,10 @@
 #define READ_SIZE 4096
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d] <udp source> <udp dest> <latency>\n", argv0);
+    fprintf(stdout, "Usage: %s [-d] [-q] [-f LxD] <udp source> <udp dest> <latency>\n", argv0);
     fprintf(stdout, "   -d: more verbose\n");
     fprintf(stdout, "   -q: more quiet\n");
+    fprintf(stdout, "   -f: send SMPTE 2022-1 FEC with L columns and D rows\n");
     exit(EXIT_FAILURE);
 }
 
@@ -273,11 +275,12 @@ static void stop(struct upump *upump)
 int main(int argc, char *argv[])
 {
     char *srcpath, *dirpath, *latency;
+    unsigned int fec_cols = 0, fec_rows = 0;
     int opt;
     enum uprobe_log_level loglevel = UPROBE_LOG_DEBUG;
 
     /* parse options */
-    while ((opt = getopt(argc, argv, "qd")) != -1) {
+    while ((opt = getopt(argc, argv, "qdf:")) != -1) {
         switch (opt) {
             case 'q':
                 loglevel++;
@@ -285,6 +288,10 @@ int main(int argc, char *argv[])
             case 'd':
                 loglevel--;
                 break;
+            case 'f':
+                if (sscanf(optarg, "%ux%u", &fec_cols, &fec_rows) != 2)
+                    usage(argv[0]);
+                break;
             default:
                 usage(argv[0]);
         }
@@ -335,9 +342,42 @@ int main(int argc, char *argv[])
     }
     upipe_attach_uclock(upipe_udpsrc);
 
+    /* protect with FEC, before retransmissions are inserted */
+    struct upipe *upipe_fec = upipe_udpsrc;
+    struct upipe *upipe_udpsink_col = NULL, *upipe_udpsink_row = NULL;
+    if (fec_cols) {
+        struct upipe_mgr *upipe_fec_mgr = upipe_rtp_fec_enc_mgr_alloc();
+        upipe_fec = upipe_rtp_fec_enc_alloc(upipe_fec_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "fec"),
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "fec col"),
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "fec row"));
+        upipe_mgr_release(upipe_fec_mgr);
+        assert(upipe_fec != NULL);
+        if (!ubase_check(upipe_rtp_fec_enc_set_matrix(upipe_fec, fec_cols,
+                                                      fec_rows)))
+            return EXIT_FAILURE;
+        ubase_assert(upipe_set_output(upipe_udpsrc, upipe_fec));
+        upipe_release(upipe_fec);
+
+        struct upipe *upipe_fec_col, *upipe_fec_row;
+        ubase_assert(upipe_rtp_fec_enc_get_col_sub(upipe_fec, &upipe_fec_col));
+        ubase_assert(upipe_rtp_fec_enc_get_row_sub(upipe_fec, &upipe_fec_row));
+
+        struct upipe_mgr *upipe_udpsink_mgr = upipe_udpsink_mgr_alloc();
+        upipe_udpsink_col = upipe_void_alloc_output(upipe_fec_col,
+                upipe_udpsink_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "udp sink col"));
+        upipe_udpsink_row = upipe_void_alloc_output(upipe_fec_row,
+                upipe_udpsink_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "udp sink row"));
+        upipe_mgr_release(upipe_udpsink_mgr);
+        upipe_release(upipe_udpsink_col);
+        upipe_release(upipe_udpsink_row);
+    }
+
     /* send through rtcp fb receiver */
     struct upipe_mgr *upipe_rtcpfb_mgr = upipe_rtcpfb_mgr_alloc();
-    struct upipe *upipe_rtcpfb = upipe_void_alloc_output(upipe_udpsrc, upipe_rtcpfb_mgr,
+    struct upipe *upipe_rtcpfb = upipe_void_alloc_output(upipe_fec, upipe_rtcpfb_mgr,
             uprobe_pfx_alloc(uprobe_use(logger), loglevel, "rtcp fb"));
     upipe_mgr_release(upipe_rtcpfb_mgr);
 
@@ -435,6 +475,25 @@ int main(int argc, char *argv[])
         return EXIT_FAILURE;
     }
 
+    /* column FEC on port + 2, row FEC on port + 4 */
+    if (fec_cols) {
+        snprintf(uri, sizeof(uri), "%.*s%s%.*s:%u%.*s",
+            (int)authority.userinfo.len, authority.userinfo.at,
+            ustring_is_empty(authority.userinfo) ? "" : "@",
+            (int)authority.host.len, authority.host.at, port + 2,
+            (int)settings.len, settings.at);
+        if (!ubase_check(upipe_set_uri(upipe_udpsink_col, uri)))
+            return EXIT_FAILURE;
+
+        snprintf(uri, sizeof(uri), "%.*s%s%.*s:%u%.*s",
+            (int)authority.userinfo.len, authority.userinfo.at,
+            ustring_is_empty(authority.userinfo) ? "" : "@",
+            (int)authority.host.len, authority.host.at, port + 4,
+            (int)settings.len, settings.at);
+        if (!ubase_check(upipe_set_uri(upipe_udpsink_row, uri)))
+            return EXIT_FAILURE;
+    }
+
     int udp_fd = -1;
     ubase_assert(upipe_udpsink_get_fd(upipe_udpsink_rtcp, &udp_fd));
     int flags = fcntl(udp_fd, F_GETFL);
@@ -89,10 +89,11 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_WARNING
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d] [-r <rotate>] [-O <rotate offset>] <udp source> <dest dir/prefix> [<suffix>]\n", argv0);
+    fprintf(stdout, "Usage: %s [-d] [-r <rotate>] [-O <rotate offset>] [-x <index file>] <udp source> <dest dir/prefix> [<suffix>]\n", argv0);
     fprintf(stdout, "   -d: force debug log level\n");
     fprintf(stdout, "   -r: rotate interval in 27MHz unit\n");
     fprintf(stdout, "   -O: rotate offset in 27MHz unit\n");
+    fprintf(stdout, "   -x: write a time index of the data files\n");
     fprintf(stdout, "If no <suffix> specified, udpmulticat sends data to a udp socket\n");
     exit(EXIT_FAILURE);
 }
@@ -114,6 +115,7 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 int main(int argc, char *argv[])
 {
     const char *srcpath, *dirpath, *suffix = NULL;
+    const char *index_file = NULL;
     bool udp = false;
     uint64_t rotate = 0;
     uint64_t rotate_offset = 0;
@@ -121,7 +123,7 @@ int main(int argc, char *argv[])
     enum uprobe_log_level loglevel = UPROBE_LOG_LEVEL;
 
     /* parse options */
-    while ((opt = getopt(argc, argv, "r:O:d")) != -1) {
+    while ((opt = getopt(argc, argv, "r:O:x:d")) != -1) {
         switch (opt) {
             case 'r':
                 rotate = strtoull(optarg, NULL, 0);
@@ -129,6 +131,9 @@ int main(int argc, char *argv[])
             case 'O':
                 rotate_offset = strtoull(optarg, NULL, 0);
                 break;
+            case 'x':
+                index_file = optarg;
+                break;
             case 'd':
                 loglevel = UPROBE_LOG_DEBUG;
                 break;
@@ -222,6 +227,8 @@ int main(int argc, char *argv[])
             upipe_multicat_sink_set_rotate(datasink, rotate, rotate_offset);
         }
         upipe_multicat_sink_set_path(datasink, dirpath, suffix);
+        if (index_file != NULL)
+            upipe_multicat_sink_set_index(datasink, index_file);
         upipe_release(datasink);
 
         /* aux block generation pipe */
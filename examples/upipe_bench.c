@@ -0,0 +1,637 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short benchmark of pipelines fed with synthetic sources
+ *
+ * Each measurement runs a synthetic source (zoneplate or blank pictures, or
+ * silence) through a chain of pipes into a null sink, on the virtual event
+ * loop of @ref upump_virtual_mgr_alloc: the source does not wait for the
+ * wall clock and the pipeline runs as fast as the CPU allows. Each
+ * measurement is made in a child process running one stream per thread, so
+ * that the peak memory of a measurement is not polluted by the previous
+ * ones.
+ *
+ * The resolutions, channel counts, bitrates and thread counts given as
+ * comma-separated lists are swept, and for each combination the program
+ * prints the frames per second and the share of a CPU taken by each
+ * stream, relative to real time, and the peak resident memory. Results may
+ * be saved and compared against a previous run, in which case the exit
+ * status reports regressions.
+ *
+ * Usage example :
+ *   ./upipe_bench -s zoneplate -p blend -r 720x576,1920x1080 -j 1,4 -o ref
+ *   ./upipe_bench -s zoneplate -p blend -r 720x576,1920x1080 -j 1,4 -B ref
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_uref_mgr.h"
+#include "upipe/uprobe_upump_mgr.h"
+#include "upipe/uprobe_uclock.h"
+#include "upipe/uprobe_ubuf_mem.h"
+#include "upipe/uclock.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/uref_sound_flow.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_stats.h"
+#include "upump-virtual/upump_virtual.h"
+#include "upipe-modules/upipe_blank_source.h"
+#include "upipe-modules/upipe_idem.h"
+#include "upipe-modules/upipe_null.h"
+#include "upipe-modules/upipe_rate_limit.h"
+#include "upipe-filters/upipe_zoneplate_source.h"
+#include "upipe-filters/upipe_filter_blend.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 10
+#define UREF_POOL_DEPTH 10
+#define UBUF_POOL_DEPTH 10
+#define UBUF_SHARED_POOL_DEPTH 10
+#define UPUMP_POOL 10
+#define UPUMP_BLOCKER_POOL 10
+/** maximum number of values of a swept parameter */
+#define MAX_VALUES 16
+/** maximum number of results in a baseline */
+#define MAX_BASELINE 1024
+/** maximum length of the key of a result */
+#define KEY_SIZE 256
+
+/** log level of the pipes */
+static enum uprobe_log_level loglevel = UPROBE_LOG_ERROR;
+/** source type */
+static const char *source = "zoneplate";
+/** comma-separated list of pipes between the source and the sink */
+static const char *chain = "";
+/** frame rate */
+static unsigned int fps = 25;
+/** number of frames per stream */
+static uint64_t frames = 250;
+
+/** @This describes a combination of swept parameters. */
+struct bench_point {
+    /** picture width */
+    uint64_t hsize;
+    /** picture height */
+    uint64_t vsize;
+    /** number of audio channels */
+    uint8_t channels;
+    /** bitrate of the rate limiter, in bits per second, or 0 */
+    uint64_t bitrate;
+    /** number of concurrent streams, one per thread */
+    unsigned int threads;
+};
+
+/** @This is the result of a stream, filled in by its thread. */
+struct bench_stream {
+    /** combination of parameters */
+    const struct bench_point *point;
+    /** number of frames received by the sink */
+    uint64_t frames;
+    /** true if the pipeline could not be built */
+    bool error;
+};
+
+/** @This describes a result of a previous run. */
+struct bench_baseline {
+    /** key of the combination of parameters */
+    char key[KEY_SIZE];
+    /** frames per second and per stream */
+    double fps;
+    /** percentage of a CPU per real-time stream */
+    double cpu;
+    /** peak resident memory, in kilo-octets */
+    long rss;
+};
+
+static void usage(const char *argv0) {
+    fprintf(stdout, "Usage: %s [-d] [-s <source>] [-p <chain>] [-r <WxH,...>] [-c <channels,...>] [-b <bitrate,...>] [-j <threads,...>] [-f <fps>] [-n <frames>] [-o <results>] [-B <baseline>] [-t <tolerance>]\n", argv0);
+    fprintf(stdout, "   -d: force debug log level\n");
+    fprintf(stdout, "   -s: source, zoneplate, blank or silence (default zoneplate)\n");
+    fprintf(stdout, "   -p: comma-separated pipes among idem, blend and ratelimit\n");
+    fprintf(stdout, "   -r: picture sizes (default 720x576)\n");
+    fprintf(stdout, "   -c: audio channels (default 2)\n");
+    fprintf(stdout, "   -b: bitrates of the rate limiter in bits per second (default 0, unlimited)\n");
+    fprintf(stdout, "   -j: concurrent streams, one per thread (default 1)\n");
+    fprintf(stdout, "   -f: frame rate (default 25)\n");
+    fprintf(stdout, "   -n: frames per stream (default 250)\n");
+    fprintf(stdout, "   -o: write the results to a file\n");
+    fprintf(stdout, "   -B: compare the results with a file written by -o\n");
+    fprintf(stdout, "   -t: tolerated regression in percent (default 10)\n");
+    exit(EXIT_FAILURE);
+}
+
+/** @This parses a comma-separated list of values.
+ *
+ * @param arg list to parse
+ * @param values filled in with the values
+ * @param values2 filled in with the second values of WxH pairs, or NULL
+ * @return number of values
+ */
+static unsigned int parse_list(const char *arg, uint64_t *values,
+                               uint64_t *values2)
+{
+    unsigned int nb = 0;
+    while (*arg && nb < MAX_VALUES) {
+        char *end;
+        values[nb] = strtoull(arg, &end, 0);
+        if (values2 != NULL) {
+            if (*end != 'x')
+                return 0;
+            values2[nb] = strtoull(end + 1, &end, 0);
+        }
+        if (end == arg || (*end && *end != ','))
+            return 0;
+        nb++;
+        arg = *end ? end + 1 : end;
+    }
+    return nb;
+}
+
+/** @This builds the key identifying a combination of parameters.
+ *
+ * @param point combination of parameters
+ * @param key filled in with the key
+ */
+static void bench_key(const struct bench_point *point, char *key)
+{
+    char format[64];
+    if (!strcmp(source, "silence"))
+        snprintf(format, sizeof(format), "%"PRIu8"ch", point->channels);
+    else
+        snprintf(format, sizeof(format), "%"PRIu64"x%"PRIu64,
+                 point->hsize, point->vsize);
+    snprintf(key, KEY_SIZE, "%s/%s/%s/%"PRIu64"bps/%uj",
+             source, *chain ? chain : "-", format, point->bitrate,
+             point->threads);
+}
+
+/** @This allocates the flow definition of the source.
+ *
+ * @param uref_mgr uref management structure
+ * @param point combination of parameters
+ * @return pointer to flow definition, or NULL
+ */
+static struct uref *bench_flow_def(struct uref_mgr *uref_mgr,
+                                   const struct bench_point *point)
+{
+    struct urational rate = { .num = fps, .den = 1 };
+    struct uref *flow_def;
+
+    if (!strcmp(source, "silence")) {
+        static const char names[] = "lrcLRSabcdefghij";
+        if (!point->channels || point->channels > sizeof(names) - 1)
+            return NULL;
+        flow_def = uref_sound_flow_alloc_def(uref_mgr, "s16.",
+                                             point->channels,
+                                             2 * point->channels);
+        if (flow_def == NULL)
+            return NULL;
+        char plane[sizeof(names)];
+        memcpy(plane, names, point->channels);
+        plane[point->channels] = '\0';
+        if (!ubase_check(uref_sound_flow_add_plane(flow_def, plane)) ||
+            !ubase_check(uref_sound_flow_set_rate(flow_def, 48000)) ||
+            !ubase_check(uref_sound_flow_set_samples(flow_def,
+                                                     48000 / fps))) {
+            uref_free(flow_def);
+            return NULL;
+        }
+        return flow_def;
+    }
+
+    flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    if (flow_def == NULL)
+        return NULL;
+    if (!ubase_check(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8")) ||
+        !ubase_check(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8")) ||
+        !ubase_check(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8")) ||
+        !ubase_check(uref_pic_flow_set_hsize(flow_def, point->hsize)) ||
+        !ubase_check(uref_pic_flow_set_vsize(flow_def, point->vsize)) ||
+        !ubase_check(uref_pic_flow_set_fps(flow_def, rate))) {
+        uref_free(flow_def);
+        return NULL;
+    }
+    return flow_def;
+}
+
+/** @This appends a pipe of the chain.
+ *
+ * @param upipe last pipe of the chain, released
+ * @param name name of the pipe
+ * @param uprobe probe hierarchy, belongs to the callee
+ * @param point combination of parameters
+ * @return new last pipe of the chain, or NULL
+ */
+static struct upipe *bench_chain_output(struct upipe *upipe, const char *name,
+                                        struct uprobe *uprobe,
+                                        const struct bench_point *point)
+{
+    struct upipe_mgr *mgr;
+    if (!strcmp(name, "idem"))
+        mgr = upipe_idem_mgr_alloc();
+    else if (!strcmp(name, "blend"))
+        mgr = upipe_filter_blend_mgr_alloc();
+    else if (!strcmp(name, "ratelimit"))
+        mgr = upipe_rate_limit_mgr_alloc();
+    else {
+        fprintf(stderr, "unknown pipe %s\n", name);
+        mgr = NULL;
+    }
+    if (mgr == NULL) {
+        uprobe_release(uprobe);
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    upipe = upipe_void_chain_output(upipe, mgr,
+            uprobe_pfx_alloc(uprobe, loglevel, name));
+    upipe_mgr_release(mgr);
+    if (upipe != NULL && !strcmp(name, "ratelimit") && point->bitrate &&
+        !ubase_check(upipe_rate_limit_set_limit(upipe, point->bitrate / 8))) {
+        upipe_release(upipe);
+        return NULL;
+    }
+    return upipe;
+}
+
+/** @This ends a stream once the wanted number of frames was generated.
+ *
+ * @param upump description structure of the timer
+ */
+static void bench_stop(struct upump *upump)
+{
+    struct upipe **source_p = upump_get_opaque(upump, struct upipe **);
+    upipe_release(*source_p);
+    *source_p = NULL;
+}
+
+/** @This runs a stream in its own event loop.
+ *
+ * @param arg pointer to struct bench_stream
+ * @return NULL
+ */
+static void *bench_stream(void *arg)
+{
+    struct bench_stream *stream = arg;
+    const struct bench_point *point = stream->point;
+    stream->error = true;
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    struct udict_mgr *udict_mgr =
+        udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr, -1, -1);
+    struct uref_mgr *uref_mgr =
+        uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    struct upump_mgr *upump_mgr =
+        upump_virtual_mgr_alloc(UPUMP_POOL, UPUMP_BLOCKER_POOL, 0);
+    assert(umem_mgr != NULL && udict_mgr != NULL && uref_mgr != NULL &&
+           upump_mgr != NULL);
+    struct uclock *uclock;
+    ubase_assert(upump_virtual_mgr_get_uclock(upump_mgr, &uclock));
+
+    struct uprobe *logger = uprobe_stdio_alloc(NULL, stderr, loglevel);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    logger = uprobe_uclock_alloc(logger, uclock);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_SHARED_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *src = NULL;
+    struct upipe *sink = NULL;
+    struct uref *flow_def = bench_flow_def(uref_mgr, point);
+    struct upipe_mgr *src_mgr = !strcmp(source, "zoneplate") ?
+        upipe_zpsrc_mgr_alloc() : upipe_blksrc_mgr_alloc();
+    if (flow_def != NULL && src_mgr != NULL)
+        src = upipe_flow_alloc(src_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, source),
+                flow_def);
+    upipe_mgr_release(src_mgr);
+    uref_free(flow_def);
+
+    struct upipe *upipe = upipe_use(src);
+    char *names = strdup(chain);
+    char *saveptr = NULL;
+    assert(names != NULL);
+    for (char *name = strtok_r(names, ",", &saveptr);
+         name != NULL && upipe != NULL;
+         name = strtok_r(NULL, ",", &saveptr))
+        upipe = bench_chain_output(upipe, name, uprobe_use(logger), point);
+    free(names);
+
+    if (upipe != NULL) {
+        struct upipe_mgr *null_mgr = upipe_null_mgr_alloc();
+        sink = upipe_void_alloc_output(upipe, null_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), loglevel, "null"));
+        upipe_mgr_release(null_mgr);
+        upipe_release(upipe);
+    }
+
+    if (sink != NULL && ubase_check(upipe_stats_enable(sink, 0))) {
+        struct upump *stop = upump_alloc_timer(upump_mgr, bench_stop, &src,
+                NULL, frames * UCLOCK_FREQ / fps, 0);
+        assert(stop != NULL);
+        upump_start(stop);
+        upump_mgr_run(upump_mgr, NULL);
+        upump_free(stop);
+
+        struct upipe_stats stats;
+        if (ubase_check(upipe_get_stats(sink, &stats))) {
+            stream->frames = stats.urefs;
+            stream->error = false;
+        }
+    }
+
+    upipe_release(src);
+    upipe_release(sink);
+    uprobe_release(logger);
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return NULL;
+}
+
+/** @This runs the streams of a combination of parameters in a child
+ * process.
+ *
+ * @param point combination of parameters
+ * @param fps_p filled in with the frames per second and per stream
+ * @param cpu_p filled in with the percentage of a CPU per real-time stream
+ * @param rss_p filled in with the peak resident memory in kilo-octets
+ * @return false in case of error
+ */
+static bool bench_run(const struct bench_point *point,
+                      double *fps_p, double *cpu_p, long *rss_p)
+{
+    int fds[2];
+    if (pipe(fds) < 0)
+        return false;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (!pid) {
+        close(fds[0]);
+        struct bench_stream streams[point->threads];
+        pthread_t threads[point->threads];
+        struct timespec begin, end;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (unsigned int i = 0; i < point->threads; i++) {
+            streams[i].point = point;
+            streams[i].frames = 0;
+            if (pthread_create(&threads[i], NULL, bench_stream, &streams[i]))
+                _exit(EXIT_FAILURE);
+        }
+
+        uint64_t total = 0;
+        for (unsigned int i = 0; i < point->threads; i++) {
+            pthread_join(threads[i], NULL);
+            if (streams[i].error)
+                _exit(EXIT_FAILURE);
+            total += streams[i].frames;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double result[2];
+        result[0] = total;
+        result[1] = (end.tv_sec - begin.tv_sec) +
+                    (end.tv_nsec - begin.tv_nsec) / 1e9;
+        if (write(fds[1], result, sizeof(result)) != sizeof(result))
+            _exit(EXIT_FAILURE);
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(fds[1]);
+    double result[2];
+    ssize_t ret = read(fds[0], result, sizeof(result));
+    close(fds[0]);
+
+    int status;
+    struct rusage rusage;
+    if (wait4(pid, &status, 0, &rusage) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != EXIT_SUCCESS || ret != sizeof(result) ||
+        !result[0] || result[1] <= 0)
+        return false;
+
+    double cpu = rusage.ru_utime.tv_sec + rusage.ru_utime.tv_usec / 1e6 +
+                 rusage.ru_stime.tv_sec + rusage.ru_stime.tv_usec / 1e6;
+    *fps_p = result[0] / point->threads / result[1];
+    /* CPU time over the media time of the frames */
+    *cpu_p = cpu * 100. * fps / result[0];
+    *rss_p = rusage.ru_maxrss;
+    return true;
+}
+
+/** @This loads a file of results.
+ *
+ * @param path path of the file
+ * @param baseline filled in with the results
+ * @return number of results
+ */
+static unsigned int bench_load(const char *path,
+                               struct bench_baseline *baseline)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        fprintf(stderr, "unable to open %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned int nb = 0;
+    char line[KEY_SIZE + 128];
+    while (nb < MAX_BASELINE && fgets(line, sizeof(line), file) != NULL) {
+        struct bench_baseline *entry = &baseline[nb];
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%255s %lf %lf %ld", entry->key, &entry->fps,
+                   &entry->cpu, &entry->rss) == 4)
+            nb++;
+    }
+    fclose(file);
+    return nb;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t hsizes[MAX_VALUES] = { 720 }, vsizes[MAX_VALUES] = { 576 };
+    uint64_t channels[MAX_VALUES] = { 2 }, bitrates[MAX_VALUES] = { 0 };
+    uint64_t threads[MAX_VALUES] = { 1 };
+    unsigned int nb_sizes = 1, nb_channels = 1, nb_bitrates = 1;
+    unsigned int nb_threads = 1;
+    const char *output = NULL, *baseline_path = NULL;
+    double tolerance = 10.;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "ds:p:r:c:b:j:f:n:o:B:t:")) != -1) {
+        switch (opt) {
+            case 'd':
+                loglevel = UPROBE_LOG_DEBUG;
+                break;
+            case 's':
+                source = optarg;
+                break;
+            case 'p':
+                chain = optarg;
+                break;
+            case 'r':
+                nb_sizes = parse_list(optarg, hsizes, vsizes);
+                break;
+            case 'c':
+                nb_channels = parse_list(optarg, channels, NULL);
+                break;
+            case 'b':
+                nb_bitrates = parse_list(optarg, bitrates, NULL);
+                break;
+            case 'j':
+                nb_threads = parse_list(optarg, threads, NULL);
+                break;
+            case 'f':
+                fps = strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                frames = strtoull(optarg, NULL, 0);
+                break;
+            case 'o':
+                output = optarg;
+                break;
+            case 'B':
+                baseline_path = optarg;
+                break;
+            case 't':
+                tolerance = strtod(optarg, NULL);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind < argc || !nb_sizes || !nb_channels || !nb_bitrates ||
+        !nb_threads || !fps || !frames ||
+        (strcmp(source, "zoneplate") && strcmp(source, "blank") &&
+         strcmp(source, "silence")))
+        usage(argv[0]);
+    for (unsigned int i = 0; i < nb_threads; i++)
+        if (!threads[i])
+            usage(argv[0]);
+
+    /* only sweep the parameters which apply to the source */
+    if (!strcmp(source, "silence"))
+        nb_sizes = 1;
+    else
+        nb_channels = 1;
+
+    static struct bench_baseline baseline[MAX_BASELINE];
+    unsigned int nb_baseline = 0;
+    if (baseline_path != NULL)
+        nb_baseline = bench_load(baseline_path, baseline);
+
+    FILE *results = NULL;
+    if (output != NULL) {
+        results = fopen(output, "w");
+        if (results == NULL) {
+            fprintf(stderr, "unable to open %s\n", output);
+            exit(EXIT_FAILURE);
+        }
+        fprintf(results, "# key fps cpu rss\n");
+    }
+
+    fprintf(stdout, "%-56s %10s %8s %10s\n", "# key", "fps/stream",
+            "cpu%", "rss(KiB)");
+    int status = EXIT_SUCCESS;
+    for (unsigned int s = 0; s < nb_sizes; s++)
+    for (unsigned int c = 0; c < nb_channels; c++)
+    for (unsigned int b = 0; b < nb_bitrates; b++)
+    for (unsigned int j = 0; j < nb_threads; j++) {
+        struct bench_point point = {
+            .hsize = hsizes[s],
+            .vsize = vsizes[s],
+            .channels = channels[c],
+            .bitrate = bitrates[b],
+            .threads = threads[j],
+        };
+        char key[KEY_SIZE];
+        bench_key(&point, key);
+
+        double fps_result, cpu;
+        long rss;
+        if (!bench_run(&point, &fps_result, &cpu, &rss)) {
+            fprintf(stdout, "%-56s failed\n", key);
+            status = EXIT_FAILURE;
+            continue;
+        }
+        fprintf(stdout, "%-56s %10.1f %8.2f %10ld", key, fps_result, cpu,
+                rss);
+        if (results != NULL)
+            fprintf(results, "%s %f %f %ld\n", key, fps_result, cpu, rss);
+
+        for (unsigned int i = 0; i < nb_baseline; i++) {
+            if (strcmp(baseline[i].key, key))
+                continue;
+            double delta = (fps_result - baseline[i].fps) * 100. /
+                           baseline[i].fps;
+            bool regression =
+                fps_result < baseline[i].fps * (1. - tolerance / 100.) ||
+                cpu > baseline[i].cpu * (1. + tolerance / 100.);
+            fprintf(stdout, "  %+6.1f%%%s", delta,
+                    regression ? " REGRESSION" : "");
+            if (regression)
+                status = EXIT_FAILURE;
+            break;
+        }
+        fprintf(stdout, "\n");
+        fflush(stdout);
+    }
+
+    if (results != NULL)
+        fclose(results);
+    return status;
+}
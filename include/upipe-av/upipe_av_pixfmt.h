@@ -174,6 +174,55 @@ static inline int upipe_av_pixfmt_to_flow_def(enum AVPixelFormat pix_fmt,
     return uref_flow_set_def(flow_def, UREF_PIC_FLOW_DEF);
 }
 
+/** @This returns the surface type of the flow definitions carrying frames
+ * of the given hardware pixel format. Such frames stay in device memory
+ * and are exchanged between pipes as opaque ubuf_av buffers.
+ *
+ * @param pix_fmt avutil hardware pixel format
+ * @return the surface type, or NULL if the pixel format is not supported
+ */
+static inline const char *
+upipe_av_hw_pixfmt_to_surface_type(enum AVPixelFormat pix_fmt)
+{
+    switch (pix_fmt) {
+        case AV_PIX_FMT_VAAPI:
+            return "av.vaapi";
+        case AV_PIX_FMT_CUDA:
+            return "av.cuda";
+        case AV_PIX_FMT_QSV:
+            return "av.qsv";
+        default:
+            break;
+    }
+    return NULL;
+}
+
+/** @This returns the hardware pixel format of the frames described by
+ * a flow definition.
+ *
+ * @param flow_def flow definition
+ * @return the hardware pixel format, or AV_PIX_FMT_NONE for frames in system
+ * memory
+ */
+static inline enum AVPixelFormat
+    upipe_av_hw_pixfmt_from_flow_def(struct uref *flow_def)
+{
+    static const enum AVPixelFormat hw_fmts[] = {
+        AV_PIX_FMT_VAAPI,
+        AV_PIX_FMT_CUDA,
+        AV_PIX_FMT_QSV,
+    };
+    const char *surface_type;
+    if (!ubase_check(uref_pic_flow_get_surface_type(flow_def, &surface_type)))
+        return AV_PIX_FMT_NONE;
+
+    for (size_t i = 0; i < UBASE_ARRAY_SIZE(hw_fmts); i++)
+        if (!strcmp(surface_type,
+                    upipe_av_hw_pixfmt_to_surface_type(hw_fmts[i])))
+            return hw_fmts[i];
+    return AV_PIX_FMT_NONE;
+}
+
 /** @This finds the appropriate av pixel format according to the flow
  * definition, and creates a mapping system for planes.
  *
@@ -47,7 +47,11 @@ enum upipe_avcenc_command {
     UPIPE_AVCENC_SENTINEL = UPIPE_CONTROL_LOCAL,
 
     /** set slice type enforcement mode (int) */
-    UPIPE_AVCENC_SET_SLICE_TYPE_ENFORCE
+    UPIPE_AVCENC_SET_SLICE_TYPE_ENFORCE,
+    /** sets the asynchronous encoding mode (unsigned int) */
+    UPIPE_AVCENC_SET_ASYNC,
+    /** returns the asynchronous encoding mode (unsigned int *) */
+    UPIPE_AVCENC_GET_ASYNC,
 };
 
 /** @This sets the slice type enforcement mode (true or false).
@@ -63,6 +67,39 @@ static inline int upipe_avcenc_set_slice_type_enforce(struct upipe *upipe,
                          UPIPE_AVCENC_SIGNATURE, enforce ? 1 : 0);
 }
 
+/** @This sets the asynchronous encoding mode. In asynchronous mode, video
+ * frames are submitted to and packets retrieved from the codec by a
+ * dedicated encoder thread, so that a slow (typically hardware) encoder does
+ * not block the event loop. The input is blocked when depth frames are
+ * waiting for the encoder thread. Audio frames are still encoded
+ * synchronously.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth maximum number of frames waiting for the encoder thread, or 0
+ * for synchronous encoding (default)
+ * @return an error code
+ */
+static inline int upipe_avcenc_set_async(struct upipe *upipe,
+                                         unsigned int depth)
+{
+    return upipe_control(upipe, UPIPE_AVCENC_SET_ASYNC,
+                         UPIPE_AVCENC_SIGNATURE, depth);
+}
+
+/** @This returns the asynchronous encoding mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth_p filled in with the maximum number of frames waiting for the
+ * encoder thread, or 0 in synchronous mode
+ * @return an error code
+ */
+static inline int upipe_avcenc_get_async(struct upipe *upipe,
+                                         unsigned int *depth_p)
+{
+    return upipe_control(upipe, UPIPE_AVCENC_GET_ASYNC,
+                         UPIPE_AVCENC_SIGNATURE, depth_p);
+}
+
 /** @This returns the management structure for avcodec encoders.
  *
  * @return pointer to manager
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Bin pipe running the avcodec encoder of a track on a pool of
+ * worker threads
+ *
+ * When encoding many audio renditions, allocating an avcodec encoder pipe
+ * per track on the main thread serializes all the encodings, while
+ * spawning a thread per track does not scale. This manager spreads the
+ * encoders of all the tracks over a fixed set of worker threads: each
+ * track gets its own encoder, allocated once with the manager of
+ * @ref upipe_avcenc_mgr_alloc and kept for the lifetime of the track, and
+ * it is placed on the worker running the fewest encoders.
+ *
+ * Frames are queued towards the worker, so that each worker encodes the
+ * frames of all its tracks in batches in its event loop, and the encoded
+ * packets are queued back to the main thread. Packets of a given track are
+ * output in order, with the flow definition of the encoder (for instance
+ * block.opus.sound. or block.aac.sound., as expected by the Opus and MPEG
+ * audio framers).
+ */
+
+#ifndef _UPIPE_AV_UPIPE_AVCODEC_ENCODE_POOL_H_
+/** @hidden */
+#define _UPIPE_AV_UPIPE_AVCODEC_ENCODE_POOL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_AVCENC_POOL_SIGNATURE UBASE_FOURCC('a','v','e','p')
+
+/** @This extends upipe_command with specific commands for avcenc pool. */
+enum upipe_avcenc_pool_command {
+    UPIPE_AVCENC_POOL_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the index of the worker running the encoder
+     * (unsigned int *) */
+    UPIPE_AVCENC_POOL_GET_WORKER,
+};
+
+/** @This returns the index of the worker thread running the encoder.
+ *
+ * @param upipe description structure of the pipe
+ * @param worker_p filled in with the index of the worker
+ * @return an error code
+ */
+static inline int upipe_avcenc_pool_get_worker(struct upipe *upipe,
+                                               unsigned int *worker_p)
+{
+    return upipe_control(upipe, UPIPE_AVCENC_POOL_GET_WORKER,
+                         UPIPE_AVCENC_POOL_SIGNATURE, worker_p);
+}
+
+/** @This returns the management structure for avcenc pool pipes.
+ *
+ * @param avcenc_mgr manager of avcodec encoder pipes
+ * @param xfer_mgrs array of managers to transfer pipes to the worker
+ * threads, for instance from @ref upipe_pthread_xfer_mgr_alloc
+ * @param nb_workers number of managers in the array
+ * @param uprobe_remote probe hierarchy to use on the worker threads, which
+ * must provide the upump_mgr of the worker thread (belongs to the callee)
+ * @param input_queue_length number of frames in the queue between the main
+ * thread and a worker, per track
+ * @param output_queue_length number of packets in the queue between a
+ * worker and the main thread, per track
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_avcenc_pool_mgr_alloc(struct upipe_mgr *avcenc_mgr,
+        struct upipe_mgr *const *xfer_mgrs, unsigned int nb_workers,
+        struct uprobe *uprobe_remote, unsigned int input_queue_length,
+        unsigned int output_queue_length);
+
+/** @This allocates the encoder of a track on the least loaded worker.
+ *
+ * @param mgr management structure for avcenc pool pipes
+ * @param uprobe structure used to raise events
+ * @param flow_def flow definition of the encoder, as given to
+ * @ref upipe_avcenc_mgr_alloc pipes
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static inline struct upipe *upipe_avcenc_pool_alloc(struct upipe_mgr *mgr,
+                                                    struct uprobe *uprobe,
+                                                    struct uref *flow_def)
+{
+    return upipe_flow_alloc(mgr, uprobe, flow_def);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -49,6 +49,9 @@ enum upipe_avfilt_command {
     UPIPE_AVFILT_SET_FILTERS_DESC,
     /** set the hardware config (const char *, const char *) */
     UPIPE_AVFILT_SET_HW_CONFIG,
+    /** send a command to filters of the running graph
+     * (const char *, const char *, const char *) */
+    UPIPE_AVFILT_SEND_COMMAND,
 };
 
 /** @This converts @ref upipe_avfilt_command to a string.
@@ -61,12 +64,18 @@ static inline const char *upipe_avfilt_command_str(int command)
     switch ((enum upipe_avfilt_command)command) {
         UBASE_CASE_TO_STR(UPIPE_AVFILT_SET_FILTERS_DESC);
         UBASE_CASE_TO_STR(UPIPE_AVFILT_SET_HW_CONFIG);
+        UBASE_CASE_TO_STR(UPIPE_AVFILT_SEND_COMMAND);
         case UPIPE_AVFILT_SENTINEL: break;
     }
     return NULL;
 }
 
 /** @This sets the filter graph description.
+ *
+ * If the graph is running and the new description only changes runtime
+ * parameters of the same filters, they are updated in place. Otherwise a
+ * new graph is built and swapped with the running one once configured, so
+ * the previous graph keeps filtering until then.
  *
  * @param upipe description structure of the pipe
  * @param filters filter graph description
@@ -95,6 +104,24 @@ static inline int upipe_avfilt_set_hw_config(struct upipe *upipe,
                          hw_type, hw_device);
 }
 
+/** @This sends a command to filters of the running graph, see
+ * avfilter_graph_send_command.
+ *
+ * @param upipe description structure of the pipe
+ * @param target filter instance name, or "all"
+ * @param cmd command (usually a runtime option name)
+ * @param arg command argument
+ * @return an error code
+ */
+static inline int upipe_avfilt_send_command(struct upipe *upipe,
+                                            const char *target,
+                                            const char *cmd,
+                                            const char *arg)
+{
+    return upipe_control(upipe, UPIPE_AVFILT_SEND_COMMAND,
+                         UPIPE_AVFILT_SIGNATURE, target, cmd, arg);
+}
+
 /** @This returns the management structure for all avfilter pipes.
  *
  * @return pointer to manager
@@ -25,6 +25,13 @@
 
 /** @file
  * @short Upipe sink module libavformat wrapper
+ *
+ * If an output pipe is set with @ref upipe_set_output before the header is
+ * written, the container is output as block buffers allocated from the
+ * pipeline's managers instead of being written by libavformat to the URI,
+ * which is then only used to guess the format. The output is not seekable,
+ * so formats needing to rewrite their header (such as non-fragmented MP4)
+ * must be configured accordingly.
  */
 
 #ifndef _UPIPE_AV_UPIPE_AVFORMAT_SINK_H_
@@ -25,6 +25,12 @@
 
 /** @file
  * @short Upipe source module libavformat wrapper
+ *
+ * Instead of opening a URL, the pipe may also be set as the output of
+ * another pipe outputting a block stream (such as a file or HTTP source).
+ * The stream is then read through a custom I/O context, and demuxed from the
+ * event loop as soon as enough data is buffered, without blocking. The input
+ * is not seekable.
  */
 
 #ifndef _UPIPE_AV_UPIPE_AVFORMAT_SOURCE_H_
@@ -90,6 +90,20 @@ static inline int ubuf_pic_bmd_get_video_frame(struct ubuf *ubuf,
 struct ubuf_mgr *ubuf_pic_bmd_mgr_alloc(uint16_t ubuf_pool_depth,
                                         uint32_t PixelFormat);
 
+/** @This allocates a new instance of the ubuf manager for picture formats
+ * using frames created on a blackmagic output. Pictures allocated with
+ * @ref ubuf_pic_alloc are rendered directly into frames that can be
+ * scheduled on the output without a copy.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param DeckLinkOutput pointer to IDeckLinkOutput
+ * @param PixelFormat blackmagic pixel format
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_pic_bmd_output_mgr_alloc(uint16_t ubuf_pool_depth,
+                                               void *DeckLinkOutput,
+                                               uint32_t PixelFormat);
+
 #ifdef __cplusplus
 }
 #endif
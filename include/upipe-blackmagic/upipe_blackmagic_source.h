@@ -52,7 +52,12 @@ enum upipe_bmd_src_command {
     /** returns the pic subpipe (struct upipe **) */
     UPIPE_BMD_SRC_GET_PIC_SUB,
     /** returns the sound subpipe (struct upipe **) */
-    UPIPE_BMD_SRC_GET_SOUND_SUB
+    UPIPE_BMD_SRC_GET_SOUND_SUB,
+    /** sets the length of the queue of captured frames (unsigned int) */
+    UPIPE_BMD_SRC_SET_QUEUE_LENGTH,
+    /** returns the number of frames dropped because the queue was full
+     * (uint64_t *) */
+    UPIPE_BMD_SRC_GET_OVERRUNS
 };
 
 /** @This returns the management structure for all bmd sources.
@@ -89,6 +94,36 @@ static inline int upipe_bmd_src_get_sound_sub(struct upipe *upipe,
                          UPIPE_BMD_SRC_SIGNATURE, upipe_p);
 }
 
+/** @This sets the length of the queue between the capture thread and the
+ * pipe. Captured frames are referenced, not copied, so a deep queue allows
+ * the pipeline to absorb hiccups without dropping frames. It must be called
+ * before setting the URI.
+ *
+ * @param upipe description structure of the super pipe
+ * @param queue_length number of captured frames and audio packets
+ * @return an error code
+ */
+static inline int upipe_bmd_src_set_queue_length(struct upipe *upipe,
+                                                 unsigned int queue_length)
+{
+    return upipe_control(upipe, UPIPE_BMD_SRC_SET_QUEUE_LENGTH,
+                         UPIPE_BMD_SRC_SIGNATURE, queue_length);
+}
+
+/** @This returns the number of captured frames and audio packets dropped
+ * because the queue was full.
+ *
+ * @param upipe description structure of the super pipe
+ * @param overruns_p filled in with the number of dropped frames
+ * @return an error code
+ */
+static inline int upipe_bmd_src_get_overruns(struct upipe *upipe,
+                                             uint64_t *overruns_p)
+{
+    return upipe_control(upipe, UPIPE_BMD_SRC_GET_OVERRUNS,
+                         UPIPE_BMD_SRC_SIGNATURE, overruns_p);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct uprobe *uprobe_pic, struct uprobe *uprobe_sound
 /** @hidden */
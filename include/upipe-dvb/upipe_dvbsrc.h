@@ -39,6 +39,38 @@ enum upipe_dvbsrc_command {
 
     /** gets the frontend status (unsigned int *, struct dtv_properties *) */
     UPIPE_DVBSRC_GET_FRONTEND_STATUS,
+    /** enable or disable the hardware PID filter (int) */
+    UPIPE_DVBSRC_SET_PID_FILTER,
+    /** select a PID in the hardware PID filter (unsigned int) */
+    UPIPE_DVBSRC_ADD_PID,
+    /** unselect a PID in the hardware PID filter (unsigned int) */
+    UPIPE_DVBSRC_DEL_PID,
+    /** sets the period of the frontend statistics events (uint64_t) */
+    UPIPE_DVBSRC_SET_STATS_PERIOD,
+};
+
+/** @This is the frontend statistics reported by the source. */
+struct upipe_dvbsrc_frontend_stats {
+    /** frontend status (fe_status_t flags) */
+    unsigned int status;
+    /** signal strength, scale FE_SCALE_NOT_AVAILABLE if not supported */
+    struct dtv_stats strength;
+    /** carrier to noise ratio, scale FE_SCALE_NOT_AVAILABLE if not
+     * supported */
+    struct dtv_stats cnr;
+    /** bit error rate after the inner code, or negative if not supported */
+    float ber;
+    /** number of uncorrected blocks */
+    uint32_t error_blocks;
+};
+
+/** @This extends uprobe_throw with specific events. */
+enum uprobe_dvbsrc_event {
+    UPROBE_DVBSRC_SENTINEL = UPROBE_LOCAL,
+
+    /** periodic frontend statistics
+     * (const struct upipe_dvbsrc_frontend_stats *) */
+    UPROBE_DVBSRC_FRONTEND_STATS,
 };
 
 static inline int upipe_dvbsrc_get_frontend_status(struct upipe *upipe,
@@ -48,6 +80,59 @@ static inline int upipe_dvbsrc_get_frontend_status(struct upipe *upipe,
             UPIPE_DVBSRC_SIGNATURE, status, props);
 }
 
+/** @This enables or disables the hardware PID filter. When enabled, only the
+ * selected PIDs are output, the filtering being done by the demux device.
+ * The PIDs needed by a TS demux may be selected when its split pipe throws
+ * UPROBE_TS_SPLIT_ADD_PID and UPROBE_TS_SPLIT_DEL_PID events.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to enable the filter
+ * @return an error code
+ */
+static inline int upipe_dvbsrc_set_pid_filter(struct upipe *upipe,
+                                              bool enabled)
+{
+    return upipe_control(upipe, UPIPE_DVBSRC_SET_PID_FILTER,
+                         UPIPE_DVBSRC_SIGNATURE, enabled ? 1 : 0);
+}
+
+/** @This selects a PID in the hardware PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to select
+ * @return an error code
+ */
+static inline int upipe_dvbsrc_add_pid(struct upipe *upipe, unsigned int pid)
+{
+    return upipe_control(upipe, UPIPE_DVBSRC_ADD_PID,
+                         UPIPE_DVBSRC_SIGNATURE, pid);
+}
+
+/** @This unselects a PID in the hardware PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to unselect
+ * @return an error code
+ */
+static inline int upipe_dvbsrc_del_pid(struct upipe *upipe, unsigned int pid)
+{
+    return upipe_control(upipe, UPIPE_DVBSRC_DEL_PID,
+                         UPIPE_DVBSRC_SIGNATURE, pid);
+}
+
+/** @This sets the period of the UPROBE_DVBSRC_FRONTEND_STATS events.
+ *
+ * @param upipe description structure of the pipe
+ * @param period period in 27 MHz ticks, or 0 to disable the events
+ * @return an error code
+ */
+static inline int upipe_dvbsrc_set_stats_period(struct upipe *upipe,
+                                                uint64_t period)
+{
+    return upipe_control(upipe, UPIPE_DVBSRC_SET_STATS_PERIOD,
+                         UPIPE_DVBSRC_SIGNATURE, period);
+}
+
 /** @This returns the management structure for all dvb sources.
  *
  * @return pointer to manager
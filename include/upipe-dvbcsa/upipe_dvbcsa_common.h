@@ -51,6 +51,8 @@ enum upipe_dvbcsa_command {
     UPIPE_DVBCSA_ADD_PID,
     /** delete a pid from the encryption/decryption list (uint64_t) */
     UPIPE_DVBCSA_DEL_PID,
+    /** get the batch statistics (struct upipe_dvbcsa_stats *) */
+    UPIPE_DVBCSA_GET_STATS,
 
     /** custom dvbcsa commands start here */
     UPIPE_DVBCSA_CONTROL_LOCAL,
@@ -94,6 +96,33 @@ static inline int upipe_dvbcsa_del_pid(struct upipe *upipe,
                          UPIPE_DVBCSA_COMMON_SIGNATURE, pid);
 }
 
+/** @This stores the batch statistics of a dvbcsa pipe. Packets are
+ * processed in batches shared by all the pids using the same control word,
+ * flushed either when full or when the maximum latency is reached. */
+struct upipe_dvbcsa_stats {
+    /** number of processed batches */
+    uint64_t batches;
+    /** number of processed packets */
+    uint64_t packets;
+    /** number of batches flushed because they were full */
+    uint64_t full_batches;
+    /** cumulated processing time, in 27MHz ticks */
+    uint64_t duration;
+};
+
+/** @This gets the batch statistics.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats filled with the statistics
+ * @return an error code
+ */
+static inline int upipe_dvbcsa_get_stats(struct upipe *upipe,
+                                         struct upipe_dvbcsa_stats *stats)
+{
+    return upipe_control(upipe, UPIPE_DVBCSA_GET_STATS,
+                         UPIPE_DVBCSA_COMMON_SIGNATURE, stats);
+}
+
 /** @This stores a parsed dvbcsa control word. */
 struct ustring_dvbcsa_cw {
     /** matching part of the string */
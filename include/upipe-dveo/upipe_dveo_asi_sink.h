@@ -62,6 +62,11 @@ static inline int upipe_dveo_asi_sink_get_uclock(struct upipe *upipe,
 
 
 /** @This returns the management structure for dveo_asi_sink pipes.
+ *
+ * By default each buffer is written to the card as soon as it is received.
+ * With the "fifo-level" option set to a number of driver buffers (up to 500),
+ * buffers are queued and written in large batches whenever the driver FIFO
+ * falls below that level, which is checked every 10 ms.
  *
  * @return pointer to manager
  */
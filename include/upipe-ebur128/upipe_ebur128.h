@@ -37,13 +37,102 @@ extern "C" {
 #include "upipe/upipe.h"
 #include "upipe/uref_attr.h"
 #include <stdint.h>
+#include <inttypes.h>
 
 UREF_ATTR_FLOAT(ebur128, momentary, "ebur128.momentary", momentary loudness)
 UREF_ATTR_FLOAT(ebur128, lra, "ebur128.lra", loudness range)
 UREF_ATTR_FLOAT(ebur128, global, "ebur128.global", global integrated loudness)
+UREF_ATTR_FLOAT_VA(ebur128, program_momentary, "ebur128.momentary[%" PRIu8"]",
+                   momentary loudness of a program, uint8_t program, program)
+UREF_ATTR_FLOAT_VA(ebur128, program_lra, "ebur128.lra[%" PRIu8"]",
+                   loudness range of a program, uint8_t program, program)
+UREF_ATTR_FLOAT_VA(ebur128, program_global, "ebur128.global[%" PRIu8"]",
+                   global integrated loudness of a program,
+                   uint8_t program, program)
 
 #define UPIPE_EBUR128_SIGNATURE UBASE_FOURCC('r', '1', '2', '8')
 
+/** interval of a measure only computed on query */
+#define UPIPE_EBUR128_ON_QUERY UINT64_MAX
+
+/** @This extends upipe_command with specific commands for ebur128 pipes. */
+enum upipe_ebur128_command {
+    UPIPE_EBUR128_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the reporting intervals of the measures
+     * (uint64_t, uint64_t, uint64_t) */
+    UPIPE_EBUR128_SET_INTERVALS,
+    /** sets the number of channels of each program (unsigned int) */
+    UPIPE_EBUR128_SET_PROGRAM_CHANNELS,
+    /** returns the current loudness of a program
+     * (unsigned int, double *, double *, double *) */
+    UPIPE_EBUR128_GET_LOUDNESS,
+};
+
+/** @This sets the reporting intervals of the measures, in 27 MHz units of
+ * audio. A measure is computed again once its interval of audio has been
+ * received, and the last computed value is attached to every uref in the
+ * meantime. The loudness range and global loudness are histogram
+ * computations much more expensive than the momentary loudness, so they
+ * are usually computed every second or so. An interval of 0, the default,
+ * computes the measure on every uref, and @ref UPIPE_EBUR128_ON_QUERY only
+ * computes it in @ref upipe_ebur128_get_loudness.
+ *
+ * @param upipe description structure of the pipe
+ * @param momentary interval of the momentary loudness
+ * @param lra interval of the loudness range
+ * @param global interval of the global integrated loudness
+ * @return an error code
+ */
+static inline int upipe_ebur128_set_intervals(struct upipe *upipe,
+                                              uint64_t momentary,
+                                              uint64_t lra, uint64_t global)
+{
+    return upipe_control(upipe, UPIPE_EBUR128_SET_INTERVALS,
+                         UPIPE_EBUR128_SIGNATURE, momentary, lra, global);
+}
+
+/** @This splits the input channels into programs of the given number of
+ * channels, for instance the eight stereo pairs of a 16-channel SDI stream,
+ * which are measured separately in a single pass over the input. The
+ * measures of each program are attached with the indexed attributes, such
+ * as @ref uref_ebur128_set_program_momentary, and those of the first
+ * program with the plain attributes as well. The number of input channels
+ * must be a multiple of the number of channels of a program.
+ *
+ * @param upipe description structure of the pipe
+ * @param channels number of channels of each program, or 0 to measure all
+ * the channels as a single program (the default)
+ * @return an error code
+ */
+static inline int upipe_ebur128_set_program_channels(struct upipe *upipe,
+                                                     uint8_t channels)
+{
+    return upipe_control(upipe, UPIPE_EBUR128_SET_PROGRAM_CHANNELS,
+                         UPIPE_EBUR128_SIGNATURE, (unsigned int)channels);
+}
+
+/** @This computes the current loudness of a program, whatever the
+ * reporting intervals.
+ *
+ * @param upipe description structure of the pipe
+ * @param program index of the program
+ * @param momentary_p filled in with the momentary loudness (may be NULL)
+ * @param lra_p filled in with the loudness range (may be NULL)
+ * @param global_p filled in with the global integrated loudness (may be
+ * NULL)
+ * @return an error code
+ */
+static inline int upipe_ebur128_get_loudness(struct upipe *upipe,
+                                             uint8_t program,
+                                             double *momentary_p,
+                                             double *lra_p, double *global_p)
+{
+    return upipe_control(upipe, UPIPE_EBUR128_GET_LOUDNESS,
+                         UPIPE_EBUR128_SIGNATURE, (unsigned int)program,
+                         momentary_p, lra_p, global_p);
+}
+
 /** @This returns the management structure for all avformat sources.
  *
  * @return pointer to manager
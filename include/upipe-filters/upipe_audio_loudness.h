@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe filter measuring EBU R128 loudness with a native K-weighting
+ * engine
+ *
+ * Unlike upipe_ebur128, this pipe does not rely on libebur128: the
+ * K-weighting filters run on blocks of channels at once, straight from the
+ * planar (or packed) input buffers, and the gating uses fixed-size
+ * histograms, so that many programs can be monitored cheaply. It typically
+ * sits behind upipe_audio_split outputs.
+ */
+
+#ifndef _UPIPE_FILTERS_UPIPE_AUDIO_LOUDNESS_H_
+/** @hidden */
+#define _UPIPE_FILTERS_UPIPE_AUDIO_LOUDNESS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+#include "upipe/uref_attr.h"
+#include <stdint.h>
+#include <inttypes.h>
+
+/* the keys are shared with upipe_ebur128 so that consumers may use either */
+UREF_ATTR_FLOAT_VA(aloud, momentary, "ebur128.momentary[%" PRIu8"]",
+        momentary loudness of a program, uint8_t program, program)
+UREF_ATTR_FLOAT_VA(aloud, short_term, "ebur128.short_term[%" PRIu8"]",
+        short-term loudness of a program, uint8_t program, program)
+UREF_ATTR_FLOAT_VA(aloud, lra, "ebur128.lra[%" PRIu8"]",
+        loudness range of a program, uint8_t program, program)
+UREF_ATTR_FLOAT_VA(aloud, global, "ebur128.global[%" PRIu8"]",
+        global integrated loudness of a program, uint8_t program, program)
+
+#define UPIPE_AUDIO_LOUDNESS_SIGNATURE UBASE_FOURCC('a', 'l', 'o', 'u')
+
+/** @This extends upipe_command with specific commands for loudness pipes. */
+enum upipe_aloud_command {
+    UPIPE_ALOUD_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the number of channels of each program (unsigned int) */
+    UPIPE_ALOUD_SET_PROGRAM_CHANNELS,
+    /** returns the current loudness of a program
+     * (unsigned int, double *, double *, double *, double *) */
+    UPIPE_ALOUD_GET_LOUDNESS,
+};
+
+/** @This splits the input channels into programs of the given number of
+ * channels, for instance the stereo pairs of an SDI stream. The number of
+ * input channels must be a multiple of it.
+ *
+ * @param upipe description structure of the pipe
+ * @param channels number of channels of each program, or 0 to measure all
+ * the channels as a single program (the default)
+ * @return an error code
+ */
+static inline int upipe_aloud_set_program_channels(struct upipe *upipe,
+                                                   uint8_t channels)
+{
+    return upipe_control(upipe, UPIPE_ALOUD_SET_PROGRAM_CHANNELS,
+                         UPIPE_AUDIO_LOUDNESS_SIGNATURE,
+                         (unsigned int)channels);
+}
+
+/** @This returns the loudness of a program as of the last 100 ms block.
+ *
+ * @param upipe description structure of the pipe
+ * @param program index of the program
+ * @param momentary_p filled in with the momentary loudness (may be NULL)
+ * @param short_term_p filled in with the short-term loudness (may be NULL)
+ * @param lra_p filled in with the loudness range (may be NULL)
+ * @param global_p filled in with the global integrated loudness (may be
+ * NULL)
+ * @return an error code
+ */
+static inline int upipe_aloud_get_loudness(struct upipe *upipe,
+                                           uint8_t program,
+                                           double *momentary_p,
+                                           double *short_term_p,
+                                           double *lra_p, double *global_p)
+{
+    return upipe_control(upipe, UPIPE_ALOUD_GET_LOUDNESS,
+                         UPIPE_AUDIO_LOUDNESS_SIGNATURE,
+                         (unsigned int)program, momentary_p, short_term_p,
+                         lra_p, global_p);
+}
+
+/** @This returns the management structure for loudness pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_aloud_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -37,9 +37,50 @@ extern "C" {
 
 UREF_ATTR_FLOAT_VA(amax, amplitude, "amax.amp[%" PRIu8"]", max amplitude,
         uint8_t plane, plane)
+UREF_ATTR_FLOAT_VA(amax, rms, "amax.rms[%" PRIu8"]", RMS amplitude,
+        uint8_t plane, plane)
+UREF_ATTR_FLOAT_VA(amax, true_peak, "amax.tp[%" PRIu8"]",
+        true-peak amplitude, uint8_t plane, plane)
 
 #define UPIPE_AUDIO_MAX_SIGNATURE UBASE_FOURCC('a', 'm', 'a', 'x')
 
+/** @This extends upipe_command with specific commands for amax pipes. */
+enum upipe_amax_command {
+    UPIPE_AMAX_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** enables or disables the RMS amplitudes (int) */
+    UPIPE_AMAX_SET_RMS,
+    /** enables or disables the true-peak amplitudes (int) */
+    UPIPE_AMAX_SET_TRUE_PEAK,
+};
+
+/** @This enables or disables the computation of the RMS amplitude of each
+ * channel, attached to the urefs with @ref uref_amax_set_rms.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to compute RMS amplitudes
+ * @return an error code
+ */
+static inline int upipe_amax_set_rms(struct upipe *upipe, bool enable)
+{
+    return upipe_control(upipe, UPIPE_AMAX_SET_RMS,
+                         UPIPE_AUDIO_MAX_SIGNATURE, enable ? 1 : 0);
+}
+
+/** @This enables or disables the computation of the true-peak amplitude
+ * of each channel (ITU-R BS.1770 4x oversampling), attached to the urefs
+ * with @ref uref_amax_set_true_peak.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to compute true-peak amplitudes
+ * @return an error code
+ */
+static inline int upipe_amax_set_true_peak(struct upipe *upipe, bool enable)
+{
+    return upipe_control(upipe, UPIPE_AMAX_SET_TRUE_PEAK,
+                         UPIPE_AUDIO_MAX_SIGNATURE, enable ? 1 : 0);
+}
+
 /** @This returns the management structure for all amax sources.
  *
  * @return pointer to manager
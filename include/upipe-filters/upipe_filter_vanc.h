@@ -52,6 +52,9 @@ enum upipe_vanc_command {
 };
 
 /** @This returns the management structure for all vanc pipes.
+ *
+ * Ancillary packets are only decoded for the subpipes which have an output,
+ * and frames are dropped without being scanned when no subpipe has one.
  *
  * @return pointer to manager
  */
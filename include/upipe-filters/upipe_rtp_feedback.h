@@ -47,6 +47,8 @@ enum upipe_rtpfb_output_command {
     UPIPE_RTPFB_OUTPUT_SET_NAME,
     /** get rtpfb_output sdes name (const char **) */
     UPIPE_RTPFB_OUTPUT_GET_NAME,
+    /** get path counters (size_t *, size_t *, size_t *, uint64_t *) */
+    UPIPE_RTPFB_OUTPUT_GET_STATS,
 };
 
 enum upipe_rtpfb_command {
@@ -70,6 +72,27 @@ static inline int upipe_rtpfb_output_set_name(struct upipe *upipe, const char *n
                          UPIPE_RTPFB_OUTPUT_SIGNATURE, name);
 }
 
+/** @This gets the counters of a path, and resets them. Lost packets are the
+ * gaps in the sequence numbers received on this path, which is meaningful
+ * when every path carries the whole stream; duplicates are packets that
+ * were already received, on this path or another one.
+ *
+ * @param upipe description structure of the subpipe
+ * @param packets_p filled in with the number of RTP packets received
+ * @param duplicates_p filled in with the number of duplicate packets
+ * @param lost_p filled in with the number of packets missing on this path
+ * @param rtt_p filled in with the round-trip time of the path, or 0
+ * @return an error code
+ */
+static inline int upipe_rtpfb_output_get_stats(struct upipe *upipe,
+        size_t *packets_p, size_t *duplicates_p, size_t *lost_p,
+        uint64_t *rtt_p)
+{
+    return upipe_control(upipe, UPIPE_RTPFB_OUTPUT_GET_STATS,
+                         UPIPE_RTPFB_OUTPUT_SIGNATURE, packets_p,
+                         duplicates_p, lost_p, rtt_p);
+}
+
 static inline int upipe_rtpfb_get_stats(struct upipe *upipe,
         unsigned *expected_seqnum, unsigned *last_output_seqnum,
         size_t *buffered, size_t *nacks, size_t *repaired,
@@ -87,6 +110,13 @@ static inline int upipe_rtpfb_get_rtt(struct upipe *upipe, uint64_t *rtt)
 }
 
 /** @This returns the management structure for rtpfb pipes.
+ *
+ * RTP packets may be fed to the pipe itself, or through its output subpipes
+ * which each represent a network path: a subpipe accepts both the RTP and
+ * the RTCP packets of its path (told apart as in RFC 5761), and outputs the
+ * RTCP feedback to send back on that path. Packets received on several
+ * bonded paths are merged and de-duplicated, and retransmission requests
+ * are sent on the path with the lowest round-trip time.
  *
  * @return pointer to manager
  */
@@ -29,9 +29,50 @@ extern "C" {
 #endif
 
 #include "upipe/ubase.h"
+#include "upipe/upipe.h"
 
 #define UPIPE_ZP_SIGNATURE   UBASE_FOURCC('z','p','l','t')
 
+/** @This extends upipe_command with specific commands for zoneplate pipes. */
+enum upipe_zp_command {
+    UPIPE_ZP_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets whether the pattern is static (int) */
+    UPIPE_ZP_SET_STATIC,
+    /** returns whether the pattern is static (int *) */
+    UPIPE_ZP_GET_STATIC,
+};
+
+/** @This sets whether the pattern is static. A static pattern is drawn once,
+ * and the same picture is then output read-only for every frame, instead of
+ * an animated pattern being drawn for every frame.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true for a static pattern
+ * @return an error code
+ */
+static inline int upipe_zp_set_static(struct upipe *upipe, bool enabled)
+{
+    return upipe_control(upipe, UPIPE_ZP_SET_STATIC, UPIPE_ZP_SIGNATURE,
+                         enabled ? 1 : 0);
+}
+
+/** @This returns whether the pattern is static.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled_p filled in with true if the pattern is static
+ * @return an error code
+ */
+static inline int upipe_zp_get_static(struct upipe *upipe, bool *enabled_p)
+{
+    int enabled;
+    UBASE_RETURN(upipe_control(upipe, UPIPE_ZP_GET_STATIC, UPIPE_ZP_SIGNATURE,
+                               &enabled));
+    if (enabled_p)
+        *enabled_p = !!enabled;
+    return UBASE_ERR_NONE;
+}
+
 /** @This returns the management structure for zoneplate pipes.
  *
  * @return a pointer to the zoneplate pipe manager
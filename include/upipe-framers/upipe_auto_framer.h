@@ -62,6 +62,10 @@ enum upipe_autof_mgr_command {
     UPIPE_AUTOF_MGR_GET_SET_MGR(opusf, OPUSF)
     UPIPE_AUTOF_MGR_GET_SET_MGR(s302f, S302F)
 #undef UPIPE_AUTOF_MGR_GET_SET_MGR
+
+    /** adds a worker thread to run framers (struct upipe_mgr *,
+     * struct uprobe *, unsigned int) */
+    UPIPE_AUTOF_MGR_ADD_WORKER,
 };
 
 /** @hidden */
@@ -106,6 +110,31 @@ UPIPE_AUTOF_MGR_GET_SET_MGR2(opusf, OPUSF)
 UPIPE_AUTOF_MGR_GET_SET_MGR2(s302f, S302F)
 #undef UPIPE_AUTOF_MGR_GET_SET_MGR2
 
+/** @This adds a worker thread to run framers. When at least one worker is
+ * registered, each new framer (except idem) is allocated with the probe
+ * hierarchy of a worker and wrapped into a worker linear pipe, the workers
+ * being used in turn. Packets, flow definitions and dates keep their order
+ * through the queues. This may only be called before any pipe has been
+ * allocated.
+ *
+ * @param mgr pointer to manager
+ * @param wlin_mgr worker linear manager transferring pipes to the worker
+ * thread
+ * @param uprobe_remote probe hierarchy to use on the worker thread
+ * @param queue_length number of packets in the queues to and from the worker
+ * thread
+ * @return an error code
+ */
+static inline int upipe_autof_mgr_add_worker(struct upipe_mgr *mgr,
+                                             struct upipe_mgr *wlin_mgr,
+                                             struct uprobe *uprobe_remote,
+                                             unsigned int queue_length)
+{
+    return upipe_mgr_control(mgr, UPIPE_AUTOF_MGR_ADD_WORKER,
+                             UPIPE_AUTOF_SIGNATURE, wlin_mgr, uprobe_remote,
+                             queue_length);
+}
+
 #ifdef __cplusplus
 }
 #endif
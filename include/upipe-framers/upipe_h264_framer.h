@@ -31,6 +31,8 @@ extern "C" {
 
 #include "upipe/upipe.h"
 
+#include <stdbool.h>
+
 #define UPIPE_H264F_SIGNATURE UBASE_FOURCC('2','6','4','f')
 /** We only accept the ISO 14496-10 annex B elementary stream. */
 #define UPIPE_H264F_EXPECTED_FLOW_DEF "block.h264."
@@ -41,6 +43,51 @@ extern "C" {
  */
 struct upipe_mgr *upipe_h264f_mgr_alloc(void);
 
+/** @This extends upipe_command with specific commands for h264f pipes. */
+enum upipe_h264f_command {
+    UPIPE_H264F_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the light framing mode (int) */
+    UPIPE_H264F_SET_LIGHT,
+    /** sets the slice output mode (int) */
+    UPIPE_H264F_SET_SLICE_OUTPUT
+};
+
+/** @This sets the light framing mode, for pass-through uses which only need
+ * access unit boundaries, key frames and dates. Parameter sets are still
+ * parsed when they change, but SEI messages are skipped and slice headers
+ * are only parsed up to the field flags. Picture structures and DPB output
+ * delays are then derived from slice headers and input dates only.
+ *
+ * @param upipe description structure of the pipe
+ * @param light true to enable the light framing mode
+ * @return an error code
+ */
+static inline int upipe_h264f_set_light(struct upipe *upipe, bool light)
+{
+    return upipe_control(upipe, UPIPE_H264F_SET_LIGHT, UPIPE_H264F_SIGNATURE,
+                         light ? 1 : 0);
+}
+
+/** @This sets the slice output mode, for low-latency decoding. Annex B
+ * access units are then output in pieces, as soon as each slice is complete,
+ * instead of waiting for the start of the next access unit. All pieces carry
+ * the h26x.au_partial attribute; the first piece of an access unit also
+ * carries the block start flag and the picture attributes and dates, and the
+ * access unit is complete when the next one starts. Inputs which are already
+ * framed in access units are not affected.
+ *
+ * @param upipe description structure of the pipe
+ * @param slice_output true to enable the slice output mode
+ * @return an error code
+ */
+static inline int upipe_h264f_set_slice_output(struct upipe *upipe,
+                                             bool slice_output)
+{
+    return upipe_control(upipe, UPIPE_H264F_SET_SLICE_OUTPUT,
+                         UPIPE_H264F_SIGNATURE, slice_output ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
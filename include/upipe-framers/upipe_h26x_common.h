@@ -35,6 +35,8 @@ extern "C" {
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 
 /** @hidden */
 enum uref_h26x_encaps;
@@ -87,6 +89,143 @@ uint32_t upipe_h26xf_stream_ue(struct ubuf_block_stream *s);
  */
 int32_t upipe_h26xf_stream_se(struct ubuf_block_stream *s);
 
+/** @This checks whether a parameter set NAL unit is identical to the one
+ * already stored for its identifier. Periodic repetitions of parameter sets
+ * can then be skipped without being copied or compared again.
+ *
+ * @param stored stored parameter set, or NULL
+ * @param ubuf ubuf containing the NAL unit
+ * @param offset offset of the NAL unit in the ubuf
+ * @param size size of the NAL unit, in octets
+ * @return true if the NAL unit is identical to the stored one
+ */
+bool upipe_h26xf_ps_equal(struct ubuf *stored, struct ubuf *ubuf,
+                          size_t offset, size_t size);
+
+/** @This is the maximum number of NAL octets decoded by
+ * @ref upipe_h26xf_bits_init. */
+#define UPIPE_H26XF_BITS_WINDOW 64
+
+/** @This is a cached bit reader working on a contiguous window of a NAL
+ * unit, from which escape words have already been removed. It is meant
+ * for headers parsed on every frame, such as slice headers. */
+struct upipe_h26xf_bits {
+    /** next octet to load into the cache */
+    const uint8_t *buffer;
+    /** end of the window */
+    const uint8_t *end;
+    /** bits cache, first bit in the MSB */
+    uint64_t cache;
+    /** number of valid bits in the cache */
+    unsigned int available;
+    /** true if more bits were read than available in the window */
+    bool overflow;
+    /** unescaped window, with room for a trailing 64-bit load */
+    uint8_t window[UPIPE_H26XF_BITS_WINDOW + 8];
+};
+
+/** @This initializes a bit reader with the start of a NAL unit, removing
+ * escape words. At most @ref UPIPE_H26XF_BITS_WINDOW octets are read.
+ *
+ * @param b bit reader
+ * @param ubuf pointer to block ubuf
+ * @param offset offset of the first octet to read
+ * @param size number of octets available from offset
+ * @return an error code
+ */
+int upipe_h26xf_bits_init(struct upipe_h26xf_bits *b, struct ubuf *ubuf,
+                          size_t offset, size_t size);
+
+/** @internal @This refills the cache with as many whole octets as fit.
+ *
+ * @param b bit reader
+ */
+static inline void upipe_h26xf_bits_refill(struct upipe_h26xf_bits *b)
+{
+    if (b->available > 56 || b->buffer >= b->end)
+        return;
+
+    uint64_t v;
+    memcpy(&v, b->buffer, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    unsigned int octets = (64 - b->available) / 8;
+    if (octets > b->end - b->buffer)
+        octets = b->end - b->buffer;
+    if (octets < 8)
+        v &= UINT64_MAX << (64 - octets * 8);
+    b->cache |= v >> b->available;
+    b->available += octets * 8;
+    b->buffer += octets;
+}
+
+/** @This discards the given number of bits.
+ *
+ * @param b bit reader
+ * @param nb number of bits to discard (at most 32)
+ */
+static inline void upipe_h26xf_bits_skip(struct upipe_h26xf_bits *b,
+                                         unsigned int nb)
+{
+    if (unlikely(nb > b->available)) {
+        upipe_h26xf_bits_refill(b);
+        if (unlikely(nb > b->available)) {
+            b->overflow = true;
+            b->cache = 0;
+            b->available = 0;
+            return;
+        }
+    }
+    b->cache <<= nb;
+    b->available -= nb;
+}
+
+/** @This reads the given number of bits.
+ *
+ * @param b bit reader
+ * @param nb number of bits to read (between 1 and 32)
+ * @return bits read
+ */
+static inline uint32_t upipe_h26xf_bits_read(struct upipe_h26xf_bits *b,
+                                             unsigned int nb)
+{
+    if (unlikely(nb > b->available))
+        upipe_h26xf_bits_refill(b);
+    uint32_t v = b->cache >> (64 - nb);
+    upipe_h26xf_bits_skip(b, nb);
+    return v;
+}
+
+/** @This reads an unsigned exp-golomb code.
+ *
+ * @param b bit reader
+ * @return code read
+ */
+static inline uint32_t upipe_h26xf_bits_ue(struct upipe_h26xf_bits *b)
+{
+    upipe_h26xf_bits_refill(b);
+    unsigned int zeros = likely(b->cache) ? __builtin_clzll(b->cache) : 64;
+    if (unlikely(zeros > 31)) {
+        b->overflow = true;
+        return UINT32_MAX;
+    }
+    upipe_h26xf_bits_skip(b, zeros);
+    return upipe_h26xf_bits_read(b, zeros + 1) - 1;
+}
+
+/** @This reads a signed exp-golomb code.
+ *
+ * @param b bit reader
+ * @return code read
+ */
+static inline int32_t upipe_h26xf_bits_se(struct upipe_h26xf_bits *b)
+{
+    uint32_t v = upipe_h26xf_bits_ue(b);
+
+    return (v & 1) ? (v + 1) / 2 : -(v / 2);
+}
+
 /** @This allocates a ubuf containing an annex B header.
  *
  * @param ubuf_mgr pointer to ubuf manager
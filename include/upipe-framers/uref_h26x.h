@@ -40,6 +40,7 @@ extern "C" {
 
 UREF_ATTR_UNSIGNED_VA(h26x, nal_offset, "h26x.n[%" PRIu64"]", nal offset,
         uint64_t nal, nal)
+UREF_ATTR_VOID(h26x, au_partial, "h26x.au_partial", access unit in progress)
 
 /** @This iterates over the NALs of an uref. Initialize counter_p at 0, and
  * don't modify the arguments between calls to this function.
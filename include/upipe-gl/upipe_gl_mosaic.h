@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe GL mosaic module - composes several pictures on the GPU
+ *
+ * The mosaic pipe forwards its input (the background, which also gives the
+ * rhythm) to a GL sink, and keeps the latest picture of each of its input
+ * subpipes. When the GL sink renders, @ref upipe_gl_mosaic_render uploads
+ * the pending pictures to textures through pixel buffer objects, and draws
+ * them scaled and blended at their configured positions. It is meant to be
+ * called from the rendering probe, see @ref uprobe_gl_mosaic_alloc.
+ */
+
+#ifndef _UPIPE_GL_UPIPE_GL_MOSAIC_H_
+/** @hidden */
+#define _UPIPE_GL_UPIPE_GL_MOSAIC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_GL_MOSAIC_SIGNATURE UBASE_FOURCC('g','l','m','o')
+#define UPIPE_GL_MOSAIC_SUB_SIGNATURE UBASE_FOURCC('g','l','m','s')
+
+/** @This extends upipe_command with specific commands for mosaic pipes. */
+enum upipe_gl_mosaic_command {
+    UPIPE_GL_MOSAIC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** uploads pending pictures and draws the inputs in the current GL
+     * context (void) */
+    UPIPE_GL_MOSAIC_RENDER,
+};
+
+/** @This extends upipe_command with specific commands for mosaic inputs. */
+enum upipe_gl_mosaic_sub_command {
+    UPIPE_GL_MOSAIC_SUB_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** gets the position of the input in the window (double *, double *,
+     * double *, double *) */
+    UPIPE_GL_MOSAIC_SUB_GET_RECT,
+    /** sets the position of the input in the window (double, double,
+     * double, double) */
+    UPIPE_GL_MOSAIC_SUB_SET_RECT,
+    /** sets the alpha multiplier (uint8_t) */
+    UPIPE_GL_MOSAIC_SUB_SET_ALPHA,
+    /** sets the z-index (int) */
+    UPIPE_GL_MOSAIC_SUB_SET_Z_INDEX,
+};
+
+/** @This returns the management structure for all mosaic pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_gl_mosaic_mgr_alloc(void);
+
+/** @This uploads the pending pictures and draws all inputs. It must be
+ * called with the GL context of the sink current, typically upon
+ * UPROBE_GL_SINK_RENDER. The projection maps the window to [0, 1] x [0, 1],
+ * with the origin in the top left corner.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static inline int upipe_gl_mosaic_render(struct upipe *upipe)
+{
+    return upipe_control(upipe, UPIPE_GL_MOSAIC_RENDER,
+                         UPIPE_GL_MOSAIC_SIGNATURE);
+}
+
+/** @This gets the position of an input in the window, as fractions of the
+ * window size.
+ *
+ * @param upipe description structure of the subpipe
+ * @param x_p filled in with the horizontal position of the left border
+ * @param y_p filled in with the vertical position of the top border
+ * @param width_p filled in with the width
+ * @param height_p filled in with the height
+ * @return an error code
+ */
+static inline int upipe_gl_mosaic_sub_get_rect(struct upipe *upipe,
+        double *x_p, double *y_p, double *width_p, double *height_p)
+{
+    return upipe_control(upipe, UPIPE_GL_MOSAIC_SUB_GET_RECT,
+                         UPIPE_GL_MOSAIC_SUB_SIGNATURE,
+                         x_p, y_p, width_p, height_p);
+}
+
+/** @This sets the position of an input in the window, as fractions of the
+ * window size. The picture is scaled to fill the rectangle.
+ *
+ * @param upipe description structure of the subpipe
+ * @param x horizontal position of the left border
+ * @param y vertical position of the top border
+ * @param width width
+ * @param height height
+ * @return an error code
+ */
+static inline int upipe_gl_mosaic_sub_set_rect(struct upipe *upipe,
+        double x, double y, double width, double height)
+{
+    return upipe_control(upipe, UPIPE_GL_MOSAIC_SUB_SET_RECT,
+                         UPIPE_GL_MOSAIC_SUB_SIGNATURE, x, y, width, height);
+}
+
+/** @This sets the alpha multiplier of an input.
+ *
+ * @param upipe description structure of the subpipe
+ * @param alpha alpha multiplier (0xff is opaque)
+ * @return an error code
+ */
+static inline int upipe_gl_mosaic_sub_set_alpha(struct upipe *upipe,
+                                                uint8_t alpha)
+{
+    return upipe_control(upipe, UPIPE_GL_MOSAIC_SUB_SET_ALPHA,
+                         UPIPE_GL_MOSAIC_SUB_SIGNATURE, (unsigned)alpha);
+}
+
+/** @This sets the z-index of an input. Inputs with higher z-index are drawn
+ * on top of the others.
+ *
+ * @param upipe description structure of the subpipe
+ * @param z_index z-index
+ * @return an error code
+ */
+static inline int upipe_gl_mosaic_sub_set_z_index(struct upipe *upipe,
+                                                  int z_index)
+{
+    return upipe_control(upipe, UPIPE_GL_MOSAIC_SUB_SET_Z_INDEX,
+                         UPIPE_GL_MOSAIC_SUB_SIGNATURE, z_index);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe GL sink mosaic renderer
+ */
+
+#ifndef _UPIPE_GL_UPROBE_GL_MOSAIC_H_
+/** @hidden */
+#define _UPIPE_GL_UPROBE_GL_MOSAIC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+#include "upipe-gl/upipe_gl_sink_common.h"
+
+/** @This allocates a gl_mosaic uprobe to render the background picture and
+ * the inputs of a mosaic pipe, in place of @ref uprobe_gl_sink_alloc.
+ *
+ * The probe does not hold a reference to the mosaic pipe, since the mosaic
+ * pipe holds the sink which holds the probe. The mosaic pipe must feed the
+ * sink this probe is attached to.
+ *
+ * @param next probe to test if this one doesn't catch the event
+ * @param mosaic mosaic pipe to render
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_gl_mosaic_alloc(struct uprobe *next,
+                                      struct upipe *mosaic);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module packing pictures into SMPTE ST 2110-20 RTP packets
+ *
+ * Input pictures are YCbCr 4:2:2 10 bits, in a single "u10y10v10y10" plane
+ * of 16-bit native endian samples. The lines are packed directly from the
+ * picture buffer into the payload of the packets, in 5-octet pixel groups,
+ * with the general packing mode of ST 2110-20 (a packet may carry the end of
+ * a line and the beginning of the next one).
+ *
+ * Each output uref is a complete RTP packet, with a 90 kHz timestamp derived
+ * from the pts of the picture and the marker bit set on the last packet of
+ * each frame or field. If the picture is dated, the packets are given a
+ * cr_sys date and a duration according to the ST 2110-21 sender model, so
+ * that a paced sink (udp sink, or netmap sink on "block.rtp." flows) sends
+ * them on time:
+ * @list
+ * @item gapped (type N): packets are sent during the active lines only,
+ * leaving a gap during the vertical blanking
+ * @item linear (type NL): packets are spread over the whole frame period
+ * @end list
+ */
+
+#ifndef _UPIPE_HBRMT_UPIPE_RTP_2110_20_PACK_H_
+/** @hidden */
+#define _UPIPE_HBRMT_UPIPE_RTP_2110_20_PACK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_RTP_2110_20_PACK_SIGNATURE UBASE_FOURCC('r','2','0','p')
+
+/** @This defines the sender types of ST 2110-21. */
+enum upipe_rtp_2110_20_sender {
+    /** packets are sent during the active lines (type N) */
+    UPIPE_RTP_2110_20_SENDER_GAPPED,
+    /** packets are spread over the frame period (type NL) */
+    UPIPE_RTP_2110_20_SENDER_LINEAR,
+};
+
+/** @This extends upipe_command with specific commands for 2110-20 pack. */
+enum upipe_rtp_2110_20_pack_command {
+    UPIPE_RTP_2110_20_PACK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** get the sender type (int *) */
+    UPIPE_RTP_2110_20_PACK_GET_SENDER,
+    /** set the sender type (int) */
+    UPIPE_RTP_2110_20_PACK_SET_SENDER,
+    /** get the maximum size of the RTP payload (unsigned int *) */
+    UPIPE_RTP_2110_20_PACK_GET_PAYLOAD_SIZE,
+    /** set the maximum size of the RTP payload (unsigned int) */
+    UPIPE_RTP_2110_20_PACK_SET_PAYLOAD_SIZE,
+    /** get the RTP payload type (uint8_t *) */
+    UPIPE_RTP_2110_20_PACK_GET_TYPE,
+    /** set the RTP payload type (unsigned int) */
+    UPIPE_RTP_2110_20_PACK_SET_TYPE,
+};
+
+/** @This returns the management structure for 2110-20 pack pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_2110_20_pack_mgr_alloc(void);
+
+/** @This returns the sender type.
+ *
+ * @param upipe description structure of the pipe
+ * @param sender_p filled in with the sender type
+ * @return an error code
+ */
+static inline int
+    upipe_rtp_2110_20_pack_get_sender(struct upipe *upipe,
+                                      enum upipe_rtp_2110_20_sender *sender_p)
+{
+    int sender;
+    UBASE_RETURN(upipe_control(upipe, UPIPE_RTP_2110_20_PACK_GET_SENDER,
+                               UPIPE_RTP_2110_20_PACK_SIGNATURE, &sender))
+    *sender_p = sender;
+    return UBASE_ERR_NONE;
+}
+
+/** @This sets the sender type. The default is gapped.
+ *
+ * @param upipe description structure of the pipe
+ * @param sender sender type
+ * @return an error code
+ */
+static inline int
+    upipe_rtp_2110_20_pack_set_sender(struct upipe *upipe,
+                                      enum upipe_rtp_2110_20_sender sender)
+{
+    return upipe_control(upipe, UPIPE_RTP_2110_20_PACK_SET_SENDER,
+                         UPIPE_RTP_2110_20_PACK_SIGNATURE, (int)sender);
+}
+
+/** @This returns the maximum size of the RTP payload.
+ *
+ * @param upipe description structure of the pipe
+ * @param size_p filled in with the size in octets
+ * @return an error code
+ */
+static inline int upipe_rtp_2110_20_pack_get_payload_size(struct upipe *upipe,
+                                                          unsigned int *size_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_2110_20_PACK_GET_PAYLOAD_SIZE,
+                         UPIPE_RTP_2110_20_PACK_SIGNATURE, size_p);
+}
+
+/** @This sets the maximum size of the RTP payload, after the RTP header.
+ * The default is 1448 octets, the standard UDP size limit of ST 2110-10
+ * minus the RTP header.
+ *
+ * @param upipe description structure of the pipe
+ * @param size size in octets
+ * @return an error code
+ */
+static inline int upipe_rtp_2110_20_pack_set_payload_size(struct upipe *upipe,
+                                                          unsigned int size)
+{
+    return upipe_control(upipe, UPIPE_RTP_2110_20_PACK_SET_PAYLOAD_SIZE,
+                         UPIPE_RTP_2110_20_PACK_SIGNATURE, size);
+}
+
+/** @This returns the RTP payload type.
+ *
+ * @param upipe description structure of the pipe
+ * @param type_p filled in with the payload type
+ * @return an error code
+ */
+static inline int upipe_rtp_2110_20_pack_get_type(struct upipe *upipe,
+                                                  uint8_t *type_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_2110_20_PACK_GET_TYPE,
+                         UPIPE_RTP_2110_20_PACK_SIGNATURE, type_p);
+}
+
+/** @This sets the RTP payload type. The default is 96.
+ *
+ * @param upipe description structure of the pipe
+ * @param type payload type
+ * @return an error code
+ */
+static inline int upipe_rtp_2110_20_pack_set_type(struct upipe *upipe,
+                                                  uint8_t type)
+{
+    return upipe_control(upipe, UPIPE_RTP_2110_20_PACK_SET_TYPE,
+                         UPIPE_RTP_2110_20_PACK_SIGNATURE, (unsigned int)type);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module unpacking SMPTE ST 2110-20 RTP packets into pictures
+ *
+ * The input is a flow of complete RTP packets, as output by the udp, netmap
+ * or AF_XDP sources, carrying YCbCr 4:2:2 10 bits video. Since the format
+ * is not signalled in band, the input flow definition must carry the
+ * picture size (hsize, vsize) and optionally the frame rate and the
+ * progressive and tff attributes, as found in the SDP.
+ *
+ * The pixel groups of each packet are unpacked directly into the lines of
+ * the output picture, a single "u10y10v10y10" plane of 16-bit native endian
+ * samples. A picture is output on the marker bit of its last frame or field,
+ * or when a packet of the next picture is received. Lost packets leave black
+ * areas in the picture.
+ */
+
+#ifndef _UPIPE_HBRMT_UPIPE_RTP_2110_20_UNPACK_H_
+/** @hidden */
+#define _UPIPE_HBRMT_UPIPE_RTP_2110_20_UNPACK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_RTP_2110_20_UNPACK_SIGNATURE UBASE_FOURCC('r','2','0','u')
+
+/** @This returns the management structure for 2110-20 unpack pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_2110_20_unpack_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -50,6 +50,12 @@ enum upipe_hls_playlist_command {
     UPIPE_HLS_PLAYLIST_NEXT,
     /** seek to this offset (uint64_t) */
     UPIPE_HLS_PLAYLIST_SEEK,
+    /** get the prefetch depth (unsigned int *) */
+    UPIPE_HLS_PLAYLIST_GET_PREFETCH,
+    /** set the prefetch depth (unsigned int) */
+    UPIPE_HLS_PLAYLIST_SET_PREFETCH,
+    /** get the estimated bandwidth (uint64_t *) */
+    UPIPE_HLS_PLAYLIST_GET_BANDWIDTH,
 };
 
 /** @This converts m3u playlist specific command to a string.
@@ -66,6 +72,9 @@ static inline const char *upipe_hls_playlist_command_str(int cmd)
     UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_PLAY);
     UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_NEXT);
     UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_SEEK);
+    UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_GET_PREFETCH);
+    UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_SET_PREFETCH);
+    UBASE_CASE_TO_STR(UPIPE_HLS_PLAYLIST_GET_BANDWIDTH);
     case UPIPE_HLS_PLAYLIST_SENTINEL: break;
     }
     return NULL;
@@ -135,6 +144,49 @@ static inline int upipe_hls_playlist_seek(struct upipe *upipe, uint64_t at,
                          UPIPE_HLS_PLAYLIST_SIGNATURE, at, offset_p);
 }
 
+/** @This gets the number of upcoming items downloaded in advance.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch_p filled with the prefetch depth
+ * @return an error code
+ */
+static inline int upipe_hls_playlist_get_prefetch(struct upipe *upipe,
+                                                  unsigned int *prefetch_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_PLAYLIST_GET_PREFETCH,
+                         UPIPE_HLS_PLAYLIST_SIGNATURE, prefetch_p);
+}
+
+/** @This sets the number of upcoming items downloaded in advance, in
+ * parallel with the item being played. The default is 0, each item is
+ * downloaded when it is played.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch prefetch depth
+ * @return an error code
+ */
+static inline int upipe_hls_playlist_set_prefetch(struct upipe *upipe,
+                                                  unsigned int prefetch)
+{
+    return upipe_control(upipe, UPIPE_HLS_PLAYLIST_SET_PREFETCH,
+                         UPIPE_HLS_PLAYLIST_SIGNATURE, prefetch);
+}
+
+/** @This gets the bandwidth estimated from the items downloaded with a
+ * prefetch depth, as a moving average of the download rate of each item.
+ * It requires an uclock to be attached.
+ *
+ * @param upipe description structure of the pipe
+ * @param bandwidth_p filled with the bandwidth in bits per second
+ * @return an error code
+ */
+static inline int upipe_hls_playlist_get_bandwidth(struct upipe *upipe,
+                                                   uint64_t *bandwidth_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_PLAYLIST_GET_BANDWIDTH,
+                         UPIPE_HLS_PLAYLIST_SIGNATURE, bandwidth_p);
+}
+
 /** @This extends @ref uprobe_event with specific m3u playlist events. */
 enum uprobe_hls_playlist_event {
     UPROBE_HLS_PLAYLIST_SENTINEL = UPROBE_LOCAL,
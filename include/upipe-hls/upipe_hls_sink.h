@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe sink module writing HLS segments and playlists
+ *
+ * The input is a muxed stream, typically the output of the TS mux
+ * ("block.mpegts.") or of a fragmented MP4 muxer ("block.mp4."). Segments
+ * are cut on random access points, signalled by the random flag of the
+ * urefs or, for TS, by the random access indicator of video packets, once
+ * the target duration is reached. They are written through an inner file
+ * sink.
+ *
+ * The media playlist is an EVENT playlist, updated by appending the lines
+ * of each new segment, and terminated by an EXT-X-ENDLIST tag when the pipe
+ * is released. If a part duration is set, the segments are also announced
+ * as LL-HLS partial segments, given as byte ranges of the segment file.
+ * If a master playlist is set, the variant is appended to it once its first
+ * segment is written, so that several sinks may share the same master
+ * playlist.
+ */
+
+#ifndef _UPIPE_HLS_UPIPE_HLS_SINK_H_
+/** @hidden */
+# define _UPIPE_HLS_UPIPE_HLS_SINK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_HLS_SINK_SIGNATURE UBASE_FOURCC('h','l','s','s')
+
+/** @This extends upipe_command with specific commands for hls sink. */
+enum upipe_hls_sink_command {
+    UPIPE_HLS_SINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** get the playlist path and the segment prefix
+     * (const char **, const char **) */
+    UPIPE_HLS_SINK_GET_PATH,
+    /** set the playlist path and the segment prefix
+     * (const char *, const char *) */
+    UPIPE_HLS_SINK_SET_PATH,
+    /** get the target duration of the segments (uint64_t *) */
+    UPIPE_HLS_SINK_GET_TARGET_DURATION,
+    /** set the target duration of the segments (uint64_t) */
+    UPIPE_HLS_SINK_SET_TARGET_DURATION,
+    /** get the duration of the partial segments (uint64_t *) */
+    UPIPE_HLS_SINK_GET_PART_DURATION,
+    /** set the duration of the partial segments (uint64_t) */
+    UPIPE_HLS_SINK_SET_PART_DURATION,
+    /** set the path of the master playlist (const char *) */
+    UPIPE_HLS_SINK_SET_MASTER,
+};
+
+/** @This converts hls sink specific commands to a string.
+ *
+ * @param cmd @ref upipe_hls_sink_command to convert
+ * @return a string or NULL if invalid
+ */
+static inline const char *upipe_hls_sink_command_str(int cmd)
+{
+    switch ((enum upipe_hls_sink_command)cmd) {
+    UBASE_CASE_TO_STR(UPIPE_HLS_SINK_GET_PATH);
+    UBASE_CASE_TO_STR(UPIPE_HLS_SINK_SET_PATH);
+    UBASE_CASE_TO_STR(UPIPE_HLS_SINK_GET_TARGET_DURATION);
+    UBASE_CASE_TO_STR(UPIPE_HLS_SINK_SET_TARGET_DURATION);
+    UBASE_CASE_TO_STR(UPIPE_HLS_SINK_GET_PART_DURATION);
+    UBASE_CASE_TO_STR(UPIPE_HLS_SINK_SET_PART_DURATION);
+    UBASE_CASE_TO_STR(UPIPE_HLS_SINK_SET_MASTER);
+    case UPIPE_HLS_SINK_SENTINEL: break;
+    }
+    return NULL;
+}
+
+/** @This returns the management structure for hls sink pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_hls_sink_mgr_alloc(void);
+
+/** @This returns the playlist path and the segment prefix.
+ *
+ * @param upipe description structure of the pipe
+ * @param playlist_p filled in with the path of the media playlist
+ * @param prefix_p filled in with the segment prefix
+ * @return an error code
+ */
+static inline int upipe_hls_sink_get_path(struct upipe *upipe,
+                                          const char **playlist_p,
+                                          const char **prefix_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_GET_PATH,
+                         UPIPE_HLS_SINK_SIGNATURE, playlist_p, prefix_p);
+}
+
+/** @This sets the path of the media playlist and the prefix of the
+ * segments. The segments are named after the prefix, the media sequence
+ * and a suffix depending on the flow definition, and the prefix is relative
+ * to the directory of the playlist. The playlist is overwritten.
+ *
+ * @param upipe description structure of the pipe
+ * @param playlist path of the media playlist
+ * @param prefix segment prefix
+ * @return an error code
+ */
+static inline int upipe_hls_sink_set_path(struct upipe *upipe,
+                                          const char *playlist,
+                                          const char *prefix)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_SET_PATH,
+                         UPIPE_HLS_SINK_SIGNATURE, playlist, prefix);
+}
+
+/** @This returns the target duration of the segments.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration_p filled in with the duration in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upipe_hls_sink_get_target_duration(struct upipe *upipe,
+                                                     uint64_t *duration_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_GET_TARGET_DURATION,
+                         UPIPE_HLS_SINK_SIGNATURE, duration_p);
+}
+
+/** @This sets the target duration of the segments. A segment is cut on
+ * the first random access point after this duration. The default is 6
+ * seconds.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration duration in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upipe_hls_sink_set_target_duration(struct upipe *upipe,
+                                                     uint64_t duration)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_SET_TARGET_DURATION,
+                         UPIPE_HLS_SINK_SIGNATURE, duration);
+}
+
+/** @This returns the duration of the partial segments.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration_p filled in with the duration in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upipe_hls_sink_get_part_duration(struct upipe *upipe,
+                                                   uint64_t *duration_p)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_GET_PART_DURATION,
+                         UPIPE_HLS_SINK_SIGNATURE, duration_p);
+}
+
+/** @This sets the duration of the LL-HLS partial segments. It must be set
+ * before the playlist is created. The default is 0 (no partial segments).
+ *
+ * @param upipe description structure of the pipe
+ * @param duration duration in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upipe_hls_sink_set_part_duration(struct upipe *upipe,
+                                                   uint64_t duration)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_SET_PART_DURATION,
+                         UPIPE_HLS_SINK_SIGNATURE, duration);
+}
+
+/** @This sets the path of a master playlist to append the variant to.
+ *
+ * @param upipe description structure of the pipe
+ * @param master path of the master playlist, or NULL
+ * @return an error code
+ */
+static inline int upipe_hls_sink_set_master(struct upipe *upipe,
+                                            const char *master)
+{
+    return upipe_control(upipe, UPIPE_HLS_SINK_SET_MASTER,
+                         UPIPE_HLS_SINK_SIGNATURE, master);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* !_UPIPE_HLS_UPIPE_HLS_SINK_H_ */
@@ -29,6 +29,16 @@ extern "C" {
 
 #define UPIPE_AES_DECRYPT_SIGNATURE     UBASE_FOURCC('a','e','s','d')
 
+/** @This returns the management structure for aes decrypt pipes.
+ *
+ * All the complete 16-octet blocks received are decrypted at once, in place
+ * unless the buffers are shared, with AES-NI or the ARMv8 cryptographic
+ * extension when available. To keep large segments from stalling the
+ * event loop, the pipe may be run in a worker thread with
+ * upipe-modules/upipe_worker_linear.h.
+ *
+ * @return pointer to manager
+ */
 struct upipe_mgr *upipe_aes_decrypt_mgr_alloc(void);
 
 #ifdef __cplusplus
@@ -28,7 +28,11 @@
  *
  * The buffer pipe directly forwards the input uref if it can. When the output
  * upump is blocked by the output pipe, the buffer pipe still accepts the input
- * uref until the maximum size is reached.
+ * uref until the maximum size or duration is reached.
+ *
+ * Several buffer pipes, possibly running in different threads, may share a
+ * memory budget. When the budget is exhausted, a buffer pipe first drops its
+ * oldest non random access urefs, then the incoming urefs.
  */
 
 #ifndef _UPIPE_MODULES_UPIPE_BUFFER_H_
@@ -42,6 +46,9 @@ extern "C" {
 
 #define UPIPE_BUFFER_SIGNATURE UBASE_FOURCC('b','u','f','f')
 
+/** @hidden */
+struct upipe_buffer_budget;
+
 /** @This extends @ref upipe_command with specific buffer commands. */
 enum upipe_buffer_command {
     UPIPE_BUFFER_SENTINEL = UPIPE_CONTROL_LOCAL,
@@ -58,6 +65,12 @@ enum upipe_buffer_command {
     UPIPE_BUFFER_SET_HIGH,
     /** get the high limit in octet (uint64_t *) */
     UPIPE_BUFFER_GET_HIGH,
+    /** set the maximum retained duration (uint64_t) */
+    UPIPE_BUFFER_SET_MAX_DURATION,
+    /** get the maximum retained duration (uint64_t *) */
+    UPIPE_BUFFER_GET_MAX_DURATION,
+    /** set the shared memory budget (struct upipe_buffer_budget *) */
+    UPIPE_BUFFER_SET_BUDGET,
 };
 
 /** @This converts @ref upipe_buffer_command to a string.
@@ -74,6 +87,9 @@ static inline const char *upipe_buffer_command_str(int command)
     UBASE_CASE_TO_STR(UPIPE_BUFFER_GET_LOW);
     UBASE_CASE_TO_STR(UPIPE_BUFFER_SET_HIGH);
     UBASE_CASE_TO_STR(UPIPE_BUFFER_GET_HIGH);
+    UBASE_CASE_TO_STR(UPIPE_BUFFER_SET_MAX_DURATION);
+    UBASE_CASE_TO_STR(UPIPE_BUFFER_GET_MAX_DURATION);
+    UBASE_CASE_TO_STR(UPIPE_BUFFER_SET_BUDGET);
     case UPIPE_BUFFER_SENTINEL: break;
     }
     return NULL;
@@ -157,6 +173,46 @@ static inline int upipe_buffer_get_high_limit(struct upipe *upipe,
                          UPIPE_BUFFER_SIGNATURE, high_limit_p);
 }
 
+/** @This sets the maximum retained duration. The duration is the difference
+ * between the last received uref DTS and the first retained uref DTS.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_duration the maximum duration in 27MHz ticks, or 0 for no limit
+ * @return an error code
+ */
+static inline int upipe_buffer_set_max_duration(struct upipe *upipe,
+                                                uint64_t max_duration)
+{
+    return upipe_control(upipe, UPIPE_BUFFER_SET_MAX_DURATION,
+                         UPIPE_BUFFER_SIGNATURE, max_duration);
+}
+
+/** @This gets the maximum retained duration.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_duration_p a pointer to the maximum duration
+ * @return an error code
+ */
+static inline int upipe_buffer_get_max_duration(struct upipe *upipe,
+                                                uint64_t *max_duration_p)
+{
+    return upipe_control(upipe, UPIPE_BUFFER_GET_MAX_DURATION,
+                         UPIPE_BUFFER_SIGNATURE, max_duration_p);
+}
+
+/** @This sets the memory budget shared with other buffer pipes.
+ *
+ * @param upipe description structure of the pipe
+ * @param budget shared budget, or NULL to remove it
+ * @return an error code
+ */
+static inline int upipe_buffer_set_budget(struct upipe *upipe,
+                                          struct upipe_buffer_budget *budget)
+{
+    return upipe_control(upipe, UPIPE_BUFFER_SET_BUDGET,
+                         UPIPE_BUFFER_SIGNATURE, budget);
+}
+
 /** @This is the buffer pipe states. */
 enum upipe_buffer_state {
     /** under the low limit */
@@ -210,6 +266,36 @@ static inline const char *upipe_buffer_event_str(int event)
  */
 struct upipe_mgr *upipe_buffer_mgr_alloc(void);
 
+/** @This allocates a memory budget to share between buffer pipes.
+ *
+ * @param max_size maximum size of all the urefs retained by the buffer pipes
+ * using the budget, in octets
+ * @return a pointer to the budget, or NULL in case of allocation error
+ */
+struct upipe_buffer_budget *upipe_buffer_budget_alloc(uint64_t max_size);
+
+/** @This increments the reference count of a budget.
+ *
+ * @param budget pointer to the budget
+ * @return same pointer to the budget
+ */
+struct upipe_buffer_budget *
+    upipe_buffer_budget_use(struct upipe_buffer_budget *budget);
+
+/** @This decrements the reference count of a budget, and frees it when it
+ * reaches 0.
+ *
+ * @param budget pointer to the budget
+ */
+void upipe_buffer_budget_release(struct upipe_buffer_budget *budget);
+
+/** @This returns the size currently accounted against a budget.
+ *
+ * @param budget pointer to the budget
+ * @return the total size of the retained urefs in octets
+ */
+uint64_t upipe_buffer_budget_get_size(struct upipe_buffer_budget *budget);
+
 #ifdef __cplusplus
 }
 #endif
@@ -69,6 +69,12 @@ enum upipe_fsink_command {
     UPIPE_FSINK_SET_SYNC_PERIOD,
     /** gets fdatasync period (uint64_t *) */
     UPIPE_FSINK_GET_SYNC_PERIOD,
+    /** sets asynchronous write mode (unsigned int, size_t, int) */
+    UPIPE_FSINK_SET_ASYNC,
+    /** gets asynchronous write mode (unsigned int *, size_t *, int *) */
+    UPIPE_FSINK_GET_ASYNC,
+    /** preallocates the next opened file (uint64_t) */
+    UPIPE_FSINK_SET_PREALLOCATE,
 
     /** outer pipes commands begin here */
     UPIPE_FSINK_CONTROL_LOCAL = UPIPE_CONTROL_LOCAL + 0x1000
@@ -162,6 +168,56 @@ static inline int upipe_fsink_set_sync_period(struct upipe *upipe,
                          UPIPE_FSINK_SIGNATURE, sync_period);
 }
 
+/** @This sets the asynchronous write mode. Buffers are then copied to
+ * staging chunks, which are written, synced and closed by a dedicated
+ * thread, so that slow disks do not stall the event loop. With direct mode,
+ * files are opened with O_DIRECT and chunks are aligned, to keep captured
+ * data out of the page cache. It must be called while no file is opened.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_chunks number of staging chunks, or 0 to write synchronously
+ * @param chunk_size size of a staging chunk, rounded up to a multiple of 4096
+ * @param direct true to open files with O_DIRECT
+ * @return an error code
+ */
+static inline int upipe_fsink_set_async(struct upipe *upipe,
+                                        unsigned int nb_chunks,
+                                        size_t chunk_size, bool direct)
+{
+    return upipe_control(upipe, UPIPE_FSINK_SET_ASYNC, UPIPE_FSINK_SIGNATURE,
+                         nb_chunks, chunk_size, direct ? 1 : 0);
+}
+
+/** @This returns the asynchronous write mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_chunks_p filled in with the number of staging chunks
+ * @param chunk_size_p filled in with the size of a staging chunk
+ * @param direct_p filled in with true if files are opened with O_DIRECT
+ * @return an error code
+ */
+static inline int upipe_fsink_get_async(struct upipe *upipe,
+                                        unsigned int *nb_chunks_p,
+                                        size_t *chunk_size_p, int *direct_p)
+{
+    return upipe_control(upipe, UPIPE_FSINK_GET_ASYNC, UPIPE_FSINK_SIGNATURE,
+                         nb_chunks_p, chunk_size_p, direct_p);
+}
+
+/** @This asks to preallocate space in the next opened file, without changing
+ * its apparent size. Space beyond the written data is released on close.
+ *
+ * @param upipe description structure of the pipe
+ * @param size number of octets to preallocate, or 0
+ * @return an error code
+ */
+static inline int upipe_fsink_set_preallocate(struct upipe *upipe,
+                                              uint64_t size)
+{
+    return upipe_control(upipe, UPIPE_FSINK_SET_PREALLOCATE,
+                         UPIPE_FSINK_SIGNATURE, size);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,51 @@ extern "C" {
 
 #define UPIPE_FSRC_SIGNATURE UBASE_FOURCC('f','s','r','c')
 
+/** @This extends upipe_command with specific commands for file source. */
+enum upipe_fsrc_command {
+    UPIPE_FSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets memory-mapped read mode (int, uint64_t) */
+    UPIPE_FSRC_SET_MMAP,
+    /** gets memory-mapped read mode (int *, uint64_t *) */
+    UPIPE_FSRC_GET_MMAP
+};
+
+/** @This sets the memory-mapped read mode, which must be done before
+ * opening a file. In this mode regular files are mapped read-only, and
+ * output blocks point directly into the page cache instead of being copied
+ * into buffers allocated from the ubuf manager. Such blocks cannot be
+ * written to, and the mapping is kept until the last of them is freed.
+ * Please note that truncating the file while it is being read causes
+ * SIGBUS.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to map regular files
+ * @param readahead number of octets ahead of the read position for which a
+ * readahead hint is given to the kernel, or 0
+ * @return an error code
+ */
+static inline int upipe_fsrc_set_mmap(struct upipe *upipe, bool enable,
+                                      uint64_t readahead)
+{
+    return upipe_control(upipe, UPIPE_FSRC_SET_MMAP, UPIPE_FSRC_SIGNATURE,
+                         enable ? 1 : 0, readahead);
+}
+
+/** @This returns the memory-mapped read mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable_p filled in with true if regular files are mapped
+ * @param readahead_p filled in with the readahead window, in octets
+ * @return an error code
+ */
+static inline int upipe_fsrc_get_mmap(struct upipe *upipe, int *enable_p,
+                                      uint64_t *readahead_p)
+{
+    return upipe_control(upipe, UPIPE_FSRC_GET_MMAP, UPIPE_FSRC_SIGNATURE,
+                         enable_p, readahead_p);
+}
+
 /** @This returns the management structure for all file sources.
  *
  * @return pointer to manager
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module running a chain of stateless pipes in a single pipe
+ *
+ * Stages are pipes exporting an in-place process function through
+ * @ref upipe_get_process. The fused pipe calls each stage's process
+ * function directly on the uref, so no intermediate output, flow
+ * definition negotiation or request forwarding happens per uref.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_FUSED_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_FUSED_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_FUSED_SIGNATURE UBASE_FOURCC('f','u','s','e')
+
+/** @This extends upipe_command with specific commands for fused pipes. */
+enum upipe_fused_command {
+    UPIPE_FUSED_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** appends a stage to the chain (struct upipe *) */
+    UPIPE_FUSED_ADD_STAGE
+};
+
+/** @This returns the management structure for all fused pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_fused_mgr_alloc(void);
+
+/** @This appends a stage to the chain. The stage must support
+ * @ref upipe_get_process, and is kept by the fused pipe until it is freed.
+ * Its output is never used.
+ *
+ * @param upipe description structure of the pipe
+ * @param stage pipe to append
+ * @return an error code
+ */
+static inline int upipe_fused_add_stage(struct upipe *upipe,
+                                        struct upipe *stage)
+{
+    return upipe_control(upipe, UPIPE_FUSED_ADD_STAGE,
+                         UPIPE_FUSED_SIGNATURE, stage);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -41,6 +41,9 @@ extern "C" {
 #include <stdint.h>
 #include "upipe/upipe.h"
 #include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_pic.h"
 
 #define UPIPE_GENAUX_SIGNATURE UBASE_FOURCC('g','a','u','x')
 
@@ -81,6 +84,24 @@ static inline int upipe_genaux_get_getattr(struct upipe *upipe,
                          UPIPE_GENAUX_SIGNATURE, get);
 }
 
+/** @This is a getter for @ref upipe_genaux_set_getattr which only accepts
+ * key frames, and returns their random access point. Placed after a framer,
+ * the genaux pipe then generates an index of random access points, which
+ * may be written with a file sink and passed to multicat sources in the
+ * msrc.rap flow attribute, so that seeks start from a random access point.
+ *
+ * @param uref uref structure
+ * @param rap_p filled in with the random access point
+ * @return an error code
+ */
+static inline int upipe_genaux_get_rap_sys(struct uref *uref, uint64_t *rap_p)
+{
+    if (!ubase_check(uref_pic_get_key(uref)) &&
+        !ubase_check(uref_flow_get_random(uref)))
+        return UBASE_ERR_INVALID;
+    return uref_clock_get_rap_sys(uref, rap_p);
+}
+
 /** @This returns the management structure for genaux pipes.
  *
  * @return pointer to manager
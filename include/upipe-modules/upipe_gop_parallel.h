@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module encoding segments of pictures on several encoders
+ *
+ * The incoming picture stream is cut into segments of a fixed number of
+ * pictures, which are dispatched in turn to the encoders added to the pipe.
+ * The first picture of each segment is flagged as a key frame, so that
+ * every segment starts a closed GOP. The outputs of the encoders are then
+ * reordered into a single elementary stream.
+ *
+ * Encoders are typically wrapped in a worker pipe (see
+ * @ref upipe_wlin_alloc) so that segments are encoded concurrently. They
+ * must output exactly one buffer per input picture, and honour the forced
+ * slice type of the first picture of each segment (slice type enforcement).
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_GOP_PARALLEL_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_GOP_PARALLEL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_GOPP_SIGNATURE UBASE_FOURCC('g','o','p','p')
+#define UPIPE_GOPP_SUB_SIGNATURE UBASE_FOURCC('g','o','p','s')
+
+/** @This extends upipe_command with specific commands for gop parallel
+ * pipes. */
+enum upipe_gopp_command {
+    UPIPE_GOPP_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** adds an encoder (struct upipe *) */
+    UPIPE_GOPP_ADD_ENCODER,
+    /** returns the number of pictures per segment (unsigned int *) */
+    UPIPE_GOPP_GET_SEGMENT_SIZE,
+    /** sets the number of pictures per segment (unsigned int) */
+    UPIPE_GOPP_SET_SEGMENT_SIZE,
+};
+
+/** @This adds an encoder to a gop parallel pipe. The pipe keeps a reference
+ * on the encoder and sets its output. Encoders may only be added before the
+ * first picture is received.
+ *
+ * @param upipe description structure of the pipe
+ * @param encoder encoder pipe
+ * @return an error code
+ */
+static inline int upipe_gopp_add_encoder(struct upipe *upipe,
+                                         struct upipe *encoder)
+{
+    return upipe_control(upipe, UPIPE_GOPP_ADD_ENCODER, UPIPE_GOPP_SIGNATURE,
+                         encoder);
+}
+
+/** @This returns the number of pictures per segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param segment_size_p filled in with the number of pictures
+ * @return an error code
+ */
+static inline int upipe_gopp_get_segment_size(struct upipe *upipe,
+                                              unsigned int *segment_size_p)
+{
+    return upipe_control(upipe, UPIPE_GOPP_GET_SEGMENT_SIZE,
+                         UPIPE_GOPP_SIGNATURE, segment_size_p);
+}
+
+/** @This sets the number of pictures per segment. It should be a multiple
+ * of the GOP size of the encoders.
+ *
+ * @param upipe description structure of the pipe
+ * @param segment_size number of pictures
+ * @return an error code
+ */
+static inline int upipe_gopp_set_segment_size(struct upipe *upipe,
+                                              unsigned int segment_size)
+{
+    return upipe_control(upipe, UPIPE_GOPP_SET_SEGMENT_SIZE,
+                         UPIPE_GOPP_SIGNATURE, segment_size);
+}
+
+/** @This returns the management structure for all gop parallel pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_gopp_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
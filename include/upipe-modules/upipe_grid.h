@@ -75,6 +75,32 @@ static inline int upipe_grid_set_max_retention(struct upipe *upipe,
 struct upipe *upipe_grid_alloc_input(struct upipe *upipe,
                                      struct uprobe *uprobe);
 
+/** @This enumerates the grid input control commands. */
+enum upipe_grid_in_command {
+    /** sentinel */
+    UPIPE_GRID_IN_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** set the tile size of the input pictures (uint64_t, uint64_t) */
+    UPIPE_GRID_IN_SET_TILE_SIZE,
+};
+
+/** @This sets the tile size of a grid input pipe. When set, the input
+ * pictures are downscaled once on reception to the tile size, so that the
+ * outputs only have to copy them. The size is rounded down to the chroma
+ * subsampling of the input, and only planar 8 bits formats are scaled.
+ *
+ * @param upipe description structure of the input pipe
+ * @param hsize tile horizontal size, or 0 to keep the input size
+ * @param vsize tile vertical size, or 0 to keep the input size
+ * @return an error code
+ */
+static inline int upipe_grid_in_set_tile_size(struct upipe *upipe,
+                                              uint64_t hsize, uint64_t vsize)
+{
+    return upipe_control(upipe, UPIPE_GRID_IN_SET_TILE_SIZE,
+                         UPIPE_GRID_IN_SIGNATURE, hsize, vsize);
+}
+
 /** @This enumerates the grid output control commands. */
 enum upipe_grid_out_command {
     /** sentinel */
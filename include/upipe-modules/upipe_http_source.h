@@ -62,6 +62,9 @@ struct upipe_http_src_hook {
         /** called when there is space for data to write */
         ssize_t (*write)(struct upipe_http_src_hook *, const uint8_t *, size_t);
     } data;
+    /** returns the application protocol negotiated by the transport, or
+     * NULL, may be NULL if the transport does not negotiate */
+    const char *(*protocol)(struct upipe_http_src_hook *);
 };
 
 static inline struct upipe_http_src_hook *
@@ -144,6 +147,16 @@ enum upipe_http_src_command {
     UPIPE_HTTP_SRC_SET_PROXY,
     /** set the http read/write timeout (uint64_t) */
     UPIPE_HTTP_SRC_SET_TIMEOUT,
+    /** get the number of parallel range requests and their size
+     * (unsigned int *, uint64_t *) */
+    UPIPE_HTTP_SRC_GET_PARALLEL,
+    /** set the number of parallel range requests and their size
+     * (unsigned int, uint64_t) */
+    UPIPE_HTTP_SRC_SET_PARALLEL,
+    /** get the HTTP/2 weight of the request (unsigned int *) */
+    UPIPE_HTTP_SRC_GET_WEIGHT,
+    /** set the HTTP/2 weight of the request (unsigned int) */
+    UPIPE_HTTP_SRC_SET_WEIGHT,
 };
 
 /** @This converts an enum upipe_http_src_command to a string.
@@ -156,6 +169,10 @@ static inline const char *upipe_http_src_command_str(int cmd)
     switch ((enum upipe_http_src_command)cmd) {
     UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_SET_PROXY);
     UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_SET_TIMEOUT);
+    UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_GET_PARALLEL);
+    UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_SET_PARALLEL);
+    UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_GET_WEIGHT);
+    UBASE_CASE_TO_STR(UPIPE_HTTP_SRC_SET_WEIGHT);
     case UPIPE_HTTP_SRC_SENTINEL: break;
     }
     return NULL;
@@ -187,6 +204,77 @@ static inline int upipe_http_src_set_timeout(struct upipe *upipe,
                          UPIPE_HTTP_SRC_SIGNATURE, timeout);
 }
 
+/** @This returns the number of parallel range requests and their size.
+ *
+ * @param upipe description structure of the pipe
+ * @param parallel_p filled in with the number of parallel requests
+ * @param chunk_size_p filled in with the size of each range in octets
+ * @return an error code
+ */
+static inline int upipe_http_src_get_parallel(struct upipe *upipe,
+                                              unsigned int *parallel_p,
+                                              uint64_t *chunk_size_p)
+{
+    return upipe_control(upipe, UPIPE_HTTP_SRC_GET_PARALLEL,
+                         UPIPE_HTTP_SRC_SIGNATURE, parallel_p, chunk_size_p);
+}
+
+/** @This sets the number of parallel range requests and their size.
+ *
+ * If parallel is greater than 1, the next opened url (or the range set
+ * with @ref upipe_src_set_range) is split into ranges of chunk_size octets,
+ * and up to parallel of them are downloaded at the same time by inner http
+ * sources allocated from the same manager, and so sharing its idle
+ * connections. The ranges are output in order, so that at most about
+ * parallel * chunk_size octets are buffered. The size of the resource is
+ * found in the Content-Range header of the first reply; if the server
+ * ignores the Range header, the resource is downloaded by a single request.
+ *
+ * @param upipe description structure of the pipe
+ * @param parallel number of parallel requests, 0 or 1 to disable
+ * @param chunk_size size of each range in octets
+ * @return an error code
+ */
+static inline int upipe_http_src_set_parallel(struct upipe *upipe,
+                                              unsigned int parallel,
+                                              uint64_t chunk_size)
+{
+    return upipe_control(upipe, UPIPE_HTTP_SRC_SET_PARALLEL,
+                         UPIPE_HTTP_SRC_SIGNATURE, parallel, chunk_size);
+}
+
+/** @This returns the HTTP/2 weight of the request.
+ *
+ * @param upipe description structure of the pipe
+ * @param weight_p filled in with the weight
+ * @return an error code
+ */
+static inline int upipe_http_src_get_weight(struct upipe *upipe,
+                                            unsigned int *weight_p)
+{
+    return upipe_control(upipe, UPIPE_HTTP_SRC_GET_WEIGHT,
+                         UPIPE_HTTP_SRC_SIGNATURE, weight_p);
+}
+
+/** @This sets the HTTP/2 weight of the request.
+ *
+ * When the request is multiplexed on a HTTP/2 connection, the server shares
+ * the bandwidth between the concurrent requests in proportion to their
+ * weights, for instance to download the playlists and keys before the
+ * segments. The weight applies to the request being downloaded, if any, and
+ * to the next ones. It is ignored on HTTP/1.1 connections.
+ *
+ * @param upipe description structure of the pipe
+ * @param weight weight between 1 and 256, 16 by default
+ * @return an error code
+ */
+static inline int upipe_http_src_set_weight(struct upipe *upipe,
+                                            unsigned int weight)
+{
+    return upipe_control(upipe, UPIPE_HTTP_SRC_SET_WEIGHT,
+                         UPIPE_HTTP_SRC_SIGNATURE, weight);
+}
+
 /** @This extends upipe_mgr_command with specific commands for http source. */
 enum upipe_http_src_mgr_command {
     UPIPE_HTTP_SRC_MGR_SENTINEL = UPIPE_MGR_CONTROL_LOCAL,
@@ -200,6 +288,11 @@ enum upipe_http_src_mgr_command {
     UPIPE_HTTP_SRC_MGR_SET_COOKIE,
     /** iterate over cookies */
     UPIPE_HTTP_SRC_MGR_ITERATE_COOKIE,
+
+    /** get the HTTP/2 mode (bool *) */
+    UPIPE_HTTP_SRC_MGR_GET_HTTP2,
+    /** set the HTTP/2 mode (int) */
+    UPIPE_HTTP_SRC_MGR_SET_HTTP2,
 };
 
 /** @This sets the proxy url to use by default for the new allocated pipes.
@@ -258,7 +351,45 @@ static inline int upipe_http_src_mgr_iterate_cookie(struct upipe_mgr *mgr,
                              UPIPE_HTTP_SRC_SIGNATURE, domain, path, uchain_p);
 }
 
+/** @This returns whether the pipes of the manager use HTTP/2.
+ *
+ * @param mgr pointer to upipe manager
+ * @param http2_p filled in with true if HTTP/2 is enabled
+ * @return an error code
+ */
+static inline int upipe_http_src_mgr_get_http2(struct upipe_mgr *mgr,
+                                               bool *http2_p)
+{
+    return upipe_mgr_control(mgr, UPIPE_HTTP_SRC_MGR_GET_HTTP2,
+                             UPIPE_HTTP_SRC_SIGNATURE, http2_p);
+}
+
+/** @This enables HTTP/2 for the pipes of the manager.
+ *
+ * The requests of the pipes to the same scheme, host and port are then
+ * multiplexed as streams of a single HTTP/2 connection kept by the manager.
+ * HTTP/2 is negotiated with ALPN over TLS, if the scheme hook supports it,
+ * and used with prior knowledge for plain http; the origins that do not
+ * support it are remembered and requested with HTTP/1.1. HTTP/2 is not
+ * used through a proxy.
+ *
+ * @param mgr pointer to upipe manager
+ * @param http2 true to enable HTTP/2
+ * @return an error code
+ */
+static inline int upipe_http_src_mgr_set_http2(struct upipe_mgr *mgr,
+                                               bool http2)
+{
+    return upipe_mgr_control(mgr, UPIPE_HTTP_SRC_MGR_SET_HTTP2,
+                             UPIPE_HTTP_SRC_SIGNATURE, http2 ? 1 : 0);
+}
+
 /** @This returns the management structure for all http sources.
+ *
+ * The manager keeps the connections of completed HTTP/1.1 keep-alive
+ * replies, and the pipes it allocates reuse them for their next request to
+ * the same scheme, host and port (or proxy), saving the TCP and TLS
+ * handshakes.
  *
  * @return pointer to manager
  */
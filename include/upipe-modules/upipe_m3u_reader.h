@@ -27,14 +27,73 @@
 extern "C" {
 #endif
 
+#include "upipe/upipe.h"
+
 # define UPIPE_M3U_READER_SIGNATURE UBASE_FOURCC('m','3','u','r')
 
+/** @This extends upipe_command with specific commands for m3u reader. */
+enum upipe_m3u_reader_command {
+    UPIPE_M3U_READER_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** get the incremental mode (int *) */
+    UPIPE_M3U_READER_GET_INCREMENTAL,
+    /** set the incremental mode (int) */
+    UPIPE_M3U_READER_SET_INCREMENTAL,
+};
+
+/** @This converts m3u reader specific commands to a string.
+ *
+ * @param cmd @ref upipe_m3u_reader_command to convert
+ * @return a string or NULL if invalid
+ */
+static inline const char *upipe_m3u_reader_command_str(int cmd)
+{
+    switch ((enum upipe_m3u_reader_command)cmd) {
+    UBASE_CASE_TO_STR(UPIPE_M3U_READER_GET_INCREMENTAL);
+    UBASE_CASE_TO_STR(UPIPE_M3U_READER_SET_INCREMENTAL);
+    case UPIPE_M3U_READER_SENTINEL: break;
+    }
+    return NULL;
+}
+
 /** @This returns the management structure for m3u reader.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_m3u_reader_mgr_alloc(void);
 
+/** @This returns the incremental mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param incremental_p filled in with true if the mode is enabled
+ * @return an error code
+ */
+static inline int upipe_m3u_reader_get_incremental(struct upipe *upipe,
+                                                   int *incremental_p)
+{
+    return upipe_control(upipe, UPIPE_M3U_READER_GET_INCREMENTAL,
+                         UPIPE_M3U_READER_SIGNATURE, incremental_p);
+}
+
+/** @This enables or disables the incremental mode. When a media playlist is
+ * reloaded, the items already output on the previous load are recognised by
+ * their media sequence: they are skipped without being parsed, and only the
+ * new items are output, with the append flag set on the flow definition.
+ * Items removed from the head of the playlist are deduced from the new
+ * media sequence. A full playlist is output again if the media sequence
+ * goes backwards or skips items that were never output.
+ *
+ * @param upipe description structure of the pipe
+ * @param incremental true to enable the mode
+ * @return an error code
+ */
+static inline int upipe_m3u_reader_set_incremental(struct upipe *upipe,
+                                                   int incremental)
+{
+    return upipe_control(upipe, UPIPE_M3U_READER_SET_INCREMENTAL,
+                         UPIPE_M3U_READER_SIGNATURE, incremental);
+}
+
 #ifdef __cplusplus
 }
 #endif
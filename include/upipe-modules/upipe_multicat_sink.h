@@ -64,7 +64,11 @@ enum upipe_multicat_sink_command {
     /** sets fsink manager (struct upipe_fsink_mgr *) */
     UPIPE_MULTICAT_SINK_SET_FSINK_MGR,
     /** gets fsink manager (struct upipe_fsink_mgr **) */
-    UPIPE_MULTICAT_SINK_GET_FSINK_MGR
+    UPIPE_MULTICAT_SINK_GET_FSINK_MGR,
+    /** preallocates each file with the size of the previous one (int) */
+    UPIPE_MULTICAT_SINK_SET_PREALLOCATE,
+    /** writes the time index of the files to the given path (const char *) */
+    UPIPE_MULTICAT_SINK_SET_INDEX
 };
 
 /** @This returns the management structure for multicat_sink pipes.
@@ -178,6 +182,39 @@ static inline int
                                 UPIPE_MULTICAT_SINK_SIGNATURE, fsink_mgr);
 }
 
+/** @This enables preallocation of each new file with the size written to
+ * the previous one, which reduces fragmentation of 24/7 captures.
+ * @see upipe_fsink_set_preallocate
+ *
+ * @param upipe description structure of the pipe
+ * @param preallocate true to preallocate files
+ * @return an error code
+ */
+static inline int
+    upipe_multicat_sink_set_preallocate(struct upipe *upipe, bool preallocate)
+{
+    return upipe_control(upipe, UPIPE_MULTICAT_SINK_SET_PREALLOCATE,
+                         UPIPE_MULTICAT_SINK_SIGNATURE, preallocate ? 1 : 0);
+}
+
+/** @This asks to append a record to the given index file each time a new
+ * file is started, so that @ref upipe_msrc_mgr_alloc can find the file
+ * containing a given time with a binary search. Each record is 16 octets
+ * long, and contains the cr_sys of the first uref of the file and the file
+ * index, both as big-endian 64-bit integers. Records are only appended if
+ * they are after the last record of the index, which keeps it sorted.
+ *
+ * @param upipe description structure of the pipe
+ * @param path path of the index file, or NULL to stop indexing
+ * @return an error code
+ */
+static inline int
+    upipe_multicat_sink_set_index(struct upipe *upipe, const char *path)
+{
+    return upipe_control(upipe, UPIPE_MULTICAT_SINK_SET_INDEX,
+                         UPIPE_MULTICAT_SINK_SIGNATURE, path);
+}
+
 #ifdef __cplusplus
 }
 #endif
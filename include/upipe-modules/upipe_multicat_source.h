@@ -44,17 +44,72 @@ UREF_ATTR_STRING(msrc_flow, data, "msrc.data", data suffix)
 UREF_ATTR_STRING(msrc_flow, aux, "msrc.aux", aux suffix)
 UREF_ATTR_UNSIGNED(msrc_flow, rotate, "msrc.rotate", rotate interval)
 UREF_ATTR_UNSIGNED(msrc_flow, offset, "msrc.offset", rotate offset)
+UREF_ATTR_STRING(msrc_flow, index, "msrc.index", index file path)
+UREF_ATTR_STRING(msrc_flow, rap, "msrc.rap", random access point index path)
 
 #define UPIPE_MSRC_SIGNATURE UBASE_FOURCC('m','s','r','c')
 #define UPIPE_MSRC_DEF_ROTATE UINT64_C(97200000000)
 #define UPIPE_MSRC_DEF_OFFSET UINT64_C(0)
 
+/** @This extends upipe_command with specific commands for msrc pipes. */
+enum upipe_msrc_command {
+    UPIPE_MSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets memory-mapped read mode (int) */
+    UPIPE_MSRC_SET_MMAP,
+    /** gets memory-mapped read mode (int *) */
+    UPIPE_MSRC_GET_MMAP
+};
+
 /** @This returns the management structure for msrc pipes.
+ *
+ * If the input flow definition has an index file path, written by
+ * @ref upipe_multicat_sink_set_index, the file containing a position and the
+ * file following the current one are found with a binary search of the
+ * index, instead of being deduced from the rotate interval. This supports
+ * archives with missing files or a changing rotate interval.
+ *
+ * If the input flow definition has a random access point index path, usually
+ * written from a framer output with @ref upipe_genaux_get_rap_sys, reading
+ * starts from the last random access point before the requested position, so
+ * that downstream pipes do not have to frame and discard the data preceding
+ * it.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_msrc_mgr_alloc(void);
 
+/** @This sets the memory-mapped read mode. In this mode the data files of
+ * the segments are mapped read-only, and output blocks point directly into
+ * the page cache instead of being copied into buffers allocated from the
+ * ubuf manager, the aux files still giving the date of each block. Such
+ * blocks cannot be written to, and a sink able to send from the page cache,
+ * such as @ref upipe_udpsink_set_zerocopy, then plays the archive out
+ * without any copy in user space. Please note that truncating a segment
+ * while it is being read causes SIGBUS.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to map the data files
+ * @return an error code
+ */
+static inline int upipe_msrc_set_mmap(struct upipe *upipe, bool enable)
+{
+    return upipe_control(upipe, UPIPE_MSRC_SET_MMAP, UPIPE_MSRC_SIGNATURE,
+                         enable ? 1 : 0);
+}
+
+/** @This returns the memory-mapped read mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable_p filled in with true if the data files are mapped
+ * @return an error code
+ */
+static inline int upipe_msrc_get_mmap(struct upipe *upipe, int *enable_p)
+{
+    return upipe_control(upipe, UPIPE_MSRC_GET_MMAP, UPIPE_MSRC_SIGNATURE,
+                         enable_p);
+}
+
 #ifdef __cplusplus
 }
 #endif
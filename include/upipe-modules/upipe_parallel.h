@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe module processing frames concurrently on several workers
+ *
+ * The incoming frames are dispatched to the workers added to the pipe,
+ * either in turn or to the worker with the fewest frames in flight, and
+ * the outputs of the workers are put back into the original order, using a
+ * sequence number attached to each frame.
+ *
+ * Workers are typically copies of a stateless per-frame pipe (scaler,
+ * blitter, packer...) each wrapped in a worker pipe (see
+ * @ref upipe_wlin_alloc) so that frames are processed concurrently. They
+ * must output at most one buffer per input frame and keep its attributes.
+ * A frame dropped by a worker is skipped when the next frame of the same
+ * worker comes out.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_PARALLEL_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_PARALLEL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_PAR_SIGNATURE UBASE_FOURCC('p','a','r','a')
+#define UPIPE_PAR_SUB_SIGNATURE UBASE_FOURCC('p','a','r','s')
+
+/** @This defines the ways of dispatching frames to workers. */
+enum upipe_par_mode {
+    /** workers are used in turn */
+    UPIPE_PAR_ROUND_ROBIN,
+    /** the worker with the fewest frames in flight is used */
+    UPIPE_PAR_LEAST_LOADED,
+};
+
+/** @This extends upipe_command with specific commands for parallel
+ * pipes. */
+enum upipe_par_command {
+    UPIPE_PAR_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** adds a worker (struct upipe *) */
+    UPIPE_PAR_ADD_WORKER,
+    /** returns the dispatch mode (enum upipe_par_mode *) */
+    UPIPE_PAR_GET_MODE,
+    /** sets the dispatch mode (enum upipe_par_mode) */
+    UPIPE_PAR_SET_MODE,
+};
+
+/** @This adds a worker to a parallel pipe. The pipe keeps a reference on
+ * the worker and sets its output. Workers may be added at any time.
+ *
+ * @param upipe description structure of the pipe
+ * @param worker worker pipe
+ * @return an error code
+ */
+static inline int upipe_par_add_worker(struct upipe *upipe,
+                                       struct upipe *worker)
+{
+    return upipe_control(upipe, UPIPE_PAR_ADD_WORKER, UPIPE_PAR_SIGNATURE,
+                         worker);
+}
+
+/** @This returns the dispatch mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode_p filled in with the dispatch mode
+ * @return an error code
+ */
+static inline int upipe_par_get_mode(struct upipe *upipe,
+                                     enum upipe_par_mode *mode_p)
+{
+    return upipe_control(upipe, UPIPE_PAR_GET_MODE, UPIPE_PAR_SIGNATURE,
+                         mode_p);
+}
+
+/** @This sets the dispatch mode. The default is
+ * @ref UPIPE_PAR_ROUND_ROBIN.
+ *
+ * @param upipe description structure of the pipe
+ * @param mode dispatch mode
+ * @return an error code
+ */
+static inline int upipe_par_set_mode(struct upipe *upipe,
+                                     enum upipe_par_mode mode)
+{
+    return upipe_control(upipe, UPIPE_PAR_SET_MODE, UPIPE_PAR_SIGNATURE,
+                         mode);
+}
+
+/** @This returns the management structure for all parallel pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_par_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
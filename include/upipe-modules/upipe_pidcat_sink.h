@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module - per-PID capture sink
+ * This sink splits a transport stream by PID, and writes each PID to its own
+ * data file, along with a time index, so that analyses on a few PIDs only
+ * read the octets they need.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_PIDCAT_SINK_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_PIDCAT_SINK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_PIDCAT_SINK_SIGNATURE UBASE_FOURCC('p','c','s','k')
+
+/** size of a TS packet in a pidcat data file */
+#define UPIPE_PIDCAT_TS_SIZE 188
+/** size of a record of a pidcat index file */
+#define UPIPE_PIDCAT_RECORD_SIZE 16
+/** number of PIDs in a transport stream */
+#define UPIPE_PIDCAT_MAX_PIDS 8192
+/** suffix of the data files */
+#define UPIPE_PIDCAT_DATA_SUFFIX ".ts"
+/** suffix of the index files */
+#define UPIPE_PIDCAT_INDEX_SUFFIX ".idx"
+
+/** @This returns the management structure for pidcat sink pipes.
+ *
+ * The URI given with @ref upipe_set_uri is a directory, created if needed.
+ * For each PID, the directory contains a data file named after the PID in
+ * decimal with the suffix @ref UPIPE_PIDCAT_DATA_SUFFIX, holding the TS
+ * packets of the PID, and an index file with the suffix
+ * @ref UPIPE_PIDCAT_INDEX_SUFFIX. The index has one 16-octet record per
+ * packet, containing the cr_sys of the packet and its number in the whole
+ * multiplex, both as big-endian 64-bit integers. The records are sorted by
+ * both fields, so that a time is found with a binary search, and the
+ * multiplex is rebuilt by merging the packet numbers of all PIDs.
+ *
+ * Existing captures are appended to.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_pidcat_sink_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
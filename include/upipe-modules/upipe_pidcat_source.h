@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module - per-PID capture source
+ * This source reads captures written by @ref upipe_pidcat_sink_mgr_alloc,
+ * and rebuilds the original multiplex, or only the chosen PIDs.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_PIDCAT_SOURCE_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_PIDCAT_SOURCE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_PIDCAT_SRC_SIGNATURE UBASE_FOURCC('p','c','s','r')
+
+/** @This extends upipe_command with specific commands for pidcat source
+ * pipes. */
+enum upipe_pidcat_src_command {
+    UPIPE_PIDCAT_SRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** adds a PID to the list of PIDs to read (unsigned int) */
+    UPIPE_PIDCAT_SRC_ADD_PID
+};
+
+/** @This returns the management structure for pidcat source pipes.
+ *
+ * The URI given with @ref upipe_set_uri is the directory of the capture.
+ * Packets are output in their original order, the packets sharing the same
+ * cr_sys being grouped in a block of at most the output size, and stamped
+ * with their cr_sys. Only the files of the read PIDs are accessed.
+ * The position of @ref upipe_src_set_position is a cr_sys date.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_pidcat_src_mgr_alloc(void);
+
+/** @This adds a PID to the list of PIDs to read. If no PID is added, all
+ * the PIDs of the capture are read.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to read
+ * @return an error code
+ */
+static inline int upipe_pidcat_src_add_pid(struct upipe *upipe,
+                                           unsigned int pid)
+{
+    return upipe_control(upipe, UPIPE_PIDCAT_SRC_ADD_PID,
+                         UPIPE_PIDCAT_SRC_SIGNATURE, pid);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
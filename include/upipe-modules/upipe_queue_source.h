@@ -28,7 +28,8 @@
  *
  * Note that the allocator requires an additional parameter:
  * @table 2
- * @item queue_length @item maximum length of the queue (<= 255)
+ * @item queue_length @item maximum length of the queue (<= 65536), rounded
+ * up to a power of two
  * @end table
  *
  * Also note that this module is exceptional in that upipe_release() may be
@@ -57,7 +58,13 @@ enum upipe_qsrc_command {
     /** returns the maximum length of the queue (unsigned int *) */
     UPIPE_QSRC_GET_MAX_LENGTH,
     /** returns the current length of the queue (unsigned int *) */
-    UPIPE_QSRC_GET_LENGTH
+    UPIPE_QSRC_GET_LENGTH,
+    /** sets the maximum work done per wake-up (unsigned int, uint64_t) */
+    UPIPE_QSRC_SET_BATCH,
+    /** sets the busy-poll duration (uint64_t) */
+    UPIPE_QSRC_SET_SPIN,
+    /** sets the flow-control watermarks (unsigned int, unsigned int) */
+    UPIPE_QSRC_SET_WATERMARKS
 };
 
 /** @This returns the management structure for all queue sources.
@@ -95,6 +102,66 @@ static inline int upipe_qsrc_get_length(struct upipe *upipe,
                          UPIPE_QSRC_SIGNATURE, length_p);
 }
 
+/** @This sets the maximum amount of work done each time the pipe is woken
+ * up. By default a single uref is output per wake-up; with a larger batch the
+ * queue is drained up to batch_size urefs, or until batch_duration has
+ * elapsed, before returning to the event loop. This function, like all
+ * control functions, may only be called from the thread which runs the
+ * queue source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of urefs output per wake-up (>= 1)
+ * @param batch_duration maximum time spent per wake-up, in 27 MHz units,
+ * or 0 for no limit
+ * @return an error code
+ */
+static inline int upipe_qsrc_set_batch(struct upipe *upipe,
+                                       unsigned int batch_size,
+                                       uint64_t batch_duration)
+{
+    return upipe_control(upipe, UPIPE_QSRC_SET_BATCH, UPIPE_QSRC_SIGNATURE,
+                         batch_size, batch_duration);
+}
+
+/** @This enables the adaptive busy-poll mode of the queue (see
+ * @ref uqueue_set_spin): when the queue is found empty, the pipe polls it
+ * for up to the given duration before going back to the event loop. This
+ * trades CPU time for the latency of the wake-up on latency-critical
+ * paths.
+ *
+ * @param upipe description structure of the pipe
+ * @param spin_duration maximum polling duration, in 27 MHz units, or 0 to
+ * disable polling
+ * @return an error code
+ */
+static inline int upipe_qsrc_set_spin(struct upipe *upipe,
+                                      uint64_t spin_duration)
+{
+    return upipe_control(upipe, UPIPE_QSRC_SET_SPIN, UPIPE_QSRC_SIGNATURE,
+                         spin_duration);
+}
+
+/** @This sets flow-control watermarks on the queue (see
+ * @ref uqueue_set_watermarks): when the queue holds high urefs, the queue
+ * sinks feeding it hold their urefs and block their sources as if the queue
+ * was full, until the queue source has brought the queue down to low urefs.
+ * Producers are thus throttled as soon as the consumer falls behind,
+ * without exchanging control messages between threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param high number of urefs above which queue sinks are throttled, or 0
+ * to disable the watermarks
+ * @param low number of urefs at or below which queue sinks resume
+ * @return an error code
+ */
+static inline int upipe_qsrc_set_watermarks(struct upipe *upipe,
+                                            unsigned int high,
+                                            unsigned int low)
+{
+    return upipe_control(upipe, UPIPE_QSRC_SET_WATERMARKS,
+                         UPIPE_QSRC_SIGNATURE, high, low);
+}
+
 /** @hidden */
 #define ARGS_DECL , unsigned int queue_length
 /** @hidden */
@@ -25,6 +25,14 @@
 
 /** @file
  * @short Upipe module to split raw audio into RTP packets
+ *
+ * Input is interleaved s32 audio, output is 24-bit big endian payloads. By
+ * default, the payloads are meant to be encapsulated by an rtp_prepend pipe.
+ *
+ * When a packet time is set, the pipe works in SMPTE ST 2110-30 mode and
+ * outputs complete RTP packets ("block.rtp.s24be.sound."), built from a
+ * header template. All the packets generated from an incoming sound buffer
+ * share a single block buffer, each output uref being a slice of it.
  */
 
 #ifndef _UPIPE_MODULES_UPIPE_RTP_PCM_PACK_H_
@@ -34,10 +42,90 @@
 extern "C" {
 #endif
 
+#include "upipe/upipe.h"
+#include "upipe/uclock.h"
+
 #define UPIPE_RTP_PCM_PACK_SIGNATURE UBASE_FOURCC('r','t','p','c')
 
+/** ST 2110-30 packet time of 1 ms (levels A and B) */
+#define UPIPE_RTP_PCM_PACK_PTIME_1MS        (UCLOCK_FREQ / 1000)
+/** ST 2110-30 packet time of 125 us (levels B and C) */
+#define UPIPE_RTP_PCM_PACK_PTIME_125US      (UCLOCK_FREQ / 8000)
+
+/** @This extends upipe_command with specific commands for rtp_pcm_pack. */
+enum upipe_rtp_pcm_pack_command {
+    UPIPE_RTP_PCM_PACK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** get the packet time (uint64_t *) */
+    UPIPE_RTP_PCM_PACK_GET_PACKET_TIME,
+    /** set the packet time and output RTP packets (uint64_t) */
+    UPIPE_RTP_PCM_PACK_SET_PACKET_TIME,
+    /** get the RTP payload type (uint8_t *) */
+    UPIPE_RTP_PCM_PACK_GET_TYPE,
+    /** set the RTP payload type (unsigned int) */
+    UPIPE_RTP_PCM_PACK_SET_TYPE,
+};
+
 struct upipe_mgr *upipe_rtp_pcm_pack_mgr_alloc(void);
 
+/** @This returns the packet time.
+ *
+ * @param upipe description structure of the pipe
+ * @param packet_time_p filled in with the packet time in #UCLOCK_FREQ units,
+ * or 0 if the pipe does not output RTP packets
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_pack_get_packet_time(struct upipe *upipe,
+                                                     uint64_t *packet_time_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_PACK_GET_PACKET_TIME,
+                         UPIPE_RTP_PCM_PACK_SIGNATURE, packet_time_p);
+}
+
+/** @This sets the packet time, and switches the pipe to ST 2110-30 mode
+ * where it outputs complete RTP packets. It must be a whole number of
+ * samples, typically @ref UPIPE_RTP_PCM_PACK_PTIME_1MS or
+ * @ref UPIPE_RTP_PCM_PACK_PTIME_125US, and must be set before the flow
+ * definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param packet_time packet time in #UCLOCK_FREQ units
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_pack_set_packet_time(struct upipe *upipe,
+                                                     uint64_t packet_time)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_PACK_SET_PACKET_TIME,
+                         UPIPE_RTP_PCM_PACK_SIGNATURE, packet_time);
+}
+
+/** @This returns the RTP payload type.
+ *
+ * @param upipe description structure of the pipe
+ * @param type_p filled in with the payload type
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_pack_get_type(struct upipe *upipe,
+                                              uint8_t *type_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_PACK_GET_TYPE,
+                         UPIPE_RTP_PCM_PACK_SIGNATURE, type_p);
+}
+
+/** @This sets the RTP payload type used in ST 2110-30 mode. The default
+ * is 97.
+ *
+ * @param upipe description structure of the pipe
+ * @param type payload type
+ * @return an error code
+ */
+static inline int upipe_rtp_pcm_pack_set_type(struct upipe *upipe,
+                                              uint8_t type)
+{
+    return upipe_control(upipe, UPIPE_RTP_PCM_PACK_SET_TYPE,
+                         UPIPE_RTP_PCM_PACK_SIGNATURE, (unsigned int)type);
+}
+
 #ifdef __cplusplus
 }
 #endif
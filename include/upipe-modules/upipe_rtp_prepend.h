@@ -148,6 +148,10 @@ upipe_rtp_prepend_get_ts_sync(struct upipe *upipe,
 }
 
 /** @This returns the management structure for rtp_prepend pipes.
+ *
+ * The pipe asks upstream allocators for headroom in front of the payloads,
+ * and writes the RTP header there when possible. Otherwise, the header is
+ * allocated separately and chained in front of the payload.
  *
  * @return pointer to manager
  */
@@ -25,6 +25,10 @@
 
 /** @file
  * @short Upipe module to buffer and reorder rtp packets from multiple sources
+ *
+ * When several input subpipes receive the same RTP stream over redundant
+ * paths (SMPTE 2022-7), each sequence number is output once, taken from
+ * whichever path delivered it first.
  */
 
 #ifndef _UPIPE_MODULES_UPIPE_RTP_REORDER_H_
@@ -47,7 +51,34 @@ enum upipe_rtpr_command {
     /** returns the current reorder delay being set into urefs (uint64_t *) */
     UPIPE_RTPR_GET_DELAY,
     /** sets the reorder delay to set into urefs (uint64_t) */
-    UPIPE_RTPR_SET_DELAY
+    UPIPE_RTPR_SET_DELAY,
+    /** outputs in-order packets without waiting for the delay (int) */
+    UPIPE_RTPR_SET_LOW_LATENCY
+};
+
+/** @This extends upipe_command with specific commands for rtpr inputs. */
+enum upipe_rtpr_input_command {
+    UPIPE_RTPR_INPUT_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the statistics of the input
+     * (struct upipe_rtpr_input_stats *) */
+    UPIPE_RTPR_INPUT_GET_STATS
+};
+
+/** @This holds the statistics of an rtpr input. */
+struct upipe_rtpr_input_stats {
+    /** number of packets received */
+    uint64_t packets;
+    /** number of packets output from this input */
+    uint64_t first;
+    /** number of packets already received from another input */
+    uint64_t duplicates;
+    /** number of packets received after their sequence number was skipped */
+    uint64_t late;
+    /** last delay behind the first copy of a packet, in 27 MHz ticks */
+    uint64_t skew;
+    /** maximum delay behind the first copy of a packet */
+    uint64_t max_skew;
 };
 
 /** @This returns the management structure for rtpr pipes.
@@ -80,6 +111,34 @@ static inline int upipe_rtpr_set_delay(struct upipe *upipe, uint64_t delay)
                          UPIPE_RTPR_SIGNATURE, delay);
 }
 
+/** @This enables or disables low latency mode. In this mode, packets
+ * following the last output packet are output immediately, and the delay
+ * is only waited for when a sequence number is missing, so it only needs
+ * to cover the skew between the input paths.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to enable low latency mode
+ * @return an error code
+ */
+static inline int upipe_rtpr_set_low_latency(struct upipe *upipe, bool enabled)
+{
+    return upipe_control(upipe, UPIPE_RTPR_SET_LOW_LATENCY,
+                         UPIPE_RTPR_SIGNATURE, enabled ? 1 : 0);
+}
+
+/** @This returns the statistics of an input subpipe.
+ *
+ * @param upipe description structure of the input subpipe
+ * @param stats filled in with the statistics
+ * @return an error code
+ */
+static inline int upipe_rtpr_input_get_stats(struct upipe *upipe,
+        struct upipe_rtpr_input_stats *stats)
+{
+    return upipe_control(upipe, UPIPE_RTPR_INPUT_GET_STATS,
+                         UPIPE_RTPR_INPUT_SIGNATURE, stats);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module keeping the last minutes of a flow in memory
+ *
+ * The timeshift pipe keeps the urefs it receives in a ring, within a limit
+ * of duration and of size, and indexes them by cr_sys. Each output subpipe
+ * is a reader with its own position in the ring: it starts at the live
+ * point, may be moved back with @ref upipe_src_set_position, and outputs
+ * the urefs from its position as fast as its output accepts them. A reader
+ * which falls behind the oldest kept uref jumps to it.
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_TIMESHIFT_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_TIMESHIFT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/uclock.h"
+#include "upipe/upipe.h"
+
+#define UPIPE_TIMESHIFT_SIGNATURE UBASE_FOURCC('t','s','h','f')
+#define UPIPE_TIMESHIFT_OUTPUT_SIGNATURE UBASE_FOURCC('t','s','h','o')
+
+/** default maximum duration of the ring - 5 minutes */
+#define UPIPE_TIMESHIFT_DEF_DURATION (UINT64_C(300) * UCLOCK_FREQ)
+/** default maximum size of the ring, in octets */
+#define UPIPE_TIMESHIFT_DEF_SIZE (UINT64_C(256) * 1024 * 1024)
+/** position of the live point */
+#define UPIPE_TIMESHIFT_LIVE UINT64_MAX
+
+/** @This extends upipe_command with specific commands for timeshift pipes. */
+enum upipe_timeshift_command {
+    UPIPE_TIMESHIFT_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the limits of the ring (uint64_t *, uint64_t *) */
+    UPIPE_TIMESHIFT_GET_LIMITS,
+    /** sets the limits of the ring (uint64_t, uint64_t) */
+    UPIPE_TIMESHIFT_SET_LIMITS,
+    /** returns the dates of the oldest and newest urefs
+     * (uint64_t *, uint64_t *) */
+    UPIPE_TIMESHIFT_GET_RANGE,
+};
+
+/** @This returns the limits of the ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration_p filled in with the maximum duration, in 27 MHz units
+ * @param size_p filled in with the maximum size, in octets
+ * @return an error code
+ */
+static inline int upipe_timeshift_get_limits(struct upipe *upipe,
+                                             uint64_t *duration_p,
+                                             uint64_t *size_p)
+{
+    return upipe_control(upipe, UPIPE_TIMESHIFT_GET_LIMITS,
+                         UPIPE_TIMESHIFT_SIGNATURE, duration_p, size_p);
+}
+
+/** @This sets the limits of the ring. The oldest urefs are dropped as soon
+ * as the dates of the urefs span more than the duration, or their block
+ * payloads take more than the size.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration maximum duration, in 27 MHz units
+ * @param size maximum size, in octets
+ * @return an error code
+ */
+static inline int upipe_timeshift_set_limits(struct upipe *upipe,
+                                             uint64_t duration,
+                                             uint64_t size)
+{
+    return upipe_control(upipe, UPIPE_TIMESHIFT_SET_LIMITS,
+                         UPIPE_TIMESHIFT_SIGNATURE, duration, size);
+}
+
+/** @This returns the dates of the oldest and newest urefs of the ring,
+ * which are the bounds of the positions of the readers.
+ *
+ * @param upipe description structure of the pipe
+ * @param first_p filled in with the date of the oldest uref
+ * @param last_p filled in with the date of the newest uref
+ * @return an error code, UBASE_ERR_INVALID if the ring is empty
+ */
+static inline int upipe_timeshift_get_range(struct upipe *upipe,
+                                            uint64_t *first_p,
+                                            uint64_t *last_p)
+{
+    return upipe_control(upipe, UPIPE_TIMESHIFT_GET_RANGE,
+                         UPIPE_TIMESHIFT_SIGNATURE, first_p, last_p);
+}
+
+/** @This returns the management structure for all timeshift pipes.
+ *
+ * The position of a reader is set with @ref upipe_src_set_position, as a
+ * cr_sys date: the reader then restarts from the last random access point
+ * (see @ref uref_flow_set_random) at or before that date, or from the first
+ * uref after it if the flow has none. @ref UPIPE_TIMESHIFT_LIVE moves it
+ * back to the live point. @ref upipe_src_get_position returns the date of
+ * the next uref to output, or @ref UPIPE_TIMESHIFT_LIVE at the live point.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_timeshift_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
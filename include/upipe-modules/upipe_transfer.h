@@ -81,7 +81,34 @@ enum upipe_xfer_mgr_command {
     /** freeze the remote event loop (void) */
     UPIPE_XFER_MGR_FREEZE,
     /** thaw the remote event loop (void) */
-    UPIPE_XFER_MGR_THAW
+    UPIPE_XFER_MGR_THAW,
+    /** sets the busy-poll duration of the remote event loop (uint64_t) */
+    UPIPE_XFER_MGR_SET_SPIN,
+    /** returns the CPU accounting of the remote thread
+     * (struct upipe_xfer_thread_stats *) */
+    UPIPE_XFER_MGR_GET_THREAD_STATS
+};
+
+/** @This is the CPU accounting of the thread running a remote event loop,
+ * since the xfer manager was attached to it. Durations are in 27 MHz
+ * units. */
+struct upipe_xfer_thread_stats {
+    /** identifier of the thread (the kernel thread ID) */
+    uint64_t thread;
+    /** time elapsed since the manager was attached */
+    uint64_t duration;
+    /** time spent running in user space */
+    uint64_t user_time;
+    /** time spent running in the kernel */
+    uint64_t system_time;
+    /** time spent on a CPU, as accounted by the scheduler */
+    uint64_t run_time;
+    /** time spent runnable, waiting for a CPU */
+    uint64_t wait_time;
+    /** number of voluntary context switches (sleeps) */
+    uint64_t voluntary_switches;
+    /** number of involuntary context switches (preemptions) */
+    uint64_t involuntary_switches;
 };
 
 /** @This returns a management structure for xfer pipes. You would need one
@@ -89,12 +116,13 @@ enum upipe_xfer_mgr_command {
  * structure can be allocated in any thread, but must be attached in the
  * same thread as the one running the upump manager.
  *
- * @param queue_length maximum length of the internal queues
+ * @param queue_length maximum length of the internal queues (max 65536),
+ * rounded up to a power of two
  * @param msg_pool_depth maximum number of messages in the pool
  * @param mutex mutual exclusion primitives to access the event loop, or NULL
  * @return pointer to manager
  */
-struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_xfer_mgr_alloc(unsigned int queue_length,
                                        uint16_t msg_pool_depth,
                                        struct umutex *mutex);
 
@@ -145,6 +173,44 @@ static inline int upipe_xfer_mgr_thaw(struct upipe_mgr *mgr)
     return upipe_mgr_control(mgr, UPIPE_XFER_MGR_THAW, UPIPE_XFER_SIGNATURE);
 }
 
+/** @This enables the adaptive busy-poll mode of the command queue of the
+ * remote event loop (see @ref uqueue_set_spin): when the queue is found
+ * empty, the remote thread polls it for up to the given duration before
+ * going back to its event loop, saving the wake-up latency of commands sent
+ * in bursts.
+ *
+ * @param mgr xfer_mgr structure
+ * @param spin_duration maximum polling duration, in 27 MHz units, or 0 to
+ * disable polling
+ * @return an error code
+ */
+static inline int upipe_xfer_mgr_set_spin(struct upipe_mgr *mgr,
+                                          uint64_t spin_duration)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_SET_SPIN, UPIPE_XFER_SIGNATURE,
+                             spin_duration);
+}
+
+/** @This returns the CPU accounting of the thread running the remote event
+ * loop, since the manager was attached to it. This call is thread-safe and
+ * may be performed from any thread, so that a single query per manager
+ * tells which remote threads are saturated: their run time grows as fast as
+ * the duration, and their wait time shows how long they were kept off a
+ * CPU by other threads.
+ *
+ * The figures are read from the kernel, and only available on Linux.
+ *
+ * @param mgr xfer_mgr structure
+ * @param stats filled in with the accounting of the thread
+ * @return an error code, UBASE_ERR_INVALID if the manager is not attached
+ */
+static inline int upipe_xfer_mgr_get_thread_stats(struct upipe_mgr *mgr,
+        struct upipe_xfer_thread_stats *stats)
+{
+    return upipe_mgr_control(mgr, UPIPE_XFER_MGR_GET_THREAD_STATS,
+                             UPIPE_XFER_SIGNATURE, stats);
+}
+
 /** @hidden */
 #define ARGS_DECL , struct upipe *upipe_remote
 /** @hidden */
@@ -46,7 +46,12 @@ enum upipe_trickp_command {
     /** returns the current playing rate (struct urational *) */
     UPIPE_TRICKP_GET_RATE,
     /** sets the playing rate (struct urational) */
-    UPIPE_TRICKP_SET_RATE
+    UPIPE_TRICKP_SET_RATE,
+    /** returns the keyframe-only settings (struct urational *,
+     * uint64_t *) */
+    UPIPE_TRICKP_GET_KEYFRAME,
+    /** sets the keyframe-only settings (struct urational, uint64_t) */
+    UPIPE_TRICKP_SET_KEYFRAME
 };
 
 /** @This returns the management structure for all trickp pipes.
@@ -81,6 +86,39 @@ static inline int upipe_trickp_set_rate(struct upipe *upipe,
                          UPIPE_TRICKP_SIGNATURE, rate);
 }
 
+/** @This returns the keyframe-only settings.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold_p filled with the rate from which only keyframes are output
+ * @param interval_p filled with the minimum system interval between keyframes
+ * @return an error code
+ */
+static inline int upipe_trickp_get_keyframe(struct upipe *upipe,
+                                            struct urational *threshold_p,
+                                            uint64_t *interval_p)
+{
+    return upipe_control(upipe, UPIPE_TRICKP_GET_KEYFRAME,
+                         UPIPE_TRICKP_SIGNATURE, threshold_p, interval_p);
+}
+
+/** @This sets the keyframe-only settings. When the playing rate is greater
+ * than or equal to threshold, picture flows only output random access
+ * points spaced by at least interval (in system time), and sound flows are
+ * dropped, so that the downstream decoders only work on displayed frames.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold rate from which only keyframes are output (0/0 disables)
+ * @param interval minimum system interval between keyframes (0 for none)
+ * @return an error code
+ */
+static inline int upipe_trickp_set_keyframe(struct upipe *upipe,
+                                            struct urational threshold,
+                                            uint64_t interval)
+{
+    return upipe_control(upipe, UPIPE_TRICKP_SET_KEYFRAME,
+                         UPIPE_TRICKP_SIGNATURE, threshold, interval);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -51,6 +51,12 @@ enum upipe_udpsink_command {
     UPIPE_UDPSINK_SET_FD,
     /** set remote address (const struct sockaddr *, socklen_t) **/
     UPIPE_UDPSINK_SET_PEER,
+    /** set batch mode parameters (unsigned int, uint64_t) **/
+    UPIPE_UDPSINK_SET_BATCH,
+    /** set transmit time parameters (int, uint64_t) **/
+    UPIPE_UDPSINK_SET_TXTIME,
+    /** set zero-copy send mode (int) **/
+    UPIPE_UDPSINK_SET_ZEROCOPY,
 };
 
 /** @This returns the management structure for all udp sinks.
@@ -96,6 +102,65 @@ static inline int upipe_udpsink_set_peer(struct upipe *upipe,
     return upipe_control(upipe, UPIPE_UDPSINK_SET_PEER, UPIPE_UDPSINK_SIGNATURE,
             addr, addrlen);
 }
+
+/** @This sets the batch mode parameters. When a uref is due, the held urefs
+ * which are due before the end of the batch window are sent along with it
+ * in a single system call, with UDP segmentation offload if all of them
+ * have the same size, or with sendmmsg() otherwise. A batch size of 1
+ * (the default) sends each uref at its own date. Raw sockets are never
+ * batched.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams sent at once (between 1
+ * and 64)
+ * @param batch_window duration in 27 MHz units
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_batch(struct upipe *upipe,
+                                          unsigned int batch_size,
+                                          uint64_t batch_window)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_BATCH,
+                         UPIPE_UDPSINK_SIGNATURE, batch_size, batch_window);
+}
+
+/** @This sets the transmit time parameters. Instead of waiting for the date
+ * of each uref, the urefs which are due before the end of the horizon are
+ * handed to the kernel along with their transmit time (SO_TXTIME), so that
+ * they are sent at their exact date by the ETF or fq queueing discipline.
+ * This requires a uclock. It may be combined with the batch mode, though
+ * segmentation offload is then disabled. Raw sockets are not supported.
+ *
+ * @param upipe description structure of the pipe
+ * @param clockid clock used by the queueing discipline (CLOCK_TAI for ETF,
+ * CLOCK_MONOTONIC for fq), or -1 to pace in user space (the default)
+ * @param horizon duration in 27 MHz units
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_txtime(struct upipe *upipe, int clockid,
+                                           uint64_t horizon)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_TXTIME,
+                         UPIPE_UDPSINK_SIGNATURE, clockid, horizon);
+}
+
+/** @This sets the zero-copy send mode. The payloads are then sent with
+ * MSG_ZEROCOPY, so that the kernel reads them from the buffers of the urefs
+ * instead of copying them, and the urefs are kept until the kernel reports
+ * that it is done with them. This is only worth it with large batches of
+ * read-only payloads, such as memory-mapped archives played out with
+ * segmentation offload. Raw sockets are not supported.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to send without copy
+ * @return an error code
+ */
+static inline int upipe_udpsink_set_zerocopy(struct upipe *upipe, bool enable)
+{
+    return upipe_control(upipe, UPIPE_UDPSINK_SET_ZEROCOPY,
+                         UPIPE_UDPSINK_SIGNATURE, enable ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
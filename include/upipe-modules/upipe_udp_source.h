@@ -47,6 +47,32 @@ enum upipe_udpsrc_command {
     UPIPE_UDPSRC_GET_FD,
     /** set socket fd (int) */
     UPIPE_UDPSRC_SET_FD,
+    /** get the maximum number of datagrams read per wake-up
+     * (unsigned int *) */
+    UPIPE_UDPSRC_GET_BATCH_SIZE,
+    /** set the maximum number of datagrams read per wake-up (unsigned int) */
+    UPIPE_UDPSRC_SET_BATCH_SIZE,
+    /** get the source of receive timestamps
+     * (enum upipe_udpsrc_timestamping *) */
+    UPIPE_UDPSRC_GET_TIMESTAMPING,
+    /** set the source of receive timestamps (enum upipe_udpsrc_timestamping) */
+    UPIPE_UDPSRC_SET_TIMESTAMPING,
+    /** enable or disable the TS PID filter (int) */
+    UPIPE_UDPSRC_SET_PID_FILTER,
+    /** select a PID in the TS PID filter (unsigned int) */
+    UPIPE_UDPSRC_ADD_PID,
+    /** unselect a PID in the TS PID filter (unsigned int) */
+    UPIPE_UDPSRC_DEL_PID,
+};
+
+/** @This defines the sources of the cr_sys date of received datagrams. */
+enum upipe_udpsrc_timestamping {
+    /** date taken with the uclock when the pipe wakes up */
+    UPIPE_UDPSRC_TIMESTAMPING_NONE = 0,
+    /** date taken by the kernel when the datagram was received */
+    UPIPE_UDPSRC_TIMESTAMPING_SOFTWARE,
+    /** date taken by the network interface, with fallback to the kernel */
+    UPIPE_UDPSRC_TIMESTAMPING_HARDWARE,
 };
 
 /** @This extends uprobe_throw with specific events. */
@@ -81,7 +107,127 @@ static inline int upipe_udpsrc_set_fd(struct upipe *upipe, int fd)
                          fd);
 }
 
+/** @This returns the maximum number of datagrams read per wake-up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size_p filled in with the maximum number of datagrams
+ * @return an error code
+ */
+static inline int upipe_udpsrc_get_batch_size(struct upipe *upipe,
+                                              unsigned int *batch_size_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_GET_BATCH_SIZE,
+                         UPIPE_UDPSRC_SIGNATURE, batch_size_p);
+}
+
+/** @This sets the maximum number of datagrams read per wake-up. With a
+ * value greater than 1, datagrams are received with a single recvmmsg()
+ * call into urefs allocated in advance, and all of them get the same
+ * cr_sys date. This is only supported on systems providing recvmmsg().
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams (between 1 and 64)
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_batch_size(struct upipe *upipe,
+                                              unsigned int batch_size)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_BATCH_SIZE,
+                         UPIPE_UDPSRC_SIGNATURE, batch_size);
+}
+
+/** @This returns the source of the cr_sys date of received datagrams.
+ *
+ * @param upipe description structure of the pipe
+ * @param timestamping_p filled in with the source of the dates
+ * @return an error code
+ */
+static inline int upipe_udpsrc_get_timestamping(struct upipe *upipe,
+        enum upipe_udpsrc_timestamping *timestamping_p)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_GET_TIMESTAMPING,
+                         UPIPE_UDPSRC_SIGNATURE, timestamping_p);
+}
+
+/** @This sets the source of the cr_sys date of received datagrams, using
+ * SO_TIMESTAMPING on Linux.
+ *
+ * Software timestamps are taken by the kernel in CLOCK_REALTIME, and are
+ * translated into the attached uclock by subtracting their age from the date
+ * of the wake-up, so they work with any uclock.
+ *
+ * Hardware timestamps are raw times of the PTP hardware clock of the network
+ * interface, only converted to 27 MHz ticks. They are not run through the
+ * servo of @ref uclock_ptp_alloc, so they are only consistent with an
+ * attached uclock in the same time scale (such as a uclock_ptp on the
+ * receiving interface) up to its filtering. Hardware timestamping must have
+ * been enabled on the interface (for instance by ptp4l or hwstamp_ctl).
+ * Datagrams without a hardware timestamp fall back to the software
+ * timestamp.
+ *
+ * Setting the URI or the file descriptor fails if the timestamps can't be
+ * enabled on the new socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param timestamping source of the dates
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_timestamping(struct upipe *upipe,
+        enum upipe_udpsrc_timestamping timestamping)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_TIMESTAMPING,
+                         UPIPE_UDPSRC_SIGNATURE, timestamping);
+}
+
+/** @This enables or disables the TS PID filter. When enabled, datagrams
+ * made of whole TS packets have the packets of unselected PIDs removed as
+ * soon as they are received, and datagrams without any selected packet are
+ * not output at all. Other datagrams are output untouched. The filter
+ * starts with no PID selected.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to enable the filter
+ * @return an error code
+ */
+static inline int upipe_udpsrc_set_pid_filter(struct upipe *upipe,
+                                              bool enabled)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_SET_PID_FILTER,
+                         UPIPE_UDPSRC_SIGNATURE, enabled ? 1 : 0);
+}
+
+/** @This selects a PID in the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to select
+ * @return an error code
+ */
+static inline int upipe_udpsrc_add_pid(struct upipe *upipe, unsigned int pid)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_ADD_PID,
+                         UPIPE_UDPSRC_SIGNATURE, pid);
+}
+
+/** @This unselects a PID in the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to unselect
+ * @return an error code
+ */
+static inline int upipe_udpsrc_del_pid(struct upipe *upipe, unsigned int pid)
+{
+    return upipe_control(upipe, UPIPE_UDPSRC_DEL_PID,
+                         UPIPE_UDPSRC_SIGNATURE, pid);
+}
+
 /** @This returns the management structure for all udp socket sources.
+ *
+ * With the /reuseport option of the URI, several sources may be bound to
+ * the same address and port, and the kernel spreads incoming flows between
+ * them by hashing their addresses. To use several cores for the same port,
+ * allocate one source per shard with the same URI, each in its own worker
+ * thread with @ref upipe_wsrc_alloc and a @ref upipe_pthread_xfer_mgr_alloc
+ * manager, so that each shard feeds its own sub-pipeline.
  *
  * @return pointer to manager
  */
@@ -27,8 +27,53 @@
 extern "C" {
 #endif
 
+#include "upipe/upipe.h"
+
 #define UPIPE_VANC_DECODER_SIGNATURE     UBASE_FOURCC('a','n','c','d')
 
+/** @This extends upipe_command with specific commands for vanc decoder
+ * pipes. */
+enum upipe_vanc_decoder_command {
+    UPIPE_VANC_DECODER_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** subscribes to an ancillary data type (unsigned int, unsigned int) */
+    UPIPE_VANC_DECODER_ADD_DID,
+    /** unsubscribes from an ancillary data type (unsigned int, unsigned int) */
+    UPIPE_VANC_DECODER_DEL_DID,
+};
+
+/** @This subscribes to an ancillary data type. Once a type has been
+ * subscribed to, packets of other types are skipped without being decoded.
+ *
+ * @param upipe description structure of the pipe
+ * @param did data identifier
+ * @param sdid secondary data identifier
+ * @return an error code
+ */
+static inline int upipe_vanc_decoder_add_did(struct upipe *upipe,
+                                             unsigned int did,
+                                             unsigned int sdid)
+{
+    return upipe_control(upipe, UPIPE_VANC_DECODER_ADD_DID,
+                         UPIPE_VANC_DECODER_SIGNATURE, did, sdid);
+}
+
+/** @This unsubscribes from an ancillary data type. When no type is
+ * subscribed to anymore, all packets are decoded.
+ *
+ * @param upipe description structure of the pipe
+ * @param did data identifier
+ * @param sdid secondary data identifier
+ * @return an error code
+ */
+static inline int upipe_vanc_decoder_del_did(struct upipe *upipe,
+                                             unsigned int did,
+                                             unsigned int sdid)
+{
+    return upipe_control(upipe, UPIPE_VANC_DECODER_DEL_DID,
+                         UPIPE_VANC_DECODER_SIGNATURE, did, sdid);
+}
+
 struct upipe_mgr *upipe_vancd_mgr_alloc(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Bin pipe running a chain of linear subpipelines on several threads
+ *
+ * It allows to split a linear processing (for instance decode, scale and
+ * encode) into stages, each of them transferred to its own remote upump_mgr.
+ * Consecutive stages are connected directly with queues, so that urefs go
+ * from one stage thread to the next without bouncing on the main thread,
+ * and every stage runs concurrently on its own core. A queue sets up the
+ * input of the first stage, and another queue retrieves the processed
+ * packets in the main upump_mgr.
+ *
+ * When the queue feeding a stage is full, the upstream stage is blocked, so
+ * that backpressure is propagated up to the main thread.
+ *
+ * As with @ref upipe_wlin_alloc, the remote subpipelines are not "used" and
+ * shouldn't be "released" afterwards. Only release the wchain pipe.
+ *
+ * Note that the allocator requires three additional parameters:
+ * @table 2
+ * @item stages @item array describing the stages, in processing order
+ * (the subpipelines and probes belong to the callee)
+ * @item nb_stages @item number of stages in the array
+ * @item output_queue_length @item number of packets in the queue between the
+ * last stage and the main thread
+ * @end table
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_WORKER_CHAIN_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_WORKER_CHAIN_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_WCHAIN_SIGNATURE UBASE_FOURCC('w','c','h','n')
+
+/** @This describes a stage of a worker chain. */
+struct upipe_wchain_stage {
+    /** linear subpipeline to transfer to the stage thread (belongs to the
+     * callee) */
+    struct upipe *upipe;
+    /** probe hierarchy to use on the stage thread, which must provide the
+     * upump_mgr of the stage thread (belongs to the callee) */
+    struct uprobe *uprobe;
+    /** manager to transfer pipes to the stage thread */
+    struct upipe_mgr *xfer_mgr;
+    /** number of packets in the queue feeding the stage */
+    unsigned int queue_length;
+};
+
+/** @This returns the management structure for all wchain pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_wchain_mgr_alloc(void);
+
+/** @hidden */
+#define ARGS_DECL , const struct upipe_wchain_stage *stages, unsigned int nb_stages, unsigned int output_queue_length
+/** @hidden */
+#define ARGS , stages, nb_stages, output_queue_length
+UPIPE_HELPER_ALLOC(wchain, UPIPE_WCHAIN_SIGNATURE)
+#undef ARGS
+#undef ARGS_DECL
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -30,6 +30,8 @@ extern "C" {
 #include "upipe/uref_attr.h"
 
 UREF_ATTR_STRING(http, content_type, "http.content_type", http content type);
+UREF_ATTR_UNSIGNED(http, size, "http.size", size of the whole resource);
+UREF_ATTR_VOID(http, h2, "http.h2", HTTP/2 is offered to the server);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe sink module for netmap transmit rings
+ *
+ * The uri has the form "netmap:eth0-0/T@239.1.1.1:5000". The part before
+ * the @ is passed to nm_open() and selects the transmit ring, the part after
+ * the @ is the multicast destination of the RTP stream. Ethernet, IPv4,
+ * UDP and RTP headers are written in place in the slots of the ring, in
+ * front of the payload.
+ *
+ * Each incoming uref is cut into datagrams of the configured payload size,
+ * which are spread over the duration of the uref starting from its cr_sys
+ * date, using the attached uclock (typically a @ref uclock_ptp_alloc clock).
+ * The marker bit is set on the last datagram of each uref, so that a packer
+ * outputting one uref per frame (such as the hbrmt packers) marks the end of
+ * frames.
+ *
+ * On "block.rtp." flows, each uref is already a complete RTP packet (as
+ * output by the 2110-20 packer), dated by its own cr_sys: it is sent as is
+ * in a single datagram, behind the Ethernet, IPv4 and UDP headers only.
+ */
+
+#ifndef _UPIPE_NETMAP_UPIPE_NETMAP_SINK_H_
+/** @hidden */
+#define _UPIPE_NETMAP_UPIPE_NETMAP_SINK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_NETMAP_SINK_SIGNATURE UBASE_FOURCC('n','t','m','k')
+
+/** @This extends upipe_command with specific commands for netmap sink. */
+enum upipe_netmap_sink_command {
+    UPIPE_NETMAP_SINK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** get RTP payload type and clock rate (uint8_t *, uint32_t *) */
+    UPIPE_NETMAP_SINK_GET_RTP,
+    /** set RTP payload type and clock rate (unsigned int, uint32_t) */
+    UPIPE_NETMAP_SINK_SET_RTP,
+    /** get the size of the payload of a datagram (unsigned int *) */
+    UPIPE_NETMAP_SINK_GET_PAYLOAD_SIZE,
+    /** set the size of the payload of a datagram (unsigned int) */
+    UPIPE_NETMAP_SINK_SET_PAYLOAD_SIZE,
+};
+
+/** @This returns the management structure for netmap_sink pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_netmap_sink_mgr_alloc(void);
+
+/** @This returns the RTP payload type and clock rate.
+ *
+ * @param upipe description structure of the pipe
+ * @param type_p filled in with the payload type
+ * @param clockrate_p filled in with the clock rate of the timestamps
+ * @return an error code
+ */
+static inline int upipe_netmap_sink_get_rtp(struct upipe *upipe,
+                                            uint8_t *type_p,
+                                            uint32_t *clockrate_p)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SINK_GET_RTP,
+                         UPIPE_NETMAP_SINK_SIGNATURE, type_p, clockrate_p);
+}
+
+/** @This sets the RTP payload type and clock rate. The default is type 98
+ * at 27 MHz, as used by SMPTE ST 2022-6.
+ *
+ * @param upipe description structure of the pipe
+ * @param type payload type
+ * @param clockrate clock rate of the timestamps
+ * @return an error code
+ */
+static inline int upipe_netmap_sink_set_rtp(struct upipe *upipe,
+                                            uint8_t type, uint32_t clockrate)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SINK_SET_RTP,
+                         UPIPE_NETMAP_SINK_SIGNATURE, (unsigned int)type,
+                         clockrate);
+}
+
+/** @This returns the size of the payload of a datagram.
+ *
+ * @param upipe description structure of the pipe
+ * @param size_p filled in with the size in octets
+ * @return an error code
+ */
+static inline int upipe_netmap_sink_get_payload_size(struct upipe *upipe,
+                                                     unsigned int *size_p)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SINK_GET_PAYLOAD_SIZE,
+                         UPIPE_NETMAP_SINK_SIGNATURE, size_p);
+}
+
+/** @This sets the size of the payload of a datagram, after the RTP header.
+ * The default is 1376 octets, as used by SMPTE ST 2022-6.
+ *
+ * @param upipe description structure of the pipe
+ * @param size size in octets
+ * @return an error code
+ */
+static inline int upipe_netmap_sink_set_payload_size(struct upipe *upipe,
+                                                     unsigned int size)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SINK_SET_PAYLOAD_SIZE,
+                         UPIPE_NETMAP_SINK_SIGNATURE, size);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
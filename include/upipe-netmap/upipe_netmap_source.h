@@ -33,12 +33,68 @@ extern "C" {
 #include "upipe/upipe.h"
 
 #define UPIPE_NETMAP_SOURCE_SIGNATURE UBASE_FOURCC('n','t','m','s')
+
+/** @This extends upipe_command with specific commands for netmap source. */
+enum upipe_netmap_source_command {
+    UPIPE_NETMAP_SOURCE_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** enable or disable the TS PID filter (int) */
+    UPIPE_NETMAP_SOURCE_SET_PID_FILTER,
+    /** select a PID in the TS PID filter (unsigned int) */
+    UPIPE_NETMAP_SOURCE_ADD_PID,
+    /** unselect a PID in the TS PID filter (unsigned int) */
+    UPIPE_NETMAP_SOURCE_DEL_PID,
+};
+
 /** @This returns the management structure for netmap_source pipes.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_netmap_source_mgr_alloc(void);
 
+/** @This enables or disables the TS PID filter. When enabled, the packets
+ * of unselected PIDs are removed from datagrams made of whole TS packets
+ * directly in the netmap ring, before any uref is allocated, and datagrams
+ * without any selected packet are skipped. The filter starts with no PID
+ * selected.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to enable the filter
+ * @return an error code
+ */
+static inline int upipe_netmap_source_set_pid_filter(struct upipe *upipe,
+                                                     bool enabled)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SOURCE_SET_PID_FILTER,
+                         UPIPE_NETMAP_SOURCE_SIGNATURE, enabled ? 1 : 0);
+}
+
+/** @This selects a PID in the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to select
+ * @return an error code
+ */
+static inline int upipe_netmap_source_add_pid(struct upipe *upipe,
+                                              unsigned int pid)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SOURCE_ADD_PID,
+                         UPIPE_NETMAP_SOURCE_SIGNATURE, pid);
+}
+
+/** @This unselects a PID in the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to unselect
+ * @return an error code
+ */
+static inline int upipe_netmap_source_del_pid(struct upipe *upipe,
+                                              unsigned int pid)
+{
+    return upipe_control(upipe, UPIPE_NETMAP_SOURCE_DEL_PID,
+                         UPIPE_NETMAP_SOURCE_SIGNATURE, pid);
+}
+
 #ifdef __cplusplus
 }
 #endif
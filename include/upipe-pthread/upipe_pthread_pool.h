@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe pool of POSIX threads running event loops, shared by many
+ * pipelines
+ *
+ * Instead of spawning one thread per pipeline with
+ * @ref upipe_pthread_xfer_mgr_alloc, a fixed number of threads is spawned,
+ * and each new pipeline is placed on the thread with the fewest live
+ * transfer pipes. All the pipes of a pipeline must be transferred with the
+ * same manager, so that a pipeline always runs on a single thread.
+ */
+
+#ifndef _UPIPE_PTHREAD_UPIPE_PTHREAD_POOL_H_
+/** @hidden */
+#define _UPIPE_PTHREAD_UPIPE_PTHREAD_POOL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/urefcount.h"
+#include "upipe-pthread/upipe_pthread_transfer.h"
+
+/** @hidden */
+struct upipe_pthread_pool;
+
+/** @This allocates a pool of threads, each running an event loop.
+ *
+ * @param nb_threads number of threads in the pool
+ * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr of each thread
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param attr pthread attributes
+ * @param sched scheduling parameters applied to all threads, or NULL
+ * @param name prefix of the thread names (followed by the thread index),
+ * or NULL
+ * @return pointer to the pool, or NULL in case of error
+ */
+struct upipe_pthread_pool *upipe_pthread_pool_alloc(unsigned int nb_threads,
+        unsigned int queue_length, uint16_t msg_pool_depth,
+        struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth,
+        const pthread_attr_t *restrict attr,
+        const struct upipe_pthread_sched *sched, const char *name);
+
+/** @This returns the transfer manager of the least loaded thread of the
+ * pool, to be used for all the pipes of a new pipeline (for instance with
+ * @ref upipe_wlin_mgr_alloc). The load of a thread is the number of live
+ * transfer pipes, so that the threads of released pipelines are reused.
+ * This function must always be called from the same thread.
+ *
+ * @param pool pointer to the pool
+ * @return pointer to xfer manager, which must be released by the caller
+ */
+struct upipe_mgr *upipe_pthread_pool_get_xfer_mgr(
+        struct upipe_pthread_pool *pool);
+
+/** @This returns the number of threads of the pool.
+ *
+ * @param pool pointer to the pool
+ * @return number of threads
+ */
+unsigned int upipe_pthread_pool_get_nb_threads(
+        struct upipe_pthread_pool *pool);
+
+/** @This increments the reference count of a pool.
+ *
+ * @param pool pointer to the pool
+ * @return same pointer to the pool
+ */
+struct upipe_pthread_pool *upipe_pthread_pool_use(
+        struct upipe_pthread_pool *pool);
+
+/** @This decrements the reference count of a pool, and frees it when it
+ * reaches zero. Each thread exits once all its transfer pipes are released.
+ *
+ * @param pool pointer to the pool
+ */
+void upipe_pthread_pool_release(struct upipe_pthread_pool *pool);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -40,15 +40,50 @@ extern "C" {
 #include "upipe/upump.h"
 
 #include <stdint.h>
+#include <limits.h>
 #include <pthread.h>
 
 /** @hidden */
 struct umutex;
 
+/** @This describes the scheduling parameters of a transfer thread. */
+struct upipe_pthread_sched {
+    /** nice value of the thread, or INT_MAX to leave it unchanged */
+    int priority;
+    /** scheduling policy (SCHED_FIFO or SCHED_RR), or -1 to leave it
+     * unchanged */
+    int policy;
+    /** real-time priority, for SCHED_FIFO and SCHED_RR */
+    int sched_priority;
+    /** NUMA node the thread and its memory allocations are bound to,
+     * or -1 */
+    int numa_node;
+    /** array of CPUs the thread is pinned to, or NULL for all CPUs (or all
+     * CPUs of the NUMA node) */
+    const unsigned int *cpus;
+    /** number of CPUs in the array */
+    unsigned int nb_cpus;
+};
+
+/** @This initializes scheduling parameters to leave the thread unchanged.
+ *
+ * @param sched scheduling parameters to initialize
+ */
+static inline void upipe_pthread_sched_init(struct upipe_pthread_sched *sched)
+{
+    sched->priority = INT_MAX;
+    sched->policy = -1;
+    sched->sched_priority = 0;
+    sched->numa_node = -1;
+    sched->cpus = NULL;
+    sched->nb_cpus = 0;
+}
+
 /** @This returns a management structure for transfer pipes, using a new
  * pthread. You would need one management structure per target thread.
  *
  * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
  * @param msg_pool_depth maximum number of messages in the pool
  * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
  * with the created upump_mgr
@@ -61,7 +96,7 @@ struct umutex;
  * @param attr pthread attributes
  * @return pointer to xfer manager
  */
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(unsigned int queue_length,
         uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -72,6 +107,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
  * target thread.
  *
  * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
  * @param msg_pool_depth maximum number of messages in the pool
  * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
  * with the created upump_mgr
@@ -85,7 +121,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
  * @param name custom name
  * @return pointer to xfer manager
  */
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named(uint8_t queue_length,
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named(unsigned int queue_length,
         uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -97,6 +133,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named(uint8_t queue_length,
  * structure per target thread.
  *
  * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
  * @param msg_pool_depth maximum number of messages in the pool
  * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
  * with the created upump_mgr
@@ -112,7 +149,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named(uint8_t queue_length,
  */
 UBASE_FMT_PRINTF(10, 11)
 static inline struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named_va(
-        uint8_t queue_length, uint16_t msg_pool_depth,
+        unsigned int queue_length, uint16_t msg_pool_depth,
         struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -133,6 +170,7 @@ static inline struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named_va(
  * pthread. You would need one management structure per target thread.
  *
  * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
  * @param msg_pool_depth maximum number of messages in the pool
  * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
  * with the created upump_mgr
@@ -147,7 +185,7 @@ static inline struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named_va(
  * @return pointer to xfer manager
  */
 struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio(
-    uint8_t queue_length, uint16_t msg_pool_depth,
+    unsigned int queue_length, uint16_t msg_pool_depth,
     struct uprobe *uprobe_pthread_upump_mgr,
     upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
     uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -158,6 +196,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio(
  * pthread. You would need one management structure per target thread.
  *
  * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
  * @param msg_pool_depth maximum number of messages in the pool
  * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
  * with the created upump_mgr
@@ -173,7 +212,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio(
  * @return pointer to xfer manager
  */
 struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named(
-    uint8_t queue_length, uint16_t msg_pool_depth,
+    unsigned int queue_length, uint16_t msg_pool_depth,
     struct uprobe *uprobe_pthread_upump_mgr,
     upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
     uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -185,6 +224,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named(
  * structure per target thread.
  *
  * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
  * @param msg_pool_depth maximum number of messages in the pool
  * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
  * with the created upump_mgr
@@ -201,7 +241,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named(
  */
 UBASE_FMT_PRINTF(11, 12)
 static inline struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named_va(
-        uint8_t queue_length, uint16_t msg_pool_depth,
+        unsigned int queue_length, uint16_t msg_pool_depth,
         struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -219,6 +259,35 @@ static inline struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named_va(
             priority, string), NULL)
 }
 
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread with the given scheduling parameters. The thread is pinned and
+ * bound before its upump manager is allocated, so that the memory allocated
+ * by the pools of the thread comes from the requested NUMA node.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * (max 65536), rounded up to a power of two
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @param sched scheduling parameters, or NULL
+ * @param name custom name or NULL
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_sched(
+    unsigned int queue_length, uint16_t msg_pool_depth,
+    struct uprobe *uprobe_pthread_upump_mgr,
+    upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+    uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+    pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+    const struct upipe_pthread_sched *sched, const char *name);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short probe logging asynchronously from a background thread
+ *
+ * Log events are turned into fixed-size records on the calling thread, and
+ * pushed without locking into a ring private to that thread. A background
+ * thread collects the records of all rings and writes them to the stream,
+ * so that pipeline threads never wait on the output. Records which do not
+ * fit in a full ring are dropped and accounted.
+ */
+
+#ifndef _UPIPE_PTHREAD_UPROBE_PTHREAD_LOG_H_
+/** @hidden */
+#define _UPIPE_PTHREAD_UPROBE_PTHREAD_LOG_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_helper_uprobe.h"
+#include "upipe/ulist.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+/** @This is a super-set of the uprobe structure with additional local
+ * members. */
+struct uprobe_pthread_log {
+    /** file stream to write to */
+    FILE *stream;
+    /** minimum level of printed messages */
+    enum uprobe_log_level min_level;
+    /** number of records of each ring */
+    unsigned int ring_length;
+
+    /** key of the ring of the current thread */
+    pthread_key_t key;
+    /** list of the rings of all threads */
+    struct uchain rings;
+    /** mutex protecting the list of rings and the condition */
+    pthread_mutex_t mutex;
+    /** condition to wake up the background thread */
+    pthread_cond_t cond;
+    /** background thread */
+    pthread_t thread;
+    /** true if the background thread must exit */
+    bool quit;
+
+    /** structure exported to modules */
+    struct uprobe uprobe;
+};
+
+UPROBE_HELPER_UPROBE(uprobe_pthread_log, uprobe);
+
+/** @This initializes an already allocated uprobe_pthread_log structure, and
+ * starts its background thread.
+ *
+ * @param uprobe_pthread_log pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param stream stdio stream to which to log the messages
+ * @param min_level level at which to log the messages
+ * @param ring_length number of records buffered for each thread
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_pthread_log_init(
+        struct uprobe_pthread_log *uprobe_pthread_log,
+        struct uprobe *next, FILE *stream,
+        enum uprobe_log_level min_level, unsigned int ring_length);
+
+/** @This cleans a uprobe_pthread_log structure. The background thread is
+ * stopped after it has written all the pending records.
+ *
+ * @param uprobe_pthread_log structure to clean
+ */
+void uprobe_pthread_log_clean(struct uprobe_pthread_log *uprobe_pthread_log);
+
+/** @This allocates a new uprobe_pthread_log structure.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @param stream stdio stream to which to log the messages
+ * @param min_level level at which to log the messages
+ * @param ring_length number of records buffered for each thread
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_pthread_log_alloc(struct uprobe *next, FILE *stream,
+                                        enum uprobe_log_level min_level,
+                                        unsigned int ring_length);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
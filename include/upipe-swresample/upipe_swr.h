@@ -35,9 +35,53 @@ extern "C" {
 #endif
 
 #include "upipe/upipe.h"
+#include "upipe/ubase.h"
 
 #define UPIPE_SWR_SIGNATURE UBASE_FOURCC('s','w','r',' ')
 
+/** @This extends upipe_command with specific commands for swr pipes. */
+enum upipe_swr_command {
+    UPIPE_SWR_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** enables or disables clock drift compensation (int) */
+    UPIPE_SWR_SET_COMPENSATION,
+    /** sets the measured clock drift rate (const struct urational *) */
+    UPIPE_SWR_SET_DRIFT_RATE,
+};
+
+/** @This enables or disables clock drift compensation. When enabled, the
+ * resampler stretches or shrinks the output by the drift rate, taken
+ * either from @ref upipe_swr_set_drift_rate or from the clock rate
+ * attribute of the incoming urefs, so that no separate upipe_speexdsp is
+ * needed behind it.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to compensate the clock drift
+ * @return an error code
+ */
+static inline int upipe_swr_set_compensation(struct upipe *upipe,
+                                             bool enabled)
+{
+    return upipe_control(upipe, UPIPE_SWR_SET_COMPENSATION,
+                         UPIPE_SWR_SIGNATURE, enabled ? 1 : 0);
+}
+
+/** @This sets the clock drift rate measured by the application, for
+ * instance from the dates of upipe_sync or upipe_grid. The output then
+ * has num/den times as many samples as the input. It takes precedence
+ * over the clock rate attribute of the urefs.
+ *
+ * @param upipe description structure of the pipe
+ * @param drift_rate drift rate, or NULL to use the attribute of the urefs
+ * @return an error code
+ */
+static inline int upipe_swr_set_drift_rate(struct upipe *upipe,
+        const struct urational *drift_rate)
+{
+    return upipe_control(upipe, UPIPE_SWR_SET_DRIFT_RATE,
+                         UPIPE_SWR_SIGNATURE, drift_rate);
+}
+
 /** @This returns the management structure for swr pipes.
  *
  * @return pointer to manager
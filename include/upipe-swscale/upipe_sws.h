@@ -45,7 +45,11 @@ enum upipe_sws_command {
     /** set flags (int) */
     UPIPE_SWS_SET_FLAGS,
     /** get flags (int *) */
-    UPIPE_SWS_GET_FLAGS
+    UPIPE_SWS_GET_FLAGS,
+    /** set the number of scaling threads (unsigned int) */
+    UPIPE_SWS_SET_THREADS,
+    /** get the number of scaling threads (unsigned int *) */
+    UPIPE_SWS_GET_THREADS
 };
 
 /** @This gets the swscale flags.
@@ -72,6 +76,38 @@ static inline bool upipe_sws_set_flags(struct upipe *upipe, int flags)
                          flags);
 }
 
+/** @This gets the number of threads used to scale a picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static inline int upipe_sws_get_threads(struct upipe *upipe,
+                                        unsigned int *threads_p)
+{
+    return upipe_control(upipe, UPIPE_SWS_GET_THREADS, UPIPE_SWS_SIGNATURE,
+                         threads_p);
+}
+
+/** @This sets the number of threads used to scale a picture. Each picture
+ * (or each field of interlaced pictures) is then cut into horizontal slices
+ * scaled concurrently by the libswscale worker pool. 1 (the default) scales
+ * on the pipe thread, and 0 uses as many threads as there are CPUs.
+ *
+ * This requires a libswscale with slice threading (FFmpeg 5.0 or later),
+ * otherwise UBASE_ERR_UNHANDLED is returned for values other than 1.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of threads
+ * @return an error code
+ */
+static inline int upipe_sws_set_threads(struct upipe *upipe,
+                                        unsigned int threads)
+{
+    return upipe_control(upipe, UPIPE_SWS_SET_THREADS, UPIPE_SWS_SIGNATURE,
+                         threads);
+}
+
 /** @This returns the management structure for sws pipes.
  *
  * @return pointer to manager
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe swscale module computing a ladder of renditions in one pass
+ *
+ * Each output subpipe is allocated with a flow definition giving the
+ * horizontal and vertical sizes of a rendition. The outputs are sorted by
+ * decreasing size, and each incoming picture is scaled in cascade: every
+ * rendition is computed from the next-higher one, rather than from the
+ * full-resolution picture. All renditions keep the pixel format of the
+ * input.
+ */
+
+#ifndef _UPIPE_SWSCALE_UPIPE_SWS_LADDER_H_
+/** @hidden */
+#define _UPIPE_SWSCALE_UPIPE_SWS_LADDER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_SWS_LADDER_SIGNATURE UBASE_FOURCC('s','w','s','l')
+#define UPIPE_SWS_LADDER_OUTPUT_SIGNATURE UBASE_FOURCC('s','w','l','o')
+
+/** @This extends upipe_command with specific commands for sws ladder
+ * pipes. */
+enum upipe_sws_ladder_command {
+    UPIPE_SWS_LADDER_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the swscale flags (int) */
+    UPIPE_SWS_LADDER_SET_FLAGS,
+    /** gets the swscale flags (int *) */
+    UPIPE_SWS_LADDER_GET_FLAGS
+};
+
+/** @This gets the swscale flags used for all renditions.
+ *
+ * @param upipe description structure of the pipe
+ * @param flags_p filled in with the swscale flags
+ * @return an error code
+ */
+static inline int upipe_sws_ladder_get_flags(struct upipe *upipe,
+                                             int *flags_p)
+{
+    return upipe_control(upipe, UPIPE_SWS_LADDER_GET_FLAGS,
+                         UPIPE_SWS_LADDER_SIGNATURE, flags_p);
+}
+
+/** @This sets the swscale flags used for all renditions.
+ *
+ * @param upipe description structure of the pipe
+ * @param flags swscale flags
+ * @return an error code
+ */
+static inline int upipe_sws_ladder_set_flags(struct upipe *upipe, int flags)
+{
+    return upipe_control(upipe, UPIPE_SWS_LADDER_SET_FLAGS,
+                         UPIPE_SWS_LADDER_SIGNATURE, flags);
+}
+
+/** @This returns the management structure for sws ladder pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_sws_ladder_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Bin pipe producing thumbnails from the random access points only
+ *
+ * Producing periodic thumbnails of many channels does not require decoding
+ * every frame: this bin drops the coded frames that the framers did not
+ * flag as random access points (uref_flow_get_random), and optionally
+ * the random access points closer than a given period to the previous
+ * thumbnail, before they reach the decoder. The decoded pictures are
+ * scaled to the thumbnail size with @ref upipe_sws_thumbs_mgr_alloc and
+ * encoded with the given encoder manager, for instance an avcodec encoder
+ * pool (@ref upipe_avcenc_pool_mgr_alloc) shared by all the channels.
+ */
+
+#ifndef _UPIPE_SWSCALE_UPIPE_SWS_RAP_THUMBS_H_
+/** @hidden */
+#define _UPIPE_SWSCALE_UPIPE_SWS_RAP_THUMBS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_SWS_RAP_THUMBS_SIGNATURE UBASE_FOURCC('s','w','r','t')
+
+/** @This extends upipe_command with specific commands for rap thumbs. */
+enum upipe_sws_rap_thumbs_command {
+    UPIPE_SWS_RAP_THUMBS_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** sets the minimum period between thumbnails (uint64_t) */
+    UPIPE_SWS_RAP_THUMBS_SET_PERIOD,
+    /** returns the minimum period between thumbnails (uint64_t *) */
+    UPIPE_SWS_RAP_THUMBS_GET_PERIOD,
+};
+
+/** @This sets the minimum period between two thumbnails. Random access
+ * points whose DTS is closer than the period to the previous thumbnail are
+ * not decoded.
+ *
+ * @param upipe description structure of the pipe
+ * @param period period in 27 MHz units (0 = every random access point)
+ * @return an error code
+ */
+static inline int upipe_sws_rap_thumbs_set_period(struct upipe *upipe,
+                                                  uint64_t period)
+{
+    return upipe_control(upipe, UPIPE_SWS_RAP_THUMBS_SET_PERIOD,
+                         UPIPE_SWS_RAP_THUMBS_SIGNATURE, period);
+}
+
+/** @This returns the minimum period between two thumbnails.
+ *
+ * @param upipe description structure of the pipe
+ * @param period_p filled in with the period in 27 MHz units
+ * @return an error code
+ */
+static inline int upipe_sws_rap_thumbs_get_period(struct upipe *upipe,
+                                                  uint64_t *period_p)
+{
+    return upipe_control(upipe, UPIPE_SWS_RAP_THUMBS_GET_PERIOD,
+                         UPIPE_SWS_RAP_THUMBS_SIGNATURE, period_p);
+}
+
+/** @This returns the management structure for rap thumbs pipes.
+ *
+ * @param dec_mgr manager of decoder pipes, for instance from
+ * @ref upipe_avcdec_mgr_alloc
+ * @param enc_mgr manager of picture encoder pipes, allocated with a
+ * block.mjpeg.pic. flow definition
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_sws_rap_thumbs_mgr_alloc(struct upipe_mgr *dec_mgr,
+                                                 struct upipe_mgr *enc_mgr);
+
+/** @This allocates a rap thumbs pipe.
+ *
+ * @param mgr management structure for rap thumbs pipes
+ * @param uprobe structure used to raise events
+ * @param flow_def flow definition of the thumbnails, with the picture
+ * format, hsize and vsize
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static inline struct upipe *upipe_sws_rap_thumbs_alloc(struct upipe_mgr *mgr,
+                                                       struct uprobe *uprobe,
+                                                       struct uref *flow_def)
+{
+    return upipe_flow_alloc(mgr, uprobe, flow_def);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
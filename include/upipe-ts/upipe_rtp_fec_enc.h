@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe SMPTE 2022-1 FEC encoder
+ *
+ * The pipe takes RTP packets as input and outputs them unchanged. For an
+ * L columns by D rows matrix, it also outputs one column FEC packet every
+ * L x D packets on the column subpipe, and one row FEC packet every L
+ * packets on the row subpipe. The parity is updated as packets pass, so
+ * only one FEC payload per column and one for the current row are kept.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_RTP_FEC_ENC_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_RTP_FEC_ENC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_RTP_FEC_ENC_SIGNATURE UBASE_FOURCC('r','f','c','e')
+#define UPIPE_RTP_FEC_ENC_OUTPUT_SIGNATURE UBASE_FOURCC('r','f','c','o')
+
+/** @This extends upipe_command with specific commands for rtp fec enc. */
+enum upipe_rtp_fec_enc_command {
+    UPIPE_RTP_FEC_ENC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the fec-column subpipe (struct upipe **) */
+    UPIPE_RTP_FEC_ENC_GET_COL_SUB,
+    /** returns the fec-row subpipe (struct upipe **) */
+    UPIPE_RTP_FEC_ENC_GET_ROW_SUB,
+    /** sets the matrix size (unsigned int, unsigned int) */
+    UPIPE_RTP_FEC_ENC_SET_MATRIX,
+    /** returns the matrix size (unsigned int *, unsigned int *) */
+    UPIPE_RTP_FEC_ENC_GET_MATRIX,
+};
+
+/** @This returns the column FEC subpipe. The refcount is not incremented
+ * so you have to use it if you want to keep the pointer.
+ *
+ * @param upipe description structure of the super pipe
+ * @param upipe_p filled in with a pointer to the column subpipe
+ * @return an error code
+ */
+static inline int upipe_rtp_fec_enc_get_col_sub(struct upipe *upipe,
+                                                struct upipe **upipe_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_FEC_ENC_GET_COL_SUB,
+                         UPIPE_RTP_FEC_ENC_SIGNATURE, upipe_p);
+}
+
+/** @This returns the row FEC subpipe. The refcount is not incremented
+ * so you have to use it if you want to keep the pointer.
+ *
+ * @param upipe description structure of the super pipe
+ * @param upipe_p filled in with a pointer to the row subpipe
+ * @return an error code
+ */
+static inline int upipe_rtp_fec_enc_get_row_sub(struct upipe *upipe,
+                                                struct upipe **upipe_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_FEC_ENC_GET_ROW_SUB,
+                         UPIPE_RTP_FEC_ENC_SIGNATURE, upipe_p);
+}
+
+/** @This sets the size of the FEC matrix. SMPTE 2022-1 requires
+ * 1 <= columns <= 20, 4 <= rows <= 20 and columns x rows <= 100. The
+ * current matrix is discarded.
+ *
+ * @param upipe description structure of the pipe
+ * @param columns number of columns (L)
+ * @param rows number of rows (D)
+ * @return an error code
+ */
+static inline int upipe_rtp_fec_enc_set_matrix(struct upipe *upipe,
+                                               unsigned int columns,
+                                               unsigned int rows)
+{
+    return upipe_control(upipe, UPIPE_RTP_FEC_ENC_SET_MATRIX,
+                         UPIPE_RTP_FEC_ENC_SIGNATURE, columns, rows);
+}
+
+/** @This returns the size of the FEC matrix.
+ *
+ * @param upipe description structure of the pipe
+ * @param columns_p filled in with the number of columns (L)
+ * @param rows_p filled in with the number of rows (D)
+ * @return an error code
+ */
+static inline int upipe_rtp_fec_enc_get_matrix(struct upipe *upipe,
+                                               unsigned int *columns_p,
+                                               unsigned int *rows_p)
+{
+    return upipe_control(upipe, UPIPE_RTP_FEC_ENC_GET_MATRIX,
+                         UPIPE_RTP_FEC_ENC_SIGNATURE, columns_p, rows_p);
+}
+
+/** @This returns the management structure for rtp fec enc pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_fec_enc_mgr_alloc(void);
+
+/** @This allocates and initializes a rtp fec enc pipe.
+ *
+ * @param mgr management structure for rtp fec enc type
+ * @param uprobe structure used to raise events for the super pipe
+ * @param uprobe_col structure used to raise events for the column subpipe
+ * @param uprobe_row structure used to raise events for the row subpipe
+ * @return pointer to allocated pipe, or NULL in case of failure
+ */
+static inline struct upipe *upipe_rtp_fec_enc_alloc(struct upipe_mgr *mgr,
+                                                    struct uprobe *uprobe,
+                                                    struct uprobe *uprobe_col,
+                                                    struct uprobe *uprobe_row)
+{
+    return upipe_alloc(mgr, uprobe, UPIPE_RTP_FEC_ENC_SIGNATURE,
+                       uprobe_col, uprobe_row);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module analyzing a transport stream without demultiplexing it
+ *
+ * This module is meant for monitoring probes: it checks the first priority
+ * indicators of ETSI TR 101 290 (sync, continuity counters, PAT and PMT
+ * repetition), together with the transport error indicator and PCR
+ * repetition and discontinuities, over whole input blocks. The PAT is
+ * parsed to find the PMT PIDs, but no table is otherwise decoded and no
+ * buffer is split or copied. Input blocks are forwarded untouched.
+ *
+ * Errors are reported with @ref UPROBE_TS_ANALYZER_ERROR, and counted in
+ * @ref upipe_ts_analyzer_stats.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_ANALYZER_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_ANALYZER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_TS_ANALYZER_SIGNATURE UBASE_FOURCC('t','s','a','n')
+
+/** @This enumerates the errors detected by ts_analyzer pipes. */
+enum upipe_ts_analyzer_error {
+    /** two or more consecutive packets without sync byte (TR 101 290 1.1) */
+    UPIPE_TS_ANALYZER_SYNC_LOSS = 0,
+    /** packet without sync byte (TR 101 290 1.2) */
+    UPIPE_TS_ANALYZER_SYNC_BYTE,
+    /** PAT missing for more than 0.5 s, scrambled or with a wrong
+     * table_id (TR 101 290 1.3) */
+    UPIPE_TS_ANALYZER_PAT,
+    /** continuity counter error (TR 101 290 1.4) */
+    UPIPE_TS_ANALYZER_CC,
+    /** PMT missing for more than 0.5 s, scrambled or with a wrong
+     * table_id (TR 101 290 1.5) */
+    UPIPE_TS_ANALYZER_PMT,
+    /** transport error indicator set (TR 101 290 2.1) */
+    UPIPE_TS_ANALYZER_TRANSPORT,
+    /** PCR missing for more than 40 ms (TR 101 290 2.3) */
+    UPIPE_TS_ANALYZER_PCR_REPETITION,
+    /** PCR jump of more than 100 ms without discontinuity indicator
+     * (TR 101 290 2.3a) */
+    UPIPE_TS_ANALYZER_PCR_DISCONTINUITY,
+
+    /** number of error types */
+    UPIPE_TS_ANALYZER_ERROR_MAX
+};
+
+/** @This returns a string describing an error.
+ *
+ * @param error error type
+ * @return a description of the error
+ */
+static inline const char *
+    upipe_ts_analyzer_error_str(enum upipe_ts_analyzer_error error)
+{
+    switch (error) {
+        case UPIPE_TS_ANALYZER_SYNC_LOSS: return "TS_sync_loss";
+        case UPIPE_TS_ANALYZER_SYNC_BYTE: return "Sync_byte_error";
+        case UPIPE_TS_ANALYZER_PAT: return "PAT_error";
+        case UPIPE_TS_ANALYZER_CC: return "Continuity_count_error";
+        case UPIPE_TS_ANALYZER_PMT: return "PMT_error";
+        case UPIPE_TS_ANALYZER_TRANSPORT: return "Transport_error";
+        case UPIPE_TS_ANALYZER_PCR_REPETITION: return "PCR_repetition_error";
+        case UPIPE_TS_ANALYZER_PCR_DISCONTINUITY:
+            return "PCR_discontinuity_indicator_error";
+        case UPIPE_TS_ANALYZER_ERROR_MAX: break;
+    }
+    return "unknown";
+}
+
+/** @This holds the counters of a ts_analyzer pipe. */
+struct upipe_ts_analyzer_stats {
+    /** number of analyzed packets */
+    uint64_t packets;
+    /** number of errors, by type */
+    uint64_t errors[UPIPE_TS_ANALYZER_ERROR_MAX];
+    /** highest difference between the PCR and the arrival time intervals
+     * of consecutive PCRs, in 27 MHz units */
+    uint64_t pcr_jitter_max;
+};
+
+/** @This extends uprobe_event with specific events for ts_analyzer. */
+enum uprobe_ts_analyzer_event {
+    UPROBE_TS_ANALYZER_SENTINEL = UPROBE_LOCAL,
+
+    /** an error was detected (unsigned int error, unsigned int pid), the
+     * PID being 8191 for sync errors */
+    UPROBE_TS_ANALYZER_ERROR
+};
+
+/** @This extends upipe_command with specific commands for ts_analyzer. */
+enum upipe_ts_analyzer_command {
+    UPIPE_TS_ANALYZER_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns the counters (struct upipe_ts_analyzer_stats *) */
+    UPIPE_TS_ANALYZER_GET_STATS,
+    /** resets the counters (void) */
+    UPIPE_TS_ANALYZER_RESET_STATS
+};
+
+/** @This returns the management structure for all ts_analyzer pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_analyzer_mgr_alloc(void);
+
+/** @This returns the counters of a ts_analyzer pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats filled in with the counters
+ * @return an error code
+ */
+static inline int upipe_ts_analyzer_get_stats(struct upipe *upipe,
+        struct upipe_ts_analyzer_stats *stats)
+{
+    return upipe_control(upipe, UPIPE_TS_ANALYZER_GET_STATS,
+                         UPIPE_TS_ANALYZER_SIGNATURE, stats);
+}
+
+/** @This resets the counters of a ts_analyzer pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static inline int upipe_ts_analyzer_reset_stats(struct upipe *upipe)
+{
+    return upipe_control(upipe, UPIPE_TS_ANALYZER_RESET_STATS,
+                         UPIPE_TS_ANALYZER_SIGNATURE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -42,12 +42,53 @@ extern "C" {
 
 #define UPIPE_TS_CHECK_SIGNATURE UBASE_FOURCC('t','s','c','k')
 
+/** @This extends upipe_command with specific commands for ts check. */
+enum upipe_ts_check_command {
+    UPIPE_TS_CHECK_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns true if packed output is enabled (int *) */
+    UPIPE_TS_CHECK_GET_PACKED,
+    /** enables or disables packed output (int) */
+    UPIPE_TS_CHECK_SET_PACKED
+};
+
 /** @This returns the management structure for all ts_check pipes.
  *
  * @return pointer to manager
  */
 struct upipe_mgr *upipe_ts_check_mgr_alloc(void);
 
+/** @This returns true if packed output is enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed_p filled in with true if packed output is enabled
+ * @return an error code
+ */
+static inline int upipe_ts_check_get_packed(struct upipe *upipe,
+                                            bool *packed_p)
+{
+    int packed;
+    UBASE_RETURN(upipe_control(upipe, UPIPE_TS_CHECK_GET_PACKED,
+                               UPIPE_TS_CHECK_SIGNATURE, &packed))
+    *packed_p = !!packed;
+    return UBASE_ERR_NONE;
+}
+
+/** @This enables or disables packed output. In packed mode, the packets
+ * of an input block are checked but not split, and are output as a single
+ * block with the flow definition "block.mpegts.packed.". Packed output is
+ * only available for 188-octet packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed true to output blocks of several packets
+ * @return an error code
+ */
+static inline int upipe_ts_check_set_packed(struct upipe *upipe, bool packed)
+{
+    return upipe_control(upipe, UPIPE_TS_CHECK_SET_PACKED,
+                         UPIPE_TS_CHECK_SIGNATURE, packed ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
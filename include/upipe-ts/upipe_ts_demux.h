@@ -44,6 +44,18 @@ enum uprobe_ts_demux_event {
     UPROBE_TS_DEMUX_SPLIT = UPROBE_LOCAL + 0x1000
 };
 
+/** @This defines the SI tables which may be decoded lazily. */
+enum upipe_ts_demux_si {
+    /** network information table */
+    UPIPE_TS_DEMUX_SI_NIT = 0x1,
+    /** service description table */
+    UPIPE_TS_DEMUX_SI_SDT = 0x2,
+    /** time and date table */
+    UPIPE_TS_DEMUX_SI_TDT = 0x4,
+    /** event information tables (p/f and schedule) */
+    UPIPE_TS_DEMUX_SI_EIT = 0x8,
+};
+
 /** @This extends upipe_command with specific commands for ts demux. */
 enum upipe_ts_demux_command {
     UPIPE_TS_DEMUX_SENTINEL = UPIPE_CONTROL_LOCAL,
@@ -58,6 +70,16 @@ enum upipe_ts_demux_command {
     UPIPE_TS_DEMUX_SET_EIT_ENABLED,
     /** enables  or disables EITs table ID decoding (int) */
     UPIPE_TS_DEMUX_SET_EITS_ENABLED,
+    /** enables or disables packed input (int) */
+    UPIPE_TS_DEMUX_SET_PACKED,
+    /** only exposes a shard of the programs (unsigned int, unsigned int) */
+    UPIPE_TS_DEMUX_SET_PROGRAM_SHARD,
+    /** enables or disables lazy SI decoding (uint64_t) */
+    UPIPE_TS_DEMUX_SET_SI_LAZY,
+    /** subscribes to SI tables in lazy mode (unsigned int) */
+    UPIPE_TS_DEMUX_SUBSCRIBE_SI,
+    /** seeds the demux with a PSI snapshot (struct uref *) */
+    UPIPE_TS_DEMUX_SET_PSI_SNAPSHOT,
 };
 
 /** @This returns the currently detected conformance mode. It cannot return
@@ -128,6 +150,96 @@ static inline int upipe_ts_demux_set_eits_enabled(struct upipe *upipe,
                          UPIPE_TS_DEMUX_SIGNATURE, enabled ? 1 : 0);
 }
 
+/** @This enables or disables packed input. In packed mode, blocks of
+ * several TS packets (for instance 7 packets from a UDP datagram) are kept
+ * whole through ts_sync or ts_check and ts_split, with the flow definition
+ * "block.mpegts.packed.", and are only broken out into individual packets
+ * by ts_decaps. Input with a "block.mpegts.packed." flow definition is
+ * always accepted.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed true to enable packed input
+ * @return an error code
+ */
+static inline int upipe_ts_demux_set_packed(struct upipe *upipe, bool packed)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_SET_PACKED,
+                         UPIPE_TS_DEMUX_SIGNATURE, packed ? 1 : 0);
+}
+
+/** @This restricts the programs exposed by the demux (through
+ * @ref upipe_split_iterate) to the programs whose number modulo count is
+ * equal to index. This allows to run several demuxes on the same stream,
+ * each in its own thread, sharing out the programs of a multiplex. The
+ * PSI tables and the PCR of a program are then only handled by the demux
+ * owning the program.
+ *
+ * @param upipe description structure of the pipe
+ * @param index index of the shard, lower than count
+ * @param count number of shards, or 1 to expose all programs (default)
+ * @return an error code
+ */
+static inline int upipe_ts_demux_set_program_shard(struct upipe *upipe,
+                                                   unsigned int index,
+                                                   unsigned int count)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_SET_PROGRAM_SHARD,
+                         UPIPE_TS_DEMUX_SIGNATURE, index, count);
+}
+
+/** @This enables or disables lazy SI decoding. In lazy mode, the NIT, SDT,
+ * TDT and EIT decoders are only allocated while the corresponding tables are
+ * subscribed with @ref upipe_ts_demux_subscribe_si, even if the conformance
+ * calls for them. Subscriptions that are not renewed within the timeout,
+ * measured on the cr_sys dates of the input, expire and the decoders are
+ * released.
+ *
+ * @param upipe description structure of the pipe
+ * @param timeout inactivity timeout of subscriptions in units of
+ * @ref #UCLOCK_FREQ, or 0 to always decode SI tables (default)
+ * @return an error code
+ */
+static inline int upipe_ts_demux_set_si_lazy(struct upipe *upipe,
+                                             uint64_t timeout)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_SET_SI_LAZY,
+                         UPIPE_TS_DEMUX_SIGNATURE, timeout);
+}
+
+/** @This subscribes to SI tables in lazy mode, starting the decoders that
+ * the conformance calls for. Subscribing again renews the subscription.
+ *
+ * @param upipe description structure of the pipe
+ * @param tables mask of @ref upipe_ts_demux_si tables
+ * @return an error code
+ */
+static inline int upipe_ts_demux_subscribe_si(struct upipe *upipe,
+                                              unsigned int tables)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_SUBSCRIBE_SI,
+                         UPIPE_TS_DEMUX_SIGNATURE, tables);
+}
+
+/** @This seeds the demux with a snapshot of PSI tables, for instance saved
+ * from a previous run, so that programs and outputs are announced without
+ * waiting for the tables on the wire. The snapshot is a block containing
+ * PAT, PMT and SDT sections, as found in the TS, concatenated. The PAT and
+ * SDT are decoded immediately and the PMT of a program is decoded when the
+ * program is allocated. The tables received afterwards from the stream are
+ * compared to the snapshot, and trigger regular updates if they differ.
+ *
+ * @param upipe description structure of the pipe
+ * @param snapshot block with concatenated PSI sections, which is not
+ * absorbed, or NULL to release the current snapshot
+ * @return an error code
+ */
+static inline int upipe_ts_demux_set_psi_snapshot(struct upipe *upipe,
+                                                  struct uref *snapshot)
+{
+    return upipe_control(upipe, UPIPE_TS_DEMUX_SET_PSI_SNAPSHOT,
+                         UPIPE_TS_DEMUX_SIGNATURE, snapshot);
+}
+
 /** @This returns the management structure for all ts_demux pipes.
  *
  * @return pointer to manager
@@ -49,6 +49,8 @@ enum upipe_ts_emmd_command {
 
     /** sets the private key file (const char *) */
     UPIPE_TS_EMM_SET_PRIVATE_KEY,
+    /** runs RSA decryption in a separate thread (int) */
+    UPIPE_TS_EMM_SET_ASYNC,
 };
 
 /** @This sets the BISS-CA private key.
@@ -64,6 +66,20 @@ static inline int upipe_ts_emmd_set_private_key(struct upipe *upipe,
             UPIPE_TS_EMMD_SIGNATURE, private_key);
 }
 
+/** @This runs the RSA decryption of the EMM in a separate thread, so that
+ * the thread of the pipe is not blocked. The session keys are then applied
+ * when the decryption completes, from the upump manager of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param async true to decrypt in a separate thread
+ * @return an error code
+ */
+static inline int upipe_ts_emmd_set_async(struct upipe *upipe, bool async)
+{
+    return upipe_control(upipe, UPIPE_TS_EMM_SET_ASYNC,
+            UPIPE_TS_EMMD_SIGNATURE, async ? 1 : 0);
+}
+
 /** @This returns the management structure for all ts_emmd pipes.
  *
  * @return pointer to manager
@@ -51,6 +51,9 @@ enum upipe_ts_encaps_command {
     /** returns a ubuf containing a TS packet and its dts_sys (uint64_t,
      * uint64_t, struct ubuf **, uint64_t *) */
     UPIPE_TS_ENCAPS_SPLICE,
+    /** writes a TS packet into the given buffer and returns its dts_sys
+     * (uint64_t, uint64_t, uint8_t *, uint64_t *) */
+    UPIPE_TS_ENCAPS_SPLICE_INTO,
     /** signals an end of stream (void) */
     UPIPE_TS_ENCAPS_EOS
 };
@@ -86,6 +89,26 @@ static inline int upipe_ts_encaps_splice(struct upipe *upipe,
                                cr_sys_min, cr_sys_max, ubuf_p, dts_sys_p);
 }
 
+/** @This writes a TS packet into a buffer supplied by the caller, and
+ * returns the dts_sys of the packet. Contrary to @ref upipe_ts_encaps_splice,
+ * no ubuf is allocated and the payload is copied.
+ *
+ * @param upipe description structure of the pipe
+ * @param cr_sys_min date at which the packet will be muxed
+ * @param cr_sys_max maximum date allowed for muxing
+ * @param buffer buffer of at least TS_SIZE octets
+ * @param dts_sys_p filled in with the dts_sys, or UINT64_MAX
+ * @return an error code
+ */
+static inline int upipe_ts_encaps_splice_into(struct upipe *upipe,
+        uint64_t cr_sys_min, uint64_t cr_sys_max,
+        uint8_t *buffer, uint64_t *dts_sys_p)
+{
+    return upipe_control_nodbg(upipe, UPIPE_TS_ENCAPS_SPLICE_INTO,
+                               UPIPE_TS_ENCAPS_SIGNATURE,
+                               cr_sys_min, cr_sys_max, buffer, dts_sys_p);
+}
+
 /** @This signals an end of stream, so that buffered packets can be released.
  *
  * @param upipe description structure of the pipe
@@ -44,6 +44,9 @@ enum uprobe_ts_mux_event {
 
     /** last continuity counter for an input (unsigned int) */
     UPROBE_TS_MUX_LAST_CC,
+    /** octetrate spent in padding over the last second, and total
+     * octetrate of the multiplex (uint64_t, uint64_t) */
+    UPROBE_TS_MUX_SPARE_OCTETRATE,
 
     /** ts_encaps events begin here */
     UPROBE_TS_MUX_ENCAPS = UPROBE_LOCAL + 0x1000
@@ -165,6 +168,12 @@ enum upipe_ts_mux_command {
     UPIPE_TS_MUX_PREPARE,
     /** sets the mux maximum octetrate (uint64_t) */
     UPIPE_TS_MUX_SET_MAX_OCTETRATE,
+    /** returns the number of slices per picture in low-latency mode
+     * (unsigned int *) */
+    UPIPE_TS_MUX_GET_SLICES,
+    /** sets the number of slices per picture in low-latency mode
+     * (unsigned int) */
+    UPIPE_TS_MUX_SET_SLICES,
 
     /** ts_encaps commands begin here */
     UPIPE_TS_MUX_ENCAPS = UPIPE_CONTROL_LOCAL + 0x1000,
@@ -759,6 +768,36 @@ static inline int upipe_ts_mux_set_max_octetrate(struct upipe *upipe,
                          UPIPE_TS_MUX_SIGNATURE, max_octetrate);
 }
 
+/** @This returns the number of slices per picture in low-latency mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param slices_p filled in with the number of slices, or 0
+ * @return an error code
+ */
+static inline int upipe_ts_mux_get_slices(struct upipe *upipe,
+                                          unsigned int *slices_p)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_GET_SLICES,
+                         UPIPE_TS_MUX_SIGNATURE, slices_p);
+}
+
+/** @This sets the number of slices per picture of a video input, and
+ * switches it to low-latency mode: TS packetization starts from partial
+ * access units (urefs without dates or start flag continue the current
+ * access unit), with a PES length of 0. Set to 0 to wait for whole access
+ * units again. It is taken into account by the next flow definition.
+ *
+ * @param upipe description structure of the input pipe
+ * @param slices number of slices per picture, or 0
+ * @return an error code
+ */
+static inline int upipe_ts_mux_set_slices(struct upipe *upipe,
+                                          unsigned int slices)
+{
+    return upipe_control(upipe, UPIPE_TS_MUX_SET_SLICES,
+                         UPIPE_TS_MUX_SIGNATURE, slices);
+}
+
 /** @This returns a description string for local commands.
  *
  * @param cmd control command
@@ -40,6 +40,8 @@ enum upipe_ts_pcr_interpolator_sink_command {
 
     /** returns the bitrate (struct urational*) **/
     UPIPE_TS_PCR_INTERPOLATOR_GET_BITRATE,
+    /** sets the PCR PID of the multiplex (int) **/
+    UPIPE_TS_PCR_INTERPOLATOR_SET_PCR_PID,
 };
 
 /** @This returns the current bitrate of the pipe.
@@ -55,6 +57,24 @@ static inline int upipe_ts_pcr_interpolator_get_bitrate(struct upipe *upipe,
                           UPIPE_TS_PCR_INTERPOLATOR_SIGNATURE, urational);
 }
 
+/** @This switches the pipe to multiplex mode. The PCRs are then read from
+ * the adaptation fields of the given PID, instead of the cr_prog attribute,
+ * and every incoming uref, which may contain several TS packets, gets a
+ * cr_prog interpolated for its first packet. The computed octetrate is
+ * exported in the output flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PCR PID, 8192 to use the first PID carrying a PCR, or -1 to
+ * read the cr_prog attribute of single packets (default)
+ * @return an error code
+ */
+static inline int upipe_ts_pcr_interpolator_set_pcr_pid(struct upipe *upipe,
+                                                        int pid)
+{
+    return upipe_control(upipe, UPIPE_TS_PCR_INTERPOLATOR_SET_PCR_PID,
+                         UPIPE_TS_PCR_INTERPOLATOR_SIGNATURE, pid);
+}
+
 /** @This returns the management structure for all ts_pcr_interpolator pipes.
  *
  * @return pointer to manager
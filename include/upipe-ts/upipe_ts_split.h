@@ -46,6 +46,11 @@ enum uprobe_ts_split_event {
 };
 
 /** @This returns the management structure for all ts_split pipes.
+ *
+ * The pipe accepts blocks containing one or several TS packets. When a
+ * block contains several packets (for instance 7 packets from a UDP
+ * datagram), runs of consecutive packets with the same PID are output as a
+ * single block, so outputs may receive multi-packet blocks.
  *
  * @return pointer to manager
  */
@@ -49,7 +49,11 @@ enum upipe_ts_sync_command {
     /** returns the configured number of packets to synchronize with (int *) */
     UPIPE_TS_SYNC_GET_SYNC,
     /** sets the configured number of packets to synchronize with (int) */
-    UPIPE_TS_SYNC_SET_SYNC
+    UPIPE_TS_SYNC_SET_SYNC,
+    /** returns true if packed output is enabled (int *) */
+    UPIPE_TS_SYNC_GET_PACKED,
+    /** enables or disables packed output (int) */
+    UPIPE_TS_SYNC_SET_PACKED
 };
 
 /** @This returns the management structure for all ts_sync pipes.
@@ -84,6 +88,36 @@ static inline int upipe_ts_sync_set_sync(struct upipe *upipe, int sync)
                          sync);
 }
 
+/** @This returns true if packed output is enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed_p filled in with true if packed output is enabled
+ * @return an error code
+ */
+static inline int upipe_ts_sync_get_packed(struct upipe *upipe, bool *packed_p)
+{
+    int packed;
+    UBASE_RETURN(upipe_control(upipe, UPIPE_TS_SYNC_GET_PACKED,
+                               UPIPE_TS_SYNC_SIGNATURE, &packed))
+    *packed_p = !!packed;
+    return UBASE_ERR_NONE;
+}
+
+/** @This enables or disables packed output. In packed mode, consecutive
+ * synchronized packets are output as a single block with the flow
+ * definition "block.mpegts.packed.". Packed output is only available for
+ * 188-octet packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed true to output blocks of several packets
+ * @return an error code
+ */
+static inline int upipe_ts_sync_set_packed(struct upipe *upipe, bool packed)
+{
+    return upipe_control(upipe, UPIPE_TS_SYNC_SET_PACKED,
+                         UPIPE_TS_SYNC_SIGNATURE, packed ? 1 : 0);
+}
+
 #ifdef __cplusplus
 }
 #endif
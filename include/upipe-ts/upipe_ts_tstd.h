@@ -34,6 +34,16 @@ extern "C" {
 
 #define UPIPE_TS_TSTD_SIGNATURE UBASE_FOURCC('t','s','t','d')
 
+/** @This extends uprobe_event with specific events for ts tstd. */
+enum uprobe_ts_tstd_event {
+    UPROBE_TS_TSTD_SENTINEL = UPROBE_LOCAL,
+
+    /** fullness and size of the T-STD buffer in octets, thrown on each
+     * random access point so that rate control may be adjusted per GOP
+     * (uint64_t, uint64_t) */
+    UPROBE_TS_TSTD_FULLNESS
+};
+
 /** @This returns the management structure for all ts_tstd pipes.
  *
  * @return pointer to manager
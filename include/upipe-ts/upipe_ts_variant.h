@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module deriving a transport stream variant
+ *
+ * This module is fed with the output of a ts_mux, usually through a dup pipe
+ * so that several variants share the same refcounted buffers. Each subpipe
+ * carries the PSI sections of one PID for this variant (typically from
+ * another ts_psig): packets of that PID in the input multiplex are replaced,
+ * together with padding packets, by packets of the variant's own sections,
+ * with their own continuity counter. All other packets are left untouched,
+ * and buffers are only copied when one of their packets is rewritten.
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_VARIANT_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_VARIANT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_TS_VARIANT_SIGNATURE UBASE_FOURCC('t','s','v','r')
+#define UPIPE_TS_VARIANT_SUB_SIGNATURE UBASE_FOURCC('t','s','v','s')
+
+/** @This returns the management structure for all ts_variant pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_variant_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Bin pipe demultiplexing a TS with a pool of worker threads
+ * The input stream is duplicated to one ts_demux per worker, each of them
+ * transferred to a remote upump_mgr through a wsink. Every ts_demux only
+ * exposes a shard of the programs of the multiplex (see
+ * @ref upipe_ts_demux_set_program_shard), so that the PMT, PCR and
+ * elementary streams of a program are all handled by the same thread, while
+ * the PAT is decoded independently by every worker.
+ *
+ * Note that the allocator requires two additional parameters:
+ * @table 2
+ * @item uprobe_remote @item probe hierarchy used by the ts_demux pipes on
+ * the remote threads (belongs to the callee); it is typically where the
+ * programs and their outputs are allocated, and must be thread-safe
+ * @item input_queue_length @item number of packets in the queue between main
+ * and remote threads
+ * @end table
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_WORKER_DEMUX_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_WORKER_DEMUX_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_TS_WDEMUX_SIGNATURE UBASE_FOURCC('t','s','w','d')
+
+/** @This returns the management structure for all ts_wdemux pipes.
+ *
+ * @param ts_demux_mgr manager of the ts_demux pipes running on the workers
+ * @param xfer_mgrs array of managers to transfer pipes to the remote
+ * threads, one per worker
+ * @param nb_workers number of elements in xfer_mgrs
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_wdemux_mgr_alloc(struct upipe_mgr *ts_demux_mgr,
+                                            struct upipe_mgr **xfer_mgrs,
+                                            unsigned int nb_workers);
+
+/** @hidden */
+#define ARGS_DECL , struct uprobe *uprobe_remote, unsigned int input_queue_length
+/** @hidden */
+#define ARGS , uprobe_remote, input_queue_length
+UPIPE_HELPER_ALLOC(ts_wdemux, UPIPE_TS_WDEMUX_SIGNATURE)
+#undef ARGS
+#undef ARGS_DECL
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -55,6 +55,8 @@ UREF_ATTR_SMALL_UNSIGNED(ts_flow, pes_header, "t.pes_header",
         minimum PES header size)
 UREF_ATTR_UNSIGNED(ts_flow, pes_min_duration, "t.pes_mindur",
         minimum PES duration)
+UREF_ATTR_VOID(ts_flow, pes_partial, "t.pes_partial",
+        PES started from partial access units)
 
 /* PMT */
 UREF_ATTR_SMALL_UNSIGNED(ts_flow, component_type, "t.ctype", component type)
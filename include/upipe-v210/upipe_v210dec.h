@@ -38,6 +38,10 @@ extern "C" {
 #define UPIPE_V210DEC_SIGNATURE UBASE_FOURCC('v','2','1','d')
 
 /** @This returns the management structure for v210 pipes.
+ *
+ * The output format is given by the flow definition passed at allocation:
+ * planar 4:2:2 or 4:2:0, 8 or 10 bits. In 4:2:0 the chroma of each pair of
+ * lines (of the same field for interlaced pictures) is averaged.
  *
  * @return pointer to manager
  */
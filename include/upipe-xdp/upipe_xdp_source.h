@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe source module for AF_XDP sockets
+ *
+ * The pipe opens an AF_XDP socket on one receive queue of a network
+ * interface, and loads an XDP program redirecting to it the IPv4 UDP
+ * datagrams sent to the ports of its sub-pipes. Other packets are passed to
+ * the kernel network stack.
+ *
+ * The uri of the pipe is the name of the interface, optionally followed by
+ * the receive queue: "eth0" or "eth0/3" (queue 0 by default).
+ *
+ * Sub-pipes are allocated with @ref upipe_void_alloc_sub, and their uri is
+ * the destination of the datagrams to output: "239.1.1.1:1234", or ":1234"
+ * for any destination address. Multicast groups are joined on the interface.
+ *
+ * Received blocks point directly into the UMEM frames shared with the
+ * kernel, and the frames are given back to the fill ring when the blocks are
+ * freed, so downstream pipes holding blocks for a long time reduce the
+ * number of frames available for reception.
+ */
+
+#ifndef _UPIPE_XDP_UPIPE_XDP_SOURCE_H_
+/** @hidden */
+#define _UPIPE_XDP_UPIPE_XDP_SOURCE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/upipe.h"
+
+#define UPIPE_XDPSRC_SIGNATURE UBASE_FOURCC('x','d','p','s')
+#define UPIPE_XDPSRC_SUB_SIGNATURE UBASE_FOURCC('x','d','p','o')
+
+/** @This extends upipe_command with specific commands. */
+enum upipe_xdpsrc_command {
+    UPIPE_XDPSRC_SENTINEL = UPIPE_CONTROL_LOCAL,
+
+    /** returns true if the socket is bound in zero-copy mode (int *) */
+    UPIPE_XDPSRC_GET_ZEROCOPY,
+};
+
+/** @This returns whether the socket is bound in zero-copy mode. Drivers
+ * without AF_XDP support fall back to copy mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param zerocopy_p filled in with true in zero-copy mode
+ * @return an error code
+ */
+static inline int upipe_xdpsrc_get_zerocopy(struct upipe *upipe,
+                                            int *zerocopy_p)
+{
+    return upipe_control(upipe, UPIPE_XDPSRC_GET_ZEROCOPY,
+                         UPIPE_XDPSRC_SIGNATURE, zerocopy_p);
+}
+
+/** @This returns the management structure for xdp_source pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xdpsrc_mgr_alloc(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
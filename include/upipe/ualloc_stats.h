@@ -0,0 +1,192 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe allocation statistics of pools of buffers and structures
+ */
+
+#ifndef _UPIPE_UALLOC_STATS_H_
+/** @hidden */
+#define _UPIPE_UALLOC_STATS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+#include "upipe/uatomic.h"
+
+#include <stdint.h>
+
+/** @This is a snapshot of the allocation statistics of a pool, as returned
+ * by the managers. */
+struct ualloc_stats {
+    /** number of allocations served from the pool */
+    uint64_t hits;
+    /** number of allocations which fell back to the system allocator */
+    uint64_t misses;
+    /** number of releases given back to the system because the pool was
+     * full */
+    uint64_t overflows;
+    /** number of elements currently retained in the pool */
+    uint64_t retained;
+    /** highest number of elements retained in the pool */
+    uint64_t high_water;
+    /** number of octets currently retained in the pool */
+    uint64_t retained_bytes;
+};
+
+/** @This holds the live allocation counters of a pool. They may be updated
+ * from several threads at once, and wrap around at 2^32. */
+struct ualloc_counters {
+    /** number of allocations served from the pool */
+    uatomic_uint32_t hits;
+    /** number of allocations which fell back to the system allocator */
+    uatomic_uint32_t misses;
+    /** number of releases given back to the system */
+    uatomic_uint32_t overflows;
+    /** number of elements currently retained in the pool */
+    uatomic_uint32_t retained;
+    /** highest number of elements retained in the pool */
+    uatomic_uint32_t high_water;
+};
+
+/** @This initializes allocation counters.
+ *
+ * @param counters pointer to allocation counters
+ */
+static inline void ualloc_counters_init(struct ualloc_counters *counters)
+{
+    uatomic_init(&counters->hits, 0);
+    uatomic_init(&counters->misses, 0);
+    uatomic_init(&counters->overflows, 0);
+    uatomic_init(&counters->retained, 0);
+    uatomic_init(&counters->high_water, 0);
+}
+
+/** @This cleans up allocation counters.
+ *
+ * @param counters pointer to allocation counters
+ */
+static inline void ualloc_counters_clean(struct ualloc_counters *counters)
+{
+    uatomic_clean(&counters->hits);
+    uatomic_clean(&counters->misses);
+    uatomic_clean(&counters->overflows);
+    uatomic_clean(&counters->retained);
+    uatomic_clean(&counters->high_water);
+}
+
+/** @This accounts for elements put into the pool.
+ *
+ * @param counters pointer to allocation counters
+ * @param nb number of elements
+ */
+static inline void ualloc_counters_put(struct ualloc_counters *counters,
+                                       uint32_t nb)
+{
+    uint32_t retained = uatomic_fetch_add(&counters->retained, nb) + nb;
+    uint32_t high_water = uatomic_load(&counters->high_water);
+    while (unlikely(retained > high_water && retained <= INT32_MAX &&
+                    !uatomic_compare_exchange(&counters->high_water,
+                                              &high_water, retained)));
+}
+
+/** @This accounts for elements taken out of the pool.
+ *
+ * @param counters pointer to allocation counters
+ * @param nb number of elements
+ */
+static inline void ualloc_counters_take(struct ualloc_counters *counters,
+                                        uint32_t nb)
+{
+    uatomic_fetch_sub(&counters->retained, nb);
+}
+
+/** @This accounts for allocations served from the pool.
+ *
+ * @param counters pointer to allocation counters
+ * @param nb number of allocations
+ */
+static inline void ualloc_counters_hit(struct ualloc_counters *counters,
+                                       uint32_t nb)
+{
+    uatomic_fetch_add(&counters->hits, nb);
+    ualloc_counters_take(counters, nb);
+}
+
+/** @This accounts for an allocation which fell back to the system.
+ *
+ * @param counters pointer to allocation counters
+ */
+static inline void ualloc_counters_miss(struct ualloc_counters *counters)
+{
+    uatomic_fetch_add(&counters->misses, 1);
+}
+
+/** @This accounts for a release which was given back to the system.
+ *
+ * @param counters pointer to allocation counters
+ */
+static inline void ualloc_counters_overflow(struct ualloc_counters *counters)
+{
+    uatomic_fetch_add(&counters->overflows, 1);
+}
+
+/** @This adds the current value of allocation counters to a snapshot.
+ * As elements may be taken out of the pool before the corresponding put
+ * is accounted for, a transiently negative number of retained elements is
+ * reported as 0.
+ *
+ * @param stats snapshot to add to
+ * @param counters pointer to allocation counters
+ * @param size size in octets of an element, or 0 if unknown
+ */
+static inline void ualloc_counters_add(struct ualloc_stats *stats,
+                                       struct ualloc_counters *counters,
+                                       size_t size)
+{
+    uint32_t retained = uatomic_load(&counters->retained);
+    if (unlikely(retained > INT32_MAX))
+        retained = 0;
+    stats->hits += uatomic_load(&counters->hits);
+    stats->misses += uatomic_load(&counters->misses);
+    stats->overflows += uatomic_load(&counters->overflows);
+    stats->retained += retained;
+    stats->high_water += uatomic_load(&counters->high_water);
+    stats->retained_bytes += (uint64_t)retained * size;
+}
+
+/** @This resets a snapshot of allocation statistics.
+ *
+ * @param stats snapshot to reset
+ */
+static inline void ualloc_stats_init(struct ualloc_stats *stats)
+{
+    stats->hits = stats->misses = stats->overflows = 0;
+    stats->retained = stats->high_water = stats->retained_bytes = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
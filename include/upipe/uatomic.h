@@ -65,6 +65,8 @@ typedef void * _Atomic uatomic_ptr_t;
 #define uatomic_fetch_add atomic_fetch_add
 #define uatomic_fetch_sub atomic_fetch_sub
 
+#define uatomic_fence() atomic_thread_fence(memory_order_seq_cst)
+
 #elif defined(UPIPE_HAVE_ATOMIC_OPS)
 
 /*
@@ -160,6 +162,14 @@ static inline uint32_t uatomic_fetch_sub(uatomic_uint32_t *obj,
     return __atomic_fetch_sub(obj, operand, __ATOMIC_SEQ_CST);
 }
 
+/** @This issues a full memory barrier, ordering the memory accesses that
+ * are not done through uatomic variables (for instance in a seqlock).
+ */
+static inline void uatomic_fence(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
 
 #elif defined(UPIPE_HAVE_SEMAPHORE_H) /* mkdoc:skip */
 
@@ -237,6 +247,11 @@ static inline uint32_t uatomic_fetch_sub(uatomic_uint32_t *obj,
     return ret;
 }
 
+static inline void uatomic_fence(void)
+{
+    __sync_synchronize();
+}
+
 
 
 #else /* mkdoc:skip */
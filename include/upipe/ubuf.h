@@ -47,6 +47,8 @@ extern "C" {
 struct ubuf_mgr;
 /** @hidden */
 struct uref;
+/** @hidden */
+struct ualloc_stats;
 
 /** @This is allocated by a manager and eventually points to a buffer
  * containing data. */
@@ -127,6 +129,8 @@ enum ubuf_command {
     UBUF_ITERATE_SOUND_PLANE,
     /** split an interlaced picture into its two fields */
     UBUF_PICTURE_SPLIT_FIELDS,
+    /** size of the buffer space available after a block ubuf (size_t *) */
+    UBUF_TAILROOM_BLOCK,
 
     /** non-standard commands implemented by a ubuf manager can start from
      * there */
@@ -140,6 +144,15 @@ enum ubuf_mgr_command {
     UBUF_MGR_CHECK,
     /** release all buffers kept in pools (void) */
     UBUF_MGR_VACUUM,
+    /** allocate several block ubufs at once (int, struct ubuf **,
+     * unsigned int, unsigned int *) */
+    UBUF_MGR_ALLOC_BLOCK_BATCH,
+    /** returns the allocation statistics of the pools
+     * (struct ualloc_stats *) */
+    UBUF_MGR_GET_STATS,
+    /** sets the maximum number of structures retained in each pool
+     * (unsigned int) */
+    UBUF_MGR_SET_POOL_LIMIT,
 
     /** non-standard commands implemented by a ubuf manager can start from
      * there */
@@ -327,6 +340,33 @@ static inline int ubuf_mgr_vacuum(struct ubuf_mgr *mgr)
     return ubuf_mgr_control(mgr, UBUF_MGR_VACUUM);
 }
 
+/** @This adds the allocation statistics of the pools of a ubuf manager to a
+ * snapshot.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param stats snapshot to add to
+ * @return an error code
+ */
+static inline int ubuf_mgr_get_stats(struct ubuf_mgr *mgr,
+                                     struct ualloc_stats *stats)
+{
+    return ubuf_mgr_control(mgr, UBUF_MGR_GET_STATS, stats);
+}
+
+/** @This changes the maximum number of structures retained in each pool of
+ * a ubuf manager, within the depths given at allocation, and releases the
+ * structures above the new limit.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param limit maximum number of structures retained in each pool
+ * @return an error code
+ */
+static inline int ubuf_mgr_set_pool_limit(struct ubuf_mgr *mgr,
+                                          unsigned int limit)
+{
+    return ubuf_mgr_control(mgr, UBUF_MGR_SET_POOL_LIMIT, limit);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,6 +37,7 @@ extern "C" {
 
 #include "upipe/ubase.h"
 #include "upipe/ubuf.h"
+#include "upipe/uatomic.h"
 #include "upipe/ubits.h"
 
 #include <stdint.h>
@@ -68,6 +69,9 @@ struct ubuf_block {
     bool map;
     /** mapped buffer */
     uint8_t *buffer;
+    /** reference count of the shared buffer space, or NULL if UBUF_SINGLE
+     * needs to be called */
+    uatomic_uint32_t *refcount;
 
     /** cached last ubuf */
     struct ubuf *cached_ubuf;
@@ -95,6 +99,35 @@ static inline struct ubuf *ubuf_block_alloc(struct ubuf_mgr *mgr, int size)
     return ubuf_alloc(mgr, UBUF_ALLOC_BLOCK, size);
 }
 
+/** @This returns several new ubufs of the same size from a block allocator.
+ * Managers which do not implement batch allocation fall back to individual
+ * allocations.
+ *
+ * @param mgr management structure for this ubuf type
+ * @param size size of each buffer
+ * @param ubufs array written with the allocated ubufs
+ * @param nb number of ubufs to allocate
+ * @return number of allocated ubufs, which may be lower than nb in case of
+ * failure
+ */
+static inline unsigned int ubuf_block_alloc_batch(struct ubuf_mgr *mgr,
+                                                  int size,
+                                                  struct ubuf **ubufs,
+                                                  unsigned int nb)
+{
+    unsigned int count;
+    if (ubase_check(ubuf_mgr_control(mgr, UBUF_MGR_ALLOC_BLOCK_BATCH,
+                                     size, ubufs, nb, &count)))
+        return count;
+
+    for (count = 0; count < nb; count++) {
+        ubufs[count] = ubuf_block_alloc(mgr, size);
+        if (unlikely(ubufs[count] == NULL))
+            break;
+    }
+    return count;
+}
+
 /** @This returns the size of the buffer pointed to by a block ubuf.
  *
  * @param ubuf pointer to ubuf
@@ -153,6 +186,39 @@ static inline struct ubuf *ubuf_block_get(struct ubuf *ubuf, int *offset_p,
     return ubuf;
 }
 
+/** @internal @This resolves the offset and size of an access to a block
+ * ubuf made of a single segment which doesn't need to be mapped, without
+ * going through @ref ubuf_block_get.
+ *
+ * @param ubuf pointer to head ubuf
+ * @param offset_p reference to the offset of the buffer space wanted, in
+ * octets, negative values start from the end (may not be NULL), filled in
+ * with the positive offset
+ * @param size_p reference to the size of the buffer space wanted, in octets,
+ * or -1 for the end of the block (may be NULL), filled in with the actual
+ * size
+ * @return an error code, or UBASE_ERR_UNHANDLED if the generic path must be
+ * used
+ */
+static inline int ubuf_block_get_single(struct ubuf *ubuf, int *offset_p,
+                                        int *size_p)
+{
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    if (unlikely(block->next_ubuf != NULL || block->map))
+        return UBASE_ERR_UNHANDLED;
+
+    int size = block->size;
+    if (*offset_p < 0)
+        *offset_p += size;
+    if (size_p != NULL && *size_p == -1)
+        *size_p = size - *offset_p;
+    if (unlikely(*offset_p < 0 || *offset_p >= size))
+        return UBASE_ERR_INVALID;
+    if (size_p != NULL && *size_p > size - *offset_p)
+        *size_p = size - *offset_p;
+    return UBASE_ERR_NONE;
+}
+
 /** @This returns the size of the largest linear buffer that can be read at a
  * given offset.
  *
@@ -193,11 +259,20 @@ static inline int ubuf_block_size_linear(struct ubuf *ubuf,
 static inline int ubuf_block_read(struct ubuf *ubuf, int offset,
                                   int *size_p, const uint8_t **buffer_p)
 {
-    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK ||
-                 (ubuf = ubuf_block_get(ubuf, &offset, size_p)) == NULL))
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK))
         return UBASE_ERR_INVALID;
 
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    int err = ubuf_block_get_single(ubuf, &offset, size_p);
+    if (likely(err == UBASE_ERR_NONE)) {
+        *buffer_p = block->buffer + block->offset + offset;
+        return UBASE_ERR_NONE;
+    }
+    if (unlikely(err != UBASE_ERR_UNHANDLED ||
+                 (ubuf = ubuf_block_get(ubuf, &offset, size_p)) == NULL))
+        return UBASE_ERR_INVALID;
+
+    block = ubuf_block_from_ubuf(ubuf);
     if (block->map) {
         UBASE_RETURN(ubuf_control(ubuf, UBUF_MAP_BLOCK, buffer_p))
     } else
@@ -229,13 +304,24 @@ static inline int ubuf_block_read(struct ubuf *ubuf, int offset,
 static inline int ubuf_block_write(struct ubuf *ubuf, int offset,
                                    int *size_p, uint8_t **buffer_p)
 {
-    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK ||
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    int err = ubuf_block_get_single(ubuf, &offset, size_p);
+    if (likely(err == UBASE_ERR_NONE && block->refcount != NULL)) {
+        if (unlikely(uatomic_load(block->refcount) != 1))
+            return UBASE_ERR_BUSY;
+        *buffer_p = block->buffer + block->offset + offset;
+        return UBASE_ERR_NONE;
+    }
+    if (unlikely(err == UBASE_ERR_INVALID ||
                  (ubuf = ubuf_block_get(ubuf, &offset, size_p)) == NULL))
         return UBASE_ERR_INVALID;
 
     UBASE_RETURN(ubuf_control(ubuf, UBUF_SINGLE))
 
-    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    block = ubuf_block_from_ubuf(ubuf);
     if (block->map) {
         UBASE_RETURN(ubuf_control(ubuf, UBUF_MAP_BLOCK, buffer_p))
     } else
@@ -257,8 +343,13 @@ static inline int ubuf_block_write(struct ubuf *ubuf, int offset,
  */
 static inline int ubuf_block_unmap(struct ubuf *ubuf, int offset)
 {
-    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK ||
-                 (ubuf = ubuf_block_get(ubuf, &offset, NULL)) == NULL))
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+
+    int err = ubuf_block_get_single(ubuf, &offset, NULL);
+    if (likely(err != UBASE_ERR_UNHANDLED))
+        return err;
+    if (unlikely((ubuf = ubuf_block_get(ubuf, &offset, NULL)) == NULL))
         return UBASE_ERR_INVALID;
 
     struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
@@ -488,6 +579,32 @@ static inline int ubuf_block_resize(struct ubuf *ubuf, int offset, int new_size)
     return UBASE_ERR_NONE;
 }
 
+/** @This returns the size of the buffer space available after the end of a
+ * block ubuf, in its last segment. This space is not part of the block and
+ * its content is undefined; it may only be written if the ubuf is not
+ * shared.
+ *
+ * @param ubuf pointer to ubuf
+ * @param tailroom_p reference written with the size of the available space
+ * @return an error code, UBASE_ERR_UNHANDLED if the manager doesn't know
+ */
+static inline int ubuf_block_tailroom(struct ubuf *ubuf, size_t *tailroom_p)
+{
+    if (unlikely(ubuf->mgr->signature != UBUF_ALLOC_BLOCK))
+        return UBASE_ERR_INVALID;
+
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    if (block->cached_end_ubuf != NULL) {
+        ubuf = block->cached_end_ubuf;
+        block = ubuf_block_from_ubuf(ubuf);
+    }
+    while (block->next_ubuf != NULL) {
+        ubuf = block->next_ubuf;
+        block = ubuf_block_from_ubuf(ubuf);
+    }
+    return ubuf_control(ubuf, UBUF_TAILROOM_BLOCK, tailroom_p);
+}
+
 /** @This prepends a block ubuf, if possible. This will only work if
  * prepend has been correctly specified at allocation.
  *
@@ -1066,7 +1183,71 @@ static inline int ubuf_block_scan(struct ubuf *ubuf, size_t *offset_p,
     return UBASE_ERR_INVALID;
 }
 
-/** @This finds a multi-octet word in a block ubuf.
+/** @This scans a linear buffer for an MPEG-style 3-octet start code
+ * (00 00 01), using SIMD instructions when the CPU supports them.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @return pointer to the first octet of the first start code lying entirely
+ * in the buffer, or end if none was found
+ */
+const uint8_t *ubuf_block_scan_startcode(const uint8_t *p, const uint8_t *end);
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of the above function, see upipe/ucpu.h */
+extern struct ucpu_kernel ubuf_block_scan_startcode_kernel;
+
+/** @This finds an MPEG-style 3-octet start code (00 00 01) in a block ubuf,
+ * including start codes spanning several segments.
+ *
+ * @param ubuf pointer to ubuf
+ * @param offset_p start offset (in octets), written with the offset of the
+ * first start code, or first candidate if there aren't enough octets in the
+ * ubuf, or the total size of the ubuf if none was found
+ * @return UBASE_ERR_NONE if the start code was found
+ */
+static inline int ubuf_block_find_startcode(struct ubuf *ubuf,
+                                            size_t *offset_p)
+{
+    size_t offset = *offset_p;
+    /* number of zero octets (up to 2) ending the previous segments */
+    unsigned int zeros = 0;
+    const uint8_t *buffer;
+    int size = -1;
+    while (ubase_check(ubuf_block_read(ubuf, offset, &size, &buffer))) {
+        const uint8_t *end = buffer + size;
+        size_t found = SIZE_MAX;
+        if (zeros >= 2 && buffer[0] == 1)
+            found = offset - 2;
+        else if (zeros >= 1 && size >= 2 && buffer[0] == 0 && buffer[1] == 1)
+            found = offset - 1;
+        else {
+            const uint8_t *p = ubuf_block_scan_startcode(buffer, end);
+            if (p < end)
+                found = offset + (p - buffer);
+        }
+
+        unsigned int next_zeros = 0;
+        if (end[-1] == 0)
+            next_zeros = size >= 2 ? (end[-2] == 0 ? 2 : 1) :
+                         (zeros ? 2 : 1);
+        ubuf_block_unmap(ubuf, offset);
+
+        if (found != SIZE_MAX) {
+            *offset_p = found;
+            return UBASE_ERR_NONE;
+        }
+        zeros = next_zeros;
+        offset += size;
+        size = -1;
+    }
+    *offset_p = offset - zeros;
+    return UBASE_ERR_INVALID;
+}
+
+/** @This finds a multi-octet word in a block ubuf. MPEG-style start codes
+ * (00 00 01) are searched with @ref ubuf_block_find_startcode.
  *
  * @param ubuf pointer to ubuf
  * @param offset_p start offset (in octets), written with the offset of the
@@ -1083,6 +1264,15 @@ static inline int ubuf_block_find_va(struct ubuf *ubuf, size_t *offset_p,
     unsigned int sync = va_arg(args, unsigned int);
     if (nb_octets == 1)
         return ubuf_block_scan(ubuf, offset_p, sync);
+    if (nb_octets == 3 && sync == 0) {
+        va_list args_copy;
+        va_copy(args_copy, args);
+        unsigned int second = va_arg(args_copy, unsigned int);
+        unsigned int third = va_arg(args_copy, unsigned int);
+        va_end(args_copy);
+        if (second == 0 && third == 1)
+            return ubuf_block_find_startcode(ubuf, offset_p);
+    }
 
     for ( ; ; ) {
         UBASE_RETURN(ubuf_block_scan(ubuf, offset_p, sync))
@@ -57,6 +57,7 @@ static inline void ubuf_block_common_init(struct ubuf *ubuf, bool map)
 
     block->map = map;
     block->buffer = NULL;
+    block->refcount = NULL;
 
     block->cached_ubuf = block->cached_end_ubuf = ubuf;
     block->cached_offset = 0;
@@ -90,6 +91,19 @@ static inline void ubuf_block_common_set_buffer(struct ubuf *ubuf,
     block->buffer = buffer;
 }
 
+/** @internal @This sets the reference count of the shared buffer space,
+ * allowing @ref ubuf_block_write to check it without calling UBUF_SINGLE.
+ *
+ * @param refcount optional pointer to the reference count, equal to 1 when
+ * the buffer space is not shared
+ */
+static inline void ubuf_block_common_set_refcount(struct ubuf *ubuf,
+                                                  uatomic_uint32_t *refcount)
+{
+    struct ubuf_block *block = ubuf_block_from_ubuf(ubuf);
+    block->refcount = refcount;
+}
+
 /** @This duplicates common sections of a block ubuf, and duplicates other
  * segments.
  *
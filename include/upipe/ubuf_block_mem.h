@@ -43,6 +43,19 @@ extern "C" {
 /** @hidden */
 struct umem_mgr;
 
+/** @This is a simple signature to make sure the ubuf_mgr_control internal
+ * API is used properly. */
+#define UBUF_BLOCK_MEM_SIGNATURE UBASE_FOURCC('b','m','e','m')
+
+/** @This extends ubuf_mgr_command with specific commands for block mem
+ * manager. */
+enum ubuf_block_mem_mgr_command {
+    UBUF_BLOCK_MEM_MGR_SENTINEL = UBUF_MGR_CONTROL_LOCAL,
+
+    /** sets the maximum size of blocks allocated in slabs (size_t) */
+    UBUF_BLOCK_MEM_MGR_SET_SLAB_SIZE
+};
+
 /** @This is the signature to use to allocate from an ubuf_pic plane. */
 #define UBUF_BLOCK_MEM_ALLOC_FROM_PIC UBASE_FOURCC('m','e','m','p')
 /** @This is the signature to use to allocate from an ubuf_sound plane. */
@@ -76,6 +89,22 @@ static inline struct ubuf *ubuf_block_mem_alloc_from_sound(struct ubuf_mgr *mgr,
     return ubuf_alloc(mgr, UBUF_BLOCK_MEM_ALLOC_FROM_SOUND, ubuf_sound, channel);
 }
 
+/** @This sets the maximum size of the blocks allocated in slabs. A slab
+ * holds the ubuf structure, the shared structure and the buffer in a single
+ * cache-line-aligned allocation, which is kept in a pool of the manager
+ * instead of going through the umem manager. Slabs are disabled by default.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param slab_size maximum size of a block in a slab, or 0 to disable slabs
+ * @return an error code
+ */
+static inline int ubuf_block_mem_mgr_set_slab_size(struct ubuf_mgr *mgr,
+                                                   size_t slab_size)
+{
+    return ubuf_mgr_control(mgr, UBUF_BLOCK_MEM_MGR_SET_SLAB_SIZE,
+                            UBUF_BLOCK_MEM_SIGNATURE, slab_size);
+}
+
 /** @This allocates a new instance of the ubuf manager for block formats
  * using umem.
  *
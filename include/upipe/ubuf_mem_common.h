@@ -253,6 +253,33 @@ static void STRUCTURE##_mgr_vacuum_pool(struct ubuf_mgr *mgr)               \
     upool_vacuum(&mem_mgr->UBUF_POOL);                                      \
     upool_vacuum(&mem_mgr->SHARED_POOL);                                    \
 }                                                                           \
+/** @internal @This adds the allocation statistics of the pools to a        \
+ * snapshot.                                                                \
+ *                                                                          \
+ * @param mgr pointer to a ubuf manager                                     \
+ * @param stats snapshot to add to                                          \
+ */                                                                         \
+static void STRUCTURE##_mgr_get_stats_pool(struct ubuf_mgr *mgr,            \
+                                           struct ualloc_stats *stats)      \
+{                                                                           \
+    struct STRUCTURE##_mgr *mem_mgr = STRUCTURE##_mgr_from_ubuf_mgr(mgr);   \
+    upool_get_stats(&mem_mgr->UBUF_POOL, stats, sizeof(struct STRUCTURE));  \
+    upool_get_stats(&mem_mgr->SHARED_POOL, stats,                           \
+                    sizeof(struct ubuf_mem_shared));                        \
+}                                                                           \
+/** @internal @This changes the maximum number of structures retained in    \
+ * the pools.                                                               \
+ *                                                                          \
+ * @param mgr pointer to a ubuf manager                                     \
+ * @param limit maximum number of structures retained in each pool          \
+ */                                                                         \
+static void STRUCTURE##_mgr_set_limit_pool(struct ubuf_mgr *mgr,            \
+                                           unsigned int limit)              \
+{                                                                           \
+    struct STRUCTURE##_mgr *mem_mgr = STRUCTURE##_mgr_from_ubuf_mgr(mgr);   \
+    upool_set_limit(&mem_mgr->UBUF_POOL, limit);                            \
+    upool_set_limit(&mem_mgr->SHARED_POOL, limit);                          \
+}                                                                           \
 /** @internal @This is called on deallocation of the manager.               \
  *                                                                          \
  * @param mgr pointer to a ubuf manager                                     \
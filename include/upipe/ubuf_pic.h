@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include "upipe/ubuf.h"
+#include "upipe/ubuf_pic_blend.h"
 
 #include <stdint.h>
 
@@ -369,7 +370,7 @@ static inline int ubuf_pic_resize(struct ubuf *ubuf, int hskip, int vskip,
  * @param alpha alpha multiplier
  * @param threshold alpha blending method
  *    0 means ignore alpha
- *    255 means blends src and dest together using alpha levels (slow)
+ *    255 means blends src and dest together using alpha levels
  *    Any value in between means using the src pixels if and only if
  *      their alpha value is more than this value
  * @return an error code
@@ -427,41 +428,43 @@ static inline int ubuf_pic_blit_alpha(struct ubuf *dest, struct ubuf *src,
                           src_macropixel_size;
         int plane_vsize = extract_vsize / src_vsub;
 
+        /* single component planes of more than 8 bits (y10l, u16l...)
+         * are blended as little-endian 16-bit samples */
+        bool words = strlen(chroma) == 4 && chroma[1] != '8' &&
+                     chroma[3] == 'l';
+        uintptr_t len = words ? plane_hsize / 2 : plane_hsize;
+
         for (int i = 0; i < plane_vsize; i++) {
+            const uint8_t *alpha_line = alpha_plane == NULL ? NULL :
+                alpha_plane + alpha_stride * (i * src_vsub);
+            uint16_t *dest_words = (uint16_t *)dest_buffer;
+            const uint16_t *src_words = (const uint16_t *)src_buffer;
+
             if ((!alpha_plane && alpha == 0xff) || threshold == 0) {
                 memcpy(dest_buffer, src_buffer, plane_hsize);
             } else if (!alpha_plane) {
-                for (int j = 0; j < plane_hsize; j++) {
-                    dest_buffer[j] = (dest_buffer[j] * (0xff - alpha) + src_buffer[j] * alpha) / 0xff;
-                }
+                if (words)
+                    ubuf_pic_blend_16(dest_words, src_words, alpha, len);
+                else
+                    ubuf_pic_blend_8(dest_buffer, src_buffer, alpha, len);
             } else if (threshold != 0xff) {
                 /* This is an on/off blending
                  * if alpha is over the threshold, we use the subpicture pixel.
                  */
-                if (alpha == 0xff) {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub];
-                        if (a > threshold) dest_buffer[j] = src_buffer[j];
-                    }
-                } else {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = (uint16_t)alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub] * (uint16_t)alpha / 0xff;
-                        if (a > threshold) dest_buffer[j] = src_buffer[j];
-                    }
-                }
+                if (words)
+                    ubuf_pic_key_alpha_16(dest_words, src_words, alpha_line,
+                                          src_hsub, alpha, threshold, len);
+                else
+                    ubuf_pic_key_alpha_8(dest_buffer, src_buffer, alpha_line,
+                                         src_hsub, alpha, threshold, len);
             } else {
-                /* smooth and slow blending */
-                if (alpha == 0xff) {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub];
-                        dest_buffer[j] = (dest_buffer[j] * (0xff - a) + src_buffer[j] * a) / 0xff;
-                    }
-                } else {
-                    for (int j = 0; j < plane_hsize; j++) {
-                        const uint8_t a = (uint16_t)alpha_plane[alpha_stride * (i * src_vsub) + j * src_hsub] * (uint16_t)alpha / 0xff;
-                        dest_buffer[j] = (dest_buffer[j] * (0xff - a) + src_buffer[j] * a) / 0xff;
-                    }
-                }
+                /* smooth blending */
+                if (words)
+                    ubuf_pic_blend_alpha_16(dest_words, src_words, alpha_line,
+                                            src_hsub, alpha, len);
+                else
+                    ubuf_pic_blend_alpha_8(dest_buffer, src_buffer,
+                                           alpha_line, src_hsub, alpha, len);
             }
             dest_buffer += dest_stride;
             src_buffer += src_stride;
@@ -504,7 +507,9 @@ static inline int ubuf_pic_blit(struct ubuf *dest, struct ubuf *src,
     size_t alpha_stride = 0;
     int ret;
 
-    if (!ubase_check(ubuf_pic_plane_read(src, "a8", 0, 0, -1, -1, &alpha_plane))) {
+    if (!ubase_check(ubuf_pic_plane_read(src, "a8", src_hoffset, src_voffset,
+                                         extract_hsize, extract_vsize,
+                                         &alpha_plane))) {
         alpha_plane = NULL;
     } else if (unlikely(!ubase_check(ubuf_pic_plane_size(src, "a8", &alpha_stride,
                             NULL, NULL, NULL)))) {
@@ -519,7 +524,8 @@ static inline int ubuf_pic_blit(struct ubuf *dest, struct ubuf *src,
 
 end:
     if (alpha_plane)
-        ubuf_pic_plane_unmap(src, "a8", 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(src, "a8", src_hoffset, src_voffset,
+                             extract_hsize, extract_vsize);
 
     return ret;
 }
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe line kernels for picture blending
+ * This file defines the kernels used to blend picture planes line by line,
+ * for 8-bit samples and for 16-bit little-endian samples (10 to 16 bits).
+ */
+
+#ifndef _UPIPE_UBUF_PIC_BLEND_H_
+/** @hidden */
+#define _UPIPE_UBUF_PIC_BLEND_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+#define UBUF_PIC_BLEND_X86
+#endif
+
+#if defined(__aarch64__)
+/** @hidden */
+#define UBUF_PIC_BLEND_NEON
+#endif
+
+/** @hidden */
+#define UBUF_PIC_BLEND_DECLARE(suffix)                                      \
+void ubuf_pic_blend_8_##suffix(uint8_t *dst, const uint8_t *src,            \
+                               uint8_t alpha, uintptr_t len);               \
+void ubuf_pic_blend_alpha_8_##suffix(uint8_t *dst, const uint8_t *src,      \
+                                     const uint8_t *alpha_plane,            \
+                                     uintptr_t hsub, uint8_t alpha,         \
+                                     uintptr_t len);                        \
+void ubuf_pic_key_alpha_8_##suffix(uint8_t *dst, const uint8_t *src,        \
+                                   const uint8_t *alpha_plane,              \
+                                   uintptr_t hsub, uint8_t alpha,           \
+                                   uint8_t threshold, uintptr_t len);       \
+void ubuf_pic_average_8_##suffix(uint8_t *dst, const uint8_t *src1,         \
+                                 const uint8_t *src2, uintptr_t len);       \
+void ubuf_pic_blend_16_##suffix(uint16_t *dst, const uint16_t *src,         \
+                                uint8_t alpha, uintptr_t len);              \
+void ubuf_pic_blend_alpha_16_##suffix(uint16_t *dst, const uint16_t *src,   \
+                                      const uint8_t *alpha_plane,           \
+                                      uintptr_t hsub, uint8_t alpha,        \
+                                      uintptr_t len);                       \
+void ubuf_pic_key_alpha_16_##suffix(uint16_t *dst, const uint16_t *src,     \
+                                    const uint8_t *alpha_plane,             \
+                                    uintptr_t hsub, uint8_t alpha,          \
+                                    uint8_t threshold, uintptr_t len);      \
+void ubuf_pic_average_16_##suffix(uint16_t *dst, const uint16_t *src1,      \
+                                  const uint16_t *src2, uintptr_t len);
+
+/* reference implementations */
+UBUF_PIC_BLEND_DECLARE(c)
+
+#ifdef UBUF_PIC_BLEND_X86
+/* process 16 (sse2) or 32 (avx2) octets per iteration, any alignment */
+UBUF_PIC_BLEND_DECLARE(sse2)
+UBUF_PIC_BLEND_DECLARE(avx2)
+#endif
+
+#ifdef UBUF_PIC_BLEND_NEON
+/* process 16 octets per iteration, any alignment */
+UBUF_PIC_BLEND_DECLARE(neon)
+#endif
+
+/** @This blends a line of 8-bit samples with a constant alpha:
+ * dst = (dst * (255 - alpha) + src * alpha) / 255.
+ *
+ * @param dst destination line
+ * @param src source line
+ * @param alpha opacity of the source
+ * @param len number of samples
+ */
+void ubuf_pic_blend_8(uint8_t *dst, const uint8_t *src,
+                      uint8_t alpha, uintptr_t len);
+
+/** @This blends a line of 8-bit samples with an alpha plane. The opacity of
+ * sample i is alpha_plane[i * hsub] * alpha / 255.
+ *
+ * @param dst destination line
+ * @param src source line
+ * @param alpha_plane line of the alpha plane
+ * @param hsub horizontal subsampling of the plane relative to the alpha plane
+ * @param alpha alpha multiplier
+ * @param len number of samples
+ */
+void ubuf_pic_blend_alpha_8(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *alpha_plane, uintptr_t hsub,
+                            uint8_t alpha, uintptr_t len);
+
+/** @This copies the 8-bit samples of a line whose opacity (computed as in
+ * @ref ubuf_pic_blend_alpha_8) is above a threshold.
+ *
+ * @param dst destination line
+ * @param src source line
+ * @param alpha_plane line of the alpha plane
+ * @param hsub horizontal subsampling of the plane relative to the alpha plane
+ * @param alpha alpha multiplier
+ * @param threshold opacity threshold
+ * @param len number of samples
+ */
+void ubuf_pic_key_alpha_8(uint8_t *dst, const uint8_t *src,
+                          const uint8_t *alpha_plane, uintptr_t hsub,
+                          uint8_t alpha, uint8_t threshold, uintptr_t len);
+
+/** @This computes the mean (rounded down) of two lines of 8-bit samples.
+ *
+ * @param dst destination line
+ * @param src1 first source line
+ * @param src2 second source line
+ * @param len number of samples
+ */
+void ubuf_pic_average_8(uint8_t *dst, const uint8_t *src1,
+                        const uint8_t *src2, uintptr_t len);
+
+/** @This blends a line of 16-bit samples with a constant alpha:
+ * dst = (dst * (256 - a) + src * a) >> 8, with a = alpha + (alpha >> 7).
+ *
+ * @param dst destination line
+ * @param src source line
+ * @param alpha opacity of the source
+ * @param len number of samples
+ */
+void ubuf_pic_blend_16(uint16_t *dst, const uint16_t *src,
+                       uint8_t alpha, uintptr_t len);
+
+/** @This blends a line of 16-bit samples with an alpha plane, as in
+ * @ref ubuf_pic_blend_alpha_8 and @ref ubuf_pic_blend_16.
+ *
+ * @param dst destination line
+ * @param src source line
+ * @param alpha_plane line of the alpha plane
+ * @param hsub horizontal subsampling of the plane relative to the alpha plane
+ * @param alpha alpha multiplier
+ * @param len number of samples
+ */
+void ubuf_pic_blend_alpha_16(uint16_t *dst, const uint16_t *src,
+                             const uint8_t *alpha_plane, uintptr_t hsub,
+                             uint8_t alpha, uintptr_t len);
+
+/** @This copies the 16-bit samples of a line whose opacity is above a
+ * threshold, as in @ref ubuf_pic_key_alpha_8.
+ *
+ * @param dst destination line
+ * @param src source line
+ * @param alpha_plane line of the alpha plane
+ * @param hsub horizontal subsampling of the plane relative to the alpha plane
+ * @param alpha alpha multiplier
+ * @param threshold opacity threshold
+ * @param len number of samples
+ */
+void ubuf_pic_key_alpha_16(uint16_t *dst, const uint16_t *src,
+                           const uint8_t *alpha_plane, uintptr_t hsub,
+                           uint8_t alpha, uint8_t threshold, uintptr_t len);
+
+/** @This computes the mean (rounded down) of two lines of 16-bit samples.
+ *
+ * @param dst destination line
+ * @param src1 first source line
+ * @param src2 second source line
+ * @param len number of samples
+ */
+void ubuf_pic_average_16(uint16_t *dst, const uint16_t *src1,
+                         const uint16_t *src2, uintptr_t len);
+
+/** @hidden */
+struct ucpu_kernel;
+
+/* implementations of the above functions, see upipe/ucpu.h */
+extern struct ucpu_kernel ubuf_pic_blend_8_kernel;
+extern struct ucpu_kernel ubuf_pic_blend_alpha_8_kernel;
+extern struct ucpu_kernel ubuf_pic_key_alpha_8_kernel;
+extern struct ucpu_kernel ubuf_pic_average_8_kernel;
+extern struct ucpu_kernel ubuf_pic_blend_16_kernel;
+extern struct ucpu_kernel ubuf_pic_blend_alpha_16_kernel;
+extern struct ucpu_kernel ubuf_pic_key_alpha_16_kernel;
+extern struct ucpu_kernel ubuf_pic_average_16_kernel;
+
+#ifdef __cplusplus
+}
+#endif
+#endif
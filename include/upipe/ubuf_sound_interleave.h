@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe kernels for interleaved sound buffers
+ * This file defines the kernels used to extract channels from packed
+ * (interleaved) sound buffers.
+ */
+
+#ifndef _UPIPE_UBUF_SOUND_INTERLEAVE_H_
+/** @hidden */
+#define _UPIPE_UBUF_SOUND_INTERLEAVE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+#define UBUF_SOUND_INTERLEAVE_X86
+#endif
+
+#if defined(__aarch64__)
+/** @hidden */
+#define UBUF_SOUND_INTERLEAVE_NEON
+#endif
+
+/** @hidden */
+#define UBUF_SOUND_INTERLEAVE_DECLARE(suffix)                               \
+void ubuf_sound_deinterleave_16_##suffix(uint8_t *const *dst,               \
+                                         const uint8_t *src,                \
+                                         uint8_t channels,                  \
+                                         uintptr_t samples);                \
+void ubuf_sound_deinterleave_32_##suffix(uint8_t *const *dst,               \
+                                         const uint8_t *src,                \
+                                         uint8_t channels,                  \
+                                         uintptr_t samples);
+
+/* reference implementations */
+UBUF_SOUND_INTERLEAVE_DECLARE(c)
+
+#ifdef UBUF_SOUND_INTERLEAVE_X86
+/* transpose blocks of 4 channels when channels is a multiple of 4 */
+UBUF_SOUND_INTERLEAVE_DECLARE(sse2)
+#endif
+
+#ifdef UBUF_SOUND_INTERLEAVE_NEON
+/* transpose blocks of 4 channels when channels is a multiple of 4 */
+UBUF_SOUND_INTERLEAVE_DECLARE(neon)
+#endif
+
+/** @This deinterleaves packed 16-bit samples into one plane per channel.
+ *
+ * @param dst array of channels plane pointers, NULL for channels to skip
+ * @param src packed samples
+ * @param channels number of channels in src
+ * @param samples number of samples per channel
+ */
+void ubuf_sound_deinterleave_16(uint8_t *const *dst, const uint8_t *src,
+                                uint8_t channels, uintptr_t samples);
+
+/** @This deinterleaves packed 32-bit (s32 or f32) samples into one plane per
+ * channel.
+ *
+ * @param dst array of channels plane pointers, NULL for channels to skip
+ * @param src packed samples
+ * @param channels number of channels in src
+ * @param samples number of samples per channel
+ */
+void ubuf_sound_deinterleave_32(uint8_t *const *dst, const uint8_t *src,
+                                uint8_t channels, uintptr_t samples);
+
+/** @This deinterleaves packed samples of any size into one plane per
+ * channel.
+ *
+ * @param dst array of channels plane pointers, NULL for channels to skip
+ * @param src packed samples
+ * @param channel_size size of a sample of one channel in octets
+ * @param channels number of channels in src
+ * @param samples number of samples per channel
+ */
+void ubuf_sound_deinterleave(uint8_t *const *dst, const uint8_t *src,
+                             uint8_t channel_size, uint8_t channels,
+                             uintptr_t samples);
+
+/** @This copies a subset of the channels of packed samples to another packed
+ * buffer, keeping their order.
+ *
+ * @param dst packed output samples
+ * @param src packed input samples
+ * @param channel_size size of a sample of one channel in octets
+ * @param channels number of channels in src
+ * @param mask bit field of the channels of src to copy
+ * @param samples number of samples per channel
+ */
+void ubuf_sound_select(uint8_t *dst, const uint8_t *src,
+                       uint8_t channel_size, uint8_t channels,
+                       uint64_t mask, uintptr_t samples);
+
+/** @hidden */
+struct ucpu_kernel;
+
+/* implementations of the above functions, see upipe/ucpu.h */
+extern struct ucpu_kernel ubuf_sound_deinterleave_16_kernel;
+extern struct ucpu_kernel ubuf_sound_deinterleave_32_kernel;
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe ubuf manager tracking the lifetime of ubufs
+ *
+ * The tracking manager wraps another ubuf manager, which still allocates
+ * the buffers. A sample of the live ubufs is recorded with its allocation
+ * site, date and size for blocks, and a histogram of the live samples by
+ * site and age may be printed on demand. Ubufs allocated through the manager
+ * keep pointing to it as long as they live, including their duplicates.
+ */
+
+#ifndef _UPIPE_UBUF_TRACK_H_
+/** @hidden */
+#define _UPIPE_UBUF_TRACK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubuf.h"
+
+#include <stdio.h>
+
+#define UBUF_TRACK_SIGNATURE UBASE_FOURCC('t','r','k','b')
+
+/** @This extends ubuf_mgr_command with specific commands for the tracking
+ * manager. */
+enum ubuf_track_mgr_command {
+    UBUF_TRACK_MGR_SENTINEL = UBUF_MGR_CONTROL_LOCAL,
+
+    /** prints the live sampled ubufs (FILE *) */
+    UBUF_TRACK_MGR_DUMP
+};
+
+/** @This prints a histogram of the live sampled ubufs by allocation site
+ * and age.
+ *
+ * @param mgr pointer to tracking ubuf manager
+ * @param file file to print to
+ * @return an error code
+ */
+static inline int ubuf_track_mgr_dump(struct ubuf_mgr *mgr, FILE *file)
+{
+    return ubuf_mgr_control(mgr, UBUF_TRACK_MGR_DUMP, UBUF_TRACK_SIGNATURE,
+                            file);
+}
+
+/** @This allocates a ubuf manager tracking the ubufs allocated with another
+ * manager.
+ *
+ * @param ubuf_mgr ubuf manager allocating the ubufs
+ * @param period one ubuf out of period is sampled (1 to track all ubufs)
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_track_mgr_alloc(struct ubuf_mgr *ubuf_mgr,
+                                      unsigned int period);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe implementation of uclock using the CPU cycle counter
+ *
+ * This clock reads the invariant TSC on x86-64 or the generic timer virtual
+ * counter (CNTVCT_EL0) on aarch64, and converts it to 27 MHz ticks using
+ * a scale calibrated against the system clock. The scale is periodically
+ * corrected so that the clock does not drift away from the system clock.
+ */
+
+#ifndef _UPIPE_UCLOCK_TSC_H_
+/** @hidden */
+#define _UPIPE_UCLOCK_TSC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/uclock.h"
+#include "upipe/uclock_std.h"
+
+/** @This allocates a new uclock structure based on the CPU cycle counter.
+ * The system clock used for calibration is selected by the same flags as
+ * @ref uclock_std_alloc.
+ *
+ * @param flags flags for the creation of a uclock structure
+ * @return pointer to uclock, or NULL if no suitable counter is available
+ * (in which case @ref uclock_std_alloc should be used)
+ */
+struct uclock *uclock_tsc_alloc(enum uclock_std_flags flags);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
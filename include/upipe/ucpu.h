@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe runtime CPU dispatch
+ * This file defines the facility used to pick the best implementation of
+ * a SIMD kernel for the running CPU.
+ *
+ * A kernel is described by a @ref ucpu_kernel structure listing its
+ * implementations, best first, ending with the portable one (no required
+ * flag). The first implementation whose flags are all supported is
+ * selected on first use, and the kernel is then added to a process-wide
+ * list which may be walked with @ref ucpu_kernel_iterate.
+ *
+ * The environment variable UPIPE_CPU_FLAGS restricts the flags used, for
+ * instance "sse2,ssse3", or "none" to only use the portable kernels.
+ */
+
+#ifndef _UPIPE_UCPU_H_
+/** @hidden */
+#define _UPIPE_UCPU_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+
+#include <stdint.h>
+
+/** @This defines the CPU features used by the kernels. */
+enum ucpu_flag {
+    /** x86 SSE2 */
+    UCPU_SSE2 = 0x1,
+    /** x86 SSSE3 */
+    UCPU_SSSE3 = 0x2,
+    /** x86 carry-less multiplication */
+    UCPU_PCLMUL = 0x4,
+    /** x86 AVX */
+    UCPU_AVX = 0x8,
+    /** x86 AVX2 */
+    UCPU_AVX2 = 0x10,
+    /** x86 AVX-512 (F and BW) */
+    UCPU_AVX512 = 0x20,
+    /** ARM Advanced SIMD */
+    UCPU_NEON = 0x40,
+    /** AES instructions (x86 AES-NI, ARMv8 cryptographic extension) */
+    UCPU_AES = 0x80,
+};
+
+/** @This describes an implementation of a kernel. */
+struct ucpu_impl {
+    /** name of the implementation (instruction set) */
+    const char *name;
+    /** CPU flags required by the implementation */
+    uint32_t flags;
+    /** implementation, to be cast to the type of the kernel */
+    void (*func)(void);
+};
+
+/** @This declares an implementation named after the suffix of a function.
+ *
+ * @param func function name without suffix
+ * @param suffix suffix of the function, and name of the implementation
+ * @param flags CPU flags required by the implementation
+ */
+#define UCPU_IMPL(func, suffix, flags)                                      \
+    { #suffix, flags, (void (*)(void))func##_##suffix }
+
+/** @This describes a kernel and its implementations. */
+struct ucpu_kernel {
+    /** name of the kernel */
+    const char *name;
+    /** implementations, best first, the last one requiring no flag */
+    const struct ucpu_impl *impls;
+    /** number of implementations */
+    unsigned nb_impls;
+
+    /** @internal selected implementation */
+    const struct ucpu_impl *selected;
+    /** @internal true if the kernel is in the list of selected kernels */
+    int registered;
+    /** @internal next kernel in the list of selected kernels */
+    struct ucpu_kernel *next;
+};
+
+/** @This statically initializes a kernel.
+ *
+ * @param name name of the kernel
+ * @param impls array of implementations
+ */
+#define UCPU_KERNEL_INIT(name, impls)                                       \
+    { name, impls, UBASE_ARRAY_SIZE(impls), NULL, 0, NULL }
+
+/** @This returns the CPU flags that kernels may use, which are the flags
+ * supported by the CPU restricted by UPIPE_CPU_FLAGS and @ref ucpu_set_mask.
+ *
+ * @return CPU flags
+ */
+uint32_t ucpu_get_flags(void);
+
+/** @This restricts the CPU flags that kernels may use, and resets the
+ * selected implementations. This is meant for tests and should be called
+ * before any kernel is in use.
+ *
+ * @param mask CPU flags to allow
+ */
+void ucpu_set_mask(uint32_t mask);
+
+/** @This returns the best implementation of a kernel for the given flags,
+ * without selecting it.
+ *
+ * @param kernel description of the kernel
+ * @param flags CPU flags
+ * @return implementation
+ */
+const struct ucpu_impl *ucpu_kernel_find(const struct ucpu_kernel *kernel,
+                                         uint32_t flags);
+
+/** @internal @This selects the implementation of a kernel for the running
+ * CPU, and adds the kernel to the list of selected kernels.
+ *
+ * @param kernel description of the kernel
+ * @return selected implementation
+ */
+const struct ucpu_impl *ucpu_kernel_select(struct ucpu_kernel *kernel);
+
+/** @This returns the implementation of a kernel for the running CPU.
+ *
+ * @param kernel description of the kernel
+ * @return selected implementation
+ */
+static inline const struct ucpu_impl *
+    ucpu_kernel_impl(struct ucpu_kernel *kernel)
+{
+    const struct ucpu_impl *impl =
+        __atomic_load_n(&kernel->selected, __ATOMIC_ACQUIRE);
+    if (likely(impl != NULL))
+        return impl;
+    return ucpu_kernel_select(kernel);
+}
+
+/** @This returns the function implementing a kernel for the running CPU.
+ *
+ * @param kernel description of the kernel
+ * @param type function pointer type of the kernel
+ * @return pointer to the function
+ */
+#define UCPU_KERNEL_FUNC(kernel, type)                                      \
+    ((type)ucpu_kernel_impl(kernel)->func)
+
+/** @This iterates over the kernels selected so far in the process.
+ *
+ * @param kernel previous kernel, or NULL to get the first one
+ * @return next kernel, or NULL at the end of the list
+ */
+struct ucpu_kernel *ucpu_kernel_iterate(struct ucpu_kernel *kernel);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -36,6 +36,7 @@ extern "C" {
 
 #include "upipe/ubase.h"
 #include "upipe/urefcount.h"
+#include "upipe/ualloc_stats.h"
 
 #include <stdio.h>
 #include <stdint.h>
@@ -199,6 +200,8 @@ struct udict {
 enum udict_mgr_command {
     /** release all buffers kept in pools (void) */
     UDICT_MGR_VACUUM,
+    /** returns the allocation statistics (struct ualloc_stats *) */
+    UDICT_MGR_GET_STATS,
 
     /** non-standard manager commands implemented by a module type can start
      * from there (first arg = signature) */
@@ -1020,6 +1023,19 @@ static inline int udict_mgr_vacuum(struct udict_mgr *mgr)
     return udict_mgr_control(mgr, UDICT_MGR_VACUUM);
 }
 
+/** @This returns the allocation statistics of a udict manager. The numbers
+ * are a snapshot and may change at any time.
+ *
+ * @param mgr pointer to udict manager
+ * @param stats filled in with the allocation statistics
+ * @return an error code
+ */
+static inline int udict_mgr_get_stats(struct udict_mgr *mgr,
+                                      struct ualloc_stats *stats)
+{
+    return udict_mgr_control(mgr, UDICT_MGR_GET_STATS, stats);
+}
+
 #ifdef __cplusplus
 }
 #endif
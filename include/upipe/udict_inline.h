@@ -39,8 +39,37 @@ extern "C" {
 
 #include "upipe/udict.h"
 
+/** @This is a simple signature to make sure the udict_mgr_control internal
+ * API is used properly. */
+#define UDICT_INLINE_SIGNATURE UBASE_FOURCC('i','n','l','n')
+
 struct umem_mgr;
 
+/** @This extends udict_mgr_command with specific commands for inline
+ * manager. */
+enum udict_inline_mgr_command {
+    UDICT_INLINE_MGR_SENTINEL = UDICT_MGR_CONTROL_LOCAL,
+
+    /** sets the number of attributes above which an index is built
+     * (unsigned int) */
+    UDICT_INLINE_MGR_SET_INDEX_THRESHOLD
+};
+
+/** @This sets the number of attributes above which a hash index of the
+ * attributes is built for a udict. It only applies to udicts allocated
+ * afterwards.
+ *
+ * @param mgr pointer to udict manager
+ * @param threshold number of attributes, or 0 to disable the index
+ * @return an error code
+ */
+static inline int udict_inline_mgr_set_index_threshold(struct udict_mgr *mgr,
+                                                       unsigned int threshold)
+{
+    return udict_mgr_control(mgr, UDICT_INLINE_MGR_SET_INDEX_THRESHOLD,
+                             UDICT_INLINE_SIGNATURE, threshold);
+}
+
 /** @This allocates a new instance of the inline udict manager.
  *
  * @param udict_pool_depth maximum number of udict structures in the pool
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe global registry of interned attribute keys
+ * Attribute names are interned once into a process-wide registry, which
+ * gives each of them a compact integer ID and a precomputed hash. The
+ * interned name is a canonical pointer which may be used in place of the
+ * original name in all udict calls, and allows udict managers to compare
+ * integers instead of strings on the hot path.
+ */
+
+#ifndef _UPIPE_UDICT_KEY_H_
+/** @hidden */
+#define _UPIPE_UDICT_KEY_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+
+#include <stdint.h>
+
+/** @This is the maximum number of interned keys. */
+#define UDICT_KEY_MAX 4096
+
+/** @This describes an interned attribute key. */
+struct udict_key {
+    /** precomputed hash of the name (see @ref udict_key_hash) */
+    uint32_t hash;
+    /** compact ID of the key, starting from 1 */
+    uint16_t id;
+    /** canonical name of the key */
+    char name[];
+};
+
+/** @This computes the hash of an attribute name (FNV-1a).
+ *
+ * @param name name of the attribute
+ * @return hash of the name
+ */
+static inline uint32_t udict_key_hash(const char *name)
+{
+    uint32_t hash = UINT32_C(2166136261);
+    while (*name)
+        hash = (hash ^ (uint8_t)*name++) * UINT32_C(16777619);
+    return hash;
+}
+
+/** @This interns an attribute name. This function is thread-safe. Interning
+ * the same name twice returns the same pointer.
+ *
+ * @param name name of the attribute
+ * @return canonical name of the attribute, or name itself if the registry
+ * is full
+ */
+const char *udict_key_intern(const char *name);
+
+/** @This returns the interned key of a canonical name.
+ *
+ * @param name canonical name, as returned by @ref udict_key_intern, or any
+ * other string
+ * @return pointer to the interned key, or NULL if name is not a canonical
+ * name
+ */
+const struct udict_key *udict_key_get(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
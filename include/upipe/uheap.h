@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe implementation of binary min-heaps of structures
+ * (NOT thread-safe)
+ *
+ * Elements embed a struct uheap_node and are ordered by its key. The heap
+ * only stores pointers to the nodes, so that an element may be moved when
+ * its key changes, in O(log n).
+ */
+
+#ifndef _UPIPE_UHEAP_H_
+/** @hidden */
+#define _UPIPE_UHEAP_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+
+/** index of a node which is not in a heap */
+#define UHEAP_NONE UINT_MAX
+/** initial number of allocated slots */
+#define UHEAP_INITIAL_SIZE 16
+
+/** @This is the structure to embed in elements of a heap. */
+struct uheap_node {
+    /** key of the element, the lowest key being on top */
+    uint64_t key;
+    /** index of the node in the heap, or UHEAP_NONE */
+    unsigned int index;
+};
+
+/** @This is the implementation of a heap. */
+struct uheap {
+    /** array of nodes */
+    struct uheap_node **nodes;
+    /** number of nodes in the heap */
+    unsigned int size;
+    /** number of allocated slots */
+    unsigned int allocated;
+};
+
+/** @This initializes a heap.
+ *
+ * @param uheap pointer to a uheap structure
+ */
+static inline void uheap_init(struct uheap *uheap)
+{
+    uheap->nodes = NULL;
+    uheap->size = uheap->allocated = 0;
+}
+
+/** @This cleans up a heap. The nodes are not released.
+ *
+ * @param uheap pointer to a uheap structure
+ */
+static inline void uheap_clean(struct uheap *uheap)
+{
+    for (unsigned int i = 0; i < uheap->size; i++)
+        uheap->nodes[i]->index = UHEAP_NONE;
+    free(uheap->nodes);
+    uheap_init(uheap);
+}
+
+/** @This initializes a node.
+ *
+ * @param node pointer to a uheap_node structure
+ */
+static inline void uheap_node_init(struct uheap_node *node)
+{
+    node->key = UINT64_MAX;
+    node->index = UHEAP_NONE;
+}
+
+/** @This checks if a node is in a heap.
+ *
+ * @param node pointer to a uheap_node structure
+ * @return true if the node is in a heap
+ */
+static inline bool uheap_node_is_in(const struct uheap_node *node)
+{
+    return node->index != UHEAP_NONE;
+}
+
+/** @This returns the number of nodes in a heap.
+ *
+ * @param uheap pointer to a uheap structure
+ * @return number of nodes
+ */
+static inline unsigned int uheap_size(const struct uheap *uheap)
+{
+    return uheap->size;
+}
+
+/** @This returns the node with the lowest key, without removing it.
+ *
+ * @param uheap pointer to a uheap structure
+ * @return pointer to the node, or NULL if the heap is empty
+ */
+static inline struct uheap_node *uheap_peek(const struct uheap *uheap)
+{
+    return uheap->size ? uheap->nodes[0] : NULL;
+}
+
+/** @internal @This stores a node at a given index.
+ *
+ * @param uheap pointer to a uheap structure
+ * @param node pointer to the node
+ * @param index index in the heap
+ */
+static inline void uheap_place(struct uheap *uheap, struct uheap_node *node,
+                               unsigned int index)
+{
+    uheap->nodes[index] = node;
+    node->index = index;
+}
+
+/** @internal @This moves a node towards the top of the heap.
+ *
+ * @param uheap pointer to a uheap structure
+ * @param node pointer to the node
+ */
+static inline void uheap_sift_up(struct uheap *uheap, struct uheap_node *node)
+{
+    unsigned int index = node->index;
+    while (index) {
+        unsigned int parent = (index - 1) / 2;
+        if (uheap->nodes[parent]->key <= node->key)
+            break;
+        uheap_place(uheap, uheap->nodes[parent], index);
+        index = parent;
+    }
+    uheap_place(uheap, node, index);
+}
+
+/** @internal @This moves a node towards the bottom of the heap.
+ *
+ * @param uheap pointer to a uheap structure
+ * @param node pointer to the node
+ */
+static inline void uheap_sift_down(struct uheap *uheap,
+                                   struct uheap_node *node)
+{
+    unsigned int index = node->index;
+    for ( ; ; ) {
+        unsigned int child = 2 * index + 1;
+        if (child >= uheap->size)
+            break;
+        if (child + 1 < uheap->size &&
+            uheap->nodes[child + 1]->key < uheap->nodes[child]->key)
+            child++;
+        if (node->key <= uheap->nodes[child]->key)
+            break;
+        uheap_place(uheap, uheap->nodes[child], index);
+        index = child;
+    }
+    uheap_place(uheap, node, index);
+}
+
+/** @This inserts a node in a heap, or moves it if it is already in the
+ * heap, according to its new key.
+ *
+ * @param uheap pointer to a uheap structure
+ * @param node pointer to the node
+ * @param key new key of the node
+ * @return false in case of allocation failure
+ */
+static inline bool uheap_update(struct uheap *uheap, struct uheap_node *node,
+                                uint64_t key)
+{
+    if (!uheap_node_is_in(node)) {
+        if (unlikely(uheap->size == uheap->allocated)) {
+            unsigned int allocated = uheap->allocated ?
+                                     uheap->allocated * 2 : UHEAP_INITIAL_SIZE;
+            struct uheap_node **nodes =
+                realloc(uheap->nodes, allocated * sizeof(*nodes));
+            if (unlikely(nodes == NULL))
+                return false;
+            uheap->nodes = nodes;
+            uheap->allocated = allocated;
+        }
+        node->key = key;
+        uheap_place(uheap, node, uheap->size++);
+        uheap_sift_up(uheap, node);
+        return true;
+    }
+
+    uint64_t old_key = node->key;
+    node->key = key;
+    if (key < old_key)
+        uheap_sift_up(uheap, node);
+    else if (key > old_key)
+        uheap_sift_down(uheap, node);
+    return true;
+}
+
+/** @This removes a node from a heap. It does nothing if the node is not in
+ * the heap.
+ *
+ * @param uheap pointer to a uheap structure
+ * @param node pointer to the node
+ */
+static inline void uheap_delete(struct uheap *uheap, struct uheap_node *node)
+{
+    if (!uheap_node_is_in(node))
+        return;
+
+    unsigned int index = node->index;
+    node->index = UHEAP_NONE;
+    struct uheap_node *last = uheap->nodes[--uheap->size];
+    if (last == node)
+        return;
+
+    uheap_place(uheap, last, index);
+    if (last->key < node->key)
+        uheap_sift_up(uheap, last);
+    else
+        uheap_sift_down(uheap, last);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -36,9 +36,12 @@ extern "C" {
 
 #include "upipe/ubase.h"
 #include "upipe/urefcount.h"
+#include "upipe/ualloc_stats.h"
+#include "upipe/usdt.h"
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
 #include <assert.h>
 
 /** @hidden */
@@ -80,6 +83,16 @@ static inline size_t umem_size(struct umem *umem)
     return umem->size;
 }
 
+/** @This defines standard commands which umem managers may implement. */
+enum umem_mgr_command {
+    /** returns the allocation statistics (struct ualloc_stats *) */
+    UMEM_MGR_GET_STATS,
+
+    /** non-standard manager commands implemented by a module type can start
+     * from there (first arg = signature) */
+    UMEM_MGR_CONTROL_LOCAL = 0x8000
+};
+
 /** @This defines a memory allocator management structure.
  */
 struct umem_mgr {
@@ -95,6 +108,9 @@ struct umem_mgr {
 
     /** function to release all buffers kept in pools */
     void (*umem_mgr_vacuum)(struct umem_mgr *);
+    /** control function for standard or local manager commands - all
+     * parameters belong to the caller */
+    int (*umem_mgr_control)(struct umem_mgr *, int, va_list);
 };
 
 /** @This allocates a new umem buffer space.
@@ -109,7 +125,10 @@ static inline bool umem_alloc(struct umem_mgr *mgr, struct umem *umem,
                               size_t size)
 {
     assert(umem != NULL);
-    return mgr->umem_alloc(mgr, umem, size);
+    if (unlikely(!mgr->umem_alloc(mgr, umem, size)))
+        return false;
+    UPIPE_USDT(umem_alloc, umem->buffer, size);
+    return true;
 }
 
 /** @This resizes a umem.
@@ -136,6 +155,7 @@ static inline bool umem_realloc(struct umem *umem, size_t new_size)
 static inline void umem_free(struct umem *umem)
 {
     assert(umem != NULL);
+    UPIPE_USDT(umem_free, umem->buffer, umem->size);
     umem->mgr->umem_free(umem);
 }
 
@@ -151,6 +171,55 @@ static inline void umem_mgr_vacuum(struct umem_mgr *mgr)
         mgr->umem_mgr_vacuum(mgr);
 }
 
+/** @internal @This sends a control command to the umem manager. Note that
+ * all arguments are owned by the caller.
+ *
+ * @param mgr pointer to umem manager
+ * @param command control command to send
+ * @param args optional read or write parameters
+ * @return an error code
+ */
+static inline int umem_mgr_control_va(struct umem_mgr *mgr,
+                                      int command, va_list args)
+{
+    assert(mgr != NULL);
+    if (mgr->umem_mgr_control == NULL)
+        return UBASE_ERR_UNHANDLED;
+
+    return mgr->umem_mgr_control(mgr, command, args);
+}
+
+/** @internal @This sends a control command to the umem manager. Note that
+ * all arguments are owned by the caller.
+ *
+ * @param mgr pointer to umem manager
+ * @param command control command to send, followed by optional read or write
+ * parameters
+ * @return an error code
+ */
+static inline int umem_mgr_control(struct umem_mgr *mgr, int command, ...)
+{
+    int err;
+    va_list args;
+    va_start(args, command);
+    err = umem_mgr_control_va(mgr, command, args);
+    va_end(args);
+    return err;
+}
+
+/** @This returns the allocation statistics of a umem manager. The numbers
+ * are a snapshot and may change at any time.
+ *
+ * @param mgr pointer to umem manager
+ * @param stats filled in with the allocation statistics
+ * @return an error code
+ */
+static inline int umem_mgr_get_stats(struct umem_mgr *mgr,
+                                     struct ualloc_stats *stats)
+{
+    return umem_mgr_control(mgr, UMEM_MGR_GET_STATS, stats);
+}
+
 /** @This increments the reference count of a umem manager.
  *
  * @param mgr pointer to umem manager
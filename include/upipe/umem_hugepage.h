@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe hugepage- and NUMA-aware memory allocator
+ * This memory allocator carves buffers organized by power of 2's sizes out
+ * of a single arena allocated at init time, backed by 2 MB or 1 GB
+ * hugepages where available, optionally bound to a NUMA node, and
+ * pre-faulted so that no page fault occurs in the data path. It reverts to
+ * malloc() and free() if a pool underflows or if the requested size is too
+ * large.
+ */
+
+#ifndef _UPIPE_UMEM_HUGEPAGE_H_
+/** @hidden */
+#define _UPIPE_UMEM_HUGEPAGE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/umem.h"
+
+/** @This is the size of a 2 MB hugepage. */
+#define UMEM_HUGEPAGE_2M (UINT64_C(2) * 1024 * 1024)
+/** @This is the size of a 1 GB hugepage. */
+#define UMEM_HUGEPAGE_1G (UINT64_C(1024) * 1024 * 1024)
+
+/** @This allocates a new instance of the umem hugepage manager, carving
+ * buffers out of a pre-faulted arena.
+ *
+ * @param page_size size of the hugepages backing the arena
+ * (@ref UMEM_HUGEPAGE_2M or @ref UMEM_HUGEPAGE_1G), or 0 to use normal pages;
+ * if hugepages cannot be reserved, the arena falls back to normal pages
+ * with transparent hugepages advised
+ * @param numa_node NUMA node to bind the arena to, or -1 for the default
+ * memory policy
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the number of buffers to
+ * carve in the arena for the pool (unsigned int); larger buffers will be
+ * directly managed with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc(size_t page_size, int numa_node,
+                                         size_t pool0_size,
+                                         size_t nb_pools, ...);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -27,7 +27,13 @@
  * @short Upipe pool-based memory allocator
  * This memory allocator keeps released memory blocks in pools organized by
  * power of 2's sizes, and reverts to malloc() and free() if the pool
- * underflows or overflows.
+ * underflows or overflows. Optionally, each thread may keep a small magazine
+ * of buffers in front of the shared pools, so that buffers allocated and
+ * released by the same thread do not touch the shared cache lines, and
+ * transfers between threads are done in batches.
+ *
+ * Please note that a manager with per-thread caches must be released after
+ * all threads using it have stopped doing so.
  */
 
 #ifndef _UPIPE_UMEM_POOL_H_
@@ -52,6 +58,23 @@ extern "C" {
  */
 struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...);
 
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using pools in power of 2's, and keeping a small
+ * magazine of buffers per thread and per pool in front of the shared pools.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param cache_depth number of buffers moved at once between a per-thread
+ * magazine and the shared pool (a magazine holds up to twice this number)
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to keep in the pool (unsigned int); larger buffers will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_cached(size_t pool0_size,
+                                            unsigned int cache_depth,
+                                            size_t nb_pools, ...);
 
 /** @This allocates a new instance of the umem pool manager allocating buffers
  * from application memory, using pools in power of 2's, with a simpler API.
@@ -62,6 +85,19 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...);
  */
 struct umem_mgr *umem_pool_mgr_alloc_simple(uint16_t base_pools_depth);
 
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using pools in power of 2's, with a simpler API,
+ * and keeping a small magazine of buffers per thread and per pool.
+ *
+ * @param base_pools_depth number of buffers to keep in the pool for the smaller
+ * buffers; for larger buffers the same number is used, divided by 2, 4, or 8
+ * @param cache_depth number of buffers moved at once between a per-thread
+ * magazine and the shared pool, or 0 to disable per-thread caches
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_simple_cached(uint16_t base_pools_depth,
+                                                   unsigned int cache_depth);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe global registry of shared managers
+ * Managers are registered under a name and allocated on first use. Later
+ * requests for the same name, from any thread, return the same manager, so
+ * that pipelines share their managers and pools instead of allocating them
+ * again. The registry holds a reference on each manager until
+ * @ref umgr_registry_clean is called.
+ *
+ * Only managers which may be used from several threads at once should be
+ * registered, such as the upipe managers without state and the managers
+ * based on @ref upool.
+ */
+
+#ifndef _UPIPE_UMGR_REGISTRY_H_
+/** @hidden */
+#define _UPIPE_UMGR_REGISTRY_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+
+/** @This is the depth of the pool of the shared udict manager. */
+#define UMGR_REGISTRY_UDICT_POOL_DEPTH 1024
+/** @This is the depth of the pool of the shared uref manager. */
+#define UMGR_REGISTRY_UREF_POOL_DEPTH 1024
+
+struct umem_mgr;
+struct udict_mgr;
+struct uref_mgr;
+struct upipe_mgr;
+
+/** @This is the type of the functions allocating a registered manager.
+ *
+ * @param opaque opaque given to @ref umgr_registry_get
+ * @param refcount_p filled in with the refcount management structure of the
+ * manager (may be NULL for static managers)
+ * @return pointer to the manager, or NULL in case of error
+ */
+typedef void *(*umgr_registry_alloc)(void *opaque,
+                                     struct urefcount **refcount_p);
+
+/** @This returns the manager registered under a name, allocating it on first
+ * use. This function is thread-safe.
+ *
+ * @param name name of the manager
+ * @param alloc function allocating the manager
+ * @param opaque opaque passed to alloc
+ * @return pointer to the manager, with a new reference for the caller, or
+ * NULL in case of error
+ */
+void *umgr_registry_get(const char *name, umgr_registry_alloc alloc,
+                        void *opaque);
+
+/** @This returns the upipe manager registered under a name, allocating it
+ * on first use. This function is thread-safe.
+ *
+ * @param name name of the manager
+ * @param alloc function allocating the manager, for instance
+ * upipe_ts_demux_mgr_alloc
+ * @return pointer to the manager, to release with upipe_mgr_release, or NULL
+ * in case of error
+ */
+struct upipe_mgr *umgr_registry_upipe_mgr(const char *name,
+                                          struct upipe_mgr *(*alloc)(void));
+
+/** @This returns the shared umem manager (using malloc()).
+ *
+ * @return pointer to the manager, to release with umem_mgr_release, or NULL
+ * in case of error
+ */
+struct umem_mgr *umgr_registry_umem_mgr(void);
+
+/** @This returns the shared inline udict manager.
+ *
+ * @return pointer to the manager, to release with udict_mgr_release, or NULL
+ * in case of error
+ */
+struct udict_mgr *umgr_registry_udict_mgr(void);
+
+/** @This returns the shared standard uref manager.
+ *
+ * @return pointer to the manager, to release with uref_mgr_release, or NULL
+ * in case of error
+ */
+struct uref_mgr *umgr_registry_uref_mgr(void);
+
+/** @This releases the references held by the registry. Managers still used
+ * by pipelines are only freed when they are released. Later calls allocate
+ * new managers.
+ */
+void umgr_registry_clean(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
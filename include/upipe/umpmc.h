@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe thread-safe bounded multi-producer multi-consumer ring
+ *
+ * Each cell of the ring carries a sequence number telling whether it is
+ * ready to be written (for a given position of the producers) or to be read
+ * (for a given position of the consumers), so that producers and consumers
+ * only contend on their own counter. The capacity of the ring is rounded up
+ * to a power of two.
+ */
+
+#ifndef _UPIPE_UMPMC_H_
+/** @hidden */
+#define _UPIPE_UMPMC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+#include "upipe/uatomic.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/** @This is the maximum number of elements in a ring. */
+#define UMPMC_MAX_LENGTH 65536
+/** @This is the assumed size of a cache line. */
+#define UMPMC_CACHE_LINE 64
+
+/** @internal @This is a cell of the ring. */
+struct umpmc_cell {
+    /** sequence number of the cell */
+    uatomic_uint32_t sequence;
+    /** opaque carried by the cell */
+    void *opaque;
+};
+
+/** @internal @This is a counter padded to a cache line. */
+union umpmc_counter {
+    /** position */
+    uatomic_uint32_t pos;
+    /** padding */
+    uint8_t padding[UMPMC_CACHE_LINE];
+};
+
+/** @This is the implementation of a bounded multi-producer multi-consumer
+ * ring. */
+struct umpmc {
+    /** position of the producers */
+    union umpmc_counter head;
+    /** position of the consumers */
+    union umpmc_counter tail;
+    /** capacity of the ring minus one */
+    uint32_t mask;
+    /** cells */
+    struct umpmc_cell *cells;
+};
+
+/** @This returns the capacity of a ring for a given maximum length.
+ *
+ * @param length maximum number of elements in the ring
+ * @return capacity of the ring (power of two)
+ */
+static inline uint32_t umpmc_capacity(uint32_t length)
+{
+    uint32_t capacity = 1;
+    while (capacity < length)
+        capacity <<= 1;
+    return capacity;
+}
+
+/** @This returns the required size of extra data space for umpmc.
+ *
+ * @param length maximum number of elements in the ring
+ * @return size in octets to allocate
+ */
+static inline size_t umpmc_sizeof(uint32_t length)
+{
+    return umpmc_capacity(length) * sizeof(struct umpmc_cell);
+}
+
+/** @This initializes a umpmc.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param length maximum number of elements in the ring (max
+ * @ref #UMPMC_MAX_LENGTH), rounded up to a power of two
+ * @param extra mandatory extra space allocated by the caller, with the size
+ * returned by @ref #umpmc_sizeof
+ */
+static inline void umpmc_init(struct umpmc *umpmc, uint32_t length,
+                              void *extra)
+{
+    assert(length && length <= UMPMC_MAX_LENGTH);
+    uint32_t capacity = umpmc_capacity(length);
+    umpmc->mask = capacity - 1;
+    umpmc->cells = (struct umpmc_cell *)extra;
+    for (uint32_t i = 0; i < capacity; i++) {
+        uatomic_init(&umpmc->cells[i].sequence, i);
+        umpmc->cells[i].opaque = NULL;
+    }
+    uatomic_init(&umpmc->head.pos, 0);
+    uatomic_init(&umpmc->tail.pos, 0);
+}
+
+/** @This returns the capacity of the ring.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @return maximum number of elements in the ring
+ */
+static inline uint32_t umpmc_length(struct umpmc *umpmc)
+{
+    return umpmc->mask + 1;
+}
+
+/** @This pushes several elements. Elements are pushed in order, and either
+ * all or a prefix of them are queued.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param opaques array of opaques to push (not NULL)
+ * @param nb number of opaques in the array
+ * @return number of elements queued, which is lower than nb if the ring is
+ * full
+ */
+static inline unsigned int umpmc_push_batch(struct umpmc *umpmc,
+                                            void *const *opaques,
+                                            unsigned int nb)
+{
+    uint32_t pos = uatomic_load(&umpmc->head.pos);
+    for ( ; ; ) {
+        unsigned int count = 0;
+        int32_t diff = 0;
+        while (count < nb && count <= umpmc->mask) {
+            struct umpmc_cell *cell = &umpmc->cells[(pos + count) &
+                                                    umpmc->mask];
+            diff = (int32_t)(uatomic_load(&cell->sequence) - (pos + count));
+            if (diff)
+                break;
+            count++;
+        }
+
+        if (unlikely(!count)) {
+            if (diff < 0 || !nb)
+                /* full */
+                return 0;
+            /* another producer went past us */
+            pos = uatomic_load(&umpmc->head.pos);
+            continue;
+        }
+
+        /* the cells seen ready stay ready as long as head is unchanged */
+        if (likely(uatomic_compare_exchange(&umpmc->head.pos, &pos,
+                                            pos + count))) {
+            for (unsigned int i = 0; i < count; i++) {
+                struct umpmc_cell *cell = &umpmc->cells[(pos + i) &
+                                                        umpmc->mask];
+                assert(opaques[i] != NULL);
+                cell->opaque = opaques[i];
+                uatomic_store(&cell->sequence, pos + i + 1);
+            }
+            return count;
+        }
+    }
+}
+
+/** @This pushes a new element.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param opaque opaque to associate with element (not NULL)
+ * @return false if the ring is full and the element couldn't be queued
+ */
+static inline bool umpmc_push(struct umpmc *umpmc, void *opaque)
+{
+    return umpmc_push_batch(umpmc, &opaque, 1) == 1;
+}
+
+/** @This pops several elements, in the order they were pushed.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param opaques array written with the popped opaques
+ * @param nb maximum number of opaques to pop
+ * @return number of popped elements, which is lower than nb if the ring is
+ * empty
+ */
+static inline unsigned int umpmc_pop_batch(struct umpmc *umpmc,
+                                           void **opaques, unsigned int nb)
+{
+    uint32_t pos = uatomic_load(&umpmc->tail.pos);
+    for ( ; ; ) {
+        unsigned int count = 0;
+        int32_t diff = 0;
+        while (count < nb && count <= umpmc->mask) {
+            struct umpmc_cell *cell = &umpmc->cells[(pos + count) &
+                                                    umpmc->mask];
+            diff = (int32_t)(uatomic_load(&cell->sequence) -
+                             (pos + count + 1));
+            if (diff)
+                break;
+            count++;
+        }
+
+        if (unlikely(!count)) {
+            if (diff < 0 || !nb)
+                /* empty */
+                return 0;
+            /* another consumer went past us */
+            pos = uatomic_load(&umpmc->tail.pos);
+            continue;
+        }
+
+        if (likely(uatomic_compare_exchange(&umpmc->tail.pos, &pos,
+                                            pos + count))) {
+            for (unsigned int i = 0; i < count; i++) {
+                struct umpmc_cell *cell = &umpmc->cells[(pos + i) &
+                                                        umpmc->mask];
+                opaques[i] = cell->opaque;
+                cell->opaque = NULL;
+                uatomic_store(&cell->sequence, pos + i + umpmc->mask + 1);
+            }
+            return count;
+        }
+    }
+}
+
+/** @internal @This pops an element.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @return pointer to opaque, or NULL if the ring is empty
+ */
+static inline void *umpmc_pop_internal(struct umpmc *umpmc)
+{
+    void *opaque;
+    if (umpmc_pop_batch(umpmc, &opaque, 1) != 1)
+        return NULL;
+    return opaque;
+}
+
+/** @This pops an element with type checking.
+ *
+ * @param umpmc pointer to a umpmc structure
+ * @param type type of the opaque pointer
+ * @return pointer to opaque, or NULL if the ring is empty
+ */
+#define umpmc_pop(umpmc, type) (type)umpmc_pop_internal(umpmc)
+
+/** @This cleans up the umpmc data structure. Please note that it is the
+ * caller's responsibility to empty the ring first.
+ *
+ * @param umpmc pointer to a umpmc structure
+ */
+static inline void umpmc_clean(struct umpmc *umpmc)
+{
+    for (uint32_t i = 0; i <= umpmc->mask; i++)
+        uatomic_clean(&umpmc->cells[i].sequence);
+    uatomic_clean(&umpmc->head.pos);
+    uatomic_clean(&umpmc->tail.pos);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -39,6 +39,7 @@ extern "C" {
 #include "upipe/uprobe.h"
 #include "upipe/urequest.h"
 #include "upipe/udict_dump.h"
+#include "upipe/usdt.h"
 
 #include <stdint.h>
 #include <stdarg.h>
@@ -61,6 +62,12 @@ struct ubuf_mgr;
 struct upipe_mgr;
 /** @hidden */
 struct upump;
+/** @hidden */
+struct ualloc_stats;
+/** @hidden */
+struct upipe_stats;
+/** @hidden */
+struct upipe_stats_state;
 
 /** @This defines standard commands which upipe modules may implement. */
 enum upipe_command {
@@ -161,6 +168,31 @@ enum upipe_command {
      * in octets (uint64_t *, uint64_t *) */
     UPIPE_SRC_GET_RANGE,
 
+    /*
+     * Encoder-related commands
+     */
+    /** sets the target octetrate and buffer size in octets, to be applied
+     * from the next random access point (uint64_t, uint64_t) */
+    UPIPE_ENC_SET_RATE,
+    /** applies a latency preset to the encoder parameters
+     * (enum upipe_enc_latency) */
+    UPIPE_ENC_SET_LATENCY,
+
+    /*
+     * Statistics commands
+     */
+    /** completes the input statistics with module-specific fields
+     * (struct upipe_stats *) */
+    UPIPE_GET_STATS,
+
+    /*
+     * Fusion commands
+     */
+    /** returns the function processing a uref in place, for pipes whose
+     * processing only depends on their configuration
+     * (upipe_process_func *) */
+    UPIPE_GET_PROCESS,
+
     /** non-standard commands implemented by a module type can start from
      * there (first arg = signature) */
     UPIPE_CONTROL_LOCAL = 0x8000
@@ -179,6 +211,8 @@ struct upipe {
     struct uprobe *uprobe;
     /** pointer to the manager for this pipe type */
     struct upipe_mgr *mgr;
+    /** input statistics, or NULL if they are disabled */
+    struct upipe_stats_state *stats;
 };
 
 UBASE_FROM_TO(upipe, uchain, uchain, uchain)
@@ -222,6 +256,11 @@ struct upipe_mgr {
     /** control function for standard or local manager commands - all parameters
      * belong to the caller */
     int (*upipe_mgr_control)(struct upipe_mgr *, int, va_list);
+
+    /** optional function to send a list of urefs to an input - the urefs
+     * then belong to the callee, which must empty the list */
+    void (*upipe_input_batch)(struct upipe *, struct uchain *,
+                              struct upump **);
 };
 
 /** @This initializes a upipe manager structure with default values.
@@ -240,6 +279,7 @@ static inline void upipe_mgr_init(struct upipe_mgr *mgr)
         mgr->upipe_input = NULL;
         mgr->upipe_control = NULL;
         mgr->upipe_mgr_control = NULL;
+        mgr->upipe_input_batch = NULL;
     }
 }
 
@@ -391,6 +431,10 @@ static inline const char *upipe_command_str(struct upipe *upipe, int cmd)
     UBASE_CASE_TO_STR(UPIPE_SRC_SET_POSITION);
     UBASE_CASE_TO_STR(UPIPE_SRC_GET_RANGE);
     UBASE_CASE_TO_STR(UPIPE_SRC_SET_RANGE);
+    UBASE_CASE_TO_STR(UPIPE_ENC_SET_RATE);
+    UBASE_CASE_TO_STR(UPIPE_ENC_SET_LATENCY);
+    UBASE_CASE_TO_STR(UPIPE_GET_STATS);
+    UBASE_CASE_TO_STR(UPIPE_GET_PROCESS);
     case UPIPE_CONTROL_LOCAL: break;
     }
     return NULL;
@@ -455,6 +499,23 @@ static inline struct upipe *upipe_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This calls the input function of a pipe, and accounts for the
+ * uref and the time spent in its input statistics.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure to send
+ * @param upump_p reference to the pump that generated the buffer
+ */
+void upipe_stats_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p);
+
+/** @This disables the input statistics of a pipe, see
+ * @ref upipe_stats_enable.
+ *
+ * @param upipe description structure of the pipe
+ */
+void upipe_stats_disable(struct upipe *upipe);
+
 /** @This initializes the public members of a pipe.
  *
  * Please note that this function does not _use() the probe, so if you want
@@ -473,6 +534,7 @@ static inline void upipe_init(struct upipe *upipe, struct upipe_mgr *mgr,
     upipe->uprobe = uprobe;
     upipe->refcount = NULL;
     upipe->mgr = mgr;
+    upipe->stats = NULL;
     upipe_mgr_use(mgr);
 }
 
@@ -579,6 +641,8 @@ static inline struct uprobe *upipe_pop_probe(struct upipe *upipe)
 static inline void upipe_clean(struct upipe *upipe)
 {
     assert(upipe != NULL);
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_disable(upipe);
     uprobe_release(upipe->uprobe);
     upipe_mgr_release(upipe->mgr);
 }
@@ -592,6 +656,7 @@ static inline void upipe_clean(struct upipe *upipe)
  */
 static inline int upipe_throw_va(struct upipe *upipe, int event, va_list args)
 {
+    UPIPE_USDT(throw, upipe, event);
     return uprobe_throw_va(upipe->uprobe, upipe, event, args);
 }
 
@@ -1025,6 +1090,76 @@ static inline int upipe_throw_preroll_end(struct upipe *upipe)
     return upipe_throw(upipe, UPROBE_PREROLL_END);
 }
 
+/** @This throws an event reporting the allocation statistics of a pool
+ * managed by the pipe, typically retrieved with @ref umem_mgr_get_stats or
+ * @ref udict_mgr_get_stats.
+ *
+ * @param upipe description structure of the pipe
+ * @param name name of the pool
+ * @param stats allocation statistics
+ * @return an error code
+ */
+static inline int upipe_throw_alloc_stats(struct upipe *upipe,
+                                          const char *name,
+                                          const struct ualloc_stats *stats)
+{
+    return upipe_throw(upipe, UPROBE_ALLOC_STATS, name, stats);
+}
+
+/** @This throws an event reporting the input statistics of the pipe over
+ * the last period, see @ref upipe_stats_enable.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats input statistics
+ * @return an error code
+ */
+static inline int upipe_throw_stats(struct upipe *upipe,
+                                    const struct upipe_stats *stats)
+{
+    return upipe_throw(upipe, UPROBE_STATS, stats);
+}
+
+/** @This throws an event reporting a uref carrying a latency trace, see
+ * @ref upipe_stats_trace.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref carrying a latency trace
+ * @return an error code
+ */
+static inline int upipe_throw_trace(struct upipe *upipe, struct uref *uref)
+{
+    return upipe_throw(upipe, UPROBE_TRACE, uref);
+}
+
+/** @This throws an event signalling a discontinuity in the input, such as
+ * a continuity counter error.
+ *
+ * @param upipe description structure of the pipe
+ * @param lost number of units (packets, frames...) presumed lost, or 0 if
+ * unknown
+ * @return an error code
+ */
+static inline int upipe_throw_discontinuity(struct upipe *upipe,
+                                            uint64_t lost)
+{
+    return upipe_throw(upipe, UPROBE_DISCONTINUITY, lost);
+}
+
+/** @This throws an event signalling that a pump callback of the pipe ran for
+ * too long, or that a timer of the pipe expired late.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration time spent in the callback, in 27 MHz units
+ * @param lag delay between the expected expiry of the timer and the
+ * callback, in 27 MHz units, or 0
+ * @return an error code
+ */
+static inline int upipe_throw_slow_upump(struct upipe *upipe,
+                                         uint64_t duration, uint64_t lag)
+{
+    return upipe_throw(upipe, UPROBE_SLOW_UPUMP, duration, lag);
+}
+
 /** @This catches an event coming from an inner pipe, and rethrows is as if
  * it were sent by the outermost pipe.
  *
@@ -1061,7 +1196,43 @@ static inline void upipe_input(struct upipe *upipe, struct uref *uref,
         return;
     }
     upipe_use(upipe);
-    upipe->mgr->upipe_input(upipe, uref, upump_p);
+    UPIPE_USDT(input, upipe, uref);
+    if (unlikely(upipe->stats != NULL))
+        upipe_stats_input(upipe, uref, upump_p);
+    else
+        upipe->mgr->upipe_input(upipe, uref, upump_p);
+    UPIPE_USDT(input_end, upipe);
+    upipe_release(upipe);
+}
+
+/** @This sends a list of urefs, chained by their uchain, into a pipe. The
+ * urefs then belong to the callee, and the list is empty on return.
+ *
+ * Pipes implementing upipe_input_batch receive the whole list at once,
+ * which amortizes the dispatch over a burst of packets. Otherwise, or if
+ * input statistics are enabled, the urefs are sent one by one with
+ * @ref upipe_input.
+ *
+ * @param upipe description structure of the pipe
+ * @param urefs list of urefs to send
+ * @param upump_p reference to the pump that generated the buffers
+ */
+static inline void upipe_input_batch(struct upipe *upipe, struct uchain *urefs,
+                                     struct upump **upump_p)
+{
+    assert(upipe != NULL);
+    if (upipe->mgr->upipe_input_batch == NULL ||
+        unlikely(upipe->stats != NULL)) {
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(urefs)) != NULL)
+            upipe_input(upipe, uref_from_uchain(uchain), upump_p);
+        return;
+    }
+    if (unlikely(ulist_empty(urefs)))
+        return;
+    upipe_use(upipe);
+    upipe->mgr->upipe_input_batch(upipe, urefs, upump_p);
+    assert(ulist_empty(urefs));
     upipe_release(upipe);
 }
 
@@ -1459,7 +1630,7 @@ static inline int upipe_src_get_size(struct upipe *upipe, uint64_t *size_p)
  * @return an error code
  */
 static inline int upipe_src_get_position(struct upipe *upipe,
-                                         uint64_t position_p)
+                                         uint64_t *position_p)
 {
     return upipe_control(upipe, UPIPE_SRC_GET_POSITION, position_p);
 }
@@ -1504,6 +1675,74 @@ static inline int upipe_src_set_range(struct upipe *upipe,
     return upipe_control(upipe, UPIPE_SRC_SET_RANGE, offset, length);
 }
 
+/** @This sets the target octetrate and buffer size of an encoder. The
+ * change is deferred to the next random access point, so that rate control
+ * is adjusted per GOP (typically in answer to the buffer and padding
+ * reports of a multiplexer, for statistical multiplexing).
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate target octetrate
+ * @param bs buffer size in octets, or 0 to keep the current one
+ * @return an error code
+ */
+static inline int upipe_enc_set_rate(struct upipe *upipe,
+                                     uint64_t octetrate, uint64_t bs)
+{
+    return upipe_control(upipe, UPIPE_ENC_SET_RATE, octetrate, bs);
+}
+
+/** @This defines the latency presets of encoders. */
+enum upipe_enc_latency {
+    /** no lookahead nor B-frames, and no frame-level parallelism, so that
+     * a picture leaves the encoder as soon as it is coded */
+    UPIPE_ENC_LATENCY_ZERO,
+    /** no B-frames and a short lookahead */
+    UPIPE_ENC_LATENCY_LOW,
+};
+
+/** @This applies a latency preset to the parameters of an encoder. The
+ * preset takes effect the next time the encoder is opened or reconfigured.
+ * The resulting latency is then reported in the output flow definition
+ * (see @ref uref_clock_get_latency), so that downstream buffers can be
+ * sized accordingly.
+ *
+ * @param upipe description structure of the pipe
+ * @param latency latency preset
+ * @return an error code
+ */
+static inline int upipe_enc_set_latency(struct upipe *upipe,
+                                        enum upipe_enc_latency latency)
+{
+    return upipe_control(upipe, UPIPE_ENC_SET_LATENCY, latency);
+}
+
+/** @This is the type of the functions processing a uref in place on behalf
+ * of a pipe, without outputting it.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure to process
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref was dropped (and freed)
+ */
+typedef bool (*upipe_process_func)(struct upipe *, struct uref *,
+                                   struct upump **);
+
+/** @This returns the function processing a uref in place on behalf of a
+ * pipe. It is only implemented by pipes which output each uref at most once,
+ * synchronously, and whose processing only depends on their configuration,
+ * so that a chain of such pipes may be run in a single call (see
+ * upipe_fused).
+ *
+ * @param upipe description structure of the pipe
+ * @param process_p filled in with the processing function
+ * @return an error code
+ */
+static inline int upipe_get_process(struct upipe *upipe,
+                                    upipe_process_func *process_p)
+{
+    return upipe_control(upipe, UPIPE_GET_PROCESS, process_p);
+}
+
 /** @This declares twelve functions to allocate pipes with a certain pipe
  * allocator.
  *
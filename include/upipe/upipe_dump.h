@@ -37,6 +37,11 @@ extern "C" {
 #include "upipe/ubase.h"
 #include "upipe/upipe.h"
 
+#include <stdio.h>
+
+/** @hidden */
+struct upump_mgr;
+
 /** @This represents a dumping function for pipe labels. */
 typedef char *(upipe_dump_pipe_label)(struct upipe *);
 
@@ -121,6 +126,90 @@ static inline int upipe_dump_open(upipe_dump_pipe_label pipe_label,
     return err;
 }
 
+/** @This dumps a pipeline in dot format, annotated with the statistics of
+ * the pipes (see @ref upipe_stats_enable): the labels of the pipes show
+ * their input rates, the share of a CPU they take themselves, the average
+ * and longest time per uref, the length of their queue and the thread they
+ * run on, and the pipes are colored from grey to red with their load. The
+ * edges show the input rates of their outputs.
+ *
+ * @param pipe_label function to print pipe labels
+ * @param flow_def_label function to print flow_def labels
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ */
+void upipe_dump_stats_va(upipe_dump_pipe_label pipe_label,
+                         upipe_dump_flow_def_label flow_def_label,
+                         FILE *file, struct uchain *ulist, va_list args);
+
+/** @This dumps a pipeline in dot format, annotated with the statistics of
+ * the pipes, with a variable list of arguments.
+ *
+ * @param pipe_label function to print pipe labels
+ * @param flow_def_label function to print flow_def labels
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format, followed by a list of
+ * source pipes terminated by NULL
+ */
+static inline void upipe_dump_stats(upipe_dump_pipe_label pipe_label,
+                                    upipe_dump_flow_def_label flow_def_label,
+                                    FILE *file, struct uchain *ulist, ...)
+{
+    va_list args;
+    va_start(args, ulist);
+    upipe_dump_stats_va(pipe_label, flow_def_label, file, ulist, args);
+    va_end(args);
+}
+
+/** @hidden */
+struct upipe_dump_watcher;
+
+/** @This allocates a watcher which dumps a pipeline in dot format, annotated
+ * with the statistics of the pipes, each time the process receives a signal.
+ * The pipes are walked from the thread of the event loop, so the pipes of
+ * other threads may be dumped while they run.
+ *
+ * @param upump_mgr event loop to watch the signal on
+ * @param signal signal to watch, for instance SIGUSR1
+ * @param path path of the file to write to
+ * @param ulist list of sources pipes in ulist format, which must outlive the
+ * watcher, or NULL
+ * @param args list of sources pipes terminated with NULL
+ * @return pointer to the watcher, or NULL in case of error
+ */
+struct upipe_dump_watcher *upipe_dump_watcher_alloc_va(
+        struct upump_mgr *upump_mgr, int signal, const char *path,
+        struct uchain *ulist, va_list args);
+
+/** @This allocates a watcher which dumps a pipeline with its statistics on
+ * a signal, with a variable list of arguments.
+ *
+ * @param upump_mgr event loop to watch the signal on
+ * @param signal signal to watch, for instance SIGUSR1
+ * @param path path of the file to write to
+ * @param ulist list of sources pipes in ulist format, or NULL, followed by
+ * a list of source pipes terminated by NULL
+ * @return pointer to the watcher, or NULL in case of error
+ */
+static inline struct upipe_dump_watcher *
+    upipe_dump_watcher_alloc(struct upump_mgr *upump_mgr, int signal,
+                             const char *path, struct uchain *ulist, ...)
+{
+    va_list args;
+    va_start(args, ulist);
+    struct upipe_dump_watcher *watcher =
+        upipe_dump_watcher_alloc_va(upump_mgr, signal, path, ulist, args);
+    va_end(args);
+    return watcher;
+}
+
+/** @This frees a watcher, and releases its source pipes.
+ *
+ * @param watcher pointer to the watcher
+ */
+void upipe_dump_watcher_free(struct upipe_dump_watcher *watcher);
+
 #ifdef __cplusplus
 }
 #endif
@@ -83,6 +83,13 @@ enum upipe_helper_output_state {
  * of sending the flow definition if necessary.
  *
  * @item @code
+ *  void upipe_foo_output_batch(struct upipe *upipe, struct uchain *urefs,
+ *                              struct upump **upump_p)
+ * @end code
+ * Called to send a list of packets to your output at once, see
+ * @ref upipe_input_batch. The list is empty on return.
+ *
+ * @item @code
  *  int upipe_foo_register_output_request(struct upipe *upipe,
  *                                        struct urequest *urequest)
  * @end code
@@ -259,6 +266,32 @@ static UBASE_UNUSED void STRUCTURE##_output(struct upipe *upipe,            \
         }                                                                   \
     }                                                                       \
 }                                                                           \
+/** @internal @This sends a list of urefs to the output, after sending the  \
+ * flow definition if necessary. The list is empty on return.               \
+ *                                                                          \
+ * @param upipe description structure of the pipe                           \
+ * @param urefs list of urefs to send                                       \
+ * @param upump_p reference to pump that generated the buffers              \
+ */                                                                         \
+static UBASE_UNUSED void STRUCTURE##_output_batch(struct upipe *upipe,      \
+                                                  struct uchain *urefs,     \
+                                                  struct upump **upump_p)   \
+{                                                                           \
+    struct STRUCTURE *s = STRUCTURE##_from_upipe(upipe);                    \
+    if (unlikely(ulist_empty(urefs)))                                       \
+        return;                                                             \
+    /* negotiates the flow definition without sending anything */           \
+    STRUCTURE##_output(upipe, NULL, upump_p);                               \
+    if (likely(s->OUTPUT != NULL &&                                         \
+               s->OUTPUT_STATE == UPIPE_HELPER_OUTPUT_VALID)) {             \
+        upipe_input_batch(s->OUTPUT, urefs, upump_p);                       \
+        return;                                                             \
+    }                                                                       \
+                                                                            \
+    struct uchain *uchain;                                                  \
+    while ((uchain = ulist_pop(urefs)) != NULL)                             \
+        uref_free(uref_from_uchain(uchain));                                \
+}                                                                           \
 /** @internal @This registers a request to be forwarded downstream. The     \
  * request will be replayed if the output changes. If there is no output,   \
  * the request will be sent via a probe.                                    \
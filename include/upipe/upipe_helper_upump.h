@@ -106,6 +106,8 @@ static void STRUCTURE##_set_##UPUMP(struct upipe *upipe,                    \
         upump_free(s->UPUMP);                                               \
     }                                                                       \
     s->UPUMP = upump;                                                       \
+    if (upump != NULL)                                                      \
+        upump->upipe = upipe;                                               \
 }                                                                           \
 /** @internal @This sets the upump to use.                                  \
  *                                                                          \
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe input statistics of pipes
+ *
+ * When enabled on a pipe, @ref upipe_input counts the urefs and octets the
+ * pipe receives, and measures the time spent in its input function. The
+ * time spent in the input functions of downstream pipes which also have
+ * statistics enabled is accounted separately, so that the time spent in the
+ * pipe itself is the difference. When disabled, the cost is a single test
+ * in @ref upipe_input.
+ *
+ * Pipes may also be declared as stages of a latency trace, see
+ * @ref upipe_stats_trace: a sample of the urefs then carries the dates at
+ * which they entered each stage.
+ */
+
+#ifndef _UPIPE_UPIPE_STATS_H_
+/** @hidden */
+#define _UPIPE_UPIPE_STATS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+#include "upipe/uclock.h"
+#include "upipe/upipe.h"
+#include "upipe/uref_attr.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** maximum size of a latency trace, in octets */
+#define UPIPE_STATS_TRACE_SIZE 1024
+
+UREF_ATTR_OPAQUE(stats, trace, "k.trace", latency trace)
+
+/** @This is a snapshot of the input statistics of a pipe. Durations are
+ * in 27 MHz units. */
+struct upipe_stats {
+    /** duration of the measurement */
+    uint64_t duration;
+    /** number of urefs received */
+    uint64_t urefs;
+    /** number of octets of block urefs received */
+    uint64_t octets;
+    /** time spent in the input function, including children */
+    uint64_t time;
+    /** part of the time spent in the input functions of downstream pipes
+     * having statistics enabled */
+    uint64_t children_time;
+    /** longest time spent in a single call to the input function */
+    uint64_t max_time;
+    /** number of urefs waiting in the queue of the pipe, or UINT64_MAX if
+     * the pipe has no queue */
+    uint64_t queue_length;
+    /** identifier of the thread of the last input (the kernel thread ID
+     * on Linux), or 0 */
+    uint64_t thread;
+    /** event loop of the pump which generated the last input, or NULL */
+    struct upump_mgr *upump_mgr;
+};
+
+/** @This enables the input statistics of a pipe, or resets them if they
+ * were already enabled. This must be called from the thread of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param period period of the @ref UPROBE_STATS events, in 27 MHz units,
+ * or 0 to disable the events
+ * @return an error code
+ */
+int upipe_stats_enable(struct upipe *upipe, uint64_t period);
+
+/** @This declares a pipe as a stage of latency traces. The pipe stamps the
+ * traced urefs it receives with the date they entered it, in the time base
+ * of @ref uclock_std without realtime flag. Input statistics are enabled on
+ * the pipe if they were not.
+ *
+ * If sample is not 0, the pipe also starts a trace on one in sample urefs
+ * which were not traced yet, with a first stamp named "cr_sys" set to the
+ * date of reception of the uref if it has one. If report is true, the pipe
+ * throws @ref UPROBE_TRACE on the traced urefs, see @ref uprobe_trace_alloc.
+ *
+ * @param upipe description structure of the pipe
+ * @param stage name of the stage, or NULL to stop stamping urefs
+ * @param sample sampling period of the traces started by the pipe, or 0
+ * @param report true to report the traced urefs
+ * @return an error code
+ */
+int upipe_stats_trace(struct upipe *upipe, const char *stage,
+                      unsigned int sample, bool report);
+
+/** @This iterates over the stamps of a latency trace. Each stamp is made of
+ * the date at which the uref entered a stage, in 27 MHz units and network
+ * byte order, followed by one octet of length and the name of the stage.
+ *
+ * @param trace latency trace
+ * @param size size of the latency trace
+ * @param offset_p offset of the next stamp, initialized to 0 by the caller
+ * @param stage_p filled in with the name of the stage (not terminated)
+ * @param stage_len_p filled in with the length of the name of the stage
+ * @param date_p filled in with the date
+ * @return false when there are no more stamps
+ */
+static inline bool upipe_stats_trace_iterate(const uint8_t *trace,
+                                             size_t size, size_t *offset_p,
+                                             const char **stage_p,
+                                             size_t *stage_len_p,
+                                             uint64_t *date_p)
+{
+    size_t offset = *offset_p;
+    if (offset + 9 > size || offset + 9 + trace[offset + 8] > size)
+        return false;
+
+    uint64_t date = 0;
+    for (int i = 0; i < 8; i++)
+        date = (date << 8) | trace[offset + i];
+    *date_p = date;
+    *stage_len_p = trace[offset + 8];
+    *stage_p = (const char *)trace + offset + 9;
+    *offset_p = offset + 9 + *stage_len_p;
+    return true;
+}
+
+/** @internal @This fills in the input statistics of a pipe since they were
+ * enabled, except the module-specific fields.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats filled in with the statistics
+ * @return an error code, UBASE_ERR_INVALID if statistics are disabled
+ */
+int upipe_stats_collect(struct upipe *upipe, struct upipe_stats *stats);
+
+/** @This returns the statistics of a pipe since they were enabled. Pipes
+ * with an internal queue report its length even if the input statistics
+ * are disabled.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats filled in with the statistics
+ * @return an error code
+ */
+static inline int upipe_get_stats(struct upipe *upipe,
+                                  struct upipe_stats *stats)
+{
+    int err = upipe_stats_collect(upipe, stats);
+    if (ubase_check(upipe_control_nodbg(upipe, UPIPE_GET_STATS, stats)))
+        return UBASE_ERR_NONE;
+    return err;
+}
+
+/** @This converts a counter of statistics to a rate per second.
+ *
+ * @param stats statistics
+ * @param counter counter, such as urefs or octets
+ * @return rate per second
+ */
+static inline uint64_t upipe_stats_rate(const struct upipe_stats *stats,
+                                        uint64_t counter)
+{
+    if (!stats->duration)
+        return 0;
+    return (uint64_t)((double)counter * UCLOCK_FREQ / stats->duration);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -37,6 +37,7 @@ extern "C" {
 #include "upipe/ubase.h"
 #include "upipe/urefcount.h"
 #include "upipe/ulifo.h"
+#include "upipe/ualloc_stats.h"
 
 /** @hidden */
 struct upool;
@@ -56,6 +57,11 @@ struct upool {
     upool_alloc_cb alloc_cb;
     /** call-back to release unused elements */
     upool_free_cb free_cb;
+    /** allocation counters */
+    struct ualloc_counters counters;
+    /** maximum number of elements retained, which may be lowered below the
+     * length of the lifo at run time */
+    uatomic_uint32_t limit;
 };
 
 /** @This returns the required size of extra data space for upool.
@@ -81,6 +87,8 @@ static inline void upool_init(struct upool *upool, struct urefcount *refcount,
     ulifo_init(&upool->lifo, length, extra);
     upool->alloc_cb = alloc_cb;
     upool->free_cb = free_cb;
+    ualloc_counters_init(&upool->counters);
+    uatomic_init(&upool->limit, length);
 }
 
 /** @This increments the reference count of a upool.
@@ -114,8 +122,12 @@ static inline void upool_release(struct upool *upool)
 static inline void *upool_alloc_internal(struct upool *upool)
 {
     void *obj = ulifo_pop(&upool->lifo, void *);
-    if (unlikely(obj == NULL))
+    if (likely(obj != NULL))
+        ualloc_counters_hit(&upool->counters, 1);
+    else {
+        ualloc_counters_miss(&upool->counters);
         obj = upool->alloc_cb(upool);
+    }
     if (obj != NULL)
         upool_use(upool);
     return obj;
@@ -129,6 +141,37 @@ static inline void *upool_alloc_internal(struct upool *upool)
  */
 #define upool_alloc(upool, type) (type)upool_alloc_internal(upool)
 
+/** @This allocates several elements from the upool, taking a single
+ * reference to the upool for all of them.
+ *
+ * @param upool pointer to a upool structure
+ * @param objs array written with the allocated elements
+ * @param nb number of elements to allocate
+ * @return number of allocated elements, which may be lower than nb in case
+ * of allocation error
+ */
+static inline unsigned int upool_alloc_batch(struct upool *upool, void **objs,
+                                             unsigned int nb)
+{
+    unsigned int i, hits = 0;
+    for (i = 0; i < nb; i++) {
+        objs[i] = ulifo_pop(&upool->lifo, void *);
+        if (likely(objs[i] != NULL))
+            hits++;
+        else {
+            ualloc_counters_miss(&upool->counters);
+            objs[i] = upool->alloc_cb(upool);
+            if (unlikely(objs[i] == NULL))
+                break;
+        }
+    }
+    if (likely(hits))
+        ualloc_counters_hit(&upool->counters, hits);
+    if (likely(i))
+        urefcount_use_nb(upool->refcount, i);
+    return i;
+}
+
 /** @This frees an element.
  *
  * @param upool pointer to a upool structure
@@ -136,11 +179,29 @@ static inline void *upool_alloc_internal(struct upool *upool)
  */
 static inline void upool_free(struct upool *upool, void *obj)
 {
-    if (unlikely(!ulifo_push(&upool->lifo, obj)))
+    if (likely(uatomic_load(&upool->counters.retained) <
+               uatomic_load(&upool->limit)) &&
+        likely(ulifo_push(&upool->lifo, obj)))
+        ualloc_counters_put(&upool->counters, 1);
+    else {
+        ualloc_counters_overflow(&upool->counters);
         upool->free_cb(upool, obj);
+    }
     upool_release(upool);
 }
 
+/** @This adds the allocation statistics of a upool to a snapshot.
+ *
+ * @param upool pointer to a upool structure
+ * @param stats snapshot to add to
+ * @param size size in octets of an element, or 0 if unknown
+ */
+static inline void upool_get_stats(struct upool *upool,
+                                   struct ualloc_stats *stats, size_t size)
+{
+    ualloc_counters_add(stats, &upool->counters, size);
+}
+
 /** @This empties a upool.
  *
  * @param upool pointer to a upool structure
@@ -148,8 +209,28 @@ static inline void upool_free(struct upool *upool, void *obj)
 static inline void upool_vacuum(struct upool *upool)
 {
     void *obj;
-    while ((obj = ulifo_pop(&upool->lifo, void *)) != NULL)
+    while ((obj = ulifo_pop(&upool->lifo, void *)) != NULL) {
+        ualloc_counters_take(&upool->counters, 1);
+        upool->free_cb(upool, obj);
+    }
+}
+
+/** @This changes the maximum number of elements retained in a upool, and
+ * releases the elements above the new limit. The limit cannot exceed the
+ * length given to @ref upool_init.
+ *
+ * @param upool pointer to a upool structure
+ * @param limit maximum number of elements retained
+ */
+static inline void upool_set_limit(struct upool *upool, uint32_t limit)
+{
+    void *obj;
+    uatomic_store(&upool->limit, limit);
+    while (uatomic_load(&upool->counters.retained) > limit &&
+           (obj = ulifo_pop(&upool->lifo, void *)) != NULL) {
+        ualloc_counters_take(&upool->counters, 1);
         upool->free_cb(upool, obj);
+    }
 }
 
 /** @This empties and cleans up a upool.
@@ -160,6 +241,8 @@ static inline void upool_clean(struct upool *upool)
 {
     upool_vacuum(upool);
     ulifo_clean(&upool->lifo);
+    ualloc_counters_clean(&upool->counters);
+    uatomic_clean(&upool->limit);
 }
 
 #ifdef __cplusplus
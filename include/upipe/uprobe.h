@@ -109,6 +109,21 @@ enum uprobe_event {
     UPROBE_CLOCK_UTC,
     /** a pipe signal the end of the preroll (void) */
     UPROBE_PREROLL_END,
+    /** a pipe reports the allocation statistics of a pool it manages
+     * (const char *, const struct ualloc_stats *) */
+    UPROBE_ALLOC_STATS,
+    /** a pipe reports its input statistics over the last period
+     * (const struct upipe_stats *) */
+    UPROBE_STATS,
+    /** a pipe reports a uref carrying a latency trace (struct uref *) */
+    UPROBE_TRACE,
+    /** a pipe detected a discontinuity in its input, such as a continuity
+     * counter error (uint64_t number of units presumed lost, or 0) */
+    UPROBE_DISCONTINUITY,
+    /** a pump callback of the pipe ran for too long, or a timer of the pipe
+     * expired late, see @ref upump_mgr_set_monitor (uint64_t duration,
+     * uint64_t lag) */
+    UPROBE_SLOW_UPUMP,
 
     /** non-standard events implemented by a module type can start from
      * there (first arg = signature) */
@@ -146,6 +161,11 @@ static inline const char *uprobe_event_str(int event)
     UBASE_CASE_TO_STR(UPROBE_CLOCK_TS);
     UBASE_CASE_TO_STR(UPROBE_CLOCK_UTC);
     UBASE_CASE_TO_STR(UPROBE_PREROLL_END);
+    UBASE_CASE_TO_STR(UPROBE_ALLOC_STATS);
+    UBASE_CASE_TO_STR(UPROBE_STATS);
+    UBASE_CASE_TO_STR(UPROBE_TRACE);
+    UBASE_CASE_TO_STR(UPROBE_DISCONTINUITY);
+    UBASE_CASE_TO_STR(UPROBE_SLOW_UPUMP);
     UBASE_CASE_TO_STR(UPROBE_LOCAL);
     }
     return NULL;
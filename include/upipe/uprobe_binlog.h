@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe writing log events to a binary ring file
+ */
+
+#ifndef _UPIPE_UPROBE_BINLOG_H_
+/** @hidden */
+#define _UPIPE_UPROBE_BINLOG_H_
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_helper_uprobe.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @This is a super-set of the uprobe structure with additional local
+ * members. */
+struct uprobe_binlog {
+    /** minimum level of logged messages */
+    enum uprobe_log_level min_level;
+    /** mutual exclusion of the threads logging messages */
+    pthread_mutex_t mutex;
+    /** mapping of the log file */
+    uint8_t *map;
+    /** size of the mapping */
+    size_t size;
+    /** hash table of the offsets of the interned strings */
+    uint32_t *strings;
+
+    /** structure exported to modules */
+    struct uprobe uprobe;
+};
+
+UPROBE_HELPER_UPROBE(uprobe_binlog, uprobe)
+
+/** @This initializes an already allocated uprobe_binlog structure.
+ *
+ * @param uprobe_binlog pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param path path of the log file, created or truncated
+ * @param ring_size size of the ring of messages in the file, in octets
+ * @param min_level minimum level of logged messages
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_binlog_init(struct uprobe_binlog *uprobe_binlog,
+                                  struct uprobe *next, const char *path,
+                                  size_t ring_size,
+                                  enum uprobe_log_level min_level);
+
+/** @This cleans a uprobe_binlog structure.
+ *
+ * @param uprobe_binlog structure to clean
+ */
+void uprobe_binlog_clean(struct uprobe_binlog *uprobe_binlog);
+
+/** @This allocates a new uprobe_binlog structure.
+ *
+ * Instead of formatting the messages, the probe writes for each of them the
+ * identifier of its format string and prefixes, and the raw arguments of
+ * the format, in a ring mapped from a file, overwriting the oldest messages.
+ * Format strings and prefixes are written once to a table of the file.
+ * The file is meant to be decoded offline with @ref uprobe_binlog_dump,
+ * even after the process has died.
+ *
+ * Messages whose format cannot be encoded (%n, wide characters) or which do
+ * not fit in the table of strings are written formatted.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @param path path of the log file, created or truncated
+ * @param ring_size size of the ring of messages in the file, in octets
+ * @param min_level minimum level of logged messages
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_binlog_alloc(struct uprobe *next, const char *path,
+                                   size_t ring_size,
+                                   enum uprobe_log_level min_level);
+
+/** @This decodes a log file written by a uprobe_binlog, and prints the
+ * messages it holds from the oldest to the newest, each prefixed with its
+ * date (seconds and nanoseconds since the Epoch).
+ *
+ * @param path path of the log file
+ * @param file stream to write to
+ * @return an error code
+ */
+int uprobe_binlog_dump(const char *path, FILE *file);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -39,6 +39,9 @@ extern "C" {
 
 #include <stdint.h>
 
+/** number of jitter samples used to estimate percentiles */
+#define UPROBE_DEJITTER_WINDOW 256
+
 /** @This is a super-set of the uprobe structure with additional local
  * members. */
 struct uprobe_dejitter {
@@ -59,6 +62,22 @@ struct uprobe_dejitter {
     /** minimum deviation */
     double minimum_deviation;
 
+    /** percentile of the jitter covered by the latency, or 0 to use three
+     * times the deviation */
+    unsigned int percentile;
+    /** minimum latency margin */
+    uint64_t min_margin;
+    /** maximum latency margin */
+    uint64_t max_margin;
+    /** latency margin currently applied on top of the average offset */
+    double margin;
+    /** sliding window of jitter samples */
+    int32_t jitter[UPROBE_DEJITTER_WINDOW];
+    /** number of samples in the window */
+    unsigned int jitter_count;
+    /** index of the next sample in the window */
+    unsigned int jitter_idx;
+
     /** cr_prog of last clock ref */
     uint64_t last_cr_prog;
     /** cr_sys of last clock ref */
@@ -120,6 +139,22 @@ void uprobe_dejitter_set(struct uprobe *uprobe, bool enabled,
 void uprobe_dejitter_set_minimum_deviation(struct uprobe *uprobe,
                                            double deviation);
 
+/** @This enables adaptive latency. Instead of three times the deviation,
+ * the latency margin is the given percentile of the jitter measured over
+ * the last @ref UPROBE_DEJITTER_WINDOW clock references, within bounds.
+ * The margin grows as soon as the jitter increases, but only shrinks at the
+ * standard drift of the PLL, so that the clock stays compliant.
+ *
+ * @param uprobe pointer to probe
+ * @param percentile percentile of the jitter to cover (1 to 100), or 0 to
+ * disable adaptive latency
+ * @param min_margin minimum latency margin
+ * @param max_margin maximum latency margin
+ */
+void uprobe_dejitter_set_adaptive(struct uprobe *uprobe,
+                                  unsigned int percentile,
+                                  uint64_t min_margin, uint64_t max_margin);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe exporting counters of pipe events in the Prometheus format
+ */
+
+#ifndef _UPIPE_UPROBE_METRICS_H_
+/** @hidden */
+#define _UPIPE_UPROBE_METRICS_H_
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uatomic.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_helper_uprobe.h"
+
+#include <stdio.h>
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @hidden */
+struct upump_mgr;
+/** @hidden */
+struct upump;
+
+/** @This is a super-set of the uprobe structure with additional local
+ * members. */
+struct uprobe_metrics {
+    /** key of the shard of the current thread */
+    pthread_key_t key;
+    /** list of shards, one per thread having thrown events */
+    uatomic_ptr_t shards;
+
+    /** listening socket, or -1 */
+    int fd;
+    /** pump watching the listening socket */
+    struct upump *upump;
+    /** list of pending HTTP connections */
+    struct uchain conns;
+
+    /** structure exported to modules */
+    struct uprobe uprobe;
+};
+
+UPROBE_HELPER_UPROBE(uprobe_metrics, uprobe)
+
+/** @This initializes an already allocated uprobe_metrics structure.
+ *
+ * @param uprobe_metrics pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_metrics_init(struct uprobe_metrics *uprobe_metrics,
+                                   struct uprobe *next);
+
+/** @This cleans a uprobe_metrics structure. No pipe may throw events to the
+ * probe anymore.
+ *
+ * @param uprobe_metrics structure to clean
+ */
+void uprobe_metrics_clean(struct uprobe_metrics *uprobe_metrics);
+
+/** @This allocates a new uprobe_metrics structure.
+ *
+ * The probe counts the errors, log errors and warnings, synchronization
+ * losses, source and sink ends, stalls, discontinuities and slow event loop
+ * callbacks (see @ref upump_mgr_set_monitor) thrown by pipes, and
+ * accumulates their input statistics (see @ref upipe_stats_enable, with a
+ * period) and the allocation statistics of their pools. Every event is
+ * forwarded to the next probe.
+ *
+ * The counters of each thread are kept in a private shard, which is updated
+ * without locks, and the shards are only summed when the metrics are
+ * formatted. Samples are labelled with the name of the pipe given to
+ * @ref uprobe_pfx_alloc, or with the signature of its manager.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_metrics_alloc(struct uprobe *next);
+
+/** @This writes the current metrics in the Prometheus text exposition
+ * format. It may be called from any thread.
+ *
+ * @param uprobe pointer to probe
+ * @param file stream to write to
+ * @return an error code
+ */
+int uprobe_metrics_print(struct uprobe *uprobe, FILE *file);
+
+/** @This starts a minimal HTTP listener answering every GET request with
+ * the current metrics, driven by pumps of the given manager. The probe must
+ * be cleaned from the thread of the manager.
+ *
+ * @param uprobe pointer to probe
+ * @param upump_mgr manager of the pumps of the listener
+ * @param node address to bind to, or NULL for all addresses
+ * @param service port to bind to
+ * @return an error code
+ */
+int uprobe_metrics_listen(struct uprobe *uprobe, struct upump_mgr *upump_mgr,
+                          const char *node, const char *service);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
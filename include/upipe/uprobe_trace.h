@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe aggregating latency traces into per-stage breakdowns
+ */
+
+#ifndef _UPIPE_UPROBE_TRACE_H_
+/** @hidden */
+#define _UPIPE_UPROBE_TRACE_H_
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_helper_uprobe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** default number of traces between two breakdowns */
+#define UPROBE_TRACE_DEF_PERIOD 100
+
+/** @This is a super-set of the uprobe structure with additional local
+ * members. */
+struct uprobe_trace {
+    /** number of traces between two breakdowns */
+    unsigned int period;
+    /** number of traces since the last breakdown */
+    unsigned int count;
+    /** sum of the end-to-end latencies since the last breakdown */
+    uint64_t sum;
+    /** maximum end-to-end latency since the last breakdown */
+    uint64_t max;
+    /** list of hops between consecutive stages */
+    struct uchain hops;
+
+    /** structure exported to modules */
+    struct uprobe uprobe;
+};
+
+UPROBE_HELPER_UPROBE(uprobe_trace, uprobe)
+
+/** @This initializes an already allocated uprobe_trace structure.
+ *
+ * @param uprobe_trace pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param period number of traces between two breakdowns, or 0 for the
+ * default
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_trace_init(struct uprobe_trace *uprobe_trace,
+                                 struct uprobe *next, unsigned int period);
+
+/** @This cleans a uprobe_trace structure.
+ *
+ * @param uprobe_trace structure to clean
+ */
+void uprobe_trace_clean(struct uprobe_trace *uprobe_trace);
+
+/** @This allocates a new uprobe_trace structure. The probe catches the
+ * @ref UPROBE_TRACE events thrown by the reporting stages (see
+ * @ref upipe_stats_trace), accumulates the latency between consecutive
+ * stages, and logs a breakdown every period traces. As a stage is stamped
+ * when a uref enters it, the latency of a hop includes both the processing
+ * in the former stage and the queueing before the latter.
+ *
+ * The probe is not thread-safe, and must only be used by reporting stages
+ * of a single thread.
+ *
+ * @param next next probe to test if this one doesn't catch the event
+ * @param period number of traces between two breakdowns, or 0 for the
+ * default
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_trace_alloc(struct uprobe *next, unsigned int period);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
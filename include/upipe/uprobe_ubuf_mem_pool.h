@@ -51,6 +51,10 @@ struct uprobe_ubuf_mem_pool {
     uint16_t ubuf_pool_depth;
     /** depth of the shared object pool */
     uint16_t shared_pool_depth;
+    /** memory budget of the pools in adaptive mode, in octets, or 0 */
+    uint64_t budget;
+    /** delay after which the pools of an idle manager are released */
+    uint64_t idle_timeout;
 
     /** chained list of ubuf managers, elements are never removed */
     uatomic_ptr_t first;
@@ -110,6 +114,34 @@ struct uprobe *uprobe_ubuf_mem_pool_alloc(struct uprobe *next,
  */
 void uprobe_ubuf_mem_pool_set(struct uprobe *uprobe, struct umem_mgr *umem_mgr);
 
+/** @This enables the adaptive sizing of the pools of the managers. The
+ * depths given at allocation become maximum depths, and the pools of
+ * managers created afterwards start small. Each call to
+ * @ref uprobe_ubuf_mem_pool_adapt then grows the pools of the managers
+ * missing allocations, shrinks the pools retaining more structures than
+ * they serve, releases the pools of the managers which have not allocated
+ * anything for idle_timeout, and shrinks all pools while the octets they
+ * retain exceed the budget.
+ *
+ * @param uprobe pointer to probe
+ * @param budget memory budget of the pools, in octets, or 0 to disable
+ * @param idle_timeout delay after which the pools of an idle manager are
+ * released, in the unit of the dates given to
+ * @ref uprobe_ubuf_mem_pool_adapt
+ */
+void uprobe_ubuf_mem_pool_set_adaptive(struct uprobe *uprobe, uint64_t budget,
+                                       uint64_t idle_timeout);
+
+/** @This adapts the depth of the pools of the managers to their allocation
+ * rate since the previous call. It is meant to be called periodically, for
+ * instance from a timer, and mustn't be called from several threads at
+ * once.
+ *
+ * @param uprobe pointer to probe
+ * @param now current date, typically from @ref uclock_now
+ */
+void uprobe_ubuf_mem_pool_adapt(struct uprobe *uprobe, uint64_t now);
+
 #ifdef __cplusplus
 }
 #endif
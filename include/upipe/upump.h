@@ -51,6 +51,10 @@ struct upump;
 struct upump_blocker;
 /** @hidden */
 struct umutex;
+/** @hidden */
+struct upipe;
+/** @hidden */
+struct uprobe;
 
 /** @This defines the standard types of pumps. */
 enum upump_type {
@@ -67,6 +71,9 @@ enum upump_type {
     UPUMP_TYPE_FD_WRITE,
     /** event triggers on a UNIX signal (argument = int) */
     UPUMP_TYPE_SIGNAL,
+    /** event triggers once after a given timeout, from the timer wheel of
+     * the event loop (arguments = uint64_t, uint64_t) */
+    UPUMP_TYPE_WHEEL_TIMER,
     /* TODO: Windows objects */
 
     /** non-standard types implemented by a upump handler can start
@@ -118,6 +125,9 @@ struct upump {
     void *opaque;
     /** pointer to urefcount structure to increment during callback */
     struct urefcount *refcount;
+    /** pipe owning the pump, or NULL - only used to report the health of the
+     * event loop */
+    struct upipe *upipe;
 };
 
 UBASE_FROM_TO(upump, uchain, uchain, uchain)
@@ -128,6 +138,10 @@ enum upump_mgr_command {
     UPUMP_MGR_RUN,
     /** release all buffers kept in pools (void) */
     UPUMP_MGR_VACUUM,
+    /** sets the monitoring of the event loop (uint64_t, struct uprobe *) */
+    UPUMP_MGR_SET_MONITOR,
+    /** returns the health of the event loop (struct upump_mgr_health *) */
+    UPUMP_MGR_GET_HEALTH,
 
     /** non-standard manager commands implemented by a upump handler can start
      * from there (first arg = signature) */
@@ -188,6 +202,7 @@ static inline struct upump *upump_alloc(struct upump_mgr *mgr,
     upump->cb = cb;
     upump->opaque = opaque;
     upump->refcount = refcount;
+    upump->upipe = NULL;
     return upump;
 }
 
@@ -229,6 +244,36 @@ static inline struct upump *upump_alloc_timer(struct upump_mgr *mgr,
                        after, repeat);
 }
 
+/** @This allocates and initializes a pump for a timer handled by the timer
+ * wheel of the event loop. Such timers have a resolution of one microsecond,
+ * and all the timers expiring at once are dispatched from a single timer of
+ * the event loop, which makes them cheaper than @ref upump_alloc_timer when
+ * thousands of them are rearmed for each packet or frame.
+ *
+ * Event loops which do not implement a timer wheel return NULL, in which case
+ * the caller should fall back to @ref upump_alloc_timer.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when the pump triggers
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param after time after which it triggers, in ticks of a 27 MHz monotonic
+ * clock
+ * @param repeat pump will trigger again each repeat occurrence, in ticks
+ * of a 27 MHz monotonic clock (0 to disable)
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static inline struct upump *upump_alloc_wheel_timer(struct upump_mgr *mgr,
+                                                    upump_cb cb, void *opaque,
+                                                    struct urefcount *refcount,
+                                                    uint64_t after,
+                                                    uint64_t repeat)
+{
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_TYPE_WHEEL_TIMER,
+                       after, repeat);
+}
+
 /** @This allocates and initializes a pump for a readable file descriptor.
  *
  * @param mgr management structure for this event loop
@@ -513,6 +558,57 @@ static inline int upump_mgr_vacuum(struct upump_mgr *mgr)
     return upump_mgr_control(mgr, UPUMP_MGR_VACUUM);
 }
 
+/** @This describes the health of an event loop since its monitoring was
+ * enabled. Durations are in 27 MHz units. */
+struct upump_mgr_health {
+    /** number of callbacks */
+    uint64_t dispatches;
+    /** time spent in callbacks, excluding nested callbacks */
+    uint64_t time;
+    /** longest callback */
+    uint64_t max_time;
+    /** number of callbacks longer than the threshold, or of timers later
+     * than the threshold */
+    uint64_t slow;
+    /** number of timers whose expected expiry is known */
+    uint64_t timers;
+    /** cumulative lag of these timers, between their expected expiry and
+     * their callback */
+    uint64_t lag;
+    /** highest lag of a timer */
+    uint64_t max_lag;
+};
+
+/** @This enables the monitoring of an event loop. The manager then measures
+ * the time spent in each callback and the lag of timers, and throws
+ * @ref UPROBE_SLOW_UPUMP when one of them exceeds the threshold, to the
+ * pipe owning the pump, or to the given probe if the pump has no owner.
+ *
+ * @param mgr pointer to upump manager
+ * @param threshold threshold in 27 MHz units, or 0 to disable monitoring
+ * @param uprobe probe for the pumps without owner, or NULL
+ * @return an error code
+ */
+static inline int upump_mgr_set_monitor(struct upump_mgr *mgr,
+                                        uint64_t threshold,
+                                        struct uprobe *uprobe)
+{
+    return upump_mgr_control(mgr, UPUMP_MGR_SET_MONITOR, threshold, uprobe);
+}
+
+/** @This returns the health of an event loop, see
+ * @ref upump_mgr_set_monitor.
+ *
+ * @param mgr pointer to upump manager
+ * @param health filled in with the health of the event loop
+ * @return an error code, UBASE_ERR_INVALID if monitoring is disabled
+ */
+static inline int upump_mgr_get_health(struct upump_mgr *mgr,
+                                       struct upump_mgr_health *health)
+{
+    return upump_mgr_control(mgr, UPUMP_MGR_GET_HEALTH, health);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,12 +38,36 @@ extern "C" {
 #include "upipe/ulist.h"
 #include "upipe/upool.h"
 #include "upipe/upump.h"
+#include "upipe/uclock.h"
 
 #include <stdbool.h>
 #include <stdarg.h>
 
 /** @hidden */
 struct upump_blocker;
+/** @hidden */
+struct upump_common_wheel;
+
+/** @This stores the parameters of a timer handled by the timer wheel.
+ */
+struct upump_common_wheel_timer {
+    /** structure for the slots of the wheel */
+    struct uchain uchain;
+    /** delay before the first expiry, in microseconds */
+    uint64_t after;
+    /** period, in microseconds, or 0 */
+    uint64_t repeat;
+    /** absolute deadline, in microseconds */
+    uint64_t deadline;
+    /** level of the slot the timer is in */
+    uint8_t level;
+    /** index of the slot the timer is in */
+    uint8_t slot;
+    /** true if the timer is armed */
+    bool armed;
+    /** true if the timer prevents the event loop from exiting */
+    bool blocking;
+};
 
 /** @This stores upump parameters invisible from modules but usually common.
  */
@@ -55,6 +79,21 @@ struct upump_common {
     /** list of blockers registered on this pump */
     struct uchain blockers;
 
+    /** true if the pump is a timer, of the event loop or of the wheel */
+    bool timer;
+    /** delay before the first expiry of the timer, in 27 MHz ticks */
+    uint64_t timer_after;
+    /** period of the timer, in 27 MHz ticks, or 0 */
+    uint64_t timer_repeat;
+    /** expected expiry of the timer, or 0 if unknown - only maintained when
+     * the event loop is monitored */
+    uint64_t timer_deadline;
+
+    /** true if the pump is a timer of the timer wheel */
+    bool wheel;
+    /** parameters of the timer of the timer wheel */
+    struct upump_common_wheel_timer wheel_timer;
+
     /** public upump structure */
     struct upump upump;
 };
@@ -80,6 +119,30 @@ void upump_common_blocker_free(struct upump_blocker *blocker);
  */
 void upump_common_init(struct upump *upump);
 
+/** @This initializes the common part of a pump as a timer of the event loop
+ * (@ref UPUMP_TYPE_TIMER), so that its lag may be monitored. It must be called
+ * after @ref upump_common_init.
+ *
+ * @param upump description structure of the pump
+ * @param after time after which it triggers, in 27 MHz ticks
+ * @param repeat period of the timer, in 27 MHz ticks (0 to disable)
+ */
+void upump_common_init_timer(struct upump *upump,
+                             uint64_t after, uint64_t repeat);
+
+/** @This initializes the common part of a pump as a timer of the timer wheel
+ * (@ref UPUMP_TYPE_WHEEL_TIMER). It must be called after
+ * @ref upump_common_init. The timer is then entirely handled by the common
+ * layer, and the real start, stop and restart functions of the manager are
+ * never called for it.
+ *
+ * @param upump description structure of the pump
+ * @param after time after which it triggers, in 27 MHz ticks
+ * @param repeat period of the timer, in 27 MHz ticks (0 to disable)
+ */
+void upump_common_init_wheel_timer(struct upump *upump,
+                                   uint64_t after, uint64_t repeat);
+
 /** @This dispatches a pump.
  *
  * @param upump description structure of the pump
@@ -140,6 +203,21 @@ struct upump_common_mgr {
     /** function to really stop a watcher */
     void (*upump_real_stop)(struct upump *, bool);
 
+    /** clock of the timer wheel, not referenced, or NULL to use the
+     * monotonic system clock */
+    struct uclock *uclock;
+    /** timer wheel, allocated when the first wheel timer is started */
+    struct upump_common_wheel *wheel;
+
+    /** threshold of the monitoring of the event loop, or 0 if disabled */
+    uint64_t monitor_threshold;
+    /** probe for the slow pumps without owner, or NULL */
+    struct uprobe *monitor_uprobe;
+    /** health of the event loop */
+    struct upump_mgr_health health;
+    /** time spent in the callbacks nested in the current one */
+    uint64_t monitor_nested;
+
     /** structure exported to modules */
     struct upump_mgr mgr;
 };
@@ -156,6 +234,18 @@ UBASE_FROM_TO(upump_common_mgr, upool, upump_blocker_pool, upump_blocker_pool)
  */
 void upump_common_mgr_vacuum(struct upump_mgr *mgr);
 
+/** @This processes the control commands common to all managers,
+ * @ref UPUMP_MGR_SET_MONITOR and @ref UPUMP_MGR_GET_HEALTH. Managers call it
+ * for the commands they do not handle.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+int upump_common_mgr_control(struct upump_mgr *mgr, int command, va_list args);
+
 /** @This returns the extra buffer space needed for pools.
  *
  * @param upump_pool_depth maximum number of upump structures in the pool
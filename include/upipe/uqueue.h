@@ -37,45 +37,71 @@ extern "C" {
 #include "upipe/config.h"
 #include "upipe/ubase.h"
 #include "upipe/uatomic.h"
-#include "upipe/ufifo.h"
+#include "upipe/umpmc.h"
 #include "upipe/ueventfd.h"
 #include "upipe/upump.h"
 
 #include <stdint.h>
 #include <assert.h>
+#include <time.h>
 
 /** @This is the implementation of a queue. */
 struct uqueue {
-    /** FIFO */
-    struct ufifo fifo;
+    /** ring */
+    struct umpmc ring;
     /** number of elements in the queue */
     uatomic_uint32_t counter;
-    /** maximum number of elements in the queue */
+    /** maximum number of elements in the queue, that is the requested
+     * length rounded up to a power of two */
     uint32_t length;
     /** ueventfd triggered when data can be pushed */
     struct ueventfd event_push;
     /** ueventfd triggered when data can be popped */
     struct ueventfd event_pop;
+
+    /** maximum time (in ns) spent polling an empty queue, 0 to block
+     * at once */
+    uatomic_uint32_t spin_max;
+    /** true while the consumer is polling (the producer then doesn't need
+     * to signal) */
+    uatomic_uint32_t spinning;
+    /** current polling window (in ns), adapted by the consumer */
+    uint32_t spin_window;
+
+    /** number of elements above which producers are throttled, 0 if
+     * disabled */
+    uatomic_uint32_t high_watermark;
+    /** number of elements below which throttled producers resume */
+    uatomic_uint32_t low_watermark;
+    /** true while producers are throttled */
+    uatomic_uint32_t throttled;
 };
 
 /** @This returns the required size of extra data space for uqueue.
  *
- * @param length maximum number of elements in the queue
+ * @param length requested number of elements in the queue
  * @return size in octets to allocate
  */
-#define uqueue_sizeof(length) ufifo_sizeof(length)
+#define uqueue_sizeof(length) umpmc_sizeof(length)
 
-/** @This initializes a uqueue.
+/** @This initializes a uqueue. The capacity of the queue is the requested
+ * length rounded up to a power of two, so that @ref uqueue_push only fails
+ * once that many elements are queued (for instance 256 for a length of 200).
+ * Use @ref uqueue_set_watermarks to bound the queue to an exact number of
+ * elements.
  *
  * @param uqueue pointer to a uqueue structure
- * @param length maximum number of elements in the queue
+ * @param length requested number of elements in the queue (max
+ * @ref #UMPMC_MAX_LENGTH)
  * @param extra mandatory extra space allocated by the caller, with the size
- * returned by @ref #ufifo_sizeof
+ * returned by @ref #uqueue_sizeof
  * @return false in case of failure
  */
-static inline bool uqueue_init(struct uqueue *uqueue, uint8_t length,
+static inline bool uqueue_init(struct uqueue *uqueue, unsigned int length,
                                void *extra)
 {
+    if (unlikely(!length || length > UMPMC_MAX_LENGTH))
+        return false;
     if (unlikely(!ueventfd_init(&uqueue->event_push, true)))
         return false;
     if (unlikely(!ueventfd_init(&uqueue->event_pop, false))) {
@@ -83,12 +109,162 @@ static inline bool uqueue_init(struct uqueue *uqueue, uint8_t length,
         return false;
     }
 
-    ufifo_init(&uqueue->fifo, length, extra);
+    umpmc_init(&uqueue->ring, length, extra);
     uatomic_init(&uqueue->counter, 0);
-    uqueue->length = length;
+    uatomic_init(&uqueue->spin_max, 0);
+    uatomic_init(&uqueue->spinning, 0);
+    uqueue->spin_window = 0;
+    uatomic_init(&uqueue->high_watermark, 0);
+    uatomic_init(&uqueue->low_watermark, 0);
+    uatomic_init(&uqueue->throttled, 0);
+    uqueue->length = umpmc_length(&uqueue->ring);
     return true;
 }
 
+/** @This enables the adaptive busy-poll mode. When the consumer finds the
+ * queue empty, it polls the queue for up to the given duration before
+ * blocking on the event, and producers skip signalling the event while the
+ * consumer is polling, which saves the wake-up latency of the event loop.
+ * The polling window is halved each time it expires (down to a sixteenth
+ * of the duration), and doubled each time data arrives during it, so that
+ * idle queues cost little CPU.
+ *
+ * This function may be called from any thread.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param spin_ns maximum polling duration in nanoseconds, or 0 to disable
+ * polling (the default)
+ */
+static inline void uqueue_set_spin(struct uqueue *uqueue, uint32_t spin_ns)
+{
+    uatomic_store(&uqueue->spin_max, spin_ns);
+}
+
+/** @This sets flow-control watermarks on the queue. Once the queue holds
+ * high elements, pushes fail as if the queue was full, and keep failing
+ * until the consumer has brought the queue down to low elements; the push
+ * event is then signalled. This throttles producers as soon as the
+ * consumer falls behind, without the latency of a completely full ring,
+ * and the hysteresis avoids waking producers for every popped element.
+ *
+ * This function may be called from any thread.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param high number of elements above which producers are throttled, or 0
+ * to disable the watermarks (the default)
+ * @param low number of elements at or below which producers resume
+ * @return false if the watermarks are invalid
+ */
+static inline bool uqueue_set_watermarks(struct uqueue *uqueue,
+                                         uint32_t high, uint32_t low)
+{
+    if (unlikely(high > uqueue->length || (high && low >= high)))
+        return false;
+    uatomic_store(&uqueue->low_watermark, low);
+    uatomic_store(&uqueue->high_watermark, high);
+    uint32_t throttled = 1;
+    if (uatomic_compare_exchange(&uqueue->throttled, &throttled, 0))
+        /* let producers check the new watermarks */
+        ueventfd_write(&uqueue->event_push);
+    return true;
+}
+
+/** @internal @This checks whether producers must be throttled.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @return true if the element must not be pushed
+ */
+static inline bool uqueue_throttle(struct uqueue *uqueue)
+{
+    uint32_t high = uatomic_load(&uqueue->high_watermark);
+    if (likely(!high))
+        return false;
+
+    uint32_t low = uatomic_load(&uqueue->low_watermark);
+    uint32_t counter = uatomic_load(&uqueue->counter);
+    if (counter <= low || (counter < high &&
+                           !uatomic_load(&uqueue->throttled)))
+        return false;
+
+    /* signal that we are throttled */
+    uatomic_store(&uqueue->throttled, 1);
+    ueventfd_read(&uqueue->event_push);
+
+    /* double-check */
+    if (likely(uatomic_load(&uqueue->counter) > low))
+        return true;
+
+    /* signal that we're alright again */
+    uatomic_store(&uqueue->throttled, 0);
+    ueventfd_write(&uqueue->event_push);
+    return false;
+}
+
+/** @internal @This resumes throttled producers once the queue has been
+ * drained down to the low watermark.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param counter number of elements left in the queue
+ */
+static inline void uqueue_unthrottle(struct uqueue *uqueue, uint32_t counter)
+{
+    uint32_t throttled = 1;
+    if (unlikely(uatomic_load(&uqueue->throttled)) &&
+        counter <= uatomic_load(&uqueue->low_watermark) &&
+        uatomic_compare_exchange(&uqueue->throttled, &throttled, 0))
+        ueventfd_write(&uqueue->event_push);
+}
+
+/** @internal @This returns the value of the monotonic clock.
+ *
+ * @return current time in nanoseconds
+ */
+static inline uint64_t uqueue_spin_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** @internal @This polls an empty queue during the adaptive window, if
+ * busy-polling is enabled.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @return true if data arrived during the window
+ */
+static inline bool uqueue_spin(struct uqueue *uqueue)
+{
+    uint32_t spin_max = uatomic_load(&uqueue->spin_max);
+    if (likely(!spin_max))
+        return false;
+    if (!uqueue->spin_window || uqueue->spin_window > spin_max)
+        uqueue->spin_window = spin_max;
+
+    bool found = false;
+    uatomic_store(&uqueue->spinning, 1);
+    uint64_t deadline = uqueue_spin_now() + uqueue->spin_window;
+    do {
+        if (uatomic_load(&uqueue->counter)) {
+            found = true;
+            break;
+        }
+    } while (uqueue_spin_now() < deadline);
+    /* producers signal again from now on, so that the double-check done
+     * before blocking cannot miss an element */
+    uatomic_store(&uqueue->spinning, 0);
+
+    if (found) {
+        /* the event may not have been signalled while polling */
+        ueventfd_write(&uqueue->event_pop);
+        uqueue->spin_window = uqueue->spin_window > spin_max / 2 ?
+                              spin_max : uqueue->spin_window * 2;
+    } else if (uqueue->spin_window > 1 &&
+               uqueue->spin_window / 2 >= spin_max / 16) {
+        uqueue->spin_window /= 2;
+    }
+    return found;
+}
+
 /** @This allocates a watcher triggering when data is ready to be pushed.
  *
  * @param uqueue pointer to a uqueue structure
@@ -131,23 +307,28 @@ static inline struct upump *uqueue_upump_alloc_pop(struct uqueue *uqueue,
  *
  * @param uqueue pointer to a uqueue structure
  * @param element pointer to element to push
- * @return false if the queue is full and the element couldn't be queued
+ * @return false if the queue is full (or above its high watermark) and the
+ * element couldn't be queued
  */
 static inline bool uqueue_push(struct uqueue *uqueue, void *element)
 {
-    if (unlikely(!ufifo_push(&uqueue->fifo, element))) {
+    if (unlikely(uqueue_throttle(uqueue)))
+        return false;
+
+    if (unlikely(!umpmc_push(&uqueue->ring, element))) {
         /* signal that we are full */
         ueventfd_read(&uqueue->event_push);
 
         /* double-check */
-        if (likely(!ufifo_push(&uqueue->fifo, element)))
+        if (likely(!umpmc_push(&uqueue->ring, element)))
             return false;
 
         /* signal that we're alright again */
         ueventfd_write(&uqueue->event_push);
     }
 
-    if (unlikely(uatomic_fetch_add(&uqueue->counter, 1) == 0))
+    if (unlikely(uatomic_fetch_add(&uqueue->counter, 1) == 0) &&
+        !uatomic_load(&uqueue->spinning))
         ueventfd_write(&uqueue->event_pop);
     return true;
 }
@@ -159,13 +340,15 @@ static inline bool uqueue_push(struct uqueue *uqueue, void *element)
  */
 static inline void *uqueue_pop_internal(struct uqueue *uqueue)
 {
-    void *element = ufifo_pop(&uqueue->fifo, void *);
+    void *element = umpmc_pop(&uqueue->ring, void *);
+    if (unlikely(element == NULL) && uqueue_spin(uqueue))
+        element = umpmc_pop(&uqueue->ring, void *);
     if (unlikely(element == NULL)) {
         /* signal that we starve */
         ueventfd_read(&uqueue->event_pop);
 
         /* double-check */
-        element = ufifo_pop(&uqueue->fifo, void *);
+        element = umpmc_pop(&uqueue->ring, void *);
         if (likely(element == NULL))
             return NULL;
 
@@ -173,8 +356,10 @@ static inline void *uqueue_pop_internal(struct uqueue *uqueue)
         ueventfd_write(&uqueue->event_pop);
     }
 
-    if (unlikely(uatomic_fetch_sub(&uqueue->counter, 1) == uqueue->length))
+    uint32_t counter = uatomic_fetch_sub(&uqueue->counter, 1);
+    if (unlikely(counter == uqueue->length))
         ueventfd_write(&uqueue->event_push);
+    uqueue_unthrottle(uqueue, counter - 1);
     return element;
 }
 
@@ -186,6 +371,45 @@ static inline void *uqueue_pop_internal(struct uqueue *uqueue)
  */
 #define uqueue_pop(uqueue, type) (type)uqueue_pop_internal(uqueue)
 
+/** @This pops several elements from the queue at once. The counter is only
+ * updated once for the whole batch, and the pop event is only cleared when
+ * the queue is found empty.
+ *
+ * @param uqueue pointer to a uqueue structure
+ * @param elements array written with the popped elements
+ * @param nb maximum number of elements to pop
+ * @return number of popped elements, 0 if the queue is empty
+ */
+static inline unsigned int uqueue_pop_batch(struct uqueue *uqueue,
+                                            void **elements, unsigned int nb)
+{
+    if (unlikely(!nb))
+        return 0;
+
+    unsigned int count = umpmc_pop_batch(&uqueue->ring, elements, nb);
+    if (unlikely(!count) && uqueue_spin(uqueue))
+        count = umpmc_pop_batch(&uqueue->ring, elements, nb);
+    if (unlikely(!count)) {
+        /* signal that we starve */
+        ueventfd_read(&uqueue->event_pop);
+
+        /* double-check */
+        count = umpmc_pop_batch(&uqueue->ring, elements, nb);
+        if (likely(!count))
+            return 0;
+
+        /* signal that we're alright again */
+        ueventfd_write(&uqueue->event_pop);
+    }
+
+    uint32_t counter = uatomic_fetch_sub(&uqueue->counter, count);
+    if (unlikely(counter >= uqueue->length &&
+                 counter - count < uqueue->length))
+        ueventfd_write(&uqueue->event_push);
+    uqueue_unthrottle(uqueue, counter - count);
+    return count;
+}
+
 /** @This returns the number of elements in the queue.
  *
  * @param uqueue pointer to a uqueue structure
@@ -203,7 +427,12 @@ static inline unsigned int uqueue_length(struct uqueue *uqueue)
 static inline void uqueue_clean(struct uqueue *uqueue)
 {
     uatomic_clean(&uqueue->counter);
-    ufifo_clean(&uqueue->fifo);
+    uatomic_clean(&uqueue->spin_max);
+    uatomic_clean(&uqueue->spinning);
+    uatomic_clean(&uqueue->high_watermark);
+    uatomic_clean(&uqueue->low_watermark);
+    uatomic_clean(&uqueue->throttled);
+    umpmc_clean(&uqueue->ring);
     ueventfd_clean(&uqueue->event_push);
     ueventfd_clean(&uqueue->event_pop);
 }
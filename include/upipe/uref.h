@@ -39,6 +39,7 @@ extern "C" {
 #include "upipe/urefcount.h"
 #include "upipe/ubuf.h"
 #include "upipe/udict.h"
+#include "upipe/usdt.h"
 
 #include <assert.h>
 #include <inttypes.h>
@@ -137,6 +138,9 @@ UBASE_FROM_TO(uref, uchain, uchain, uchain)
 enum uref_mgr_command {
     /** release all buffers kept in pools (void) */
     UREF_MGR_VACUUM,
+    /** allocate several urefs at once (struct uref **, unsigned int,
+     * unsigned int *) */
+    UREF_MGR_ALLOC_BATCH,
 
     /** non-standard manager commands implemented by a module type can start
      * from there (first arg = signature) */
@@ -171,6 +175,7 @@ static inline void uref_free(struct uref *uref)
 {
     if (uref == NULL)
         return;
+    UPIPE_USDT(uref_free, uref);
     ubuf_free(uref->ubuf);
     udict_free(uref->udict);
     uref->mgr->uref_free(uref);
@@ -207,6 +212,7 @@ static inline struct uref *uref_alloc(struct uref_mgr *mgr)
         return NULL;
 
     uref_init(uref);
+    UPIPE_USDT(uref_alloc, uref);
     return uref;
 }
 
@@ -421,6 +427,33 @@ static inline int uref_mgr_vacuum(struct uref_mgr *mgr)
     return uref_mgr_control(mgr, UREF_MGR_VACUUM);
 }
 
+/** @This allocates and initializes several urefs at once. Managers which do
+ * not implement batch allocation fall back to individual allocations.
+ *
+ * @param mgr management structure
+ * @param urefs array written with the allocated urefs
+ * @param nb number of urefs to allocate
+ * @return number of allocated urefs, which may be lower than nb in case of
+ * allocation failure
+ */
+static inline unsigned int uref_alloc_batch(struct uref_mgr *mgr,
+                                            struct uref **urefs,
+                                            unsigned int nb)
+{
+    unsigned int count;
+    if (!ubase_check(uref_mgr_control(mgr, UREF_MGR_ALLOC_BATCH,
+                                      urefs, nb, &count))) {
+        for (count = 0; count < nb; count++) {
+            urefs[count] = mgr->uref_alloc(mgr);
+            if (unlikely(urefs[count] == NULL))
+                break;
+        }
+    }
+    for (unsigned int i = 0; i < count; i++)
+        uref_init(urefs[i]);
+    return count;
+}
+
 #ifdef __cplusplus
 }
 #endif
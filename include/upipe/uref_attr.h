@@ -34,8 +34,29 @@
 extern "C" {
 #endif
 
+#include "upipe/uatomic.h"
 #include "upipe/uref.h"
 #include "upipe/udict.h"
+#include "upipe/udict_key.h"
+
+/** @This returns the canonical name of an attribute, interned in the
+ * global key registry on first use. It must be given a constant string.
+ *
+ * @param name constant name of the attribute
+ * @return canonical name of the attribute
+ */
+#define UREF_ATTR_KEY(name)                                                 \
+    ({                                                                      \
+        /* concurrent initializations store the same value */               \
+        static uatomic_ptr_t uref_attr_key = NULL;                          \
+        const char *uref_attr_key_p =                                       \
+            uatomic_ptr_load_ptr(&uref_attr_key, const char *);             \
+        if (unlikely(uref_attr_key_p == NULL)) {                            \
+            uref_attr_key_p = udict_key_intern(name);                       \
+            uatomic_ptr_store(&uref_attr_key, (void *)uref_attr_key_p);     \
+        }                                                                   \
+        uref_attr_key_p;                                                    \
+    })
 
 /** @This imports all attributes from a uref into another uref (see also
  * @ref udict_import).
@@ -291,7 +312,7 @@ static inline int uref_attr_set_opaque_from_hex_va(struct uref *uref,
  * @param name opaque defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_OPAQUE(group, attr, name, desc)                           \
+#define _UREF_ATTR_OPAQUE(group, attr, name, desc)                          \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -360,6 +381,17 @@ uref_##group##_copy_##attr(struct uref *uref, struct uref *uref_src)        \
                                  UDICT_TYPE_OPAQUE, name);                  \
 }
 
+/* @This allows to define accessors for a opaque attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_OPAQUE(group, attr, name, desc)                           \
+    _UREF_ATTR_OPAQUE(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand opaque attribute.
  *
  * @param group group of attributes
@@ -500,7 +532,7 @@ static inline int uref_##group##_copy_##attr(struct uref *uref,             \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_STRING(group, attr, name, desc)                           \
+#define _UREF_ATTR_STRING(group, attr, name, desc)                          \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -590,6 +622,17 @@ uref_##group##_cmp_##attr(struct uref *uref1, struct uref *uref2)           \
     return strcmp(v1, v2);                                                  \
 }
 
+/* @This allows to define accessors for a string attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_STRING(group, attr, name, desc)                           \
+    _UREF_ATTR_STRING(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand string attribute.
  *
  * @param group group of attributes
@@ -772,7 +815,7 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_VOID(group, attr, name, desc)                             \
+#define _UREF_ATTR_VOID(group, attr, name, desc)                            \
 /** @This returns the presence of a desc attribute in a uref.               \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -829,6 +872,17 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
     return 0;                                                               \
 }
 
+/* @This allows to define accessors for a void attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_VOID(group, attr, name, desc)                             \
+    _UREF_ATTR_VOID(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand void attribute.
  *
  * @param group group of attributes
@@ -1022,7 +1076,7 @@ static inline void uref_##group##_copy_##attr(struct uref *uref,            \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_BOOL(group, attr, name, desc)                             \
+#define _UREF_ATTR_BOOL(group, attr, name, desc)                            \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -1082,6 +1136,17 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
     return v1 == v2 ? 0 : 1;                                                \
 }
 
+/* @This allows to define accessors for a bool attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_BOOL(group, attr, name, desc)                             \
+    _UREF_ATTR_BOOL(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand bool attribute.
  *
  * @param group group of attributes
@@ -1161,7 +1226,7 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_SMALL_UNSIGNED(group, attr, name, desc)                   \
+#define _UREF_ATTR_SMALL_UNSIGNED(group, attr, name, desc)                  \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -1239,6 +1304,17 @@ uref_##group##_cmp_##attr(struct uref *uref1, struct uref *uref2)           \
     return v1 - v2;                                                         \
 }
 
+/* @This allows to define accessors for a small unsigned attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_SMALL_UNSIGNED(group, attr, name, desc)                   \
+    _UREF_ATTR_SMALL_UNSIGNED(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand small_unsigned attribute.
  *
  * @param group group of attributes
@@ -1426,7 +1502,7 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_UNSIGNED(group, attr, name, desc)                         \
+#define _UREF_ATTR_UNSIGNED(group, attr, name, desc)                        \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -1502,6 +1578,17 @@ uref_##group##_cmp_##attr(struct uref *uref1, struct uref *uref2)           \
     return v1 - v2;                                                         \
 }
 
+/* @This allows to define accessors for a unsigned attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_UNSIGNED(group, attr, name, desc)                         \
+    _UREF_ATTR_UNSIGNED(group, attr, UREF_ATTR_KEY(name), desc)
+
 
 /* @This allows to define accessors for a shorthand unsigned attribute.
  *
@@ -1775,7 +1862,7 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_INT(group, attr, name, desc)                              \
+#define _UREF_ATTR_INT(group, attr, name, desc)                             \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -1836,6 +1923,17 @@ uref_##group##_cmp_##attr(struct uref *uref1, struct uref *uref2)           \
     return v1 - v2;                                                         \
 }
 
+/* @This allows to define accessors for a int attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_INT(group, attr, name, desc)                              \
+    _UREF_ATTR_INT(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand int attribute.
  *
  * @param group group of attributes
@@ -1950,7 +2048,7 @@ static inline int uref_##group##_copy_##attr(struct uref *uref,             \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_FLOAT(group, attr, name, desc)                            \
+#define _UREF_ATTR_FLOAT(group, attr, name, desc)                           \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -2010,6 +2108,17 @@ static inline int uref_##group##_cmp_##attr(struct uref *uref1,             \
     return v1 - v2;                                                         \
 }
 
+/* @This allows to define accessors for a float attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_FLOAT(group, attr, name, desc)                            \
+    _UREF_ATTR_FLOAT(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand int attribute.
  *
  * @param group group of attributes
@@ -2125,7 +2234,7 @@ static inline int uref_##group##_copy_##attr(struct uref *uref,             \
  * @param name string defining the attribute
  * @param desc description of the attribute
  */
-#define UREF_ATTR_RATIONAL(group, attr, name, desc)                         \
+#define _UREF_ATTR_RATIONAL(group, attr, name, desc)                        \
 /** @This returns the desc attribute of a uref.                             \
  *                                                                          \
  * @param uref pointer to the uref                                          \
@@ -2170,6 +2279,17 @@ static inline int uref_##group##_copy_##attr(struct uref *uref,             \
                                    name);                                   \
 }
 
+/* @This allows to define accessors for a rational attribute, with
+ * the name interned in the global key registry.
+ *
+ * @param group group of attributes
+ * @param attr readable name of the attribute, for the function names
+ * @param name string defining the attribute
+ * @param desc description of the attribute
+ */
+#define UREF_ATTR_RATIONAL(group, attr, name, desc)                         \
+    _UREF_ATTR_RATIONAL(group, attr, UREF_ATTR_KEY(name), desc)
+
 /* @This allows to define accessors for a shorthand rational attribute.
  *
  * @param group group of attributes
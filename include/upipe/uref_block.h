@@ -73,6 +73,41 @@ static inline struct uref *uref_block_alloc(struct uref_mgr *uref_mgr,
     return uref;
 }
 
+/** @This allocates several new urefs pointing to new block ubufs of the same
+ * size, in a single pass over the pools of both managers.
+ *
+ * @param uref_mgr management structure for the uref
+ * @param ubuf_mgr management structure for the ubuf
+ * @param size size of each buffer
+ * @param urefs array written with the allocated urefs
+ * @param nb number of urefs to allocate
+ * @return number of allocated urefs, which may be lower than nb in case of
+ * allocation failure
+ */
+static inline unsigned int uref_block_alloc_batch(struct uref_mgr *uref_mgr,
+                                                  struct ubuf_mgr *ubuf_mgr,
+                                                  int size,
+                                                  struct uref **urefs,
+                                                  unsigned int nb)
+{
+    nb = uref_alloc_batch(uref_mgr, urefs, nb);
+    unsigned int count = 0;
+    while (count < nb) {
+        struct ubuf *ubufs[64];
+        unsigned int chunk = nb - count < 64 ? nb - count : 64;
+        unsigned int done = ubuf_block_alloc_batch(ubuf_mgr, size, ubufs,
+                                                   chunk);
+        for (unsigned int i = 0; i < done; i++)
+            uref_attach_ubuf(urefs[count + i], ubufs[i]);
+        count += done;
+        if (unlikely(done < chunk))
+            break;
+    }
+    for (unsigned int i = count; i < nb; i++)
+        uref_free(urefs[i]);
+    return count;
+}
+
 /** @see ubuf_block_size */
 static inline int uref_block_size(struct uref *uref, size_t *size_p)
 {
@@ -321,6 +356,15 @@ static inline int uref_block_scan(struct uref *uref, size_t *offset_p,
     return ubuf_block_scan(uref->ubuf, offset_p, word);
 }
 
+/** @see ubuf_block_find_startcode */
+static inline int uref_block_find_startcode(struct uref *uref,
+                                            size_t *offset_p)
+{
+    if (uref->ubuf == NULL)
+        return UBASE_ERR_INVALID;
+    return ubuf_block_find_startcode(uref->ubuf, offset_p);
+}
+
 /** @see ubuf_block_find_va */
 static inline int uref_block_find_va(struct uref *uref, size_t *offset_p,
                                      unsigned int nb_octets, va_list args)
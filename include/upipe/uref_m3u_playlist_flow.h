@@ -40,6 +40,8 @@ UREF_ATTR_UNSIGNED(m3u_playlist_flow, media_sequence,
                    media sequence)
 UREF_ATTR_VOID(m3u_playlist_flow, endlist, "m3u.playlist.endlist",
                endlist)
+UREF_ATTR_VOID(m3u_playlist_flow, append, "m3u.playlist.append",
+               items follow the previously output items)
 
 static inline int uref_m3u_playlist_flow_delete(struct uref *uref)
 {
@@ -48,6 +50,7 @@ static inline int uref_m3u_playlist_flow_delete(struct uref *uref)
         uref_m3u_playlist_flow_delete_target_duration,
         uref_m3u_playlist_flow_delete_media_sequence,
         uref_m3u_playlist_flow_delete_endlist,
+        uref_m3u_playlist_flow_delete_append,
     };
 
     return uref_attr_delete_list(uref, list, UBASE_ARRAY_SIZE(list));
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe FIFO of sound urefs, cut into fixed-size periods
+ *
+ * Pipes that output audio at a fixed period (a video frame, an encoder
+ * frame) receive it in chunks of arbitrary sizes. This FIFO queues the
+ * incoming urefs and pops periods out of them, without copying the samples
+ * whenever the period lies within a single uref: the ubuf is then shared
+ * and only resized. Samples are only copied when a period spans several
+ * urefs. It also keeps a buffer of silence, shared between all the urefs
+ * that need it.
+ */
+
+#ifndef _UPIPE_UREF_SOUND_FIFO_H_
+/** @hidden */
+#define _UPIPE_UREF_SOUND_FIFO_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uref.h"
+#include "upipe/ubuf.h"
+
+#include <stdint.h>
+
+/** @This is a FIFO of sound urefs. */
+struct uref_sound_fifo {
+    /** queued urefs */
+    struct uchain urefs;
+    /** number of queued samples */
+    uint64_t samples;
+    /** sample rate, used to date the remainder of split urefs */
+    uint64_t rate;
+    /** shared buffer of silence, or NULL */
+    struct ubuf *silence;
+};
+
+/** @This initializes a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ * @param rate sample rate, or 0 if the urefs are not to be dated
+ */
+void uref_sound_fifo_init(struct uref_sound_fifo *fifo, uint64_t rate);
+
+/** @This frees all urefs queued in a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ */
+void uref_sound_fifo_flush(struct uref_sound_fifo *fifo);
+
+/** @This cleans up a sound FIFO, and releases the buffer of silence.
+ *
+ * @param fifo pointer to the FIFO
+ */
+void uref_sound_fifo_clean(struct uref_sound_fifo *fifo);
+
+/** @This returns the number of samples queued in a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ * @return number of samples
+ */
+static inline uint64_t uref_sound_fifo_samples(struct uref_sound_fifo *fifo)
+{
+    return fifo->samples;
+}
+
+/** @This returns the first uref of a sound FIFO, without dequeuing it.
+ *
+ * @param fifo pointer to the FIFO
+ * @return pointer to the first uref, or NULL if the FIFO is empty
+ */
+static inline struct uref *uref_sound_fifo_peek(struct uref_sound_fifo *fifo)
+{
+    struct uchain *uchain = ulist_peek(&fifo->urefs);
+    return uchain != NULL ? uref_from_uchain(uchain) : NULL;
+}
+
+/** @This queues a sound uref at the end of a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ * @param uref sound uref, belonging to the FIFO afterwards
+ * @return an error code
+ */
+int uref_sound_fifo_push(struct uref_sound_fifo *fifo, struct uref *uref);
+
+/** @This dequeues the first uref of a sound FIFO, whatever its size.
+ *
+ * @param fifo pointer to the FIFO
+ * @return pointer to the uref, or NULL if the FIFO is empty
+ */
+struct uref *uref_sound_fifo_pop_uref(struct uref_sound_fifo *fifo);
+
+/** @This dequeues a given number of samples from a sound FIFO. If the first
+ * uref holds enough samples, the returned uref shares its buffer and no
+ * sample is copied. Otherwise a new buffer is allocated from the given
+ * manager, and the samples of the following urefs are copied into it. If
+ * the FIFO runs short, the end of the buffer is filled with zeros.
+ *
+ * @param fifo pointer to the FIFO
+ * @param ubuf_mgr manager of the copied buffers, or NULL to use the manager
+ * of the first uref
+ * @param samples number of samples to dequeue
+ * @return pointer to the uref, or NULL if the FIFO is empty or in case of
+ * allocation error
+ */
+struct uref *uref_sound_fifo_pop(struct uref_sound_fifo *fifo,
+                                 struct ubuf_mgr *ubuf_mgr, size_t samples);
+
+/** @This drops a given number of samples from the head of a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ * @param samples number of samples to drop
+ */
+void uref_sound_fifo_drop(struct uref_sound_fifo *fifo, size_t samples);
+
+/** @This maps the first samples of a sound FIFO for reading, if they are
+ * contiguous in the first uref.
+ *
+ * @param fifo pointer to the FIFO
+ * @param samples number of samples to map
+ * @param buffers_p filled in with pointers to the planes
+ * @param planes number of planes
+ * @return an error code, UBASE_ERR_INVALID if the samples are not
+ * contiguous
+ */
+int uref_sound_fifo_read(struct uref_sound_fifo *fifo, size_t samples,
+                         const uint8_t *buffers_p[], uint8_t planes);
+
+/** @This unmaps the samples mapped by @ref uref_sound_fifo_read.
+ *
+ * @param fifo pointer to the FIFO
+ * @param samples number of samples mapped
+ * @param planes number of planes
+ * @return an error code
+ */
+int uref_sound_fifo_unmap(struct uref_sound_fifo *fifo, size_t samples,
+                          uint8_t planes);
+
+/** @This returns a uref of silence. All such urefs share the same zeroed
+ * buffer, which is only reallocated when a larger one is needed, so they
+ * must not be written to.
+ *
+ * @param fifo pointer to the FIFO
+ * @param uref_mgr management structure for the uref
+ * @param ubuf_mgr management structure for the buffer of silence
+ * @param samples number of samples
+ * @return pointer to the uref, or NULL in case of allocation error
+ */
+struct uref *uref_sound_fifo_silence(struct uref_sound_fifo *fifo,
+                                     struct uref_mgr *uref_mgr,
+                                     struct ubuf_mgr *ubuf_mgr,
+                                     size_t samples);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
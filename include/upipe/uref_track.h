@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe uref manager tracking the lifetime of urefs
+ *
+ * The tracking manager wraps another uref manager, which still allocates
+ * and pools the urefs. A sample of the live urefs is recorded with its
+ * allocation site and date, and a histogram of the live samples by site and
+ * age may be printed on demand, to find out which code holds references
+ * when pools grow. Urefs allocated through the manager keep pointing to it
+ * as long as they live, including their duplicates.
+ */
+
+#ifndef _UPIPE_UREF_TRACK_H_
+/** @hidden */
+#define _UPIPE_UREF_TRACK_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/uref.h"
+
+#include <stdio.h>
+
+#define UREF_TRACK_SIGNATURE UBASE_FOURCC('t','r','k','u')
+
+/** @This extends uref_mgr_command with specific commands for the tracking
+ * manager. */
+enum uref_track_mgr_command {
+    UREF_TRACK_MGR_SENTINEL = UREF_MGR_CONTROL_LOCAL,
+
+    /** prints the live sampled urefs (FILE *) */
+    UREF_TRACK_MGR_DUMP
+};
+
+/** @This prints a histogram of the live sampled urefs by allocation site
+ * (the function of the pipe which allocated or duplicated them) and age.
+ *
+ * @param mgr pointer to tracking uref manager
+ * @param file file to print to
+ * @return an error code
+ */
+static inline int uref_track_mgr_dump(struct uref_mgr *mgr, FILE *file)
+{
+    return uref_mgr_control(mgr, UREF_TRACK_MGR_DUMP, UREF_TRACK_SIGNATURE,
+                            file);
+}
+
+/** @This allocates a uref manager tracking the urefs allocated with another
+ * manager.
+ *
+ * @param uref_mgr uref manager allocating the urefs
+ * @param period one uref out of period is sampled (1 to track all urefs)
+ * @return pointer to manager, or NULL in case of error
+ */
+struct uref_mgr *uref_track_mgr_alloc(struct uref_mgr *uref_mgr,
+                                      unsigned int period);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
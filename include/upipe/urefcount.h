@@ -91,6 +91,22 @@ static inline struct urefcount *urefcount_use(struct urefcount *refcount)
         return NULL;
 }
 
+/** @This increments a reference counter by a given number of references.
+ *
+ * @param refcount pointer to a urefcount structure
+ * @param nb number of references to add
+ * @return same pointer to a urefcount structure, or NULL if refcount is dead
+ */
+static inline struct urefcount *urefcount_use_nb(struct urefcount *refcount,
+                                                 uint32_t nb)
+{
+    if (refcount != NULL && refcount->cb != NULL) {
+        uatomic_fetch_add(&refcount->refcount, nb);
+        return refcount;
+    } else
+        return NULL;
+}
+
 /** @This decrements a reference counter, and possibly frees the object if
  * the refcount goes down to 0.
  *
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe USDT static probes
+ *
+ * When sys/sdt.h is available at build time (see configure --disable-usdt),
+ * the following probes are compiled in the provider "upipe". They cost a
+ * single nop until a tracer such as bpftrace attaches to them:
+ * @list
+ * @item input(upipe, uref) and input_end(upipe): @ref upipe_input
+ * @item throw(upipe, event): @ref upipe_throw
+ * @item uref_alloc(uref) and uref_free(uref): @ref uref_alloc and
+ * @ref uref_free
+ * @item umem_alloc(buffer, size) and umem_free(buffer, size):
+ * @ref umem_alloc and @ref umem_free
+ * @item dispatch(upump, cb) and dispatch_end(upump): dispatch of a pump by
+ * any upump manager
+ * @item xfer_send(mgr, type, upipe) and xfer_recv(mgr, type, upipe):
+ * commands sent to the remote thread of an xfer manager
+ * @item xfer_event_send(upipe, event) and xfer_event_recv(upipe, event):
+ * events sent back from the remote thread of an xfer pipe
+ * @end list
+ *
+ * For instance:
+ * @code
+ * bpftrace -e 'usdt:./app:upipe:input { @start[tid] = nsecs; }
+ *     usdt:./app:upipe:input_end /@start[tid]/ {
+ *         @us = hist((nsecs - @start[tid]) / 1000); }'
+ * @end code
+ */
+
+#ifndef _UPIPE_USDT_H_
+/** @hidden */
+#define _UPIPE_USDT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/config.h"
+
+#ifdef UPIPE_HAVE_SYS_SDT_H
+/* sys/sdt.h relies on templates in C++, and may be included from within
+ * extern "C" blocks */
+#ifdef __cplusplus
+extern "C++" {
+#endif
+#include <sys/sdt.h>
+#ifdef __cplusplus
+}
+#endif
+
+/** @This defines a probe point with a name and up to 12 arguments. */
+#define UPIPE_USDT(...) STAP_PROBEV(upipe, __VA_ARGS__)
+
+#else /* mkdoc:skip */
+#define UPIPE_USDT(...) do { } while (0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe bitmap of TS PIDs, used to filter raw TS datagrams
+ *
+ * This is used by sources receiving raw TS over IP to drop unwanted
+ * packets from the received buffer before it is output, so that a single
+ * program can be extracted from a large multiplex without any per-packet
+ * allocation for the other programs.
+ */
+
+#ifndef _UPIPE_UTS_PID_FILTER_H_
+/** @hidden */
+#define _UPIPE_UTS_PID_FILTER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** size of a TS packet */
+#define UTS_PID_FILTER_PACKET_SIZE 188
+/** number of PIDs */
+#define UTS_PID_FILTER_PIDS 8192
+/** TS synchronization word */
+#define UTS_PID_FILTER_SYNC 0x47
+
+/** @This is a bitmap of selected PIDs. */
+struct uts_pid_filter {
+    /** one bit per PID */
+    uint64_t bitmap[UTS_PID_FILTER_PIDS / 64];
+};
+
+/** @This initializes a PID filter with no PID selected.
+ *
+ * @param filter pointer to PID filter
+ */
+static inline void uts_pid_filter_init(struct uts_pid_filter *filter)
+{
+    memset(filter->bitmap, 0, sizeof(filter->bitmap));
+}
+
+/** @This selects a PID.
+ *
+ * @param filter pointer to PID filter
+ * @param pid PID to select
+ */
+static inline void uts_pid_filter_add(struct uts_pid_filter *filter,
+                                      uint16_t pid)
+{
+    pid &= UTS_PID_FILTER_PIDS - 1;
+    filter->bitmap[pid / 64] |= UINT64_C(1) << (pid % 64);
+}
+
+/** @This unselects a PID.
+ *
+ * @param filter pointer to PID filter
+ * @param pid PID to unselect
+ */
+static inline void uts_pid_filter_del(struct uts_pid_filter *filter,
+                                      uint16_t pid)
+{
+    pid &= UTS_PID_FILTER_PIDS - 1;
+    filter->bitmap[pid / 64] &= ~(UINT64_C(1) << (pid % 64));
+}
+
+/** @This checks whether a PID is selected.
+ *
+ * @param filter pointer to PID filter
+ * @param pid PID to check
+ * @return true if the PID is selected
+ */
+static inline bool uts_pid_filter_check(const struct uts_pid_filter *filter,
+                                        uint16_t pid)
+{
+    pid &= UTS_PID_FILTER_PIDS - 1;
+    return filter->bitmap[pid / 64] & (UINT64_C(1) << (pid % 64));
+}
+
+/** @This removes the packets of unselected PIDs from a buffer of TS
+ * packets, by moving the selected packets to the front of the buffer.
+ * Buffers which do not look like a whole number of TS packets (for
+ * instance RTP datagrams) are left untouched.
+ *
+ * @param filter pointer to PID filter
+ * @param buffer buffer of TS packets
+ * @param size size of the buffer
+ * @return size of the selected packets at the front of the buffer
+ */
+static inline size_t uts_pid_filter_compact(const struct uts_pid_filter *filter,
+                                            uint8_t *buffer, size_t size)
+{
+    if (unlikely(!size || size % UTS_PID_FILTER_PACKET_SIZE))
+        return size;
+    for (size_t offset = 0; offset < size;
+         offset += UTS_PID_FILTER_PACKET_SIZE)
+        if (unlikely(buffer[offset] != UTS_PID_FILTER_SYNC))
+            return size;
+
+    size_t kept = 0;
+    for (size_t offset = 0; offset < size;
+         offset += UTS_PID_FILTER_PACKET_SIZE) {
+        uint16_t pid = ((buffer[offset + 1] & 0x1f) << 8) |
+                       buffer[offset + 2];
+        if (!uts_pid_filter_check(filter, pid))
+            continue;
+        if (kept != offset)
+            memmove(buffer + kept, buffer + offset,
+                    UTS_PID_FILTER_PACKET_SIZE);
+        kept += UTS_PID_FILTER_PACKET_SIZE;
+    }
+    return kept;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
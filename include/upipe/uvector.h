@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe implementation of growable ring buffers of pointers
+ * (NOT thread-safe)
+ *
+ * A uvector stores pointers to its elements in a contiguous array used as a
+ * ring buffer, so that elements can be added at the end and removed from
+ * the beginning in O(1), like a queue. Unlike a ulist, iterating does not
+ * follow a pointer per element, and the next elements may be prefetched.
+ */
+
+#ifndef _UPIPE_UVECTOR_H_
+/** @hidden */
+#define _UPIPE_UVECTOR_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/ubase.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+/** initial number of allocated slots, must be a power of 2 */
+#define UVECTOR_INITIAL_SIZE 4
+
+/** @This is the implementation of a vector. */
+struct uvector {
+    /** array of elements */
+    void **items;
+    /** index of the first element in the array */
+    unsigned int first;
+    /** number of elements */
+    unsigned int size;
+    /** number of allocated slots, a power of 2 */
+    unsigned int allocated;
+};
+
+/** @This initializes a vector.
+ *
+ * @param uvector pointer to a uvector structure
+ */
+static inline void uvector_init(struct uvector *uvector)
+{
+    uvector->items = NULL;
+    uvector->first = uvector->size = uvector->allocated = 0;
+}
+
+/** @This cleans up a vector. The elements are not released.
+ *
+ * @param uvector pointer to a uvector structure
+ */
+static inline void uvector_clean(struct uvector *uvector)
+{
+    free(uvector->items);
+    uvector_init(uvector);
+}
+
+/** @This returns the number of elements in a vector.
+ *
+ * @param uvector pointer to a uvector structure
+ * @return number of elements
+ */
+static inline unsigned int uvector_size(const struct uvector *uvector)
+{
+    return uvector->size;
+}
+
+/** @This checks if a vector is empty.
+ *
+ * @param uvector pointer to a uvector structure
+ * @return true if the vector is empty
+ */
+static inline bool uvector_empty(const struct uvector *uvector)
+{
+    return !uvector->size;
+}
+
+/** @This returns an element of a vector.
+ *
+ * @param uvector pointer to a uvector structure
+ * @param index index of the element, lower than the size
+ * @return pointer to the element
+ */
+static inline void *uvector_at(const struct uvector *uvector,
+                               unsigned int index)
+{
+    return uvector->items[(uvector->first + index) &
+                          (uvector->allocated - 1)];
+}
+
+/** @This prefetches an element of a vector, if it exists.
+ *
+ * @param uvector pointer to a uvector structure
+ * @param index index of the element
+ */
+static inline void uvector_prefetch(const struct uvector *uvector,
+                                    unsigned int index)
+{
+#ifdef __GNUC__
+    if (index < uvector->size)
+        __builtin_prefetch(uvector_at(uvector, index));
+#endif
+}
+
+/** @This returns the first element of a vector, without removing it.
+ *
+ * @param uvector pointer to a uvector structure
+ * @return pointer to the element, or NULL if the vector is empty
+ */
+static inline void *uvector_peek(const struct uvector *uvector)
+{
+    return uvector->size ? uvector_at(uvector, 0) : NULL;
+}
+
+/** @This returns the last element of a vector, without removing it.
+ *
+ * @param uvector pointer to a uvector structure
+ * @return pointer to the element, or NULL if the vector is empty
+ */
+static inline void *uvector_peek_last(const struct uvector *uvector)
+{
+    return uvector->size ? uvector_at(uvector, uvector->size - 1) : NULL;
+}
+
+/** @internal @This makes room for at least one more element.
+ *
+ * @param uvector pointer to a uvector structure
+ * @return false in case of allocation failure
+ */
+static inline bool uvector_grow(struct uvector *uvector)
+{
+    if (likely(uvector->size < uvector->allocated))
+        return true;
+
+    unsigned int allocated = uvector->allocated ?
+                             uvector->allocated * 2 : UVECTOR_INITIAL_SIZE;
+    void **items = malloc(allocated * sizeof(*items));
+    if (unlikely(items == NULL))
+        return false;
+    for (unsigned int i = 0; i < uvector->size; i++)
+        items[i] = uvector_at(uvector, i);
+    free(uvector->items);
+    uvector->items = items;
+    uvector->first = 0;
+    uvector->allocated = allocated;
+    return true;
+}
+
+/** @This adds an element at the end of a vector.
+ *
+ * @param uvector pointer to a uvector structure
+ * @param item pointer to the element
+ * @return false in case of allocation failure
+ */
+static inline bool uvector_add(struct uvector *uvector, void *item)
+{
+    if (unlikely(!uvector_grow(uvector)))
+        return false;
+    uvector->items[(uvector->first + uvector->size++) &
+                   (uvector->allocated - 1)] = item;
+    return true;
+}
+
+/** @This removes the first element of a vector.
+ *
+ * @param uvector pointer to a uvector structure
+ * @return pointer to the element, or NULL if the vector is empty
+ */
+static inline void *uvector_pop(struct uvector *uvector)
+{
+    if (unlikely(!uvector->size))
+        return NULL;
+    void *item = uvector_at(uvector, 0);
+    uvector->first = (uvector->first + 1) & (uvector->allocated - 1);
+    uvector->size--;
+    return item;
+}
+
+/** @This removes the element at a given index of a vector, keeping the
+ * order of the other elements.
+ *
+ * @param uvector pointer to a uvector structure
+ * @param index index of the element, lower than the size
+ */
+static inline void uvector_delete_at(struct uvector *uvector,
+                                     unsigned int index)
+{
+    unsigned int mask = uvector->allocated - 1;
+    for (unsigned int i = index + 1; i < uvector->size; i++)
+        uvector->items[(uvector->first + i - 1) & mask] =
+            uvector->items[(uvector->first + i) & mask];
+    uvector->size--;
+}
+
+/** @This removes all the occurrences of an element from a vector, keeping
+ * the order of the other elements.
+ *
+ * @param uvector pointer to a uvector structure
+ * @param item pointer to the element
+ * @return true if the element was found
+ */
+static inline bool uvector_delete(struct uvector *uvector, void *item)
+{
+    unsigned int mask = uvector->allocated - 1;
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < uvector->size; i++) {
+        void *cur = uvector->items[(uvector->first + i) & mask];
+        if (cur != item)
+            uvector->items[(uvector->first + j++) & mask] = cur;
+    }
+    bool found = j != uvector->size;
+    uvector->size = j;
+    return found;
+}
+
+/** @This walks through a vector.
+ *
+ * @param UVECTOR pointer to a uvector structure
+ * @param INDEX unsigned int variable iterating on the indexes
+ * @param ITEM pointer variable filled with each element
+ */
+#define uvector_foreach(UVECTOR, INDEX, ITEM)                               \
+    for (INDEX = 0; INDEX < (UVECTOR)->size &&                              \
+                    ((ITEM) = uvector_at(UVECTOR, INDEX), true); INDEX++)
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe helper macros for embedded uvector.
+ */
+
+#ifndef _UPIPE_UVECTOR_HELPER_H_
+/** @hidden */
+#define _UPIPE_UVECTOR_HELPER_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "upipe/uvector.h"
+
+/** @This declares functions dealing with an embedded uvector of a
+ * structure.
+ *
+ * @param STRUCTURE name of the structure containing the vector
+ * @param UVECTOR name of the embedded vector in the structure
+ * @param SUBSTRUCTURE name of the item structure
+ */
+#define UVECTOR_HELPER(STRUCTURE, UVECTOR, SUBSTRUCTURE)                    \
+/** @This initializes the embedded vector.                                  \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ */                                                                         \
+static UBASE_UNUSED inline void                                             \
+STRUCTURE##_init_##UVECTOR(struct STRUCTURE *s)                             \
+{                                                                           \
+    uvector_init(&s->UVECTOR);                                              \
+}                                                                           \
+                                                                            \
+/** @This cleans the embedded vector. The items are not released.          \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ */                                                                         \
+static UBASE_UNUSED inline void                                             \
+STRUCTURE##_clean_##UVECTOR(struct STRUCTURE *s)                            \
+{                                                                           \
+    uvector_clean(&s->UVECTOR);                                             \
+}                                                                           \
+                                                                            \
+/** @This returns the number of items in the embedded vector.               \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ * @return number of items                                                  \
+ */                                                                         \
+static UBASE_UNUSED inline unsigned int                                     \
+STRUCTURE##_size_##UVECTOR(struct STRUCTURE *s)                             \
+{                                                                           \
+    return uvector_size(&s->UVECTOR);                                       \
+}                                                                           \
+                                                                            \
+/** @This adds an item at the end of the embedded vector.                   \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ * @param i pointer to the item structure                                   \
+ * @return an error code                                                    \
+ */                                                                         \
+static UBASE_UNUSED inline int                                              \
+STRUCTURE##_add_##UVECTOR(struct STRUCTURE *s, struct SUBSTRUCTURE *i)      \
+{                                                                           \
+    return uvector_add(&s->UVECTOR, i) ? UBASE_ERR_NONE : UBASE_ERR_ALLOC;  \
+}                                                                           \
+                                                                            \
+/** @This removes an item from the embedded vector.                         \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ * @param i pointer to the item structure                                   \
+ * @return true if the item was found                                       \
+ */                                                                         \
+static UBASE_UNUSED inline bool                                             \
+STRUCTURE##_delete_##UVECTOR(struct STRUCTURE *s, struct SUBSTRUCTURE *i)   \
+{                                                                           \
+    return uvector_delete(&s->UVECTOR, i);                                  \
+}                                                                           \
+                                                                            \
+/** @This returns an item of the embedded vector.                           \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ * @param index index of the item                                           \
+ * @return pointer to the item structure                                    \
+ */                                                                         \
+static UBASE_UNUSED inline struct SUBSTRUCTURE *                            \
+STRUCTURE##_at_##UVECTOR(struct STRUCTURE *s, unsigned int index)           \
+{                                                                           \
+    return (struct SUBSTRUCTURE *)uvector_at(&s->UVECTOR, index);           \
+}                                                                           \
+                                                                            \
+/** @This peeks from the embedded vector.                                   \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ * @return the first item of the embedded vector (without removing it)      \
+ */                                                                         \
+static UBASE_UNUSED inline struct SUBSTRUCTURE *                            \
+STRUCTURE##_peek_##UVECTOR(struct STRUCTURE *s)                             \
+{                                                                           \
+    return (struct SUBSTRUCTURE *)uvector_peek(&s->UVECTOR);                \
+}                                                                           \
+                                                                            \
+/** @This pops from the embedded vector.                                    \
+ *                                                                          \
+ * @param s pointer to the structure containing the vector                  \
+ * @return the first item of the embedded vector (and remove it)            \
+ */                                                                         \
+static UBASE_UNUSED inline struct SUBSTRUCTURE *                            \
+STRUCTURE##_pop_##UVECTOR(struct STRUCTURE *s)                              \
+{                                                                           \
+    return (struct SUBSTRUCTURE *)uvector_pop(&s->UVECTOR);                 \
+}
+
+/** @This is an helper to iterate the items of an embedded vector,
+ * prefetching the next item while the current one is processed.
+ * The macro UVECTOR_HELPER must be defined. The index of the current item
+ * is available in the loop as uvector_idx.
+ *
+ * @param STRUCTURE name of the structure containing the vector
+ * @param UVECTOR name of the embedded vector in the structure
+ * @param s pointer to the structure containing the vector
+ * @param item pointer iterating the items
+ */
+#define uvector_helper_foreach(STRUCTURE, UVECTOR, s, item)                 \
+    for (unsigned int uvector_idx = 0;                                      \
+         uvector_idx < STRUCTURE##_size_##UVECTOR(s) &&                     \
+         (uvector_prefetch(&(s)->UVECTOR, uvector_idx + 1),                 \
+          (item = STRUCTURE##_at_##UVECTOR(s, uvector_idx)), true);         \
+         uvector_idx++)
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -34,6 +34,7 @@
 #include "upipe/upump.h"
 
 #include <srt/srt.h>
+#include <limits.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -51,6 +52,14 @@ enum upump_srt_type {
     UPUMP_SRT_TYPE_WRITE,
 };
 
+/** @This extends upump_mgr_command with specific commands for upump_srt. */
+enum upump_srt_mgr_command {
+    UPUMP_SRT_MGR_SENTINEL = UPUMP_MGR_CONTROL_LOCAL,
+
+    /** returns the number of started srt socket pumps (unsigned int *) */
+    UPUMP_SRT_MGR_GET_LOAD,
+};
+
 /** @This allocates and initializes a upump_mgr structure.
  *
  * @param upump_pool_depth maximum number of upump structures in the pool
@@ -61,6 +70,46 @@ enum upump_srt_type {
 struct upump_mgr *upump_srt_mgr_alloc(uint16_t upump_pool_depth,
                                       uint16_t upump_blocker_pool_depth);
 
+/** @This returns the number of started pumps watching srt sockets on an
+ * event loop. Contrary to other commands, this may be called from any
+ * thread.
+ *
+ * @param mgr management structure for this event loop
+ * @param load_p filled in with the number of started srt socket pumps
+ * @return an error code
+ */
+static inline int upump_srt_mgr_get_load(struct upump_mgr *mgr,
+                                         unsigned int *load_p)
+{
+    return upump_mgr_control(mgr, UPUMP_SRT_MGR_GET_LOAD,
+                             UPUMP_SRT_SIGNATURE, load_p);
+}
+
+/** @This returns the least loaded of a pool of event loops, typically each
+ * running in its own thread, so that new srt sessions may be spread across
+ * them.
+ *
+ * @param mgrs array of management structures
+ * @param nb number of management structures in the array
+ * @return management structure of the least loaded event loop
+ */
+static inline struct upump_mgr *upump_srt_mgr_pick(struct upump_mgr **mgrs,
+                                                   unsigned int nb)
+{
+    struct upump_mgr *best = NULL;
+    unsigned int best_load = UINT_MAX;
+    for (unsigned int i = 0; i < nb; i++) {
+        unsigned int load;
+        if (!ubase_check(upump_srt_mgr_get_load(mgrs[i], &load)))
+            continue;
+        if (best == NULL || load < best_load) {
+            best = mgrs[i];
+            best_load = load;
+        }
+    }
+    return best;
+}
+
 /** @This allocates and initializes a pump for a readable srt socket.
  *
  * @param mgr management structure for this event loop
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short declarations for a Upipe event loop using io_uring
+ *
+ * Besides the standard pump types, which are implemented with poll and
+ * timeout requests, this event loop provides pumps submitting read, write
+ * and recvmsg requests directly. Such a pump submits its request when it is
+ * started, and calls its callback once the request has completed, with the
+ * result available from @ref upump_uring_get_result. It then stays idle until
+ * it is restarted with @ref upump_restart, possibly after changing its
+ * buffer with @ref upump_uring_set_buffer. Requests queued during a loop
+ * iteration are submitted together when the loop waits for events.
+ */
+
+#ifndef _UPUMP_URING_UPUMP_URING_H_
+/** @hidden */
+#define _UPUMP_URING_UPUMP_URING_H_
+
+#include "upipe/upump.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPUMP_URING_SIGNATURE UBASE_FOURCC('u','r','n','g')
+
+/** @This extends upump_type with specific types for upump_uring. */
+enum upump_uring_type {
+    UPUMP_URING_TYPE_SENTINEL = UPUMP_TYPE_LOCAL,
+
+    /** event triggers when a read completes (int, void *, size_t, int64_t) */
+    UPUMP_URING_TYPE_READ,
+    /** event triggers when a write completes
+     * (int, const void *, size_t, int64_t) */
+    UPUMP_URING_TYPE_WRITE,
+    /** event triggers when a recvmsg completes (int, struct msghdr *, int) */
+    UPUMP_URING_TYPE_RECVMSG,
+};
+
+/** @This extends upump_command with specific commands for upump_uring. */
+enum upump_uring_command {
+    UPUMP_URING_SENTINEL = UPUMP_CONTROL_LOCAL,
+
+    /** returns the result of the last request (ssize_t *) */
+    UPUMP_URING_GET_RESULT,
+    /** sets the buffer of the next request (void *, size_t, int64_t) */
+    UPUMP_URING_SET_BUFFER,
+};
+
+/** @This allocates and initializes a upump_mgr structure.
+ *
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure
+ */
+struct upump_mgr *upump_uring_mgr_alloc(uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth);
+
+/** @This allocates and initializes a pump reading from a file descriptor.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when the read completes
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param fd file descriptor to read from
+ * @param buffer buffer to read into
+ * @param size size of the buffer
+ * @param offset offset in the file, or -1 to use the file position
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static inline struct upump *upump_uring_alloc_read(struct upump_mgr *mgr,
+                                                   upump_cb cb, void *opaque,
+                                                   struct urefcount *refcount,
+                                                   int fd, void *buffer,
+                                                   size_t size, int64_t offset)
+{
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_URING_TYPE_READ,
+                       UPUMP_URING_SIGNATURE, fd, buffer, size, offset);
+}
+
+/** @This allocates and initializes a pump writing to a file descriptor.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when the write completes
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param fd file descriptor to write to
+ * @param buffer buffer to write
+ * @param size size of the buffer
+ * @param offset offset in the file, or -1 to use the file position
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static inline struct upump *upump_uring_alloc_write(struct upump_mgr *mgr,
+                                                    upump_cb cb, void *opaque,
+                                                    struct urefcount *refcount,
+                                                    int fd, const void *buffer,
+                                                    size_t size, int64_t offset)
+{
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_URING_TYPE_WRITE,
+                       UPUMP_URING_SIGNATURE, fd, buffer, size, offset);
+}
+
+/** @This allocates and initializes a pump receiving a message from a socket.
+ *
+ * @param mgr management structure for this event loop
+ * @param cb function to call when a message is received
+ * @param opaque pointer to the module's internal structure
+ * @param refcount pointer to urefcount structure to increment during callback,
+ * or NULL
+ * @param fd socket to receive from
+ * @param msghdr message header, which must stay valid while the pump is
+ * started
+ * @param flags flags of recvmsg
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static inline struct upump *
+    upump_uring_alloc_recvmsg(struct upump_mgr *mgr,
+                              upump_cb cb, void *opaque,
+                              struct urefcount *refcount,
+                              int fd, struct msghdr *msghdr, int flags)
+{
+    return upump_alloc(mgr, cb, opaque, refcount, UPUMP_URING_TYPE_RECVMSG,
+                       UPUMP_URING_SIGNATURE, fd, msghdr, flags);
+}
+
+/** @This returns the result of the last request of a pump, that is the
+ * number of octets transferred, or a negative errno value.
+ *
+ * @param upump description structure of the pump
+ * @param result_p filled in with the result
+ * @return an error code
+ */
+static inline int upump_uring_get_result(struct upump *upump,
+                                         ssize_t *result_p)
+{
+    return upump_control(upump, UPUMP_URING_GET_RESULT,
+                         UPUMP_URING_SIGNATURE, result_p);
+}
+
+/** @This sets the buffer of the next read or write request of a pump. It
+ * takes effect on the next start or restart.
+ *
+ * @param upump description structure of the pump
+ * @param buffer buffer to read into or write
+ * @param size size of the buffer
+ * @param offset offset in the file, or -1 to use the file position
+ * @return an error code
+ */
+static inline int upump_uring_set_buffer(struct upump *upump, void *buffer,
+                                         size_t size, int64_t offset)
+{
+    return upump_control(upump, UPUMP_URING_SET_BUFFER,
+                         UPUMP_URING_SIGNATURE, buffer, size, offset);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
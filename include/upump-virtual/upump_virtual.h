@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short declarations for a Upipe event loop running on virtual time
+ *
+ * This event loop never sleeps: whenever no file descriptor is ready and no
+ * idler is started, the virtual clock jumps straight to the deadline of the
+ * next timer. Pipelines paced on the clock returned by
+ * @ref upump_virtual_mgr_get_uclock, for instance when replaying a capture
+ * stamped with cr_sys dates, therefore run as fast as the CPU allows while
+ * seeing exactly the same sequence of events from one run to the next.
+ *
+ * Signal watchers are not supported. The manager is meant to be used by a
+ * single thread; file descriptors written by other threads are still
+ * watched, but virtual time does not advance while waiting for them.
+ */
+
+#ifndef _UPUMP_VIRTUAL_UPUMP_VIRTUAL_H_
+/** @hidden */
+#define _UPUMP_VIRTUAL_UPUMP_VIRTUAL_H_
+
+#include "upipe/upump.h"
+#include "upipe/uclock.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UPUMP_VIRTUAL_SIGNATURE UBASE_FOURCC('v','i','r','t')
+
+/** @This extends upump_mgr_command with specific commands for
+ * upump_virtual. */
+enum upump_virtual_mgr_command {
+    UPUMP_VIRTUAL_MGR_SENTINEL = UPUMP_MGR_CONTROL_LOCAL,
+
+    /** returns the virtual clock of the event loop (struct uclock **) */
+    UPUMP_VIRTUAL_MGR_GET_UCLOCK,
+    /** returns the current virtual time (uint64_t *) */
+    UPUMP_VIRTUAL_MGR_GET_TIME,
+    /** sets the current virtual time (uint64_t) */
+    UPUMP_VIRTUAL_MGR_SET_TIME,
+};
+
+/** @This allocates and initializes a upump_mgr structure running on virtual
+ * time.
+ *
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param now initial virtual time, in 27 MHz ticks
+ * @return pointer to the wrapped upump_mgr structure
+ */
+struct upump_mgr *upump_virtual_mgr_alloc(uint16_t upump_pool_depth,
+                                          uint16_t upump_blocker_pool_depth,
+                                          uint64_t now);
+
+/** @This returns the virtual clock of the event loop. The clock shares the
+ * refcount of the manager; the caller must use @ref uclock_use to keep it.
+ *
+ * @param mgr management structure for this event loop
+ * @param uclock_p filled in with a pointer to the virtual clock
+ * @return an error code
+ */
+static inline int upump_virtual_mgr_get_uclock(struct upump_mgr *mgr,
+                                               struct uclock **uclock_p)
+{
+    return upump_mgr_control(mgr, UPUMP_VIRTUAL_MGR_GET_UCLOCK,
+                             UPUMP_VIRTUAL_SIGNATURE, uclock_p);
+}
+
+/** @This returns the current virtual time of the event loop.
+ *
+ * @param mgr management structure for this event loop
+ * @param now_p filled in with the current virtual time, in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upump_virtual_mgr_get_time(struct upump_mgr *mgr,
+                                             uint64_t *now_p)
+{
+    return upump_mgr_control(mgr, UPUMP_VIRTUAL_MGR_GET_TIME,
+                             UPUMP_VIRTUAL_SIGNATURE, now_p);
+}
+
+/** @This sets the current virtual time of the event loop, typically to the
+ * first date of a capture before replaying it. Virtual time cannot go
+ * backwards; deadlines of started timers are kept as they are.
+ *
+ * @param mgr management structure for this event loop
+ * @param now new virtual time, in 27 MHz ticks
+ * @return an error code
+ */
+static inline int upump_virtual_mgr_set_time(struct upump_mgr *mgr,
+                                             uint64_t now)
+{
+    return upump_mgr_control(mgr, UPUMP_VIRTUAL_MGR_SET_TIME,
+                             UPUMP_VIRTUAL_SIGNATURE, now);
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif
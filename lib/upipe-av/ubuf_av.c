@@ -484,6 +484,54 @@ static int ubuf_pic_av_resize(struct ubuf *ubuf, int hskip, int vskip,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This splits an interlaced picture in its two fields, as views
+ * of the same frame buffers with a doubled line size.
+ *
+ * @param ubuf pointer to buffer
+ * @param odd_p filled with the odd field
+ * @param even_p filled with the even field
+ * @return an error code
+ */
+static int ubuf_pic_av_split_fields(struct ubuf *ubuf, struct ubuf **odd_p,
+                                    struct ubuf **even_p)
+{
+    struct ubuf_av *ubuf_av = ubuf_av_from_ubuf(ubuf);
+    struct ubuf_pic_av *ubuf_pic_av = ubuf_av_to_ubuf_pic_av(ubuf_av);
+
+    if (unlikely(!ubuf_pic_av))
+        return UBASE_ERR_INVALID;
+
+    const AVFrame *frame = ubuf_av->frame;
+    if (frame->hw_frames_ctx)
+        return UBASE_ERR_UNHANDLED;
+    if (frame->height % 2 || frame->crop_top % 2 || frame->crop_bottom % 2)
+        return UBASE_ERR_INVALID;
+
+    struct ubuf *fields[2] = { NULL, NULL };
+    for (int i = 0; i < 2; i++) {
+        int err = ubuf_av_dup(ubuf, &fields[i]);
+        if (unlikely(!ubase_check(err))) {
+            ubuf_free(fields[0]);
+            return err;
+        }
+
+        AVFrame *field = ubuf_av_from_ubuf(fields[i])->frame;
+        for (uint8_t plane = 0;
+             plane < ubuf_pic_av->flow_format->nb_planes; plane++) {
+            if (i)
+                field->data[plane] += field->linesize[plane];
+            field->linesize[plane] *= 2;
+        }
+        field->height /= 2;
+        field->crop_top /= 2;
+        field->crop_bottom /= 2;
+    }
+
+    *even_p = fields[0];
+    *odd_p = fields[1];
+    return UBASE_ERR_NONE;
+}
+
 static int ubuf_av_ref(struct ubuf *ubuf, AVBufferRef *av_ref)
 {
     struct ubuf_av *ubuf_av = ubuf_av_from_ubuf(ubuf);
@@ -900,6 +948,12 @@ static int ubuf_av_control(struct ubuf *ubuf, int command, va_list args)
             int vsize = va_arg(args, int);
             return ubuf_pic_av_resize(ubuf, hskip, vskip, hsize, vsize);
         }
+        case UBUF_PICTURE_SPLIT_FIELDS: {
+            va_arg(args, struct ubuf *);
+            struct ubuf **odd_p = va_arg(args, struct ubuf **);
+            struct ubuf **even_p = va_arg(args, struct ubuf **);
+            return ubuf_pic_av_split_fields(ubuf, odd_p, even_p);
+        }
 
         case UBUF_SIZE_SOUND: {
             size_t *size_p = va_arg(args, size_t *);
@@ -30,6 +30,7 @@
 
 #include "upipe/uclock.h"
 #include "upipe/ubuf.h"
+#include "upipe/ufifo.h"
 #include "upipe/uref.h"
 #include "upipe/uref_pic.h"
 #include "upipe/uref_flow.h"
@@ -74,6 +75,10 @@
 #include <bitstream/dvb/sub.h>
 
 #define EXPECTED_FLOW_DEF "block."
+/** maximum number of picture buffers kept for direct rendering */
+#define UPIPE_AVCDEC_POOL_DEPTH 16
+/** uref private value of pictures allocated for direct rendering */
+#define UPIPE_AVCDEC_PRIV_DR1 UBASE_FOURCC('d','r','1',' ')
 
 /** @hidden */
 static int upipe_avcdec_check(struct upipe *upipe, struct uref *flow_format);
@@ -114,6 +119,10 @@ struct upipe_avcdec {
     struct uref *flow_format;
     /** ubuf manager request */
     struct urequest ubuf_mgr_request;
+    /** picture buffers released by avcodec, to be recycled */
+    struct ufifo pool;
+    /** extra data for the pool */
+    uint8_t *pool_extra;
 
     /** upump mgr */
     struct upump_mgr *upump_mgr;
@@ -241,14 +250,83 @@ static void upipe_av_uref_pic_free(void *opaque, uint8_t *data);
  * Does not need to be reentrant.
  */
 
+/** @internal @This is called by avcodec when it no longer uses a picture.
+ * Pictures allocated for direct rendering keep their buffer in the pool, so
+ * that it is recycled once the downstream pipes have released it.
+ *
+ * @param opaque description structure of the pipe
+ * @param data uref describing the picture
+ */
 static void buffer_uref_free(void *opaque, uint8_t *data)
 {
+    struct upipe *upipe = opaque;
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
     struct uref *uref = (struct uref *)data;
     struct uref *flow_def_attr = uref_from_uchain(uref->uchain.next);
     uref_free(flow_def_attr);
+    if (uref->priv == UPIPE_AVCDEC_PRIV_DR1 && uref->ubuf != NULL &&
+        ufifo_push(&upipe_avcdec->pool, uref->ubuf))
+        uref->ubuf = NULL;
     uref_free(uref);
 }
 
+/** @internal @This allocates a picture buffer for direct rendering, reusing
+ * a buffer from the pool if one is no longer used downstream. Only new
+ * buffers are cleared, recycled ones hold a previously decoded picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param hsize horizontal size in pixels
+ * @param vsize vertical size in lines
+ * @param chroma chroma of the first plane
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *upipe_avcdec_pool_alloc(struct upipe *upipe,
+                                            size_t hsize, size_t vsize,
+                                            const char *chroma)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    struct ubuf *ubuf;
+
+    for (unsigned i = 0; i < UPIPE_AVCDEC_POOL_DEPTH &&
+         (ubuf = ufifo_pop(&upipe_avcdec->pool, struct ubuf *)) != NULL; i++) {
+        size_t ubuf_hsize, ubuf_vsize;
+        uint8_t *buffer;
+        if (ubuf->mgr != upipe_avcdec->ubuf_mgr ||
+            !ubase_check(ubuf_pic_size(ubuf, &ubuf_hsize, &ubuf_vsize,
+                                       NULL)) ||
+            ubuf_hsize != hsize || ubuf_vsize != vsize) {
+            /* allocated for a previous format */
+            ubuf_free(ubuf);
+            continue;
+        }
+        if (ubase_check(ubuf_pic_plane_write(ubuf, chroma, 0, 0, -1, -1,
+                                             &buffer))) {
+            ubuf_pic_plane_unmap(ubuf, chroma, 0, 0, -1, -1);
+            return ubuf;
+        }
+        /* still in use downstream */
+        if (!ufifo_push(&upipe_avcdec->pool, ubuf))
+            ubuf_free(ubuf);
+    }
+
+    ubuf = ubuf_pic_alloc(upipe_avcdec->ubuf_mgr, hsize, vsize);
+    if (likely(ubuf != NULL))
+        ubuf_pic_clear(ubuf, 0, 0, -1, -1, 0);
+    return ubuf;
+}
+
+/** @internal @This frees the picture buffers kept in the pool.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcdec_pool_clean(struct upipe *upipe)
+{
+    struct upipe_avcdec *upipe_avcdec = upipe_avcdec_from_upipe(upipe);
+    struct ubuf *ubuf;
+    while ((ubuf = ufifo_pop(&upipe_avcdec->pool, struct ubuf *)) != NULL)
+        ubuf_free(ubuf);
+}
+
 /** @internal @This is called by avcodec when allocating a new picture.
  *
  * @param context current avcodec context
@@ -274,8 +352,9 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return -1;
         }
+        uref->priv = UINT64_MAX;
         frame->opaque_ref = av_buffer_create((uint8_t *)uref, sizeof (*uref),
-                                             buffer_uref_free, NULL, 0);
+                                             buffer_uref_free, upipe, 0);
         if (frame->opaque_ref == NULL) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             uref_free(uref);
@@ -346,8 +425,12 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
         return -1;
     }
 
-    if (frame->format == AV_PIX_FMT_VAAPI)
-        uref_pic_flow_set_surface_type(flow_def_attr, "av.vaapi");
+    /* hardware frames are output as is, to stay in device memory */
+    const char *surface_type =
+        upipe_av_hw_pixfmt_to_surface_type(frame->format);
+    if (surface_type != NULL)
+        UBASE_FATAL(upipe, uref_pic_flow_set_surface_type(flow_def_attr,
+                                                          surface_type))
 
     UBASE_FATAL(upipe, uref_pic_flow_set_align(flow_def_attr, align))
     UBASE_FATAL(upipe, uref_pic_flow_set_hsize(flow_def_attr, context->width))
@@ -426,14 +509,17 @@ static int upipe_avcdec_get_buffer_pic(struct AVCodecContext *context,
             goto error;
         }
     } else {
-        ubuf = ubuf_pic_alloc(upipe_avcdec->ubuf_mgr,
-                              width_aligned, height_aligned);
+        const char *chroma;
+        if (unlikely(!ubase_check(uref_pic_flow_get_chroma(flow_def_attr,
+                                                           &chroma, 0))))
+            goto error;
+        ubuf = upipe_avcdec_pool_alloc(upipe, width_aligned, height_aligned,
+                                       chroma);
         if (unlikely(ubuf == NULL)) {
             upipe_err_va(upipe, "cannot alloc ubuf");
             goto error;
         }
-
-        ubuf_pic_clear(ubuf, 0, 0, -1, -1, 0);
+        uref->priv = UPIPE_AVCDEC_PRIV_DR1;
     }
     uref_attach_ubuf(uref, ubuf);
 
@@ -1113,6 +1199,7 @@ static void upipe_avcdec_output_pic(struct upipe *upipe, struct upump **upump_p)
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
     }
+    uref->priv = UINT64_MAX;
 
     /* Resize the picture (was allocated too big). */
     if (unlikely(!ubase_check(uref_pic_resize(uref, 0, 0, frame->width, frame->height)))) {
@@ -1695,6 +1782,9 @@ static void upipe_avcdec_free(struct upipe *upipe)
     av_packet_free(&upipe_avcdec->avpkt);
     av_buffer_unref(&upipe_avcdec->hw_device_ctx);
     free(upipe_avcdec->hw_device);
+    upipe_avcdec_pool_clean(upipe);
+    ufifo_clean(&upipe_avcdec->pool);
+    free(upipe_avcdec->pool_extra);
 
     upipe_throw_dead(upipe);
     uref_free(upipe_avcdec->uref);
@@ -1734,10 +1824,18 @@ static struct upipe *upipe_avcdec_alloc(struct upipe_mgr *mgr,
         return NULL;
     }
 
+    uint8_t *pool_extra = malloc(ufifo_sizeof(UPIPE_AVCDEC_POOL_DEPTH));
+    if (unlikely(pool_extra == NULL)) {
+        av_frame_free(&frame);
+        av_packet_free(&avpkt);
+        return NULL;
+    }
+
     struct upipe *upipe = upipe_avcdec_alloc_void(mgr, uprobe, signature, args);
     if (unlikely(upipe == NULL)) {
         av_frame_free(&frame);
         av_packet_free(&avpkt);
+        free(pool_extra);
         return NULL;
     }
     upipe_avcdec_init_urefcount(upipe);
@@ -1757,6 +1855,8 @@ static struct upipe *upipe_avcdec_alloc(struct upipe_mgr *mgr,
     upipe_avcdec->context = NULL;
     upipe_avcdec->frame = frame;
     upipe_avcdec->avpkt = avpkt;
+    upipe_avcdec->pool_extra = pool_extra;
+    ufifo_init(&upipe_avcdec->pool, UPIPE_AVCDEC_POOL_DEPTH, pool_extra);
     upipe_avcdec->counter = 0;
     upipe_avcdec->close = false;
     upipe_avcdec->pix_fmt = AV_PIX_FMT_NONE;
@@ -30,6 +30,7 @@
  */
 
 #include "upipe/uclock.h"
+#include "upipe/ueventfd.h"
 #include "upipe/ubuf.h"
 #include "upipe/ubuf_block.h"
 #include "upipe/uref.h"
@@ -67,6 +68,7 @@
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include <libavcodec/avcodec.h>
 #include <libavutil/avutil.h>
@@ -85,6 +87,18 @@ UREF_ATTR_INT(avcenc, priv, "x.avcenc_priv", avcenc private pts)
 /** start offset of avcodec PTS */
 #define AVCPTS_INIT 1
 
+/** @internal @This is a frame or a packet exchanged with the encoder thread. */
+struct upipe_avcenc_job {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** frame to encode, or NULL to flush the encoder */
+    AVFrame *frame;
+    /** encoded packet */
+    AVPacket *avpkt;
+};
+
+UBASE_FROM_TO(upipe_avcenc_job, uchain, uchain, uchain)
+
 /** @hidden */
 static int upipe_avcenc_check_ubuf_mgr(struct upipe *upipe,
                                        struct uref *flow_format);
@@ -104,6 +118,9 @@ static bool upipe_avcenc_handle(struct upipe *upipe, struct uref *uref,
 /** @hidden */
 static int upipe_avcenc_set_option(struct upipe *upipe,
                                    const char *option, const char *content);
+/** @hidden */
+static void upipe_avcenc_wait_async(struct upipe *upipe,
+                                    struct upump **upump_p);
 
 /** upipe_avcenc structure with avcenc parameters */
 struct upipe_avcenc {
@@ -177,6 +194,10 @@ struct upipe_avcenc {
 
     /** true if the existing slice types must be enforced */
     bool slice_type_enforce;
+    /** pending target octetrate, applied on the next keyframe (or 0) */
+    uint64_t rate_octetrate;
+    /** pending buffer size, applied on the next keyframe (or 0) */
+    uint64_t rate_bs;
     /** uref serving as a dictionary for options */
     struct uref *options;
 
@@ -193,6 +214,36 @@ struct upipe_avcenc {
     /** true if the pipe need to be released after output_input */
     bool release_needed;
 
+    /** maximum number of frames waiting for the encoder thread, or 0 for
+     * synchronous encoding */
+    unsigned int async_depth;
+    /** encoder thread */
+    pthread_t thread;
+    /** protects the following fields, shared with the encoder thread */
+    pthread_mutex_t mutex;
+    /** signals the encoder thread, or the end of a job */
+    pthread_cond_t cond;
+    /** frames to encode */
+    struct uchain async_frames;
+    /** number of frames to encode */
+    unsigned int async_nb;
+    /** encoded packets */
+    struct uchain async_pkts;
+    /** true while the encoder thread is encoding a frame */
+    bool async_busy;
+    /** true if the encoder thread must exit once idle */
+    bool async_quit;
+    /** last error of the encoder thread */
+    int async_error;
+    /** pending bit rate for the encoder thread (or 0) */
+    int64_t async_bit_rate;
+    /** pending buffer size for the encoder thread (or 0) */
+    int async_buffer_size;
+    /** triggered when a job is complete */
+    struct ueventfd async_event;
+    /** watcher on the async event */
+    struct upump *upump_async;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -214,6 +265,7 @@ UPIPE_HELPER_UBUF_MGR(upipe_avcenc, ubuf_mgr, flow_format, ubuf_mgr_request,
                       upipe_avcenc_unregister_output_request)
 UPIPE_HELPER_UPUMP_MGR(upipe_avcenc, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_avcenc, upump_av_deal, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_avcenc, upump_async, upump_mgr)
 
 /** @This allows to convert from Upipe color space to avcenc color space. */
 struct upipe_avcenc_color {
@@ -265,6 +317,27 @@ static const char *
     return upipe_color;
 }
 
+/** @internal @This returns the hardware pixel format of the flow definition
+ * if the codec accepts it directly.
+ *
+ * @param codec avcodec encoder
+ * @param flow_def input flow definition
+ * @return the hardware pixel format or AV_PIX_FMT_NONE
+ */
+static enum AVPixelFormat
+    upipe_avcenc_hw_pixfmt_from_flow_def(const AVCodec *codec,
+                                         struct uref *flow_def)
+{
+    enum AVPixelFormat hw_pix_fmt = upipe_av_hw_pixfmt_from_flow_def(flow_def);
+    if (hw_pix_fmt == AV_PIX_FMT_NONE || codec->pix_fmts == NULL)
+        return AV_PIX_FMT_NONE;
+
+    for (int i = 0; codec->pix_fmts[i] != AV_PIX_FMT_NONE; i++)
+        if (codec->pix_fmts[i] == hw_pix_fmt)
+            return hw_pix_fmt;
+    return AV_PIX_FMT_NONE;
+}
+
 /** @hidden */
 static void upipe_avcenc_free(struct upipe *upipe);
 
@@ -441,6 +514,8 @@ static void upipe_avcenc_start_av_deal(struct upipe *upipe)
     struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
     /* abort a pending open request */
     upipe_avcenc_abort_av_deal(upipe);
+    /* the encoder thread must be done with the context */
+    upipe_avcenc_wait_async(upipe, NULL);
 
     /* use udeal/upump callback if available */
     upipe_avcenc_check_upump_mgr(upipe);
@@ -561,6 +636,51 @@ static void upipe_avcenc_build_flow_def(struct upipe *upipe)
     upipe_avcenc_store_flow_def(upipe, flow_def);
 }
 
+/** @internal @This checks if frames are encoded by the encoder thread.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if frames are encoded asynchronously
+ */
+static bool upipe_avcenc_is_async(struct upipe *upipe)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    return upipe_avcenc->async_depth && upipe_avcenc->context != NULL &&
+           upipe_avcenc->context->codec->type == AVMEDIA_TYPE_VIDEO;
+}
+
+/** @internal @This applies the pending octetrate and buffer size to the
+ * avcodec context.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcenc_apply_rate(struct upipe *upipe)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    AVCodecContext *context = upipe_avcenc->context;
+    int64_t bit_rate = upipe_avcenc->rate_octetrate * 8;
+    int buffer_size = upipe_avcenc->rate_bs * 8;
+    upipe_avcenc->rate_octetrate = upipe_avcenc->rate_bs = 0;
+
+    if (upipe_avcenc_is_async(upipe)) {
+        /* the context is in use by the encoder thread */
+        pthread_mutex_lock(&upipe_avcenc->mutex);
+        upipe_avcenc->async_bit_rate = bit_rate;
+        if (buffer_size)
+            upipe_avcenc->async_buffer_size = buffer_size;
+        pthread_mutex_unlock(&upipe_avcenc->mutex);
+        upipe_verbose_va(upipe, "setting rate to %"PRId64" bit/s", bit_rate);
+        return;
+    }
+
+    context->bit_rate = bit_rate;
+    context->rc_max_rate = context->bit_rate;
+    if (buffer_size)
+        context->rc_buffer_size = buffer_size;
+
+    upipe_verbose_va(upipe, "setting rate to %"PRId64" bit/s (VBV %d bit)",
+                     (int64_t)context->bit_rate, context->rc_buffer_size);
+}
+
 /** @internal @This outputs av packet.
  *
  * @param upipe description structure of the pipe
@@ -670,8 +790,11 @@ static void upipe_avcenc_output_pkt(struct upipe *upipe,
     upipe_avcenc->last_dts = dts;
     upipe_avcenc->last_dts_sys = dts_sys;
 
-    if (codec->type == AVMEDIA_TYPE_VIDEO && keyframe)
+    if (codec->type == AVMEDIA_TYPE_VIDEO && keyframe) {
         uref_flow_set_random(uref);
+        if (upipe_avcenc->rate_octetrate)
+            upipe_avcenc_apply_rate(upipe);
+    }
 
     if (upipe_avcenc->flow_def == NULL)
         upipe_avcenc_build_flow_def(upipe);
@@ -679,6 +802,328 @@ static void upipe_avcenc_output_pkt(struct upipe *upipe,
     upipe_avcenc_output(upipe, uref, upump_p);
 }
 
+/** @internal @This allocates a job for the encoder thread.
+ *
+ * @return pointer to the job, or NULL in case of allocation error
+ */
+static struct upipe_avcenc_job *upipe_avcenc_job_alloc(void)
+{
+    struct upipe_avcenc_job *job = malloc(sizeof(struct upipe_avcenc_job));
+    if (unlikely(job == NULL))
+        return NULL;
+    uchain_init(&job->uchain);
+    job->frame = NULL;
+    job->avpkt = NULL;
+    return job;
+}
+
+/** @internal @This frees a job of the encoder thread.
+ *
+ * @param job job to free
+ */
+static void upipe_avcenc_job_free(struct upipe_avcenc_job *job)
+{
+    av_frame_free(&job->frame);
+    av_packet_free(&job->avpkt);
+    free(job);
+}
+
+/** @internal @This is the encoder thread. It submits the queued frames to
+ * the codec and retrieves the encoded packets.
+ *
+ * @param arg pointer to the private structure of the pipe
+ * @return NULL
+ */
+static void *upipe_avcenc_thread(void *arg)
+{
+    struct upipe_avcenc *upipe_avcenc = arg;
+
+    pthread_mutex_lock(&upipe_avcenc->mutex);
+    for ( ; ; ) {
+        struct uchain *uchain = ulist_pop(&upipe_avcenc->async_frames);
+        if (uchain == NULL) {
+            if (upipe_avcenc->async_quit)
+                break;
+            pthread_cond_wait(&upipe_avcenc->cond, &upipe_avcenc->mutex);
+            continue;
+        }
+        upipe_avcenc->async_busy = true;
+        AVCodecContext *context = upipe_avcenc->context;
+        if (upipe_avcenc->async_bit_rate) {
+            context->bit_rate = upipe_avcenc->async_bit_rate;
+            context->rc_max_rate = context->bit_rate;
+            upipe_avcenc->async_bit_rate = 0;
+        }
+        if (upipe_avcenc->async_buffer_size) {
+            context->rc_buffer_size = upipe_avcenc->async_buffer_size;
+            upipe_avcenc->async_buffer_size = 0;
+        }
+        pthread_mutex_unlock(&upipe_avcenc->mutex);
+
+        struct upipe_avcenc_job *job = upipe_avcenc_job_from_uchain(uchain);
+        struct uchain pkts;
+        ulist_init(&pkts);
+        int err = avcodec_send_frame(context, job->frame);
+        upipe_avcenc_job_free(job);
+
+        while (err >= 0) {
+            struct upipe_avcenc_job *pkt = upipe_avcenc_job_alloc();
+            if (unlikely(pkt == NULL ||
+                         (pkt->avpkt = av_packet_alloc()) == NULL)) {
+                if (pkt != NULL)
+                    upipe_avcenc_job_free(pkt);
+                err = AVERROR(ENOMEM);
+                break;
+            }
+            err = avcodec_receive_packet(context, pkt->avpkt);
+            if (err < 0) {
+                upipe_avcenc_job_free(pkt);
+                if (err == AVERROR(EAGAIN) || err == AVERROR_EOF)
+                    err = 0;
+                break;
+            }
+            ulist_add(&pkts, &pkt->uchain);
+        }
+
+        pthread_mutex_lock(&upipe_avcenc->mutex);
+        while ((uchain = ulist_pop(&pkts)) != NULL)
+            ulist_add(&upipe_avcenc->async_pkts, uchain);
+        if (err < 0 && !upipe_avcenc->async_error)
+            upipe_avcenc->async_error = err;
+        upipe_avcenc->async_nb--;
+        upipe_avcenc->async_busy = false;
+        pthread_cond_broadcast(&upipe_avcenc->cond);
+        ueventfd_write(&upipe_avcenc->async_event);
+    }
+    pthread_mutex_unlock(&upipe_avcenc->mutex);
+    return NULL;
+}
+
+/** @internal @This outputs the packets encoded by the encoder thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to upump structure
+ */
+static void upipe_avcenc_collect_async(struct upipe *upipe,
+                                       struct upump **upump_p)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    struct uchain pkts;
+    ulist_init(&pkts);
+
+    pthread_mutex_lock(&upipe_avcenc->mutex);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&upipe_avcenc->async_pkts)) != NULL)
+        ulist_add(&pkts, uchain);
+    int err = upipe_avcenc->async_error;
+    upipe_avcenc->async_error = 0;
+    pthread_mutex_unlock(&upipe_avcenc->mutex);
+
+    if (unlikely(err < 0)) {
+        upipe_err_va(upipe, "encoder thread: %s", av_err2str(err));
+        upipe_throw_error(upipe, UBASE_ERR_EXTERNAL);
+    }
+
+    while ((uchain = ulist_pop(&pkts)) != NULL) {
+        struct upipe_avcenc_job *pkt = upipe_avcenc_job_from_uchain(uchain);
+        upipe_avcenc_output_pkt(upipe, pkt->avpkt, upump_p);
+        upipe_avcenc_job_free(pkt);
+    }
+}
+
+/** @internal @This waits for the encoder thread to encode all queued frames,
+ * and outputs the packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to upump structure
+ */
+static void upipe_avcenc_wait_async(struct upipe *upipe,
+                                    struct upump **upump_p)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (!upipe_avcenc->async_depth)
+        return;
+
+    pthread_mutex_lock(&upipe_avcenc->mutex);
+    while (upipe_avcenc->async_nb || upipe_avcenc->async_busy)
+        pthread_cond_wait(&upipe_avcenc->cond, &upipe_avcenc->mutex);
+    pthread_mutex_unlock(&upipe_avcenc->mutex);
+    ueventfd_read(&upipe_avcenc->async_event);
+
+    upipe_avcenc_collect_async(upipe, upump_p);
+}
+
+/** @internal @This outputs the urefs held while the encoder thread was
+ * busy.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcenc_resume_async(struct upipe *upipe)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (upipe_avcenc_check_input(upipe) ||
+        !upipe_avcenc_output_input(upipe))
+        return;
+
+    upipe_avcenc_unblock_input(upipe);
+    /* All packets have been output, release again the pipe that has been
+     * used in @ref upipe_avcenc_input. */
+    if (upipe_avcenc->release_needed) {
+        upipe_avcenc->release_needed = false;
+        upipe_release(upipe);
+    }
+}
+
+/** @internal @This is called when the encoder thread completes a job.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_avcenc_watcher_async(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    ueventfd_read(&upipe_avcenc->async_event);
+    upipe_avcenc_collect_async(upipe, &upipe_avcenc->upump_async);
+    upipe_avcenc_resume_async(upipe);
+}
+
+/** @internal @This allocates the watcher retrieving the packets encoded by
+ * the encoder thread, if an upump manager is available.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcenc_poll_async(struct upipe *upipe)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (!upipe_avcenc->async_depth || upipe_avcenc->upump_async != NULL ||
+        !ubase_check(upipe_avcenc_check_upump_mgr(upipe)))
+        return;
+
+    struct upump *upump = ueventfd_upump_alloc(&upipe_avcenc->async_event,
+            upipe_avcenc->upump_mgr, upipe_avcenc_watcher_async, upipe,
+            upipe->refcount);
+    if (unlikely(upump == NULL)) {
+        upipe_err(upipe, "can't create watcher");
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        return;
+    }
+    upipe_avcenc_set_upump_async(upipe, upump);
+    upump_start(upump);
+}
+
+/** @internal @This queues a frame for the encoder thread. The frame
+ * references are moved to the queued frame.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame frame, or NULL to flush the encoder
+ * @param upump_p reference to upump structure
+ * @return an error code
+ */
+static int upipe_avcenc_push_async(struct upipe *upipe, AVFrame *frame,
+                                   struct upump **upump_p)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    struct upipe_avcenc_job *job = upipe_avcenc_job_alloc();
+    UBASE_ALLOC_RETURN(job)
+    if (frame != NULL) {
+        job->frame = av_frame_alloc();
+        if (unlikely(job->frame == NULL)) {
+            upipe_avcenc_job_free(job);
+            return UBASE_ERR_ALLOC;
+        }
+        av_frame_move_ref(job->frame, frame);
+    }
+
+    upipe_avcenc_poll_async(upipe);
+
+    pthread_mutex_lock(&upipe_avcenc->mutex);
+    ulist_add(&upipe_avcenc->async_frames, &job->uchain);
+    upipe_avcenc->async_nb++;
+    pthread_cond_broadcast(&upipe_avcenc->cond);
+    pthread_mutex_unlock(&upipe_avcenc->mutex);
+
+    if (frame == NULL || upipe_avcenc->upump_async == NULL)
+        /* no event loop to retrieve the packets */
+        upipe_avcenc_wait_async(upipe, upump_p);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This checks if another frame may be queued for the encoder
+ * thread.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if the input must be blocked
+ */
+static bool upipe_avcenc_check_async(struct upipe *upipe)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (!upipe_avcenc_is_async(upipe))
+        return true;
+
+    pthread_mutex_lock(&upipe_avcenc->mutex);
+    bool ret = upipe_avcenc->async_nb < upipe_avcenc->async_depth;
+    pthread_mutex_unlock(&upipe_avcenc->mutex);
+    return ret;
+}
+
+/** @internal @This starts the encoder thread.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_avcenc_start_async(struct upipe *upipe)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (unlikely(!ueventfd_init(&upipe_avcenc->async_event, false)))
+        return UBASE_ERR_EXTERNAL;
+    pthread_mutex_init(&upipe_avcenc->mutex, NULL);
+    pthread_cond_init(&upipe_avcenc->cond, NULL);
+    ulist_init(&upipe_avcenc->async_frames);
+    ulist_init(&upipe_avcenc->async_pkts);
+    upipe_avcenc->async_nb = 0;
+    upipe_avcenc->async_busy = false;
+    upipe_avcenc->async_quit = false;
+    upipe_avcenc->async_error = 0;
+    upipe_avcenc->async_bit_rate = 0;
+    upipe_avcenc->async_buffer_size = 0;
+
+    if (unlikely(pthread_create(&upipe_avcenc->thread, NULL,
+                                upipe_avcenc_thread, upipe_avcenc) != 0)) {
+        upipe_err(upipe, "can't create encoder thread");
+        pthread_cond_destroy(&upipe_avcenc->cond);
+        pthread_mutex_destroy(&upipe_avcenc->mutex);
+        ueventfd_clean(&upipe_avcenc->async_event);
+        upipe_avcenc->async_depth = 0;
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This waits for the encoder thread to encode all queued frames
+ * and stops it.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcenc_stop_async(struct upipe *upipe)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (!upipe_avcenc->async_depth)
+        return;
+
+    upipe_avcenc_wait_async(upipe, NULL);
+    upipe_avcenc_set_upump_async(upipe, NULL);
+    pthread_mutex_lock(&upipe_avcenc->mutex);
+    upipe_avcenc->async_quit = true;
+    pthread_cond_broadcast(&upipe_avcenc->cond);
+    pthread_mutex_unlock(&upipe_avcenc->mutex);
+    pthread_join(upipe_avcenc->thread, NULL);
+
+    pthread_cond_destroy(&upipe_avcenc->cond);
+    pthread_mutex_destroy(&upipe_avcenc->mutex);
+    ueventfd_clean(&upipe_avcenc->async_event);
+    upipe_avcenc->async_depth = 0;
+}
+
 /** @internal @This encodes av frames.
  *
  * @param upipe description structure of the pipe
@@ -696,6 +1141,9 @@ static int upipe_avcenc_encode_frame(struct upipe *upipe,
     if (unlikely(frame == NULL))
         upipe_dbg(upipe, "received null frame");
 
+    if (upipe_avcenc_is_async(upipe))
+        return upipe_avcenc_push_async(upipe, frame, upump_p);
+
     /* encode frame */
     int err;
     if ((err = avcodec_send_frame(context, frame)) < 0) {
@@ -970,7 +1418,7 @@ static bool upipe_avcenc_handle(struct upipe *upipe, struct uref *uref,
     if (upipe_avcenc->flow_def_requested == NULL)
         return false;
 
-    if (context->pix_fmt == AV_PIX_FMT_VAAPI) {
+    if (upipe_av_hw_pixfmt_to_surface_type(context->pix_fmt) != NULL) {
         AVFrame *frame = av_frame_alloc();
         if (frame == NULL) {
             upipe_err(upipe, "cannot allocate avframe");
@@ -986,6 +1434,13 @@ static bool upipe_avcenc_handle(struct upipe *upipe, struct uref *uref,
             uref_free(uref);
             return true;
         }
+        if (frame->hw_frames_ctx == NULL) {
+            upipe_err(upipe, "received a frame in system memory");
+            upipe_throw_error(upipe, UBASE_ERR_INVALID);
+            av_frame_free(&frame);
+            uref_free(uref);
+            return true;
+        }
         if (context->hw_frames_ctx != NULL &&
             context->hw_frames_ctx->data != frame->hw_frames_ctx->data) {
             upipe_notice(upipe, "hw frames ctx changed");
@@ -1018,6 +1473,10 @@ static bool upipe_avcenc_handle(struct upipe *upipe, struct uref *uref,
         upipe_avcenc_open(upipe);
     }
 
+    /* back-pressure from the encoder thread */
+    if (!upipe_avcenc_check_async(upipe))
+        return false;
+
     uref_clock_get_rate(uref, &upipe_avcenc->drift_rate);
     uref_clock_get_pts_prog(uref, &upipe_avcenc->input_pts);
     uref_clock_get_pts_sys(uref, &upipe_avcenc->input_pts_sys);
@@ -1303,12 +1762,11 @@ static int upipe_avcenc_set_flow_def(struct upipe *upipe, struct uref *flow_def)
         context->width = hsize;
         context->height = vsize;
 
-        const char *surface_type;
-        if ((ubase_check(uref_pic_flow_get_surface_type(flow_def,
-                                                        &surface_type))) &&
-            !strcmp(surface_type, "av.vaapi") &&
-            codec->pix_fmts[0] == AV_PIX_FMT_VAAPI) {
-            context->pix_fmt = AV_PIX_FMT_VAAPI;
+        enum AVPixelFormat hw_pix_fmt =
+            upipe_avcenc_hw_pixfmt_from_flow_def(codec, flow_def);
+        if (hw_pix_fmt != AV_PIX_FMT_NONE) {
+            /* device frames are encoded without leaving device memory */
+            context->pix_fmt = hw_pix_fmt;
             upipe_avcenc->chroma_map[0] = NULL;
         } else {
             context->pix_fmt = upipe_av_pixfmt_from_flow_def(
@@ -1495,13 +1953,19 @@ static int _upipe_avcenc_provide_flow_format(struct upipe *upipe,
         if (unlikely(codec->pix_fmts == NULL || codec->pix_fmts[0] == -1))
             goto upipe_avcenc_provide_flow_format_err;
 
-        if (codec->pix_fmts[0] == AV_PIX_FMT_VAAPI) {
+        const char *surface_type =
+            upipe_av_hw_pixfmt_to_surface_type(codec->pix_fmts[0]);
+        if (upipe_avcenc_hw_pixfmt_from_flow_def(codec, flow_format) !=
+            AV_PIX_FMT_NONE) {
+            /* keep device frames as they are */
+        } else if (surface_type != NULL) {
             uref_pic_flow_clear_format(flow_format);
             if (unlikely(!ubase_check(upipe_av_pixfmt_to_flow_def(
                             AV_PIX_FMT_NV12, flow_format))))
                 goto upipe_avcenc_provide_flow_format_err;
-            uref_pic_flow_set_surface_type(flow_format, "av.vaapi");
+            uref_pic_flow_set_surface_type(flow_format, surface_type);
         } else {
+            uref_pic_flow_delete_surface_type(flow_format);
             const char *chroma_map[UPIPE_AV_MAX_PLANES];
             enum AVPixelFormat pix_fmt = upipe_av_pixfmt_from_flow_def(flow_format,
                         codec->pix_fmts, chroma_map);
@@ -1658,6 +2122,30 @@ static int upipe_avcenc_set_option(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @This sets the asynchronous encoding mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param depth maximum number of frames waiting for the encoder thread, or 0
+ * for synchronous encoding
+ * @return an error code
+ */
+static int _upipe_avcenc_set_async(struct upipe *upipe, unsigned int depth)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (depth == upipe_avcenc->async_depth)
+        return UBASE_ERR_NONE;
+
+    upipe_avcenc_stop_async(upipe);
+    if (depth) {
+        upipe_avcenc->async_depth = depth;
+        UBASE_RETURN(upipe_avcenc_start_async(upipe))
+        upipe_dbg_va(upipe, "encoding asynchronously (%u frames)", depth);
+    } else
+        upipe_dbg(upipe, "encoding synchronously");
+    upipe_avcenc_resume_async(upipe);
+    return UBASE_ERR_NONE;
+}
+
 /** @This sets the slice type enforcement mode (true or false).
  *
  * @param upipe description structure of the pipe
@@ -1674,6 +2162,29 @@ static int _upipe_avcenc_set_slice_type_enforce(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the target octetrate and buffer size. The change
+ * is applied on the next keyframe, or immediately if the context is not
+ * open yet. Only some codecs (such as libx264) take into account rate
+ * changes in an open context.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate target octetrate
+ * @param bs buffer size in octets, or 0 to keep the current one
+ * @return an error code
+ */
+static int _upipe_avcenc_set_rate(struct upipe *upipe,
+                                  uint64_t octetrate, uint64_t bs)
+{
+    struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
+    if (unlikely(!octetrate))
+        return UBASE_ERR_INVALID;
+    upipe_avcenc->rate_octetrate = octetrate;
+    upipe_avcenc->rate_bs = bs;
+    if (!avcodec_is_open(upipe_avcenc->context))
+        upipe_avcenc_apply_rate(upipe);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -1703,8 +2214,11 @@ static int upipe_avcenc_control(struct upipe *upipe,
         }
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_avcenc_set_upump_av_deal(upipe, NULL);
+            upipe_avcenc_set_upump_async(upipe, NULL);
             upipe_avcenc_abort_av_deal(upipe);
-            return upipe_avcenc_attach_upump_mgr(upipe);
+            UBASE_RETURN(upipe_avcenc_attach_upump_mgr(upipe))
+            upipe_avcenc_poll_async(upipe);
+            return UBASE_ERR_NONE;
 
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
@@ -1725,6 +2239,22 @@ static int upipe_avcenc_control(struct upipe *upipe,
             bool enforce = va_arg(args, int) != 0;
             return _upipe_avcenc_set_slice_type_enforce(upipe, enforce);
         }
+        case UPIPE_AVCENC_SET_ASYNC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCENC_SIGNATURE)
+            unsigned int depth = va_arg(args, unsigned int);
+            return _upipe_avcenc_set_async(upipe, depth);
+        }
+        case UPIPE_AVCENC_GET_ASYNC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCENC_SIGNATURE)
+            unsigned int *depth_p = va_arg(args, unsigned int *);
+            *depth_p = upipe_avcenc_from_upipe(upipe)->async_depth;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_ENC_SET_RATE: {
+            uint64_t octetrate = va_arg(args, uint64_t);
+            uint64_t bs = va_arg(args, uint64_t);
+            return _upipe_avcenc_set_rate(upipe, octetrate, bs);
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -1739,6 +2269,7 @@ static void upipe_avcenc_free(struct upipe *upipe)
 {
     struct upipe_avcenc *upipe_avcenc = upipe_avcenc_from_upipe(upipe);
 
+    upipe_avcenc_stop_async(upipe);
     if (upipe_avcenc->context != NULL)
         av_free(upipe_avcenc->context);
     av_frame_free(&upipe_avcenc->frame);
@@ -1761,6 +2292,7 @@ static void upipe_avcenc_free(struct upipe *upipe)
     upipe_avcenc_clean_input(upipe);
     upipe_avcenc_clean_ubuf_mgr(upipe);
     upipe_avcenc_clean_upump_av_deal(upipe);
+    upipe_avcenc_clean_upump_async(upipe);
     upipe_avcenc_clean_upump_mgr(upipe);
     upipe_avcenc_clean_output(upipe);
     upipe_avcenc_clean_flow_format(upipe);
@@ -1841,6 +2373,7 @@ static struct upipe *upipe_avcenc_alloc(struct upipe_mgr *mgr,
     upipe_avcenc_init_ubuf_mgr(upipe);
     upipe_avcenc_init_upump_mgr(upipe);
     upipe_avcenc_init_upump_av_deal(upipe);
+    upipe_avcenc_init_upump_async(upipe);
     upipe_avcenc_init_output(upipe);
     upipe_avcenc_init_input(upipe);
     upipe_avcenc_init_flow_format(upipe);
@@ -1849,8 +2382,11 @@ static struct upipe *upipe_avcenc_alloc(struct upipe_mgr *mgr,
     upipe_avcenc_store_flow_def_attr(upipe, flow_def);
     upipe_avcenc->flow_def_requested = NULL;
     upipe_avcenc->slice_type_enforce = false;
+    upipe_avcenc->rate_octetrate = 0;
+    upipe_avcenc->rate_bs = 0;
     upipe_avcenc->options = options;
     upipe_avcenc->release_needed = false;
+    upipe_avcenc->async_depth = 0;
 
     ulist_init(&upipe_avcenc->sound_urefs);
     upipe_avcenc->nb_samples = 0;
@@ -0,0 +1,337 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Bin pipe running the avcodec encoder of a track on a pool of
+ * worker threads
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uref.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_inner.h"
+#include "upipe/upipe_helper_uprobe.h"
+#include "upipe/upipe_helper_bin_input.h"
+#include "upipe/upipe_helper_bin_output.h"
+#include "upipe-modules/upipe_worker_linear.h"
+#include "upipe-av/upipe_avcodec_encode_pool.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+/** @internal @This is the private context of an avcenc pool manager. */
+struct upipe_avcenc_pool_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** manager of avcodec encoder pipes */
+    struct upipe_mgr *avcenc_mgr;
+    /** probe hierarchy to use on the worker threads */
+    struct uprobe *uprobe_remote;
+    /** number of frames in the queues towards the workers */
+    unsigned int input_queue_length;
+    /** number of packets in the queues from the workers */
+    unsigned int output_queue_length;
+
+    /** number of workers */
+    unsigned int nb_workers;
+    /** wlin manager of each worker */
+    struct upipe_mgr **wlin_mgrs;
+    /** number of encoders running on each worker */
+    unsigned int *loads;
+
+    /** public upipe_mgr structure */
+    struct upipe_mgr mgr;
+};
+
+UBASE_FROM_TO(upipe_avcenc_pool_mgr, upipe_mgr, upipe_mgr, mgr)
+UBASE_FROM_TO(upipe_avcenc_pool_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This is the private context of an avcenc pool pipe. */
+struct upipe_avcenc_pool {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of input bin requests */
+    struct uchain input_request_list;
+    /** list of output bin requests */
+    struct uchain output_request_list;
+    /** proxy probe */
+    struct uprobe proxy_probe;
+
+    /** worker pipe, as first inner pipe of the bin */
+    struct upipe *first_inner;
+    /** worker pipe, as last inner pipe of the bin */
+    struct upipe *last_inner;
+    /** output */
+    struct upipe *output;
+
+    /** index of the worker running the encoder */
+    unsigned int worker;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_avcenc_pool, upipe, UPIPE_AVCENC_POOL_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_avcenc_pool, urefcount, upipe_avcenc_pool_no_ref)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_avcenc_pool, urefcount_real,
+                            upipe_avcenc_pool_free)
+UPIPE_HELPER_INNER(upipe_avcenc_pool, first_inner)
+UPIPE_HELPER_BIN_INPUT(upipe_avcenc_pool, first_inner, input_request_list)
+UPIPE_HELPER_INNER(upipe_avcenc_pool, last_inner)
+UPIPE_HELPER_UPROBE(upipe_avcenc_pool, urefcount_real, proxy_probe, NULL)
+UPIPE_HELPER_BIN_OUTPUT(upipe_avcenc_pool, last_inner, output,
+                        output_request_list)
+
+/** @internal @This allocates an avcenc pool pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_avcenc_pool_alloc_pipe(struct upipe_mgr *mgr,
+                                                  struct uprobe *uprobe,
+                                                  uint32_t signature,
+                                                  va_list args)
+{
+    struct upipe_avcenc_pool_mgr *pool_mgr =
+        upipe_avcenc_pool_mgr_from_upipe_mgr(mgr);
+    if (signature != UPIPE_FLOW_SIGNATURE) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct uref *flow_def = va_arg(args, struct uref *);
+
+    struct upipe_avcenc_pool *upipe_avcenc_pool =
+        malloc(sizeof(struct upipe_avcenc_pool));
+    if (unlikely(upipe_avcenc_pool == NULL)) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+
+    struct upipe *upipe = upipe_avcenc_pool_to_upipe(upipe_avcenc_pool);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_avcenc_pool_init_urefcount(upipe);
+    upipe_avcenc_pool_init_urefcount_real(upipe);
+    upipe_avcenc_pool_init_proxy_probe(upipe);
+    upipe_avcenc_pool_init_bin_input(upipe);
+    upipe_avcenc_pool_init_bin_output(upipe);
+
+    /* pick the least loaded worker */
+    unsigned int worker = 0;
+    for (unsigned int i = 1; i < pool_mgr->nb_workers; i++)
+        if (pool_mgr->loads[i] < pool_mgr->loads[worker])
+            worker = i;
+    upipe_avcenc_pool->worker = worker;
+    pool_mgr->loads[worker]++;
+    upipe_throw_ready(upipe);
+
+    struct upipe *avcenc = upipe_flow_alloc(pool_mgr->avcenc_mgr,
+            uprobe_pfx_alloc(uprobe_use(pool_mgr->uprobe_remote),
+                             UPROBE_LOG_VERBOSE, "avcenc"),
+            flow_def);
+    if (unlikely(avcenc == NULL)) {
+        upipe_err(upipe, "unable to allocate encoder");
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    struct upipe *wlin = upipe_wlin_alloc(pool_mgr->wlin_mgrs[worker],
+            uprobe_pfx_alloc(uprobe_use(&upipe_avcenc_pool->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "wlin"),
+            avcenc,
+            uprobe_pfx_alloc(uprobe_use(pool_mgr->uprobe_remote),
+                             UPROBE_LOG_VERBOSE, "wlin_remote"),
+            pool_mgr->input_queue_length, pool_mgr->output_queue_length);
+    if (unlikely(wlin == NULL)) {
+        upipe_err(upipe, "unable to allocate worker pipe");
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_avcenc_pool_store_bin_input(upipe, upipe_use(wlin));
+    upipe_avcenc_pool_store_bin_output(upipe, wlin);
+
+    upipe_dbg_va(upipe, "encoder running on worker %u", worker);
+    return upipe;
+}
+
+/** @internal @This processes control commands on an avcenc pool pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_avcenc_pool_control(struct upipe *upipe, int command,
+                                     va_list args)
+{
+    struct upipe_avcenc_pool *upipe_avcenc_pool =
+        upipe_avcenc_pool_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_AVCENC_POOL_GET_WORKER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVCENC_POOL_SIGNATURE)
+            unsigned int *worker_p = va_arg(args, unsigned int *);
+            *worker_p = upipe_avcenc_pool->worker;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_ATTACH_UPUMP_MGR:
+            if (upipe_avcenc_pool->first_inner == NULL)
+                return UBASE_ERR_UNHANDLED;
+            return upipe_attach_upump_mgr(upipe_avcenc_pool->first_inner);
+        default:
+            break;
+    }
+
+    UBASE_HANDLED_RETURN(
+        upipe_avcenc_pool_control_bin_input(upipe, command, args));
+    return upipe_avcenc_pool_control_bin_output(upipe, command, args);
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe pipe to free
+ */
+static void upipe_avcenc_pool_free(struct upipe *upipe)
+{
+    struct upipe_avcenc_pool *upipe_avcenc_pool =
+        upipe_avcenc_pool_from_upipe(upipe);
+    struct upipe_avcenc_pool_mgr *pool_mgr =
+        upipe_avcenc_pool_mgr_from_upipe_mgr(upipe->mgr);
+
+    upipe_throw_dead(upipe);
+    pool_mgr->loads[upipe_avcenc_pool->worker]--;
+    upipe_avcenc_pool_clean_proxy_probe(upipe);
+    upipe_avcenc_pool_clean_urefcount_real(upipe);
+    upipe_avcenc_pool_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_avcenc_pool);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avcenc_pool_no_ref(struct upipe *upipe)
+{
+    upipe_avcenc_pool_clean_bin_input(upipe);
+    upipe_avcenc_pool_clean_bin_output(upipe);
+    upipe_avcenc_pool_release_urefcount_real(upipe);
+}
+
+/** @This frees a upipe manager.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_avcenc_pool_mgr_free(struct urefcount *urefcount)
+{
+    struct upipe_avcenc_pool_mgr *pool_mgr =
+        upipe_avcenc_pool_mgr_from_urefcount(urefcount);
+    for (unsigned int i = 0; i < pool_mgr->nb_workers; i++)
+        upipe_mgr_release(pool_mgr->wlin_mgrs[i]);
+    free(pool_mgr->wlin_mgrs);
+    free(pool_mgr->loads);
+    uprobe_release(pool_mgr->uprobe_remote);
+    upipe_mgr_release(pool_mgr->avcenc_mgr);
+
+    urefcount_clean(urefcount);
+    free(pool_mgr);
+}
+
+/** @This returns the management structure for avcenc pool pipes.
+ *
+ * @param avcenc_mgr manager of avcodec encoder pipes
+ * @param xfer_mgrs array of managers to transfer pipes to the worker
+ * threads
+ * @param nb_workers number of managers in the array
+ * @param uprobe_remote probe hierarchy to use on the worker threads
+ * (belongs to the callee)
+ * @param input_queue_length number of frames in the queue between the main
+ * thread and a worker, per track
+ * @param output_queue_length number of packets in the queue between a
+ * worker and the main thread, per track
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_avcenc_pool_mgr_alloc(struct upipe_mgr *avcenc_mgr,
+        struct upipe_mgr *const *xfer_mgrs, unsigned int nb_workers,
+        struct uprobe *uprobe_remote, unsigned int input_queue_length,
+        unsigned int output_queue_length)
+{
+    if (unlikely(avcenc_mgr == NULL || xfer_mgrs == NULL || !nb_workers ||
+                 !input_queue_length || !output_queue_length)) {
+        uprobe_release(uprobe_remote);
+        return NULL;
+    }
+
+    struct upipe_avcenc_pool_mgr *pool_mgr =
+        malloc(sizeof(struct upipe_avcenc_pool_mgr));
+    if (unlikely(pool_mgr == NULL)) {
+        uprobe_release(uprobe_remote);
+        return NULL;
+    }
+
+    memset(pool_mgr, 0, sizeof(*pool_mgr));
+    pool_mgr->avcenc_mgr = upipe_mgr_use(avcenc_mgr);
+    pool_mgr->uprobe_remote = uprobe_remote;
+    pool_mgr->input_queue_length = input_queue_length;
+    pool_mgr->output_queue_length = output_queue_length;
+    pool_mgr->wlin_mgrs = calloc(nb_workers, sizeof(struct upipe_mgr *));
+    pool_mgr->loads = calloc(nb_workers, sizeof(unsigned int));
+    urefcount_init(upipe_avcenc_pool_mgr_to_urefcount(pool_mgr),
+                   upipe_avcenc_pool_mgr_free);
+    if (unlikely(pool_mgr->wlin_mgrs == NULL || pool_mgr->loads == NULL)) {
+        urefcount_release(upipe_avcenc_pool_mgr_to_urefcount(pool_mgr));
+        return NULL;
+    }
+
+    for ( ; pool_mgr->nb_workers < nb_workers; pool_mgr->nb_workers++) {
+        struct upipe_mgr *wlin_mgr =
+            upipe_wlin_mgr_alloc(xfer_mgrs[pool_mgr->nb_workers]);
+        if (unlikely(wlin_mgr == NULL)) {
+            urefcount_release(upipe_avcenc_pool_mgr_to_urefcount(pool_mgr));
+            return NULL;
+        }
+        pool_mgr->wlin_mgrs[pool_mgr->nb_workers] = wlin_mgr;
+    }
+
+    pool_mgr->mgr.refcount = upipe_avcenc_pool_mgr_to_urefcount(pool_mgr);
+    pool_mgr->mgr.signature = UPIPE_AVCENC_POOL_SIGNATURE;
+    pool_mgr->mgr.upipe_alloc = upipe_avcenc_pool_alloc_pipe;
+    pool_mgr->mgr.upipe_input = upipe_avcenc_pool_bin_input;
+    pool_mgr->mgr.upipe_control = upipe_avcenc_pool_control;
+    pool_mgr->mgr.upipe_mgr_control = NULL;
+    return upipe_avcenc_pool_mgr_to_upipe_mgr(pool_mgr);
+}
@@ -114,6 +114,8 @@ struct upipe_avfilt_sub {
     bool input;
     /** avfilter buffer source */
     AVFilterContext *buffer_ctx;
+    /** buffer of the previous graph while a new one is built */
+    AVFilterContext *prev_buffer_ctx;
     /** system clock offset */
     uint64_t pts_sys_offset;
     /** prog clock offset */
@@ -215,6 +217,14 @@ struct upipe_avfilt {
     AVFilterGraph *filter_graph;
     /** filter graph is configured? */
     bool configured;
+    /** true while a new graph is built to replace the running one */
+    bool swapping;
+    /** running graph while the new one waits for its first frame */
+    AVFilterGraph *prev_graph;
+    /** avfilter buffer source of the running graph */
+    AVFilterContext *prev_buffer_ctx;
+    /** avfilter buffer sink of the running graph */
+    AVFilterContext *prev_buffersink_ctx;
 
     /** reference to hardware device context for filters */
     AVBufferRef *hw_device_ctx;
@@ -271,6 +281,9 @@ static int upipe_avfilt_init_filters(struct upipe *upipe);
 static void upipe_avfilt_clean_filters(struct upipe *upipe);
 /** @hidden */
 static void upipe_avfilt_update_outputs(struct upipe *upipe);
+/** @hidden */
+static int upipe_avfilt_set_flow_def(struct upipe *upipe,
+                                     struct uref *flow_def);
 
 UPIPE_HELPER_UPIPE(upipe_avfilt, upipe, UPIPE_AVFILT_SIGNATURE)
 UPIPE_HELPER_VOID(upipe_avfilt)
@@ -458,6 +471,21 @@ static int upipe_avfilt_sub_build_flow_def(struct upipe *upipe,
             if (width < 0 || height < 0)
                 return UBASE_ERR_INVALID;
 
+            const char *surface_type =
+                upipe_av_hw_pixfmt_to_surface_type(pix_fmt);
+            if (surface_type != NULL) {
+                AVBufferRef *hw_frames_ctx =
+                    av_buffersink_get_hw_frames_ctx(
+                        upipe_avfilt_sub->buffer_ctx);
+                if (hw_frames_ctx == NULL)
+                    return UBASE_ERR_INVALID;
+                AVHWFramesContext *hw_frames =
+                    (AVHWFramesContext *) hw_frames_ctx->data;
+                pix_fmt = hw_frames->sw_format;
+                UBASE_RETURN(uref_pic_flow_set_surface_type(flow_def,
+                                                            surface_type))
+            }
+
             UBASE_RETURN(upipe_av_pixfmt_to_flow_def(pix_fmt, flow_def))
             UBASE_RETURN(uref_pic_flow_set_hsize(flow_def, width))
             UBASE_RETURN(uref_pic_flow_set_vsize( flow_def, height))
@@ -925,6 +953,7 @@ static struct upipe *upipe_avfilt_sub_alloc(struct upipe_mgr *mgr,
     upipe_avfilt_sub->last_pts_prog = UINT64_MAX;
     upipe_avfilt_sub->last_duration = 0;
     upipe_avfilt_sub->buffer_ctx = NULL;
+    upipe_avfilt_sub->prev_buffer_ctx = NULL;
     upipe_avfilt_sub->warn_not_configured = true;
     upipe_avfilt_sub->media_type = UPIPE_AVFILT_SUB_MEDIA_TYPE_UNKNOWN;
     upipe_avfilt_sub->latency = 0;
@@ -1441,6 +1470,12 @@ static int upipe_avfilt_set_configured(struct upipe *upipe, bool configured)
     if (upipe_avfilt->configured == configured)
         return UBASE_ERR_NONE;
 
+    if (upipe_avfilt->swapping) {
+        /* the previous graph keeps running until the swap */
+        upipe_avfilt->configured = configured;
+        return UBASE_ERR_NONE;
+    }
+
     upipe_notice_va(upipe, "filter %s is %s",
                     upipe_avfilt->filters_desc ?: "(none)",
                     configured ? "configured" :
@@ -1482,6 +1517,7 @@ static void upipe_avfilt_clean_filters(struct upipe *upipe)
         sub->buffer_ctx = NULL;
     }
     avfilter_graph_free(&upipe_avfilt->filter_graph);
+    avfilter_graph_free(&upipe_avfilt->prev_graph);
     upipe_avfilt_set_configured(upipe, false);
 }
 
@@ -1689,6 +1725,221 @@ static void upipe_avfilt_reset(struct upipe *upipe)
     upipe_avfilt_init_filters(upipe);
 }
 
+/** @internal @This checks that a filter graph description only differs from
+ * the running graph by runtime parameters, and sends them to the running
+ * filters.
+ *
+ * @param upipe description structure of the pipe
+ * @param filters_desc new filter graph description
+ * @return an error code, UBASE_ERR_INVALID if the graph must be rebuilt
+ */
+static int upipe_avfilt_update_params(struct upipe *upipe,
+                                      const char *filters_desc)
+{
+    struct upipe_avfilt *upipe_avfilt = upipe_avfilt_from_upipe(upipe);
+    AVFilterGraph *graph = upipe_avfilt->filter_graph;
+    AVFilterInOut *inputs = NULL;
+    AVFilterInOut *outputs = NULL;
+    int ret = UBASE_ERR_INVALID;
+
+    AVFilterGraph *scratch = avfilter_graph_alloc();
+    UBASE_ALLOC_RETURN(scratch);
+    if (avfilter_graph_parse2(scratch, filters_desc, &inputs, &outputs) < 0)
+        goto end;
+
+    /* parsed filters are named after their position in the description */
+    unsigned nb_parsed = 0;
+    for (unsigned i = 0; i < graph->nb_filters; i++) {
+        AVFilterContext *f = graph->filters[i];
+        if (!strncmp(f->name, "Parsed_", strlen("Parsed_")) &&
+            strcmp(f->filter->name, "buffersink") &&
+            strcmp(f->filter->name, "abuffersink"))
+            nb_parsed++;
+    }
+    if (nb_parsed != scratch->nb_filters)
+        goto end;
+
+    /* first pass: same topology and only runtime parameters changed */
+    unsigned nb_changes = 0;
+    for (unsigned i = 0; i < scratch->nb_filters; i++) {
+        AVFilterContext *f = scratch->filters[i];
+        AVFilterContext *cur = avfilter_graph_get_filter(graph, f->name);
+        if (cur == NULL || cur->filter != f->filter ||
+            cur->nb_inputs != f->nb_inputs)
+            goto end;
+        for (unsigned j = 0; j < f->nb_inputs; j++)
+            if (f->inputs[j] != NULL &&
+                (cur->inputs[j] == NULL ||
+                 strcmp(cur->inputs[j]->src->name, f->inputs[j]->src->name)))
+                goto end;
+
+        if (f->filter->priv_class == NULL)
+            continue;
+        const AVOption *opt = NULL;
+        while ((opt = av_opt_next(f->priv, opt)) != NULL) {
+            uint8_t *val, *cur_val;
+            if (opt->type == AV_OPT_TYPE_CONST ||
+                av_opt_get(f->priv, opt->name, 0, &val) < 0)
+                continue;
+            if (av_opt_get(cur->priv, opt->name, 0, &cur_val) < 0) {
+                av_free(val);
+                continue;
+            }
+            bool changed = strcmp((const char *)val, (const char *)cur_val);
+            av_free(val);
+            av_free(cur_val);
+            if (!changed)
+                continue;
+            if (!(opt->flags & AV_OPT_FLAG_RUNTIME_PARAM))
+                goto end;
+            nb_changes++;
+        }
+    }
+
+    /* second pass: send the changed parameters */
+    for (unsigned i = 0; i < scratch->nb_filters && nb_changes; i++) {
+        AVFilterContext *f = scratch->filters[i];
+        AVFilterContext *cur = avfilter_graph_get_filter(graph, f->name);
+        if (f->filter->priv_class == NULL)
+            continue;
+        const AVOption *opt = NULL;
+        while ((opt = av_opt_next(f->priv, opt)) != NULL) {
+            uint8_t *val, *cur_val;
+            if (opt->type == AV_OPT_TYPE_CONST ||
+                av_opt_get(f->priv, opt->name, 0, &val) < 0)
+                continue;
+            if (av_opt_get(cur->priv, opt->name, 0, &cur_val) < 0) {
+                av_free(val);
+                continue;
+            }
+            bool changed = strcmp((const char *)val, (const char *)cur_val);
+            av_free(cur_val);
+            if (changed) {
+                int err = avfilter_graph_send_command(graph, f->name,
+                                                      opt->name,
+                                                      (const char *)val,
+                                                      NULL, 0, 0);
+                if (err < 0) {
+                    upipe_warn_va(upipe, "cannot set %s on %s: %s",
+                                  opt->name, f->name, av_err2str(err));
+                    av_free(val);
+                    goto end;
+                }
+                upipe_dbg_va(upipe, "set %s=%s on %s",
+                             opt->name, (const char *)val, f->name);
+            }
+            av_free(val);
+        }
+    }
+
+    upipe_notice_va(upipe, "filter %s updated in place", filters_desc);
+    ret = UBASE_ERR_NONE;
+
+end:
+    avfilter_inout_free(&outputs);
+    avfilter_inout_free(&inputs);
+    avfilter_graph_free(&scratch);
+    return ret;
+}
+
+/** @internal @This builds a new graph for sub pipe inputs and swaps it with
+ * the running one if it could be configured, keeping the running graph
+ * otherwise.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_avfilt_swap_filters(struct upipe *upipe)
+{
+    struct upipe_avfilt *upipe_avfilt = upipe_avfilt_from_upipe(upipe);
+    AVFilterGraph *prev_graph = upipe_avfilt->filter_graph;
+    struct uchain *uchain;
+
+    ulist_foreach(&upipe_avfilt->subs, uchain) {
+        struct upipe_avfilt_sub *sub = upipe_avfilt_sub_from_uchain(uchain);
+        sub->prev_buffer_ctx = sub->buffer_ctx;
+        sub->buffer_ctx = NULL;
+    }
+    upipe_avfilt->filter_graph = NULL;
+    upipe_avfilt->configured = false;
+    upipe_avfilt->swapping = true;
+    int ret = upipe_avfilt_init_filters(upipe);
+    upipe_avfilt->swapping = false;
+
+    if (!upipe_avfilt->configured) {
+        upipe_warn_va(upipe, "keeping previous filter graph");
+        avfilter_graph_free(&upipe_avfilt->filter_graph);
+        upipe_avfilt->filter_graph = prev_graph;
+        upipe_avfilt->configured = true;
+        ulist_foreach(&upipe_avfilt->subs, uchain) {
+            struct upipe_avfilt_sub *sub =
+                upipe_avfilt_sub_from_uchain(uchain);
+            sub->buffer_ctx = sub->prev_buffer_ctx;
+            sub->prev_buffer_ctx = NULL;
+        }
+        return ubase_check(ret) ? UBASE_ERR_INVALID : ret;
+    }
+
+    ulist_foreach(&upipe_avfilt->subs, uchain) {
+        struct upipe_avfilt_sub *sub = upipe_avfilt_sub_from_uchain(uchain);
+        sub->prev_buffer_ctx = NULL;
+    }
+    avfilter_graph_free(&prev_graph);
+    upipe_notice_va(upipe, "filter %s swapped", upipe_avfilt->filters_desc);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This drops the new graph of the main input, and restores the
+ * running one.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfilt_restore_input(struct upipe *upipe)
+{
+    struct upipe_avfilt *upipe_avfilt = upipe_avfilt_from_upipe(upipe);
+    avfilter_graph_free(&upipe_avfilt->filter_graph);
+    upipe_avfilt->filter_graph = upipe_avfilt->prev_graph;
+    upipe_avfilt->buffer_ctx = upipe_avfilt->prev_buffer_ctx;
+    upipe_avfilt->buffersink_ctx = upipe_avfilt->prev_buffersink_ctx;
+    upipe_avfilt->prev_graph = NULL;
+    upipe_avfilt->prev_buffer_ctx = NULL;
+    upipe_avfilt->prev_buffersink_ctx = NULL;
+}
+
+/** @internal @This builds a new graph for the main input. The running graph
+ * keeps filtering until the new one is configured by the next frame.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_avfilt_swap_input(struct upipe *upipe)
+{
+    struct upipe_avfilt *upipe_avfilt = upipe_avfilt_from_upipe(upipe);
+
+    if (upipe_avfilt->prev_graph != NULL)
+        /* replace the pending graph */
+        avfilter_graph_free(&upipe_avfilt->filter_graph);
+    else if (upipe_avfilt->configured) {
+        upipe_avfilt->prev_graph = upipe_avfilt->filter_graph;
+        upipe_avfilt->prev_buffer_ctx = upipe_avfilt->buffer_ctx;
+        upipe_avfilt->prev_buffersink_ctx = upipe_avfilt->buffersink_ctx;
+    } else
+        avfilter_graph_free(&upipe_avfilt->filter_graph);
+    upipe_avfilt->filter_graph = NULL;
+    upipe_avfilt->buffer_ctx = NULL;
+    upipe_avfilt->buffersink_ctx = NULL;
+
+    struct uref *flow_def = uref_dup(upipe_avfilt->flow_def_input);
+    int ret = flow_def != NULL ? upipe_avfilt_set_flow_def(upipe, flow_def) :
+                                 UBASE_ERR_ALLOC;
+    uref_free(flow_def);
+    if (unlikely(!ubase_check(ret))) {
+        upipe_warn_va(upipe, "keeping previous filter graph");
+        upipe_avfilt_restore_input(upipe);
+    }
+    return ret;
+}
+
 /** @internal @This sets the filter graph description.
  *
  * @param upipe description structure of the pipe
@@ -1703,8 +1954,22 @@ static int _upipe_avfilt_set_filters_desc(struct upipe *upipe,
     UBASE_ALLOC_RETURN(filters_desc_dup);
     free(upipe_avfilt->filters_desc);
     upipe_avfilt->filters_desc = filters_desc_dup;
-    upipe_avfilt_reset(upipe);
-    return UBASE_ERR_NONE;
+
+    if (upipe_avfilt->filter_graph == NULL || !upipe_avfilt->configured ||
+        upipe_avfilt->prev_graph != NULL) {
+        if (upipe_avfilt->flow_def_input == NULL)
+            upipe_avfilt_reset(upipe);
+        else
+            upipe_avfilt_swap_input(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    if (ubase_check(upipe_avfilt_update_params(upipe, filters_desc)))
+        return UBASE_ERR_NONE;
+
+    if (upipe_avfilt->flow_def_input == NULL)
+        return upipe_avfilt_swap_filters(upipe);
+    return upipe_avfilt_swap_input(upipe);
 }
 
 /** @This sets the hardware configuration.
@@ -1796,7 +2061,10 @@ static int upipe_avfilt_set_flow_def_pic(struct upipe *upipe,
     }
     p->time_base.num = 1;
     p->time_base.den = UCLOCK_FREQ;
-    p->format = pix_fmt;
+    /* hardware frames keep their device pixel format, the frames context
+     * is attached with the first frame */
+    enum AVPixelFormat hw_pix_fmt = upipe_av_hw_pixfmt_from_flow_def(flow_def);
+    p->format = hw_pix_fmt != AV_PIX_FMT_NONE ? hw_pix_fmt : pix_fmt;
     p->width = width;
     p->height = height;
     if (sar.num) {
@@ -2086,7 +2354,9 @@ static int upipe_avfilt_build_flow_def(struct upipe *upipe,
             if (width < 0 || height < 0)
                 return UBASE_ERR_INVALID;
 
-            if (pix_fmt == AV_PIX_FMT_VAAPI) {
+            const char *surface_type =
+                upipe_av_hw_pixfmt_to_surface_type(pix_fmt);
+            if (surface_type != NULL) {
                 AVBufferRef *hw_frames_ctx =
                     av_buffersink_get_hw_frames_ctx(ctx);
                 if (hw_frames_ctx == NULL)
@@ -2095,7 +2365,7 @@ static int upipe_avfilt_build_flow_def(struct upipe *upipe,
                     (AVHWFramesContext *) hw_frames_ctx->data;
                 pix_fmt = hw_frames->sw_format;
                 UBASE_RETURN(uref_pic_flow_set_surface_type(flow_def,
-                                                            "av.vaapi"))
+                                                            surface_type))
             }
 
             UBASE_RETURN(upipe_av_pixfmt_to_flow_def(pix_fmt, flow_def))
@@ -2573,6 +2843,48 @@ static int upipe_avfilt_avframe_from_uref(struct upipe *upipe,
     return UBASE_ERR_INVALID;
 }
 
+/** @internal @This configures the new graph of the main input with the
+ * first frame received after a change, then drains the running graph and
+ * swaps them. The running graph is kept if the new one cannot be
+ * configured.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame first frame for the new graph
+ * @param upump_p reference to the pump that generated the buffer
+ */
+static void upipe_avfilt_swap_pending(struct upipe *upipe, AVFrame *frame,
+                                      struct upump **upump_p)
+{
+    struct upipe_avfilt *upipe_avfilt = upipe_avfilt_from_upipe(upipe);
+
+    int err = 0;
+    int ret = upipe_avfilt_init_buffer_from_first_frame(upipe, frame);
+    if (ubase_check(ret) &&
+        (err = avfilter_graph_config(upipe_avfilt->filter_graph, NULL)) < 0)
+        upipe_err_va(upipe, "cannot configure filter graph: %s",
+                     av_err2str(err));
+    if (!ubase_check(ret) || err < 0) {
+        upipe_warn_va(upipe, "keeping previous filter graph");
+        upipe_avfilt_restore_input(upipe);
+        return;
+    }
+
+    /* output what remains in the running graph */
+    AVFrame *out = av_frame_alloc();
+    if (out != NULL &&
+        av_buffersrc_write_frame(upipe_avfilt->prev_buffer_ctx, NULL) >= 0) {
+        while (av_buffersink_get_frame(upipe_avfilt->prev_buffersink_ctx,
+                                       out) >= 0)
+            upipe_avfilt_output_frame(upipe, out, upump_p);
+    }
+    av_frame_free(&out);
+
+    avfilter_graph_free(&upipe_avfilt->prev_graph);
+    upipe_avfilt->prev_buffer_ctx = NULL;
+    upipe_avfilt->prev_buffersink_ctx = NULL;
+    upipe_notice_va(upipe, "filter %s swapped", upipe_avfilt->filters_desc);
+}
+
 /** @internal @This handles the input buffer.
  *
  * @param upipe description structure of the pipe
@@ -2614,7 +2926,9 @@ static void upipe_avfilt_input(struct upipe *upipe,
             frame->pkt_duration = duration;
     }
 
-    if (!upipe_avfilt->configured) {
+    if (upipe_avfilt->prev_graph != NULL)
+        upipe_avfilt_swap_pending(upipe, frame, upump_p);
+    else if (!upipe_avfilt->configured) {
         ret = upipe_avfilt_init_buffer_from_first_frame(upipe, frame);
         if (!ubase_check(ret)) {
             upipe_throw_error(upipe, ret);
@@ -2693,6 +3007,41 @@ static int upipe_avfilt_set_option(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sends a command to filters of the running graph.
+ *
+ * @param upipe description structure of the pipe
+ * @param target filter instance name, or "all"
+ * @param cmd command
+ * @param arg command argument
+ * @return an error code
+ */
+static int _upipe_avfilt_send_command(struct upipe *upipe,
+                                      const char *target,
+                                      const char *cmd,
+                                      const char *arg)
+{
+    struct upipe_avfilt *upipe_avfilt = upipe_avfilt_from_upipe(upipe);
+    AVFilterGraph *graph = upipe_avfilt->prev_graph ?:
+                           upipe_avfilt->filter_graph;
+
+    if (target == NULL || cmd == NULL)
+        return UBASE_ERR_INVALID;
+    if (graph == NULL || !upipe_avfilt->configured)
+        return UBASE_ERR_BUSY;
+
+    char res[256] = "";
+    int err = avfilter_graph_send_command(graph, target, cmd, arg ?: "",
+                                          res, sizeof (res), 0);
+    if (err < 0) {
+        upipe_err_va(upipe, "cannot send command %s %s to %s: %s",
+                     cmd, arg ?: "", target, av_err2str(err));
+        return UBASE_ERR_EXTERNAL;
+    }
+    if (*res)
+        upipe_dbg_va(upipe, "command %s to %s: %s", cmd, target, res);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on an avfilter pipe.
  *
  * @param upipe description structure of the pipe
@@ -2727,6 +3076,13 @@ static int upipe_avfilt_control(struct upipe *upipe,
             const char *hw_device = va_arg(args, const char *);
             return _upipe_avfilt_set_hw_config(upipe, hw_type, hw_device);
         }
+        case UPIPE_AVFILT_SEND_COMMAND: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AVFILT_SIGNATURE)
+            const char *target = va_arg(args, const char *);
+            const char *cmd = va_arg(args, const char *);
+            const char *arg = va_arg(args, const char *);
+            return _upipe_avfilt_send_command(upipe, target, cmd, arg);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -2773,6 +3129,10 @@ static struct upipe *upipe_avfilt_alloc(struct upipe_mgr *mgr,
     struct upipe_avfilt *upipe_avfilt = upipe_avfilt_from_upipe(upipe);
     upipe_avfilt->filters_desc = NULL;
     upipe_avfilt->filter_graph = NULL;
+    upipe_avfilt->swapping = false;
+    upipe_avfilt->prev_graph = NULL;
+    upipe_avfilt->prev_buffer_ctx = NULL;
+    upipe_avfilt->prev_buffersink_ctx = NULL;
     upipe_avfilt->hw_device_ctx = NULL;
     upipe_avfilt->ubuf_mgr = ubuf_av_mgr_alloc();
     upipe_avfilt->buffer_ctx = NULL;
@@ -2802,6 +3162,7 @@ static void upipe_avfilt_free(struct upipe *upipe)
 
     free(upipe_avfilt->filters_desc);
     avfilter_graph_free(&upipe_avfilt->filter_graph);
+    avfilter_graph_free(&upipe_avfilt->prev_graph);
     av_buffer_unref(&upipe_avfilt->hw_device_ctx);
     av_dict_free(&upipe_avfilt->options);
     uref_free(upipe_avfilt->uref);
@@ -40,6 +40,9 @@
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
 #include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_uref_mgr.h"
+#include "upipe/upipe_helper_ubuf_mgr.h"
 #include "upipe/upipe_helper_flow_def_check.h"
 #include "upipe/upipe_helper_subpipe.h"
 #include "upipe/upipe_helper_sync.h"
@@ -58,11 +61,41 @@
 #include <libavutil/dict.h>
 #include <libavformat/avformat.h>
 
+/** size of the I/O buffer when writing to the output pipe */
+#define UPIPE_AVFSINK_IO_SIZE 32768
+
+/** @hidden */
+static int upipe_avfsink_check(struct upipe *upipe, struct uref *flow_format);
+
 /** @internal @This is the private context of an avformat source pipe. */
 struct upipe_avfsink {
     /** refcount management structure */
     struct urefcount urefcount;
 
+    /** pipe acting as output, if the container is written to a pipe */
+    struct upipe *output;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** pump that generated the buffer being muxed */
+    struct upump **upump_p;
+
     /** list of subs */
     struct uchain subs;
 
@@ -101,6 +134,14 @@ UPIPE_HELPER_UPIPE(upipe_avfsink, upipe, UPIPE_AVFSINK_SIGNATURE)
 UPIPE_HELPER_UREFCOUNT(upipe_avfsink, urefcount, upipe_avfsink_free)
 UPIPE_HELPER_VOID(upipe_avfsink)
 UPIPE_HELPER_SYNC(upipe_avfsink, acquired)
+UPIPE_HELPER_OUTPUT(upipe_avfsink, output, flow_def, output_state, request_list)
+UPIPE_HELPER_UREF_MGR(upipe_avfsink, uref_mgr, uref_mgr_request, NULL,
+                      upipe_avfsink_register_output_request,
+                      upipe_avfsink_unregister_output_request)
+UPIPE_HELPER_UBUF_MGR(upipe_avfsink, ubuf_mgr, flow_format, ubuf_mgr_request,
+                      upipe_avfsink_check,
+                      upipe_avfsink_register_output_request,
+                      upipe_avfsink_unregister_output_request)
 
 /** @internal @This is the private context of an output of an avformat source
  * pipe. */
@@ -722,7 +763,11 @@ static struct upipe *upipe_avfsink_alloc(struct upipe_mgr *mgr,
     upipe_avfsink_init_sub_subs(upipe);
     upipe_avfsink_init_sub_mgr(upipe);
     upipe_avfsink_init_sync(upipe);
+    upipe_avfsink_init_output(upipe);
+    upipe_avfsink_init_uref_mgr(upipe);
+    upipe_avfsink_init_ubuf_mgr(upipe);
 
+    upipe_avfsink->upump_p = NULL;
     upipe_avfsink->uri = NULL;
     upipe_avfsink->init_uri = NULL;
     upipe_avfsink->mime = NULL;
@@ -766,6 +811,124 @@ static struct upipe_avfsink_sub *upipe_avfsink_find_input(struct upipe *upipe)
     return earliest_input;
 }
 
+/** @internal @This receives the amended flow format of the output.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_avfsink_check(struct upipe *upipe, struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        upipe_avfsink_store_flow_def(upipe, flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This outputs a chunk of the container written by avformat.
+ *
+ * @param opaque description structure of the pipe
+ * @param buf buffer to write
+ * @param buf_size size of the buffer
+ * @return the number of octets written, or a negative error code
+ */
+#if LIBAVFORMAT_VERSION_MAJOR < 61
+static int upipe_avfsink_io_write(void *opaque, uint8_t *buf, int buf_size)
+#else
+static int upipe_avfsink_io_write(void *opaque, const uint8_t *buf,
+                                  int buf_size)
+#endif
+{
+    struct upipe *upipe = opaque;
+    struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
+
+    struct uref *uref = uref_block_alloc(upipe_avfsink->uref_mgr,
+                                         upipe_avfsink->ubuf_mgr, buf_size);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return AVERROR(ENOMEM);
+    }
+
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &size, &buffer)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return AVERROR(ENOMEM);
+    }
+    memcpy(buffer, buf, buf_size);
+    uref_block_unmap(uref, 0);
+
+    upipe_avfsink_output(upipe, uref, upipe_avfsink->upump_p);
+    return buf_size;
+}
+
+/** @internal @This allocates an I/O context writing the container to the
+ * output pipe, with buffers from the pipeline's managers.
+ *
+ * @param upipe description structure of the pipe
+ * @return 0 or a negative avformat error code
+ */
+static int upipe_avfsink_io_alloc(struct upipe *upipe)
+{
+    struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
+
+    if (unlikely(!upipe_avfsink_demand_uref_mgr(upipe)))
+        return AVERROR(ENOMEM);
+
+    if (upipe_avfsink->ubuf_mgr == NULL) {
+        struct uref *flow_def =
+            uref_block_flow_alloc_def(upipe_avfsink->uref_mgr, NULL);
+        if (unlikely(flow_def == NULL))
+            return AVERROR(ENOMEM);
+        if (unlikely(!upipe_avfsink_demand_ubuf_mgr(upipe, flow_def)))
+            return AVERROR(ENOMEM);
+    }
+
+    uint8_t *buffer = av_malloc(UPIPE_AVFSINK_IO_SIZE);
+    if (unlikely(buffer == NULL))
+        return AVERROR(ENOMEM);
+
+    AVIOContext *pb = avio_alloc_context(buffer, UPIPE_AVFSINK_IO_SIZE, 1,
+                                         upipe, NULL, upipe_avfsink_io_write,
+                                         NULL);
+    if (unlikely(pb == NULL)) {
+        av_free(buffer);
+        return AVERROR(ENOMEM);
+    }
+    upipe_avfsink->context->pb = pb;
+    return 0;
+}
+
+/** @internal @This closes the I/O context of the avformat context.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfsink_avio_close(struct upipe *upipe)
+{
+    struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
+
+    if (upipe_avfsink->context->oformat->flags & AVFMT_NOFILE)
+        return;
+
+    if (upipe_avfsink->output != NULL) {
+        AVIOContext *pb = upipe_avfsink->context->pb;
+        if (pb != NULL) {
+            avio_flush(pb);
+            av_freep(&pb->buffer);
+            avio_context_free(&pb);
+            upipe_avfsink->context->pb = NULL;
+        }
+    } else
+        avio_close(upipe_avfsink->context->pb);
+}
+
+/** @internal @This opens the I/O context of the avformat context, either on
+ * the URL or on the output pipe if one is set.
+ *
+ * @param upipe description structure of the pipe
+ * @param input input subpipe currently being muxed
+ * @return an error code
+ */
 static int upipe_avfsink_avio_open(struct upipe *upipe, struct upipe_avfsink_sub *input)
 {
     struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
@@ -779,11 +942,16 @@ static int upipe_avfsink_avio_open(struct upipe *upipe, struct upipe_avfsink_sub
     char *url = upipe_avfsink->context->url;
 #endif
 
-    AVDictionary *options = NULL;
-    av_dict_copy(&options, upipe_avfsink->options, 0);
-    int error = avio_open2(&upipe_avfsink->context->pb, url,
+    int error;
+    if (upipe_avfsink->output != NULL)
+        error = upipe_avfsink_io_alloc(upipe);
+    else {
+        AVDictionary *options = NULL;
+        av_dict_copy(&options, upipe_avfsink->options, 0);
+        error = avio_open2(&upipe_avfsink->context->pb, url,
                            AVIO_FLAG_WRITE, NULL, &options);
-    av_dict_free(&options);
+        av_dict_free(&options);
+    }
     if (error < 0) {
         upipe_av_strerror(error, buf);
         upipe_err_va(upipe, "couldn't open file %s (%s)", url, buf);
@@ -843,6 +1011,65 @@ static void upipe_avfsink_set_disposition_default(struct upipe *upipe)
         video_stream->disposition = AV_DISPOSITION_DEFAULT;
 }
 
+/** @internal @This releases the ubuf wrapped in an AVPacket buffer.
+ *
+ * @param opaque pointer to the ubuf
+ * @param data pointer to the mapped data
+ */
+static void upipe_avfsink_free_buffer(void *opaque, uint8_t *data)
+{
+    struct ubuf *ubuf = opaque;
+    ubuf_block_unmap(ubuf, 0);
+    ubuf_free(ubuf);
+}
+
+/** @internal @This allocates an AVPacket carrying the data of a block uref.
+ * If the block is made of a single unshared segment followed by at least
+ * AV_INPUT_BUFFER_PADDING_SIZE octets of tailroom, the padding is zeroed
+ * and the ubuf is detached from the uref and wrapped in the packet without
+ * copy; otherwise the data is copied into a new padded packet buffer.
+ *
+ * @param uref block uref
+ * @param size size of the block
+ * @return pointer to the packet, or NULL in case of allocation failure
+ */
+static AVPacket *upipe_avfsink_alloc_packet(struct uref *uref, size_t size)
+{
+    AVPacket *avpkt = av_packet_alloc();
+    if (unlikely(avpkt == NULL))
+        return NULL;
+
+    size_t tailroom;
+    int write_size = size;
+    uint8_t *buffer;
+    if (ubase_check(ubuf_block_tailroom(uref->ubuf, &tailroom)) &&
+        tailroom >= AV_INPUT_BUFFER_PADDING_SIZE &&
+        ubase_check(ubuf_block_write(uref->ubuf, 0, &write_size, &buffer))) {
+        if (write_size == size) {
+            avpkt->buf = av_buffer_create(buffer, size,
+                                          upipe_avfsink_free_buffer,
+                                          uref->ubuf,
+                                          AV_BUFFER_FLAG_READONLY);
+            if (likely(avpkt->buf != NULL)) {
+                memset(buffer + size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+                uref_detach_ubuf(uref);
+                avpkt->data = buffer;
+                avpkt->size = size;
+                return avpkt;
+            }
+        }
+        ubuf_block_unmap(uref->ubuf, 0);
+    }
+
+    if (unlikely(av_new_packet(avpkt, size) < 0 ||
+                 !ubase_check(uref_block_extract(uref, 0, size,
+                                                 avpkt->data)))) {
+        av_packet_free(&avpkt);
+        return NULL;
+    }
+    return avpkt;
+}
+
 /** @internal @This asks avformat to multiplex some data.
  *
  * @param upipe description structure of the pipe
@@ -853,6 +1080,7 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
     struct upipe_avfsink *upipe_avfsink = upipe_avfsink_from_upipe(upipe);
     struct upipe_avfsink_sub *input;
 
+    upipe_avfsink->upump_p = upump_p;
     while ((input = upipe_avfsink_find_input(upipe)) != NULL) {
         if (unlikely(!upipe_avfsink->opened)) {
             /* prevent the pipe to be released during event handling */
@@ -925,8 +1153,7 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
                 }
                 upipe_notice_va(upipe, "closing init URI %s",
                                 upipe_avfsink->init_uri);
-                if (!(upipe_avfsink->context->oformat->flags & AVFMT_NOFILE))
-                    avio_close(upipe_avfsink->context->pb);
+                upipe_avfsink_avio_close(upipe);
 #if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 7, 100)
                 snprintf(upipe_avfsink->context->filename,
                          sizeof (upipe_avfsink->context->filename),
@@ -970,42 +1197,42 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
             continue;
         }
 
-        AVPacket avpkt;
-        if (unlikely(av_new_packet(&avpkt, size) < 0)) {
+        AVPacket *avpkt = upipe_avfsink_alloc_packet(uref, size);
+        if (unlikely(avpkt == NULL)) {
             uref_free(uref);
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             upipe_release(upipe_avfsink_sub_to_upipe(input));
             return;
         }
 
-        avpkt.stream_index = input->id;
+        avpkt->stream_index = input->id;
         if (ubase_check(uref_flow_get_random(uref)))
-            avpkt.flags |= AV_PKT_FLAG_KEY;
+            avpkt->flags |= AV_PKT_FLAG_KEY;
 
         uint64_t dts;
         if (ubase_check(uref_clock_get_dts_prog(uref, &dts)))
-            avpkt.dts = ((dts - upipe_avfsink->ts_offset) *
-                         stream->time_base.den + UCLOCK_FREQ / 2) /
-                        UCLOCK_FREQ / stream->time_base.num;
+            avpkt->dts = ((dts - upipe_avfsink->ts_offset) *
+                          stream->time_base.den + UCLOCK_FREQ / 2) /
+                         UCLOCK_FREQ / stream->time_base.num;
         uint64_t pts;
         if (ubase_check(uref_clock_get_pts_prog(uref, &pts)))
-            avpkt.pts = ((pts - upipe_avfsink->ts_offset) *
-                         stream->time_base.den + UCLOCK_FREQ / 2) /
-                        UCLOCK_FREQ / stream->time_base.num;
+            avpkt->pts = ((pts - upipe_avfsink->ts_offset) *
+                          stream->time_base.den + UCLOCK_FREQ / 2) /
+                         UCLOCK_FREQ / stream->time_base.num;
 
         if (input->ts_max != UINT64_MAX) {
-            if (avpkt.dts != AV_NOPTS_VALUE)
-                avpkt.dts %= input->ts_max + 1;
-            if (avpkt.pts != AV_NOPTS_VALUE)
-                avpkt.pts %= input->ts_max + 1;
+            if (avpkt->dts != AV_NOPTS_VALUE)
+                avpkt->dts %= input->ts_max + 1;
+            if (avpkt->pts != AV_NOPTS_VALUE)
+                avpkt->pts %= input->ts_max + 1;
         }
 
         uint64_t duration;
         if (ubase_check(uref_clock_get_duration(uref, &duration)))
-            avpkt.duration = (duration * stream->time_base.den + UCLOCK_FREQ / 2) /
-                             UCLOCK_FREQ / stream->time_base.num;
+            avpkt->duration = (duration * stream->time_base.den +
+                               UCLOCK_FREQ / 2) /
+                              UCLOCK_FREQ / stream->time_base.num;
 
-        uref_block_extract(uref, 0, avpkt.size, avpkt.data);
         uref_free(uref);
 
         if (input->next_dts > upipe_avfsink->highest_next_dts) {
@@ -1014,8 +1241,8 @@ static void upipe_avfsink_mux(struct upipe *upipe, struct upump **upump_p)
 
         upipe_release(upipe_avfsink_sub_to_upipe(input));
 
-        int error = av_write_frame(upipe_avfsink->context, &avpkt);
-        av_packet_unref(&avpkt);
+        int error = av_write_frame(upipe_avfsink->context, avpkt);
+        av_packet_free(&avpkt);
 
         if (unlikely(error < 0)) {
             upipe_av_strerror(error, buf);
@@ -1207,9 +1434,9 @@ static int upipe_avfsink_set_uri(struct upipe *upipe, const char *uri)
             upipe_notice_va(upipe, "closing URI %s", upipe_avfsink->uri);
         if (upipe_avfsink->opened) {
             upipe_dbg(upipe, "writing trailer");
+            upipe_avfsink->upump_p = NULL;
             av_write_trailer(upipe_avfsink->context);
-            if (!(upipe_avfsink->context->oformat->flags & AVFMT_NOFILE))
-                avio_close(upipe_avfsink->context->pb);
+            upipe_avfsink_avio_close(upipe);
         }
         avformat_free_context(upipe_avfsink->context);
     }
@@ -1318,6 +1545,17 @@ static int upipe_avfsink_control(struct upipe *upipe, int command, va_list args)
         case UPIPE_UNREGISTER_REQUEST:
             return upipe_control_provide_request(upipe, command, args);
 
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT: {
+            struct upipe_avfsink *upipe_avfsink =
+                upipe_avfsink_from_upipe(upipe);
+            if (upipe_avfsink->opened && command == UPIPE_SET_OUTPUT)
+                return UBASE_ERR_BUSY;
+            return upipe_avfsink_control_output(upipe, command, args);
+        }
+        case UPIPE_GET_FLOW_DEF:
+            return upipe_avfsink_control_output(upipe, command, args);
+
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_avfsink_set_flow_def(upipe, flow_def);
@@ -1409,6 +1647,9 @@ static void upipe_avfsink_free(struct upipe *upipe)
 
     av_dict_free(&upipe_avfsink->options);
 
+    upipe_avfsink_clean_ubuf_mgr(upipe);
+    upipe_avfsink_clean_uref_mgr(upipe);
+    upipe_avfsink_clean_output(upipe);
     upipe_avfsink_clean_sync(upipe);
     upipe_avfsink_clean_urefcount(upipe);
     upipe_avfsink_free_void(upipe);
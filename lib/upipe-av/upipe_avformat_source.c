@@ -75,6 +75,14 @@
 #define PCR_OFFSET (UCLOCK_FREQ * 3)
 /** 1/UCLOCK_FREQ time base */
 #define UCLOCK_TIME_BASE (AVRational){ 1, UCLOCK_FREQ }
+/** size of the I/O buffer when reading from the input */
+#define UPIPE_AVFSRC_IO_SIZE 32768
+/** octets that must be buffered ahead of the demuxer when reading from the
+ * input, so that it never runs out of data in the middle of a packet */
+#define UPIPE_AVFSRC_IO_LOW (256 * 1024)
+
+/** @hidden */
+static int upipe_avfsrc_check(struct upipe *upipe);
 
 /** @internal @This is the private context of an avfsrc manager. */
 struct upipe_avfsrc_mgr {
@@ -134,6 +142,15 @@ struct upipe_avfsrc {
     /** URL */
     char *url;
 
+    /** I/O context reading from the input, or NULL */
+    AVIOContext *io;
+    /** buffered input urefs */
+    struct uchain io_urefs;
+    /** number of buffered input octets */
+    size_t io_size;
+    /** true if the input has ended */
+    bool io_end;
+
     /** avcodec initialization watcher */
     struct upump *upump_av_deal;
     /** avformat options */
@@ -481,6 +498,10 @@ static struct upipe *upipe_avfsrc_alloc(struct upipe_mgr *mgr,
     upipe_avfsrc->systime_rap = UINT64_MAX;
 
     upipe_avfsrc->url = NULL;
+    upipe_avfsrc->io = NULL;
+    ulist_init(&upipe_avfsrc->io_urefs);
+    upipe_avfsrc->io_size = 0;
+    upipe_avfsrc->io_end = false;
 
     upipe_avfsrc->upump_av_deal = NULL;
     upipe_avfsrc->options = NULL;
@@ -505,6 +526,142 @@ static void upipe_avfsrc_abort_av_deal(struct upipe *upipe)
     }
 }
 
+/** @internal @This feeds avformat with data buffered from the input.
+ *
+ * @param opaque description structure of the pipe
+ * @param buf buffer to fill
+ * @param buf_size size of the buffer
+ * @return the number of octets read, or AVERROR_EOF
+ */
+static int upipe_avfsrc_io_read(void *opaque, uint8_t *buf, int buf_size)
+{
+    struct upipe *upipe = opaque;
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    int read_size = 0;
+
+    while (read_size < buf_size && !ulist_empty(&upipe_avfsrc->io_urefs)) {
+        struct uref *uref =
+            uref_from_uchain(ulist_peek(&upipe_avfsrc->io_urefs));
+        size_t size = 0;
+        uref_block_size(uref, &size);
+        int chunk = size;
+        if (chunk > buf_size - read_size)
+            chunk = buf_size - read_size;
+
+        if (chunk)
+            uref_block_extract(uref, 0, chunk, buf + read_size);
+        read_size += chunk;
+        upipe_avfsrc->io_size -= chunk;
+
+        if (chunk == size) {
+            ulist_pop(&upipe_avfsrc->io_urefs);
+            uref_free(uref);
+        } else
+            uref_block_resize(uref, chunk, -1);
+    }
+
+    return read_size ? read_size : AVERROR_EOF;
+}
+
+/** @internal @This releases the I/O context reading from the input, after
+ * the avformat context has been closed.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfsrc_io_free(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    if (upipe_avfsrc->io != NULL) {
+        av_freep(&upipe_avfsrc->io->buffer);
+        avio_context_free(&upipe_avfsrc->io);
+    }
+}
+
+/** @internal @This outputs a void flow definition on the main output and
+ * makes sure the managers are available before demuxing.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_avfsrc_prepare(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+
+    if (unlikely(!upipe_avfsrc_demand_uref_mgr(upipe)))
+        return UBASE_ERR_ALLOC;
+    upipe_avfsrc_check_upump_mgr(upipe);
+
+    struct uref *flow_def = uref_alloc_control(upipe_avfsrc->uref_mgr);
+    uref_flow_set_def(flow_def, "void.");
+    upipe_avfsrc_store_flow_def(upipe, flow_def);
+    /* Force sending flow def */
+    struct uref *uref = uref_alloc(upipe_avfsrc->uref_mgr);
+    upipe_avfsrc_output(upipe, uref, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This opens an avformat context reading from the input, once
+ * enough data has been buffered for format probing.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_avfsrc_io_open(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    UBASE_RETURN(upipe_avfsrc_prepare(upipe))
+
+    uint8_t *buffer = av_malloc(UPIPE_AVFSRC_IO_SIZE);
+    if (unlikely(buffer == NULL))
+        return UBASE_ERR_ALLOC;
+    upipe_avfsrc->io = avio_alloc_context(buffer, UPIPE_AVFSRC_IO_SIZE, 0,
+                                          upipe, upipe_avfsrc_io_read,
+                                          NULL, NULL);
+    if (unlikely(upipe_avfsrc->io == NULL)) {
+        av_free(buffer);
+        return UBASE_ERR_ALLOC;
+    }
+
+    upipe_avfsrc->context = avformat_alloc_context();
+    if (unlikely(upipe_avfsrc->context == NULL)) {
+        upipe_avfsrc_io_free(upipe);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_avfsrc->context->pb = upipe_avfsrc->io;
+    upipe_avfsrc->context->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    AVDictionary *options = NULL;
+    av_dict_copy(&options, upipe_avfsrc->options, 0);
+    int error = avformat_open_input(&upipe_avfsrc->context, NULL, NULL,
+                                    &options);
+    av_dict_free(&options);
+    if (unlikely(error < 0)) {
+        upipe_av_strerror(error, buf);
+        upipe_err_va(upipe, "can't open input (%s)", buf);
+        upipe_avfsrc_io_free(upipe);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    upipe_avfsrc->context->flags |= AVFMT_FLAG_KEEP_SIDE_DATA;
+    upipe_avfsrc->timestamp_offset = 0;
+    upipe_avfsrc->probed = false;
+    upipe_notice(upipe, "opening input");
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This flushes the data buffered from the input.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_avfsrc_io_flush(struct upipe *upipe)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&upipe_avfsrc->io_urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    upipe_avfsrc->io_size = 0;
+}
+
 /** @internal @This finds the given id in the list of output subpipes.
  *
  * @param upipe description structure of the pipe
@@ -536,6 +693,13 @@ static void upipe_avfsrc_worker(struct upump *upump)
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
     AVPacket pkt;
 
+    if (upipe_avfsrc->io != NULL && !upipe_avfsrc->io_end &&
+        upipe_avfsrc->io_size < UPIPE_AVFSRC_IO_LOW) {
+        /* wait for more input */
+        upump_stop(upump);
+        return;
+    }
+
     int error = av_read_frame(upipe_avfsrc->context, &pkt);
     if (unlikely(error < 0)) {
         if (error != AVERROR_EOF) {
@@ -859,6 +1023,9 @@ static void upipe_avfsrc_probe(struct upump *upump)
     upump_free(upipe_avfsrc->upump_av_deal);
     upipe_avfsrc->upump_av_deal = NULL;
     upipe_avfsrc->probed = true;
+    if (upipe_avfsrc->io != NULL && !upipe_avfsrc->io_end)
+        /* probing may have drained the input buffer */
+        upipe_avfsrc->io->eof_reached = 0;
 
     if (unlikely(error < 0)) {
         upipe_av_strerror(error, buf);
@@ -867,6 +1034,7 @@ static void upipe_avfsrc_probe(struct upump *upump)
             upipe_notice_va(upipe, "closing URL %s", upipe_avfsrc->url);
         avformat_close_input(&upipe_avfsrc->context);
         upipe_avfsrc->context = NULL;
+        upipe_avfsrc_io_free(upipe);
         ubase_clean_str(&upipe_avfsrc->url);
         return;
     }
@@ -1043,26 +1211,20 @@ static int upipe_avfsrc_set_uri(struct upipe *upipe, const char *url)
             upipe_notice_va(upipe, "closing URL %s", upipe_avfsrc->url);
         avformat_close_input(&upipe_avfsrc->context);
         upipe_avfsrc->context = NULL;
+        upipe_avfsrc_io_free(upipe);
         upipe_avfsrc_set_upump(upipe, NULL);
         upipe_avfsrc_abort_av_deal(upipe);
         upipe_avfsrc_throw_sub_subs(upipe, UPROBE_SOURCE_END);
         free(upipe_avfsrc->streams);
     }
     ubase_clean_str(&upipe_avfsrc->url);
+    upipe_avfsrc_io_flush(upipe);
+    upipe_avfsrc->io_end = false;
 
     if (unlikely(url == NULL))
         return UBASE_ERR_NONE;
 
-    if (unlikely(!upipe_avfsrc_demand_uref_mgr(upipe)))
-        return UBASE_ERR_ALLOC;
-    upipe_avfsrc_check_upump_mgr(upipe);
-
-    struct uref *flow_def = uref_alloc_control(upipe_avfsrc->uref_mgr);
-    uref_flow_set_def(flow_def, "void.");
-    upipe_avfsrc_store_flow_def(upipe, flow_def);
-    /* Force sending flow def */
-    struct uref *uref = uref_alloc(upipe_avfsrc->uref_mgr);
-    upipe_avfsrc_output(upipe, uref, NULL);
+    UBASE_RETURN(upipe_avfsrc_prepare(upipe))
 
     AVDictionary *options = NULL;
     av_dict_copy(&options, upipe_avfsrc->options, 0);
@@ -1140,6 +1302,10 @@ static int _upipe_avfsrc_control(struct upipe *upipe,
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
             return upipe_avfsrc_control_output(upipe, command, args);
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_avfsrc_set_flow_def(upipe, flow_def);
+        }
 
         case UPIPE_SPLIT_ITERATE: {
             struct uref **p = va_arg(args, struct uref **);
@@ -1179,20 +1345,65 @@ static int _upipe_avfsrc_control(struct upipe *upipe,
     }
 }
 
-/** @internal @This processes control commands on an avformat source pipe, and
- * checks the status of the pipe afterwards.
+/** @internal @This buffers data received on the input, and demuxes it once
+ * enough data is available.
  *
  * @param upipe description structure of the pipe
- * @param command type of command to process
- * @param args arguments of the command
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_avfsrc_input(struct upipe *upipe, struct uref *uref,
+                               struct upump **upump_p)
+{
+    struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    size_t size;
+    if (unlikely(upipe_avfsrc->url != NULL ||
+                 !ubase_check(uref_block_size(uref, &size)))) {
+        upipe_warn(upipe, "dropping input buffer");
+        uref_free(uref);
+        return;
+    }
+
+    ulist_add(&upipe_avfsrc->io_urefs, uref_to_uchain(uref));
+    upipe_avfsrc->io_size += size;
+    if (upipe_avfsrc->io_size < UPIPE_AVFSRC_IO_LOW)
+        return;
+
+    if (upipe_avfsrc->context == NULL) {
+        if (unlikely(!ubase_check(upipe_avfsrc_io_open(upipe)))) {
+            upipe_avfsrc_io_flush(upipe);
+            return;
+        }
+    } else if (upipe_avfsrc->upump != NULL)
+        upump_start(upipe_avfsrc->upump);
+    upipe_avfsrc_check(upipe);
+}
+
+/** @internal @This sets the input flow definition, to demux a stream
+ * received from another pipe instead of opening a URL.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
  * @return an error code
  */
-static int upipe_avfsrc_control(struct upipe *upipe, int command, va_list args)
+static int upipe_avfsrc_set_flow_def(struct upipe *upipe,
+                                     struct uref *flow_def)
 {
-    UBASE_RETURN(_upipe_avfsrc_control(upipe, command, args));
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+    return UBASE_ERR_NONE;
+}
 
+/** @internal @This checks if the probing or the worker may be started.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_avfsrc_check(struct upipe *upipe)
+{
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
-    if (upipe_avfsrc->upump_mgr != NULL && upipe_avfsrc->url != NULL &&
+    if (upipe_avfsrc->upump_mgr != NULL && upipe_avfsrc->context != NULL &&
         upipe_avfsrc->upump == NULL) {
         if (unlikely(upipe_avfsrc->probed))
             return upipe_avfsrc_start(upipe) ?
@@ -1216,6 +1427,20 @@ static int upipe_avfsrc_control(struct upipe *upipe, int command, va_list args)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This processes control commands on an avformat source pipe, and
+ * checks the status of the pipe afterwards.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_avfsrc_control(struct upipe *upipe, int command, va_list args)
+{
+    UBASE_RETURN(_upipe_avfsrc_control(upipe, command, args));
+    return upipe_avfsrc_check(upipe);
+}
+
 /** @This frees a upipe.
  *
  * @param urefcount_real pointer to urefcount_real structure
@@ -1237,7 +1462,9 @@ static void upipe_avfsrc_free(struct urefcount *urefcount_real)
 
         free(upipe_avfsrc->streams);
         avformat_close_input(&upipe_avfsrc->context);
+        upipe_avfsrc_io_free(upipe);
     }
+    upipe_avfsrc_io_flush(upipe);
     upipe_throw_dead(upipe);
 
     av_dict_free(&upipe_avfsrc->options);
@@ -1260,6 +1487,12 @@ static void upipe_avfsrc_free(struct urefcount *urefcount_real)
 static void upipe_avfsrc_no_input(struct upipe *upipe)
 {
     struct upipe_avfsrc *upipe_avfsrc = upipe_avfsrc_from_upipe(upipe);
+    if (upipe_avfsrc->io != NULL && upipe_avfsrc->probed) {
+        /* demux what remains of the input */
+        upipe_avfsrc->io_end = true;
+        while (upipe_avfsrc->upump != NULL)
+            upipe_avfsrc_worker(upipe_avfsrc->upump);
+    }
     upipe_avfsrc_throw_sub_subs(upipe, UPROBE_SOURCE_END);
     upipe_split_throw_update(upipe);
     urefcount_release(upipe_avfsrc_to_urefcount_real(upipe_avfsrc));
@@ -1338,7 +1571,7 @@ struct upipe_mgr *upipe_avfsrc_mgr_alloc(void)
     avfsrc_mgr->mgr.refcount = upipe_avfsrc_mgr_to_urefcount(avfsrc_mgr);
     avfsrc_mgr->mgr.signature = UPIPE_AVFSRC_SIGNATURE;
     avfsrc_mgr->mgr.upipe_alloc = upipe_avfsrc_alloc;
-    avfsrc_mgr->mgr.upipe_input = NULL;
+    avfsrc_mgr->mgr.upipe_input = upipe_avfsrc_input;
     avfsrc_mgr->mgr.upipe_control = upipe_avfsrc_control;
     avfsrc_mgr->mgr.upipe_mgr_control = upipe_avfsrc_mgr_control;
     return upipe_avfsrc_mgr_to_upipe_mgr(avfsrc_mgr);
@@ -28,14 +28,42 @@
  */
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
 #include <bearssl.h>
 
 #include "upipe/ubase.h"
 #include "upipe/uref_uri.h"
 #include "upipe/urefcount_helper.h"
+#include "upipe-modules/uref_http_flow.h"
 
 #include "https_source_hook.h"
 
+/** maximum number of sessions kept in a cache */
+#define HTTPS_SRC_SESSION_CACHE_SIZE    16
+
+/** @This describes a cached TLS session. */
+struct https_src_session {
+    /** server name, or NULL if the entry is unused */
+    char *host;
+    /** session parameters */
+    br_ssl_session_parameters params;
+};
+
+/** @This describes a cache of TLS sessions, shared by the hooks. */
+struct https_src_session_cache {
+    /** refcount */
+    struct urefcount urefcount;
+    /** cached sessions */
+    struct https_src_session sessions[HTTPS_SRC_SESSION_CACHE_SIZE];
+    /** next entry to replace */
+    unsigned int next;
+};
+
+/** @hidden */
+UREFCOUNT_HELPER(https_src_session_cache, urefcount,
+                 https_src_session_cache_free);
+
 /** This describes a x509 no anchor context to allow not trusted certificate. */
 struct x509_noanchor_context {
     const br_x509_class *vtable;
@@ -56,6 +84,12 @@ struct https_src_hook {
     unsigned char iobuf[BR_SSL_BUFSIZE_BIDI];
     /** no anchor context */
     struct x509_noanchor_context x509_noanchor;
+    /** session cache, or NULL */
+    struct https_src_session_cache *cache;
+    /** server name */
+    char *host;
+    /** true if the session was stored in the cache */
+    bool stored;
 };
 
 /** @hidden */
@@ -146,6 +180,96 @@ static void x509_noanchor_init(struct x509_noanchor_context *xwc,
     xwc->inner = inner;
 }
 
+/** @This is called when there is no more reference on the session cache.
+ *
+ * @param cache session cache
+ */
+static void https_src_session_cache_free(struct https_src_session_cache *cache)
+{
+    for (unsigned int i = 0; i < HTTPS_SRC_SESSION_CACHE_SIZE; i++)
+        free(cache->sessions[i].host);
+    https_src_session_cache_clean_urefcount(cache);
+    free(cache);
+}
+
+/** @This allocates a TLS session cache.
+ *
+ * @return pointer to the cache or NULL in case of allocation failure
+ */
+struct https_src_session_cache *https_src_session_cache_alloc(void)
+{
+    struct https_src_session_cache *cache = calloc(1, sizeof (*cache));
+    if (unlikely(!cache))
+        return NULL;
+    https_src_session_cache_init_urefcount(cache);
+    return cache;
+}
+
+/** @This releases a TLS session cache.
+ *
+ * @param cache session cache
+ */
+void https_src_session_cache_release(struct https_src_session_cache *cache)
+{
+    https_src_session_cache_release_urefcount(cache);
+}
+
+/** @internal @This finds the cached session of a server.
+ *
+ * @param cache session cache
+ * @param host server name
+ * @return the cached session or NULL
+ */
+static struct https_src_session *
+https_src_session_cache_find(struct https_src_session_cache *cache,
+                             const char *host)
+{
+    for (unsigned int i = 0; i < HTTPS_SRC_SESSION_CACHE_SIZE; i++)
+        if (cache->sessions[i].host &&
+            !strcmp(cache->sessions[i].host, host))
+            return &cache->sessions[i];
+    return NULL;
+}
+
+/** @internal @This stores the session of an established connection in the
+ * cache, replacing the oldest entry if it is full.
+ *
+ * @param https private SSL HTTPS context
+ */
+static void https_src_hook_store_session(struct https_src_hook *https)
+{
+    struct https_src_session_cache *cache = https->cache;
+    https->stored = true;
+    if (!cache)
+        return;
+
+    struct https_src_session *session =
+        https_src_session_cache_find(cache, https->host);
+    if (!session) {
+        char *host = strdup(https->host);
+        if (unlikely(!host))
+            return;
+        session = &cache->sessions[cache->next];
+        cache->next = (cache->next + 1) % HTTPS_SRC_SESSION_CACHE_SIZE;
+        free(session->host);
+        session->host = host;
+    }
+    br_ssl_engine_get_session_parameters(&https->client.eng,
+                                         &session->params);
+}
+
+/** @internal @This updates the session cache once the handshake is done.
+ *
+ * @param https private SSL HTTPS context
+ * @param state BearSSL state
+ */
+static void https_src_hook_check_session(struct https_src_hook *https,
+                                         unsigned state)
+{
+    if (!https->stored && (state & (BR_SSL_SENDAPP | BR_SSL_RECVAPP)))
+        https_src_hook_store_session(https);
+}
+
 /** @internal @This converts BearSSL state to upipe state.
  *
  * @param state BearSSL state
@@ -187,6 +311,7 @@ https_src_hook_transport_read(struct upipe_http_src_hook *hook, int fd)
 
         br_ssl_engine_recvrec_ack(eng, rlen);
         state = br_ssl_engine_current_state(eng);
+        https_src_hook_check_session(https, state);
     }
 
     return https_src_hook_state_to_code(state);
@@ -213,6 +338,7 @@ https_src_hook_transport_write(struct upipe_http_src_hook *hook, int fd)
             return wlen;
         br_ssl_engine_sendrec_ack(eng, wlen);
         state = br_ssl_engine_current_state(eng);
+        https_src_hook_check_session(https, state);
     }
 
     return https_src_hook_state_to_code(state);
@@ -281,46 +407,87 @@ static ssize_t https_src_hook_data_write(struct upipe_http_src_hook *hook,
     return wsize;
 }
 
+/** @internal @This returns the application protocol negotiated with ALPN.
+ *
+ * @param hook SSL hook structure
+ * @return the protocol name, or NULL if none was negotiated
+ */
+static const char *https_src_hook_protocol(struct upipe_http_src_hook *hook)
+{
+    struct https_src_hook *https = https_src_hook_from_hook(hook);
+    return br_ssl_engine_get_selected_protocol(&https->client.eng);
+}
+
 /** @This is called when there is no more reference on the hook.
  *
  * @param https https source hook
  */
 static void https_src_hook_free(struct https_src_hook *https)
 {
+    if (https->cache)
+        https_src_session_cache_release_urefcount(https->cache);
+    free(https->host);
     https_src_hook_clean_urefcount(https);
     free(https);
 }
 
 /** @This initializes the ssl context.
  *
- * @param https private SSL HTTPS context to initialize
+ * If a session with the same server is found in the cache, the handshake
+ * tries to resume it, saving the key exchange and the certificate chain.
+ *
  * @param flow_def connection attributes
+ * @param cache session cache, or NULL
  * @return the public hook description
  */
-struct upipe_http_src_hook *https_src_hook_alloc(struct uref *flow_def)
+struct upipe_http_src_hook *
+https_src_hook_alloc(struct uref *flow_def,
+                     struct https_src_session_cache *cache)
 {
+    const char *host = NULL;
+    int err = uref_uri_get_host(flow_def, &host);
+    if (!ubase_check(err) || !host)
+        return NULL;
+
     struct https_src_hook *https = malloc(sizeof (*https));
     if (unlikely(!https))
         return NULL;
 
-    const char *host = NULL;
-    int err = uref_uri_get_host(flow_def, &host);
-    if (!ubase_check(err) || !host) {
+    https->host = strdup(host);
+    if (unlikely(!https->host)) {
         free(https);
         return NULL;
     }
+    https->cache = NULL;
+    if (cache)
+        https->cache = https_src_session_cache_use_urefcount(cache);
+    https->stored = false;
 
     br_ssl_client_init_full(&https->client, &https->x509, NULL, 0);
     x509_noanchor_init(&https->x509_noanchor, &https->x509.vtable);
     br_ssl_engine_set_x509(&https->client.eng, &https->x509_noanchor.vtable);
     br_ssl_engine_set_buffer(&https->client.eng, https->iobuf,
                              sizeof (https->iobuf), 1);
-    br_ssl_client_reset(&https->client, host, 0);
+    if (ubase_check(uref_http_get_h2(flow_def))) {
+        /* most preferred first */
+        static const char *protocols[] = { "h2", "http/1.1" };
+        br_ssl_engine_set_protocol_names(&https->client.eng, protocols,
+                                         UBASE_ARRAY_SIZE(protocols));
+    }
+
+    struct https_src_session *session =
+        cache ? https_src_session_cache_find(cache, host) : NULL;
+    if (session)
+        br_ssl_engine_set_session_parameters(&https->client.eng,
+                                             &session->params);
+    br_ssl_client_reset(&https->client, host, session ? 1 : 0);
+
     https_src_hook_init_urefcount(https);
     https->hook.urefcount = &https->urefcount;
     https->hook.transport.read = https_src_hook_transport_read;
     https->hook.transport.write = https_src_hook_transport_write;
     https->hook.data.read = https_src_hook_data_read;
     https->hook.data.write = https_src_hook_data_write;
+    https->hook.protocol = https_src_hook_protocol;
     return &https->hook;
 }
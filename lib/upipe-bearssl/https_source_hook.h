@@ -33,11 +33,29 @@
 #include "upipe/uref.h"
 #include "upipe-modules/upipe_http_source.h"
 
+/** @This describes a cache of TLS sessions. */
+struct https_src_session_cache;
+
+/** @This allocates a TLS session cache.
+ *
+ * @return pointer to the cache or NULL in case of allocation failure
+ */
+struct https_src_session_cache *https_src_session_cache_alloc(void);
+
+/** @This releases a TLS session cache.
+ *
+ * @param cache session cache
+ */
+void https_src_session_cache_release(struct https_src_session_cache *cache);
+
 /** @This allocates and initializes a ssl context.
  *
  * @param flow_def connection attributes
+ * @param cache session cache, or NULL
  * @return the public hook description
  */
-struct upipe_http_src_hook *https_src_hook_alloc(struct uref *flow_def);
+struct upipe_http_src_hook *
+https_src_hook_alloc(struct uref *flow_def,
+                     struct https_src_session_cache *cache);
 
 #endif
@@ -41,6 +41,8 @@
 struct uprobe_https {
     /** public probe structure */
     struct uprobe uprobe;
+    /** TLS sessions shared by the connections */
+    struct https_src_session_cache *cache;
 };
 
 UPROBE_HELPER_UPROBE(uprobe_https, uprobe);
@@ -69,8 +71,10 @@ static int uprobe_https_catch(struct uprobe *uprobe,
 
     const char *scheme = NULL;
     uref_uri_get_scheme(flow_def, &scheme);
+    struct uprobe_https *uprobe_https = uprobe_https_from_uprobe(uprobe);
     if (scheme && !strcasecmp(scheme, "https")) {
-        struct upipe_http_src_hook *https_hook = https_src_hook_alloc(flow_def);
+        struct upipe_http_src_hook *https_hook = https_src_hook_alloc(
+            flow_def, uprobe_https->cache);
         if (unlikely(!https_hook))
             return UBASE_ERR_ALLOC;
 
@@ -94,6 +98,9 @@ static struct uprobe *uprobe_https_init(struct uprobe_https *uprobe_https,
 {
     assert(uprobe_https);
     struct uprobe *uprobe = uprobe_https_to_uprobe(uprobe_https);
+    uprobe_https->cache = https_src_session_cache_alloc();
+    if (unlikely(!uprobe_https->cache))
+        return NULL;
     uprobe_init(uprobe, uprobe_https_catch, next);
     return uprobe;
 }
@@ -106,6 +113,7 @@ static void uprobe_https_clean(struct uprobe_https *uprobe_https)
 {
     assert(uprobe_https);
     struct uprobe *uprobe = uprobe_https_to_uprobe(uprobe_https);
+    https_src_session_cache_release(uprobe_https->cache);
     uprobe_clean(uprobe);
 }
 
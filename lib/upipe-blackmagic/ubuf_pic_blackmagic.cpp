@@ -67,6 +67,8 @@ struct ubuf_pic_bmd_mgr {
 
     /** blackmagic pixel format */
     BMDPixelFormat PixelFormat;
+    /** blackmagic output creating the frames, or NULL */
+    IDeckLinkOutput *DeckLinkOutput;
 
     /** common picture management structure */
     struct ubuf_pic_common_mgr common_mgr;
@@ -79,23 +81,40 @@ UBASE_FROM_TO(ubuf_pic_bmd_mgr, ubuf_mgr, ubuf_mgr, common_mgr.mgr)
 UBASE_FROM_TO(ubuf_pic_bmd_mgr, urefcount, urefcount, urefcount)
 UBASE_FROM_TO(ubuf_pic_bmd_mgr, upool, ubuf_pool, ubuf_pool)
 
-/** @This allocates a ubuf, a shared structure and a blackmagic buffer.
+/** @internal @This returns the number of bytes of a line of a blackmagic
+ * frame.
+ *
+ * @param PixelFormat blackmagic pixel format
+ * @param hsize horizontal size in pixels
+ * @return number of bytes per line
+ */
+static int32_t ubuf_pic_bmd_row_bytes(BMDPixelFormat PixelFormat, int hsize)
+{
+    switch (PixelFormat) {
+        case bmdFormat8BitYUV:
+            return hsize * 2;
+        case bmdFormat10BitYUV:
+            /* groups of 48 pixels in 128 bytes */
+            return ((hsize + 47) / 48) * 128;
+        case bmdFormat10BitRGB:
+            /* groups of 64 pixels in 256 bytes */
+            return ((hsize + 63) / 64) * 256;
+        default:
+            return hsize * 4;
+    }
+}
+
+/** @internal @This allocates a ubuf pointing to a blackmagic video frame.
  *
  * @param mgr common management structure
- * @param alloc_type must be UBUF_ALLOC_PICTURE (sentinel)
- * @param args optional arguments (1st = hsize, 2nd = vsize)
+ * @param VideoFrame blackmagic video frame
  * @return pointer to ubuf or NULL in case of allocation error
  */
-static struct ubuf *ubuf_pic_bmd_alloc(struct ubuf_mgr *mgr,
-                                       uint32_t signature, va_list args)
+static struct ubuf *ubuf_pic_bmd_alloc_frame(struct ubuf_mgr *mgr,
+                                             IDeckLinkVideoFrame *VideoFrame)
 {
-    if (unlikely(signature != UBUF_BMD_ALLOC_PICTURE))
-        return NULL;
-
     struct ubuf_pic_bmd_mgr *pic_mgr =
         ubuf_pic_bmd_mgr_from_ubuf_mgr(mgr);
-    void *_VideoFrame = va_arg(args, void *);
-    IDeckLinkVideoFrame *VideoFrame = (IDeckLinkVideoFrame *)_VideoFrame;
     BMDPixelFormat PixelFormat = VideoFrame->GetPixelFormat();
     if (unlikely(PixelFormat != pic_mgr->PixelFormat))
         return NULL;
@@ -121,6 +140,51 @@ static struct ubuf *ubuf_pic_bmd_alloc(struct ubuf_mgr *mgr,
     return ubuf;
 }
 
+/** @This allocates a ubuf, a shared structure and a blackmagic buffer.
+ *
+ * @param mgr common management structure
+ * @param signature UBUF_BMD_ALLOC_PICTURE to wrap an existing frame, or
+ * UBUF_ALLOC_PICTURE to create a frame on the blackmagic output
+ * @param args optional arguments (frame, or 1st = hsize, 2nd = vsize)
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_pic_bmd_alloc(struct ubuf_mgr *mgr,
+                                       uint32_t signature, va_list args)
+{
+    struct ubuf_pic_bmd_mgr *pic_mgr =
+        ubuf_pic_bmd_mgr_from_ubuf_mgr(mgr);
+
+    switch (signature) {
+        case UBUF_BMD_ALLOC_PICTURE: {
+            void *_VideoFrame = va_arg(args, void *);
+            return ubuf_pic_bmd_alloc_frame(mgr,
+                    (IDeckLinkVideoFrame *)_VideoFrame);
+        }
+        case UBUF_ALLOC_PICTURE: {
+            int hsize = va_arg(args, int);
+            int vsize = va_arg(args, int);
+            if (unlikely(pic_mgr->DeckLinkOutput == NULL ||
+                         hsize <= 0 || vsize <= 0))
+                return NULL;
+
+            IDeckLinkMutableVideoFrame *VideoFrame;
+            if (unlikely(pic_mgr->DeckLinkOutput->CreateVideoFrame(hsize,
+                            vsize,
+                            ubuf_pic_bmd_row_bytes(pic_mgr->PixelFormat,
+                                                   hsize),
+                            pic_mgr->PixelFormat, bmdFrameFlagDefault,
+                            &VideoFrame) != S_OK))
+                return NULL;
+
+            struct ubuf *ubuf = ubuf_pic_bmd_alloc_frame(mgr, VideoFrame);
+            VideoFrame->Release();
+            return ubuf;
+        }
+        default:
+            return NULL;
+    }
+}
+
 /** @This asks for the creation of a new reference to the same buffer space.
  *
  * @param ubuf pointer to ubuf
@@ -217,8 +281,27 @@ static int ubuf_pic_bmd_control(struct ubuf *ubuf, int command, va_list args)
                                              hsize, vsize, buffer_p);
         }
         case UBUF_WRITE_PICTURE_PLANE: {
-            /* There is no way to know reference count */
-            return UBASE_ERR_BUSY;
+            /* Frames captured by the card may be reused by the driver, but
+             * frames created on the output belong to us until they are
+             * scheduled. */
+            struct ubuf_pic_bmd_mgr *pic_mgr =
+                ubuf_pic_bmd_mgr_from_ubuf_mgr(ubuf->mgr);
+            struct ubuf_pic_bmd *pic_bmd = ubuf_pic_bmd_from_ubuf(ubuf);
+            if (pic_mgr->DeckLinkOutput == NULL)
+                return UBASE_ERR_BUSY;
+            ULONG refcount = pic_bmd->shared->AddRef();
+            pic_bmd->shared->Release();
+            if (refcount != 2)
+                return UBASE_ERR_BUSY;
+
+            const char *chroma = va_arg(args, const char *);
+            int hoffset = va_arg(args, int);
+            int voffset = va_arg(args, int);
+            int hsize = va_arg(args, int);
+            int vsize = va_arg(args, int);
+            uint8_t **buffer_p = va_arg(args, uint8_t **);
+            return ubuf_pic_common_plane_map(ubuf, chroma, hoffset, voffset,
+                                             hsize, vsize, buffer_p);
         }
         case UBUF_UNMAP_PICTURE_PLANE: {
             /* we don't actually care about the parameters */
@@ -327,6 +410,8 @@ static void ubuf_pic_bmd_mgr_free(struct urefcount *urefcount)
     upool_clean(&pic_mgr->ubuf_pool);
 
     ubuf_pic_common_mgr_clean(mgr);
+    if (pic_mgr->DeckLinkOutput != NULL)
+        pic_mgr->DeckLinkOutput->Release();
 
     urefcount_clean(urefcount);
     free(pic_mgr);
@@ -381,6 +466,7 @@ struct ubuf_mgr *ubuf_pic_bmd_mgr_alloc(uint16_t ubuf_pool_depth,
     mgr->ubuf_mgr_control = ubuf_pic_bmd_mgr_control;
 
     pic_mgr->PixelFormat = PixelFormat;
+    pic_mgr->DeckLinkOutput = NULL;
     upool_init(&pic_mgr->ubuf_pool, mgr->refcount, ubuf_pool_depth,
                pic_mgr->upool_extra,
                ubuf_pic_bmd_alloc_inner, ubuf_pic_bmd_free_inner);
@@ -420,3 +506,32 @@ struct ubuf_mgr *ubuf_pic_bmd_mgr_alloc(uint16_t ubuf_pool_depth,
 
     return mgr;
 }
+
+/** @This allocates a new instance of the ubuf manager for picture formats
+ * using frames created on a blackmagic output. Pictures allocated with
+ * @ref ubuf_pic_alloc are rendered directly into frames that can be
+ * scheduled on the output without a copy, and are writable as long as they
+ * are not shared.
+ *
+ * @param ubuf_pool_depth maximum number of ubuf structures in the pool
+ * @param DeckLinkOutput pointer to IDeckLinkOutput
+ * @param PixelFormat blackmagic pixel format
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_pic_bmd_output_mgr_alloc(uint16_t ubuf_pool_depth,
+                                               void *DeckLinkOutput,
+                                               uint32_t PixelFormat)
+{
+    if (unlikely(DeckLinkOutput == NULL))
+        return NULL;
+
+    struct ubuf_mgr *mgr = ubuf_pic_bmd_mgr_alloc(ubuf_pool_depth,
+                                                  PixelFormat);
+    if (unlikely(mgr == NULL))
+        return NULL;
+
+    struct ubuf_pic_bmd_mgr *pic_mgr = ubuf_pic_bmd_mgr_from_ubuf_mgr(mgr);
+    pic_mgr->DeckLinkOutput = (IDeckLinkOutput *)DeckLinkOutput;
+    pic_mgr->DeckLinkOutput->AddRef();
+    return mgr;
+}
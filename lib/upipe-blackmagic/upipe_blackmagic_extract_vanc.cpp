@@ -48,6 +48,8 @@
 #include <stdint.h>
 #include <stdarg.h>
 
+#include <bitstream/smpte/291.h>
+
 #include "include/DeckLinkAPI.h"
 
 const static struct upipe_bmd_vanc_field_start_line {
@@ -300,6 +302,32 @@ static void upipe_bmd_vanc_copy(uint16_t *w, const uint8_t *r,
         upipe_bmd_vanc_copy10(w, r, frame_start_line, hsize);
 }
 
+/** @internal @This checks if a line starts with an ancillary data flag, by
+ * only unpacking its first pixels.
+ *
+ * @param r buffer to read from
+ * @param PixelFormat Blackmagic pixel format
+ * @param frame_start_line structure describing the image format
+ * @return true if the line may carry ancillary data
+ */
+static bool upipe_bmd_vanc_has_adf(const uint8_t *r,
+        BMDPixelFormat PixelFormat,
+        const struct upipe_bmd_vanc_frame_start_line *frame_start_line)
+{
+    /* one group of 6 pixels, luma first then chroma in HD */
+    uint16_t samples[12];
+    upipe_bmd_vanc_copy(samples, r, PixelFormat, frame_start_line, 6);
+
+    /* compare the 8 most significant bits to also match 8-bit lines */
+#define IS_ADF(s) ((s)[0] >> 2 == S291_ADF1 >> 2 &&                         \
+                   (s)[1] >> 2 == S291_ADF2 >> 2 &&                         \
+                   (s)[2] >> 2 == S291_ADF3 >> 2)
+    if (frame_start_line->sd)
+        return IS_ADF(samples);
+    return IS_ADF(samples) || IS_ADF(samples + 6);
+#undef IS_ADF
+}
+
 /** @internal @This blanks a line.
  *
  * @param w buffer to write to
@@ -476,7 +504,10 @@ static bool upipe_bmd_vanc_handle(struct upipe *upipe, struct uref *uref,
 
     while (nb_lines--) {
         void *r;
-        if (Ancillary->GetBufferForVerticalBlankingLine(line, &r) == S_OK)
+        /* only unpack lines carrying ancillary data */
+        if (Ancillary->GetBufferForVerticalBlankingLine(line, &r) == S_OK &&
+            upipe_bmd_vanc_has_adf((const uint8_t *)r, PixelFormat,
+                                   frame_start_line))
             upipe_bmd_vanc_copy((uint16_t *)w, (const uint8_t *)r,
                                 PixelFormat, frame_start_line, hsize);
         else
@@ -620,7 +651,9 @@ static struct upipe_mgr upipe_bmd_vanc_mgr = {
     /* .upipe_input = */ upipe_bmd_vanc_input,
     /* .upipe_control = */ upipe_bmd_vanc_control,
 
-    /* .upipe_mgr_control = */ NULL
+    /* .upipe_mgr_control = */ NULL,
+
+    /* .upipe_input_batch = */ NULL
 };
 }
 
@@ -51,6 +51,7 @@
 #include "upipe/upipe_helper_uclock.h"
 #include "upipe/upipe_helper_sync.h"
 #include "upipe-blackmagic/upipe_blackmagic_sink.h"
+#include "upipe-blackmagic/ubuf_pic_blackmagic.h"
 
 #include <arpa/inet.h>
 #include <assert.h>
@@ -71,6 +72,8 @@ extern "C" {
 
 #define PREROLL_FRAMES 3
 
+#define UBUF_POOL_DEPTH 25
+
 #define DECKLINK_CHANNELS 16
 
 #define OP47_PACKETS_PER_FIELD 5
@@ -323,7 +326,10 @@ struct upipe_bmd_sink {
     uatomic_uint32_t ttx;
 
     /** last frame output */
-    upipe_bmd_sink_frame *video_frame;
+    IDeckLinkVideoFrame *video_frame;
+
+    /** manager of pictures allocated on the card output */
+    struct ubuf_mgr *ubuf_mgr;
 
     /** current timing adjustement */
     int64_t timing_adjustment;
@@ -377,8 +383,9 @@ public:
             return S_OK;
 
         if (pts == 0) {
-            /* preroll has ended, set up our counter */
-            pts = ((upipe_bmd_sink_frame*)frame)->pts;
+            /* preroll has ended, set up our counter, the first completed
+             * frame being the first scheduled one */
+            pts = upipe_bmd_sink->start_pts;
             pts += PREROLL_FRAMES * upipe_bmd_sink->ticks_per_frame;
         }
 
@@ -841,7 +848,7 @@ static unsigned upipe_bmd_sink_sub_sound_get_samples(struct upipe *upipe,
     return samples;
 }
 
-static upipe_bmd_sink_frame *get_video_frame(struct upipe *upipe,
+static IDeckLinkVideoFrame *get_video_frame(struct upipe *upipe,
     uint64_t pts, struct uref *uref)
 {
     struct upipe_bmd_sink *upipe_bmd_sink = upipe_bmd_sink_from_upipe(upipe);
@@ -862,21 +869,33 @@ static upipe_bmd_sink_frame *get_video_frame(struct upipe *upipe,
         return upipe_bmd_sink->video_frame;
     }
 
-    const char *v210 = "u10y10v10y10u10y10v10y10u10y10v10y10";
-    size_t stride;
-    const uint8_t *plane;
-    if (unlikely(!ubase_check(uref_pic_plane_size(uref, v210, &stride,
-                        NULL, NULL, NULL)) ||
-                !ubase_check(uref_pic_plane_read(uref, v210, 0, 0, -1, -1,
-                        &plane)))) {
-        upipe_err_va(upipe, "Could not read v210 plane");
-        return NULL;
-    }
-    upipe_bmd_sink_frame *video_frame = new upipe_bmd_sink_frame(uref,
-            (void*)plane, w, h, stride, pts);
-    if (!video_frame) {
-        uref_free(uref);
-        return NULL;
+    IDeckLinkVideoFrame *video_frame;
+    upipe_bmd_sink_frame *sink_frame = NULL;
+    void *card_frame;
+    if (upipe_bmd_sink->ubuf_mgr != NULL && uref->ubuf != NULL &&
+        uref->ubuf->mgr == upipe_bmd_sink->ubuf_mgr &&
+        ubase_check(ubuf_pic_bmd_get_video_frame(uref->ubuf, &card_frame))) {
+        /* upstream rendered into a frame of the card, schedule it as is */
+        video_frame = (IDeckLinkVideoFrame *)card_frame;
+        video_frame->AddRef();
+    } else {
+        const char *v210 = "u10y10v10y10u10y10v10y10u10y10v10y10";
+        size_t stride;
+        const uint8_t *plane;
+        if (unlikely(!ubase_check(uref_pic_plane_size(uref, v210, &stride,
+                            NULL, NULL, NULL)) ||
+                    !ubase_check(uref_pic_plane_read(uref, v210, 0, 0, -1, -1,
+                            &plane)))) {
+            upipe_err_va(upipe, "Could not read v210 plane");
+            return NULL;
+        }
+        sink_frame = new upipe_bmd_sink_frame(uref,
+                (void*)plane, w, h, stride, pts);
+        if (!sink_frame) {
+            uref_free(uref);
+            return NULL;
+        }
+        video_frame = sink_frame;
     }
 
     if (upipe_bmd_sink->video_frame)
@@ -887,7 +906,12 @@ static upipe_bmd_sink_frame *get_video_frame(struct upipe *upipe,
     HRESULT res = upipe_bmd_sink->deckLinkOutput->CreateAncillaryData(video_frame->GetPixelFormat(), &ancillary);
     if (res != S_OK) {
         upipe_err(upipe, "Could not create ancillary data");
-        delete video_frame;
+        if (sink_frame)
+            delete sink_frame;
+        else {
+            video_frame->Release();
+            uref_free(uref);
+        }
         return NULL;
     }
 
@@ -983,7 +1007,14 @@ static upipe_bmd_sink_frame *get_video_frame(struct upipe *upipe,
 #endif
     }
 
-    video_frame->SetAncillaryData(ancillary);
+    if (sink_frame)
+        sink_frame->SetAncillaryData(ancillary);
+    else {
+        ((IDeckLinkMutableVideoFrame *)video_frame)->SetAncillaryData(ancillary);
+        ancillary->Release();
+        /* the frame holds the picture */
+        uref_free(uref);
+    }
 
     video_frame->AddRef(); // we're gonna buffer this frame
     upipe_bmd_sink->video_frame = video_frame;
@@ -996,7 +1027,7 @@ static void schedule_frame(struct upipe *upipe, struct uref *uref, uint64_t pts)
     HRESULT result;
     struct upipe_bmd_sink *upipe_bmd_sink = upipe_bmd_sink_from_sub_mgr(upipe->mgr);
 
-    upipe_bmd_sink_frame *video_frame = get_video_frame(&upipe_bmd_sink->upipe, pts, uref);
+    IDeckLinkVideoFrame *video_frame = get_video_frame(&upipe_bmd_sink->upipe, pts, uref);
     if (!video_frame)
         return;
 
@@ -1413,6 +1444,35 @@ static int upipe_bmd_sink_sub_set_flow_def(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This provides the pic subpipe with pictures allocated on the
+ * card output, so that upstream pipes render directly into the frames that
+ * are scheduled.
+ *
+ * @param upipe description structure of the pipe
+ * @param request ubuf_mgr request
+ * @return an error code
+ */
+static int upipe_bmd_sink_sub_provide_ubuf_mgr(struct upipe *upipe,
+                                               struct urequest *request)
+{
+    struct upipe_bmd_sink *upipe_bmd_sink =
+        upipe_bmd_sink_from_sub_mgr(upipe->mgr);
+    struct uref *flow_format = request->uref;
+    uint8_t macropixel;
+    if (upipe_bmd_sink->ubuf_mgr == NULL || flow_format == NULL ||
+        !ubase_check(uref_pic_flow_get_macropixel(flow_format, &macropixel)) ||
+        macropixel != 6 ||
+        !ubase_check(uref_pic_flow_check_chroma(flow_format, 1, 1, 16,
+                        "u10y10v10y10u10y10v10y10u10y10v10y10")))
+        return upipe_throw_provide_request(upipe, request);
+
+    flow_format = uref_dup(flow_format);
+    UBASE_ALLOC_RETURN(flow_format)
+    return urequest_provide_ubuf_mgr(request,
+                                     ubuf_mgr_use(upipe_bmd_sink->ubuf_mgr),
+                                     flow_format);
+}
+
 /** @internal @This processes control commands on an output subpipe of an
  * bmd_sink pipe.
  *
@@ -1434,6 +1494,11 @@ static int upipe_bmd_sink_sub_control(struct upipe *upipe,
         }
         case UPIPE_REGISTER_REQUEST: {
             struct urequest *request = va_arg(args, struct urequest *);
+            struct upipe_bmd_sink *upipe_bmd_sink =
+                upipe_bmd_sink_from_sub_mgr(upipe->mgr);
+            if (upipe == &upipe_bmd_sink->pic_subpipe.upipe &&
+                request->type == UREQUEST_UBUF_MGR)
+                return upipe_bmd_sink_sub_provide_ubuf_mgr(upipe, request);
             return upipe_throw_provide_request(upipe, request);
         }
         case UPIPE_UNREGISTER_REQUEST:
@@ -1824,6 +1889,11 @@ static int upipe_bmd_sink_open_card(struct upipe *upipe)
         goto end;
     }
 
+    upipe_bmd_sink->ubuf_mgr = ubuf_pic_bmd_output_mgr_alloc(UBUF_POOL_DEPTH,
+            upipe_bmd_sink->deckLinkOutput, bmdFormat10BitYUV);
+    if (upipe_bmd_sink->ubuf_mgr == NULL)
+        upipe_warn(upipe, "Could not allocate pictures on the card");
+
     upipe_bmd_sink->cb = new callback(upipe_bmd_sink);
     if (upipe_bmd_sink->deckLinkOutput->SetScheduledFrameCompletionCallback(
                 upipe_bmd_sink->cb) != S_OK)
@@ -2107,6 +2177,7 @@ static void upipe_bmd_sink_free(struct upipe *upipe)
 
     if (upipe_bmd_sink->deckLink) {
         free((void*)upipe_bmd_sink->modelName);
+        ubuf_mgr_release(upipe_bmd_sink->ubuf_mgr);
         upipe_bmd_sink->deckLinkOutput->Release();
         upipe_bmd_sink->deckLink->Release();
     }
@@ -2137,7 +2208,9 @@ static struct upipe_mgr upipe_bmd_sink_mgr = {
     /* .upipe_input = */ NULL,
     /* .upipe_control = */ upipe_bmd_sink_control,
 
-    /* .upipe_mgr_control = */ NULL
+    /* .upipe_mgr_control = */ NULL,
+
+    /* .upipe_input_batch = */ NULL
 };
 
 /** @This returns the management structure for bmd_sink pipes
@@ -59,7 +59,7 @@
 
 #include "include/DeckLinkAPI.h"
 
-/** uqueue length */
+/** default uqueue length */
 #define MAX_QUEUE_LENGTH 255
 /** ubuf pool depth */
 #define UBUF_POOL_DEPTH 25
@@ -253,6 +253,15 @@ struct upipe_bmd_src {
     char *uri;
     /** queue between blackmagic thread and pipe thread */
     struct uqueue uqueue;
+    /** extra data for the queue structure */
+    void *uqueue_extra;
+    /** number of frames dropped because the queue was full */
+    uatomic_uint32_t overruns;
+    /** number of dropped frames already reported */
+    uint32_t overruns_reported;
+    /** true if the sound subpipe has an output - for use by the private
+     * thread */
+    uatomic_uint32_t sound_output;
     /** handle to decklink card */
     IDeckLink *deckLink;
     /** handle to decklink card input */
@@ -284,9 +293,6 @@ struct upipe_bmd_src {
 
     /** public upipe structure */
     struct upipe upipe;
-
-    /** extra data for the queue structures */
-    uint8_t uqueue_extra[];
 };
 
 UPIPE_HELPER_UPIPE(upipe_bmd_src, upipe, UPIPE_BMD_SRC_SIGNATURE)
@@ -545,12 +551,15 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(
             else if (upipe_bmd_src->tff)
                 uref_pic_set_tff(uref);
 
-            if (!uqueue_push(&upipe_bmd_src->uqueue, uref))
+            if (!uqueue_push(&upipe_bmd_src->uqueue, uref)) {
+                uatomic_fetch_add(&upipe_bmd_src->overruns, 1);
                 uref_free(uref);
+            }
         }
     }
 
-    if (AudioPacket) {
+    /* audio packets are only referenced if they are going to be output */
+    if (AudioPacket && uatomic_load(&upipe_bmd_src->sound_output)) {
         struct ubuf *ubuf =
             ubuf_sound_bmd_alloc(upipe_bmd_src->sound_subpipe.ubuf_mgr,
                                  AudioPacket);
@@ -568,8 +577,10 @@ HRESULT DeckLinkCaptureDelegate::VideoInputFrameArrived(
             uref_clock_set_duration(uref, AudioPacket->GetSampleFrameCount() *
                                           UCLOCK_FREQ / BMD_SAMPLERATE);
 
-            if (!uqueue_push(&upipe_bmd_src->uqueue, uref))
+            if (!uqueue_push(&upipe_bmd_src->uqueue, uref)) {
+                uatomic_fetch_add(&upipe_bmd_src->overruns, 1);
                 uref_free(uref);
+            }
         }
     }
     return S_OK;
@@ -606,9 +617,19 @@ static int upipe_bmd_src_output_control(struct upipe *upipe,
                                         int command, va_list args)
 {
     switch (command) {
+        case UPIPE_SET_OUTPUT: {
+            struct upipe_bmd_src *upipe_bmd_src =
+                upipe_bmd_src_from_sub_mgr(upipe->mgr);
+            UBASE_RETURN(upipe_bmd_src_output_control_output(upipe, command,
+                                                             args))
+            if (upipe == upipe_bmd_src_output_to_upipe(
+                        upipe_bmd_src_to_sound_subpipe(upipe_bmd_src)))
+                uatomic_store(&upipe_bmd_src->sound_output,
+                              upipe_bmd_src->sound_subpipe.output != NULL);
+            return UBASE_ERR_NONE;
+        }
         case UPIPE_GET_FLOW_DEF:
         case UPIPE_GET_OUTPUT:
-        case UPIPE_SET_OUTPUT:
             return upipe_bmd_src_output_control_output(upipe, command, args);
         case UPIPE_SUB_GET_SUPER: {
             struct upipe **p = va_arg(args, struct upipe **);
@@ -666,9 +687,11 @@ static struct upipe *_upipe_bmd_src_alloc(struct upipe_mgr *mgr,
     struct uprobe *uprobe_sound = va_arg(args, struct uprobe *);
 
     struct upipe_bmd_src *upipe_bmd_src =
-        (struct upipe_bmd_src *)malloc(sizeof(struct upipe_bmd_src) +
-                                       uqueue_sizeof(MAX_QUEUE_LENGTH));
-    if (unlikely(upipe_bmd_src == NULL)) {
+        (struct upipe_bmd_src *)malloc(sizeof(struct upipe_bmd_src));
+    void *uqueue_extra = malloc(uqueue_sizeof(MAX_QUEUE_LENGTH));
+    if (unlikely(upipe_bmd_src == NULL || uqueue_extra == NULL)) {
+        free(upipe_bmd_src);
+        free(uqueue_extra);
         uprobe_release(uprobe_pic);
         uprobe_release(uprobe_sound);
         return NULL;
@@ -693,8 +716,12 @@ static struct upipe *_upipe_bmd_src_alloc(struct upipe_mgr *mgr,
                                 upipe_bmd_src_to_sound_subpipe(upipe_bmd_src)),
                               &upipe_bmd_src->sub_mgr, uprobe_sound);
 
+    upipe_bmd_src->uqueue_extra = uqueue_extra;
     uqueue_init(&upipe_bmd_src->uqueue, MAX_QUEUE_LENGTH,
                 upipe_bmd_src->uqueue_extra);
+    uatomic_init(&upipe_bmd_src->overruns, 0);
+    upipe_bmd_src->overruns_reported = 0;
+    uatomic_init(&upipe_bmd_src->sound_output, 0);
     upipe_bmd_src->uri = NULL;
     upipe_bmd_src->deckLink = NULL;
     upipe_bmd_src->deckLinkInput = NULL;
@@ -723,6 +750,13 @@ static void upipe_bmd_src_work(struct upipe *upipe, struct upump *upump)
     struct upipe_bmd_src *upipe_bmd_src = upipe_bmd_src_from_upipe(upipe);
     struct uref *uref;
 
+    uint32_t overruns = uatomic_load(&upipe_bmd_src->overruns);
+    if (unlikely(overruns != upipe_bmd_src->overruns_reported)) {
+        upipe_warn_va(upipe, "queue overrun, %" PRIu32 " frames dropped",
+                      overruns - upipe_bmd_src->overruns_reported);
+        upipe_bmd_src->overruns_reported = overruns;
+    }
+
     /* unqueue urefs */
     while ((uref = uqueue_pop(&upipe_bmd_src->uqueue, struct uref *))) {
         uint64_t type;
@@ -1281,6 +1315,34 @@ static int upipe_bmd_src_set_uri(struct upipe *upipe, const char *uri)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the length of the queue between the capture thread
+ * and the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param queue_length number of captured frames and audio packets
+ * @return an error code
+ */
+static int upipe_bmd_src_set_queue_length_real(struct upipe *upipe,
+                                               unsigned int queue_length)
+{
+    struct upipe_bmd_src *upipe_bmd_src = upipe_bmd_src_from_upipe(upipe);
+    if (unlikely(upipe_bmd_src->uri != NULL)) {
+        upipe_err(upipe, "queue length must be set before the URI");
+        return UBASE_ERR_BUSY;
+    }
+    if (unlikely(!queue_length || queue_length > UMPMC_MAX_LENGTH))
+        return UBASE_ERR_INVALID;
+
+    void *uqueue_extra = malloc(uqueue_sizeof(queue_length));
+    UBASE_ALLOC_RETURN(uqueue_extra)
+    uqueue_clean(&upipe_bmd_src->uqueue);
+    free(upipe_bmd_src->uqueue_extra);
+    upipe_bmd_src->uqueue_extra = uqueue_extra;
+    uqueue_init(&upipe_bmd_src->uqueue, queue_length,
+                upipe_bmd_src->uqueue_extra);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a blackmagic source pipe.
  *
  * @param upipe description structure of the pipe
@@ -1334,6 +1396,18 @@ static int _upipe_bmd_src_control(struct upipe *upipe,
                         upipe_bmd_src_from_upipe(upipe)));
             return UBASE_ERR_NONE;
         }
+        case UPIPE_BMD_SRC_SET_QUEUE_LENGTH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_BMD_SRC_SIGNATURE)
+            unsigned int queue_length = va_arg(args, unsigned int);
+            return upipe_bmd_src_set_queue_length_real(upipe, queue_length);
+        }
+        case UPIPE_BMD_SRC_GET_OVERRUNS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_BMD_SRC_SIGNATURE)
+            uint64_t *overruns_p = va_arg(args, uint64_t *);
+            *overruns_p = uatomic_load(
+                    &upipe_bmd_src_from_upipe(upipe)->overruns);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -1390,6 +1464,9 @@ static void upipe_bmd_src_free(struct upipe *upipe)
         upipe_bmd_src->deckLink->Release();
     upipe_bmd_src_work(upipe, NULL);
     uqueue_clean(&upipe_bmd_src->uqueue);
+    free(upipe_bmd_src->uqueue_extra);
+    uatomic_clean(&upipe_bmd_src->overruns);
+    uatomic_clean(&upipe_bmd_src->sound_output);
 
     ubuf_mgr_release(upipe_bmd_src->pic_subpipe.ubuf_mgr);
     ubuf_mgr_release(upipe_bmd_src->sound_subpipe.ubuf_mgr);
@@ -1430,7 +1507,9 @@ static struct upipe_mgr upipe_bmd_src_mgr = {
     /* .upipe_input = */ NULL,
     /* .upipe_control = */ upipe_bmd_src_control,
 
-    /* .upipe_mgr_control = */ NULL
+    /* .upipe_mgr_control = */ NULL,
+
+    /* .upipe_input_batch = */ NULL
 };
 }
 
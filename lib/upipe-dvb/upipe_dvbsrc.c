@@ -23,11 +23,13 @@
  */
 
 #include "upipe/ubase.h"
+#include "upipe/uclock.h"
 #include "upipe/uref.h"
 #include "upipe/uref_block.h"
 #include "upipe/uref_block_flow.h"
 #include "upipe/upump.h"
 #include "upipe/upipe.h"
+#include "upipe/uts_pid_filter.h"
 
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -44,8 +46,19 @@
 #include <libdvbv5/dvb-dev.h>
 #include <libdvbv5/dvb-fe.h>
 
+#include <sys/ioctl.h>
+#include <linux/dvb/dmx.h>
 
-#define MTU (7 * 188)
+/** size of a TS packet */
+#define TS_SIZE 188
+/** size of the buffers read from the demux */
+#define READ_SIZE (256 * TS_SIZE)
+/** alignment of the buffers read from the demux */
+#define READ_ALIGN 64
+/** size of the kernel demux buffer */
+#define DEMUX_BUFFER_SIZE (2 * 96 * 7 * TS_SIZE)
+/** PID selecting the whole transport stream */
+#define WHOLE_TS_PID 0x2000
 
 /** @hidden */
 static int upipe_dvbsrc_check(struct upipe *upipe, struct uref *flow_format);
@@ -85,6 +98,15 @@ struct upipe_dvbsrc {
     struct upump_mgr *upump_mgr;
     /** read watcher */
     struct upump *upump;
+    /** frontend statistics timer */
+    struct upump *upump_stats;
+    /** period of the frontend statistics events, or 0 */
+    uint64_t stats_period;
+
+    /** hardware PID filter, or NULL to output the whole transport stream */
+    struct uts_pid_filter *pid_filter;
+    /** number of PIDs programmed in the demux */
+    unsigned int nb_pids;
 
     /** DVB receiver uri */
     char *uri;
@@ -121,6 +143,7 @@ UPIPE_HELPER_UCLOCK(upipe_dvbsrc, uclock, uclock_request, upipe_dvbsrc_check,
 
 UPIPE_HELPER_UPUMP_MGR(upipe_dvbsrc, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_dvbsrc, upump, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_dvbsrc, upump_stats, upump_mgr)
 
 UBASE_FMT_PRINTF(3, 4)
 static void upipe_dvbsrc_log(void *priv, int level, const char *fmt, ...)
@@ -181,7 +204,11 @@ static struct upipe *upipe_dvbsrc_alloc(struct upipe_mgr *mgr,
     upipe_dvbsrc_init_output(upipe);
     upipe_dvbsrc_init_upump_mgr(upipe);
     upipe_dvbsrc_init_upump(upipe);
+    upipe_dvbsrc_init_upump_stats(upipe);
     upipe_dvbsrc_init_uclock(upipe);
+    upipe_dvbsrc->stats_period = 0;
+    upipe_dvbsrc->pid_filter = NULL;
+    upipe_dvbsrc->nb_pids = 0;
     upipe_dvbsrc->uri = NULL;
     upipe_dvbsrc->demux = NULL;
     upipe_dvbsrc->frontend = NULL;
@@ -204,7 +231,7 @@ static void upipe_dvbsrc_worker(struct upump *upump)
     struct upipe_dvbsrc *upipe_dvbsrc = upipe_dvbsrc_from_upipe(upipe);
 
     struct uref *uref = uref_block_alloc(upipe_dvbsrc->uref_mgr,
-            upipe_dvbsrc->ubuf_mgr, MTU);
+            upipe_dvbsrc->ubuf_mgr, READ_SIZE);
 
     if (unlikely(uref == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
@@ -220,7 +247,7 @@ static void upipe_dvbsrc_worker(struct upump *upump)
         return;
     }
 
-    ssize_t ret = dvb_dev_read(upipe_dvbsrc->demux, buffer, MTU);
+    ssize_t ret = dvb_dev_read(upipe_dvbsrc->demux, buffer, READ_SIZE);
     uref_block_unmap(uref, 0);
 
     if (unlikely(ret < 0)) {
@@ -228,14 +255,129 @@ static void upipe_dvbsrc_worker(struct upump *upump)
             upipe_err_va(upipe, "read failed: %m");
         uref_free(uref);
         return;
-    } else if (ret < MTU) {
-        upipe_verbose_va(upipe, "incomplete read: %zd < %u", ret, MTU);
+    } else if (ret < READ_SIZE) {
         uref_block_resize(uref, 0, ret);
     }
 
     upipe_dvbsrc_output(upipe, uref, &upipe_dvbsrc->upump);
 }
 
+/** @internal @This throws the frontend statistics.
+ *
+ * @param upump description structure of the statistics timer
+ */
+static void upipe_dvbsrc_stats_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_dvbsrc *upipe_dvbsrc = upipe_dvbsrc_from_upipe(upipe);
+    struct dvb_v5_fe_parms *parms = upipe_dvbsrc->dvb->fe_parms;
+
+    if (dvb_fe_get_stats(parms) < 0) {
+        upipe_warn(upipe, "could not get frontend stats");
+        return;
+    }
+
+    struct upipe_dvbsrc_frontend_stats stats;
+    memset(&stats, 0, sizeof (stats));
+    dvb_fe_retrieve_stats(parms, DTV_STATUS, &stats.status);
+
+    struct dtv_stats *st =
+        dvb_fe_retrieve_stats_layer(parms, DTV_STAT_SIGNAL_STRENGTH, 0);
+    if (st != NULL)
+        stats.strength = *st;
+    else
+        stats.strength.scale = FE_SCALE_NOT_AVAILABLE;
+    st = dvb_fe_retrieve_stats_layer(parms, DTV_STAT_CNR, 0);
+    if (st != NULL)
+        stats.cnr = *st;
+    else
+        stats.cnr.scale = FE_SCALE_NOT_AVAILABLE;
+
+    enum fecap_scale_params scale;
+    stats.ber = dvb_fe_retrieve_ber(parms, 0, &scale);
+    if (scale == FE_SCALE_NOT_AVAILABLE)
+        stats.ber = -1;
+    dvb_fe_retrieve_stats(parms, DTV_STAT_ERROR_BLOCK_COUNT,
+                          &stats.error_blocks);
+
+    upipe_throw(upipe, UPROBE_DVBSRC_FRONTEND_STATS, UPIPE_DVBSRC_SIGNATURE,
+                &stats);
+}
+
+/** @internal @This adds a PID to the demux filter, the first PID setting up
+ * the filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to add
+ * @return an error code
+ */
+static int upipe_dvbsrc_add_demux_pid(struct upipe *upipe, uint16_t pid)
+{
+    struct upipe_dvbsrc *upipe_dvbsrc = upipe_dvbsrc_from_upipe(upipe);
+
+    if (!upipe_dvbsrc->nb_pids) {
+        if (dvb_dev_dmx_set_pesfilter(upipe_dvbsrc->demux, pid,
+                    DMX_PES_OTHER, DMX_OUT_TSDEMUX_TAP,
+                    DEMUX_BUFFER_SIZE) < 0) {
+            upipe_err(upipe, "could not setup demux filter");
+            return UBASE_ERR_EXTERNAL;
+        }
+    } else if (ioctl(dvb_dev_get_fd(upipe_dvbsrc->demux),
+                     DMX_ADD_PID, &pid) < 0) {
+        upipe_err_va(upipe, "could not add PID %"PRIu16" to demux: %m", pid);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_dvbsrc->nb_pids++;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This removes a PID from the demux filter, the last PID
+ * stopping the filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to remove
+ * @return an error code
+ */
+static int upipe_dvbsrc_del_demux_pid(struct upipe *upipe, uint16_t pid)
+{
+    struct upipe_dvbsrc *upipe_dvbsrc = upipe_dvbsrc_from_upipe(upipe);
+
+    if (upipe_dvbsrc->nb_pids == 1)
+        dvb_dev_dmx_stop(upipe_dvbsrc->demux);
+    else if (ioctl(dvb_dev_get_fd(upipe_dvbsrc->demux),
+                   DMX_REMOVE_PID, &pid) < 0) {
+        upipe_err_va(upipe, "could not remove PID %"PRIu16" from demux: %m",
+                     pid);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_dvbsrc->nb_pids--;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This programs the demux with the selected PIDs, or the whole
+ * transport stream if the PID filter is disabled.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_dvbsrc_set_demux_filter(struct upipe *upipe)
+{
+    struct upipe_dvbsrc *upipe_dvbsrc = upipe_dvbsrc_from_upipe(upipe);
+    if (upipe_dvbsrc->demux == NULL)
+        return UBASE_ERR_NONE;
+
+    dvb_dev_dmx_stop(upipe_dvbsrc->demux);
+    upipe_dvbsrc->nb_pids = 0;
+
+    if (upipe_dvbsrc->pid_filter == NULL)
+        return upipe_dvbsrc_add_demux_pid(upipe, WHOLE_TS_PID);
+
+    for (uint16_t pid = 0; pid < UTS_PID_FILTER_PIDS; pid++)
+        if (uts_pid_filter_check(upipe_dvbsrc->pid_filter, pid))
+            UBASE_RETURN(upipe_dvbsrc_add_demux_pid(upipe, pid))
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This checks if the pump may be allocated.
  *
  * @param upipe description structure of the pipe
@@ -262,11 +404,12 @@ static int upipe_dvbsrc_check(struct upipe *upipe, struct uref *flow_format)
     if (upipe_dvbsrc->ubuf_mgr == NULL) {
         struct uref *flow_format =
             uref_block_flow_alloc_def(upipe_dvbsrc->uref_mgr, NULL);
-        uref_block_flow_set_size(flow_format, MTU);
         if (unlikely(flow_format == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return UBASE_ERR_ALLOC;
         }
+        uref_block_flow_set_size(flow_format, READ_SIZE);
+        uref_block_flow_set_align(flow_format, READ_ALIGN);
         upipe_dvbsrc_require_ubuf_mgr(upipe, flow_format);
         return UBASE_ERR_NONE;
     }
@@ -294,6 +437,19 @@ static int upipe_dvbsrc_check(struct upipe *upipe, struct uref *flow_format)
         upipe_dvbsrc_set_upump(upipe, upump);
         upump_start(upump);
     }
+
+    if (upipe_dvbsrc->upump_stats == NULL && upipe_dvbsrc->stats_period &&
+        upipe_dvbsrc->frontend != NULL) {
+        struct upump *upump = upump_alloc_timer(upipe_dvbsrc->upump_mgr,
+                upipe_dvbsrc_stats_worker, upipe, upipe->refcount,
+                upipe_dvbsrc->stats_period, upipe_dvbsrc->stats_period);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_dvbsrc_set_upump_stats(upipe, upump);
+        upump_start(upump);
+    }
     return UBASE_ERR_NONE;
 }
 
@@ -329,6 +485,7 @@ static int upipe_dvbsrc_set_uri(struct upipe *upipe, const char *uri)
             dvb_dev_dmx_stop(upipe_dvbsrc->demux);
             dvb_dev_close(upipe_dvbsrc->demux);
             upipe_dvbsrc->demux = NULL;
+            upipe_dvbsrc->nb_pids = 0;
         }
 
         if (upipe_dvbsrc->frontend) {
@@ -338,6 +495,7 @@ static int upipe_dvbsrc_set_uri(struct upipe *upipe, const char *uri)
     }
 
     upipe_dvbsrc_set_upump(upipe, NULL);
+    upipe_dvbsrc_set_upump_stats(upipe, NULL);
 
     if (unlikely(uri == NULL))
         return UBASE_ERR_NONE;
@@ -391,9 +549,7 @@ static int upipe_dvbsrc_set_uri(struct upipe *upipe, const char *uri)
     struct dvb_v5_fe_parms *parms = upipe_dvbsrc->dvb->fe_parms;
     dvb_fe_get_parms(parms);
 
-    if (dvb_dev_dmx_set_pesfilter(upipe_dvbsrc->demux, 0x2000, DMX_PES_OTHER,
-                DMX_OUT_TAP, 2*96*MTU) < 0) {
-        upipe_err(upipe, "could not setup demux filter");
+    if (!ubase_check(upipe_dvbsrc_set_demux_filter(upipe))) {
         dvb_dev_close(upipe_dvbsrc->frontend);
         upipe_dvbsrc->frontend = NULL;
         goto free_demux;
@@ -404,9 +560,63 @@ static int upipe_dvbsrc_set_uri(struct upipe *upipe, const char *uri)
 free_demux:
     dvb_dev_close(upipe_dvbsrc->demux);
     upipe_dvbsrc->demux = NULL;
+    upipe_dvbsrc->nb_pids = 0;
     return UBASE_ERR_INVALID;
 }
 
+/** @internal @This enables or disables the hardware PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to enable the filter
+ * @return an error code
+ */
+static int _upipe_dvbsrc_set_pid_filter(struct upipe *upipe, bool enabled)
+{
+    struct upipe_dvbsrc *upipe_dvbsrc = upipe_dvbsrc_from_upipe(upipe);
+    if (!enabled) {
+        if (upipe_dvbsrc->pid_filter == NULL)
+            return UBASE_ERR_NONE;
+        free(upipe_dvbsrc->pid_filter);
+        upipe_dvbsrc->pid_filter = NULL;
+        return upipe_dvbsrc_set_demux_filter(upipe);
+    }
+    if (upipe_dvbsrc->pid_filter != NULL)
+        return UBASE_ERR_NONE;
+
+    upipe_dvbsrc->pid_filter = malloc(sizeof(struct uts_pid_filter));
+    if (unlikely(upipe_dvbsrc->pid_filter == NULL))
+        return UBASE_ERR_ALLOC;
+    uts_pid_filter_init(upipe_dvbsrc->pid_filter);
+    return upipe_dvbsrc_set_demux_filter(upipe);
+}
+
+/** @internal @This selects or unselects a PID in the hardware PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to change
+ * @param selected true to select the PID
+ * @return an error code
+ */
+static int _upipe_dvbsrc_set_pid(struct upipe *upipe, unsigned int pid,
+                                 bool selected)
+{
+    struct upipe_dvbsrc *upipe_dvbsrc = upipe_dvbsrc_from_upipe(upipe);
+    if (unlikely(upipe_dvbsrc->pid_filter == NULL ||
+                 pid >= UTS_PID_FILTER_PIDS))
+        return UBASE_ERR_INVALID;
+    if (uts_pid_filter_check(upipe_dvbsrc->pid_filter, pid) == selected)
+        return UBASE_ERR_NONE;
+
+    if (selected)
+        uts_pid_filter_add(upipe_dvbsrc->pid_filter, pid);
+    else
+        uts_pid_filter_del(upipe_dvbsrc->pid_filter, pid);
+    if (upipe_dvbsrc->demux == NULL)
+        return UBASE_ERR_NONE;
+    return selected ? upipe_dvbsrc_add_demux_pid(upipe, pid) :
+                      upipe_dvbsrc_del_demux_pid(upipe, pid);
+}
+
 /** @internal */
 static enum fe_code_rate get_fec_code(const char *val)
 {
@@ -520,6 +730,7 @@ static int _upipe_dvbsrc_control(struct upipe *upipe,
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_dvbsrc_set_upump(upipe, NULL);
+            upipe_dvbsrc_set_upump_stats(upipe, NULL);
             return upipe_dvbsrc_attach_upump_mgr(upipe);
         case UPIPE_ATTACH_UCLOCK:
             upipe_dvbsrc_set_upump(upipe, NULL);
@@ -575,6 +786,28 @@ static int _upipe_dvbsrc_control(struct upipe *upipe,
             return UBASE_ERR_NONE;
         }
 
+        case UPIPE_DVBSRC_SET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBSRC_SIGNATURE)
+            int enabled = va_arg(args, int);
+            return _upipe_dvbsrc_set_pid_filter(upipe, !!enabled);
+        }
+        case UPIPE_DVBSRC_ADD_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBSRC_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            return _upipe_dvbsrc_set_pid(upipe, pid, true);
+        }
+        case UPIPE_DVBSRC_DEL_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBSRC_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            return _upipe_dvbsrc_set_pid(upipe, pid, false);
+        }
+        case UPIPE_DVBSRC_SET_STATS_PERIOD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBSRC_SIGNATURE)
+            upipe_dvbsrc->stats_period = va_arg(args, uint64_t);
+            upipe_dvbsrc_set_upump_stats(upipe, NULL);
+            return UBASE_ERR_NONE;
+        }
+
         case UPIPE_GET_FLOW_DEF:
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
@@ -630,9 +863,11 @@ static void upipe_dvbsrc_free(struct upipe *upipe)
     dvb_dev_free(upipe_dvbsrc->dvb);
 
     free(upipe_dvbsrc->uri);
+    free(upipe_dvbsrc->pid_filter);
 
     upipe_dvbsrc_clean_uclock(upipe);
     upipe_dvbsrc_clean_upump(upipe);
+    upipe_dvbsrc_clean_upump_stats(upipe);
     upipe_dvbsrc_clean_upump_mgr(upipe);
     upipe_dvbsrc_clean_output(upipe);
     upipe_dvbsrc_clean_ubuf_mgr(upipe);
@@ -29,26 +29,22 @@
 #include "upipe/ubase.h"
 #include "upipe/uclock.h"
 
+#include <string.h>
+
 /** default maximum latency */
 #define UPIPE_DVBCSA_MAX_LATENCY UCLOCK_FREQ
 
-/** @This is the item of a pid list. */
-struct upipe_dvbcsa_common_pid {
-    /** link into the list */
-    struct uchain uchain;
-    /** value */
-    uint64_t value;
-};
-
-/** @hidden */
-UBASE_FROM_TO(upipe_dvbcsa_common_pid, uchain, uchain, uchain);
+/** maximum number of pids */
+#define UPIPE_DVBCSA_MAX_PIDS 8192
 
 /** @This is the common structure for dvbcsa pipes. */
 struct upipe_dvbcsa_common {
-    /** list of pids */
-    struct uchain pids;
+    /** pids to encrypt/decrypt, indexed by pid */
+    bool pids[UPIPE_DVBCSA_MAX_PIDS];
     /** maximum latency */
     uint64_t latency;
+    /** batch statistics */
+    struct upipe_dvbcsa_stats stats;
 };
 
 /** @This initializes the common structure.
@@ -58,7 +54,8 @@ struct upipe_dvbcsa_common {
 static inline void upipe_dvbcsa_common_init(struct upipe_dvbcsa_common *common)
 {
     common->latency = UPIPE_DVBCSA_MAX_LATENCY;
-    ulist_init(&common->pids);
+    memset(common->pids, 0, sizeof (common->pids));
+    memset(&common->stats, 0, sizeof (common->stats));
 }
 
 /** @This cleans the common structure.
@@ -68,28 +65,6 @@ static inline void upipe_dvbcsa_common_init(struct upipe_dvbcsa_common *common)
 static inline void
 upipe_dvbcsa_common_clean(struct upipe_dvbcsa_common *common)
 {
-    struct uchain *uchain;
-    while ((uchain = ulist_pop(&common->pids)))
-        free(upipe_dvbcsa_common_pid_from_uchain(uchain));
-}
-
-/** @This gets a pid item from the list.
- *
- * @param common pointer to the common structure
- * @param value pid value to look for
- * @return a pointer to the item or NULL if not found
- */
-static inline struct upipe_dvbcsa_common_pid *
-upipe_dvbcsa_common_get_pid(struct upipe_dvbcsa_common *common, uint64_t value)
-{
-    struct uchain *uchain;
-    ulist_foreach(&common->pids, uchain) {
-        struct upipe_dvbcsa_common_pid *pid =
-            upipe_dvbcsa_common_pid_from_uchain(uchain);
-        if (pid->value == value)
-            return pid;
-    }
-    return NULL;
 }
 
 /** @This adds a pid into the list if needed.
@@ -101,15 +76,9 @@ upipe_dvbcsa_common_get_pid(struct upipe_dvbcsa_common *common, uint64_t value)
 static inline int
 upipe_dvbcsa_common_add_pid(struct upipe_dvbcsa_common *common, uint64_t value)
 {
-    struct upipe_dvbcsa_common_pid *pid =
-        upipe_dvbcsa_common_get_pid(common, value);
-    if (pid)
-        return UBASE_ERR_NONE;
-
-    pid = malloc(sizeof (*pid));
-    UBASE_ALLOC_RETURN(pid);
-    pid->value = value;
-    ulist_add(&common->pids, &pid->uchain);
+    if (unlikely(value >= UPIPE_DVBCSA_MAX_PIDS))
+        return UBASE_ERR_INVALID;
+    common->pids[value] = true;
     return UBASE_ERR_NONE;
 }
 
@@ -121,12 +90,8 @@ upipe_dvbcsa_common_add_pid(struct upipe_dvbcsa_common *common, uint64_t value)
 static inline void
 upipe_dvbcsa_common_del_pid(struct upipe_dvbcsa_common *common, uint64_t value)
 {
-    struct upipe_dvbcsa_common_pid *pid =
-        upipe_dvbcsa_common_get_pid(common, value);
-    if (pid) {
-        ulist_delete(&pid->uchain);
-        free(pid);
-    }
+    if (likely(value < UPIPE_DVBCSA_MAX_PIDS))
+        common->pids[value] = false;
 }
 
 /** @This checks if a pid is present in the list.
@@ -139,7 +104,25 @@ static inline bool
 upipe_dvbcsa_common_check_pid(struct upipe_dvbcsa_common *common,
                               uint64_t value)
 {
-    return upipe_dvbcsa_common_get_pid(common, value) ? true : false;
+    return value < UPIPE_DVBCSA_MAX_PIDS && common->pids[value];
+}
+
+/** @This accounts a processed batch.
+ *
+ * @param common pointer to the common structure
+ * @param packets number of packets in the batch
+ * @param full true if the batch was flushed because it was full
+ * @param duration time spent processing the batch
+ */
+static inline void
+upipe_dvbcsa_common_add_batch(struct upipe_dvbcsa_common *common,
+                              unsigned packets, bool full, uint64_t duration)
+{
+    common->stats.batches++;
+    common->stats.packets += packets;
+    if (full)
+        common->stats.full_batches++;
+    common->stats.duration += duration;
 }
 
 /** @This sets the maximum latency of a dvbcsa pipe.
@@ -192,6 +175,14 @@ upipe_dvbcsa_common_control(struct upipe_dvbcsa_common *common,
             uint64_t latency = va_arg(args, uint64_t);
             return upipe_dvbcsa_common_set_max_latency(common, latency);
         }
+
+        case UPIPE_DVBCSA_GET_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_DVBCSA_COMMON_SIGNATURE);
+            struct upipe_dvbcsa_stats *stats =
+                va_arg(args, struct upipe_dvbcsa_stats *);
+            *stats = common->stats;
+            return UBASE_ERR_NONE;
+        }
     }
 
     va_end(args_copy);
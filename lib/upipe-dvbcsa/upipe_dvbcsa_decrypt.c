@@ -328,6 +328,9 @@ static void upipe_dvbcsa_dec_flush(struct upipe *upipe,
         if ((after - before) > DVBCSA_LATENCY)
             upipe_warn_va(upipe, "dvbcsa latency too high %"PRIu64 "ms",
                           (after - before) / (UCLOCK_FREQ / 1000));
+        upipe_dvbcsa_common_add_batch(&upipe_dvbcsa_dec->common, current,
+                                      current >= upipe_dvbcsa_dec->batch_size,
+                                      after - before);
         for (unsigned i = 0; i < current; i++)
             uref_block_unmap(upipe_dvbcsa_dec->mapped[i], 0);
     }
@@ -488,8 +491,11 @@ static void upipe_dvbcsa_dec_input(struct upipe *upipe,
 
     /* biss mode */
 
-    if (!first && upipe_dvbcsa_dec->odd != odd)
+    if (!first && upipe_dvbcsa_dec->odd != odd) {
+        /* a batch is descrambled with a single key */
         upipe_dvbcsa_dec_flush(upipe, upump_p);
+        first = true;
+    }
     upipe_dvbcsa_dec->odd = odd;
 
     unsigned current = upipe_dvbcsa_dec->current;
@@ -281,7 +281,10 @@ static void upipe_dvbcsa_enc_flush(struct upipe *upipe,
         uint64_t after = uclock_now(upipe_dvbcsa_enc->uclock);
         if ((after - before) > DVBCSA_LATENCY)
             upipe_warn_va(upipe, "dvbcsa latency too high %"PRIu64 "ms",
-                          (after - before) / 1000);
+                          (after - before) / (UCLOCK_FREQ / 1000));
+        upipe_dvbcsa_common_add_batch(&upipe_dvbcsa_enc->common, current,
+                                      current >= upipe_dvbcsa_enc->batch_size,
+                                      after - before);
         for (unsigned i = 0; i < current; i++)
             uref_block_unmap(upipe_dvbcsa_enc->mapped[i], 0);
     }
@@ -415,7 +418,7 @@ static void upipe_dvbcsa_enc_input(struct upipe *upipe,
         return upipe_dvbcsa_enc_output(upipe, uref, upump_p);
     }
 
-    uint8_t current = upipe_dvbcsa_enc->current;
+    unsigned current = upipe_dvbcsa_enc->current;
     upipe_dvbcsa_enc->batch[current].data = ts + ts_header_size;
     upipe_dvbcsa_enc->batch[current].len = size - ts_header_size;
     upipe_dvbcsa_enc->mapped[current] = uref;
@@ -55,6 +55,16 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+
+/** size of the driver buffers */
+#define ASI_BUFSIZE (6 * (188 + 8))
+/** number of driver buffers */
+#define ASI_BUFFERS 500
+/** period of the driver FIFO checks in FIFO mode */
+#define FIFO_PERIOD (UCLOCK_FREQ / 100)
+/** maximum number of iovecs written at once in FIFO mode */
+#define FIFO_IOVECS 256
 
 /** @hidden */
 static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
@@ -69,6 +79,8 @@ struct upipe_dveo_asi_sink {
     struct upump_mgr *upump_mgr;
     /** write watcher */
     struct upump *upump;
+    /** driver FIFO timer */
+    struct upump *upump_fifo;
 
     /** file descriptor */
     int fd;
@@ -85,6 +97,12 @@ struct upipe_dveo_asi_sink {
     /** list of blockers */
     struct uchain blockers;
 
+    /** target number of filled driver buffers, or 0 to write each uref
+     * as soon as possible */
+    unsigned int fifo_level;
+    /** urefs waiting to be written in FIFO mode */
+    struct uchain fifo_urefs;
+
     /** hardware clock */
     struct uclock uclock;
     unsigned int last_val;
@@ -102,6 +120,7 @@ UPIPE_HELPER_UREFCOUNT(upipe_dveo_asi_sink, urefcount, upipe_dveo_asi_sink_free)
 UPIPE_HELPER_VOID(upipe_dveo_asi_sink)
 UPIPE_HELPER_UPUMP_MGR(upipe_dveo_asi_sink, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_dveo_asi_sink, upump, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_dveo_asi_sink, upump_fifo, upump_mgr)
 UPIPE_HELPER_INPUT(upipe_dveo_asi_sink, urefs, nb_urefs, max_urefs, blockers, upipe_dveo_asi_sink_output)
 UBASE_FROM_TO(upipe_dveo_asi_sink, uclock, uclock, uclock)
 
@@ -190,7 +209,10 @@ static struct upipe *upipe_dveo_asi_sink_alloc(struct upipe_mgr *mgr,
     upipe_dveo_asi_sink_init_urefcount(upipe);
     upipe_dveo_asi_sink_init_upump_mgr(upipe);
     upipe_dveo_asi_sink_init_upump(upipe);
+    upipe_dveo_asi_sink_init_upump_fifo(upipe);
     upipe_dveo_asi_sink_init_input(upipe);
+    upipe_dveo_asi_sink->fifo_level = 0;
+    ulist_init(&upipe_dveo_asi_sink->fifo_urefs);
     upipe_dveo_asi_sink->fd = -1;
     upipe_dveo_asi_sink->card_idx = 0;
     upipe_dveo_asi_sink->first_timestamp = true;
@@ -203,7 +225,8 @@ static struct upipe *upipe_dveo_asi_sink_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-static void upipe_dveo_asi_sink_stats(struct upipe *upipe)
+static void upipe_dveo_asi_sink_stats(struct upipe *upipe,
+                                      unsigned int *level_p)
 {
     struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
     int fd = upipe_dveo_asi_sink->fd;
@@ -233,6 +256,8 @@ static void upipe_dveo_asi_sink_stats(struct upipe *upipe)
     if (ioctl(fd, ASI_IOC_TXGETBUFLEVEL, &val) < 0)
         upipe_err_va(upipe, "ioctl TXGETBUFLEVEL failed (%m)");
     else {
+        if (level_p != NULL)
+            *level_p = val;
         static int old;
 #define MARGIN 2
         if ((val - MARGIN) >  old || (val + MARGIN) < old) {
@@ -365,21 +390,21 @@ static bool upipe_dveo_asi_sink_add_header(struct upipe *upipe, struct uref *ure
     return false;
 }
 
-/** @internal @This outputs data to the file sink.
+/** @internal @This checks a buffer and prepends its timestamp header.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
- * @param upump_p reference to pump that generated the buffer
- * @return true if the uref was processed
+ * @param first_p filled in with true if the header sets the counter
+ * @return false if the uref was discarded
  */
-static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
-                               struct upump **upump_p)
+static bool upipe_dveo_asi_sink_prepare(struct upipe *upipe, struct uref *uref,
+                                        bool *first_p)
 {
     struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
     const char *def;
     if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
         uref_free(uref);
-        return true;
+        return false;
     }
 
     int fd = upipe_dveo_asi_sink->fd;
@@ -387,14 +412,14 @@ static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
     if (unlikely(fd == -1)) {
         upipe_warn(upipe, "received a buffer before opening the device");
         uref_free(uref);
-        return true;
+        return false;
     }
 
     uint64_t cr_sys = 0;
     if (unlikely(!ubase_check(uref_clock_get_cr_sys(uref, &cr_sys))) || cr_sys == -1) {
         upipe_warn(upipe, "received non-dated buffer");
         uref_free(uref);
-        return true;
+        return false;
     }
 
     if (ubase_check(uref_flow_get_discontinuity(uref))) {
@@ -408,21 +433,39 @@ static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
             upipe_err_va(upipe, "ioctl TXGETTXDfailed (%m)");
             upipe_throw_fatal(upipe, UBASE_ERR_UNKNOWN);
             uref_free(uref);
-            return true;
+            return false;
         } else if (val) {
             upipe_warn(upipe, "Waiting for transmission to stop");
             uref_free(uref);
-            return true;
+            return false;
         }
     }
 
     /* Make sure we set the counter */
-    bool reset_first_timestamp = upipe_dveo_asi_sink->first_timestamp;
+    *first_p = upipe_dveo_asi_sink->first_timestamp;
 
     if (upipe_dveo_asi_sink_add_header(upipe, uref, cr_sys)) {
         uref_free(uref);
-        return true; /* invalid uref, discarded */
+        return false; /* invalid uref, discarded */
     }
+    return true;
+}
+
+/** @internal @This outputs data to the file sink.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ * @return true if the uref was processed
+ */
+static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
+                               struct upump **upump_p)
+{
+    struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
+
+    bool reset_first_timestamp;
+    if (!upipe_dveo_asi_sink_prepare(upipe, uref, &reset_first_timestamp))
+        return true;
 
     if (!upipe_dveo_asi_sink_write(upipe, uref, &reset_first_timestamp))
         return false; /* would block */
@@ -432,11 +475,178 @@ static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
     if (reset_first_timestamp)
         upipe_dveo_asi_sink->first_timestamp = true;
 
-    upipe_dveo_asi_sink_stats(upipe);
+    upipe_dveo_asi_sink_stats(upipe, NULL);
 
     return true;
 }
 
+/** @internal @This drops the urefs waiting in FIFO mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_dveo_asi_sink_flush_fifo(struct upipe *upipe)
+{
+    struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
+    if (ulist_empty(&upipe_dveo_asi_sink->fifo_urefs))
+        return;
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&upipe_dveo_asi_sink->fifo_urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    /* release the pipe used in @ref upipe_dveo_asi_sink_fifo_input */
+    upipe_release(upipe);
+}
+
+/** @internal @This writes the waiting urefs in a single call, up to the
+ * given number of octets.
+ *
+ * @param upipe description structure of the pipe
+ * @param budget maximum number of octets to write
+ */
+static void upipe_dveo_asi_sink_fifo_write(struct upipe *upipe, size_t budget)
+{
+    struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
+    struct iovec iovecs[FIFO_IOVECS];
+    int iovec_count = 0;
+    unsigned int nb_urefs = 0;
+    size_t size = 0;
+
+    struct uchain *uchain;
+    ulist_foreach(&upipe_dveo_asi_sink->fifo_urefs, uchain) {
+        struct uref *uref = uref_from_uchain(uchain);
+        size_t uref_size;
+        int count = uref_block_iovec_count(uref, 0, -1);
+        if (unlikely(count <= 0 ||
+                     !ubase_check(uref_block_size(uref, &uref_size))))
+            break;
+        if (iovec_count + count > FIFO_IOVECS ||
+            (nb_urefs && size + uref_size > budget))
+            break;
+        if (unlikely(!ubase_check(uref_block_iovec_read(uref, 0, -1,
+                                    iovecs + iovec_count))))
+            break;
+        iovec_count += count;
+        size += uref_size;
+        nb_urefs++;
+    }
+
+    if (unlikely(!nb_urefs)) {
+        upipe_warn(upipe, "cannot read ubuf buffer");
+        uchain = ulist_pop(&upipe_dveo_asi_sink->fifo_urefs);
+        uref_free(uref_from_uchain(uchain));
+        if (ulist_empty(&upipe_dveo_asi_sink->fifo_urefs))
+            upipe_release(upipe);
+        return;
+    }
+
+    ssize_t ret = writev(upipe_dveo_asi_sink->fd, iovecs, iovec_count);
+
+    unsigned int i = 0;
+    ulist_foreach(&upipe_dveo_asi_sink->fifo_urefs, uchain) {
+        if (i++ >= nb_urefs)
+            break;
+        uref_block_iovec_unmap(uref_from_uchain(uchain), 0, -1, iovecs);
+    }
+
+    if (unlikely(ret == -1)) {
+        switch (errno) {
+            case EINTR:
+            case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+            case EWOULDBLOCK:
+#endif
+                return;
+            default:
+                break;
+        }
+        upipe_warn_va(upipe, "write error to device %d (%m)", upipe_dveo_asi_sink->card_idx);
+        upipe_dveo_asi_sink->first_timestamp = true;
+        upipe_dveo_asi_sink_set_upump_fifo(upipe, NULL);
+        upipe_dveo_asi_sink_flush_fifo(upipe);
+        upipe_throw_sink_end(upipe);
+        return;
+    }
+
+    while ((uchain = ulist_peek(&upipe_dveo_asi_sink->fifo_urefs)) != NULL) {
+        struct uref *uref = uref_from_uchain(uchain);
+        size_t uref_size;
+        if (unlikely(!ubase_check(uref_block_size(uref, &uref_size))))
+            uref_size = 0;
+        if (uref_size > ret) {
+            if (ret)
+                uref_block_resize(uref, ret, -1);
+            break;
+        }
+        ret -= uref_size;
+        ulist_pop(&upipe_dveo_asi_sink->fifo_urefs);
+        uref_free(uref);
+    }
+
+    if (ulist_empty(&upipe_dveo_asi_sink->fifo_urefs))
+        /* release the pipe used in @ref upipe_dveo_asi_sink_fifo_input */
+        upipe_release(upipe);
+}
+
+/** @internal @This is called periodically in FIFO mode to top up the driver
+ * FIFO to its target level.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_dveo_asi_sink_fifo_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
+
+    unsigned int level = UINT_MAX;
+    upipe_dveo_asi_sink_stats(upipe, &level);
+    if (level >= upipe_dveo_asi_sink->fifo_level ||
+        ulist_empty(&upipe_dveo_asi_sink->fifo_urefs))
+        return;
+
+    upipe_dveo_asi_sink_fifo_write(upipe,
+            (upipe_dveo_asi_sink->fifo_level - level) * ASI_BUFSIZE);
+}
+
+/** @internal @This queues a buffer in FIFO mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ */
+static void upipe_dveo_asi_sink_fifo_input(struct upipe *upipe,
+                                           struct uref *uref)
+{
+    struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
+
+    bool first;
+    if (!upipe_dveo_asi_sink_prepare(upipe, uref, &first))
+        return;
+
+    if (upipe_dveo_asi_sink->upump_fifo == NULL) {
+        if (unlikely(!ubase_check(upipe_dveo_asi_sink_check_upump_mgr(upipe)))) {
+            upipe_err_va(upipe, "can't get upump_mgr");
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            uref_free(uref);
+            return;
+        }
+        struct upump *upump = upump_alloc_timer(upipe_dveo_asi_sink->upump_mgr,
+                upipe_dveo_asi_sink_fifo_worker, upipe, upipe->refcount,
+                0, FIFO_PERIOD);
+        if (unlikely(upump == NULL)) {
+            upipe_err(upipe, "can't create timer");
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            uref_free(uref);
+            return;
+        }
+        upipe_dveo_asi_sink_set_upump_fifo(upipe, upump);
+        upump_start(upump);
+    }
+
+    if (ulist_empty(&upipe_dveo_asi_sink->fifo_urefs))
+        /* keep the pipe until all packets have been sent */
+        upipe_use(upipe);
+    ulist_add(&upipe_dveo_asi_sink->fifo_urefs, uref_to_uchain(uref));
+}
+
 /** @internal @This receives data.
  *
  * @param upipe description structure of the pipe
@@ -446,6 +656,12 @@ static bool upipe_dveo_asi_sink_output(struct upipe *upipe, struct uref *uref,
 static void upipe_dveo_asi_sink_input(struct upipe *upipe, struct uref *uref,
                               struct upump **upump_p)
 {
+    struct upipe_dveo_asi_sink *upipe_dveo_asi_sink = upipe_dveo_asi_sink_from_upipe(upipe);
+    if (upipe_dveo_asi_sink->fifo_level) {
+        upipe_dveo_asi_sink_fifo_input(upipe, uref);
+        return;
+    }
+
     if (!upipe_dveo_asi_sink_check_input(upipe)) {
         upipe_dveo_asi_sink_hold_input(upipe, uref);
         upipe_dveo_asi_sink_block_input(upipe, upump_p);
@@ -484,6 +700,8 @@ static void upipe_dveo_asi_sink_close(struct upipe *upipe)
         ubase_clean_fd(&upipe_dveo_asi_sink->fd);
     }
     upipe_dveo_asi_sink_set_upump(upipe, NULL);
+    upipe_dveo_asi_sink_set_upump_fifo(upipe, NULL);
+    upipe_dveo_asi_sink_flush_fifo(upipe);
 }
 
 /* From the example code */
@@ -556,14 +774,14 @@ static int upipe_dveo_asi_sink_open(struct upipe *upipe)
     }
 
     snprintf(sys, sizeof(sys), sys_fmt, upipe_dveo_asi_sink->card_idx, "bufsize");
-    snprintf(buf, sizeof(buf), "%u\n", 6*(188+8)); /* minimum is 1024 */
+    snprintf(buf, sizeof(buf), "%u\n", ASI_BUFSIZE); /* minimum is 1024 */
     if (util_write(sys, buf, sizeof(buf)) < 0) {
         upipe_err_va(upipe, "Couldn't set buffer size (%m)");
         return UBASE_ERR_EXTERNAL;
     }
 
     snprintf(sys, sizeof(sys), sys_fmt, upipe_dveo_asi_sink->card_idx, "buffers");
-    snprintf(buf, sizeof(buf), "%u\n", 500);
+    snprintf(buf, sizeof(buf), "%u\n", ASI_BUFFERS);
     if (util_write(sys, buf, sizeof(buf)) < 0) {
         upipe_err_va(upipe, "Couldn't set # of buffers (%m)");
         return UBASE_ERR_EXTERNAL;
@@ -664,6 +882,18 @@ static int upipe_dveo_asi_sink_set_option(struct upipe *upipe,
     if (k == NULL || v == NULL)
         return UBASE_ERR_INVALID;
 
+    if (!strcmp(k, "fifo-level")) {
+        int level = atoi(v);
+        if (level < 0 || level > ASI_BUFFERS)
+            return UBASE_ERR_INVALID;
+        upipe_dveo_asi_sink->fifo_level = level;
+        if (!level) {
+            upipe_dveo_asi_sink_set_upump_fifo(upipe, NULL);
+            upipe_dveo_asi_sink_flush_fifo(upipe);
+        }
+        return UBASE_ERR_NONE;
+    }
+
     if (unlikely(upipe_dveo_asi_sink->fd != -1))
         upipe_dveo_asi_sink_close(upipe);
 
@@ -687,6 +917,7 @@ static int upipe_dveo_asi_sink_control(struct upipe *upipe, int command, va_list
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
             upipe_dveo_asi_sink_set_upump(upipe, NULL);
+            upipe_dveo_asi_sink_set_upump_fifo(upipe, NULL);
             return upipe_dveo_asi_sink_attach_upump_mgr(upipe);
         case UPIPE_DVEO_ASI_SINK_GET_UCLOCK: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_DVEO_ASI_SINK_SIGNATURE)
@@ -730,6 +961,7 @@ static void upipe_dveo_asi_sink_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     upipe_dveo_asi_sink_clean_upump(upipe);
+    upipe_dveo_asi_sink_clean_upump_fifo(upipe);
     upipe_dveo_asi_sink_clean_upump_mgr(upipe);
     upipe_dveo_asi_sink_clean_input(upipe);
     upipe_dveo_asi_sink_clean_urefcount(upipe);
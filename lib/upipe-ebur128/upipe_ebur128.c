@@ -27,6 +27,7 @@
  * @short Upipe ebur128
  */
 
+#include "upipe/uclock.h"
 #include "upipe/uref.h"
 #include "upipe/uref_flow.h"
 #include "upipe/uref_sound_flow.h"
@@ -40,7 +41,10 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
 
 #include <ebur128.h>
 
@@ -52,6 +56,22 @@ enum upipe_ebur128_fmt {
     UPIPE_EBUR128_DOUBLE
 };
 
+/** @internal measures */
+enum upipe_ebur128_measure {
+    UPIPE_EBUR128_MOMENTARY,
+    UPIPE_EBUR128_LRA,
+    UPIPE_EBUR128_GLOBAL,
+    UPIPE_EBUR128_MEASURES
+};
+
+/** @internal state of a measured program */
+struct upipe_ebur128_program {
+    /** ebur128 state */
+    ebur128_state *st;
+    /** last computed values of the measures */
+    double values[UPIPE_EBUR128_MEASURES];
+};
+
 /** @internal upipe_ebur128 private structure */
 struct upipe_ebur128 {
     /** refcount management structure */
@@ -66,14 +86,32 @@ struct upipe_ebur128 {
     /** list of output requests */
     struct uchain request_list;
 
-    /** ebur128 state */
-    ebur128_state *st;
+    /** measured programs */
+    struct upipe_ebur128_program *programs;
+    /** number of measured programs */
+    uint8_t nb_programs;
+    /** number of channels of each program, or 0 for all channels */
+    uint8_t program_channels;
     /** number of channels */
     uint8_t channels;
     /** number of planes */
     uint8_t planes;
     /** sample format */
     enum upipe_ebur128_fmt fmt;
+    /** sample rate */
+    uint64_t rate;
+
+    /** reporting intervals of the measures, in 27 MHz units */
+    uint64_t intervals[UPIPE_EBUR128_MEASURES];
+    /** samples received since the measures were last computed */
+    uint64_t elapsed[UPIPE_EBUR128_MEASURES];
+    /** true if the measures were computed at least once */
+    bool computed[UPIPE_EBUR128_MEASURES];
+
+    /** buffer to interleave planes and split programs */
+    uint8_t *buffer;
+    /** size of the buffer */
+    size_t buffer_size;
 
     /** public structure */
     struct upipe upipe;
@@ -103,7 +141,18 @@ static struct upipe *upipe_ebur128_alloc(struct upipe_mgr *mgr,
     if (unlikely(upipe == NULL))
         return NULL;
     struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
-    upipe_ebur128->st = NULL;
+    upipe_ebur128->programs = NULL;
+    upipe_ebur128->nb_programs = 0;
+    upipe_ebur128->program_channels = 0;
+    upipe_ebur128->channels = 0;
+    upipe_ebur128->rate = 0;
+    for (int i = 0; i < UPIPE_EBUR128_MEASURES; i++) {
+        upipe_ebur128->intervals[i] = 0;
+        upipe_ebur128->elapsed[i] = 0;
+        upipe_ebur128->computed[i] = false;
+    }
+    upipe_ebur128->buffer = NULL;
+    upipe_ebur128->buffer_size = 0;
 
     upipe_ebur128_init_urefcount(upipe);
     upipe_ebur128_init_output(upipe);
@@ -111,6 +160,144 @@ static struct upipe *upipe_ebur128_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This destroys the states of the programs.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ebur128_clean_programs(struct upipe *upipe)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    for (uint8_t i = 0; i < upipe_ebur128->nb_programs; i++)
+        if (upipe_ebur128->programs[i].st != NULL)
+            ebur128_destroy(&upipe_ebur128->programs[i].st);
+    free(upipe_ebur128->programs);
+    upipe_ebur128->programs = NULL;
+    upipe_ebur128->nb_programs = 0;
+}
+
+/** @internal @This allocates the states of the programs for the current
+ * channels and rate, or only updates the rate if the programs are
+ * unchanged.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_ebur128_init_programs(struct upipe *upipe)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    uint8_t program_channels = upipe_ebur128->program_channels ?
+        upipe_ebur128->program_channels : upipe_ebur128->channels;
+    if (!program_channels ||
+        upipe_ebur128->channels % program_channels)
+        return UBASE_ERR_INVALID;
+    uint8_t nb_programs = upipe_ebur128->channels / program_channels;
+
+    if (nb_programs == upipe_ebur128->nb_programs) {
+        for (uint8_t i = 0; i < nb_programs; i++)
+            ebur128_change_parameters(upipe_ebur128->programs[i].st,
+                                      program_channels, upipe_ebur128->rate);
+        return UBASE_ERR_NONE;
+    }
+
+    upipe_ebur128_clean_programs(upipe);
+    upipe_ebur128->programs =
+        calloc(nb_programs, sizeof(struct upipe_ebur128_program));
+    UBASE_ALLOC_RETURN(upipe_ebur128->programs);
+    upipe_ebur128->nb_programs = nb_programs;
+    for (uint8_t i = 0; i < nb_programs; i++) {
+        upipe_ebur128->programs[i].st =
+            ebur128_init(program_channels, upipe_ebur128->rate,
+                EBUR128_MODE_LRA | EBUR128_MODE_I | EBUR128_MODE_HISTOGRAM);
+        if (unlikely(upipe_ebur128->programs[i].st == NULL)) {
+            upipe_ebur128_clean_programs(upipe);
+            return UBASE_ERR_ALLOC;
+        }
+    }
+    for (int i = 0; i < UPIPE_EBUR128_MEASURES; i++) {
+        upipe_ebur128->elapsed[i] = 0;
+        upipe_ebur128->computed[i] = false;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This computes a measure of a program.
+ *
+ * @param program measured program
+ * @param measure measure to compute
+ */
+static void upipe_ebur128_compute(struct upipe_ebur128_program *program,
+                                  enum upipe_ebur128_measure measure)
+{
+    double *value = &program->values[measure];
+    switch (measure) {
+        case UPIPE_EBUR128_MOMENTARY:
+            ebur128_loudness_momentary(program->st, value);
+            break;
+        case UPIPE_EBUR128_LRA:
+            ebur128_loudness_range(program->st, value);
+            break;
+        case UPIPE_EBUR128_GLOBAL:
+            ebur128_loudness_global(program->st, value);
+            break;
+        default:
+            break;
+    }
+}
+
+/** @internal @This adds interleaved frames to the state of a program.
+ *
+ * @param upipe description structure of the pipe
+ * @param st ebur128 state
+ * @param buf interleaved frames
+ * @param samples number of frames
+ */
+static void upipe_ebur128_add_frames(struct upipe *upipe, ebur128_state *st,
+                                     const void *buf, size_t samples)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    switch (upipe_ebur128->fmt) {
+        case UPIPE_EBUR128_SHORT:
+            ebur128_add_frames_short(st, (const short *)buf, samples);
+            break;
+
+        case UPIPE_EBUR128_INT:
+            ebur128_add_frames_int(st, (const int *)buf, samples);
+            break;
+
+        case UPIPE_EBUR128_FLOAT:
+            ebur128_add_frames_float(st, (const float *)buf, samples);
+            break;
+
+        case UPIPE_EBUR128_DOUBLE:
+            ebur128_add_frames_double(st, (const double *)buf, samples);
+            break;
+
+        default:
+            upipe_warn_va(upipe, "unknown sample format %d",
+                          upipe_ebur128->fmt);
+            break;
+    }
+}
+
+/** @internal @This returns a buffer of at least the given size.
+ *
+ * @param upipe description structure of the pipe
+ * @param size wanted size
+ * @return pointer to the buffer, or NULL in case of allocation error
+ */
+static uint8_t *upipe_ebur128_buffer(struct upipe *upipe, size_t size)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    if (size > upipe_ebur128->buffer_size) {
+        uint8_t *buffer = realloc(upipe_ebur128->buffer, size);
+        if (unlikely(buffer == NULL))
+            return NULL;
+        upipe_ebur128->buffer = buffer;
+        upipe_ebur128->buffer_size = size;
+    }
+    return upipe_ebur128->buffer;
+}
+
 /** @internal @This handles input.
  *
  * @param upipe description structure of the pipe
@@ -121,9 +308,9 @@ static void upipe_ebur128_input(struct upipe *upipe, struct uref *uref,
                                 struct upump **upump_p)
 {
     struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
-    double loud = 0, lra = 0, global = 0;
 
-    if (unlikely(upipe_ebur128->output_flow == NULL)) {
+    if (unlikely(upipe_ebur128->output_flow == NULL ||
+                 !upipe_ebur128->nb_programs)) {
         upipe_err_va(upipe, "invalid input");
         uref_free(uref);
         return;
@@ -137,7 +324,24 @@ static void upipe_ebur128_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
-    void *buf = NULL;
+    uint8_t nb_programs = upipe_ebur128->nb_programs;
+    /* packed sample sizes already cover all channels */
+    size_t frame_size = upipe_ebur128->planes == 1 ? sample_size :
+                        (size_t)sample_size * upipe_ebur128->channels;
+    size_t interleaved_size = upipe_ebur128->planes == 1 ? 0 :
+                              frame_size * samples;
+    size_t split_size = nb_programs == 1 ? 0 : frame_size * samples;
+    uint8_t *buffer = NULL;
+    if (interleaved_size + split_size) {
+        buffer = upipe_ebur128_buffer(upipe, interleaved_size + split_size);
+        if (unlikely(buffer == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            uref_free(uref);
+            return;
+        }
+    }
+
+    const uint8_t *buf = NULL;
     const char *channel = NULL;
     if (upipe_ebur128->planes == 1) {
         if (ubase_check(uref_sound_iterate_plane(uref, &channel)) && channel) {
@@ -150,65 +354,84 @@ static void upipe_ebur128_input(struct upipe *upipe, struct uref *uref,
         }
 
     } else {
-        buf = malloc(sample_size * upipe_ebur128->channels * samples);
-        if (buf == NULL) {
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            uref_free(uref);
-            return;
-        }
-        if (!ubase_check(uref_sound_interleave(uref, (uint8_t *)buf, 0,
+        if (!ubase_check(uref_sound_interleave(uref, buffer, 0,
                                                samples, sample_size,
                                                upipe_ebur128->planes))) {
             upipe_warn(upipe, "error mapping sound buffer");
             uref_free(uref);
             return;
         }
+        buf = buffer;
     }
 
     if (unlikely((uintptr_t)buf & 1))
         upipe_warn(upipe, "unaligned buffer");
 
-    switch (upipe_ebur128->fmt) {
-        case UPIPE_EBUR128_SHORT:
-            ebur128_add_frames_short(upipe_ebur128->st, (short *)buf,
-                                     samples);
-            break;
-
-        case UPIPE_EBUR128_INT:
-            ebur128_add_frames_int(upipe_ebur128->st, (int *)buf,
-                                   samples);
-            break;
-
-        case UPIPE_EBUR128_FLOAT:
-            ebur128_add_frames_float(upipe_ebur128->st, (float *)buf,
+    if (nb_programs == 1)
+        upipe_ebur128_add_frames(upipe, upipe_ebur128->programs[0].st,
+                                 buf, samples);
+    else {
+        /* split the programs in a single pass over the frames */
+        uint8_t *split = buffer + interleaved_size;
+        size_t program_size = frame_size / nb_programs;
+        const uint8_t *src = buf;
+        for (size_t i = 0; i < samples; i++)
+            for (uint8_t j = 0; j < nb_programs; j++) {
+                memcpy(split + (j * samples + i) * program_size, src,
+                       program_size);
+                src += program_size;
+            }
+        for (uint8_t j = 0; j < nb_programs; j++)
+            upipe_ebur128_add_frames(upipe, upipe_ebur128->programs[j].st,
+                                     split + j * samples * program_size,
                                      samples);
-            break;
-
-        case UPIPE_EBUR128_DOUBLE:
-            ebur128_add_frames_double(upipe_ebur128->st, (double *)buf,
-                                      samples);
-            break;
-
-        default:
-            upipe_warn_va(upipe, "unknown sample format %d",
-                          upipe_ebur128->fmt);
-            break;
     }
 
     if (upipe_ebur128->planes == 1)
         uref_sound_plane_unmap(uref, channel, 0, -1);
-    else
-        free(buf);
-
-    ebur128_loudness_momentary(upipe_ebur128->st, &loud);
-    ebur128_loudness_range(upipe_ebur128->st, &lra);
-    ebur128_loudness_global(upipe_ebur128->st, &global);
 
-    uref_ebur128_set_momentary(uref, loud);
-    uref_ebur128_set_lra(uref, lra);
-    uref_ebur128_set_global(uref, global);
+    for (int i = 0; i < UPIPE_EBUR128_MEASURES; i++) {
+        uint64_t interval = upipe_ebur128->intervals[i];
+        if (interval == UPIPE_EBUR128_ON_QUERY)
+            continue;
+        upipe_ebur128->elapsed[i] += samples;
+        if (upipe_ebur128->computed[i] &&
+            upipe_ebur128->elapsed[i] * UCLOCK_FREQ <
+            interval * upipe_ebur128->rate)
+            continue;
+        for (uint8_t j = 0; j < nb_programs; j++)
+            upipe_ebur128_compute(&upipe_ebur128->programs[j], i);
+        upipe_ebur128->elapsed[i] = 0;
+        upipe_ebur128->computed[i] = true;
+    }
 
-    upipe_verbose_va(upipe, "loud %f lra %f global %f", loud, lra, global);
+    for (uint8_t j = 0; j < nb_programs; j++) {
+        const double *values = upipe_ebur128->programs[j].values;
+        if (nb_programs > 1) {
+            if (upipe_ebur128->computed[UPIPE_EBUR128_MOMENTARY])
+                uref_ebur128_set_program_momentary(uref,
+                        values[UPIPE_EBUR128_MOMENTARY], j);
+            if (upipe_ebur128->computed[UPIPE_EBUR128_LRA])
+                uref_ebur128_set_program_lra(uref,
+                        values[UPIPE_EBUR128_LRA], j);
+            if (upipe_ebur128->computed[UPIPE_EBUR128_GLOBAL])
+                uref_ebur128_set_program_global(uref,
+                        values[UPIPE_EBUR128_GLOBAL], j);
+        }
+        if (j)
+            continue;
+        if (upipe_ebur128->computed[UPIPE_EBUR128_MOMENTARY])
+            uref_ebur128_set_momentary(uref, values[UPIPE_EBUR128_MOMENTARY]);
+        if (upipe_ebur128->computed[UPIPE_EBUR128_LRA])
+            uref_ebur128_set_lra(uref, values[UPIPE_EBUR128_LRA]);
+        if (upipe_ebur128->computed[UPIPE_EBUR128_GLOBAL])
+            uref_ebur128_set_global(uref, values[UPIPE_EBUR128_GLOBAL]);
+
+        upipe_verbose_va(upipe, "loud %f lra %f global %f",
+                         values[UPIPE_EBUR128_MOMENTARY],
+                         values[UPIPE_EBUR128_LRA],
+                         values[UPIPE_EBUR128_GLOBAL]);
+    }
 
     upipe_ebur128_output(upipe, uref, upump_p);
 }
@@ -255,15 +478,16 @@ static int upipe_ebur128_set_flow_def(struct upipe *upipe,
         return UBASE_ERR_ALLOC;
     }
     upipe_ebur128->fmt = fmt;
-
-    if (unlikely(upipe_ebur128->st)) {
-        //ebur128_destroy(&upipe_ebur128->st);
-        ebur128_change_parameters(upipe_ebur128->st,
-                                  upipe_ebur128->channels, rate);
-    } else {
-        upipe_ebur128->st =
-            ebur128_init(upipe_ebur128->channels, rate,
-            EBUR128_MODE_LRA | EBUR128_MODE_I | EBUR128_MODE_HISTOGRAM);
+    upipe_ebur128->rate = rate;
+
+    int err = upipe_ebur128_init_programs(upipe);
+    if (unlikely(!ubase_check(err))) {
+        upipe_err_va(upipe, "unable to measure %"PRIu8" channels as "
+                     "programs of %"PRIu8" channels",
+                     upipe_ebur128->channels,
+                     upipe_ebur128->program_channels);
+        uref_free(flow_dup);
+        return err;
     }
 
     upipe_ebur128_store_flow_def(upipe, flow_dup);
@@ -290,6 +514,64 @@ static int upipe_ebur128_provide_flow_format(struct upipe *upipe,
     return urequest_provide_flow_format(request, flow);
 }
 
+/** @internal @This sets the number of channels of each program.
+ *
+ * @param upipe description structure of the pipe
+ * @param channels number of channels of each program, or 0
+ * @return an error code
+ */
+static int upipe_ebur128_set_program_channels_real(struct upipe *upipe,
+                                                   unsigned int channels)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    if (channels > UINT8_MAX)
+        return UBASE_ERR_INVALID;
+    uint8_t previous = upipe_ebur128->program_channels;
+    upipe_ebur128->program_channels = channels;
+    if (!upipe_ebur128->channels)
+        return UBASE_ERR_NONE;
+
+    /* rebuild the states for the new programs */
+    upipe_ebur128_clean_programs(upipe);
+    int err = upipe_ebur128_init_programs(upipe);
+    if (unlikely(!ubase_check(err))) {
+        upipe_ebur128->program_channels = previous;
+        upipe_ebur128_init_programs(upipe);
+    }
+    return err;
+}
+
+/** @internal @This computes the current loudness of a program.
+ *
+ * @param upipe description structure of the pipe
+ * @param program index of the program
+ * @param momentary_p filled in with the momentary loudness
+ * @param lra_p filled in with the loudness range
+ * @param global_p filled in with the global integrated loudness
+ * @return an error code
+ */
+static int upipe_ebur128_get_loudness_real(struct upipe *upipe,
+                                           unsigned int program,
+                                           double *momentary_p,
+                                           double *lra_p, double *global_p)
+{
+    struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
+    if (program >= upipe_ebur128->nb_programs)
+        return UBASE_ERR_INVALID;
+
+    struct upipe_ebur128_program *p = &upipe_ebur128->programs[program];
+    double *values[UPIPE_EBUR128_MEASURES] = {
+        momentary_p, lra_p, global_p
+    };
+    for (int i = 0; i < UPIPE_EBUR128_MEASURES; i++) {
+        if (values[i] == NULL)
+            continue;
+        upipe_ebur128_compute(p, i);
+        *values[i] = p->values[i];
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on the pipe.
  *
  * @param upipe description structure of the pipe
@@ -319,6 +601,30 @@ static int upipe_ebur128_control(struct upipe *upipe,
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
             return upipe_ebur128_control_output(upipe, command, args);
+
+        case UPIPE_EBUR128_SET_INTERVALS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_EBUR128_SIGNATURE)
+            struct upipe_ebur128 *upipe_ebur128 =
+                upipe_ebur128_from_upipe(upipe);
+            for (int i = 0; i < UPIPE_EBUR128_MEASURES; i++)
+                upipe_ebur128->intervals[i] = va_arg(args, uint64_t);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_EBUR128_SET_PROGRAM_CHANNELS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_EBUR128_SIGNATURE)
+            unsigned int channels = va_arg(args, unsigned int);
+            return upipe_ebur128_set_program_channels_real(upipe, channels);
+        }
+        case UPIPE_EBUR128_GET_LOUDNESS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_EBUR128_SIGNATURE)
+            unsigned int program = va_arg(args, unsigned int);
+            double *momentary_p = va_arg(args, double *);
+            double *lra_p = va_arg(args, double *);
+            double *global_p = va_arg(args, double *);
+            return upipe_ebur128_get_loudness_real(upipe, program,
+                                                   momentary_p, lra_p,
+                                                   global_p);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -331,9 +637,8 @@ static int upipe_ebur128_control(struct upipe *upipe,
 static void upipe_ebur128_free(struct upipe *upipe)
 {
     struct upipe_ebur128 *upipe_ebur128 = upipe_ebur128_from_upipe(upipe);
-    if (likely(upipe_ebur128->st)) {
-        ebur128_destroy(&upipe_ebur128->st);
-    }
+    upipe_ebur128_clean_programs(upipe);
+    free(upipe_ebur128->buffer);
     upipe_throw_dead(upipe);
 
     upipe_ebur128_clean_output(upipe);
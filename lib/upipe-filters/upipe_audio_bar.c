@@ -95,6 +95,11 @@ struct upipe_audiobar {
     /* peak date */
     uint64_t peak_date[255];
 
+    /** picture persisting across frames, only changed parts are redrawn */
+    struct ubuf *canvas;
+    /** top of the bar of each channel currently drawn in the canvas */
+    int drawn[255];
+
     /** temporary uref storage (used during urequest) */
     struct uchain urefs;
     /** nb urefs in storage */
@@ -162,6 +167,7 @@ static struct upipe *upipe_audiobar_alloc(struct upipe_mgr *mgr,
     upipe_audiobar_init_flow_format(upipe);
     upipe_audiobar->flow_def_config = flow_def;
     upipe_audiobar->alpha = DEFAULT_ALPHA;
+    upipe_audiobar->canvas = NULL;
     upipe_audiobar->hsize = upipe_audiobar->vsize =
         upipe_audiobar->sep_width = upipe_audiobar->pad_width = UINT64_MAX;
 
@@ -235,6 +241,85 @@ static void copy_color(uint8_t **dst, size_t *strides,
     }
 }
 
+/** chromas of the output pictures */
+static const char *chroma[] = { "y8", "u8", "v8", "a8", "u8v8" };
+#define NR_CHROMA UBASE_ARRAY_SIZE(chroma)
+
+/** @internal @This maps the planes of a picture for writing.
+ *
+ * @param ubuf picture buffer
+ * @param dst filled in with the plane buffers, or NULL if absent
+ * @param strides filled in with the strides of the planes
+ * @param hsubs filled in with the hsubs of the planes
+ * @param vsubs filled in with the vsubs of the planes
+ * @return an error code, UBASE_ERR_BUSY if the buffer is shared
+ */
+static int upipe_audiobar_map(struct ubuf *ubuf, uint8_t **dst,
+                              size_t *strides, uint8_t *hsubs, uint8_t *vsubs)
+{
+    for (int i = 0; i < NR_CHROMA; i++) {
+        int err = ubuf_pic_plane_write(ubuf, chroma[i], 0, 0, -1, -1, &dst[i]);
+        if (unlikely(err == UBASE_ERR_BUSY)) {
+            while (--i >= 0)
+                if (dst[i] != NULL)
+                    ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+            return err;
+        }
+        if (unlikely(!ubase_check(err)))
+            dst[i] = NULL;
+        else if (unlikely(!ubase_check(ubuf_pic_plane_size(ubuf, chroma[i],
+                            &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
+            ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+            dst[i] = NULL;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This maps the persistent picture for writing. If the picture
+ * of the previous frame is still used downstream, it is copied first, so
+ * that only the changed parts need to be drawn.
+ *
+ * @param upipe description structure of the pipe
+ * @param dst filled in with the plane buffers, or NULL if absent
+ * @param strides filled in with the strides of the planes
+ * @param hsubs filled in with the hsubs of the planes
+ * @param vsubs filled in with the vsubs of the planes
+ * @param full_p set to true if the whole picture must be drawn
+ * @return an error code
+ */
+static int upipe_audiobar_map_canvas(struct upipe *upipe, uint8_t **dst,
+                                     size_t *strides, uint8_t *hsubs,
+                                     uint8_t *vsubs, bool *full_p)
+{
+    struct upipe_audiobar *upipe_audiobar = upipe_audiobar_from_upipe(upipe);
+    *full_p = false;
+
+    if (upipe_audiobar->canvas != NULL) {
+        int err = upipe_audiobar_map(upipe_audiobar->canvas,
+                                     dst, strides, hsubs, vsubs);
+        if (err != UBASE_ERR_BUSY)
+            return err;
+
+        struct ubuf *ubuf = ubuf_pic_copy(upipe_audiobar->ubuf_mgr,
+                                          upipe_audiobar->canvas,
+                                          0, 0, -1, -1);
+        ubuf_free(upipe_audiobar->canvas);
+        upipe_audiobar->canvas = ubuf;
+        if (likely(ubuf != NULL))
+            return upipe_audiobar_map(ubuf, dst, strides, hsubs, vsubs);
+    }
+
+    upipe_audiobar->canvas = ubuf_pic_alloc(upipe_audiobar->ubuf_mgr,
+                                            upipe_audiobar->hsize,
+                                            upipe_audiobar->vsize);
+    if (unlikely(upipe_audiobar->canvas == NULL))
+        return UBASE_ERR_ALLOC;
+    *full_p = true;
+    return upipe_audiobar_map(upipe_audiobar->canvas,
+                              dst, strides, hsubs, vsubs);
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -274,25 +359,19 @@ static bool upipe_audiobar_handle(struct upipe *upipe, struct uref *uref,
     if (unlikely(upipe_audiobar->hsize == UINT64_MAX))
         return false;
 
-    struct ubuf *ubuf = ubuf_pic_alloc(upipe_audiobar->ubuf_mgr,
-                                       upipe_audiobar->hsize,
-                                       upipe_audiobar->vsize);
-    uref_attach_ubuf(uref, ubuf);
-
-    static const char *chroma[] = { "y8", "u8", "v8", "a8", "u8v8" };
-#define NR_CHROMA UBASE_ARRAY_SIZE(chroma)
     uint8_t *dst[NR_CHROMA];
     size_t strides[NR_CHROMA];
     uint8_t hsubs[NR_CHROMA];
     uint8_t vsubs[NR_CHROMA];
-    for (int i = 0; i < NR_CHROMA; i++) {
-        if (unlikely(!ubase_check(uref_pic_plane_write(uref, chroma[i],
-                            0, 0, -1, -1, &dst[i])) ||
-                     !ubase_check(uref_pic_plane_size(uref, chroma[i],
-                             &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
-             dst[i] = NULL;
-        }
+    bool full;
+    if (unlikely(!ubase_check(upipe_audiobar_map_canvas(upipe, dst, strides,
+                                                        hsubs, vsubs,
+                                                        &full)))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(uref);
+        return true;
     }
+    struct ubuf *ubuf = upipe_audiobar->canvas;
 
     uint8_t alpha = upipe_audiobar->alpha;
     uint64_t h = upipe_audiobar->vsize;
@@ -304,11 +383,16 @@ static bool upipe_audiobar_handle(struct upipe *upipe, struct uref *uref,
     uint8_t green[2][4] = { { 150, 44, 21, alpha }, { 74, 85, 74, alpha } };
     uint8_t yellow[2][4] = { { 226, 1, 148, alpha }, { 112, 64, 138, alpha } };
 
+    int marks[6];
+    for (int i = 0; i < 6; i++)
+        marks[i] = h - (iec_scale(-10 * (i + 1)) * h);
+
     uint64_t pts = 0;
     if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts)))) {
         upipe_warn(upipe, "unable to read pts");
     }
 
+    const unsigned sep = upipe_audiobar->sep_width / 2;
     for (uint8_t chan = 0; chan < upipe_audiobar->channels; chan++) {
         double amplitude = 0.;
         if (unlikely(!ubase_check(uref_amax_get_amplitude(uref, &amplitude,
@@ -330,40 +414,75 @@ static bool upipe_audiobar_handle(struct upipe *upipe, struct uref *uref,
 
         scale = iec_scale(scale);
 
+        /* visible part of the bar, between the separators */
+        unsigned col = chan * upipe_audiobar->chan_width;
+        unsigned w = upipe_audiobar->chan_width;
+        if (chan && sep) {
+            col += sep;
+            w -= sep;
+        }
+        if (chan < upipe_audiobar->channels - 1)
+            w -= sep;
+
+        /* only the rows whose brightness changed are drawn again */
         const int hmax = h - scale * h;
-        for (int row = 0; row < h; row++) {
+        int from = 0, to = h;
+        if (!full) {
+            int prev = upipe_audiobar->drawn[chan];
+            from = (prev < hmax ? prev : hmax) + 1;
+            to = (prev < hmax ? hmax : prev) + 1;
+            if (from < 0)
+                from = 0;
+            if (to > h)
+                to = h;
+        }
+        upipe_audiobar->drawn[chan] = hmax;
+
+        for (int row = from; row < to; row++) {
             bool bright = row > hmax;
 
             const uint8_t *color = row < hred ? red[!bright] :
                                    row < hyellow ? yellow[!bright] :
                                    green[!bright];
+            for (int i = 0; i < 6; i++)
+                if (row == marks[i])
+                    color = black;
+
+            copy_color(dst, strides, hsubs, vsubs, color, row, col, w);
+        }
+    }
 
-            copy_color(dst, strides, hsubs, vsubs, color, row,
-                       chan * upipe_audiobar->chan_width,
-                       upipe_audiobar->chan_width);
-            if (chan && upipe_audiobar->sep_width)
-                copy_color(dst, strides, hsubs, vsubs, black, row,
-                           chan * upipe_audiobar->chan_width -
-                           upipe_audiobar->sep_width / 2,
-                           upipe_audiobar->sep_width);
-
-            if (chan == upipe_audiobar->channels - 1 &&
-                upipe_audiobar->pad_width)
+    if (full) {
+        for (int row = 0; row < h; row++) {
+            for (uint8_t chan = 1; chan < upipe_audiobar->channels; chan++)
+                if (upipe_audiobar->sep_width)
+                    copy_color(dst, strides, hsubs, vsubs, black, row,
+                               chan * upipe_audiobar->chan_width - sep,
+                               upipe_audiobar->sep_width);
+            if (upipe_audiobar->pad_width)
                 copy_color(dst, strides, hsubs, vsubs, transparent, row,
-                           (chan + 1) * upipe_audiobar->chan_width,
+                           upipe_audiobar->channels *
+                           upipe_audiobar->chan_width,
                            upipe_audiobar->pad_width);
         }
-    }
 
-    /* dB marks */
-    for (int i = 1; i <= 6; i++) {
-        int row = h - (iec_scale(-10 * i) * h);
-        copy_color(dst, strides, hsubs, vsubs, black, row, 0,
-                   upipe_audiobar->hsize);
+        /* dB marks */
+        for (int i = 0; i < 6; i++)
+            copy_color(dst, strides, hsubs, vsubs, black, marks[i], 0,
+                       upipe_audiobar->hsize);
     }
 
     for (int i = 0; i < NR_CHROMA; i++)
-        ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+        if (dst[i] != NULL)
+            ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+
+    ubuf = ubuf_dup(ubuf);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(uref);
+        return true;
+    }
+    uref_attach_ubuf(uref, ubuf);
     upipe_audiobar_output(upipe, uref, upump_p);
     return true;
 }
@@ -418,6 +537,8 @@ static int upipe_audiobar_check_ubuf_mgr(struct upipe *upipe,
         return UBASE_ERR_NONE;
 
     upipe_audiobar_store_flow_def(upipe, flow_format);
+    ubuf_free(upipe_audiobar->canvas);
+    upipe_audiobar->canvas = NULL;
     UBASE_RETURN(uref_pic_flow_get_hsize(flow_format, &upipe_audiobar->hsize))
     UBASE_RETURN(uref_pic_flow_get_vsize(flow_format, &upipe_audiobar->vsize))
     upipe_audiobar->chan_width =
@@ -556,6 +677,7 @@ static void upipe_audiobar_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     struct upipe_audiobar *upipe_audiobar = upipe_audiobar_from_upipe(upipe);
+    ubuf_free(upipe_audiobar->canvas);
     uref_free(upipe_audiobar->flow_def_config);
     upipe_audiobar_clean_flow_format(upipe);
     upipe_audiobar_clean_ubuf_mgr(upipe);
@@ -93,6 +93,9 @@ struct upipe_agraph {
     /** previous values */
     double *prev[255];
 
+    /** picture persisting across frames, scrolled and completed */
+    struct ubuf *canvas;
+
     /** temporary uref storage (used during urequest) */
     struct uchain urefs;
     /** nb urefs in storage */
@@ -161,6 +164,7 @@ static struct upipe *upipe_agraph_alloc(struct upipe_mgr *mgr,
     upipe_agraph_init_ubuf_mgr(upipe);
     upipe_agraph_init_flow_format(upipe);
     upipe_agraph->flow_def_config = flow_def;
+    upipe_agraph->canvas = NULL;
     upipe_agraph->hsize = upipe_agraph->vsize =
         upipe_agraph->sep_width = upipe_agraph->pad_width = UINT64_MAX;
 
@@ -221,6 +225,103 @@ static void copy_color(uint8_t **dst, size_t *strides,
            color[2], w / hsubs[2]); // v8
 }
 
+/** @internal @This scrolls a region of the picture two pixels leftwards.
+ *
+ * @param dst array of destination chromas (planar YUV422)
+ * @param strides array of strides for each chroma
+ * @param hsubs array of hsubs of each chroma
+ * @param vsubs array of vsubs of each chroma
+ * @param h number of lines
+ * @param col first column of the region
+ * @param w width of the region
+ */
+static void scroll(uint8_t **dst, size_t *strides,
+                   uint8_t *hsubs, uint8_t *vsubs,
+                   unsigned h, unsigned col, unsigned w)
+{
+    for (int i = 0; i < 3; i++) {
+        for (unsigned line = 0; line < h / vsubs[i]; line++) {
+            uint8_t *p = &dst[i][line * strides[i] + col / hsubs[i]];
+            memmove(p, p + 2 / hsubs[i], (w - 2) / hsubs[i]);
+        }
+    }
+}
+
+/** chromas of the output pictures */
+static const char *chroma[3] = { "y8", "u8", "v8" };
+
+/** @internal @This maps the planes of a picture for writing.
+ *
+ * @param ubuf picture buffer
+ * @param dst filled in with the plane buffers
+ * @param strides filled in with the strides of the planes
+ * @param hsubs filled in with the hsubs of the planes
+ * @param vsubs filled in with the vsubs of the planes
+ * @return an error code, UBASE_ERR_BUSY if the buffer is shared
+ */
+static int upipe_agraph_map(struct ubuf *ubuf, uint8_t **dst,
+                            size_t *strides, uint8_t *hsubs, uint8_t *vsubs)
+{
+    for (int i = 0; i < 3; i++) {
+        int err = ubuf_pic_plane_write(ubuf, chroma[i], 0, 0, -1, -1, &dst[i]);
+        if (ubase_check(err)) {
+            err = ubuf_pic_plane_size(ubuf, chroma[i], &strides[i],
+                                      &hsubs[i], &vsubs[i], NULL);
+            if (!ubase_check(err))
+                ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+        }
+        if (unlikely(!ubase_check(err))) {
+            while (--i >= 0)
+                ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+            return err;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This maps the persistent picture for writing. If the picture
+ * of the previous frame is still used downstream, it is copied first, so
+ * that it only needs to be scrolled and completed.
+ *
+ * @param upipe description structure of the pipe
+ * @param dst filled in with the plane buffers
+ * @param strides filled in with the strides of the planes
+ * @param hsubs filled in with the hsubs of the planes
+ * @param vsubs filled in with the vsubs of the planes
+ * @param full_p set to true if the whole picture must be drawn
+ * @return an error code
+ */
+static int upipe_agraph_map_canvas(struct upipe *upipe, uint8_t **dst,
+                                   size_t *strides, uint8_t *hsubs,
+                                   uint8_t *vsubs, bool *full_p)
+{
+    struct upipe_agraph *upipe_agraph = upipe_agraph_from_upipe(upipe);
+    *full_p = false;
+
+    if (upipe_agraph->canvas != NULL) {
+        int err = upipe_agraph_map(upipe_agraph->canvas,
+                                   dst, strides, hsubs, vsubs);
+        if (err != UBASE_ERR_BUSY)
+            return err;
+
+        struct ubuf *ubuf = ubuf_pic_copy(upipe_agraph->ubuf_mgr,
+                                          upipe_agraph->canvas,
+                                          0, 0, -1, -1);
+        ubuf_free(upipe_agraph->canvas);
+        upipe_agraph->canvas = ubuf;
+        if (likely(ubuf != NULL))
+            return upipe_agraph_map(ubuf, dst, strides, hsubs, vsubs);
+    }
+
+    upipe_agraph->canvas = ubuf_pic_alloc(upipe_agraph->ubuf_mgr,
+                                          upipe_agraph->hsize,
+                                          upipe_agraph->vsize);
+    if (unlikely(upipe_agraph->canvas == NULL))
+        return UBASE_ERR_ALLOC;
+    *full_p = true;
+    return upipe_agraph_map(upipe_agraph->canvas, dst, strides, hsubs, vsubs);
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -259,26 +360,18 @@ static bool upipe_agraph_handle(struct upipe *upipe, struct uref *uref,
     if (unlikely(upipe_agraph->hsize == UINT64_MAX))
         return false;
 
-    struct ubuf *ubuf = ubuf_pic_alloc(upipe_agraph->ubuf_mgr,
-                                       upipe_agraph->hsize,
-                                       upipe_agraph->vsize);
-    uref_attach_ubuf(uref, ubuf);
-
-    uint8_t *dst[4];
-    size_t strides[4];
-    uint8_t hsubs[4];
-    uint8_t vsubs[4];
-    static const char *chroma[3] = { "y8", "u8", "v8" };
-    for (int i = 0; i < 3; i++) {
-        if (unlikely(!ubase_check(uref_pic_plane_write(uref, chroma[i],
-                            0, 0, -1, -1, &dst[i])) ||
-                     !ubase_check(uref_pic_plane_size(uref, chroma[i],
-                             &strides[i], &hsubs[i], &vsubs[i], NULL)))) {
-             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-             uref_free(uref);
-             return true;
-        }
+    uint8_t *dst[3];
+    size_t strides[3];
+    uint8_t hsubs[3];
+    uint8_t vsubs[3];
+    bool full;
+    if (unlikely(!ubase_check(upipe_agraph_map_canvas(upipe, dst, strides,
+                                                      hsubs, vsubs, &full)))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(uref);
+        return true;
     }
+    struct ubuf *ubuf = upipe_agraph->canvas;
 
     uint64_t h = upipe_agraph->vsize;
     const int hred = h - (iec_scale(-8.) * h);
@@ -289,11 +382,16 @@ static bool upipe_agraph_handle(struct upipe *upipe, struct uref *uref,
     uint8_t green[2][3] = { { 150, 44, 21 }, { 74, 85, 74 } };
     uint8_t yellow[2][3] = { { 226, 1, 148 }, { 112, 64, 138 } };
 
+    int marks[6];
+    for (int i = 0; i < 6; i++)
+        marks[i] = h - (iec_scale(-10 * (i + 1)) * h);
+
     uint64_t pts = 0;
     if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts)))) {
         upipe_warn(upipe, "unable to read pts");
     }
 
+    const uint64_t hist = upipe_agraph->chan_hist;
     for (uint8_t chan = 0; chan < upipe_agraph->channels; chan++) {
         double amplitude = 0.;
         if (unlikely(!ubase_check(uref_amax_get_amplitude(uref, &amplitude,
@@ -316,60 +414,85 @@ static bool upipe_agraph_handle(struct upipe *upipe, struct uref *uref,
         scale = iec_scale(scale);
 
         if (unlikely(upipe_agraph->prev[chan] == NULL)) {
-            upipe_agraph->prev[chan] =
-                malloc(upipe_agraph->chan_hist * sizeof(double));
+            upipe_agraph->prev[chan] = malloc(hist * sizeof(double));
             if (unlikely(upipe_agraph->prev[chan] == NULL)) {
+                for (int i = 0; i < 3; i++)
+                    ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
                 upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
                 uref_free(uref);
                 return true;
             }
-            for (uint64_t i = 0; i < upipe_agraph->chan_hist - 1; i++)
+            for (uint64_t i = 0; i < hist - 1; i++)
                 upipe_agraph->prev[chan][i] = 0.;
         } else {
             memmove(&upipe_agraph->prev[chan][0], &upipe_agraph->prev[chan][1],
-                    (upipe_agraph->chan_hist - 1) * sizeof(double));
+                    (hist - 1) * sizeof(double));
         }
 
-        upipe_agraph->prev[chan][upipe_agraph->chan_hist - 1] = scale;
+        upipe_agraph->prev[chan][hist - 1] = scale;
+
+        /* when the previous picture is reused, it is scrolled, and only
+         * the last two columns change: the previous one is dimmed, and the
+         * current one is drawn */
+        const unsigned col = upipe_agraph->sep_width +
+                             chan * upipe_agraph->chan_width;
+        uint64_t first = 0;
+        if (!full) {
+            scroll(dst, strides, hsubs, vsubs, h, col, 2 * hist);
+            first = hist >= 2 ? hist - 2 : 0;
+        }
 
-        for (uint64_t i = 0; i < upipe_agraph->chan_hist; i++) {
+        for (uint64_t i = first; i < hist; i++) {
             scale = upipe_agraph->prev[chan][i];
             const int hmax = h - scale * h;
-            for (int row = 0; row < h; row++) {
-                bool bright = (i == upipe_agraph->chan_hist - 1);
-
+            bool bright = (i == hist - 1);
+            int row = 0;
+            if (!full && !bright)
+                row = hmax > 0 ? hmax : 0;
+            for ( ; row < h; row++) {
                 const uint8_t *color = row < hmax ? black :
                                        row < hred ? red[!bright] :
                                        row < hyellow ? yellow[!bright] :
                                        green[!bright];
+                for (int m = 0; m < 6; m++)
+                    if (row == marks[m])
+                        color = black;
 
-                if (!i && upipe_agraph->sep_width)
-                    copy_color(dst, strides, hsubs, vsubs, black, row,
-                               chan * upipe_agraph->chan_width,
-                               upipe_agraph->sep_width);
                 copy_color(dst, strides, hsubs, vsubs, color, row,
-                           upipe_agraph->sep_width +
-                           chan * upipe_agraph->chan_width + 2 * i,
-                           2);
-
-                if (chan == upipe_agraph->channels - 1 &&
-                    upipe_agraph->pad_width)
-                    copy_color(dst, strides, hsubs, vsubs, transparent, row,
-                               (chan + 1) * upipe_agraph->chan_width,
-                               upipe_agraph->pad_width);
+                           col + 2 * i, 2);
             }
         }
     }
 
-    /* dB marks */
-    for (int i = 1; i <= 6; i++) {
-        int row = h - (iec_scale(-10 * i) * h);
-        copy_color(dst, strides, hsubs, vsubs, black, row, 0,
-                   upipe_agraph->hsize);
+    if (full) {
+        for (int row = 0; row < h; row++) {
+            for (uint8_t chan = 0; chan < upipe_agraph->channels; chan++)
+                if (upipe_agraph->sep_width)
+                    copy_color(dst, strides, hsubs, vsubs, black, row,
+                               chan * upipe_agraph->chan_width,
+                               upipe_agraph->sep_width);
+            if (upipe_agraph->pad_width)
+                copy_color(dst, strides, hsubs, vsubs, transparent, row,
+                           upipe_agraph->channels * upipe_agraph->chan_width,
+                           upipe_agraph->pad_width);
+        }
+
+        /* dB marks */
+        for (int i = 0; i < 6; i++)
+            copy_color(dst, strides, hsubs, vsubs, black, marks[i], 0,
+                       upipe_agraph->hsize);
     }
 
     for (int i = 0; i < 3; i++)
         ubuf_pic_plane_unmap(ubuf, chroma[i], 0, 0, -1, -1);
+
+    ubuf = ubuf_dup(ubuf);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(uref);
+        return true;
+    }
+    uref_attach_ubuf(uref, ubuf);
     upipe_agraph_output(upipe, uref, upump_p);
     return true;
 }
@@ -424,6 +547,8 @@ static int upipe_agraph_check_ubuf_mgr(struct upipe *upipe,
         return UBASE_ERR_NONE;
 
     upipe_agraph_store_flow_def(upipe, flow_format);
+    ubuf_free(upipe_agraph->canvas);
+    upipe_agraph->canvas = NULL;
     UBASE_RETURN(uref_pic_flow_get_hsize(flow_format, &upipe_agraph->hsize))
     UBASE_RETURN(uref_pic_flow_get_vsize(flow_format, &upipe_agraph->vsize))
     upipe_agraph->chan_width =
@@ -532,6 +657,7 @@ static void upipe_agraph_free(struct upipe *upipe)
     struct upipe_agraph *upipe_agraph = upipe_agraph_from_upipe(upipe);
     for (int i = 0; i < 255; i++)
         free(upipe_agraph->prev[i]);
+    ubuf_free(upipe_agraph->canvas);
     uref_free(upipe_agraph->flow_def_config);
     upipe_agraph_clean_flow_format(upipe);
     upipe_agraph_clean_ubuf_mgr(upipe);
@@ -0,0 +1,822 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe filter measuring EBU R128 loudness with a native K-weighting
+ * engine
+ *
+ * The K-weighting (ITU-R BS.1770) is a cascade of two biquads, a high shelf
+ * and a high pass, run on blocks of @ref UPIPE_ALOUD_LANES channels so that
+ * the compiler may keep a whole block in vector registers. Samples are read
+ * directly from the mapped buffers, whatever the number of planes. The
+ * filtered energy is accumulated per 100 ms block, which gives the
+ * momentary (400 ms) and short-term (3 s) loudnesses, and the gated
+ * integrated loudness and loudness range (EBU Tech 3342) are computed from
+ * histograms of 0.1 LU, so the memory used does not grow with time.
+ */
+
+#include "upipe/uref.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_sound_flow.h"
+#include "upipe/uref_sound.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe-filters/upipe_audio_loudness.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+/** number of channels filtered at once */
+#define UPIPE_ALOUD_LANES 8
+/** number of 100 ms blocks in the short-term window */
+#define UPIPE_ALOUD_SHORT_TERM_BLOCKS 30
+/** number of 100 ms blocks in the momentary window */
+#define UPIPE_ALOUD_MOMENTARY_BLOCKS 4
+/** absolute gate, and lowest loudness of the histograms */
+#define UPIPE_ALOUD_GATE -70.
+/** number of bins of 0.1 LU in the histograms, up to +30 LUFS */
+#define UPIPE_ALOUD_BINS 1000
+/** relative gate of the integrated loudness */
+#define UPIPE_ALOUD_GLOBAL_GATE -10.
+/** relative gate of the loudness range */
+#define UPIPE_ALOUD_LRA_GATE -20.
+
+/** @internal @This is the type of the functions filtering input samples.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffers mapped buffers of every channel
+ * @param stride distance between two samples of a channel, in samples
+ * @param offset offset of the first sample to filter
+ * @param samples number of samples to filter
+ */
+typedef void (*upipe_aloud_filter)(struct upipe *, const void **, size_t,
+                                   size_t, size_t);
+
+/** @internal state of a measured program */
+struct upipe_aloud_program {
+    /** energy of the last 100 ms blocks */
+    double blocks[UPIPE_ALOUD_SHORT_TERM_BLOCKS];
+    /** histogram of the momentary loudness */
+    uint32_t momentary_histogram[UPIPE_ALOUD_BINS];
+    /** histogram of the short-term loudness */
+    uint32_t short_term_histogram[UPIPE_ALOUD_BINS];
+
+    /** last momentary loudness */
+    double momentary;
+    /** last short-term loudness */
+    double short_term;
+    /** last loudness range */
+    double lra;
+    /** last global integrated loudness */
+    double global;
+};
+
+/** @internal upipe_aloud private structure */
+struct upipe_aloud {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** filtering function */
+    upipe_aloud_filter filter;
+    /** number of channels */
+    uint8_t channels;
+    /** number of planes */
+    uint8_t planes;
+    /** size of a sample of a channel */
+    uint8_t sample_size;
+    /** sample rate */
+    uint64_t rate;
+
+    /** high shelf coefficients b0, b1, b2, a1, a2 */
+    double shelf[5];
+    /** high pass coefficients a1, a2 (b0, b1, b2 being 1, -2, 1) */
+    double pass[2];
+    /** filter states, by blocks of 4 * UPIPE_ALOUD_LANES */
+    double *states;
+    /** filtered energy of each channel in the current 100 ms block */
+    double *energies;
+
+    /** number of samples in a 100 ms block */
+    size_t block_size;
+    /** number of samples in the current 100 ms block */
+    size_t block_samples;
+    /** index of the current 100 ms block in the programs */
+    unsigned int block_index;
+    /** number of complete 100 ms blocks, up to the short-term window */
+    unsigned int nb_blocks;
+
+    /** measured programs */
+    struct upipe_aloud_program *programs;
+    /** number of measured programs */
+    uint8_t nb_programs;
+    /** number of channels of each program, or 0 for all channels */
+    uint8_t program_channels;
+
+    /** energy of the center of each bin of the histograms */
+    double bin_energies[UPIPE_ALOUD_BINS];
+
+    /** output */
+    struct upipe *output;
+    /** output flow */
+    struct uref *output_flow;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** public structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_aloud, upipe, UPIPE_AUDIO_LOUDNESS_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_aloud, urefcount, upipe_aloud_free)
+UPIPE_HELPER_VOID(upipe_aloud)
+UPIPE_HELPER_OUTPUT(upipe_aloud, output, output_flow, output_state,
+                    request_list)
+
+/** @internal @This converts a mean square to a loudness.
+ *
+ * @param energy mean square of the K-weighted signal
+ * @return loudness in LUFS
+ */
+static inline double upipe_aloud_loudness(double energy)
+{
+    if (energy <= 0.)
+        return -HUGE_VAL;
+    return -0.691 + 10. * log10(energy);
+}
+
+/** @internal @This returns the histogram bin of a loudness.
+ *
+ * @param loudness loudness in LUFS
+ * @return index of the bin, or -1 if the loudness is below the absolute gate
+ */
+static inline int upipe_aloud_bin(double loudness)
+{
+    if (!(loudness >= UPIPE_ALOUD_GATE))
+        return -1;
+    int bin = (loudness - UPIPE_ALOUD_GATE) * 10.;
+    return bin < UPIPE_ALOUD_BINS ? bin : UPIPE_ALOUD_BINS - 1;
+}
+
+/** @internal @This allocates a loudness pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_aloud_alloc(struct upipe_mgr *mgr,
+                                       struct uprobe *uprobe,
+                                       uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_aloud_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    upipe_aloud_init_urefcount(upipe);
+    upipe_aloud_init_output(upipe);
+    upipe_aloud->filter = NULL;
+    upipe_aloud->channels = 0;
+    upipe_aloud->planes = 0;
+    upipe_aloud->sample_size = 0;
+    upipe_aloud->rate = 0;
+    upipe_aloud->states = NULL;
+    upipe_aloud->energies = NULL;
+    upipe_aloud->block_size = 0;
+    upipe_aloud->block_samples = 0;
+    upipe_aloud->block_index = 0;
+    upipe_aloud->nb_blocks = 0;
+    upipe_aloud->programs = NULL;
+    upipe_aloud->nb_programs = 0;
+    upipe_aloud->program_channels = 0;
+    for (int i = 0; i < UPIPE_ALOUD_BINS; i++)
+        upipe_aloud->bin_energies[i] =
+            pow(10., (UPIPE_ALOUD_GATE + (i + .5) / 10. + 0.691) / 10.);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+#define UPIPE_ALOUD_TEMPLATE(type, scale)                                   \
+/** @internal @This K-weights samples of type type and accumulates their    \
+ * energy.                                                                  \
+ *                                                                          \
+ * @param upipe description structure of the pipe                           \
+ * @param buffers mapped buffers of every channel                           \
+ * @param stride distance between two samples of a channel, in samples     \
+ * @param offset offset of the first sample to filter                       \
+ * @param samples number of samples to filter                               \
+ */                                                                         \
+static void upipe_aloud_filter_##type(struct upipe *upipe,                  \
+        const void **buffers, size_t stride, size_t offset, size_t samples) \
+{                                                                           \
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);        \
+    static const type zero = 0;                                             \
+    const double b0 = upipe_aloud->shelf[0], b1 = upipe_aloud->shelf[1],    \
+                 b2 = upipe_aloud->shelf[2], a1 = upipe_aloud->shelf[3],    \
+                 a2 = upipe_aloud->shelf[4];                                \
+    const double p1 = upipe_aloud->pass[0], p2 = upipe_aloud->pass[1];      \
+                                                                            \
+    for (unsigned int c = 0; c < upipe_aloud->channels;                     \
+         c += UPIPE_ALOUD_LANES) {                                          \
+        const type *src[UPIPE_ALOUD_LANES];                                 \
+        size_t steps[UPIPE_ALOUD_LANES];                                    \
+        for (unsigned int l = 0; l < UPIPE_ALOUD_LANES; l++) {              \
+            if (c + l < upipe_aloud->channels) {                            \
+                src[l] = (const type *)buffers[c + l] + offset * stride;    \
+                steps[l] = stride;                                          \
+            } else {                                                        \
+                src[l] = &zero;                                             \
+                steps[l] = 0;                                               \
+            }                                                               \
+        }                                                                   \
+                                                                            \
+        double *states = upipe_aloud->states + c * 4;                       \
+        double s1[UPIPE_ALOUD_LANES], s2[UPIPE_ALOUD_LANES],                \
+               s3[UPIPE_ALOUD_LANES], s4[UPIPE_ALOUD_LANES],                \
+               energies[UPIPE_ALOUD_LANES];                                 \
+        memcpy(s1, states, sizeof(s1));                                     \
+        memcpy(s2, states + UPIPE_ALOUD_LANES, sizeof(s2));                 \
+        memcpy(s3, states + 2 * UPIPE_ALOUD_LANES, sizeof(s3));             \
+        memcpy(s4, states + 3 * UPIPE_ALOUD_LANES, sizeof(s4));             \
+        memcpy(energies, upipe_aloud->energies + c, sizeof(energies));      \
+                                                                            \
+        for (size_t i = 0; i < samples; i++) {                              \
+            double x[UPIPE_ALOUD_LANES];                                    \
+            for (unsigned int l = 0; l < UPIPE_ALOUD_LANES; l++)            \
+                x[l] = src[l][i * steps[l]] * (scale);                      \
+            for (unsigned int l = 0; l < UPIPE_ALOUD_LANES; l++) {          \
+                double y = b0 * x[l] + s1[l];                               \
+                s1[l] = b1 * x[l] - a1 * y + s2[l];                         \
+                s2[l] = b2 * x[l] - a2 * y;                                 \
+                double z = y + s3[l];                                       \
+                s3[l] = -2. * y - p1 * z + s4[l];                           \
+                s4[l] = y - p2 * z;                                         \
+                energies[l] += z * z;                                       \
+            }                                                               \
+        }                                                                   \
+                                                                            \
+        /* avoid denormals after silence */                                 \
+        for (unsigned int l = 0; l < UPIPE_ALOUD_LANES; l++) {              \
+            if (fabs(s1[l]) < 1e-30) s1[l] = 0.;                            \
+            if (fabs(s2[l]) < 1e-30) s2[l] = 0.;                            \
+            if (fabs(s3[l]) < 1e-30) s3[l] = 0.;                            \
+            if (fabs(s4[l]) < 1e-30) s4[l] = 0.;                            \
+        }                                                                   \
+        memcpy(states, s1, sizeof(s1));                                     \
+        memcpy(states + UPIPE_ALOUD_LANES, s2, sizeof(s2));                 \
+        memcpy(states + 2 * UPIPE_ALOUD_LANES, s3, sizeof(s3));             \
+        memcpy(states + 3 * UPIPE_ALOUD_LANES, s4, sizeof(s4));             \
+        memcpy(upipe_aloud->energies + c, energies, sizeof(energies));      \
+    }                                                                       \
+}
+UPIPE_ALOUD_TEMPLATE(int16_t, 1. / 32768.)
+UPIPE_ALOUD_TEMPLATE(int32_t, 1. / 2147483648.)
+UPIPE_ALOUD_TEMPLATE(float, 1.)
+UPIPE_ALOUD_TEMPLATE(double, 1.)
+#undef UPIPE_ALOUD_TEMPLATE
+
+/** @internal @This computes a gated loudness from a histogram.
+ *
+ * @param upipe description structure of the pipe
+ * @param histogram histogram of block loudnesses
+ * @param gate relative gate, in LU
+ * @param start_p filled in with the first bin above the relative gate
+ * @param count_p filled in with the number of blocks above the relative gate
+ * @return gated loudness in LUFS
+ */
+static double upipe_aloud_gate(struct upipe *upipe, const uint32_t *histogram,
+                               double gate, int *start_p, uint64_t *count_p)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    double sum = 0.;
+    uint64_t count = 0;
+    for (int i = 0; i < UPIPE_ALOUD_BINS; i++) {
+        sum += histogram[i] * upipe_aloud->bin_energies[i];
+        count += histogram[i];
+    }
+    *start_p = 0;
+    *count_p = 0;
+    if (!count)
+        return -HUGE_VAL;
+
+    int start = upipe_aloud_bin(upipe_aloud_loudness(sum / count) + gate);
+    if (start < 0)
+        start = 0;
+    sum = 0.;
+    count = 0;
+    for (int i = start; i < UPIPE_ALOUD_BINS; i++) {
+        sum += histogram[i] * upipe_aloud->bin_energies[i];
+        count += histogram[i];
+    }
+    *start_p = start;
+    *count_p = count;
+    return count ? upipe_aloud_loudness(sum / count) : -HUGE_VAL;
+}
+
+/** @internal @This computes the loudness range of a program.
+ *
+ * @param upipe description structure of the pipe
+ * @param program measured program
+ * @return loudness range in LU
+ */
+static double upipe_aloud_lra(struct upipe *upipe,
+                              struct upipe_aloud_program *program)
+{
+    int start;
+    uint64_t count;
+    upipe_aloud_gate(upipe, program->short_term_histogram,
+                     UPIPE_ALOUD_LRA_GATE, &start, &count);
+    if (!count)
+        return 0.;
+
+    uint64_t low = (count - 1) * 10 / 100;
+    uint64_t high = (count - 1) * 95 / 100;
+    int low_bin = -1, high_bin = -1;
+    uint64_t cumul = 0;
+    for (int i = start; i < UPIPE_ALOUD_BINS && high_bin < 0; i++) {
+        cumul += program->short_term_histogram[i];
+        if (low_bin < 0 && cumul > low)
+            low_bin = i;
+        if (cumul > high)
+            high_bin = i;
+    }
+    return (high_bin - low_bin) / 10.;
+}
+
+/** @internal @This completes a 100 ms block and updates the measures.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_aloud_complete_block(struct upipe *upipe)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    uint8_t program_channels = upipe_aloud->channels /
+                               upipe_aloud->nb_programs;
+    unsigned int index = upipe_aloud->block_index;
+    if (upipe_aloud->nb_blocks < UPIPE_ALOUD_SHORT_TERM_BLOCKS)
+        upipe_aloud->nb_blocks++;
+    upipe_aloud->block_index = (index + 1) % UPIPE_ALOUD_SHORT_TERM_BLOCKS;
+
+    for (uint8_t i = 0; i < upipe_aloud->nb_programs; i++) {
+        struct upipe_aloud_program *program = &upipe_aloud->programs[i];
+        double energy = 0.;
+        for (uint8_t j = 0; j < program_channels; j++)
+            energy += upipe_aloud->energies[i * program_channels + j];
+        program->blocks[index] = energy;
+
+        /* missing blocks at the start count as silence */
+        double momentary = 0., short_term = 0.;
+        for (unsigned int j = 0; j < upipe_aloud->nb_blocks; j++) {
+            double block = program->blocks[
+                (index + UPIPE_ALOUD_SHORT_TERM_BLOCKS - j) %
+                UPIPE_ALOUD_SHORT_TERM_BLOCKS];
+            if (j < UPIPE_ALOUD_MOMENTARY_BLOCKS)
+                momentary += block;
+            short_term += block;
+        }
+        program->momentary = upipe_aloud_loudness(momentary /
+                (UPIPE_ALOUD_MOMENTARY_BLOCKS * upipe_aloud->block_size));
+        program->short_term = upipe_aloud_loudness(short_term /
+                (UPIPE_ALOUD_SHORT_TERM_BLOCKS * upipe_aloud->block_size));
+
+        int bin;
+        if (upipe_aloud->nb_blocks >= UPIPE_ALOUD_MOMENTARY_BLOCKS &&
+            (bin = upipe_aloud_bin(program->momentary)) >= 0)
+            program->momentary_histogram[bin]++;
+        if (upipe_aloud->nb_blocks >= UPIPE_ALOUD_SHORT_TERM_BLOCKS &&
+            (bin = upipe_aloud_bin(program->short_term)) >= 0)
+            program->short_term_histogram[bin]++;
+
+        int start;
+        uint64_t count;
+        program->global = upipe_aloud_gate(upipe,
+                program->momentary_histogram, UPIPE_ALOUD_GLOBAL_GATE,
+                &start, &count);
+        program->lra = upipe_aloud_lra(upipe, program);
+    }
+
+    memset(upipe_aloud->energies, 0, upipe_aloud->channels * sizeof(double));
+}
+
+/** @internal @This handles input.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to upump structure
+ */
+static void upipe_aloud_input(struct upipe *upipe, struct uref *uref,
+                              struct upump **upump_p)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    if (unlikely(upipe_aloud->filter == NULL || uref->ubuf == NULL)) {
+        upipe_warn(upipe, "invalid uref received");
+        uref_free(uref);
+        return;
+    }
+
+    size_t samples;
+    if (unlikely(!ubase_check(uref_sound_size(uref, &samples, NULL)))) {
+        upipe_warn(upipe, "invalid sound buffer");
+        uref_free(uref);
+        return;
+    }
+
+    const void *buffers[upipe_aloud->channels];
+    if (unlikely(!ubase_check(uref_sound_read_void(uref, 0, -1, buffers,
+                                                   upipe_aloud->planes)))) {
+        upipe_warn(upipe, "error mapping sound buffer");
+        uref_free(uref);
+        return;
+    }
+    size_t stride = 1;
+    if (upipe_aloud->planes == 1) {
+        /* packed samples are read in place */
+        for (uint8_t i = 1; i < upipe_aloud->channels; i++)
+            buffers[i] = (const uint8_t *)buffers[0] +
+                         i * upipe_aloud->sample_size;
+        stride = upipe_aloud->channels;
+    }
+
+    size_t offset = 0;
+    while (offset < samples) {
+        size_t size = upipe_aloud->block_size - upipe_aloud->block_samples;
+        if (size > samples - offset)
+            size = samples - offset;
+        upipe_aloud->filter(upipe, buffers, stride, offset, size);
+        offset += size;
+        upipe_aloud->block_samples += size;
+        if (upipe_aloud->block_samples == upipe_aloud->block_size) {
+            upipe_aloud_complete_block(upipe);
+            upipe_aloud->block_samples = 0;
+        }
+    }
+    uref_sound_unmap(uref, 0, -1, upipe_aloud->planes);
+
+    for (uint8_t i = 0; i < upipe_aloud->nb_programs; i++) {
+        struct upipe_aloud_program *program = &upipe_aloud->programs[i];
+        uref_aloud_set_momentary(uref, program->momentary, i);
+        uref_aloud_set_short_term(uref, program->short_term, i);
+        uref_aloud_set_lra(uref, program->lra, i);
+        uref_aloud_set_global(uref, program->global, i);
+    }
+
+    upipe_aloud_output(upipe, uref, upump_p);
+}
+
+/** @internal @This resets the measures and allocates the programs.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_aloud_reset(struct upipe *upipe)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    uint8_t program_channels = upipe_aloud->program_channels ?
+        upipe_aloud->program_channels : upipe_aloud->channels;
+    if (unlikely(!program_channels ||
+                 upipe_aloud->channels % program_channels))
+        return UBASE_ERR_INVALID;
+    uint8_t nb_programs = upipe_aloud->channels / program_channels;
+
+    /* the states are padded to a whole number of blocks of lanes */
+    unsigned int padded = (upipe_aloud->channels + UPIPE_ALOUD_LANES - 1) /
+                          UPIPE_ALOUD_LANES * UPIPE_ALOUD_LANES;
+    double *states = calloc(padded * 5, sizeof(double));
+    UBASE_ALLOC_RETURN(states);
+    struct upipe_aloud_program *programs =
+        calloc(nb_programs, sizeof(struct upipe_aloud_program));
+    if (unlikely(programs == NULL)) {
+        free(states);
+        return UBASE_ERR_ALLOC;
+    }
+    for (uint8_t i = 0; i < nb_programs; i++) {
+        programs[i].momentary = -HUGE_VAL;
+        programs[i].short_term = -HUGE_VAL;
+        programs[i].global = -HUGE_VAL;
+    }
+
+    free(upipe_aloud->states);
+    free(upipe_aloud->programs);
+    upipe_aloud->states = states;
+    upipe_aloud->energies = states + padded * 4;
+    upipe_aloud->programs = programs;
+    upipe_aloud->nb_programs = nb_programs;
+    upipe_aloud->block_samples = 0;
+    upipe_aloud->block_index = 0;
+    upipe_aloud->nb_blocks = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This computes the K-weighting coefficients for a sample rate.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_aloud_init_coefficients(struct upipe *upipe)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    double rate = upipe_aloud->rate;
+
+    /* high shelf modelling the acoustic effect of the head */
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    double vh = pow(10., gain / 20.);
+    double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1. + k / q + k * k;
+    upipe_aloud->shelf[0] = (vh + vb * k / q + k * k) / a0;
+    upipe_aloud->shelf[1] = 2. * (k * k - vh) / a0;
+    upipe_aloud->shelf[2] = (vh - vb * k / q + k * k) / a0;
+    upipe_aloud->shelf[3] = 2. * (k * k - 1.) / a0;
+    upipe_aloud->shelf[4] = (1. - k / q + k * k) / a0;
+
+    /* revised low-frequency B-curve high pass */
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1. + k / q + k * k;
+    upipe_aloud->pass[0] = 2. * (k * k - 1.) / a0;
+    upipe_aloud->pass[1] = (1. - k / q + k * k) / a0;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow flow definition packet
+ * @return an error code
+ */
+static int upipe_aloud_set_flow_def(struct upipe *upipe, struct uref *flow)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    if (flow == NULL)
+        return UBASE_ERR_INVALID;
+
+    const char *def;
+    UBASE_RETURN(uref_flow_get_def(flow, &def))
+    upipe_aloud_filter filter = NULL;
+    uint8_t sample_size;
+    if (!ubase_ncmp(def, "sound.s16.")) {
+        filter = upipe_aloud_filter_int16_t;
+        sample_size = sizeof(int16_t);
+    } else if (!ubase_ncmp(def, "sound.s32.")) {
+        filter = upipe_aloud_filter_int32_t;
+        sample_size = sizeof(int32_t);
+    } else if (!ubase_ncmp(def, "sound.f32.")) {
+        filter = upipe_aloud_filter_float;
+        sample_size = sizeof(float);
+    } else if (!ubase_ncmp(def, "sound.f64.")) {
+        filter = upipe_aloud_filter_double;
+        sample_size = sizeof(double);
+    } else
+        return UBASE_ERR_INVALID;
+
+    uint8_t channels, planes;
+    uint64_t rate;
+    if (unlikely(!ubase_check(uref_sound_flow_get_channels(flow, &channels))
+              || !ubase_check(uref_sound_flow_get_planes(flow, &planes))
+              || !ubase_check(uref_sound_flow_get_rate(flow, &rate))
+              || !channels || !rate
+              || (planes != channels && planes != 1)))
+        return UBASE_ERR_INVALID;
+
+    struct uref *flow_dup;
+    if (unlikely((flow_dup = uref_dup(flow)) == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    if (channels != upipe_aloud->channels || rate != upipe_aloud->rate) {
+        uint8_t old_channels = upipe_aloud->channels;
+        upipe_aloud->channels = channels;
+        int err = upipe_aloud_reset(upipe);
+        if (unlikely(!ubase_check(err))) {
+            upipe_err_va(upipe, "unable to measure %"PRIu8" channels as "
+                         "programs of %"PRIu8" channels", channels,
+                         upipe_aloud->program_channels);
+            upipe_aloud->channels = old_channels;
+            uref_free(flow_dup);
+            return err;
+        }
+        upipe_aloud->rate = rate;
+        upipe_aloud->block_size = (rate + 5) / 10;
+        upipe_aloud_init_coefficients(upipe);
+    }
+    upipe_aloud->filter = filter;
+    upipe_aloud->planes = planes;
+    upipe_aloud->sample_size = sample_size;
+
+    upipe_aloud_store_flow_def(upipe, flow_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This provides a flow format suggestion.
+ *
+ * @param upipe description structure of the pipe
+ * @param request description structure of the request
+ * @return an error code
+ */
+static int upipe_aloud_provide_flow_format(struct upipe *upipe,
+                                           struct urequest *request)
+{
+    struct uref *flow = uref_dup(request->uref);
+    UBASE_ALLOC_RETURN(flow);
+
+    /* planar buffers are the cheapest to filter */
+    uint8_t planes, channels, sample_size;
+    const char *channels_names;
+    if (ubase_check(uref_sound_flow_get_planes(request->uref, &planes)) &&
+        ubase_check(uref_sound_flow_get_channels(request->uref, &channels)) &&
+        planes == 1 && channels > 1 &&
+        ubase_check(uref_sound_flow_get_sample_size(request->uref,
+                                                    &sample_size)) &&
+        ubase_check(uref_sound_flow_get_channel(request->uref,
+                                                &channels_names, 0)) &&
+        strlen(channels_names) >= channels) {
+        uref_sound_flow_clear_format(flow);
+        UBASE_FATAL(upipe,
+                uref_sound_flow_set_sample_size(flow, sample_size / channels));
+
+        char channel_name[2];
+        channel_name[1] = '\0';
+        for (int i = 0; i < channels; i++) {
+            channel_name[0] = channels_names[i];
+            UBASE_FATAL(upipe, uref_sound_flow_add_plane(flow, channel_name));
+        }
+    }
+
+    return urequest_provide_flow_format(request, flow);
+}
+
+/** @internal @This sets the number of channels of each program.
+ *
+ * @param upipe description structure of the pipe
+ * @param channels number of channels of each program, or 0
+ * @return an error code
+ */
+static int upipe_aloud_set_program_channels_real(struct upipe *upipe,
+                                                 unsigned int channels)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    if (channels > UINT8_MAX)
+        return UBASE_ERR_INVALID;
+    uint8_t previous = upipe_aloud->program_channels;
+    upipe_aloud->program_channels = channels;
+    if (!upipe_aloud->channels)
+        return UBASE_ERR_NONE;
+
+    int err = upipe_aloud_reset(upipe);
+    if (unlikely(!ubase_check(err)))
+        upipe_aloud->program_channels = previous;
+    return err;
+}
+
+/** @internal @This returns the loudness of a program.
+ *
+ * @param upipe description structure of the pipe
+ * @param program index of the program
+ * @param momentary_p filled in with the momentary loudness
+ * @param short_term_p filled in with the short-term loudness
+ * @param lra_p filled in with the loudness range
+ * @param global_p filled in with the global integrated loudness
+ * @return an error code
+ */
+static int upipe_aloud_get_loudness_real(struct upipe *upipe,
+                                         unsigned int program,
+                                         double *momentary_p,
+                                         double *short_term_p,
+                                         double *lra_p, double *global_p)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    if (program >= upipe_aloud->nb_programs)
+        return UBASE_ERR_INVALID;
+
+    struct upipe_aloud_program *p = &upipe_aloud->programs[program];
+    if (momentary_p != NULL)
+        *momentary_p = p->momentary;
+    if (short_term_p != NULL)
+        *short_term_p = p->short_term;
+    if (lra_p != NULL)
+        *lra_p = p->lra;
+    if (global_p != NULL)
+        *global_p = p->global;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_aloud_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_aloud_provide_flow_format(upipe, request);
+            return upipe_aloud_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_FLOW_FORMAT)
+                return UBASE_ERR_NONE;
+            return upipe_aloud_free_output_proxy(upipe, request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_aloud_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_aloud_control_output(upipe, command, args);
+
+        case UPIPE_ALOUD_SET_PROGRAM_CHANNELS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AUDIO_LOUDNESS_SIGNATURE)
+            unsigned int channels = va_arg(args, unsigned int);
+            return upipe_aloud_set_program_channels_real(upipe, channels);
+        }
+        case UPIPE_ALOUD_GET_LOUDNESS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AUDIO_LOUDNESS_SIGNATURE)
+            unsigned int program = va_arg(args, unsigned int);
+            double *momentary_p = va_arg(args, double *);
+            double *short_term_p = va_arg(args, double *);
+            double *lra_p = va_arg(args, double *);
+            double *global_p = va_arg(args, double *);
+            return upipe_aloud_get_loudness_real(upipe, program, momentary_p,
+                                                 short_term_p, lra_p,
+                                                 global_p);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_aloud_free(struct upipe *upipe)
+{
+    struct upipe_aloud *upipe_aloud = upipe_aloud_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    free(upipe_aloud->states);
+    free(upipe_aloud->programs);
+    upipe_aloud_clean_output(upipe);
+    upipe_aloud_clean_urefcount(upipe);
+    upipe_aloud_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_aloud_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_AUDIO_LOUDNESS_SIGNATURE,
+
+    .upipe_alloc = upipe_aloud_alloc,
+    .upipe_input = upipe_aloud_input,
+    .upipe_control = upipe_aloud_control
+};
+
+/** @This returns the management structure for loudness pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_aloud_mgr_alloc(void)
+{
+    return &upipe_aloud_mgr;
+}
@@ -37,16 +37,55 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <float.h>
+#include <math.h>
 
-typedef double (*upipe_amax_process)(struct upipe *, struct uref *,
-                                     const char *, size_t);
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/** number of taps of each phase of the true-peak interpolator */
+#define TP_TAPS 12
+
+/** @internal @This is the state of the true-peak interpolator of a
+ * channel. The last samples are stored twice, so that they can always be
+ * read contiguously. */
+struct upipe_amax_tp {
+    /** last samples, most recent first from pos */
+    double history[2 * TP_TAPS];
+    /** position of the most recent sample */
+    unsigned pos;
+};
+
+/** @internal @This computes the peak amplitude of each channel. */
+typedef void (*upipe_amax_peak)(const void *, size_t, uint8_t, double *);
+/** @internal @This computes the peak amplitude of each channel, along with
+ * the optional RMS and true-peak amplitudes. */
+typedef void (*upipe_amax_stats)(const void *, size_t, uint8_t, double *,
+                                 double *, struct upipe_amax_tp *, double *);
 
 /** @internal upipe_amax private structure */
 struct upipe_amax {
     /** refcount management structure */
     struct urefcount urefcount;
 
-    upipe_amax_process process;
+    /** peak function */
+    upipe_amax_peak peak;
+    /** statistics function */
+    upipe_amax_stats stats;
+    /** number of channels */
+    uint8_t channels;
+    /** true if the channels are interleaved in a single plane */
+    bool interleaved;
+    /** true if RMS amplitudes are computed */
+    bool rms;
+    /** true if true-peak amplitudes are computed */
+    bool true_peak;
+    /** true-peak interpolators, one per channel */
+    struct upipe_amax_tp *tp;
 
     /** output */
     struct upipe *output;
@@ -85,47 +124,327 @@ static struct upipe *upipe_amax_alloc(struct upipe_mgr *mgr,
     struct upipe_amax *upipe_amax = upipe_amax_from_upipe(upipe);
     upipe_amax_init_urefcount(upipe);
     upipe_amax_init_output(upipe);
-    upipe_amax->process = NULL;
+    upipe_amax->peak = NULL;
+    upipe_amax->stats = NULL;
+    upipe_amax->channels = 0;
+    upipe_amax->interleaved = false;
+    upipe_amax->rms = false;
+    upipe_amax->true_peak = false;
+    upipe_amax->tp = NULL;
 
     upipe_throw_ready(upipe);
     return upipe;
 }
 
-#define UPIPE_AMAX_TEMPLATE(type, type_max)                                 \
-/** @internal @This processes input of format type.                         \
+/** ITU-R BS.1770-4 4x oversampling filter, one row per phase */
+static const double tp_coeffs[4][TP_TAPS] = {
+    {  0.0017089843750,  0.0109863281250, -0.0196533203125,
+       0.0332031250000, -0.0594482421875,  0.1373291015625,
+       0.9721679687500, -0.1022949218750,  0.0476074218750,
+      -0.0266113281250,  0.0148925781250, -0.0083007812500 },
+    { -0.0291748046875,  0.0292968750000, -0.0517578125000,
+       0.0891113281250, -0.1665039062500,  0.4650878906250,
+       0.7797851562500, -0.2003173828125,  0.1015625000000,
+      -0.0582275390625,  0.0330810546875, -0.0189208984375 },
+    { -0.0189208984375,  0.0330810546875, -0.0582275390625,
+       0.1015625000000, -0.2003173828125,  0.7797851562500,
+       0.4650878906250, -0.1665039062500,  0.0891113281250,
+      -0.0517578125000,  0.0292968750000, -0.0291748046875 },
+    { -0.0083007812500,  0.0148925781250, -0.0266113281250,
+       0.0476074218750, -0.1022949218750,  0.9721679687500,
+       0.1373291015625, -0.0594482421875,  0.0332031250000,
+      -0.0196533203125,  0.0109863281250,  0.0017089843750 },
+};
+
+/** @internal @This feeds a sample to a true-peak interpolator.
+ *
+ * @param tp interpolator state
+ * @param x normalized sample
+ * @return the highest absolute value of the interpolated samples
+ */
+static inline double upipe_amax_tp_feed(struct upipe_amax_tp *tp, double x)
+{
+    tp->pos = (tp->pos + TP_TAPS - 1) % TP_TAPS;
+    tp->history[tp->pos] = tp->history[tp->pos + TP_TAPS] = x;
+    const double *h = &tp->history[tp->pos];
+
+    double max = 0.;
+    for (int phase = 0; phase < 4; phase++) {
+        double y = 0.;
+        for (int j = 0; j < TP_TAPS; j++)
+            y += tp_coeffs[phase][j] * h[j];
+        y = fabs(y);
+        if (y > max)
+            max = y;
+    }
+    return max;
+}
+
+/** @internal @This folds the lanes of SIMD minimum and maximum vectors into
+ * the per-channel extrema, the lanes cycling through the channels. */
+#define UPIPE_AMAX_FOLD(lanes, lmin, lmax, channels, mins, maxs)            \
+    for (int l = 0; l < lanes; l++) {                                       \
+        uint8_t c = l % channels;                                           \
+        if (lmin[l] < mins[c])                                              \
+            mins[c] = lmin[l];                                              \
+        if (lmax[l] > maxs[c])                                              \
+            maxs[c] = lmax[l];                                              \
+    }
+
+/** @internal @This updates the extrema of each channel from s16 samples,
+ * as long as whole vectors can be processed.
+ *
+ * @param buf interleaved samples
+ * @param n total number of samples, for all channels
+ * @param channels number of channels
+ * @param mins per-channel minimums to update
+ * @param maxs per-channel maximums to update
+ * @return the number of samples processed
+ */
+static size_t upipe_amax_simd_int16_t(const int16_t *buf, size_t n,
+                                      uint8_t channels,
+                                      int16_t *mins, int16_t *maxs)
+{
+    size_t i = 0;
+    if (8 % channels)
+        return 0;
+#if defined(__SSE2__)
+    __m128i vmin = _mm_set1_epi16(INT16_MAX);
+    __m128i vmax = _mm_set1_epi16(INT16_MIN);
+    for ( ; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&buf[i]);
+        vmin = _mm_min_epi16(vmin, v);
+        vmax = _mm_max_epi16(vmax, v);
+    }
+    int16_t lmin[8], lmax[8];
+    _mm_storeu_si128((__m128i *)lmin, vmin);
+    _mm_storeu_si128((__m128i *)lmax, vmax);
+    UPIPE_AMAX_FOLD(8, lmin, lmax, channels, mins, maxs)
+#elif defined(__ARM_NEON)
+    int16x8_t vmin = vdupq_n_s16(INT16_MAX);
+    int16x8_t vmax = vdupq_n_s16(INT16_MIN);
+    for ( ; i + 8 <= n; i += 8) {
+        int16x8_t v = vld1q_s16(&buf[i]);
+        vmin = vminq_s16(vmin, v);
+        vmax = vmaxq_s16(vmax, v);
+    }
+    int16_t lmin[8], lmax[8];
+    vst1q_s16(lmin, vmin);
+    vst1q_s16(lmax, vmax);
+    UPIPE_AMAX_FOLD(8, lmin, lmax, channels, mins, maxs)
+#endif
+    return i;
+}
+
+/** @internal @This updates the extrema of each channel from s32 samples,
+ * as long as whole vectors can be processed.
+ *
+ * @param buf interleaved samples
+ * @param n total number of samples, for all channels
+ * @param channels number of channels
+ * @param mins per-channel minimums to update
+ * @param maxs per-channel maximums to update
+ * @return the number of samples processed
+ */
+static size_t upipe_amax_simd_int32_t(const int32_t *buf, size_t n,
+                                      uint8_t channels,
+                                      int32_t *mins, int32_t *maxs)
+{
+    size_t i = 0;
+    if (4 % channels)
+        return 0;
+#if defined(__SSE2__)
+    __m128i vmin = _mm_set1_epi32(INT32_MAX);
+    __m128i vmax = _mm_set1_epi32(INT32_MIN);
+    for ( ; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&buf[i]);
+        /* no 32-bit min/max before SSE4.1 */
+        __m128i lt = _mm_cmplt_epi32(v, vmin);
+        vmin = _mm_or_si128(_mm_and_si128(lt, v), _mm_andnot_si128(lt, vmin));
+        __m128i gt = _mm_cmpgt_epi32(v, vmax);
+        vmax = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, vmax));
+    }
+    int32_t lmin[4], lmax[4];
+    _mm_storeu_si128((__m128i *)lmin, vmin);
+    _mm_storeu_si128((__m128i *)lmax, vmax);
+    UPIPE_AMAX_FOLD(4, lmin, lmax, channels, mins, maxs)
+#elif defined(__ARM_NEON)
+    int32x4_t vmin = vdupq_n_s32(INT32_MAX);
+    int32x4_t vmax = vdupq_n_s32(INT32_MIN);
+    for ( ; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(&buf[i]);
+        vmin = vminq_s32(vmin, v);
+        vmax = vmaxq_s32(vmax, v);
+    }
+    int32_t lmin[4], lmax[4];
+    vst1q_s32(lmin, vmin);
+    vst1q_s32(lmax, vmax);
+    UPIPE_AMAX_FOLD(4, lmin, lmax, channels, mins, maxs)
+#endif
+    return i;
+}
+
+/** @internal @This updates the extrema of each channel from f32 samples,
+ * as long as whole vectors can be processed.
+ *
+ * @param buf interleaved samples
+ * @param n total number of samples, for all channels
+ * @param channels number of channels
+ * @param mins per-channel minimums to update
+ * @param maxs per-channel maximums to update
+ * @return the number of samples processed
+ */
+static size_t upipe_amax_simd_float(const float *buf, size_t n,
+                                    uint8_t channels,
+                                    float *mins, float *maxs)
+{
+    size_t i = 0;
+    if (4 % channels)
+        return 0;
+#if defined(__SSE2__)
+    __m128 vmin = _mm_set1_ps(FLT_MAX);
+    __m128 vmax = _mm_set1_ps(-FLT_MAX);
+    for ( ; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(&buf[i]);
+        vmin = _mm_min_ps(vmin, v);
+        vmax = _mm_max_ps(vmax, v);
+    }
+    float lmin[4], lmax[4];
+    _mm_storeu_ps(lmin, vmin);
+    _mm_storeu_ps(lmax, vmax);
+    UPIPE_AMAX_FOLD(4, lmin, lmax, channels, mins, maxs)
+#elif defined(__ARM_NEON)
+    float32x4_t vmin = vdupq_n_f32(FLT_MAX);
+    float32x4_t vmax = vdupq_n_f32(-FLT_MAX);
+    for ( ; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(&buf[i]);
+        vmin = vminq_f32(vmin, v);
+        vmax = vmaxq_f32(vmax, v);
+    }
+    float lmin[4], lmax[4];
+    vst1q_f32(lmin, vmin);
+    vst1q_f32(lmax, vmax);
+    UPIPE_AMAX_FOLD(4, lmin, lmax, channels, mins, maxs)
+#endif
+    return i;
+}
+
+/** @internal @This has no vector implementation. */
+#define upipe_amax_simd_uint8_t(buf, n, channels, mins, maxs) 0
+/** @internal @This has no vector implementation. */
+#define upipe_amax_simd_double(buf, n, channels, mins, maxs) 0
+
+#define UPIPE_AMAX_TEMPLATE(type, type_max, type_lowest, type_highest)      \
+/** @internal @This computes the peak amplitude of each channel of input    \
+ * of format type, in a single pass.                                        \
+ *                                                                          \
+ * @param _buf interleaved samples                                          \
+ * @param samples number of samples per channel                             \
+ * @param channels number of channels                                       \
+ * @param peaks filled in with the peak amplitude of each channel           \
+ */                                                                         \
+static void upipe_amax_peak_##type(const void *_buf, size_t samples,        \
+                                   uint8_t channels, double *peaks)         \
+{                                                                           \
+    const type *buf = _buf;                                                 \
+    type mins[channels], maxs[channels];                                    \
+    for (uint8_t c = 0; c < channels; c++) {                                \
+        mins[c] = type_highest;                                             \
+        maxs[c] = type_lowest;                                              \
+    }                                                                       \
+    size_t n = samples * channels;                                          \
+    size_t i = upipe_amax_simd_##type(buf, n, channels, mins, maxs);        \
+    for ( ; i < n; i += channels)                                           \
+        for (uint8_t c = 0; c < channels; c++) {                            \
+            type v = buf[i + c];                                            \
+            if (v < mins[c])                                                \
+                mins[c] = v;                                                \
+            if (v > maxs[c])                                                \
+                maxs[c] = v;                                                \
+        }                                                                   \
+    for (uint8_t c = 0; c < channels; c++) {                                \
+        double max = samples ? maxs[c] : 0., min = samples ? -mins[c] : 0.; \
+        peaks[c] = (max > min ? max : min) / type_max;                      \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+/** @internal @This computes the peak amplitude of each channel of input    \
+ * of format type, along with the optional RMS and true-peak amplitudes,    \
+ * in a single pass.                                                        \
  *                                                                          \
- * @param upipe description structure of the pipe                           \
- * @param uref uref structure                                               \
- * @param channel channel name                                              \
- * @param samples number of samples                                         \
+ * @param _buf interleaved samples                                          \
+ * @param samples number of samples per channel                             \
+ * @param channels number of channels                                       \
+ * @param peaks filled in with the peak amplitude of each channel           \
+ * @param rms filled in with the RMS amplitude of each channel, or NULL     \
+ * @param tp true-peak interpolators of the channels, or NULL               \
+ * @param tps filled in with the true-peak amplitude of each channel        \
  */                                                                         \
-static double upipe_amax_process_##type(struct upipe *upipe,                \
-        struct uref *uref, const char *channel, size_t samples)             \
+static void upipe_amax_stats_##type(const void *_buf, size_t samples,       \
+                                    uint8_t channels, double *peaks,        \
+                                    double *rms, struct upipe_amax_tp *tp,  \
+                                    double *tps)                            \
 {                                                                           \
-    const type *buf = NULL;                                                 \
-    if (unlikely(!ubase_check(uref_sound_plane_read_##type(uref,            \
-            channel, 0, -1, &buf)))) {                                      \
-        upipe_warn(upipe, "error mapping sound buffer");                    \
-        return 0.;                                                          \
+    const type *buf = _buf;                                                 \
+    double sums[channels];                                                  \
+    for (uint8_t c = 0; c < channels; c++) {                                \
+        peaks[c] = sums[c] = 0.;                                            \
+        if (tp != NULL)                                                     \
+            tps[c] = 0.;                                                    \
     }                                                                       \
-    type max = 0;                                                           \
-    for (size_t i = 0; i < samples; i++) {                                  \
-        type c = buf[i];                                                    \
-        if (c > max)                                                        \
-            max = c;                                                        \
-        else if (-c > max)                                                  \
-            max = -c;                                                       \
+    for (size_t i = 0; i < samples; i++, buf += channels)                   \
+        for (uint8_t c = 0; c < channels; c++) {                            \
+            double x = buf[c] * 1. / type_max;                              \
+            double a = fabs(x);                                             \
+            if (a > peaks[c])                                               \
+                peaks[c] = a;                                               \
+            sums[c] += x * x;                                               \
+            if (tp != NULL) {                                               \
+                double t = upipe_amax_tp_feed(&tp[c], x);                   \
+                if (t > tps[c])                                             \
+                    tps[c] = t;                                             \
+            }                                                               \
+        }                                                                   \
+    for (uint8_t c = 0; c < channels; c++) {                                \
+        if (rms != NULL)                                                    \
+            rms[c] = samples ? sqrt(sums[c] / samples) : 0.;                \
+        if (tp != NULL && peaks[c] > tps[c])                                \
+            tps[c] = peaks[c];                                              \
     }                                                                       \
-    uref_sound_plane_unmap(uref, channel, 0, -1);                           \
-    return max * 1. / type_max;                                             \
 }
-UPIPE_AMAX_TEMPLATE(uint8_t, UINT8_MAX)
-UPIPE_AMAX_TEMPLATE(int16_t, INT16_MAX)
-UPIPE_AMAX_TEMPLATE(int32_t, INT32_MAX)
-UPIPE_AMAX_TEMPLATE(float, 1.)
-UPIPE_AMAX_TEMPLATE(double, 1.)
+UPIPE_AMAX_TEMPLATE(uint8_t, UINT8_MAX, 0, UINT8_MAX)
+UPIPE_AMAX_TEMPLATE(int16_t, INT16_MAX, INT16_MIN, INT16_MAX)
+UPIPE_AMAX_TEMPLATE(int32_t, INT32_MAX, INT32_MIN, INT32_MAX)
+UPIPE_AMAX_TEMPLATE(float, 1., -FLT_MAX, FLT_MAX)
+UPIPE_AMAX_TEMPLATE(double, 1., -DBL_MAX, DBL_MAX)
 #undef UPIPE_AMAX_TEMPLATE
 
+/** @internal @This processes a buffer of interleaved channels.
+ *
+ * @param upipe description structure of the pipe
+ * @param buf interleaved samples
+ * @param samples number of samples per channel
+ * @param channels number of channels
+ * @param first index of the first channel
+ * @param peaks filled in with the peak amplitudes
+ * @param rms filled in with the RMS amplitudes
+ * @param tps filled in with the true-peak amplitudes
+ */
+static void upipe_amax_process(struct upipe *upipe, const void *buf,
+                               size_t samples, uint8_t channels,
+                               uint8_t first, double *peaks, double *rms,
+                               double *tps)
+{
+    struct upipe_amax *upipe_amax = upipe_amax_from_upipe(upipe);
+    if (!upipe_amax->rms && upipe_amax->tp == NULL)
+        upipe_amax->peak(buf, samples, channels, peaks + first);
+    else
+        upipe_amax->stats(buf, samples, channels, peaks + first,
+                          upipe_amax->rms ? rms + first : NULL,
+                          upipe_amax->tp ? upipe_amax->tp + first : NULL,
+                          tps + first);
+}
+
 /** @internal @This handles input.
  *
  * @param upipe description structure of the pipe
@@ -136,7 +455,7 @@ static void upipe_amax_input(struct upipe *upipe, struct uref *uref,
                              struct upump **upump_p)
 {
     struct upipe_amax *upipe_amax = upipe_amax_from_upipe(upipe);
-    if (unlikely(upipe_amax->process == NULL || uref->ubuf == NULL)) {
+    if (unlikely(upipe_amax->peak == NULL || uref->ubuf == NULL)) {
         upipe_warn(upipe, "invalid uref received");
         uref_free(uref);
         return;
@@ -148,11 +467,41 @@ static void upipe_amax_input(struct upipe *upipe, struct uref *uref,
         uref_free(uref);
         return;
     }
+
+    if (upipe_amax->true_peak && upipe_amax->tp == NULL) {
+        upipe_amax->tp = calloc(upipe_amax->channels,
+                                sizeof(struct upipe_amax_tp));
+        if (unlikely(upipe_amax->tp == NULL))
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+    }
+
+    uint8_t channels = upipe_amax->channels;
+    double peaks[channels], rms[channels], tps[channels];
     const char *channel = NULL;
     uint8_t j = 0;
     uref_sound_foreach_plane(uref, channel) {
-        double maxf = upipe_amax->process(upipe, uref, channel, samples);
-        uref_amax_set_amplitude(uref, maxf, j++);
+        const uint8_t *buf;
+        uint8_t n = upipe_amax->interleaved ? channels : 1;
+        if (unlikely(j + n > channels))
+            break;
+        if (unlikely(!ubase_check(uref_sound_plane_read_uint8_t(uref,
+                            channel, 0, -1, &buf)))) {
+            upipe_warn(upipe, "error mapping sound buffer");
+            for (uint8_t c = j; c < j + n; c++)
+                peaks[c] = rms[c] = tps[c] = 0.;
+        } else {
+            upipe_amax_process(upipe, buf, samples, n, j, peaks, rms, tps);
+            uref_sound_plane_unmap(uref, channel, 0, -1);
+        }
+        j += n;
+    }
+
+    for (uint8_t c = 0; c < j; c++) {
+        uref_amax_set_amplitude(uref, peaks[c], c);
+        if (upipe_amax->rms)
+            uref_amax_set_rms(uref, rms[c], c);
+        if (upipe_amax->tp != NULL)
+            uref_amax_set_true_peak(uref, tps[c], c);
     }
 
     upipe_amax_output(upipe, uref, upump_p);
@@ -172,26 +521,38 @@ static int upipe_amax_set_flow_def(struct upipe *upipe, struct uref *flow)
 
     const char *def;
     UBASE_RETURN(uref_flow_get_def(flow, &def))
-    upipe_amax_process process = NULL;
+    upipe_amax_peak peak = NULL;
+    upipe_amax_stats stats = NULL;
+#define SET_PROCESS(type)                                                   \
+    do {                                                                    \
+        peak = upipe_amax_peak_##type;                                      \
+        stats = upipe_amax_stats_##type;                                    \
+    } while (0)
     if (!ubase_ncmp(def, "sound.u8."))
-        process = upipe_amax_process_uint8_t;
+        SET_PROCESS(uint8_t);
     else if (!ubase_ncmp(def, "sound.s16."))
-        process = upipe_amax_process_int16_t;
+        SET_PROCESS(int16_t);
     else if (!ubase_ncmp(def, "sound.s32."))
-        process = upipe_amax_process_int32_t;
+        SET_PROCESS(int32_t);
     else if (!ubase_ncmp(def, "sound.f32."))
-        process = upipe_amax_process_float;
+        SET_PROCESS(float);
     else if (!ubase_ncmp(def, "sound.f64."))
-        process = upipe_amax_process_double;
+        SET_PROCESS(double);
     else
         return UBASE_ERR_INVALID;
+#undef SET_PROCESS
     uint8_t channels, planes;
     if (unlikely(!ubase_check(uref_sound_flow_get_channels(flow, &channels))
               || !ubase_check(uref_sound_flow_get_planes(flow, &planes))
-              || planes != channels))
+              || (planes != channels && planes != 1)))
         return UBASE_ERR_INVALID;
 
-    upipe_amax->process = process;
+    upipe_amax->peak = peak;
+    upipe_amax->stats = stats;
+    upipe_amax->channels = channels;
+    upipe_amax->interleaved = planes == 1;
+    free(upipe_amax->tp);
+    upipe_amax->tp = NULL;
 
     struct uref *flow_dup;
     if (unlikely((flow_dup = uref_dup(flow)) == NULL)) {
@@ -203,7 +564,8 @@ static int upipe_amax_set_flow_def(struct upipe *upipe, struct uref *flow)
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This provides a flow format suggestion.
+/** @internal @This provides a flow format suggestion. Both planar and
+ * interleaved formats are handled, so the proposed format is kept as is.
  *
  * @param upipe description structure of the pipe
  * @param request description structure of the request
@@ -214,30 +576,6 @@ static int upipe_amax_provide_flow_format(struct upipe *upipe,
 {
     struct uref *flow = uref_dup(request->uref);
     UBASE_ALLOC_RETURN(flow);
-
-    uint8_t planes, channels, sample_size;
-    const char *channels_names;
-    if (ubase_check(uref_sound_flow_get_planes(request->uref, &planes)) &&
-        ubase_check(uref_sound_flow_get_channels(request->uref, &channels)) &&
-        planes == 1 && channels > 1 &&
-        ubase_check(uref_sound_flow_get_sample_size(request->uref,
-                                                    &sample_size)) &&
-        ubase_check(uref_sound_flow_get_channel(request->uref,
-                                                &channels_names, 0)) &&
-        strlen (channels_names) >= channels) {
-        /* set attributes */
-        uref_sound_flow_clear_format(flow);
-        UBASE_FATAL(upipe,
-                uref_sound_flow_set_sample_size(flow, sample_size / channels));
-
-        char channel_name[2];
-        channel_name[1] = '\0';
-        for (int i = 0; i < channels; i++) {
-            channel_name[0] = channels_names[i];
-            UBASE_FATAL(upipe, uref_sound_flow_add_plane(flow, channel_name));
-        }
-    }
-
     return urequest_provide_flow_format(request, flow);
 }
 
@@ -271,6 +609,23 @@ static int upipe_amax_control(struct upipe *upipe, int command, va_list args)
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
             return upipe_amax_control_output(upipe, command, args);
+
+        case UPIPE_AMAX_SET_RMS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AUDIO_MAX_SIGNATURE)
+            struct upipe_amax *upipe_amax = upipe_amax_from_upipe(upipe);
+            upipe_amax->rms = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_AMAX_SET_TRUE_PEAK: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AUDIO_MAX_SIGNATURE)
+            struct upipe_amax *upipe_amax = upipe_amax_from_upipe(upipe);
+            upipe_amax->true_peak = !!va_arg(args, int);
+            if (!upipe_amax->true_peak) {
+                free(upipe_amax->tp);
+                upipe_amax->tp = NULL;
+            }
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -284,6 +639,8 @@ static void upipe_amax_free(struct upipe *upipe)
 {
     upipe_throw_dead(upipe);
 
+    struct upipe_amax *upipe_amax = upipe_amax_from_upipe(upipe);
+    free(upipe_amax->tp);
     upipe_amax_clean_output(upipe);
     upipe_amax_clean_urefcount(upipe);
     upipe_amax_free_void(upipe);
@@ -31,6 +31,7 @@
 #include "upipe/uref_flow.h"
 #include "upipe/ubuf.h"
 #include "upipe/uref_pic.h"
+#include "upipe/ubuf_pic_blend.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -119,47 +120,6 @@ static struct upipe *upipe_filter_blend_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This computes the per-pixel mean of two lines
- * Code from VLC.
- * - modules/video_filter/deinterlace/merge.c
- *
- * @param _dest dest line
- * @param _s1 first source line
- * @param _s2 second source line
- * @param bytes length in bytes
- */
-static void upipe_filter_merge16bit( void *_dest, const void *_s1,
-                       const void *_s2, size_t bytes )
-{
-    uint16_t *dest = _dest;
-    const uint16_t *s1 = _s1;
-    const uint16_t *s2 = _s2;
-
-    bytes /= 2;
-    for( ; bytes > 0; bytes-- )
-        *dest++ = ( *s1++ + *s2++ ) >> 1;
-}
-
-/** @internal @This computes the per-pixel mean of two lines
- * Code from VLC.
- * - modules/video_filter/deinterlace/merge.c
- *
- * @param _dest dest line
- * @param _s1 first source line
- * @param _s2 second source line
- * @param bytes length in bytes
- */
-static void upipe_filter_merge8bit( void *_dest, const void *_s1,
-                       const void *_s2, size_t bytes )
-{
-    uint8_t *dest = _dest;
-    const uint8_t *s1 = _s1;
-    const uint8_t *s2 = _s2;
-
-    for( ; bytes > 0; bytes-- )
-        *dest++ = ( *s1++ + *s2++ ) >> 1;
-}
-
 /** @internal @This processes a picture plane
  * Adapted from VLC.
  * - modules/video_filter/deinterlace/algo_basic.c
@@ -182,12 +142,12 @@ static void upipe_filter_blend_plane(const uint8_t *in, uint8_t *out,
 
     // Compute mean value for remaining lines
     while (out < out_end) {
+        size_t bytes = (stride_in < stride_out) ? stride_in : stride_out;
         if (macropixel_size == 2)
-            upipe_filter_merge16bit(out, in, in+stride_in,
-                    (stride_in < stride_out) ? stride_in : stride_out);
+            ubuf_pic_average_16((uint16_t *)out, (const uint16_t *)in,
+                                (const uint16_t *)(in + stride_in), bytes / 2);
         else
-            upipe_filter_merge8bit(out, in, in+stride_in,
-                    (stride_in < stride_out) ? stride_in : stride_out);
+            ubuf_pic_average_8(out, in, in + stride_in, bytes);
 
         out += stride_out;
         in += stride_in;
@@ -783,6 +783,7 @@ static void upipe_vanc_process_line(struct upipe *upipe, struct uref *uref,
                                     struct upump **upump_p,
                                     const uint16_t *r, size_t hsize)
 {
+    struct upipe_vanc *upipe_vanc = upipe_vanc_from_upipe(upipe);
     while (hsize > S291_HEADER_SIZE + S291_FOOTER_SIZE) {
         if (r[0] != S291_ADF1 || r[1] != S291_ADF2 || r[2] != S291_ADF3) {
             r++;
@@ -809,15 +810,20 @@ static void upipe_vanc_process_line(struct upipe *upipe, struct uref *uref,
         r += S291_HEADER_SIZE;
         hsize -= S291_HEADER_SIZE;
 
-        if (did == S291_AFD_DID && sdid == S291_AFD_SDID)
-            upipe_vanc_process_afd(upipe, uref, r, dc);
-        else if (did == S291_SCTE104_DID && sdid == S291_SCTE104_SDID)
-            upipe_vanc_process_scte104(upipe, uref, upump_p, r, dc);
-        else if (did == S291_OP47SDP_DID && sdid == S291_OP47SDP_SDID)
-            upipe_vanc_process_op47sdp(upipe, uref, r, dc);
-        else if (did == S291_CEA708_DID && sdid == S291_CEA708_SDID)
-            upipe_vanc_process_cea708(upipe, uref, r, dc);
-        else
+        /* only decode the packets of subpipes having an output */
+        if (did == S291_AFD_DID && sdid == S291_AFD_SDID) {
+            if (upipe_vanc_to_afd_subpipe(upipe_vanc)->output != NULL)
+                upipe_vanc_process_afd(upipe, uref, r, dc);
+        } else if (did == S291_SCTE104_DID && sdid == S291_SCTE104_SDID) {
+            if (upipe_vanc_to_scte104_subpipe(upipe_vanc)->output != NULL)
+                upipe_vanc_process_scte104(upipe, uref, upump_p, r, dc);
+        } else if (did == S291_OP47SDP_DID && sdid == S291_OP47SDP_SDID) {
+            if (upipe_vanc_to_op47_subpipe(upipe_vanc)->output != NULL)
+                upipe_vanc_process_op47sdp(upipe, uref, r, dc);
+        } else if (did == S291_CEA708_DID && sdid == S291_CEA708_SDID) {
+            if (upipe_vanc_to_cea708_subpipe(upipe_vanc)->output != NULL)
+                upipe_vanc_process_cea708(upipe, uref, r, dc);
+        } else
             upipe_verbose_va(upipe, "unhandled ancillary 0x%"PRIx8"/0x%"PRIx8,
                              did, sdid);
 
@@ -863,6 +869,13 @@ static bool upipe_vanc_handle(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
+    if (upipe_vanc_afd->output == NULL && upipe_vanc_scte104->output == NULL &&
+        upipe_vanc_op47->output == NULL && upipe_vanc_cea708->output == NULL) {
+        /* nobody is interested in ancillary data */
+        uref_free(uref);
+        return true;
+    }
+
     if (upipe_vanc_scte104->ubuf_mgr == NULL ||
         upipe_vanc_op47->ubuf_mgr == NULL ||
         upipe_vanc_cea708->ubuf_mgr == NULL)
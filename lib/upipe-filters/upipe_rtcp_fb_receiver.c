@@ -60,6 +60,8 @@
 #include <bitstream/ietf/rtcp_sdes.h>
 
 #define EXPECTED_FLOW_DEF "block."
+/** default maximum size of the retransmission buffer, in octets */
+#define DEFAULT_MAX_SIZE (64 << 20)
 
 /** upipe_rtcpfb structure */
 struct upipe_rtcpfb {
@@ -84,7 +86,14 @@ struct upipe_rtcpfb {
     struct upump *upump_timer;
     struct uclock *uclock;
     struct urequest uclock_request;
+    /** packets kept for retransmission, oldest first */
     struct uchain queue;
+    /** packets of queue, indexed by sequence number */
+    struct uref *index[UINT16_MAX + 1];
+    /** size of the packets of queue, in octets */
+    uint64_t queue_size;
+    /** maximum size of the packets of queue, in octets */
+    uint64_t max_size;
     unsigned last_seq;
 
     /** list of input subpipes */
@@ -262,78 +271,86 @@ static int ctz(unsigned int x)
 #endif
 }
 
-/** @internal @This retransmits a number of packets */
+/** @internal @This removes a packet from the retransmission buffer.
+ *
+ * @param upipe_rtcpfb private structure of the pipe
+ * @param uref buffered packet
+ */
+static void upipe_rtcpfb_delete(struct upipe_rtcpfb *upipe_rtcpfb,
+                                struct uref *uref)
+{
+    uint64_t seqnum = 0;
+    uref_attr_get_priv(uref, &seqnum);
+    if (upipe_rtcpfb->index[(uint16_t)seqnum] == uref)
+        upipe_rtcpfb->index[(uint16_t)seqnum] = NULL;
+
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    upipe_rtcpfb->queue_size -= size;
+
+    ulist_delete(uref_to_uchain(uref));
+    uref_free(uref);
+}
+
+/** @internal @This retransmits a packet if it is still buffered.
+ *
+ * @param upipe description structure of the subpipe
+ * @param upipe_super description structure of the super pipe
+ * @param seq sequence number of the lost packet
+ * @return false if the packet is not buffered
+ */
+static bool upipe_rtcpfb_retransmit(struct upipe *upipe,
+                                    struct upipe *upipe_super, uint16_t seq)
+{
+    struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe_super);
+    struct uref *uref = upipe_rtcpfb->index[seq];
+    if (uref == NULL)
+        return false;
+
+    upipe_verbose_va(upipe, "Retransmit %hu", seq);
+    upipe_rtcpfb->retrans++;
+
+    uint8_t *buf;
+    int s = 0;
+    if (ubase_check(uref_block_write(uref, 0, &s, &buf))) {
+        uint8_t ssrc[4];
+        rtp_get_ssrc(buf, ssrc);
+        ssrc[3] |= 1; /* RIST retransmitted packet */
+        rtp_set_ssrc(buf, ssrc);
+        uref_block_unmap(uref, 0);
+    }
+
+    upipe_rtcpfb_output(upipe_super, uref_dup(uref), NULL);
+    return true;
+}
+
+/** @internal @This retransmits a range of packets, from seq to seq + pkts
+ * included. */
 static void upipe_rtcpfb_lost_sub_n(struct upipe *upipe, uint16_t seq, uint16_t pkts)
 {
     struct upipe *upipe_super = NULL;
     upipe_rtcpfb_input_get_super(upipe, &upipe_super);
-    struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe_super);
-
-    struct uchain *uchain;
-    ulist_foreach(&upipe_rtcpfb->queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-        uint64_t uref_seqnum = 0;
-        uref_attr_get_priv(uref, &uref_seqnum);
-
-        uint16_t diff = uref_seqnum - seq;
-        if (diff > pkts) {
-            /* packet not in range */
-            if (diff < 0x8000) {
-                /* packet after range */
-                return;
-            }
-            continue;
-        }
 
-        upipe_verbose_va(upipe, "Retransmit %hu", seq);
-        upipe_rtcpfb->retrans++;
-
-        uint8_t *buf;
-        int s = 0;
-        if (ubase_check(uref_block_write(uref, 0, &s, &buf))) {
-            uint8_t ssrc[4];
-            rtp_get_ssrc(buf, ssrc);
-            ssrc[3] |= 1; /* RIST retransmitted packet */
-            rtp_set_ssrc(buf, ssrc);
-            uref_block_unmap(uref, 0);
-        }
+    unsigned int missing = 0;
+    for (uint32_t i = 0; i <= pkts; i++)
+        if (!upipe_rtcpfb_retransmit(upipe, upipe_super, seq + i))
+            missing++;
 
-        upipe_rtcpfb_output(upipe_super, uref_dup(uref), NULL);
-    }
+    if (missing)
+        upipe_warn_va(upipe, "Couldn't find %u packets in range %hu-%hu",
+                      missing, seq, (uint16_t)(seq + pkts));
 }
 
 /** @internal @This retransmits a list of packets described by a single FCI.
- * TODO: handle a list of FCIs.
  */
 static void upipe_rtcpfb_lost_sub(struct upipe *upipe, uint16_t seq, uint16_t mask)
 {
     struct upipe *upipe_super = NULL;
     upipe_rtcpfb_input_get_super(upipe, &upipe_super);
-    struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe_super);
 
-    struct uchain *uchain;
-    ulist_foreach(&upipe_rtcpfb->queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-        uint64_t uref_seqnum = 0;
-        uref_attr_get_priv(uref, &uref_seqnum);
-
-        if (seq != uref_seqnum)
-            continue;
-
-        upipe_verbose_va(upipe, "Retransmit %hu", seq);
-        upipe_rtcpfb->retrans++;
-
-        uint8_t *buf;
-        int s = 0;
-        if (ubase_check(uref_block_write(uref, 0, &s, &buf))) {
-            uint8_t ssrc[4];
-            rtp_get_ssrc(buf, ssrc);
-            ssrc[3] |= 1; /* RIST retransmitted packet */
-            rtp_set_ssrc(buf, ssrc);
-            uref_block_unmap(uref, 0);
-        }
-
-        upipe_rtcpfb_output(upipe_super, uref_dup(uref), NULL);
+    for (;;) {
+        if (!upipe_rtcpfb_retransmit(upipe, upipe_super, seq))
+            upipe_warn_va(upipe, "Couldn't find seq %hu", seq);
 
         if (!mask)
             return;
@@ -342,8 +359,6 @@ static void upipe_rtcpfb_lost_sub(struct upipe *upipe, uint16_t seq, uint16_t ma
         mask >>= zeros + 1;
         seq += zeros + 1;
     }
-
-    upipe_warn_va(upipe, "Couldn't find seq %hu", seq);
 }
 
 /** @This is called when there is no external reference to the pipe anymore.
@@ -420,8 +435,7 @@ static void upipe_rtcpfb_timer(struct upump *upump)
         upipe_verbose_va(upipe, "Delete seq %" PRIu64 " after %"PRIu64" clocks",
                 seqnum, now - cr_sys);
 
-        ulist_delete(uchain);
-        uref_free(uref);
+        upipe_rtcpfb_delete(upipe_rtcpfb, uref);
     }
 }
 
@@ -547,6 +561,9 @@ static struct upipe *upipe_rtcpfb_alloc(struct upipe_mgr *mgr,
     upipe_rtcpfb_init_ubuf_mgr(upipe);
     upipe_rtcpfb_init_uref_mgr(upipe);
     ulist_init(&upipe_rtcpfb->queue);
+    memset(upipe_rtcpfb->index, 0, sizeof(upipe_rtcpfb->index));
+    upipe_rtcpfb->queue_size = 0;
+    upipe_rtcpfb->max_size = DEFAULT_MAX_SIZE;
     upipe_rtcpfb->expected_seqnum = -1;
     upipe_rtcpfb->retrans = 0;
     upipe_rtcpfb->last_seq = UINT_MAX;
@@ -590,8 +607,20 @@ static inline void upipe_rtcpfb_input(struct upipe *upipe, struct uref *uref,
     upipe_verbose_va(upipe, "Output & buffer %hu", seqnum);
 
     /* Buffer packet in case retransmission is needed */
+    if (upipe_rtcpfb->index[seqnum] != NULL)
+        upipe_rtcpfb_delete(upipe_rtcpfb, upipe_rtcpfb->index[seqnum]);
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    upipe_rtcpfb->queue_size += size;
+    upipe_rtcpfb->index[seqnum] = uref;
     ulist_add(&upipe_rtcpfb->queue, uref_to_uchain(uref));
 
+    /* Drop the oldest packets if the buffer is too large */
+    while (upipe_rtcpfb->queue_size > upipe_rtcpfb->max_size) {
+        struct uchain *uchain = ulist_peek(&upipe_rtcpfb->queue);
+        upipe_rtcpfb_delete(upipe_rtcpfb, uref_from_uchain(uchain));
+    }
+
     upipe_rtcpfb->last_seq = seqnum;
 }
 
@@ -640,10 +669,16 @@ static int _upipe_rtcpfb_control(struct upipe *upipe, int command, va_list args)
         case UPIPE_SET_OPTION: {
             const char *k = va_arg(args, const char *);
             const char *v = va_arg(args, const char *);
+            struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe);
+            if (!strcmp(k, "max-size")) {
+                upipe_rtcpfb->max_size = strtoull(v, NULL, 10);
+                upipe_dbg_va(upipe, "Set buffer size to %"PRIu64" octets",
+                        upipe_rtcpfb->max_size);
+                return UBASE_ERR_NONE;
+            }
             if (strcmp(k, "latency"))
                 return UBASE_ERR_INVALID;
 
-            struct upipe_rtcpfb *upipe_rtcpfb = upipe_rtcpfb_from_upipe(upipe);
             upipe_rtcpfb->latency = atoi(v);
             upipe_dbg_va(upipe, "Set latency to %"PRIu64" msecs",
                     upipe_rtcpfb->latency);
@@ -690,11 +725,8 @@ static void upipe_rtcpfb_free(struct upipe *upipe)
     upipe_rtcpfb_clean_uclock(upipe);
 
     struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach(&upipe_rtcpfb->queue, uchain, uchain_tmp) {
-        struct uref *uref = uref_from_uchain(uchain);
-        ulist_delete(uchain);
-        uref_free(uref);
-    }
+    ulist_delete_foreach(&upipe_rtcpfb->queue, uchain, uchain_tmp)
+        upipe_rtcpfb_delete(upipe_rtcpfb, uref_from_uchain(uchain));
 
     upipe_rtcpfb_free_void(upipe);
 }
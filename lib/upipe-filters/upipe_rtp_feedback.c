@@ -82,6 +82,8 @@ struct upipe_rtpfb {
     struct uclock *uclock;
     struct urequest uclock_request;
     struct uchain queue;
+    /** packets of queue, indexed by sequence number */
+    struct uref *index[UINT16_MAX + 1];
     struct uprobe *uprobe;
 
     /** expected sequence number */
@@ -111,8 +113,6 @@ struct upipe_rtpfb {
     /** buffer latency */
     uint64_t latency;
 
-    struct upipe *rtpfb_output;
-
     /** last time a NACK was sent */
     uint64_t last_nack[65536];
 
@@ -170,6 +170,17 @@ struct upipe_rtpfb_output {
     /** timestamp of last XR */
     uint64_t xr_cr;
 
+    /** round-trip time of the path */
+    uint64_t rtt;
+    /** next sequence number expected on the path */
+    unsigned expected_seqnum;
+    /** RTP packets received on the path */
+    size_t packets;
+    /** duplicate RTP packets received on the path */
+    size_t dups;
+    /** RTP packets missing on the path */
+    size_t loss;
+
     /** cname */
     char *name;
 
@@ -243,10 +254,6 @@ static struct upipe *upipe_rtpfb_output_alloc(struct upipe_mgr *mgr,
     if (mgr->signature != UPIPE_RTPFB_OUTPUT_SIGNATURE)
         return NULL;
 
-    struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_sub_mgr(mgr);
-    if (upipe_rtpfb->rtpfb_output)
-        return NULL;
-
     struct upipe *upipe = upipe_rtpfb_output_alloc_void(mgr, uprobe, signature, args);
     if (unlikely(upipe == NULL))
         return NULL;
@@ -255,8 +262,12 @@ static struct upipe *upipe_rtpfb_output_alloc(struct upipe_mgr *mgr,
 
     upipe_rtpfb_output->sr_cr = UINT64_MAX;
     upipe_rtpfb_output->xr_cr = UINT64_MAX;
+    upipe_rtpfb_output->rtt = 0;
+    upipe_rtpfb_output->expected_seqnum = UINT_MAX;
+    upipe_rtpfb_output->packets = 0;
+    upipe_rtpfb_output->dups = 0;
+    upipe_rtpfb_output->loss = 0;
     upipe_rtpfb_output->name = NULL;
-    upipe_rtpfb->rtpfb_output = upipe;
 
     upipe_rtpfb_output_init_urefcount(upipe);
     upipe_rtpfb_output_init_output(upipe);
@@ -271,6 +282,60 @@ static struct upipe *upipe_rtpfb_output_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+static void upipe_rtpfb_restart_timer(struct upipe *upipe);
+
+/** @internal @This updates the round-trip time of the pipe from the lowest
+ * one measured on its paths.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtpfb_update_rtt(struct upipe *upipe)
+{
+    struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_upipe(upipe);
+    uint64_t rtt = 0;
+
+    struct uchain *uchain;
+    ulist_foreach(&upipe_rtpfb->outputs, uchain) {
+        struct upipe_rtpfb_output *upipe_rtpfb_output =
+            upipe_rtpfb_output_from_uchain(uchain);
+        if (upipe_rtpfb_output->rtt &&
+            (!rtt || upipe_rtpfb_output->rtt < rtt))
+            rtt = upipe_rtpfb_output->rtt;
+    }
+
+    if (rtt == upipe_rtpfb->rtt)
+        return;
+    upipe_rtpfb->rtt = rtt;
+    upipe_rtpfb_restart_timer(upipe);
+}
+
+/** @internal @This returns the path retransmission requests are sent on,
+ * which is the one with the lowest round-trip time.
+ *
+ * @param upipe description structure of the pipe
+ * @return description structure of the subpipe, or NULL
+ */
+static struct upipe *upipe_rtpfb_best_path(struct upipe *upipe)
+{
+    struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_upipe(upipe);
+    struct upipe_rtpfb_output *best = NULL;
+
+    struct uchain *uchain;
+    ulist_foreach(&upipe_rtpfb->outputs, uchain) {
+        struct upipe_rtpfb_output *upipe_rtpfb_output =
+            upipe_rtpfb_output_from_uchain(uchain);
+        if (upipe_rtpfb_output->uref_mgr == NULL ||
+            upipe_rtpfb_output->ubuf_mgr == NULL)
+            continue;
+        if (best == NULL ||
+            (upipe_rtpfb_output->rtt &&
+             (!best->rtt || upipe_rtpfb_output->rtt < best->rtt)))
+            best = upipe_rtpfb_output;
+    }
+
+    return best ? upipe_rtpfb_output_to_upipe(best) : NULL;
+}
+
 /** @This frees a upipe.
  *
  * @param upipe description structure of the pipe
@@ -281,10 +346,10 @@ static void upipe_rtpfb_output_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_sub_mgr(upipe->mgr);
-    upipe_rtpfb->rtpfb_output = NULL;
     free(upipe_rtpfb_output->name);
     upipe_rtpfb_output_clean_output(upipe);
     upipe_rtpfb_output_clean_sub(upipe);
+    upipe_rtpfb_update_rtt(upipe_rtpfb_to_upipe(upipe_rtpfb));
     upipe_rtpfb_output_clean_urefcount(upipe);
     upipe_rtpfb_output_clean_ubuf_mgr(upipe);
     upipe_rtpfb_output_clean_uref_mgr(upipe);
@@ -385,6 +450,8 @@ static void upipe_rtpfb_timer_lost(struct upump *upump)
     /* space out NACKs a bit more than RTT. XXX: tune me */
     uint64_t next_nack = now - rtt * 12 / 10;
 
+    struct upipe *path = upipe_rtpfb_best_path(upipe);
+
     /* TODO: do not look at the last pkts/s * rtt
      * It it too late to send a NACK for these
      * XXX: use cr_sys, because pkts/s also accounts for
@@ -428,8 +495,8 @@ static void upipe_rtpfb_timer_lost(struct upump *upump)
                 - check the following packets to fill in bitmask
                 - send request in a single batch (multiple FCI)
              */
-            if (upipe_rtpfb->rtpfb_output)
-                upipe_rtpfb_output_lost(upipe_rtpfb->rtpfb_output, expected_seq, seqnum, upipe_rtpfb->last_ssrc);
+            if (path)
+                upipe_rtpfb_output_lost(path, expected_seq, seqnum, upipe_rtpfb->last_ssrc);
             holes++;
         }
 
@@ -483,6 +550,8 @@ static void upipe_rtpfb_timer(struct upump *upump)
 
         upipe_rtpfb->last_output_seqnum = seqnum;
 
+        if (upipe_rtpfb->index[(uint16_t)seqnum] == uref)
+            upipe_rtpfb->index[(uint16_t)seqnum] = NULL;
         ulist_delete(uchain);
         upipe_rtpfb_output(upipe, uref, NULL); // XXX: use timer upump ?
         if (--upipe_rtpfb->buffered == 0) {
@@ -492,6 +561,11 @@ static void upipe_rtpfb_timer(struct upump *upump)
     }
 }
 
+/** @internal @This restarts the timer checking for lost packets, after a
+ * change of round-trip time.
+ *
+ * @param upipe description structure of the pipe
+ */
 static void upipe_rtpfb_restart_timer(struct upipe *upipe)
 {
     struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_upipe(upipe);
@@ -555,6 +629,12 @@ static int upipe_rtpfb_output_set_flow_def(struct upipe *upipe, struct uref *flo
         return UBASE_ERR_INVALID;
     UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
 
+    /* RTP packets received on paths are output by the super pipe */
+    struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_sub_mgr(upipe->mgr);
+    if (upipe_rtpfb->flow_def_input == NULL)
+        return upipe_set_flow_def(upipe_rtpfb_to_upipe(upipe_rtpfb),
+                                  flow_def);
+
     return UBASE_ERR_NONE;
 }
 
@@ -601,6 +681,25 @@ static int _upipe_rtpfb_output_control(struct upipe *upipe,
             const char *name = va_arg(args, const char *);
             return _upipe_rtpfb_output_set_name(upipe, name);
         }
+        case UPIPE_RTPFB_OUTPUT_GET_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTPFB_OUTPUT_SIGNATURE)
+            size_t *packets_p = va_arg(args, size_t *);
+            size_t *dups_p = va_arg(args, size_t *);
+            size_t *loss_p = va_arg(args, size_t *);
+            uint64_t *rtt_p = va_arg(args, uint64_t *);
+
+            struct upipe_rtpfb_output *upipe_rtpfb_output =
+                upipe_rtpfb_output_from_upipe(upipe);
+            *packets_p = upipe_rtpfb_output->packets;
+            *dups_p = upipe_rtpfb_output->dups;
+            *loss_p = upipe_rtpfb_output->loss;
+            *rtt_p = upipe_rtpfb_output->rtt;
+
+            upipe_rtpfb_output->packets = 0;
+            upipe_rtpfb_output->dups = 0;
+            upipe_rtpfb_output->loss = 0;
+            return UBASE_ERR_NONE;
+        }
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_rtpfb_output_set_flow_def(upipe, flow_def);
@@ -750,10 +849,10 @@ static struct upipe *upipe_rtpfb_alloc(struct upipe_mgr *mgr,
     upipe_rtpfb_init_upump_timer_lost(upipe);
     upipe_rtpfb_init_uclock(upipe);
     ulist_init(&upipe_rtpfb->queue);
+    memset(upipe_rtpfb->index, 0, sizeof(upipe_rtpfb->index));
     memset(upipe_rtpfb->last_nack, 0, sizeof(upipe_rtpfb->last_nack));
     upipe_rtpfb->rtt = 0;
     upipe_rtpfb_require_uclock(upipe);
-    upipe_rtpfb->rtpfb_output = NULL;
     upipe_rtpfb->uprobe = uprobe_use(uprobe);
     upipe_rtpfb->last_output_seqnum = UINT_MAX;
     upipe_rtpfb->buffered = 0;
@@ -815,6 +914,7 @@ static bool upipe_rtpfb_insert_inner(struct upipe *upipe, struct uref *uref,
 
     upipe_rtpfb->buffered++;
     ulist_insert(uchain->prev, uchain, uref_to_uchain(uref));
+    upipe_rtpfb->index[seqnum] = uref;
     upipe_rtpfb->repaired++;
     upipe_rtpfb->last_nack[seqnum] = 0;
 
@@ -839,7 +939,39 @@ static bool upipe_rtpfb_insert(struct upipe *upipe, struct uref *uref, const uin
     return false;
 }
 
-/** @internal @This handles RTCP data.
+static bool upipe_rtpfb_handle_rtp(struct upipe *upipe, struct uref *uref,
+                                   uint16_t seqnum);
+
+/** @internal @This handles RTP data received on a path.
+ *
+ * @param upipe description structure of the subpipe
+ * @param uref uref structure
+ * @param seqnum RTP sequence number of the packet
+ */
+static void upipe_rtpfb_output_input_rtp(struct upipe *upipe,
+                                         struct uref *uref, uint16_t seqnum)
+{
+    struct upipe_rtpfb_output *upipe_rtpfb_output =
+        upipe_rtpfb_output_from_upipe(upipe);
+    struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_sub_mgr(upipe->mgr);
+
+    upipe_rtpfb_output->packets++;
+    if (likely(upipe_rtpfb_output->expected_seqnum != UINT_MAX)) {
+        uint16_t diff = seqnum - upipe_rtpfb_output->expected_seqnum;
+        if (diff < 0x8000) {
+            upipe_rtpfb_output->loss += diff;
+            upipe_rtpfb_output->expected_seqnum = (seqnum + 1) & UINT16_MAX;
+        }
+    } else
+        upipe_rtpfb_output->expected_seqnum = (seqnum + 1) & UINT16_MAX;
+
+    if (upipe_rtpfb_handle_rtp(upipe_rtpfb_to_upipe(upipe_rtpfb), uref, seqnum))
+        upipe_rtpfb_output->dups++;
+}
+
+/** @internal @This handles data received on a path: RTCP packets are
+ * processed and RTP packets are merged into the buffer of the super pipe.
+ * Both are told apart by their payload type, as in RFC 5761.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
@@ -851,12 +983,6 @@ static void upipe_rtpfb_output_input(struct upipe *upipe, struct uref *uref,
     struct upipe_rtpfb_output *upipe_rtpfb_output = upipe_rtpfb_output_from_upipe(upipe);
     struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_sub_mgr(upipe->mgr);
 
-    if (upipe_rtpfb_output->uref_mgr == NULL || upipe_rtpfb_output->ubuf_mgr == NULL) {
-        upipe_rtpfb_output_check(upipe, NULL);
-        uref_free(uref);
-        return;
-    }
-
     const uint8_t *buf;
     int s = -1;
     if (!ubase_check(uref_block_read(uref, 0, &s, &buf))) {
@@ -878,6 +1004,20 @@ static void upipe_rtpfb_output_input(struct upipe *upipe, struct uref *uref,
         goto unmap;
     }
 
+    if (pt < 192 || pt > 223) {
+        /* RTP packet */
+        uint16_t seqnum = rtp_get_seqnum(buf);
+        rtp_get_ssrc(buf, upipe_rtpfb->last_ssrc);
+        uref_block_unmap(uref, 0);
+        upipe_rtpfb_output_input_rtp(upipe, uref, seqnum);
+        return;
+    }
+
+    if (upipe_rtpfb_output->uref_mgr == NULL || upipe_rtpfb_output->ubuf_mgr == NULL) {
+        upipe_rtpfb_output_check(upipe, NULL);
+        goto unmap;
+    }
+
     if (pt == RTCP_PT_SR) {
         if (s < RTCP_SR_SIZE) {
             goto unmap;
@@ -939,8 +1079,8 @@ static void upipe_rtpfb_output_input(struct upipe *upipe, struct uref *uref,
             upipe_rtpfb_output->xr_cr - delay * UCLOCK_FREQ / 65536;
 
         upipe_verbose_va(upipe, "RTT %f", (float)rtt / UCLOCK_FREQ);
-        upipe_rtpfb->rtt = rtt;
-        upipe_rtpfb_restart_timer(upipe_rtpfb_to_upipe(upipe_rtpfb));
+        upipe_rtpfb_output->rtt = rtt;
+        upipe_rtpfb_update_rtt(upipe_rtpfb_to_upipe(upipe_rtpfb));
     }
 
 unmap:
@@ -948,41 +1088,29 @@ unmap:
     uref_free(uref);
 }
 
-/** @internal @This handles RTP data.
+/** @internal @This buffers an RTP packet.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
- * @param upump_p reference to pump that generated the buffer
+ * @param seqnum RTP sequence number of the packet
+ * @return true if the packet was a duplicate
  */
-static void upipe_rtpfb_input(struct upipe *upipe, struct uref *uref,
-                                    struct upump **upump_p)
+static bool upipe_rtpfb_handle_rtp(struct upipe *upipe, struct uref *uref,
+                                   uint16_t seqnum)
 {
     struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_upipe(upipe);
-    uint8_t rtp_buffer[RTP_HEADER_SIZE];
-    const uint8_t *rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE,
-                                                rtp_buffer);
-    if (unlikely(rtp_header == NULL)) {
-        upipe_warn(upipe, "invalid buffer received");
-        uref_free(uref);
-        return;
-    }
-
-    /* parse RTP header */
-    bool valid = rtp_check_hdr(rtp_header);
-    uint16_t seqnum = rtp_get_seqnum(rtp_header);
-
-    rtp_get_ssrc(rtp_header, upipe_rtpfb->last_ssrc);
 
-    uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
-    if (unlikely(!valid)) {
-        upipe_warn(upipe, "invalid RTP header");
+    if (upipe_rtpfb->upump_mgr == NULL) {
         uref_free(uref);
-        return;
+        return false;
     }
 
-    if (upipe_rtpfb->upump_mgr == NULL) {
+    /* packet already received, possibly on another path */
+    if (upipe_rtpfb->index[seqnum] != NULL) {
+        upipe_verbose_va(upipe, "dropping duplicate %hu", seqnum);
+        upipe_rtpfb->dups++;
         uref_free(uref);
-        return;
+        return true;
     }
 
     /* store seqnum in uref */
@@ -998,6 +1126,7 @@ static void upipe_rtpfb_input(struct upipe *upipe, struct uref *uref,
         /* packet is from the future */
         upipe_rtpfb->buffered++;
         ulist_add(&upipe_rtpfb->queue, uref_to_uchain(uref));
+        upipe_rtpfb->index[seqnum] = uref;
         upipe_rtpfb->last_nack[seqnum] = 0;
 
         if (diff != 0) {
@@ -1010,12 +1139,12 @@ static void upipe_rtpfb_input(struct upipe *upipe, struct uref *uref,
         }
 
         upipe_rtpfb->expected_seqnum = seqnum + 1;
-        return;
+        return false;
     }
 
     /* packet is from the past, reordered or retransmitted */
     if (upipe_rtpfb_insert(upipe, uref, seqnum))
-        return;
+        return false;
 
     uint64_t first_seq = 0, last_seq = 0;
     uref_attr_get_priv(uref_from_uchain(upipe_rtpfb->queue.next), &first_seq);
@@ -1024,6 +1153,42 @@ static void upipe_rtpfb_input(struct upipe *upipe, struct uref *uref,
     upipe_err_va(upipe, "LATE packet %hu, dropped (buffered %"PRIu64" -> %"PRIu64")",
             seqnum, first_seq, last_seq);
     uref_free(uref);
+    return false;
+}
+
+/** @internal @This handles RTP data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtpfb_input(struct upipe *upipe, struct uref *uref,
+                                    struct upump **upump_p)
+{
+    struct upipe_rtpfb *upipe_rtpfb = upipe_rtpfb_from_upipe(upipe);
+    uint8_t rtp_buffer[RTP_HEADER_SIZE];
+    const uint8_t *rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE,
+                                                rtp_buffer);
+    if (unlikely(rtp_header == NULL)) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return;
+    }
+
+    /* parse RTP header */
+    bool valid = rtp_check_hdr(rtp_header);
+    uint16_t seqnum = rtp_get_seqnum(rtp_header);
+
+    rtp_get_ssrc(rtp_header, upipe_rtpfb->last_ssrc);
+
+    uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
+    if (unlikely(!valid)) {
+        upipe_warn(upipe, "invalid RTP header");
+        uref_free(uref);
+        return;
+    }
+
+    upipe_rtpfb_handle_rtp(upipe, uref, seqnum);
 }
 
 /** @internal @This sets the input flow definition.
@@ -1055,10 +1220,19 @@ static int upipe_rtpfb_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     uref_clock_set_latency(flow_def, latency + upipe_rtpfb->latency);
     upipe_rtpfb_store_flow_def(upipe, flow_def);
 
-    if (upipe_rtpfb->rtpfb_output)
-        upipe_rtpfb_output_store_flow_def(upipe_rtpfb->rtpfb_output, flow_def_dup);
-    else
-        uref_free(flow_def_dup);
+    struct uchain *uchain;
+    ulist_foreach(&upipe_rtpfb->outputs, uchain) {
+        struct upipe_rtpfb_output *upipe_rtpfb_output =
+            upipe_rtpfb_output_from_uchain(uchain);
+        struct uref *flow_def_output = uref_dup(flow_def_dup);
+        if (unlikely(flow_def_output == NULL)) {
+            uref_free(flow_def_dup);
+            return UBASE_ERR_ALLOC;
+        }
+        upipe_rtpfb_output_store_flow_def(
+            upipe_rtpfb_output_to_upipe(upipe_rtpfb_output), flow_def_output);
+    }
+    uref_free(flow_def_dup);
 
     return UBASE_ERR_NONE;
 }
@@ -1161,7 +1335,6 @@ static void upipe_rtpfb_free(struct upipe *upipe)
     upipe_rtpfb_clean_output(upipe);
     upipe_rtpfb_clean_urefcount(upipe);
     upipe_rtpfb_clean_urefcount_real(upipe);
-    upipe_release(upipe_rtpfb->rtpfb_output);
     upipe_rtpfb_clean_upump_timer_lost(upipe);
     upipe_rtpfb_clean_upump_timer(upipe);
     upipe_rtpfb_clean_upump_mgr(upipe);
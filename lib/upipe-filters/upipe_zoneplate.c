@@ -64,6 +64,10 @@ struct upipe_zp {
     struct uref *flow_format;
     /** frame counter */
     int frame;
+    /** true if the pattern is static */
+    bool frozen;
+    /** picture output for every frame if the pattern is static */
+    struct ubuf *ubuf;
 };
 
 /** @hidden */
@@ -103,6 +107,8 @@ static struct upipe *upipe_zp_alloc(struct upipe_mgr *mgr,
 
     struct upipe_zp *upipe_zp = upipe_zp_from_upipe(upipe);
     upipe_zp->frame = 0;
+    upipe_zp->frozen = false;
+    upipe_zp->ubuf = NULL;
 
     upipe_throw_ready(upipe);
 
@@ -127,6 +133,9 @@ static void upipe_zp_free(struct upipe *upipe)
 {
     upipe_throw_dead(upipe);
 
+    struct upipe_zp *upipe_zp = upipe_zp_from_upipe(upipe);
+    if (upipe_zp->ubuf)
+        ubuf_free(upipe_zp->ubuf);
     upipe_zp_clean_ubuf_mgr(upipe);
     upipe_zp_clean_output(upipe);
     upipe_zp_clean_urefcount(upipe);
@@ -143,8 +152,13 @@ static int upipe_zp_check(struct upipe *upipe, struct uref *flow_format)
 {
     struct upipe_zp *upipe_zp = upipe_zp_from_upipe(upipe);
 
-    if (flow_format)
+    if (flow_format) {
+        if (upipe_zp->ubuf) {
+            ubuf_free(upipe_zp->ubuf);
+            upipe_zp->ubuf = NULL;
+        }
         upipe_zp_store_flow_def(upipe, flow_format);
+    }
 
     assert(upipe_zp->flow_def);
 
@@ -165,6 +179,13 @@ static int upipe_zp_draw(struct upipe *upipe, struct uref *uref)
     struct upipe_zp *upipe_zp = upipe_zp_from_upipe(upipe);
     int frame = upipe_zp->frame;
 
+    if (upipe_zp->ubuf) {
+        struct ubuf *ubuf = ubuf_dup(upipe_zp->ubuf);
+        UBASE_ALLOC_RETURN(ubuf);
+        uref_attach_ubuf(uref, ubuf);
+        return UBASE_ERR_NONE;
+    }
+
     uint64_t hsize, vsize;
     assert(upipe_zp->flow_def);
     ubase_assert(uref_pic_flow_get_hsize(upipe_zp->flow_def, &hsize));
@@ -203,7 +224,11 @@ static int upipe_zp_draw(struct upipe *upipe, struct uref *uref)
             UBASE_RETURN(uref_pic_plane_clear(uref, chroma, 0, 0, -1, -1, 1));
         }
     }
-    upipe_zp->frame++;
+
+    if (upipe_zp->frozen)
+        upipe_zp->ubuf = ubuf_dup(uref->ubuf);
+    else
+        upipe_zp->frame++;
     return UBASE_ERR_NONE;
 }
 
@@ -248,6 +273,24 @@ static int upipe_zp_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets whether the pattern is static.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true for a static pattern
+ * @return an error code
+ */
+static int upipe_zp_set_static_real(struct upipe *upipe, bool enabled)
+{
+    struct upipe_zp *upipe_zp = upipe_zp_from_upipe(upipe);
+
+    upipe_zp->frozen = enabled;
+    if (!enabled && upipe_zp->ubuf) {
+        ubuf_free(upipe_zp->ubuf);
+        upipe_zp->ubuf = NULL;
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles control commands.
  *
  * @param upipe description structure of the pipe
@@ -263,6 +306,17 @@ static int upipe_zp_control_real(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_zp_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_ZP_SET_STATIC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_ZP_SIGNATURE)
+            int enabled = va_arg(args, int);
+            return upipe_zp_set_static_real(upipe, !!enabled);
+        }
+        case UPIPE_ZP_GET_STATIC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_ZP_SIGNATURE)
+            int *enabled_p = va_arg(args, int *);
+            *enabled_p = upipe_zp_from_upipe(upipe)->frozen;
+            return UBASE_ERR_NONE;
+        }
     }
     return UBASE_ERR_UNHANDLED;
 }
@@ -233,6 +233,9 @@ static int upipe_zpsrc_control(struct upipe *upipe,
         case UPIPE_GET_FLOW_DEF:
             return upipe_zpsrc_control_bin_output(upipe, command, args);
     }
+    if (command >= UPIPE_CONTROL_LOCAL &&
+        ubase_get_signature(args) == UPIPE_ZP_SIGNATURE)
+        return upipe_zpsrc_control_bin_output(upipe, command, args);
     return upipe_zpsrc_control_src(upipe, command, args);
 }
 
@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "videotestsrc.h"
 
@@ -70,174 +71,82 @@ static const uint8_t sine_table[256] = {
   103, 106, 109, 112, 115, 118, 121, 124
 };
 
-void
-gst_video_test_src_zoneplate_8bit (uint8_t *data,
-        int w, int h, size_t stride, int t)
-{
-  int i;
-  int j;
-  int xreset = -(w / 2) - V_POINTER_XOFFSET;   /* starting values for x^2 and y^2, centering the ellipse */
-  int yreset = -(h / 2) - V_POINTER_YOFFSET;
-
-  int x, y;
-  int accum_kx;
-  int accum_kxt;
-  int accum_ky;
-  int accum_kyt;
-  int accum_kxy;
-  int kt;
-  int kt2;
-  int ky2;
-  int delta_kxt = V_POINTER_KXT * t;
-  int delta_kxy;
-  int scale_kxy = 0xffff / (w / 2);
-  int scale_kx2 = 0xffff / w;
+/* The pattern is separable: with no x*y term, the phase of a pixel is the sum
+ * of a term depending only on its column and a term depending only on its
+ * line. */
+#if V_POINTER_KXY != 0
+#error "the x*y term is not supported"
+#endif
 
+/* Computes the phase of the terms depending only on x, for every column. */
+static void
+zoneplate_columns (uint8_t *col, int w, int h, int t)
+{
+  int xreset = -(w / 2) - V_POINTER_XOFFSET;
+  unsigned int scale_kx2 = 0xffff / w;
   const int KX2 = (h > w) ? V_POINTER_KX2 * w / h : V_POINTER_KX2;
-  const int KY2 = (w > h) ? V_POINTER_KY2 * h / w : V_POINTER_KY2;
-
-  /* Zoneplate equation:
-   *
-   * phase = k0 + kx*x + ky*y + kt*t
-   *       + kxt*x*t + kyt*y*t + kxy*x*y
-   *       + kx2*x*x + ky2*y*y + Kt2*t*t
-   */
-
-#if 0
-  for (j = 0, y = yreset; j < h; j++, y++) {
-    for (i = 0, x = xreset; i < w; i++, x++) {
-
-      /* zero order */
-      int phase = v->k0;
-
-      /* first order */
-      phase = phase + (v->kx * i) + (v->ky * j) + (v->kt * t);
-
-      /* cross term */
-      /* phase = phase + (v->kxt * i * t) + (v->kyt * j * t); */
-      /* phase = phase + (v->kxy * x * y) / (w/2); */
-
-      /*second order */
-      /*normalise x/y terms to rate of change of phase at the picture edge */
-      phase =
-          phase + ((v->kx2 * x * x) / w) + ((v->ky2 * y * y) / h) +
-          ((v->kt2 * t * t) >> 1);
-
-      color.Y = sine_table[phase & 0xff];
-
-      color.R = color.Y;
-      color.G = color.Y;
-      color.B = color.Y;
-      p->paint_tmpline (p, i, 1);
-    }
+  /* only the 8 lower bits of the phase are used, so accumulate modulo 256 */
+  uint8_t delta = V_POINTER_KX + V_POINTER_KXT * t;
+  uint8_t accum = 0;
+  int i, x;
+
+  for (i = 0, x = xreset; i < w; i++, x++) {
+    accum += delta;
+    /* the product may exceed 2^31 for wide pictures, it is defined to wrap */
+    col[i] = accum +
+        ((int32_t)((unsigned int)KX2 * (unsigned int)(x * x) * scale_kx2) >> 16);
   }
-#endif
-
-  /* optimised version, with original code shown in comments */
-  accum_ky = 0;
-  accum_kyt = 0;
-  kt = V_POINTER_KT * t;
-  kt2 = V_POINTER_KT2 * t * t;
-  for (j = 0, y = yreset; j < h; j++, y++) {
-    accum_kx = 0;
-    accum_kxt = 0;
-    accum_ky += V_POINTER_KY;
-    accum_kyt += V_POINTER_KYT * t;
-    delta_kxy = V_POINTER_KXY * y * scale_kxy;
-    accum_kxy = delta_kxy * xreset;
-    ky2 = (KY2 * y * y) / h;
-    for (i = 0, x = xreset; i < w; i++, x++) {
-
-      /* zero order */
-      int phase = V_POINTER_K0;
-
-      /* first order */
-      accum_kx += V_POINTER_KX;
-      /* phase = phase + (v->kx * i) + (v->ky * j) + (v->kt * t); */
-      phase = phase + accum_kx + accum_ky + kt;
-
-      /* cross term */
-      accum_kxt += delta_kxt;
-      accum_kxy += delta_kxy;
-      /* phase = phase + (v->kxt * i * t) + (v->kyt * j * t); */
-      phase = phase + accum_kxt + accum_kyt;
+}
 
-      /* phase = phase + (v->kxy * x * y) / (w/2); */
-      /* phase = phase + accum_kxy / (w/2); */
-      phase = phase + (accum_kxy >> 16);
+/* Computes the phase of the terms depending only on y, for line j. */
+static uint8_t
+zoneplate_row (int j, int w, int h, int t)
+{
+  int y = j - (h / 2) - V_POINTER_YOFFSET;
+  const int KY2 = (w > h) ? V_POINTER_KY2 * h / w : V_POINTER_KY2;
+  uint8_t phase = V_POINTER_K0 + V_POINTER_KT * t +
+      ((V_POINTER_KT2 * t * t) >> 1);
 
-      /*second order */
-      /*normalise x/y terms to rate of change of phase at the picture edge */
-      /*phase = phase + ((v->kx2 * x * x)/w) + ((v->ky2 * y * y)/h) + ((v->kt2 * t * t)>>1); */
-      phase = phase + ((KX2 * x * x * scale_kx2) >> 16) + ky2 + (kt2 >> 1);
+  phase += (uint8_t)(j + 1) * (uint8_t)(V_POINTER_KY + V_POINTER_KYT * t);
+  return phase + (KY2 * y * y) / h;
+}
 
-      data[j*stride + i] = sine_table[phase & 0xff];
-    }
+/* As the phase wraps at 256, there are at most 256 different lines in a
+ * picture; lines which were already drawn are copied. */
+#define ZONEPLATE_DRAW(type, shift)                                          \
+  uint8_t col[w];                                                            \
+  int first[256];                                                            \
+  int i, j;                                                                  \
+                                                                             \
+  zoneplate_columns (col, w, h, t);                                          \
+  for (i = 0; i < 256; i++)                                                  \
+    first[i] = -1;                                                           \
+                                                                             \
+  for (j = 0; j < h; j++) {                                                  \
+    type *line = (type *) ((uint8_t *) data + j * stride);                   \
+    uint8_t row = zoneplate_row (j, w, h, t);                                \
+                                                                             \
+    if (first[row] >= 0) {                                                   \
+      memcpy (line, (uint8_t *) data + first[row] * stride,                  \
+          w * sizeof (type));                                                \
+      continue;                                                              \
+    }                                                                        \
+    first[row] = j;                                                          \
+                                                                             \
+    for (i = 0; i < w; i++)                                                  \
+      line[i] = sine_table[(uint8_t) (col[i] + row)] << shift;               \
   }
-}
 
+void
+gst_video_test_src_zoneplate_8bit (uint8_t *data,
+        int w, int h, size_t stride, int t)
+{
+  ZONEPLATE_DRAW (uint8_t, 0)
+}
 
 void
 gst_video_test_src_zoneplate_10bit (uint16_t *data,
         int w, int h, size_t stride, int t)
 {
-  int i;
-  int j;
-  int xreset = -(w / 2) - V_POINTER_XOFFSET;   /* starting values for x^2 and y^2, centering the ellipse */
-  int yreset = -(h / 2) - V_POINTER_YOFFSET;
-
-  int x, y;
-  int accum_kx;
-  int accum_kxt;
-  int accum_ky;
-  int accum_kyt;
-  int accum_kxy;
-  int kt;
-  int kt2;
-  int ky2;
-  int delta_kxt = V_POINTER_KXT * t;
-  int delta_kxy;
-  int scale_kxy = 0xffff / (w / 2);
-  int scale_kx2 = 0xffff / w;
-
-  const int KX2 = (h > w) ? V_POINTER_KX2 * w / h : V_POINTER_KX2;
-  const int KY2 = (w > h) ? V_POINTER_KY2 * h / w : V_POINTER_KY2;
-
-  stride /= 2;
-
-  accum_ky = 0;
-  accum_kyt = 0;
-  kt = V_POINTER_KT * t;
-  kt2 = V_POINTER_KT2 * t * t;
-  for (j = 0, y = yreset; j < h; j++, y++) {
-    accum_kx = 0;
-    accum_kxt = 0;
-    accum_ky += V_POINTER_KY;
-    accum_kyt += V_POINTER_KYT * t;
-    delta_kxy = V_POINTER_KXY * y * scale_kxy;
-    accum_kxy = delta_kxy * xreset;
-    ky2 = (KY2 * y * y) / h;
-    for (i = 0, x = xreset; i < w; i++, x++) {
-
-      /* zero order */
-      int phase = V_POINTER_K0;
-
-      /* first order */
-      accum_kx += V_POINTER_KX;
-      phase = phase + accum_kx + accum_ky + kt;
-
-      /* cross term */
-      accum_kxt += delta_kxt;
-      accum_kxy += delta_kxy;
-      phase = phase + accum_kxt + accum_kyt;
-
-      phase = phase + (accum_kxy >> 16);
-
-      /*second order */
-      /*normalise x/y terms to rate of change of phase at the picture edge */
-      phase = phase + ((KX2 * x * x * scale_kx2) >> 16) + ky2 + (kt2 >> 1);
-
-      data[j*stride + i] = sine_table[phase & 0xff] << 2;
-    }
-  }
+  ZONEPLATE_DRAW (uint16_t, 2)
 }
@@ -36,6 +36,7 @@
 #include "upipe/upipe_helper_bin_input.h"
 #include "upipe/upipe_helper_bin_output.h"
 #include "upipe-modules/upipe_idem.h"
+#include "upipe-modules/upipe_worker_linear.h"
 #include "upipe-framers/upipe_auto_framer.h"
 #include "upipe-framers/upipe_mpga_framer.h"
 #include "upipe-framers/upipe_a52_framer.h"
@@ -51,6 +52,16 @@
 #include <stdarg.h>
 #include <string.h>
 
+/** @internal @This describes a worker thread running framers. */
+struct upipe_autof_worker {
+    /** worker linear manager */
+    struct upipe_mgr *wlin_mgr;
+    /** probe hierarchy to use on the worker thread */
+    struct uprobe *uprobe_remote;
+    /** length of the queues to and from the worker thread */
+    unsigned int queue_length;
+};
+
 /** @internal @This is the private context of an autof manager. */
 struct upipe_autof_mgr {
     /** refcount management structure */
@@ -79,6 +90,13 @@ struct upipe_autof_mgr {
     /** pointer to s302f manager */
     struct upipe_mgr *s302f_mgr;
 
+    /** worker threads running framers */
+    struct upipe_autof_worker *workers;
+    /** number of worker threads */
+    unsigned int nb_workers;
+    /** next worker thread to use */
+    unsigned int next_worker;
+
     /** public upipe_mgr structure */
     struct upipe_mgr mgr;
 };
@@ -156,6 +174,46 @@ static struct upipe *upipe_autof_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This allocates an inner framer, on a worker thread if any
+ * was registered.
+ *
+ * @param upipe description structure of the pipe
+ * @param mgr framer manager
+ * @param name name of the framer, for the probe prefix
+ * @return pointer to framer
+ */
+static struct upipe *upipe_autof_alloc_inner(struct upipe *upipe,
+                                             struct upipe_mgr *mgr,
+                                             const char *name)
+{
+    struct upipe_autof_mgr *autof_mgr =
+        upipe_autof_mgr_from_upipe_mgr(upipe->mgr);
+    struct upipe_autof *autof = upipe_autof_from_upipe(upipe);
+
+    if (!autof_mgr->nb_workers)
+        return upipe_void_alloc(mgr,
+                uprobe_pfx_alloc(
+                    uprobe_use(&autof->last_inner_probe),
+                    UPROBE_LOG_VERBOSE, name));
+
+    struct upipe_autof_worker *worker =
+        &autof_mgr->workers[autof_mgr->next_worker];
+    autof_mgr->next_worker =
+        (autof_mgr->next_worker + 1) % autof_mgr->nb_workers;
+
+    struct upipe *framer = upipe_void_alloc(mgr,
+            uprobe_pfx_alloc(uprobe_use(worker->uprobe_remote),
+                             UPROBE_LOG_VERBOSE, name));
+    if (unlikely(framer == NULL))
+        return NULL;
+
+    return upipe_wlin_alloc(worker->wlin_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(&autof->last_inner_probe),
+                                UPROBE_LOG_VERBOSE, "w%s", name),
+            framer, uprobe_use(worker->uprobe_remote),
+            worker->queue_length, worker->queue_length);
+}
+
 /** @internal @This allocates the framer.
  *
  * @param upipe description structure of the pipe
@@ -174,68 +232,42 @@ static struct upipe *upipe_autof_alloc_framer(struct upipe *upipe,
          !ubase_ncmp(def, "block.aac.") ||
          !ubase_ncmp(def, "block.aac_latm.")) &&
         autof_mgr->mpgaf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->mpgaf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "mpgaf"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->mpgaf_mgr, "mpgaf");
 
     if ((!ubase_ncmp(def, "block.ac3.") ||
          !ubase_ncmp(def, "block.eac3.")) &&
         autof_mgr->a52f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->a52f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "a52f"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->a52f_mgr, "a52f");
 
     if ((!ubase_ncmp(def, "block.mpeg2video.") ||
          !ubase_ncmp(def, "block.mpeg1video.")) &&
         autof_mgr->mpgvf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->mpgvf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "mpgvf"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->mpgvf_mgr, "mpgvf");
 
     if (!ubase_ncmp(def, "block.h264.") &&
         autof_mgr->h264f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->h264f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "h264f"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->h264f_mgr, "h264f");
 
     if (!ubase_ncmp(def, "block.hevc.") &&
         autof_mgr->h265f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->h265f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "h265f"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->h265f_mgr, "h265f");
 
     if (!ubase_ncmp(def, "block.dvb_teletext.") &&
         autof_mgr->telxf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->telxf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "telxf"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->telxf_mgr, "telxf");
 
     if (!ubase_ncmp(def, "block.dvb_subtitle.") &&
         autof_mgr->dvbsubf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->dvbsubf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "dvbsubf"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->dvbsubf_mgr,
+                                       "dvbsubf");
 
     if (!ubase_ncmp(def, "block.opus.") &&
         autof_mgr->opusf_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->opusf_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "opusf"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->opusf_mgr, "opusf");
 
     if (!ubase_ncmp(def, "block.s302m.") &&
         autof_mgr->s302f_mgr != NULL)
-        return upipe_void_alloc(autof_mgr->s302f_mgr,
-                uprobe_pfx_alloc(
-                    uprobe_use(&autof->last_inner_probe),
-                    UPROBE_LOG_VERBOSE, "s302f"));
+        return upipe_autof_alloc_inner(upipe, autof_mgr->s302f_mgr, "s302f");
 
     upipe_warn_va(upipe, "unframed inner flow definition: %s", def);
     return upipe_void_alloc(autof_mgr->idem_mgr,
@@ -361,6 +393,11 @@ static void upipe_autof_mgr_free(struct urefcount *urefcount)
     upipe_mgr_release(autof_mgr->dvbsubf_mgr);
     upipe_mgr_release(autof_mgr->opusf_mgr);
     upipe_mgr_release(autof_mgr->s302f_mgr);
+    for (unsigned int i = 0; i < autof_mgr->nb_workers; i++) {
+        upipe_mgr_release(autof_mgr->workers[i].wlin_mgr);
+        uprobe_release(autof_mgr->workers[i].uprobe_remote);
+    }
+    free(autof_mgr->workers);
 
     urefcount_clean(urefcount);
     free(autof_mgr);
@@ -408,6 +445,28 @@ static int upipe_autof_mgr_control(struct upipe_mgr *mgr,
         GET_SET_MGR(s302f, S302F)
 #undef GET_SET_MGR
 
+        case UPIPE_AUTOF_MGR_ADD_WORKER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_AUTOF_SIGNATURE)
+            if (!urefcount_single(&autof_mgr->urefcount))
+                return UBASE_ERR_BUSY;
+            struct upipe_mgr *wlin_mgr = va_arg(args, struct upipe_mgr *);
+            struct uprobe *uprobe_remote = va_arg(args, struct uprobe *);
+            unsigned int queue_length = va_arg(args, unsigned int);
+            if (unlikely(wlin_mgr == NULL || uprobe_remote == NULL))
+                return UBASE_ERR_INVALID;
+
+            struct upipe_autof_worker *workers = realloc(autof_mgr->workers,
+                    (autof_mgr->nb_workers + 1) * sizeof(*workers));
+            UBASE_ALLOC_RETURN(workers)
+            autof_mgr->workers = workers;
+            workers[autof_mgr->nb_workers].wlin_mgr = upipe_mgr_use(wlin_mgr);
+            workers[autof_mgr->nb_workers].uprobe_remote =
+                uprobe_use(uprobe_remote);
+            workers[autof_mgr->nb_workers].queue_length = queue_length;
+            autof_mgr->nb_workers++;
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
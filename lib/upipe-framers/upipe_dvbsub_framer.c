@@ -76,6 +76,9 @@ struct upipe_dvbsubf {
 
     /** next uref to be processed */
     struct uref *next_uref;
+    /** display definition segment presence in the current flow definition,
+     * or -1 */
+    int display_def;
 
     /** true if we have thrown the sync_acquired event (that means we found a
      * sequence header) */
@@ -115,6 +118,7 @@ static struct upipe *upipe_dvbsubf_alloc(struct upipe_mgr *mgr,
     upipe_dvbsubf_init_output(upipe);
     upipe_dvbsubf_init_flow_def(upipe);
     upipe_dvbsubf->next_uref = NULL;
+    upipe_dvbsubf->display_def = -1;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -152,13 +156,6 @@ static void upipe_dvbsubf_work(struct upipe *upipe, struct upump **upump_p)
         goto upipe_dvbsubf_work_err;
     }
 
-    struct uref *flow_def = upipe_dvbsubf_alloc_flow_def_attr(upipe);
-    if (unlikely(flow_def == NULL)) {
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        uref_free(upipe_dvbsubf->next_uref);
-        goto upipe_dvbsubf_work_err;
-    }
-
     while (ubase_check(uref_block_extract(upipe_dvbsubf->next_uref,
                                           offset, 1, &buffer)) &&
            buffer == DVBSUBS_SYNC) {
@@ -177,11 +174,26 @@ static void upipe_dvbsubf_work(struct upipe *upipe, struct upump **upump_p)
 
 
         if (type == DVBSUBS_DISPLAY_DEFINITION) {
+            /* nothing else in the frame changes the flow definition */
             display_def = true;
+            break;
         }
         offset += length + DVBSUBS_HEADER_SIZE;
     }
 
+    /* the payload is forwarded as is, so only rebuild the flow definition
+     * when the buffer model changes */
+    if (upipe_dvbsubf->flow_def != NULL &&
+        upipe_dvbsubf->display_def == display_def)
+        goto upipe_dvbsubf_work_sync;
+
+    struct uref *flow_def = upipe_dvbsubf_alloc_flow_def_attr(upipe);
+    if (unlikely(flow_def == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(upipe_dvbsubf->next_uref);
+        goto upipe_dvbsubf_work_err;
+    }
+
     UBASE_FATAL(upipe, uref_flow_set_complete(flow_def))
     UBASE_FATAL(upipe, uref_block_flow_set_octetrate(flow_def,
                             display_def ? TB_RATE_DVBSUB_DISP :
@@ -197,7 +209,9 @@ static void upipe_dvbsubf_work(struct upipe *upipe, struct upump **upump_p)
         goto upipe_dvbsubf_work_err;
     }
     upipe_dvbsubf_store_flow_def(upipe, flow_def);
+    upipe_dvbsubf->display_def = display_def;
 
+upipe_dvbsubf_work_sync:
     upipe_dvbsubf_sync_acquired(upipe);
 
 upipe_dvbsubf_work_output:
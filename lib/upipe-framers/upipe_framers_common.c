@@ -26,6 +26,7 @@
 
 #include <stdint.h>
 
+#include "upipe/ubuf_block.h"
 #include "upipe-framers/upipe_framers_common.h"
 
 /** @This scans for an MPEG-style 3-octet start code in a linear buffer.
@@ -48,15 +49,10 @@ const uint8_t *upipe_framers_mpeg_scan(const uint8_t *restrict p,
             return p;
     }
 
-    while (p < end) {
-        if      (p[-1] > 1      ) p += 3;
-        else if (p[-2]          ) p += 2;
-        else if (p[-3]|(p[-1]-1)) p++;
-        else {
-            p++;
-            break;
-        }
-    }
+    /* the start code is searched from the beginning of the buffer, and p
+     * points after its value octet */
+    const uint8_t *start = ubuf_block_scan_startcode(p - 3, end);
+    p = start < end ? start + 4 : end;
 
     if (p > end)
         p = end;
@@ -130,6 +130,12 @@ struct upipe_h264f {
     int32_t last_frame_num;
     /** true we have had a discontinuity recently */
     bool got_discontinuity;
+    /** true if only access unit boundaries, key frames and dates are
+     * recovered (see @ref upipe_h264f_set_light) */
+    bool light;
+    /** true if annex B access units are output slice by slice (see
+     * @ref upipe_h264f_set_slice_output) */
+    bool slice_output;
     /** pointers to sequence parameter sets */
     struct ubuf *sps[H264SPS_ID_MAX];
     /** pointers to sequence parameter set extensions */
@@ -230,6 +236,8 @@ struct upipe_h264f {
     bool au_slice;
     /** NAL start code of the first slice, or UINT8_MAX */
     uint8_t au_slice_nal;
+    /** true if the first slices of this access unit were already output */
+    bool au_partial;
     /** pseudo-packet containing date information for the next picture */
     struct uref au_uref_s;
     /** drift rate of the next picture */
@@ -334,6 +342,8 @@ static struct upipe *upipe_h264f_alloc(struct upipe_mgr *mgr,
     upipe_h264f->dpb_output_delay = UINT64_MAX;
     upipe_h264f->duration = 0;
     upipe_h264f->got_discontinuity = false;
+    upipe_h264f->light = false;
+    upipe_h264f->slice_output = false;
     upipe_h264f->scan_context = UINT32_MAX;
     upipe_h264f->au_size = 0;
     upipe_h264f->au_last_nal_offset = -1;
@@ -343,6 +353,7 @@ static struct upipe *upipe_h264f_alloc(struct upipe_mgr *mgr,
     upipe_h264f->au_vcl_offset = -1;
     upipe_h264f->au_slice = false;
     upipe_h264f->au_slice_nal = UINT8_MAX;
+    upipe_h264f->au_partial = false;
     uref_init(&upipe_h264f->au_uref_s);
     upipe_h264f_flush_dates(upipe);
 
@@ -1133,29 +1144,29 @@ static int upipe_h264f_handle_sps(struct upipe *upipe, struct ubuf *ubuf,
     struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
     upipe_h264f->sps_rap = upipe_h264f->dts_rap;
 
-    ubuf = ubuf_block_splice(ubuf, offset, size);
-    if (unlikely(ubuf == NULL))
-        return UBASE_ERR_ALLOC;
-
     struct upipe_h26xf_stream f;
     upipe_h26xf_stream_init(&f);
     struct ubuf_block_stream *s = &f.s;
     if (!ubase_check(ubuf_block_stream_init(s, ubuf,
-                                            H264SPS_HEADER_SIZE - 3))) {
-        ubuf_free(ubuf);
+                                            offset + H264SPS_HEADER_SIZE - 3)))
         return UBASE_ERR_INVALID;
-    }
     uint32_t sps_id = upipe_h26xf_stream_ue(s);
     ubuf_block_stream_clean(s);
 
     if (unlikely(sps_id >= H264SPS_ID_MAX)) {
         upipe_warn_va(upipe, "invalid SPS %"PRIu32, sps_id);
-        ubuf_free(ubuf);
         return UBASE_ERR_INVALID;
     }
 
-    if (upipe_h264f->active_sps == sps_id &&
-        !ubase_check(ubuf_block_equal(upipe_h264f->sps[sps_id], ubuf)))
+    /* periodic repetition */
+    if (upipe_h26xf_ps_equal(upipe_h264f->sps[sps_id], ubuf, offset, size))
+        return UBASE_ERR_NONE;
+
+    ubuf = ubuf_block_splice(ubuf, offset, size);
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_ALLOC;
+
+    if (upipe_h264f->active_sps == sps_id)
         upipe_h264f->active_sps = -1;
 
     if (upipe_h264f->sps[sps_id] != NULL)
@@ -1176,26 +1187,28 @@ static int upipe_h264f_handle_sps_ext(struct upipe *upipe, struct ubuf *ubuf,
                                       size_t offset, size_t size)
 {
     struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
-    ubuf = ubuf_block_splice(ubuf, offset, size);
-    if (unlikely(ubuf == NULL))
-        return UBASE_ERR_ALLOC;
-
     struct upipe_h26xf_stream f;
     upipe_h26xf_stream_init(&f);
     struct ubuf_block_stream *s = &f.s;
-    if (!ubase_check(ubuf_block_stream_init(s, ubuf, 1))) {
-        ubuf_free(ubuf);
+    if (!ubase_check(ubuf_block_stream_init(s, ubuf, offset + 1)))
         return UBASE_ERR_INVALID;
-    }
     uint32_t sps_id = upipe_h26xf_stream_ue(s);
     ubuf_block_stream_clean(s);
 
     if (unlikely(sps_id >= H264SPS_ID_MAX)) {
         upipe_warn_va(upipe, "invalid SPS extension %"PRIu32, sps_id);
-        ubuf_free(ubuf);
         return UBASE_ERR_INVALID;
     }
 
+    /* periodic repetition */
+    if (upipe_h26xf_ps_equal(upipe_h264f->sps_ext[sps_id], ubuf, offset,
+                             size))
+        return UBASE_ERR_NONE;
+
+    ubuf = ubuf_block_splice(ubuf, offset, size);
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_ALLOC;
+
     /* We do not reset active_sps because so far we don't care about SPS
      * extension. */
 
@@ -1219,31 +1232,30 @@ static int upipe_h264f_handle_pps(struct upipe *upipe, struct ubuf *ubuf,
     struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
     upipe_h264f->pps_rap = upipe_h264f->sps_rap;
 
-    ubuf = ubuf_block_splice(ubuf, offset, size);
-    if (unlikely(ubuf == NULL))
-        return UBASE_ERR_ALLOC;
-
     struct upipe_h26xf_stream f;
     upipe_h26xf_stream_init(&f);
     struct ubuf_block_stream *s = &f.s;
-    if (!ubase_check(ubuf_block_stream_init(s, ubuf, 1))) {
-        ubuf_free(ubuf);
+    if (!ubase_check(ubuf_block_stream_init(s, ubuf, offset + 1)))
         return UBASE_ERR_INVALID;
-    }
     uint32_t pps_id = upipe_h26xf_stream_ue(s);
     ubuf_block_stream_clean(s);
 
     if (unlikely(pps_id >= H264PPS_ID_MAX)) {
         upipe_warn_va(upipe, "invalid PPS %"PRIu32, pps_id);
-        ubuf_free(ubuf);
         return UBASE_ERR_INVALID;
     }
 
+    bool repeated = upipe_h26xf_ps_equal(upipe_h264f->pps[pps_id], ubuf,
+                                         offset, size);
     if (upipe_h264f->active_sps == -1 ||
-        (upipe_h264f->active_pps == pps_id &&
-         !ubase_check(ubuf_block_equal(upipe_h264f->pps[pps_id], ubuf)))) {
+        (upipe_h264f->active_pps == pps_id && !repeated))
         upipe_h264f->active_pps = -1;
-    }
+    if (repeated)
+        return UBASE_ERR_NONE;
+
+    ubuf = ubuf_block_splice(ubuf, offset, size);
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_ALLOC;
 
     if (upipe_h264f->pps[pps_id] != NULL)
         ubuf_free(upipe_h264f->pps[pps_id]);
@@ -1339,7 +1351,10 @@ static int upipe_h264f_handle_sei(struct upipe *upipe, struct ubuf *ubuf,
     struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
 
     uint8_t type;
-    if (unlikely(!ubase_check(ubuf_block_extract(ubuf, offset + 1, 1, &type))))
+    if (upipe_h264f->light)
+        type = UINT8_MAX;
+    else if (unlikely(!ubase_check(ubuf_block_extract(ubuf, offset + 1, 1,
+                                                      &type))))
         return UBASE_ERR_INVALID;
 
     int err = UBASE_ERR_NONE;
@@ -1402,63 +1417,65 @@ static int upipe_h264f_handle_slice(struct upipe *upipe, struct ubuf *ubuf,
                                     bool *au_slice_p)
 {
     struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
-    struct upipe_h26xf_stream f;
-    upipe_h26xf_stream_init(&f);
-    struct ubuf_block_stream *s = &f.s;
-    if (unlikely(!ubase_check(ubuf_block_stream_init(s, ubuf, offset + 1))))
+    struct upipe_h26xf_bits b;
+    if (unlikely(!ubase_check(upipe_h26xf_bits_init(&b, ubuf, offset + 1,
+                                                    size - 1))))
         return UBASE_ERR_INVALID;
 
-    upipe_h26xf_stream_ue(s); /* first_mb_in_slice */
-    uint32_t slice_type = upipe_h26xf_stream_ue(s);
-    uint32_t pps_id = upipe_h26xf_stream_ue(s);
+    uint32_t first_mb = upipe_h26xf_bits_ue(&b);
+    uint32_t slice_type = upipe_h26xf_bits_ue(&b);
+    uint32_t pps_id = upipe_h26xf_bits_ue(&b);
     if (unlikely(pps_id >= H264PPS_ID_MAX)) {
         upipe_warn_va(upipe, "invalid PPS %"PRIu32" in slice", pps_id);
-        ubuf_block_stream_clean(s);
         return UBASE_ERR_INVALID;
     }
 
-    if (*au_slice_p && pps_id != upipe_h264f->active_pps) {
-        ubuf_block_stream_clean(s);
+    if (*au_slice_p && pps_id != upipe_h264f->active_pps)
         return UBASE_ERR_BUSY;
-    }
 
-    if (unlikely(!upipe_h264f_activate_pps(upipe, pps_id))) {
-        ubuf_block_stream_clean(s);
+    if (unlikely(!upipe_h264f_activate_pps(upipe, pps_id)))
         return UBASE_ERR_INVALID;
-    }
 
-    if (upipe_h264f->separate_colour_plane) {
-        upipe_h26xf_stream_fill_bits(s, 2);
-        ubuf_block_stream_skip_bits(s, 2);
-    }
-    upipe_h26xf_stream_fill_bits(s, upipe_h264f->log2_max_frame_num);
-    uint32_t frame_num = ubuf_block_stream_show_bits(s,
+    if (upipe_h264f->separate_colour_plane)
+        upipe_h26xf_bits_skip(&b, 2);
+    uint32_t frame_num = upipe_h26xf_bits_read(&b,
             upipe_h264f->log2_max_frame_num);
-    ubuf_block_stream_skip_bits(s, upipe_h264f->log2_max_frame_num);
     bool field_pic = false;
     bool bf = false;
     if (!upipe_h264f->frame_mbs_only) {
-        upipe_h26xf_stream_fill_bits(s, 2);
-        field_pic = !!ubuf_block_stream_show_bits(s, 1);
-        ubuf_block_stream_skip_bits(s, 1);
-        if (field_pic) {
-            bf = !!ubuf_block_stream_show_bits(s, 1);
-            ubuf_block_stream_skip_bits(s, 1);
-        }
+        field_pic = !!upipe_h26xf_bits_read(&b, 1);
+        if (field_pic)
+            bf = !!upipe_h26xf_bits_read(&b, 1);
+    }
+
+    if (upipe_h264f->light) {
+        /* without arbitrary slice order, a picture starts with macroblock 0 */
+        if (*au_slice_p &&
+            (!first_mb ||
+             frame_num != upipe_h264f->frame_num ||
+             field_pic != upipe_h264f->field_pic ||
+             bf != upipe_h264f->bf))
+            return UBASE_ERR_BUSY;
+        upipe_h264f->frame_num = frame_num;
+        upipe_h264f->slice_type = slice_type;
+        upipe_h264f->field_pic = field_pic;
+        upipe_h264f->bf = bf;
+        upipe_h264f->delta_poc_bottom = 0;
+        upipe_h264f->delta_poc0 = 0;
+        upipe_h264f->delta_poc1 = 0;
+        goto upipe_h264f_handle_slice_done;
     }
 
     uint32_t idr_pic_id = upipe_h264f->idr_pic_id;
     if (h264nalst_get_type(nal) == H264NAL_TYPE_IDR)
-        idr_pic_id = upipe_h26xf_stream_ue(s);
+        idr_pic_id = upipe_h26xf_bits_ue(&b);
 
     if (*au_slice_p &&
         (frame_num != upipe_h264f->frame_num ||
          field_pic != upipe_h264f->field_pic ||
          bf != upipe_h264f->bf ||
-         idr_pic_id != upipe_h264f->idr_pic_id)) {
-        ubuf_block_stream_clean(s);
+         idr_pic_id != upipe_h264f->idr_pic_id))
         return UBASE_ERR_BUSY;
-    }
     upipe_h264f->frame_num = frame_num;
     upipe_h264f->slice_type = slice_type;
     upipe_h264f->field_pic = field_pic;
@@ -1466,40 +1483,35 @@ static int upipe_h264f_handle_slice(struct upipe *upipe, struct ubuf *ubuf,
     upipe_h264f->idr_pic_id = idr_pic_id;
 
     if (upipe_h264f->poc_type == 0) {
-        upipe_h26xf_stream_fill_bits(s, upipe_h264f->log2_max_poc_lsb);
-        uint32_t poc_lsb = ubuf_block_stream_show_bits(s,
+        uint32_t poc_lsb = upipe_h26xf_bits_read(&b,
                 upipe_h264f->log2_max_poc_lsb);
-        ubuf_block_stream_skip_bits(s, upipe_h264f->log2_max_poc_lsb);
         int32_t delta_poc_bottom = 0;
         if (upipe_h264f->bf_poc && !field_pic)
-            delta_poc_bottom = upipe_h26xf_stream_se(s);
+            delta_poc_bottom = upipe_h26xf_bits_se(&b);
 
         if (*au_slice_p &&
             (poc_lsb != upipe_h264f->poc_lsb ||
-             delta_poc_bottom != upipe_h264f->delta_poc_bottom)) {
-            ubuf_block_stream_clean(s);
+             delta_poc_bottom != upipe_h264f->delta_poc_bottom))
             return UBASE_ERR_BUSY;
-        }
         upipe_h264f->poc_lsb = poc_lsb;
         upipe_h264f->delta_poc_bottom = delta_poc_bottom;
 
     } else if (upipe_h264f->poc_type == 1 &&
                !upipe_h264f->delta_poc_always_zero) {
-        int32_t delta_poc0 = upipe_h26xf_stream_se(s);
+        int32_t delta_poc0 = upipe_h26xf_bits_se(&b);
         int32_t delta_poc1 = 0;
         if (upipe_h264f->bf_poc && !field_pic)
-            delta_poc1 = upipe_h26xf_stream_se(s);
+            delta_poc1 = upipe_h26xf_bits_se(&b);
 
         if (*au_slice_p &&
             (delta_poc0 != upipe_h264f->delta_poc0 ||
-             delta_poc1 != upipe_h264f->delta_poc1)) {
-            ubuf_block_stream_clean(s);
+             delta_poc1 != upipe_h264f->delta_poc1))
             return UBASE_ERR_BUSY;
-        }
         upipe_h264f->delta_poc0 = delta_poc0;
         upipe_h264f->delta_poc1 = delta_poc1;
     }
 
+upipe_h264f_handle_slice_done:
     upipe_h264f->au_slice_nal = nal;
     if (upipe_h264f->au_vcl_offset == -1)
         upipe_h264f->au_vcl_offset = upipe_h264f->au_last_nal_offset;
@@ -2046,7 +2058,9 @@ static void upipe_h264f_output_au(struct upipe *upipe, struct uref *uref,
             upipe_throw_error(upipe, err);
     }
 
-    if (upipe_h264f_find_annexb_nal(upipe, uref, H264NAL_TYPE_AUD) == -1) {
+    if ((!ubase_check(uref_h26x_get_au_partial(uref)) ||
+         ubase_check(uref_block_get_start(uref))) &&
+        upipe_h264f_find_annexb_nal(upipe, uref, H264NAL_TYPE_AUD) == -1) {
         upipe_verbose(upipe, "prepending AUD");
         struct ubuf *ubuf = ubuf_dup(upipe_h264f->annexb_aud);
         if (unlikely(ubuf == NULL)) {
@@ -2062,37 +2076,15 @@ static void upipe_h264f_output_au(struct upipe *upipe, struct uref *uref,
     upipe_h264f_output(upipe, uref, upump_p);
 }
 
-/** @internal @This prepares an annex B access unit.
+/** @internal @This extracts the beginning of an annex B access unit, and
+ * sets the attributes and dates of the access unit.
  *
  * @param upipe description structure of the pipe
  * @return pointer to uref
  */
-static struct uref *upipe_h264f_prepare_annexb(struct upipe *upipe)
+static struct uref *upipe_h264f_extract_annexb(struct upipe *upipe)
 {
     struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
-    if (!upipe_h264f->au_size) {
-        upipe_h264f->au_nal_units = 0;
-        upipe_h264f->au_vcl_offset = -1;
-        upipe_h264f->au_slice = false;
-        upipe_h264f->au_slice_nal = UINT8_MAX;
-        upipe_h264f->pic_struct = -1;
-        upipe_h264f->dpb_output_delay = UINT64_MAX;
-        return NULL;
-    }
-    if (upipe_h264f->au_slice_nal == UINT8_MAX ||
-        upipe_h264f->active_sps == -1 || upipe_h264f->active_pps == -1) {
-        upipe_warn(upipe, "discarding data without SPS/PPS");
-        upipe_h264f_consume_uref_stream(upipe, upipe_h264f->au_size);
-        upipe_h264f->au_size = 0;
-        upipe_h264f->au_nal_units = 0;
-        upipe_h264f->au_vcl_offset = -1;
-        upipe_h264f->au_slice = false;
-        upipe_h264f->au_slice_nal = UINT8_MAX;
-        upipe_h264f->pic_struct = -1;
-        upipe_h264f->dpb_output_delay = UINT64_MAX;
-        return NULL;
-    }
-
     struct uref au_uref_s = upipe_h264f->au_uref_s;
     struct urational drift_rate = upipe_h264f->drift_rate;
     /* From now on, PTS declaration only impacts the next frame. */
@@ -2156,6 +2148,70 @@ static struct uref *upipe_h264f_prepare_annexb(struct upipe *upipe)
         uref_clock_delete_rate(uref);
 
     upipe_h264f->au_size = 0;
+    return uref;
+}
+
+/** @internal @This extracts the next piece of an annex B access unit whose
+ * beginning was already output in slice output mode.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to uref, or NULL if there is nothing to output
+ */
+static struct uref *upipe_h264f_extract_partial_annexb(struct upipe *upipe)
+{
+    struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
+    if (!upipe_h264f->au_size)
+        return NULL;
+
+    struct uref *uref = upipe_h264f_extract_uref_stream(upipe,
+                                                        upipe_h264f->au_size);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+    upipe_h264f->au_size = 0;
+    upipe_h264f->au_nal_units = 0;
+    UBASE_FATAL(upipe, uref_h26x_set_au_partial(uref))
+    return uref;
+}
+
+/** @internal @This prepares an annex B access unit.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to uref
+ */
+static struct uref *upipe_h264f_prepare_annexb(struct upipe *upipe)
+{
+    struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
+    if (!upipe_h264f->au_size || upipe_h264f->au_partial) {
+        struct uref *uref = upipe_h264f_extract_partial_annexb(upipe);
+        upipe_h264f->au_nal_units = 0;
+        upipe_h264f->au_vcl_offset = -1;
+        upipe_h264f->au_slice = false;
+        upipe_h264f->au_slice_nal = UINT8_MAX;
+        upipe_h264f->au_partial = false;
+        upipe_h264f->pic_struct = -1;
+        upipe_h264f->dpb_output_delay = UINT64_MAX;
+        return uref;
+    }
+    if (upipe_h264f->au_slice_nal == UINT8_MAX ||
+        upipe_h264f->active_sps == -1 || upipe_h264f->active_pps == -1) {
+        upipe_warn(upipe, "discarding data without SPS/PPS");
+        upipe_h264f_consume_uref_stream(upipe, upipe_h264f->au_size);
+        upipe_h264f->au_size = 0;
+        upipe_h264f->au_nal_units = 0;
+        upipe_h264f->au_vcl_offset = -1;
+        upipe_h264f->au_slice = false;
+        upipe_h264f->au_slice_nal = UINT8_MAX;
+        upipe_h264f->pic_struct = -1;
+        upipe_h264f->dpb_output_delay = UINT64_MAX;
+        return NULL;
+    }
+
+    struct uref *uref = upipe_h264f_extract_annexb(upipe);
+    if (unlikely(uref == NULL))
+        return NULL;
+
     upipe_h264f->au_vcl_offset = -1;
     upipe_h264f->au_slice = false;
     upipe_h264f->au_slice_nal = UINT8_MAX;
@@ -2184,6 +2240,38 @@ static void upipe_h264f_output_annexb(struct upipe *upipe,
         upipe_h264f_output_au(upipe, uref, upump_p);
 }
 
+/** @internal @This outputs the slices parsed so far in the current access
+ * unit, in slice output mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_h264f_output_slice_annexb(struct upipe *upipe,
+                                            struct upump **upump_p)
+{
+    struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
+    if (!upipe_h264f->slice_output ||
+        upipe_h264f->flow_def_requested == NULL)
+        return;
+
+    struct uref *uref;
+    if (!upipe_h264f->au_partial) {
+        if (upipe_h264f->active_sps == -1 || upipe_h264f->active_pps == -1)
+            return;
+        uref = upipe_h264f_extract_annexb(upipe);
+        if (unlikely(uref == NULL))
+            return;
+        upipe_h264f->au_partial = true;
+        uref_block_set_start(uref);
+        UBASE_FATAL(upipe, uref_h26x_set_au_partial(uref))
+    } else {
+        uref = upipe_h264f_extract_partial_annexb(upipe);
+        if (uref == NULL)
+            return;
+    }
+    upipe_h264f_output_au(upipe, uref, upump_p);
+}
+
 /** @internal @This outputs the previous access unit, before the current NAL.
  *
  * @param upipe description structure of the pipe
@@ -2258,6 +2346,7 @@ static void upipe_h264f_end_annexb(struct upipe *upipe, struct upump **upump_p)
         if (last_nal_type == H264NAL_TYPE_IDR) {
             uref_flow_set_random(upipe_h264f->next_uref);
         }
+        upipe_h264f_output_slice_annexb(upipe, upump_p);
         return;
     }
 
@@ -2889,6 +2978,18 @@ static int upipe_h264f_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_h264f_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_H264F_SET_LIGHT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H264F_SIGNATURE)
+            struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
+            upipe_h264f->light = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_H264F_SET_SLICE_OUTPUT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H264F_SIGNATURE)
+            struct upipe_h264f *upipe_h264f = upipe_h264f_from_upipe(upipe);
+            upipe_h264f->slice_output = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
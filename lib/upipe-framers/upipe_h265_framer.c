@@ -132,6 +132,12 @@ struct upipe_h265f {
     int32_t last_frame_num;
     /** true we have had a discontinuity recently */
     bool got_discontinuity;
+    /** true if only access unit boundaries, key frames and dates are
+     * recovered (see @ref upipe_h265f_set_light) */
+    bool light;
+    /** true if annex B access units are output slice by slice (see
+     * @ref upipe_h265f_set_slice_output) */
+    bool slice_output;
     /** pointers to video parameter sets */
     struct ubuf *vps[H265VPS_ID_MAX];
     /** active video parameter set, or -1 */
@@ -208,6 +214,8 @@ struct upipe_h265f {
     ssize_t au_vcl_offset;
     /** true if there is already a slice starting in this access unit */
     bool au_slice;
+    /** true if the first slices of this access unit were already output */
+    bool au_partial;
     /** pseudo-packet containing date information for the next picture */
     struct uref au_uref_s;
     /** drift rate of the next picture */
@@ -316,6 +324,8 @@ static struct upipe *upipe_h265f_alloc(struct upipe_mgr *mgr,
     upipe_h265f->pic_struct = -1;
     upipe_h265f->duration = 0;
     upipe_h265f->got_discontinuity = false;
+    upipe_h265f->light = false;
+    upipe_h265f->slice_output = false;
     upipe_h265f->scan_context = UINT32_MAX;
     upipe_h265f->au_size = 0;
     upipe_h265f->au_last_nal_offset = -1;
@@ -324,6 +334,7 @@ static struct upipe *upipe_h265f_alloc(struct upipe_mgr *mgr,
     upipe_h265f->au_nal_units = 0;
     upipe_h265f->au_vcl_offset = -1;
     upipe_h265f->au_slice = false;
+    upipe_h265f->au_partial = false;
     uref_init(&upipe_h265f->au_uref_s);
     upipe_h265f_flush_dates(upipe);
 
@@ -1261,19 +1272,20 @@ static int upipe_h265f_handle_vps(struct upipe *upipe, struct ubuf *ubuf,
     struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
     upipe_h265f->vps_rap = upipe_h265f->dts_rap;
 
-    ubuf = ubuf_block_splice(ubuf, offset, size);
-    if (unlikely(ubuf == NULL))
-        return UBASE_ERR_ALLOC;
-
     uint8_t buffer;
-    if (!ubase_check(ubuf_block_extract(ubuf, 2, 1, &buffer))) {
-        ubuf_free(ubuf);
+    if (!ubase_check(ubuf_block_extract(ubuf, offset + 2, 1, &buffer)))
         return UBASE_ERR_INVALID;
-    }
     uint8_t vps_id = buffer >> 4;
 
-    if (upipe_h265f->active_vps == vps_id &&
-        !ubase_check(ubuf_block_equal(upipe_h265f->vps[vps_id], ubuf)))
+    /* periodic repetition */
+    if (upipe_h26xf_ps_equal(upipe_h265f->vps[vps_id], ubuf, offset, size))
+        return UBASE_ERR_NONE;
+
+    ubuf = ubuf_block_splice(ubuf, offset, size);
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_ALLOC;
+
+    if (upipe_h265f->active_vps == vps_id)
         upipe_h265f->active_vps = -1;
 
     if (upipe_h265f->vps[vps_id] != NULL)
@@ -1296,17 +1308,11 @@ static int upipe_h265f_handle_sps(struct upipe *upipe, struct ubuf *ubuf,
     struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
     upipe_h265f->sps_rap = upipe_h265f->vps_rap;
 
-    ubuf = ubuf_block_splice(ubuf, offset, size);
-    if (unlikely(ubuf == NULL))
-        return UBASE_ERR_ALLOC;
-
     struct upipe_h26xf_stream f;
     upipe_h26xf_stream_init(&f);
     struct ubuf_block_stream *s = &f.s;
-    if (!ubase_check(ubuf_block_stream_init(s, ubuf, 2))) {
-        ubuf_free(ubuf);
+    if (!ubase_check(ubuf_block_stream_init(s, ubuf, offset + 2)))
         return UBASE_ERR_INVALID;
-    }
 
     upipe_h26xf_stream_fill_bits(s, 8);
     ubuf_block_stream_skip_bits(s, 4); /* vps_id */
@@ -1321,15 +1327,20 @@ static int upipe_h265f_handle_sps(struct upipe *upipe, struct ubuf *ubuf,
 
     if (unlikely(sps_id >= H265SPS_ID_MAX)) {
         upipe_warn_va(upipe, "invalid SPS %"PRIu32, sps_id);
-        ubuf_free(ubuf);
         return UBASE_ERR_INVALID;
     }
 
+    bool repeated = upipe_h26xf_ps_equal(upipe_h265f->sps[sps_id], ubuf,
+                                         offset, size);
     if (upipe_h265f->active_vps == -1 ||
-        (upipe_h265f->active_sps == sps_id &&
-         !ubase_check(ubuf_block_equal(upipe_h265f->sps[sps_id], ubuf)))) {
+        (upipe_h265f->active_sps == sps_id && !repeated))
         upipe_h265f->active_sps = -1;
-    }
+    if (repeated)
+        return UBASE_ERR_NONE;
+
+    ubuf = ubuf_block_splice(ubuf, offset, size);
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_ALLOC;
 
     if (upipe_h265f->sps[sps_id] != NULL)
         ubuf_free(upipe_h265f->sps[sps_id]);
@@ -1351,31 +1362,30 @@ static int upipe_h265f_handle_pps(struct upipe *upipe, struct ubuf *ubuf,
     struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
     upipe_h265f->pps_rap = upipe_h265f->sps_rap;
 
-    ubuf = ubuf_block_splice(ubuf, offset, size);
-    if (unlikely(ubuf == NULL))
-        return UBASE_ERR_ALLOC;
-
     struct upipe_h26xf_stream f;
     upipe_h26xf_stream_init(&f);
     struct ubuf_block_stream *s = &f.s;
-    if (!ubase_check(ubuf_block_stream_init(s, ubuf, 2))) {
-        ubuf_free(ubuf);
+    if (!ubase_check(ubuf_block_stream_init(s, ubuf, offset + 2)))
         return UBASE_ERR_INVALID;
-    }
     uint32_t pps_id = upipe_h26xf_stream_ue(s);
     ubuf_block_stream_clean(s);
 
     if (unlikely(pps_id >= H265PPS_ID_MAX)) {
         upipe_warn_va(upipe, "invalid PPS %"PRIu32, pps_id);
-        ubuf_free(ubuf);
         return UBASE_ERR_INVALID;
     }
 
+    bool repeated = upipe_h26xf_ps_equal(upipe_h265f->pps[pps_id], ubuf,
+                                         offset, size);
     if (upipe_h265f->active_vps == -1 || upipe_h265f->active_sps == -1 ||
-        (upipe_h265f->active_pps == pps_id &&
-         !ubase_check(ubuf_block_equal(upipe_h265f->pps[pps_id], ubuf)))) {
+        (upipe_h265f->active_pps == pps_id && !repeated))
         upipe_h265f->active_pps = -1;
-    }
+    if (repeated)
+        return UBASE_ERR_NONE;
+
+    ubuf = ubuf_block_splice(ubuf, offset, size);
+    if (unlikely(ubuf == NULL))
+        return UBASE_ERR_ALLOC;
 
     if (upipe_h265f->pps[pps_id] != NULL)
         ubuf_free(upipe_h265f->pps[pps_id]);
@@ -1442,7 +1452,10 @@ static int upipe_h265f_handle_sei(struct upipe *upipe, struct ubuf *ubuf,
     struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
 
     uint8_t type;
-    if (unlikely(!ubase_check(ubuf_block_extract(ubuf, offset + 2, 1, &type))))
+    if (upipe_h265f->light)
+        type = UINT8_MAX;
+    else if (unlikely(!ubase_check(ubuf_block_extract(ubuf, offset + 2, 1,
+                                                      &type))))
         return UBASE_ERR_INVALID;
 
     int err = UBASE_ERR_NONE;
@@ -1505,45 +1518,33 @@ static int upipe_h265f_handle_slice(struct upipe *upipe, struct ubuf *ubuf,
                                     bool *au_slice_p)
 {
     struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
-    struct upipe_h26xf_stream f;
-    upipe_h26xf_stream_init(&f);
-    struct ubuf_block_stream *s = &f.s;
-    if (unlikely(!ubase_check(ubuf_block_stream_init(s, ubuf, offset + 2))))
+    struct upipe_h26xf_bits b;
+    if (unlikely(!ubase_check(upipe_h26xf_bits_init(&b, ubuf, offset + 2,
+                                                    size - 2))))
         return UBASE_ERR_INVALID;
 
-    upipe_h26xf_stream_fill_bits(s, 2);
-    bool first_slice_in_pic = !!ubuf_block_stream_show_bits(s, 1);
-    ubuf_block_stream_skip_bits(s, 1);
-    if (*au_slice_p && first_slice_in_pic) {
-        ubuf_block_stream_clean(s);
+    bool first_slice_in_pic = !!upipe_h26xf_bits_read(&b, 1);
+    if (*au_slice_p && first_slice_in_pic)
         return UBASE_ERR_BUSY;
-    }
 
     uint8_t last_nal_type = h265nalst_get_type(nal);
     if (last_nal_type >= H265NAL_TYPE_BLA_W_LP &&
         last_nal_type <= H265NAL_TYPE_IRAP_VCL23)
-        ubuf_block_stream_skip_bits(s, 1);
+        upipe_h26xf_bits_skip(&b, 1);
 
-    uint32_t pps_id = upipe_h26xf_stream_ue(s);
+    uint32_t pps_id = upipe_h26xf_bits_ue(&b);
     if (unlikely(pps_id >= H265PPS_ID_MAX)) {
         upipe_warn_va(upipe, "invalid PPS %"PRIu32" in slice", pps_id);
-        ubuf_block_stream_clean(s);
         return UBASE_ERR_INVALID;
     }
-    if (*au_slice_p && pps_id != upipe_h265f->active_pps) {
-        ubuf_block_stream_clean(s);
+    if (*au_slice_p && pps_id != upipe_h265f->active_pps)
         return UBASE_ERR_BUSY;
-    }
-    if (unlikely(!upipe_h265f_activate_pps(upipe, pps_id))) {
-        ubuf_block_stream_clean(s);
+    if (unlikely(!upipe_h265f_activate_pps(upipe, pps_id)))
         return UBASE_ERR_INVALID;
-    }
 
     if (first_slice_in_pic) {
-        upipe_h26xf_stream_fill_bits(s, 8);
-        ubuf_block_stream_skip_bits(s,
-                upipe_h265f->num_extra_slice_header_bits);
-        upipe_h265f->slice_type = upipe_h26xf_stream_ue(s);
+        upipe_h26xf_bits_skip(&b, upipe_h265f->num_extra_slice_header_bits);
+        upipe_h265f->slice_type = upipe_h26xf_bits_ue(&b);
     }
 
     if (upipe_h265f->au_vcl_offset == -1)
@@ -2120,7 +2121,9 @@ static void upipe_h265f_output_au(struct upipe *upipe, struct uref *uref,
             upipe_throw_error(upipe, err);
     }
 
-    if (upipe_h265f_find_annexb_nal(upipe, uref, H265NAL_TYPE_AUD) == -1) {
+    if ((!ubase_check(uref_h26x_get_au_partial(uref)) ||
+         ubase_check(uref_block_get_start(uref))) &&
+        upipe_h265f_find_annexb_nal(upipe, uref, H265NAL_TYPE_AUD) == -1) {
         upipe_verbose(upipe, "prepending AUD");
         struct ubuf *ubuf = ubuf_dup(upipe_h265f->annexb_aud);
         if (unlikely(ubuf == NULL)) {
@@ -2136,33 +2139,15 @@ static void upipe_h265f_output_au(struct upipe *upipe, struct uref *uref,
     upipe_h265f_output(upipe, uref, upump_p);
 }
 
-/** @internal @This prepares an annex B access unit.
+/** @internal @This extracts the beginning of an annex B access unit, and
+ * sets the attributes and dates of the access unit.
  *
  * @param upipe description structure of the pipe
  * @return pointer to uref
  */
-static struct uref *upipe_h265f_prepare_annexb(struct upipe *upipe)
+static struct uref *upipe_h265f_extract_annexb(struct upipe *upipe)
 {
     struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
-    if (!upipe_h265f->au_size) {
-        upipe_h265f->au_nal_units = 0;
-        upipe_h265f->au_vcl_offset = -1;
-        upipe_h265f->au_slice = false;
-        upipe_h265f->pic_struct = -1;
-        return NULL;
-    }
-    if (upipe_h265f->active_vps == -1 || upipe_h265f->active_sps == -1 ||
-        upipe_h265f->active_pps == -1) {
-        upipe_warn(upipe, "discarding data without VPS/SPS/PPS");
-        upipe_h265f_consume_uref_stream(upipe, upipe_h265f->au_size);
-        upipe_h265f->au_size = 0;
-        upipe_h265f->au_nal_units = 0;
-        upipe_h265f->au_vcl_offset = -1;
-        upipe_h265f->au_slice = false;
-        upipe_h265f->pic_struct = -1;
-        return NULL;
-    }
-
     struct uref au_uref_s = upipe_h265f->au_uref_s;
     struct urational drift_rate = upipe_h265f->drift_rate;
     /* From now on, PTS declaration only impacts the next frame. */
@@ -2212,6 +2197,66 @@ static struct uref *upipe_h265f_prepare_annexb(struct upipe *upipe)
         uref_clock_delete_rate(uref);
 
     upipe_h265f->au_size = 0;
+    return uref;
+}
+
+/** @internal @This extracts the next piece of an annex B access unit whose
+ * beginning was already output in slice output mode.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to uref, or NULL if there is nothing to output
+ */
+static struct uref *upipe_h265f_extract_partial_annexb(struct upipe *upipe)
+{
+    struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
+    if (!upipe_h265f->au_size)
+        return NULL;
+
+    struct uref *uref = upipe_h265f_extract_uref_stream(upipe,
+                                                        upipe_h265f->au_size);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+    upipe_h265f->au_size = 0;
+    upipe_h265f->au_nal_units = 0;
+    UBASE_FATAL(upipe, uref_h26x_set_au_partial(uref))
+    return uref;
+}
+
+/** @internal @This prepares an annex B access unit.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to uref
+ */
+static struct uref *upipe_h265f_prepare_annexb(struct upipe *upipe)
+{
+    struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
+    if (!upipe_h265f->au_size || upipe_h265f->au_partial) {
+        struct uref *uref = upipe_h265f_extract_partial_annexb(upipe);
+        upipe_h265f->au_nal_units = 0;
+        upipe_h265f->au_vcl_offset = -1;
+        upipe_h265f->au_slice = false;
+        upipe_h265f->au_partial = false;
+        upipe_h265f->pic_struct = -1;
+        return uref;
+    }
+    if (upipe_h265f->active_vps == -1 || upipe_h265f->active_sps == -1 ||
+        upipe_h265f->active_pps == -1) {
+        upipe_warn(upipe, "discarding data without VPS/SPS/PPS");
+        upipe_h265f_consume_uref_stream(upipe, upipe_h265f->au_size);
+        upipe_h265f->au_size = 0;
+        upipe_h265f->au_nal_units = 0;
+        upipe_h265f->au_vcl_offset = -1;
+        upipe_h265f->au_slice = false;
+        upipe_h265f->pic_struct = -1;
+        return NULL;
+    }
+
+    struct uref *uref = upipe_h265f_extract_annexb(upipe);
+    if (unlikely(uref == NULL))
+        return NULL;
+
     upipe_h265f->au_vcl_offset = -1;
     upipe_h265f->au_slice = false;
     upipe_h265f->pic_struct = -1;
@@ -2238,6 +2283,39 @@ static void upipe_h265f_output_annexb(struct upipe *upipe,
         upipe_h265f_output_au(upipe, uref, upump_p);
 }
 
+/** @internal @This outputs the slices parsed so far in the current access
+ * unit, in slice output mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_h265f_output_slice_annexb(struct upipe *upipe,
+                                            struct upump **upump_p)
+{
+    struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
+    if (!upipe_h265f->slice_output ||
+        upipe_h265f->flow_def_requested == NULL)
+        return;
+
+    struct uref *uref;
+    if (!upipe_h265f->au_partial) {
+        if (upipe_h265f->active_vps == -1 || upipe_h265f->active_sps == -1 ||
+            upipe_h265f->active_pps == -1)
+            return;
+        uref = upipe_h265f_extract_annexb(upipe);
+        if (unlikely(uref == NULL))
+            return;
+        upipe_h265f->au_partial = true;
+        uref_block_set_start(uref);
+        UBASE_FATAL(upipe, uref_h26x_set_au_partial(uref))
+    } else {
+        uref = upipe_h265f_extract_partial_annexb(upipe);
+        if (uref == NULL)
+            return;
+    }
+    upipe_h265f_output_au(upipe, uref, upump_p);
+}
+
 /** @internal @This outputs the previous access unit, before the current NAL.
  *
  * @param upipe description structure of the pipe
@@ -2311,6 +2389,7 @@ static void upipe_h265f_end_annexb(struct upipe *upipe, struct upump **upump_p)
             last_nal_type == H265NAL_TYPE_CRA) {
             uref_flow_set_random(upipe_h265f->next_uref);
         }
+        upipe_h265f_output_slice_annexb(upipe, upump_p);
         return;
     }
 
@@ -2836,6 +2915,18 @@ static int upipe_h265f_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_h265f_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_H265F_SET_LIGHT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H265F_SIGNATURE)
+            struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
+            upipe_h265f->light = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_H265F_SET_SLICE_OUTPUT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_H265F_SIGNATURE)
+            struct upipe_h265f *upipe_h265f = upipe_h265f_from_upipe(upipe);
+            upipe_h265f->slice_output = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
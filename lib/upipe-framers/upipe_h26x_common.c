@@ -33,6 +33,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 /** @This translates the h26x aspect_ratio_idc to urational */
 const struct urational upipe_h26xf_sar_from_idc[17] = {
@@ -135,6 +136,65 @@ int32_t upipe_h26xf_stream_se(struct ubuf_block_stream *s)
     return (v & 1) ? (v + 1) / 2 : -(v / 2);
 }
 
+/** @This checks whether a parameter set NAL unit is identical to the one
+ * already stored for its identifier.
+ *
+ * @param stored stored parameter set, or NULL
+ * @param ubuf ubuf containing the NAL unit
+ * @param offset offset of the NAL unit in the ubuf
+ * @param size size of the NAL unit, in octets
+ * @return true if the NAL unit is identical to the stored one
+ */
+bool upipe_h26xf_ps_equal(struct ubuf *stored, struct ubuf *ubuf,
+                          size_t offset, size_t size)
+{
+    size_t stored_size;
+    return stored != NULL &&
+           ubase_check(ubuf_block_size(stored, &stored_size)) &&
+           stored_size == size &&
+           ubase_check(ubuf_block_compare(ubuf, offset, stored));
+}
+
+/** @This initializes a bit reader with the start of a NAL unit, removing
+ * escape words. At most @ref UPIPE_H26XF_BITS_WINDOW octets are read.
+ *
+ * @param b bit reader
+ * @param ubuf pointer to block ubuf
+ * @param offset offset of the first octet to read
+ * @param size number of octets available from offset
+ * @return an error code
+ */
+int upipe_h26xf_bits_init(struct upipe_h26xf_bits *b, struct ubuf *ubuf,
+                          size_t offset, size_t size)
+{
+    uint8_t raw[UPIPE_H26XF_BITS_WINDOW];
+    if (size > UPIPE_H26XF_BITS_WINDOW)
+        size = UPIPE_H26XF_BITS_WINDOW;
+    UBASE_RETURN(ubuf_block_extract(ubuf, offset, size, raw))
+
+    /* escape words are 00 00 03, copy the runs between them at once */
+    uint8_t *w = b->window;
+    size_t run = 0;
+    for (size_t i = 2; i < size; i++) {
+        if (unlikely(raw[i] == 3 && !raw[i - 1] && !raw[i - 2])) {
+            memcpy(w, raw + run, i - run);
+            w += i - run;
+            run = i + 1;
+        }
+    }
+    if (run < size) {
+        memcpy(w, raw + run, size - run);
+        w += size - run;
+    }
+
+    b->buffer = b->window;
+    b->end = w;
+    b->cache = 0;
+    b->available = 0;
+    b->overflow = false;
+    return UBASE_ERR_NONE;
+}
+
 /** @This allocates a ubuf containing an annex B header.
  *
  * @param ubuf_mgr pointer to ubuf manager
@@ -272,6 +332,57 @@ static int upipe_h26xf_encaps_nal(struct uref *uref,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This rewrites the header of a NAL unit in place, when the
+ * input and output headers have the same size, so that neither the payload
+ * nor the header needs to be moved or reallocated.
+ *
+ * @param uref pointer to uref
+ * @param nal_offset offset of the NAL unit
+ * @param nal_size size of the NAL unit, including start code
+ * @param encaps_input input H26x encapsulation
+ * @param encaps_output output H26x encapsulation
+ * @return an error code, esp. UBASE_ERR_UNHANDLED if the header cannot be
+ * rewritten in place
+ */
+static int upipe_h26xf_rewrite_nal(struct uref *uref,
+        uint64_t nal_offset, uint64_t nal_size,
+        enum uref_h26x_encaps encaps_input, enum uref_h26x_encaps encaps_output)
+{
+    uint8_t header[4];
+    if (nal_size <= 4)
+        return UBASE_ERR_UNHANDLED;
+
+    if (encaps_input == UREF_H26X_ENCAPS_ANNEXB &&
+        encaps_output == UREF_H26X_ENCAPS_LENGTH4) {
+        UBASE_RETURN(uref_block_extract(uref, nal_offset, 4, header))
+        /* only 00 00 00 01 start codes have the size of a length field */
+        if (header[2] != 0 || nal_size - 4 > UINT32_MAX)
+            return UBASE_ERR_UNHANDLED;
+        header[0] = (nal_size - 4) >> 24;
+        header[1] = ((nal_size - 4) >> 16) & 0xff;
+        header[2] = ((nal_size - 4) >> 8) & 0xff;
+        header[3] = (nal_size - 4) & 0xff;
+    } else if (encaps_input == UREF_H26X_ENCAPS_LENGTH4 &&
+               encaps_output == UREF_H26X_ENCAPS_ANNEXB) {
+        header[0] = header[1] = header[2] = 0;
+        header[3] = 1;
+    } else
+        return UBASE_ERR_UNHANDLED;
+
+    int size = 4;
+    uint8_t *buffer;
+    if (!ubase_check(uref_block_write(uref, nal_offset, &size, &buffer)))
+        /* shared buffer */
+        return UBASE_ERR_UNHANDLED;
+    if (size < 4) {
+        /* header split across segments */
+        uref_block_unmap(uref, nal_offset);
+        return UBASE_ERR_UNHANDLED;
+    }
+    memcpy(buffer, header, 4);
+    return uref_block_unmap(uref, nal_offset);
+}
+
 /** @This converts a frame from an encapsulation to another.
  *
  * @param upipe description structure of the pipe
@@ -298,11 +409,16 @@ int upipe_h26xf_convert_frame(struct uref *uref,
     while (ubase_check(uref_h26x_iterate_nal(uref, &nal_units,
                                              &nal_offset, &nal_size,
                                              nal_offset_correction))) {
-        UBASE_RETURN(upipe_h26xf_decaps_nal(uref, nal_offset, &nal_size,
-                    encaps_input, &nal_offset_correction))
-        UBASE_RETURN(upipe_h26xf_encaps_nal(uref, nal_offset, &nal_size,
-                    encaps_output, ubuf_mgr, annexb_header,
-                    &nal_offset_correction))
+        int err = upipe_h26xf_rewrite_nal(uref, nal_offset, nal_size,
+                                          encaps_input, encaps_output);
+        if (err == UBASE_ERR_UNHANDLED) {
+            UBASE_RETURN(upipe_h26xf_decaps_nal(uref, nal_offset, &nal_size,
+                        encaps_input, &nal_offset_correction))
+            UBASE_RETURN(upipe_h26xf_encaps_nal(uref, nal_offset, &nal_size,
+                        encaps_output, ubuf_mgr, annexb_header,
+                        &nal_offset_correction))
+        } else
+            UBASE_RETURN(err)
 
         if (vcl_offset && vcl_offset <= nal_offset + nal_size) {
             uref_block_set_header_size(uref,
@@ -66,6 +66,15 @@
 /** max number of octetrate changes before considering it is free octetrate
  * (mp3 only) */
 #define MAX_OCTETRATE_CHANGES 10
+/** number of octets dropped while resyncing on the last valid header, before
+ * accepting any sync word */
+#define MAX_RESYNC_CACHED 16384
+/** fixed fields of an MPEG audio header: sync, ID, layer, protection and
+ * sampling frequency */
+#define MPGA_SYNC_MASK UINT32_C(0xffff0c00)
+/** fixed fields of an ADTS header: sync, ID, layer, protection, profile,
+ * sampling frequency and channel configuration */
+#define ADTS_SYNC_MASK UINT32_C(0xfffffdc0)
 
 /** @This returns the octetrate / 1000 of an MPEG-1 or 2 audio stream. */
 static const uint8_t mpeg_octetrate_table[2][3][16] = {
@@ -197,6 +206,8 @@ struct upipe_mpgaf {
     bool got_discontinuity;
     /** sync header */
     uint8_t sync_header[MPGA_HEADER_SIZE + ADTS_HEADER_SIZE]; // to be sure
+    /** number of octets dropped since the sync was lost */
+    size_t resync_dropped;
     /** number of bits the header (LATM is not octet-aligned) */
     int latm_header_size;
     /** duration since last LATM mux configuration */
@@ -318,6 +329,7 @@ static struct upipe *upipe_mpgaf_alloc(struct upipe_mgr *mgr,
     upipe_mpgaf_flush_dates(upipe);
     upipe_mpgaf->drift_rate.num = upipe_mpgaf->drift_rate.den = 0;
     upipe_mpgaf->sync_header[0] = 0x0;
+    upipe_mpgaf->resync_dropped = 0;
     upipe_mpgaf->latm_header_size = 0;
     upipe_mpgaf->latm_config_duration = 0;
     upipe_throw_ready(upipe);
@@ -1616,6 +1628,52 @@ static bool upipe_mpgaf_scan(struct upipe *upipe, size_t *dropped_p)
     return false;
 }
 
+/** @internal @This scans for a header with the same fixed fields as the
+ * last valid header, so that a single masked compare discards most of the
+ * false sync words found in corrupted input. After @ref MAX_RESYNC_CACHED
+ * octets, or if no header is known, any sync word is accepted, in case the
+ * format has changed.
+ *
+ * @param upipe description structure of the pipe
+ * @param dropped_p filled with the number of octets to drop before the sync
+ * @return true if a sync word was found
+ */
+static bool upipe_mpgaf_resync(struct upipe *upipe, size_t *dropped_p)
+{
+    struct upipe_mpgaf *upipe_mpgaf = upipe_mpgaf_from_upipe(upipe);
+    uint32_t mask;
+    if (upipe_mpgaf->encaps_input == UREF_MPGA_ENCAPS_LOAS ||
+        upipe_mpgaf->sync_header[0] != 0xff ||
+        upipe_mpgaf->resync_dropped >= MAX_RESYNC_CACHED)
+        mask = 0;
+    else if (upipe_mpgaf->type == UPIPE_MPGAF_MP2)
+        mask = MPGA_SYNC_MASK;
+    else if (upipe_mpgaf->type == UPIPE_MPGAF_AAC)
+        mask = ADTS_SYNC_MASK;
+    else
+        mask = 0;
+    if (!mask)
+        return upipe_mpgaf_scan(upipe, dropped_p);
+
+    const uint8_t *h = upipe_mpgaf->sync_header;
+    uint32_t sync = ((uint32_t)h[0] << 24 | h[1] << 16 | h[2] << 8 | h[3]) &
+                    mask;
+    while (ubase_check(uref_block_scan(upipe_mpgaf->next_uref, dropped_p,
+                                       0xff))) {
+        uint8_t words[4];
+        if (!ubase_check(uref_block_extract(upipe_mpgaf->next_uref,
+                         *dropped_p, 4, words)))
+            return false;
+
+        uint32_t word = (uint32_t)words[0] << 24 | words[1] << 16 |
+                        words[2] << 8 | words[3];
+        if ((word & mask) == sync)
+            return true;
+        (*dropped_p)++;
+    }
+    return false;
+}
+
 /** @internal @This checks if a sync word begins just after the end of the
  * next frame.
  *
@@ -1661,8 +1719,9 @@ static void upipe_mpgaf_work(struct upipe *upipe, struct upump **upump_p)
     while (upipe_mpgaf->next_uref != NULL) {
         if (unlikely(!upipe_mpgaf->acquired)) {
             size_t dropped = 0;
-            bool ret = upipe_mpgaf_scan(upipe, &dropped);
+            bool ret = upipe_mpgaf_resync(upipe, &dropped);
             upipe_mpgaf_consume_uref_stream(upipe, dropped);
+            upipe_mpgaf->resync_dropped += dropped;
             if (!ret)
                 return;
         }
@@ -1670,6 +1729,7 @@ static void upipe_mpgaf_work(struct upipe *upipe, struct upump **upump_p)
             !upipe_mpgaf_parse_header(upipe)) {
             upipe_warn(upipe, "invalid header");
             upipe_mpgaf_consume_uref_stream(upipe, 1);
+            upipe_mpgaf->resync_dropped++;
             upipe_mpgaf_sync_lost(upipe);
             continue;
         }
@@ -1687,6 +1747,7 @@ static void upipe_mpgaf_work(struct upipe *upipe, struct upump **upump_p)
             if (unlikely(!upipe_mpgaf_check_frame(upipe, &ready))) {
                 upipe_warn(upipe, "invalid frame");
                 upipe_mpgaf_consume_uref_stream(upipe, 1);
+                upipe_mpgaf->resync_dropped++;
                 upipe_mpgaf->next_frame_size = -1;
                 upipe_mpgaf_sync_lost(upipe);
                 continue;
@@ -1696,6 +1757,7 @@ static void upipe_mpgaf_work(struct upipe *upipe, struct upump **upump_p)
         }
 
         upipe_mpgaf_sync_acquired(upipe);
+        upipe_mpgaf->resync_dropped = 0;
         struct uref *uref = upipe_mpgaf_handle_frame(upipe);
         upipe_mpgaf->next_frame_size = -1;
 
@@ -148,8 +148,29 @@ static struct upipe *upipe_s337d_alloc(struct upipe_mgr *mgr,
 static bool upipe_s337d_scan(struct upipe *upipe, size_t *dropped_p)
 {
     struct upipe_s337d *upipe_s337d = upipe_s337d_from_upipe(upipe);
-    while (ubase_check(uref_block_scan(upipe_s337d->next_uref, dropped_p,
-                                       S337_PREAMBLE_A1))) {
+    const uint8_t *buffer;
+    int size = -1;
+    while (ubase_check(uref_block_read(upipe_s337d->next_uref, *dropped_p,
+                                       &size, &buffer))) {
+        /* check candidates in place, as long as the preamble does not
+         * straddle two segments */
+        const uint8_t *end = buffer + size;
+        const uint8_t *p = memchr(buffer, S337_PREAMBLE_A1, size);
+        while (p != NULL && end - p >= 4 &&
+               (p[1] != S337_PREAMBLE_A2 || p[2] != S337_PREAMBLE_B1 ||
+                p[3] != S337_PREAMBLE_B2))
+            p = memchr(p + 1, S337_PREAMBLE_A1, end - p - 1);
+        uref_block_unmap(upipe_s337d->next_uref, *dropped_p);
+
+        if (p == NULL) {
+            *dropped_p += size;
+            size = -1;
+            continue;
+        }
+        *dropped_p += p - buffer;
+        if (end - p >= 4)
+            return true;
+
         uint8_t preamble[3];
         if (!ubase_check(uref_block_extract(upipe_s337d->next_uref,
                         *dropped_p + 1, 3, preamble)))
@@ -160,6 +181,7 @@ static bool upipe_s337d_scan(struct upipe *upipe, size_t *dropped_p)
             preamble[2] == S337_PREAMBLE_B2)
             return true;
         (*dropped_p)++;
+        size = -1;
     }
     return false;
 }
@@ -35,6 +35,7 @@
 #include "upipe/uref.h"
 #include "upipe/uref_sound_flow.h"
 #include "upipe/uref_sound.h"
+#include "upipe/ubuf_sound.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -42,9 +43,16 @@
 #include "upipe/upipe_helper_output.h"
 #include "upipe/upipe_helper_flow_def.h"
 #include "upipe-framers/upipe_s337_framer.h"
+#include "upipe-framers/uref_s337.h"
 
 #include <bitstream/smpte/337.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 /** upipe_s337f structure */
 struct upipe_s337f {
     /** refcount management structure */
@@ -62,8 +70,12 @@ struct upipe_s337f {
     /** buffered uref */
     struct uref *uref;
 
-    /** size in samples of buffered uref */
+    /** size in samples of buffered uref, from the sync word */
     ssize_t buffered_samples;
+    /** size in samples of the input frame the buffered uref comes from */
+    size_t frame_samples;
+    /** position of the sync word in the last uref, or -1 */
+    ssize_t sync_pos;
 
     /** input flow definition packet */
     struct uref *flow_def_input;
@@ -101,65 +113,116 @@ static struct upipe *upipe_s337f_alloc(struct upipe_mgr *mgr,
     upipe_s337f_init_output(upipe);
     upipe_s337f_init_flow_def(upipe);
     upipe_s337f->uref = NULL;
+    upipe_s337f->buffered_samples = 0;
+    upipe_s337f->frame_samples = 0;
+    upipe_s337f->sync_pos = -1;
     upipe_throw_ready(upipe);
     return upipe;
 }
 
-/** @internal @This finds the position of the s337m sync word in the frame
+/** @internal @This checks if a stereo sample carries the Pa/Pb sync words,
+ * in 20 or 24-bit mode.
+ */
+static inline bool upipe_s337f_is_sync(const int32_t *in)
+{
+    return (in[0] == (0x6f872 << 12) && in[1] == (0x54e1f << 12)) ||
+           (in[0] == (0x96f872 << 8) && in[1] == (0xa54e1f << 8));
+}
+
+/** @internal @This scans stereo samples for the Pa/Pb sync words, two
+ * samples at a time when SIMD instructions are available.
+ *
+ * @param in interleaved stereo samples
+ * @param size number of samples
+ * @return position of the first sync word, or -1
+ */
+static ssize_t upipe_s337f_scan(const int32_t *in, size_t size)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i sync20 = _mm_set_epi32(0x54e1f << 12, 0x6f872 << 12,
+                                         0x54e1f << 12, 0x6f872 << 12);
+    const __m128i sync24 = _mm_set_epi32(0xa54e1f << 8, 0x96f872 << 8,
+                                         0xa54e1f << 8, 0x96f872 << 8);
+    for ( ; i + 2 <= size; i += 2) {
+        __m128i v = _mm_loadu_si128((const __m128i *)&in[2*i]);
+        __m128i m = _mm_or_si128(_mm_cmpeq_epi32(v, sync20),
+                                 _mm_cmpeq_epi32(v, sync24));
+        if (unlikely(_mm_movemask_epi8(m))) {
+            if (upipe_s337f_is_sync(&in[2*i]))
+                return i;
+            if (upipe_s337f_is_sync(&in[2*i+2]))
+                return i + 1;
+        }
+    }
+#elif defined(__ARM_NEON)
+    const int32_t sync20_words[4] = { 0x6f872 << 12, 0x54e1f << 12,
+                                      0x6f872 << 12, 0x54e1f << 12 };
+    const int32_t sync24_words[4] = { 0x96f872 << 8, 0xa54e1f << 8,
+                                      0x96f872 << 8, 0xa54e1f << 8 };
+    const int32x4_t sync20 = vld1q_s32(sync20_words);
+    const int32x4_t sync24 = vld1q_s32(sync24_words);
+    for ( ; i + 2 <= size; i += 2) {
+        int32x4_t v = vld1q_s32(&in[2*i]);
+        uint64x2_t m = vreinterpretq_u64_u32(vorrq_u32(vceqq_s32(v, sync20),
+                                                       vceqq_s32(v, sync24)));
+        if (unlikely(vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1))) {
+            if (upipe_s337f_is_sync(&in[2*i]))
+                return i;
+            if (upipe_s337f_is_sync(&in[2*i+2]))
+                return i + 1;
+        }
+    }
+#endif
+    for ( ; i < size; i++)
+        if (upipe_s337f_is_sync(&in[2*i]))
+            return i;
+    return -1;
+}
+
+/** @internal @This finds the position of the s337m sync word in the frame.
+ * Once locked, bursts are usually aligned on the input frames, so the
+ * position of the previous sync word is checked first.
  */
 static ssize_t upipe_s337f_sync(struct upipe *upipe, struct uref *uref)
 {
+    struct upipe_s337f *upipe_s337f = upipe_s337f_from_upipe(upipe);
     size_t size = 0;
     if (!ubase_check(uref_sound_size(uref, &size, NULL))) {
         return -1;
     }
 
     const int32_t *in;
-    uref_sound_read_int32_t(uref, 0, -1, &in, 1);
+    if (!ubase_check(uref_sound_read_int32_t(uref, 0, -1, &in, 1)))
+        return -1;
 
-    for (size_t i = 0; i < size; i++)
-        if ((in[2*i+0] == (0x6f872 << 12) && in[2*i+1] == (0x54e1f << 12)) ||
-                ((in[2*i+0] == (0x96f872 << 8) && in[2*i+1] == (0xa54e1f << 8)))) {
-            uref_sound_unmap(uref, 0, -1, 1);
-            return i;
-        }
+    ssize_t sync_pos = upipe_s337f->sync_pos;
+    if (upipe_s337f->uref == NULL || sync_pos < 0 ||
+        (size_t)sync_pos >= size || !upipe_s337f_is_sync(&in[2*sync_pos]))
+        sync_pos = upipe_s337f_scan(in, size);
 
     uref_sound_unmap(uref, 0, -1, 1);
 
-    return -1;
+    upipe_s337f->sync_pos = sync_pos;
+    return sync_pos;
 }
 
 
-/** @internal @This buffers last uref
+/** @internal @This buffers last uref, from its sync word. The leading
+ * samples are skipped by resizing the uref, without touching the buffer.
  */
 static int upipe_s337f_buffer(struct upipe *upipe, struct uref *uref, ssize_t sync_pos)
 {
     struct upipe_s337f *upipe_s337f = upipe_s337f_from_upipe(upipe);
 
-    /* discard leading samples up to sync word */
-
     size_t size;
-    uref_sound_size(uref, &size, NULL);
-
-    int32_t *samples;
-    if (!ubase_check(uref_sound_write_int32_t(uref, 0, -1, &samples, 1))) {
-        // FIXME
-        struct ubuf *ubuf = ubuf_sound_copy(uref->ubuf->mgr, uref->ubuf,
-                0, size);
-        if (!ubuf)
-            return UBASE_ERR_ALLOC;
-        uref_attach_ubuf(uref, ubuf);
-
-        if (!ubase_check(uref_sound_write_int32_t(uref, 0, -1, &samples, 1))) {
-            upipe_err(upipe, "Could not map buffered audio uref for writing");
-            return UBASE_ERR_INVALID;
-        }
-    }
+    UBASE_RETURN(uref_sound_size(uref, &size, NULL))
 
-    size_t s = 2 /* stereo */ * 4 /* s32 */ * (size - sync_pos);
-    memmove(samples, &samples[2*sync_pos], s); // discard up to sync word
+    /* discard leading samples up to sync word */
+    if (sync_pos)
+        UBASE_RETURN(uref_sound_resize(uref, sync_pos, -1))
 
-    uref_sound_unmap(uref, 0, -1, 1);
+    upipe_s337f->frame_samples = size;
     upipe_s337f->buffered_samples = size - sync_pos;
 
     /* buffer next uref */
@@ -204,36 +267,30 @@ static void upipe_s337f_throw_flow_def(struct upipe *upipe, size_t frame_size,
         upipe_s337f_store_flow_def(upipe, flow_def);
 }
 
-/** @internal @This handles current uref
+/** @internal @This completes the buffered uref with the samples of the
+ * current uref preceding its sync word. When the burst is aligned on the
+ * input frames, the buffered uref is output as is; otherwise both parts are
+ * copied once into a new buffer.
  */
 static int upipe_s337f_handle(struct upipe *upipe, struct uref *uref, ssize_t sync_pos)
 {
     struct upipe_s337f *upipe_s337f = upipe_s337f_from_upipe(upipe);
     struct uref *output = upipe_s337f->uref;
+    size_t buffered = upipe_s337f->buffered_samples;
 
     /* current uref */
     size_t in_size;
     if (!ubase_check(uref_sound_size(uref, &in_size, NULL)))
         return UBASE_ERR_INVALID;
 
-    /* buffered uref */
-    size_t out_size;
-    if (!ubase_check(uref_sound_size(output, &out_size, NULL)))
-        return UBASE_ERR_INVALID;
+    /* size of the output frame */
+    size_t out_size = upipe_s337f->frame_samples;
 
-    if (in_size < upipe_s337f->buffered_samples)
+    if (in_size < buffered)
         return UBASE_ERR_INVALID;
 
-    /* how much data to copy from current to buffered uref */
-    size_t missing_size = in_size - upipe_s337f->buffered_samples;
-    if (missing_size < sync_pos)
-        upipe_verbose(upipe, "Frame too small");
-
     /* NTSC sequence */
-    bool enlarge_output = false;
-
     if (in_size == out_size + 1) {
-        enlarge_output = true;
         out_size++;
     } else if (in_size > out_size) {
         upipe_warn_va(upipe, "Too large frame, dropping buffered uref");
@@ -241,51 +298,70 @@ static int upipe_s337f_handle(struct upipe *upipe, struct uref *uref, ssize_t sy
         return UBASE_ERR_INVALID;
     }
 
-    /* map current uref until sync word */
-    const int32_t *in32;
-    if (!ubase_check(uref_sound_read_int32_t(uref, 0, sync_pos, &in32, 1))) {
-        upipe_err(upipe, "Could not map audio uref for reading");
-        return UBASE_ERR_INVALID;
-    }
+    /* how much data to copy from current to buffered uref */
+    size_t missing_size = out_size - buffered;
+    if (missing_size > sync_pos) {
+        upipe_verbose(upipe, "Frame too big, padding");
+        missing_size = sync_pos;
+    } else if (missing_size < sync_pos)
+        upipe_verbose(upipe, "Frame too small");
+
+    if (buffered != out_size) {
+        struct ubuf *ubuf = ubuf_sound_alloc(output->ubuf->mgr, out_size);
+        if (unlikely(ubuf == NULL))
+            return UBASE_ERR_ALLOC;
 
-    /* map buffered uref for filling */
-    int32_t *out32;
-    if (enlarge_output ||
-            !ubase_check(uref_sound_write_int32_t(output, 0, -1, &out32, 1))) {
-        struct ubuf *ubuf = ubuf_sound_copy(output->ubuf->mgr, output->ubuf,
-                0, out_size);
-        if (!ubuf) {
-            uref_sound_unmap(uref, 0, sync_pos, 1);
+        int32_t *out32;
+        const int32_t *buf32, *in32;
+        if (unlikely(!ubase_check(ubuf_sound_write_int32_t(ubuf, 0, -1,
+                                                           &out32, 1)))) {
+            ubuf_free(ubuf);
             return UBASE_ERR_INVALID;
         }
-        uref_attach_ubuf(output, ubuf);
-
-        if (!ubase_check(uref_sound_write_int32_t(output, 0, -1, &out32, 1))) {
-            upipe_err(upipe, "Could not map buffered audio uref for writing");
-            uref_sound_unmap(uref, 0, sync_pos, 1);
+        if (unlikely(!ubase_check(uref_sound_read_int32_t(output, 0, -1,
+                                                          &buf32, 1)))) {
+            ubuf_sound_unmap(ubuf, 0, -1, 1);
+            ubuf_free(ubuf);
             return UBASE_ERR_INVALID;
         }
-    }
+        memcpy(out32, buf32, buffered * 2 /* channels */ * 4 /* s32 */);
+        uref_sound_unmap(output, 0, -1, 1);
+
+        if (missing_size) {
+            if (unlikely(!ubase_check(uref_sound_read_int32_t(uref, 0,
+                                missing_size, &in32, 1)))) {
+                upipe_err(upipe, "Could not map audio uref for reading");
+                ubuf_sound_unmap(ubuf, 0, -1, 1);
+                ubuf_free(ubuf);
+                return UBASE_ERR_INVALID;
+            }
+            memcpy(&out32[2*buffered], in32,
+                   missing_size * 2 /* channels */ * 4 /* s32 */);
+            uref_sound_unmap(uref, 0, missing_size, 1);
+        }
 
-    /* data from current uref won't be enough */
-    if (missing_size > sync_pos) {
-        upipe_verbose(upipe, "Frame too big, padding");
-        size_t padding = out_size - missing_size - upipe_s337f->buffered_samples;
-        memset(&out32[2*(upipe_s337f->buffered_samples + missing_size)], 0, 4 * padding);
-    }
+        size_t padding = out_size - buffered - missing_size;
+        memset(&out32[2*(buffered + missing_size)], 0,
+               padding * 2 /* channels */ * 4 /* s32 */);
 
-    memcpy(&out32[2*upipe_s337f->buffered_samples], in32,
-            missing_size * 2 /* channels */ * 4 /* s32 */);
-    uref_sound_unmap(uref, 0, sync_pos, 1);
+        ubuf_sound_unmap(ubuf, 0, -1, 1);
+        uref_attach_ubuf(output, ubuf);
+    }
 
     /* header */
+    const int32_t *out32;
+    if (!ubase_check(uref_sound_read_int32_t(output, 0, 4, &out32, 1))) {
+        upipe_err(upipe, "Could not map buffered audio uref for reading");
+        return UBASE_ERR_INVALID;
+    }
+
     int bits = (out32[0] == 0x6f872 << 12) ? 20 : 24;
 
     uint32_t hdr[2]; /* Pc + Pd */
     hdr[0] = out32[2] >> 16;
     hdr[1] = out32[3] >> (32 - bits);
 
-    uref_sound_unmap(output, 0, -1, 1);
+    uref_sound_unmap(output, 0, 4, 1);
 
     unsigned error_flag         = (hdr[0] >>  7) & 0x1;
     unsigned data_type          = (hdr[0] >>  0) & 0x1f;
@@ -298,6 +374,10 @@ static int upipe_s337f_handle(struct upipe *upipe, struct uref *uref, ssize_t sy
         upipe_err_va(upipe, "S337 frame truncated");
     }
 
+    /* so that downstream pipes need not parse the burst again */
+    uref_s337_set_data_type(output, data_type);
+    uref_s337_set_length(output, hdr[1]);
+
     upipe_s337f_throw_flow_def(upipe, in_size, data_type);
 
     return UBASE_ERR_NONE;
@@ -52,6 +52,81 @@
 #include FT_CACHE_H
 #include FT_ADVANCES_H
 
+#include <stdlib.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** number of buckets of the glyph atlas */
+#define ATLAS_BUCKETS 64
+
+/** @internal @This is a rendered glyph of the atlas. */
+struct upipe_freetype_glyph {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** glyph index */
+    FT_UInt index;
+    /** left offset of the bitmap */
+    int left;
+    /** top offset of the bitmap */
+    int top;
+    /** width of the bitmap */
+    int width;
+    /** height of the bitmap */
+    int height;
+    /** horizontal advance (16.16) */
+    int xadvance;
+    /** vertical advance (16.16) */
+    int yadvance;
+    /** coverage bitmap, width * height */
+    uint8_t buffer[];
+};
+
+UBASE_FROM_TO(upipe_freetype_glyph, uchain, uchain, uchain)
+
+/** @internal @This is a glyph placed by the text layout. */
+struct upipe_freetype_pos {
+    /** rendered glyph */
+    const struct upipe_freetype_glyph *glyph;
+    /** horizontal position of the bitmap */
+    int x;
+    /** vertical position of the bitmap */
+    int y;
+};
+
+/** @internal @This is a mapped plane of the output picture. */
+struct upipe_freetype_plane {
+    /** chroma name */
+    const char *chroma;
+    /** stride */
+    size_t stride;
+    /** horizontal subsampling */
+    uint8_t hsub;
+    /** vertical subsampling */
+    uint8_t vsub;
+    /** macropixel size */
+    uint8_t macropixel_size;
+    /** mapped buffer, or NULL */
+    uint8_t *p;
+};
+
+/** @internal @This lists the supported planes, in the order of @ref
+ * upipe_freetype_plane_id */
+static const char *upipe_freetype_chromas[] = {
+    "y8", "u8", "v8", "a8", "u8v8"
+};
+
+/** @internal @This identifies the supported planes. */
+enum upipe_freetype_plane_id {
+    PLANE_Y,
+    PLANE_U,
+    PLANE_V,
+    PLANE_A,
+    PLANE_UV,
+    PLANE_NB
+};
+
 /** upipe_freetype structure */
 struct upipe_freetype {
     /** refcount management structure exported to the public structure */
@@ -85,10 +160,16 @@ struct upipe_freetype {
     struct uref *flow_format;
     /** ubuf manager request */
     struct urequest ubuf_mgr_request;
-    /** cached ubuf */
+    /** cached ubuf, redrawn incrementally */
     struct ubuf *ubuf;
     /** cached text */
     char *text;
+    /** cached layout of the text */
+    struct upipe_freetype_pos *layout;
+    /** number of glyphs in the cached layout */
+    size_t layout_size;
+    /** rendered glyphs, for the current font and size */
+    struct uchain atlas[ATLAS_BUCKETS];
 
     /** request output */
     struct uref *flow_output;
@@ -171,6 +252,24 @@ static void upipe_freetype_flush_cache(struct upipe *upipe)
     upipe_freetype->ubuf = NULL;
     free(upipe_freetype->text);
     upipe_freetype->text = NULL;
+    free(upipe_freetype->layout);
+    upipe_freetype->layout = NULL;
+    upipe_freetype->layout_size = 0;
+}
+
+/** @internal @This flushes the rendered glyphs, and the cached buffer.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_freetype_flush_atlas(struct upipe *upipe)
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
+    upipe_freetype_flush_cache(upipe);
+    for (int i = 0; i < ATLAS_BUCKETS; i++) {
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&upipe_freetype->atlas[i])) != NULL)
+            free(upipe_freetype_glyph_from_uchain(uchain));
+    }
 }
 
 /** @internal @This checks the compatibility of a flow format.
@@ -276,7 +375,7 @@ static void upipe_freetype_free(struct upipe *upipe)
 
     upipe_throw_dead(upipe);
 
-    upipe_freetype_flush_cache(upipe);
+    upipe_freetype_flush_atlas(upipe);
     free(upipe_freetype->font);
     FTC_Manager_Done(upipe_freetype->cache_manager);
     FT_Done_FreeType(upipe_freetype->library);
@@ -338,6 +437,10 @@ static struct upipe *upipe_freetype_alloc(struct upipe_mgr *mgr,
     upipe_freetype->flow_output = flow_def;
     upipe_freetype->ubuf = NULL;
     upipe_freetype->text = NULL;
+    upipe_freetype->layout = NULL;
+    upipe_freetype->layout_size = 0;
+    for (int i = 0; i < ATLAS_BUCKETS; i++)
+        ulist_init(&upipe_freetype->atlas[i]);
     upipe_freetype->library = NULL;
     upipe_freetype->cache_manager = NULL;
     upipe_freetype->face = NULL;
@@ -460,289 +563,528 @@ static int upipe_freetype_throw_new_text(struct upipe *upipe, const char *text)
                        UPIPE_FREETYPE_SIGNATURE, text);
 }
 
-/** @internal @This tries to output input buffers.
+/** @internal @This returns a rendered glyph from the atlas, rendering it
+ * if needed.
  *
  * @param upipe description structure of the pipe
- * @param uref input buffer to output
- * @param upump_p reference to pump that generated the buffer
- * @return true if the buffer was output
+ * @param index glyph index
+ * @return pointer to the rendered glyph, or NULL in case of error
  */
-static bool upipe_freetype_handle(struct upipe *upipe, struct uref *uref,
-                                  struct upump **upump_p)
+static const struct upipe_freetype_glyph *
+    upipe_freetype_get_glyph(struct upipe *upipe, FT_UInt index)
 {
     struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
-    int ret;
+    struct uchain *bucket = &upipe_freetype->atlas[index % ATLAS_BUCKETS];
+    struct uchain *uchain;
+    ulist_foreach (bucket, uchain) {
+        struct upipe_freetype_glyph *glyph =
+            upipe_freetype_glyph_from_uchain(uchain);
+        if (glyph->index == index)
+            return glyph;
+    }
 
-    if (!upipe_freetype->ubuf_mgr)
-        return false;
+    FT_Glyph ft_glyph = NULL;
+    FTC_ImageTypeRec type;
+    type.face_id = upipe_freetype->font;
+    type.width = upipe_freetype->pixel_size;
+    type.height = upipe_freetype->pixel_size;
+    type.flags = FT_LOAD_DEFAULT;
+    FTC_SBit sbit;
+    if (FTC_SBitCache_Lookup(upipe_freetype->sbit_cache,
+                             &type, index, &sbit, NULL))
+        return NULL;
 
-    if (unlikely(!upipe_freetype->face)) {
-        upipe_warn(upipe, "no font set");
-        uref_free(uref);
-        return true;
+    int left, top, width, height, pitch, xadvance, yadvance;
+    const unsigned char *buffer;
+    if (!sbit->buffer) {
+        if (FTC_ImageCache_Lookup(upipe_freetype->img_cache,
+                                  &type, index, &ft_glyph, NULL))
+            return NULL;
+
+        if (FT_Glyph_To_Bitmap(&ft_glyph, FT_RENDER_MODE_NORMAL, 0, 0))
+            return NULL;
+
+        FT_BitmapGlyph slot = (FT_BitmapGlyph)ft_glyph;
+        left = slot->left;
+        top = slot->top;
+        width = slot->bitmap.width;
+        height = slot->bitmap.rows;
+        pitch = slot->bitmap.pitch;
+        xadvance = ft_glyph->advance.x;
+        yadvance = ft_glyph->advance.y;
+        buffer = slot->bitmap.buffer;
     }
-
-    const char *text;
-    int r = uref_void_get_text(uref, &text);
-    if (!ubase_check(r) || !text) {
-        uref_dump(uref, upipe->uprobe);
-        text = "fail";
+    else {
+        left = sbit->left;
+        top = sbit->top;
+        width = sbit->width;
+        height = sbit->height;
+        pitch = sbit->pitch;
+        /* scale to 16.16 */
+        xadvance = sbit->xadvance << 16;
+        yadvance = sbit->yadvance << 16;
+        buffer = sbit->buffer;
     }
 
-    if (upipe_freetype->text && !strcmp(upipe_freetype->text, text)) {
-        /* cache hit */
-        uref_attach_ubuf(uref, ubuf_dup(upipe_freetype->ubuf));
-        upipe_freetype_output(upipe, uref, upump_p);
-        return true;
+    struct upipe_freetype_glyph *glyph =
+        malloc(sizeof(struct upipe_freetype_glyph) + width * height);
+    if (unlikely(glyph == NULL)) {
+        FT_Done_Glyph(ft_glyph);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
     }
+    glyph->index = index;
+    glyph->left = left;
+    glyph->top = top;
+    glyph->width = width;
+    glyph->height = height;
+    glyph->xadvance = xadvance;
+    glyph->yadvance = yadvance;
+    for (int j = 0; j < height; j++)
+        memcpy(glyph->buffer + j * width, buffer + j * pitch, width);
+    FT_Done_Glyph(ft_glyph);
+
+    ulist_add(bucket, upipe_freetype_glyph_to_uchain(glyph));
+    return glyph;
+}
 
-    if (unlikely(!ubase_check(upipe_freetype_throw_new_text(upipe, text))))
-        upipe_warn(upipe, "fail to send probe");
+/** @internal @This places the glyphs of a text.
+ *
+ * @param upipe description structure of the pipe
+ * @param text text to lay out
+ * @param size_p filled in with the number of placed glyphs
+ * @return an allocated array of placed glyphs, or NULL in case of error
+ */
+static struct upipe_freetype_pos *upipe_freetype_layout(struct upipe *upipe,
+                                                        const char *text,
+                                                        size_t *size_p)
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
+    struct upipe_freetype_pos *layout =
+        malloc(sizeof(struct upipe_freetype_pos) * (strlen(text) + 1));
+    if (unlikely(layout == NULL))
+        return NULL;
 
-    uint64_t hsize = upipe_freetype->hsize;
-    uint64_t vsize = upipe_freetype->vsize;
-    struct ubuf *ubuf = ubuf_pic_alloc(upipe_freetype->ubuf_mgr, hsize, vsize);
-    if (!ubuf) {
-        upipe_err(upipe, "Could not allocate pic");
-        uref_free(uref);
-        return true;
+    FT_Bool use_kerning = FT_HAS_KERNING(upipe_freetype->face);
+    FT_UInt previous = 0;
+    /* scale offset to 16.16 */
+    int64_t xoff = upipe_freetype->xoff << 16;
+    int64_t yoff = upipe_freetype->yoff << 16;
+    size_t size = 0;
+
+    for (size_t i = 0; text[i] != '\0';) {
+        size_t char_size = 0;
+        uint32_t c = unicode_character(&text[i], &char_size);
+        if (char_size == 0)
+            break;
+
+        i += char_size;
+
+        FT_UInt index = FTC_CMapCache_Lookup(upipe_freetype->cmap_cache,
+                                             upipe_freetype->font, -1, c);
+
+        if (use_kerning && previous) {
+            FT_Vector delta;
+            FT_Get_Kerning(upipe_freetype->face, previous, index,
+                           FT_KERNING_DEFAULT, &delta);
+            /* delta is 26.6, scale to 16.16 */
+            xoff += delta.x << 10;
+        }
+
+        const struct upipe_freetype_glyph *glyph =
+            upipe_freetype_get_glyph(upipe, index);
+        if (glyph == NULL)
+            continue;
+
+        layout[size].glyph = glyph;
+        layout[size].x = (xoff >> 16) + glyph->left;
+        layout[size].y = (yoff >> 16) - glyph->top;
+        size++;
+
+        /* increment pen position */
+        xoff += glyph->xadvance;
+        yoff += glyph->yadvance;
+
+        previous = index;
     }
 
-    size_t width, height;
-    uint8_t macropixel;
-    ret = ubuf_pic_size(ubuf, &width, &height, &macropixel);
-    if (unlikely(!ubase_check(ret))) {
-        upipe_err(upipe, "fail to get pic buffer size");
-        ubuf_free(ubuf);
-        uref_free(uref);
-        return true;
+    *size_p = size;
+    return layout;
+}
+
+/** @internal @This extends a rectangle to include the bitmap of a placed
+ * glyph.
+ *
+ * @param pos placed glyph
+ * @param rect rectangle (x0, y0, x1, y1) to extend
+ */
+static void upipe_freetype_extend_rect(const struct upipe_freetype_pos *pos,
+                                       int rect[4])
+{
+    if (pos->x < rect[0])
+        rect[0] = pos->x;
+    if (pos->y < rect[1])
+        rect[1] = pos->y;
+    if (pos->x + pos->glyph->width > rect[2])
+        rect[2] = pos->x + pos->glyph->width;
+    if (pos->y + pos->glyph->height > rect[3])
+        rect[3] = pos->y + pos->glyph->height;
+}
+
+/** @internal @This blends a row of pixels with a constant value.
+ *
+ * @param dst row to blend
+ * @param alpha opacity of each pixel
+ * @param n number of pixels
+ * @param val value to blend
+ */
+static void upipe_freetype_blend_row(uint8_t *dst, const uint8_t *alpha,
+                                     int n, uint8_t val)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    /* x / 255 == (x + 1 + (x >> 8)) >> 8 for x <= 255 * 255 */
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ff = _mm_set1_epi16(0xff);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i v = _mm_set1_epi16(val);
+    for ( ; i + 16 <= n; i += 16) {
+        __m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i a = _mm_loadu_si128((const __m128i *)(alpha + i));
+        __m128i res[2];
+        for (int k = 0; k < 2; k++) {
+            __m128i d16 = k ? _mm_unpackhi_epi8(d, zero) :
+                              _mm_unpacklo_epi8(d, zero);
+            __m128i a16 = k ? _mm_unpackhi_epi8(a, zero) :
+                              _mm_unpacklo_epi8(a, zero);
+            __m128i x = _mm_add_epi16(
+                _mm_mullo_epi16(d16, _mm_sub_epi16(ff, a16)),
+                _mm_mullo_epi16(v, a16));
+            x = _mm_add_epi16(x, _mm_add_epi16(one, _mm_srli_epi16(x, 8)));
+            res[k] = _mm_srli_epi16(x, 8);
+        }
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_packus_epi16(res[0], res[1]));
     }
+#endif
+    for ( ; i < n; i++)
+        dst[i] = (dst[i] * (0xff - alpha[i]) + val * alpha[i]) / 0xff;
+}
 
-    struct plane {
-        size_t stride;
-        uint8_t hsub;
-        uint8_t vsub;
-        uint8_t macropixel_size;
-        size_t memset_width;
-        uint8_t *p;
+/** @internal @This blends the part of a placed glyph inside a rectangle.
+ *
+ * @param upipe description structure of the pipe
+ * @param planes mapped planes
+ * @param pos placed glyph
+ * @param rect rectangle (x0, y0, x1, y1) to draw
+ */
+static void upipe_freetype_blend(struct upipe *upipe,
+                                 struct upipe_freetype_plane *planes,
+                                 const struct upipe_freetype_pos *pos,
+                                 const int rect[4])
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
+    const struct upipe_freetype_glyph *glyph = pos->glyph;
+    int i0 = rect[0] > pos->x ? rect[0] - pos->x : 0;
+    int i1 = rect[2] - pos->x < glyph->width ? rect[2] - pos->x :
+                                               glyph->width;
+    int j0 = rect[1] > pos->y ? rect[1] - pos->y : 0;
+    int j1 = rect[3] - pos->y < glyph->height ? rect[3] - pos->y :
+                                                glyph->height;
+    if (i0 >= i1 || j0 >= j1)
+        return;
+
+    static const uint8_t opaque = 0xff;
+    const uint8_t values[PLANE_UV] = {
+        upipe_freetype->foreground[0], upipe_freetype->foreground[1],
+        upipe_freetype->foreground[2], opaque
     };
-    struct plane y;
-    struct plane u;
-    struct plane v;
-    struct plane a;
-    struct plane uv;
-
-    memset(&y, 0, sizeof (y));
-    memset(&u, 0, sizeof (u));
-    memset(&v, 0, sizeof (v));
-    memset(&a, 0, sizeof (a));
-    memset(&uv, 0, sizeof (uv));
+    uint8_t px[i1 - i0];
+
+    for (int j = j0; j < j1; j++) {
+        const uint8_t *buffer = glyph->buffer + j * glyph->width;
+        for (int i = i0; i < i1; i++)
+            px[i - i0] = buffer[i] * upipe_freetype->foreground[3] / 0xff;
+
+        int x = pos->x + i0;
+        int y = pos->y + j;
+        for (int k = 0; k < PLANE_UV; k++) {
+            struct upipe_freetype_plane *plane = &planes[k];
+            if (!plane->p)
+                continue;
+            uint8_t *row = plane->p + y / plane->vsub * plane->stride;
+            if (plane->hsub == 1) {
+                upipe_freetype_blend_row(row + x, px, i1 - i0, values[k]);
+                continue;
+            }
+            for (int i = 0; i < i1 - i0; i++) {
+                uint8_t *p = row + (x + i) / plane->hsub;
+                *p = (*p * (0xff - px[i]) + values[k] * px[i]) / 0xff;
+            }
+        }
+
+        struct upipe_freetype_plane *uv = &planes[PLANE_UV];
+        if (uv->p) {
+            uint8_t *row = uv->p + y / uv->vsub * uv->stride;
+            int fg_1 = upipe_freetype->foreground[1];
+            int fg_2 = upipe_freetype->foreground[2];
+            for (int i = 0; i < i1 - i0; i++) {
+                uint8_t *p = row + (x + i) / uv->hsub * uv->macropixel_size;
+                p[0] = (p[0] * (0xff - px[i]) + fg_1 * px[i]) / 0xff;
+                p[1] = (p[1] * (0xff - px[i]) + fg_2 * px[i]) / 0xff;
+            }
+        }
+    }
+}
+
+/** @internal @This maps the planes of a buffer for writing.
+ *
+ * @param upipe description structure of the pipe
+ * @param ubuf buffer to map
+ * @param planes filled in with the mapped planes
+ * @return an error code, UBASE_ERR_BUSY if the buffer is shared
+ */
+static int upipe_freetype_map_planes(struct upipe *upipe, struct ubuf *ubuf,
+                                     struct upipe_freetype_plane *planes)
+{
+    memset(planes, 0, sizeof (struct upipe_freetype_plane) * PLANE_NB);
 
     const char *chroma;
     ubuf_pic_foreach_plane(ubuf, chroma) {
-        struct plane *plane = NULL;
-
-        if (!strcmp(chroma, "y8")) {
-            plane = &y;
-        } else if (!strcmp(chroma, "u8")) {
-            plane = &u;
-        } else if (!strcmp(chroma, "v8")) {
-            plane = &v;
-        } else if (!strcmp(chroma, "a8")) {
-            plane = &a;
-        } else if (!strcmp(chroma, "u8v8")) {
-            plane = &uv;
-        } else {
+        int k;
+        for (k = 0; k < PLANE_NB; k++)
+            if (!strcmp(chroma, upipe_freetype_chromas[k]))
+                break;
+        if (k == PLANE_NB) {
             upipe_warn_va(upipe, "unsupported plane %s", chroma);
             continue;
         }
 
-        ret = ubuf_pic_plane_size(ubuf, chroma, &plane->stride,
-                                  &plane->hsub, &plane->vsub,
-                                  &plane->macropixel_size);
+        struct upipe_freetype_plane *plane = &planes[k];
+        int ret = ubuf_pic_plane_size(ubuf, chroma, &plane->stride,
+                                      &plane->hsub, &plane->vsub,
+                                      &plane->macropixel_size);
         if (unlikely(!ubase_check(ret))) {
             upipe_warn_va(upipe, "fail to get plane %s size", chroma);
             continue;
         }
-        plane->memset_width = width * plane->macropixel_size /
-            plane->hsub / macropixel;
 
         ret = ubuf_pic_plane_write(ubuf, chroma, 0, 0, -1, -1, &plane->p);
+        if (unlikely(ret == UBASE_ERR_BUSY)) {
+            plane->p = NULL;
+            for (k = 0; k < PLANE_NB; k++)
+                if (planes[k].p)
+                    ubuf_pic_plane_unmap(ubuf, planes[k].chroma,
+                                         0, 0, -1, -1);
+            return ret;
+        }
         if (unlikely(!ubase_check(ret))) {
             upipe_warn_va(upipe, "fail to map %s plane", chroma);
             plane->p = NULL;
             continue;
         }
+        plane->chroma = upipe_freetype_chromas[k];
     }
+    return UBASE_ERR_NONE;
+}
 
-    if (y.p) {
-        uint8_t *buf = y.p;
-        for (size_t i = 0; i < height / y.vsub; i++) {
-            memset(buf, upipe_freetype->background[0], y.memset_width);
-            buf += y.stride;
-        }
-    }
+/** @internal @This maps the planes of the cached buffer for writing,
+ * copying it if it is still used downstream, or allocating it.
+ *
+ * @param upipe description structure of the pipe
+ * @param planes filled in with the mapped planes
+ * @param redraw set to true if the buffer was allocated
+ * @return an error code
+ */
+static int upipe_freetype_map(struct upipe *upipe,
+                              struct upipe_freetype_plane *planes,
+                              bool *redraw)
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
 
-    if (u.p) {
-        uint8_t *buf = u.p;
-        for (size_t i = 0; i < height / u.vsub; i++) {
-            memset(buf, upipe_freetype->background[1], u.memset_width);
-            buf += u.stride;
-        }
-    }
+    if (upipe_freetype->ubuf != NULL) {
+        int err = upipe_freetype_map_planes(upipe, upipe_freetype->ubuf,
+                                            planes);
+        if (err != UBASE_ERR_BUSY)
+            return err;
 
-    if (v.p) {
-        uint8_t *buf = v.p;
-        for (size_t i = 0; i < height / v.vsub; i++) {
-            memset(buf, upipe_freetype->background[2], v.memset_width);
-            buf += v.stride;
-        }
+        /* still used downstream */
+        struct ubuf *ubuf = ubuf_pic_copy(upipe_freetype->ubuf_mgr,
+                                          upipe_freetype->ubuf,
+                                          0, 0, -1, -1);
+        ubuf_free(upipe_freetype->ubuf);
+        upipe_freetype->ubuf = ubuf;
+        if (likely(ubuf != NULL))
+            return upipe_freetype_map_planes(upipe, ubuf, planes);
     }
 
-    if (a.p) {
-        uint8_t *buf = a.p;
-        for (size_t i = 0; i < height / a.vsub; i++) {
-            memset(buf, upipe_freetype->background[3], a.memset_width);
-            buf += a.stride;
+    upipe_freetype->ubuf = ubuf_pic_alloc(upipe_freetype->ubuf_mgr,
+                                          upipe_freetype->hsize,
+                                          upipe_freetype->vsize);
+    UBASE_ALLOC_RETURN(upipe_freetype->ubuf);
+    *redraw = true;
+    return upipe_freetype_map_planes(upipe, upipe_freetype->ubuf, planes);
+}
+
+/** @internal @This fills a rectangle with the background color.
+ *
+ * @param upipe description structure of the pipe
+ * @param planes mapped planes
+ * @param rect rectangle (x0, y0, x1, y1) to fill, aligned on the
+ * subsampling
+ */
+static void upipe_freetype_clear(struct upipe *upipe,
+                                 struct upipe_freetype_plane *planes,
+                                 const int rect[4])
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
+
+    for (int k = 0; k < PLANE_UV; k++) {
+        struct upipe_freetype_plane *plane = &planes[k];
+        if (!plane->p)
+            continue;
+        uint8_t *buf = plane->p + rect[1] / plane->vsub * plane->stride +
+            rect[0] / plane->hsub * plane->macropixel_size;
+        size_t width = (rect[2] - rect[0]) / plane->hsub *
+            plane->macropixel_size;
+        for (int i = rect[1] / plane->vsub; i < rect[3] / plane->vsub; i++) {
+            memset(buf, upipe_freetype->background[k], width);
+            buf += plane->stride;
         }
     }
 
-    if (uv.p) {
-        uint8_t *buf = uv.p;
-        for (size_t i = 0; i < height / uv.vsub; i++) {
-            for (int j = 0; j < uv.memset_width; j += 2) {
+    struct upipe_freetype_plane *uv = &planes[PLANE_UV];
+    if (uv->p) {
+        uint8_t *buf = uv->p + rect[1] / uv->vsub * uv->stride +
+            rect[0] / uv->hsub * uv->macropixel_size;
+        size_t width = (rect[2] - rect[0]) / uv->hsub * uv->macropixel_size;
+        for (int i = rect[1] / uv->vsub; i < rect[3] / uv->vsub; i++) {
+            for (int j = 0; j < width; j += 2) {
                 buf[j] = upipe_freetype->background[1];
                 buf[j + 1] = upipe_freetype->background[2];
             }
-            buf += uv.stride;
+            buf += uv->stride;
         }
     }
+}
 
-    FT_Bool use_kerning = FT_HAS_KERNING(upipe_freetype->face);
-    FT_UInt previous = 0;
-    /* scale offset to 16.16 */
-    int64_t xoff = upipe_freetype->xoff << 16;
-    int64_t yoff = upipe_freetype->yoff << 16;
+/** @internal @This tries to output input buffers.
+ *
+ * The cached buffer is kept from one text to the next, and only the area
+ * covered by the glyphs that changed is redrawn, with glyphs rendered
+ * once in the atlas.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref input buffer to output
+ * @param upump_p reference to pump that generated the buffer
+ * @return true if the buffer was output
+ */
+static bool upipe_freetype_handle(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_freetype *upipe_freetype = upipe_freetype_from_upipe(upipe);
 
-    for (size_t i = 0; text[i] != '\0';) {
-        size_t char_size = 0;
-        uint32_t c = unicode_character(&text[i], &char_size);
-        if (char_size == 0)
-            break;
+    if (!upipe_freetype->ubuf_mgr)
+        return false;
 
-        i += char_size;
+    if (unlikely(!upipe_freetype->face)) {
+        upipe_warn(upipe, "no font set");
+        uref_free(uref);
+        return true;
+    }
 
-        FT_UInt index = FTC_CMapCache_Lookup(upipe_freetype->cmap_cache,
-                                             upipe_freetype->font, -1, c);
+    const char *text;
+    int r = uref_void_get_text(uref, &text);
+    if (!ubase_check(r) || !text) {
+        uref_dump(uref, upipe->uprobe);
+        text = "fail";
+    }
 
-        if (use_kerning && previous) {
-            FT_Vector delta;
-            FT_Get_Kerning(upipe_freetype->face, previous, index,
-                           FT_KERNING_DEFAULT, &delta);
-            /* delta is 26.6, scale to 16.16 */
-            xoff += delta.x << 10;
-        }
-        FT_Glyph glyph = NULL;
-        FTC_ImageTypeRec type;
-        type.face_id = upipe_freetype->font;
-        type.width = upipe_freetype->pixel_size;
-        type.height = upipe_freetype->pixel_size;
-        type.flags = FT_LOAD_DEFAULT;
-        FTC_SBit sbit;
-        if (FTC_SBitCache_Lookup(upipe_freetype->sbit_cache,
-                                 &type, index, &sbit, NULL))
-            continue;
+    if (upipe_freetype->text && !strcmp(upipe_freetype->text, text)) {
+        /* cache hit */
+        uref_attach_ubuf(uref, ubuf_dup(upipe_freetype->ubuf));
+        upipe_freetype_output(upipe, uref, upump_p);
+        return true;
+    }
 
-        int left, top, width, height, xadvance, yadvance;
-        unsigned char *buffer;
-        if (!sbit->buffer) {
-            if (FTC_ImageCache_Lookup(upipe_freetype->img_cache,
-                                      &type, index, &glyph, NULL))
-                continue;
+    if (unlikely(!ubase_check(upipe_freetype_throw_new_text(upipe, text))))
+        upipe_warn(upipe, "fail to send probe");
 
-            if (FT_Glyph_To_Bitmap(&glyph, FT_RENDER_MODE_NORMAL, 0, 0))
-                continue;
+    char *new_text = strdup(text);
+    size_t layout_size;
+    struct upipe_freetype_pos *layout =
+        upipe_freetype_layout(upipe, text, &layout_size);
+    if (unlikely(new_text == NULL || layout == NULL)) {
+        free(new_text);
+        free(layout);
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return true;
+    }
 
-            FT_BitmapGlyph slot = (FT_BitmapGlyph)glyph;
-            left = slot->left;
-            top = slot->top;
-            width = slot->bitmap.width;
-            height = slot->bitmap.rows;
-            xadvance = glyph->advance.x;
-            yadvance = glyph->advance.y;
-            buffer = slot->bitmap.buffer;
-        }
-        else {
-            left = sbit->left;
-            top = sbit->top;
-            width = sbit->width;
-            height = sbit->height;
-            /* scale to 16.16 */
-            xadvance = sbit->xadvance << 16;
-            yadvance = sbit->yadvance << 16;
-            buffer = sbit->buffer;
-        }
-        FT_Int xpos = (xoff >> 16) + left;
-        FT_Int ypos = (yoff >> 16) - top;
+    int hsize = upipe_freetype->hsize;
+    int vsize = upipe_freetype->vsize;
+    bool redraw = upipe_freetype->ubuf == NULL || upipe_freetype->text == NULL;
+    struct upipe_freetype_plane planes[PLANE_NB];
+    if (unlikely(!ubase_check(upipe_freetype_map(upipe, planes, &redraw)))) {
+        upipe_err(upipe, "Could not allocate pic");
+        free(new_text);
+        free(layout);
+        uref_free(uref);
+        return true;
+    }
 
-        for (FT_Int i = 0; i < width; i++) {
-            if (xpos + i < 0 || xpos + i >= hsize)
+    /* find the area covered by the glyphs that changed */
+    int rect[4] = { hsize, vsize, 0, 0 };
+    if (redraw) {
+        rect[0] = rect[1] = 0;
+        rect[2] = hsize;
+        rect[3] = vsize;
+    } else {
+        size_t old_size = upipe_freetype->layout_size;
+        const struct upipe_freetype_pos *old = upipe_freetype->layout;
+        for (size_t i = 0; i < old_size || i < layout_size; i++) {
+            if (i < old_size && i < layout_size &&
+                old[i].glyph == layout[i].glyph &&
+                old[i].x == layout[i].x && old[i].y == layout[i].y)
                 continue;
-
-            for (FT_Int j = 0; j < height; j++) {
-                if (ypos + j < 0 || ypos + j >= vsize)
-                    continue;
-
-                uint8_t px = buffer[j * width + i] * upipe_freetype->foreground[3] / 0xff;
-
-#define DO_PLANE(Plane, Val)                                                \
-                if (Plane.p) {                                              \
-                    FT_Int p_y = (ypos + j) / Plane.vsub * Plane.stride;    \
-                    FT_Int p_x = (xpos + i) / Plane.hsub;                   \
-                    FT_Int p = p_y + p_x;                                   \
-                    Plane.p[p] = (Plane.p[p] * (0xff - px) + Val * px) / 0xff; \
-                }
-
-                DO_PLANE(y, upipe_freetype->foreground[0]);
-                DO_PLANE(u, upipe_freetype->foreground[1]);
-                DO_PLANE(v, upipe_freetype->foreground[2]);
-                DO_PLANE(a, 0xff);
-
-                if (uv.p) {
-                    FT_Int p_y = (ypos + j) / uv.vsub * uv.stride;
-                    FT_Int p_x = (xpos + i) / uv.hsub * uv.macropixel_size;
-                    FT_Int p = p_y + p_x;
-                    int fg_1 = upipe_freetype->foreground[1];
-                    int fg_2 = upipe_freetype->foreground[2];
-                    uv.p[p] = (uv.p[p] * (0xff - px) + fg_1 * px) / 0xff;
-                    uv.p[p + 1] = (uv.p[p + 1] * (0xff - px) + fg_2 * px) / 0xff;
-                }
-            }
+            if (i < old_size)
+                upipe_freetype_extend_rect(&old[i], rect);
+            if (i < layout_size)
+                upipe_freetype_extend_rect(&layout[i], rect);
         }
 
-        /* increment pen position */
-        xoff += xadvance;
-        yoff += yadvance;
-
-        previous = index;
+        /* align on the chroma subsampling */
+        rect[0] &= ~1;
+        rect[1] &= ~1;
+        rect[2] = (rect[2] + 1) & ~1;
+        rect[3] = (rect[3] + 1) & ~1;
+        if (rect[0] < 0)
+            rect[0] = 0;
+        if (rect[1] < 0)
+            rect[1] = 0;
+        if (rect[2] > hsize)
+            rect[2] = hsize;
+        if (rect[3] > vsize)
+            rect[3] = vsize;
+    }
 
-        FT_Done_Glyph(glyph);
+    if (rect[0] < rect[2] && rect[1] < rect[3]) {
+        upipe_freetype_clear(upipe, planes, rect);
+        for (size_t i = 0; i < layout_size; i++)
+            upipe_freetype_blend(upipe, planes, &layout[i], rect);
     }
 
-    if (y.p)
-        ubuf_pic_plane_unmap(ubuf, "y8", 0, 0, -1, -1);
-    if (u.p)
-        ubuf_pic_plane_unmap(ubuf, "u8", 0, 0, -1, -1);
-    if (v.p)
-        ubuf_pic_plane_unmap(ubuf, "v8", 0, 0, -1, -1);
-    if (a.p)
-        ubuf_pic_plane_unmap(ubuf, "a8", 0, 0, -1, -1);
-    if (uv.p)
-        ubuf_pic_plane_unmap(ubuf, "u8v8", 0, 0, -1, -1);
+    for (int k = 0; k < PLANE_NB; k++)
+        if (planes[k].p)
+            ubuf_pic_plane_unmap(upipe_freetype->ubuf, planes[k].chroma,
+                                 0, 0, -1, -1);
 
-    upipe_freetype_flush_cache(upipe);
-    upipe_freetype->ubuf = ubuf;
-    upipe_freetype->text = strdup(text);
+    free(upipe_freetype->text);
+    upipe_freetype->text = new_text;
+    free(upipe_freetype->layout);
+    upipe_freetype->layout = layout;
+    upipe_freetype->layout_size = layout_size;
     uref_attach_ubuf(uref, ubuf_dup(upipe_freetype->ubuf));
     upipe_freetype_output(upipe, uref, upump_p);
     return true;
@@ -839,7 +1181,7 @@ static int upipe_freetype_set_option(struct upipe *upipe,
             upipe_freetype->face = NULL;
             return UBASE_ERR_EXTERNAL;
         }
-        upipe_freetype_flush_cache(upipe);
+        upipe_freetype_flush_atlas(upipe);
         return UBASE_ERR_NONE;
     }
     else if (!strcmp(option, "foreground-color")) {
@@ -926,7 +1268,7 @@ static int _upipe_freetype_set_pixel_size(struct upipe *upipe,
         upipe_err(upipe, "fail to get size");
         return UBASE_ERR_EXTERNAL;
     }
-    upipe_freetype_flush_cache(upipe);
+    upipe_freetype_flush_atlas(upipe);
     return UBASE_ERR_NONE;
 }
 
@@ -0,0 +1,661 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe GL mosaic module - composes several pictures on the GPU
+ */
+
+#define GL_GLEXT_PROTOTYPES
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uref.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_dump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_subpipe.h"
+#include "upipe-gl/upipe_gl_mosaic.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <GL/gl.h>
+#include <GL/glext.h>
+
+/** @internal @This is the private context of a mosaic pipe. */
+struct upipe_gl_mosaic {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** list of input subpipes */
+    struct uchain subs;
+    /** manager to create input subpipes */
+    struct upipe_mgr sub_mgr;
+
+    /** GL names of freed inputs, to delete in the GL context */
+    GLuint *garbage;
+    /** number of GL names to delete */
+    unsigned int nb_garbage;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_gl_mosaic, upipe, UPIPE_GL_MOSAIC_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_gl_mosaic, urefcount, upipe_gl_mosaic_free)
+UPIPE_HELPER_VOID(upipe_gl_mosaic)
+UPIPE_HELPER_OUTPUT(upipe_gl_mosaic, output, flow_def, output_state,
+                    request_list)
+
+/** @hidden */
+static void upipe_gl_mosaic_sort(struct upipe *upipe);
+
+/** @internal @This is the private context of an input of a mosaic pipe. */
+struct upipe_gl_mosaic_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** horizontal position of the left border */
+    double x;
+    /** vertical position of the top border */
+    double y;
+    /** width */
+    double width;
+    /** height */
+    double height;
+    /** alpha multiplier */
+    uint8_t alpha;
+    /** z-index */
+    int z_index;
+
+    /** latest picture not uploaded yet */
+    struct uref *uref;
+    /** GL texture, or 0 */
+    GLuint texture;
+    /** GL pixel buffer object used to upload pictures, or 0 */
+    GLuint pbo;
+    /** width of the texture */
+    size_t texture_width;
+    /** height of the texture */
+    size_t texture_height;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_gl_mosaic_sub, upipe, UPIPE_GL_MOSAIC_SUB_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_gl_mosaic_sub, urefcount, upipe_gl_mosaic_sub_free)
+UPIPE_HELPER_VOID(upipe_gl_mosaic_sub)
+
+UPIPE_HELPER_SUBPIPE(upipe_gl_mosaic, upipe_gl_mosaic_sub, sub, sub_mgr, subs,
+                     uchain)
+
+/** @internal @This allocates an input subpipe of a mosaic pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_gl_mosaic_sub_alloc(struct upipe_mgr *mgr,
+                                               struct uprobe *uprobe,
+                                               uint32_t signature,
+                                               va_list args)
+{
+    struct upipe *upipe =
+        upipe_gl_mosaic_sub_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_gl_mosaic_sub *sub = upipe_gl_mosaic_sub_from_upipe(upipe);
+    upipe_gl_mosaic_sub_init_urefcount(upipe);
+    upipe_gl_mosaic_sub_init_sub(upipe);
+    sub->x = sub->y = 0;
+    sub->width = sub->height = 1;
+    sub->alpha = 0xff; /* opaque */
+    sub->z_index = 0;
+    sub->uref = NULL;
+    sub->texture = sub->pbo = 0;
+    sub->texture_width = sub->texture_height = 0;
+
+    upipe_throw_ready(upipe);
+
+    struct upipe_gl_mosaic *upipe_gl_mosaic =
+        upipe_gl_mosaic_from_sub_mgr(upipe->mgr);
+    upipe_gl_mosaic_sort(upipe_gl_mosaic_to_upipe(upipe_gl_mosaic));
+    return upipe;
+}
+
+/** @internal @This keeps the latest picture of an input, until the next
+ * rendering.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_gl_mosaic_sub_input(struct upipe *upipe, struct uref *uref,
+                                      struct upump **upump_p)
+{
+    struct upipe_gl_mosaic_sub *sub = upipe_gl_mosaic_sub_from_upipe(upipe);
+    if (sub->uref != NULL)
+        upipe_verbose(upipe, "dropping picture not rendered");
+    uref_free(sub->uref);
+    sub->uref = uref;
+}
+
+/** @internal @This sets the input flow definition of an input.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_gl_mosaic_sub_set_flow_def(struct upipe *upipe,
+                                            struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "pic."))
+
+    /* same formats as the GL sinks */
+    uint8_t macropixel;
+    if (!ubase_check(uref_pic_flow_get_macropixel(flow_def, &macropixel)) ||
+        macropixel != 1 ||
+        (!ubase_check(uref_pic_flow_check_chroma(flow_def, 1, 1, 2,
+                                                 "r5g6b5")) &&
+         !ubase_check(uref_pic_flow_check_chroma(flow_def, 1, 1, 3,
+                                                 "r8g8b8")))) {
+        upipe_err(upipe, "incompatible flow definition");
+        uref_dump(flow_def, upipe->uprobe);
+        return UBASE_ERR_INVALID;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This uploads the latest picture of an input to its texture.
+ * The picture is copied to an orphaned pixel buffer object, so that the
+ * transfer to the texture is done asynchronously by the GL implementation.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gl_mosaic_sub_upload(struct upipe *upipe)
+{
+    struct upipe_gl_mosaic_sub *sub = upipe_gl_mosaic_sub_from_upipe(upipe);
+    struct uref *uref = sub->uref;
+    sub->uref = NULL;
+
+    const char *chroma = "r8g8b8";
+    const uint8_t *data = NULL;
+    size_t width, height, stride;
+    uint8_t msize;
+    if (!ubase_check(uref_pic_size(uref, &width, &height, NULL)) ||
+        (!ubase_check(uref_pic_plane_size(uref, chroma, &stride,
+                                          NULL, NULL, &msize)) &&
+         !ubase_check(uref_pic_plane_size(uref, chroma = "r5g6b5", &stride,
+                                          NULL, NULL, &msize))) ||
+        !ubase_check(uref_pic_plane_read(uref, chroma, 0, 0, -1, -1,
+                                         &data))) {
+        upipe_warn(upipe, "unable to map picture");
+        uref_free(uref);
+        return;
+    }
+    bool rgb565 = msize == 2;
+
+    if (sub->texture == 0) {
+        glGenTextures(1, &sub->texture);
+        glBindTexture(GL_TEXTURE_2D, sub->texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glGenBuffers(1, &sub->pbo);
+    }
+
+    size_t line = width * msize;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, sub->pbo);
+    /* orphan the previous buffer instead of waiting for its transfer */
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, line * height, NULL, GL_STREAM_DRAW);
+    uint8_t *buffer = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if (likely(buffer != NULL)) {
+        for (size_t i = 0; i < height; i++)
+            memcpy(buffer + i * line, data + i * stride, line);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, rgb565 ? 2 : 1);
+        glBindTexture(GL_TEXTURE_2D, sub->texture);
+        GLenum type = rgb565 ? GL_UNSIGNED_SHORT_5_6_5 : GL_UNSIGNED_BYTE;
+        if (width != sub->texture_width || height != sub->texture_height) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB,
+                         type, NULL);
+            sub->texture_width = width;
+            sub->texture_height = height;
+        } else
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGB,
+                            type, NULL);
+    } else
+        upipe_warn(upipe, "unable to map pixel buffer");
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+    uref_free(uref);
+}
+
+/** @internal @This draws the texture of an input.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gl_mosaic_sub_draw(struct upipe *upipe)
+{
+    struct upipe_gl_mosaic_sub *sub = upipe_gl_mosaic_sub_from_upipe(upipe);
+    if (sub->texture_width == 0 || sub->texture_height == 0)
+        return;
+
+    glColor4f(1, 1, 1, sub->alpha / 255.f);
+    glBindTexture(GL_TEXTURE_2D, sub->texture);
+    glBegin(GL_QUADS);
+    {
+        glTexCoord2f(0, 0); glVertex2d(sub->x, sub->y);
+        glTexCoord2f(1, 0); glVertex2d(sub->x + sub->width, sub->y);
+        glTexCoord2f(1, 1); glVertex2d(sub->x + sub->width,
+                                       sub->y + sub->height);
+        glTexCoord2f(0, 1); glVertex2d(sub->x, sub->y + sub->height);
+    }
+    glEnd();
+}
+
+/** @internal @This gets the position of an input.
+ *
+ * @param upipe description structure of the pipe
+ * @param x_p filled in with the horizontal position of the left border
+ * @param y_p filled in with the vertical position of the top border
+ * @param width_p filled in with the width
+ * @param height_p filled in with the height
+ * @return an error code
+ */
+static int _upipe_gl_mosaic_sub_get_rect(struct upipe *upipe,
+        double *x_p, double *y_p, double *width_p, double *height_p)
+{
+    struct upipe_gl_mosaic_sub *sub = upipe_gl_mosaic_sub_from_upipe(upipe);
+    if (x_p != NULL)
+        *x_p = sub->x;
+    if (y_p != NULL)
+        *y_p = sub->y;
+    if (width_p != NULL)
+        *width_p = sub->width;
+    if (height_p != NULL)
+        *height_p = sub->height;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the position of an input.
+ *
+ * @param upipe description structure of the pipe
+ * @param x horizontal position of the left border
+ * @param y vertical position of the top border
+ * @param width width
+ * @param height height
+ * @return an error code
+ */
+static int _upipe_gl_mosaic_sub_set_rect(struct upipe *upipe,
+        double x, double y, double width, double height)
+{
+    struct upipe_gl_mosaic_sub *sub = upipe_gl_mosaic_sub_from_upipe(upipe);
+    if (width < 0 || height < 0)
+        return UBASE_ERR_INVALID;
+    sub->x = x;
+    sub->y = y;
+    sub->width = width;
+    sub->height = height;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on an input subpipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_gl_mosaic_sub_control(struct upipe *upipe,
+                                       int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_gl_mosaic_sub_control_super(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_gl_mosaic_sub_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_GL_MOSAIC_SUB_GET_RECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_MOSAIC_SUB_SIGNATURE)
+            double *x_p = va_arg(args, double *);
+            double *y_p = va_arg(args, double *);
+            double *width_p = va_arg(args, double *);
+            double *height_p = va_arg(args, double *);
+            return _upipe_gl_mosaic_sub_get_rect(upipe,
+                    x_p, y_p, width_p, height_p);
+        }
+        case UPIPE_GL_MOSAIC_SUB_SET_RECT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_MOSAIC_SUB_SIGNATURE)
+            double x = va_arg(args, double);
+            double y = va_arg(args, double);
+            double width = va_arg(args, double);
+            double height = va_arg(args, double);
+            return _upipe_gl_mosaic_sub_set_rect(upipe, x, y, width, height);
+        }
+        case UPIPE_GL_MOSAIC_SUB_SET_ALPHA: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_MOSAIC_SUB_SIGNATURE)
+            struct upipe_gl_mosaic_sub *sub =
+                upipe_gl_mosaic_sub_from_upipe(upipe);
+            sub->alpha = va_arg(args, unsigned);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_GL_MOSAIC_SUB_SET_Z_INDEX: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_MOSAIC_SUB_SIGNATURE)
+            struct upipe_gl_mosaic_sub *sub =
+                upipe_gl_mosaic_sub_from_upipe(upipe);
+            sub->z_index = va_arg(args, int);
+            struct upipe_gl_mosaic *upipe_gl_mosaic =
+                upipe_gl_mosaic_from_sub_mgr(upipe->mgr);
+            upipe_gl_mosaic_sort(upipe_gl_mosaic_to_upipe(upipe_gl_mosaic));
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This compares two subpipes wrt. ascending z-index.
+ *
+ * @param uchain1 pointer to first subpipe
+ * @param uchain2 pointer to second subpipe
+ * @return an integer less than, equal to, or greater than zero if the first
+ * argument is considered to be respectively less than, equal to, or greater
+ * than the second.
+ */
+static int upipe_gl_mosaic_sub_compare(struct uchain **uchain1,
+                                       struct uchain **uchain2)
+{
+    struct upipe_gl_mosaic_sub *sub1 =
+        upipe_gl_mosaic_sub_from_uchain(*uchain1);
+    struct upipe_gl_mosaic_sub *sub2 =
+        upipe_gl_mosaic_sub_from_uchain(*uchain2);
+    return sub1->z_index - sub2->z_index;
+}
+
+/** @This frees an input subpipe. Its GL objects are deleted upon the next
+ * rendering, since the GL context is not current here.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gl_mosaic_sub_free(struct upipe *upipe)
+{
+    struct upipe_gl_mosaic_sub *sub = upipe_gl_mosaic_sub_from_upipe(upipe);
+    struct upipe_gl_mosaic *upipe_gl_mosaic =
+        upipe_gl_mosaic_from_sub_mgr(upipe->mgr);
+    upipe_throw_dead(upipe);
+
+    if (sub->texture != 0) {
+        GLuint *garbage = realloc(upipe_gl_mosaic->garbage,
+                (upipe_gl_mosaic->nb_garbage + 2) * sizeof(GLuint));
+        if (likely(garbage != NULL)) {
+            garbage[upipe_gl_mosaic->nb_garbage++] = sub->texture;
+            garbage[upipe_gl_mosaic->nb_garbage++] = sub->pbo;
+            upipe_gl_mosaic->garbage = garbage;
+        }
+    }
+    uref_free(sub->uref);
+    upipe_gl_mosaic_sub_clean_sub(upipe);
+    upipe_gl_mosaic_sub_clean_urefcount(upipe);
+    upipe_gl_mosaic_sub_free_void(upipe);
+}
+
+/** @internal @This initializes the input manager for a mosaic pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gl_mosaic_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_gl_mosaic *upipe_gl_mosaic =
+        upipe_gl_mosaic_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_gl_mosaic->sub_mgr;
+    sub_mgr->refcount = upipe_gl_mosaic_to_urefcount(upipe_gl_mosaic);
+    sub_mgr->signature = UPIPE_GL_MOSAIC_SUB_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_gl_mosaic_sub_alloc;
+    sub_mgr->upipe_input = upipe_gl_mosaic_sub_input;
+    sub_mgr->upipe_control = upipe_gl_mosaic_sub_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a mosaic pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_gl_mosaic_alloc(struct upipe_mgr *mgr,
+                                           struct uprobe *uprobe,
+                                           uint32_t signature, va_list args)
+{
+    struct upipe *upipe =
+        upipe_gl_mosaic_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_gl_mosaic *upipe_gl_mosaic =
+        upipe_gl_mosaic_from_upipe(upipe);
+    upipe_gl_mosaic_init_urefcount(upipe);
+    upipe_gl_mosaic_init_output(upipe);
+    upipe_gl_mosaic_init_sub_subs(upipe);
+    upipe_gl_mosaic_init_sub_mgr(upipe);
+    upipe_gl_mosaic->garbage = NULL;
+    upipe_gl_mosaic->nb_garbage = 0;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This sorts subpipes according to z-index.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gl_mosaic_sort(struct upipe *upipe)
+{
+    struct upipe_gl_mosaic *upipe_gl_mosaic =
+        upipe_gl_mosaic_from_upipe(upipe);
+    ulist_sort(&upipe_gl_mosaic->subs, upipe_gl_mosaic_sub_compare);
+}
+
+/** @internal @This forwards the background picture to the sink.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_gl_mosaic_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    upipe_gl_mosaic_output(upipe, uref, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_gl_mosaic_set_flow_def(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, "pic."))
+    struct uref *flow_def_dup;
+    if ((flow_def_dup = uref_dup(flow_def)) == NULL)
+        return UBASE_ERR_ALLOC;
+    upipe_gl_mosaic_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This uploads the pending pictures and draws all inputs in
+ * the current GL context.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int _upipe_gl_mosaic_render(struct upipe *upipe)
+{
+    struct upipe_gl_mosaic *upipe_gl_mosaic =
+        upipe_gl_mosaic_from_upipe(upipe);
+
+    if (upipe_gl_mosaic->nb_garbage) {
+        for (unsigned int i = 0; i < upipe_gl_mosaic->nb_garbage; i += 2) {
+            glDeleteTextures(1, &upipe_gl_mosaic->garbage[i]);
+            glDeleteBuffers(1, &upipe_gl_mosaic->garbage[i + 1]);
+        }
+        free(upipe_gl_mosaic->garbage);
+        upipe_gl_mosaic->garbage = NULL;
+        upipe_gl_mosaic->nb_garbage = 0;
+    }
+
+    /* start all transfers before drawing anything */
+    struct uchain *uchain;
+    ulist_foreach (&upipe_gl_mosaic->subs, uchain) {
+        struct upipe_gl_mosaic_sub *sub =
+            upipe_gl_mosaic_sub_from_uchain(uchain);
+        if (sub->uref != NULL)
+            upipe_gl_mosaic_sub_upload(upipe_gl_mosaic_sub_to_upipe(sub));
+    }
+
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    ulist_foreach (&upipe_gl_mosaic->subs, uchain) {
+        struct upipe_gl_mosaic_sub *sub =
+            upipe_gl_mosaic_sub_from_uchain(uchain);
+        upipe_gl_mosaic_sub_draw(upipe_gl_mosaic_sub_to_upipe(sub));
+    }
+    glDisable(GL_BLEND);
+    glDisable(GL_TEXTURE_2D);
+    glColor4f(1, 1, 1, 1);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a mosaic pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_gl_mosaic_control(struct upipe *upipe,
+                                   int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_gl_mosaic_control_output(upipe, command, args));
+    UBASE_HANDLED_RETURN(upipe_gl_mosaic_control_subs(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_gl_mosaic_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_GL_MOSAIC_RENDER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_MOSAIC_SIGNATURE)
+            return _upipe_gl_mosaic_render(upipe);
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a mosaic pipe. GL objects of the freed inputs which were
+ * not deleted yet are released with the GL context.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gl_mosaic_free(struct upipe *upipe)
+{
+    struct upipe_gl_mosaic *upipe_gl_mosaic =
+        upipe_gl_mosaic_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    free(upipe_gl_mosaic->garbage);
+    upipe_gl_mosaic_clean_sub_subs(upipe);
+    upipe_gl_mosaic_clean_output(upipe);
+    upipe_gl_mosaic_clean_urefcount(upipe);
+    upipe_gl_mosaic_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_gl_mosaic_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_GL_MOSAIC_SIGNATURE,
+
+    .upipe_alloc = upipe_gl_mosaic_alloc,
+    .upipe_input = upipe_gl_mosaic_input,
+    .upipe_control = upipe_gl_mosaic_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all mosaic pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_gl_mosaic_mgr_alloc(void)
+{
+    return &upipe_gl_mosaic_mgr;
+}
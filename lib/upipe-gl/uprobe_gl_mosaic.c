@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe GL sink mosaic renderer
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_helper_uprobe.h"
+#include "upipe/uprobe_helper_alloc.h"
+#include "upipe/upipe.h"
+#include "upipe/uref_pic.h"
+#include "upipe-gl/upipe_gl_mosaic.h"
+#include "upipe-gl/uprobe_gl_mosaic.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+
+#include <GL/gl.h>
+
+/** @This is the private structure for gl mosaic renderer probe. */
+struct uprobe_gl_mosaic {
+    /** mosaic pipe (not referenced) */
+    struct upipe *mosaic;
+    /** background texture */
+    GLuint texture;
+
+    /** structure exported to modules */
+    struct uprobe uprobe;
+};
+
+UPROBE_HELPER_UPROBE(uprobe_gl_mosaic, uprobe);
+
+/** @internal @This reshapes the gl view upon receiving an Exposure event
+ * @param uprobe description structure of the probe
+ * @param upipe description structure of the pipe
+ * @param w window width
+ * @param h window height
+ */
+static void uprobe_gl_mosaic_reshape(struct uprobe *uprobe,
+                                     struct upipe *upipe,
+                                     int w, int h)
+{
+    glViewport(0, 0, w, h);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, 1, 1, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+/** @internal @This renders the background picture and the mosaic inputs
+ * @param uprobe description structure of the probe
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @return an error code
+ */
+static int uprobe_gl_mosaic_render(struct uprobe *uprobe,
+                                   struct upipe *upipe, struct uref *uref)
+{
+    struct uprobe_gl_mosaic *uprobe_gl_mosaic =
+        uprobe_gl_mosaic_from_uprobe(uprobe);
+
+    glClear(GL_COLOR_BUFFER_BIT);
+    glLoadIdentity();
+
+    if (upipe_gl_texture_load_uref(uref, uprobe_gl_mosaic->texture)) {
+        glEnable(GL_TEXTURE_2D);
+        glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+        glBindTexture(GL_TEXTURE_2D, uprobe_gl_mosaic->texture);
+        glBegin(GL_QUADS);
+        {
+            glTexCoord2f(0, 0); glVertex2f(0, 0);
+            glTexCoord2f(1, 0); glVertex2f(1, 0);
+            glTexCoord2f(1, 1); glVertex2f(1, 1);
+            glTexCoord2f(0, 1); glVertex2f(0, 1);
+        }
+        glEnd();
+        glDisable(GL_TEXTURE_2D);
+    }
+
+    int err = upipe_gl_mosaic_render(uprobe_gl_mosaic->mosaic);
+    if (!ubase_check(err))
+        return err;
+
+    return uprobe_throw(uprobe->next, upipe, UPROBE_GL_SINK_RENDER,
+                        UPIPE_GL_SINK_SIGNATURE, uref);
+}
+
+/** @internal @This does the gl (window-system non-specific) init
+ * @param uprobe description structure of the probe
+ * @param upipe description structure of the pipe
+ * @param w pic width
+ * @param h pic height
+ */
+static void uprobe_gl_mosaic_init2(struct uprobe *uprobe,
+                                   struct upipe *upipe,
+                                   int w, int h)
+{
+    struct uprobe_gl_mosaic *uprobe_gl_mosaic =
+        uprobe_gl_mosaic_from_uprobe(uprobe);
+
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glDisable(GL_DEPTH_TEST);
+
+    glGenTextures(1, &uprobe_gl_mosaic->texture);
+    glBindTexture(GL_TEXTURE_2D, uprobe_gl_mosaic->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+    uprobe_gl_mosaic_reshape(uprobe, upipe, w, h);
+}
+
+/** @internal @This catches events thrown by pipes.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param event event thrown
+ * @param args optional event-specific parameters
+ * @return an error code
+ */
+static int uprobe_gl_mosaic_throw(struct uprobe *uprobe,
+                                  struct upipe *upipe,
+                                  int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_GL_SINK_INIT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_SINK_SIGNATURE)
+            int w = va_arg(args, int);
+            int h = va_arg(args, int);
+            uprobe_gl_mosaic_init2(uprobe, upipe, w, h);
+            return UBASE_ERR_NONE;
+        }
+        case UPROBE_GL_SINK_RENDER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_SINK_SIGNATURE)
+            struct uref *uref = va_arg(args, struct uref *);
+            return uprobe_gl_mosaic_render(uprobe, upipe, uref);
+        }
+        case UPROBE_GL_SINK_RESHAPE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GL_SINK_SIGNATURE)
+            int w = va_arg(args, int);
+            int h = va_arg(args, int);
+            uprobe_gl_mosaic_reshape(uprobe, upipe, w, h);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return uprobe_throw_next(uprobe, upipe, event, args);
+    }
+}
+
+/** @internal @This initializes a new uprobe_gl_mosaic structure.
+ *
+ * @param uprobe_gl_mosaic pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param mosaic mosaic pipe to render
+ * @return pointer to uprobe, or NULL in case of error
+ */
+static struct uprobe *
+uprobe_gl_mosaic_init(struct uprobe_gl_mosaic *uprobe_gl_mosaic,
+                      struct uprobe *next, struct upipe *mosaic)
+{
+    assert(uprobe_gl_mosaic != NULL);
+    struct uprobe *uprobe = uprobe_gl_mosaic_to_uprobe(uprobe_gl_mosaic);
+
+    uprobe_gl_mosaic->mosaic = mosaic;
+    uprobe_gl_mosaic->texture = 0;
+
+    uprobe_init(uprobe, uprobe_gl_mosaic_throw, next);
+    return uprobe;
+}
+
+/** @internal @This cleans up a uprobe_gl_mosaic structure.
+ *
+ * @param uprobe_gl_mosaic structure to free
+ */
+static void uprobe_gl_mosaic_clean(struct uprobe_gl_mosaic *uprobe_gl_mosaic)
+{
+    glDeleteTextures(1, &uprobe_gl_mosaic->texture);
+    struct uprobe *uprobe = &uprobe_gl_mosaic->uprobe;
+    uprobe_clean(uprobe);
+}
+
+#define ARGS_DECL struct uprobe *next, struct upipe *mosaic
+#define ARGS next, mosaic
+UPROBE_HELPER_ALLOC(uprobe_gl_mosaic)
+#undef ARGS
+#undef ARGS_DECL
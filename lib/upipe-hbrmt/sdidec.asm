@@ -21,15 +21,15 @@
 
 %include "x86util.asm"
 
-SECTION_RODATA 32
+SECTION_RODATA 64
 
-sdi_comp_mask_10:  times 2 db 0xff, 0xc0, 0xf,  0xfc, 0x0,  0xff, 0xc0, 0xf,  0xfc, 0x0,  0x0, 0x0, 0x0, 0x0, 0x0, 0x0
+sdi_comp_mask_10:  times 4 db 0xff, 0xc0, 0xf,  0xfc, 0x0,  0xff, 0xc0, 0xf,  0xfc, 0x0,  0x0, 0x0, 0x0, 0x0, 0x0, 0x0
 
-sdi_chroma_shuf_10:  times 2 db  1,  0, -1, -1,  3,  2, -1, -1,  6,  5, -1, -1,  8,  7, -1, -1
-sdi_luma_shuf_10:    times 2 db -1, -1,  2,  1, -1, -1,  4,  3, -1, -1,  7,  6, -1, -1,  9,  8
+sdi_chroma_shuf_10:  times 4 db  1,  0, -1, -1,  3,  2, -1, -1,  6,  5, -1, -1,  8,  7, -1, -1
+sdi_luma_shuf_10:    times 4 db -1, -1,  2,  1, -1, -1,  4,  3, -1, -1,  7,  6, -1, -1,  9,  8
 
-sdi_chroma_mult_10:  times 4 dw 0x400, 0x0, 0x4000, 0x0
-sdi_luma_mult_10:    times 4 dw 0x0, 0x800, 0x0, 0x7fff
+sdi_chroma_mult_10:  times 8 dw 0x400, 0x0, 0x4000, 0x0
+sdi_luma_mult_10:    times 8 dw 0x0, 0x800, 0x0, 0x7fff
 
 SECTION .text
 
@@ -45,12 +45,18 @@ cglobal sdi_to_uyvy, 3, 3, 7, src, y, pixels
     mova     m4, [sdi_luma_shuf_10]
     mova     m5, [sdi_chroma_mult_10]
     mova     m6, [sdi_luma_mult_10]
+%if mmsize == 64
+    cmp pixelsq, -16
+    jg .tail
+%endif
 
 .loop:
     movu     xm0, [srcq]
-%if cpuflag(avx2)
-    vinserti128 m0, m0, [srcq + 10], 1
-%endif
+%assign i 1
+%rep mmsize/16 - 1
+    vinserti128 m0, m0, [srcq + 10*i], i
+%assign i i+1
+%endrep
 
     pandn    m1, m2, m0
     pand     m0, m2
@@ -67,7 +73,37 @@ cglobal sdi_to_uyvy, 3, 3, 7, src, y, pixels
 
     add    srcq, (mmsize*5)/8
     add pixelsq, mmsize/4
+%if mmsize == 64
+    cmp pixelsq, -16
+    jle .loop
+
+    ; remaining pixels, 4 at a time so as not to write further than the
+    ; narrower variants
+.tail:
+    test pixelsq, pixelsq
+    jge .end
+    movu     xm0, [srcq]
+
+    pandn    xm1, xm2, xm0
+    pand     xm0, xm2
+
+    pshufb   xm0, xm3
+    pshufb   xm1, xm4
+
+    pmulhuw  xm0, xm5
+    pmulhrsw xm1, xm6
+
+    por      xm0, xm1
+
+    movu     [yq + 4*pixelsq], xm0
+
+    add    srcq, 10
+    add pixelsq, 4
+    jl .tail
+.end:
+%else
     jl .loop
+%endif
 
     RET
 %endmacro
@@ -76,3 +112,5 @@ INIT_XMM ssse3
 sdi_to_uyvy
 INIT_YMM avx2
 sdi_to_uyvy
+INIT_ZMM avx512
+sdi_to_uyvy
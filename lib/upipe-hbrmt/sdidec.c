@@ -19,6 +19,10 @@
  */
 
 #include <stdint.h>
+
+#include "upipe/config.h"
+#include "upipe/ucpu.h"
+
 #include "sdidec.h"
 
 void upipe_sdi_to_uyvy_c(const uint8_t *src, uint16_t *y, uintptr_t pixels)
@@ -36,3 +40,19 @@ void upipe_sdi_to_uyvy_c(const uint8_t *src, uint16_t *y, uintptr_t pixels)
         y[i+3] = ((d & 0x03) << 8) | e;                 //4455555555
     }
 }
+
+/* implementations of the kernels, best first */
+static const struct ucpu_impl upipe_sdi_to_uyvy_impls[] = {
+#if defined(UPIPE_HAVE_X86ASM) && (defined(__i686__) || defined(__x86_64__))
+    UCPU_IMPL(upipe_sdi_to_uyvy, avx512, UCPU_AVX512),
+    UCPU_IMPL(upipe_sdi_to_uyvy, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_sdi_to_uyvy, ssse3, UCPU_SSSE3),
+#endif
+#ifdef UPIPE_HAVE_AARCH64ASM
+    UCPU_IMPL(upipe_sdi_to_uyvy, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(upipe_sdi_to_uyvy, c, 0),
+};
+
+struct ucpu_kernel upipe_sdi_to_uyvy_kernel =
+    UCPU_KERNEL_INIT("sdi_to_uyvy", upipe_sdi_to_uyvy_impls);
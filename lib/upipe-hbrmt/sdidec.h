@@ -1,3 +1,10 @@
 void upipe_sdi_to_uyvy_c    (const uint8_t *src, uint16_t *y, uintptr_t pixels);
 void upipe_sdi_to_uyvy_ssse3(const uint8_t *src, uint16_t *y, uintptr_t pixels);
 void upipe_sdi_to_uyvy_avx2 (const uint8_t *src, uint16_t *y, uintptr_t pixels);
+void upipe_sdi_to_uyvy_avx512(const uint8_t *src, uint16_t *y, uintptr_t pixels);
+void upipe_sdi_to_uyvy_neon (const uint8_t *src, uint16_t *y, uintptr_t pixels);
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of the kernels, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_sdi_to_uyvy_kernel;
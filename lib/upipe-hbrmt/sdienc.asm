@@ -21,11 +21,11 @@
 
 %include "x86util.asm"
 
-SECTION_RODATA 32
+SECTION_RODATA 64
 
-sdi_enc_mult_10: times 4 dw 64, 16, 4, 1
-sdi_chroma_shuf_10: times 2 db 1, 0, 5, 4, -1, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1
-sdi_luma_shuf_10: times 2 db -1, 3, 2, 7, 6, -1, 11, 10, 15, 14, -1, -1, -1, -1, -1, -1
+sdi_enc_mult_10: times 8 dw 64, 16, 4, 1
+sdi_chroma_shuf_10: times 4 db 1, 0, 5, 4, -1, 9, 8, 13, 12, -1, -1, -1, -1, -1, -1, -1
+sdi_luma_shuf_10: times 4 db -1, 3, 2, 7, 6, -1, 11, 10, 15, 14, -1, -1, -1, -1, -1, -1
 
 SECTION .text
 
@@ -38,6 +38,10 @@ cglobal uyvy_to_sdi, 3, 4, 5, dst, y, pixels
     mova    m2, [sdi_enc_mult_10]
     mova    m3, [sdi_chroma_shuf_10]
     mova    m4, [sdi_luma_shuf_10]
+%if mmsize == 64
+    cmp     pixelsq, -16
+    jg .tail
+%endif
 
 .loop:
 %if notcpuflag(avx)
@@ -51,13 +55,37 @@ cglobal uyvy_to_sdi, 3, 4, 5, dst, y, pixels
     por     m0, m1
 
     movu    [dstq], xm0
-%if cpuflag(avx2)
-    vextracti128 [dstq+10], m0, 1
-%endif
+%assign i 1
+%rep mmsize/16 - 1
+    vextracti128 [dstq+10*i], m0, i
+%assign i i+1
+%endrep
 
     add     dstq, (mmsize*5)/8
     add     pixelsq, mmsize/4
+%if mmsize == 64
+    cmp     pixelsq, -16
+    jle .loop
+
+    ; remaining pixels, 4 at a time so as not to write further than the
+    ; narrower variants
+.tail:
+    test    pixelsq, pixelsq
+    jge .end
+    pmullw  xm0, xm2, [yq+4*pixelsq]
+    pshufb  xm1, xm0, xm3
+    pshufb  xm0, xm4
+    por     xm0, xm1
+
+    movu    [dstq], xm0
+
+    add     dstq, 10
+    add     pixelsq, 4
+    jl .tail
+.end:
+%else
     jl .loop
+%endif
 
     RET
 %endmacro
@@ -68,3 +96,5 @@ INIT_XMM avx
 uyvy_to_sdi
 INIT_YMM avx2
 uyvy_to_sdi
+INIT_ZMM avx512
+uyvy_to_sdi
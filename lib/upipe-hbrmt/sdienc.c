@@ -22,6 +22,9 @@
 
 #include <arpa/inet.h>
 
+#include "upipe/config.h"
+#include "upipe/ucpu.h"
+
 #include "sdienc.h"
 
 void upipe_uyvy_to_sdi_c(uint8_t *dst, const uint8_t *y, uintptr_t pixels)
@@ -35,3 +38,20 @@ void upipe_uyvy_to_sdi_c(uint8_t *dst, const uint8_t *y, uintptr_t pixels)
     uint8_t *temp;
     ubits_clean(&s, &temp);
 }
+
+/* implementations of the kernels, best first */
+static const struct ucpu_impl upipe_uyvy_to_sdi_impls[] = {
+#if defined(UPIPE_HAVE_X86ASM) && (defined(__i686__) || defined(__x86_64__))
+    UCPU_IMPL(upipe_uyvy_to_sdi, avx512, UCPU_AVX512),
+    UCPU_IMPL(upipe_uyvy_to_sdi, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_uyvy_to_sdi, avx, UCPU_AVX),
+    UCPU_IMPL(upipe_uyvy_to_sdi, ssse3, UCPU_SSSE3),
+#endif
+#ifdef UPIPE_HAVE_AARCH64ASM
+    UCPU_IMPL(upipe_uyvy_to_sdi, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(upipe_uyvy_to_sdi, c, 0),
+};
+
+struct ucpu_kernel upipe_uyvy_to_sdi_kernel =
+    UCPU_KERNEL_INIT("uyvy_to_sdi", upipe_uyvy_to_sdi_impls);
@@ -2,3 +2,10 @@ void upipe_uyvy_to_sdi_c    (uint8_t *dst, const uint8_t *y, uintptr_t pixels);
 void upipe_uyvy_to_sdi_ssse3(uint8_t *dst, const uint8_t *y, uintptr_t pixels);
 void upipe_uyvy_to_sdi_avx  (uint8_t *dst, const uint8_t *y, uintptr_t pixels);
 void upipe_uyvy_to_sdi_avx2 (uint8_t *dst, const uint8_t *y, uintptr_t pixels);
+void upipe_uyvy_to_sdi_avx512(uint8_t *dst, const uint8_t *y, uintptr_t pixels);
+void upipe_uyvy_to_sdi_neon (uint8_t *dst, const uint8_t *y, uintptr_t pixels);
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of the kernels, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_uyvy_to_sdi_kernel;
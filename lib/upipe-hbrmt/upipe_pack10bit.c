@@ -24,6 +24,7 @@
 
 #include "upipe/config.h"
 #include "upipe/ubase.h"
+#include "upipe/ucpu.h"
 #include "upipe/uref.h"
 #include "upipe/ubuf.h"
 #include "upipe/uref_block_flow.h"
@@ -342,20 +343,9 @@ static struct upipe *upipe_pack10bit_alloc(struct upipe_mgr *mgr,
 
     struct upipe_pack10bit *upipe_pack10bit = upipe_pack10bit_from_upipe(upipe);
 
-    upipe_pack10bit->pack = upipe_uyvy_to_sdi_c;
-
-#if defined(UPIPE_HAVE_X86ASM)
-#if defined(__i686__) || defined(__x86_64__)
-    if (__builtin_cpu_supports("ssse3"))
-        upipe_pack10bit->pack = upipe_uyvy_to_sdi_ssse3;
-
-    if (__builtin_cpu_supports("avx"))
-        upipe_pack10bit->pack = upipe_uyvy_to_sdi_avx;
-
-    if (__builtin_cpu_supports("avx2"))
-        upipe_pack10bit->pack = upipe_uyvy_to_sdi_avx2;
-#endif
-#endif
+    upipe_pack10bit->pack =
+        UCPU_KERNEL_FUNC(&upipe_uyvy_to_sdi_kernel,
+                         __typeof__(upipe_pack10bit->pack));
 
     upipe_pack10bit_init_urefcount(upipe);
     upipe_pack10bit_init_ubuf_mgr(upipe);
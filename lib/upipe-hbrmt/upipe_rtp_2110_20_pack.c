@@ -0,0 +1,680 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module packing pictures into SMPTE ST 2110-20 RTP packets
+ */
+
+#include "upipe/config.h"
+#include "upipe/ubase.h"
+#include "upipe/ucpu.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/ubuf.h"
+#include "upipe/upipe.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_dump.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_ubuf_mgr.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_input.h"
+
+#include "upipe-hbrmt/upipe_rtp_2110_20_pack.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <bitstream/ietf/rtp.h>
+
+#include "sdienc.h"
+
+/** chroma of the input plane */
+#define UYVY10_CHROMA "u10y10v10y10"
+/** size of a pixel group, in octets */
+#define PGROUP_SIZE 5
+/** number of pixels in a pixel group */
+#define PGROUP_PIXELS 2
+/** size of the extended sequence number */
+#define EXT_SEQNUM_SIZE 2
+/** size of a sample row data header */
+#define SRD_HEADER_SIZE 6
+/** maximum number of sample row data headers in a packet */
+#define SRD_MAX 3
+/** number of pixels packed by the C kernel at the end of a segment, since
+ * the SIMD kernels may read and write past the end */
+#define TAIL_PIXELS 32
+/** RTP clock rate of ST 2110-20 */
+#define CLOCK_RATE 90000
+/** default RTP payload type */
+#define DEFAULT_TYPE 96
+/** default maximum size of the RTP payload */
+#define DEFAULT_PAYLOAD_SIZE 1448
+
+/** @internal @This describes a sample row data segment. */
+struct upipe_rtp_2110_20_pack_srd {
+    /** row number in the field */
+    uint16_t row;
+    /** offset of the first pixel */
+    uint16_t offset;
+    /** number of pixels */
+    uint16_t pixels;
+};
+
+/** upipe_rtp_2110_20_pack structure with 2110-20 pack parameters */
+struct upipe_rtp_2110_20_pack {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** temporary uref storage (used during urequest) */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers (used during udeal) */
+    struct uchain blockers;
+
+    /** frame period from the input flow definition, or 0 */
+    uint64_t frame_duration;
+    /** sender type */
+    enum upipe_rtp_2110_20_sender sender;
+    /** maximum size of the RTP payload */
+    unsigned int payload_size;
+    /** RTP payload type */
+    uint8_t type;
+    /** extended RTP sequence number of the next packet */
+    uint32_t seqnum;
+
+    /** packing */
+    void (*pack)(uint8_t *dst, const uint8_t *y, uintptr_t pixels);
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static bool upipe_rtp_2110_20_pack_handle(struct upipe *upipe,
+                                          struct uref *uref,
+                                          struct upump **upump_p);
+/** @hidden */
+static int upipe_rtp_2110_20_pack_check(struct upipe *upipe,
+                                        struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_rtp_2110_20_pack, upipe,
+                   UPIPE_RTP_2110_20_PACK_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_2110_20_pack, urefcount,
+                       upipe_rtp_2110_20_pack_free);
+UPIPE_HELPER_VOID(upipe_rtp_2110_20_pack);
+UPIPE_HELPER_OUTPUT(upipe_rtp_2110_20_pack, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_rtp_2110_20_pack, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_rtp_2110_20_pack_check,
+                      upipe_rtp_2110_20_pack_register_output_request,
+                      upipe_rtp_2110_20_pack_unregister_output_request)
+UPIPE_HELPER_INPUT(upipe_rtp_2110_20_pack, urefs, nb_urefs, max_urefs,
+                   blockers, upipe_rtp_2110_20_pack_handle)
+
+/** @internal @This packs pixels, leaving the end of the segment to the C
+ * kernel so that nothing is read or written past it.
+ *
+ * @param upipe description structure of the pipe
+ * @param dst packed pixel groups
+ * @param src 16-bit samples
+ * @param pixels number of pixels, multiple of 2
+ */
+static void upipe_rtp_2110_20_pack_pixels(struct upipe *upipe, uint8_t *dst,
+                                          const uint8_t *src,
+                                          unsigned int pixels)
+{
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+    if (pixels > TAIL_PIXELS) {
+        unsigned int head = pixels - TAIL_PIXELS;
+        upipe_rtp_2110_20_pack->pack(dst, src, head);
+        dst += head / PGROUP_PIXELS * PGROUP_SIZE;
+        src += head * 2 * sizeof(uint16_t);
+        pixels = TAIL_PIXELS;
+    }
+    upipe_uyvy_to_sdi_c(dst, src, pixels);
+}
+
+/** @internal @This lays out the next packet of a field.
+ *
+ * @param upipe description structure of the pipe
+ * @param hsize number of pixels per line
+ * @param rows number of rows in the field
+ * @param row_p current row, updated
+ * @param offset_p current pixel offset in the row, updated
+ * @param srds filled in with the segments of the packet
+ * @return the number of segments in the packet
+ */
+static unsigned int upipe_rtp_2110_20_pack_layout(struct upipe *upipe,
+        uint64_t hsize, uint64_t rows, uint64_t *row_p, uint64_t *offset_p,
+        struct upipe_rtp_2110_20_pack_srd *srds)
+{
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+    unsigned int space = upipe_rtp_2110_20_pack->payload_size -
+                         EXT_SEQNUM_SIZE;
+    unsigned int nb_srds = 0;
+
+    while (nb_srds < SRD_MAX && *row_p < rows &&
+           space >= SRD_HEADER_SIZE + PGROUP_SIZE) {
+        uint64_t pixels = (space - SRD_HEADER_SIZE) / PGROUP_SIZE *
+                          PGROUP_PIXELS;
+        if (pixels > hsize - *offset_p)
+            pixels = hsize - *offset_p;
+
+        srds[nb_srds].row = *row_p;
+        srds[nb_srds].offset = *offset_p;
+        srds[nb_srds].pixels = pixels;
+        nb_srds++;
+        space -= SRD_HEADER_SIZE + pixels / PGROUP_PIXELS * PGROUP_SIZE;
+
+        *offset_p += pixels;
+        if (*offset_p == hsize) {
+            *offset_p = 0;
+            (*row_p)++;
+        }
+    }
+    return nb_srds;
+}
+
+/** @internal @This returns the total number of lines of a format, used to
+ * compute the timing of a gapped sender.
+ *
+ * @param vsize number of active lines
+ * @return total number of lines
+ */
+static uint64_t upipe_rtp_2110_20_pack_vtotal(uint64_t vsize)
+{
+    switch (vsize) {
+        case 2160: return 2250;
+        case 1080: return 1125;
+        case 720: return 750;
+        case 576: return 625;
+        case 486:
+        case 480: return 525;
+        default: return vsize * 1125 / 1080;
+    }
+}
+
+/** @internal @This packs a field (or frame) into RTP packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param src first line of the field in the picture plane
+ * @param stride distance between two lines of the field
+ * @param hsize number of pixels per line
+ * @param rows number of lines of the field
+ * @param field field number (0 or 1)
+ * @param timestamp RTP timestamp of the field
+ * @param date date of the first packet, or UINT64_MAX
+ * @param period period during which the packets are sent
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_2110_20_pack_field(struct upipe *upipe,
+        struct uref *uref, const uint8_t *src, size_t stride,
+        uint64_t hsize, uint64_t rows, unsigned int field,
+        uint32_t timestamp, uint64_t date, uint64_t period,
+        struct upump **upump_p)
+{
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+    struct upipe_rtp_2110_20_pack_srd srds[SRD_MAX];
+
+    /* count the packets to spread them over the period */
+    uint64_t nb_packets = 0;
+    uint64_t row = 0, offset = 0;
+    while (upipe_rtp_2110_20_pack_layout(upipe, hsize, rows, &row, &offset,
+                                         srds))
+        nb_packets++;
+
+    row = offset = 0;
+    for (uint64_t packet = 0; packet < nb_packets; packet++) {
+        unsigned int nb_srds =
+            upipe_rtp_2110_20_pack_layout(upipe, hsize, rows, &row, &offset,
+                                          srds);
+        int size = RTP_HEADER_SIZE + EXT_SEQNUM_SIZE;
+        for (unsigned int i = 0; i < nb_srds; i++)
+            size += SRD_HEADER_SIZE +
+                    srds[i].pixels / PGROUP_PIXELS * PGROUP_SIZE;
+
+        struct ubuf *ubuf = ubuf_block_alloc(upipe_rtp_2110_20_pack->ubuf_mgr,
+                                             size);
+        uint8_t *buf;
+        if (unlikely(ubuf == NULL ||
+                     !ubase_check(ubuf_block_write(ubuf, 0, &size, &buf)))) {
+            if (ubuf != NULL)
+                ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+
+        uint32_t seqnum = upipe_rtp_2110_20_pack->seqnum++;
+        memset(buf, 0, RTP_HEADER_SIZE);
+        rtp_set_hdr(buf);
+        rtp_set_type(buf, upipe_rtp_2110_20_pack->type);
+        rtp_set_seqnum(buf, seqnum & UINT16_MAX);
+        rtp_set_timestamp(buf, timestamp);
+        if (packet == nb_packets - 1)
+            rtp_set_marker(buf);
+
+        uint8_t *payload = buf + RTP_HEADER_SIZE;
+        payload[0] = seqnum >> 24;
+        payload[1] = seqnum >> 16;
+        uint8_t *srd = payload + EXT_SEQNUM_SIZE;
+        uint8_t *data = srd + nb_srds * SRD_HEADER_SIZE;
+        for (unsigned int i = 0; i < nb_srds; i++) {
+            uint16_t length = srds[i].pixels / PGROUP_PIXELS * PGROUP_SIZE;
+            srd[0] = length >> 8;
+            srd[1] = length;
+            srd[2] = (field << 7) | (srds[i].row >> 8);
+            srd[3] = srds[i].row;
+            srd[4] = ((i < nb_srds - 1) << 7) | (srds[i].offset >> 8);
+            srd[5] = srds[i].offset;
+            srd += SRD_HEADER_SIZE;
+
+            upipe_rtp_2110_20_pack_pixels(upipe, data,
+                    src + srds[i].row * stride +
+                    srds[i].offset * 2 * sizeof(uint16_t),
+                    srds[i].pixels);
+            data += length;
+        }
+        ubuf_block_unmap(ubuf, 0);
+
+        struct uref *output = uref_fork(uref, ubuf);
+        if (unlikely(output == NULL)) {
+            ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        if (date != UINT64_MAX) {
+            uref_clock_set_cr_sys(output, date + period * packet / nb_packets);
+            uref_clock_set_duration(output, period / nb_packets);
+        }
+        upipe_rtp_2110_20_pack_output(upipe, output, upump_p);
+    }
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the input must be blocked
+ */
+static bool upipe_rtp_2110_20_pack_handle(struct upipe *upipe,
+                                          struct uref *uref,
+                                          struct upump **upump_p)
+{
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        upipe_rtp_2110_20_pack_store_flow_def(upipe, NULL);
+        upipe_rtp_2110_20_pack_require_ubuf_mgr(upipe, uref);
+        return true;
+    }
+
+    if (upipe_rtp_2110_20_pack->flow_def == NULL)
+        return false;
+
+    size_t hsize, vsize, stride;
+    const uint8_t *src;
+    if (unlikely(!ubase_check(uref_pic_size(uref, &hsize, &vsize, NULL)) ||
+                 !ubase_check(uref_pic_plane_size(uref, UYVY10_CHROMA,
+                                                  &stride, NULL, NULL,
+                                                  NULL)) ||
+                 !ubase_check(uref_pic_plane_read(uref, UYVY10_CHROMA,
+                                                  0, 0, -1, -1, &src)))) {
+        upipe_warn(upipe, "invalid picture received");
+        uref_free(uref);
+        return true;
+    }
+    if (unlikely(hsize % PGROUP_PIXELS)) {
+        upipe_warn_va(upipe, "invalid width %zu", hsize);
+        uref_pic_plane_unmap(uref, UYVY10_CHROMA, 0, 0, -1, -1);
+        uref_free(uref);
+        return true;
+    }
+
+    bool progressive = ubase_check(uref_pic_get_progressive(uref));
+    unsigned int nb_fields = progressive ? 1 : 2;
+    bool tff = ubase_check(uref_pic_get_tff(uref));
+
+    uint64_t pts = 0;
+    if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts))))
+        uref_clock_get_pts_sys(uref, &pts);
+
+    uint64_t duration = upipe_rtp_2110_20_pack->frame_duration;
+    uref_clock_get_duration(uref, &duration);
+    uint64_t date = UINT64_MAX;
+    if (!duration || !ubase_check(uref_clock_get_cr_sys(uref, &date)))
+        date = UINT64_MAX;
+
+    /* time offset and duration of the packets of a field */
+    uint64_t field_duration = duration / nb_fields;
+    uint64_t tro = 0, period = field_duration;
+    if (upipe_rtp_2110_20_pack->sender == UPIPE_RTP_2110_20_SENDER_GAPPED) {
+        uint64_t vtotal = upipe_rtp_2110_20_pack_vtotal(vsize);
+        uint64_t blanking = vtotal > vsize ? vtotal - vsize : 0;
+        if (progressive)
+            blanking = blanking > 2 ? blanking - 2 : 0;
+        else
+            blanking /= 2;
+        tro = duration * blanking / vtotal;
+        period = field_duration * vsize / vtotal;
+    }
+
+    for (unsigned int field = 0; field < nb_fields; field++) {
+        /* the first field holds the top lines unless bottom field first */
+        unsigned int line = progressive ? 0 : (tff ? field : 1 - field);
+        uint64_t field_pts = pts + field_duration * field;
+        lldiv_t div = lldiv(field_pts, UCLOCK_FREQ);
+        uint32_t timestamp = div.quot * CLOCK_RATE +
+            ((uint64_t)div.rem * CLOCK_RATE) / UCLOCK_FREQ;
+
+        upipe_rtp_2110_20_pack_field(upipe, uref, src + line * stride,
+                stride * nb_fields, hsize, vsize / nb_fields, field,
+                timestamp,
+                date == UINT64_MAX ? UINT64_MAX :
+                    date + field_duration * field + tro,
+                period, upump_p);
+    }
+
+    uref_pic_plane_unmap(uref, UYVY10_CHROMA, 0, 0, -1, -1);
+    uref_free(uref);
+    return true;
+}
+
+/** @internal @This receives incoming uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the picture
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_2110_20_pack_input(struct upipe *upipe,
+                                         struct uref *uref,
+                                         struct upump **upump_p)
+{
+    if (!upipe_rtp_2110_20_pack_check_input(upipe)) {
+        upipe_rtp_2110_20_pack_hold_input(upipe, uref);
+        upipe_rtp_2110_20_pack_block_input(upipe, upump_p);
+    } else if (!upipe_rtp_2110_20_pack_handle(upipe, uref, upump_p)) {
+        upipe_rtp_2110_20_pack_hold_input(upipe, uref);
+        upipe_rtp_2110_20_pack_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This receives a provided ubuf manager.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_rtp_2110_20_pack_check(struct upipe *upipe,
+                                        struct uref *flow_format)
+{
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_rtp_2110_20_pack_store_flow_def(upipe, flow_format);
+
+    if (upipe_rtp_2110_20_pack->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    bool was_buffered = !upipe_rtp_2110_20_pack_check_input(upipe);
+    upipe_rtp_2110_20_pack_output_input(upipe);
+    upipe_rtp_2110_20_pack_unblock_input(upipe);
+    if (was_buffered && upipe_rtp_2110_20_pack_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_rtp_2110_20_pack_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_rtp_2110_20_pack_set_flow_def(struct upipe *upipe,
+                                               struct uref *flow_def)
+{
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+
+    UBASE_RETURN(uref_flow_match_def(flow_def, "pic."))
+    uint8_t macropixel;
+    if (unlikely(!ubase_check(uref_pic_flow_get_macropixel(flow_def,
+                                                           &macropixel)) ||
+                 macropixel != PGROUP_PIXELS ||
+                 !ubase_check(uref_pic_flow_check_chroma(flow_def, 1, 1, 8,
+                                                         UYVY10_CHROMA)))) {
+        upipe_err(upipe, "incompatible input flow def");
+        uref_dump(flow_def, upipe->uprobe);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct urational fps;
+    upipe_rtp_2110_20_pack->frame_duration = 0;
+    if (ubase_check(uref_pic_flow_get_fps(flow_def, &fps)) && fps.num)
+        upipe_rtp_2110_20_pack->frame_duration =
+            UCLOCK_FREQ * fps.den / fps.num;
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    uref_flow_set_def(flow_def_dup, "block.rtp.2110_20.pic.");
+    uref_pic_flow_clear_format(flow_def_dup);
+    upipe_input(upipe, flow_def_dup, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a 2110-20 pack pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_2110_20_pack_control(struct upipe *upipe, int command,
+                                          va_list args)
+{
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_rtp_2110_20_pack_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return UBASE_ERR_NONE;
+            return upipe_rtp_2110_20_pack_free_output_proxy(upipe, request);
+        }
+
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+        case UPIPE_GET_FLOW_DEF:
+            return upipe_rtp_2110_20_pack_control_output(upipe, command,
+                                                         args);
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow = va_arg(args, struct uref *);
+            return upipe_rtp_2110_20_pack_set_flow_def(upipe, flow);
+        }
+
+        case UPIPE_RTP_2110_20_PACK_GET_SENDER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_2110_20_PACK_SIGNATURE)
+            int *sender_p = va_arg(args, int *);
+            *sender_p = upipe_rtp_2110_20_pack->sender;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_2110_20_PACK_SET_SENDER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_2110_20_PACK_SIGNATURE)
+            int sender = va_arg(args, int);
+            if (sender != UPIPE_RTP_2110_20_SENDER_GAPPED &&
+                sender != UPIPE_RTP_2110_20_SENDER_LINEAR)
+                return UBASE_ERR_INVALID;
+            upipe_rtp_2110_20_pack->sender = sender;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_2110_20_PACK_GET_PAYLOAD_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_2110_20_PACK_SIGNATURE)
+            unsigned int *size_p = va_arg(args, unsigned int *);
+            *size_p = upipe_rtp_2110_20_pack->payload_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_2110_20_PACK_SET_PAYLOAD_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_2110_20_PACK_SIGNATURE)
+            unsigned int size = va_arg(args, unsigned int);
+            if (size < EXT_SEQNUM_SIZE + SRD_HEADER_SIZE + PGROUP_SIZE ||
+                size > UINT16_MAX)
+                return UBASE_ERR_INVALID;
+            upipe_rtp_2110_20_pack->payload_size = size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_2110_20_PACK_GET_TYPE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_2110_20_PACK_SIGNATURE)
+            uint8_t *type_p = va_arg(args, uint8_t *);
+            *type_p = upipe_rtp_2110_20_pack->type;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_2110_20_PACK_SET_TYPE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_2110_20_PACK_SIGNATURE)
+            unsigned int type = va_arg(args, unsigned int);
+            if (type > 0x7f)
+                return UBASE_ERR_INVALID;
+            upipe_rtp_2110_20_pack->type = type;
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This allocates a 2110-20 pack pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_rtp_2110_20_pack_alloc(struct upipe_mgr *mgr,
+                                                  struct uprobe *uprobe,
+                                                  uint32_t signature,
+                                                  va_list args)
+{
+    struct upipe *upipe = upipe_rtp_2110_20_pack_alloc_void(mgr, uprobe,
+                                                            signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_rtp_2110_20_pack *upipe_rtp_2110_20_pack =
+        upipe_rtp_2110_20_pack_from_upipe(upipe);
+
+    upipe_rtp_2110_20_pack->pack =
+        UCPU_KERNEL_FUNC(&upipe_uyvy_to_sdi_kernel,
+                         __typeof__(upipe_rtp_2110_20_pack->pack));
+    upipe_rtp_2110_20_pack->frame_duration = 0;
+    upipe_rtp_2110_20_pack->sender = UPIPE_RTP_2110_20_SENDER_GAPPED;
+    upipe_rtp_2110_20_pack->payload_size = DEFAULT_PAYLOAD_SIZE;
+    upipe_rtp_2110_20_pack->type = DEFAULT_TYPE;
+    upipe_rtp_2110_20_pack->seqnum = 0;
+
+    upipe_rtp_2110_20_pack_init_urefcount(upipe);
+    upipe_rtp_2110_20_pack_init_ubuf_mgr(upipe);
+    upipe_rtp_2110_20_pack_init_output(upipe);
+    upipe_rtp_2110_20_pack_init_input(upipe);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_2110_20_pack_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_rtp_2110_20_pack_clean_input(upipe);
+    upipe_rtp_2110_20_pack_clean_output(upipe);
+    upipe_rtp_2110_20_pack_clean_ubuf_mgr(upipe);
+    upipe_rtp_2110_20_pack_clean_urefcount(upipe);
+    upipe_rtp_2110_20_pack_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_rtp_2110_20_pack_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_2110_20_PACK_SIGNATURE,
+
+    .upipe_alloc = upipe_rtp_2110_20_pack_alloc,
+    .upipe_input = upipe_rtp_2110_20_pack_input,
+    .upipe_control = upipe_rtp_2110_20_pack_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for 2110-20 pack pipes
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_2110_20_pack_mgr_alloc(void)
+{
+    return &upipe_rtp_2110_20_pack_mgr;
+}
@@ -0,0 +1,649 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module unpacking SMPTE ST 2110-20 RTP packets into pictures
+ */
+
+#include "upipe/config.h"
+#include "upipe/ubase.h"
+#include "upipe/ucpu.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_pic.h"
+#include "upipe/upipe.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_dump.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_ubuf_mgr.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_input.h"
+
+#include "upipe-hbrmt/upipe_rtp_2110_20_unpack.h"
+
+#include <string.h>
+
+#include <bitstream/ietf/rtp.h>
+
+#include "sdidec.h"
+
+/** chroma of the output plane */
+#define UYVY10_CHROMA "u10y10v10y10"
+/** size of a pixel group, in octets */
+#define PGROUP_SIZE 5
+/** number of pixels in a pixel group */
+#define PGROUP_PIXELS 2
+/** size of the extended sequence number */
+#define EXT_SEQNUM_SIZE 2
+/** size of a sample row data header */
+#define SRD_HEADER_SIZE 6
+/** number of pixels unpacked by the C kernel at the end of a segment, since
+ * the SIMD kernels may write past the end */
+#define TAIL_PIXELS 32
+/** RTP clock rate of ST 2110-20 */
+#define CLOCK_RATE 90000
+/** largest datagram copied when a block is segmented */
+#define MAX_PACKET_SIZE 9000
+/** 2^32 */
+#define POW2_32 UINT64_C(4294967296)
+
+/** upipe_rtp_2110_20_unpack structure with 2110-20 unpack parameters */
+struct upipe_rtp_2110_20_unpack {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** temporary uref storage (used during urequest) */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers (used during udeal) */
+    struct uchain blockers;
+
+    /** number of pixels per line */
+    uint64_t hsize;
+    /** number of lines */
+    uint64_t vsize;
+    /** true for progressive pictures */
+    bool progressive;
+    /** true for top field first pictures */
+    bool tff;
+    /** frame period, or 0 */
+    uint64_t frame_duration;
+
+    /** extended sequence number of the next packet, or -1 */
+    int64_t expected_seqnum;
+
+    /** picture being received */
+    struct uref *frame;
+    /** RTP timestamp of the picture being received */
+    uint32_t timestamp;
+    /** mapped plane of the picture being received */
+    uint8_t *plane;
+    /** stride of the plane of the picture being received */
+    size_t stride;
+    /** number of packets received for the picture */
+    unsigned int packets;
+
+    /** unpacking */
+    void (*unpack)(const uint8_t *src, uint16_t *y, uintptr_t pixels);
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static bool upipe_rtp_2110_20_unpack_handle(struct upipe *upipe,
+                                            struct uref *uref,
+                                            struct upump **upump_p);
+/** @hidden */
+static int upipe_rtp_2110_20_unpack_check(struct upipe *upipe,
+                                          struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_rtp_2110_20_unpack, upipe,
+                   UPIPE_RTP_2110_20_UNPACK_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_2110_20_unpack, urefcount,
+                       upipe_rtp_2110_20_unpack_free);
+UPIPE_HELPER_VOID(upipe_rtp_2110_20_unpack);
+UPIPE_HELPER_OUTPUT(upipe_rtp_2110_20_unpack, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_rtp_2110_20_unpack, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_rtp_2110_20_unpack_check,
+                      upipe_rtp_2110_20_unpack_register_output_request,
+                      upipe_rtp_2110_20_unpack_unregister_output_request)
+UPIPE_HELPER_INPUT(upipe_rtp_2110_20_unpack, urefs, nb_urefs, max_urefs,
+                   blockers, upipe_rtp_2110_20_unpack_handle)
+
+/** @internal @This unpacks pixels, leaving the end of the segment to the C
+ * kernel so that pixels of other packets are not overwritten.
+ *
+ * @param upipe description structure of the pipe
+ * @param src packed pixel groups
+ * @param dst 16-bit samples
+ * @param pixels number of pixels, multiple of 2
+ */
+static void upipe_rtp_2110_20_unpack_pixels(struct upipe *upipe,
+                                            const uint8_t *src, uint16_t *dst,
+                                            unsigned int pixels)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+    if (pixels > TAIL_PIXELS) {
+        unsigned int head = pixels - TAIL_PIXELS;
+        upipe_rtp_2110_20_unpack->unpack(src, dst, head);
+        src += head / PGROUP_PIXELS * PGROUP_SIZE;
+        dst += head * 2;
+        pixels = TAIL_PIXELS;
+    }
+    upipe_sdi_to_uyvy_c(src, dst, pixels);
+}
+
+/** @internal @This outputs the picture being received.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_2110_20_unpack_output_frame(struct upipe *upipe,
+                                                  struct upump **upump_p)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+    struct uref *frame = upipe_rtp_2110_20_unpack->frame;
+    if (frame == NULL)
+        return;
+
+    upipe_rtp_2110_20_unpack->frame = NULL;
+    uref_pic_plane_unmap(frame, UYVY10_CHROMA, 0, 0, -1, -1);
+    upipe_verbose_va(upipe, "output picture (%u packets)",
+                     upipe_rtp_2110_20_unpack->packets);
+    upipe_rtp_2110_20_unpack_output(upipe, frame, upump_p);
+}
+
+/** @internal @This allocates the picture of a packet.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the packet
+ * @param timestamp RTP timestamp of the packet
+ * @return an error code
+ */
+static int upipe_rtp_2110_20_unpack_alloc_frame(struct upipe *upipe,
+                                                struct uref *uref,
+                                                uint32_t timestamp)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+    struct ubuf *ubuf = ubuf_pic_alloc(upipe_rtp_2110_20_unpack->ubuf_mgr,
+                                       upipe_rtp_2110_20_unpack->hsize,
+                                       upipe_rtp_2110_20_unpack->vsize);
+    UBASE_ALLOC_RETURN(ubuf)
+    /* lost packets leave black areas */
+    ubuf_pic_clear(ubuf, 0, 0, -1, -1, 0);
+
+    struct uref *frame = uref_fork(uref, ubuf);
+    if (unlikely(frame == NULL)) {
+        ubuf_free(ubuf);
+        return UBASE_ERR_ALLOC;
+    }
+
+    uint8_t *plane;
+    size_t stride;
+    if (unlikely(!ubase_check(uref_pic_plane_size(frame, UYVY10_CHROMA,
+                                                  &stride, NULL, NULL,
+                                                  NULL)) ||
+                 !ubase_check(uref_pic_plane_write(frame, UYVY10_CHROMA,
+                                                   0, 0, -1, -1, &plane)))) {
+        uref_free(frame);
+        return UBASE_ERR_INVALID;
+    }
+
+    if (upipe_rtp_2110_20_unpack->progressive)
+        uref_pic_set_progressive(frame);
+    else
+        uref_pic_delete_progressive(frame);
+    if (upipe_rtp_2110_20_unpack->tff)
+        uref_pic_set_tff(frame);
+    else
+        uref_pic_delete_tff(frame);
+    if (upipe_rtp_2110_20_unpack->frame_duration)
+        uref_clock_set_duration(frame,
+                                upipe_rtp_2110_20_unpack->frame_duration);
+    uref_clock_set_pts_orig(frame,
+                            (uint64_t)timestamp * UCLOCK_FREQ / CLOCK_RATE);
+    upipe_throw_clock_ts(upipe, frame);
+
+    upipe_rtp_2110_20_unpack->frame = frame;
+    upipe_rtp_2110_20_unpack->timestamp = timestamp;
+    upipe_rtp_2110_20_unpack->plane = plane;
+    upipe_rtp_2110_20_unpack->stride = stride;
+    upipe_rtp_2110_20_unpack->packets = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This unpacks the sample row data of a packet.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the packet
+ * @param rtp RTP packet
+ * @param size size of the RTP packet
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_2110_20_unpack_packet(struct upipe *upipe,
+                                            struct uref *uref,
+                                            const uint8_t *rtp, size_t size,
+                                            struct upump **upump_p)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+
+    if (unlikely(size < RTP_HEADER_SIZE || !rtp_check_hdr(rtp))) {
+        upipe_warn(upipe, "invalid RTP header");
+        return;
+    }
+    const uint8_t *payload = rtp_payload((uint8_t *)rtp);
+    if (unlikely(payload + EXT_SEQNUM_SIZE + SRD_HEADER_SIZE > rtp + size)) {
+        upipe_warn(upipe, "invalid RTP payload");
+        return;
+    }
+    const uint8_t *end = rtp + size;
+
+    uint32_t seqnum = ((uint32_t)payload[0] << 24) | (payload[1] << 16) |
+                      rtp_get_seqnum(rtp);
+    if (unlikely(upipe_rtp_2110_20_unpack->expected_seqnum != -1 &&
+                 seqnum != upipe_rtp_2110_20_unpack->expected_seqnum))
+        upipe_warn_va(upipe, "potentially lost %"PRIu32" packets",
+                      seqnum - (uint32_t)
+                      upipe_rtp_2110_20_unpack->expected_seqnum);
+    upipe_rtp_2110_20_unpack->expected_seqnum = (uint32_t)(seqnum + 1);
+
+    uint32_t timestamp = rtp_get_timestamp(rtp);
+    bool marker = rtp_check_marker(rtp);
+
+    /* count the sample row data headers */
+    const uint8_t *srd = payload + EXT_SEQNUM_SIZE;
+    unsigned int nb_srds = 0;
+    bool cont;
+    do {
+        if (unlikely(srd + (nb_srds + 1) * SRD_HEADER_SIZE > end)) {
+            upipe_warn(upipe, "invalid sample row data headers");
+            return;
+        }
+        cont = srd[nb_srds * SRD_HEADER_SIZE + 4] & 0x80;
+        nb_srds++;
+    } while (cont);
+    bool field = srd[2] & 0x80;
+
+    /* a packet of the first field with a new timestamp starts a picture */
+    if (upipe_rtp_2110_20_unpack->frame != NULL && !field &&
+        timestamp != upipe_rtp_2110_20_unpack->timestamp) {
+        upipe_warn(upipe, "incomplete picture");
+        upipe_rtp_2110_20_unpack_output_frame(upipe, upump_p);
+    }
+    if (upipe_rtp_2110_20_unpack->frame == NULL) {
+        int err = upipe_rtp_2110_20_unpack_alloc_frame(upipe, uref, timestamp);
+        if (unlikely(!ubase_check(err))) {
+            upipe_throw_fatal(upipe, err);
+            return;
+        }
+    }
+    upipe_rtp_2110_20_unpack->packets++;
+
+    unsigned int nb_fields = upipe_rtp_2110_20_unpack->progressive ? 1 : 2;
+    uint64_t rows = upipe_rtp_2110_20_unpack->vsize / nb_fields;
+    const uint8_t *data = srd + nb_srds * SRD_HEADER_SIZE;
+    for (unsigned int i = 0; i < nb_srds; i++, srd += SRD_HEADER_SIZE) {
+        unsigned int length = (srd[0] << 8) | srd[1];
+        unsigned int f = srd[2] >> 7;
+        uint64_t row = ((srd[2] & 0x7f) << 8) | srd[3];
+        uint64_t offset = ((srd[4] & 0x7f) << 8) | srd[5];
+        uint64_t pixels = length / PGROUP_SIZE * PGROUP_PIXELS;
+        if (unlikely(data + length > end || length % PGROUP_SIZE ||
+                     row >= rows || f >= nb_fields ||
+                     offset % PGROUP_PIXELS ||
+                     offset + pixels > upipe_rtp_2110_20_unpack->hsize)) {
+            upipe_warn(upipe, "invalid sample row data");
+            return;
+        }
+
+        uint64_t line = row;
+        if (nb_fields == 2)
+            line = row * 2 + (upipe_rtp_2110_20_unpack->tff ? f : 1 - f);
+        uint16_t *dst = (uint16_t *)(upipe_rtp_2110_20_unpack->plane +
+                                     line * upipe_rtp_2110_20_unpack->stride) +
+                        offset * 2;
+        upipe_rtp_2110_20_unpack_pixels(upipe, data, dst, pixels);
+        data += length;
+    }
+
+    /* the marker bit is set on the last packet of a frame or field */
+    if (marker && (nb_fields == 1 || field))
+        upipe_rtp_2110_20_unpack_output_frame(upipe, upump_p);
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the packet
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the input must be blocked
+ */
+static bool upipe_rtp_2110_20_unpack_handle(struct upipe *upipe,
+                                            struct uref *uref,
+                                            struct upump **upump_p)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        upipe_rtp_2110_20_unpack_store_flow_def(upipe, NULL);
+        upipe_rtp_2110_20_unpack_require_ubuf_mgr(upipe, uref);
+        return true;
+    }
+
+    if (upipe_rtp_2110_20_unpack->flow_def == NULL)
+        return false;
+
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)) ||
+                 size > MAX_PACKET_SIZE)) {
+        upipe_warn(upipe, "invalid packet received");
+        uref_free(uref);
+        return true;
+    }
+
+    /* the payload is read in place unless the block is segmented */
+    uint8_t buffer[MAX_PACKET_SIZE];
+    const uint8_t *rtp = uref_block_peek(uref, 0, size, buffer);
+    if (unlikely(rtp == NULL)) {
+        upipe_warn(upipe, "unable to read packet");
+        uref_free(uref);
+        return true;
+    }
+    upipe_rtp_2110_20_unpack_packet(upipe, uref, rtp, size, upump_p);
+    uref_block_peek_unmap(uref, 0, buffer, rtp);
+    uref_free(uref);
+    return true;
+}
+
+/** @internal @This receives incoming uref.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure describing the packet
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_2110_20_unpack_input(struct upipe *upipe,
+                                           struct uref *uref,
+                                           struct upump **upump_p)
+{
+    if (!upipe_rtp_2110_20_unpack_check_input(upipe)) {
+        upipe_rtp_2110_20_unpack_hold_input(upipe, uref);
+        upipe_rtp_2110_20_unpack_block_input(upipe, upump_p);
+    } else if (!upipe_rtp_2110_20_unpack_handle(upipe, uref, upump_p)) {
+        upipe_rtp_2110_20_unpack_hold_input(upipe, uref);
+        upipe_rtp_2110_20_unpack_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This receives a provided ubuf manager.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_rtp_2110_20_unpack_check(struct upipe *upipe,
+                                          struct uref *flow_format)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_rtp_2110_20_unpack_store_flow_def(upipe, flow_format);
+
+    if (upipe_rtp_2110_20_unpack->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    bool was_buffered = !upipe_rtp_2110_20_unpack_check_input(upipe);
+    upipe_rtp_2110_20_unpack_output_input(upipe);
+    upipe_rtp_2110_20_unpack_unblock_input(upipe);
+    if (was_buffered && upipe_rtp_2110_20_unpack_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_rtp_2110_20_unpack_input. */
+        upipe_release(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_rtp_2110_20_unpack_set_flow_def(struct upipe *upipe,
+                                                 struct uref *flow_def)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+    uint64_t hsize, vsize;
+    if (unlikely(!ubase_check(uref_pic_flow_get_hsize(flow_def, &hsize)) ||
+                 !ubase_check(uref_pic_flow_get_vsize(flow_def, &vsize)) ||
+                 hsize % PGROUP_PIXELS)) {
+        upipe_err(upipe, "incompatible input flow def");
+        uref_dump(flow_def, upipe->uprobe);
+        return UBASE_ERR_EXTERNAL;
+    }
+    bool progressive = ubase_check(uref_pic_get_progressive(flow_def));
+    if (unlikely(!progressive && vsize % 2)) {
+        upipe_err(upipe, "odd number of lines in interlaced flow def");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct urational fps;
+    uint64_t frame_duration = 0;
+    if (ubase_check(uref_pic_flow_get_fps(flow_def, &fps)) && fps.num)
+        frame_duration = UCLOCK_FREQ * fps.den / fps.num;
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    uref_flow_set_def(flow_def_dup, "pic.");
+    uref_pic_flow_clear_format(flow_def_dup);
+    if (unlikely(!ubase_check(uref_pic_flow_set_macropixel(flow_def_dup,
+                                                           PGROUP_PIXELS)) ||
+                 !ubase_check(uref_pic_flow_add_plane(flow_def_dup, 1, 1, 8,
+                                                      UYVY10_CHROMA)) ||
+                 !ubase_check(uref_clock_set_wrap(flow_def_dup,
+                         POW2_32 * UCLOCK_FREQ / CLOCK_RATE)))) {
+        uref_free(flow_def_dup);
+        return UBASE_ERR_ALLOC;
+    }
+
+    if (upipe_rtp_2110_20_unpack->frame != NULL &&
+        (hsize != upipe_rtp_2110_20_unpack->hsize ||
+         vsize != upipe_rtp_2110_20_unpack->vsize)) {
+        uref_pic_plane_unmap(upipe_rtp_2110_20_unpack->frame, UYVY10_CHROMA,
+                             0, 0, -1, -1);
+        uref_free(upipe_rtp_2110_20_unpack->frame);
+        upipe_rtp_2110_20_unpack->frame = NULL;
+    }
+    upipe_rtp_2110_20_unpack->hsize = hsize;
+    upipe_rtp_2110_20_unpack->vsize = vsize;
+    upipe_rtp_2110_20_unpack->progressive = progressive;
+    upipe_rtp_2110_20_unpack->tff = ubase_check(uref_pic_get_tff(flow_def));
+    upipe_rtp_2110_20_unpack->frame_duration = frame_duration;
+
+    upipe_input(upipe, flow_def_dup, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a 2110-20 unpack pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_2110_20_unpack_control(struct upipe *upipe, int command,
+                                            va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return upipe_throw_provide_request(upipe, request);
+            return upipe_rtp_2110_20_unpack_alloc_output_proxy(upipe,
+                                                               request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR ||
+                request->type == UREQUEST_FLOW_FORMAT)
+                return UBASE_ERR_NONE;
+            return upipe_rtp_2110_20_unpack_free_output_proxy(upipe,
+                                                              request);
+        }
+
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+        case UPIPE_GET_FLOW_DEF:
+            return upipe_rtp_2110_20_unpack_control_output(upipe, command,
+                                                           args);
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow = va_arg(args, struct uref *);
+            return upipe_rtp_2110_20_unpack_set_flow_def(upipe, flow);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This allocates a 2110-20 unpack pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_rtp_2110_20_unpack_alloc(struct upipe_mgr *mgr,
+                                                    struct uprobe *uprobe,
+                                                    uint32_t signature,
+                                                    va_list args)
+{
+    struct upipe *upipe = upipe_rtp_2110_20_unpack_alloc_void(mgr, uprobe,
+                                                              signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+
+    upipe_rtp_2110_20_unpack->unpack =
+        UCPU_KERNEL_FUNC(&upipe_sdi_to_uyvy_kernel,
+                         __typeof__(upipe_rtp_2110_20_unpack->unpack));
+    upipe_rtp_2110_20_unpack->hsize = 0;
+    upipe_rtp_2110_20_unpack->vsize = 0;
+    upipe_rtp_2110_20_unpack->progressive = true;
+    upipe_rtp_2110_20_unpack->tff = false;
+    upipe_rtp_2110_20_unpack->frame_duration = 0;
+    upipe_rtp_2110_20_unpack->expected_seqnum = -1;
+    upipe_rtp_2110_20_unpack->frame = NULL;
+    upipe_rtp_2110_20_unpack->timestamp = 0;
+    upipe_rtp_2110_20_unpack->plane = NULL;
+    upipe_rtp_2110_20_unpack->stride = 0;
+    upipe_rtp_2110_20_unpack->packets = 0;
+
+    upipe_rtp_2110_20_unpack_init_urefcount(upipe);
+    upipe_rtp_2110_20_unpack_init_ubuf_mgr(upipe);
+    upipe_rtp_2110_20_unpack_init_output(upipe);
+    upipe_rtp_2110_20_unpack_init_input(upipe);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_2110_20_unpack_free(struct upipe *upipe)
+{
+    struct upipe_rtp_2110_20_unpack *upipe_rtp_2110_20_unpack =
+        upipe_rtp_2110_20_unpack_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+    if (upipe_rtp_2110_20_unpack->frame != NULL) {
+        uref_pic_plane_unmap(upipe_rtp_2110_20_unpack->frame, UYVY10_CHROMA,
+                             0, 0, -1, -1);
+        uref_free(upipe_rtp_2110_20_unpack->frame);
+    }
+    upipe_rtp_2110_20_unpack_clean_input(upipe);
+    upipe_rtp_2110_20_unpack_clean_output(upipe);
+    upipe_rtp_2110_20_unpack_clean_ubuf_mgr(upipe);
+    upipe_rtp_2110_20_unpack_clean_urefcount(upipe);
+    upipe_rtp_2110_20_unpack_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_rtp_2110_20_unpack_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_2110_20_UNPACK_SIGNATURE,
+
+    .upipe_alloc = upipe_rtp_2110_20_unpack_alloc,
+    .upipe_input = upipe_rtp_2110_20_unpack_input,
+    .upipe_control = upipe_rtp_2110_20_unpack_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for 2110-20 unpack pipes
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_2110_20_unpack_mgr_alloc(void)
+{
+    return &upipe_rtp_2110_20_unpack_mgr;
+}
@@ -24,6 +24,7 @@
 
 #include "upipe/config.h"
 #include "upipe/ubase.h"
+#include "upipe/ucpu.h"
 #include "upipe/uref.h"
 #include "upipe/ubuf.h"
 #include "upipe/uref_block_flow.h"
@@ -329,16 +330,9 @@ static struct upipe *upipe_unpack10bit_alloc(struct upipe_mgr *mgr,
 
     struct upipe_unpack10bit *upipe_unpack10bit = upipe_unpack10bit_from_upipe(upipe);
 
-    upipe_unpack10bit->unpack = upipe_sdi_to_uyvy_c;
-#if defined(UPIPE_HAVE_X86ASM)
-#if defined(__i686__) || defined(__x86_64__)
-    if (__builtin_cpu_supports("ssse3"))
-        upipe_unpack10bit->unpack = upipe_sdi_to_uyvy_ssse3;
-
-    if (__builtin_cpu_supports("avx2"))
-        upipe_unpack10bit->unpack = upipe_sdi_to_uyvy_avx2;
-#endif
-#endif
+    upipe_unpack10bit->unpack =
+        UCPU_KERNEL_FUNC(&upipe_sdi_to_uyvy_kernel,
+                         __typeof__(upipe_unpack10bit->unpack));
 
     upipe_unpack10bit_init_urefcount(upipe);
     upipe_unpack10bit_init_ubuf_mgr(upipe);
@@ -511,6 +511,7 @@ static int probe_src(struct uprobe *uprobe, struct upipe *inner,
                              UPROBE_LOG_VERBOSE, "m3u"));
         upipe_mgr_release(upipe_m3u_reader_mgr);
         UBASE_ALLOC_RETURN(output);
+        upipe_m3u_reader_set_incremental(output, true);
 
         /* playlist pipe
         */
@@ -45,12 +45,15 @@
 #include "upipe/uprobe_prefix.h"
 #include "upipe/uprobe.h"
 
+#include "upipe/urefcount_helper.h"
+
 #include "upipe/uref_m3u_master.h"
 #include "upipe/uref_m3u_playlist_flow.h"
 #include "upipe/uref_m3u_playlist.h"
 #include "upipe/uref_m3u.h"
 #include "upipe/uref_dump.h"
 #include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
 #include "upipe/uref_uri.h"
 
 #include "upipe/uclock.h"
@@ -60,6 +63,8 @@
 
 /** @showvalue */
 #define EXPECTED_FLOW_DEF "block.m3u.playlist."
+/** weight of the previous estimate in the bandwidth moving average */
+#define BANDWIDTH_SMOOTHING 3
 
 static int upipe_hls_playlist_throw_need_reload(struct upipe *upipe)
 {
@@ -141,15 +146,58 @@ struct upipe_hls_playlist {
     bool attach_uclock;
     /** is currently playing */
     bool playing;
+    /** number of upcoming items to download in advance */
+    unsigned int prefetch;
+    /** list of items being downloaded in advance */
+    struct uchain prefetches;
+    /** download of the current item, if it was prefetched */
+    struct upipe_hls_playlist_prefetch *current;
+    /** estimated bandwidth in bits per second */
+    uint64_t bandwidth;
 };
 
+/** @internal @This describes the download of an item. */
+struct upipe_hls_playlist_prefetch {
+    /** refcount, held by the probes */
+    struct urefcount urefcount;
+    /** link in the list of prefetches */
+    struct uchain uchain;
+    /** pointer to the playlist pipe */
+    struct upipe *upipe;
+    /** media sequence of the item */
+    uint64_t index;
+    /** source pipe */
+    struct upipe *src;
+    /** probe uref pipe catching the data */
+    struct upipe *sink;
+    /** probe for the source pipe */
+    struct uprobe probe_src;
+    /** probe for the probe uref pipe */
+    struct uprobe probe_sink;
+    /** data received before the item is played */
+    struct uchain urefs;
+    /** number of octets received */
+    uint64_t size;
+    /** system date of the first received data */
+    uint64_t first_sys;
+    /** system date of the last received data */
+    uint64_t last_sys;
+    /** the source has ended */
+    bool ended;
+    /** the item is being played */
+    bool active;
+};
+
+UBASE_FROM_TO(upipe_hls_playlist_prefetch, uchain, uchain, uchain);
+UBASE_FROM_TO(upipe_hls_playlist_prefetch, uprobe, probe_src, probe_src);
+UBASE_FROM_TO(upipe_hls_playlist_prefetch, uprobe, probe_sink, probe_sink);
+
 static int probe_key_src(struct uprobe *uprobe, struct upipe *inner,
                          int event, va_list args);
 static int probe_key(struct uprobe *uprobe, struct upipe *inner,
                      int event, va_list args);
 static int probe_src(struct uprobe *uprobe, struct upipe *inner,
                      int event, va_list args);
-
 UPIPE_HELPER_UPIPE(upipe_hls_playlist, upipe, UPIPE_HLS_PLAYLIST_SIGNATURE);
 UPIPE_HELPER_UREFCOUNT(upipe_hls_playlist, urefcount, upipe_hls_playlist_no_ref);
 UPIPE_HELPER_UREFCOUNT_REAL(upipe_hls_playlist, urefcount_real,
@@ -167,6 +215,9 @@ UPIPE_HELPER_BIN_OUTPUT(upipe_hls_playlist, setflowdef, output, requests);
 UPIPE_HELPER_UPUMP_MGR(upipe_hls_playlist, upump_mgr);
 UPIPE_HELPER_UPUMP(upipe_hls_playlist, upump, upump_mgr);
 
+UREFCOUNT_HELPER(upipe_hls_playlist_prefetch, urefcount,
+                 upipe_hls_playlist_prefetch_free);
+
 /** @internal @This catches the inner key source pipe event.
  *
  * @param uprobe structure used to raise events
@@ -262,6 +313,175 @@ static int probe_src(struct uprobe *uprobe, struct upipe *inner,
     return upipe_throw_proxy(upipe, inner, event, args);
 }
 
+/** @internal @This updates the estimated bandwidth with the download rate
+ * of an item.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch download of the item
+ */
+static void upipe_hls_playlist_update_bandwidth(
+    struct upipe *upipe,
+    struct upipe_hls_playlist_prefetch *prefetch)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    if (prefetch->first_sys == UINT64_MAX ||
+        prefetch->last_sys <= prefetch->first_sys)
+        return;
+
+    uint64_t rate = prefetch->size * 8 * UCLOCK_FREQ /
+        (prefetch->last_sys - prefetch->first_sys);
+    if (upipe_hls_playlist->bandwidth)
+        upipe_hls_playlist->bandwidth =
+            (upipe_hls_playlist->bandwidth * BANDWIDTH_SMOOTHING + rate) /
+            (BANDWIDTH_SMOOTHING + 1);
+    else
+        upipe_hls_playlist->bandwidth = rate;
+    upipe_verbose_va(upipe, "item %"PRIu64" downloaded at %"PRIu64" bps, "
+                     "bandwidth %"PRIu64" bps", prefetch->index, rate,
+                     upipe_hls_playlist->bandwidth);
+}
+
+/** @internal @This catches the events of a prefetch source pipe.
+ *
+ * @param uprobe structure used to raise events
+ * @param inner the inner pipe
+ * @param event event thrown
+ * @param args optional arguments
+ * @return an error code
+ */
+static int probe_prefetch_src(struct uprobe *uprobe, struct upipe *inner,
+                              int event, va_list args)
+{
+    struct upipe_hls_playlist_prefetch *prefetch =
+        upipe_hls_playlist_prefetch_from_probe_src(uprobe);
+    struct upipe *upipe = prefetch->upipe;
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    switch (event) {
+    case UPROBE_SOURCE_END:
+        if (prefetch->ended)
+            return UBASE_ERR_NONE;
+        prefetch->ended = true;
+        upipe_hls_playlist_update_bandwidth(upipe, prefetch);
+        if (!prefetch->active) {
+            upipe_dbg_va(upipe, "item %"PRIu64" prefetched", prefetch->index);
+            return UBASE_ERR_NONE;
+        }
+        upipe_dbg(upipe, "stopped");
+        upipe_hls_playlist->playing = false;
+        return upipe_hls_playlist_throw_item_end(upipe);
+    }
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
+/** @internal @This catches the events of a prefetch probe uref pipe, and
+ * keeps the data until the item is played.
+ *
+ * @param uprobe structure used to raise events
+ * @param inner the inner pipe
+ * @param event event thrown
+ * @param args optional arguments
+ * @return an error code
+ */
+static int probe_prefetch_sink(struct uprobe *uprobe, struct upipe *inner,
+                               int event, va_list args)
+{
+    struct upipe_hls_playlist_prefetch *prefetch =
+        upipe_hls_playlist_prefetch_from_probe_sink(uprobe);
+    struct upipe *upipe = prefetch->upipe;
+
+    switch (event) {
+    case UPROBE_PROBE_UREF: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_PROBE_UREF_SIGNATURE);
+        struct uref *uref = va_arg(args, struct uref *);
+        va_arg(args, struct upump **);
+        bool *drop = va_arg(args, bool *);
+
+        size_t size;
+        if (ubase_check(uref_block_size(uref, &size)))
+            prefetch->size += size;
+        uint64_t cr_sys;
+        if (ubase_check(uref_clock_get_cr_sys(uref, &cr_sys))) {
+            if (prefetch->first_sys == UINT64_MAX)
+                prefetch->first_sys = cr_sys;
+            prefetch->last_sys = cr_sys;
+        }
+
+        if (prefetch->active)
+            return UBASE_ERR_NONE;
+
+        *drop = true;
+        struct uref *dup = uref_dup(uref);
+        if (unlikely(dup == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+        ulist_add(&prefetch->urefs, uref_to_uchain(dup));
+        return UBASE_ERR_NONE;
+    }
+    case UPROBE_NEW_FLOW_DEF:
+        return UBASE_ERR_NONE;
+    case UPROBE_NEED_OUTPUT:
+        return UBASE_ERR_INVALID;
+    }
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
+/** @internal @This frees a download when the probes are released.
+ *
+ * @param prefetch download of an item
+ */
+static void upipe_hls_playlist_prefetch_free(
+    struct upipe_hls_playlist_prefetch *prefetch)
+{
+    struct upipe *upipe = prefetch->upipe;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&prefetch->urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    uprobe_clean(&prefetch->probe_sink);
+    uprobe_clean(&prefetch->probe_src);
+    upipe_hls_playlist_prefetch_clean_urefcount(prefetch);
+    free(prefetch);
+    upipe_hls_playlist_release_urefcount_real(upipe);
+}
+
+/** @internal @This stops a download and releases its inner pipes.
+ *
+ * @param prefetch download of an item
+ */
+static void upipe_hls_playlist_prefetch_stop(
+    struct upipe_hls_playlist_prefetch *prefetch)
+{
+    if (!prefetch->active)
+        ulist_delete(&prefetch->uchain);
+    upipe_release(prefetch->sink);
+    prefetch->sink = NULL;
+    upipe_release(prefetch->src);
+    prefetch->src = NULL;
+    upipe_hls_playlist_prefetch_release_urefcount(prefetch);
+}
+
+/** @internal @This stops all the downloads.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_playlist_clean_prefetches(struct upipe *upipe)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_hls_playlist->prefetches, uchain, uchain_tmp)
+        upipe_hls_playlist_prefetch_stop(
+            upipe_hls_playlist_prefetch_from_uchain(uchain));
+    if (upipe_hls_playlist->current != NULL) {
+        upipe_hls_playlist_prefetch_stop(upipe_hls_playlist->current);
+        upipe_hls_playlist->current = NULL;
+    }
+}
+
 /** @internal @This allocates a m3u playlist pipe.
  *
  * @param mgr pointer to upipe manager
@@ -306,6 +526,10 @@ static struct upipe *upipe_hls_playlist_alloc(struct upipe_mgr *mgr,
     upipe_hls_playlist->key.method = NULL;
     upipe_hls_playlist->attach_uclock = false;
     upipe_hls_playlist->playing = false;
+    upipe_hls_playlist->prefetch = 0;
+    ulist_init(&upipe_hls_playlist->prefetches);
+    upipe_hls_playlist->current = NULL;
+    upipe_hls_playlist->bandwidth = 0;
 
     upipe_throw_ready(upipe);
 
@@ -385,12 +609,33 @@ static void upipe_hls_playlist_no_ref(struct upipe *upipe)
         upipe_hls_playlist_from_upipe(upipe);
 
     upipe_hls_playlist_clean_upipe_key(upipe);
+    upipe_hls_playlist_clean_prefetches(upipe);
     upipe_hls_playlist_clean_setflowdef(upipe);
     upipe_hls_playlist_clean_src(upipe);
     upipe_mgr_release(upipe_hls_playlist->source_mgr);
     upipe_hls_playlist_release_urefcount_real(upipe);
 }
 
+/** @internal @This applies the uclock and output size to a source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param src source pipe
+ * @return an error code
+ */
+static int upipe_hls_playlist_setup_src(struct upipe *upipe,
+                                        struct upipe *src)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    if (upipe_hls_playlist->attach_uclock)
+        UBASE_RETURN(upipe_attach_uclock(src));
+    if (upipe_hls_playlist->output_size)
+        UBASE_RETURN(upipe_set_output_size(src,
+                                           upipe_hls_playlist->output_size));
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This sets the inner source pipe of the playlist.
  *
  * @param upipe description structure of the pipe
@@ -400,24 +645,11 @@ static void upipe_hls_playlist_no_ref(struct upipe *upipe)
 static int upipe_hls_playlist_set_src(struct upipe *upipe,
                                       struct upipe *src)
 {
-    struct upipe_hls_playlist *upipe_hls_playlist =
-        upipe_hls_playlist_from_upipe(upipe);
-    int ret;
-
     if (src) {
-        if (upipe_hls_playlist->attach_uclock) {
-            ret = upipe_attach_uclock(src);
-            if (unlikely(!ubase_check(ret))) {
-                upipe_release(src);
-                return ret;
-            }
-        }
-        if (upipe_hls_playlist->output_size) {
-            ret = upipe_set_output_size(src, upipe_hls_playlist->output_size);
-            if (unlikely(!ubase_check(ret))) {
-                upipe_release(src);
-                return ret;
-            }
+        int ret = upipe_hls_playlist_setup_src(upipe, src);
+        if (unlikely(!ubase_check(ret))) {
+            upipe_release(src);
+            return ret;
         }
     }
     upipe_hls_playlist_store_src(upipe, src);
@@ -439,6 +671,130 @@ static int upipe_hls_playlist_check_source_mgr(struct upipe *upipe)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This starts the download of an item.
+ *
+ * @param upipe description structure of the pipe
+ * @param item item to download
+ * @param index media sequence of the item
+ * @param uri resolved URI of the item
+ * @return pointer to the download or NULL in case of error
+ */
+static struct upipe_hls_playlist_prefetch *
+upipe_hls_playlist_prefetch_alloc(struct upipe *upipe, struct uref *item,
+                                  uint64_t index, const char *uri)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    if (unlikely(!ubase_check(upipe_hls_playlist_check_source_mgr(upipe))))
+        return NULL;
+    struct upipe_mgr *upipe_probe_uref_mgr = upipe_probe_uref_mgr_alloc();
+    if (unlikely(upipe_probe_uref_mgr == NULL))
+        return NULL;
+    struct upipe_hls_playlist_prefetch *prefetch = malloc(sizeof (*prefetch));
+    if (unlikely(prefetch == NULL)) {
+        upipe_mgr_release(upipe_probe_uref_mgr);
+        return NULL;
+    }
+
+    upipe_hls_playlist_prefetch_init_urefcount(prefetch);
+    prefetch->upipe = upipe_hls_playlist_use_urefcount_real(upipe);
+    prefetch->index = index;
+    prefetch->src = NULL;
+    prefetch->sink = NULL;
+    ulist_init(&prefetch->urefs);
+    prefetch->size = 0;
+    prefetch->first_sys = UINT64_MAX;
+    prefetch->last_sys = 0;
+    prefetch->ended = false;
+    prefetch->active = false;
+    uprobe_init(&prefetch->probe_src, probe_prefetch_src, NULL);
+    prefetch->probe_src.refcount = &prefetch->urefcount;
+    uprobe_init(&prefetch->probe_sink, probe_prefetch_sink, NULL);
+    prefetch->probe_sink.refcount = &prefetch->urefcount;
+    ulist_add(&upipe_hls_playlist->prefetches, &prefetch->uchain);
+
+    prefetch->src = upipe_void_alloc(
+        upipe_hls_playlist->source_mgr,
+        uprobe_pfx_alloc_va(uprobe_use(&prefetch->probe_src),
+                            UPROBE_LOG_VERBOSE, "src %"PRIu64, index));
+    if (likely(prefetch->src != NULL))
+        prefetch->sink = upipe_void_alloc_output(
+            prefetch->src, upipe_probe_uref_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(&prefetch->probe_sink),
+                                UPROBE_LOG_VERBOSE, "sink %"PRIu64, index));
+    upipe_mgr_release(upipe_probe_uref_mgr);
+
+    uint64_t range_off = 0;
+    uref_m3u_playlist_get_byte_range_off(item, &range_off);
+    uint64_t range_len = (uint64_t)-1;
+    uref_m3u_playlist_get_byte_range_len(item, &range_len);
+    if (unlikely(prefetch->sink == NULL) ||
+        unlikely(!ubase_check(upipe_hls_playlist_setup_src(
+                    upipe, prefetch->src))) ||
+        unlikely(!ubase_check(upipe_set_uri(prefetch->src, uri))) ||
+        unlikely(!ubase_check(upipe_src_set_range(prefetch->src,
+                                                  range_off, range_len)))) {
+        upipe_hls_playlist_prefetch_stop(prefetch);
+        return NULL;
+    }
+    return prefetch;
+}
+
+/** @internal @This finds the download of an item.
+ *
+ * @param upipe description structure of the pipe
+ * @param index media sequence of the item
+ * @return pointer to the download or NULL
+ */
+static struct upipe_hls_playlist_prefetch *
+upipe_hls_playlist_prefetch_find(struct upipe *upipe, uint64_t index)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->prefetches, uchain) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        if (prefetch->index == index)
+            return prefetch;
+    }
+    return NULL;
+}
+
+/** @internal @This outputs a downloaded item, starting with the data
+ * received in advance.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch download of the item
+ * @return an error code
+ */
+static int upipe_hls_playlist_prefetch_play(
+    struct upipe *upipe,
+    struct upipe_hls_playlist_prefetch *prefetch)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct upipe *setflowdef = upipe_hls_playlist->setflowdef;
+
+    ulist_delete(&prefetch->uchain);
+    prefetch->active = true;
+    if (upipe_hls_playlist->current != NULL)
+        upipe_hls_playlist_prefetch_stop(upipe_hls_playlist->current);
+    upipe_hls_playlist->current = prefetch;
+    upipe_hls_playlist_store_src(upipe, NULL);
+
+    if (!ulist_empty(&prefetch->urefs)) {
+        struct uref *flow_def = NULL;
+        UBASE_RETURN(upipe_get_flow_def(prefetch->sink, &flow_def));
+        UBASE_RETURN(upipe_set_flow_def(setflowdef, flow_def));
+    }
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&prefetch->urefs)) != NULL)
+        upipe_input(setflowdef, uref_from_uchain(uchain), NULL);
+    return upipe_set_output(prefetch->sink, setflowdef);
+}
+
 /** @internal @This creates the inner pipeline to get a key.
  *
  * @param upipe description structure of the pipe
@@ -575,22 +931,17 @@ static void upipe_hls_playlist_need_reload(struct upipe *upipe)
  *
  * @param upipe description structure of the pipe
  * @param item item to play
- * @param uuri the URI of the item to play
+ * @param uri the URI of the item to play
  * @return an error code
  */
 static int upipe_hls_playlist_play_uri(struct upipe *upipe,
                                        struct uref *item,
-                                       struct uuri *uuri)
+                                       const char *uri)
 {
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     struct uref *input_flow_def = upipe_hls_playlist->input_flow_def;
 
-    size_t len;
-    UBASE_RETURN(uuri_len(uuri, &len));
-    char uri[len + 1];
-    UBASE_RETURN(uuri_to_buffer(uuri, uri, sizeof (uri)));
-
     uint64_t media_sequence = 0;
     uref_m3u_playlist_flow_get_media_sequence(input_flow_def, &media_sequence);
     uint64_t last_sequence = media_sequence;
@@ -630,59 +981,78 @@ static int upipe_hls_playlist_play_uri(struct upipe *upipe,
     }
     UBASE_RETURN(upipe_hls_playlist_update_flow_def(upipe));
 
-    UBASE_RETURN(upipe_hls_playlist_check_source_mgr(upipe));
-    struct upipe *inner = upipe_void_alloc(
-        upipe_hls_playlist->source_mgr,
-        uprobe_pfx_alloc(
-            uprobe_use(&upipe_hls_playlist->probe_src),
-            UPROBE_LOG_VERBOSE, "src"));
-    UBASE_ALLOC_RETURN(inner);
-    UBASE_RETURN(upipe_set_output(inner, upipe_hls_playlist->setflowdef));
-    UBASE_RETURN(upipe_set_uri(inner, uri));
-    UBASE_RETURN(upipe_hls_playlist_set_src(upipe, inner));
-
-    uint64_t range_off = 0;
-    uref_m3u_playlist_get_byte_range_off(item, &range_off);
-    uint64_t range_len = (uint64_t)-1;
-    uref_m3u_playlist_get_byte_range_len(item, &range_len);
-    UBASE_RETURN(upipe_src_set_range(inner, range_off, range_len));
+    struct upipe_hls_playlist_prefetch *prefetch = NULL;
+    if (upipe_hls_playlist->prefetch) {
+        prefetch = upipe_hls_playlist_prefetch_find(
+            upipe, upipe_hls_playlist->index);
+        if (prefetch == NULL)
+            prefetch = upipe_hls_playlist_prefetch_alloc(
+                upipe, item, upipe_hls_playlist->index, uri);
+        else
+            upipe_dbg(upipe, "item was prefetched");
+        UBASE_ALLOC_RETURN(prefetch);
+        UBASE_RETURN(upipe_hls_playlist_prefetch_play(upipe, prefetch));
+    }
+    else {
+        if (upipe_hls_playlist->current != NULL) {
+            upipe_hls_playlist_prefetch_stop(upipe_hls_playlist->current);
+            upipe_hls_playlist->current = NULL;
+        }
+        UBASE_RETURN(upipe_hls_playlist_check_source_mgr(upipe));
+        struct upipe *inner = upipe_void_alloc(
+            upipe_hls_playlist->source_mgr,
+            uprobe_pfx_alloc(
+                uprobe_use(&upipe_hls_playlist->probe_src),
+                UPROBE_LOG_VERBOSE, "src"));
+        UBASE_ALLOC_RETURN(inner);
+        UBASE_RETURN(upipe_set_output(inner, upipe_hls_playlist->setflowdef));
+        UBASE_RETURN(upipe_set_uri(inner, uri));
+        UBASE_RETURN(upipe_hls_playlist_set_src(upipe, inner));
+
+        uint64_t range_off = 0;
+        uref_m3u_playlist_get_byte_range_off(item, &range_off);
+        uint64_t range_len = (uint64_t)-1;
+        uref_m3u_playlist_get_byte_range_len(item, &range_len);
+        UBASE_RETURN(upipe_src_set_range(inner, range_off, range_len));
+    }
     upipe_dbg(upipe, "playing");
     upipe_hls_playlist->playing = true;
     if (upipe_hls_playlist->index >= last_sequence - 1) {
         upipe_warn(upipe, "reach the end of the playlist");
         upipe_hls_playlist_need_reload(upipe);
     }
+    if (prefetch != NULL && prefetch->ended) {
+        /* the whole item was prefetched */
+        upipe_dbg(upipe, "stopped");
+        upipe_hls_playlist->playing = false;
+        return upipe_hls_playlist_throw_item_end(upipe);
+    }
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This plays an item.
+/** @internal @This resolves the URI of an item.
  *
  * @param upipe description structure of the pipe
- * @param item item to play
+ * @param item playlist item
+ * @param uri_p filled with an allocated string to free after use
  * @return an error code
  */
-static int upipe_hls_playlist_play_item(struct upipe *upipe,
-                                        struct uref *item)
+static int upipe_hls_playlist_item_uri(struct upipe *upipe,
+                                       struct uref *item,
+                                       char **uri_p)
 {
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     struct uref *input_flow_def = upipe_hls_playlist->input_flow_def;
     int ret;
 
-    if (unlikely(input_flow_def == NULL) || unlikely(item == NULL))
-        return UBASE_ERR_INVALID;
-
-    upipe_verbose_va(upipe, "play item sequence %"PRIu64,
-                     upipe_hls_playlist->index);
-    uref_dump(item, upipe->uprobe);
-
     const char *m3u_uri;
     UBASE_RETURN(uref_m3u_get_uri(item, &m3u_uri));
 
     struct uuri uuri;
     if (ubase_check(uuri_from_str(&uuri, m3u_uri)))
         /* this is a valid URI, we can directly play it */
-        return upipe_hls_playlist_play_uri(upipe, item, &uuri);
+        return uuri_to_str(&uuri, uri_p);
 
     UBASE_RETURN(uref_uri_get(input_flow_def, &uuri));
     uuri.query = ustring_null();
@@ -692,7 +1062,7 @@ static int upipe_hls_playlist_play_item(struct upipe *upipe,
         char uri[uuri.scheme.len + 1 + strlen(m3u_uri) + 1];
         sprintf(uri, "%.*s:%s", (int)uuri.scheme.len, uuri.scheme.at, m3u_uri);
         if (ubase_check(uuri_from_str(&uuri, uri)))
-            return upipe_hls_playlist_play_uri(upipe, item, &uuri);
+            return uuri_to_str(&uuri, uri_p);
         else {
             upipe_err(upipe, "invalid uri");
             return UBASE_ERR_INVALID;
@@ -701,7 +1071,7 @@ static int upipe_hls_playlist_play_item(struct upipe *upipe,
     if (strlen(m3u_uri) && *m3u_uri == '/') {
         /* use the item absolute path with the input scheme */
         uuri.path = ustring_from_str(m3u_uri);
-        return upipe_hls_playlist_play_uri(upipe, item, &uuri);
+        return uuri_to_str(&uuri, uri_p);
     }
 
     /* use the item relative path with the input path as root path */
@@ -713,7 +1083,83 @@ static int upipe_hls_playlist_play_item(struct upipe *upipe,
     if (ret < 0 || (unsigned)ret >= sizeof (new_path))
         return UBASE_ERR_NOSPC;
     uuri.path = ustring_from_str(new_path);
-    return upipe_hls_playlist_play_uri(upipe, item, &uuri);
+    return uuri_to_str(&uuri, uri_p);
+}
+
+/** @internal @This plays an item.
+ *
+ * @param upipe description structure of the pipe
+ * @param item item to play
+ * @return an error code
+ */
+static int upipe_hls_playlist_play_item(struct upipe *upipe,
+                                        struct uref *item)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uref *input_flow_def = upipe_hls_playlist->input_flow_def;
+
+    if (unlikely(input_flow_def == NULL) || unlikely(item == NULL))
+        return UBASE_ERR_INVALID;
+
+    upipe_verbose_va(upipe, "play item sequence %"PRIu64,
+                     upipe_hls_playlist->index);
+    uref_dump(item, upipe->uprobe);
+
+    char *uri;
+    UBASE_RETURN(upipe_hls_playlist_item_uri(upipe, item, &uri));
+    int ret = upipe_hls_playlist_play_uri(upipe, item, uri);
+    free(uri);
+    return ret;
+}
+
+/** @internal @This starts the downloads of the upcoming items, and stops
+ * the ones that are no longer needed.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_playlist_prefetch_update(struct upipe *upipe)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    struct uref *input_flow_def = upipe_hls_playlist->input_flow_def;
+    uint64_t index = upipe_hls_playlist->index;
+    uint64_t last = index + upipe_hls_playlist->prefetch;
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_hls_playlist->prefetches, uchain, uchain_tmp) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        if (index == (uint64_t)-1 ||
+            prefetch->index <= index || prefetch->index > last)
+            upipe_hls_playlist_prefetch_stop(prefetch);
+    }
+    if (index == (uint64_t)-1 || input_flow_def == NULL)
+        return;
+
+    uint64_t sequence = 0;
+    uref_m3u_playlist_flow_get_media_sequence(input_flow_def, &sequence);
+    ulist_foreach(&upipe_hls_playlist->items, uchain) {
+        uint64_t item_index = sequence++;
+        if (item_index <= index)
+            continue;
+        if (item_index > last)
+            break;
+        if (upipe_hls_playlist_prefetch_find(upipe, item_index) != NULL)
+            continue;
+
+        struct uref *item = uref_from_uchain(uchain);
+        char *uri;
+        if (unlikely(!ubase_check(upipe_hls_playlist_item_uri(upipe, item,
+                                                              &uri))))
+            continue;
+        upipe_dbg_va(upipe, "prefetch item %"PRIu64, item_index);
+        if (unlikely(upipe_hls_playlist_prefetch_alloc(
+                    upipe, item, item_index, uri) == NULL))
+            upipe_warn_va(upipe, "unable to prefetch item %"PRIu64,
+                          item_index);
+        free(uri);
+    }
 }
 
 /** @internal @This gets a media sequence by its sequence number.
@@ -840,7 +1286,9 @@ static int _upipe_hls_playlist_play(struct upipe *upipe)
             return upipe_hls_playlist_get_key(upipe, method, key_uri);
     }
 
-    return upipe_hls_playlist_play_item(upipe, item);
+    UBASE_RETURN(upipe_hls_playlist_play_item(upipe, item));
+    upipe_hls_playlist_prefetch_update(upipe);
+    return UBASE_ERR_NONE;
 }
 
 /** @internal @This goes to the next element in the playlist.
@@ -894,7 +1342,10 @@ static void upipe_hls_playlist_input(struct upipe *upipe,
 
     if (unlikely(!upipe_hls_playlist->reloading)) {
         upipe_dbg(upipe, "playlist start");
-        upipe_hls_playlist_flush(upipe);
+        if (!upipe_hls_playlist->input_flow_def ||
+            !ubase_check(uref_m3u_playlist_flow_get_append(
+                    upipe_hls_playlist->input_flow_def)))
+            upipe_hls_playlist_flush(upipe);
         upipe_hls_playlist->reloading = true;
     }
 
@@ -906,6 +1357,31 @@ static void upipe_hls_playlist_input(struct upipe *upipe,
     }
 }
 
+/** @internal @This removes the items that are no longer in an appended
+ * playlist.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def new input flow definition
+ */
+static void upipe_hls_playlist_trim(struct upipe *upipe,
+                                    struct uref *flow_def)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+
+    uint64_t old_media_sequence = 0, media_sequence = 0;
+    if (upipe_hls_playlist->input_flow_def != NULL)
+        uref_m3u_playlist_flow_get_media_sequence(
+            upipe_hls_playlist->input_flow_def, &old_media_sequence);
+    uref_m3u_playlist_flow_get_media_sequence(flow_def, &media_sequence);
+
+    struct uchain *uchain;
+    for (; old_media_sequence < media_sequence &&
+         (uchain = ulist_pop(&upipe_hls_playlist->items)) != NULL;
+         old_media_sequence++)
+        uref_free(uref_from_uchain(uchain));
+}
+
 /** @internal @This stores a new input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -994,6 +1470,8 @@ static int upipe_hls_playlist_set_flow_def(struct upipe *upipe,
             upipe_hls_playlist_set_upump(upipe, NULL);
         }
     }
+    if (ubase_check(uref_m3u_playlist_flow_get_append(flow_def_dup)))
+        upipe_hls_playlist_trim(upipe, flow_def_dup);
     upipe_hls_playlist_store_input_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -1089,6 +1567,16 @@ static int upipe_hls_playlist_set_output_size(struct upipe *upipe,
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     upipe_hls_playlist->output_size = output_size;
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->prefetches, uchain) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        UBASE_RETURN(upipe_set_output_size(prefetch->src, output_size));
+    }
+    if (upipe_hls_playlist->current != NULL &&
+        upipe_hls_playlist->current->src != NULL)
+        UBASE_RETURN(upipe_set_output_size(upipe_hls_playlist->current->src,
+                                           output_size));
     if (likely(upipe_hls_playlist->src != NULL))
         return upipe_set_output_size(upipe_hls_playlist->src, output_size);
     return UBASE_ERR_NONE;
@@ -1104,11 +1592,37 @@ static int upipe_hls_playlist_attach_uclock(struct upipe *upipe)
     struct upipe_hls_playlist *upipe_hls_playlist =
         upipe_hls_playlist_from_upipe(upipe);
     upipe_hls_playlist->attach_uclock = true;
+    struct uchain *uchain;
+    ulist_foreach(&upipe_hls_playlist->prefetches, uchain) {
+        struct upipe_hls_playlist_prefetch *prefetch =
+            upipe_hls_playlist_prefetch_from_uchain(uchain);
+        UBASE_RETURN(upipe_attach_uclock(prefetch->src));
+    }
+    if (upipe_hls_playlist->current != NULL &&
+        upipe_hls_playlist->current->src != NULL)
+        UBASE_RETURN(upipe_attach_uclock(upipe_hls_playlist->current->src));
     if (upipe_hls_playlist->src != NULL)
         return upipe_attach_uclock(upipe_hls_playlist->src);
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the number of upcoming items downloaded in advance.
+ *
+ * @param upipe description structure of the pipe
+ * @param prefetch prefetch depth
+ * @return an error code
+ */
+static int _upipe_hls_playlist_set_prefetch(struct upipe *upipe,
+                                            unsigned int prefetch)
+{
+    struct upipe_hls_playlist *upipe_hls_playlist =
+        upipe_hls_playlist_from_upipe(upipe);
+    upipe_hls_playlist->prefetch = prefetch;
+    if (upipe_hls_playlist->playing)
+        upipe_hls_playlist_prefetch_update(upipe);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This dispatches commands.
  *
  * @param upipe description structure of the pipe
@@ -1145,6 +1659,8 @@ static int upipe_hls_playlist_control_internal(struct upipe *upipe,
             upipe_hls_playlist_from_upipe(upipe);
         struct upipe **p = va_arg(args, struct upipe **);
         *p = upipe_hls_playlist->src;
+        if (*p == NULL && upipe_hls_playlist->current != NULL)
+            *p = upipe_hls_playlist->current->src;
         return (*p != NULL) ? UBASE_ERR_NONE : UBASE_ERR_UNHANDLED;
     }
 
@@ -1176,6 +1692,30 @@ static int upipe_hls_playlist_control_internal(struct upipe *upipe,
         return _upipe_hls_playlist_seek(upipe, at, offset_p);
     }
 
+    case UPIPE_HLS_PLAYLIST_GET_PREFETCH: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_PLAYLIST_SIGNATURE);
+        struct upipe_hls_playlist *upipe_hls_playlist =
+            upipe_hls_playlist_from_upipe(upipe);
+        unsigned int *prefetch_p = va_arg(args, unsigned int *);
+        *prefetch_p = upipe_hls_playlist->prefetch;
+        return UBASE_ERR_NONE;
+    }
+    case UPIPE_HLS_PLAYLIST_SET_PREFETCH: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_PLAYLIST_SIGNATURE);
+        unsigned int prefetch = va_arg(args, unsigned int);
+        return _upipe_hls_playlist_set_prefetch(upipe, prefetch);
+    }
+    case UPIPE_HLS_PLAYLIST_GET_BANDWIDTH: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_PLAYLIST_SIGNATURE);
+        struct upipe_hls_playlist *upipe_hls_playlist =
+            upipe_hls_playlist_from_upipe(upipe);
+        uint64_t *bandwidth_p = va_arg(args, uint64_t *);
+        if (!upipe_hls_playlist->bandwidth)
+            return UBASE_ERR_INVALID;
+        *bandwidth_p = upipe_hls_playlist->bandwidth;
+        return UBASE_ERR_NONE;
+    }
+
     default:
         return upipe_hls_playlist_control_bin_output(upipe, command, args);
     }
@@ -0,0 +1,783 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe sink module writing HLS segments and playlists
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_clock.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe-modules/upipe_file_sink.h"
+#include "upipe-hls/upipe_hls_sink.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/pes.h>
+
+#ifndef O_CLOEXEC
+#   define O_CLOEXEC 0
+#endif
+
+/** we only accept blocks */
+#define EXPECTED_FLOW_DEF "block."
+/** default target duration of the segments */
+#define DEFAULT_TARGET_DURATION (6 * UCLOCK_FREQ)
+/** name of the initialization segment of fragmented MP4 flows */
+#define INIT_SEGMENT "init.mp4"
+
+/** @internal @This is the private context of a hls sink pipe. */
+struct upipe_hls_sink {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** input flow definition */
+    struct uref *flow_def;
+    /** inner file sink */
+    struct upipe *fsink;
+
+    /** path of the media playlist */
+    char *playlist;
+    /** directory of the media playlist, with a trailing slash */
+    char *dir;
+    /** segment prefix */
+    char *prefix;
+    /** segment suffix */
+    const char *suffix;
+    /** path of the master playlist, or NULL */
+    char *master;
+    /** media playlist file descriptor, or -1 */
+    int fd;
+    /** true if the random access points are searched in TS packets */
+    bool ts;
+
+    /** target duration of the segments */
+    uint64_t target_duration;
+    /** duration of the partial segments, or 0 */
+    uint64_t part_duration;
+
+    /** media sequence of the current segment */
+    uint64_t sequence;
+    /** true if a segment is being written */
+    bool segment;
+    /** date of the beginning of the segment */
+    uint64_t segment_start;
+    /** octets written to the segment */
+    uint64_t segment_size;
+    /** date of the beginning of the partial segment */
+    uint64_t part_start;
+    /** offset of the partial segment in the segment */
+    uint64_t part_offset;
+    /** true if the partial segment starts with a random access point */
+    bool part_independent;
+    /** date of the end of the last uref */
+    uint64_t last_date;
+    /** true if the variant was added to the master playlist */
+    bool master_written;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_hls_sink, upipe, UPIPE_HLS_SINK_SIGNATURE);
+UPIPE_HELPER_UREFCOUNT(upipe_hls_sink, urefcount, upipe_hls_sink_free)
+UPIPE_HELPER_VOID(upipe_hls_sink)
+
+/** @internal @This allocates a hls sink pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_hls_sink_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_hls_sink_alloc_void(mgr, uprobe, signature,
+                                                    args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink_init_urefcount(upipe);
+    upipe_hls_sink->flow_def = NULL;
+    upipe_hls_sink->fsink = NULL;
+    upipe_hls_sink->playlist = NULL;
+    upipe_hls_sink->dir = NULL;
+    upipe_hls_sink->prefix = NULL;
+    upipe_hls_sink->suffix = ".bin";
+    upipe_hls_sink->master = NULL;
+    upipe_hls_sink->fd = -1;
+    upipe_hls_sink->ts = false;
+    upipe_hls_sink->target_duration = DEFAULT_TARGET_DURATION;
+    upipe_hls_sink->part_duration = 0;
+    upipe_hls_sink->sequence = 0;
+    upipe_hls_sink->segment = false;
+    upipe_hls_sink->segment_start = 0;
+    upipe_hls_sink->segment_size = 0;
+    upipe_hls_sink->part_start = 0;
+    upipe_hls_sink->part_offset = 0;
+    upipe_hls_sink->part_independent = false;
+    upipe_hls_sink->last_date = 0;
+    upipe_hls_sink->master_written = false;
+    upipe_throw_ready(upipe);
+
+    struct upipe_mgr *fsink_mgr = upipe_fsink_mgr_alloc();
+    if (unlikely(fsink_mgr == NULL)) {
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_hls_sink->fsink = upipe_void_alloc(fsink_mgr,
+        uprobe_pfx_alloc(uprobe_use(upipe->uprobe),
+                         UPROBE_LOG_VERBOSE, "fsink"));
+    upipe_mgr_release(fsink_mgr);
+    if (unlikely(upipe_hls_sink->fsink == NULL)) {
+        upipe_release(upipe);
+        return NULL;
+    }
+    return upipe;
+}
+
+/** @internal @This appends formatted text to a playlist, in a single
+ * write so that a reader never sees a partial update.
+ *
+ * @param upipe description structure of the pipe
+ * @param fd playlist file descriptor
+ * @param format printf-style format, followed by arguments
+ * @return an error code
+ */
+UBASE_FMT_PRINTF(3, 4)
+static int upipe_hls_sink_append(struct upipe *upipe, int fd,
+                                 const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (unlikely(len < 0))
+        return UBASE_ERR_INVALID;
+
+    char buffer[len + 1];
+    va_start(args, format);
+    vsnprintf(buffer, sizeof (buffer), format, args);
+    va_end(args);
+
+    if (unlikely(write(fd, buffer, len) != len)) {
+        upipe_err_va(upipe, "unable to write playlist (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the bandwidth of the variant for the master
+ * playlist.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration duration of the first segment
+ * @return the bandwidth in bits per second
+ */
+static uint64_t upipe_hls_sink_bandwidth(struct upipe *upipe,
+                                         uint64_t duration)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    uint64_t octetrate = 0;
+    if (!ubase_check(uref_block_flow_get_max_octetrate(
+                upipe_hls_sink->flow_def, &octetrate)))
+        uref_block_flow_get_octetrate(upipe_hls_sink->flow_def, &octetrate);
+    if (octetrate)
+        return octetrate * 8;
+    if (!duration)
+        return 0;
+    return upipe_hls_sink->segment_size * 8 * UCLOCK_FREQ / duration;
+}
+
+/** @internal @This appends the variant to the master playlist.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration duration of the first segment
+ */
+static void upipe_hls_sink_write_master(struct upipe *upipe,
+                                        uint64_t duration)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink->master_written = true;
+    if (upipe_hls_sink->master == NULL)
+        return;
+
+    int fd = open(upipe_hls_sink->master,
+                  O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "unable to open master playlist %s (%m)",
+                     upipe_hls_sink->master);
+        return;
+    }
+
+    /* make the playlist path relative to the master playlist */
+    const char *uri = upipe_hls_sink->playlist;
+    const char *slash = strrchr(upipe_hls_sink->master, '/');
+    if (slash != NULL) {
+        size_t len = slash + 1 - upipe_hls_sink->master;
+        if (!strncmp(uri, upipe_hls_sink->master, len))
+            uri += len;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size == 0)
+        upipe_hls_sink_append(upipe, fd, "#EXTM3U\n");
+    upipe_hls_sink_append(upipe, fd,
+                          "#EXT-X-STREAM-INF:BANDWIDTH=%"PRIu64"\n%s\n",
+                          upipe_hls_sink_bandwidth(upipe, duration), uri);
+    close(fd);
+    upipe_notice_va(upipe, "added variant to %s", upipe_hls_sink->master);
+}
+
+/** @internal @This writes the initialization segment of a fragmented MP4
+ * flow, from the global headers of the flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_hls_sink_write_init(struct upipe *upipe)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    const uint8_t *headers;
+    size_t size;
+    if (upipe_hls_sink->ts ||
+        !ubase_check(uref_flow_get_headers(upipe_hls_sink->flow_def,
+                                           &headers, &size)))
+        return UBASE_ERR_NONE;
+
+    char path[MAXPATHLEN];
+    snprintf(path, sizeof (path), "%s%s%s", upipe_hls_sink->dir,
+             upipe_hls_sink->prefix, INIT_SEGMENT);
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "unable to open %s (%m)", path);
+        return UBASE_ERR_EXTERNAL;
+    }
+    ssize_t ret = write(fd, headers, size);
+    close(fd);
+    if (unlikely(ret != (ssize_t)size)) {
+        upipe_err_va(upipe, "unable to write %s", path);
+        return UBASE_ERR_EXTERNAL;
+    }
+    return upipe_hls_sink_append(upipe, upipe_hls_sink->fd,
+                                 "#EXT-X-MAP:URI=\"%s%s\"\n",
+                                 upipe_hls_sink->prefix, INIT_SEGMENT);
+}
+
+/** @internal @This creates the media playlist and writes its header.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_hls_sink_open_playlist(struct upipe *upipe)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    int fd = open(upipe_hls_sink->playlist,
+                  O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "unable to open playlist %s (%m)",
+                     upipe_hls_sink->playlist);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_hls_sink->fd = fd;
+    upipe_notice_va(upipe, "writing playlist %s", upipe_hls_sink->playlist);
+
+    UBASE_RETURN(upipe_hls_sink_append(upipe, fd,
+        "#EXTM3U\n"
+        "#EXT-X-VERSION:6\n"
+        "#EXT-X-TARGETDURATION:%"PRIu64"\n"
+        "#EXT-X-MEDIA-SEQUENCE:%"PRIu64"\n"
+        "#EXT-X-PLAYLIST-TYPE:EVENT\n"
+        "#EXT-X-INDEPENDENT-SEGMENTS\n",
+        (upipe_hls_sink->target_duration + UCLOCK_FREQ - 1) / UCLOCK_FREQ,
+        upipe_hls_sink->sequence));
+    if (upipe_hls_sink->part_duration) {
+        double part = (double)upipe_hls_sink->part_duration / UCLOCK_FREQ;
+        UBASE_RETURN(upipe_hls_sink_append(upipe, fd,
+            "#EXT-X-PART-INF:PART-TARGET=%.5f\n"
+            "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%.5f\n",
+            part, part * 3));
+    }
+    return upipe_hls_sink_write_init(upipe);
+}
+
+/** @internal @This announces the partial segment being written.
+ *
+ * @param upipe description structure of the pipe
+ * @param date date of the end of the partial segment
+ */
+static void upipe_hls_sink_close_part(struct upipe *upipe, uint64_t date)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (!upipe_hls_sink->part_duration ||
+        upipe_hls_sink->segment_size <= upipe_hls_sink->part_offset)
+        return;
+
+    upipe_hls_sink_append(upipe, upipe_hls_sink->fd,
+        "#EXT-X-PART:DURATION=%.5f,URI=\"%s%"PRIu64"%s\","
+        "BYTERANGE=\"%"PRIu64"@%"PRIu64"\"%s\n",
+        (double)(date - upipe_hls_sink->part_start) / UCLOCK_FREQ,
+        upipe_hls_sink->prefix, upipe_hls_sink->sequence,
+        upipe_hls_sink->suffix,
+        upipe_hls_sink->segment_size - upipe_hls_sink->part_offset,
+        upipe_hls_sink->part_offset,
+        upipe_hls_sink->part_independent ? ",INDEPENDENT=YES" : "");
+    upipe_hls_sink->part_start = date;
+    upipe_hls_sink->part_offset = upipe_hls_sink->segment_size;
+    upipe_hls_sink->part_independent = false;
+}
+
+/** @internal @This announces the segment being written.
+ *
+ * @param upipe description structure of the pipe
+ * @param date date of the end of the segment
+ */
+static void upipe_hls_sink_close_segment(struct upipe *upipe, uint64_t date)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink_close_part(upipe, date);
+
+    uint64_t duration = date - upipe_hls_sink->segment_start;
+    if (duration > upipe_hls_sink->target_duration + UCLOCK_FREQ / 2)
+        upipe_warn_va(upipe, "segment %"PRIu64" exceeds the target duration "
+                      "(%.2f s)", upipe_hls_sink->sequence,
+                      (double)duration / UCLOCK_FREQ);
+    upipe_hls_sink_append(upipe, upipe_hls_sink->fd,
+                          "#EXTINF:%.5f,\n%s%"PRIu64"%s\n",
+                          (double)duration / UCLOCK_FREQ,
+                          upipe_hls_sink->prefix, upipe_hls_sink->sequence,
+                          upipe_hls_sink->suffix);
+    if (!upipe_hls_sink->master_written)
+        upipe_hls_sink_write_master(upipe, duration);
+
+    upipe_hls_sink->sequence++;
+    upipe_hls_sink->segment = false;
+}
+
+/** @internal @This starts a new segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param date date of the beginning of the segment
+ * @return an error code
+ */
+static int upipe_hls_sink_open_segment(struct upipe *upipe, uint64_t date)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (upipe_hls_sink->fd == -1)
+        UBASE_RETURN(upipe_hls_sink_open_playlist(upipe));
+
+    char path[MAXPATHLEN];
+    snprintf(path, sizeof (path), "%s%s%"PRIu64"%s", upipe_hls_sink->dir,
+             upipe_hls_sink->prefix, upipe_hls_sink->sequence,
+             upipe_hls_sink->suffix);
+    UBASE_RETURN(upipe_fsink_set_path(upipe_hls_sink->fsink, path,
+                                      UPIPE_FSINK_OVERWRITE));
+
+    upipe_hls_sink->segment = true;
+    upipe_hls_sink->segment_start = date;
+    upipe_hls_sink->segment_size = 0;
+    upipe_hls_sink->part_start = date;
+    upipe_hls_sink->part_offset = 0;
+    upipe_hls_sink->part_independent = true;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This looks for a video random access point in a buffer of
+ * TS packets.
+ *
+ * @param uref uref structure
+ * @param offset_p filled in with the offset of the packet
+ * @return true if a random access point was found
+ */
+static bool upipe_hls_sink_find_rap(struct uref *uref, size_t *offset_p)
+{
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size))))
+        return false;
+
+    for (size_t offset = 0; offset + TS_SIZE <= size; offset += TS_SIZE) {
+        uint8_t buffer[TS_SIZE];
+        const uint8_t *ts = uref_block_peek(uref, offset, TS_SIZE, buffer);
+        if (unlikely(ts == NULL))
+            return false;
+
+        bool rap = false;
+        if (ts_validate(ts) && ts_get_unitstart(ts) && ts_has_payload(ts) &&
+            ts_has_adaptation(ts) && ts_get_adaptation(ts) &&
+            tsaf_has_randomaccess(ts)) {
+            const uint8_t *pes = ts_payload((uint8_t *)ts);
+            rap = pes + PES_HEADER_SIZE <= ts + TS_SIZE &&
+                  pes_validate(pes) &&
+                  (pes_get_streamid(pes) & 0xf0) == PES_STREAM_ID_VIDEO_MPEG;
+        }
+        uref_block_peek_unmap(uref, offset, buffer, ts);
+        if (rap) {
+            *offset_p = offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @internal @This writes a uref to the current segment, cutting a new
+ * segment or partial segment if needed.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param random true if the uref starts with a random access point
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_hls_sink_write(struct upipe *upipe, struct uref *uref,
+                                 bool random, struct upump **upump_p)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    uint64_t date = upipe_hls_sink->last_date;
+    if (!ubase_check(uref_clock_get_cr_prog(uref, &date)) &&
+        !ubase_check(uref_clock_get_dts_prog(uref, &date)))
+        uref_clock_get_cr_sys(uref, &date);
+
+    if (random && (!upipe_hls_sink->segment ||
+                   date - upipe_hls_sink->segment_start >=
+                   upipe_hls_sink->target_duration)) {
+        if (upipe_hls_sink->segment)
+            upipe_hls_sink_close_segment(upipe, date);
+        if (unlikely(!ubase_check(upipe_hls_sink_open_segment(upipe,
+                                                              date)))) {
+            uref_free(uref);
+            return;
+        }
+    }
+    else if (upipe_hls_sink->segment && upipe_hls_sink->part_duration &&
+             date - upipe_hls_sink->part_start >=
+             upipe_hls_sink->part_duration) {
+        upipe_hls_sink_close_part(upipe, date);
+        upipe_hls_sink->part_independent = random;
+    }
+
+    if (unlikely(!upipe_hls_sink->segment)) {
+        upipe_verbose(upipe, "waiting for a random access point");
+        uref_free(uref);
+        return;
+    }
+
+    uint64_t duration = 0;
+    uref_clock_get_duration(uref, &duration);
+    upipe_hls_sink->last_date = date + duration;
+    size_t size;
+    if (ubase_check(uref_block_size(uref, &size)))
+        upipe_hls_sink->segment_size += size;
+    upipe_input(upipe_hls_sink->fsink, uref, upump_p);
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_hls_sink_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (unlikely(upipe_hls_sink->playlist == NULL)) {
+        upipe_warn(upipe, "no playlist path, dropping");
+        uref_free(uref);
+        return;
+    }
+
+    bool random = ubase_check(uref_flow_get_random(uref));
+    size_t offset;
+    if (upipe_hls_sink->ts && upipe_hls_sink_find_rap(uref, &offset)) {
+        if (offset) {
+            /* write the packets before the random access point first */
+            struct uref *before = uref_dup(uref);
+            if (unlikely(before == NULL)) {
+                uref_free(uref);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+            uref_block_resize(before, 0, offset);
+            uref_block_resize(uref, offset, -1);
+            upipe_hls_sink_write(upipe, before, random, upump_p);
+        }
+        random = true;
+    }
+    upipe_hls_sink_write(upipe, uref, random, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_hls_sink_set_flow_def(struct upipe *upipe,
+                                       struct uref *flow_def)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    UBASE_RETURN(upipe_set_flow_def(upipe_hls_sink->fsink, flow_def))
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    uref_free(upipe_hls_sink->flow_def);
+    upipe_hls_sink->flow_def = flow_def_dup;
+
+    upipe_hls_sink->ts = false;
+    if (ubase_check(uref_flow_match_def(flow_def, "block.mpegts."))) {
+        upipe_hls_sink->suffix = ".ts";
+        upipe_hls_sink->ts = true;
+    } else if (ubase_check(uref_flow_match_def(flow_def, "block.mp4.")))
+        upipe_hls_sink->suffix = ".m4s";
+    else if (ubase_check(uref_flow_match_def(flow_def, "block.aac.")))
+        upipe_hls_sink->suffix = ".aac";
+    else
+        upipe_hls_sink->suffix = ".bin";
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This terminates the media playlist.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_sink_close_playlist(struct upipe *upipe)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    if (upipe_hls_sink->segment)
+        upipe_hls_sink_close_segment(upipe, upipe_hls_sink->last_date);
+    if (upipe_hls_sink->fd != -1) {
+        upipe_hls_sink_append(upipe, upipe_hls_sink->fd, "#EXT-X-ENDLIST\n");
+        ubase_clean_fd(&upipe_hls_sink->fd);
+    }
+}
+
+/** @internal @This sets the playlist path and the segment prefix.
+ *
+ * @param upipe description structure of the pipe
+ * @param playlist path of the media playlist
+ * @param prefix segment prefix
+ * @return an error code
+ */
+static int _upipe_hls_sink_set_path(struct upipe *upipe,
+                                    const char *playlist, const char *prefix)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    upipe_hls_sink_close_playlist(upipe);
+    upipe_fsink_set_path(upipe_hls_sink->fsink, NULL, UPIPE_FSINK_OVERWRITE);
+    free(upipe_hls_sink->playlist);
+    free(upipe_hls_sink->dir);
+    free(upipe_hls_sink->prefix);
+    upipe_hls_sink->playlist = NULL;
+    upipe_hls_sink->dir = NULL;
+    upipe_hls_sink->prefix = NULL;
+    upipe_hls_sink->sequence = 0;
+    upipe_hls_sink->master_written = false;
+    if (playlist == NULL)
+        return UBASE_ERR_NONE;
+
+    const char *slash = strrchr(playlist, '/');
+    upipe_hls_sink->playlist = strdup(playlist);
+    upipe_hls_sink->dir = strndup(playlist, slash ? slash + 1 - playlist : 0);
+    upipe_hls_sink->prefix = strdup(prefix ? prefix : "");
+    if (unlikely(upipe_hls_sink->playlist == NULL ||
+                 upipe_hls_sink->dir == NULL ||
+                 upipe_hls_sink->prefix == NULL)) {
+        free(upipe_hls_sink->playlist);
+        free(upipe_hls_sink->dir);
+        free(upipe_hls_sink->prefix);
+        upipe_hls_sink->playlist = NULL;
+        upipe_hls_sink->dir = NULL;
+        upipe_hls_sink->prefix = NULL;
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_notice_va(upipe, "setting playlist %s and prefix %s",
+                    playlist, upipe_hls_sink->prefix);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the path of the master playlist.
+ *
+ * @param upipe description structure of the pipe
+ * @param master path of the master playlist, or NULL
+ * @return an error code
+ */
+static int _upipe_hls_sink_set_master(struct upipe *upipe,
+                                      const char *master)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+    free(upipe_hls_sink->master);
+    upipe_hls_sink->master = NULL;
+    if (master != NULL) {
+        upipe_hls_sink->master = strdup(master);
+        UBASE_ALLOC_RETURN(upipe_hls_sink->master);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_hls_sink_control(struct upipe *upipe,
+                                  int command, va_list args)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_va(upipe_hls_sink->fsink, command, args);
+
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_hls_sink_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_HLS_SINK_GET_PATH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            const char **playlist_p = va_arg(args, const char **);
+            const char **prefix_p = va_arg(args, const char **);
+            *playlist_p = upipe_hls_sink->playlist;
+            *prefix_p = upipe_hls_sink->prefix;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_SET_PATH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            const char *playlist = va_arg(args, const char *);
+            const char *prefix = va_arg(args, const char *);
+            return _upipe_hls_sink_set_path(upipe, playlist, prefix);
+        }
+        case UPIPE_HLS_SINK_GET_TARGET_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            uint64_t *duration_p = va_arg(args, uint64_t *);
+            *duration_p = upipe_hls_sink->target_duration;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_SET_TARGET_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            uint64_t duration = va_arg(args, uint64_t);
+            if (unlikely(!duration))
+                return UBASE_ERR_INVALID;
+            if (unlikely(upipe_hls_sink->fd != -1))
+                return UBASE_ERR_BUSY;
+            upipe_hls_sink->target_duration = duration;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_GET_PART_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            uint64_t *duration_p = va_arg(args, uint64_t *);
+            *duration_p = upipe_hls_sink->part_duration;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_SET_PART_DURATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            uint64_t duration = va_arg(args, uint64_t);
+            if (unlikely(upipe_hls_sink->fd != -1))
+                return UBASE_ERR_BUSY;
+            upipe_hls_sink->part_duration = duration;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_HLS_SINK_SET_MASTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HLS_SINK_SIGNATURE)
+            const char *master = va_arg(args, const char *);
+            return _upipe_hls_sink_set_master(upipe, master);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_hls_sink_free(struct upipe *upipe)
+{
+    struct upipe_hls_sink *upipe_hls_sink = upipe_hls_sink_from_upipe(upipe);
+
+    if (upipe_hls_sink->fsink != NULL)
+        upipe_hls_sink_close_playlist(upipe);
+    upipe_throw_dead(upipe);
+
+    upipe_release(upipe_hls_sink->fsink);
+    free(upipe_hls_sink->playlist);
+    free(upipe_hls_sink->dir);
+    free(upipe_hls_sink->prefix);
+    free(upipe_hls_sink->master);
+    uref_free(upipe_hls_sink->flow_def);
+    upipe_hls_sink_clean_urefcount(upipe);
+    upipe_hls_sink_free_void(upipe);
+}
+
+/** hls sink management structure */
+static struct upipe_mgr upipe_hls_sink_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_HLS_SINK_SIGNATURE,
+
+    .upipe_alloc = upipe_hls_sink_alloc,
+    .upipe_input = upipe_hls_sink_input,
+    .upipe_control = upipe_hls_sink_control,
+    .upipe_command_str = upipe_hls_sink_command_str,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for hls sink pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_hls_sink_mgr_alloc(void)
+{
+    return &upipe_hls_sink_mgr;
+}
@@ -0,0 +1,1124 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short HTTP/2 client framing layer for the http source.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_source_h2.h"
+
+/** connection preface sent by the client */
+#define H2_PREFACE              "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+/** size of a frame header */
+#define H2_FRAME_HEADER_SIZE    9
+/** maximum size of the received frames, as we do not change the default */
+#define H2_MAX_FRAME_SIZE       16384
+/** receive window of the streams and of the connection */
+#define H2_WINDOW_SIZE          (1 << 24)
+/** default receive window, before the settings are applied */
+#define H2_DEFAULT_WINDOW_SIZE  65535
+/** default size of the HPACK dynamic table */
+#define H2_TABLE_SIZE           4096
+/** overhead of an entry of the HPACK dynamic table */
+#define H2_ENTRY_OVERHEAD       32
+
+/** frame types */
+enum h2_frame_type {
+    H2_DATA = 0x0,
+    H2_HEADERS = 0x1,
+    H2_PRIORITY = 0x2,
+    H2_RST_STREAM = 0x3,
+    H2_SETTINGS = 0x4,
+    H2_PUSH_PROMISE = 0x5,
+    H2_PING = 0x6,
+    H2_GOAWAY = 0x7,
+    H2_WINDOW_UPDATE = 0x8,
+    H2_CONTINUATION = 0x9,
+};
+
+/** frame flags */
+enum h2_frame_flag {
+    H2_FLAG_ACK = 0x1,
+    H2_FLAG_END_STREAM = 0x1,
+    H2_FLAG_END_HEADERS = 0x4,
+    H2_FLAG_PADDED = 0x8,
+    H2_FLAG_PRIORITY = 0x20,
+};
+
+/** settings identifiers */
+enum h2_setting {
+    H2_SETTINGS_HEADER_TABLE_SIZE = 0x1,
+    H2_SETTINGS_ENABLE_PUSH = 0x2,
+    H2_SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+    H2_SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+    H2_SETTINGS_MAX_FRAME_SIZE = 0x5,
+};
+
+/** HPACK static table (RFC 7541 appendix A) */
+static const struct {
+    const char *name;
+    const char *value;
+} h2_static_table[] = {
+    { ":authority", "" },
+    { ":method", "GET" },
+    { ":method", "POST" },
+    { ":path", "/" },
+    { ":path", "/index.html" },
+    { ":scheme", "http" },
+    { ":scheme", "https" },
+    { ":status", "200" },
+    { ":status", "204" },
+    { ":status", "206" },
+    { ":status", "304" },
+    { ":status", "400" },
+    { ":status", "404" },
+    { ":status", "500" },
+    { "accept-charset", "" },
+    { "accept-encoding", "gzip, deflate" },
+    { "accept-language", "" },
+    { "accept-ranges", "" },
+    { "accept", "" },
+    { "access-control-allow-origin", "" },
+    { "age", "" },
+    { "allow", "" },
+    { "authorization", "" },
+    { "cache-control", "" },
+    { "content-disposition", "" },
+    { "content-encoding", "" },
+    { "content-language", "" },
+    { "content-length", "" },
+    { "content-location", "" },
+    { "content-range", "" },
+    { "content-type", "" },
+    { "cookie", "" },
+    { "date", "" },
+    { "etag", "" },
+    { "expect", "" },
+    { "expires", "" },
+    { "from", "" },
+    { "host", "" },
+    { "if-match", "" },
+    { "if-modified-since", "" },
+    { "if-none-match", "" },
+    { "if-range", "" },
+    { "if-unmodified-since", "" },
+    { "last-modified", "" },
+    { "link", "" },
+    { "location", "" },
+    { "max-forwards", "" },
+    { "proxy-authenticate", "" },
+    { "proxy-authorization", "" },
+    { "range", "" },
+    { "referer", "" },
+    { "refresh", "" },
+    { "retry-after", "" },
+    { "server", "" },
+    { "set-cookie", "" },
+    { "strict-transport-security", "" },
+    { "transfer-encoding", "" },
+    { "user-agent", "" },
+    { "vary", "" },
+    { "via", "" },
+    { "www-authenticate", "" },
+};
+
+#define H2_STATIC_TABLE_SIZE UBASE_ARRAY_SIZE(h2_static_table)
+
+/** number of HPACK Huffman codes of each length (RFC 7541 appendix B) */
+static const uint8_t h2_huffman_counts[31] = {
+    0, 0, 0, 0, 0, 10, 26, 32, 6, 0, 5, 3, 2, 6, 2, 3,
+    0, 0, 0, 3, 8, 13, 26, 29, 12, 4, 15, 19, 29, 0, 4
+};
+
+/** symbols of the HPACK Huffman code, by increasing code */
+static const uint16_t h2_huffman_symbols[257] = {
+    48, 49, 50, 97, 99, 101, 105, 111, 115, 116, 32, 37,
+    45, 46, 47, 51, 52, 53, 54, 55, 56, 57, 61, 65,
+    95, 98, 100, 102, 103, 104, 108, 109, 110, 112, 114, 117,
+    58, 66, 67, 68, 69, 70, 71, 72, 73, 74, 75, 76,
+    77, 78, 79, 80, 81, 82, 83, 84, 85, 86, 87, 89,
+    106, 107, 113, 118, 119, 120, 121, 122, 38, 42, 44, 59,
+    88, 90, 33, 34, 40, 41, 63, 39, 43, 124, 35, 62,
+    0, 36, 64, 91, 93, 126, 94, 125, 60, 96, 123, 92,
+    195, 208, 128, 130, 131, 162, 184, 194, 224, 226, 153, 161,
+    167, 172, 176, 177, 179, 209, 216, 217, 227, 229, 230, 129,
+    132, 133, 134, 136, 146, 154, 156, 160, 163, 164, 169, 170,
+    173, 178, 181, 185, 186, 187, 189, 190, 196, 198, 228, 232,
+    233, 1, 135, 137, 138, 139, 140, 141, 143, 147, 149, 150,
+    151, 152, 155, 157, 158, 165, 166, 168, 174, 175, 180, 182,
+    183, 188, 191, 197, 231, 239, 9, 142, 144, 145, 148, 159,
+    171, 206, 215, 225, 236, 237, 199, 207, 234, 235, 192, 193,
+    200, 201, 202, 205, 210, 213, 218, 219, 238, 240, 242, 243,
+    255, 203, 204, 211, 212, 214, 221, 222, 223, 241, 244, 245,
+    246, 247, 248, 250, 251, 252, 253, 254, 2, 3, 4, 5,
+    6, 7, 8, 11, 12, 14, 15, 16, 17, 18, 19, 20,
+    21, 23, 24, 25, 26, 27, 28, 29, 30, 31, 127, 220,
+    249, 10, 13, 22, 256,
+};
+
+/** @internal @This reserves space in the output buffer.
+ *
+ * @param h2 connection state
+ * @param len number of octets to append
+ * @return pointer to the reserved space, or NULL
+ */
+static uint8_t *http_src_h2_reserve(struct http_src_h2 *h2, size_t len)
+{
+    if (h2->out_len + len > h2->out_size) {
+        size_t size = h2->out_size * 2;
+        if (size < h2->out_len + len)
+            size = h2->out_len + len;
+        uint8_t *out = realloc(h2->out, size);
+        if (unlikely(out == NULL))
+            return NULL;
+        h2->out = out;
+        h2->out_size = size;
+    }
+    uint8_t *p = h2->out + h2->out_len;
+    h2->out_len += len;
+    return p;
+}
+
+/** @internal @This writes a 32 bits big endian integer.
+ *
+ * @param p pointer to the buffer
+ * @param value value to write
+ */
+static inline void http_src_h2_set32(uint8_t *p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+/** @internal @This reads a 32 bits big endian integer.
+ *
+ * @param p pointer to the buffer
+ * @return the value
+ */
+static inline uint32_t http_src_h2_get32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/** @internal @This appends a frame to the output buffer.
+ *
+ * @param h2 connection state
+ * @param type frame type
+ * @param flags frame flags
+ * @param stream_id stream identifier
+ * @param payload frame payload
+ * @param len length of the payload
+ * @return an error code
+ */
+static int http_src_h2_frame(struct http_src_h2 *h2, uint8_t type,
+                             uint8_t flags, uint32_t stream_id,
+                             const uint8_t *payload, size_t len)
+{
+    uint8_t *p = http_src_h2_reserve(h2, H2_FRAME_HEADER_SIZE + len);
+    UBASE_ALLOC_RETURN(p);
+    p[0] = len >> 16;
+    p[1] = len >> 8;
+    p[2] = len;
+    p[3] = type;
+    p[4] = flags;
+    http_src_h2_set32(p + 5, stream_id & 0x7fffffff);
+    if (len)
+        memcpy(p + H2_FRAME_HEADER_SIZE, payload, len);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This appends a window update frame.
+ *
+ * @param h2 connection state
+ * @param stream_id stream identifier, or 0 for the connection
+ * @param increment window size increment
+ * @return an error code
+ */
+static int http_src_h2_window_update(struct http_src_h2 *h2,
+                                     uint32_t stream_id, uint32_t increment)
+{
+    uint8_t payload[4];
+    http_src_h2_set32(payload, increment);
+    return http_src_h2_frame(h2, H2_WINDOW_UPDATE, 0, stream_id,
+                             payload, sizeof (payload));
+}
+
+/** @internal @This appends a stream reset frame.
+ *
+ * @param h2 connection state
+ * @param stream_id stream identifier
+ * @param error error code
+ * @return an error code
+ */
+static int http_src_h2_rst_stream(struct http_src_h2 *h2, uint32_t stream_id,
+                                  uint32_t error)
+{
+    uint8_t payload[4];
+    http_src_h2_set32(payload, error);
+    return http_src_h2_frame(h2, H2_RST_STREAM, 0, stream_id,
+                             payload, sizeof (payload));
+}
+
+/** @internal @This finds an open stream.
+ *
+ * @param h2 connection state
+ * @param stream_id stream identifier
+ * @return pointer to the stream, or NULL
+ */
+static struct http_src_h2_stream *http_src_h2_find(struct http_src_h2 *h2,
+                                                   uint32_t stream_id)
+{
+    struct uchain *uchain;
+    ulist_foreach(&h2->streams, uchain) {
+        struct http_src_h2_stream *stream =
+            http_src_h2_stream_from_uchain(uchain);
+        if (stream->id == stream_id)
+            return stream;
+    }
+    return NULL;
+}
+
+/** @internal @This removes a stream from the list of open streams.
+ *
+ * @param h2 connection state
+ * @param stream stream to remove
+ */
+static void http_src_h2_remove(struct http_src_h2 *h2,
+                               struct http_src_h2_stream *stream)
+{
+    ulist_delete(&stream->uchain);
+    h2->nb_streams--;
+}
+
+/** @internal @This resets all the streams above an identifier.
+ *
+ * @param h2 connection state
+ * @param last_id last stream identifier to keep
+ * @param error error code to report
+ */
+static void http_src_h2_reset_above(struct http_src_h2 *h2, uint32_t last_id,
+                                    uint32_t error)
+{
+    /* the callbacks may close other streams, so restart from the head */
+    for (;;) {
+        struct http_src_h2_stream *stream = NULL;
+        struct uchain *uchain;
+        ulist_foreach(&h2->streams, uchain) {
+            struct http_src_h2_stream *item =
+                http_src_h2_stream_from_uchain(uchain);
+            if (item->id > last_id) {
+                stream = item;
+                break;
+            }
+        }
+        if (stream == NULL)
+            break;
+        http_src_h2_remove(h2, stream);
+        h2->cb->reset(h2, stream, error);
+    }
+}
+
+/** @internal @This handles a connection error. The streams are reset when
+ * the connection is closed.
+ *
+ * @param h2 connection state
+ * @param error error code
+ * @return an error code
+ */
+static int http_src_h2_error(struct http_src_h2 *h2, uint32_t error)
+{
+    if (!h2->error) {
+        h2->error = true;
+        uint8_t payload[8];
+        http_src_h2_set32(payload, 0);
+        http_src_h2_set32(payload + 4, error);
+        http_src_h2_frame(h2, H2_GOAWAY, 0, 0, payload, sizeof (payload));
+    }
+    return UBASE_ERR_INVALID;
+}
+
+int http_src_h2_init(struct http_src_h2 *h2, const struct http_src_h2_cb *cb)
+{
+    h2->cb = cb;
+    h2->out = NULL;
+    h2->out_len = 0;
+    h2->out_size = 0;
+    h2->header_len = 0;
+    h2->payload = NULL;
+    h2->block = NULL;
+    h2->block_len = 0;
+    h2->block_size = 0;
+    h2->block_stream = 0;
+    h2->block_end_stream = false;
+    h2->table = NULL;
+    h2->table_nb = 0;
+    h2->table_alloc = 0;
+    h2->table_size = 0;
+    h2->table_max = H2_TABLE_SIZE;
+    ulist_init(&h2->streams);
+    h2->nb_streams = 0;
+    h2->next_id = 1;
+    /* until the settings of the server are received */
+    h2->max_streams = 100;
+    h2->max_frame_size = H2_MAX_FRAME_SIZE;
+    h2->consumed = 0;
+    h2->settings = false;
+    h2->goaway = false;
+    h2->error = false;
+
+    h2->payload = malloc(H2_MAX_FRAME_SIZE);
+    UBASE_ALLOC_RETURN(h2->payload);
+
+    size_t preface_len = strlen(H2_PREFACE);
+    uint8_t *p = http_src_h2_reserve(h2, preface_len);
+    UBASE_ALLOC_RETURN(p);
+    memcpy(p, H2_PREFACE, preface_len);
+
+    uint8_t settings[12];
+    settings[0] = 0;
+    settings[1] = H2_SETTINGS_ENABLE_PUSH;
+    http_src_h2_set32(settings + 2, 0);
+    settings[6] = 0;
+    settings[7] = H2_SETTINGS_INITIAL_WINDOW_SIZE;
+    http_src_h2_set32(settings + 8, H2_WINDOW_SIZE);
+    UBASE_RETURN(http_src_h2_frame(h2, H2_SETTINGS, 0, 0,
+                                   settings, sizeof (settings)));
+    return http_src_h2_window_update(h2, 0,
+                                     H2_WINDOW_SIZE - H2_DEFAULT_WINDOW_SIZE);
+}
+
+void http_src_h2_clean(struct http_src_h2 *h2)
+{
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&h2->streams, uchain, uchain_tmp)
+        ulist_delete(uchain);
+    h2->nb_streams = 0;
+    for (unsigned int i = 0; i < h2->table_nb; i++)
+        free(h2->table[i]);
+    free(h2->table);
+    free(h2->block);
+    free(h2->payload);
+    free(h2->out);
+}
+
+/** @internal @This appends a HPACK integer.
+ *
+ * @param p pointer to the buffer, at least 6 octets
+ * @param first bits of the first octet which are not part of the prefix
+ * @param prefix number of bits of the prefix
+ * @param value value to encode
+ * @return the number of octets written
+ */
+static size_t http_src_h2_put_int(uint8_t *p, uint8_t first,
+                                  unsigned int prefix, size_t value)
+{
+    size_t max = (1 << prefix) - 1;
+    if (value < max) {
+        p[0] = first | value;
+        return 1;
+    }
+    size_t len = 0;
+    p[len++] = first | max;
+    value -= max;
+    while (value >= 128) {
+        p[len++] = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+    p[len++] = value;
+    return len;
+}
+
+/** @internal @This appends a HPACK string literal, without Huffman coding.
+ *
+ * @param p pointer to the buffer, at least 6 octets plus the string length
+ * @param str string to encode
+ * @return the number of octets written
+ */
+static size_t http_src_h2_put_str(uint8_t *p, const char *str)
+{
+    size_t str_len = strlen(str);
+    size_t len = http_src_h2_put_int(p, 0, 7, str_len);
+    memcpy(p + len, str, str_len);
+    return len + str_len;
+}
+
+int http_src_h2_submit(struct http_src_h2 *h2,
+                       struct http_src_h2_stream *stream,
+                       const struct http_src_h2_header *headers,
+                       unsigned int nb_headers, unsigned int weight)
+{
+    if (unlikely(!http_src_h2_can_submit(h2)))
+        return UBASE_ERR_BUSY;
+    if (unlikely(weight < 1 || weight > 256))
+        return UBASE_ERR_INVALID;
+
+    size_t size = 5;
+    for (unsigned int i = 0; i < nb_headers; i++)
+        size += 12 + strlen(headers[i].name) + strlen(headers[i].value);
+    uint8_t *block = malloc(size);
+    UBASE_ALLOC_RETURN(block);
+
+    /* priority: no dependency */
+    http_src_h2_set32(block, 0);
+    block[4] = weight - 1;
+    size_t len = 5;
+    for (unsigned int i = 0; i < nb_headers; i++) {
+        unsigned int index = 0;
+        for (unsigned int j = 0; j < H2_STATIC_TABLE_SIZE; j++)
+            if (!strcmp(h2_static_table[j].name, headers[i].name)) {
+                index = j + 1;
+                break;
+            }
+        /* literal header field without indexing */
+        len += http_src_h2_put_int(block + len, 0, 4, index);
+        if (!index)
+            len += http_src_h2_put_str(block + len, headers[i].name);
+        len += http_src_h2_put_str(block + len, headers[i].value);
+    }
+
+    stream->id = h2->next_id;
+    stream->consumed = 0;
+    h2->next_id += 2;
+
+    /* split the header block in HEADERS and CONTINUATION frames */
+    int err = UBASE_ERR_NONE;
+    size_t offset = 0;
+    do {
+        size_t frame_len = len - offset;
+        if (frame_len > h2->max_frame_size)
+            frame_len = h2->max_frame_size;
+        uint8_t flags = offset + frame_len == len ? H2_FLAG_END_HEADERS : 0;
+        if (!offset)
+            err = http_src_h2_frame(h2, H2_HEADERS,
+                                    flags | H2_FLAG_END_STREAM |
+                                    H2_FLAG_PRIORITY,
+                                    stream->id, block, frame_len);
+        else
+            err = http_src_h2_frame(h2, H2_CONTINUATION, flags, stream->id,
+                                    block + offset, frame_len);
+        offset += frame_len;
+    } while (ubase_check(err) && offset < len);
+    free(block);
+    if (unlikely(!ubase_check(err))) {
+        /* the frames are incomplete and may not be sent */
+        http_src_h2_error(h2, HTTP_SRC_H2_INTERNAL_ERROR);
+        return err;
+    }
+
+    ulist_add(&h2->streams, &stream->uchain);
+    h2->nb_streams++;
+    return UBASE_ERR_NONE;
+}
+
+int http_src_h2_set_weight(struct http_src_h2 *h2,
+                           struct http_src_h2_stream *stream,
+                           unsigned int weight)
+{
+    if (unlikely(weight < 1 || weight > 256))
+        return UBASE_ERR_INVALID;
+    if (!stream->id || http_src_h2_find(h2, stream->id) != stream)
+        return UBASE_ERR_INVALID;
+
+    uint8_t payload[5];
+    http_src_h2_set32(payload, 0);
+    payload[4] = weight - 1;
+    return http_src_h2_frame(h2, H2_PRIORITY, 0, stream->id,
+                             payload, sizeof (payload));
+}
+
+void http_src_h2_cancel(struct http_src_h2 *h2,
+                        struct http_src_h2_stream *stream)
+{
+    if (!stream->id || http_src_h2_find(h2, stream->id) != stream)
+        return;
+    http_src_h2_remove(h2, stream);
+    if (!h2->error)
+        http_src_h2_rst_stream(h2, stream->id, HTTP_SRC_H2_CANCEL);
+}
+
+void http_src_h2_close(struct http_src_h2 *h2)
+{
+    h2->goaway = true;
+    http_src_h2_reset_above(h2, 0, HTTP_SRC_H2_INTERNAL_ERROR);
+}
+
+void http_src_h2_consume(struct http_src_h2 *h2, size_t len)
+{
+    if (len > h2->out_len)
+        len = h2->out_len;
+    h2->out_len -= len;
+    memmove(h2->out, h2->out + len, h2->out_len);
+}
+
+/** @internal @This reads a HPACK integer.
+ *
+ * @param p pointer to the current position, updated
+ * @param end end of the buffer
+ * @param prefix number of bits of the prefix
+ * @param value_p filled in with the value
+ * @return an error code
+ */
+static int http_src_h2_get_int(const uint8_t **p, const uint8_t *end,
+                               unsigned int prefix, size_t *value_p)
+{
+    if (*p >= end)
+        return UBASE_ERR_INVALID;
+    size_t max = (1 << prefix) - 1;
+    size_t value = *(*p)++ & max;
+    if (value == max) {
+        unsigned int shift = 0;
+        uint8_t c;
+        do {
+            if (*p >= end || shift > 28)
+                return UBASE_ERR_INVALID;
+            c = *(*p)++;
+            value += (size_t)(c & 0x7f) << shift;
+            shift += 7;
+        } while (c & 0x80);
+    }
+    *value_p = value;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This decodes a HPACK Huffman coded string.
+ *
+ * @param in coded string
+ * @param in_len length of the coded string
+ * @param out filled in with the decoded string, at least in_len * 8 / 5
+ * octets
+ * @param out_len_p filled in with the length of the decoded string
+ * @return an error code
+ */
+static int http_src_h2_huffman(const uint8_t *in, size_t in_len,
+                               char *out, size_t *out_len_p)
+{
+    size_t out_len = 0;
+    /* canonical code decoding: codes of the same length are consecutive */
+    int code = 0, first = 0, index = 0;
+    unsigned int len = 0;
+    for (size_t i = 0; i < in_len; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            code |= (in[i] >> bit) & 1;
+            len++;
+            int count = len < UBASE_ARRAY_SIZE(h2_huffman_counts) ?
+                h2_huffman_counts[len] : 0;
+            if (code - first < count) {
+                uint16_t symbol = h2_huffman_symbols[index + code - first];
+                if (symbol == 256)
+                    return UBASE_ERR_INVALID;
+                out[out_len++] = symbol;
+                code = first = index = 0;
+                len = 0;
+                continue;
+            }
+            if (len >= 30)
+                return UBASE_ERR_INVALID;
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+        }
+    }
+    /* the padding is the most significant bits of EOS, all ones */
+    if (len > 7 || (unsigned int)(code >> 1) != (1U << len) - 1)
+        return UBASE_ERR_INVALID;
+    *out_len_p = out_len;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This reads a HPACK string literal.
+ *
+ * @param p pointer to the current position, updated
+ * @param end end of the buffer
+ * @param str_p filled in with an allocated string, to free
+ * @param len_p filled in with the length of the string
+ * @return an error code
+ */
+static int http_src_h2_get_str(const uint8_t **p, const uint8_t *end,
+                               char **str_p, size_t *len_p)
+{
+    if (*p >= end)
+        return UBASE_ERR_INVALID;
+    bool huffman = **p & 0x80;
+    size_t len;
+    UBASE_RETURN(http_src_h2_get_int(p, end, 7, &len));
+    if (len > end - *p)
+        return UBASE_ERR_INVALID;
+
+    char *str = malloc(huffman ? len * 8 / 5 + 1 : len + 1);
+    UBASE_ALLOC_RETURN(str);
+    if (huffman) {
+        int err = http_src_h2_huffman(*p, len, str, len_p);
+        if (unlikely(!ubase_check(err))) {
+            free(str);
+            return err;
+        }
+    } else {
+        memcpy(str, *p, len);
+        *len_p = len;
+    }
+    str[*len_p] = '\0';
+    *p += len;
+    *str_p = str;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This evicts entries from the dynamic table until its size is
+ * below a limit.
+ *
+ * @param h2 connection state
+ * @param max maximum size
+ */
+static void http_src_h2_evict(struct http_src_h2 *h2, size_t max)
+{
+    while (h2->table_nb && h2->table_size > max) {
+        struct http_src_h2_entry *entry = h2->table[--h2->table_nb];
+        h2->table_size -= entry->name_len + entry->value_len +
+                          H2_ENTRY_OVERHEAD;
+        free(entry);
+    }
+}
+
+/** @internal @This inserts an entry in the dynamic table.
+ *
+ * @param h2 connection state
+ * @param name header name
+ * @param name_len length of the name
+ * @param value header value
+ * @param value_len length of the value
+ * @return an error code
+ */
+static int http_src_h2_insert(struct http_src_h2 *h2,
+                              const char *name, size_t name_len,
+                              const char *value, size_t value_len)
+{
+    size_t size = name_len + value_len + H2_ENTRY_OVERHEAD;
+    if (size > h2->table_max) {
+        http_src_h2_evict(h2, 0);
+        return UBASE_ERR_NONE;
+    }
+    http_src_h2_evict(h2, h2->table_max - size);
+
+    if (h2->table_nb == h2->table_alloc) {
+        unsigned int alloc = h2->table_alloc ? h2->table_alloc * 2 : 16;
+        struct http_src_h2_entry **table =
+            realloc(h2->table, alloc * sizeof (*table));
+        UBASE_ALLOC_RETURN(table);
+        h2->table = table;
+        h2->table_alloc = alloc;
+    }
+    struct http_src_h2_entry *entry =
+        malloc(sizeof (*entry) + name_len + value_len);
+    UBASE_ALLOC_RETURN(entry);
+    entry->name_len = name_len;
+    entry->value_len = value_len;
+    memcpy(entry->buf, name, name_len);
+    memcpy(entry->buf + name_len, value, value_len);
+    memmove(h2->table + 1, h2->table, h2->table_nb * sizeof (*h2->table));
+    h2->table[0] = entry;
+    h2->table_nb++;
+    h2->table_size += size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This looks up an entry of the static or dynamic tables.
+ *
+ * @param h2 connection state
+ * @param index index of the entry, starting from 1
+ * @param name_p filled in with the name
+ * @param name_len_p filled in with the length of the name
+ * @param value_p filled in with the value
+ * @param value_len_p filled in with the length of the value
+ * @return an error code
+ */
+static int http_src_h2_lookup(struct http_src_h2 *h2, size_t index,
+                              const char **name_p, size_t *name_len_p,
+                              const char **value_p, size_t *value_len_p)
+{
+    if (!index)
+        return UBASE_ERR_INVALID;
+    if (index <= H2_STATIC_TABLE_SIZE) {
+        *name_p = h2_static_table[index - 1].name;
+        *name_len_p = strlen(*name_p);
+        *value_p = h2_static_table[index - 1].value;
+        *value_len_p = strlen(*value_p);
+        return UBASE_ERR_NONE;
+    }
+    index -= H2_STATIC_TABLE_SIZE + 1;
+    if (index >= h2->table_nb)
+        return UBASE_ERR_INVALID;
+    struct http_src_h2_entry *entry = h2->table[index];
+    *name_p = entry->buf;
+    *name_len_p = entry->name_len;
+    *value_p = entry->buf + entry->name_len;
+    *value_len_p = entry->value_len;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This decodes a header block and calls back the stream for
+ * each header. The block is decoded even if the stream is closed, to keep
+ * the dynamic table synchronized.
+ *
+ * @param h2 connection state
+ * @param stream_id stream identifier
+ * @param p header block
+ * @param len length of the header block
+ * @return an error code
+ */
+static int http_src_h2_decode(struct http_src_h2 *h2, uint32_t stream_id,
+                              const uint8_t *p, size_t len)
+{
+    const uint8_t *end = p + len;
+    while (p < end) {
+        uint8_t c = *p;
+        size_t index;
+        const char *name, *value;
+        size_t name_len, value_len;
+        char *name_buf = NULL, *value_buf = NULL;
+        bool indexing = false;
+
+        if (c & 0x80) {
+            /* indexed header field */
+            UBASE_RETURN(http_src_h2_get_int(&p, end, 7, &index));
+            UBASE_RETURN(http_src_h2_lookup(h2, index, &name, &name_len,
+                                            &value, &value_len));
+        } else if ((c & 0xe0) == 0x20) {
+            /* dynamic table size update */
+            UBASE_RETURN(http_src_h2_get_int(&p, end, 5, &index));
+            if (index > H2_TABLE_SIZE)
+                return UBASE_ERR_INVALID;
+            h2->table_max = index;
+            http_src_h2_evict(h2, h2->table_max);
+            continue;
+        } else {
+            /* literal header field, with incremental indexing if 01,
+             * without indexing if 0000 and never indexed if 0001 */
+            indexing = (c & 0xc0) == 0x40;
+            UBASE_RETURN(http_src_h2_get_int(&p, end, indexing ? 6 : 4,
+                                             &index));
+            if (index) {
+                UBASE_RETURN(http_src_h2_lookup(h2, index, &name, &name_len,
+                                                &value, &value_len));
+            } else {
+                UBASE_RETURN(http_src_h2_get_str(&p, end, &name_buf,
+                                                 &name_len));
+                name = name_buf;
+            }
+            int err = http_src_h2_get_str(&p, end, &value_buf, &value_len);
+            if (unlikely(!ubase_check(err))) {
+                free(name_buf);
+                return err;
+            }
+            value = value_buf;
+        }
+
+        struct http_src_h2_stream *stream = http_src_h2_find(h2, stream_id);
+        if (stream != NULL)
+            h2->cb->header(h2, stream, name, name_len, value, value_len);
+
+        int err = UBASE_ERR_NONE;
+        if (indexing)
+            err = http_src_h2_insert(h2, name, name_len, value, value_len);
+        free(name_buf);
+        free(value_buf);
+        UBASE_RETURN(err);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This ends a stream.
+ *
+ * @param h2 connection state
+ * @param stream_id stream identifier
+ */
+static void http_src_h2_end(struct http_src_h2 *h2, uint32_t stream_id)
+{
+    struct http_src_h2_stream *stream = http_src_h2_find(h2, stream_id);
+    if (stream == NULL)
+        return;
+    http_src_h2_remove(h2, stream);
+    h2->cb->end(h2, stream);
+}
+
+/** @internal @This appends a fragment of header block, and decodes the
+ * block once complete.
+ *
+ * @param h2 connection state
+ * @param p fragment of header block
+ * @param len length of the fragment
+ * @return an error code
+ */
+static int http_src_h2_block(struct http_src_h2 *h2,
+                             const uint8_t *p, size_t len)
+{
+    if (h2->block_len + len > h2->block_size) {
+        size_t size = h2->block_len + len;
+        uint8_t *block = realloc(h2->block, size);
+        if (unlikely(block == NULL))
+            return http_src_h2_error(h2, HTTP_SRC_H2_INTERNAL_ERROR);
+        h2->block = block;
+        h2->block_size = size;
+    }
+    memcpy(h2->block + h2->block_len, p, len);
+    h2->block_len += len;
+
+    if (!(h2->flags & H2_FLAG_END_HEADERS))
+        return UBASE_ERR_NONE;
+
+    uint32_t stream_id = h2->block_stream;
+    h2->block_stream = 0;
+    if (!ubase_check(http_src_h2_decode(h2, stream_id, h2->block,
+                                        h2->block_len)))
+        return http_src_h2_error(h2, HTTP_SRC_H2_COMPRESSION_ERROR);
+    h2->block_len = 0;
+    if (h2->block_end_stream)
+        http_src_h2_end(h2, stream_id);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes a received frame, except data frames.
+ *
+ * @param h2 connection state
+ * @return an error code
+ */
+static int http_src_h2_process(struct http_src_h2 *h2)
+{
+    const uint8_t *p = h2->payload;
+    size_t len = h2->length;
+
+    if (h2->block_stream &&
+        (h2->type != H2_CONTINUATION || h2->stream_id != h2->block_stream))
+        return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+
+    switch (h2->type) {
+    case H2_HEADERS:
+        if (!h2->stream_id)
+            return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        if (h2->flags & H2_FLAG_PADDED) {
+            if (!len || p[0] >= len)
+                return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+            len -= p[0] + 1;
+            p++;
+        }
+        if (h2->flags & H2_FLAG_PRIORITY) {
+            if (len < 5)
+                return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+            len -= 5;
+            p += 5;
+        }
+        h2->block_stream = h2->stream_id;
+        h2->block_end_stream = h2->flags & H2_FLAG_END_STREAM;
+        h2->block_len = 0;
+        return http_src_h2_block(h2, p, len);
+
+    case H2_CONTINUATION:
+        if (!h2->block_stream)
+            return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        return http_src_h2_block(h2, p, len);
+
+    case H2_RST_STREAM: {
+        if (len != 4 || !h2->stream_id)
+            return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        struct http_src_h2_stream *stream =
+            http_src_h2_find(h2, h2->stream_id);
+        if (stream != NULL) {
+            http_src_h2_remove(h2, stream);
+            h2->cb->reset(h2, stream, http_src_h2_get32(p));
+        }
+        return UBASE_ERR_NONE;
+    }
+
+    case H2_SETTINGS:
+        if (h2->stream_id)
+            return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        if (h2->flags & H2_FLAG_ACK)
+            return UBASE_ERR_NONE;
+        if (len % 6)
+            return http_src_h2_error(h2, HTTP_SRC_H2_FRAME_SIZE_ERROR);
+        for (size_t i = 0; i < len; i += 6) {
+            uint16_t id = (p[i] << 8) | p[i + 1];
+            uint32_t value = http_src_h2_get32(p + i + 2);
+            switch (id) {
+            case H2_SETTINGS_MAX_CONCURRENT_STREAMS:
+                h2->max_streams = value;
+                break;
+            case H2_SETTINGS_MAX_FRAME_SIZE:
+                if (value < H2_MAX_FRAME_SIZE || value > 0xffffff)
+                    return http_src_h2_error(h2,
+                                             HTTP_SRC_H2_PROTOCOL_ERROR);
+                h2->max_frame_size = value;
+                break;
+            default:
+                /* our requests have no body and our header blocks are
+                 * not indexed, the other settings do not apply */
+                break;
+            }
+        }
+        h2->settings = true;
+        return http_src_h2_frame(h2, H2_SETTINGS, H2_FLAG_ACK, 0, NULL, 0);
+
+    case H2_PING:
+        if (len != 8 || h2->stream_id)
+            return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        if (h2->flags & H2_FLAG_ACK)
+            return UBASE_ERR_NONE;
+        return http_src_h2_frame(h2, H2_PING, H2_FLAG_ACK, 0, p, len);
+
+    case H2_GOAWAY:
+        if (len < 8 || h2->stream_id)
+            return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        h2->goaway = true;
+        /* the streams above the last identifier were not processed */
+        http_src_h2_reset_above(h2, http_src_h2_get32(p) & 0x7fffffff,
+                                HTTP_SRC_H2_REFUSED_STREAM);
+        return UBASE_ERR_NONE;
+
+    case H2_PUSH_PROMISE:
+        /* server push is disabled */
+        return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+
+    case H2_PRIORITY:
+    case H2_WINDOW_UPDATE:
+    default:
+        /* we do not send data, and unknown frames are ignored */
+        return UBASE_ERR_NONE;
+    }
+}
+
+/** @internal @This accounts received data for flow control.
+ *
+ * @param h2 connection state
+ * @return an error code
+ */
+static int http_src_h2_data_end(struct http_src_h2 *h2)
+{
+    h2->consumed += h2->length;
+    if (h2->consumed >= H2_WINDOW_SIZE / 2) {
+        UBASE_RETURN(http_src_h2_window_update(h2, 0, h2->consumed));
+        h2->consumed = 0;
+    }
+
+    if (h2->flags & H2_FLAG_END_STREAM) {
+        http_src_h2_end(h2, h2->stream_id);
+        return UBASE_ERR_NONE;
+    }
+
+    struct http_src_h2_stream *stream = http_src_h2_find(h2, h2->stream_id);
+    if (stream == NULL)
+        return UBASE_ERR_NONE;
+    stream->consumed += h2->length;
+    if (stream->consumed >= H2_WINDOW_SIZE / 2) {
+        UBASE_RETURN(http_src_h2_window_update(h2, stream->id,
+                                               stream->consumed));
+        stream->consumed = 0;
+    }
+    return UBASE_ERR_NONE;
+}
+
+int http_src_h2_feed(struct http_src_h2 *h2, const uint8_t *buf, size_t len)
+{
+    while (len) {
+        if (h2->error)
+            return UBASE_ERR_INVALID;
+
+        if (h2->header_len < H2_FRAME_HEADER_SIZE) {
+            size_t size = H2_FRAME_HEADER_SIZE - h2->header_len;
+            if (size > len)
+                size = len;
+            memcpy(h2->header + h2->header_len, buf, size);
+            h2->header_len += size;
+            buf += size;
+            len -= size;
+            if (h2->header_len < H2_FRAME_HEADER_SIZE)
+                return UBASE_ERR_NONE;
+
+            h2->length = (h2->header[0] << 16) | (h2->header[1] << 8) |
+                         h2->header[2];
+            h2->type = h2->header[3];
+            h2->flags = h2->header[4];
+            h2->stream_id = http_src_h2_get32(h2->header + 5) & 0x7fffffff;
+            h2->pos = 0;
+            h2->pad = 0;
+            if (h2->length > H2_MAX_FRAME_SIZE)
+                return http_src_h2_error(h2, HTTP_SRC_H2_FRAME_SIZE_ERROR);
+            if (h2->type == H2_DATA &&
+                (!h2->stream_id || h2->block_stream))
+                return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        }
+
+        if (h2->type != H2_DATA) {
+            size_t size = h2->length - h2->pos;
+            if (size > len)
+                size = len;
+            memcpy(h2->payload + h2->pos, buf, size);
+            h2->pos += size;
+            buf += size;
+            len -= size;
+            if (h2->pos < h2->length)
+                return UBASE_ERR_NONE;
+            h2->header_len = 0;
+            UBASE_RETURN(http_src_h2_process(h2));
+            continue;
+        }
+
+        /* data frames are given to the stream as they are received */
+        if (!h2->pos && (h2->flags & H2_FLAG_PADDED) && h2->length) {
+            h2->pad = *buf++;
+            len--;
+            h2->pos++;
+            if (h2->pad >= h2->length)
+                return http_src_h2_error(h2, HTTP_SRC_H2_PROTOCOL_ERROR);
+        }
+        size_t data_end = h2->length - h2->pad;
+        if (h2->pos < data_end && len) {
+            size_t size = data_end - h2->pos;
+            if (size > len)
+                size = len;
+            struct http_src_h2_stream *stream =
+                http_src_h2_find(h2, h2->stream_id);
+            h2->pos += size;
+            if (stream != NULL)
+                h2->cb->data(h2, stream, buf, size);
+            buf += size;
+            len -= size;
+        }
+        if (h2->pos >= data_end) {
+            size_t size = h2->length - h2->pos;
+            if (size > len)
+                size = len;
+            h2->pos += size;
+            buf += size;
+            len -= size;
+        }
+        if (h2->pos < h2->length)
+            return UBASE_ERR_NONE;
+        h2->header_len = 0;
+        UBASE_RETURN(http_src_h2_data_end(h2));
+    }
+    return UBASE_ERR_NONE;
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short HTTP/2 client framing layer for the http source.
+ *
+ * This implements the client side of HTTP/2 (RFC 7540) and the HPACK header
+ * decompression (RFC 7541), independently of the transport: the received
+ * octets are given to @ref http_src_h2_feed, which calls back the streams,
+ * and the octets to send are appended to an output buffer.
+ *
+ * Only requests without body are supported, server push is disabled, and
+ * the request headers are sent as literals without indexing.
+ */
+
+#ifndef _UPIPE_MODULES_HTTP_SOURCE_H2_H_
+#define _UPIPE_MODULES_HTTP_SOURCE_H2_H_
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** ALPN identifier of HTTP/2 over TLS */
+#define HTTP_SRC_H2_ALPN                "h2"
+/** default weight of a stream */
+#define HTTP_SRC_H2_DEFAULT_WEIGHT      16
+
+/** @This enumerates the HTTP/2 error codes. */
+enum http_src_h2_error {
+    HTTP_SRC_H2_NO_ERROR = 0x0,
+    HTTP_SRC_H2_PROTOCOL_ERROR = 0x1,
+    HTTP_SRC_H2_INTERNAL_ERROR = 0x2,
+    HTTP_SRC_H2_FLOW_CONTROL_ERROR = 0x3,
+    HTTP_SRC_H2_SETTINGS_TIMEOUT = 0x4,
+    HTTP_SRC_H2_STREAM_CLOSED = 0x5,
+    HTTP_SRC_H2_FRAME_SIZE_ERROR = 0x6,
+    HTTP_SRC_H2_REFUSED_STREAM = 0x7,
+    HTTP_SRC_H2_CANCEL = 0x8,
+    HTTP_SRC_H2_COMPRESSION_ERROR = 0x9,
+};
+
+/** @This describes a request header. */
+struct http_src_h2_header {
+    /** lower case name */
+    const char *name;
+    /** value */
+    const char *value;
+};
+
+/** @This describes a request multiplexed on a HTTP/2 connection. */
+struct http_src_h2_stream {
+    /** link in the list of open streams */
+    struct uchain uchain;
+    /** stream identifier, or 0 if not submitted */
+    uint32_t id;
+    /** octets received since the last window update */
+    uint32_t consumed;
+};
+
+UBASE_FROM_TO(http_src_h2_stream, uchain, uchain, uchain);
+
+struct http_src_h2;
+
+/** @This describes the functions called back on stream events. The stream
+ * is closed before end and reset are called, so it may be freed by them. */
+struct http_src_h2_cb {
+    /** called for each received header, including the :status
+     * pseudo-header */
+    void (*header)(struct http_src_h2 *, struct http_src_h2_stream *,
+                   const char *name, size_t name_len,
+                   const char *value, size_t value_len);
+    /** called for each received fragment of body */
+    void (*data)(struct http_src_h2 *, struct http_src_h2_stream *,
+                 const uint8_t *buf, size_t len);
+    /** called when the reply is complete */
+    void (*end)(struct http_src_h2 *, struct http_src_h2_stream *);
+    /** called when the stream is reset by the server or by a connection
+     * error, with the error code */
+    void (*reset)(struct http_src_h2 *, struct http_src_h2_stream *,
+                  uint32_t error);
+};
+
+/** @This describes an entry of the HPACK dynamic table. */
+struct http_src_h2_entry {
+    /** length of the name */
+    size_t name_len;
+    /** length of the value */
+    size_t value_len;
+    /** name followed by value */
+    char buf[];
+};
+
+/** @This describes the state of a HTTP/2 connection. */
+struct http_src_h2 {
+    /** stream callbacks */
+    const struct http_src_h2_cb *cb;
+
+    /** octets to send */
+    uint8_t *out;
+    /** number of octets to send */
+    size_t out_len;
+    /** allocated size of the output buffer */
+    size_t out_size;
+
+    /** header of the frame being received */
+    uint8_t header[9];
+    /** number of received octets of the frame header */
+    size_t header_len;
+    /** length of the frame payload */
+    uint32_t length;
+    /** frame type */
+    uint8_t type;
+    /** frame flags */
+    uint8_t flags;
+    /** frame stream identifier */
+    uint32_t stream_id;
+    /** number of received octets of the frame payload */
+    uint32_t pos;
+    /** padding length of the data frame */
+    uint8_t pad;
+    /** frame payload, except for data frames */
+    uint8_t *payload;
+
+    /** header block being received */
+    uint8_t *block;
+    /** length of the header block */
+    size_t block_len;
+    /** allocated size of the header block */
+    size_t block_size;
+    /** stream of the header block, or 0 if none */
+    uint32_t block_stream;
+    /** the header block ends the stream */
+    bool block_end_stream;
+
+    /** HPACK dynamic table, most recent entry first */
+    struct http_src_h2_entry **table;
+    /** number of entries in the dynamic table */
+    unsigned int table_nb;
+    /** allocated number of entries */
+    unsigned int table_alloc;
+    /** size of the dynamic table, as defined by HPACK */
+    size_t table_size;
+    /** maximum size of the dynamic table */
+    size_t table_max;
+
+    /** list of open streams */
+    struct uchain streams;
+    /** number of open streams */
+    unsigned int nb_streams;
+    /** identifier of the next stream */
+    uint32_t next_id;
+    /** maximum number of concurrent streams allowed by the server */
+    uint32_t max_streams;
+    /** maximum frame size allowed by the server */
+    uint32_t max_frame_size;
+    /** octets received on the connection since the last window update */
+    uint32_t consumed;
+
+    /** the settings of the server were received */
+    bool settings;
+    /** the server sent a GOAWAY frame */
+    bool goaway;
+    /** a connection error occurred */
+    bool error;
+};
+
+/** @This initializes a HTTP/2 connection, and queues the connection
+ * preface and the initial settings.
+ *
+ * @param h2 connection state
+ * @param cb stream callbacks
+ * @return an error code
+ */
+int http_src_h2_init(struct http_src_h2 *h2, const struct http_src_h2_cb *cb);
+
+/** @This releases the resources of a HTTP/2 connection. The open streams
+ * are dropped without being called back.
+ *
+ * @param h2 connection state
+ */
+void http_src_h2_clean(struct http_src_h2 *h2);
+
+/** @This checks whether a new stream may be submitted.
+ *
+ * @param h2 connection state
+ * @return true if a stream may be submitted
+ */
+static inline bool http_src_h2_can_submit(struct http_src_h2 *h2)
+{
+    return !h2->goaway && !h2->error && h2->next_id < (UINT32_C(1) << 31) &&
+           h2->nb_streams < h2->max_streams;
+}
+
+/** @This checks whether the connection may still be used.
+ *
+ * @param h2 connection state
+ * @return true if the connection may be used for new streams
+ */
+static inline bool http_src_h2_usable(struct http_src_h2 *h2)
+{
+    return !h2->goaway && !h2->error && h2->next_id < (UINT32_C(1) << 31);
+}
+
+/** @This submits a GET request on a new stream.
+ *
+ * @param h2 connection state
+ * @param stream stream to open
+ * @param headers request headers, starting with the pseudo-headers
+ * @param nb_headers number of request headers
+ * @param weight weight of the stream, between 1 and 256
+ * @return an error code
+ */
+int http_src_h2_submit(struct http_src_h2 *h2,
+                       struct http_src_h2_stream *stream,
+                       const struct http_src_h2_header *headers,
+                       unsigned int nb_headers, unsigned int weight);
+
+/** @This changes the weight of an open stream.
+ *
+ * @param h2 connection state
+ * @param stream open stream
+ * @param weight weight of the stream, between 1 and 256
+ * @return an error code
+ */
+int http_src_h2_set_weight(struct http_src_h2 *h2,
+                           struct http_src_h2_stream *stream,
+                           unsigned int weight);
+
+/** @This closes a stream before the end of the reply.
+ *
+ * @param h2 connection state
+ * @param stream stream to close
+ */
+void http_src_h2_cancel(struct http_src_h2 *h2,
+                        struct http_src_h2_stream *stream);
+
+/** @This processes received octets.
+ *
+ * @param h2 connection state
+ * @param buf received octets
+ * @param len number of received octets
+ * @return an error code, in case of error the connection must be closed
+ * and @ref http_src_h2_close called
+ */
+int http_src_h2_feed(struct http_src_h2 *h2, const uint8_t *buf, size_t len);
+
+/** @This fails all the open streams, when the connection is closed.
+ *
+ * @param h2 connection state
+ */
+void http_src_h2_close(struct http_src_h2 *h2);
+
+/** @This removes sent octets from the output buffer.
+ *
+ * @param h2 connection state
+ * @param len number of sent octets
+ */
+void http_src_h2_consume(struct http_src_h2 *h2, size_t len);
+
+#endif
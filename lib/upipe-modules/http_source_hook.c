@@ -160,6 +160,7 @@ struct upipe_http_src_hook *http_src_hook_init(struct http_src_hook *http,
     http->hook.transport.write = http_src_hook_transport_write;
     http->hook.data.read = http_src_hook_data_read;
     http->hook.data.write = http_src_hook_data_write;
+    http->hook.protocol = NULL;
     http->in.len = 0;
     http->out.len = 0;
     http->closed = false;
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe AES-128 CBC decryption kernels
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_AES_CBC_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_AES_CBC_H_
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+#define UPIPE_AES_CBC_X86
+#endif
+
+#if defined(__aarch64__) && defined(__GNUC__)
+/** @hidden */
+#define UPIPE_AES_CBC_ARM
+#ifdef __clang__
+/** @hidden */
+#define UPIPE_AES_CBC_ARM_TARGET __attribute__((target("aes")))
+#else
+/** @hidden */
+#define UPIPE_AES_CBC_ARM_TARGET __attribute__((target("+crypto")))
+#endif
+#endif
+
+/* expands a 128-bit key to the 11 round keys */
+void upipe_aes_key_expansion(const uint8_t key[16],
+                             uint8_t round_keys[11][4][4]);
+
+/* reference implementation, one block at a time */
+void upipe_aes_cbc_decrypt_c(uint8_t round_keys[11][4][4], uint8_t iv[16],
+                             uint8_t *buf, uintptr_t len);
+
+#ifdef UPIPE_AES_CBC_X86
+/* decrypts 4 blocks per iteration with aesdec */
+void upipe_aes_cbc_decrypt_aesni(uint8_t round_keys[11][4][4], uint8_t iv[16],
+                                 uint8_t *buf, uintptr_t len);
+#endif
+
+#ifdef UPIPE_AES_CBC_ARM
+/* decrypts 4 blocks per iteration with aesd */
+void upipe_aes_cbc_decrypt_ce(uint8_t round_keys[11][4][4], uint8_t iv[16],
+                              uint8_t *buf, uintptr_t len);
+#endif
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of upipe_aes_cbc_decrypt, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_aes_cbc_decrypt_kernel;
+
+/** @This decrypts AES-128 CBC blocks in place, using the fastest kernel
+ * supported by the CPU. The initialization vector is updated with the last
+ * cipher block, so that a stream may be decrypted in several calls.
+ *
+ * @param round_keys the round keys
+ * @param iv the initialization vector
+ * @param buf pointer to the data
+ * @param len size of the data in octets, multiple of 16
+ */
+void upipe_aes_cbc_decrypt(uint8_t round_keys[11][4][4], uint8_t iv[16],
+                           uint8_t *buf, uintptr_t len);
+
+#endif
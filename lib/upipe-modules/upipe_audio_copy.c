@@ -255,8 +255,35 @@ static bool upipe_audio_copy_output_buffer(struct upipe *upipe,
     struct uchain *uchain = ulist_peek(&upipe_audio_copy->urefs);
     assert(uchain);
     struct uref *in = uref_from_uchain(uchain);
+    uint64_t duration = UCLOCK_FREQ * samples / upipe_audio_copy->samplerate;
+
+    size_t in_size;
+    if (likely(ubase_check(uref_sound_size(in, &in_size, NULL))) &&
+        in_size >= samples) {
+        /* the frame lies within the first buffer, output a view on it */
+        struct uref *out;
+        if (in_size == samples) {
+            ulist_delete(uchain);
+            out = in;
+        } else {
+            out = uref_dup(in);
+            if (unlikely(!out)) {
+                upipe_err(upipe, "fail to duplicate sound buffer");
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return false;
+            }
+            uref_sound_resize(out, 0, samples);
+            uref_sound_consume(in, samples, upipe_audio_copy->samplerate);
+        }
+        uref_clock_set_duration(out, duration);
+        upipe_audio_copy->size -= samples;
 
-    /* allocate output sound buffer from first buffer */
+        upipe_audio_copy_output(upipe, out, upump_p);
+        return true;
+    }
+
+    /* the frame straddles several buffers, copy to a new sound buffer
+     * allocated from the first one */
     struct uref *out = uref_sound_alloc(in->mgr, in->ubuf->mgr, samples);
     if (unlikely(!out)) {
         upipe_err(upipe, "fail to allocate sound buffer");
@@ -276,7 +303,6 @@ static bool upipe_audio_copy_output_buffer(struct upipe *upipe,
     if (type != UREF_DATE_NONE)
         uref_clock_set_date_orig(out, date, type);
     uref_attr_import(out, in);
-    uint64_t duration = UCLOCK_FREQ * samples / upipe_audio_copy->samplerate;
     uref_clock_set_duration(out, duration);
 
     uint8_t planes = upipe_audio_copy->planes;
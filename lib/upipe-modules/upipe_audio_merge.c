@@ -269,12 +269,15 @@ static int upipe_audio_merge_sub_control(struct upipe *upipe,
     }
 }
 
-/** @internal @Copies data from the input urefs to an output buffer.
+/** @internal @Copies data from the input urefs to an output buffer, and
+ * zeroes the parts of it that no input covers.
  *
  * @param upipe description structure of the pipe
  * @param out_data reference to the output buffers
+ * @param out_size size of each output plane, in octets
  */
-static void upipe_audio_merge_copy_to_output(struct upipe *upipe, uint8_t **out_data)
+static void upipe_audio_merge_copy_to_output(struct upipe *upipe, uint8_t **out_data,
+                                             size_t out_size)
 {
     int8_t cur_plane = 0;
     struct upipe_audio_merge *upipe_audio_merge = upipe_audio_merge_from_upipe(upipe);
@@ -283,6 +286,9 @@ static void upipe_audio_merge_copy_to_output(struct upipe *upipe, uint8_t **out_
     uint8_t output_channels = 0;
     UBASE_ERROR(upipe, uref_sound_flow_get_channels(upipe_audio_merge->flow_def, &output_channels));
 
+    size_t written[output_channels];
+    memset(written, 0, sizeof(written));
+
     ulist_foreach (&upipe_audio_merge->inputs, uchain) {
         struct upipe_audio_merge_sub *upipe_audio_merge_sub =
             upipe_audio_merge_sub_from_uchain(uchain);
@@ -301,8 +307,13 @@ static void upipe_audio_merge_copy_to_output(struct upipe *upipe, uint8_t **out_
             for (int i = 0; i < planes; i++) {
                 /* Only copy up to the number of channels in the output flowdef,
                    and thus what we've allocated */
-                if ((cur_plane + i) < output_channels)
-                    memcpy(out_data[cur_plane + i], in_data[i], sample_size * samples);
+                if ((cur_plane + i) < output_channels) {
+                    size_t size = sample_size * samples;
+                    if (size > out_size)
+                        size = out_size;
+                    memcpy(out_data[cur_plane + i], in_data[i], size);
+                    written[cur_plane + i] = size;
+                }
             }
             uref_sound_unmap(upipe_audio_merge_sub->uref, 0, -1, planes);
         }
@@ -313,6 +324,11 @@ static void upipe_audio_merge_copy_to_output(struct upipe *upipe, uint8_t **out_
         uref_free(upipe_audio_merge_sub->uref);
         upipe_audio_merge_sub->uref = NULL;
     }
+
+    /* blank what was not copied */
+    for (int i = 0; i < output_channels; i++)
+        if (written[i] < out_size)
+            memset(out_data[i] + written[i], 0, out_size - written[i]);
 }
 
 /** @internal @Output a uref, if possible
@@ -381,16 +397,13 @@ static void upipe_audio_merge_produce_output(struct upipe *upipe, struct upump *
 
     uint8_t *out_data[output_channels];
 
-    /* Alloc and zero the output ubuf */
+    /* Alloc the output ubuf */
     ubuf = ubuf_sound_alloc(upipe_audio_merge->ubuf_mgr, output_num_samples);
     if (unlikely(ubuf == NULL)) {
         upipe_throw_error(upipe, UBASE_ERR_ALLOC);
         return;
     }
-    if (likely(ubase_check(ubuf_sound_write_uint8_t(ubuf, 0, -1, out_data, output_channels)))) {
-        for (int i = 0; i < output_channels; i++)
-            memset(out_data[i], 0, output_sample_size * output_num_samples);
-    } else {
+    if (unlikely(!ubase_check(ubuf_sound_write_uint8_t(ubuf, 0, -1, out_data, output_channels)))) {
         upipe_err(upipe, "error writing output audio buffer, skipping");
         uref_free(output_uref);
         ubuf_free(ubuf);
@@ -398,7 +411,8 @@ static void upipe_audio_merge_produce_output(struct upipe *upipe, struct upump *
     }
 
     /* copy input data to output */
-    upipe_audio_merge_copy_to_output(upipe, out_data);
+    upipe_audio_merge_copy_to_output(upipe, out_data,
+                                     output_sample_size * output_num_samples);
 
     /* clean up and output */
     ubuf_sound_unmap(ubuf, 0, -1, output_channels);
@@ -42,6 +42,7 @@
 #include "upipe/upipe_helper_output.h"
 #include "upipe/upipe_helper_subpipe.h"
 #include "upipe/upipe_helper_ubuf_mgr.h"
+#include "upipe/ubuf_sound_interleave.h"
 #include "upipe-modules/upipe_audio_split.h"
 
 #include <stdlib.h>
@@ -182,6 +183,54 @@ static struct upipe *upipe_audio_split_sub_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This copies the selected channels of the input samples to
+ * the output buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param ubuf output buffer
+ * @param in_buf packed input samples
+ * @param samples number of samples
+ * @return an error code
+ */
+static int upipe_audio_split_sub_copy(struct upipe *upipe, struct ubuf *ubuf,
+                                      const uint8_t *in_buf, size_t samples)
+{
+    struct upipe_audio_split_sub *sub = upipe_audio_split_sub_from_upipe(upipe);
+    struct upipe_audio_split *split = upipe_audio_split_from_sub_mgr(upipe->mgr);
+
+    /* pick the input channel of each output channel */
+    uint8_t out_channels = sub->planes == 1 ? sub->channels : sub->planes;
+    uint8_t *out_bufs[sub->planes];
+    uint8_t *dst[split->channels];
+    uint64_t mask = 0;
+    uint8_t in_idx = 0;
+    for (uint8_t out_idx = 0; out_idx < out_channels; out_idx++, in_idx++) {
+        while (in_idx < split->channels &&
+               !(sub->bitfield & (UINT64_C(1) << in_idx)))
+            in_idx++;
+
+        if (unlikely(in_idx == split->channels)) {
+            upipe_warn(upipe, "couldn't find channels");
+            break;
+        }
+        mask |= UINT64_C(1) << in_idx;
+    }
+
+    UBASE_RETURN(ubuf_sound_write_uint8_t(ubuf, 0, -1, out_bufs, sub->planes))
+
+    if (sub->planes == 1) {
+        ubuf_sound_select(out_bufs[0], in_buf, split->channel_sample_size,
+                          split->channels, mask, samples);
+    } else {
+        uint8_t plane = 0;
+        for (uint8_t c = 0; c < split->channels; c++)
+            dst[c] = mask & (UINT64_C(1) << c) ? out_bufs[plane++] : NULL;
+        ubuf_sound_deinterleave(dst, in_buf, split->channel_sample_size,
+                                split->channels, samples);
+    }
+    return ubuf_sound_unmap(ubuf, 0, -1, sub->planes);
+}
+
 /** @internal @This processes data.
  *
  * @param upipe description structure of the pipe
@@ -213,43 +262,11 @@ static void upipe_audio_split_sub_process(struct upipe *upipe,
         goto upipe_audio_split_sub_process_err;
     }
 
-    /* iterate through output channels */
-    uint8_t in_idx = 0;
-    const char *channel;
-    ubuf_sound_foreach_plane(ubuf, channel) {
-        uint8_t out_idx = 0;
-
-        do {
-            while (in_idx < split->channels && !(sub->bitfield & (1 << in_idx)))
-                in_idx++;
-
-            if (unlikely(in_idx == split->channels)) {
-                upipe_warn(upipe, "couldn't find channels");
-                break;
-            }
-
-            uint8_t *out_buf;
-            if (unlikely(!ubase_check(ubuf_sound_plane_write_uint8_t(ubuf,
-                                channel, 0, -1, &out_buf)))) {
-                upipe_throw_error(upipe, UBASE_ERR_ALLOC);
-                break;
-            }
-
-            const uint8_t *in = in_buf + in_idx * split->channel_sample_size;
-            uint8_t *out = out_buf + out_idx * split->channel_sample_size;
-            int i, j;
-            for (i = 0; i < samples; i++) {
-                for (j = 0; j < split->channel_sample_size; j++) {
-                    out[j] = in[j];
-                }
-                in += split->sample_size;
-                out += sub->sample_size;
-            }
-            ubuf_sound_plane_unmap(ubuf, channel, 0, -1);
-
-            in_idx++;
-            out_idx++;
-        } while (sub->planes == 1 && out_idx < sub->channels);
+    if (unlikely(!ubase_check(upipe_audio_split_sub_copy(upipe, ubuf, in_buf,
+                                                         samples)))) {
+        upipe_throw_error(upipe, UBASE_ERR_ALLOC);
+        ubuf_free(ubuf);
+        goto upipe_audio_split_sub_process_err;
     }
 
     /* dup uref, allocate new ubuf */
@@ -52,6 +52,20 @@
 
 /** we only accept pictures */
 #define EXPECTED_FLOW_DEF "pic."
+/** maximum number of dirty rectangles before recomposing the whole picture */
+#define MAX_DIRTY 16
+
+/** @internal @This describes a rectangle of the output picture. */
+struct upipe_blit_rect {
+    /** horizontal offset */
+    uint64_t hoffset;
+    /** vertical offset */
+    uint64_t voffset;
+    /** horizontal size */
+    uint64_t hsize;
+    /** vertical size */
+    uint64_t vsize;
+};
 
 /** @internal @This is the private context of a blit pipe */
 struct upipe_blit {
@@ -104,6 +118,15 @@ struct upipe_blit {
     /** last received uref */
     struct uref *uref;
 
+    /** persistent composed picture */
+    struct ubuf *canvas;
+    /** background picture the canvas was composed on */
+    struct ubuf *background;
+    /** rectangles of the canvas to compose again */
+    struct upipe_blit_rect dirty[MAX_DIRTY];
+    /** number of dirty rectangles */
+    unsigned int nb_dirty;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -202,6 +225,129 @@ UPIPE_HELPER_VOID(upipe_blit_sub)
 
 UPIPE_HELPER_SUBPIPE(upipe_blit, upipe_blit_sub, sub, sub_mgr, subs, uchain)
 
+/** @internal @This checks whether two pictures share the same buffers, in
+ * which case they have the same content.
+ *
+ * @param ubuf1 first picture or NULL
+ * @param ubuf2 second picture or NULL
+ * @return true if both pictures are identical
+ */
+static bool upipe_blit_same_ubuf(struct ubuf *ubuf1, struct ubuf *ubuf2)
+{
+    if (ubuf1 == ubuf2)
+        return true;
+    if (ubuf1 == NULL || ubuf2 == NULL)
+        return false;
+
+    size_t hsize1, vsize1, hsize2, vsize2;
+    if (!ubase_check(ubuf_pic_size(ubuf1, &hsize1, &vsize1, NULL)) ||
+        !ubase_check(ubuf_pic_size(ubuf2, &hsize2, &vsize2, NULL)) ||
+        hsize1 != hsize2 || vsize1 != vsize2)
+        return false;
+
+    const char *chroma;
+    ubuf_pic_foreach_plane(ubuf1, chroma) {
+        const uint8_t *buffer1, *buffer2;
+        if (!ubase_check(ubuf_pic_plane_read(ubuf1, chroma, 0, 0, -1, -1,
+                                             &buffer1)))
+            return false;
+        if (!ubase_check(ubuf_pic_plane_read(ubuf2, chroma, 0, 0, -1, -1,
+                                             &buffer2))) {
+            ubuf_pic_plane_unmap(ubuf1, chroma, 0, 0, -1, -1);
+            return false;
+        }
+        ubuf_pic_plane_unmap(ubuf1, chroma, 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(ubuf2, chroma, 0, 0, -1, -1);
+        if (buffer1 != buffer2)
+            return false;
+    }
+    return true;
+}
+
+/** @internal @This drops the composed picture, so that the next output
+ * picture is composed from scratch.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_blit_flush_canvas(struct upipe *upipe)
+{
+    struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
+    ubuf_free(upipe_blit->canvas);
+    upipe_blit->canvas = NULL;
+    ubuf_free(upipe_blit->background);
+    upipe_blit->background = NULL;
+    upipe_blit->nb_dirty = 0;
+}
+
+/** @internal @This marks a rectangle of the composed picture to be composed
+ * again for the next output picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param rect rectangle to compose again
+ */
+static void upipe_blit_invalidate(struct upipe *upipe,
+                                  const struct upipe_blit_rect *rect)
+{
+    struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
+    if (upipe_blit->canvas == NULL)
+        return;
+
+    /* align on the chroma subsampling and clip to the picture */
+    uint64_t hround = upipe_blit->hsub * upipe_blit->macropixel;
+    uint64_t vround = upipe_blit->vsub;
+    uint64_t left = rect->hoffset - rect->hoffset % hround;
+    uint64_t top = rect->voffset - rect->voffset % vround;
+    uint64_t right = rect->hoffset + rect->hsize;
+    uint64_t bottom = rect->voffset + rect->vsize;
+    right += (hround - right % hround) % hround;
+    bottom += (vround - bottom % vround) % vround;
+    if (right > upipe_blit->hsize)
+        right = upipe_blit->hsize;
+    if (bottom > upipe_blit->vsize)
+        bottom = upipe_blit->vsize;
+    if (left >= right || top >= bottom)
+        return;
+
+    struct upipe_blit_rect dirty = {
+        .hoffset = left, .voffset = top,
+        .hsize = right - left, .vsize = bottom - top,
+    };
+    for (unsigned int i = 0; i < upipe_blit->nb_dirty; i++) {
+        const struct upipe_blit_rect *r = &upipe_blit->dirty[i];
+        if (r->hoffset <= dirty.hoffset && r->voffset <= dirty.voffset &&
+            r->hoffset + r->hsize >= right && r->voffset + r->vsize >= bottom)
+            return;
+    }
+
+    if (upipe_blit->nb_dirty >= MAX_DIRTY) {
+        /* too many changes, compose everything again */
+        upipe_blit_flush_canvas(upipe);
+        return;
+    }
+    upipe_blit->dirty[upipe_blit->nb_dirty++] = dirty;
+}
+
+/** @internal @This marks the rectangle covered by a subpicture to be
+ * composed again.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_blit_sub_invalidate(struct upipe *upipe)
+{
+    struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    struct upipe_blit *upipe_blit = upipe_blit_from_sub_mgr(upipe->mgr);
+    if (sub->ubuf == NULL ||
+        sub->hsize == UINT64_MAX || sub->vsize == UINT64_MAX ||
+        sub->hposition == UINT64_MAX || sub->vposition == UINT64_MAX)
+        return;
+
+    struct upipe_blit_rect rect = {
+        .hoffset = sub->hposition, .voffset = sub->vposition,
+        .hsize = sub->hsize, .vsize = sub->vsize,
+    };
+    upipe_blit_invalidate(upipe_blit_to_upipe(upipe_blit), &rect);
+}
+
 /** @internal @This allocates an input subpipe of a blit pipe.
 *
 * @param mgr common management structure
@@ -240,19 +386,36 @@ static struct upipe *upipe_blit_sub_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This blits the subpicture into the input uref.
+/** @internal @This blits the part of the subpicture covering a rectangle
+* into the composed picture.
 *
 * @param upipe description structure of the pipe
-* @param uref uref structure
+* @param canvas composed picture
+* @param rect rectangle of the composed picture to blit
 */
-static void upipe_blit_sub_work(struct upipe *upipe, struct uref *uref)
+static void upipe_blit_sub_work(struct upipe *upipe, struct ubuf *canvas,
+                                const struct upipe_blit_rect *rect)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
     if (unlikely(sub->ubuf == NULL))
         return;
 
-    int err = uref_pic_blit(uref, sub->ubuf, sub->hposition, sub->vposition,
-                            0, 0, sub->hsize, sub->vsize, sub->alpha,
+    uint64_t left = rect->hoffset > sub->hposition ?
+        rect->hoffset : sub->hposition;
+    uint64_t top = rect->voffset > sub->vposition ?
+        rect->voffset : sub->vposition;
+    uint64_t right = rect->hoffset + rect->hsize;
+    if (right > sub->hposition + sub->hsize)
+        right = sub->hposition + sub->hsize;
+    uint64_t bottom = rect->voffset + rect->vsize;
+    if (bottom > sub->vposition + sub->vsize)
+        bottom = sub->vposition + sub->vsize;
+    if (left >= right || top >= bottom)
+        return;
+
+    int err = ubuf_pic_blit(canvas, sub->ubuf, left, top,
+                            left - sub->hposition, top - sub->vposition,
+                            right - left, bottom - top, sub->alpha,
                             sub->alpha_threshold);
     if (unlikely(!ubase_check(err))) {
         upipe_warn(upipe, "unable to blit picture");
@@ -293,9 +456,17 @@ static void upipe_blit_sub_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
-    ubuf_free(sub->ubuf);
-    sub->ubuf = uref_detach_ubuf(uref);
+    struct ubuf *ubuf = uref_detach_ubuf(uref);
     uref_free(uref);
+    if (upipe_blit_same_ubuf(sub->ubuf, ubuf)) {
+        /* static subpicture, nothing to compose again */
+        ubuf_free(ubuf);
+        return;
+    }
+
+    ubuf_free(sub->ubuf);
+    sub->ubuf = ubuf;
+    upipe_blit_sub_invalidate(upipe);
 }
 
 /** @internal @This provides a flow format suggestion.
@@ -527,6 +698,7 @@ static int upipe_blit_sub_set_flow_def(struct upipe *upipe,
         return UBASE_ERR_INVALID;
     UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
 
+    upipe_blit_sub_invalidate(upipe);
     sub->hsize = sub->vsize = sub->hposition = sub->vposition = UINT64_MAX;
     uref_pic_flow_get_hsize(flow_def, &sub->hsize);
     uref_pic_flow_get_vsize(flow_def, &sub->vsize);
@@ -631,6 +803,8 @@ static int _upipe_blit_sub_get_alpha(struct upipe *upipe, uint8_t *alpha_p)
 static int _upipe_blit_sub_set_alpha(struct upipe *upipe, uint8_t alpha)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    if (sub->alpha != alpha)
+        upipe_blit_sub_invalidate(upipe);
     sub->alpha = alpha;
     return UBASE_ERR_NONE;
 }
@@ -660,6 +834,8 @@ static int _upipe_blit_sub_set_alpha_threshold(struct upipe *upipe,
         uint8_t threshold)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    if (sub->alpha_threshold != threshold)
+        upipe_blit_sub_invalidate(upipe);
     sub->alpha_threshold = threshold;
     return UBASE_ERR_NONE;
 }
@@ -686,6 +862,8 @@ static int _upipe_blit_sub_get_z_index(struct upipe *upipe, int *z_index_p)
 static int _upipe_blit_sub_set_z_index(struct upipe *upipe, int z_index)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    if (sub->z_index != z_index)
+        upipe_blit_sub_invalidate(upipe);
     sub->z_index = z_index;
 
     struct upipe_blit *upipe_blit = upipe_blit_from_sub_mgr(upipe->mgr);
@@ -701,6 +879,7 @@ static int _upipe_blit_sub_set_z_index(struct upipe *upipe, int z_index)
 static int _upipe_blit_sub_flush(struct upipe *upipe)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
+    upipe_blit_sub_invalidate(upipe);
     ubuf_free(sub->ubuf);
     sub->ubuf = NULL;
     return UBASE_ERR_NONE;
@@ -835,6 +1014,7 @@ static void upipe_blit_sub_free(struct upipe *upipe)
 {
     struct upipe_blit_sub *sub = upipe_blit_sub_from_upipe(upipe);
     upipe_throw_dead(upipe);
+    upipe_blit_sub_invalidate(upipe);
     ubuf_free(sub->ubuf);
     upipe_blit_sub_clean_sub(upipe);
     upipe_blit_sub_clean_urefcount(upipe);
@@ -884,6 +1064,9 @@ static struct upipe *upipe_blit_alloc(struct upipe_mgr *mgr,
     upipe_blit_init_ubuf_mgr(upipe);
     upipe_blit->hsize = upipe_blit->vsize = UINT64_MAX;
     upipe_blit->uref = NULL;
+    upipe_blit->canvas = NULL;
+    upipe_blit->background = NULL;
+    upipe_blit->nb_dirty = 0;
     urequest_init(&upipe_blit->flow_format_proxy, UREQUEST_FLOW_FORMAT,
                   NULL, upipe_blit_provide_upstream_flow_format,
                   (urequest_free_func)free);
@@ -988,6 +1171,7 @@ static int upipe_blit_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     upipe_blit->hsize = hsize;
     upipe_blit->vsize = vsize;
     upipe_blit->sar = sar;
+    upipe_blit_flush_canvas(upipe);
 
     upipe_blit_require_ubuf_mgr(upipe, uref_dup(flow_def));
 
@@ -999,6 +1183,94 @@ static int upipe_blit_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This composes a rectangle of the output picture, from the
+ * background and all the subpictures covering it.
+ *
+ * @param upipe description structure of the pipe
+ * @param rect rectangle to compose
+ * @return an error code
+ */
+static int upipe_blit_compose(struct upipe *upipe,
+                              const struct upipe_blit_rect *rect)
+{
+    struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
+    UBASE_RETURN(ubuf_pic_blit(upipe_blit->canvas, upipe_blit->background,
+                               rect->hoffset, rect->voffset,
+                               rect->hoffset, rect->voffset,
+                               rect->hsize, rect->vsize, 0xff, 0))
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_blit->subs, uchain) {
+        struct upipe_blit_sub *sub = upipe_blit_sub_from_uchain(uchain);
+        upipe_blit_sub_work(upipe_blit_sub_to_upipe(sub), upipe_blit->canvas,
+                            rect);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This updates the composed picture. Only the rectangles which
+ * changed since the last output picture are composed again, unless the
+ * background changed.
+ *
+ * @param upipe description structure of the pipe
+ * @param background background picture
+ * @return an error code
+ */
+static int upipe_blit_update_canvas(struct upipe *upipe,
+                                    struct ubuf *background)
+{
+    struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
+
+    if (upipe_blit->canvas != NULL &&
+        upipe_blit_same_ubuf(upipe_blit->background, background)) {
+        if (!upipe_blit->nb_dirty)
+            return UBASE_ERR_NONE;
+
+        /* the previous picture may still be in use downstream */
+        const char *chroma;
+        bool writable = true;
+        ubuf_pic_foreach_plane(upipe_blit->canvas, chroma) {
+            if (!ubase_check(ubuf_pic_plane_write(upipe_blit->canvas, chroma,
+                                                  0, 0, -1, -1, NULL)) ||
+                !ubase_check(ubuf_pic_plane_unmap(upipe_blit->canvas, chroma,
+                                                  0, 0, -1, -1))) {
+                writable = false;
+                break;
+            }
+        }
+        if (!writable) {
+            struct ubuf *canvas = ubuf_pic_copy(upipe_blit->ubuf_mgr,
+                                                upipe_blit->canvas,
+                                                0, 0, -1, -1);
+            UBASE_ALLOC_RETURN(canvas);
+            ubuf_free(upipe_blit->canvas);
+            upipe_blit->canvas = canvas;
+        }
+
+        for (unsigned int i = 0; i < upipe_blit->nb_dirty; i++)
+            UBASE_RETURN(upipe_blit_compose(upipe, &upipe_blit->dirty[i]))
+        upipe_blit->nb_dirty = 0;
+        return UBASE_ERR_NONE;
+    }
+
+    /* compose everything */
+    upipe_blit_flush_canvas(upipe);
+    size_t hsize, vsize;
+    UBASE_RETURN(ubuf_pic_size(background, &hsize, &vsize, NULL))
+    upipe_blit->background = ubuf_dup(background);
+    UBASE_ALLOC_RETURN(upipe_blit->background);
+    upipe_blit->canvas = ubuf_pic_alloc(upipe_blit->ubuf_mgr, hsize, vsize);
+    UBASE_ALLOC_RETURN(upipe_blit->canvas);
+
+    struct upipe_blit_rect rect = {
+        .hoffset = 0, .voffset = 0, .hsize = hsize, .vsize = vsize,
+    };
+    int err = upipe_blit_compose(upipe, &rect);
+    if (unlikely(!ubase_check(err)))
+        upipe_blit_flush_canvas(upipe);
+    return err;
+}
+
 /** @internal @This prepares the next picture to output.
  *
  * @param upipe description structure of the pipe
@@ -1011,6 +1283,7 @@ static int _upipe_blit_prepare(struct upipe *upipe, struct upump **upump_p)
     if (unlikely(upipe_blit->uref == NULL))
         return UBASE_ERR_INVALID;
     struct uref *uref = uref_dup(upipe_blit->uref);
+    UBASE_ALLOC_RETURN(uref);
 
     struct uchain *uchain;
     bool subpic = false;
@@ -1024,41 +1297,29 @@ static int _upipe_blit_prepare(struct upipe *upipe, struct upump **upump_p)
 
     /* Avoid copying the picture if there is nothing to blit */
     if (!subpic) {
+        upipe_blit_flush_canvas(upipe);
         upipe_blit_output(upipe, uref, upump_p);
         return UBASE_ERR_NONE;
     }
 
-    /* Check if we can write on the planes */
-    bool writable = true;
-    const char *chroma;
-    uref_pic_foreach_plane(uref, chroma) {
-        if (!ubase_check(uref_pic_plane_write(uref, chroma, 0, 0, -1, -1,
-                                              NULL)) ||
-            !ubase_check(uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1))) {
-            writable = false;
-            break;
-        }
+    if (unlikely(!upipe_blit->ubuf_mgr)) {
+        upipe_warn(upipe, "no ubuf manager set, dropping...");
+        uref_free(uref);
+        return UBASE_ERR_BUSY;
     }
 
-    if (!writable) {
-        if (unlikely(!upipe_blit->ubuf_mgr)) {
-            upipe_warn(upipe, "no ubuf manager set, dropping...");
-            uref_free(uref);
-            return UBASE_ERR_BUSY;
-        }
-        struct ubuf *ubuf = ubuf_pic_copy(upipe_blit->ubuf_mgr,
-                                          uref->ubuf, 0, 0, -1, -1);
-        if (unlikely(ubuf == NULL)) {
-            uref_free(uref);
-            return UBASE_ERR_ALLOC;;
-        }
-        uref_attach_ubuf(uref, ubuf);
+    int err = upipe_blit_update_canvas(upipe, uref->ubuf);
+    if (unlikely(!ubase_check(err))) {
+        uref_free(uref);
+        return err;
     }
 
-    ulist_foreach (&upipe_blit->subs, uchain) {
-        struct upipe_blit_sub *sub = upipe_blit_sub_from_uchain(uchain);
-        upipe_blit_sub_work(upipe_blit_sub_to_upipe(sub), uref);
+    struct ubuf *ubuf = ubuf_dup(upipe_blit->canvas);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
     }
+    uref_attach_ubuf(uref, ubuf);
 
     upipe_blit_output(upipe, uref, upump_p);
     return UBASE_ERR_NONE;
@@ -1290,6 +1551,7 @@ static void upipe_blit_free(struct upipe *upipe)
 
     struct upipe_blit *upipe_blit = upipe_blit_from_upipe(upipe);
     uref_free(upipe_blit->uref);
+    upipe_blit_flush_canvas(upipe);
     urequest_clean(&upipe_blit->flow_format_proxy);
     upipe_blit_clean_ubuf_mgr(upipe);
     upipe_blit_clean_flow_format(upipe);
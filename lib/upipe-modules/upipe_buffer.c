@@ -28,13 +28,18 @@
  *
  * The buffer pipe directly forwards the input uref if it can. When the output
  * upump is blocked by the output pipe, the buffer pipe still accepts the input
- * uref until the maximum size is reached.
+ * uref until the maximum size or duration is reached.
+ *
+ * Several buffer pipes, possibly running in different threads, may share a
+ * memory budget. When the budget is exhausted, a buffer pipe first drops its
+ * oldest non random access urefs, then the incoming urefs.
  */
 
 
 #include "upipe/uclock.h"
 #include "upipe/uref_clock.h"
 #include "upipe/uref_block.h"
+#include "upipe/uref_flow.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
 #include "upipe/upipe_helper_void.h"
@@ -44,6 +49,128 @@
 #include "upipe/upipe_helper_output.h"
 #include "upipe-modules/upipe_buffer.h"
 
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+
+/** @internal @This is a memory budget shared between buffer pipes. */
+struct upipe_buffer_budget {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** mutex protecting the accounted size */
+    pthread_mutex_t lock;
+    /** maximum accounted size */
+    uint64_t max_size;
+    /** currently accounted size */
+    uint64_t size;
+};
+
+/** @internal @This frees a budget.
+ *
+ * @param urefcount pointer to the urefcount structure of the budget
+ */
+static void upipe_buffer_budget_free(struct urefcount *urefcount)
+{
+    struct upipe_buffer_budget *budget =
+        container_of(urefcount, struct upipe_buffer_budget, urefcount);
+    pthread_mutex_destroy(&budget->lock);
+    urefcount_clean(&budget->urefcount);
+    free(budget);
+}
+
+/** @This allocates a memory budget to share between buffer pipes.
+ *
+ * @param max_size maximum size of all the urefs retained by the buffer pipes
+ * using the budget, in octets
+ * @return a pointer to the budget, or NULL in case of allocation error
+ */
+struct upipe_buffer_budget *upipe_buffer_budget_alloc(uint64_t max_size)
+{
+    struct upipe_buffer_budget *budget =
+        malloc(sizeof(struct upipe_buffer_budget));
+    if (unlikely(budget == NULL))
+        return NULL;
+    if (unlikely(pthread_mutex_init(&budget->lock, NULL))) {
+        free(budget);
+        return NULL;
+    }
+    urefcount_init(&budget->urefcount, upipe_buffer_budget_free);
+    budget->max_size = max_size;
+    budget->size = 0;
+    return budget;
+}
+
+/** @This increments the reference count of a budget.
+ *
+ * @param budget pointer to the budget
+ * @return same pointer to the budget
+ */
+struct upipe_buffer_budget *
+    upipe_buffer_budget_use(struct upipe_buffer_budget *budget)
+{
+    if (budget != NULL)
+        urefcount_use(&budget->urefcount);
+    return budget;
+}
+
+/** @This decrements the reference count of a budget, and frees it when it
+ * reaches 0.
+ *
+ * @param budget pointer to the budget
+ */
+void upipe_buffer_budget_release(struct upipe_buffer_budget *budget)
+{
+    if (budget != NULL)
+        urefcount_release(&budget->urefcount);
+}
+
+/** @This returns the size currently accounted against a budget.
+ *
+ * @param budget pointer to the budget
+ * @return the total size of the retained urefs in octets
+ */
+uint64_t upipe_buffer_budget_get_size(struct upipe_buffer_budget *budget)
+{
+    pthread_mutex_lock(&budget->lock);
+    uint64_t size = budget->size;
+    pthread_mutex_unlock(&budget->lock);
+    return size;
+}
+
+/** @internal @This accounts a size against a budget.
+ *
+ * @param budget pointer to the budget
+ * @param size size to account in octets
+ * @param force account the size even if it exceeds the budget
+ * @return false if the budget is exhausted
+ */
+static bool upipe_buffer_budget_reserve(struct upipe_buffer_budget *budget,
+                                        uint64_t size, bool force)
+{
+    bool ret = true;
+    pthread_mutex_lock(&budget->lock);
+    if (!force && budget->size + size > budget->max_size)
+        ret = false;
+    else
+        budget->size += size;
+    pthread_mutex_unlock(&budget->lock);
+    return ret;
+}
+
+/** @internal @This returns a previously accounted size to a budget.
+ *
+ * @param budget pointer to the budget
+ * @param size size to return in octets
+ */
+static void upipe_buffer_budget_unreserve(struct upipe_buffer_budget *budget,
+                                          uint64_t size)
+{
+    pthread_mutex_lock(&budget->lock);
+    assert(budget->size >= size);
+    budget->size -= size;
+    pthread_mutex_unlock(&budget->lock);
+}
+
 /** @internal @This throws an update event.
  *
  * @param upipe description structure of the pipe
@@ -89,6 +216,10 @@ struct upipe_buffer {
     size_t size;
     /** max buffered size */
     uint64_t max_size;
+    /** max buffered duration */
+    uint64_t max_duration;
+    /** shared memory budget */
+    struct upipe_buffer_budget *budget;
     /** low limit */
     uint64_t low_limit;
     /** high limit */
@@ -141,6 +272,8 @@ static struct upipe *upipe_buffer_alloc(struct upipe_mgr *mgr,
     ulist_init(&upipe_buffer->buffered);
     upipe_buffer->size = 0;
     upipe_buffer->max_size = 0;
+    upipe_buffer->max_duration = 0;
+    upipe_buffer->budget = NULL;
     upipe_buffer->low_limit = 0;
     upipe_buffer->high_limit = 0;
     upipe_buffer->last_dts = 0;
@@ -151,6 +284,22 @@ static struct upipe *upipe_buffer_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This removes a uref from the accounted size.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref buffered uref
+ */
+static void upipe_buffer_unaccount(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_buffer *upipe_buffer = upipe_buffer_from_upipe(upipe);
+    size_t block_size;
+    ubase_assert(uref_block_size(uref, &block_size));
+    assert(upipe_buffer->size >= block_size);
+    upipe_buffer->size -= block_size;
+    if (upipe_buffer->budget != NULL)
+        upipe_buffer_budget_unreserve(upipe_buffer->budget, block_size);
+}
+
 /** @internal @This free a buffer pipe.
  *
  * @param upipe description structure of the pipe
@@ -162,8 +311,12 @@ static void upipe_buffer_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     struct uchain *uchain;
-    while ((uchain = ulist_pop(&upipe_buffer->buffered)) != NULL)
-        uref_free(uref_from_uchain(uchain));
+    while ((uchain = ulist_pop(&upipe_buffer->buffered)) != NULL) {
+        struct uref *uref = uref_from_uchain(uchain);
+        upipe_buffer_unaccount(upipe, uref);
+        uref_free(uref);
+    }
+    upipe_buffer_budget_release(upipe_buffer->budget);
 
     upipe_buffer_clean_output(upipe);
     upipe_buffer_clean_input(upipe);
@@ -246,10 +399,7 @@ static void upipe_buffer_worker(struct upump *upump)
         return;
 
     struct uref *uref = uref_from_uchain(uchain);
-    size_t block_size;
-    ubase_assert(uref_block_size(uref, &block_size));
-    assert(upipe_buffer->size >= block_size);
-    upipe_buffer->size -= block_size;
+    upipe_buffer_unaccount(upipe, uref);
     upipe_buffer_update(upipe);
 
     upipe_buffer_output(upipe, uref, &upipe_buffer->upump);
@@ -257,6 +407,29 @@ static void upipe_buffer_worker(struct upump *upump)
         upipe_buffer_unblock_input(upipe);
 }
 
+/** @internal @This drops the oldest buffered uref which is not a random
+ * access point, to free some of the shared budget.
+ *
+ * @param upipe description structure of the pipe
+ * @return false if there was no such uref
+ */
+static bool upipe_buffer_drop(struct upipe *upipe)
+{
+    struct upipe_buffer *upipe_buffer = upipe_buffer_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_buffer->buffered, uchain) {
+        struct uref *uref = uref_from_uchain(uchain);
+        if (ubase_check(uref_flow_get_random(uref)))
+            continue;
+        ulist_delete(uchain);
+        upipe_buffer_unaccount(upipe, uref);
+        uref_free(uref);
+        upipe_dbg(upipe, "memory budget exhausted, dropping buffered uref");
+        return true;
+    }
+    return false;
+}
+
 /** @internal @This allocates the upump if it's not.
  *
  * @param upipe description structure of the pipe
@@ -313,6 +486,12 @@ static bool upipe_buffer_process(struct upipe *upipe,
     if (block_size + upipe_buffer->size > upipe_buffer->max_size)
         return false;
 
+    uint64_t duration;
+    if (upipe_buffer->max_duration &&
+        ubase_check(upipe_buffer_get_duration(upipe, &duration)) &&
+        duration >= upipe_buffer->max_duration)
+        return false;
+
     ret = upipe_buffer_upump_check(upipe);
     if (!ubase_check(ret)) {
         upipe_err(upipe, "fail to allocate upump, dropping...");
@@ -320,6 +499,17 @@ static bool upipe_buffer_process(struct upipe *upipe,
         return true;
     }
 
+    while (upipe_buffer->budget != NULL &&
+           !upipe_buffer_budget_reserve(upipe_buffer->budget, block_size,
+                                        false)) {
+        if (!upipe_buffer_drop(upipe)) {
+            upipe_warn(upipe, "memory budget exhausted, dropping...");
+            uref_free(uref);
+            upipe_buffer_update(upipe);
+            return true;
+        }
+    }
+
     uint64_t date;
     if (ubase_check(uref_clock_get_dts_prog(uref, &date)) ||
         ubase_check(uref_clock_get_dts_sys(uref, &date))) {
@@ -407,6 +597,59 @@ static int _upipe_buffer_set_max_size(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This gets the maximum retain duration of the buffer pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_duration_p a pointer filled with the maximum duration
+ * @return an error code
+ */
+static int _upipe_buffer_get_max_duration(struct upipe *upipe,
+                                          uint64_t *max_duration_p)
+{
+    struct upipe_buffer *upipe_buffer = upipe_buffer_from_upipe(upipe);
+    if (max_duration_p)
+        *max_duration_p = upipe_buffer->max_duration;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum retain duration of the buffer pipe.
+ * The buffer pipe will retain at most @tt {max_duration} before blocking
+ * the input upump.
+ *
+ * @param upipe description structure of the pipe
+ * @param max_duration the maximum duration to set, or 0 for no limit
+ * @return an error code
+ */
+static int _upipe_buffer_set_max_duration(struct upipe *upipe,
+                                          uint64_t max_duration)
+{
+    struct upipe_buffer *upipe_buffer = upipe_buffer_from_upipe(upipe);
+    upipe_buffer->max_duration = max_duration;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the memory budget shared with other buffer pipes.
+ * The urefs already retained are moved to the new budget.
+ *
+ * @param upipe description structure of the pipe
+ * @param budget shared budget, or NULL to remove it
+ * @return an error code
+ */
+static int _upipe_buffer_set_budget(struct upipe *upipe,
+                                    struct upipe_buffer_budget *budget)
+{
+    struct upipe_buffer *upipe_buffer = upipe_buffer_from_upipe(upipe);
+    if (upipe_buffer->budget != NULL) {
+        upipe_buffer_budget_unreserve(upipe_buffer->budget,
+                                      upipe_buffer->size);
+        upipe_buffer_budget_release(upipe_buffer->budget);
+    }
+    upipe_buffer->budget = upipe_buffer_budget_use(budget);
+    if (budget != NULL)
+        upipe_buffer_budget_reserve(budget, upipe_buffer->size, true);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This gets the low limit of the buffer pipe.
  *
  * @param upipe description structure of the pipe
@@ -513,6 +756,22 @@ static int upipe_buffer_control(struct upipe *upipe,
         uint64_t high_limit = va_arg(args, uint64_t);
         return _upipe_buffer_set_high(upipe, high_limit);
     }
+    case UPIPE_BUFFER_GET_MAX_DURATION: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_BUFFER_SIGNATURE)
+        uint64_t *max_duration_p = va_arg(args, uint64_t *);
+        return _upipe_buffer_get_max_duration(upipe, max_duration_p);
+    }
+    case UPIPE_BUFFER_SET_MAX_DURATION: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_BUFFER_SIGNATURE)
+        uint64_t max_duration = va_arg(args, uint64_t);
+        return _upipe_buffer_set_max_duration(upipe, max_duration);
+    }
+    case UPIPE_BUFFER_SET_BUDGET: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_BUFFER_SIGNATURE)
+        struct upipe_buffer_budget *budget =
+            va_arg(args, struct upipe_buffer_budget *);
+        return _upipe_buffer_set_budget(upipe, budget);
+    }
     }
     return UBASE_ERR_UNHANDLED;
 }
@@ -148,8 +148,15 @@ static void upipe_crop_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
-    UBASE_ERROR(upipe, uref_pic_resize(uref, crop->hskip, crop->vskip,
-                                       crop->out_hsize, crop->out_vsize))
+    /* only shrinking, so the output is a view of the input picture */
+    int err = uref_pic_resize(uref, crop->hskip, crop->vskip,
+                              crop->out_hsize, crop->out_vsize);
+    if (unlikely(!ubase_check(err))) {
+        upipe_warn(upipe, "unable to crop picture, dropping...");
+        upipe_throw_error(upipe, err);
+        uref_free(uref);
+        return;
+    }
 
     upipe_crop_output(upipe, uref, upump_p);
 }
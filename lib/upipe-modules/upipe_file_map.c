@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe internal read-only file mappings for file-based sources
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/ubuf_block_common.h"
+#include "upipe_file_map.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+#include <assert.h>
+
+/** @internal @This is a block ubuf pointing into a file mapping. */
+struct upipe_file_map_ubuf {
+    /** common block structure */
+    struct ubuf_block ubuf_block;
+};
+
+UBASE_FROM_TO(upipe_file_map_ubuf, ubuf, ubuf, ubuf_block.ubuf)
+
+/** @This allocates a block ubuf pointing into a mapping.
+ *
+ * @param map pointer to mapping
+ * @param offset offset of the data in the mapping
+ * @param size size of the data
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+struct ubuf *upipe_file_map_ubuf_alloc(struct upipe_file_map *map,
+                                       uint64_t offset, size_t size)
+{
+    struct upipe_file_map_ubuf *map_ubuf =
+        malloc(sizeof(struct upipe_file_map_ubuf));
+    if (unlikely(map_ubuf == NULL))
+        return NULL;
+
+    struct ubuf *ubuf = upipe_file_map_ubuf_to_ubuf(map_ubuf);
+    ubuf->mgr = ubuf_mgr_use(upipe_file_map_to_ubuf_mgr(map));
+    ubuf_block_common_init(ubuf, false);
+    ubuf_block_common_set(ubuf, 0, size);
+    ubuf_block_common_set_buffer(ubuf, map->base + offset);
+    return ubuf;
+}
+
+/** @This refuses to allocate blocks, as mappings are read-only.
+ *
+ * @param mgr common management structure
+ * @param signature type of allocation
+ * @param args optional arguments
+ * @return NULL
+ */
+static struct ubuf *upipe_file_map_alloc_ubuf(struct ubuf_mgr *mgr,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    return NULL;
+}
+
+/** @This creates a new reference to the same mapping.
+ *
+ * @param ubuf pointer to ubuf
+ * @param new_ubuf_p reference written with a pointer to the newly allocated
+ * ubuf
+ * @param offset offset in the buffer, or 0 for a duplicate
+ * @param size final size of the buffer, or -1 for a duplicate
+ * @return an error code
+ */
+static int upipe_file_map_ubuf_splice(struct ubuf *ubuf,
+                                      struct ubuf **new_ubuf_p,
+                                      int offset, int size)
+{
+    assert(new_ubuf_p != NULL);
+    struct upipe_file_map *map = upipe_file_map_from_ubuf_mgr(ubuf->mgr);
+    struct ubuf *new_ubuf = upipe_file_map_ubuf_alloc(map, 0, 0);
+    if (unlikely(new_ubuf == NULL))
+        return UBASE_ERR_ALLOC;
+
+    int err = size < 0 ? ubuf_block_common_dup(ubuf, new_ubuf) :
+              ubuf_block_common_splice(ubuf, new_ubuf, offset, size);
+    if (unlikely(!ubase_check(err))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_INVALID;
+    }
+    *new_ubuf_p = new_ubuf;
+    return UBASE_ERR_NONE;
+}
+
+/** @This handles control commands of mapped blocks.
+ *
+ * @param ubuf pointer to ubuf
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_file_map_ubuf_control(struct ubuf *ubuf, int command,
+                                       va_list args)
+{
+    switch (command) {
+        case UBUF_DUP: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            return upipe_file_map_ubuf_splice(ubuf, new_ubuf_p, 0, -1);
+        }
+        case UBUF_SINGLE:
+            /* pages are mapped read-only */
+            return UBASE_ERR_BUSY;
+        case UBUF_SPLICE_BLOCK: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            int offset = va_arg(args, int);
+            int size = va_arg(args, int);
+            return upipe_file_map_ubuf_splice(ubuf, new_ubuf_p, offset, size);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a mapped block.
+ *
+ * @param ubuf pointer to ubuf
+ */
+static void upipe_file_map_ubuf_free(struct ubuf *ubuf)
+{
+    struct ubuf_mgr *mgr = ubuf->mgr;
+    ubuf_block_common_clean(ubuf);
+    free(upipe_file_map_ubuf_from_ubuf(ubuf));
+    ubuf_mgr_release(mgr);
+}
+
+/** @internal @This unmaps the file when neither the pipe nor a block refers
+ * to the mapping anymore.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upipe_file_map_free(struct urefcount *urefcount)
+{
+    struct upipe_file_map *map = upipe_file_map_from_urefcount(urefcount);
+    munmap(map->base, map->size);
+    urefcount_clean(urefcount);
+    free(map);
+}
+
+/** @This maps the given size of a file, and advises sequential access.
+ *
+ * @param fd file descriptor
+ * @param size size to map, in octets
+ * @return pointer to mapping, or NULL in case of error
+ */
+struct upipe_file_map *upipe_file_map_alloc(int fd, uint64_t size)
+{
+    if (unlikely(!size || size > SIZE_MAX))
+        return NULL;
+
+    struct upipe_file_map *map = malloc(sizeof(struct upipe_file_map));
+    if (unlikely(map == NULL))
+        return NULL;
+
+    map->base = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (unlikely(map->base == MAP_FAILED)) {
+        free(map);
+        return NULL;
+    }
+    map->size = size;
+    madvise(map->base, size, MADV_SEQUENTIAL);
+
+    urefcount_init(upipe_file_map_to_urefcount(map), upipe_file_map_free);
+    map->mgr.refcount = upipe_file_map_to_urefcount(map);
+    map->mgr.signature = UBUF_ALLOC_BLOCK;
+    map->mgr.ubuf_alloc = upipe_file_map_alloc_ubuf;
+    map->mgr.ubuf_control = upipe_file_map_ubuf_control;
+    map->mgr.ubuf_free = upipe_file_map_ubuf_free;
+    map->mgr.ubuf_mgr_control = NULL;
+    return map;
+}
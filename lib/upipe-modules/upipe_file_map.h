@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe internal read-only file mappings for file-based sources
+ */
+
+#ifndef _UPIPE_FILE_MAP_H_
+/** @hidden */
+#define _UPIPE_FILE_MAP_H_
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/ubuf.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** @This is a read-only mapping of a file. It is also the ubuf manager of
+ * the blocks pointing into it, so that it is kept until the last block is
+ * freed. */
+struct upipe_file_map {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** mapped memory */
+    uint8_t *base;
+    /** size of the mapped memory */
+    uint64_t size;
+
+    /** common management structure */
+    struct ubuf_mgr mgr;
+};
+
+UBASE_FROM_TO(upipe_file_map, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(upipe_file_map, ubuf_mgr, ubuf_mgr, mgr)
+
+/** @This maps the given size of a file, and advises sequential access.
+ *
+ * @param fd file descriptor
+ * @param size size to map, in octets
+ * @return pointer to mapping, or NULL in case of error
+ */
+struct upipe_file_map *upipe_file_map_alloc(int fd, uint64_t size);
+
+/** @This allocates a block ubuf pointing into a mapping. The block is
+ * read-only: it refuses UBUF_SINGLE.
+ *
+ * @param map pointer to mapping
+ * @param offset offset of the data in the mapping
+ * @param size size of the data
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+struct ubuf *upipe_file_map_ubuf_alloc(struct upipe_file_map *map,
+                                       uint64_t offset, size_t size);
+
+/** @This releases a reference to a mapping. The file is unmapped when no
+ * block points into it anymore.
+ *
+ * @param map pointer to mapping, or NULL
+ */
+static inline void upipe_file_map_release(struct upipe_file_map *map)
+{
+    if (map != NULL)
+        urefcount_release(upipe_file_map_to_urefcount(map));
+}
+
+#endif
@@ -29,7 +29,11 @@
  * @short Upipe sink module for files
  */
 
+#define _GNU_SOURCE
+
 #include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/ueventfd.h"
 #include "upipe/uclock.h"
 #include "upipe/uref.h"
 #include "upipe/uref_block.h"
@@ -54,10 +58,48 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <assert.h>
+#include <poll.h>
+#include <pthread.h>
 
 #ifndef O_CLOEXEC
 #   define O_CLOEXEC 0
 #endif
+#ifndef O_DIRECT
+#   define O_DIRECT 0
+#endif
+
+/** alignment of staging chunks and direct writes */
+#define UPIPE_FSINK_ALIGN 4096
+
+/** @internal @This is a staging chunk, or a control request if it has no
+ * buffer, processed by the writer thread. */
+struct upipe_fsink_chunk {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** aligned buffer, or NULL */
+    uint8_t *buffer;
+    /** number of octets in the buffer */
+    size_t size;
+
+    /** file descriptor */
+    int fd;
+    /** position in the file, or -1 if it is not seekable */
+    int64_t offset;
+    /** true if the file was opened with O_DIRECT */
+    bool direct;
+    /** number of octets to preallocate before writing */
+    uint64_t prealloc;
+    /** true to sync the file after writing */
+    bool sync;
+    /** true to close the file after writing */
+    bool close;
+    /** true to release preallocated space when closing */
+    bool truncate;
+    /** true if the chunk does not belong to the pool */
+    bool overflow;
+};
+
+UBASE_FROM_TO(upipe_fsink_chunk, uchain, uchain, uchain)
 
 /** @hidden */
 static void upipe_fsink_watcher(struct upump *upump);
@@ -90,6 +132,43 @@ struct upipe_fsink {
     char *path;
     /** sync period */
     uint64_t sync_period;
+    /** octets to preallocate in the next opened file */
+    uint64_t prealloc;
+    /** true if space was preallocated in the current file */
+    bool preallocated;
+
+    /** number of staging chunks, or 0 for synchronous writes */
+    unsigned int async_nb;
+    /** size of a staging chunk */
+    size_t async_size;
+    /** true if files are opened with O_DIRECT in asynchronous mode */
+    bool direct;
+    /** true if the current file is opened with O_DIRECT */
+    bool direct_open;
+    /** position of the next chunk in the current file, or -1 */
+    int64_t offset;
+    /** octets to preallocate with the next chunk */
+    uint64_t prealloc_pending;
+    /** chunk being filled */
+    struct upipe_fsink_chunk *chunk;
+    /** writer thread */
+    pthread_t thread;
+    /** protects the following fields, shared with the writer thread */
+    pthread_mutex_t mutex;
+    /** signals the writer thread */
+    pthread_cond_t cond;
+    /** chunks to process */
+    struct uchain pending;
+    /** chunks available for filling */
+    struct uchain chunks;
+    /** true if the writer thread must exit once idle */
+    bool quit;
+    /** last write error of the writer thread */
+    int error;
+    /** triggered when a chunk is made available */
+    struct ueventfd event;
+    /** true while held buffers are flushed before closing the file */
+    bool flushing;
 
     /** temporary uref storage */
     struct uchain urefs;
@@ -140,6 +219,16 @@ static struct upipe *upipe_fsink_alloc(struct upipe_mgr *mgr,
     upipe_fsink->fd = -1;
     upipe_fsink->path = NULL;
     upipe_fsink->sync_period = 0;
+    upipe_fsink->prealloc = 0;
+    upipe_fsink->preallocated = false;
+    upipe_fsink->async_nb = 0;
+    upipe_fsink->async_size = 0;
+    upipe_fsink->direct = false;
+    upipe_fsink->direct_open = false;
+    upipe_fsink->offset = -1;
+    upipe_fsink->prealloc_pending = 0;
+    upipe_fsink->chunk = NULL;
+    upipe_fsink->flushing = false;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -156,8 +245,15 @@ static void upipe_fsink_poll(struct upipe *upipe)
         upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
         return;
     }
-    struct upump *watcher = upump_alloc_fd_write(upipe_fsink->upump_mgr,
-            upipe_fsink_watcher, upipe, upipe->refcount, upipe_fsink->fd);
+    struct upump *watcher;
+    if (upipe_fsink->async_nb)
+        /* wait for the writer thread to release a chunk */
+        watcher = ueventfd_upump_alloc(&upipe_fsink->event,
+                upipe_fsink->upump_mgr, upipe_fsink_watcher, upipe,
+                upipe->refcount);
+    else
+        watcher = upump_alloc_fd_write(upipe_fsink->upump_mgr,
+                upipe_fsink_watcher, upipe, upipe->refcount, upipe_fsink->fd);
     if (unlikely(watcher == NULL)) {
         upipe_err(upipe, "can't create watcher");
         upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
@@ -167,6 +263,455 @@ static void upipe_fsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This preallocates space in a file without changing its size.
+ *
+ * @param fd file descriptor
+ * @param offset position of the preallocated space
+ * @param size number of octets to preallocate
+ * @return true if space was preallocated
+ */
+static bool upipe_fsink_fallocate(int fd, int64_t offset, uint64_t size)
+{
+#if defined(UPIPE_HAVE_FALLOCATE) && defined(FALLOC_FL_KEEP_SIZE)
+    return fallocate(fd, FALLOC_FL_KEEP_SIZE, offset, size) == 0;
+#else
+    return false;
+#endif
+}
+
+/** @internal @This processes a chunk in the writer thread.
+ *
+ * @param chunk chunk to process
+ * @return 0, or the errno value of the first failure
+ */
+static int upipe_fsink_chunk_process(struct upipe_fsink_chunk *chunk)
+{
+    int err = 0;
+    if (chunk->prealloc && chunk->offset >= 0)
+        upipe_fsink_fallocate(chunk->fd, chunk->offset, chunk->prealloc);
+
+    if (chunk->size) {
+        size_t length = chunk->size;
+        if (chunk->direct && length % UPIPE_FSINK_ALIGN) {
+            /* the last chunk of a file is padded, then truncated */
+            size_t padded = length + UPIPE_FSINK_ALIGN -
+                            length % UPIPE_FSINK_ALIGN;
+            memset(chunk->buffer + length, 0, padded - length);
+            length = padded;
+        }
+
+        const uint8_t *buffer = chunk->buffer;
+        size_t remaining = length;
+        int64_t offset = chunk->offset;
+        while (remaining) {
+            ssize_t ret = offset >= 0 ?
+                pwrite(chunk->fd, buffer, remaining, offset) :
+                write(chunk->fd, buffer, remaining);
+            if (unlikely(ret == -1)) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    struct pollfd pollfd = {
+                        .fd = chunk->fd, .events = POLLOUT
+                    };
+                    poll(&pollfd, 1, -1);
+                    continue;
+                }
+                err = errno;
+                break;
+            }
+            buffer += ret;
+            remaining -= ret;
+            if (offset >= 0)
+                offset += ret;
+        }
+
+        if (!err && length != chunk->size &&
+            ftruncate(chunk->fd, chunk->offset + chunk->size) == -1)
+            err = errno;
+    }
+
+    if (chunk->close && chunk->truncate && chunk->offset >= 0)
+        /* release the preallocated space beyond the data */
+        ftruncate(chunk->fd, chunk->offset + chunk->size);
+    if (chunk->sync)
+#if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+        fdatasync(chunk->fd);
+#else
+        fsync(chunk->fd);
+#endif
+    if (chunk->close)
+        close(chunk->fd);
+    return err;
+}
+
+/** @internal @This is the writer thread.
+ *
+ * @param arg pointer to the private structure of the pipe
+ * @return NULL
+ */
+static void *upipe_fsink_thread(void *arg)
+{
+    struct upipe_fsink *upipe_fsink = arg;
+
+    pthread_mutex_lock(&upipe_fsink->mutex);
+    for ( ; ; ) {
+        struct uchain *uchain = ulist_pop(&upipe_fsink->pending);
+        if (uchain == NULL) {
+            if (upipe_fsink->quit)
+                break;
+            pthread_cond_wait(&upipe_fsink->cond, &upipe_fsink->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&upipe_fsink->mutex);
+
+        struct upipe_fsink_chunk *chunk = upipe_fsink_chunk_from_uchain(uchain);
+        int err = upipe_fsink_chunk_process(chunk);
+
+        pthread_mutex_lock(&upipe_fsink->mutex);
+        if (err && !upipe_fsink->error)
+            upipe_fsink->error = err;
+        if (chunk->buffer != NULL && !chunk->overflow) {
+            chunk->size = 0;
+            ulist_add(&upipe_fsink->chunks, uchain);
+            ueventfd_write(&upipe_fsink->event);
+        } else {
+            free(chunk->buffer);
+            free(chunk);
+        }
+    }
+    pthread_mutex_unlock(&upipe_fsink->mutex);
+    return NULL;
+}
+
+/** @internal @This queues a chunk for the writer thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param chunk chunk to queue, or NULL to queue a control request
+ * @param sync true to sync the file after writing
+ * @param close true to close the file after writing
+ * @return false in case of allocation error
+ */
+static bool upipe_fsink_push_chunk(struct upipe *upipe,
+                                   struct upipe_fsink_chunk *chunk,
+                                   bool sync, bool close)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (chunk == NULL) {
+        chunk = malloc(sizeof(struct upipe_fsink_chunk));
+        if (unlikely(chunk == NULL))
+            return false;
+        uchain_init(&chunk->uchain);
+        chunk->buffer = NULL;
+        chunk->size = 0;
+        chunk->overflow = false;
+    }
+
+    chunk->fd = upipe_fsink->fd;
+    chunk->offset = upipe_fsink->offset;
+    chunk->direct = upipe_fsink->direct_open;
+    chunk->prealloc = upipe_fsink->prealloc_pending;
+    chunk->sync = sync;
+    chunk->close = close;
+    chunk->truncate = close && upipe_fsink->preallocated;
+    upipe_fsink->prealloc_pending = 0;
+    if (upipe_fsink->offset >= 0)
+        upipe_fsink->offset += chunk->size;
+
+    pthread_mutex_lock(&upipe_fsink->mutex);
+    ulist_add(&upipe_fsink->pending, &chunk->uchain);
+    pthread_cond_signal(&upipe_fsink->cond);
+    pthread_mutex_unlock(&upipe_fsink->mutex);
+    return true;
+}
+
+/** @internal @This gets a chunk released by the writer thread. While
+ * flushing, a chunk is allocated outside of the pool if none is available.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to an empty chunk, or NULL if none is available
+ */
+static struct upipe_fsink_chunk *upipe_fsink_get_chunk(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    for (int i = 0; i < 2; i++) {
+        pthread_mutex_lock(&upipe_fsink->mutex);
+        struct uchain *uchain = ulist_pop(&upipe_fsink->chunks);
+        pthread_mutex_unlock(&upipe_fsink->mutex);
+        if (uchain != NULL)
+            return upipe_fsink_chunk_from_uchain(uchain);
+        if (!i)
+            /* double-check after clearing the event */
+            ueventfd_read(&upipe_fsink->event);
+    }
+    if (!upipe_fsink->flushing)
+        return NULL;
+
+    struct upipe_fsink_chunk *chunk = malloc(sizeof(struct upipe_fsink_chunk));
+    if (unlikely(chunk == NULL))
+        return NULL;
+    void *buffer;
+    if (unlikely(posix_memalign(&buffer, UPIPE_FSINK_ALIGN,
+                                upipe_fsink->async_size))) {
+        free(chunk);
+        return NULL;
+    }
+    uchain_init(&chunk->uchain);
+    chunk->buffer = buffer;
+    chunk->size = 0;
+    chunk->overflow = true;
+    return chunk;
+}
+
+/** @internal @This starts the writer thread and allocates staging chunks.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_fsink_start_async(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (unlikely(!ueventfd_init(&upipe_fsink->event, false)))
+        return UBASE_ERR_EXTERNAL;
+    pthread_mutex_init(&upipe_fsink->mutex, NULL);
+    pthread_cond_init(&upipe_fsink->cond, NULL);
+    ulist_init(&upipe_fsink->pending);
+    ulist_init(&upipe_fsink->chunks);
+    upipe_fsink->quit = false;
+    upipe_fsink->error = 0;
+
+    int err = UBASE_ERR_NONE;
+    for (unsigned int i = 0; i < upipe_fsink->async_nb; i++) {
+        struct upipe_fsink_chunk *chunk =
+            malloc(sizeof(struct upipe_fsink_chunk));
+        if (unlikely(chunk == NULL)) {
+            err = UBASE_ERR_ALLOC;
+            break;
+        }
+        void *buffer;
+        if (unlikely(posix_memalign(&buffer, UPIPE_FSINK_ALIGN,
+                                    upipe_fsink->async_size))) {
+            free(chunk);
+            err = UBASE_ERR_ALLOC;
+            break;
+        }
+        uchain_init(&chunk->uchain);
+        chunk->buffer = buffer;
+        chunk->size = 0;
+        chunk->overflow = false;
+        ulist_add(&upipe_fsink->chunks, &chunk->uchain);
+    }
+
+    if (likely(err == UBASE_ERR_NONE) &&
+        unlikely(pthread_create(&upipe_fsink->thread, NULL,
+                                upipe_fsink_thread, upipe_fsink) != 0)) {
+        upipe_err(upipe, "can't create writer thread");
+        err = UBASE_ERR_EXTERNAL;
+    }
+
+    if (unlikely(err != UBASE_ERR_NONE)) {
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&upipe_fsink->chunks)) != NULL) {
+            struct upipe_fsink_chunk *chunk =
+                upipe_fsink_chunk_from_uchain(uchain);
+            free(chunk->buffer);
+            free(chunk);
+        }
+        pthread_cond_destroy(&upipe_fsink->cond);
+        pthread_mutex_destroy(&upipe_fsink->mutex);
+        ueventfd_clean(&upipe_fsink->event);
+        upipe_fsink->async_nb = 0;
+    }
+    return err;
+}
+
+/** @internal @This waits for the writer thread to process all queued chunks,
+ * stops it and releases the staging chunks.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_stop_async(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (!upipe_fsink->async_nb)
+        return;
+
+    upipe_fsink_set_upump(upipe, NULL);
+    pthread_mutex_lock(&upipe_fsink->mutex);
+    if (upipe_fsink->chunk != NULL) {
+        upipe_fsink->chunk->size = 0;
+        ulist_add(&upipe_fsink->chunks, &upipe_fsink->chunk->uchain);
+        upipe_fsink->chunk = NULL;
+    }
+    upipe_fsink->quit = true;
+    pthread_cond_signal(&upipe_fsink->cond);
+    pthread_mutex_unlock(&upipe_fsink->mutex);
+    pthread_join(upipe_fsink->thread, NULL);
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&upipe_fsink->chunks)) != NULL) {
+        struct upipe_fsink_chunk *chunk = upipe_fsink_chunk_from_uchain(uchain);
+        free(chunk->buffer);
+        free(chunk);
+    }
+    pthread_cond_destroy(&upipe_fsink->cond);
+    pthread_mutex_destroy(&upipe_fsink->mutex);
+    ueventfd_clean(&upipe_fsink->event);
+    upipe_fsink->async_nb = 0;
+}
+
+/** @internal @This closes the current file, or hands it over to the writer
+ * thread in asynchronous mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param close false to flush the file without closing it
+ */
+static void upipe_fsink_close(struct upipe *upipe, bool close)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (upipe_fsink->fd == -1)
+        return;
+    if (likely(upipe_fsink->path != NULL))
+        upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
+
+    if (upipe_fsink->async_nb) {
+        /* buffers held for lack of chunks belong to this file */
+        if (!upipe_fsink_check_input(upipe)) {
+            upipe_fsink->flushing = true;
+            upipe_fsink_output_input(upipe);
+            upipe_fsink->flushing = false;
+            if (upipe_fsink_check_input(upipe)) {
+                upipe_fsink_set_upump(upipe, NULL);
+                upipe_fsink_unblock_input(upipe);
+                /* Release the pipe used in @ref upipe_fsink_input. */
+                upipe_release(upipe);
+            }
+        }
+        if (unlikely(!upipe_fsink_push_chunk(upipe, upipe_fsink->chunk,
+                                             false, close))) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            if (close)
+                ubase_clean_fd(&upipe_fsink->fd);
+        }
+        upipe_fsink->chunk = NULL;
+    } else if (close) {
+        if (upipe_fsink->preallocated) {
+            off_t offset = lseek(upipe_fsink->fd, 0, SEEK_CUR);
+            if (offset != -1)
+                ftruncate(upipe_fsink->fd, offset);
+        }
+        ubase_clean_fd(&upipe_fsink->fd);
+    }
+    upipe_fsink->fd = -1;
+    upipe_fsink->preallocated = false;
+}
+
+/** @internal @This prepares a newly opened file for writing.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsink_open(struct upipe *upipe)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    upipe_fsink->offset = lseek(upipe_fsink->fd, 0, SEEK_CUR);
+    upipe_fsink->direct_open = false;
+    if (upipe_fsink->async_nb && O_DIRECT) {
+        int flags = fcntl(upipe_fsink->fd, F_GETFL);
+        if (flags != -1 && (flags & O_DIRECT)) {
+            if (upipe_fsink->offset >= 0 &&
+                !(upipe_fsink->offset % UPIPE_FSINK_ALIGN))
+                upipe_fsink->direct_open = true;
+            else {
+                upipe_warn(upipe, "unaligned file, disabling direct I/O");
+                fcntl(upipe_fsink->fd, F_SETFL, flags & ~O_DIRECT);
+            }
+        }
+    }
+
+    upipe_fsink->preallocated = false;
+    if (upipe_fsink->prealloc && upipe_fsink->offset >= 0) {
+        upipe_fsink->preallocated = true;
+        if (upipe_fsink->async_nb)
+            upipe_fsink->prealloc_pending = upipe_fsink->prealloc;
+        else if (!upipe_fsink_fallocate(upipe_fsink->fd, upipe_fsink->offset,
+                                        upipe_fsink->prealloc))
+            upipe_fsink->preallocated = false;
+    }
+    upipe_fsink->prealloc = 0;
+}
+
+/** @internal @This copies data to the staging chunks in asynchronous mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @return true if the uref was processed
+ */
+static bool upipe_fsink_output_async(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+
+    pthread_mutex_lock(&upipe_fsink->mutex);
+    int err = upipe_fsink->error;
+    upipe_fsink->error = 0;
+    pthread_mutex_unlock(&upipe_fsink->mutex);
+    if (unlikely(err)) {
+        uref_free(uref);
+        errno = err;
+        upipe_warn_va(upipe, "write error to %s (%m)", upipe_fsink->path);
+        upipe_fsink_set_upump(upipe, NULL);
+        upipe_fsink_set_upump_sync(upipe, NULL);
+        upipe_throw_sink_end(upipe);
+        return true;
+    }
+
+    for ( ; ; ) {
+        size_t size;
+        if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+            uref_free(uref);
+            upipe_warn(upipe, "cannot read ubuf buffer");
+            return true;
+        }
+        if (unlikely(!size)) {
+            uref_free(uref);
+            return true;
+        }
+
+        if (upipe_fsink->chunk == NULL &&
+            (upipe_fsink->chunk = upipe_fsink_get_chunk(upipe)) == NULL) {
+            upipe_fsink_poll(upipe);
+            return false;
+        }
+
+        struct upipe_fsink_chunk *chunk = upipe_fsink->chunk;
+        size_t copy = upipe_fsink->async_size - chunk->size;
+        if (copy > size)
+            copy = size;
+        if (unlikely(!ubase_check(uref_block_extract(uref, 0, copy,
+                        chunk->buffer + chunk->size)))) {
+            uref_free(uref);
+            upipe_warn(upipe, "cannot read ubuf buffer");
+            return true;
+        }
+        chunk->size += copy;
+
+        if (chunk->size == upipe_fsink->async_size) {
+            if (unlikely(!upipe_fsink_push_chunk(upipe, chunk, false,
+                                                 false))) {
+                uref_free(uref);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return true;
+            }
+            upipe_fsink->chunk = NULL;
+        }
+
+        if (copy == size) {
+            uref_free(uref);
+            return true;
+        }
+        uref_block_resize(uref, copy, -1);
+    }
+}
+
 /** @internal @This outputs data to the file sink.
  *
  * @param upipe description structure of the pipe
@@ -194,7 +739,7 @@ static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
-    if (likely(upipe_fsink->uclock == NULL))
+    if (likely(upipe_fsink->uclock == NULL) || upipe_fsink->flushing)
         goto write_buffer;
 
     uint64_t cr_sys = 0;
@@ -211,6 +756,9 @@ static bool upipe_fsink_output(struct upipe *upipe, struct uref *uref,
     }
 
 write_buffer:
+    if (upipe_fsink->async_nb)
+        return upipe_fsink_output_async(upipe, uref);
+
     for ( ; ; ) {
         int iovec_count = uref_block_iovec_count(uref, 0, -1);
         if (unlikely(iovec_count == -1)) {
@@ -298,7 +846,10 @@ static void upipe_fsink_sync(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
-    if (likely(upipe_fsink->fd != -1))
+    if (upipe_fsink->async_nb) {
+        if (likely(upipe_fsink->fd != -1))
+            upipe_fsink_push_chunk(upipe, NULL, true, false);
+    } else if (likely(upipe_fsink->fd != -1))
 #if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
         fdatasync(upipe_fsink->fd);
 #else
@@ -387,11 +938,7 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
 {
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
 
-    if (unlikely(upipe_fsink->fd != -1)) {
-        if (likely(upipe_fsink->path != NULL))
-            upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
-        ubase_clean_fd(&upipe_fsink->fd);
-    }
+    upipe_fsink_close(upipe, true);
     ubase_clean_str(&upipe_fsink->path);
     upipe_fsink_set_upump(upipe, NULL);
     upipe_fsink_set_upump_sync(upipe, NULL);
@@ -426,8 +973,16 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
             upipe_err_va(upipe, "invalid mode %d", mode);
             return UBASE_ERR_INVALID;
     }
-    upipe_fsink->fd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC | flags,
-                           S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (upipe_fsink->async_nb && upipe_fsink->direct) {
+        upipe_fsink->fd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC |
+                               O_DIRECT | flags,
+                               S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (upipe_fsink->fd == -1 && errno == EINVAL)
+            upipe_warn_va(upipe, "direct I/O not supported for %s", path);
+    }
+    if (upipe_fsink->fd == -1)
+        upipe_fsink->fd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC | flags,
+                               S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
     if (unlikely(upipe_fsink->fd == -1)) {
         upipe_err_va(upipe, "can't open file %s (%s)", path, mode_desc);
         return UBASE_ERR_EXTERNAL;
@@ -451,6 +1006,7 @@ static int _upipe_fsink_set_path(struct upipe *upipe, const char *path,
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+    upipe_fsink_open(upipe);
     if (!upipe_fsink_check_input(upipe))
         /* Use again the pipe that we previously released. */
         upipe_use(upipe);
@@ -471,11 +1027,7 @@ static int _upipe_fsink_set_fd(struct upipe *upipe, int fd,
 {
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
 
-    if (unlikely(upipe_fsink->fd != -1)) {
-        if (likely(upipe_fsink->path != NULL))
-            upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
-        ubase_clean_fd(&upipe_fsink->fd);
-    }
+    upipe_fsink_close(upipe, true);
     ubase_clean_str(&upipe_fsink->path);
     upipe_fsink_set_upump(upipe, NULL);
     upipe_fsink_set_upump_sync(upipe, NULL);
@@ -518,6 +1070,7 @@ static int _upipe_fsink_set_fd(struct upipe *upipe, int fd,
         default:
             break;
     }
+    upipe_fsink_open(upipe);
 
     if (!upipe_fsink_check_input(upipe))
         /* Use again the pipe that we previously released. */
@@ -568,6 +1121,62 @@ static int _upipe_fsink_get_sync_period(struct upipe *upipe, uint64_t *p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the asynchronous write mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_chunks number of staging chunks, or 0 for synchronous writes
+ * @param chunk_size size of a staging chunk
+ * @param direct true to open files with O_DIRECT
+ * @return an error code
+ */
+static int _upipe_fsink_set_async(struct upipe *upipe, unsigned int nb_chunks,
+                                  size_t chunk_size, bool direct)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (unlikely(upipe_fsink->fd != -1)) {
+        upipe_warn(upipe, "can't change write mode while a file is opened");
+        return UBASE_ERR_BUSY;
+    }
+    if (nb_chunks && unlikely(!chunk_size))
+        return UBASE_ERR_INVALID;
+
+    upipe_fsink_stop_async(upipe);
+    upipe_fsink->direct = direct;
+    if (!nb_chunks)
+        return UBASE_ERR_NONE;
+
+    upipe_fsink->async_nb = nb_chunks;
+    upipe_fsink->async_size = (chunk_size + UPIPE_FSINK_ALIGN - 1) &
+                              ~(size_t)(UPIPE_FSINK_ALIGN - 1);
+    UBASE_RETURN(upipe_fsink_start_async(upipe))
+    upipe_dbg_va(upipe, "writing asynchronously with %u chunks of %zu octets%s",
+                 nb_chunks, upipe_fsink->async_size,
+                 direct ? " (direct)" : "");
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the asynchronous write mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_chunks_p filled in with the number of staging chunks
+ * @param chunk_size_p filled in with the size of a staging chunk
+ * @param direct_p filled in with true if files are opened with O_DIRECT
+ * @return an error code
+ */
+static int _upipe_fsink_get_async(struct upipe *upipe,
+                                  unsigned int *nb_chunks_p,
+                                  size_t *chunk_size_p, int *direct_p)
+{
+    struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+    if (nb_chunks_p != NULL)
+        *nb_chunks_p = upipe_fsink->async_nb;
+    if (chunk_size_p != NULL)
+        *chunk_size_p = upipe_fsink->async_size;
+    if (direct_p != NULL)
+        *direct_p = upipe_fsink->direct ? 1 : 0;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file sink pipe.
  *
  * @param upipe description structure of the pipe
@@ -639,6 +1248,28 @@ static int  _upipe_fsink_control(struct upipe *upipe, int command, va_list args)
             uint64_t *p = va_arg(args, uint64_t *);
             return _upipe_fsink_get_sync_period(upipe, p);
         }
+        case UPIPE_FSINK_SET_ASYNC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int nb_chunks = va_arg(args, unsigned int);
+            size_t chunk_size = va_arg(args, size_t);
+            int direct = va_arg(args, int);
+            return _upipe_fsink_set_async(upipe, nb_chunks, chunk_size,
+                                          !!direct);
+        }
+        case UPIPE_FSINK_GET_ASYNC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int *nb_chunks_p = va_arg(args, unsigned int *);
+            size_t *chunk_size_p = va_arg(args, size_t *);
+            int *direct_p = va_arg(args, int *);
+            return _upipe_fsink_get_async(upipe, nb_chunks_p, chunk_size_p,
+                                          direct_p);
+        }
+        case UPIPE_FSINK_SET_PREALLOCATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
+            upipe_fsink->prealloc = va_arg(args, uint64_t);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -688,12 +1319,9 @@ static int upipe_fsink_control(struct upipe *upipe, int command, va_list args)
 static void upipe_fsink_free(struct upipe *upipe)
 {
     struct upipe_fsink *upipe_fsink = upipe_fsink_from_upipe(upipe);
-    if (likely(upipe_fsink->fd != -1)) {
-        if (likely(upipe_fsink->path != NULL)) {
-            upipe_notice_va(upipe, "closing file %s", upipe_fsink->path);
-            close(upipe_fsink->fd);
-        }
-    }
+    /* descriptors associated without a path are not closed */
+    upipe_fsink_close(upipe, upipe_fsink->path != NULL);
+    upipe_fsink_stop_async(upipe);
     upipe_throw_dead(upipe);
 
     free(upipe_fsink->path);
@@ -36,6 +36,8 @@
 #include "upipe/uref_block.h"
 #include "upipe/uref_block_flow.h"
 #include "upipe/uref_clock.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block.h"
 #include "upipe/upump.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
@@ -49,13 +51,20 @@
 #include "upipe/upipe_helper_uclock.h"
 #include "upipe/upipe_helper_output_size.h"
 #include "upipe-modules/upipe_file_source.h"
+#include "upipe_file_map.h"
+
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+#include "upump-uring/upump_uring.h"
+#endif
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <assert.h>
@@ -105,6 +114,8 @@ struct upipe_fsrc {
     struct upump_mgr *upump_mgr;
     /** read watcher */
     struct upump *upump;
+    /** uref being read into by an io_uring read pump, or NULL */
+    struct uref *uring_uref;
     /** read size */
     unsigned int output_size;
 
@@ -118,6 +129,17 @@ struct upipe_fsrc {
     /** length to read */
     uint64_t length;
 
+    /** true if regular files are mapped */
+    bool mmap;
+    /** readahead window in memory-mapped mode */
+    uint64_t readahead;
+    /** current mapping, or NULL */
+    struct upipe_file_map *map;
+    /** reading position in the mapping */
+    uint64_t position;
+    /** end of the range already given as readahead hint */
+    uint64_t readahead_end;
+
     /** public upipe structure */
     struct upipe upipe;
     /** guard for upump */
@@ -144,6 +166,121 @@ UPIPE_HELPER_UPUMP_MGR(upipe_fsrc, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_fsrc, upump, upump_mgr)
 UPIPE_HELPER_OUTPUT_SIZE(upipe_fsrc, output_size)
 
+/** @internal @This releases the current mapping, if any.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsrc_unmap(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    upipe_file_map_release(upipe_fsrc->map);
+    upipe_fsrc->map = NULL;
+}
+
+/** @internal @This maps the opened file again if it has grown beyond the
+ * current mapping. Blocks pointing into the previous mapping stay valid.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if the mapping was extended
+ */
+static bool upipe_fsrc_remap(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t mapped = upipe_fsrc->map != NULL ? upipe_fsrc->map->size : 0;
+    struct stat st;
+    if (unlikely(fstat(upipe_fsrc->fd, &st) == -1) ||
+        (uint64_t)st.st_size <= mapped)
+        return false;
+
+    struct upipe_file_map *map = upipe_file_map_alloc(upipe_fsrc->fd,
+                                                      st.st_size);
+    if (unlikely(map == NULL)) {
+        upipe_warn_va(upipe, "unable to map %"PRIu64" octets (%m)",
+                      (uint64_t)st.st_size);
+        return false;
+    }
+    upipe_fsrc_unmap(upipe);
+    upipe_fsrc->map = map;
+    upipe_verbose_va(upipe, "mapped %"PRIu64" octets", map->size);
+    return true;
+}
+
+/** @internal @This gives the kernel a readahead hint for the pages following
+ * the reading position, once it gets close to the end of the previous hint.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsrc_readahead(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    struct upipe_file_map *map = upipe_fsrc->map;
+    if (!upipe_fsrc->readahead ||
+        upipe_fsrc->readahead_end >= map->size ||
+        upipe_fsrc->position + upipe_fsrc->readahead / 2 <
+            upipe_fsrc->readahead_end)
+        return;
+
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    uint64_t start = upipe_fsrc->readahead_end;
+    uint64_t end = upipe_fsrc->position + upipe_fsrc->readahead;
+    end = (end + page_size - 1) & ~(page_size - 1);
+    if (end > map->size)
+        end = map->size;
+    if (unlikely(madvise(map->base + start, end - start, MADV_WILLNEED)))
+        upipe_warn_va(upipe, "unable to give readahead hint (%m)");
+    upipe_fsrc->readahead_end = end;
+}
+
+/** @internal @This moves the reading position in the mapping.
+ *
+ * @param upipe description structure of the pipe
+ * @param position new reading position, in octets
+ */
+static void upipe_fsrc_seek_map(struct upipe *upipe, uint64_t position)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t page_size = sysconf(_SC_PAGESIZE);
+    upipe_fsrc->position = position;
+    upipe_fsrc->readahead_end = position & ~(page_size - 1);
+}
+
+/** @internal @This allocates a uref pointing to the next data of the
+ * mapping.
+ *
+ * @param upipe description structure of the pipe
+ * @param size_p filled in with the size of the data, 0 at the end of file
+ * @return pointer to uref or NULL in case of allocation error
+ */
+static struct uref *upipe_fsrc_read_map(struct upipe *upipe, size_t *size_p)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    if (upipe_fsrc->position >= upipe_fsrc->map->size)
+        upipe_fsrc_remap(upipe);
+
+    struct upipe_file_map *map = upipe_fsrc->map;
+    uint64_t size = 0;
+    if (upipe_fsrc->position < map->size)
+        size = map->size - upipe_fsrc->position;
+    if (size > upipe_fsrc->output_size)
+        size = upipe_fsrc->output_size;
+
+    struct uref *uref = uref_alloc(upipe_fsrc->uref_mgr);
+    if (unlikely(uref == NULL))
+        return NULL;
+    struct ubuf *ubuf = upipe_file_map_ubuf_alloc(map,
+            size ? upipe_fsrc->position : 0, size);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(uref);
+        return NULL;
+    }
+    uref_attach_ubuf(uref, ubuf);
+
+    upipe_fsrc->position += size;
+    upipe_fsrc_readahead(upipe);
+    *size_p = size;
+    return uref;
+}
+
 /** @internal @This allocates a file source pipe.
  *
  * @param mgr common management structure
@@ -172,6 +309,12 @@ static struct upipe *upipe_fsrc_alloc(struct upipe_mgr *mgr,
     upipe_fsrc->uri = NULL;
     upipe_fsrc->fd = -1;
     upipe_fsrc->length = (uint64_t)-1;
+    upipe_fsrc->mmap = false;
+    upipe_fsrc->readahead = 0;
+    upipe_fsrc->map = NULL;
+    upipe_fsrc->position = 0;
+    upipe_fsrc->readahead_end = 0;
+    upipe_fsrc->uring_uref = NULL;
     upipe_fsrc->safe = false;
     upipe_throw_ready(upipe);
     return upipe;
@@ -183,6 +326,12 @@ static void upipe_fsrc_set_upump_safe(struct upipe *upipe,
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     upipe_fsrc->safe = false;
     upipe_fsrc_set_upump(upipe, upump);
+    /* the previous pump has completed its pending read once freed */
+    if (upipe_fsrc->uring_uref != NULL) {
+        uref_block_unmap(upipe_fsrc->uring_uref, 0);
+        uref_free(upipe_fsrc->uring_uref);
+        upipe_fsrc->uring_uref = NULL;
+    }
 }
 
 /** @internal @This returns the path of the currently opened file.
@@ -200,6 +349,45 @@ static int upipe_fsrc_get_uri(struct upipe *upipe, const char **path_p)
     return uref_uri_get_path(upipe_fsrc->uri, path_p);
 }
 
+/** @internal @This outputs a block read from the file, and handles the end
+ * of file.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref block allocated with the output size
+ * @param ret number of octets read into the block
+ * @param systime date of the wake-up, if a uclock is attached
+ * @return false if the pump was released during the output
+ */
+static bool upipe_fsrc_output_read(struct upipe *upipe, struct uref *uref,
+                                   size_t ret, uint64_t systime)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    size_t size = 0;
+    uref_block_size(uref, &size);
+    if (upipe_fsrc->length != (uint64_t)-1)
+        upipe_fsrc->length -= ret;
+    if (upipe_fsrc->uclock != NULL)
+        uref_clock_set_cr_sys(uref, systime);
+    if (unlikely(ret != size))
+        uref_block_resize(uref, 0, ret);
+    if (unlikely(ret == 0))
+        uref_block_set_end(uref);
+    upipe_fsrc->safe = true;
+    upipe_fsrc_output(upipe, uref, &upipe_fsrc->upump);
+    if (unlikely(!upipe_fsrc->safe))
+        return false;
+    if (unlikely(ret == 0)) {
+        const char *path = "(none)";
+        upipe_fsrc_get_uri(upipe, &path);
+        upipe_notice_va(upipe, "end of file %s", path);
+        upipe_fsrc_set_upump_safe(upipe, NULL);
+        ubase_clean_fd(&upipe_fsrc->fd);
+        upipe_throw_source_end(upipe);
+        return false;
+    }
+    return true;
+}
+
 /** @internal @This reads data from the source and outputs it.
  * It is called either when the idler triggers (permanent storage mode) or
  * when data is available on the file descriptor (live stream mode).
@@ -232,70 +420,152 @@ static void upipe_fsrc_worker(struct upump *upump)
             return;
     }
 
+    struct uref *uref;
+    ssize_t ret;
+    if (upipe_fsrc->map != NULL) {
+        size_t size;
+        uref = upipe_fsrc_read_map(upipe, &size);
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        ret = size;
+    } else {
+        uref = uref_block_alloc(upipe_fsrc->uref_mgr, upipe_fsrc->ubuf_mgr,
+                                upipe_fsrc->output_size);
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+
+        uint8_t *buffer;
+        int output_size = -1;
+        if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                                   &buffer)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        assert(output_size == upipe_fsrc->output_size);
+
+        ret = read(upipe_fsrc->fd, buffer, upipe_fsrc->output_size);
+        uref_block_unmap(uref, 0);
+
+        if (unlikely(ret == -1)) {
+            uref_free(uref);
+            switch (errno) {
+                case EINTR:
+                case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+                case EWOULDBLOCK:
+#endif
+                    /* not an issue, try again later */
+                    return;
+                case EBADF:
+                case EINVAL:
+                case EIO:
+                default:
+                    break;
+            }
+            const char *path = "(none)";
+            upipe_fsrc_get_uri(upipe, &path);
+            upipe_err_va(upipe, "read error from %s (%m)", path);
+            upipe_fsrc_set_upump_safe(upipe, NULL);
+            ubase_clean_fd(&upipe_fsrc->fd);
+            upipe_throw_source_end(upipe);
+            return;
+        }
+    }
+
+    upipe_fsrc_output_read(upipe, uref, ret, systime);
+}
+
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+/** @internal @This allocates the next block and submits its read to the
+ * io_uring read pump.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fsrc_uring_submit(struct upipe *upipe)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t size = upipe_fsrc->output_size;
+    if (upipe_fsrc->length < size)
+        size = upipe_fsrc->length;
+
     struct uref *uref = uref_block_alloc(upipe_fsrc->uref_mgr,
-                                         upipe_fsrc->ubuf_mgr,
-                                         upipe_fsrc->output_size);
+                                         upipe_fsrc->ubuf_mgr, size);
     if (unlikely(uref == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
     }
 
     uint8_t *buffer;
-    int output_size = -1;
-    if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+    int write_size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &write_size,
                                                &buffer)))) {
         uref_free(uref);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return;
     }
-    assert(output_size == upipe_fsrc->output_size);
+    upipe_fsrc->uring_uref = uref;
+    upump_uring_set_buffer(upipe_fsrc->upump, buffer, write_size, -1);
+    upump_restart(upipe_fsrc->upump);
+}
 
-    ssize_t ret = read(upipe_fsrc->fd, buffer, upipe_fsrc->output_size);
-    uref_block_unmap(uref, 0);
+/** @internal @This outputs the data read by the io_uring read pump, and
+ * submits the next read.
+ *
+ * @param upump description structure of the read pump
+ */
+static void upipe_fsrc_uring_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    uint64_t systime = 0; /* to keep gcc quiet */
+    if (upipe_fsrc->uclock != NULL)
+        systime = uclock_now(upipe_fsrc->uclock);
 
-    if (unlikely(ret == -1)) {
+    ssize_t ret;
+    if (unlikely(!ubase_check(upump_uring_get_result(upump, &ret))))
+        ret = -EIO;
+    if (unlikely(ret == -EINTR || ret == -EAGAIN)) {
+        /* not an issue, submit the same buffer again */
+        upump_restart(upump);
+        return;
+    }
+
+    struct uref *uref = upipe_fsrc->uring_uref;
+    upipe_fsrc->uring_uref = NULL;
+    uref_block_unmap(uref, 0);
+    if (unlikely(ret < 0)) {
         uref_free(uref);
-        switch (errno) {
-            case EINTR:
-            case EAGAIN:
-#if EAGAIN != EWOULDBLOCK
-            case EWOULDBLOCK:
-#endif
-                /* not an issue, try again later */
-                return;
-            case EBADF:
-            case EINVAL:
-            case EIO:
-            default:
-                break;
-        }
         const char *path = "(none)";
         upipe_fsrc_get_uri(upipe, &path);
+        errno = -ret;
         upipe_err_va(upipe, "read error from %s (%m)", path);
         upipe_fsrc_set_upump_safe(upipe, NULL);
         ubase_clean_fd(&upipe_fsrc->fd);
         upipe_throw_source_end(upipe);
         return;
     }
-    if (upipe_fsrc->length != (uint64_t)-1)
-        upipe_fsrc->length -= ret;
-    if (upipe_fsrc->uclock != NULL)
-        uref_clock_set_cr_sys(uref, systime);
-    if (unlikely(ret != upipe_fsrc->output_size))
-        uref_block_resize(uref, 0, ret);
-    if (unlikely(ret == 0))
-        uref_block_set_end(uref);
-    upipe_fsrc->safe = true;
-    upipe_fsrc_output(upipe, uref, &upipe_fsrc->upump);
-    if (likely(upipe_fsrc->safe) && unlikely(ret == 0)) {
-        const char *path = "(none)";
-        upipe_fsrc_get_uri(upipe, &path);
-        upipe_notice_va(upipe, "end of file %s", path);
+
+    if (!upipe_fsrc_output_read(upipe, uref, ret, systime))
+        return;
+
+    if (!upipe_fsrc->length) {
+        const char *path;
+        if (ubase_check(upipe_fsrc_get_uri(upipe, &path)))
+            path = "(none)";
+        upipe_notice_va(upipe, "end of range %s", path);
         upipe_fsrc_set_upump_safe(upipe, NULL);
         ubase_clean_fd(&upipe_fsrc->fd);
         upipe_throw_source_end(upipe);
+        return;
     }
+    upipe_fsrc_uring_submit(upipe);
 }
+#endif
 
 /** @internal @This builds the flow definition.
  *
@@ -357,6 +627,22 @@ static int upipe_fsrc_check(struct upipe *upipe, struct uref *flow_format)
 
     if (upipe_fsrc->fd != -1 && upipe_fsrc->upump == NULL) {
         struct upump *upump;
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+        if (upipe_fsrc->map == NULL && upipe_fsrc->length &&
+            upipe_fsrc->upump_mgr->signature == UPUMP_URING_SIGNATURE) {
+            upump = upump_uring_alloc_read(upipe_fsrc->upump_mgr,
+                                           upipe_fsrc_uring_worker, upipe,
+                                           upipe->refcount, upipe_fsrc->fd,
+                                           NULL, 0, -1);
+            if (unlikely(upump == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+                return UBASE_ERR_UPUMP;
+            }
+            upipe_fsrc_set_upump_safe(upipe, upump);
+            upipe_fsrc_uring_submit(upipe);
+            return UBASE_ERR_NONE;
+        }
+#endif
         if (upipe_fsrc->regular_file)
             upump = upump_alloc_idler(upipe_fsrc->upump_mgr,
                                       upipe_fsrc_worker, upipe,
@@ -408,6 +694,11 @@ static int upipe_fsrc_open(struct upipe *upipe)
     upipe_fsrc->fd = fd;
     upipe_fsrc->regular_file = !!S_ISREG(st.st_mode);
     upipe_notice_va(upipe, "opening file %s", path);
+    if (upipe_fsrc->mmap && upipe_fsrc->regular_file) {
+        upipe_fsrc_seek_map(upipe, 0);
+        if (!upipe_fsrc_remap(upipe))
+            upipe_warn_va(upipe, "not mapping file %s", path);
+    }
     upipe_fsrc_build_flow_def(upipe);
     return UBASE_ERR_NONE;
 }
@@ -423,6 +714,7 @@ static void upipe_fsrc_close(struct upipe *upipe)
         upipe_notice_va(upipe, "closing file %s", path);
         ubase_clean_fd(&upipe_fsrc->fd);
     }
+    upipe_fsrc_unmap(upipe);
     upipe_fsrc->length = (uint64_t)-1;
     upipe_fsrc_set_upump_safe(upipe, NULL);
     uref_free(upipe_fsrc->uri);
@@ -509,6 +801,10 @@ static int _upipe_fsrc_get_position(struct upipe *upipe,
     assert(position_p != NULL);
     if (unlikely(upipe_fsrc->fd == -1))
         return UBASE_ERR_UNHANDLED;
+    if (upipe_fsrc->map != NULL) {
+        *position_p = upipe_fsrc->position;
+        return UBASE_ERR_NONE;
+    }
     off_t position = lseek(upipe_fsrc->fd, 0, SEEK_CUR);
     if (unlikely(position == (off_t)-1))
         return UBASE_ERR_EXTERNAL;
@@ -527,6 +823,13 @@ static int _upipe_fsrc_set_position(struct upipe *upipe, uint64_t position)
     struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
     if (unlikely(upipe_fsrc->fd == -1))
         return UBASE_ERR_UNHANDLED;
+    if (upipe_fsrc->map != NULL) {
+        upipe_fsrc_seek_map(upipe, position);
+        return UBASE_ERR_NONE;
+    }
+    if (upipe_fsrc->uring_uref != NULL)
+        /* drop the pending read, the pump is reallocated afterwards */
+        upipe_fsrc_set_upump_safe(upipe, NULL);
     return lseek(upipe_fsrc->fd, position, SEEK_SET) != (off_t)-1 ?
         UBASE_ERR_NONE : UBASE_ERR_EXTERNAL;
 }
@@ -583,6 +886,26 @@ static int _upipe_fsrc_get_range(struct upipe *upipe,
     return _upipe_fsrc_get_length(upipe, length_p);
 }
 
+/** @internal @This sets the memory-mapped read mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to map regular files
+ * @param readahead readahead window, in octets, or 0
+ * @return an error code
+ */
+static int _upipe_fsrc_set_mmap(struct upipe *upipe, bool enable,
+                                uint64_t readahead)
+{
+    struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+    if (unlikely(upipe_fsrc->fd != -1)) {
+        upipe_err(upipe, "cannot change read mode of an opened file");
+        return UBASE_ERR_BUSY;
+    }
+    upipe_fsrc->mmap = enable;
+    upipe_fsrc->readahead = readahead;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe.
  *
  * @param upipe description structure of the pipe
@@ -646,6 +969,24 @@ static int _upipe_fsrc_control(struct upipe *upipe, int command, va_list args)
             return _upipe_fsrc_get_range(upipe, offset_p, length_p);
         }
 
+        case UPIPE_FSRC_SET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            bool enable = !!va_arg(args, int);
+            uint64_t readahead = va_arg(args, uint64_t);
+            return _upipe_fsrc_set_mmap(upipe, enable, readahead);
+        }
+        case UPIPE_FSRC_GET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSRC_SIGNATURE)
+            struct upipe_fsrc *upipe_fsrc = upipe_fsrc_from_upipe(upipe);
+            int *enable_p = va_arg(args, int *);
+            uint64_t *readahead_p = va_arg(args, uint64_t *);
+            if (enable_p != NULL)
+                *enable_p = upipe_fsrc->mmap ? 1 : 0;
+            if (readahead_p != NULL)
+                *readahead_p = upipe_fsrc->readahead;
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
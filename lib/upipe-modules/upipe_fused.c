@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module running a chain of stateless pipes in a single pipe
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uref.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe-modules/upipe_fused.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+
+/** @internal @This describes a stage of the chain. */
+struct upipe_fused_stage {
+    /** stage pipe */
+    struct upipe *upipe;
+    /** in-place process function of the stage */
+    upipe_process_func process;
+};
+
+/** @internal @This is the private context of a fused pipe. */
+struct upipe_fused {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** input flow definition packet */
+    struct uref *flow_def_input;
+    /** array of stages */
+    struct upipe_fused_stage *stages;
+    /** number of stages */
+    unsigned int nb_stages;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_fused, upipe, UPIPE_FUSED_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_fused, urefcount, upipe_fused_free)
+UPIPE_HELPER_VOID(upipe_fused)
+UPIPE_HELPER_OUTPUT(upipe_fused, output, flow_def, output_state, request_list)
+
+/** @internal @This allocates a fused pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_fused_alloc(struct upipe_mgr *mgr,
+                                       struct uprobe *uprobe,
+                                       uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_fused_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_fused *upipe_fused = upipe_fused_from_upipe(upipe);
+    upipe_fused_init_urefcount(upipe);
+    upipe_fused_init_output(upipe);
+    upipe_fused->flow_def_input = NULL;
+    upipe_fused->stages = NULL;
+    upipe_fused->nb_stages = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This runs the uref through all stages and outputs it.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_fused_input(struct upipe *upipe, struct uref *uref,
+                              struct upump **upump_p)
+{
+    struct upipe_fused *upipe_fused = upipe_fused_from_upipe(upipe);
+    for (unsigned int i = 0; i < upipe_fused->nb_stages; i++) {
+        struct upipe_fused_stage *stage = &upipe_fused->stages[i];
+        if (!stage->process(stage->upipe, uref, upump_p))
+            return;
+    }
+    upipe_fused_output(upipe, uref, upump_p);
+}
+
+/** @internal @This propagates the input flow definition through all stages
+ * and stores the resulting output flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_fused_build_flow_def(struct upipe *upipe)
+{
+    struct upipe_fused *upipe_fused = upipe_fused_from_upipe(upipe);
+    if (upipe_fused->flow_def_input == NULL)
+        return UBASE_ERR_NONE;
+
+    struct uref *flow_def = upipe_fused->flow_def_input;
+    for (unsigned int i = 0; i < upipe_fused->nb_stages; i++) {
+        struct upipe *stage = upipe_fused->stages[i].upipe;
+        UBASE_RETURN(upipe_set_flow_def(stage, flow_def))
+        UBASE_RETURN(upipe_get_flow_def(stage, &flow_def))
+        if (unlikely(flow_def == NULL))
+            return UBASE_ERR_INVALID;
+    }
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    upipe_fused_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_fused_set_flow_def(struct upipe *upipe,
+                                    struct uref *flow_def)
+{
+    struct upipe_fused *upipe_fused = upipe_fused_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    struct uref *flow_def_dup;
+    if ((flow_def_dup = uref_dup(flow_def)) == NULL)
+        return UBASE_ERR_ALLOC;
+    uref_free(upipe_fused->flow_def_input);
+    upipe_fused->flow_def_input = flow_def_dup;
+    return upipe_fused_build_flow_def(upipe);
+}
+
+/** @internal @This appends a stage to the chain.
+ *
+ * @param upipe description structure of the pipe
+ * @param stage pipe to append
+ * @return an error code
+ */
+static int _upipe_fused_add_stage(struct upipe *upipe, struct upipe *stage)
+{
+    struct upipe_fused *upipe_fused = upipe_fused_from_upipe(upipe);
+    if (stage == NULL)
+        return UBASE_ERR_INVALID;
+
+    upipe_process_func process = NULL;
+    if (!ubase_check(upipe_get_process(stage, &process)) || process == NULL) {
+        upipe_warn(upipe, "stage cannot process urefs in place");
+        return UBASE_ERR_INVALID;
+    }
+
+    struct upipe_fused_stage *stages =
+        realloc(upipe_fused->stages,
+                (upipe_fused->nb_stages + 1) * sizeof(*stages));
+    UBASE_ALLOC_RETURN(stages)
+    upipe_fused->stages = stages;
+    stages[upipe_fused->nb_stages].upipe = upipe_use(stage);
+    stages[upipe_fused->nb_stages].process = process;
+    upipe_fused->nb_stages++;
+    return upipe_fused_build_flow_def(upipe);
+}
+
+/** @internal @This processes control commands on a fused pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_fused_control(struct upipe *upipe, int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_fused_control_output(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_fused_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_FUSED_ADD_STAGE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FUSED_SIGNATURE)
+            struct upipe *stage = va_arg(args, struct upipe *);
+            return _upipe_fused_add_stage(upipe, stage);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_fused_free(struct upipe *upipe)
+{
+    struct upipe_fused *upipe_fused = upipe_fused_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    for (unsigned int i = 0; i < upipe_fused->nb_stages; i++)
+        upipe_release(upipe_fused->stages[i].upipe);
+    free(upipe_fused->stages);
+    uref_free(upipe_fused->flow_def_input);
+    upipe_fused_clean_output(upipe);
+    upipe_fused_clean_urefcount(upipe);
+    upipe_fused_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_fused_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_FUSED_SIGNATURE,
+
+    .upipe_alloc = upipe_fused_alloc,
+    .upipe_input = upipe_fused_input,
+    .upipe_control = upipe_fused_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all fused pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_fused_mgr_alloc(void)
+{
+    return &upipe_fused_mgr;
+}
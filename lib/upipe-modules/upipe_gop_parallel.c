@@ -0,0 +1,568 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module encoding segments of pictures on several encoders
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uref.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/uref_flow.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_subpipe.h"
+#include "upipe-modules/upipe_gop_parallel.h"
+#include "upipe-framers/uref_h264.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+
+#include <bitstream/itu/h264.h>
+
+/** default number of pictures per segment */
+#define UPIPE_GOPP_DEFAULT_SEGMENT_SIZE 250
+
+/** @internal @This is the private context of a gop parallel pipe. */
+struct upipe_gopp {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of encoder subpipes */
+    struct uchain subs;
+    /** manager to create encoder subpipes */
+    struct upipe_mgr sub_mgr;
+    /** number of encoders */
+    unsigned int nb_encoders;
+
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output pipe */
+    struct upipe *output;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** output requests */
+    struct uchain requests;
+
+    /** number of pictures per segment */
+    unsigned int segment_size;
+    /** segment being received */
+    uint64_t segment_in;
+    /** number of pictures received in the current input segment */
+    unsigned int pictures_in;
+    /** segment being output */
+    uint64_t segment_out;
+    /** number of buffers output in the current output segment */
+    unsigned int pictures_out;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_gopp, upipe, UPIPE_GOPP_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_gopp, urefcount, upipe_gopp_no_input)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_gopp, urefcount_real, upipe_gopp_free)
+UPIPE_HELPER_VOID(upipe_gopp)
+UPIPE_HELPER_OUTPUT(upipe_gopp, output, flow_def, output_state, requests)
+
+/** @internal @This is the private context of an encoder of a gop parallel
+ * pipe. The subpipe is the output of the encoder. */
+struct upipe_gopp_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** index of the encoder */
+    unsigned int index;
+    /** encoder pipe */
+    struct upipe *encoder;
+    /** flow definition of the encoder output */
+    struct uref *flow_def;
+    /** buffers waiting for their segment to be output */
+    struct uchain urefs;
+    /** true if the encoder released its output */
+    bool ended;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_gopp_sub, upipe, UPIPE_GOPP_SUB_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_gopp_sub, urefcount, upipe_gopp_sub_no_ref)
+UPIPE_HELPER_VOID(upipe_gopp_sub)
+
+UPIPE_HELPER_SUBPIPE(upipe_gopp, upipe_gopp_sub, sub, sub_mgr, subs, uchain)
+
+/** @internal @This returns the encoder subpipe handling the given segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param segment segment number
+ * @return pointer to the subpipe, or NULL if it no longer exists
+ */
+static struct upipe_gopp_sub *upipe_gopp_find_sub(struct upipe *upipe,
+                                                  uint64_t segment)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+    unsigned int index = segment % upipe_gopp->nb_encoders;
+    struct uchain *uchain;
+    ulist_foreach (&upipe_gopp->subs, uchain) {
+        struct upipe_gopp_sub *sub = upipe_gopp_sub_from_uchain(uchain);
+        if (sub->index == index)
+            return sub;
+    }
+    return NULL;
+}
+
+/** @internal @This frees an encoder subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_gopp_sub_free(struct upipe *upipe)
+{
+    struct upipe_gopp_sub *sub = upipe_gopp_sub_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&sub->urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    uref_free(sub->flow_def);
+    upipe_release(sub->encoder);
+
+    upipe_gopp_sub_clean_sub(upipe);
+    upipe_gopp_sub_clean_urefcount(upipe);
+    upipe_gopp_sub_free_void(upipe);
+}
+
+/** @internal @This outputs the buffers of the encoders in segment order.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_gopp_flush(struct upipe *upipe, struct upump **upump_p)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+    /* freeing the last subpipe would free the pipe */
+    upipe_gopp_use_urefcount_real(upipe);
+
+    for ( ; ; ) {
+        struct upipe_gopp_sub *sub =
+            upipe_gopp_find_sub(upipe, upipe_gopp->segment_out);
+        struct uchain *uchain = sub != NULL ? ulist_pop(&sub->urefs) : NULL;
+        if (uchain != NULL) {
+            if (sub->flow_def != NULL &&
+                (upipe_gopp->flow_def == NULL ||
+                 udict_cmp(upipe_gopp->flow_def->udict,
+                           sub->flow_def->udict))) {
+                struct uref *flow_def = uref_dup(sub->flow_def);
+                if (unlikely(flow_def == NULL)) {
+                    upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                    uref_free(uref_from_uchain(uchain));
+                    continue;
+                }
+                upipe_gopp_store_flow_def(upipe, flow_def);
+            }
+            upipe_gopp_output(upipe, uref_from_uchain(uchain), upump_p);
+            if (++upipe_gopp->pictures_out < upipe_gopp->segment_size)
+                continue;
+        } else if (sub != NULL && !sub->ended)
+            /* wait for the encoder */
+            break;
+        else {
+            /* the encoder is gone, skip its remaining pictures if the
+             * following segments are ready */
+            bool pending = false;
+            struct uchain *u;
+            ulist_foreach (&upipe_gopp->subs, u)
+                if (!ulist_empty(&upipe_gopp_sub_from_uchain(u)->urefs))
+                    pending = true;
+            if (!pending)
+                break;
+        }
+
+        upipe_gopp->segment_out++;
+        upipe_gopp->pictures_out = 0;
+    }
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_gopp->subs, uchain, uchain_tmp) {
+        struct upipe_gopp_sub *sub = upipe_gopp_sub_from_uchain(uchain);
+        if (sub->ended && ulist_empty(&sub->urefs))
+            upipe_gopp_sub_free(upipe_gopp_sub_to_upipe(sub));
+    }
+
+    upipe_gopp_release_urefcount_real(upipe);
+}
+
+/** @internal @This is called when the encoder releases the subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_gopp_sub_no_ref(struct upipe *upipe)
+{
+    struct upipe_gopp_sub *sub = upipe_gopp_sub_from_upipe(upipe);
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_sub_mgr(upipe->mgr);
+    sub->ended = true;
+    upipe_gopp_flush(upipe_gopp_to_upipe(upipe_gopp), NULL);
+}
+
+/** @internal @This allocates an encoder subpipe of a gop parallel pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_gopp_sub_alloc(struct upipe_mgr *mgr,
+                                          struct uprobe *uprobe,
+                                          uint32_t signature, va_list args)
+{
+    if (mgr->signature != UPIPE_GOPP_SUB_SIGNATURE)
+        return NULL;
+
+    struct upipe *upipe =
+        upipe_gopp_sub_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_gopp_sub *sub = upipe_gopp_sub_from_upipe(upipe);
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_sub_mgr(mgr);
+    upipe_gopp_sub_init_urefcount(upipe);
+    upipe_gopp_sub_init_sub(upipe);
+    sub->index = upipe_gopp->nb_encoders;
+    sub->encoder = NULL;
+    sub->flow_def = NULL;
+    ulist_init(&sub->urefs);
+    sub->ended = false;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This receives a buffer from the encoder.
+ *
+ * @param upipe description structure of the subpipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_gopp_sub_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_gopp_sub *sub = upipe_gopp_sub_from_upipe(upipe);
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_sub_mgr(upipe->mgr);
+    ulist_add(&sub->urefs, uref_to_uchain(uref));
+    upipe_gopp_flush(upipe_gopp_to_upipe(upipe_gopp), upump_p);
+}
+
+/** @internal @This processes control commands on an encoder subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_gopp_sub_control(struct upipe *upipe,
+                                  int command, va_list args)
+{
+    struct upipe_gopp_sub *sub = upipe_gopp_sub_from_upipe(upipe);
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_sub_mgr(upipe->mgr);
+
+    UBASE_HANDLED_RETURN(upipe_gopp_sub_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_gopp_register_output_request(
+                upipe_gopp_to_upipe(upipe_gopp), request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_gopp_unregister_output_request(
+                upipe_gopp_to_upipe(upipe_gopp), request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            struct uref *flow_def_dup = uref_dup(flow_def);
+            UBASE_ALLOC_RETURN(flow_def_dup);
+            uref_free(sub->flow_def);
+            sub->flow_def = flow_def_dup;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This initializes the encoder manager of a gop parallel pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gopp_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_gopp->sub_mgr;
+    sub_mgr->refcount = upipe_gopp_to_urefcount_real(upipe_gopp);
+    sub_mgr->signature = UPIPE_GOPP_SUB_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_gopp_sub_alloc;
+    sub_mgr->upipe_input = upipe_gopp_sub_input;
+    sub_mgr->upipe_control = upipe_gopp_sub_control;
+}
+
+/** @internal @This allocates a gop parallel pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_gopp_alloc(struct upipe_mgr *mgr,
+                                      struct uprobe *uprobe,
+                                      uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_gopp_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+    upipe_gopp_init_urefcount(upipe);
+    upipe_gopp_init_urefcount_real(upipe);
+    upipe_gopp_init_sub_subs(upipe);
+    upipe_gopp_init_sub_mgr(upipe);
+    upipe_gopp_init_output(upipe);
+    upipe_gopp->nb_encoders = 0;
+    upipe_gopp->segment_size = UPIPE_GOPP_DEFAULT_SEGMENT_SIZE;
+    upipe_gopp->segment_in = 0;
+    upipe_gopp->pictures_in = 0;
+    upipe_gopp->segment_out = 0;
+    upipe_gopp->pictures_out = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This dispatches a picture to the encoder of its segment.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_gopp_input(struct upipe *upipe, struct uref *uref,
+                             struct upump **upump_p)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+
+    if (unlikely(!upipe_gopp->nb_encoders)) {
+        upipe_warn(upipe, "no encoder, dropping picture");
+        uref_free(uref);
+        return;
+    }
+
+    if (upipe_gopp->pictures_in >= upipe_gopp->segment_size) {
+        upipe_gopp->segment_in++;
+        upipe_gopp->pictures_in = 0;
+    }
+    if (!upipe_gopp->pictures_in) {
+        /* start a closed GOP */
+        uref_pic_set_key(uref);
+        uref_h264_set_type(uref, H264SLI_TYPE_I);
+    }
+    upipe_gopp->pictures_in++;
+
+    struct upipe_gopp_sub *sub =
+        upipe_gopp_find_sub(upipe, upipe_gopp->segment_in);
+    if (unlikely(sub == NULL || sub->encoder == NULL)) {
+        upipe_warn(upipe, "encoder is gone, dropping picture");
+        uref_free(uref);
+        return;
+    }
+    upipe_input(sub->encoder, uref, upump_p);
+}
+
+/** @internal @This adds an encoder.
+ *
+ * @param upipe description structure of the pipe
+ * @param encoder encoder pipe
+ * @return an error code
+ */
+static int upipe_gopp_add_encoder_internal(struct upipe *upipe,
+                                           struct upipe *encoder)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+    if (encoder == NULL)
+        return UBASE_ERR_INVALID;
+    if (upipe_gopp->segment_in || upipe_gopp->pictures_in)
+        return UBASE_ERR_BUSY;
+
+    struct upipe *sub = upipe_void_alloc(&upipe_gopp->sub_mgr,
+        uprobe_pfx_alloc_va(uprobe_use(upipe->uprobe), UPROBE_LOG_VERBOSE,
+                            "enc %u", upipe_gopp->nb_encoders));
+    UBASE_ALLOC_RETURN(sub);
+
+    struct upipe_gopp_sub *upipe_gopp_sub = upipe_gopp_sub_from_upipe(sub);
+    int err = upipe_set_output(encoder, sub);
+    /* the encoder now holds the only reference to its output */
+    upipe_release(sub);
+    if (unlikely(!ubase_check(err))) {
+        upipe_err(upipe, "cannot set the output of the encoder");
+        return err;
+    }
+    upipe_gopp_sub->encoder = upipe_use(encoder);
+    upipe_gopp->nb_encoders++;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition on all encoders.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def new flow definition
+ * @return an error code
+ */
+static int upipe_gopp_set_flow_def(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF))
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_gopp->subs, uchain) {
+        struct upipe_gopp_sub *sub = upipe_gopp_sub_from_uchain(uchain);
+        if (sub->encoder != NULL)
+            UBASE_RETURN(upipe_set_flow_def(sub->encoder, flow_def))
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a gop parallel pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_gopp_control(struct upipe *upipe, int command, va_list args)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(upipe_gopp_control_output(upipe, command, args));
+    UBASE_HANDLED_RETURN(upipe_gopp_control_subs(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_gopp_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_GOPP_ADD_ENCODER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GOPP_SIGNATURE)
+            struct upipe *encoder = va_arg(args, struct upipe *);
+            return upipe_gopp_add_encoder_internal(upipe, encoder);
+        }
+        case UPIPE_GOPP_GET_SEGMENT_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GOPP_SIGNATURE)
+            unsigned int *segment_size_p = va_arg(args, unsigned int *);
+            *segment_size_p = upipe_gopp->segment_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_GOPP_SET_SEGMENT_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GOPP_SIGNATURE)
+            unsigned int segment_size = va_arg(args, unsigned int);
+            if (!segment_size)
+                return UBASE_ERR_INVALID;
+            if (upipe_gopp->segment_in || upipe_gopp->pictures_in)
+                return UBASE_ERR_BUSY;
+            upipe_gopp->segment_size = segment_size;
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gopp_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_gopp_clean_sub_subs(upipe);
+    upipe_gopp_clean_output(upipe);
+    upipe_gopp_clean_urefcount_real(upipe);
+    upipe_gopp_clean_urefcount(upipe);
+    upipe_gopp_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ * The encoders are released, so that they flush their last segments.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_gopp_no_input(struct upipe *upipe)
+{
+    struct upipe_gopp *upipe_gopp = upipe_gopp_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+
+    /* the subpipes are kept alive until the pipe is freed */
+    upipe_gopp_use_urefcount_real(upipe);
+    ulist_delete_foreach (&upipe_gopp->subs, uchain, uchain_tmp) {
+        struct upipe_gopp_sub *sub = upipe_gopp_sub_from_uchain(uchain);
+        struct upipe *encoder = sub->encoder;
+        sub->encoder = NULL;
+        upipe_release(encoder);
+    }
+    upipe_gopp_release_urefcount_real(upipe);
+    upipe_gopp_release_urefcount_real(upipe);
+}
+
+/** gop parallel module manager static descriptor */
+static struct upipe_mgr upipe_gopp_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_GOPP_SIGNATURE,
+
+    .upipe_alloc = upipe_gopp_alloc,
+    .upipe_input = upipe_gopp_input,
+    .upipe_control = upipe_gopp_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all gop parallel pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_gopp_mgr_alloc(void)
+{
+    return &upipe_gopp_mgr;
+}
@@ -119,6 +119,20 @@ struct upipe_grid_in {
     struct upump_mgr *upump_mgr;
     /** update timer */
     struct upump *upump;
+    /** requested tile horizontal size or 0 */
+    uint64_t tile_hsize;
+    /** requested tile vertical size or 0 */
+    uint64_t tile_vsize;
+    /** last received flow def, before scaling */
+    struct uref *input_flow_def;
+    /** horizontal size of the scaled pictures, or 0 if not scaled */
+    size_t scale_hsize;
+    /** vertical size of the scaled pictures, or 0 if not scaled */
+    size_t scale_vsize;
+    /** scaler scratch buffer */
+    uint32_t *scale_buffer;
+    /** scaler scratch buffer size in elements */
+    size_t scale_buffer_size;
 };
 
 /** @hidden */
@@ -211,6 +225,8 @@ static void upipe_grid_in_free(struct upipe *upipe)
         ulist_delete(uchain);
         uref_free(uref_from_uchain(uchain));
     }
+    uref_free(upipe_grid_in->input_flow_def);
+    free(upipe_grid_in->scale_buffer);
     upipe_grid_in_clean_upump(upipe);
     upipe_grid_in_clean_upump_mgr(upipe);
     upipe_grid_in_clean_flow_def(upipe);
@@ -252,6 +268,13 @@ static struct upipe *upipe_grid_in_alloc(struct upipe_mgr *mgr,
     upipe_grid_in->last_update_print = 0;
     upipe_grid_in->max_buffer = INT64_MIN;
     upipe_grid_in->min_buffer = INT64_MAX;
+    upipe_grid_in->tile_hsize = 0;
+    upipe_grid_in->tile_vsize = 0;
+    upipe_grid_in->input_flow_def = NULL;
+    upipe_grid_in->scale_hsize = 0;
+    upipe_grid_in->scale_vsize = 0;
+    upipe_grid_in->scale_buffer = NULL;
+    upipe_grid_in->scale_buffer_size = 0;
 
     upipe_throw_ready(upipe);
 
@@ -495,6 +518,195 @@ static void upipe_grid_in_schedule_update(struct upipe *upipe)
         upipe_grid_in_wait_upump(upipe, duration, upipe_grid_in_update_cb);
 }
 
+/** @internal @This rewrites an input flow def to the tile size, and
+ * enables or disables the scaling of the following pictures.
+ *
+ * @param upipe description structure of the input pipe
+ * @param flow_def input flow def, modified in place
+ */
+static void upipe_grid_in_tile_flow_def(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    struct upipe_grid_in *upipe_grid_in = upipe_grid_in_from_upipe(upipe);
+
+    upipe_grid_in->scale_hsize = 0;
+    upipe_grid_in->scale_vsize = 0;
+    if (!upipe_grid_in->tile_hsize || !upipe_grid_in->tile_vsize ||
+        !ubase_check(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF)))
+        return;
+
+    uint8_t macropixel, planes, hsub, vsub;
+    uint64_t hsize, vsize;
+    if (!ubase_check(uref_pic_flow_get_macropixel(flow_def, &macropixel)) ||
+        !ubase_check(uref_pic_flow_get_planes(flow_def, &planes)) ||
+        !ubase_check(uref_pic_flow_max_subsampling(flow_def, &hsub, &vsub)) ||
+        !ubase_check(uref_pic_flow_get_hsize(flow_def, &hsize)) ||
+        !ubase_check(uref_pic_flow_get_vsize(flow_def, &vsize)) ||
+        macropixel != 1) {
+        upipe_warn(upipe, "unsupported picture format, not scaling");
+        return;
+    }
+    for (uint8_t plane = 0; plane < planes; plane++) {
+        uint8_t macropixel_size;
+        if (!ubase_check(uref_pic_flow_get_macropixel_size(
+                    flow_def, &macropixel_size, plane)) ||
+            macropixel_size != 1) {
+            upipe_warn(upipe, "unsupported picture format, not scaling");
+            return;
+        }
+    }
+
+    uint64_t tile_hsize = upipe_grid_in->tile_hsize;
+    uint64_t tile_vsize = upipe_grid_in->tile_vsize;
+    tile_hsize -= tile_hsize % hsub;
+    tile_vsize -= tile_vsize % vsub;
+    if (!tile_hsize || !tile_vsize ||
+        tile_hsize > hsize || tile_vsize > vsize) {
+        upipe_warn_va(upipe, "invalid tile size %"PRIu64"x%"PRIu64
+                      " for %"PRIu64"x%"PRIu64", not scaling",
+                      upipe_grid_in->tile_hsize, upipe_grid_in->tile_vsize,
+                      hsize, vsize);
+        return;
+    }
+
+    /* keep the display aspect ratio */
+    struct urational sar = { 1, 1 };
+    uref_pic_flow_get_sar(flow_def, &sar);
+    sar.num *= hsize * tile_vsize;
+    sar.den *= vsize * tile_hsize;
+    urational_simplify(&sar);
+    if (!ubase_check(uref_pic_flow_set_sar(flow_def, sar)) ||
+        !ubase_check(uref_pic_flow_set_hsize(flow_def, tile_hsize)) ||
+        !ubase_check(uref_pic_flow_set_vsize(flow_def, tile_vsize))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uref_pic_flow_delete_hsize_visible(flow_def);
+    uref_pic_flow_delete_vsize_visible(flow_def);
+
+    upipe_grid_in->scale_hsize = tile_hsize;
+    upipe_grid_in->scale_vsize = tile_vsize;
+}
+
+/** @internal @This downscales a picture plane by averaging the source area
+ * covered by each destination pixel.
+ *
+ * @param src source plane
+ * @param src_stride source stride
+ * @param src_hsize source width in pixels
+ * @param src_vsize source height in lines
+ * @param dst destination plane
+ * @param dst_stride destination stride
+ * @param dst_hsize destination width in pixels
+ * @param dst_vsize destination height in lines
+ * @param buffer scratch buffer of at least src_hsize + dst_hsize + 1
+ * elements
+ */
+static void upipe_grid_in_scale_plane(const uint8_t *src, size_t src_stride,
+                                      size_t src_hsize, size_t src_vsize,
+                                      uint8_t *dst, size_t dst_stride,
+                                      size_t dst_hsize, size_t dst_vsize,
+                                      uint32_t *buffer)
+{
+    uint32_t *acc = buffer;
+    uint32_t *xoff = buffer + src_hsize;
+
+    for (size_t x = 0; x <= dst_hsize; x++)
+        xoff[x] = x * src_hsize / dst_hsize;
+
+    for (size_t y = 0; y < dst_vsize; y++) {
+        size_t y0 = y * src_vsize / dst_vsize;
+        size_t y1 = (y + 1) * src_vsize / dst_vsize;
+
+        /* sum the source lines */
+        const uint8_t *line = src + y0 * src_stride;
+        for (size_t x = 0; x < src_hsize; x++)
+            acc[x] = line[x];
+        for (size_t l = y0 + 1; l < y1; l++) {
+            line = src + l * src_stride;
+            for (size_t x = 0; x < src_hsize; x++)
+                acc[x] += line[x];
+        }
+
+        /* then the source columns */
+        uint8_t *out = dst + y * dst_stride;
+        for (size_t x = 0; x < dst_hsize; x++) {
+            uint32_t sum = 0;
+            for (uint32_t c = xoff[x]; c < xoff[x + 1]; c++)
+                sum += acc[c];
+            uint32_t count = (xoff[x + 1] - xoff[x]) * (y1 - y0);
+            out[x] = (sum + count / 2) / count;
+        }
+    }
+}
+
+/** @internal @This downscales an input picture to the tile size.
+ *
+ * @param upipe description structure of the input pipe
+ * @param uref input picture, its ubuf is replaced by the scaled one
+ * @return an error code
+ */
+static int upipe_grid_in_scale(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_grid_in *upipe_grid_in = upipe_grid_in_from_upipe(upipe);
+    size_t dst_hsize = upipe_grid_in->scale_hsize;
+    size_t dst_vsize = upipe_grid_in->scale_vsize;
+    size_t hsize, vsize;
+
+    UBASE_RETURN(ubuf_pic_size(uref->ubuf, &hsize, &vsize, NULL));
+    if (hsize == dst_hsize && vsize == dst_vsize)
+        return UBASE_ERR_NONE;
+    if (unlikely(hsize < dst_hsize || vsize < dst_vsize))
+        return UBASE_ERR_INVALID;
+
+    if (upipe_grid_in->scale_buffer_size < hsize + dst_hsize + 1) {
+        uint32_t *buffer = realloc(upipe_grid_in->scale_buffer,
+                (hsize + dst_hsize + 1) * sizeof (uint32_t));
+        UBASE_ALLOC_RETURN(buffer);
+        upipe_grid_in->scale_buffer = buffer;
+        upipe_grid_in->scale_buffer_size = hsize + dst_hsize + 1;
+    }
+
+    struct ubuf *ubuf = ubuf_pic_alloc(uref->ubuf->mgr, dst_hsize, dst_vsize);
+    UBASE_ALLOC_RETURN(ubuf);
+
+    const char *chroma;
+    ubuf_pic_foreach_plane(ubuf, chroma) {
+        size_t src_stride, dst_stride;
+        uint8_t hsub, vsub;
+        const uint8_t *src;
+        uint8_t *dst;
+        int err = ubuf_pic_plane_size(uref->ubuf, chroma, &src_stride,
+                                      &hsub, &vsub, NULL);
+        if (ubase_check(err))
+            err = ubuf_pic_plane_size(ubuf, chroma, &dst_stride,
+                                      NULL, NULL, NULL);
+        if (ubase_check(err))
+            err = ubuf_pic_plane_read(uref->ubuf, chroma, 0, 0, -1, -1, &src);
+        if (unlikely(!ubase_check(err))) {
+            ubuf_free(ubuf);
+            return err;
+        }
+        err = ubuf_pic_plane_write(ubuf, chroma, 0, 0, -1, -1, &dst);
+        if (unlikely(!ubase_check(err))) {
+            ubuf_pic_plane_unmap(uref->ubuf, chroma, 0, 0, -1, -1);
+            ubuf_free(ubuf);
+            return err;
+        }
+
+        upipe_grid_in_scale_plane(src, src_stride, hsize / hsub, vsize / vsub,
+                                  dst, dst_stride,
+                                  dst_hsize / hsub, dst_vsize / vsub,
+                                  upipe_grid_in->scale_buffer);
+
+        ubuf_pic_plane_unmap(ubuf, chroma, 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(uref->ubuf, chroma, 0, 0, -1, -1);
+    }
+
+    uref_attach_ubuf(uref, ubuf);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles input buffer from input pipe.
  *
  * @param upipe input pipe description
@@ -512,6 +724,15 @@ static void upipe_grid_in_input(struct upipe *upipe,
     if (unlikely(ubase_check(uref_flow_get_def(uref, NULL)))) {
         upipe_grid_in->latency = 0;
         uref_clock_get_latency(uref, &upipe_grid_in->latency);
+        struct uref *input_flow_def = uref_dup(uref);
+        if (unlikely(!input_flow_def)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            uref_free(uref);
+            return;
+        }
+        uref_free(upipe_grid_in->input_flow_def);
+        upipe_grid_in->input_flow_def = input_flow_def;
+        upipe_grid_in_tile_flow_def(upipe, uref);
         if (!upipe_grid_in->flow_def)
             upipe_grid_in_set_flow_def_real(upipe, uref);
         else
@@ -548,6 +769,13 @@ static void upipe_grid_in_input(struct upipe *upipe,
         return;
     }
 
+    if (upipe_grid_in->scale_hsize &&
+        unlikely(!ubase_check(upipe_grid_in_scale(upipe, uref)))) {
+        upipe_warn(upipe, "fail to scale picture, dropping...");
+        uref_free(uref);
+        return;
+    }
+
     uint64_t duration = 0;
     uref_clock_get_duration(uref, &duration);
 
@@ -602,6 +830,33 @@ static int upipe_grid_in_get_flow_def(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the tile size of a grid input pipe.
+ * The last received flow def is pushed again with the new size.
+ *
+ * @param upipe description structure of the pipe
+ * @param hsize tile horizontal size, or 0 to keep the input size
+ * @param vsize tile vertical size, or 0 to keep the input size
+ * @return an error code
+ */
+static int upipe_grid_in_set_tile_size_real(struct upipe *upipe,
+                                            uint64_t hsize, uint64_t vsize)
+{
+    struct upipe_grid_in *upipe_grid_in = upipe_grid_in_from_upipe(upipe);
+
+    if (hsize == upipe_grid_in->tile_hsize &&
+        vsize == upipe_grid_in->tile_vsize)
+        return UBASE_ERR_NONE;
+
+    upipe_grid_in->tile_hsize = hsize;
+    upipe_grid_in->tile_vsize = vsize;
+    if (upipe_grid_in->input_flow_def) {
+        struct uref *flow_def = uref_dup(upipe_grid_in->input_flow_def);
+        UBASE_ALLOC_RETURN(flow_def);
+        upipe_grid_in_input(upipe, flow_def, NULL);
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles grid input controls.
  *
  * @param upipe input pipe description
@@ -628,6 +883,13 @@ static int upipe_grid_in_control_real(struct upipe *upipe,
             struct uref **flow_def_p = va_arg(args, struct uref **);
             return upipe_grid_in_get_flow_def(upipe, flow_def_p);
         }
+
+        case UPIPE_GRID_IN_SET_TILE_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_GRID_IN_SIGNATURE);
+            uint64_t hsize = va_arg(args, uint64_t);
+            uint64_t vsize = va_arg(args, uint64_t);
+            return upipe_grid_in_set_tile_size_real(upipe, hsize, vsize);
+        }
     }
 
     return UBASE_ERR_UNHANDLED;
@@ -38,6 +38,8 @@
 #include "upipe/upipe_helper_output.h"
 #include "upipe-modules/upipe_htons.h"
 
+#include "upipe_htons_swap.h"
+
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdarg.h>
@@ -117,11 +119,7 @@ static void upipe_htons_input(struct upipe *upipe, struct uref *uref,
             return;
         }
 
-        for (int i = 0; i < bufsize - 1; i += 2) {
-            uint8_t t = buf[i];
-            buf[i] = buf[i + 1];
-            buf[i + 1] = t;
-        }
+        upipe_htons_swap(buf, bufsize);
 
         uref_block_unmap(uref, offset);
         offset += bufsize;
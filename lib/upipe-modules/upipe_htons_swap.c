@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe 16-bit byte swap kernels
+ *
+ * The SSSE3 and AVX2 kernels swap with a byte shuffle, and the NEON kernel
+ * with vrev16. Trailing octets shorter than a vector are swapped by the
+ * reference loop.
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ucpu.h"
+#include "upipe_htons_swap.h"
+
+#ifdef UPIPE_HTONS_SWAP_X86
+#include <immintrin.h>
+#endif
+
+#ifdef UPIPE_HTONS_SWAP_NEON
+#include <arm_neon.h>
+#endif
+
+/** @This swaps the octets of each 16-bit word with the reference
+ * implementation.
+ *
+ * @param buf pointer to the data
+ * @param len size of the data in octets
+ */
+void upipe_htons_swap_c(uint8_t *buf, uintptr_t len)
+{
+    for (uintptr_t i = 0; i + 1 < len; i += 2) {
+        uint8_t t = buf[i];
+        buf[i] = buf[i + 1];
+        buf[i + 1] = t;
+    }
+}
+
+#ifdef UPIPE_HTONS_SWAP_X86
+/** @This swaps the octets of each 16-bit word with SSSE3.
+ *
+ * @param buf pointer to the data
+ * @param len size of the data in octets
+ */
+__attribute__((target("ssse3")))
+void upipe_htons_swap_ssse3(uint8_t *buf, uintptr_t len)
+{
+    const __m128i shuf = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                       9, 8, 11, 10, 13, 12, 15, 14);
+
+    while (len >= 32) {
+        __m128i x0 = _mm_loadu_si128((const __m128i *)buf);
+        __m128i x1 = _mm_loadu_si128((const __m128i *)(buf + 16));
+        _mm_storeu_si128((__m128i *)buf, _mm_shuffle_epi8(x0, shuf));
+        _mm_storeu_si128((__m128i *)(buf + 16), _mm_shuffle_epi8(x1, shuf));
+        buf += 32;
+        len -= 32;
+    }
+    if (len >= 16) {
+        __m128i x0 = _mm_loadu_si128((const __m128i *)buf);
+        _mm_storeu_si128((__m128i *)buf, _mm_shuffle_epi8(x0, shuf));
+        buf += 16;
+        len -= 16;
+    }
+    upipe_htons_swap_c(buf, len);
+}
+
+/** @This swaps the octets of each 16-bit word with AVX2.
+ *
+ * @param buf pointer to the data
+ * @param len size of the data in octets
+ */
+__attribute__((target("avx2")))
+void upipe_htons_swap_avx2(uint8_t *buf, uintptr_t len)
+{
+    const __m256i shuf = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                          9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6,
+                                          9, 8, 11, 10, 13, 12, 15, 14);
+
+    while (len >= 64) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i *)buf);
+        __m256i x1 = _mm256_loadu_si256((const __m256i *)(buf + 32));
+        _mm256_storeu_si256((__m256i *)buf, _mm256_shuffle_epi8(x0, shuf));
+        _mm256_storeu_si256((__m256i *)(buf + 32),
+                            _mm256_shuffle_epi8(x1, shuf));
+        buf += 64;
+        len -= 64;
+    }
+    if (len >= 32) {
+        __m256i x0 = _mm256_loadu_si256((const __m256i *)buf);
+        _mm256_storeu_si256((__m256i *)buf, _mm256_shuffle_epi8(x0, shuf));
+        buf += 32;
+        len -= 32;
+    }
+    upipe_htons_swap_ssse3(buf, len);
+}
+#endif
+
+#ifdef UPIPE_HTONS_SWAP_NEON
+/** @This swaps the octets of each 16-bit word with NEON.
+ *
+ * @param buf pointer to the data
+ * @param len size of the data in octets
+ */
+void upipe_htons_swap_neon(uint8_t *buf, uintptr_t len)
+{
+    while (len >= 32) {
+        uint8x16_t x0 = vld1q_u8(buf);
+        uint8x16_t x1 = vld1q_u8(buf + 16);
+        vst1q_u8(buf, vrev16q_u8(x0));
+        vst1q_u8(buf + 16, vrev16q_u8(x1));
+        buf += 32;
+        len -= 32;
+    }
+    if (len >= 16) {
+        vst1q_u8(buf, vrev16q_u8(vld1q_u8(buf)));
+        buf += 16;
+        len -= 16;
+    }
+    upipe_htons_swap_c(buf, len);
+}
+#endif
+
+/** @internal @This lists the byte swap kernels, best first. */
+static const struct ucpu_impl upipe_htons_swap_impls[] = {
+#ifdef UPIPE_HTONS_SWAP_X86
+    UCPU_IMPL(upipe_htons_swap, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_htons_swap, ssse3, UCPU_SSSE3),
+#endif
+#ifdef UPIPE_HTONS_SWAP_NEON
+    UCPU_IMPL(upipe_htons_swap, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(upipe_htons_swap, c, 0),
+};
+
+/** byte swap kernel */
+struct ucpu_kernel upipe_htons_swap_kernel =
+    UCPU_KERNEL_INIT("htons_swap", upipe_htons_swap_impls);
+
+/** @This swaps the octets of each 16-bit word, using the fastest kernel
+ * supported by the CPU.
+ *
+ * @param buf pointer to the data
+ * @param len size of the data in octets
+ */
+void upipe_htons_swap(uint8_t *buf, uintptr_t len)
+{
+    if (len < 16) {
+        upipe_htons_swap_c(buf, len);
+        return;
+    }
+    UCPU_KERNEL_FUNC(&upipe_htons_swap_kernel,
+                     __typeof__(&upipe_htons_swap_c))(buf, len);
+}
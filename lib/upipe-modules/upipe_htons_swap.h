@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe 16-bit byte swap kernels
+ */
+
+#ifndef _UPIPE_MODULES_UPIPE_HTONS_SWAP_H_
+/** @hidden */
+#define _UPIPE_MODULES_UPIPE_HTONS_SWAP_H_
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+#define UPIPE_HTONS_SWAP_X86
+#endif
+
+#if defined(__aarch64__)
+/** @hidden */
+#define UPIPE_HTONS_SWAP_NEON
+#endif
+
+/* reference implementation, one word at a time */
+void upipe_htons_swap_c(uint8_t *buf, uintptr_t len);
+
+#ifdef UPIPE_HTONS_SWAP_X86
+/* swaps 32 octets per iteration with pshufb */
+void upipe_htons_swap_ssse3(uint8_t *buf, uintptr_t len);
+/* swaps 64 octets per iteration with vpshufb */
+void upipe_htons_swap_avx2(uint8_t *buf, uintptr_t len);
+#endif
+
+#ifdef UPIPE_HTONS_SWAP_NEON
+/* swaps 32 octets per iteration with rev16 */
+void upipe_htons_swap_neon(uint8_t *buf, uintptr_t len);
+#endif
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of upipe_htons_swap, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_htons_swap_kernel;
+
+/** @This swaps the octets of each 16-bit word of a buffer in place, using
+ * the fastest kernel supported by the CPU. A trailing odd octet is left
+ * untouched.
+ *
+ * @param buf pointer to the data
+ * @param len size of the data in octets
+ */
+void upipe_htons_swap(uint8_t *buf, uintptr_t len);
+
+#endif
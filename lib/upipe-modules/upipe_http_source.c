@@ -36,11 +36,14 @@
 #include "upipe/uref_block_flow.h"
 #include "upipe/uref_clock.h"
 #include "upipe/uref_uri.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/urefcount_helper.h"
 #include "upipe/upump.h"
 #include "upipe/ueventfd.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
 #include "upipe/upipe_helper_void.h"
 #include "upipe/upipe_helper_uref_mgr.h"
 #include "upipe/upipe_helper_ubuf_mgr.h"
@@ -51,6 +54,7 @@
 #include "upipe/upipe_helper_output_size.h"
 #include "upipe-modules/upipe_http_source.h"
 #include "upipe-modules/uref_http_flow.h"
+#include "upipe-modules/upipe_probe_uref.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -65,6 +69,7 @@
 #include <assert.h>
 
 #include "http_source_hook.h"
+#include "http_source_h2.h"
 #include "http-parser/http_parser.h"
 
 /** default size of buffers when unspecified */
@@ -74,6 +79,12 @@
 #define HTTP_VERSION            "HTTP/1.1"
 #define USER_AGENT              "upipe_http_src"
 #define TIMEOUT                 (5 * 27000000) /* 5s */
+/** maximum number of idle connections kept by a manager */
+#define MAX_IDLE_CONNECTIONS    8
+/** maximum number of origins remembered as not supporting HTTP/2 */
+#define MAX_H1_ORIGINS          64
+/** maximum number of times a HTTP/2 request is sent again */
+#define MAX_H2_RETRIES          2
 
 struct http_range {
     uint64_t offset;
@@ -91,8 +102,41 @@ struct upipe_http_src_cookie {
 
 UBASE_FROM_TO(upipe_http_src_cookie, uchain, uchain, uchain)
 
+/** @internal @This is the private context of a http source manager. */
+struct upipe_http_src_mgr {
+    /** upipe manager */
+    struct upipe_mgr upipe_mgr;
+    /** urefcount structure */
+    struct urefcount urefcount;
+    /** cookie list */
+    struct uchain cookies;
+    /** proxy url */
+    char *proxy;
+    /** idle connections, oldest first */
+    struct uchain connections;
+    /** number of idle connections */
+    unsigned int nb_connections;
+    /** true if HTTP/2 is enabled */
+    bool http2;
+    /** HTTP/2 connections */
+    struct uchain h2_connections;
+    /** origins not supporting HTTP/2, oldest first */
+    struct uchain h1_origins;
+    /** number of origins not supporting HTTP/2 */
+    unsigned int nb_h1_origins;
+};
+
+UBASE_FROM_TO(upipe_http_src_mgr, upipe_mgr, upipe_mgr, upipe_mgr)
+UBASE_FROM_TO(upipe_http_src_mgr, urefcount, urefcount, urefcount);
+
 /** @hidden */
 static int upipe_http_src_check(struct upipe *upipe, struct uref *flow_format);
+/** @hidden */
+static int upipe_http_src_reconnect(struct upipe *upipe);
+/** @hidden */
+static void upipe_http_src_h2_detach(struct upipe *upipe);
+/** @hidden */
+static int upipe_http_src_h2_check(struct upipe *upipe);
 
 struct header {
     const char *value;
@@ -114,10 +158,73 @@ struct upipe_http_src_request {
 #define HEADER(Value, Len) \
     (struct header){ .value = Value, .len = Len }
 
+/** @internal @This is an idle keep-alive connection kept by the manager. */
+struct upipe_http_src_connection {
+    /** attach to the manager list */
+    struct uchain uchain;
+    /** scheme, host and port of the connection */
+    char *key;
+    /** socket descriptor */
+    int fd;
+    /** read/write hook */
+    struct upipe_http_src_hook *hook;
+    /** plain hook, used if the connection is not encrypted */
+    struct http_src_hook http_hook;
+};
+
+UBASE_FROM_TO(upipe_http_src_connection, uchain, uchain, uchain)
+
+/** @internal @This is a HTTP/2 connection, shared by the requests of the
+ * pipes of a manager to the same origin. */
+struct upipe_http_src_h2_conn {
+    /** attach to the manager list */
+    struct uchain uchain;
+    /** manager owning the connection */
+    struct upipe_mgr *mgr;
+    /** scheme, host and port of the connection */
+    char *key;
+    /** socket descriptor */
+    int fd;
+    /** read/write hook */
+    struct upipe_http_src_hook *hook;
+    /** plain hook, used if the connection is not encrypted */
+    struct http_src_hook http_hook;
+    /** HTTP/2 framing state */
+    struct http_src_h2 h2;
+    /** true once HTTP/2 is negotiated */
+    bool ready;
+    /** true if frames were given to the hook since the last watcher call */
+    bool flushed;
+    /** pipes whose request is not yet submitted */
+    struct uchain pending;
+    /** number of pipes whose request is not yet submitted */
+    unsigned int nb_pending;
+    /** upump manager, set while the connection is active */
+    struct upump_mgr *upump_mgr;
+    /** read watcher */
+    struct upump *upump_read;
+    /** write watcher */
+    struct upump *upump_write;
+};
+
+UBASE_FROM_TO(upipe_http_src_h2_conn, uchain, uchain, uchain)
+
+/** @internal @This is an origin which does not support HTTP/2. */
+struct upipe_http_src_origin {
+    /** attach to the manager list */
+    struct uchain uchain;
+    /** scheme, host and port */
+    char *key;
+};
+
+UBASE_FROM_TO(upipe_http_src_origin, uchain, uchain, uchain)
+
 /** @internal @This is the private context of a http source pipe. */
 struct upipe_http_src {
     /** refcount management structure */
     struct urefcount urefcount;
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
 
     /** uref manager */
     struct uref_mgr *uref_mgr;
@@ -168,6 +275,16 @@ struct upipe_http_src {
 
     /** socket descriptor */
     int fd;
+    /** scheme, host and port of the connection */
+    char *key;
+    /** true if the connection was taken from the manager */
+    bool reused;
+    /** true if data was received on the connection */
+    bool received;
+    /** buffer being parsed, body fragments are spliced from it */
+    struct ubuf *ubuf;
+    /** mapped start of the buffer being parsed */
+    const uint8_t *ubuf_base;
     /** pending request */
     struct upipe_http_src_request request;
     /** http url */
@@ -199,12 +316,78 @@ struct upipe_http_src {
     /** read/write hook */
     struct upipe_http_src_hook *hook;
 
+    /** number of parallel range requests, 0 or 1 if disabled */
+    unsigned int parallel;
+    /** size of the parallel range requests */
+    uint64_t chunk_size;
+    /** list of ranges being downloaded, in order */
+    struct uchain chunks;
+    /** offset of the next range to request */
+    uint64_t next_offset;
+    /** end of the resource or of the requested range, or UINT64_MAX */
+    uint64_t end;
+
+    /** HTTP/2 connection of the request, or NULL */
+    struct upipe_http_src_h2_conn *h2_conn;
+    /** attach to the pending list of the HTTP/2 connection */
+    struct uchain h2_uchain;
+    /** HTTP/2 stream of the request, not submitted if its id is 0 */
+    struct http_src_h2_stream h2_stream;
+    /** true once the pipe may output the HTTP/2 reply */
+    bool h2_ready;
+    /** HTTP/2 reply status code */
+    unsigned int h2_status;
+    /** HTTP/2 weight of the requests */
+    unsigned int weight;
+    /** number of times the HTTP/2 request was sent again */
+    unsigned int retries;
+
     /** public upipe structure */
     struct upipe upipe;
 };
 
+/** @internal @This describes a range downloaded by an inner http source in
+ * parallel mode. */
+struct upipe_http_src_chunk {
+    /** refcount, held by the probes */
+    struct urefcount urefcount;
+    /** link in the list of ranges */
+    struct uchain uchain;
+    /** pointer to the http source pipe */
+    struct upipe *upipe;
+    /** offset of the range */
+    uint64_t offset;
+    /** length of the range */
+    uint64_t length;
+    /** number of octets received */
+    uint64_t received;
+    /** inner http source */
+    struct upipe *src;
+    /** probe uref pipe catching the data */
+    struct upipe *sink;
+    /** probe for the inner http source */
+    struct uprobe probe_src;
+    /** probe for the probe uref pipe */
+    struct uprobe probe_sink;
+    /** data received and not yet output */
+    struct uchain urefs;
+    /** the inner http source has ended */
+    bool ended;
+};
+
+UBASE_FROM_TO(upipe_http_src_chunk, uchain, uchain, uchain);
+UBASE_FROM_TO(upipe_http_src_chunk, uprobe, probe_src, probe_src);
+UBASE_FROM_TO(upipe_http_src_chunk, uprobe, probe_sink, probe_sink);
+UBASE_FROM_TO(upipe_http_src, uchain, h2_uchain, h2_uchain);
+UBASE_FROM_TO(upipe_http_src, http_src_h2_stream, h2_stream, h2_stream);
+
+static void upipe_http_src_no_ref(struct upipe *upipe);
+static void upipe_http_src_chunk_free(struct upipe_http_src_chunk *chunk);
+
 UPIPE_HELPER_UPIPE(upipe_http_src, upipe, UPIPE_HTTP_SRC_SIGNATURE)
-UPIPE_HELPER_UREFCOUNT(upipe_http_src, urefcount, upipe_http_src_free)
+UPIPE_HELPER_UREFCOUNT(upipe_http_src, urefcount, upipe_http_src_no_ref)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_http_src, urefcount_real,
+                            upipe_http_src_free)
 UPIPE_HELPER_VOID(upipe_http_src)
 
 UPIPE_HELPER_OUTPUT(upipe_http_src, output, flow_def, output_state, request_list)
@@ -228,6 +411,8 @@ UPIPE_HELPER_UPUMP(upipe_http_src, upump_timeout, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_http_src, upump_data_in, upump_mgr)
 UPIPE_HELPER_UPUMP(upipe_http_src, upump_data_out, upump_mgr)
 
+UREFCOUNT_HELPER(upipe_http_src_chunk, urefcount, upipe_http_src_chunk_free);
+
 static int upipe_http_src_header_field(http_parser *parser,
                                        const char *at,
                                        size_t len);
@@ -273,6 +458,7 @@ static struct upipe *upipe_http_src_alloc(struct upipe_mgr *mgr,
     struct upipe *upipe = upipe_http_src_alloc_void(mgr, uprobe, signature,
                                                     args);
     upipe_http_src_init_urefcount(upipe);
+    upipe_http_src_init_urefcount_real(upipe);
     upipe_http_src_init_uref_mgr(upipe);
     upipe_http_src_init_ubuf_mgr(upipe);
     upipe_http_src_init_output(upipe);
@@ -287,6 +473,11 @@ static struct upipe *upipe_http_src_alloc(struct upipe_mgr *mgr,
 
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
     upipe_http_src->fd = -1;
+    upipe_http_src->key = NULL;
+    upipe_http_src->reused = false;
+    upipe_http_src->received = false;
+    upipe_http_src->ubuf = NULL;
+    upipe_http_src->ubuf_base = NULL;
     upipe_http_src->url = NULL;
     upipe_http_src->range = HTTP_RANGE(0, -1);
     upipe_http_src->position = 0;
@@ -298,6 +489,18 @@ static struct upipe *upipe_http_src_alloc(struct upipe_mgr *mgr,
     upipe_http_src->request.len = 0;
     upipe_http_src->request.size = 0;
     upipe_http_src->hook = NULL;
+    upipe_http_src->parallel = 0;
+    upipe_http_src->chunk_size = 0;
+    ulist_init(&upipe_http_src->chunks);
+    upipe_http_src->next_offset = 0;
+    upipe_http_src->end = UINT64_MAX;
+    upipe_http_src->h2_conn = NULL;
+    uchain_init(&upipe_http_src->h2_uchain);
+    upipe_http_src->h2_stream.id = 0;
+    upipe_http_src->h2_ready = false;
+    upipe_http_src->h2_status = 0;
+    upipe_http_src->weight = HTTP_SRC_H2_DEFAULT_WEIGHT;
+    upipe_http_src->retries = 0;
     ueventfd_init(&upipe_http_src->data_in, false);
     ueventfd_init(&upipe_http_src->data_out, false);
 
@@ -326,6 +529,147 @@ static struct upipe *upipe_http_src_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This frees an idle connection.
+ *
+ * @param connection idle connection to free
+ */
+static void upipe_http_src_connection_free(
+    struct upipe_http_src_connection *connection)
+{
+    upipe_http_src_hook_release(connection->hook);
+    ubase_clean_fd(&connection->fd);
+    free(connection->key);
+    free(connection);
+}
+
+/** @internal @This hands the current connection over to the manager, so that
+ * it may be reused by the next request to the same server.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_park(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(upipe->mgr);
+
+    if (upipe_http_src->fd == -1 || upipe_http_src->key == NULL ||
+        upipe_http_src->hook == NULL || upipe_http_src->request.len)
+        return;
+    /* do not keep unread data */
+    if (upipe_http_src->hook == &upipe_http_src->http_hook.hook &&
+        (upipe_http_src->http_hook.in.len ||
+         upipe_http_src->http_hook.out.len ||
+         upipe_http_src->http_hook.closed))
+        return;
+
+    struct upipe_http_src_connection *connection =
+        malloc(sizeof (*connection));
+    if (unlikely(connection == NULL))
+        return;
+    uchain_init(&connection->uchain);
+    connection->key = upipe_http_src->key;
+    connection->fd = upipe_http_src->fd;
+    if (upipe_http_src->hook == &upipe_http_src->http_hook.hook) {
+        connection->http_hook = upipe_http_src->http_hook;
+        connection->hook = &connection->http_hook.hook;
+    } else
+        connection->hook = upipe_http_src->hook;
+    upipe_http_src->key = NULL;
+    upipe_http_src->fd = -1;
+    upipe_http_src->hook = NULL;
+
+    upipe_dbg_va(upipe, "keeping connection to %s alive", connection->key);
+    ulist_add(&upipe_http_src_mgr->connections,
+              upipe_http_src_connection_to_uchain(connection));
+    if (++upipe_http_src_mgr->nb_connections > MAX_IDLE_CONNECTIONS) {
+        struct uchain *uchain = ulist_pop(&upipe_http_src_mgr->connections);
+        upipe_http_src_connection_free(
+            upipe_http_src_connection_from_uchain(uchain));
+        upipe_http_src_mgr->nb_connections--;
+    }
+}
+
+/** @internal @This takes an idle connection to the server of the current
+ * url from the manager, if any.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if a connection was found
+ */
+static bool upipe_http_src_unpark(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(upipe->mgr);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach_reverse(&upipe_http_src_mgr->connections,
+                                 uchain, uchain_tmp) {
+        struct upipe_http_src_connection *connection =
+            upipe_http_src_connection_from_uchain(uchain);
+        if (strcmp(connection->key, upipe_http_src->key))
+            continue;
+
+        ulist_delete(uchain);
+        upipe_http_src_mgr->nb_connections--;
+
+        /* the server may have closed the connection in the meantime */
+        char c;
+        if (recv(connection->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) != -1 ||
+            (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            upipe_dbg_va(upipe, "dropping stale connection to %s",
+                         connection->key);
+            upipe_http_src_connection_free(connection);
+            continue;
+        }
+
+        upipe_dbg_va(upipe, "reusing connection to %s", connection->key);
+        upipe_http_src->fd = connection->fd;
+        if (connection->hook == &connection->http_hook.hook) {
+            upipe_http_src->http_hook = connection->http_hook;
+            upipe_http_src->hook = &upipe_http_src->http_hook.hook;
+        } else
+            upipe_http_src->hook = connection->hook;
+        connection->fd = -1;
+        connection->hook = NULL;
+        upipe_http_src_connection_free(connection);
+        return true;
+    }
+    return false;
+}
+
+/** @internal @This frees a range when the probes are released.
+ *
+ * @param chunk range description
+ */
+static void upipe_http_src_chunk_free(struct upipe_http_src_chunk *chunk)
+{
+    struct upipe *upipe = chunk->upipe;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&chunk->urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    uprobe_clean(&chunk->probe_sink);
+    uprobe_clean(&chunk->probe_src);
+    upipe_http_src_chunk_clean_urefcount(chunk);
+    free(chunk);
+    upipe_http_src_release_urefcount_real(upipe);
+}
+
+/** @internal @This stops the download of a range and releases its inner
+ * pipes.
+ *
+ * @param chunk range description
+ */
+static void upipe_http_src_chunk_stop(struct upipe_http_src_chunk *chunk)
+{
+    ulist_delete(&chunk->uchain);
+    upipe_release(chunk->sink);
+    chunk->sink = NULL;
+    upipe_release(chunk->src);
+    chunk->src = NULL;
+    upipe_http_src_chunk_release_urefcount(chunk);
+}
+
 /** @This closes a connection.
  *
  * @param upipe description structure of the pipe
@@ -335,11 +679,17 @@ static void upipe_http_src_close(struct upipe *upipe)
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
     struct uref *flow_def = upipe_http_src->flow_def;
 
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_http_src->chunks, uchain, uchain_tmp)
+        upipe_http_src_chunk_stop(upipe_http_src_chunk_from_uchain(uchain));
+
     if (likely(upipe_http_src->url != NULL))
         upipe_notice_va(upipe, "closing %s", upipe_http_src->url);
+    upipe_http_src_h2_detach(upipe);
     upipe_http_src_hook_release(upipe_http_src->hook);
     upipe_http_src->hook = NULL;
     ubase_clean_fd(&upipe_http_src->fd);
+    ubase_clean_str(&upipe_http_src->key);
     ubase_clean_str(&upipe_http_src->url);
     free(upipe_http_src->request.buf);
     upipe_http_src->request.buf = NULL;
@@ -350,8 +700,10 @@ static void upipe_http_src_close(struct upipe *upipe)
     upipe_http_src_set_upump_timeout(upipe, NULL);
     upipe_http_src_set_upump_data_in(upipe, NULL);
     upipe_http_src_set_upump_data_out(upipe, NULL);
-    if (flow_def)
+    if (flow_def) {
         uref_http_delete_content_type(flow_def);
+        uref_http_delete_size(flow_def);
+    }
 }
 
 /** @This frees a upipe.
@@ -383,9 +735,21 @@ static void upipe_http_src_free(struct upipe *upipe)
     upipe_http_src_clean_ubuf_mgr(upipe);
     upipe_http_src_clean_uref_mgr(upipe);
     upipe_http_src_clean_urefcount(upipe);
+    upipe_http_src_clean_urefcount_real(upipe);
     upipe_http_src_free_void(upipe);
 }
 
+/** @internal @This is called when there is no external reference to the
+ * pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_no_ref(struct upipe *upipe)
+{
+    upipe_http_src_close(upipe);
+    upipe_http_src_release_urefcount_real(upipe);
+}
+
 static int upipe_http_src_add_cookie(struct upipe *upipe,
                                       const char *buf,
                                       size_t len)
@@ -415,44 +779,72 @@ static int upipe_http_src_header_field(http_parser *parser,
     return 0;
 }
 
-static int upipe_http_src_header_value(http_parser *parser,
-                                       const char *at,
-                                       size_t len)
+/** @internal @This handles a reply header.
+ *
+ * @param upipe description structure of the pipe
+ * @param name header name
+ * @param name_len length of the name
+ * @param at header value
+ * @param len length of the value
+ */
+static void upipe_http_src_header(struct upipe *upipe,
+                                  const char *name, size_t name_len,
+                                  const char *at, size_t len)
 {
-    struct upipe_http_src *upipe_http_src = upipe_http_src_from_parser(parser);
-    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
     struct uref *flow_def = upipe_http_src->flow_def;
 
-    struct header field = upipe_http_src->header_field;
-    upipe_http_src->header_field = HEADER(NULL, 0);
-    assert(field.value != NULL);
-
-    upipe_verbose_va(upipe, "%.*s: %.*s",
-                     (int)field.len, field.value,
-                     (int)len, at);
-    if (!strncasecmp("Location", field.value, field.len)) {
+    upipe_verbose_va(upipe, "%.*s: %.*s", (int)name_len, name, (int)len, at);
+    if (!strncasecmp("Location", name, name_len)) {
+        free(upipe_http_src->location);
         upipe_http_src->location = strndup(at, len);
     }
-    else if (!strncasecmp("Set-Cookie", field.value, field.len)) {
+    else if (!strncasecmp("Set-Cookie", name, name_len)) {
         if (!ubase_check(upipe_http_src_add_cookie(upipe, at, len)))
             upipe_warn_va(upipe, "fail to set cookie %.*s", (int)len, at);
     }
-    else if (!strncasecmp("Content-Type", field.value, field.len)) {
+    else if (!strncasecmp("Content-Type", name, name_len)) {
         char content_type[len + 1];
         snprintf(content_type, len + 1, "%.*s", (int)len, at);
         uref_http_set_content_type(flow_def, content_type);
     }
-    return 0;
+    else if (!strncasecmp("Content-Range", name, name_len)) {
+        /* bytes first-last/size, size may be * if unknown */
+        char content_range[len + 1];
+        snprintf(content_range, len + 1, "%.*s", (int)len, at);
+        const char *size = strchr(content_range, '/');
+        if (size != NULL && size[1] >= '0' && size[1] <= '9')
+            uref_http_set_size(flow_def, strtoull(size + 1, NULL, 10));
+    }
 }
 
-static int upipe_http_src_status_cb(http_parser *parser)
+static int upipe_http_src_header_value(http_parser *parser,
+                                       const char *at,
+                                       size_t len)
 {
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_parser(parser);
     struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
 
-    upipe_dbg_va(upipe, "reply http code %i", parser->status_code);
+    struct header field = upipe_http_src->header_field;
+    upipe_http_src->header_field = HEADER(NULL, 0);
+    assert(field.value != NULL);
 
-    switch (parser->status_code) {
+    upipe_http_src_header(upipe, field.value, field.len, at, len);
+    return 0;
+}
+
+/** @internal @This checks the reply status code.
+ *
+ * @param upipe description structure of the pipe
+ * @param status_code reply status code
+ * @return an error code
+ */
+static int upipe_http_src_status(struct upipe *upipe,
+                                 unsigned int status_code)
+{
+    upipe_dbg_va(upipe, "reply http code %u", status_code);
+
+    switch (status_code) {
     /* success */
     case 200:
     /* partial content */
@@ -461,9 +853,19 @@ static int upipe_http_src_status_cb(http_parser *parser)
     case 302:
         break;
     default:
-        upipe_http_src_throw_error(upipe, parser->status_code);
-        return -1;
+        upipe_http_src_throw_error(upipe, status_code);
+        return UBASE_ERR_INVALID;
     }
+    return UBASE_ERR_NONE;
+}
+
+static int upipe_http_src_status_cb(http_parser *parser)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_parser(parser);
+    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+
+    if (!ubase_check(upipe_http_src_status(upipe, parser->status_code)))
+        return -1;
     return 0;
 }
 
@@ -484,19 +886,35 @@ static int upipe_http_src_output_data(struct upipe *upipe,
         systime = uclock_now(upipe_http_src->uclock);
     }
 
-    /* alloc, map, copy, unmap */
-    uref = uref_block_alloc(upipe_http_src->uref_mgr,
-                            upipe_http_src->ubuf_mgr, len);
-    if (unlikely(!uref)) {
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return 0;
+    if (likely(at != NULL && upipe_http_src->ubuf != NULL)) {
+        /* the body is in the read buffer, reference it */
+        uref = uref_alloc(upipe_http_src->uref_mgr);
+        struct ubuf *ubuf =
+            ubuf_block_splice(upipe_http_src->ubuf,
+                              (const uint8_t *)at - upipe_http_src->ubuf_base,
+                              len);
+        if (unlikely(!uref || !ubuf)) {
+            uref_free(uref);
+            ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return 0;
+        }
+        uref_attach_ubuf(uref, ubuf);
+    } else {
+        /* alloc, map, copy, unmap */
+        uref = uref_block_alloc(upipe_http_src->uref_mgr,
+                                upipe_http_src->ubuf_mgr, len);
+        if (unlikely(!uref)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return 0;
+        }
+        size = -1;
+        uref_block_write(uref, 0, &size, &buf);
+        assert(len == size);
+        if (likely(at != NULL))
+            memcpy(buf, at, len);
+        uref_block_unmap(uref, 0);
     }
-    size = -1;
-    uref_block_write(uref, 0, &size, &buf);
-    assert(len == size);
-    if (likely(at != NULL))
-        memcpy(buf, at, len);
-    uref_block_unmap(uref, 0);
 
     if (systime)
         uref_clock_set_cr_sys(uref, systime);
@@ -509,21 +927,22 @@ static int upipe_http_src_output_data(struct upipe *upipe,
     return 0;
 }
 
-/** @internal @This is called by http_parser when message is completed.
+/** @internal @This ends the output once the reply is complete.
  *
- * @param parser http parser structure
- * @return 0
+ * @param upipe description structure of the pipe
+ * @param status_code reply status code
+ * @param keep_alive true if the connection may be reused
  */
-static int upipe_http_src_message_complete(http_parser *parser)
+static void upipe_http_src_complete(struct upipe *upipe,
+                                    unsigned int status_code,
+                                    bool keep_alive)
 {
-    struct upipe_http_src *upipe_http_src = upipe_http_src_from_parser(parser);
-    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
     char *location = upipe_http_src->location;
-    int status_code = parser->status_code;
 
     upipe_http_src->location = NULL;
 
-    upipe_dbg_va(upipe, "message complete %i", status_code);
+    upipe_dbg_va(upipe, "message complete %u", status_code);
 
     switch (status_code) {
     /* success */
@@ -533,6 +952,8 @@ static int upipe_http_src_message_complete(http_parser *parser)
         upipe_http_src_output_data(upipe, NULL, 0);
         break;
     }
+    if (keep_alive)
+        upipe_http_src_park(upipe);
     upipe_http_src_close(upipe);
     upipe_throw_source_end(upipe);
 
@@ -544,7 +965,20 @@ static int upipe_http_src_message_complete(http_parser *parser)
     }
 
     free(location);
+}
+
+/** @internal @This is called by http_parser when message is completed.
+ *
+ * @param parser http parser structure
+ * @return 0
+ */
+static int upipe_http_src_message_complete(http_parser *parser)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_parser(parser);
+    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
 
+    upipe_http_src_complete(upipe, parser->status_code,
+                            http_should_keep_alive(parser));
     return 0;
 }
 
@@ -589,6 +1023,7 @@ static void upipe_http_src_process(struct upipe *upipe, const uint8_t *buffer,
     if (size == 0)
         upipe_http_src_output_data(upipe, NULL, 0);
     else {
+        upipe_http_src->received = true;
         size_t parsed_len =
             http_parser_execute(&upipe_http_src->parser,
                                 &upipe_http_src->parser_settings,
@@ -710,12 +1145,14 @@ static int upipe_http_src_send_request(struct upipe *upipe)
         else
             upipe_http_src_request_add(upipe, "Range: bytes=0-");
 
-        if (upipe_http_src->range.length != (uint64_t)-1) {
+        if (upipe_http_src->range.length &&
+            upipe_http_src->range.length != (uint64_t)-1) {
             upipe_verbose_va(upipe, "range length: %"PRIu64,
                              upipe_http_src->range.length);
+            /* the last position is inclusive */
             upipe_http_src_request_add(upipe, "%"PRIu64,
                                        upipe_http_src->range.offset +
-                                       upipe_http_src->range.length);
+                                       upipe_http_src->range.length - 1);
         }
 
         upipe_http_src_request_add(upipe, "\r\n");
@@ -894,10 +1331,22 @@ static void upipe_http_src_data_out(struct upump *upump)
 
     ueventfd_read(&upipe_http_src->data_out);
 
-    uint8_t buffer[upipe_http_src->output_size];
+    /* read directly into an output buffer, so that the body fragments are
+     * spliced from it instead of being copied */
+    struct ubuf *ubuf = ubuf_block_alloc(upipe_http_src->ubuf_mgr,
+                                         upipe_http_src->output_size);
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(!ubuf ||
+                 !ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)))) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
     ssize_t len =
         upipe_http_src->hook->data.read(
             upipe_http_src->hook, buffer, upipe_http_src->output_size);
+    ubuf_block_unmap(ubuf, 0);
     if (unlikely(len < 0)) {
         switch (errno) {
             case EINTR:
@@ -906,6 +1355,7 @@ static void upipe_http_src_data_out(struct upump *upump)
             case EWOULDBLOCK:
 #endif
                 /* not an issue, try again later */
+                ubuf_free(ubuf);
                 return;
 
             default:
@@ -920,7 +1370,31 @@ static void upipe_http_src_data_out(struct upump *upump)
     else if (len == upipe_http_src->output_size)
         ueventfd_write(&upipe_http_src->data_out);
 
-    upipe_http_src_process(upipe, buffer, len > 0 ? len : 0);
+    if (len <= 0 && upipe_http_src->reused && !upipe_http_src->received &&
+        ubase_check(upipe_http_src_reconnect(upipe))) {
+        ubuf_free(ubuf);
+        return;
+    }
+
+    if (len > 0) {
+        const uint8_t *base;
+        size = len;
+        if (unlikely(!ubase_check(ubuf_block_resize(ubuf, 0, len)) ||
+                     !ubase_check(ubuf_block_read(ubuf, 0, &size, &base)))) {
+            ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+            return;
+        }
+        upipe_http_src->ubuf = ubuf;
+        upipe_http_src->ubuf_base = base;
+        upipe_http_src_process(upipe, base, len);
+        upipe_http_src->ubuf = NULL;
+        upipe_http_src->ubuf_base = NULL;
+        ubuf_block_unmap(ubuf, 0);
+    }
+    else
+        upipe_http_src_process(upipe, NULL, 0);
+    ubuf_free(ubuf);
 
     if (len <= 0) {
         upipe_http_src_set_upump_read(upipe, NULL);
@@ -981,6 +1455,9 @@ static int upipe_http_src_check(struct upipe *upipe, struct uref *flow_format)
             != NULL)
         return UBASE_ERR_NONE;
 
+    if (upipe_http_src->h2_conn != NULL)
+        return upipe_http_src_h2_check(upipe);
+
     if (upipe_http_src->fd != -1) {
         if (upipe_http_src->upump_read == NULL) {
             struct upump *upump;
@@ -1068,13 +1545,12 @@ static int upipe_http_src_get_uri(struct upipe *upipe, const char **url_p)
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This asks to open the given http (real code here).
+/** @internal @This opens a new connection to the server of the current url.
  *
  * @param upipe description structure of the pipe
- * @param url relative or absolute url of the http
  * @return an error code
  */
-static int upipe_http_src_open_url(struct upipe *upipe)
+static int upipe_http_src_connect(struct upipe *upipe)
 {
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
     struct uref *flow_def = upipe_http_src->flow_def;
@@ -1082,12 +1558,6 @@ static int upipe_http_src_open_url(struct upipe *upipe)
     struct addrinfo hints;
     int ret, fd = -1;
 
-    if (unlikely(flow_def == NULL))
-        return UBASE_ERR_INVALID;
-
-    /* init parser */
-    http_parser_init(&upipe_http_src->parser, HTTP_RESPONSE);
-
     /* get socket information */
     memset(&hints, 0, sizeof(struct addrinfo));
     hints.ai_family = PF_UNSPEC;
@@ -1156,61 +1626,1198 @@ static int upipe_http_src_open_url(struct upipe *upipe)
 
     upipe_http_src->hook = hook;
     upipe_http_src->fd = fd;
+    upipe_http_src->reused = false;
+    upipe_http_src->received = false;
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This asks to open the given http.
+/** @internal @This builds the key of the origin of the current url, which
+ * identifies the connections which may be shared.
  *
  * @param upipe description structure of the pipe
- * @param url relative or absolute url of the http
  * @return an error code
  */
-static int upipe_http_src_set_uri(struct upipe *upipe, const char *url)
+static int upipe_http_src_set_key(struct upipe *upipe)
 {
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
-    int ret;
-
-    upipe_http_src_close(upipe);
-
-    if (unlikely(url == NULL))
-        return UBASE_ERR_NONE;
-
-    upipe_notice_va(upipe, "opening %s", url);
+    struct uref *flow_def = upipe_http_src->flow_def;
 
-    upipe_http_src_demand_uref_mgr(upipe);
-    if (unlikely(upipe_http_src->uref_mgr == NULL)) {
-        upipe_err(upipe, "no uref mgr");
-        return UBASE_ERR_ALLOC;
+    /* connections are shared by scheme, host and port */
+    const char *scheme = "http", *host = "", *port = "";
+    if (upipe_http_src->proxy)
+        host = upipe_http_src->proxy;
+    else {
+        uref_uri_get_scheme(flow_def, &scheme);
+        uref_uri_get_host(flow_def, &host);
+        uref_uri_get_port(flow_def, &port);
     }
+    size_t key_size = strlen(scheme) + strlen(host) + strlen(port) + 5;
+    free(upipe_http_src->key);
+    upipe_http_src->key = malloc(key_size);
+    UBASE_ALLOC_RETURN(upipe_http_src->key);
+    snprintf(upipe_http_src->key, key_size, "%s://%s:%s", scheme, host, port);
+    return UBASE_ERR_NONE;
+}
 
-    struct uref *flow_def =
-        uref_block_flow_alloc_def(upipe_http_src->uref_mgr, NULL);
-    if (unlikely(flow_def == NULL)) {
-        upipe_err(upipe, "fail to create flow def");
-        return UBASE_ERR_NONE;
-    }
+/** @internal @This asks to open the given http (real code here).
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_http_src_open_url(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct uref *flow_def = upipe_http_src->flow_def;
 
-    ret = uref_uri_set_from_str(flow_def, url);
-    if (unlikely(!ubase_check(ret))) {
-        uref_free(flow_def);
-        return ret;
-    }
+    if (unlikely(flow_def == NULL))
+        return UBASE_ERR_INVALID;
 
-    upipe_http_src_store_flow_def(upipe, flow_def);
+    /* init parser */
+    http_parser_init(&upipe_http_src->parser, HTTP_RESPONSE);
 
-    upipe_http_src->url = strdup(url);
-    if (unlikely(upipe_http_src->url == NULL)) {
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return UBASE_ERR_ALLOC;
-    }
+    UBASE_RETURN(upipe_http_src_set_key(upipe));
 
-    /* now call real code */
-    UBASE_RETURN(upipe_http_src_open_url(upipe));
-    return upipe_http_src_send_request(upipe);
+    if (upipe_http_src_unpark(upipe)) {
+        upipe_http_src->reused = true;
+        upipe_http_src->received = false;
+        return UBASE_ERR_NONE;
+    }
+    return upipe_http_src_connect(upipe);
 }
 
-static int _upipe_http_src_get_position(struct upipe *upipe,
-                                        uint64_t *position_p)
+/** @internal @This opens a new connection and sends the request again, when
+ * a reused connection was closed by the server before any reply.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_http_src_reconnect(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    upipe_warn(upipe, "kept alive connection closed, reconnecting");
+    upipe_http_src_hook_release(upipe_http_src->hook);
+    upipe_http_src->hook = NULL;
+    ubase_clean_fd(&upipe_http_src->fd);
+    free(upipe_http_src->request.buf);
+    upipe_http_src->request.buf = NULL;
+    upipe_http_src->request.len = 0;
+    upipe_http_src->request.size = 0;
+    upipe_http_src_set_upump_read(upipe, NULL);
+    upipe_http_src_set_upump_write(upipe, NULL);
+    upipe_http_src_set_upump_timeout(upipe, NULL);
+
+    http_parser_init(&upipe_http_src->parser, HTTP_RESPONSE);
+    UBASE_RETURN(upipe_http_src_connect(upipe));
+    UBASE_RETURN(upipe_http_src_send_request(upipe));
+    return upipe_http_src_check(upipe, NULL);
+}
+
+/** @internal @This checks whether an origin is known not to support
+ * HTTP/2.
+ *
+ * @param mgr http source manager
+ * @param key scheme, host and port of the origin
+ * @return true if the origin does not support HTTP/2
+ */
+static bool upipe_http_src_mgr_h1_origin(struct upipe_http_src_mgr *mgr,
+                                         const char *key)
+{
+    struct uchain *uchain;
+    ulist_foreach(&mgr->h1_origins, uchain) {
+        struct upipe_http_src_origin *origin =
+            upipe_http_src_origin_from_uchain(uchain);
+        if (!strcmp(origin->key, key))
+            return true;
+    }
+    return false;
+}
+
+/** @internal @This remembers that an origin does not support HTTP/2.
+ *
+ * @param mgr http source manager
+ * @param key scheme, host and port of the origin
+ */
+static void upipe_http_src_mgr_add_h1_origin(struct upipe_http_src_mgr *mgr,
+                                             const char *key)
+{
+    if (upipe_http_src_mgr_h1_origin(mgr, key))
+        return;
+
+    struct upipe_http_src_origin *origin = malloc(sizeof (*origin));
+    if (unlikely(origin == NULL))
+        return;
+    origin->key = strdup(key);
+    if (unlikely(origin->key == NULL)) {
+        free(origin);
+        return;
+    }
+    ulist_add(&mgr->h1_origins, upipe_http_src_origin_to_uchain(origin));
+    if (++mgr->nb_h1_origins > MAX_H1_ORIGINS) {
+        struct uchain *uchain = ulist_pop(&mgr->h1_origins);
+        origin = upipe_http_src_origin_from_uchain(uchain);
+        free(origin->key);
+        free(origin);
+        mgr->nb_h1_origins--;
+    }
+}
+
+/** @internal @This stops the watchers of an idle HTTP/2 connection, so that
+ * it does not keep the event loop running.
+ *
+ * @param conn HTTP/2 connection
+ */
+static void upipe_http_src_h2_conn_stop(struct upipe_http_src_h2_conn *conn)
+{
+    if (conn->upump_mgr == NULL)
+        return;
+    upump_free(conn->upump_read);
+    conn->upump_read = NULL;
+    upump_free(conn->upump_write);
+    conn->upump_write = NULL;
+    upump_mgr_release(conn->upump_mgr);
+    conn->upump_mgr = NULL;
+    /* last, as the manager may be freed */
+    upipe_mgr_release(conn->mgr);
+}
+
+/** @internal @This frees a HTTP/2 connection, which must not be in the
+ * manager list anymore.
+ *
+ * @param conn HTTP/2 connection
+ */
+static void upipe_http_src_h2_conn_free(struct upipe_http_src_h2_conn *conn)
+{
+    struct upipe_mgr *mgr = conn->upump_mgr != NULL ? conn->mgr : NULL;
+    upump_free(conn->upump_read);
+    upump_free(conn->upump_write);
+    upump_mgr_release(conn->upump_mgr);
+    http_src_h2_clean(&conn->h2);
+    upipe_http_src_hook_release(conn->hook);
+    ubase_clean_fd(&conn->fd);
+    free(conn->key);
+    free(conn);
+    upipe_mgr_release(mgr);
+}
+
+/** @internal @This writes the pending frames of a HTTP/2 connection to the
+ * hook.
+ *
+ * @param conn HTTP/2 connection
+ */
+static void upipe_http_src_h2_conn_flush(struct upipe_http_src_h2_conn *conn)
+{
+    while (conn->h2.out_len) {
+        ssize_t len = conn->hook->data.write(conn->hook, conn->h2.out,
+                                             conn->h2.out_len);
+        if (len <= 0)
+            break;
+        http_src_h2_consume(&conn->h2, len);
+        conn->flushed = true;
+    }
+    if (conn->flushed && conn->upump_write != NULL)
+        upump_start(conn->upump_write);
+}
+
+/** @internal @This ends the output of a pipe whose HTTP/2 request failed.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_h2_abort(struct upipe *upipe)
+{
+    upipe_http_src_output_data(upipe, NULL, 0);
+    upipe_http_src_close(upipe);
+    upipe_throw_source_end(upipe);
+}
+
+/** @hidden */
+static int upipe_http_src_request(struct upipe *upipe);
+
+/** @internal @This sends a request again, on another connection, when the
+ * HTTP/2 connection failed before any reply.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_h2_retry(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    upipe_http_src->h2_conn = NULL;
+    upipe_http_src->h2_stream.id = 0;
+    upipe_http_src->h2_ready = false;
+    if (upipe_http_src->retries++ < MAX_H2_RETRIES) {
+        upipe_warn(upipe, "HTTP/2 request failed, sending it again");
+        if (ubase_check(upipe_http_src_request(upipe)) &&
+            ubase_check(upipe_http_src_check(upipe, NULL)))
+            return;
+    }
+    upipe_http_src_h2_abort(upipe);
+}
+
+/** @internal @This submits the request of a pipe on its HTTP/2 connection.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_http_src_h2_submit(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_h2_conn *conn = upipe_http_src->h2_conn;
+    struct uref *flow_def = upipe_http_src->flow_def;
+
+    const char *scheme = "http", *host = "", *port = NULL, *path = "",
+               *query = NULL;
+    uref_uri_get_scheme(flow_def, &scheme);
+    uref_uri_get_host(flow_def, &host);
+    uref_uri_get_port(flow_def, &port);
+    uref_uri_get_path(flow_def, &path);
+    uref_uri_get_query(flow_def, &query);
+    if (!strlen(path))
+        path = "/";
+
+    char authority[strlen(host) + (port ? strlen(port) + 1 : 0) + 1];
+    sprintf(authority, "%s%s%s", host, port ? ":" : "", port ? port : "");
+    char url[strlen(path) + 1 + (query ? strlen(query) : 0) + 1];
+    sprintf(url, "%s%s%s", path, query ? "?" : "", query ? query : "");
+    upipe_dbg_va(upipe, "GET %s (HTTP/2)", url);
+
+    struct http_src_h2_header headers[7] = {
+        { ":method", "GET" },
+        { ":scheme", scheme },
+        { ":authority", authority },
+        { ":path", url },
+        { "user-agent", USER_AGENT },
+    };
+    unsigned int nb_headers = 5;
+
+    /* Range */
+    char range[64];
+    upipe_http_src->position = 0;
+    if (upipe_http_src->range.offset ||
+        upipe_http_src->range.length != (uint64_t)-1) {
+        upipe_http_src->position = upipe_http_src->range.offset;
+        int len = snprintf(range, sizeof (range), "bytes=%"PRIu64"-",
+                           upipe_http_src->range.offset);
+        if (upipe_http_src->range.length &&
+            upipe_http_src->range.length != (uint64_t)-1)
+            /* the last position is inclusive */
+            snprintf(range + len, sizeof (range) - len, "%"PRIu64,
+                     upipe_http_src->range.offset +
+                     upipe_http_src->range.length - 1);
+        upipe_verbose_va(upipe, "range: %s", range);
+        headers[nb_headers++] = (struct http_src_h2_header){ "range", range };
+    }
+
+    /* Cookie, in a single header */
+    size_t cookie_size = 1;
+    struct uchain *uchain = NULL;
+    while (ubase_check(upipe_http_src_mgr_iterate_cookie(upipe->mgr,
+                                                         host, path,
+                                                         &uchain)) &&
+           uchain != NULL) {
+        struct upipe_http_src_cookie *cookie =
+            upipe_http_src_cookie_from_uchain(uchain);
+        cookie_size += cookie->ucookie.name.len +
+                       cookie->ucookie.value.len + 3;
+    }
+    char cookies[cookie_size];
+    size_t cookie_len = 0;
+    uchain = NULL;
+    cookies[0] = '\0';
+    while (ubase_check(upipe_http_src_mgr_iterate_cookie(upipe->mgr,
+                                                         host, path,
+                                                         &uchain)) &&
+           uchain != NULL) {
+        struct upipe_http_src_cookie *cookie =
+            upipe_http_src_cookie_from_uchain(uchain);
+        cookie_len += snprintf(cookies + cookie_len, cookie_size - cookie_len,
+            "%s%.*s=%.*s", cookie_len ? "; " : "",
+            (int)cookie->ucookie.name.len, cookie->ucookie.name.at,
+            (int)cookie->ucookie.value.len, cookie->ucookie.value.at);
+    }
+    if (cookie_len) {
+        upipe_verbose_va(upipe, "cookie: %s", cookies);
+        headers[nb_headers++] =
+            (struct http_src_h2_header){ "cookie", cookies };
+    }
+
+    upipe_http_src->received = false;
+    upipe_http_src->h2_status = 0;
+    UBASE_RETURN(http_src_h2_submit(&conn->h2, &upipe_http_src->h2_stream,
+                                    headers, nb_headers,
+                                    upipe_http_src->weight));
+    upipe_http_src_h2_conn_flush(conn);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This submits the requests of the pipes waiting for a HTTP/2
+ * connection, once it is negotiated.
+ *
+ * @param conn HTTP/2 connection
+ */
+static void upipe_http_src_h2_conn_submit(struct upipe_http_src_h2_conn *conn)
+{
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&conn->pending, uchain, uchain_tmp) {
+        struct upipe_http_src *upipe_http_src =
+            upipe_http_src_from_h2_uchain(uchain);
+        struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+        if (!upipe_http_src->h2_ready)
+            continue;
+
+        ulist_delete(uchain);
+        conn->nb_pending--;
+        if (!ubase_check(upipe_http_src_h2_submit(upipe)))
+            upipe_http_src_h2_retry(upipe);
+    }
+}
+
+/** @internal @This hands the pipes waiting for a HTTP/2 connection over to
+ * HTTP/1.1, when the server did not negotiate HTTP/2. The first pipe takes
+ * the connection.
+ *
+ * @param conn HTTP/2 connection, freed
+ */
+static void upipe_http_src_h2_conn_fallback(
+    struct upipe_http_src_h2_conn *conn)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(conn->mgr);
+
+    ulist_delete(&conn->uchain);
+    upipe_http_src_mgr_add_h1_origin(upipe_http_src_mgr, conn->key);
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&conn->pending)) != NULL) {
+        struct upipe_http_src *upipe_http_src =
+            upipe_http_src_from_h2_uchain(uchain);
+        struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+        conn->nb_pending--;
+        upipe_http_src->h2_conn = NULL;
+        upipe_http_src->h2_ready = false;
+
+        if (conn->hook == NULL) {
+            if (!ubase_check(upipe_http_src_request(upipe)) ||
+                !ubase_check(upipe_http_src_check(upipe, NULL)))
+                upipe_http_src_h2_abort(upipe);
+            continue;
+        }
+
+        upipe_dbg_va(upipe, "HTTP/2 not negotiated with %s", conn->key);
+        upipe_http_src->fd = conn->fd;
+        if (conn->hook == &conn->http_hook.hook) {
+            upipe_http_src->http_hook = conn->http_hook;
+            upipe_http_src->hook = &upipe_http_src->http_hook.hook;
+        } else
+            upipe_http_src->hook = conn->hook;
+        conn->fd = -1;
+        conn->hook = NULL;
+        upipe_http_src->reused = false;
+        upipe_http_src->received = false;
+        http_parser_init(&upipe_http_src->parser, HTTP_RESPONSE);
+        if (!ubase_check(upipe_http_src_send_request(upipe)) ||
+            !ubase_check(upipe_http_src_check(upipe, NULL)))
+            upipe_http_src_h2_abort(upipe);
+    }
+    upipe_http_src_h2_conn_free(conn);
+}
+
+/** @internal @This handles the failure of a HTTP/2 connection. The requests
+ * without reply are sent again, and the origin is requested with HTTP/1.1
+ * if it did not answer with HTTP/2 frames.
+ *
+ * @param conn HTTP/2 connection, freed
+ */
+static void upipe_http_src_h2_conn_fail(struct upipe_http_src_h2_conn *conn)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(conn->mgr);
+
+    ulist_delete(&conn->uchain);
+    if (!conn->h2.settings)
+        upipe_http_src_mgr_add_h1_origin(upipe_http_src_mgr, conn->key);
+
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&conn->pending)) != NULL) {
+        struct upipe_http_src *upipe_http_src =
+            upipe_http_src_from_h2_uchain(uchain);
+        conn->nb_pending--;
+        upipe_http_src_h2_retry(upipe_http_src_to_upipe(upipe_http_src));
+    }
+    http_src_h2_close(&conn->h2);
+    upipe_http_src_h2_conn_free(conn);
+}
+
+/** @internal @This processes the state of the hook of a HTTP/2 connection.
+ *
+ * @param conn HTTP/2 connection
+ * @param ret state returned by the hook
+ */
+static void upipe_http_src_h2_conn_worker(struct upipe_http_src_h2_conn *conn,
+                                          int ret)
+{
+    if (ret < 0 && (errno == EINTR || errno == EAGAIN ||
+                    errno == EWOULDBLOCK))
+        return;
+    if (ret <= 0) {
+        upipe_http_src_h2_conn_fail(conn);
+        return;
+    }
+
+    conn->flushed = false;
+    if (!conn->ready && (ret & UPIPE_HTTP_SRC_HOOK_DATA_WRITE)) {
+        /* without negotiation, use prior knowledge */
+        const char *protocol = conn->hook->protocol != NULL ?
+            conn->hook->protocol(conn->hook) : HTTP_SRC_H2_ALPN;
+        if (protocol == NULL || strcmp(protocol, HTTP_SRC_H2_ALPN)) {
+            upipe_http_src_h2_conn_fallback(conn);
+            return;
+        }
+        conn->ready = true;
+        upipe_http_src_h2_conn_submit(conn);
+    }
+
+    if (conn->ready) {
+        uint8_t buffer[UBUF_DEFAULT_SIZE];
+        ssize_t len;
+        while ((len = conn->hook->data.read(conn->hook, buffer,
+                                            sizeof (buffer))) > 0) {
+            if (!ubase_check(http_src_h2_feed(&conn->h2, buffer, len))) {
+                /* try to send the GOAWAY frame */
+                upipe_http_src_h2_conn_flush(conn);
+                conn->hook->transport.write(conn->hook, conn->fd);
+                upipe_http_src_h2_conn_fail(conn);
+                return;
+            }
+        }
+        if (len == 0) {
+            upipe_http_src_h2_conn_fail(conn);
+            return;
+        }
+        upipe_http_src_h2_conn_flush(conn);
+    }
+
+    if ((ret & UPIPE_HTTP_SRC_HOOK_TRANSPORT_WRITE) || conn->flushed ||
+        conn->h2.out_len) {
+        upump_start(conn->upump_write);
+        return;
+    }
+    upump_stop(conn->upump_write);
+
+    if (!conn->h2.nb_streams && !conn->nb_pending) {
+        if (!http_src_h2_usable(&conn->h2)) {
+            ulist_delete(&conn->uchain);
+            upipe_http_src_h2_conn_free(conn);
+        } else
+            upipe_http_src_h2_conn_stop(conn);
+    }
+}
+
+/** @internal @This is called when the socket of a HTTP/2 connection is
+ * readable.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_http_src_h2_conn_read(struct upump *upump)
+{
+    struct upipe_http_src_h2_conn *conn =
+        upump_get_opaque(upump, struct upipe_http_src_h2_conn *);
+    int ret = conn->hook->transport.read(conn->hook, conn->fd);
+    upipe_http_src_h2_conn_worker(conn, ret);
+}
+
+/** @internal @This is called when the socket of a HTTP/2 connection is
+ * writable.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_http_src_h2_conn_write(struct upump *upump)
+{
+    struct upipe_http_src_h2_conn *conn =
+        upump_get_opaque(upump, struct upipe_http_src_h2_conn *);
+    int ret = conn->hook->transport.write(conn->hook, conn->fd);
+    upipe_http_src_h2_conn_worker(conn, ret);
+}
+
+/** @internal @This allocates the watchers of a HTTP/2 connection, if they
+ * are not already running.
+ *
+ * @param conn HTTP/2 connection
+ * @param upump_mgr upump manager to use
+ * @return an error code
+ */
+static int upipe_http_src_h2_conn_start(struct upipe_http_src_h2_conn *conn,
+                                        struct upump_mgr *upump_mgr)
+{
+    if (conn->upump_mgr != NULL)
+        return UBASE_ERR_NONE;
+
+    conn->upump_read = upump_alloc_fd_read(upump_mgr,
+                                           upipe_http_src_h2_conn_read,
+                                           conn, NULL, conn->fd);
+    conn->upump_write = upump_alloc_fd_write(upump_mgr,
+                                             upipe_http_src_h2_conn_write,
+                                             conn, NULL, conn->fd);
+    if (unlikely(conn->upump_read == NULL || conn->upump_write == NULL)) {
+        upump_free(conn->upump_read);
+        conn->upump_read = NULL;
+        upump_free(conn->upump_write);
+        conn->upump_write = NULL;
+        return UBASE_ERR_UPUMP;
+    }
+    /* the active connections keep the manager */
+    conn->upump_mgr = upump_mgr_use(upump_mgr);
+    upipe_mgr_use(conn->mgr);
+    upump_start(conn->upump_read);
+    upump_start(conn->upump_write);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This is called for each header of a HTTP/2 reply.
+ */
+static void upipe_http_src_h2_header(struct http_src_h2 *h2,
+                                     struct http_src_h2_stream *stream,
+                                     const char *name, size_t name_len,
+                                     const char *value, size_t value_len)
+{
+    struct upipe_http_src *upipe_http_src =
+        upipe_http_src_from_h2_stream(stream);
+    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+
+    upipe_http_src->received = true;
+    if (likely(upipe_http_src->upump_timeout))
+        upump_restart(upipe_http_src->upump_timeout);
+
+    if (name_len == strlen(":status") && !memcmp(name, ":status", name_len)) {
+        char status[value_len + 1];
+        memcpy(status, value, value_len);
+        status[value_len] = '\0';
+        upipe_http_src->h2_status = strtoul(status, NULL, 10);
+        if (!ubase_check(upipe_http_src_status(upipe,
+                                               upipe_http_src->h2_status)))
+            upipe_http_src_h2_abort(upipe);
+    } else if (name_len && name[0] != ':')
+        upipe_http_src_header(upipe, name, name_len, value, value_len);
+}
+
+/** @internal @This is called for each fragment of a HTTP/2 reply body.
+ */
+static void upipe_http_src_h2_data(struct http_src_h2 *h2,
+                                   struct http_src_h2_stream *stream,
+                                   const uint8_t *buf, size_t len)
+{
+    struct upipe_http_src *upipe_http_src =
+        upipe_http_src_from_h2_stream(stream);
+    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+
+    upipe_verbose_va(upipe, "received %zu bytes of body", len);
+    if (likely(upipe_http_src->upump_timeout))
+        upump_restart(upipe_http_src->upump_timeout);
+
+    switch (upipe_http_src->h2_status) {
+    /* success */
+    case 200:
+    /* partial content */
+    case 206:
+        upipe_http_src_output_data(upipe, (const char *)buf, len);
+        break;
+    }
+}
+
+/** @internal @This is called when a HTTP/2 reply is complete.
+ */
+static void upipe_http_src_h2_end(struct http_src_h2 *h2,
+                                  struct http_src_h2_stream *stream)
+{
+    struct upipe_http_src *upipe_http_src =
+        upipe_http_src_from_h2_stream(stream);
+    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+
+    upipe_http_src->h2_conn = NULL;
+    upipe_http_src_complete(upipe, upipe_http_src->h2_status, false);
+}
+
+/** @internal @This is called when a HTTP/2 stream is reset.
+ */
+static void upipe_http_src_h2_reset(struct http_src_h2 *h2,
+                                    struct http_src_h2_stream *stream,
+                                    uint32_t error)
+{
+    struct upipe_http_src *upipe_http_src =
+        upipe_http_src_from_h2_stream(stream);
+    struct upipe *upipe = upipe_http_src_to_upipe(upipe_http_src);
+
+    upipe_warn_va(upipe, "HTTP/2 stream reset (error %"PRIu32")", error);
+    upipe_http_src->h2_conn = NULL;
+    if (!upipe_http_src->received)
+        upipe_http_src_h2_retry(upipe);
+    else
+        upipe_http_src_h2_abort(upipe);
+}
+
+/** @internal @This is the callbacks of the HTTP/2 streams. */
+static const struct http_src_h2_cb upipe_http_src_h2_cb = {
+    .header = upipe_http_src_h2_header,
+    .data = upipe_http_src_h2_data,
+    .end = upipe_http_src_h2_end,
+    .reset = upipe_http_src_h2_reset,
+};
+
+/** @internal @This opens a HTTP/2 connection to the origin of the current
+ * url.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the connection, or NULL in case of error
+ */
+static struct upipe_http_src_h2_conn *
+upipe_http_src_h2_conn_alloc(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(upipe->mgr);
+    struct uref *flow_def = upipe_http_src->flow_def;
+
+    struct upipe_http_src_h2_conn *conn = malloc(sizeof (*conn));
+    if (unlikely(conn == NULL))
+        return NULL;
+    conn->key = strdup(upipe_http_src->key);
+    if (unlikely(conn->key == NULL ||
+                 !ubase_check(http_src_h2_init(&conn->h2,
+                                               &upipe_http_src_h2_cb)))) {
+        http_src_h2_clean(&conn->h2);
+        free(conn->key);
+        free(conn);
+        return NULL;
+    }
+
+    /* offer HTTP/2 to the scheme hook */
+    uref_http_set_h2(flow_def);
+    int err = upipe_http_src_connect(upipe);
+    uref_http_delete_h2(flow_def);
+    if (unlikely(!ubase_check(err))) {
+        http_src_h2_clean(&conn->h2);
+        free(conn->key);
+        free(conn);
+        return NULL;
+    }
+
+    upipe_dbg_va(upipe, "opening HTTP/2 connection to %s", conn->key);
+    uchain_init(&conn->uchain);
+    conn->mgr = upipe->mgr;
+    conn->fd = upipe_http_src->fd;
+    if (upipe_http_src->hook == &upipe_http_src->http_hook.hook) {
+        conn->http_hook = upipe_http_src->http_hook;
+        conn->hook = &conn->http_hook.hook;
+    } else
+        conn->hook = upipe_http_src->hook;
+    upipe_http_src->fd = -1;
+    upipe_http_src->hook = NULL;
+    conn->ready = false;
+    conn->flushed = false;
+    ulist_init(&conn->pending);
+    conn->nb_pending = 0;
+    conn->upump_mgr = NULL;
+    conn->upump_read = NULL;
+    conn->upump_write = NULL;
+    ulist_add(&upipe_http_src_mgr->h2_connections,
+              upipe_http_src_h2_conn_to_uchain(conn));
+    return conn;
+}
+
+/** @internal @This opens the current url with HTTP/2, if enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code, UBASE_ERR_UNHANDLED if HTTP/2 is not used
+ */
+static int upipe_http_src_h2_open(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(upipe->mgr);
+    struct uref *flow_def = upipe_http_src->flow_def;
+
+    if (!upipe_http_src_mgr->http2 || upipe_http_src->proxy != NULL)
+        return UBASE_ERR_UNHANDLED;
+    const char *scheme;
+    if (unlikely(flow_def == NULL) ||
+        !ubase_check(uref_uri_get_scheme(flow_def, &scheme)) ||
+        (strcasecmp(scheme, "http") && strcasecmp(scheme, "https")))
+        return UBASE_ERR_UNHANDLED;
+    UBASE_RETURN(upipe_http_src_set_key(upipe));
+    if (upipe_http_src_mgr_h1_origin(upipe_http_src_mgr,
+                                     upipe_http_src->key))
+        return UBASE_ERR_UNHANDLED;
+
+    struct upipe_http_src_h2_conn *conn = NULL;
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_http_src_mgr->h2_connections,
+                         uchain, uchain_tmp) {
+        struct upipe_http_src_h2_conn *item =
+            upipe_http_src_h2_conn_from_uchain(uchain);
+        if (strcmp(item->key, upipe_http_src->key) ||
+            !http_src_h2_usable(&item->h2) ||
+            item->h2.nb_streams + item->nb_pending >= item->h2.max_streams)
+            continue;
+
+        /* the server may have closed an idle connection in the meantime */
+        char c;
+        if (item->upump_mgr == NULL &&
+            (recv(item->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) != -1 ||
+             (errno != EAGAIN && errno != EWOULDBLOCK))) {
+            upipe_dbg_va(upipe, "dropping stale connection to %s",
+                         item->key);
+            ulist_delete(uchain);
+            upipe_http_src_h2_conn_free(item);
+            continue;
+        }
+        conn = item;
+        break;
+    }
+    if (conn == NULL) {
+        conn = upipe_http_src_h2_conn_alloc(upipe);
+        if (unlikely(conn == NULL))
+            return UBASE_ERR_EXTERNAL;
+    } else
+        upipe_dbg_va(upipe, "reusing HTTP/2 connection to %s", conn->key);
+
+    /* the request is submitted once the pipe is ready to output */
+    upipe_http_src->h2_conn = conn;
+    upipe_http_src->h2_stream.id = 0;
+    upipe_http_src->h2_ready = false;
+    upipe_http_src->received = false;
+    ulist_add(&conn->pending, upipe_http_src_to_h2_uchain(upipe_http_src));
+    conn->nb_pending++;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This detaches a pipe from its HTTP/2 connection, and cancels
+ * its request.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_h2_detach(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_h2_conn *conn = upipe_http_src->h2_conn;
+    if (conn == NULL)
+        return;
+
+    upipe_http_src->h2_conn = NULL;
+    upipe_http_src->h2_ready = false;
+    if (!upipe_http_src->h2_stream.id) {
+        ulist_delete(upipe_http_src_to_h2_uchain(upipe_http_src));
+        conn->nb_pending--;
+    } else {
+        http_src_h2_cancel(&conn->h2, &upipe_http_src->h2_stream);
+        upipe_http_src_h2_conn_flush(conn);
+    }
+    upipe_http_src->h2_stream.id = 0;
+    /* the watchers are stopped by the worker once the connection is idle */
+    if (conn->upump_write != NULL)
+        upump_start(conn->upump_write);
+}
+
+/** @internal @This starts the HTTP/2 connection of a pipe, and submits its
+ * request, once the pipe is ready to output.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_http_src_h2_check(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_h2_conn *conn = upipe_http_src->h2_conn;
+
+    if (upipe_http_src->upump_timeout == NULL) {
+        struct upump *upump =
+            upump_alloc_timer(upipe_http_src->upump_mgr,
+                              upipe_http_src_worker_timeout, upipe,
+                              upipe->refcount,
+                              upipe_http_src->timeout, 0);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_http_src_set_upump_timeout(upipe, upump);
+        upump_start(upump);
+    }
+
+    int err = upipe_http_src_h2_conn_start(conn, upipe_http_src->upump_mgr);
+    if (unlikely(!ubase_check(err))) {
+        upipe_throw_fatal(upipe, err);
+        return err;
+    }
+
+    upipe_http_src->h2_ready = true;
+    if (conn->ready && !upipe_http_src->h2_stream.id) {
+        ulist_delete(upipe_http_src_to_h2_uchain(upipe_http_src));
+        conn->nb_pending--;
+        if (!ubase_check(upipe_http_src_h2_submit(upipe)))
+            upipe_http_src_h2_retry(upipe);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This opens the current url and sends the request, with
+ * HTTP/2 if possible.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_http_src_request(struct upipe *upipe)
+{
+    int err = upipe_http_src_h2_open(upipe);
+    if (err != UBASE_ERR_UNHANDLED)
+        return err;
+
+    UBASE_RETURN(upipe_http_src_open_url(upipe));
+    return upipe_http_src_send_request(upipe);
+}
+
+static void upipe_http_src_parallel_pump(struct upipe *upipe);
+
+/** @internal @This catches the events of the inner http source of a range.
+ *
+ * @param uprobe structure used to raise events
+ * @param inner the inner pipe
+ * @param event event thrown
+ * @param args optional arguments
+ * @return an error code
+ */
+static int probe_chunk_src(struct uprobe *uprobe, struct upipe *inner,
+                           int event, va_list args)
+{
+    struct upipe_http_src_chunk *chunk =
+        upipe_http_src_chunk_from_probe_src(uprobe);
+    struct upipe *upipe = chunk->upipe;
+
+    switch (event) {
+    case UPROBE_SOURCE_END:
+        if (!chunk->ended) {
+            chunk->ended = true;
+            upipe_http_src_parallel_pump(upipe);
+        }
+        return UBASE_ERR_NONE;
+    }
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
+/** @internal @This retrieves the content type and the size of the resource
+ * from the first reply.
+ *
+ * @param upipe description structure of the pipe
+ * @param chunk range description
+ */
+static void upipe_http_src_parallel_flow_def(struct upipe *upipe,
+                                             struct upipe_http_src_chunk *chunk)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct uref *flow_def;
+    if (!ubase_check(upipe_get_flow_def(chunk->src, &flow_def)) ||
+        flow_def == NULL)
+        return;
+
+    const char *content_type;
+    if (ubase_check(uref_http_get_content_type(flow_def, &content_type)))
+        uref_http_set_content_type(upipe_http_src->flow_def, content_type);
+
+    uint64_t size;
+    if (ubase_check(uref_http_get_size(flow_def, &size))) {
+        uref_http_set_size(upipe_http_src->flow_def, size);
+        if (size < upipe_http_src->end) {
+            upipe_dbg_va(upipe, "resource size %"PRIu64, size);
+            upipe_http_src->end = size;
+        }
+    }
+}
+
+/** @internal @This catches the events of the probe uref pipe of a range,
+ * and keeps the data until the previous ranges are output.
+ *
+ * @param uprobe structure used to raise events
+ * @param inner the inner pipe
+ * @param event event thrown
+ * @param args optional arguments
+ * @return an error code
+ */
+static int probe_chunk_sink(struct uprobe *uprobe, struct upipe *inner,
+                            int event, va_list args)
+{
+    struct upipe_http_src_chunk *chunk =
+        upipe_http_src_chunk_from_probe_sink(uprobe);
+    struct upipe *upipe = chunk->upipe;
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    switch (event) {
+    case UPROBE_PROBE_UREF: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_PROBE_UREF_SIGNATURE);
+        struct uref *uref = va_arg(args, struct uref *);
+        va_arg(args, struct upump **);
+        bool *drop = va_arg(args, bool *);
+        *drop = true;
+
+        /* the end of each range is signalled by an empty buffer */
+        size_t size;
+        if (!ubase_check(uref_block_size(uref, &size)) || !size)
+            return UBASE_ERR_NONE;
+
+        if (!chunk->received)
+            upipe_http_src_parallel_flow_def(upipe, chunk);
+        chunk->received += size;
+
+        struct uref *dup = uref_dup(uref);
+        if (unlikely(dup == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return UBASE_ERR_ALLOC;
+        }
+        ulist_add(&chunk->urefs, uref_to_uchain(dup));
+        if (ulist_peek(&upipe_http_src->chunks) == &chunk->uchain)
+            upipe_http_src_parallel_pump(upipe);
+        return UBASE_ERR_NONE;
+    }
+    case UPROBE_NEW_FLOW_DEF:
+        return UBASE_ERR_NONE;
+    case UPROBE_NEED_OUTPUT:
+        return UBASE_ERR_INVALID;
+    }
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
+/** @internal @This configures the inner http source of a range and sends
+ * its request.
+ *
+ * @param upipe description structure of the pipe
+ * @param chunk range description
+ * @return an error code
+ */
+static int upipe_http_src_chunk_open(struct upipe *upipe,
+                                     struct upipe_http_src_chunk *chunk)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe *src = chunk->src;
+
+    UBASE_RETURN(upipe_set_output_size(src, upipe_http_src->output_size));
+    UBASE_RETURN(upipe_http_src_set_timeout(src, upipe_http_src->timeout));
+    if (upipe_http_src->proxy != NULL)
+        UBASE_RETURN(upipe_http_src_set_proxy(src, upipe_http_src->proxy));
+    if (upipe_http_src->uclock != NULL)
+        UBASE_RETURN(upipe_attach_uclock(src));
+    UBASE_RETURN(upipe_src_set_range(src, chunk->offset, chunk->length));
+    return upipe_set_uri(src, upipe_http_src->url);
+}
+
+/** @internal @This allocates an inner http source downloading a range.
+ *
+ * @param upipe description structure of the pipe
+ * @param offset offset of the range
+ * @param length length of the range
+ * @return pointer to the range description or NULL in case of error
+ */
+static struct upipe_http_src_chunk *
+upipe_http_src_chunk_alloc(struct upipe *upipe, uint64_t offset,
+                           uint64_t length)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_mgr *upipe_probe_uref_mgr = upipe_probe_uref_mgr_alloc();
+    if (unlikely(upipe_probe_uref_mgr == NULL))
+        return NULL;
+    struct upipe_http_src_chunk *chunk = malloc(sizeof (*chunk));
+    if (unlikely(chunk == NULL)) {
+        upipe_mgr_release(upipe_probe_uref_mgr);
+        return NULL;
+    }
+
+    upipe_http_src_chunk_init_urefcount(chunk);
+    chunk->upipe = upipe_http_src_use_urefcount_real(upipe);
+    chunk->offset = offset;
+    chunk->length = length;
+    chunk->received = 0;
+    chunk->src = NULL;
+    chunk->sink = NULL;
+    ulist_init(&chunk->urefs);
+    chunk->ended = false;
+    uprobe_init(&chunk->probe_src, probe_chunk_src, NULL);
+    chunk->probe_src.refcount = &chunk->urefcount;
+    uprobe_init(&chunk->probe_sink, probe_chunk_sink, NULL);
+    chunk->probe_sink.refcount = &chunk->urefcount;
+    ulist_add(&upipe_http_src->chunks, &chunk->uchain);
+
+    chunk->src = upipe_void_alloc(
+        upipe->mgr,
+        uprobe_pfx_alloc_va(uprobe_use(&chunk->probe_src),
+                            UPROBE_LOG_VERBOSE, "range %"PRIu64, offset));
+    if (likely(chunk->src != NULL))
+        chunk->sink = upipe_void_alloc_output(
+            chunk->src, upipe_probe_uref_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(&chunk->probe_sink),
+                                UPROBE_LOG_VERBOSE, "sink %"PRIu64, offset));
+    upipe_mgr_release(upipe_probe_uref_mgr);
+
+    if (unlikely(chunk->sink == NULL) ||
+        unlikely(!ubase_check(upipe_http_src_chunk_open(upipe, chunk)))) {
+        upipe_http_src_chunk_stop(chunk);
+        return NULL;
+    }
+    return chunk;
+}
+
+/** @internal @This requests the next ranges, and terminates the download
+ * once all the ranges are output.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_parallel_schedule(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+
+    /* until the size is known, the ranges are requested one at a time */
+    while (ulist_depth(&upipe_http_src->chunks) < upipe_http_src->parallel &&
+           upipe_http_src->next_offset < upipe_http_src->end &&
+           (upipe_http_src->end != UINT64_MAX ||
+            ulist_empty(&upipe_http_src->chunks))) {
+        uint64_t offset = upipe_http_src->next_offset;
+        uint64_t length = upipe_http_src->chunk_size;
+        if (length > upipe_http_src->end - offset)
+            length = upipe_http_src->end - offset;
+        if (unlikely(upipe_http_src_chunk_alloc(upipe, offset,
+                                                length) == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_http_src->next_offset += length;
+    }
+
+    if (upipe_http_src->url != NULL &&
+        ulist_empty(&upipe_http_src->chunks) &&
+        upipe_http_src->next_offset >= upipe_http_src->end) {
+        upipe_http_src_output_data(upipe, NULL, 0);
+        upipe_http_src_close(upipe);
+        upipe_throw_source_end(upipe);
+    }
+}
+
+/** @internal @This outputs the data of the first ranges, releases the
+ * ranges that are complete and requests the next ones.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_http_src_parallel_pump(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+
+    while ((uchain = ulist_peek(&upipe_http_src->chunks)) != NULL) {
+        struct upipe_http_src_chunk *chunk =
+            upipe_http_src_chunk_from_uchain(uchain);
+
+        struct uchain *uchain_uref;
+        while ((uchain_uref = ulist_pop(&chunk->urefs)) != NULL) {
+            struct uref *uref = uref_from_uchain(uchain_uref);
+            size_t size = 0;
+            uref_block_size(uref, &size);
+            upipe_http_src->position += size;
+            upipe_http_src_output(upipe, uref, NULL);
+        }
+        if (!chunk->ended)
+            break;
+
+        if (chunk->received != chunk->length) {
+            /* short reply, or the server ignored the range */
+            uint64_t end = chunk->offset + chunk->received;
+            if (upipe_http_src->end != UINT64_MAX &&
+                end < upipe_http_src->end)
+                upipe_warn_va(upipe, "range %"PRIu64" ended after %"PRIu64
+                              " octets", chunk->offset, chunk->received);
+            upipe_http_src->end = end;
+            upipe_http_src->next_offset = end;
+            ulist_delete_foreach(&upipe_http_src->chunks, uchain, uchain_tmp)
+                upipe_http_src_chunk_stop(
+                    upipe_http_src_chunk_from_uchain(uchain));
+            break;
+        }
+        upipe_http_src_chunk_stop(chunk);
+    }
+
+    upipe_http_src_parallel_schedule(upipe);
+}
+
+/** @internal @This starts downloading the current url by parallel range
+ * requests.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_http_src_parallel_open(struct upipe *upipe)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct http_range range = upipe_http_src->range;
+
+    upipe_dbg_va(upipe, "downloading by %u ranges of %"PRIu64" octets",
+                 upipe_http_src->parallel, upipe_http_src->chunk_size);
+    upipe_http_src->position = range.offset;
+    upipe_http_src->next_offset = range.offset;
+    /* a null length is set by set_position and means up to the end */
+    upipe_http_src->end = range.length && range.length != (uint64_t)-1 ?
+        range.offset + range.length : UINT64_MAX;
+    upipe_http_src_parallel_schedule(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This asks to open the given http.
+ *
+ * @param upipe description structure of the pipe
+ * @param url relative or absolute url of the http
+ * @return an error code
+ */
+static int upipe_http_src_set_uri(struct upipe *upipe, const char *url)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    int ret;
+
+    upipe_http_src_close(upipe);
+
+    if (unlikely(url == NULL))
+        return UBASE_ERR_NONE;
+
+    upipe_notice_va(upipe, "opening %s", url);
+
+    upipe_http_src_demand_uref_mgr(upipe);
+    if (unlikely(upipe_http_src->uref_mgr == NULL)) {
+        upipe_err(upipe, "no uref mgr");
+        return UBASE_ERR_ALLOC;
+    }
+
+    struct uref *flow_def =
+        uref_block_flow_alloc_def(upipe_http_src->uref_mgr, NULL);
+    if (unlikely(flow_def == NULL)) {
+        upipe_err(upipe, "fail to create flow def");
+        return UBASE_ERR_NONE;
+    }
+
+    ret = uref_uri_set_from_str(flow_def, url);
+    if (unlikely(!ubase_check(ret))) {
+        uref_free(flow_def);
+        return ret;
+    }
+
+    upipe_http_src_store_flow_def(upipe, flow_def);
+
+    upipe_http_src->url = strdup(url);
+    if (unlikely(upipe_http_src->url == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    if (upipe_http_src->parallel > 1)
+        return upipe_http_src_parallel_open(upipe);
+
+    /* now call real code */
+    upipe_http_src->retries = 0;
+    return upipe_http_src_request(upipe);
+}
+
+static int _upipe_http_src_get_position(struct upipe *upipe,
+                                        uint64_t *position_p)
 {
     struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
 
@@ -1269,6 +2876,85 @@ static int _upipe_http_src_set_timeout(struct upipe *upipe, uint64_t timeout)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the number of parallel range requests and their
+ * size.
+ *
+ * @param upipe description structure of the pipe
+ * @param parallel_p filled in with the number of parallel requests
+ * @param chunk_size_p filled in with the size of each range in octets
+ * @return an error code
+ */
+static int _upipe_http_src_get_parallel(struct upipe *upipe,
+                                        unsigned int *parallel_p,
+                                        uint64_t *chunk_size_p)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    if (parallel_p)
+        *parallel_p = upipe_http_src->parallel;
+    if (chunk_size_p)
+        *chunk_size_p = upipe_http_src->chunk_size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the number of parallel range requests and their
+ * size, for the next opened url.
+ *
+ * @param upipe description structure of the pipe
+ * @param parallel number of parallel requests, 0 or 1 to disable
+ * @param chunk_size size of each range in octets
+ * @return an error code
+ */
+static int _upipe_http_src_set_parallel(struct upipe *upipe,
+                                        unsigned int parallel,
+                                        uint64_t chunk_size)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    if (parallel > 1 && !chunk_size)
+        return UBASE_ERR_INVALID;
+    upipe_http_src->parallel = parallel;
+    upipe_http_src->chunk_size = chunk_size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the HTTP/2 weight of the requests.
+ *
+ * @param upipe description structure of the pipe
+ * @param weight_p filled in with the weight
+ * @return an error code
+ */
+static int _upipe_http_src_get_weight(struct upipe *upipe,
+                                      unsigned int *weight_p)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    if (weight_p)
+        *weight_p = upipe_http_src->weight;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the HTTP/2 weight of the requests, and of the
+ * request being downloaded.
+ *
+ * @param upipe description structure of the pipe
+ * @param weight weight between 1 and 256
+ * @return an error code
+ */
+static int _upipe_http_src_set_weight(struct upipe *upipe,
+                                      unsigned int weight)
+{
+    struct upipe_http_src *upipe_http_src = upipe_http_src_from_upipe(upipe);
+    struct upipe_http_src_h2_conn *conn = upipe_http_src->h2_conn;
+    if (weight < 1 || weight > 256)
+        return UBASE_ERR_INVALID;
+    upipe_http_src->weight = weight;
+    if (conn != NULL && upipe_http_src->h2_stream.id) {
+        UBASE_RETURN(http_src_h2_set_weight(&conn->h2,
+                                            &upipe_http_src->h2_stream,
+                                            weight));
+        upipe_http_src_h2_conn_flush(conn);
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a http source pipe.
  *
  * @param upipe description structure of the pipe
@@ -1341,6 +3027,31 @@ static int _upipe_http_src_control(struct upipe *upipe,
             return _upipe_http_src_set_timeout(upipe, timeout);
         }
 
+        case UPIPE_HTTP_SRC_GET_PARALLEL: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+            unsigned int *parallel_p = va_arg(args, unsigned int *);
+            uint64_t *chunk_size_p = va_arg(args, uint64_t *);
+            return _upipe_http_src_get_parallel(upipe, parallel_p,
+                                                chunk_size_p);
+        }
+        case UPIPE_HTTP_SRC_SET_PARALLEL: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+            unsigned int parallel = va_arg(args, unsigned int);
+            uint64_t chunk_size = va_arg(args, uint64_t);
+            return _upipe_http_src_set_parallel(upipe, parallel, chunk_size);
+        }
+
+        case UPIPE_HTTP_SRC_GET_WEIGHT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+            unsigned int *weight_p = va_arg(args, unsigned int *);
+            return _upipe_http_src_get_weight(upipe, weight_p);
+        }
+        case UPIPE_HTTP_SRC_SET_WEIGHT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+            unsigned int weight = va_arg(args, unsigned int);
+            return _upipe_http_src_set_weight(upipe, weight);
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -1362,20 +3073,6 @@ static int upipe_http_src_control(struct upipe *upipe,
     return upipe_http_src_check(upipe, NULL);
 }
 
-struct upipe_http_src_mgr {
-    /** upipe manager */
-    struct upipe_mgr upipe_mgr;
-    /** urefcount structure */
-    struct urefcount urefcount;
-    /** cookie list */
-    struct uchain cookies;
-    /** proxy url */
-    char *proxy;
-};
-
-UBASE_FROM_TO(upipe_http_src_mgr, upipe_mgr, upipe_mgr, upipe_mgr)
-UBASE_FROM_TO(upipe_http_src_mgr, urefcount, urefcount, urefcount);
-
 static int _upipe_http_src_mgr_set_cookie(struct upipe_mgr *upipe_mgr,
                                           const char *cookie_string)
 {
@@ -1484,6 +3181,24 @@ static int _upipe_http_src_mgr_set_proxy(struct upipe_mgr *mgr,
     return UBASE_ERR_NONE;
 }
 
+static int _upipe_http_src_mgr_get_http2(struct upipe_mgr *mgr,
+                                         bool *http2_p)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+    if (http2_p)
+        *http2_p = upipe_http_src_mgr->http2;
+    return UBASE_ERR_NONE;
+}
+
+static int _upipe_http_src_mgr_set_http2(struct upipe_mgr *mgr, bool http2)
+{
+    struct upipe_http_src_mgr *upipe_http_src_mgr =
+        upipe_http_src_mgr_from_upipe_mgr(mgr);
+    upipe_http_src_mgr->http2 = http2;
+    return UBASE_ERR_NONE;
+}
+
 static int upipe_http_src_mgr_control(struct upipe_mgr *upipe_mgr,
                                       int command, va_list args)
 {
@@ -1512,6 +3227,17 @@ static int upipe_http_src_mgr_control(struct upipe_mgr *upipe_mgr,
         const char *proxy = va_arg(args, const char *);
         return _upipe_http_src_mgr_set_proxy(upipe_mgr, proxy);
     }
+
+    case UPIPE_HTTP_SRC_MGR_GET_HTTP2: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+        bool *http2_p = va_arg(args, bool *);
+        return _upipe_http_src_mgr_get_http2(upipe_mgr, http2_p);
+    }
+    case UPIPE_HTTP_SRC_MGR_SET_HTTP2: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_HTTP_SRC_SIGNATURE)
+        bool http2 = va_arg(args, int);
+        return _upipe_http_src_mgr_set_http2(upipe_mgr, http2);
+    }
     }
     return UBASE_ERR_UNHANDLED;
 }
@@ -1529,6 +3255,26 @@ static void upipe_http_src_mgr_free(struct urefcount *urefcount)
         free(cookie->value);
         free(cookie);
     }
+    ulist_delete_foreach(&upipe_http_src_mgr->connections, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        upipe_http_src_connection_free(
+            upipe_http_src_connection_from_uchain(uchain));
+    }
+    /* the active connections keep the manager, these ones are idle */
+    ulist_delete_foreach(&upipe_http_src_mgr->h2_connections,
+                         uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        upipe_http_src_h2_conn_free(
+            upipe_http_src_h2_conn_from_uchain(uchain));
+    }
+    ulist_delete_foreach(&upipe_http_src_mgr->h1_origins,
+                         uchain, uchain_tmp) {
+        struct upipe_http_src_origin *origin =
+            upipe_http_src_origin_from_uchain(uchain);
+        ulist_delete(uchain);
+        free(origin->key);
+        free(origin);
+    }
     free(upipe_http_src_mgr->proxy);
     urefcount_clean(urefcount);
     free(upipe_http_src_mgr);
@@ -1562,6 +3308,12 @@ struct upipe_mgr *upipe_http_src_mgr_alloc(void)
     upipe_mgr->refcount = urefcount;
     ulist_init(&upipe_http_src_mgr->cookies);
     upipe_http_src_mgr->proxy = NULL;
+    ulist_init(&upipe_http_src_mgr->connections);
+    upipe_http_src_mgr->nb_connections = 0;
+    upipe_http_src_mgr->http2 = false;
+    ulist_init(&upipe_http_src_mgr->h2_connections);
+    ulist_init(&upipe_http_src_mgr->h1_origins);
+    upipe_http_src_mgr->nb_h1_origins = 0;
 
     return upipe_http_src_mgr_to_upipe_mgr(upipe_http_src_mgr);
 }
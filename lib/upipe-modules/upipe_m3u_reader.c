@@ -144,6 +144,17 @@ struct upipe_m3u_reader {
     struct uref *key;
     /** list of items */
     struct uchain items;
+    /** number of items of the playlist being parsed */
+    uint64_t nb_items;
+
+    /** skip the items already output on the previous load */
+    bool incremental;
+    /** true if a media playlist was output */
+    bool loaded;
+    /** media sequence of the last output playlist */
+    uint64_t media_sequence;
+    /** media sequence following the last output item */
+    uint64_t next_sequence;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -189,6 +200,11 @@ static struct upipe *upipe_m3u_reader_alloc(struct upipe_mgr *mgr,
     upipe_m3u_reader->flow_def = NULL;
     upipe_m3u_reader->item = NULL;
     upipe_m3u_reader->key = NULL;
+    upipe_m3u_reader->nb_items = 0;
+    upipe_m3u_reader->incremental = false;
+    upipe_m3u_reader->loaded = false;
+    upipe_m3u_reader->media_sequence = 0;
+    upipe_m3u_reader->next_sequence = 0;
     upipe_m3u_reader->restart = false;
     upipe_throw_ready(upipe);
 
@@ -207,6 +223,7 @@ static void upipe_m3u_reader_flush(struct upipe *upipe)
     uref_free(upipe_m3u_reader->current_flow_def);
     uref_free(upipe_m3u_reader->item);
     upipe_m3u_reader->item = NULL;
+    upipe_m3u_reader->nb_items = 0;
 
     struct uchain *uchain;
     while ((uchain = ulist_pop(&upipe_m3u_reader->items)) != NULL)
@@ -264,6 +281,31 @@ static int upipe_m3u_reader_get_item(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This checks whether the current item was already output on
+ * the previous load of the playlist, in incremental mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def the current flow definition
+ * @return true if the item may be skipped
+ */
+static bool upipe_m3u_reader_item_known(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    struct upipe_m3u_reader *upipe_m3u_reader =
+        upipe_m3u_reader_from_upipe(upipe);
+
+    if (!upipe_m3u_reader->incremental || !upipe_m3u_reader->loaded)
+        return false;
+
+    uint64_t media_sequence = 0;
+    uref_m3u_playlist_flow_get_media_sequence(flow_def, &media_sequence);
+    if (media_sequence < upipe_m3u_reader->media_sequence ||
+        media_sequence > upipe_m3u_reader->next_sequence)
+        return false;
+    return media_sequence + upipe_m3u_reader->nb_items <
+        upipe_m3u_reader->next_sequence;
+}
+
 /** @internal @This checks a "#EXTM3U" tag.
  *
  * @param upipe description structure of the pipe
@@ -437,6 +479,8 @@ static int upipe_m3u_reader_process_extinf(struct upipe *upipe,
     if (strcmp(def, M3U_FLOW_DEF) && strcmp(def, PLAYLIST_FLOW_DEF))
         return UBASE_ERR_INVALID;
     UBASE_RETURN(uref_flow_set_def(flow_def, PLAYLIST_FLOW_DEF));
+    if (upipe_m3u_reader_item_known(upipe, flow_def))
+        return UBASE_ERR_NONE;
     UBASE_RETURN(upipe_m3u_reader_get_item(upipe, flow_def, &item));
 
     const char *endptr;
@@ -560,6 +604,8 @@ static int upipe_m3u_reader_process_byte_range(struct upipe *upipe,
     if (strcmp(def, M3U_FLOW_DEF) && strcmp(def, PLAYLIST_FLOW_DEF))
         return UBASE_ERR_INVALID;
     UBASE_RETURN(uref_flow_set_def(flow_def, PLAYLIST_FLOW_DEF));
+    if (upipe_m3u_reader_item_known(upipe, flow_def))
+        return UBASE_ERR_NONE;
     UBASE_RETURN(upipe_m3u_reader_get_item(upipe, flow_def, &item));
 
     char *endptr = NULL;
@@ -789,12 +835,17 @@ static int upipe_m3u_reader_process_uri(struct upipe *upipe,
 
     upipe_verbose_va(upipe, "uri %s", uri);
     UBASE_RETURN(uref_flow_match_def(flow_def, M3U_FLOW_DEF));
+    if (upipe_m3u_reader_item_known(upipe, flow_def)) {
+        upipe_m3u_reader->nb_items++;
+        return UBASE_ERR_NONE;
+    }
     struct uref *item;
     UBASE_RETURN(upipe_m3u_reader_get_item(upipe, flow_def, &item));
     UBASE_RETURN(uref_m3u_set_uri(item, uri));
     if (upipe_m3u_reader->key)
         UBASE_RETURN(uref_m3u_playlist_key_copy(item, upipe_m3u_reader->key));
     upipe_m3u_reader->item = NULL;
+    upipe_m3u_reader->nb_items++;
     ulist_add(&upipe_m3u_reader->items, uref_to_uchain(item));
     return UBASE_ERR_NONE;
 }
@@ -917,6 +968,28 @@ static void upipe_m3u_reader_output_all(struct upipe *upipe,
         return;
     }
 
+    bool append = false;
+    if (ubase_check(uref_flow_match_def(flow_def, PLAYLIST_FLOW_DEF))) {
+        uint64_t media_sequence = 0;
+        uref_m3u_playlist_flow_get_media_sequence(flow_def, &media_sequence);
+        append = upipe_m3u_reader->incremental &&
+            upipe_m3u_reader->loaded &&
+            media_sequence >= upipe_m3u_reader->media_sequence &&
+            media_sequence <= upipe_m3u_reader->next_sequence;
+        if (append) {
+            upipe_verbose_va(upipe, "append %"PRIu64" items",
+                media_sequence + upipe_m3u_reader->nb_items -
+                upipe_m3u_reader->next_sequence);
+            uref_m3u_playlist_flow_set_append(flow_def);
+        }
+        upipe_m3u_reader->loaded = true;
+        upipe_m3u_reader->media_sequence = media_sequence;
+        upipe_m3u_reader->next_sequence =
+            media_sequence + upipe_m3u_reader->nb_items;
+    }
+    else
+        upipe_m3u_reader->loaded = false;
+
     /* force new flow def */
     upipe_m3u_reader_store_flow_def(upipe, NULL);
     /* set output flow def */
@@ -938,6 +1011,9 @@ static void upipe_m3u_reader_output_all(struct upipe *upipe,
 
         upipe_m3u_reader_output(upipe, uref, upump_p);
     }
+    /* no new item, still forward the new media sequence */
+    if (first && append)
+        upipe_m3u_reader_output(upipe, NULL, upump_p);
     upipe_release(upipe);
 }
 
@@ -1009,6 +1085,9 @@ static int upipe_m3u_reader_control(struct upipe *upipe,
                                     int command,
                                     va_list args)
 {
+    struct upipe_m3u_reader *upipe_m3u_reader =
+        upipe_m3u_reader_from_upipe(upipe);
+
     UBASE_HANDLED_RETURN(upipe_m3u_reader_control_output(upipe, command, args));
     switch (command) {
     case UPIPE_SET_FLOW_DEF: {
@@ -1016,6 +1095,19 @@ static int upipe_m3u_reader_control(struct upipe *upipe,
         return upipe_m3u_reader_set_flow_def(upipe, p);
     }
 
+    case UPIPE_M3U_READER_GET_INCREMENTAL: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_M3U_READER_SIGNATURE);
+        int *incremental_p = va_arg(args, int *);
+        *incremental_p = upipe_m3u_reader->incremental;
+        return UBASE_ERR_NONE;
+    }
+    case UPIPE_M3U_READER_SET_INCREMENTAL: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_M3U_READER_SIGNATURE);
+        upipe_m3u_reader->incremental = !!va_arg(args, int);
+        upipe_m3u_reader->loaded = false;
+        return UBASE_ERR_NONE;
+    }
+
     default:
         return UBASE_ERR_UNHANDLED;
     }
@@ -1029,6 +1121,7 @@ static struct upipe_mgr upipe_m3u_reader_mgr = {
     .upipe_alloc = upipe_m3u_reader_alloc,
     .upipe_input = upipe_m3u_reader_input,
     .upipe_control = upipe_m3u_reader_control,
+    .upipe_command_str = upipe_m3u_reader_command_str,
 
     .upipe_mgr_control = NULL,
 };
@@ -79,14 +79,15 @@ UPIPE_HELPER_UREFCOUNT(upipe_match_attr, urefcount, upipe_match_attr_free)
 UPIPE_HELPER_VOID(upipe_match_attr)
 UPIPE_HELPER_OUTPUT(upipe_match_attr, output, flow_def, output_state, request_list)
 
-/** @internal @This receives data.
+/** @internal @This processes a uref in place.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref was dropped
  */
-static void upipe_match_attr_input(struct upipe *upipe, struct uref *uref,
-                                   struct upump **upump_p)
+static bool upipe_match_attr_process(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
 {
     struct upipe_match_attr *upipe_match_attr = upipe_match_attr_from_upipe(upipe);
     int forward = UBASE_ERR_NONE;
@@ -112,11 +113,24 @@ static void upipe_match_attr_input(struct upipe *upipe, struct uref *uref,
             break;
     }
 
-    if (ubase_check(forward)) {
-        upipe_match_attr_output(upipe, uref, upump_p);
-    } else {
+    if (!ubase_check(forward)) {
         uref_free(uref);
+        return false;
     }
+    return true;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_match_attr_input(struct upipe *upipe, struct uref *uref,
+                                   struct upump **upump_p)
+{
+    if (upipe_match_attr_process(upipe, uref, upump_p))
+        upipe_match_attr_output(upipe, uref, upump_p);
 }
 
 /** @internal @This sets the input flow definition.
@@ -155,6 +169,12 @@ static int upipe_match_attr_control(struct upipe *upipe,
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_match_attr_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_GET_PROCESS: {
+            upipe_process_func *process_p =
+                va_arg(args, upipe_process_func *);
+            *process_p = upipe_match_attr_process;
+            return UBASE_ERR_NONE;
+        }
 
         case UPIPE_MATCH_ATTR_SET_UINT8_T: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_MATCH_ATTR_SIGNATURE)
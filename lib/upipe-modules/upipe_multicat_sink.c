@@ -39,6 +39,7 @@
 #include "upipe/upipe_helper_void.h"
 #include "upipe-modules/upipe_multicat_sink.h"
 #include "upipe-modules/upipe_file_sink.h"
+#include "upipe-modules/upipe_genaux.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -47,9 +48,18 @@
 #include <stdarg.h>
 #include <string.h>
 #include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <sys/param.h>
 
+#ifndef O_CLOEXEC
+#   define O_CLOEXEC 0
+#endif
+
 #define EXPECTED_FLOW_DEF "block."
+/** size of a record of the index file */
+#define INDEX_RECORD_SIZE 16
 
 /** upipe_multicat_sink structure */
 struct upipe_multicat_sink {
@@ -81,6 +91,25 @@ struct upipe_multicat_sink {
     enum upipe_fsink_mode mode;
     /** sync period */
     uint64_t sync_period;
+    /** number of staging chunks of the fsink asynchronous mode */
+    unsigned int async_nb;
+    /** size of the staging chunks */
+    size_t async_size;
+    /** true to open files with O_DIRECT */
+    bool async_direct;
+    /** true to preallocate each file with the size of the previous one */
+    bool preallocate;
+    /** octets written to the current file */
+    uint64_t file_size;
+
+    /** index file descriptor, or -1 */
+    int index_fd;
+    /** true if the index already contains a record */
+    bool index_last;
+    /** cr_sys of the last record of the index */
+    uint64_t index_last_cr_sys;
+    /** file index of the last record of the index */
+    uint64_t index_last_idx;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -115,6 +144,85 @@ static bool _upipe_multicat_sink_change_file(struct upipe *upipe, int64_t idx)
     return true;
 }
 
+/** @internal @This appends a record for a new file to the index.
+ *
+ * @param upipe description structure of the pipe
+ * @param cr_sys cr_sys of the first uref of the file
+ * @param idx file index
+ */
+static void upipe_multicat_sink_write_index(struct upipe *upipe,
+                                            uint64_t cr_sys, int64_t idx)
+{
+    struct upipe_multicat_sink *upipe_multicat_sink =
+        upipe_multicat_sink_from_upipe(upipe);
+    if (upipe_multicat_sink->index_fd == -1 || idx < 0)
+        return;
+    if (upipe_multicat_sink->index_last &&
+        (cr_sys <= upipe_multicat_sink->index_last_cr_sys ||
+         (uint64_t)idx <= upipe_multicat_sink->index_last_idx))
+        return;
+
+    uint8_t record[INDEX_RECORD_SIZE];
+    upipe_genaux_hton64(record, cr_sys);
+    upipe_genaux_hton64(record + 8, idx);
+    if (unlikely(write(upipe_multicat_sink->index_fd, record,
+                       INDEX_RECORD_SIZE) != INDEX_RECORD_SIZE)) {
+        upipe_warn_va(upipe, "unable to write index (%m)");
+        return;
+    }
+    upipe_multicat_sink->index_last = true;
+    upipe_multicat_sink->index_last_cr_sys = cr_sys;
+    upipe_multicat_sink->index_last_idx = idx;
+}
+
+/** @internal @This opens the index file, and reads its last record.
+ *
+ * @param upipe description structure of the pipe
+ * @param path path of the index file, or NULL
+ * @return an error code
+ */
+static int _upipe_multicat_sink_set_index(struct upipe *upipe,
+                                          const char *path)
+{
+    struct upipe_multicat_sink *upipe_multicat_sink =
+        upipe_multicat_sink_from_upipe(upipe);
+    ubase_clean_fd(&upipe_multicat_sink->index_fd);
+    upipe_multicat_sink->index_last = false;
+    if (path == NULL)
+        return UBASE_ERR_NONE;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "unable to open index %s (%m)", path);
+        return UBASE_ERR_EXTERNAL;
+    }
+    struct stat st;
+    if (unlikely(fstat(fd, &st) == -1)) {
+        upipe_err_va(upipe, "unable to stat index %s (%m)", path);
+        close(fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+    off_t nb = st.st_size / INDEX_RECORD_SIZE;
+    if (unlikely(st.st_size % INDEX_RECORD_SIZE))
+        upipe_warn_va(upipe, "index %s has a truncated record", path);
+    if (nb) {
+        uint8_t record[INDEX_RECORD_SIZE];
+        if (unlikely(pread(fd, record, INDEX_RECORD_SIZE,
+                           (nb - 1) * INDEX_RECORD_SIZE) !=
+                     INDEX_RECORD_SIZE)) {
+            upipe_err_va(upipe, "unable to read index %s (%m)", path);
+            close(fd);
+            return UBASE_ERR_EXTERNAL;
+        }
+        upipe_multicat_sink->index_last = true;
+        upipe_multicat_sink->index_last_cr_sys = upipe_genaux_ntoh64(record);
+        upipe_multicat_sink->index_last_idx = upipe_genaux_ntoh64(record + 8);
+    }
+    upipe_multicat_sink->index_fd = fd;
+    upipe_notice_va(upipe, "writing index %s", path);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -136,14 +244,23 @@ static void upipe_multicat_sink_input(struct upipe *upipe, struct uref *uref,
     newidx = (systime - upipe_multicat_sink->rotate_offset) /
              upipe_multicat_sink->rotate;
     if (upipe_multicat_sink->fileidx != newidx) {
+        if (upipe_multicat_sink->preallocate && upipe_multicat_sink->fsink &&
+            upipe_multicat_sink->file_size)
+            upipe_fsink_set_preallocate(upipe_multicat_sink->fsink,
+                                        upipe_multicat_sink->file_size);
+        upipe_multicat_sink->file_size = 0;
         if (unlikely(! _upipe_multicat_sink_change_file(upipe, newidx))) {
             upipe_warn(upipe, "couldn't change file path");
             uref_free(uref);
             return;
         }
         upipe_multicat_sink->fileidx = newidx;
+        upipe_multicat_sink_write_index(upipe, systime, newidx);
     }
 
+    size_t size;
+    if (ubase_check(uref_block_size(uref, &size)))
+        upipe_multicat_sink->file_size += size;
     upipe_input(upipe_multicat_sink->fsink, uref, upump_p);
 }
 
@@ -174,6 +291,14 @@ static int _upipe_multicat_sink_output_alloc(struct upipe *upipe)
         upipe_warn(upipe, "set_flow_def failed");
         return err;
     }
+    if (upipe_multicat_sink->async_nb &&
+        (err = upipe_fsink_set_async(fsink, upipe_multicat_sink->async_nb,
+                                     upipe_multicat_sink->async_size,
+                                     upipe_multicat_sink->async_direct)) !=
+        UBASE_ERR_NONE) {
+        upipe_warn(upipe, "set_async failed");
+        return err;
+    }
     upipe_multicat_sink->fsink = fsink;
     return UBASE_ERR_NONE;
 }
@@ -391,6 +516,30 @@ static int upipe_multicat_sink_control(struct upipe *upipe,
             *p = upipe_multicat_sink->sync_period;
             return UBASE_ERR_NONE;
         }
+        case UPIPE_FSINK_SET_ASYNC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_FSINK_SIGNATURE)
+            unsigned int nb_chunks = va_arg(args, unsigned int);
+            size_t chunk_size = va_arg(args, size_t);
+            int direct = va_arg(args, int);
+            if (upipe_multicat_sink->fsink != NULL)
+                UBASE_RETURN(upipe_fsink_set_async(upipe_multicat_sink->fsink,
+                                                   nb_chunks, chunk_size,
+                                                   direct))
+            upipe_multicat_sink->async_nb = nb_chunks;
+            upipe_multicat_sink->async_size = chunk_size;
+            upipe_multicat_sink->async_direct = !!direct;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_MULTICAT_SINK_SET_PREALLOCATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_MULTICAT_SINK_SIGNATURE)
+            upipe_multicat_sink->preallocate = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_MULTICAT_SINK_SET_INDEX: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_MULTICAT_SINK_SIGNATURE)
+            const char *path = va_arg(args, const char *);
+            return _upipe_multicat_sink_set_index(upipe, path);
+        }
         default:
             if (upipe_multicat_sink->fsink != NULL)
                 return upipe_control_va(upipe_multicat_sink->fsink,
@@ -430,6 +579,15 @@ static struct upipe *upipe_multicat_sink_alloc(struct upipe_mgr *mgr,
     upipe_multicat_sink->rotate_offset = UPIPE_MULTICAT_SINK_DEF_ROTATE_OFFSET;
     upipe_multicat_sink->mode = UPIPE_FSINK_APPEND;
     upipe_multicat_sink->sync_period = 0;
+    upipe_multicat_sink->async_nb = 0;
+    upipe_multicat_sink->async_size = 0;
+    upipe_multicat_sink->async_direct = false;
+    upipe_multicat_sink->preallocate = false;
+    upipe_multicat_sink->file_size = 0;
+    upipe_multicat_sink->index_fd = -1;
+    upipe_multicat_sink->index_last = false;
+    upipe_multicat_sink->index_last_cr_sys = 0;
+    upipe_multicat_sink->index_last_idx = 0;
     upipe_multicat_sink->flow_def = NULL;
     upipe_throw_ready(upipe);
     return upipe;
@@ -451,6 +609,7 @@ static void upipe_multicat_sink_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     upipe_mgr_release(upipe_multicat_sink->fsink_mgr);
+    ubase_clean_fd(&upipe_multicat_sink->index_fd);
     free(upipe_multicat_sink->dirpath);
     free(upipe_multicat_sink->suffix);
     upipe_multicat_sink_clean_urefcount(upipe);
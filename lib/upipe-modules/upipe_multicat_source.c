@@ -46,6 +46,7 @@
 #include "upipe/upipe_helper_upump.h"
 #include "upipe/upipe_helper_output_size.h"
 #include "upipe-modules/upipe_multicat_source.h"
+#include "upipe_file_map.h"
 
 #include <stdlib.h>
 #include <stdint.h>
@@ -67,6 +68,10 @@
 #define UBUF_DEFAULT_SIZE       1316
 /** mux number of missing segments */
 #define MISSING_SEGMENTS        5
+/** size of a record of the index file */
+#define INDEX_RECORD_SIZE       16
+/** size of a record of the random access point index */
+#define RAP_RECORD_SIZE         8
 
 /** @internal @This is the private context of a multicat source pipe. */
 struct upipe_msrc {
@@ -115,6 +120,13 @@ struct upipe_msrc {
     /** number of missing segments */
     unsigned long missing;
 
+    /** true if the data files are mapped */
+    bool mmap;
+    /** mapping of the current data file, or NULL */
+    struct upipe_file_map *map;
+    /** reading position in the mapping */
+    uint64_t map_pos;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -188,10 +200,172 @@ static struct upipe *upipe_msrc_alloc(struct upipe_mgr *mgr,
     upipe_msrc->fileidx = -1;
     upipe_msrc->pos = UINT64_MAX;
     upipe_msrc->missing = 0;
+    upipe_msrc->mmap = false;
+    upipe_msrc->map = NULL;
+    upipe_msrc->map_pos = 0;
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This looks up the index file, if there is one. Records are
+ * sorted both by cr_sys and by file index, so they are binary-searched for
+ * the first record whose key is strictly greater than the given value.
+ *
+ * @param upipe description structure of the pipe
+ * @param next true to find the file following the given file index, false to
+ * find the file containing the given position
+ * @param value position or file index
+ * @param fileidx_p filled in with the file index found
+ * @return an error code
+ */
+static int upipe_msrc_index_lookup(struct upipe *upipe, bool next,
+                                   uint64_t value, uint64_t *fileidx_p)
+{
+    struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
+    const char *index;
+    UBASE_RETURN(uref_msrc_flow_get_index(upipe_msrc->flow_def_input, &index))
+
+    int fd = open(index, O_RDONLY | O_CLOEXEC);
+    if (unlikely(fd == -1)) {
+        upipe_warn_va(upipe, "unable to open index %s (%m)", index);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct stat index_stat;
+    uint64_t nb = 0;
+    if (likely(fstat(fd, &index_stat) != -1))
+        nb = index_stat.st_size / INDEX_RECORD_SIZE;
+    if (unlikely(!nb)) {
+        upipe_warn_va(upipe, "empty index %s", index);
+        close(fd);
+        return UBASE_ERR_INVALID;
+    }
+
+    uint8_t *index_buf = mmap(NULL, nb * INDEX_RECORD_SIZE, PROT_READ,
+                              MAP_SHARED, fd, 0);
+    close(fd);
+    if (unlikely(index_buf == MAP_FAILED)) {
+        upipe_warn_va(upipe, "unable to mmap index %s (%m)", index);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    unsigned int key = next ? 8 : 0;
+    uint64_t low = 0;
+    uint64_t high = nb;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (upipe_msrc_ntoh64(index_buf + mid * INDEX_RECORD_SIZE + key) >
+            value)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    int err = UBASE_ERR_NONE;
+    if (next) {
+        /* first file after the given index */
+        if (low < nb)
+            *fileidx_p = upipe_msrc_ntoh64(index_buf + low * INDEX_RECORD_SIZE +
+                                           8);
+        else
+            err = UBASE_ERR_INVALID;
+    } else {
+        /* last file starting before the position, or the first file */
+        if (low)
+            low--;
+        *fileidx_p = upipe_msrc_ntoh64(index_buf + low * INDEX_RECORD_SIZE +
+                                       8);
+    }
+    munmap(index_buf, nb * INDEX_RECORD_SIZE);
+    return err;
+}
+
+/** @internal @This looks up the random access point index, if there is one,
+ * for the last random access point before the given position. Records are
+ * 64-bit dates in increasing order.
+ *
+ * @param upipe description structure of the pipe
+ * @param pos position
+ * @param rap_p filled in with the random access point found
+ * @return an error code
+ */
+static int upipe_msrc_rap_lookup(struct upipe *upipe, uint64_t pos,
+                                 uint64_t *rap_p)
+{
+    struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
+    const char *rap;
+    UBASE_RETURN(uref_msrc_flow_get_rap(upipe_msrc->flow_def_input, &rap))
+
+    int fd = open(rap, O_RDONLY | O_CLOEXEC);
+    if (unlikely(fd == -1)) {
+        upipe_warn_va(upipe, "unable to open RAP index %s (%m)", rap);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct stat rap_stat;
+    uint64_t nb = 0;
+    if (likely(fstat(fd, &rap_stat) != -1))
+        nb = rap_stat.st_size / RAP_RECORD_SIZE;
+    if (unlikely(!nb)) {
+        close(fd);
+        return UBASE_ERR_INVALID;
+    }
+
+    uint8_t *rap_buf = mmap(NULL, nb * RAP_RECORD_SIZE, PROT_READ,
+                            MAP_SHARED, fd, 0);
+    close(fd);
+    if (unlikely(rap_buf == MAP_FAILED)) {
+        upipe_warn_va(upipe, "unable to mmap RAP index %s (%m)", rap);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    uint64_t low = 0;
+    uint64_t high = nb;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (upipe_msrc_ntoh64(rap_buf + mid * RAP_RECORD_SIZE) > pos)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+
+    int err = UBASE_ERR_INVALID;
+    if (low) {
+        *rap_p = upipe_msrc_ntoh64(rap_buf + (low - 1) * RAP_RECORD_SIZE);
+        err = UBASE_ERR_NONE;
+    }
+    munmap(rap_buf, nb * RAP_RECORD_SIZE);
+    return err;
+}
+
+/** @internal @This maps the current data file again if it has grown beyond
+ * the current mapping, which happens when reading the segment being
+ * written. Blocks pointing into the previous mapping stay valid.
+ *
+ * @param upipe description structure of the pipe
+ * @return true if the mapping was extended
+ */
+static bool upipe_msrc_remap(struct upipe *upipe)
+{
+    struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
+    uint64_t mapped = upipe_msrc->map != NULL ? upipe_msrc->map->size : 0;
+    struct stat st;
+    if (unlikely(fstat(upipe_msrc->fd, &st) == -1) ||
+        (uint64_t)st.st_size <= mapped)
+        return false;
+
+    struct upipe_file_map *map = upipe_file_map_alloc(upipe_msrc->fd,
+                                                      st.st_size);
+    if (unlikely(map == NULL)) {
+        upipe_warn_va(upipe, "unable to map segment %"PRIu64" (%m)",
+                      upipe_msrc->fileidx);
+        return false;
+    }
+    upipe_file_map_release(upipe_msrc->map);
+    upipe_msrc->map = map;
+    return true;
+}
+
 /** @internal @This skips the current segment in case of error.
  *
  * @param upipe description structure of the pipe
@@ -202,7 +376,12 @@ static int upipe_msrc_skip(struct upipe *upipe)
     struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
     if (upipe_msrc->missing++ >= MISSING_SEGMENTS)
         return UBASE_ERR_INVALID;
-    upipe_msrc->fileidx++;
+    uint64_t fileidx;
+    if (ubase_check(upipe_msrc_index_lookup(upipe, true, upipe_msrc->fileidx,
+                                            &fileidx)))
+        upipe_msrc->fileidx = fileidx;
+    else
+        upipe_msrc->fileidx++;
     return upipe_msrc_setup(upipe);
 }
 
@@ -225,6 +404,9 @@ static int upipe_msrc_setup(struct upipe *upipe)
         fclose(upipe_msrc->aux_file);
         upipe_msrc->aux_file = NULL;
     }
+    upipe_file_map_release(upipe_msrc->map);
+    upipe_msrc->map = NULL;
+    upipe_msrc->map_pos = 0;
 
     char data_file[strlen(path) + strlen(data) +
                    sizeof("18446744073709551615")];
@@ -251,6 +433,9 @@ static int upipe_msrc_setup(struct upipe *upipe)
         /* try next file anyway */
         return upipe_msrc_skip(upipe);
     }
+
+    if (upipe_msrc->mmap)
+        upipe_msrc_remap(upipe);
     return UBASE_ERR_NONE;
 }
 
@@ -270,7 +455,18 @@ static int upipe_msrc_start(struct upipe *upipe)
     UBASE_RETURN(uref_msrc_flow_get_aux(upipe_msrc->flow_def_input, &aux))
     uref_msrc_flow_get_rotate(upipe_msrc->flow_def_input, &rotate);
     uref_msrc_flow_get_offset(upipe_msrc->flow_def_input, &offset);
-    upipe_msrc->fileidx = (upipe_msrc->pos - offset) / rotate;
+    uint64_t rap;
+    if (ubase_check(upipe_msrc_rap_lookup(upipe, upipe_msrc->pos, &rap))) {
+        upipe_dbg_va(upipe, "starting from random access point %"PRIu64,
+                     rap);
+        upipe_msrc->pos = rap;
+    }
+    const char *index;
+    if (!ubase_check(uref_msrc_flow_get_index(upipe_msrc->flow_def_input,
+                                              &index)) ||
+        !ubase_check(upipe_msrc_index_lookup(upipe, false, upipe_msrc->pos,
+                                             &upipe_msrc->fileidx)))
+        upipe_msrc->fileidx = (upipe_msrc->pos - offset) / rotate;
 
     char aux_file[strlen(path) + strlen(aux) +
                   sizeof(".18446744073709551615")];
@@ -328,10 +524,47 @@ static int upipe_msrc_start(struct upipe *upipe)
         /* try next file anyway */
         return upipe_msrc_skip(upipe);
     }
+    upipe_msrc->map_pos = (uint64_t)upipe_msrc->output_size * offset1;
 
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This allocates a uref pointing to the next block of the
+ * mapped data file.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref_p filled in with the uref, or NULL at the end of the segment
+ * @return an error code
+ */
+static int upipe_msrc_read_map(struct upipe *upipe, struct uref **uref_p)
+{
+    struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
+    *uref_p = NULL;
+    if (upipe_msrc->map == NULL ||
+        upipe_msrc->map_pos >= upipe_msrc->map->size)
+        upipe_msrc_remap(upipe);
+    struct upipe_file_map *map = upipe_msrc->map;
+    if (map == NULL || upipe_msrc->map_pos >= map->size)
+        return UBASE_ERR_NONE;
+
+    uint64_t size = map->size - upipe_msrc->map_pos;
+    if (size > upipe_msrc->output_size)
+        size = upipe_msrc->output_size;
+
+    struct uref *uref = uref_alloc(upipe_msrc->uref_mgr);
+    UBASE_ALLOC_RETURN(uref)
+    struct ubuf *ubuf = upipe_file_map_ubuf_alloc(map, upipe_msrc->map_pos,
+                                                  size);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(uref);
+        return UBASE_ERR_ALLOC;
+    }
+    uref_attach_ubuf(uref, ubuf);
+    upipe_msrc->map_pos += size;
+    *uref_p = uref;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This reads data from the source and outputs it.
  *
  * @param upipe description structure of the pipe
@@ -345,6 +578,21 @@ static int upipe_msrc_handle(struct upipe *upipe)
         return upipe_msrc_skip(upipe);
     uint64_t cr_sys = upipe_msrc_ntoh64(aux);
 
+    if (upipe_msrc->map != NULL) {
+        struct uref *uref;
+        UBASE_RETURN(upipe_msrc_read_map(upipe, &uref))
+        if (unlikely(uref == NULL)) {
+            upipe_warn_va(upipe, "premature end of segment %"PRIu64,
+                          upipe_msrc->fileidx);
+            return upipe_msrc_skip(upipe);
+        }
+        uref_clock_set_cr_sys(uref, cr_sys);
+
+        upipe_msrc->missing = 0;
+        upipe_msrc_output(upipe, uref, &upipe_msrc->upump);
+        return UBASE_ERR_NONE;
+    }
+
     struct uref *uref = uref_block_alloc(upipe_msrc->uref_mgr,
                                          upipe_msrc->ubuf_mgr,
                                          upipe_msrc->output_size);
@@ -454,6 +702,8 @@ static void upipe_msrc_close(struct upipe *upipe)
         fclose(upipe_msrc->aux_file);
         upipe_msrc->aux_file = NULL;
     }
+    upipe_file_map_release(upipe_msrc->map);
+    upipe_msrc->map = NULL;
 
     upipe_msrc_set_upump(upipe, NULL);
 }
@@ -591,6 +841,23 @@ static int upipe_msrc_set_position(struct upipe *upipe, uint64_t pos)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the memory-mapped read mode. Reading restarts from
+ * the last position set.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to map the data files
+ * @return an error code
+ */
+static int _upipe_msrc_set_mmap(struct upipe *upipe, bool enable)
+{
+    struct upipe_msrc *upipe_msrc = upipe_msrc_from_upipe(upipe);
+    if (upipe_msrc->mmap == enable)
+        return UBASE_ERR_NONE;
+    upipe_msrc_close(upipe);
+    upipe_msrc->mmap = enable;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a multicat source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -627,6 +894,17 @@ static int _upipe_msrc_control(struct upipe *upipe, int command, va_list args)
             uint64_t *p = va_arg(args, uint64_t *);
             return upipe_msrc_get_position(upipe, p);
         }
+        case UPIPE_MSRC_SET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_MSRC_SIGNATURE)
+            bool enable = va_arg(args, int);
+            return _upipe_msrc_set_mmap(upipe, enable);
+        }
+        case UPIPE_MSRC_GET_MMAP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_MSRC_SIGNATURE)
+            int *enable_p = va_arg(args, int *);
+            *enable_p = upipe_msrc_from_upipe(upipe)->mmap ? 1 : 0;
+            return UBASE_ERR_NONE;
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -93,20 +93,34 @@ static struct upipe *upipe_noclock_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This receives data.
+/** @internal @This processes a uref in place.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref was dropped
  */
-static void upipe_noclock_input(struct upipe *upipe, struct uref *uref,
-                                struct upump **upump_p)
+static bool upipe_noclock_process(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
 {
     int type;
     uint64_t date;
     uref_clock_get_date_prog(uref, &date, &type);
     uref_clock_set_date_sys(uref, date, type);
-    upipe_noclock_output(upipe, uref, upump_p);
+    return true;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_noclock_input(struct upipe *upipe, struct uref *uref,
+                                struct upump **upump_p)
+{
+    if (upipe_noclock_process(upipe, uref, upump_p))
+        upipe_noclock_output(upipe, uref, upump_p);
 }
 
 /** @internal @This sets the input flow definition.
@@ -142,6 +156,12 @@ static int upipe_noclock_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_noclock_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_GET_PROCESS: {
+            upipe_process_func *process_p =
+                va_arg(args, upipe_process_func *);
+            *process_p = upipe_noclock_process;
+            return UBASE_ERR_NONE;
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
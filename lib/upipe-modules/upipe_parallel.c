@@ -0,0 +1,650 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe module processing frames concurrently on several workers
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uref.h"
+#include "upipe/uref_attr.h"
+#include "upipe/uref_flow.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_subpipe.h"
+#include "upipe-modules/upipe_parallel.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <inttypes.h>
+
+UREF_ATTR_UNSIGNED(par, seq, "par.seq", parallel sequence number)
+
+/** @internal @This is the private context of a parallel pipe. */
+struct upipe_par {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of worker subpipes */
+    struct uchain subs;
+    /** manager to create worker subpipes */
+    struct upipe_mgr sub_mgr;
+    /** number of workers added */
+    unsigned int nb_workers;
+    /** last worker used in round-robin mode */
+    struct uchain *last_sub;
+
+    /** input flow definition */
+    struct uref *flow_def_input;
+    /** output flow definition */
+    struct uref *flow_def;
+    /** output pipe */
+    struct upipe *output;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** output requests */
+    struct uchain requests;
+
+    /** dispatch mode */
+    enum upipe_par_mode mode;
+    /** sequence number of the next input frame */
+    uint64_t seq_in;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_par, upipe, UPIPE_PAR_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_par, urefcount, upipe_par_no_input)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_par, urefcount_real, upipe_par_free)
+UPIPE_HELPER_VOID(upipe_par)
+UPIPE_HELPER_OUTPUT(upipe_par, output, flow_def, output_state, requests)
+
+/** @internal @This is the private context of a worker of a parallel pipe.
+ * The subpipe is the output of the worker. */
+struct upipe_par_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** worker pipe */
+    struct upipe *worker;
+    /** flow definition of the worker output */
+    struct uref *flow_def;
+    /** buffers output by the worker, waiting for their turn */
+    struct uchain urefs;
+    /** sequence numbers of the frames in flight in the worker */
+    uint64_t *seqs;
+    /** allocated size of the seqs array */
+    unsigned int seqs_size;
+    /** index of the oldest frame in flight in the seqs array */
+    unsigned int seqs_start;
+    /** number of frames in flight */
+    unsigned int nb_seqs;
+    /** true if the worker released its output */
+    bool ended;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_par_sub, upipe, UPIPE_PAR_SUB_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_par_sub, urefcount, upipe_par_sub_no_ref)
+UPIPE_HELPER_VOID(upipe_par_sub)
+
+UPIPE_HELPER_SUBPIPE(upipe_par, upipe_par_sub, sub, sub_mgr, subs, uchain)
+
+/** @internal @This records a frame sent to a worker.
+ *
+ * @param sub description structure of the subpipe
+ * @param seq sequence number of the frame
+ * @return an error code
+ */
+static int upipe_par_sub_push_seq(struct upipe_par_sub *sub, uint64_t seq)
+{
+    if (sub->nb_seqs == sub->seqs_size) {
+        unsigned int size = sub->seqs_size ? sub->seqs_size * 2 : 16;
+        uint64_t *seqs = realloc(sub->seqs, size * sizeof(uint64_t));
+        UBASE_ALLOC_RETURN(seqs);
+        /* move the wrapped part after the end of the old array */
+        for (unsigned int i = 0; i < sub->seqs_start; i++)
+            seqs[sub->seqs_size + i] = seqs[i];
+        sub->seqs = seqs;
+        sub->seqs_size = size;
+    }
+    sub->seqs[(sub->seqs_start + sub->nb_seqs) % sub->seqs_size] = seq;
+    sub->nb_seqs++;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This forgets the oldest frame sent to a worker.
+ *
+ * @param sub description structure of the subpipe
+ */
+static void upipe_par_sub_pop_seq(struct upipe_par_sub *sub)
+{
+    sub->seqs_start = (sub->seqs_start + 1) % sub->seqs_size;
+    sub->nb_seqs--;
+}
+
+/** @internal @This frees a worker subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_par_sub_free(struct upipe *upipe)
+{
+    struct upipe_par_sub *sub = upipe_par_sub_from_upipe(upipe);
+    struct upipe_par *upipe_par = upipe_par_from_sub_mgr(upipe->mgr);
+    upipe_throw_dead(upipe);
+
+    if (upipe_par->last_sub == &sub->uchain)
+        upipe_par->last_sub = NULL;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&sub->urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    free(sub->seqs);
+    uref_free(sub->flow_def);
+    upipe_release(sub->worker);
+
+    upipe_par_sub_clean_sub(upipe);
+    upipe_par_sub_clean_urefcount(upipe);
+    upipe_par_sub_free_void(upipe);
+}
+
+/** @internal @This outputs the buffers of the workers in sequence order.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_par_flush(struct upipe *upipe, struct upump **upump_p)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    /* freeing the last subpipe would free the pipe */
+    upipe_par_use_urefcount_real(upipe);
+
+    for ( ; ; ) {
+        /* the oldest frame in flight is the next one to output */
+        struct upipe_par_sub *owner = NULL;
+        struct uchain *uchain;
+        ulist_foreach (&upipe_par->subs, uchain) {
+            struct upipe_par_sub *sub = upipe_par_sub_from_uchain(uchain);
+            if (sub->nb_seqs &&
+                (owner == NULL ||
+                 sub->seqs[sub->seqs_start] <
+                     owner->seqs[owner->seqs_start]))
+                owner = sub;
+        }
+        if (owner == NULL)
+            break;
+
+        uint64_t next = owner->seqs[owner->seqs_start];
+        uchain = ulist_peek(&owner->urefs);
+        if (uchain == NULL) {
+            if (!owner->ended)
+                /* wait for the worker */
+                break;
+            upipe_verbose_va(upipe, "worker is gone, skipping frame %"PRIu64,
+                             next);
+            upipe_par_sub_pop_seq(owner);
+            continue;
+        }
+
+        struct uref *uref = uref_from_uchain(uchain);
+        uint64_t seq = 0;
+        uref_par_get_seq(uref, &seq);
+        if (seq > next) {
+            upipe_verbose_va(upipe, "frame %"PRIu64" dropped by worker",
+                             next);
+            upipe_par_sub_pop_seq(owner);
+            continue;
+        }
+
+        ulist_pop(&owner->urefs);
+        if (unlikely(seq < next)) {
+            upipe_warn_va(upipe, "dropping unexpected frame %"PRIu64, seq);
+            uref_free(uref);
+            continue;
+        }
+        upipe_par_sub_pop_seq(owner);
+        uref_par_delete_seq(uref);
+
+        if (owner->flow_def != NULL &&
+            (upipe_par->flow_def == NULL ||
+             udict_cmp(upipe_par->flow_def->udict,
+                       owner->flow_def->udict))) {
+            struct uref *flow_def = uref_dup(owner->flow_def);
+            if (unlikely(flow_def == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                uref_free(uref);
+                continue;
+            }
+            upipe_par_store_flow_def(upipe, flow_def);
+        }
+        upipe_par_output(upipe, uref, upump_p);
+    }
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_par->subs, uchain, uchain_tmp) {
+        struct upipe_par_sub *sub = upipe_par_sub_from_uchain(uchain);
+        if (sub->ended && !sub->nb_seqs)
+            upipe_par_sub_free(upipe_par_sub_to_upipe(sub));
+    }
+
+    upipe_par_release_urefcount_real(upipe);
+}
+
+/** @internal @This is called when the worker releases the subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_par_sub_no_ref(struct upipe *upipe)
+{
+    struct upipe_par_sub *sub = upipe_par_sub_from_upipe(upipe);
+    struct upipe_par *upipe_par = upipe_par_from_sub_mgr(upipe->mgr);
+    sub->ended = true;
+    upipe_par_flush(upipe_par_to_upipe(upipe_par), NULL);
+}
+
+/** @internal @This allocates a worker subpipe of a parallel pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_par_sub_alloc(struct upipe_mgr *mgr,
+                                         struct uprobe *uprobe,
+                                         uint32_t signature, va_list args)
+{
+    if (mgr->signature != UPIPE_PAR_SUB_SIGNATURE)
+        return NULL;
+
+    struct upipe *upipe =
+        upipe_par_sub_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_par_sub *sub = upipe_par_sub_from_upipe(upipe);
+    upipe_par_sub_init_urefcount(upipe);
+    upipe_par_sub_init_sub(upipe);
+    sub->worker = NULL;
+    sub->flow_def = NULL;
+    ulist_init(&sub->urefs);
+    sub->seqs = NULL;
+    sub->seqs_size = 0;
+    sub->seqs_start = 0;
+    sub->nb_seqs = 0;
+    sub->ended = false;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This receives a buffer from the worker.
+ *
+ * @param upipe description structure of the subpipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_par_sub_input(struct upipe *upipe, struct uref *uref,
+                                struct upump **upump_p)
+{
+    struct upipe_par_sub *sub = upipe_par_sub_from_upipe(upipe);
+    struct upipe_par *upipe_par = upipe_par_from_sub_mgr(upipe->mgr);
+    uint64_t seq;
+    if (unlikely(!ubase_check(uref_par_get_seq(uref, &seq)))) {
+        upipe_warn(upipe, "frame without sequence number, dropping");
+        uref_free(uref);
+        return;
+    }
+    ulist_add(&sub->urefs, uref_to_uchain(uref));
+    upipe_par_flush(upipe_par_to_upipe(upipe_par), upump_p);
+}
+
+/** @internal @This processes control commands on a worker subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_par_sub_control(struct upipe *upipe,
+                                 int command, va_list args)
+{
+    struct upipe_par_sub *sub = upipe_par_sub_from_upipe(upipe);
+    struct upipe_par *upipe_par = upipe_par_from_sub_mgr(upipe->mgr);
+
+    UBASE_HANDLED_RETURN(upipe_par_sub_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_par_register_output_request(
+                upipe_par_to_upipe(upipe_par), request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_par_unregister_output_request(
+                upipe_par_to_upipe(upipe_par), request);
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            struct uref *flow_def_dup = uref_dup(flow_def);
+            UBASE_ALLOC_RETURN(flow_def_dup);
+            uref_free(sub->flow_def);
+            sub->flow_def = flow_def_dup;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This initializes the worker manager of a parallel pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_par_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_par->sub_mgr;
+    sub_mgr->refcount = upipe_par_to_urefcount_real(upipe_par);
+    sub_mgr->signature = UPIPE_PAR_SUB_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_par_sub_alloc;
+    sub_mgr->upipe_input = upipe_par_sub_input;
+    sub_mgr->upipe_control = upipe_par_sub_control;
+}
+
+/** @internal @This allocates a parallel pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_par_alloc(struct upipe_mgr *mgr,
+                                     struct uprobe *uprobe,
+                                     uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_par_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    upipe_par_init_urefcount(upipe);
+    upipe_par_init_urefcount_real(upipe);
+    upipe_par_init_sub_subs(upipe);
+    upipe_par_init_sub_mgr(upipe);
+    upipe_par_init_output(upipe);
+    upipe_par->nb_workers = 0;
+    upipe_par->last_sub = NULL;
+    upipe_par->flow_def_input = NULL;
+    upipe_par->mode = UPIPE_PAR_ROUND_ROBIN;
+    upipe_par->seq_in = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This selects the worker for the next frame.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the subpipe, or NULL if there is no worker
+ */
+static struct upipe_par_sub *upipe_par_select(struct upipe *upipe)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    struct upipe_par_sub *selected = NULL;
+    struct uchain *uchain;
+
+    if (upipe_par->mode == UPIPE_PAR_LEAST_LOADED) {
+        ulist_foreach (&upipe_par->subs, uchain) {
+            struct upipe_par_sub *sub = upipe_par_sub_from_uchain(uchain);
+            if (sub->worker != NULL &&
+                (selected == NULL || sub->nb_seqs < selected->nb_seqs))
+                selected = sub;
+        }
+        return selected;
+    }
+
+    /* round robin, starting after the last worker used */
+    uchain = upipe_par->last_sub != NULL ? upipe_par->last_sub :
+             &upipe_par->subs;
+    for (unsigned int i = 0; i <= upipe_par->nb_workers; i++) {
+        uchain = uchain->next;
+        if (uchain == &upipe_par->subs)
+            uchain = uchain->next;
+        if (uchain == &upipe_par->subs)
+            break;
+        struct upipe_par_sub *sub = upipe_par_sub_from_uchain(uchain);
+        if (sub->worker != NULL) {
+            upipe_par->last_sub = uchain;
+            return sub;
+        }
+    }
+    return NULL;
+}
+
+/** @internal @This dispatches a frame to a worker.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_par_input(struct upipe *upipe, struct uref *uref,
+                            struct upump **upump_p)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+
+    struct upipe_par_sub *sub = upipe_par_select(upipe);
+    if (unlikely(sub == NULL)) {
+        upipe_warn(upipe, "no worker, dropping frame");
+        uref_free(uref);
+        return;
+    }
+
+    uint64_t seq = upipe_par->seq_in++;
+    if (unlikely(!ubase_check(uref_par_set_seq(uref, seq)) ||
+                 !ubase_check(upipe_par_sub_push_seq(sub, seq)))) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        uref_free(uref);
+        return;
+    }
+    upipe_input(sub->worker, uref, upump_p);
+}
+
+/** @internal @This adds a worker.
+ *
+ * @param upipe description structure of the pipe
+ * @param worker worker pipe
+ * @return an error code
+ */
+static int upipe_par_add_worker_internal(struct upipe *upipe,
+                                         struct upipe *worker)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    if (worker == NULL)
+        return UBASE_ERR_INVALID;
+
+    struct upipe *sub = upipe_void_alloc(&upipe_par->sub_mgr,
+        uprobe_pfx_alloc_va(uprobe_use(upipe->uprobe), UPROBE_LOG_VERBOSE,
+                            "worker %u", upipe_par->nb_workers));
+    UBASE_ALLOC_RETURN(sub);
+
+    struct upipe_par_sub *upipe_par_sub = upipe_par_sub_from_upipe(sub);
+    int err = upipe_set_output(worker, sub);
+    /* the worker now holds the only reference to its output */
+    upipe_release(sub);
+    if (unlikely(!ubase_check(err))) {
+        upipe_err(upipe, "cannot set the output of the worker");
+        return err;
+    }
+    upipe_par_sub->worker = upipe_use(worker);
+    upipe_par->nb_workers++;
+
+    if (upipe_par->flow_def_input != NULL)
+        return upipe_set_flow_def(worker, upipe_par->flow_def_input);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the input flow definition on all workers.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def new flow definition
+ * @return an error code
+ */
+static int upipe_par_set_flow_def(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_par->subs, uchain) {
+        struct upipe_par_sub *sub = upipe_par_sub_from_uchain(uchain);
+        if (sub->worker != NULL)
+            UBASE_RETURN(upipe_set_flow_def(sub->worker, flow_def))
+    }
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    uref_free(upipe_par->flow_def_input);
+    upipe_par->flow_def_input = flow_def_dup;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a parallel pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_par_control(struct upipe *upipe, int command, va_list args)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(upipe_par_control_output(upipe, command, args));
+    UBASE_HANDLED_RETURN(upipe_par_control_subs(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_par_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_PAR_ADD_WORKER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_PAR_SIGNATURE)
+            struct upipe *worker = va_arg(args, struct upipe *);
+            return upipe_par_add_worker_internal(upipe, worker);
+        }
+        case UPIPE_PAR_GET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_PAR_SIGNATURE)
+            enum upipe_par_mode *mode_p = va_arg(args, enum upipe_par_mode *);
+            *mode_p = upipe_par->mode;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_PAR_SET_MODE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_PAR_SIGNATURE)
+            enum upipe_par_mode mode = va_arg(args, enum upipe_par_mode);
+            if (mode != UPIPE_PAR_ROUND_ROBIN &&
+                mode != UPIPE_PAR_LEAST_LOADED)
+                return UBASE_ERR_INVALID;
+            upipe_par->mode = mode;
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_par_free(struct upipe *upipe)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    uref_free(upipe_par->flow_def_input);
+    upipe_par_clean_sub_subs(upipe);
+    upipe_par_clean_output(upipe);
+    upipe_par_clean_urefcount_real(upipe);
+    upipe_par_clean_urefcount(upipe);
+    upipe_par_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ * The workers are released, so that they output their last frames.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_par_no_input(struct upipe *upipe)
+{
+    struct upipe_par *upipe_par = upipe_par_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+
+    /* the subpipes are kept alive until the pipe is freed */
+    upipe_par_use_urefcount_real(upipe);
+    ulist_delete_foreach (&upipe_par->subs, uchain, uchain_tmp) {
+        struct upipe_par_sub *sub = upipe_par_sub_from_uchain(uchain);
+        struct upipe *worker = sub->worker;
+        sub->worker = NULL;
+        upipe_release(worker);
+    }
+    upipe_par_release_urefcount_real(upipe);
+    upipe_par_release_urefcount_real(upipe);
+}
+
+/** parallel module manager static descriptor */
+static struct upipe_mgr upipe_par_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_PAR_SIGNATURE,
+
+    .upipe_alloc = upipe_par_alloc,
+    .upipe_input = upipe_par_input,
+    .upipe_control = upipe_par_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all parallel pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_par_mgr_alloc(void)
+{
+    return &upipe_par_mgr;
+}
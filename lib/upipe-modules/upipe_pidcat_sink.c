@@ -0,0 +1,462 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module - per-PID capture sink
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_flow.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe-modules/upipe_pidcat_sink.h"
+#include "upipe-modules/upipe_genaux.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+
+#ifndef O_CLOEXEC
+#   define O_CLOEXEC 0
+#endif
+
+#define EXPECTED_FLOW_DEF "block.mpegts."
+/** number of packets buffered per PID before writing */
+#define BUFFER_PACKETS 64
+
+/** @internal @This is the context of a PID of a pidcat sink. */
+struct upipe_pidcat_sink_pid {
+    /** data file descriptor */
+    int data_fd;
+    /** index file descriptor */
+    int index_fd;
+    /** number of buffered packets */
+    unsigned int nb;
+    /** buffered packets */
+    uint8_t data[BUFFER_PACKETS * UPIPE_PIDCAT_TS_SIZE];
+    /** buffered index records */
+    uint8_t index[BUFFER_PACKETS * UPIPE_PIDCAT_RECORD_SIZE];
+};
+
+/** @internal @This is the private context of a pidcat sink pipe. */
+struct upipe_pidcat_sink {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** directory path */
+    char *path;
+    /** number of the next packet in the multiplex */
+    uint64_t packet_nb;
+    /** contexts of the PIDs, allocated when the first packet is received */
+    struct upipe_pidcat_sink_pid *pids[UPIPE_PIDCAT_MAX_PIDS];
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_pidcat_sink, upipe, UPIPE_PIDCAT_SINK_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_pidcat_sink, urefcount, upipe_pidcat_sink_free)
+UPIPE_HELPER_VOID(upipe_pidcat_sink)
+
+/** @internal @This allocates a pidcat sink pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_pidcat_sink_alloc(struct upipe_mgr *mgr,
+                                             struct uprobe *uprobe,
+                                             uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_pidcat_sink_alloc_void(mgr, uprobe, signature,
+                                                       args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    upipe_pidcat_sink_init_urefcount(upipe);
+    upipe_pidcat_sink->path = NULL;
+    upipe_pidcat_sink->packet_nb = 0;
+    for (unsigned int i = 0; i < UPIPE_PIDCAT_MAX_PIDS; i++)
+        upipe_pidcat_sink->pids[i] = NULL;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This writes the buffered packets of a PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to write
+ */
+static void upipe_pidcat_sink_write_pid(struct upipe *upipe, unsigned int pid)
+{
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    struct upipe_pidcat_sink_pid *ctx = upipe_pidcat_sink->pids[pid];
+    if (ctx == NULL || !ctx->nb)
+        return;
+
+    /* the data is written first, so that the index never refers to missing
+     * packets */
+    size_t data_size = ctx->nb * UPIPE_PIDCAT_TS_SIZE;
+    size_t index_size = ctx->nb * UPIPE_PIDCAT_RECORD_SIZE;
+    ctx->nb = 0;
+    if (unlikely(write(ctx->data_fd, ctx->data, data_size) !=
+                 (ssize_t)data_size)) {
+        upipe_warn_va(upipe, "unable to write PID %u (%m)", pid);
+        return;
+    }
+    if (unlikely(write(ctx->index_fd, ctx->index, index_size) !=
+                 (ssize_t)index_size))
+        upipe_warn_va(upipe, "unable to write index of PID %u (%m)", pid);
+}
+
+/** @internal @This opens the files of a PID. If a previous capture was
+ * interrupted between the writes of the data and of the index, the longer
+ * file is truncated.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to open
+ * @return pointer to the context of the PID, or NULL in case of error
+ */
+static struct upipe_pidcat_sink_pid *
+    upipe_pidcat_sink_open_pid(struct upipe *upipe, unsigned int pid)
+{
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    struct upipe_pidcat_sink_pid *ctx =
+        malloc(sizeof(struct upipe_pidcat_sink_pid));
+    if (unlikely(ctx == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+    ctx->nb = 0;
+
+    char path[MAXPATHLEN];
+    snprintf(path, sizeof(path), "%s/%u" UPIPE_PIDCAT_DATA_SUFFIX,
+             upipe_pidcat_sink->path, pid);
+    ctx->data_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                        0644);
+    if (unlikely(ctx->data_fd == -1)) {
+        upipe_err_va(upipe, "unable to open %s (%m)", path);
+        free(ctx);
+        return NULL;
+    }
+    snprintf(path, sizeof(path), "%s/%u" UPIPE_PIDCAT_INDEX_SUFFIX,
+             upipe_pidcat_sink->path, pid);
+    ctx->index_fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                         0644);
+    if (unlikely(ctx->index_fd == -1)) {
+        upipe_err_va(upipe, "unable to open %s (%m)", path);
+        close(ctx->data_fd);
+        free(ctx);
+        return NULL;
+    }
+
+    struct stat data_st, index_st;
+    if (likely(fstat(ctx->data_fd, &data_st) != -1 &&
+               fstat(ctx->index_fd, &index_st) != -1)) {
+        uint64_t nb_data = data_st.st_size / UPIPE_PIDCAT_TS_SIZE;
+        uint64_t nb_index = index_st.st_size / UPIPE_PIDCAT_RECORD_SIZE;
+        uint64_t nb = nb_data < nb_index ? nb_data : nb_index;
+        if (unlikely(nb * UPIPE_PIDCAT_TS_SIZE != data_st.st_size ||
+                     nb * UPIPE_PIDCAT_RECORD_SIZE != index_st.st_size)) {
+            upipe_warn_va(upipe, "truncating PID %u to %"PRIu64" packets",
+                          pid, nb);
+            if (unlikely(ftruncate(ctx->data_fd,
+                                   nb * UPIPE_PIDCAT_TS_SIZE) == -1 ||
+                         ftruncate(ctx->index_fd,
+                                   nb * UPIPE_PIDCAT_RECORD_SIZE) == -1))
+                upipe_warn_va(upipe, "unable to truncate PID %u (%m)", pid);
+        }
+    }
+
+    upipe_pidcat_sink->pids[pid] = ctx;
+    return ctx;
+}
+
+/** @internal @This writes and closes the files of all PIDs.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_pidcat_sink_close(struct upipe *upipe)
+{
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    for (unsigned int pid = 0; pid < UPIPE_PIDCAT_MAX_PIDS; pid++) {
+        struct upipe_pidcat_sink_pid *ctx = upipe_pidcat_sink->pids[pid];
+        if (ctx == NULL)
+            continue;
+        upipe_pidcat_sink_write_pid(upipe, pid);
+        close(ctx->data_fd);
+        close(ctx->index_fd);
+        free(ctx);
+        upipe_pidcat_sink->pids[pid] = NULL;
+    }
+    ubase_clean_str(&upipe_pidcat_sink->path);
+    upipe_pidcat_sink->packet_nb = 0;
+}
+
+/** @internal @This finds the number of the next packet of an existing
+ * capture, from the last record of each index.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_pidcat_sink_scan(struct upipe *upipe)
+{
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    DIR *dir = opendir(upipe_pidcat_sink->path);
+    if (unlikely(dir == NULL))
+        return;
+
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        char *end;
+        unsigned long pid = strtoul(dirent->d_name, &end, 10);
+        if (end == dirent->d_name || pid >= UPIPE_PIDCAT_MAX_PIDS ||
+            strcmp(end, UPIPE_PIDCAT_INDEX_SUFFIX))
+            continue;
+
+        char path[MAXPATHLEN];
+        snprintf(path, sizeof(path), "%s/%s", upipe_pidcat_sink->path,
+                 dirent->d_name);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (unlikely(fd == -1))
+            continue;
+        struct stat st;
+        uint8_t record[UPIPE_PIDCAT_RECORD_SIZE];
+        if (fstat(fd, &st) != -1 &&
+            st.st_size >= UPIPE_PIDCAT_RECORD_SIZE &&
+            pread(fd, record, UPIPE_PIDCAT_RECORD_SIZE,
+                  (st.st_size / UPIPE_PIDCAT_RECORD_SIZE - 1) *
+                  UPIPE_PIDCAT_RECORD_SIZE) == UPIPE_PIDCAT_RECORD_SIZE) {
+            uint64_t packet_nb = upipe_genaux_ntoh64(record + 8) + 1;
+            if (packet_nb > upipe_pidcat_sink->packet_nb)
+                upipe_pidcat_sink->packet_nb = packet_nb;
+        }
+        close(fd);
+    }
+    closedir(dir);
+}
+
+/** @internal @This handles data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_pidcat_sink_input(struct upipe *upipe, struct uref *uref,
+                                    struct upump **upump_p)
+{
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    uint64_t cr_sys;
+    size_t size;
+    if (unlikely(upipe_pidcat_sink->path == NULL)) {
+        upipe_warn(upipe, "received a buffer before opening a directory");
+        uref_free(uref);
+        return;
+    }
+    if (unlikely(!ubase_check(uref_clock_get_cr_sys(uref, &cr_sys)))) {
+        upipe_warn(upipe, "uref has no cr_sys, dropping");
+        uref_free(uref);
+        return;
+    }
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        upipe_warn(upipe, "unable to read uref");
+        uref_free(uref);
+        return;
+    }
+    if (unlikely(size % UPIPE_PIDCAT_TS_SIZE))
+        upipe_warn_va(upipe, "dropping %zu trailing octets",
+                      size % UPIPE_PIDCAT_TS_SIZE);
+
+    for (size_t offset = 0; offset + UPIPE_PIDCAT_TS_SIZE <= size;
+         offset += UPIPE_PIDCAT_TS_SIZE) {
+        uint8_t buffer[UPIPE_PIDCAT_TS_SIZE];
+        const uint8_t *ts = uref_block_peek(uref, offset,
+                                            UPIPE_PIDCAT_TS_SIZE, buffer);
+        if (unlikely(ts == NULL)) {
+            upipe_warn(upipe, "unable to read TS packet");
+            break;
+        }
+        if (unlikely(ts[0] != 0x47)) {
+            upipe_warn(upipe, "invalid TS packet");
+            uref_block_peek_unmap(uref, offset, buffer, ts);
+            continue;
+        }
+
+        unsigned int pid = ((ts[1] & 0x1f) << 8) | ts[2];
+        struct upipe_pidcat_sink_pid *ctx = upipe_pidcat_sink->pids[pid];
+        if (unlikely(ctx == NULL) &&
+            unlikely((ctx = upipe_pidcat_sink_open_pid(upipe, pid)) == NULL)) {
+            uref_block_peek_unmap(uref, offset, buffer, ts);
+            continue;
+        }
+
+        memcpy(ctx->data + ctx->nb * UPIPE_PIDCAT_TS_SIZE, ts,
+               UPIPE_PIDCAT_TS_SIZE);
+        uref_block_peek_unmap(uref, offset, buffer, ts);
+        uint8_t *record = ctx->index + ctx->nb * UPIPE_PIDCAT_RECORD_SIZE;
+        upipe_genaux_hton64(record, cr_sys);
+        upipe_genaux_hton64(record + 8, upipe_pidcat_sink->packet_nb++);
+        if (++ctx->nb == BUFFER_PACKETS)
+            upipe_pidcat_sink_write_pid(upipe, pid);
+    }
+    uref_free(uref);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_pidcat_sink_set_flow_def(struct upipe *upipe,
+                                          struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the path of the currently opened directory.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri_p filled in with the path of the directory
+ * @return an error code
+ */
+static int upipe_pidcat_sink_get_uri(struct upipe *upipe, const char **uri_p)
+{
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    *uri_p = upipe_pidcat_sink->path;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This asks to open the given directory.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri path of the directory, or NULL to close the capture
+ * @return an error code
+ */
+static int upipe_pidcat_sink_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_pidcat_sink *upipe_pidcat_sink =
+        upipe_pidcat_sink_from_upipe(upipe);
+    upipe_pidcat_sink_close(upipe);
+    if (uri == NULL)
+        return UBASE_ERR_NONE;
+
+    if (unlikely(mkdir(uri, 0755) == -1 && errno != EEXIST)) {
+        upipe_err_va(upipe, "unable to create directory %s (%m)", uri);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_pidcat_sink->path = strdup(uri);
+    if (unlikely(upipe_pidcat_sink->path == NULL))
+        return UBASE_ERR_ALLOC;
+    upipe_pidcat_sink_scan(upipe);
+    upipe_notice_va(upipe, "capturing to %s from packet %"PRIu64,
+                    uri, upipe_pidcat_sink->packet_nb);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a pidcat sink pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_pidcat_sink_control(struct upipe *upipe, int command,
+                                     va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_pidcat_sink_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            return upipe_pidcat_sink_get_uri(upipe, uri_p);
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_pidcat_sink_set_uri(upipe, uri);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_pidcat_sink_free(struct upipe *upipe)
+{
+    upipe_pidcat_sink_close(upipe);
+    upipe_throw_dead(upipe);
+    upipe_pidcat_sink_clean_urefcount(upipe);
+    upipe_pidcat_sink_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_pidcat_sink_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_PIDCAT_SINK_SIGNATURE,
+
+    .upipe_alloc = upipe_pidcat_sink_alloc,
+    .upipe_input = upipe_pidcat_sink_input,
+    .upipe_control = upipe_pidcat_sink_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all pidcat sink pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_pidcat_sink_mgr_alloc(void)
+{
+    return &upipe_pidcat_sink_mgr;
+}
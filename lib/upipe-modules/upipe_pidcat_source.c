@@ -0,0 +1,705 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module - per-PID capture source
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uprobe.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_clock.h"
+#include "upipe/ubuf.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_uref_mgr.h"
+#include "upipe/upipe_helper_ubuf_mgr.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_upump_mgr.h"
+#include "upipe/upipe_helper_upump.h"
+#include "upipe/upipe_helper_output_size.h"
+#include "upipe-modules/upipe_pidcat_source.h"
+#include "upipe-modules/upipe_pidcat_sink.h"
+#include "upipe-modules/upipe_genaux.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+
+#ifndef O_CLOEXEC
+#   define O_CLOEXEC 0
+#endif
+
+/** default size of output buffers (7 TS packets) */
+#define DEFAULT_OUTPUT_SIZE (7 * UPIPE_PIDCAT_TS_SIZE)
+/** number of packets read at once per PID */
+#define BUFFER_PACKETS 64
+
+/** @hidden */
+static int upipe_pidcat_src_check(struct upipe *upipe,
+                                  struct uref *flow_format);
+
+/** @internal @This is the context of a read PID of a pidcat source. */
+struct upipe_pidcat_src_pid {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** PID */
+    unsigned int pid;
+    /** data file descriptor */
+    int data_fd;
+    /** index file descriptor */
+    int index_fd;
+    /** number of the packet following the buffered ones in the files */
+    uint64_t next;
+    /** number of buffered packets */
+    unsigned int nb;
+    /** position of the next packet in the buffers */
+    unsigned int pos;
+    /** buffered packets */
+    uint8_t data[BUFFER_PACKETS * UPIPE_PIDCAT_TS_SIZE];
+    /** buffered index records */
+    uint8_t index[BUFFER_PACKETS * UPIPE_PIDCAT_RECORD_SIZE];
+};
+
+UBASE_FROM_TO(upipe_pidcat_src_pid, uchain, uchain, uchain)
+
+/** @internal @This is the private context of a pidcat source pipe. */
+struct upipe_pidcat_src {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** read idler */
+    struct upump *upump;
+    /** output size */
+    unsigned int output_size;
+
+    /** directory path */
+    char *path;
+    /** true if the PID is to be read */
+    bool selected[UPIPE_PIDCAT_MAX_PIDS];
+    /** number of selected PIDs, 0 for all */
+    unsigned int nb_selected;
+    /** list of opened PIDs */
+    struct uchain pids;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_pidcat_src, upipe, UPIPE_PIDCAT_SRC_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_pidcat_src, urefcount, upipe_pidcat_src_free)
+UPIPE_HELPER_VOID(upipe_pidcat_src)
+
+UPIPE_HELPER_OUTPUT(upipe_pidcat_src, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UREF_MGR(upipe_pidcat_src, uref_mgr, uref_mgr_request,
+                      upipe_pidcat_src_check,
+                      upipe_pidcat_src_register_output_request,
+                      upipe_pidcat_src_unregister_output_request)
+UPIPE_HELPER_UBUF_MGR(upipe_pidcat_src, ubuf_mgr, flow_format,
+                      ubuf_mgr_request, upipe_pidcat_src_check,
+                      upipe_pidcat_src_register_output_request,
+                      upipe_pidcat_src_unregister_output_request)
+UPIPE_HELPER_UPUMP_MGR(upipe_pidcat_src, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_pidcat_src, upump, upump_mgr)
+UPIPE_HELPER_OUTPUT_SIZE(upipe_pidcat_src, output_size)
+
+/** @internal @This allocates a pidcat source pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_pidcat_src_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_pidcat_src_alloc_void(mgr, uprobe, signature,
+                                                      args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    upipe_pidcat_src_init_urefcount(upipe);
+    upipe_pidcat_src_init_uref_mgr(upipe);
+    upipe_pidcat_src_init_ubuf_mgr(upipe);
+    upipe_pidcat_src_init_output(upipe);
+    upipe_pidcat_src_init_upump_mgr(upipe);
+    upipe_pidcat_src_init_upump(upipe);
+    upipe_pidcat_src_init_output_size(upipe, DEFAULT_OUTPUT_SIZE);
+    upipe_pidcat_src->path = NULL;
+    memset(upipe_pidcat_src->selected, 0, sizeof(upipe_pidcat_src->selected));
+    upipe_pidcat_src->nb_selected = 0;
+    ulist_init(&upipe_pidcat_src->pids);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This reads the next packets of a PID if its buffers are
+ * empty.
+ *
+ * @param upipe description structure of the pipe
+ * @param ctx context of the PID
+ * @return false at the end of the PID
+ */
+static bool upipe_pidcat_src_fill(struct upipe *upipe,
+                                  struct upipe_pidcat_src_pid *ctx)
+{
+    if (ctx->pos < ctx->nb)
+        return true;
+
+    ctx->pos = ctx->nb = 0;
+    ssize_t index_size = pread(ctx->index_fd, ctx->index, sizeof(ctx->index),
+                               ctx->next * UPIPE_PIDCAT_RECORD_SIZE);
+    if (index_size < UPIPE_PIDCAT_RECORD_SIZE)
+        return false;
+    ssize_t data_size = pread(ctx->data_fd, ctx->data,
+            (index_size / UPIPE_PIDCAT_RECORD_SIZE) * UPIPE_PIDCAT_TS_SIZE,
+            ctx->next * UPIPE_PIDCAT_TS_SIZE);
+    if (data_size < UPIPE_PIDCAT_TS_SIZE) {
+        if (data_size == -1)
+            upipe_warn_va(upipe, "unable to read PID %u (%m)", ctx->pid);
+        return false;
+    }
+    ctx->nb = data_size / UPIPE_PIDCAT_TS_SIZE;
+    ctx->next += ctx->nb;
+    return true;
+}
+
+/** @internal @This returns the PID holding the next packet of the
+ * multiplex.
+ *
+ * @param upipe description structure of the pipe
+ * @return context of the PID, or NULL at the end of the capture
+ */
+static struct upipe_pidcat_src_pid *upipe_pidcat_src_next(struct upipe *upipe)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    struct upipe_pidcat_src_pid *next = NULL;
+    uint64_t next_nb = UINT64_MAX;
+    struct uchain *uchain;
+    ulist_foreach (&upipe_pidcat_src->pids, uchain) {
+        struct upipe_pidcat_src_pid *ctx =
+            upipe_pidcat_src_pid_from_uchain(uchain);
+        if (!upipe_pidcat_src_fill(upipe, ctx))
+            continue;
+        uint64_t nb = upipe_genaux_ntoh64(ctx->index +
+                ctx->pos * UPIPE_PIDCAT_RECORD_SIZE + 8);
+        if (nb < next_nb) {
+            next = ctx;
+            next_nb = nb;
+        }
+    }
+    return next;
+}
+
+/** @internal @This returns the cr_sys of the next packet of a PID.
+ *
+ * @param ctx context of the PID, with buffered packets
+ * @return cr_sys of the packet
+ */
+static inline uint64_t
+    upipe_pidcat_src_pid_cr_sys(struct upipe_pidcat_src_pid *ctx)
+{
+    return upipe_genaux_ntoh64(ctx->index +
+                               ctx->pos * UPIPE_PIDCAT_RECORD_SIZE);
+}
+
+/** @internal @This outputs the next packets sharing the same cr_sys.
+ *
+ * @param upump description structure of the idler
+ */
+static void upipe_pidcat_src_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+
+    struct upipe_pidcat_src_pid *ctx = upipe_pidcat_src_next(upipe);
+    if (ctx == NULL) {
+        upipe_notice_va(upipe, "end of capture %s", upipe_pidcat_src->path);
+        upipe_pidcat_src_set_upump(upipe, NULL);
+        upipe_throw_source_end(upipe);
+        return;
+    }
+
+    struct uref *uref = uref_block_alloc(upipe_pidcat_src->uref_mgr,
+                                         upipe_pidcat_src->ubuf_mgr,
+                                         upipe_pidcat_src->output_size);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &size, &buffer)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    uint64_t cr_sys = upipe_pidcat_src_pid_cr_sys(ctx);
+    int offset = 0;
+    do {
+        memcpy(buffer + offset, ctx->data + ctx->pos * UPIPE_PIDCAT_TS_SIZE,
+               UPIPE_PIDCAT_TS_SIZE);
+        offset += UPIPE_PIDCAT_TS_SIZE;
+        ctx->pos++;
+    } while (offset + UPIPE_PIDCAT_TS_SIZE <= size &&
+             (ctx = upipe_pidcat_src_next(upipe)) != NULL &&
+             upipe_pidcat_src_pid_cr_sys(ctx) == cr_sys);
+
+    uref_block_unmap(uref, 0);
+    if (offset != size)
+        uref_block_resize(uref, 0, offset);
+    uref_clock_set_cr_sys(uref, cr_sys);
+    upipe_pidcat_src_output(upipe, uref, &upipe_pidcat_src->upump);
+}
+
+/** @internal @This builds the flow definition.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_pidcat_src_build_flow_def(struct upipe *upipe)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    if (upipe_pidcat_src->uref_mgr == NULL)
+        return;
+    struct uref *flow_def =
+        uref_block_flow_alloc_def(upipe_pidcat_src->uref_mgr, "mpegts.");
+    if (unlikely(flow_def == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uref_block_flow_set_size(flow_def, upipe_pidcat_src->output_size);
+    upipe_pidcat_src_require_ubuf_mgr(upipe, flow_def);
+}
+
+/** @internal @This checks if the pump may be allocated.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_pidcat_src_check(struct upipe *upipe,
+                                  struct uref *flow_format)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    if (flow_format != NULL)
+        upipe_pidcat_src_store_flow_def(upipe, flow_format);
+
+    upipe_pidcat_src_check_upump_mgr(upipe);
+    if (upipe_pidcat_src->upump_mgr == NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_pidcat_src->uref_mgr == NULL) {
+        upipe_pidcat_src_require_uref_mgr(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    if (upipe_pidcat_src->ubuf_mgr == NULL) {
+        if (urequest_get_opaque(&upipe_pidcat_src->ubuf_mgr_request,
+                                struct upipe *) == NULL)
+            upipe_pidcat_src_build_flow_def(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    if (upipe_pidcat_src->path != NULL && upipe_pidcat_src->upump == NULL) {
+        struct upump *upump = upump_alloc_idler(upipe_pidcat_src->upump_mgr,
+                                                upipe_pidcat_src_worker,
+                                                upipe, upipe->refcount);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_pidcat_src_set_upump(upipe, upump);
+        upump_start(upump);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This opens the files of a PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to open
+ * @return an error code
+ */
+static int upipe_pidcat_src_open_pid(struct upipe *upipe, unsigned int pid)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_pidcat_src->pids, uchain) {
+        if (upipe_pidcat_src_pid_from_uchain(uchain)->pid == pid)
+            return UBASE_ERR_NONE;
+    }
+
+    struct upipe_pidcat_src_pid *ctx =
+        malloc(sizeof(struct upipe_pidcat_src_pid));
+    if (unlikely(ctx == NULL))
+        return UBASE_ERR_ALLOC;
+    ctx->pid = pid;
+    ctx->next = 0;
+    ctx->nb = ctx->pos = 0;
+
+    char path[MAXPATHLEN];
+    snprintf(path, sizeof(path), "%s/%u" UPIPE_PIDCAT_DATA_SUFFIX,
+             upipe_pidcat_src->path, pid);
+    ctx->data_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (unlikely(ctx->data_fd == -1)) {
+        upipe_err_va(upipe, "unable to open %s (%m)", path);
+        free(ctx);
+        return UBASE_ERR_EXTERNAL;
+    }
+    snprintf(path, sizeof(path), "%s/%u" UPIPE_PIDCAT_INDEX_SUFFIX,
+             upipe_pidcat_src->path, pid);
+    ctx->index_fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (unlikely(ctx->index_fd == -1)) {
+        upipe_err_va(upipe, "unable to open %s (%m)", path);
+        close(ctx->data_fd);
+        free(ctx);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    ulist_add(&upipe_pidcat_src->pids, upipe_pidcat_src_pid_to_uchain(ctx));
+    upipe_dbg_va(upipe, "reading PID %u", pid);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This closes the capture.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_pidcat_src_close(struct upipe *upipe)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_pidcat_src->pids, uchain, uchain_tmp) {
+        struct upipe_pidcat_src_pid *ctx =
+            upipe_pidcat_src_pid_from_uchain(uchain);
+        ulist_delete(uchain);
+        close(ctx->data_fd);
+        close(ctx->index_fd);
+        free(ctx);
+    }
+    if (upipe_pidcat_src->path != NULL)
+        upipe_notice_va(upipe, "closing capture %s", upipe_pidcat_src->path);
+    ubase_clean_str(&upipe_pidcat_src->path);
+    upipe_pidcat_src_set_upump(upipe, NULL);
+}
+
+/** @internal @This asks to open the given capture.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri path of the directory
+ * @return an error code
+ */
+static int upipe_pidcat_src_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    upipe_pidcat_src_close(upipe);
+    if (uri == NULL)
+        return UBASE_ERR_NONE;
+
+    DIR *dir = opendir(uri);
+    if (unlikely(dir == NULL)) {
+        upipe_err_va(upipe, "unable to open capture %s (%m)", uri);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_pidcat_src->path = strdup(uri);
+    if (unlikely(upipe_pidcat_src->path == NULL)) {
+        closedir(dir);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_notice_va(upipe, "opening capture %s", uri);
+
+    struct dirent *dirent;
+    while ((dirent = readdir(dir)) != NULL) {
+        char *end;
+        unsigned long pid = strtoul(dirent->d_name, &end, 10);
+        if (end == dirent->d_name || pid >= UPIPE_PIDCAT_MAX_PIDS ||
+            strcmp(end, UPIPE_PIDCAT_INDEX_SUFFIX) ||
+            (upipe_pidcat_src->nb_selected &&
+             !upipe_pidcat_src->selected[pid]))
+            continue;
+        upipe_pidcat_src_open_pid(upipe, pid);
+    }
+    closedir(dir);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This adds a PID to the list of PIDs to read.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to read
+ * @return an error code
+ */
+static int _upipe_pidcat_src_add_pid(struct upipe *upipe, unsigned int pid)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    if (unlikely(pid >= UPIPE_PIDCAT_MAX_PIDS))
+        return UBASE_ERR_INVALID;
+    if (upipe_pidcat_src->selected[pid])
+        return UBASE_ERR_NONE;
+
+    if (upipe_pidcat_src->path != NULL && !upipe_pidcat_src->nb_selected) {
+        /* all PIDs were opened, only keep this one */
+        struct uchain *uchain, *uchain_tmp;
+        ulist_delete_foreach (&upipe_pidcat_src->pids, uchain, uchain_tmp) {
+            struct upipe_pidcat_src_pid *ctx =
+                upipe_pidcat_src_pid_from_uchain(uchain);
+            if (ctx->pid == pid)
+                continue;
+            ulist_delete(uchain);
+            close(ctx->data_fd);
+            close(ctx->index_fd);
+            free(ctx);
+        }
+    }
+    upipe_pidcat_src->selected[pid] = true;
+    upipe_pidcat_src->nb_selected++;
+    if (upipe_pidcat_src->path != NULL)
+        return upipe_pidcat_src_open_pid(upipe, pid);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the cr_sys of the next packet to output.
+ *
+ * @param upipe description structure of the pipe
+ * @param position_p filled in with the cr_sys of the next packet
+ * @return an error code
+ */
+static int _upipe_pidcat_src_get_position(struct upipe *upipe,
+                                          uint64_t *position_p)
+{
+    struct upipe_pidcat_src_pid *ctx = upipe_pidcat_src_next(upipe);
+    if (ctx == NULL)
+        return UBASE_ERR_INVALID;
+    *position_p = upipe_pidcat_src_pid_cr_sys(ctx);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This asks to read from the first packets at or after the given
+ * cr_sys, with a binary search in the index of each PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param position cr_sys to read from
+ * @return an error code
+ */
+static int _upipe_pidcat_src_set_position(struct upipe *upipe,
+                                          uint64_t position)
+{
+    struct upipe_pidcat_src *upipe_pidcat_src =
+        upipe_pidcat_src_from_upipe(upipe);
+    if (unlikely(upipe_pidcat_src->path == NULL))
+        return UBASE_ERR_UNHANDLED;
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_pidcat_src->pids, uchain) {
+        struct upipe_pidcat_src_pid *ctx =
+            upipe_pidcat_src_pid_from_uchain(uchain);
+        struct stat st;
+        if (unlikely(fstat(ctx->index_fd, &st) == -1))
+            return UBASE_ERR_EXTERNAL;
+
+        uint64_t low = 0, high = st.st_size / UPIPE_PIDCAT_RECORD_SIZE;
+        while (low < high) {
+            uint64_t middle = low + (high - low) / 2;
+            uint8_t cr_sys[8];
+            if (unlikely(pread(ctx->index_fd, cr_sys, sizeof(cr_sys),
+                               middle * UPIPE_PIDCAT_RECORD_SIZE) !=
+                         sizeof(cr_sys)))
+                return UBASE_ERR_EXTERNAL;
+            if (upipe_genaux_ntoh64(cr_sys) < position)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        ctx->next = low;
+        ctx->nb = ctx->pos = 0;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a pidcat source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int _upipe_pidcat_src_control(struct upipe *upipe, int command,
+                                     va_list args)
+{
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_pidcat_src_set_upump(upipe, NULL);
+            return upipe_pidcat_src_attach_upump_mgr(upipe);
+
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_pidcat_src_control_output(upipe, command, args);
+
+        case UPIPE_GET_OUTPUT_SIZE:
+            return upipe_pidcat_src_control_output_size(upipe, command, args);
+        case UPIPE_SET_OUTPUT_SIZE: {
+            unsigned int output_size = va_arg(args, unsigned int);
+            if (unlikely(output_size < UPIPE_PIDCAT_TS_SIZE))
+                return UBASE_ERR_INVALID;
+            UBASE_RETURN(upipe_pidcat_src_set_output_size(upipe, output_size))
+            upipe_pidcat_src_build_flow_def(upipe);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_GET_URI: {
+            struct upipe_pidcat_src *upipe_pidcat_src =
+                upipe_pidcat_src_from_upipe(upipe);
+            const char **uri_p = va_arg(args, const char **);
+            *uri_p = upipe_pidcat_src->path;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_pidcat_src_set_uri(upipe, uri);
+        }
+
+        case UPIPE_SRC_GET_POSITION: {
+            uint64_t *position_p = va_arg(args, uint64_t *);
+            return _upipe_pidcat_src_get_position(upipe, position_p);
+        }
+        case UPIPE_SRC_SET_POSITION: {
+            uint64_t position = va_arg(args, uint64_t);
+            return _upipe_pidcat_src_set_position(upipe, position);
+        }
+
+        case UPIPE_PIDCAT_SRC_ADD_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_PIDCAT_SRC_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            return _upipe_pidcat_src_add_pid(upipe, pid);
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes control commands on a pidcat source pipe, and
+ * checks the status of the pipe afterwards.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_pidcat_src_control(struct upipe *upipe, int command,
+                                    va_list args)
+{
+    UBASE_RETURN(_upipe_pidcat_src_control(upipe, command, args))
+
+    return upipe_pidcat_src_check(upipe, NULL);
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_pidcat_src_free(struct upipe *upipe)
+{
+    upipe_pidcat_src_close(upipe);
+    upipe_throw_dead(upipe);
+
+    upipe_pidcat_src_clean_output_size(upipe);
+    upipe_pidcat_src_clean_upump(upipe);
+    upipe_pidcat_src_clean_upump_mgr(upipe);
+    upipe_pidcat_src_clean_output(upipe);
+    upipe_pidcat_src_clean_ubuf_mgr(upipe);
+    upipe_pidcat_src_clean_uref_mgr(upipe);
+    upipe_pidcat_src_clean_urefcount(upipe);
+    upipe_pidcat_src_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_pidcat_src_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_PIDCAT_SRC_SIGNATURE,
+
+    .upipe_alloc = upipe_pidcat_src_alloc,
+    .upipe_input = NULL,
+    .upipe_control = upipe_pidcat_src_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all pidcat source pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_pidcat_src_mgr_alloc(void)
+{
+    return &upipe_pidcat_src_mgr;
+}
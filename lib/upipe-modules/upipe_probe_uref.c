@@ -64,23 +64,37 @@ UPIPE_HELPER_UREFCOUNT(upipe_probe_uref, urefcount, upipe_probe_uref_free)
 UPIPE_HELPER_VOID(upipe_probe_uref)
 UPIPE_HELPER_OUTPUT(upipe_probe_uref, output, flow_def, output_state, request_list);
 
-/** @internal @This handles urefs (data & flows).
+/** @internal @This processes a uref in place.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref was dropped
  */
-static void upipe_probe_uref_input(struct upipe *upipe, struct uref *uref,
-                                   struct upump **upump_p)
+static bool upipe_probe_uref_process(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
 {
     bool drop = false;
     upipe_throw(upipe, UPROBE_PROBE_UREF, UPIPE_PROBE_UREF_SIGNATURE, uref,
                 upump_p, &drop);
     if (drop) {
         uref_free(uref);
-    } else {
-        upipe_probe_uref_output(upipe, uref, upump_p);
+        return false;
     }
+    return true;
+}
+
+/** @internal @This handles urefs (data & flows).
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_probe_uref_input(struct upipe *upipe, struct uref *uref,
+                                   struct upump **upump_p)
+{
+    if (upipe_probe_uref_process(upipe, uref, upump_p))
+        upipe_probe_uref_output(upipe, uref, upump_p);
 }
 
 /** @internal @This sets the input flow definition.
@@ -118,6 +132,12 @@ static int upipe_probe_uref_control(struct upipe *upipe,
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_probe_uref_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_GET_PROCESS: {
+            upipe_process_func *process_p =
+                va_arg(args, upipe_process_func *);
+            *process_p = upipe_probe_uref_process;
+            return UBASE_ERR_NONE;
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
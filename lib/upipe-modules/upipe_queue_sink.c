@@ -33,6 +33,7 @@
 #include "upipe/uprobe.h"
 #include "upipe/uref.h"
 #include "upipe/upump.h"
+#include "upipe/upipe_stats.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
 #include "upipe/upipe_helper_upump_mgr.h"
@@ -515,6 +516,15 @@ static int _upipe_qsink_control(struct upipe *upipe, int command, va_list args)
 
         case UPIPE_FLUSH:
             return upipe_qsink_flush(upipe);
+        case UPIPE_GET_STATS: {
+            struct upipe_qsink *upipe_qsink = upipe_qsink_from_upipe(upipe);
+            struct upipe_stats *stats = va_arg(args, struct upipe_stats *);
+            stats->queue_length = upipe_qsink->nb_urefs;
+            if (upipe_qsink->qsrc != NULL)
+                stats->queue_length +=
+                    uqueue_length(&upipe_queue(upipe_qsink->qsrc)->uqueue);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -28,7 +28,7 @@
  *
  * Note that the allocator requires an additional parameter:
  * @table 2
- * @item queue_length @item maximum length of the queue (<= 255)
+ * @item queue_length @item maximum length of the queue (<= 65536)
  * @end table
  *
  * Also note that this module is exceptional in that upipe_release() may be
@@ -39,6 +39,9 @@
 #include "upipe/uprobe.h"
 #include "upipe/uref.h"
 #include "upipe/upump.h"
+#include "upipe/uclock.h"
+#include "upipe/uclock_std.h"
+#include "upipe/upipe_stats.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
 #include "upipe/upipe_helper_output.h"
@@ -55,6 +58,8 @@
 
 /** maximum length of out of band queues */
 #define OOB_QUEUES 255
+/** number of urefs popped at once from the queue */
+#define UPIPE_QSRC_POP_CHUNK 16
 
 /** @internal @This is the private context of a queue source pipe. */
 struct upipe_qsrc {
@@ -77,6 +82,13 @@ struct upipe_qsrc {
     /** list of output requests */
     struct uchain request_list;
 
+    /** maximum number of urefs output per wake-up */
+    unsigned int batch_size;
+    /** maximum time spent outputting urefs per wake-up, or 0 */
+    uint64_t batch_duration;
+    /** clock used to enforce batch_duration */
+    struct uclock *uclock;
+
     /** structure exported to the sinks */
     struct upipe_queue upipe_queue;
 
@@ -108,7 +120,7 @@ static struct upipe *_upipe_qsrc_alloc(struct upipe_mgr *mgr,
     if (signature != UPIPE_QSRC_SIGNATURE)
         goto upipe_qsrc_alloc_err;
     unsigned int length = va_arg(args, unsigned int);
-    if (!length || length > UINT8_MAX)
+    if (!length || length > UMPMC_MAX_LENGTH)
         goto upipe_qsrc_alloc_err;
 
     struct upipe_qsrc *upipe_qsrc = malloc(sizeof(struct upipe_qsrc) +
@@ -137,6 +149,9 @@ static struct upipe *_upipe_qsrc_alloc(struct upipe_mgr *mgr,
     upipe_qsrc_init_upump(upipe);
     upipe_qsrc_init_upump_oob(upipe);
     upipe_qsrc->upipe_queue.max_length = length;
+    upipe_qsrc->batch_size = 1;
+    upipe_qsrc->batch_duration = 0;
+    upipe_qsrc->uclock = NULL;
     upipe_throw_ready(upipe);
 
     return upipe;
@@ -164,7 +179,9 @@ static void upipe_qsrc_input(struct upipe *upipe, struct uref *uref,
     upipe_qsrc_output(upipe, uref, upump_p);
 }
 
-/** @internal @This reads data from the queue and outputs it.
+/** @internal @This reads data from the queue and outputs it. Up to
+ * batch_size urefs are output per wake-up, unless batch_duration is
+ * exhausted first.
  *
  * @param upump description structure of the read watcher
  */
@@ -172,9 +189,27 @@ static void upipe_qsrc_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
-    struct uref *uref = uqueue_pop(&upipe_queue(upipe)->uqueue, struct uref *);
-    if (likely(uref != NULL))
-        upipe_qsrc_input(upipe, uref, &upipe_qsrc->upump);
+    unsigned int remaining = upipe_qsrc->batch_size;
+    uint64_t deadline = UINT64_MAX;
+    if (upipe_qsrc->uclock != NULL)
+        deadline = uclock_now(upipe_qsrc->uclock) + upipe_qsrc->batch_duration;
+
+    while (remaining) {
+        struct uref *urefs[UPIPE_QSRC_POP_CHUNK];
+        unsigned int nb = remaining < UPIPE_QSRC_POP_CHUNK ?
+                          remaining : UPIPE_QSRC_POP_CHUNK;
+        nb = uqueue_pop_batch(&upipe_queue(upipe)->uqueue, (void **)urefs, nb);
+        if (!nb)
+            break;
+
+        for (unsigned int i = 0; i < nb; i++)
+            upipe_qsrc_input(upipe, urefs[i], &upipe_qsrc->upump);
+        remaining -= nb;
+
+        if (remaining && deadline != UINT64_MAX &&
+            uclock_now(upipe_qsrc->uclock) >= deadline)
+            break;
+    }
 }
 
 /** @internal @This handles the result of a request.
@@ -301,6 +336,7 @@ static void upipe_qsrc_ref_end(struct upipe *upipe)
     upipe_qsrc_clean_upump_oob(upipe);
     upipe_qsrc_clean_upump_mgr(upipe);
     upipe_qsrc_clean_output(upipe);
+    uclock_release(upipe_qsrc_from_upipe(upipe)->uclock);
 
     uqueue_clean(&upipe_queue(upipe)->uqueue);
     uqueue_clean(&upipe_queue(upipe)->downstream_oob);
@@ -377,6 +413,66 @@ static int _upipe_qsrc_get_length(struct upipe *upipe, unsigned int *length_p)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the maximum amount of work done per wake-up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of urefs output per wake-up (>= 1)
+ * @param batch_duration maximum time spent per wake-up, in 27 MHz units,
+ * or 0 for no limit
+ * @return an error code
+ */
+static int _upipe_qsrc_set_batch(struct upipe *upipe, unsigned int batch_size,
+                                 uint64_t batch_duration)
+{
+    struct upipe_qsrc *upipe_qsrc = upipe_qsrc_from_upipe(upipe);
+    if (unlikely(!batch_size))
+        return UBASE_ERR_INVALID;
+
+    if (batch_duration && upipe_qsrc->uclock == NULL) {
+        upipe_qsrc->uclock = uclock_std_alloc(0);
+        UBASE_ALLOC_RETURN(upipe_qsrc->uclock);
+    } else if (!batch_duration) {
+        uclock_release(upipe_qsrc->uclock);
+        upipe_qsrc->uclock = NULL;
+    }
+    upipe_qsrc->batch_size = batch_size;
+    upipe_qsrc->batch_duration = batch_duration;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the busy-poll duration of the queue.
+ *
+ * @param upipe description structure of the pipe
+ * @param spin_duration maximum polling duration, in 27 MHz units, or 0 to
+ * disable polling
+ * @return an error code
+ */
+static int _upipe_qsrc_set_spin(struct upipe *upipe, uint64_t spin_duration)
+{
+    uint64_t spin_ns = spin_duration * 1000 / 27;
+    if (spin_duration > UINT32_MAX || spin_ns > UINT32_MAX)
+        return UBASE_ERR_INVALID;
+    uqueue_set_spin(&upipe_queue(upipe)->uqueue, spin_ns);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the flow-control watermarks of the queue.
+ *
+ * @param upipe description structure of the pipe
+ * @param high number of urefs above which queue sinks are throttled, or 0
+ * to disable the watermarks
+ * @param low number of urefs at or below which queue sinks resume
+ * @return an error code
+ */
+static int _upipe_qsrc_set_watermarks(struct upipe *upipe,
+                                      unsigned int high, unsigned int low)
+{
+    if (unlikely(!uqueue_set_watermarks(&upipe_queue(upipe)->uqueue,
+                                        high, low)))
+        return UBASE_ERR_INVALID;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a queue source pipe.
  *
  * @param upipe description structure of the pipe
@@ -405,6 +501,30 @@ static int _upipe_qsrc_control(struct upipe *upipe, int command, va_list args)
             unsigned int *length_p = va_arg(args, unsigned int *);
             return _upipe_qsrc_get_length(upipe, length_p);
         }
+        case UPIPE_GET_STATS: {
+            struct upipe_stats *stats = va_arg(args, struct upipe_stats *);
+            unsigned int length;
+            UBASE_RETURN(_upipe_qsrc_get_length(upipe, &length))
+            stats->queue_length = length;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_QSRC_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSRC_SIGNATURE)
+            unsigned int batch_size = va_arg(args, unsigned int);
+            uint64_t batch_duration = va_arg(args, uint64_t);
+            return _upipe_qsrc_set_batch(upipe, batch_size, batch_duration);
+        }
+        case UPIPE_QSRC_SET_SPIN: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSRC_SIGNATURE)
+            uint64_t spin_duration = va_arg(args, uint64_t);
+            return _upipe_qsrc_set_spin(upipe, spin_duration);
+        }
+        case UPIPE_QSRC_SET_WATERMARKS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_QSRC_SIGNATURE)
+            unsigned int high = va_arg(args, unsigned int);
+            unsigned int low = va_arg(args, unsigned int);
+            return _upipe_qsrc_set_watermarks(upipe, high, low);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
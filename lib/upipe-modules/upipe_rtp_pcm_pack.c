@@ -28,23 +28,32 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "upipe/upipe.h"
 #include "upipe/uclock.h"
 #include "upipe/uref_clock.h"
+#include "upipe/uref_flow.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
 #include "upipe/upipe_helper_void.h"
-#include "upipe/upipe_helper_uref_stream.h"
 #include "upipe/upipe_helper_output.h"
 #include "upipe/upipe_helper_ubuf_mgr.h"
 #include "upipe/upipe_helper_input.h"
 
+#include "upipe/ubuf_block.h"
 #include "upipe/uref_sound.h"
 #include "upipe/uref_sound_flow.h"
 
 #include "upipe-modules/upipe_rtp_pcm_pack.h"
 
+/** maximum size of the payloads when no packet size is configured */
+#define MTU 1440
+/** size of the RTP header written in ST 2110-30 mode */
+#define RTP_HEADER_SIZE 12
+/** default RTP payload type */
+#define DEFAULT_TYPE 97
+
 struct upipe_rtp_pcm_pack {
     /** refcount management structure */
     struct urefcount urefcount;
@@ -71,6 +80,20 @@ struct upipe_rtp_pcm_pack {
     int output_samples;
     /** maximum time (microseconds) to put in each output uref */
     int output_time;
+    /** ST 2110-30 packet time, or 0 */
+    uint64_t packet_time;
+    /** samples per packet */
+    size_t packet_samples;
+
+    /** RTP header template */
+    uint8_t header[RTP_HEADER_SIZE];
+    /** next RTP sequence number */
+    uint16_t seqnum;
+
+    /** samples left over from the previous uref */
+    int32_t *carry;
+    /** number of samples per channel in the carry buffer */
+    size_t carry_samples;
 
     /** ubuf manager */
     struct ubuf_mgr *ubuf_mgr;
@@ -79,13 +102,6 @@ struct upipe_rtp_pcm_pack {
     /** ubuf manager request */
     struct urequest ubuf_mgr_request;
 
-    /** next uref to be processed */
-    struct uref *next_uref;
-    /** original size of the next uref */
-    size_t next_uref_size;
-    /** urefs received after next uref */
-    struct uchain urefs;
-
     /** temporary uref storage (used during urequest) */
     struct uchain input_urefs;
     /** nb urefs in storage */
@@ -115,7 +131,6 @@ UPIPE_HELPER_UBUF_MGR(upipe_rtp_pcm_pack, ubuf_mgr, flow_format, ubuf_mgr_reques
                       upipe_rtp_pcm_pack_check,
                       upipe_rtp_pcm_pack_register_output_request,
                       upipe_rtp_pcm_pack_unregister_output_request)
-UPIPE_HELPER_UREF_STREAM(upipe_rtp_pcm_pack, next_uref, next_uref_size, urefs, NULL)
 UPIPE_HELPER_INPUT(upipe_rtp_pcm_pack, input_urefs, nb_urefs, max_urefs, blockers,
         upipe_rtp_pcm_pack_handle)
 
@@ -150,28 +165,57 @@ static int upipe_rtp_pcm_pack_set_flow_def(struct upipe *upipe,
     if (planes != 1)
         return UBASE_ERR_INVALID;
 
-    UBASE_RETURN(uref_sound_flow_get_rate(flow_def, &upipe_rtp_pcm_pack->rate));
-    UBASE_RETURN(uref_sound_flow_get_channels(flow_def, &upipe_rtp_pcm_pack->channels));
+    uint64_t rate;
+    uint8_t channels;
+    UBASE_RETURN(uref_sound_flow_get_rate(flow_def, &rate));
+    UBASE_RETURN(uref_sound_flow_get_channels(flow_def, &channels));
+    if (!rate || !channels)
+        return UBASE_ERR_INVALID;
+
+    size_t packet_samples;
+    if (upipe_rtp_pcm_pack->packet_time) {
+        uint64_t packet_time = upipe_rtp_pcm_pack->packet_time;
+        packet_samples = rate * packet_time / UCLOCK_FREQ;
+        if (rate * packet_time % UCLOCK_FREQ)
+            upipe_warn_va(upipe, "packet time is not a whole number of "
+                          "samples, using %zu samples", packet_samples);
+    } else if (upipe_rtp_pcm_pack->output_time)
+        packet_samples = rate * upipe_rtp_pcm_pack->output_time / 1e6;
+    else if (upipe_rtp_pcm_pack->output_samples)
+        packet_samples = upipe_rtp_pcm_pack->output_samples;
+    else
+        packet_samples = MTU / 3 / channels;
+    if (!packet_samples) {
+        upipe_err(upipe, "packets would not hold any sample");
+        return UBASE_ERR_INVALID;
+    }
+
+    int32_t *carry = realloc(upipe_rtp_pcm_pack->carry,
+                             packet_samples * channels * sizeof(int32_t));
+    UBASE_ALLOC_RETURN(carry);
+    upipe_rtp_pcm_pack->carry = carry;
+    upipe_rtp_pcm_pack->carry_samples = 0;
+    upipe_rtp_pcm_pack->packet_samples = packet_samples;
+    upipe_rtp_pcm_pack->rate = rate;
+    upipe_rtp_pcm_pack->channels = channels;
+
     upipe_dbg(upipe, "running uref_clock_get_latency");
     if (!ubase_check(uref_clock_get_latency(flow_def, &upipe_rtp_pcm_pack->latency))) {
         upipe_warn(upipe, "unable to get latency from flow_def, assuming 0");
         upipe_rtp_pcm_pack->latency = 0;
     }
 
-    if (upipe_rtp_pcm_pack->output_time) {
-        upipe_rtp_pcm_pack->output_samples = upipe_rtp_pcm_pack->rate *
-            upipe_rtp_pcm_pack->output_time / 1e6;
-    }
-
     struct uref *flow_def_dup = uref_sibling_alloc(flow_def);
     if (unlikely(flow_def_dup == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
 
-    uref_flow_set_def(flow_def_dup, "block.s24be.sound.");
+    uref_flow_set_def(flow_def_dup, upipe_rtp_pcm_pack->packet_time ?
+                      "block.rtp.s24be.sound." : "block.s24be.sound.");
     /* RTP clock rate */
     uref_sound_flow_set_rate(flow_def_dup, upipe_rtp_pcm_pack->rate);
+    uref_sound_flow_set_channels(flow_def_dup, upipe_rtp_pcm_pack->channels);
 
     upipe_rtp_pcm_pack_require_ubuf_mgr(upipe, flow_def_dup);
 
@@ -230,6 +274,8 @@ static int upipe_rtp_pcm_pack_set_option(struct upipe *upipe, const char *option
 static int upipe_rtp_pcm_pack_control(struct upipe *upipe, int command,
                                   va_list args)
 {
+    struct upipe_rtp_pcm_pack *upipe_rtp_pcm_pack = upipe_rtp_pcm_pack_from_upipe(upipe);
+
     switch (command) {
         case UPIPE_REGISTER_REQUEST: {
             struct urequest *request = va_arg(args, struct urequest *);
@@ -259,6 +305,35 @@ static int upipe_rtp_pcm_pack_control(struct upipe *upipe, int command,
         case UPIPE_GET_OUTPUT:
         case UPIPE_SET_OUTPUT:
             return upipe_rtp_pcm_pack_control_output(upipe, command, args);
+
+        case UPIPE_RTP_PCM_PACK_GET_PACKET_TIME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_PACK_SIGNATURE)
+            uint64_t *packet_time_p = va_arg(args, uint64_t *);
+            *packet_time_p = upipe_rtp_pcm_pack->packet_time;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_PCM_PACK_SET_PACKET_TIME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_PACK_SIGNATURE)
+            uint64_t packet_time = va_arg(args, uint64_t);
+            if (upipe_rtp_pcm_pack->packet_samples)
+                return UBASE_ERR_BUSY;
+            upipe_rtp_pcm_pack->packet_time = packet_time;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_PCM_PACK_GET_TYPE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_PACK_SIGNATURE)
+            uint8_t *type_p = va_arg(args, uint8_t *);
+            *type_p = upipe_rtp_pcm_pack->header[1] & 0x7f;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_RTP_PCM_PACK_SET_TYPE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_PCM_PACK_SIGNATURE)
+            unsigned int type = va_arg(args, unsigned int);
+            if (type > 0x7f)
+                return UBASE_ERR_INVALID;
+            upipe_rtp_pcm_pack->header[1] = type;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -266,10 +341,12 @@ static int upipe_rtp_pcm_pack_control(struct upipe *upipe, int command,
 
 static void upipe_rtp_pcm_pack_free(struct upipe *upipe)
 {
+    struct upipe_rtp_pcm_pack *upipe_rtp_pcm_pack = upipe_rtp_pcm_pack_from_upipe(upipe);
+
     upipe_throw_dead(upipe);
+    free(upipe_rtp_pcm_pack->carry);
     upipe_rtp_pcm_pack_clean_ubuf_mgr(upipe);
     upipe_rtp_pcm_pack_clean_urefcount(upipe);
-    upipe_rtp_pcm_pack_clean_uref_stream(upipe);
     upipe_rtp_pcm_pack_clean_output(upipe);
     upipe_rtp_pcm_pack_clean_input(upipe);
     upipe_rtp_pcm_pack_free_void(upipe);
@@ -285,12 +362,28 @@ static struct upipe *upipe_rtp_pcm_pack_alloc(struct upipe_mgr *mgr,
     if (unlikely(upipe == NULL))
         return NULL;
 
+    struct upipe_rtp_pcm_pack *upipe_rtp_pcm_pack = upipe_rtp_pcm_pack_from_upipe(upipe);
     upipe_rtp_pcm_pack_init_urefcount(upipe);
     upipe_rtp_pcm_pack_init_input(upipe);
     upipe_rtp_pcm_pack_init_ubuf_mgr(upipe);
-    upipe_rtp_pcm_pack_init_uref_stream(upipe);
     upipe_rtp_pcm_pack_init_output(upipe);
 
+    upipe_rtp_pcm_pack->channels = 0;
+    upipe_rtp_pcm_pack->rate = 0;
+    upipe_rtp_pcm_pack->latency = 0;
+    upipe_rtp_pcm_pack->output_samples = 0;
+    upipe_rtp_pcm_pack->output_time = 0;
+    upipe_rtp_pcm_pack->packet_time = 0;
+    upipe_rtp_pcm_pack->packet_samples = 0;
+    upipe_rtp_pcm_pack->carry = NULL;
+    upipe_rtp_pcm_pack->carry_samples = 0;
+    upipe_rtp_pcm_pack->seqnum = 0;
+
+    /* version 2, no padding, extension or CSRC, SSRC 0 */
+    memset(upipe_rtp_pcm_pack->header, 0, RTP_HEADER_SIZE);
+    upipe_rtp_pcm_pack->header[0] = 0x80;
+    upipe_rtp_pcm_pack->header[1] = DEFAULT_TYPE;
+
     return upipe;
 }
 
@@ -309,6 +402,25 @@ static void upipe_rtp_pcm_pack_input(struct upipe *upipe, struct uref *uref,
     }
 }
 
+/** @internal @This converts s32 samples to 24-bit big endian.
+ *
+ * @param dst destination buffer
+ * @param src source samples
+ * @param n number of samples (all channels)
+ * @return pointer past the written samples
+ */
+static uint8_t *upipe_rtp_pcm_pack_convert(uint8_t *dst, const int32_t *src,
+                                           size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        int32_t sample = src[i];
+        dst[3*i+0] = (sample >> 24) & 0xff;
+        dst[3*i+1] = (sample >> 16) & 0xff;
+        dst[3*i+2] = (sample >>  8) & 0xff;
+    }
+    return dst + 3 * n;
+}
+
 static bool upipe_rtp_pcm_pack_handle(struct upipe *upipe, struct uref *uref,
                                   struct upump **upump_p)
 {
@@ -316,75 +428,131 @@ static bool upipe_rtp_pcm_pack_handle(struct upipe *upipe, struct uref *uref,
     if (!upipe_rtp_pcm_pack->ubuf_mgr)
         return false;
 
-    size_t s;
-    uref_sound_size(uref, &s, NULL);
-    s *= upipe_rtp_pcm_pack->channels;
+    uint8_t channels = upipe_rtp_pcm_pack->channels;
+    size_t packet_samples = upipe_rtp_pcm_pack->packet_samples;
+    size_t carry = upipe_rtp_pcm_pack->carry_samples;
+    bool rtp = upipe_rtp_pcm_pack->packet_time != 0;
+    size_t header_size = rtp ? RTP_HEADER_SIZE : 0;
+    size_t packet_size = header_size + packet_samples * channels * 3;
 
-    struct ubuf *ubuf = ubuf_block_alloc(upipe_rtp_pcm_pack->ubuf_mgr,
-            s * 3 /* 24 bits */);
-    if (!ubuf) {
+    size_t samples;
+    const int32_t *src = NULL;
+    if (unlikely(!ubase_check(uref_sound_size(uref, &samples, NULL)) ||
+                 !ubase_check(uref_sound_read_int32_t(uref, 0, -1, &src, 1)))) {
+        upipe_warn(upipe, "unable to read sound buffer");
         uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return true;
     }
 
+    /* all the packets of this uref share a single buffer */
+    size_t nb_packets = (carry + samples) / packet_samples;
+    struct ubuf *ubuf = NULL;
     uint8_t *dst = NULL;
-    const int32_t *src = NULL;
-    int size = -1;
-    ubuf_block_write(ubuf, 0, &size, &dst);
-
-    uref_sound_read_int32_t(uref, 0, -1, &src, 1);
-
-    for (int i = 0; i < s; i++) {
-        int32_t sample = src[i];
-        dst[3*i+0] = (sample >> 24) & 0xff;
-        dst[3*i+1] = (sample >> 16) & 0xff;
-        dst[3*i+2] = (sample >>  8) & 0xff;
+    if (nb_packets) {
+        ubuf = ubuf_block_alloc(upipe_rtp_pcm_pack->ubuf_mgr,
+                                nb_packets * packet_size);
+        int size = -1;
+        if (unlikely(ubuf == NULL ||
+                     !ubase_check(ubuf_block_write(ubuf, 0, &size, &dst)))) {
+            if (ubuf != NULL)
+                ubuf_free(ubuf);
+            uref_sound_unmap(uref, 0, -1, 1);
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return true;
+        }
     }
 
-    ubuf_block_unmap(ubuf, 0);
-    uref_sound_unmap(uref, 0, -1, 1);
+    /* RTP timestamp of the first sample of the uref, rounded to the nearest
+     * sample as the pts may not fall exactly on a sample */
+    uint32_t timestamp = 0;
+    if (rtp) {
+        uint64_t pts = 0;
+        if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts))))
+            uref_clock_get_pts_sys(uref, &pts);
+        lldiv_t div = lldiv(pts, UCLOCK_FREQ);
+        timestamp = div.quot * upipe_rtp_pcm_pack->rate +
+            ((uint64_t)div.rem * upipe_rtp_pcm_pack->rate + UCLOCK_FREQ / 2) /
+            UCLOCK_FREQ;
+    }
 
-    uref_attach_ubuf(uref, ubuf);
+    size_t consumed = 0;
+    for (size_t i = 0; i < nb_packets; i++) {
+        uint8_t *packet = dst + i * packet_size;
+        if (rtp) {
+            uint16_t seqnum = upipe_rtp_pcm_pack->seqnum++;
+            uint32_t ts = timestamp + i * packet_samples - carry;
+            memcpy(packet, upipe_rtp_pcm_pack->header, RTP_HEADER_SIZE);
+            packet[2] = seqnum >> 8;
+            packet[3] = seqnum;
+            packet[4] = ts >> 24;
+            packet[5] = ts >> 16;
+            packet[6] = ts >> 8;
+            packet[7] = ts;
+        }
 
-#define MTU 1440
-    size_t chunk_size;
-    if (upipe_rtp_pcm_pack->output_samples)
-        chunk_size = upipe_rtp_pcm_pack->output_samples;
-    else
-        chunk_size = MTU / 3 / upipe_rtp_pcm_pack->channels;
-    chunk_size *= 3 * upipe_rtp_pcm_pack->channels;
+        uint8_t *payload = packet + header_size;
+        size_t n = packet_samples;
+        if (!i && carry) {
+            payload = upipe_rtp_pcm_pack_convert(payload,
+                    upipe_rtp_pcm_pack->carry, carry * channels);
+            n -= carry;
+        }
+        upipe_rtp_pcm_pack_convert(payload, src + consumed * channels,
+                                   n * channels);
+        consumed += n;
+    }
 
-    upipe_rtp_pcm_pack_append_uref_stream(upipe, uref);
+    /* keep the remaining samples for the next packet */
+    size_t kept = nb_packets ? 0 : carry;
+    memcpy(upipe_rtp_pcm_pack->carry + kept * channels,
+           src + consumed * channels,
+           (samples - consumed) * channels * sizeof(int32_t));
+    upipe_rtp_pcm_pack->carry_samples = kept + samples - consumed;
 
-    if (upipe_rtp_pcm_pack->next_uref_size + s*3 < chunk_size)
+    uref_sound_unmap(uref, 0, -1, 1);
+    if (!nb_packets) {
+        uref_free(uref);
         return true;
+    }
+    ubuf_block_unmap(ubuf, 0);
 
-    uref_clock_set_cr_dts_delay(upipe_rtp_pcm_pack->next_uref, 0);
-    uref_clock_set_dts_pts_delay(upipe_rtp_pcm_pack->next_uref, 0);
-    uref_clock_add_date_sys(upipe_rtp_pcm_pack->next_uref, upipe_rtp_pcm_pack->latency);
-
-    const uint64_t adjustment = (chunk_size / 3 / upipe_rtp_pcm_pack->channels)
-            * UCLOCK_FREQ / upipe_rtp_pcm_pack->rate;
-
-    while (upipe_rtp_pcm_pack->next_uref != NULL
-            && upipe_rtp_pcm_pack->next_uref_size + s*3 >= chunk_size) {
-        /* Get uref to output. */
-        struct uref *output = upipe_rtp_pcm_pack_extract_uref_stream(upipe, chunk_size);
-
-        /* Update clocks on next uref. */
-        if (upipe_rtp_pcm_pack->next_uref) {
-            uref_clock_add_date_prog(upipe_rtp_pcm_pack->next_uref, adjustment);
-            uref_clock_add_date_sys(upipe_rtp_pcm_pack->next_uref, adjustment);
-        }
-
+    uref_clock_set_cr_dts_delay(uref, 0);
+    uref_clock_set_dts_pts_delay(uref, 0);
+    uref_clock_add_date_sys(uref, upipe_rtp_pcm_pack->latency);
+    uref_clock_set_duration(uref, packet_samples * UCLOCK_FREQ /
+                                  upipe_rtp_pcm_pack->rate);
+
+    /* the first packet starts with the samples of the previous uref */
+    int64_t offset = -(int64_t)carry;
+    for (size_t i = 0; i < nb_packets; i++) {
+        struct ubuf *slice = ubuf_block_splice(ubuf, i * packet_size,
+                                               packet_size);
+        struct uref *output = slice == NULL ? NULL :
+            i == nb_packets - 1 ? uref : uref_fork(uref, slice);
         if (unlikely(output == NULL)) {
+            if (slice != NULL)
+                ubuf_free(slice);
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            continue;
+            break;
         }
+        if (output == uref)
+            uref_attach_ubuf(uref, slice);
+
+        int64_t delay = offset * (int64_t)UCLOCK_FREQ /
+                        (int64_t)upipe_rtp_pcm_pack->rate;
+        uref_clock_add_date_sys(output, delay);
+        uref_clock_add_date_prog(output, delay);
+        uref_clock_add_date_orig(output, delay);
+        offset += packet_samples;
 
         upipe_rtp_pcm_pack_output(upipe, output, upump_p);
+        if (output == uref)
+            uref = NULL;
     }
+    ubuf_free(ubuf);
+    if (uref != NULL)
+        uref_free(uref);
 
     return true;
 }
@@ -35,6 +35,8 @@
 #include "upipe/ubuf_block.h"
 #include "upipe/upipe.h"
 #include "upipe/uref_sound_flow.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_block_flow.h"
 #include "upipe/uref_flow.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -61,6 +63,8 @@
 #define DEFAULT_TS_SYNC         UPIPE_RTP_PREPEND_TS_SYNC_CR
 #define DEFAULT_CLOCKRATE       90000
 #define RTP_TYPE_INVALID        UINT8_MAX
+/** size of the RFC 2250 MPEG audio header */
+#define MPA_HEADER_SIZE         4
 
 /** upipe_rtp_prepend structure */
 struct upipe_rtp_prepend {
@@ -143,6 +147,32 @@ static void upipe_rtp_prepend_input(struct upipe *upipe, struct uref *uref,
     ts = div.quot * upipe_rtp_prepend->clockrate
          + ((uint64_t)div.rem * upipe_rtp_prepend->clockrate)/UCLOCK_FREQ;
 
+    /* write the headers in place if the payload has enough headroom */
+    int header_size = RTP_HEADER_SIZE +
+        (upipe_rtp_prepend->mpa ? MPA_HEADER_SIZE : 0);
+    if (ubase_check(uref_block_prepend(uref, header_size))) {
+        size = header_size;
+        if (likely(ubase_check(uref_block_write(uref, 0, &size, &buf)) &&
+                   size == header_size)) {
+            memset(buf, 0, header_size);
+            rtp_set_hdr(buf);
+            rtp_set_type(buf, upipe_rtp_prepend->type);
+            rtp_set_seqnum(buf, upipe_rtp_prepend->seqnum);
+            rtp_set_timestamp(buf, ts);
+            uref_block_unmap(uref, 0);
+            upipe_rtp_prepend->seqnum++;
+
+            upipe_rtp_prepend_output(upipe, uref, upump_p);
+            return;
+        }
+
+        /* shared or segmented buffer */
+        if (size != -1)
+            uref_block_unmap(uref, 0);
+        uref_block_resize(uref, header_size, -1);
+        size = -1;
+    }
+
     /* alloc header */
     header = ubuf_block_alloc(uref->ubuf->mgr, RTP_HEADER_SIZE);
     if (unlikely(!header)) {
@@ -163,7 +193,8 @@ static void upipe_rtp_prepend_input(struct upipe *upipe, struct uref *uref,
 
     if (upipe_rtp_prepend->mpa) {
         /* alloc mpa header */
-        struct ubuf *mpa_header = ubuf_block_alloc(uref->ubuf->mgr, 4);
+        struct ubuf *mpa_header = ubuf_block_alloc(uref->ubuf->mgr,
+                                                   MPA_HEADER_SIZE);
         if (unlikely(!mpa_header)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             uref_free(uref);
@@ -173,7 +204,7 @@ static void upipe_rtp_prepend_input(struct upipe *upipe, struct uref *uref,
 
         /* write mpa mpa_header */
         ubuf_block_write(mpa_header, 0, &size, &buf);
-        memset(buf, 0, 4); // frag_offset = 0
+        memset(buf, 0, MPA_HEADER_SIZE); // frag_offset = 0
         ubuf_block_unmap(mpa_header, 0);
 
         if (unlikely(!ubase_check(ubuf_block_append(header, mpa_header)))) {
@@ -404,6 +435,36 @@ static int upipe_rtp_prepend_set_flow_def(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This requires a ubuf manager by proxy, and amends the flow
+ * format so that payloads are allocated with enough headroom to write the
+ * RTP headers in place.
+ *
+ * @param upipe description structure of the pipe
+ * @param request description structure of the request
+ * @return an error code
+ */
+static int upipe_rtp_prepend_amend_ubuf_mgr(struct upipe *upipe,
+                                            struct urequest *request)
+{
+    struct uref *flow_format = uref_dup(request->uref);
+    UBASE_ALLOC_RETURN(flow_format);
+
+    uint64_t prepend;
+    if (!ubase_check(uref_block_flow_get_prepend(flow_format, &prepend)))
+        prepend = 0;
+    /* the payload type may not be known yet */
+    uref_block_flow_set_prepend(flow_format,
+                                prepend + RTP_HEADER_SIZE + MPA_HEADER_SIZE);
+
+    struct urequest ubuf_mgr_request;
+    urequest_set_opaque(&ubuf_mgr_request, request);
+    urequest_init_ubuf_mgr(&ubuf_mgr_request, flow_format,
+                           upipe_rtp_prepend_provide_output_proxy, NULL);
+    upipe_throw_provide_request(upipe, &ubuf_mgr_request);
+    urequest_clean(&ubuf_mgr_request);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This sets the rtp payload type.
  *
  * @param upipe description structure of the pipe
@@ -503,9 +564,24 @@ _upipe_rtp_prepend_set_ts_sync(struct upipe *upipe,
 static int upipe_rtp_prepend_control(struct upipe *upipe,
                                      int command, va_list args)
 {
-    UBASE_HANDLED_RETURN(
-        upipe_rtp_prepend_control_output(upipe, command, args));
     switch (command) {
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR)
+                return upipe_rtp_prepend_amend_ubuf_mgr(upipe, request);
+            return upipe_rtp_prepend_alloc_output_proxy(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            if (request->type == UREQUEST_UBUF_MGR)
+                return UBASE_ERR_NONE;
+            return upipe_rtp_prepend_free_output_proxy(upipe, request);
+        }
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_rtp_prepend_control_output(upipe, command, args);
+
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_rtp_prepend_set_flow_def(upipe, flow_def);
@@ -48,6 +48,7 @@
 #include <bitstream/ietf/rtp.h>
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
@@ -90,12 +91,19 @@ struct upipe_rtpr {
     struct upipe_mgr sub_mgr;
 
     struct uchain queue;
+    /** packets of the queue, indexed by sequence number */
+    struct uref *index[UINT16_MAX + 1];
+    /** date of the first copy of each sequence number, 0 if it had no date,
+     * or UINT64_MAX if it was not received */
+    uint64_t arrival[UINT16_MAX + 1];
 
     uint64_t last_sent_seqnum;
     uint64_t num_consecutive_late;
 
     /** delay to set */
     uint64_t delay;
+    /** output in-order packets immediately */
+    bool low_latency;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -127,6 +135,9 @@ struct upipe_rtpr_sub {
     /** flow_definition packet */
     struct uref *flow_def;
 
+    /** statistics */
+    struct upipe_rtpr_input_stats stats;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -148,6 +159,31 @@ static inline bool seq_num_lt(uint16_t s1, uint16_t s2)
         return 0;
 }
 
+/** @internal @This outputs the queued packets that directly follow the
+ * last output packet.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtpr_output_consecutive(struct upipe *upipe)
+{
+    struct upipe_rtpr *rtpr = upipe_rtpr_from_upipe(upipe);
+    struct uchain *uchain;
+
+    while ((uchain = ulist_peek(&rtpr->queue)) != NULL) {
+        struct uref *uref = uref_from_uchain(uchain);
+        uint64_t seqnum = 0;
+        uref_attr_get_priv(uref, &seqnum);
+        if (rtpr->last_sent_seqnum != UINT64_MAX &&
+            seqnum != (uint16_t)(rtpr->last_sent_seqnum + 1))
+            break;
+
+        ulist_pop(&rtpr->queue);
+        rtpr->index[(uint16_t)seqnum] = NULL;
+        upipe_rtpr_output(upipe, uref, NULL);
+        rtpr->last_sent_seqnum = seqnum;
+    }
+}
+
 static void upipe_rtpr_timer(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
@@ -166,6 +202,7 @@ static void upipe_rtpr_timer(struct upump *upump)
 
         if (now >= date_sys || date_sys == UINT64_MAX) {
             ulist_delete(uchain);
+            rtpr->index[(uint16_t)seqnum] = NULL;
             upipe_rtpr_output(upipe, uref, NULL);
             rtpr->last_sent_seqnum = seqnum;
         }
@@ -173,6 +210,9 @@ static void upipe_rtpr_timer(struct upump *upump)
             break;
         }
     }
+
+    if (rtpr->low_latency)
+        upipe_rtpr_output_consecutive(upipe);
 }
 
 static int upipe_rtpr_check(struct upipe *upipe, struct uref *flow_format)
@@ -240,6 +280,7 @@ static struct upipe *upipe_rtpr_sub_alloc(struct upipe_mgr *mgr,
 
     struct upipe_rtpr_sub *upipe_rtpr_sub = upipe_rtpr_sub_from_upipe(upipe);
     upipe_rtpr_sub->flow_def = NULL;
+    memset(&upipe_rtpr_sub->stats, 0, sizeof(upipe_rtpr_sub->stats));
     upipe_rtpr_sub_init_urefcount(upipe);
     upipe_rtpr_sub_init_sub(upipe);
     upipe_throw_ready(upipe);
@@ -272,16 +313,43 @@ static int upipe_rtpr_sub_control(struct upipe *upipe,
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_rtpr_sub_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_RTPR_INPUT_GET_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTPR_INPUT_SIGNATURE)
+            struct upipe_rtpr_input_stats *stats =
+                va_arg(args, struct upipe_rtpr_input_stats *);
+            struct upipe_rtpr_sub *upipe_rtpr_sub =
+                upipe_rtpr_sub_from_upipe(upipe);
+            *stats = upipe_rtpr_sub->stats;
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
 }
 
-static void upipe_rtpr_list_add(struct upipe *upipe, struct uref *uref)
+/** @internal @This accounts for a copy of a packet already received from
+ * another input.
+ *
+ * @param sub input subpipe which received the copy
+ * @param arrival date of the copy, or 0
+ * @param first date of the first copy, or 0
+ */
+static void upipe_rtpr_sub_duplicate(struct upipe_rtpr_sub *sub,
+                                     uint64_t arrival, uint64_t first)
+{
+    sub->stats.duplicates++;
+    if (arrival && first && arrival >= first) {
+        sub->stats.skew = arrival - first;
+        if (sub->stats.skew > sub->stats.max_skew)
+            sub->stats.max_skew = sub->stats.skew;
+    }
+}
+
+static void upipe_rtpr_list_add(struct upipe *upipe,
+                                struct upipe_rtpr_sub *sub,
+                                struct uref *uref, uint64_t arrival)
 {
     struct upipe_rtpr *rtpr = upipe_rtpr_from_upipe(upipe);
-    int dup = 0, ooo = 0;
-    struct uchain *uchain, *uchain_tmp;
 
     uint8_t rtp_buffer[RTP_HEADER_SIZE];
     const uint8_t *rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE,
@@ -295,11 +363,16 @@ static void upipe_rtpr_list_add(struct upipe *upipe, struct uref *uref)
     uint16_t new_seqnum = rtp_get_seqnum(rtp_header);
     uref_attr_set_priv(uref, new_seqnum);
     uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
+    sub->stats.packets++;
 
     /* Drop late packets */
     if (rtpr->last_sent_seqnum != UINT64_MAX &&
         (seq_num_lt(new_seqnum, rtpr->last_sent_seqnum) ||
          new_seqnum == rtpr->last_sent_seqnum)) {
+        if (rtpr->arrival[new_seqnum] != UINT64_MAX)
+            upipe_rtpr_sub_duplicate(sub, arrival, rtpr->arrival[new_seqnum]);
+        else
+            sub->stats.late++;
         uref_free(uref);
         rtpr->num_consecutive_late++;
 
@@ -312,47 +385,48 @@ static void upipe_rtpr_list_add(struct upipe *upipe, struct uref *uref)
 
     rtpr->num_consecutive_late = 0;
 
-    /* Remove date_sys for any late packets */
-    ulist_delete_foreach_reverse(&rtpr->queue, uchain, uchain_tmp) {
-        struct uref *cur_uref = uref_from_uchain(uchain);
-        uint64_t seqnum = 0;
-        uref_attr_get_priv(cur_uref, &seqnum);
-
-        if (seq_num_lt(new_seqnum, seqnum)) {
-            if (ulist_is_first(&rtpr->queue, uchain)) {
-                uref_clock_delete_date_sys(uref);
-                ulist_insert(uchain->prev, uchain, uref_to_uchain(uref));
-                ooo = 1;
-                break;
-            }
-            else {
-                struct uref *prev_uref = uref_from_uchain(uchain->prev);
-                uint64_t prev_seqnum = 0;
-                uref_attr_get_priv(prev_uref, &prev_seqnum);
-                if (!seq_num_lt(new_seqnum, prev_seqnum) &&
-                    !(new_seqnum == prev_seqnum)) {
-                    uref_clock_delete_date_sys(uref);
-                    ulist_insert(uchain->prev, uchain, uref_to_uchain(uref));
-                    ooo = 1;
-                    break;
-                }
-            }
-        }
-        /* Duplicate packet */
-        else if (new_seqnum == seqnum) {
-            dup = 1;
-            uref_free(uref);
-            break;
-        }
-        else
-            break;
+    /* Duplicate packet */
+    if (rtpr->index[new_seqnum]) {
+        upipe_rtpr_sub_duplicate(sub, arrival, rtpr->arrival[new_seqnum]);
+        uref_free(uref);
+        return;
     }
-
+    rtpr->index[new_seqnum] = uref;
+    rtpr->arrival[new_seqnum] = arrival;
+    /* forget the sequence number half a cycle away */
+    rtpr->arrival[(uint16_t)(new_seqnum + 0x8000)] = UINT64_MAX;
+    sub->stats.first++;
 
     /* Add to end if normal packet */
-    if (!dup && !ooo) {
+    struct uchain *last = ulist_peek_last(&rtpr->queue);
+    uint64_t seqnum = 0;
+    if (last)
+        uref_attr_get_priv(uref_from_uchain(last), &seqnum);
+    if (!last || !seq_num_lt(new_seqnum, seqnum)) {
         ulist_add(&rtpr->queue, uref_to_uchain(uref));
+        if (rtpr->low_latency)
+            upipe_rtpr_output_consecutive(upipe);
+        return;
     }
+
+    /* Remove date_sys for any late packets */
+    uref_clock_delete_date_sys(uref);
+
+    uref_attr_get_priv(uref_from_uchain(ulist_peek(&rtpr->queue)), &seqnum);
+    if (seq_num_lt(new_seqnum, seqnum)) {
+        ulist_unshift(&rtpr->queue, uref_to_uchain(uref));
+        if (rtpr->low_latency)
+            upipe_rtpr_output_consecutive(upipe);
+        return;
+    }
+
+    /* insert after the closest older packet, found in the index; the first
+     * packet is older so this terminates */
+    uint16_t prev_seqnum = new_seqnum - 1;
+    while (!rtpr->index[prev_seqnum])
+        prev_seqnum--;
+    struct uchain *prev = uref_to_uchain(rtpr->index[prev_seqnum]);
+    ulist_insert(prev, prev->next, uref_to_uchain(uref));
 }
 
 /** @internal @This receives data.
@@ -365,14 +439,18 @@ static bool upipe_rtpr_sub_output(struct upipe *upipe, struct uref *uref,
                                   struct upump **upump_p)
 {
     struct upipe_rtpr *upipe_rtpr = upipe_rtpr_from_sub_mgr(upipe->mgr);
-    uint64_t date_sys;
+    struct upipe_rtpr_sub *upipe_rtpr_sub = upipe_rtpr_sub_from_upipe(upipe);
+    uint64_t date_sys, arrival = 0;
     int type;
 
     uref_clock_get_date_sys(uref, &date_sys, &type);
-    date_sys += upipe_rtpr->delay;
-    uref_clock_set_date_sys(uref, date_sys, type);
+    if (type != UREF_DATE_NONE) {
+        arrival = date_sys;
+        date_sys += upipe_rtpr->delay;
+        uref_clock_set_date_sys(uref, date_sys, type);
+    }
 
-    upipe_rtpr_list_add(&upipe_rtpr->upipe, uref);
+    upipe_rtpr_list_add(&upipe_rtpr->upipe, upipe_rtpr_sub, uref, arrival);
 
     return true;
 }
@@ -433,6 +511,8 @@ static void upipe_rtpr_clean_queue(struct upipe *upipe)
         ulist_delete(uchain);
         uref_free(uref);
     }
+    memset(rtpr->index, 0, sizeof(rtpr->index));
+    memset(rtpr->arrival, 0xff, sizeof(rtpr->arrival));
 }
 
 /** @internal @This allocates a rtpr pipe.
@@ -464,10 +544,13 @@ static struct upipe *upipe_rtpr_alloc(struct upipe_mgr *mgr,
     upipe_rtpr_init_sub_mgr(upipe);
 
     ulist_init(&upipe_rtpr->queue);
+    memset(upipe_rtpr->index, 0, sizeof(upipe_rtpr->index));
+    memset(upipe_rtpr->arrival, 0xff, sizeof(upipe_rtpr->arrival));
 
     upipe_rtpr->last_sent_seqnum = UINT64_MAX;
     upipe_rtpr->num_consecutive_late = 0;
     upipe_rtpr->delay = UCLOCK_FREQ/10;
+    upipe_rtpr->low_latency = false;
 
     upipe_throw_ready(upipe);
     upipe_rtpr_check_upump_mgr(upipe);
@@ -533,6 +616,12 @@ static int _upipe_rtpr_control(struct upipe *upipe, int command, va_list args)
             uint64_t delay = va_arg(args, uint64_t);
             return _upipe_rtpr_set_delay(upipe, delay);
         }
+        case UPIPE_RTPR_SET_LOW_LATENCY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_RTPR_SIGNATURE)
+            struct upipe_rtpr *upipe_rtpr = upipe_rtpr_from_upipe(upipe);
+            upipe_rtpr->low_latency = !!va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -43,6 +43,7 @@
 #include "upipe/upipe_helper_input.h"
 #include "upipe/ubuf_sound.h"
 #include "upipe-modules/upipe_s337_encaps.h"
+#include "upipe-framers/uref_s337.h"
 
 #include <bitstream/atsc/a52.h>
 #include <bitstream/smpte/337.h>
@@ -169,7 +170,12 @@ static bool upipe_s337_encaps_handle(struct upipe *upipe, struct uref *uref,
     }
 
     int32_t *out_data;
-    ubuf_sound_write_int32_t(ubuf, 0, -1, &out_data, 1);
+    if (!ubase_check(ubuf_sound_write_int32_t(ubuf, 0, -1, &out_data, 1))) {
+        upipe_err(upipe, "Couldn't map sound buffer");
+        ubuf_free(ubuf);
+        uref_free(uref);
+        return true;
+    }
 
     /* Pa, Pb, Pc, Pd */
     out_data[0] = (S337_PREAMBLE_A1 << 24) | (S337_PREAMBLE_A2 << 16);
@@ -215,6 +221,8 @@ static bool upipe_s337_encaps_handle(struct upipe *upipe, struct uref *uref,
     ubuf_sound_unmap(ubuf, 0, -1, 1);
 
     uref_attach_ubuf(uref, ubuf);
+    uref_s337_set_data_type(uref, S337_TYPE_A52);
+    uref_s337_set_length(uref, offset * 8);
     upipe_s337_encaps_output(upipe, uref, upump_p);
     return true;
 }
@@ -29,6 +29,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "upipe/upipe.h"
 #include "upipe/uclock.h"
@@ -79,11 +80,13 @@ static int upipe_separate_fields_set_flow_def(struct upipe *upipe,
         return UBASE_ERR_INVALID;
     UBASE_RETURN(uref_flow_match_def(flow_def, "pic."));
 
-    /* TODO: check vertical chroma subsampling */
     uint64_t height;
+    uint8_t hsub, vsub;
     UBASE_RETURN(uref_pic_flow_get_vsize(flow_def, &height));
-    if (height & 1) {
-        upipe_err(upipe, "flow def is an odd height");
+    UBASE_RETURN(uref_pic_flow_max_subsampling(flow_def, &hsub, &vsub));
+    if (height % (2 * vsub)) {
+        upipe_err(upipe, "flow def height is not a multiple of the fields "
+                  "chroma subsampling");
         upipe_throw_error(upipe, UBASE_ERR_UNKNOWN);
         return UBASE_ERR_UNKNOWN;
     }
@@ -152,6 +155,75 @@ static struct upipe *upipe_separate_fields_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This copies the fields of a picture which cannot be split
+ * in place.
+ *
+ * @param uref interlaced picture
+ * @param odd_p filled with the odd field
+ * @param even_p filled with the even field
+ * @return an error code
+ */
+static int upipe_separate_fields_copy(struct uref *uref, struct uref **odd_p,
+                                      struct uref **even_p)
+{
+    size_t hsize, vsize;
+    uint8_t macropixel;
+    UBASE_RETURN(uref_pic_size(uref, &hsize, &vsize, &macropixel));
+
+    struct uref *fields[2] = { NULL, NULL };
+    for (int i = 0; i < 2; i++) {
+        int err = UBASE_ERR_ALLOC;
+        struct ubuf *ubuf = ubuf_pic_alloc(uref->ubuf->mgr, hsize, vsize / 2);
+        fields[i] = uref_dup_inner(uref);
+        if (unlikely(!ubuf || !fields[i])) {
+            ubuf_free(ubuf);
+            goto error;
+        }
+        uref_attach_ubuf(fields[i], ubuf);
+
+        const char *chroma;
+        uref_pic_foreach_plane(uref, chroma) {
+            size_t src_stride, dst_stride;
+            uint8_t hsub, vsub, macropixel_size;
+            const uint8_t *src;
+            uint8_t *dst;
+            err = uref_pic_plane_size(uref, chroma, &src_stride,
+                                      &hsub, &vsub, &macropixel_size);
+            if (ubase_check(err))
+                err = uref_pic_plane_size(fields[i], chroma, &dst_stride,
+                                          NULL, NULL, NULL);
+            if (ubase_check(err))
+                err = uref_pic_plane_read(uref, chroma, 0, 0, -1, -1, &src);
+            if (!ubase_check(err))
+                goto error;
+            err = uref_pic_plane_write(fields[i], chroma, 0, 0, -1, -1, &dst);
+            if (!ubase_check(err)) {
+                uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+                goto error;
+            }
+
+            size_t width = hsize / hsub / macropixel * macropixel_size;
+            size_t lines = vsize / 2 / vsub;
+            src += i * src_stride;
+            for (size_t y = 0; y < lines; y++)
+                memcpy(dst + y * dst_stride, src + 2 * y * src_stride, width);
+
+            uref_pic_plane_unmap(fields[i], chroma, 0, 0, -1, -1);
+            uref_pic_plane_unmap(uref, chroma, 0, 0, -1, -1);
+        }
+        continue;
+
+error:
+        uref_free(fields[0]);
+        uref_free(fields[1]);
+        return err;
+    }
+
+    *even_p = fields[0];
+    *odd_p = fields[1];
+    return UBASE_ERR_NONE;
+}
+
 static void upipe_separate_fields_input(struct upipe *upipe, struct uref *uref,
                                   struct upump **upump_p)
 {
@@ -175,8 +247,12 @@ static void upipe_separate_fields_input(struct upipe *upipe, struct uref *uref,
 
     uref_clock_set_duration(uref, ctx->field_duration);
 
+    /* fields are views of the picture with a doubled stride, unless the
+     * buffer manager does not support it */
     struct uref *odd = NULL, *even = NULL;
     int err = uref_split_fields(uref, &odd, &even);
+    if (err == UBASE_ERR_UNHANDLED)
+        err = upipe_separate_fields_copy(uref, &odd, &even);
     if (!ubase_check(err)) {
         upipe_err_va(upipe, "%s", ubase_err_str(err));
         uref_free(uref);
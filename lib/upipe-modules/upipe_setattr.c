@@ -90,20 +90,19 @@ static struct upipe *upipe_setattr_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This receives data.
+/** @internal @This processes a uref in place.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref was dropped
  */
-static void upipe_setattr_input(struct upipe *upipe, struct uref *uref,
-                                struct upump **upump_p)
+static bool upipe_setattr_process(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
 {
     struct upipe_setattr *upipe_setattr = upipe_setattr_from_upipe(upipe);
-    if (unlikely(upipe_setattr->dict == NULL)) {
-        upipe_setattr_output(upipe, uref, upump_p);
-        return;
-    }
+    if (unlikely(upipe_setattr->dict == NULL))
+        return true;
 
     if (upipe_setattr->dict->udict != NULL) {
         if (uref->udict == NULL) {
@@ -111,7 +110,7 @@ static void upipe_setattr_input(struct upipe *upipe, struct uref *uref,
             if (unlikely(uref->udict == NULL)) {
                 upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
                 uref_free(uref);
-                return;
+                return false;
             }
         }
         const char *name = NULL;
@@ -127,12 +126,25 @@ static void upipe_setattr_input(struct upipe *upipe, struct uref *uref,
             if (unlikely(v1 == NULL || v2 == NULL)) {
                 uref_free(uref);
                 upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-                return;
+                return false;
             }
             memcpy(v2, v1, size);
         }
     }
-    upipe_setattr_output(upipe, uref, upump_p);
+    return true;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_setattr_input(struct upipe *upipe, struct uref *uref,
+                                struct upump **upump_p)
+{
+    if (upipe_setattr_process(upipe, uref, upump_p))
+        upipe_setattr_output(upipe, uref, upump_p);
 }
 
 /** @internal @This sets the input flow definition.
@@ -203,6 +215,12 @@ static int upipe_setattr_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_setattr_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_GET_PROCESS: {
+            upipe_process_func *process_p =
+                va_arg(args, upipe_process_func *);
+            *process_p = upipe_setattr_process;
+            return UBASE_ERR_NONE;
+        }
 
         case UPIPE_SETATTR_GET_DICT: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_SETATTR_SIGNATURE)
@@ -106,6 +106,20 @@ static void upipe_setflowdef_input(struct upipe *upipe, struct uref *uref,
     upipe_setflowdef_output(upipe, uref, upump_p);
 }
 
+/** @internal @This processes a uref in place. Only the flow definition is
+ * changed, so urefs are left untouched.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref was dropped
+ */
+static bool upipe_setflowdef_process(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
+{
+    return true;
+}
+
 /** @internal @This builds the output flow definition.
  *
  * @param upipe description structure of the pipe
@@ -231,6 +245,12 @@ static int upipe_setflowdef_control(struct upipe *upipe, int command, va_list ar
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_setflowdef_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_GET_PROCESS: {
+            upipe_process_func *process_p =
+                va_arg(args, upipe_process_func *);
+            *process_p = upipe_setflowdef_process;
+            return UBASE_ERR_NONE;
+        }
 
         case UPIPE_SETFLOWDEF_GET_DICT: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_SETFLOWDEF_SIGNATURE)
@@ -90,14 +90,15 @@ static struct upipe *upipe_setrap_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
-/** @internal @This receives data.
+/** @internal @This processes a uref in place.
  *
  * @param upipe description structure of the pipe
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
+ * @return false if the uref was dropped
  */
-static void upipe_setrap_input(struct upipe *upipe, struct uref *uref,
-                               struct upump **upump_p)
+static bool upipe_setrap_process(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
 {
     struct upipe_setrap *upipe_setrap = upipe_setrap_from_upipe(upipe);
 
@@ -105,7 +106,20 @@ static void upipe_setrap_input(struct upipe *upipe, struct uref *uref,
         if (unlikely(!ubase_check(uref_clock_set_rap_sys(uref,
                             upipe_setrap->rap_sys))))
             upipe_dbg(upipe, "invalid clock ref for RAP");
-    upipe_setrap_output(upipe, uref, upump_p);
+    return true;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_setrap_input(struct upipe *upipe, struct uref *uref,
+                               struct upump **upump_p)
+{
+    if (upipe_setrap_process(upipe, uref, upump_p))
+        upipe_setrap_output(upipe, uref, upump_p);
 }
 
 /** @internal @This sets the input flow definition.
@@ -166,6 +180,12 @@ static int upipe_setrap_control(struct upipe *upipe, int command, va_list args)
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_setrap_set_flow_def(upipe, flow_def);
         }
+        case UPIPE_GET_PROCESS: {
+            upipe_process_func *process_p =
+                va_arg(args, upipe_process_func *);
+            *process_p = upipe_setrap_process;
+            return UBASE_ERR_NONE;
+        }
 
         case UPIPE_SETRAP_GET_RAP: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_SETRAP_SIGNATURE)
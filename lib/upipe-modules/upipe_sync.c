@@ -32,6 +32,7 @@
 #include "upipe/uref_clock.h"
 #include "upipe/uref_sound_flow.h"
 #include "upipe/uref_sound.h"
+#include "upipe/uref_sound_fifo.h"
 #include "upipe/uref_pic_flow.h"
 #include "upipe/uclock.h"
 #include "upipe/upipe.h"
@@ -159,11 +160,8 @@ struct upipe_sync_sub {
     /** channels */
     uint8_t channels;
 
-    /** linked list of buffered urefs */
-    struct uchain urefs;
-
-    /** buffered duration */
-    uint64_t samples;
+    /** FIFO of buffered sound */
+    struct uref_sound_fifo fifo;
 };
 
 UPIPE_HELPER_UPIPE(upipe_sync_sub, upipe, UPIPE_SYNC_SUB_SIGNATURE);
@@ -198,8 +196,7 @@ static struct upipe *upipe_sync_sub_alloc(struct upipe_mgr *mgr,
         return NULL;
 
     struct upipe_sync_sub *upipe_sync_sub = upipe_sync_sub_from_upipe(upipe);
-    ulist_init(&upipe_sync_sub->urefs);
-    upipe_sync_sub->samples = 0;
+    uref_sound_fifo_init(&upipe_sync_sub->fifo, 48000);
     upipe_sync_sub->sound = false;
     upipe_sync_sub->s337 = false;
     upipe_sync_sub->a52 = false;
@@ -423,7 +420,8 @@ static bool sync_channel(struct upipe *upipe)
     const bool a52 = upipe_sync_sub->a52;
 
     struct uchain *uchain_uref = NULL, *uchain_tmp;
-    ulist_delete_foreach(&upipe_sync_sub->urefs, uchain_uref, uchain_tmp) {
+    ulist_delete_foreach(&upipe_sync_sub->fifo.urefs, uchain_uref,
+                         uchain_tmp) {
         struct uref *uref = uref_from_uchain(uchain_uref);
 
         uint64_t pts = 0;
@@ -449,6 +447,7 @@ static bool sync_channel(struct upipe *upipe)
                             "LOLDROP, duration in CLOCK %" PRIu64 "", duration);
                     ulist_delete(uchain_uref);
                     uref_free(uref);
+                    upipe_sync_sub->fifo.samples -= samples;
                     continue;
                 }
                 if (!s337 || a52) {
@@ -460,7 +459,7 @@ static bool sync_channel(struct upipe *upipe)
                         uref_sound_resize(uref, 0, samples - drop_samples);
                     else
                         uref_sound_resize(uref, drop_samples, -1);
-                    upipe_sync_sub->samples -= drop_samples;
+                    upipe_sync_sub->fifo.samples -= drop_samples;
                     pts += pts_diff;
                     pts -= upipe_sync->latency;
                     uref_clock_set_pts_sys(uref, pts);
@@ -471,15 +470,16 @@ static bool sync_channel(struct upipe *upipe)
                         "DROP %.2f, duration in CLOCK %" PRIu64 "", f, duration);
                 ulist_delete(uchain_uref);
                 uref_free(uref);
-                upipe_sync_sub->samples -= samples;
+                upipe_sync_sub->fifo.samples -= samples;
                 continue;
             }
         }
     }
 
-    if (upipe_sync_sub->samples < 48000 * fps->den / fps->num)
-        upipe_notice_va(&upipe_sync_sub->upipe, "SAMPLES %" PRIu64, upipe_sync_sub->samples);
-    return upipe_sync_sub->samples >= 48000 * fps->den / fps->num;
+    uint64_t samples = uref_sound_fifo_samples(&upipe_sync_sub->fifo);
+    if (samples < 48000 * fps->den / fps->num)
+        upipe_notice_va(&upipe_sync_sub->upipe, "SAMPLES %" PRIu64, samples);
+    return samples >= 48000 * fps->den / fps->num;
 }
 
 static bool sync_audio(struct upipe *upipe)
@@ -552,22 +552,10 @@ static struct uref *get_silence(struct upipe *upipe, size_t samples)
     if (!upipe_sync_sub->uref_mgr || !upipe_sync_sub->ubuf_mgr)
         return NULL;
 
-    struct uref *uref = uref_sound_alloc(upipe_sync_sub->uref_mgr,
-            upipe_sync_sub->ubuf_mgr, samples);
-
+    struct uref *uref = uref_sound_fifo_silence(&upipe_sync_sub->fifo,
+            upipe_sync_sub->uref_mgr, upipe_sync_sub->ubuf_mgr, samples);
     if (!uref)
-        return NULL;
-
-    int32_t *buf;
-    if (!ubase_check(uref_sound_write_int32_t(uref, 0, -1, &buf, 1))) {
-        upipe_err_va(upipe, "Could not map uref");
-        return uref;
-    }
-
-    memset(buf, 0, samples * sizeof(int32_t) * upipe_sync_sub->channels);
-
-    uref_sound_unmap(uref, 0, -1, 1);
-
+        upipe_err_va(upipe, "Could not allocate silence");
     return uref;
 }
 
@@ -584,24 +572,22 @@ static void output_sound(struct upipe *upipe, const struct urational *fps,
             continue;
 
         struct upipe *upipe_sub = upipe_sync_sub_to_upipe(upipe_sync_sub);
-        const uint8_t channels = upipe_sync_sub->channels;
         size_t samples = frame_samples;
-        int wait = 0;
 
         const bool s337 = upipe_sync_sub->s337;
         const bool a52 = upipe_sync_sub->a52;
 
         if (s337 && !a52) {
             struct uref *uref = NULL;
-            struct uchain *uchain = ulist_peek(&upipe_sync_sub->urefs);
-            if (!uchain) {
+            struct uref *head = uref_sound_fifo_peek(&upipe_sync_sub->fifo);
+            if (!head) {
                 upipe_err_va(upipe_sub, "no urefs");
 
                 uref = upipe_sync_get_cached_compressed_audio(upipe_sub);
                 if (!uref)
                     continue;
             } else {
-                uref = uref_from_uchain(uchain);
+                uref = head;
 
                 uint64_t pts = 0;
                 uref_clock_get_pts_sys(uref, &pts);
@@ -615,7 +601,7 @@ static void output_sound(struct upipe *upipe, const struct urational *fps,
                     if (!uref)
                         continue;
                 } else {
-                    ulist_pop(&upipe_sync_sub->urefs);
+                    uref_sound_fifo_pop_uref(&upipe_sync_sub->fifo);
                     upipe_sync_sub->missed_compressed_audio_e = 0;
                     /* cache uref */
                     uref_free(upipe_sync_sub->uref);
@@ -625,7 +611,6 @@ static void output_sound(struct upipe *upipe, const struct urational *fps,
 
             size_t src_samples = 0;
             uref_sound_size(uref, &src_samples, NULL);
-            upipe_sync_sub->samples -= src_samples;
             uref_clock_set_pts_sys(uref, upipe_sync->pts - upipe_sync->latency);
             if (samples != src_samples) {
                 if (samples - 1 != src_samples && samples + 1 != src_samples) {
@@ -645,96 +630,33 @@ static void output_sound(struct upipe *upipe, const struct urational *fps,
         }
 
         /* look at first uref without dequeuing */
-        struct uref *src = uref_from_uchain(ulist_peek(&upipe_sync_sub->urefs));
-        if (!src) {
-            src = get_silence(upipe_sub, samples);
-            if (src)
-                uref_clock_set_pts_sys(src, upipe_sync->pts - upipe_sync->latency);
-        }
-        if (!src) {
-            upipe_dbg_va(upipe_sub, "no urefs");
-            continue;
-        }
-
-        uint64_t pts = 0;
-        uref_clock_get_pts_sys(src, &pts);
-        if (pts + upipe_sync->latency > upipe_sync->pts + upipe_sync->ticks_per_frame) {
-            upipe_warn_va(upipe_sub, "Waiting to buffer %.0f",
-                    pts_to_time(pts + upipe_sync->latency - upipe_sync->pts));
-
-            /* Although waiting to buffer, still output audio with corresponding video frame tick */
-            src = get_silence(upipe_sub, samples);
-            if (src) {
-                uref_clock_set_pts_sys(src, upipe_sync->pts - upipe_sync->latency);
-                size_t dup_samples;
-                ubase_assert(uref_sound_size(src, &dup_samples, NULL));
-                upipe_sync_sub->samples += dup_samples;
-                uref_clock_get_pts_sys(src, &pts);
-                wait = 1;
-            }
-            else {
-                upipe_dbg_va(upipe_sub, "no urefs");
-                continue;
+        struct uref *uref = uref_sound_fifo_peek(&upipe_sync_sub->fifo);
+        if (uref) {
+            uint64_t pts = 0;
+            uref_clock_get_pts_sys(uref, &pts);
+            if (pts + upipe_sync->latency > upipe_sync->pts + upipe_sync->ticks_per_frame) {
+                upipe_warn_va(upipe_sub, "Waiting to buffer %.0f",
+                        pts_to_time(pts + upipe_sync->latency - upipe_sync->pts));
+                uref = NULL;
             }
         }
 
-        /* output */
-        struct uref *uref = uref_dup_inner(src);
-        if (!uref)
-            upipe_err_va(upipe_sub, "Could not allocate ubuf");
-        uref->ubuf = ubuf_sound_alloc(src->ubuf->mgr, samples);
-        if (!uref->ubuf)
-            upipe_err_va(upipe_sub, "Could not allocate ubuf");
-        int32_t *dst_buf;
-        if (!ubase_check(uref_sound_write_int32_t(uref, 0, -1, &dst_buf, 1))) {
-            upipe_err_va(upipe_sub, "Could not map dst");
+        if (uref) {
+            /* shares the buffer when the first uref covers the period,
+             * pads with zeros when running short */
+            uref = uref_sound_fifo_pop(&upipe_sync_sub->fifo,
+                                       upipe_sync_sub->ubuf_mgr, samples);
+            if (!uref)
+                upipe_err_va(upipe_sub, "Could not allocate ubuf");
+        } else {
+            /* Although waiting to buffer, still output audio with corresponding video frame tick */
+            uref = get_silence(upipe_sub, samples);
         }
-        // map
-
-        while (samples) {
-            const int32_t *src_buf;
-            size_t src_samples = 0;
-            uref_sound_size(src, &src_samples, NULL);
-
-            if (!ubase_check(uref_sound_read_int32_t(src, 0, src_samples, &src_buf, 1))) {
-                upipe_err_va(upipe_sub, "Could not map src");
-            }
-
-            size_t uref_samples = src_samples;
-            if (uref_samples > samples) {
-                uref_samples = samples;
-            }
-
-            memcpy(dst_buf, src_buf, channels * sizeof(int32_t) * uref_samples);
-            dst_buf += channels * uref_samples;
-
-            uref_sound_unmap(src, 0, -1, 1);
-
-            src_samples -= uref_samples;
-            samples -= uref_samples;
-            upipe_sync_sub->samples -= uref_samples;
-            //upipe_notice_va(upipe_sub, "pop, samples %" PRIu64, upipe_sync_sub->samples);
-
-            if (src_samples == 0) {
-                if(!wait)
-                    ulist_pop(&upipe_sync_sub->urefs);
-                uref_free(src);
-                src = uref_from_uchain(ulist_peek(&upipe_sync_sub->urefs));
-                if (!src)
-                    break;
-            } else {
-                uref_sound_resize(src, uref_samples, -1);
-                assert(samples == 0);
-
-                uref_clock_get_pts_sys(src, &pts);
-                pts += uref_samples * UCLOCK_FREQ / 48000;
-                uref_clock_set_pts_sys(src, pts);
-            }
-
-            // TODO : next uref
+        if (!uref) {
+            upipe_dbg_va(upipe_sub, "no urefs");
+            continue;
         }
 
-        uref_sound_unmap(uref, 0, -1, 1);
         uref_clock_set_pts_sys(uref, upipe_sync->pts - upipe_sync->latency);
         upipe_sync_sub_output(upipe_sub, uref, upump_p);
     }
@@ -879,17 +801,11 @@ static void upipe_sync_sub_input(struct upipe *upipe, struct uref *uref,
 #endif
 
     /* buffer audio */
-    size_t samples = 0;
-    uref_sound_size(uref, &samples, NULL);
-    upipe_sync_sub->samples += samples;
-    //upipe_notice_va(upipe, "push, samples %" PRIu64, upipe_sync_sub->samples);
+    uref_sound_fifo_push(&upipe_sync_sub->fifo, uref);
 
-    ulist_add(&upipe_sync_sub->urefs, uref_to_uchain(uref));
-
-    if (unlikely(upipe_sync_sub->samples >= MAX_AUDIO_SAMPLES)) {
-        ulist_uref_flush(&upipe_sync_sub->urefs);
-        upipe_sync_sub->samples = 0;
-    }
+    if (unlikely(uref_sound_fifo_samples(&upipe_sync_sub->fifo) >=
+                 MAX_AUDIO_SAMPLES))
+        uref_sound_fifo_flush(&upipe_sync_sub->fifo);
 }
 
 /** @internal @This initializes the output manager for a dup set pipe.
@@ -1116,7 +1032,7 @@ static void upipe_sync_sub_free(struct upipe *upipe)
     struct upipe_sync_sub *upipe_sync_sub = upipe_sync_sub_from_upipe(upipe);
     upipe_throw_dead(upipe);
 
-    ulist_uref_flush(&upipe_sync_sub->urefs);
+    uref_sound_fifo_clean(&upipe_sync_sub->fifo);
     uref_free(upipe_sync_sub->uref);
 
     upipe_sync_sub_clean_urefcount(upipe);
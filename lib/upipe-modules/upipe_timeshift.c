@@ -0,0 +1,884 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe module keeping the last minutes of a flow in memory
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uprobe.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_flow.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_subpipe.h"
+#include "upipe/upipe_helper_upump_mgr.h"
+#include "upipe/upipe_helper_upump.h"
+#include "upipe-modules/upipe_timeshift.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+
+/** initial number of entries of the ring */
+#define UPIPE_TIMESHIFT_INIT_ENTRIES 1024
+
+/** @internal @This is a uref kept in the ring. */
+struct upipe_timeshift_entry {
+    /** uref */
+    struct uref *uref;
+    /** date in system time, never decreasing along the ring */
+    uint64_t date;
+    /** size of the block payload */
+    uint64_t size;
+    /** identifier of the flow definition of the uref */
+    uint64_t flow_id;
+    /** true if the uref is a random access point */
+    bool random;
+};
+
+/** @internal @This is a flow definition which applies to urefs of the
+ * ring. */
+struct upipe_timeshift_flow {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** identifier of the flow definition */
+    uint64_t id;
+    /** flow definition packet */
+    struct uref *flow_def;
+};
+
+UBASE_FROM_TO(upipe_timeshift_flow, uchain, uchain, uchain)
+
+/** @internal @This is the private context of a timeshift pipe. */
+struct upipe_timeshift {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of output subpipes */
+    struct uchain outputs;
+    /** manager to create output subpipes */
+    struct upipe_mgr sub_mgr;
+
+    /** ring of entries, of a power of 2 size */
+    struct upipe_timeshift_entry *entries;
+    /** allocated number of entries */
+    uint64_t entries_size;
+    /** index of the oldest entry in the ring */
+    uint64_t first;
+    /** number of entries in the ring */
+    uint64_t nb;
+    /** sequence number of the oldest entry */
+    uint64_t first_seq;
+    /** total size of the block payloads of the ring */
+    uint64_t size;
+    /** date of the newest entry */
+    uint64_t last_date;
+    /** true if a random access point was received */
+    bool has_random;
+
+    /** maximum duration of the ring */
+    uint64_t max_duration;
+    /** maximum size of the ring */
+    uint64_t max_size;
+
+    /** list of flow definitions applying to the ring, oldest first */
+    struct uchain flow_defs;
+    /** identifier of the last flow definition */
+    uint64_t flow_id;
+    /** true if the input was released */
+    bool ended;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_timeshift, upipe, UPIPE_TIMESHIFT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_timeshift, urefcount, upipe_timeshift_no_input)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_timeshift, urefcount_real,
+                            upipe_timeshift_free)
+UPIPE_HELPER_VOID(upipe_timeshift)
+
+/** @internal @This is the private context of a reader of a timeshift
+ * pipe. */
+struct upipe_timeshift_output {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** read idler */
+    struct upump *upump;
+
+    /** sequence number of the next uref to output */
+    uint64_t seq;
+    /** identifier of the flow definition last output, or 0 */
+    uint64_t flow_id;
+    /** true if the end of the source was thrown */
+    bool ended;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_timeshift_output, upipe,
+                   UPIPE_TIMESHIFT_OUTPUT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_timeshift_output, urefcount,
+                       upipe_timeshift_output_free)
+UPIPE_HELPER_VOID(upipe_timeshift_output)
+UPIPE_HELPER_OUTPUT(upipe_timeshift_output, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UPUMP_MGR(upipe_timeshift_output, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_timeshift_output, upump, upump_mgr)
+
+UPIPE_HELPER_SUBPIPE(upipe_timeshift, upipe_timeshift_output, output, sub_mgr,
+                     outputs, uchain)
+
+/** @internal @This returns the entry of the given sequence number.
+ *
+ * @param upipe_timeshift private context of the timeshift pipe
+ * @param seq sequence number, in the ring
+ * @return pointer to the entry
+ */
+static inline struct upipe_timeshift_entry *
+    upipe_timeshift_entry(struct upipe_timeshift *upipe_timeshift, uint64_t seq)
+{
+    return &upipe_timeshift->entries[(upipe_timeshift->first + seq -
+                                      upipe_timeshift->first_seq) &
+                                     (upipe_timeshift->entries_size - 1)];
+}
+
+/** @internal @This returns the sequence number following the newest entry.
+ *
+ * @param upipe_timeshift private context of the timeshift pipe
+ * @return sequence number of the next input uref
+ */
+static inline uint64_t
+    upipe_timeshift_end(struct upipe_timeshift *upipe_timeshift)
+{
+    return upipe_timeshift->first_seq + upipe_timeshift->nb;
+}
+
+/** @internal @This returns the flow definition of the given identifier.
+ *
+ * @param upipe_timeshift private context of the timeshift pipe
+ * @param id identifier of the flow definition
+ * @return pointer to the flow definition, or NULL
+ */
+static struct uref *
+    upipe_timeshift_flow_def(struct upipe_timeshift *upipe_timeshift,
+                             uint64_t id)
+{
+    struct uchain *uchain;
+    ulist_foreach (&upipe_timeshift->flow_defs, uchain) {
+        struct upipe_timeshift_flow *flow =
+            upipe_timeshift_flow_from_uchain(uchain);
+        if (flow->id == id)
+            return flow->flow_def;
+    }
+    return NULL;
+}
+
+/** @internal @This outputs the next uref of a reader.
+ *
+ * @param upump description structure of the idler
+ */
+static void upipe_timeshift_output_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_timeshift_output *upipe_timeshift_output =
+        upipe_timeshift_output_from_upipe(upipe);
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_sub_mgr(upipe->mgr);
+
+    if (upipe_timeshift_output->seq >= upipe_timeshift_end(upipe_timeshift)) {
+        upump_stop(upump);
+        if (upipe_timeshift->ended && !upipe_timeshift_output->ended) {
+            upipe_timeshift_output->ended = true;
+            upipe_throw_source_end(upipe);
+        }
+        return;
+    }
+
+    struct upipe_timeshift_entry *entry =
+        upipe_timeshift_entry(upipe_timeshift, upipe_timeshift_output->seq);
+    struct uref *uref = uref_dup(entry->uref);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    if (entry->flow_id != upipe_timeshift_output->flow_id) {
+        struct uref *flow_def =
+            upipe_timeshift_flow_def(upipe_timeshift, entry->flow_id);
+        if (flow_def != NULL && (flow_def = uref_dup(flow_def)) == NULL) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_timeshift_output->flow_id = entry->flow_id;
+        upipe_timeshift_output_store_flow_def(upipe, flow_def);
+    }
+
+    upipe_timeshift_output->seq++;
+    upipe_timeshift_output_output(upipe, uref, &upipe_timeshift_output->upump);
+}
+
+/** @internal @This starts the idler of a reader which has urefs to output,
+ * or which must throw the end of the source.
+ *
+ * @param upipe description structure of the reader
+ */
+static void upipe_timeshift_output_wake(struct upipe *upipe)
+{
+    struct upipe_timeshift_output *upipe_timeshift_output =
+        upipe_timeshift_output_from_upipe(upipe);
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_sub_mgr(upipe->mgr);
+    if (upipe_timeshift_output->upump != NULL &&
+        (upipe_timeshift_output->seq < upipe_timeshift_end(upipe_timeshift) ||
+         (upipe_timeshift->ended && !upipe_timeshift_output->ended)))
+        upump_start(upipe_timeshift_output->upump);
+}
+
+/** @internal @This allocates a reader of a timeshift pipe, at the live
+ * point.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_timeshift_output_alloc(struct upipe_mgr *mgr,
+                                                  struct uprobe *uprobe,
+                                                  uint32_t signature,
+                                                  va_list args)
+{
+    if (mgr->signature != UPIPE_TIMESHIFT_OUTPUT_SIGNATURE)
+        return NULL;
+
+    struct upipe *upipe =
+        upipe_timeshift_output_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_timeshift_output *upipe_timeshift_output =
+        upipe_timeshift_output_from_upipe(upipe);
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_sub_mgr(mgr);
+    upipe_timeshift_output_init_urefcount(upipe);
+    upipe_timeshift_output_init_output(upipe);
+    upipe_timeshift_output_init_upump_mgr(upipe);
+    upipe_timeshift_output_init_upump(upipe);
+    upipe_timeshift_output_init_sub(upipe);
+    upipe_timeshift_output->seq = upipe_timeshift_end(upipe_timeshift);
+    upipe_timeshift_output->flow_id = 0;
+    upipe_timeshift_output->ended = false;
+
+    upipe_throw_ready(upipe);
+
+    struct uref *flow_def =
+        upipe_timeshift_flow_def(upipe_timeshift, upipe_timeshift->flow_id);
+    if (flow_def != NULL) {
+        if (unlikely((flow_def = uref_dup(flow_def)) == NULL)) {
+            upipe_release(upipe);
+            return NULL;
+        }
+        upipe_timeshift_output->flow_id = upipe_timeshift->flow_id;
+        upipe_timeshift_output_store_flow_def(upipe, flow_def);
+    }
+    return upipe;
+}
+
+/** @internal @This moves a reader to the given date.
+ *
+ * @param upipe description structure of the reader
+ * @param date cr_sys date, or UPIPE_TIMESHIFT_LIVE
+ * @return an error code
+ */
+static int upipe_timeshift_output_set_position(struct upipe *upipe,
+                                               uint64_t date)
+{
+    struct upipe_timeshift_output *upipe_timeshift_output =
+        upipe_timeshift_output_from_upipe(upipe);
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_sub_mgr(upipe->mgr);
+    uint64_t first = upipe_timeshift->first_seq;
+    uint64_t end = upipe_timeshift_end(upipe_timeshift);
+    upipe_timeshift_output->ended = false;
+    if (date == UPIPE_TIMESHIFT_LIVE || first == end) {
+        upipe_timeshift_output->seq = end;
+        return UBASE_ERR_NONE;
+    }
+
+    /* first entry at or after the date */
+    uint64_t low = first;
+    uint64_t high = end;
+    while (low < high) {
+        uint64_t mid = low + (high - low) / 2;
+        if (upipe_timeshift_entry(upipe_timeshift, mid)->date < date)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (upipe_timeshift->has_random) {
+        /* last random access point at or before the date, or else the
+         * first one after it */
+        uint64_t seq = low < end ? low + 1 : end;
+        while (seq > first) {
+            struct upipe_timeshift_entry *entry =
+                upipe_timeshift_entry(upipe_timeshift, --seq);
+            if (entry->random && entry->date <= date) {
+                upipe_timeshift_output->seq = seq;
+                return UBASE_ERR_NONE;
+            }
+        }
+        for (seq = low; seq < end; seq++)
+            if (upipe_timeshift_entry(upipe_timeshift, seq)->random)
+                break;
+        if (seq < end)
+            low = seq;
+    }
+    upipe_timeshift_output->seq = low;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the date of the next uref of a reader.
+ *
+ * @param upipe description structure of the reader
+ * @param date_p filled in with the date, or UPIPE_TIMESHIFT_LIVE
+ * @return an error code
+ */
+static int upipe_timeshift_output_get_position(struct upipe *upipe,
+                                               uint64_t *date_p)
+{
+    struct upipe_timeshift_output *upipe_timeshift_output =
+        upipe_timeshift_output_from_upipe(upipe);
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_sub_mgr(upipe->mgr);
+    if (upipe_timeshift_output->seq < upipe_timeshift_end(upipe_timeshift))
+        *date_p = upipe_timeshift_entry(upipe_timeshift,
+                                        upipe_timeshift_output->seq)->date;
+    else
+        *date_p = UPIPE_TIMESHIFT_LIVE;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This allocates the idler of a reader if possible, and starts
+ * it if needed.
+ *
+ * @param upipe description structure of the reader
+ * @return an error code
+ */
+static int upipe_timeshift_output_check(struct upipe *upipe)
+{
+    struct upipe_timeshift_output *upipe_timeshift_output =
+        upipe_timeshift_output_from_upipe(upipe);
+    upipe_timeshift_output_check_upump_mgr(upipe);
+    if (upipe_timeshift_output->upump_mgr == NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_timeshift_output->upump == NULL) {
+        struct upump *upump =
+            upump_alloc_idler(upipe_timeshift_output->upump_mgr,
+                              upipe_timeshift_output_worker, upipe,
+                              upipe->refcount);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_timeshift_output_set_upump(upipe, upump);
+    }
+    upipe_timeshift_output_wake(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a reader of a timeshift
+ * pipe.
+ *
+ * @param upipe description structure of the reader
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int _upipe_timeshift_output_control(struct upipe *upipe,
+                                           int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_timeshift_output_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_timeshift_output_set_upump(upipe, NULL);
+            return upipe_timeshift_output_attach_upump_mgr(upipe);
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_timeshift_output_control_output(upipe, command,
+                                                         args);
+        case UPIPE_SRC_GET_POSITION: {
+            uint64_t *date_p = va_arg(args, uint64_t *);
+            return upipe_timeshift_output_get_position(upipe, date_p);
+        }
+        case UPIPE_SRC_SET_POSITION: {
+            uint64_t date = va_arg(args, uint64_t);
+            return upipe_timeshift_output_set_position(upipe, date);
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes control commands on a reader of a timeshift
+ * pipe, and checks the status of the reader afterwards.
+ *
+ * @param upipe description structure of the reader
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_timeshift_output_control(struct upipe *upipe,
+                                          int command, va_list args)
+{
+    UBASE_RETURN(_upipe_timeshift_output_control(upipe, command, args))
+    return upipe_timeshift_output_check(upipe);
+}
+
+/** @This frees a reader.
+ *
+ * @param upipe description structure of the reader
+ */
+static void upipe_timeshift_output_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_timeshift_output_clean_upump(upipe);
+    upipe_timeshift_output_clean_upump_mgr(upipe);
+    upipe_timeshift_output_clean_output(upipe);
+    upipe_timeshift_output_clean_sub(upipe);
+    upipe_timeshift_output_clean_urefcount(upipe);
+    upipe_timeshift_output_free_void(upipe);
+}
+
+/** @internal @This initializes the output manager for a timeshift pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_timeshift_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_timeshift->sub_mgr;
+    sub_mgr->refcount = upipe_timeshift_to_urefcount_real(upipe_timeshift);
+    sub_mgr->signature = UPIPE_TIMESHIFT_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_timeshift_output_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_timeshift_output_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a timeshift pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_timeshift_alloc(struct upipe_mgr *mgr,
+                                           struct uprobe *uprobe,
+                                           uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_timeshift_alloc_void(mgr, uprobe, signature,
+                                                     args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    upipe_timeshift_init_urefcount(upipe);
+    upipe_timeshift_init_urefcount_real(upipe);
+    upipe_timeshift_init_sub_outputs(upipe);
+    upipe_timeshift_init_sub_mgr(upipe);
+    upipe_timeshift->entries = NULL;
+    upipe_timeshift->entries_size = 0;
+    upipe_timeshift->first = 0;
+    upipe_timeshift->nb = 0;
+    upipe_timeshift->first_seq = 0;
+    upipe_timeshift->size = 0;
+    upipe_timeshift->last_date = 0;
+    upipe_timeshift->has_random = false;
+    upipe_timeshift->max_duration = UPIPE_TIMESHIFT_DEF_DURATION;
+    upipe_timeshift->max_size = UPIPE_TIMESHIFT_DEF_SIZE;
+    ulist_init(&upipe_timeshift->flow_defs);
+    upipe_timeshift->flow_id = 0;
+    upipe_timeshift->ended = false;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This drops the flow definitions which no longer apply to any
+ * uref of the ring, except the last one.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_timeshift_trim_flow_defs(struct upipe *upipe)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    uint64_t oldest = upipe_timeshift->flow_id;
+    if (upipe_timeshift->nb)
+        oldest = upipe_timeshift_entry(upipe_timeshift,
+                    upipe_timeshift->first_seq)->flow_id;
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_timeshift->flow_defs, uchain, uchain_tmp) {
+        struct upipe_timeshift_flow *flow =
+            upipe_timeshift_flow_from_uchain(uchain);
+        if (flow->id >= oldest)
+            break;
+        ulist_delete(uchain);
+        uref_free(flow->flow_def);
+        free(flow);
+    }
+}
+
+/** @internal @This drops the oldest urefs beyond the limits of the ring, and
+ * moves the readers which were still to output them.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_timeshift_trim(struct upipe *upipe)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    uint64_t dropped = 0;
+    while (upipe_timeshift->nb > 1) {
+        struct upipe_timeshift_entry *entry =
+            upipe_timeshift_entry(upipe_timeshift, upipe_timeshift->first_seq);
+        if (upipe_timeshift->size <= upipe_timeshift->max_size &&
+            upipe_timeshift->last_date - entry->date <=
+                upipe_timeshift->max_duration)
+            break;
+
+        uref_free(entry->uref);
+        upipe_timeshift->size -= entry->size;
+        upipe_timeshift->first = (upipe_timeshift->first + 1) &
+                                 (upipe_timeshift->entries_size - 1);
+        upipe_timeshift->first_seq++;
+        upipe_timeshift->nb--;
+        dropped++;
+    }
+    if (!dropped)
+        return;
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_timeshift->outputs, uchain) {
+        struct upipe_timeshift_output *upipe_timeshift_output =
+            upipe_timeshift_output_from_uchain(uchain);
+        if (upipe_timeshift_output->seq >= upipe_timeshift->first_seq)
+            continue;
+        upipe_warn_va(upipe_timeshift_output_to_upipe(upipe_timeshift_output),
+                      "reader overrun, skipping %"PRIu64" urefs",
+                      upipe_timeshift->first_seq - upipe_timeshift_output->seq);
+        upipe_timeshift_output->seq = upipe_timeshift->first_seq;
+    }
+    upipe_timeshift_trim_flow_defs(upipe);
+}
+
+/** @internal @This doubles the number of entries of the ring.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_timeshift_grow(struct upipe *upipe)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    uint64_t entries_size = upipe_timeshift->entries_size ?
+        upipe_timeshift->entries_size * 2 : UPIPE_TIMESHIFT_INIT_ENTRIES;
+    struct upipe_timeshift_entry *entries =
+        malloc(entries_size * sizeof(struct upipe_timeshift_entry));
+    UBASE_ALLOC_RETURN(entries)
+
+    for (uint64_t i = 0; i < upipe_timeshift->nb; i++)
+        entries[i] = *upipe_timeshift_entry(upipe_timeshift,
+                                            upipe_timeshift->first_seq + i);
+    free(upipe_timeshift->entries);
+    upipe_timeshift->entries = entries;
+    upipe_timeshift->entries_size = entries_size;
+    upipe_timeshift->first = 0;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_timeshift_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    if (unlikely(!upipe_timeshift->flow_id)) {
+        upipe_warn(upipe, "received a buffer before the flow definition");
+        uref_free(uref);
+        return;
+    }
+
+    if (upipe_timeshift->nb == upipe_timeshift->entries_size &&
+        unlikely(!ubase_check(upipe_timeshift_grow(upipe)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    uint64_t date = upipe_timeshift->last_date;
+    uref_clock_get_cr_sys(uref, &date);
+    if (unlikely(date < upipe_timeshift->last_date))
+        /* keep the ring sorted */
+        date = upipe_timeshift->last_date;
+    size_t size = 0;
+    uref_block_size(uref, &size);
+
+    struct upipe_timeshift_entry *entry =
+        upipe_timeshift_entry(upipe_timeshift,
+                              upipe_timeshift_end(upipe_timeshift));
+    entry->uref = uref;
+    entry->date = date;
+    entry->size = size;
+    entry->flow_id = upipe_timeshift->flow_id;
+    entry->random = ubase_check(uref_flow_get_random(uref));
+    upipe_timeshift->nb++;
+    upipe_timeshift->size += size;
+    upipe_timeshift->last_date = date;
+    upipe_timeshift->has_random |= entry->random;
+    upipe_timeshift_trim(upipe);
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_timeshift->outputs, uchain) {
+        struct upipe_timeshift_output *upipe_timeshift_output =
+            upipe_timeshift_output_from_uchain(uchain);
+        upipe_timeshift_output_wake(
+            upipe_timeshift_output_to_upipe(upipe_timeshift_output));
+    }
+}
+
+/** @internal @This sets the flow definition of the next urefs.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def new flow definition
+ * @return an error code
+ */
+static int upipe_timeshift_set_flow_def(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+
+    struct upipe_timeshift_flow *flow =
+        malloc(sizeof(struct upipe_timeshift_flow));
+    UBASE_ALLOC_RETURN(flow)
+    flow->flow_def = uref_dup(flow_def);
+    if (unlikely(flow->flow_def == NULL)) {
+        free(flow);
+        return UBASE_ERR_ALLOC;
+    }
+    flow->id = ++upipe_timeshift->flow_id;
+    uchain_init(&flow->uchain);
+    ulist_add(&upipe_timeshift->flow_defs, &flow->uchain);
+    upipe_timeshift_trim_flow_defs(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the limits of the ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param duration maximum duration
+ * @param size maximum size, in octets
+ * @return an error code
+ */
+static int _upipe_timeshift_set_limits(struct upipe *upipe,
+                                       uint64_t duration, uint64_t size)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    upipe_timeshift->max_duration = duration;
+    upipe_timeshift->max_size = size;
+    upipe_timeshift_trim(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a timeshift pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_timeshift_control(struct upipe *upipe, int command,
+                                   va_list args)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    UBASE_HANDLED_RETURN(upipe_timeshift_control_outputs(upipe, command,
+                                                         args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_timeshift_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_TIMESHIFT_GET_LIMITS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TIMESHIFT_SIGNATURE)
+            uint64_t *duration_p = va_arg(args, uint64_t *);
+            uint64_t *size_p = va_arg(args, uint64_t *);
+            *duration_p = upipe_timeshift->max_duration;
+            *size_p = upipe_timeshift->max_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TIMESHIFT_SET_LIMITS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TIMESHIFT_SIGNATURE)
+            uint64_t duration = va_arg(args, uint64_t);
+            uint64_t size = va_arg(args, uint64_t);
+            return _upipe_timeshift_set_limits(upipe, duration, size);
+        }
+        case UPIPE_TIMESHIFT_GET_RANGE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TIMESHIFT_SIGNATURE)
+            uint64_t *first_p = va_arg(args, uint64_t *);
+            uint64_t *last_p = va_arg(args, uint64_t *);
+            if (!upipe_timeshift->nb)
+                return UBASE_ERR_INVALID;
+            *first_p = upipe_timeshift_entry(upipe_timeshift,
+                            upipe_timeshift->first_seq)->date;
+            *last_p = upipe_timeshift->last_date;
+            return UBASE_ERR_NONE;
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_timeshift_free(struct upipe *upipe)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    for (uint64_t i = 0; i < upipe_timeshift->nb; i++)
+        uref_free(upipe_timeshift_entry(upipe_timeshift,
+                    upipe_timeshift->first_seq + i)->uref);
+    free(upipe_timeshift->entries);
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_timeshift->flow_defs, uchain, uchain_tmp) {
+        struct upipe_timeshift_flow *flow =
+            upipe_timeshift_flow_from_uchain(uchain);
+        ulist_delete(uchain);
+        uref_free(flow->flow_def);
+        free(flow);
+    }
+
+    upipe_timeshift_clean_sub_outputs(upipe);
+    upipe_timeshift_clean_urefcount_real(upipe);
+    upipe_timeshift_clean_urefcount(upipe);
+    upipe_timeshift_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ * The readers throw the end of the source once they have output the whole
+ * ring.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_timeshift_no_input(struct upipe *upipe)
+{
+    struct upipe_timeshift *upipe_timeshift =
+        upipe_timeshift_from_upipe(upipe);
+    upipe_timeshift->ended = true;
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_timeshift->outputs, uchain) {
+        struct upipe_timeshift_output *upipe_timeshift_output =
+            upipe_timeshift_output_from_uchain(uchain);
+        upipe_timeshift_output_wake(
+            upipe_timeshift_output_to_upipe(upipe_timeshift_output));
+    }
+    upipe_timeshift_release_urefcount_real(upipe);
+}
+
+/** timeshift module manager static descriptor */
+static struct upipe_mgr upipe_timeshift_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_TIMESHIFT_SIGNATURE,
+
+    .upipe_alloc = upipe_timeshift_alloc,
+    .upipe_input = upipe_timeshift_input,
+    .upipe_control = upipe_timeshift_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all timeshift pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_timeshift_mgr_alloc(void)
+{
+    return &upipe_timeshift_mgr;
+}
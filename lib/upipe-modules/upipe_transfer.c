@@ -30,11 +30,14 @@
 
 #include "upipe/ubase.h"
 #include "upipe/urefcount.h"
+#include "upipe/uatomic.h"
+#include "upipe/uclock.h"
 #include "upipe/umutex.h"
 #include "upipe/ulifo.h"
 #include "upipe/uqueue.h"
 #include "upipe/uprobe.h"
 #include "upipe/upump.h"
+#include "upipe/usdt.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
 #include "upipe/upipe_helper_urefcount_real.h"
@@ -45,9 +48,19 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include <assert.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+/** maximum number of messages handled per batch */
+#define UPIPE_XFER_BATCH 32
 
 /** @internal @This is the private context of a xfer pipe manager. */
 struct upipe_xfer_mgr {
@@ -63,8 +76,12 @@ struct upipe_xfer_mgr {
     struct upump *upump;
     /** remote upump_mgr */
     struct upump_mgr *upump_mgr;
+    /** kernel ID of the remote thread, or 0 before attach */
+    uatomic_uint32_t thread;
+    /** monotonic date of the attach, in 27 MHz units */
+    uint64_t attach_date;
     /** queue length */
-    uint8_t queue_length;
+    unsigned int queue_length;
     /** queue of messages */
     struct uqueue uqueue;
     /** pool of @ref upipe_xfer_msg */
@@ -262,6 +279,7 @@ static int upipe_xfer_probe(struct uprobe *uprobe, struct upipe *remote,
         upipe_xfer_msg_free(upipe->mgr, msg);
         return UBASE_ERR_EXTERNAL;
     }
+    UPIPE_USDT(xfer_event_send, upipe, event);
 
     return UBASE_ERR_NONE;
 }
@@ -360,33 +378,40 @@ static void upipe_xfer_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_xfer *upipe_xfer = upipe_xfer_from_upipe(upipe);
-    struct upipe_xfer_msg *msg;
-    while ((msg = uqueue_pop(&upipe_xfer->uqueue,
-                             struct upipe_xfer_msg *)) != NULL) {
-        switch (msg->type) {
-            case UPROBE_DEAD:
-                upipe_xfer_release_urefcount_real(upipe);
-                break;
-            case UPROBE_XFER_VOID:
-                if (upipe_xfer->upipe_remote == msg->upipe_remote)
-                    upipe_throw(upipe, msg->arg.event);
-                break;
-            case UPROBE_XFER_UINT64_T:
-                if (upipe_xfer->upipe_remote == msg->upipe_remote)
-                    upipe_throw(upipe, msg->arg.event, msg->event_arg.u64);
-                break;
-            case UPROBE_XFER_UNSIGNED_LONG_LOCAL:
-                if (upipe_xfer->upipe_remote == msg->upipe_remote)
-                    upipe_throw(upipe, msg->arg.event, msg->event_signature,
-                                msg->event_arg.ulong);
-                break;
-            default:
-                /* this should not happen */
-                break;
-        }
+    struct upipe_xfer_msg *msgs[UPIPE_XFER_BATCH];
+    unsigned int nb;
+    while ((nb = uqueue_pop_batch(&upipe_xfer->uqueue, (void **)msgs,
+                                  UPIPE_XFER_BATCH))) {
+        for (unsigned int i = 0; i < nb; i++) {
+            struct upipe_xfer_msg *msg = msgs[i];
+            UPIPE_USDT(xfer_event_recv, upipe, msg->arg.event);
+            switch (msg->type) {
+                case UPROBE_DEAD:
+                    upipe_xfer_release_urefcount_real(upipe);
+                    break;
+                case UPROBE_XFER_VOID:
+                    if (upipe_xfer->upipe_remote == msg->upipe_remote)
+                        upipe_throw(upipe, msg->arg.event);
+                    break;
+                case UPROBE_XFER_UINT64_T:
+                    if (upipe_xfer->upipe_remote == msg->upipe_remote)
+                        upipe_throw(upipe, msg->arg.event,
+                                    msg->event_arg.u64);
+                    break;
+                case UPROBE_XFER_UNSIGNED_LONG_LOCAL:
+                    if (upipe_xfer->upipe_remote == msg->upipe_remote)
+                        upipe_throw(upipe, msg->arg.event,
+                                    msg->event_signature,
+                                    msg->event_arg.ulong);
+                    break;
+                default:
+                    /* this should not happen */
+                    break;
+            }
 
-        upipe_xfer_msg_free(upipe->mgr, msg);
-        upipe_xfer_release_urefcount_real(upipe);
+            upipe_xfer_msg_free(upipe->mgr, msg);
+            upipe_xfer_release_urefcount_real(upipe);
+        }
     }
 }
 
@@ -515,6 +540,7 @@ static void upipe_xfer_mgr_free(struct upipe_mgr *mgr)
     upump_free(xfer_mgr->upump);
     upump_mgr_release(xfer_mgr->upump_mgr);
     uqueue_clean(&xfer_mgr->uqueue);
+    uatomic_clean(&xfer_mgr->thread);
     umutex_release(xfer_mgr->mutex);
     upipe_xfer_mgr_vacuum(mgr);
     free(xfer_mgr);
@@ -528,34 +554,45 @@ static void upipe_xfer_mgr_worker(struct upump *upump)
 {
     struct upipe_mgr *mgr = upump_get_opaque(upump, struct upipe_mgr *);
     struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
-    struct upipe_xfer_msg *msg;
-    while ((msg = uqueue_pop(&xfer_mgr->uqueue,
-                             struct upipe_xfer_msg *)) != NULL) {
-        switch (msg->type) {
-            case UPIPE_XFER_ATTACH_UPUMP_MGR:
-                upipe_attach_upump_mgr(msg->upipe_remote);
-                break;
-            case UPIPE_XFER_SET_URI:
-                upipe_set_uri(msg->upipe_remote, msg->arg.string);
-                free(msg->arg.string);
-                break;
-            case UPIPE_XFER_SET_OUTPUT:
-                upipe_set_output(msg->upipe_remote, msg->arg.pipe);
-                upipe_release(msg->arg.pipe);
-                break;
-            case UPIPE_XFER_RELEASE:
-                upipe_release(msg->upipe_remote);
-                break;
-            case UPIPE_XFER_DETACH:
-                upipe_xfer_msg_free(mgr, msg);
-                upipe_xfer_mgr_free(mgr);
-                return;
-            default:
-                /* this should not happen */
-                break;
+    struct upipe_xfer_msg *msgs[UPIPE_XFER_BATCH];
+    unsigned int nb;
+    while ((nb = uqueue_pop_batch(&xfer_mgr->uqueue, (void **)msgs,
+                                  UPIPE_XFER_BATCH))) {
+        bool detach = false;
+        for (unsigned int i = 0; i < nb; i++) {
+            struct upipe_xfer_msg *msg = msgs[i];
+            UPIPE_USDT(xfer_recv, mgr, msg->type, msg->upipe_remote);
+            switch (msg->type) {
+                case UPIPE_XFER_ATTACH_UPUMP_MGR:
+                    upipe_attach_upump_mgr(msg->upipe_remote);
+                    break;
+                case UPIPE_XFER_SET_URI:
+                    upipe_set_uri(msg->upipe_remote, msg->arg.string);
+                    free(msg->arg.string);
+                    break;
+                case UPIPE_XFER_SET_OUTPUT:
+                    upipe_set_output(msg->upipe_remote, msg->arg.pipe);
+                    upipe_release(msg->arg.pipe);
+                    break;
+                case UPIPE_XFER_RELEASE:
+                    upipe_release(msg->upipe_remote);
+                    break;
+                case UPIPE_XFER_DETACH:
+                    /* the manager is freed once the batch is handled */
+                    detach = true;
+                    break;
+                default:
+                    /* this should not happen */
+                    break;
+            }
+
+            upipe_xfer_msg_free(mgr, msg);
         }
 
-        upipe_xfer_msg_free(mgr, msg);
+        if (detach) {
+            upipe_xfer_mgr_free(mgr);
+            return;
+        }
     }
 }
 
@@ -584,6 +621,7 @@ static int upipe_xfer_mgr_send(struct upipe_mgr *mgr, int type,
         upipe_xfer_msg_free(mgr, msg);
         return UBASE_ERR_EXTERNAL;
     }
+    UPIPE_USDT(xfer_send, mgr, type, upipe_remote);
     return UBASE_ERR_NONE;
 }
 
@@ -604,6 +642,18 @@ static void upipe_xfer_mgr_detach(struct urefcount *urefcount)
                         UPIPE_XFER_DETACH, NULL, arg);
 }
 
+/** @internal @This returns the monotonic date, in 27 MHz units.
+ *
+ * @return current date
+ */
+static uint64_t upipe_xfer_mgr_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * UCLOCK_FREQ +
+           (uint64_t)ts.tv_nsec * 27 / 1000;
+}
+
 /** @This attaches a upipe_xfer_mgr to a given event loop. The xfer manager
  * will call upump_alloc_XXX and upump_start, so it must be done in a context
  * where it is possible, which generally means that this command is done in
@@ -633,6 +683,11 @@ static int _upipe_xfer_mgr_attach(struct upipe_mgr *mgr,
     xfer_mgr->upump_mgr = upump_mgr;
     upump_mgr_use(upump_mgr);
     upump_start(xfer_mgr->upump);
+
+#ifdef __linux__
+    xfer_mgr->attach_date = upipe_xfer_mgr_now();
+    uatomic_store(&xfer_mgr->thread, syscall(SYS_gettid));
+#endif
     return UBASE_ERR_NONE;
 }
 
@@ -667,6 +722,90 @@ static inline int _upipe_xfer_mgr_thaw(struct upipe_mgr *mgr)
     return err;
 }
 
+/** @internal @This sets the busy-poll duration of the command queue.
+ *
+ * @param mgr xfer_mgr structure
+ * @param spin_duration maximum polling duration, in 27 MHz units, or 0 to
+ * disable polling
+ * @return an error code
+ */
+static int _upipe_xfer_mgr_set_spin(struct upipe_mgr *mgr,
+                                    uint64_t spin_duration)
+{
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+    uint64_t spin_ns = spin_duration * 1000 / 27;
+    if (spin_duration > UINT32_MAX || spin_ns > UINT32_MAX)
+        return UBASE_ERR_INVALID;
+    uqueue_set_spin(&xfer_mgr->uqueue, spin_ns);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the CPU accounting of the remote thread, read
+ * from the files the kernel exports for each thread of the process.
+ *
+ * @param mgr xfer_mgr structure
+ * @param stats filled in with the accounting of the thread
+ * @return an error code
+ */
+static int _upipe_xfer_mgr_get_thread_stats(struct upipe_mgr *mgr,
+        struct upipe_xfer_thread_stats *stats)
+{
+    struct upipe_xfer_mgr *xfer_mgr = upipe_xfer_mgr_from_upipe_mgr(mgr);
+    uint32_t thread = uatomic_load(&xfer_mgr->thread);
+    if (unlikely(!thread))
+        return UBASE_ERR_INVALID;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->thread = thread;
+    stats->duration = upipe_xfer_mgr_now() - xfer_mgr->attach_date;
+
+    char path[64], line[512];
+    FILE *file;
+
+    /* utime and stime are the 14th and 15th fields, after the name of the
+     * thread which may contain spaces */
+    snprintf(path, sizeof(path), "/proc/self/task/%"PRIu32"/stat", thread);
+    if ((file = fopen(path, "r")) == NULL)
+        return UBASE_ERR_EXTERNAL;
+    char *end = NULL;
+    if (fgets(line, sizeof(line), file) != NULL)
+        end = strrchr(line, ')');
+    fclose(file);
+    unsigned long utime, stime;
+    long ticks = sysconf(_SC_CLK_TCK);
+    if (end == NULL || ticks <= 0 ||
+        sscanf(end + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+               &utime, &stime) != 2)
+        return UBASE_ERR_EXTERNAL;
+    stats->user_time = (uint64_t)utime * UCLOCK_FREQ / ticks;
+    stats->system_time = (uint64_t)stime * UCLOCK_FREQ / ticks;
+
+    snprintf(path, sizeof(path), "/proc/self/task/%"PRIu32"/status", thread);
+    if ((file = fopen(path, "r")) == NULL)
+        return UBASE_ERR_EXTERNAL;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        sscanf(line, "voluntary_ctxt_switches: %"SCNu64,
+               &stats->voluntary_switches);
+        sscanf(line, "nonvoluntary_ctxt_switches: %"SCNu64,
+               &stats->involuntary_switches);
+    }
+    fclose(file);
+
+    /* schedstat is only there if the kernel has CONFIG_SCHED_INFO */
+    snprintf(path, sizeof(path), "/proc/self/task/%"PRIu32"/schedstat",
+             thread);
+    if ((file = fopen(path, "r")) != NULL) {
+        uint64_t run_ns, wait_ns;
+        if (fscanf(file, "%"SCNu64" %"SCNu64, &run_ns, &wait_ns) == 2) {
+            stats->run_time = run_ns * 27 / 1000;
+            stats->wait_time = wait_ns * 27 / 1000;
+        }
+        fclose(file);
+    } else
+        stats->run_time = stats->user_time + stats->system_time;
+    return UBASE_ERR_NONE;
+}
+
 /** @This processes manager control commands.
  *
  * @param mgr xfer_mgr structure
@@ -691,6 +830,17 @@ static int upipe_xfer_mgr_control(struct upipe_mgr *mgr,
             UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
             return _upipe_xfer_mgr_thaw(mgr);
         }
+        case UPIPE_XFER_MGR_SET_SPIN: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            uint64_t spin_duration = va_arg(args, uint64_t);
+            return _upipe_xfer_mgr_set_spin(mgr, spin_duration);
+        }
+        case UPIPE_XFER_MGR_GET_THREAD_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XFER_SIGNATURE)
+            struct upipe_xfer_thread_stats *stats =
+                va_arg(args, struct upipe_xfer_thread_stats *);
+            return _upipe_xfer_mgr_get_thread_stats(mgr, stats);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -706,7 +856,7 @@ static int upipe_xfer_mgr_control(struct upipe_mgr *mgr,
  * @param mutex mutual exclusion primitives to access the event loop, or NULL
  * @return pointer to manager
  */
-struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_xfer_mgr_alloc(unsigned int queue_length,
                                        uint16_t msg_pool_depth,
                                        struct umutex *mutex)
 {
@@ -726,6 +876,8 @@ struct upipe_mgr *upipe_xfer_mgr_alloc(uint8_t queue_length,
     xfer_mgr->mutex = umutex_use(mutex);
     xfer_mgr->upump = NULL;
     xfer_mgr->upump_mgr = NULL;
+    uatomic_init(&xfer_mgr->thread, 0);
+    xfer_mgr->attach_date = 0;
     xfer_mgr->queue_length = queue_length;
     ulifo_init(&xfer_mgr->msg_pool, msg_pool_depth,
                xfer_mgr->extra + uqueue_sizeof(queue_length));
@@ -74,6 +74,10 @@ struct upipe_trickp {
 
     /** current rate */
     struct urational rate;
+    /** rate from which only keyframes are output (den 0 = disabled) */
+    struct urational keyframe_threshold;
+    /** minimum system interval between output keyframes */
+    uint64_t keyframe_interval;
     /** list of subs */
     struct uchain subs;
 
@@ -107,6 +111,8 @@ struct upipe_trickp_sub {
 
     /** type of the flow */
     enum upipe_trickp_sub_type type;
+    /** system date of the last output keyframe */
+    uint64_t last_keyframe_sys;
     /** temporary uref storage */
     struct uchain urefs;
     /** nb urefs in storage */
@@ -162,6 +168,7 @@ static struct upipe *upipe_trickp_sub_alloc(struct upipe_mgr *mgr,
         upipe_trickp_sub_from_upipe(upipe);
     ulist_init(&upipe_trickp_sub->urefs);
     upipe_trickp_sub->type = UPIPE_TRICKP_UNKNOWN;
+    upipe_trickp_sub->last_keyframe_sys = UINT64_MAX;
 
     struct upipe_trickp *upipe_trickp = upipe_trickp_from_sub_mgr(upipe->mgr);
     if (upipe_trickp->rate.den)
@@ -171,6 +178,22 @@ static struct upipe *upipe_trickp_sub_alloc(struct upipe_mgr *mgr,
     return upipe;
 }
 
+/** @internal @This checks if only keyframes must be output at the current
+ * rate.
+ *
+ * @param upipe_trickp private context of the trickp pipe
+ * @return true if only keyframes must be output
+ */
+static bool upipe_trickp_keyframe_only(struct upipe_trickp *upipe_trickp)
+{
+    struct urational threshold = upipe_trickp->keyframe_threshold;
+    struct urational rate = upipe_trickp->rate;
+    if (!threshold.den || !rate.den || rate.num <= 0)
+        return false;
+    return (uint64_t)rate.num * threshold.den >=
+           (uint64_t)threshold.num * rate.den;
+}
+
 /** @internal @This processes data.
  *
  * @param upipe description structure of the pipe
@@ -198,6 +221,28 @@ static bool upipe_trickp_sub_process(struct upipe *upipe, struct uref *uref,
         uref_clock_set_date_sys(uref, date_sys, type);
         upipe_verbose_va(upipe, "stamping %"PRIu64" -> %"PRIu64,
                          date, date_sys);
+
+        if (upipe_trickp_keyframe_only(upipe_trickp)) {
+            struct upipe_trickp_sub *upipe_trickp_sub =
+                upipe_trickp_sub_from_upipe(upipe);
+            switch (upipe_trickp_sub->type) {
+                case UPIPE_TRICKP_SOUND:
+                    uref_free(uref);
+                    return true;
+                case UPIPE_TRICKP_PIC:
+                    if (!ubase_check(uref_flow_get_random(uref)) ||
+                        (upipe_trickp_sub->last_keyframe_sys != UINT64_MAX &&
+                         date_sys < upipe_trickp_sub->last_keyframe_sys +
+                                    upipe_trickp->keyframe_interval)) {
+                        uref_free(uref);
+                        return true;
+                    }
+                    upipe_trickp_sub->last_keyframe_sys = date_sys;
+                    break;
+                default:
+                    break;
+            }
+        }
     }
 
     upipe_trickp_sub_output(upipe, uref, upump_p);
@@ -348,6 +393,9 @@ static struct upipe *upipe_trickp_alloc(struct upipe_mgr *mgr,
     upipe_trickp->ts_origin = 0;
     upipe_trickp->preroll = true;
     upipe_trickp->rate.num = upipe_trickp->rate.den = 1;
+    upipe_trickp->keyframe_threshold.num = 0;
+    upipe_trickp->keyframe_threshold.den = 0;
+    upipe_trickp->keyframe_interval = 0;
     upipe_throw_ready(upipe);
     upipe_trickp_require_uclock(upipe);
     return upipe;
@@ -442,6 +490,13 @@ static void upipe_trickp_reset_uclock(struct upipe *upipe)
     struct upipe_trickp *upipe_trickp = upipe_trickp_from_upipe(upipe);
     upipe_trickp->systime_offset = 0;
     upipe_trickp->ts_origin = 0;
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_trickp->subs, uchain) {
+        struct upipe_trickp_sub *upipe_trickp_sub =
+            upipe_trickp_sub_from_uchain(uchain);
+        upipe_trickp_sub->last_keyframe_sys = UINT64_MAX;
+    }
 }
 
 /** @This returns the current playing rate.
@@ -495,6 +550,49 @@ static inline int _upipe_trickp_set_rate(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @This returns the keyframe-only settings.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold_p filled with the keyframe-only threshold rate
+ * @param interval_p filled with the minimum interval between keyframes
+ * @return an error code
+ */
+static int _upipe_trickp_get_keyframe(struct upipe *upipe,
+                                      struct urational *threshold_p,
+                                      uint64_t *interval_p)
+{
+    struct upipe_trickp *upipe_trickp = upipe_trickp_from_upipe(upipe);
+    if (threshold_p != NULL)
+        *threshold_p = upipe_trickp->keyframe_threshold;
+    if (interval_p != NULL)
+        *interval_p = upipe_trickp->keyframe_interval;
+    return UBASE_ERR_NONE;
+}
+
+/** @This sets the keyframe-only settings.
+ *
+ * @param upipe description structure of the pipe
+ * @param threshold rate from which only keyframes are output (0/0 disables)
+ * @param interval minimum system interval between keyframes
+ * @return an error code
+ */
+static int _upipe_trickp_set_keyframe(struct upipe *upipe,
+                                      struct urational threshold,
+                                      uint64_t interval)
+{
+    struct upipe_trickp *upipe_trickp = upipe_trickp_from_upipe(upipe);
+    if (threshold.den && threshold.num <= 0)
+        return UBASE_ERR_INVALID;
+    upipe_trickp->keyframe_threshold = threshold;
+    upipe_trickp->keyframe_interval = interval;
+    if (threshold.den)
+        upipe_dbg_va(upipe, "keyframe-only from rate %f, interval %"PRIu64,
+                     (float)threshold.num / threshold.den, interval);
+    else
+        upipe_dbg(upipe, "disabling keyframe-only mode");
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a trickp pipe.
  *
  * @param upipe description structure of the pipe
@@ -524,6 +622,18 @@ static int upipe_trickp_control(struct upipe *upipe, int command, va_list args)
             struct urational rate = va_arg(args, struct urational);
             return _upipe_trickp_set_rate(upipe, rate);
         }
+        case UPIPE_TRICKP_GET_KEYFRAME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TRICKP_SIGNATURE)
+            struct urational *threshold_p = va_arg(args, struct urational *);
+            uint64_t *interval_p = va_arg(args, uint64_t *);
+            return _upipe_trickp_get_keyframe(upipe, threshold_p, interval_p);
+        }
+        case UPIPE_TRICKP_SET_KEYFRAME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TRICKP_SIGNATURE)
+            struct urational threshold = va_arg(args, struct urational);
+            uint64_t interval = va_arg(args, uint64_t);
+            return _upipe_trickp_set_keyframe(upipe, threshold, interval);
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
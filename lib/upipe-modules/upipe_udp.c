@@ -342,6 +342,7 @@ int upipe_udp_open_socket(struct upipe *upipe, const char *_uri, int ttl,
     int family;
     socklen_t sockaddr_len;
     in_addr_t miface = 0;
+    bool reuseport = false;
 #if !defined(__APPLE__) && !defined(__native_client__)
     char *ifname = NULL;
 #endif
@@ -455,6 +456,8 @@ int upipe_udp_open_socket(struct upipe *upipe, const char *_uri, int ttl,
                 char *option = config_stropt(ARG_OPTION("miface="));
                 miface = inet_addr(option);
                 free(option);
+            } else if (IS_OPTION("reuseport")) {
+                reuseport = true;
             } else {
                 upipe_warn_va(upipe, "unrecognized option %s", token2);
             }
@@ -545,6 +548,22 @@ int upipe_udp_open_socket(struct upipe *upipe, const char *_uri, int ttl,
             return -1;
         }
 
+        if (reuseport) {
+#ifdef SO_REUSEPORT
+            /* several sockets may be bound to the same address, and the
+             * kernel spreads incoming flows between them */
+            i = 1;
+            if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, (void *)&i,
+                           sizeof(i)) == -1) {
+                upipe_err_va(upipe, "unable to set SO_REUSEPORT (%m)");
+                close(fd);
+                return -1;
+            }
+#else
+            upipe_warn(upipe, "ignoring reuseport option");
+#endif
+        }
+
         if (family == AF_INET6) {
             if (bind_if_index
                   && setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_IF,
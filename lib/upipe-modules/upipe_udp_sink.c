@@ -28,11 +28,14 @@
  * @short Upipe sink module for udp
  */
 
+#define _GNU_SOURCE
+
 #include "upipe/ubase.h"
 #include "upipe/uclock.h"
 #include "upipe/uref.h"
 #include "upipe/uref_block.h"
 #include "upipe/uref_clock.h"
+#include "upipe/uref_attr.h"
 #include "upipe/upump.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
@@ -52,8 +55,17 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
+#ifdef UPIPE_HAVE_LINUX_NET_TSTAMP_H
+#include <linux/net_tstamp.h>
+#endif
+#ifdef UPIPE_HAVE_LINUX_ERRQUEUE_H
+#include <linux/errqueue.h>
+#endif
 
 /** tolerance for late packets */
 #define SYSTIME_TOLERANCE UCLOCK_FREQ
@@ -65,6 +77,25 @@
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
 
+/** maximum number of datagrams sent per system call */
+#define UPIPE_UDPSINK_MAX_BATCH 64
+/** maximum size of a segmented (GSO) send */
+#define UPIPE_UDPSINK_MAX_GSO_SIZE 65000
+/** true if transmit times may be passed to the kernel */
+#if defined(SO_TXTIME) && defined(UPIPE_HAVE_LINUX_NET_TSTAMP_H)
+#define UPIPE_UDPSINK_TXTIME
+#endif
+/** true if payloads may be sent without copy */
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && \
+    defined(UPIPE_HAVE_LINUX_ERRQUEUE_H)
+#define UPIPE_UDPSINK_ZEROCOPY
+#else
+#define MSG_ZEROCOPY 0
+#endif
+/** maximum number of urefs waiting for the completion of a zero-copy send,
+ * beyond which payloads are copied again */
+#define UPIPE_UDPSINK_MAX_ZEROCOPY 4096
+
 /** @hidden */
 static void upipe_udpsink_watcher(struct upump *upump);
 /** @hidden */
@@ -111,6 +142,29 @@ struct upipe_udpsink {
     /** destination for not-connected socket (size) */
     socklen_t addrlen;
 
+    /** maximum number of datagrams sent at once */
+    unsigned int batch_size;
+    /** urefs due before now + batch_window are sent together */
+    uint64_t batch_window;
+    /** true if UDP segmentation offload may be tried */
+    bool gso;
+    /** clock of the transmit times (SO_TXTIME), or -1 to pace in
+     * user space */
+    int txtime_clockid;
+    /** urefs due before now + txtime_horizon are handed to the kernel
+     * with their transmit time */
+    uint64_t txtime_horizon;
+    /** true if payloads are sent with MSG_ZEROCOPY */
+    bool zerocopy;
+    /** urefs sent without copy, waiting for their completion */
+    struct uchain zc_urefs;
+    /** number of urefs waiting for completion */
+    unsigned int nb_zc_urefs;
+    /** identifier of the next zero-copy send */
+    uint32_t zc_next;
+    /** true if the kernel reported that it copied a payload */
+    bool zc_copied;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -151,6 +205,20 @@ static struct upipe *upipe_udpsink_alloc(struct upipe_mgr *mgr,
     upipe_udpsink->uri = NULL;
     upipe_udpsink->raw = false;
     upipe_udpsink->addrlen = 0;
+    upipe_udpsink->batch_size = 1;
+    upipe_udpsink->batch_window = 0;
+#ifdef UDP_SEGMENT
+    upipe_udpsink->gso = true;
+#else
+    upipe_udpsink->gso = false;
+#endif
+    upipe_udpsink->txtime_clockid = -1;
+    upipe_udpsink->txtime_horizon = 0;
+    upipe_udpsink->zerocopy = false;
+    ulist_init(&upipe_udpsink->zc_urefs);
+    upipe_udpsink->nb_zc_urefs = 0;
+    upipe_udpsink->zc_next = 0;
+    upipe_udpsink->zc_copied = false;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -178,6 +246,457 @@ static void upipe_udpsink_poll(struct upipe *upipe)
     }
 }
 
+/** @internal @This enables the SO_TXTIME option on the current socket, if
+ * transmit times were requested.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_udpsink_apply_txtime(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (upipe_udpsink->txtime_clockid == -1 || upipe_udpsink->fd == -1)
+        return UBASE_ERR_NONE;
+
+#ifdef UPIPE_UDPSINK_TXTIME
+    struct sock_txtime sock_txtime = {
+        .clockid = upipe_udpsink->txtime_clockid,
+        .flags = 0,
+    };
+    if (likely(setsockopt(upipe_udpsink->fd, SOL_SOCKET, SO_TXTIME,
+                          &sock_txtime, sizeof(sock_txtime)) != -1))
+        return UBASE_ERR_NONE;
+    upipe_warn_va(upipe, "can't set SO_TXTIME (%m)");
+#endif
+    upipe_udpsink->txtime_clockid = -1;
+    return UBASE_ERR_EXTERNAL;
+}
+
+/** @internal @This enables the SO_ZEROCOPY option on the current socket, if
+ * zero-copy sends were requested.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_udpsink_apply_zerocopy(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (!upipe_udpsink->zerocopy || upipe_udpsink->fd == -1)
+        return UBASE_ERR_NONE;
+    if (unlikely(upipe_udpsink->raw)) {
+        /* the raw header is shared by all datagrams */
+        upipe_warn(upipe, "zero-copy sends unsupported on raw sockets");
+        upipe_udpsink->zerocopy = false;
+        return UBASE_ERR_INVALID;
+    }
+
+#ifdef UPIPE_UDPSINK_ZEROCOPY
+    int enable = 1;
+    if (likely(setsockopt(upipe_udpsink->fd, SOL_SOCKET, SO_ZEROCOPY,
+                          &enable, sizeof(enable)) != -1))
+        return UBASE_ERR_NONE;
+    upipe_warn_va(upipe, "can't set SO_ZEROCOPY (%m)");
+#endif
+    upipe_udpsink->zerocopy = false;
+    return UBASE_ERR_EXTERNAL;
+}
+
+/** @internal @This returns the flags of the next send, asking for a
+ * zero-copy send unless too many urefs are already waiting.
+ *
+ * @param upipe description structure of the pipe
+ * @return MSG_ZEROCOPY or 0
+ */
+static inline int upipe_udpsink_zc_flags(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (!upipe_udpsink->zerocopy ||
+        upipe_udpsink->nb_zc_urefs >= UPIPE_UDPSINK_MAX_ZEROCOPY)
+        return 0;
+    return MSG_ZEROCOPY;
+}
+
+/** @internal @This keeps a uref sent without copy until the kernel reports
+ * the completion of the send.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref sent
+ * @param id identifier of the send
+ */
+static void upipe_udpsink_zc_hold(struct upipe *upipe, struct uref *uref,
+                                  uint32_t id)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    uref_attr_set_priv(uref, id);
+    ulist_add(&upipe_udpsink->zc_urefs, uref_to_uchain(uref));
+    upipe_udpsink->nb_zc_urefs++;
+}
+
+/** @internal @This frees the urefs waiting for completion, either all of
+ * them or those of the given range of sends.
+ *
+ * @param upipe description structure of the pipe
+ * @param all true to free all the urefs
+ * @param lo first identifier of the range
+ * @param hi last identifier of the range
+ */
+static void upipe_udpsink_zc_free(struct upipe *upipe, bool all,
+                                  uint32_t lo, uint32_t hi)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&upipe_udpsink->zc_urefs, uchain, uchain_tmp) {
+        struct uref *uref = uref_from_uchain(uchain);
+        uint64_t id = 0;
+        uref_attr_get_priv(uref, &id);
+        if (!all && (uint32_t)((uint32_t)id - lo) > (uint32_t)(hi - lo))
+            continue;
+        ulist_delete(uchain);
+        uref_free(uref);
+        upipe_udpsink->nb_zc_urefs--;
+    }
+}
+
+/** @internal @This reads the completions of zero-copy sends from the error
+ * queue of the socket, and frees the corresponding urefs.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsink_zc_reap(struct upipe *upipe)
+{
+#ifdef UPIPE_UDPSINK_ZEROCOPY
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    while (upipe_udpsink->nb_zc_urefs && upipe_udpsink->fd != -1) {
+        char control[CMSG_SPACE(sizeof(struct sock_extended_err) +
+                                sizeof(struct sockaddr_storage))];
+        struct msghdr msghdr = {
+            .msg_control = control,
+            .msg_controllen = sizeof(control),
+        };
+        if (recvmsg(upipe_udpsink->fd, &msghdr,
+                    MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        struct cmsghdr *cmsg;
+        for (cmsg = CMSG_FIRSTHDR(&msghdr); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msghdr, cmsg)) {
+            if (!(cmsg->cmsg_level == SOL_IP &&
+                  cmsg->cmsg_type == IP_RECVERR) &&
+                !(cmsg->cmsg_level == SOL_IPV6 &&
+                  cmsg->cmsg_type == IPV6_RECVERR))
+                continue;
+            struct sock_extended_err serr;
+            memcpy(&serr, CMSG_DATA(cmsg), sizeof(serr));
+            if (serr.ee_errno || serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                continue;
+            if ((serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) &&
+                !upipe_udpsink->zc_copied) {
+                upipe_dbg(upipe, "the kernel copied zero-copy payloads");
+                upipe_udpsink->zc_copied = true;
+            }
+            upipe_udpsink_zc_free(upipe, false, serr.ee_info, serr.ee_data);
+        }
+    }
+#endif
+}
+
+/** @internal @This returns the current date of the transmit time clock.
+ *
+ * @param upipe description structure of the pipe
+ * @return current date in nanoseconds
+ */
+static uint64_t upipe_udpsink_txtime_now(struct upipe *upipe)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    struct timespec ts;
+    if (unlikely(clock_gettime(upipe_udpsink->txtime_clockid, &ts) == -1))
+        return 0;
+    return ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+}
+
+/** @internal @This converts a uref date to a transmit time. Late urefs are
+ * scheduled immediately.
+ *
+ * @param txtime_now current date of the transmit time clock
+ * @param systime date of the uref
+ * @param now current date of the uclock
+ * @return transmit time in nanoseconds
+ */
+static inline uint64_t upipe_udpsink_txtime(uint64_t txtime_now,
+                                            uint64_t systime, uint64_t now)
+{
+    if (systime <= now)
+        return txtime_now;
+    return txtime_now + (systime - now) * UINT64_C(1000) /
+                        (UCLOCK_FREQ / UINT64_C(1000000));
+}
+
+/** @internal @This fills in the control message carrying a transmit time.
+ *
+ * @param msghdr message header, with a control buffer of
+ * CMSG_SPACE(sizeof(uint64_t)) octets
+ * @param txtime transmit time in nanoseconds
+ */
+static void upipe_udpsink_set_cmsg_txtime(struct msghdr *msghdr,
+                                          uint64_t txtime)
+{
+#ifdef UPIPE_UDPSINK_TXTIME
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(msghdr);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_TXTIME;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+    memcpy(CMSG_DATA(cmsg), &txtime, sizeof(txtime));
+#endif
+}
+
+#ifdef UPIPE_HAVE_SENDMMSG
+/** @internal @This collects the held urefs which are due before the end of
+ * the batch window, after the given uref. Late urefs are dropped.
+ *
+ * @param upipe description structure of the pipe
+ * @param urefs array of urefs, with the first one already set
+ * @param now current date, or 0 without uclock
+ * @return number of urefs in the array
+ */
+static unsigned int upipe_udpsink_collect(struct upipe *upipe,
+                                          struct uref **urefs, uint64_t now)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    unsigned int nb = 1;
+    struct uchain *uchain;
+    uint64_t window = upipe_udpsink->batch_window;
+    if (upipe_udpsink->txtime_clockid != -1 &&
+        upipe_udpsink->txtime_horizon > window)
+        window = upipe_udpsink->txtime_horizon;
+
+    while (nb < upipe_udpsink->batch_size &&
+           (uchain = ulist_peek(&upipe_udpsink->urefs)) != NULL) {
+        struct uref *uref = uref_from_uchain(uchain);
+        const char *def;
+        if (unlikely(ubase_check(uref_flow_get_def(uref, &def))))
+            break;
+
+        uint64_t systime;
+        if (upipe_udpsink->uclock != NULL &&
+            ubase_check(uref_clock_get_cr_sys(uref, &systime))) {
+            systime += upipe_udpsink->latency;
+            if (systime > now + window)
+                break;
+            if (unlikely(now > systime + SYSTIME_TOLERANCE)) {
+                upipe_warn_va(upipe,
+                    "dropping late packet %"PRIu64" ms, latency %"PRIu64" ms",
+                    (now - systime) / (UCLOCK_FREQ / 1000),
+                    upipe_udpsink->latency / (UCLOCK_FREQ / 1000));
+                uref_free(upipe_udpsink_pop_input(upipe));
+                continue;
+            }
+        }
+        urefs[nb++] = upipe_udpsink_pop_input(upipe);
+    }
+    return nb;
+}
+
+/** @internal @This sends several datagrams with a single system call, using
+ * UDP segmentation offload if all datagrams have the same size, or
+ * sendmmsg() otherwise. Datagrams which could not be sent because the
+ * socket is full are held again.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref first uref to send
+ * @return false if the first uref could not be sent
+ */
+static bool upipe_udpsink_output_batch(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    uint64_t now = 0;
+    if (upipe_udpsink->uclock != NULL)
+        now = uclock_now(upipe_udpsink->uclock);
+
+    struct uref *urefs[UPIPE_UDPSINK_MAX_BATCH];
+    urefs[0] = uref;
+    unsigned int nb = upipe_udpsink_collect(upipe, urefs, now);
+
+    /* drop the urefs without payload */
+    int counts[nb];
+    size_t sizes[nb];
+    int total_count = 0;
+    unsigned int valid = 0;
+    for (unsigned int i = 0; i < nb; i++) {
+        int count = uref_block_iovec_count(urefs[i], 0, -1);
+        if (unlikely(count <= 0 ||
+                     !ubase_check(uref_block_size(urefs[i], &sizes[valid])))) {
+            if (count)
+                upipe_warn(upipe, "cannot read ubuf buffer");
+            uref_free(urefs[i]);
+            continue;
+        }
+        urefs[valid] = urefs[i];
+        counts[valid++] = count;
+        total_count += count;
+    }
+    if (unlikely(!valid))
+        return true;
+    nb = valid;
+
+    struct iovec iovecs[total_count];
+    struct mmsghdr msgs[nb];
+    struct iovec *iovec = iovecs;
+    total_count = 0;
+    valid = 0;
+    for (unsigned int i = 0; i < nb; i++) {
+        if (unlikely(!ubase_check(uref_block_iovec_read(urefs[i], 0, -1,
+                                                        iovec)))) {
+            upipe_warn(upipe, "cannot read ubuf buffer");
+            uref_free(urefs[i]);
+            continue;
+        }
+        urefs[valid] = urefs[i];
+        counts[valid] = counts[i];
+        sizes[valid++] = sizes[i];
+        total_count += counts[i];
+        iovec += counts[i];
+    }
+    if (unlikely(!valid))
+        return true;
+    bool first_valid = urefs[0] == uref;
+    nb = valid;
+
+    bool txtime = upipe_udpsink->txtime_clockid != -1 &&
+                  upipe_udpsink->uclock != NULL;
+    uint64_t txtime_now = txtime ? upipe_udpsink_txtime_now(upipe) : 0;
+    char controls[txtime ? nb : 1][CMSG_SPACE(sizeof(uint64_t))];
+    iovec = iovecs;
+    for (unsigned int i = 0; i < nb; i++) {
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_name =
+            upipe_udpsink->addrlen ? &upipe_udpsink->addr : NULL;
+        msgs[i].msg_hdr.msg_namelen = upipe_udpsink->addrlen;
+        msgs[i].msg_hdr.msg_iov = iovec;
+        msgs[i].msg_hdr.msg_iovlen = counts[i];
+        msgs[i].msg_len = 0;
+        iovec += counts[i];
+
+        uint64_t systime;
+        if (txtime && ubase_check(uref_clock_get_cr_sys(urefs[i], &systime))) {
+            memset(controls[i], 0, sizeof(controls[i]));
+            msgs[i].msg_hdr.msg_control = controls[i];
+            msgs[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+            upipe_udpsink_set_cmsg_txtime(&msgs[i].msg_hdr,
+                upipe_udpsink_txtime(txtime_now,
+                                     systime + upipe_udpsink->latency, now));
+        }
+    }
+
+    int flags = upipe_udpsink_zc_flags(upipe);
+    /* identifier of each zero-copy send, or -1 */
+    int64_t zc_ids[nb];
+    for (unsigned int i = 0; i < nb; i++)
+        zc_ids[i] = -1;
+
+    unsigned int sent = 0;
+#ifdef UDP_SEGMENT
+    /* a segmented send has a single transmit time */
+    bool same_size = nb > 1 && !txtime &&
+                     sizes[0] * nb <= UPIPE_UDPSINK_MAX_GSO_SIZE;
+    for (unsigned int i = 1; same_size && i < nb; i++)
+        same_size = sizes[i] == sizes[0];
+    while (upipe_udpsink->gso && same_size) {
+        char control[CMSG_SPACE(sizeof(uint16_t))];
+        memset(control, 0, sizeof(control));
+        struct msghdr msghdr = msgs[0].msg_hdr;
+        msghdr.msg_iov = iovecs;
+        msghdr.msg_iovlen = total_count;
+        msghdr.msg_control = control;
+        msghdr.msg_controllen = sizeof(control);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msghdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t segment = sizes[0];
+        memcpy(CMSG_DATA(cmsg), &segment, sizeof(segment));
+
+        if (likely(sendmsg(upipe_udpsink->fd, &msghdr, flags) != -1)) {
+            sent = nb;
+            if (flags) {
+                /* a single send for all the datagrams */
+                for (unsigned int i = 0; i < nb; i++)
+                    zc_ids[i] = upipe_udpsink->zc_next;
+                upipe_udpsink->zc_next++;
+            }
+            break;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno == ENOBUFS && flags) {
+            /* too much memory locked for zero-copy sends */
+            flags = 0;
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        if (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT ||
+            errno == EOPNOTSUPP) {
+            upipe_warn_va(upipe, "segmentation offload unavailable (%m)");
+            upipe_udpsink->gso = false;
+            break;
+        }
+        /* transient errors are ignored, see upipe_udpsink_output */
+        sent = nb;
+        break;
+    }
+    if (upipe_udpsink->gso && same_size)
+        goto batch_sent;
+#endif
+
+    while (sent < nb) {
+        int ret = sendmmsg(upipe_udpsink->fd, msgs + sent, nb - sent, flags);
+        if (likely(ret > 0)) {
+            for ( ; flags && ret > 0; ret--)
+                zc_ids[sent++] = upipe_udpsink->zc_next++;
+            sent += ret;
+            continue;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno == ENOBUFS && flags) {
+            flags = 0;
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            break;
+        /* transient errors only drop the first datagram, see
+         * upipe_udpsink_output */
+        sent++;
+    }
+
+#ifdef UDP_SEGMENT
+batch_sent:
+#endif
+    iovec = iovecs;
+    for (unsigned int i = 0; i < nb; i++) {
+        uref_block_iovec_unmap(urefs[i], 0, -1, iovec);
+        iovec += counts[i];
+        if (i < sent && zc_ids[i] != -1)
+            upipe_udpsink_zc_hold(upipe, urefs[i], zc_ids[i]);
+        else if (i < sent)
+            uref_free(urefs[i]);
+    }
+    if (likely(sent == nb))
+        return true;
+
+    /* the socket is full, hold the remaining datagrams in order */
+    unsigned int first = !sent && first_valid ? 1 : 0;
+    for (unsigned int i = nb; i > sent + first; i--)
+        upipe_udpsink_unshift_input(upipe, urefs[i - 1]);
+    upipe_udpsink_poll(upipe);
+    /* the first uref is held again by our caller */
+    return !first;
+}
+#endif
+
 /** @internal @This outputs data to the udp sink.
  *
  * @param upipe description structure of the pipe
@@ -205,6 +724,13 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
         return true;
     }
 
+    if (unlikely(upipe_udpsink->batch_size > 1 && upipe_udpsink->upump != NULL))
+        /* a previous batch is waiting for the socket */
+        return false;
+
+    upipe_udpsink_zc_reap(upipe);
+
+    uint64_t txtime = 0;
     if (likely(upipe_udpsink->uclock == NULL))
         goto write_buffer;
 
@@ -216,15 +742,19 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
 
     uint64_t now = uclock_now(upipe_udpsink->uclock);
     systime += upipe_udpsink->latency;
-    if (unlikely(now < systime)) {
+    uint64_t horizon = upipe_udpsink->txtime_clockid != -1 ?
+                       upipe_udpsink->txtime_horizon : 0;
+    if (unlikely(now + horizon < systime)) {
         upipe_udpsink_check_upump_mgr(upipe);
         if (likely(upipe_udpsink->upump_mgr != NULL)) {
             upipe_verbose_va(upipe, "sleeping %"PRIu64" (%"PRIu64")",
-                             systime - now, systime);
-            upipe_udpsink_wait_upump(upipe, systime - now,
+                             systime - now - horizon, systime);
+            upipe_udpsink_wait_upump(upipe, systime - now - horizon,
                                      upipe_udpsink_watcher);
             return false;
         }
+    } else if (now < systime) {
+        /* the kernel sends the packet at its date */
     } else if (now > systime + SYSTIME_TOLERANCE) {
         upipe_warn_va(upipe,
                       "dropping late packet %"PRIu64" ms, latency %"PRIu64" ms",
@@ -238,7 +768,17 @@ static bool upipe_udpsink_output(struct upipe *upipe, struct uref *uref,
                       (now - systime) / (UCLOCK_FREQ / 1000),
                       upipe_udpsink->latency / (UCLOCK_FREQ / 1000));
 
+    if (upipe_udpsink->txtime_clockid != -1)
+        txtime = upipe_udpsink_txtime(upipe_udpsink_txtime_now(upipe),
+                                      systime, now);
+
 write_buffer:
+#ifdef UPIPE_HAVE_SENDMMSG
+    if (upipe_udpsink->batch_size > 1 && !upipe_udpsink->raw)
+        return upipe_udpsink_output_batch(upipe, uref);
+#endif
+
+    int flags = upipe_udpsink_zc_flags(upipe);
     for ( ; ; ) {
         size_t payload_len = 0;
         if (unlikely(!ubase_check(uref_block_size(uref, &payload_len)))) {
@@ -288,11 +828,27 @@ write_buffer:
             .msg_controllen = 0,
             .msg_flags = 0,
         };
+        char control[CMSG_SPACE(sizeof(uint64_t))];
+        if (txtime) {
+            memset(control, 0, sizeof(control));
+            msghdr.msg_control = control;
+            msghdr.msg_controllen = sizeof(control);
+            upipe_udpsink_set_cmsg_txtime(&msghdr, txtime);
+        }
 
-        ssize_t ret = sendmsg(upipe_udpsink->fd, &msghdr, 0);
+        ssize_t ret = sendmsg(upipe_udpsink->fd, &msghdr, flags);
         uref_block_iovec_unmap(uref, 0, -1, iovecs);
+        if (likely(ret != -1) && flags) {
+            upipe_udpsink_zc_hold(upipe, uref, upipe_udpsink->zc_next++);
+            break;
+        }
 
         if (unlikely(ret == -1)) {
+            if (errno == ENOBUFS && flags) {
+                /* too much memory locked for zero-copy sends */
+                flags = 0;
+                continue;
+            }
             switch (errno) {
                 case EINTR:
                     continue;
@@ -361,6 +917,32 @@ static void upipe_udpsink_input(struct upipe *upipe, struct uref *uref,
     }
 }
 
+/** @internal @This receives a list of urefs. They are queued at once, so
+ * that in batch mode they are sent with as few system calls as possible.
+ *
+ * @param upipe description structure of the pipe
+ * @param urefs list of urefs
+ * @param upump_p reference to pump that generated the buffers
+ */
+static void upipe_udpsink_input_batch(struct upipe *upipe,
+                                      struct uchain *urefs,
+                                      struct upump **upump_p)
+{
+    bool blocked = !upipe_udpsink_check_input(upipe);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(urefs)) != NULL)
+        upipe_udpsink_hold_input(upipe, uref_from_uchain(uchain));
+
+    if (blocked) {
+        upipe_udpsink_block_input(upipe, upump_p);
+    } else if (!upipe_udpsink_output_input(upipe)) {
+        upipe_udpsink_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -410,6 +992,8 @@ static int _upipe_udpsink_set_uri(struct upipe *upipe, const char *uri)
             upipe_notice_va(upipe, "closing socket %s", upipe_udpsink->uri);
         close(upipe_udpsink->fd);
     }
+    upipe_udpsink_zc_free(upipe, true, 0, 0);
+    upipe_udpsink->zc_next = 0;
     ubase_clean_str(&upipe_udpsink->uri);
     upipe_udpsink_set_upump(upipe, NULL);
     if (!upipe_udpsink_check_input(upipe))
@@ -440,6 +1024,8 @@ static int _upipe_udpsink_set_uri(struct upipe *upipe, const char *uri)
         /* Use again the pipe that we previously released. */
         upipe_use(upipe);
     upipe_notice_va(upipe, "opening uri %s", upipe_udpsink->uri);
+    upipe_udpsink_apply_txtime(upipe);
+    upipe_udpsink_apply_zerocopy(upipe);
     return UBASE_ERR_NONE;
 }
 
@@ -460,6 +1046,80 @@ static int upipe_udpsink_flush(struct upipe *upipe)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the batch mode parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams sent at once (between 1
+ * and 64)
+ * @param batch_window urefs due before now plus this duration are sent
+ * together
+ * @return an error code
+ */
+static int _upipe_udpsink_set_batch(struct upipe *upipe,
+                                    unsigned int batch_size,
+                                    uint64_t batch_window)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+    if (unlikely(!batch_size || batch_size > UPIPE_UDPSINK_MAX_BATCH))
+        return UBASE_ERR_INVALID;
+#ifndef UPIPE_HAVE_SENDMMSG
+    if (batch_size > 1)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    upipe_udpsink->batch_size = batch_size;
+    upipe_udpsink->batch_window = batch_window;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the transmit time parameters.
+ *
+ * @param upipe description structure of the pipe
+ * @param clockid clock of the transmit times, or -1 to pace in user space
+ * @param horizon urefs due before now plus this duration are handed to the
+ * kernel
+ * @return an error code
+ */
+static int _upipe_udpsink_set_txtime(struct upipe *upipe, int clockid,
+                                     uint64_t horizon)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#ifndef UPIPE_UDPSINK_TXTIME
+    if (clockid != -1)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    if (unlikely(upipe_udpsink->raw && clockid != -1))
+        return UBASE_ERR_INVALID;
+    upipe_udpsink->txtime_clockid = clockid;
+    upipe_udpsink->txtime_horizon = horizon;
+    upipe_udpsink_set_upump(upipe, NULL);
+    return upipe_udpsink_apply_txtime(upipe);
+}
+
+/** @internal @This sets the zero-copy send mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param enable true to send payloads with MSG_ZEROCOPY
+ * @return an error code
+ */
+static int _upipe_udpsink_set_zerocopy(struct upipe *upipe, bool enable)
+{
+    struct upipe_udpsink *upipe_udpsink = upipe_udpsink_from_upipe(upipe);
+#ifndef UPIPE_UDPSINK_ZEROCOPY
+    if (enable)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    if (unlikely(upipe_udpsink->raw && enable))
+        return UBASE_ERR_INVALID;
+    if (upipe_udpsink->zerocopy == enable)
+        return UBASE_ERR_NONE;
+    upipe_udpsink->zerocopy = enable;
+    if (!enable)
+        /* the socket keeps SO_ZEROCOPY, but sends without MSG_ZEROCOPY are
+         * copied */
+        return UBASE_ERR_NONE;
+    return upipe_udpsink_apply_zerocopy(upipe);
+}
+
 /** @internal @This processes control commands on a udp sink pipe.
  *
  * @param upipe description structure of the pipe
@@ -516,7 +1176,12 @@ static int _upipe_udpsink_control(struct upipe *upipe,
         case UPIPE_UDPSINK_SET_FD: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
             upipe_udpsink_set_upump(upipe, NULL);
+            upipe_udpsink_zc_reap(upipe);
+            upipe_udpsink_zc_free(upipe, true, 0, 0);
+            upipe_udpsink->zc_next = 0;
             upipe_udpsink->fd = va_arg(args, int );
+            upipe_udpsink_apply_txtime(upipe);
+            upipe_udpsink_apply_zerocopy(upipe);
             return UBASE_ERR_NONE;
         }
         case UPIPE_UDPSINK_SET_PEER: {
@@ -526,6 +1191,23 @@ static int _upipe_udpsink_control(struct upipe *upipe,
             memcpy(&upipe_udpsink->addr, s, upipe_udpsink->addrlen);
             return UBASE_ERR_NONE;
         }
+        case UPIPE_UDPSINK_SET_BATCH: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            unsigned int batch_size = va_arg(args, unsigned int);
+            uint64_t batch_window = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_batch(upipe, batch_size, batch_window);
+        }
+        case UPIPE_UDPSINK_SET_TXTIME: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            int clockid = va_arg(args, int);
+            uint64_t horizon = va_arg(args, uint64_t);
+            return _upipe_udpsink_set_txtime(upipe, clockid, horizon);
+        }
+        case UPIPE_UDPSINK_SET_ZEROCOPY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSINK_SIGNATURE)
+            bool enable = va_arg(args, int);
+            return _upipe_udpsink_set_zerocopy(upipe, enable);
+        }
         case UPIPE_FLUSH:
             return upipe_udpsink_flush(upipe);
         default:
@@ -567,6 +1249,7 @@ static void upipe_udpsink_free(struct upipe *upipe)
             upipe_notice_va(upipe, "closing socket %s", upipe_udpsink->uri);
         close(upipe_udpsink->fd);
     }
+    upipe_udpsink_zc_free(upipe, true, 0, 0);
     upipe_throw_dead(upipe);
 
     free(upipe_udpsink->uri);
@@ -585,6 +1268,7 @@ static struct upipe_mgr upipe_udpsink_mgr = {
 
     .upipe_alloc = upipe_udpsink_alloc,
     .upipe_input = upipe_udpsink_input,
+    .upipe_input_batch = upipe_udpsink_input_batch,
     .upipe_control = upipe_udpsink_control,
 
     .upipe_mgr_control = NULL
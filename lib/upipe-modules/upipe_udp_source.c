@@ -28,6 +28,8 @@
  * @short Upipe source module for udp sockets
  */
 
+#define _GNU_SOURCE
+
 #include "upipe/ubase.h"
 #include "upipe/uclock.h"
 #include "upipe/uref.h"
@@ -35,6 +37,7 @@
 #include "upipe/uref_block_flow.h"
 #include "upipe/uref_clock.h"
 #include "upipe/upump.h"
+#include "upipe/uts_pid_filter.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -49,6 +52,10 @@
 #include "upipe-modules/upipe_udp_source.h"
 #include "upipe_udp.h"
 
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+#include "upump-uring/upump_uring.h"
+#endif
+
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -57,14 +64,29 @@
 #include <unistd.h>
 #include <errno.h>
 #include <assert.h>
+#include <time.h>
 #include <sys/socket.h>
+#ifdef UPIPE_HAVE_LINUX_NET_TSTAMP_H
+#include <linux/net_tstamp.h>
+#endif
 
 /** default size of buffers when unspecified */
 #define UBUF_DEFAULT_SIZE       4096
+/** maximum number of datagrams received per system call */
+#define UPIPE_UDPSRC_MAX_BATCH  64
 
 #define UDP_DEFAULT_TTL 0
 #define UDP_DEFAULT_PORT 1234
 
+/** @internal @This is a control buffer receiving the timestamps of a
+ * datagram (struct scm_timestamping). */
+union upipe_udpsrc_control {
+    /** buffer */
+    char buf[CMSG_SPACE(3 * sizeof(struct timespec))];
+    /** alignment */
+    struct cmsghdr align;
+};
+
 /** @hidden */
 static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format);
 
@@ -116,6 +138,29 @@ struct upipe_udpsrc {
     /** source address (size) */
     socklen_t addrlen;
 
+    /** maximum number of datagrams received per wake-up */
+    unsigned int batch_size;
+    /** urefs allocated in advance and not used by the previous batch */
+    struct uref *spares[UPIPE_UDPSRC_MAX_BATCH];
+    /** number of spare urefs */
+    unsigned int nb_spares;
+
+    /** uref being received into by an io_uring recvmsg pump, or NULL */
+    struct uref *uring_uref;
+    /** message header of the io_uring recvmsg pump */
+    struct msghdr uring_msg;
+    /** buffer of the io_uring recvmsg pump */
+    struct iovec uring_iovec;
+    /** source address of the io_uring recvmsg pump */
+    struct sockaddr_storage uring_addr;
+    /** control buffer of the io_uring recvmsg pump */
+    union upipe_udpsrc_control uring_control;
+
+    /** source of the cr_sys dates */
+    enum upipe_udpsrc_timestamping timestamping;
+    /** TS PID filter, or NULL */
+    struct uts_pid_filter *pid_filter;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -166,10 +211,355 @@ static struct upipe *upipe_udpsrc_alloc(struct upipe_mgr *mgr,
     upipe_udpsrc->fd = -1;
     upipe_udpsrc->uri = NULL;
     upipe_udpsrc->addrlen = 0;
+    upipe_udpsrc->batch_size = 1;
+    upipe_udpsrc->nb_spares = 0;
+    upipe_udpsrc->uring_uref = NULL;
+    upipe_udpsrc->timestamping = UPIPE_UDPSRC_TIMESTAMPING_NONE;
+    upipe_udpsrc->pid_filter = NULL;
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This releases the urefs allocated in advance.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_flush_spares(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    while (upipe_udpsrc->nb_spares)
+        uref_free(upipe_udpsrc->spares[--upipe_udpsrc->nb_spares]);
+}
+
+/** @internal @This sets the read watcher, and releases the uref of the
+ * request of the previous io_uring pump, if any.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump new read watcher, or NULL
+ */
+static void upipe_udpsrc_replace_upump(struct upipe *upipe,
+                                       struct upump *upump)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    upipe_udpsrc_set_upump(upipe, upump);
+    /* the previous pump has completed its pending request once freed */
+    if (upipe_udpsrc->uring_uref != NULL) {
+        uref_block_unmap(upipe_udpsrc->uring_uref, 0);
+        uref_free(upipe_udpsrc->uring_uref);
+        upipe_udpsrc->uring_uref = NULL;
+    }
+}
+
+/** @internal @This handles an error while reading the socket.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_read_error(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    switch (errno) {
+        case EINTR:
+        case EAGAIN:
+#if EAGAIN != EWOULDBLOCK
+        case EWOULDBLOCK:
+#endif
+            /* not an issue, try again later */
+            return;
+        case EBADF:
+        case EINVAL:
+        case EIO:
+        default:
+            break;
+    }
+    upipe_err_va(upipe, "read error from %s (%m)", upipe_udpsrc->uri);
+    upipe_udpsrc_replace_upump(upipe, NULL);
+    upipe_throw_source_end(upipe);
+}
+
+/** @internal @This throws an event if the remote address changed.
+ *
+ * @param upipe description structure of the pipe
+ * @param addr address of the peer
+ * @param addrlen size of the address of the peer
+ */
+static void upipe_udpsrc_check_peer(struct upipe *upipe,
+                                    struct sockaddr_storage *addr,
+                                    socklen_t addrlen)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (addrlen != upipe_udpsrc->addrlen ||
+        memcmp(addr, &upipe_udpsrc->addr, addrlen)) {
+        upipe_throw(upipe, UPROBE_UDPSRC_NEW_PEER, UPIPE_UDPSRC_SIGNATURE,
+                addr, &addrlen);
+        upipe_udpsrc->addrlen = addrlen;
+        memcpy(&upipe_udpsrc->addr, addr, addrlen);
+    }
+}
+
+/** @internal @This converts a timespec to a date in 27 MHz ticks.
+ *
+ * @param ts timespec to convert
+ * @return date in 27 MHz ticks
+ */
+static inline uint64_t upipe_udpsrc_ts_to_ticks(const struct timespec *ts)
+{
+    return ts->tv_sec * UCLOCK_FREQ +
+           ts->tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @internal @This returns the current date in CLOCK_REALTIME, the clock of
+ * the kernel timestamps, if they are enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @return date in 27 MHz ticks, or 0
+ */
+static uint64_t upipe_udpsrc_realtime(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    struct timespec ts;
+    if (likely(upipe_udpsrc->timestamping == UPIPE_UDPSRC_TIMESTAMPING_NONE) ||
+        unlikely(clock_gettime(CLOCK_REALTIME, &ts) == -1))
+        return 0;
+    return upipe_udpsrc_ts_to_ticks(&ts);
+}
+
+/** @internal @This prepares the control buffer of a message if timestamps
+ * are enabled.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg message header
+ * @param control control buffer
+ */
+static void upipe_udpsrc_init_control(struct upipe *upipe, struct msghdr *msg,
+                                      union upipe_udpsrc_control *control)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (likely(upipe_udpsrc->timestamping == UPIPE_UDPSRC_TIMESTAMPING_NONE ||
+               upipe_udpsrc->uclock == NULL)) {
+        msg->msg_control = NULL;
+        msg->msg_controllen = 0;
+        return;
+    }
+    msg->msg_control = control->buf;
+    msg->msg_controllen = sizeof(control->buf);
+}
+
+/** @internal @This returns the cr_sys date of a received datagram. Hardware
+ * timestamps are raw times of the clock of the network interface, converted
+ * to 27 MHz ticks without any further correction, and kernel timestamps are
+ * translated into the uclock by their age.
+ *
+ * @param upipe description structure of the pipe
+ * @param msg received message header
+ * @param systime date of the wake-up in the uclock
+ * @param realtime date of the wake-up in CLOCK_REALTIME
+ * @return cr_sys date
+ */
+static uint64_t upipe_udpsrc_get_stamp(struct upipe *upipe,
+                                       struct msghdr *msg,
+                                       uint64_t systime, uint64_t realtime)
+{
+#ifdef UPIPE_HAVE_LINUX_NET_TSTAMP_H
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (msg->msg_control == NULL)
+        return systime;
+
+    struct cmsghdr *cmsg;
+    for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+         cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET ||
+            cmsg->cmsg_type != SO_TIMESTAMPING ||
+            cmsg->cmsg_len < CMSG_LEN(3 * sizeof(struct timespec)))
+            continue;
+
+        /* 0: software, 1: deprecated, 2: raw hardware */
+        struct timespec ts[3];
+        memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+        if (upipe_udpsrc->timestamping == UPIPE_UDPSRC_TIMESTAMPING_HARDWARE &&
+            (ts[2].tv_sec || ts[2].tv_nsec))
+            return upipe_udpsrc_ts_to_ticks(&ts[2]);
+
+        if (!ts[0].tv_sec && !ts[0].tv_nsec)
+            break;
+        uint64_t stamp = upipe_udpsrc_ts_to_ticks(&ts[0]);
+        if (unlikely(stamp > realtime || realtime - stamp > systime))
+            break;
+        return systime - (realtime - stamp);
+    }
+#else
+    (void)upipe;
+    (void)msg;
+    (void)realtime;
+#endif
+    return systime;
+}
+
+/** @internal @This enables the configured timestamps on the socket.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_udpsrc_apply_timestamping(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (upipe_udpsrc->fd == -1)
+        return UBASE_ERR_NONE;
+
+#ifdef UPIPE_HAVE_LINUX_NET_TSTAMP_H
+    int flags = 0;
+    switch (upipe_udpsrc->timestamping) {
+        case UPIPE_UDPSRC_TIMESTAMPING_HARDWARE:
+            flags |= SOF_TIMESTAMPING_RX_HARDWARE |
+                     SOF_TIMESTAMPING_RAW_HARDWARE;
+            /* fallthrough */
+        case UPIPE_UDPSRC_TIMESTAMPING_SOFTWARE:
+            flags |= SOF_TIMESTAMPING_RX_SOFTWARE |
+                     SOF_TIMESTAMPING_SOFTWARE;
+            break;
+        default:
+            break;
+    }
+    if (unlikely(setsockopt(upipe_udpsrc->fd, SOL_SOCKET, SO_TIMESTAMPING,
+                            &flags, sizeof(flags)) == -1)) {
+        upipe_warn_va(upipe, "can't set timestamping on udp socket (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+#else
+    if (upipe_udpsrc->timestamping == UPIPE_UDPSRC_TIMESTAMPING_NONE)
+        return UBASE_ERR_NONE;
+    upipe_warn(upipe, "timestamping is not supported on this platform");
+    return UBASE_ERR_UNHANDLED;
+#endif
+}
+
+#ifdef UPIPE_HAVE_RECVMMSG
+/** @internal @This reads up to batch_size datagrams with a single system
+ * call and outputs them as a single list. The urefs which were not filled
+ * are kept for the next wake-up.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_worker_batch(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    unsigned int nb = upipe_udpsrc->batch_size;
+    uint64_t systime = 0; /* to keep gcc quiet */
+    uint64_t realtime = 0;
+    if (unlikely(upipe_udpsrc->uclock != NULL)) {
+        systime = uclock_now(upipe_udpsrc->uclock);
+        realtime = upipe_udpsrc_realtime(upipe);
+    }
+
+    if (upipe_udpsrc->nb_spares < nb) {
+        unsigned int allocated =
+            uref_block_alloc_batch(upipe_udpsrc->uref_mgr,
+                                   upipe_udpsrc->ubuf_mgr,
+                                   upipe_udpsrc->output_size,
+                                   upipe_udpsrc->spares +
+                                   upipe_udpsrc->nb_spares,
+                                   nb - upipe_udpsrc->nb_spares);
+        upipe_udpsrc->nb_spares += allocated;
+        if (unlikely(!upipe_udpsrc->nb_spares)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        nb = upipe_udpsrc->nb_spares;
+    }
+
+    struct mmsghdr msgs[nb];
+    struct iovec iovecs[nb];
+    struct sockaddr_storage addrs[nb];
+    union upipe_udpsrc_control controls[nb];
+    for (unsigned int i = 0; i < nb; i++) {
+        struct uref *uref = upipe_udpsrc->spares[i];
+        uint8_t *buffer;
+        int output_size = -1;
+        if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                                   &buffer)))) {
+            for (unsigned int j = 0; j < i; j++)
+                uref_block_unmap(upipe_udpsrc->spares[j], 0);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        assert(output_size == upipe_udpsrc->output_size);
+        iovecs[i].iov_base = buffer;
+        iovecs[i].iov_len = output_size;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iovecs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        upipe_udpsrc_init_control(upipe, &msgs[i].msg_hdr, &controls[i]);
+        msgs[i].msg_len = 0;
+    }
+
+    int ret = recvmmsg(upipe_udpsrc->fd, msgs, nb, MSG_DONTWAIT, NULL);
+    if (upipe_udpsrc->pid_filter != NULL)
+        for (int i = 0; i < ret; i++)
+            /* the size of the selected packets replaces the buffer size */
+            iovecs[i].iov_len = uts_pid_filter_compact(
+                    upipe_udpsrc->pid_filter, iovecs[i].iov_base,
+                    msgs[i].msg_len);
+    for (unsigned int i = 0; i < nb; i++)
+        uref_block_unmap(upipe_udpsrc->spares[i], 0);
+
+    if (unlikely(ret == -1)) {
+        upipe_udpsrc_read_error(upipe);
+        return;
+    }
+    if (unlikely(ret == 0))
+        return;
+
+    struct uref *urefs[ret];
+    memcpy(urefs, upipe_udpsrc->spares, ret * sizeof(struct uref *));
+    upipe_udpsrc->nb_spares -= ret;
+    memmove(upipe_udpsrc->spares, upipe_udpsrc->spares + ret,
+            upipe_udpsrc->nb_spares * sizeof(struct uref *));
+
+    struct uchain output;
+    ulist_init(&output);
+    for (int i = 0; i < ret; i++) {
+        struct uref *uref = urefs[i];
+        upipe_udpsrc_check_peer(upipe, &addrs[i],
+                                msgs[i].msg_hdr.msg_namelen);
+
+        if (unlikely(msgs[i].msg_len == 0)) {
+            uref_free(uref);
+            if (likely(upipe_udpsrc->uclock == NULL)) {
+                upipe_notice_va(upipe, "end of udp socket %s",
+                                upipe_udpsrc->uri);
+                for (i++; i < ret; i++)
+                    uref_free(urefs[i]);
+                upipe_udpsrc_output_batch(upipe, &output,
+                                          &upipe_udpsrc->upump);
+                upipe_udpsrc_replace_upump(upipe, NULL);
+                upipe_throw_source_end(upipe);
+                return;
+            }
+            continue;
+        }
+        unsigned int len = msgs[i].msg_len;
+        if (upipe_udpsrc->pid_filter != NULL) {
+            len = iovecs[i].iov_len;
+            if (!len) {
+                /* keep the uref for the next batch */
+                upipe_udpsrc->spares[upipe_udpsrc->nb_spares++] = uref;
+                continue;
+            }
+        }
+        if (unlikely(upipe_udpsrc->uclock != NULL))
+            uref_clock_set_cr_sys(uref,
+                upipe_udpsrc_get_stamp(upipe, &msgs[i].msg_hdr,
+                                       systime, realtime));
+        if (unlikely(len != upipe_udpsrc->output_size))
+            uref_block_resize(uref, 0, len);
+        ulist_add(&output, uref_to_uchain(uref));
+    }
+    upipe_udpsrc_output_batch(upipe, &output, &upipe_udpsrc->upump);
+}
+#endif
+
 /** @internal @This reads data from the source and outputs it.
  * It is called either when the idler triggers (permanent storage mode) or
  * when data is available on the udp socket descriptor (live stream mode).
@@ -180,9 +570,19 @@ static void upipe_udpsrc_worker(struct upump *upump)
 {
     struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
     struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+#ifdef UPIPE_HAVE_RECVMMSG
+    if (upipe_udpsrc->batch_size > 1) {
+        upipe_udpsrc_worker_batch(upipe);
+        return;
+    }
+#endif
+
     uint64_t systime = 0; /* to keep gcc quiet */
-    if (unlikely(upipe_udpsrc->uclock != NULL))
+    uint64_t realtime = 0;
+    if (unlikely(upipe_udpsrc->uclock != NULL)) {
         systime = uclock_now(upipe_udpsrc->uclock);
+        realtime = upipe_udpsrc_realtime(upipe);
+    }
 
     struct uref *uref = uref_block_alloc(upipe_udpsrc->uref_mgr,
                                          upipe_udpsrc->ubuf_mgr,
@@ -203,56 +603,168 @@ static void upipe_udpsrc_worker(struct upump *upump)
     assert(output_size == upipe_udpsrc->output_size);
 
     struct sockaddr_storage addr;
-    socklen_t addrlen = sizeof(addr);
+    struct iovec iovec = {
+        .iov_base = buffer,
+        .iov_len = upipe_udpsrc->output_size
+    };
+    union upipe_udpsrc_control control;
+    struct msghdr msg = {
+        .msg_name = &addr,
+        .msg_namelen = sizeof(addr),
+        .msg_iov = &iovec,
+        .msg_iovlen = 1,
+    };
+    upipe_udpsrc_init_control(upipe, &msg, &control);
 
-    ssize_t ret = recvfrom(upipe_udpsrc->fd, buffer, upipe_udpsrc->output_size,
-                        0, (struct sockaddr*)&addr, &addrlen);
+    ssize_t ret = recvmsg(upipe_udpsrc->fd, &msg, 0);
+    if (upipe_udpsrc->pid_filter != NULL && ret > 0) {
+        ret = uts_pid_filter_compact(upipe_udpsrc->pid_filter, buffer, ret);
+        if (!ret) {
+            uref_block_unmap(uref, 0);
+            uref_free(uref);
+            return;
+        }
+    }
     uref_block_unmap(uref, 0);
 
     if (unlikely(ret == -1)) {
         uref_free(uref);
-        switch (errno) {
-            case EINTR:
-            case EAGAIN:
-#if EAGAIN != EWOULDBLOCK
-            case EWOULDBLOCK:
-#endif
-                /* not an issue, try again later */
-                return;
-            case EBADF:
-            case EINVAL:
-            case EIO:
-            default:
-                break;
-        }
-        upipe_err_va(upipe, "read error from %s (%m)", upipe_udpsrc->uri);
-        upipe_udpsrc_set_upump(upipe, NULL);
-        upipe_throw_source_end(upipe);
+        upipe_udpsrc_read_error(upipe);
         return;
-    } else if (addrlen != upipe_udpsrc->addrlen ||
-        memcmp(&addr, &upipe_udpsrc->addr, addrlen)) {
-        upipe_throw(upipe, UPROBE_UDPSRC_NEW_PEER, UPIPE_UDPSRC_SIGNATURE,
-                &addr, &addrlen);
-        upipe_udpsrc->addrlen = addrlen;
-        memcpy(&upipe_udpsrc->addr, &addr, addrlen);
     }
+    upipe_udpsrc_check_peer(upipe, &addr, msg.msg_namelen);
 
     if (unlikely(ret == 0)) {
         uref_free(uref);
         if (likely(upipe_udpsrc->uclock == NULL)) {
             upipe_notice_va(upipe, "end of udp socket %s", upipe_udpsrc->uri);
-            upipe_udpsrc_set_upump(upipe, NULL);
+            upipe_udpsrc_replace_upump(upipe, NULL);
             upipe_throw_source_end(upipe);
         }
         return;
     }
     if (unlikely(upipe_udpsrc->uclock != NULL))
-        uref_clock_set_cr_sys(uref, systime);
+        uref_clock_set_cr_sys(uref, upipe_udpsrc_get_stamp(upipe, &msg,
+                                                           systime, realtime));
     if (unlikely(ret != upipe_udpsrc->output_size))
         uref_block_resize(uref, 0, ret);
     upipe_udpsrc_output(upipe, uref, &upipe_udpsrc->upump);
 }
 
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+/** @internal @This allocates the next block and submits its reception to
+ * the io_uring recvmsg pump.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_udpsrc_uring_submit(struct upipe *upipe)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    struct uref *uref = uref_block_alloc(upipe_udpsrc->uref_mgr,
+                                         upipe_udpsrc->ubuf_mgr,
+                                         upipe_udpsrc->output_size);
+    if (unlikely(uref == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    uint8_t *buffer;
+    int output_size = -1;
+    if (unlikely(!ubase_check(uref_block_write(uref, 0, &output_size,
+                                               &buffer)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    upipe_udpsrc->uring_uref = uref;
+    upipe_udpsrc->uring_iovec.iov_base = buffer;
+    upipe_udpsrc->uring_iovec.iov_len = output_size;
+    upipe_udpsrc->uring_msg.msg_name = &upipe_udpsrc->uring_addr;
+    upipe_udpsrc->uring_msg.msg_namelen = sizeof(upipe_udpsrc->uring_addr);
+    upipe_udpsrc->uring_msg.msg_iov = &upipe_udpsrc->uring_iovec;
+    upipe_udpsrc->uring_msg.msg_iovlen = 1;
+    upipe_udpsrc->uring_msg.msg_flags = 0;
+    upipe_udpsrc_init_control(upipe, &upipe_udpsrc->uring_msg,
+                              &upipe_udpsrc->uring_control);
+    upump_restart(upipe_udpsrc->upump);
+}
+
+/** @internal @This outputs the datagram received by the io_uring recvmsg
+ * pump, and submits the next reception.
+ *
+ * @param upump description structure of the recvmsg pump
+ */
+static void upipe_udpsrc_uring_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    uint64_t systime = 0; /* to keep gcc quiet */
+    uint64_t realtime = 0;
+    if (unlikely(upipe_udpsrc->uclock != NULL)) {
+        systime = uclock_now(upipe_udpsrc->uclock);
+        realtime = upipe_udpsrc_realtime(upipe);
+    }
+
+    ssize_t ret;
+    if (unlikely(!ubase_check(upump_uring_get_result(upump, &ret))))
+        ret = -EIO;
+    if (unlikely(ret == -EINTR || ret == -EAGAIN)) {
+        /* not an issue, submit the same message again */
+        upipe_udpsrc->uring_msg.msg_namelen =
+            sizeof(upipe_udpsrc->uring_addr);
+        upipe_udpsrc_init_control(upipe, &upipe_udpsrc->uring_msg,
+                                  &upipe_udpsrc->uring_control);
+        upump_restart(upump);
+        return;
+    }
+
+    struct uref *uref = upipe_udpsrc->uring_uref;
+    upipe_udpsrc->uring_uref = NULL;
+    if (upipe_udpsrc->pid_filter != NULL && ret > 0) {
+        ret = uts_pid_filter_compact(upipe_udpsrc->pid_filter,
+                                     upipe_udpsrc->uring_iovec.iov_base, ret);
+        if (!ret) {
+            uref_block_unmap(uref, 0);
+            uref_free(uref);
+            upipe_udpsrc_uring_submit(upipe);
+            return;
+        }
+    }
+    uref_block_unmap(uref, 0);
+
+    if (unlikely(ret < 0)) {
+        uref_free(uref);
+        errno = -ret;
+        upipe_udpsrc_read_error(upipe);
+        return;
+    }
+    upipe_udpsrc_check_peer(upipe, &upipe_udpsrc->uring_addr,
+                            upipe_udpsrc->uring_msg.msg_namelen);
+
+    if (unlikely(ret == 0)) {
+        uref_free(uref);
+        if (likely(upipe_udpsrc->uclock == NULL)) {
+            upipe_notice_va(upipe, "end of udp socket %s", upipe_udpsrc->uri);
+            upipe_udpsrc_replace_upump(upipe, NULL);
+            upipe_throw_source_end(upipe);
+            return;
+        }
+        upipe_udpsrc_uring_submit(upipe);
+        return;
+    }
+    if (unlikely(upipe_udpsrc->uclock != NULL))
+        uref_clock_set_cr_sys(uref,
+                upipe_udpsrc_get_stamp(upipe, &upipe_udpsrc->uring_msg,
+                                       systime, realtime));
+    if (unlikely((size_t)ret != upipe_udpsrc->uring_iovec.iov_len))
+        uref_block_resize(uref, 0, ret);
+    upipe_udpsrc_output(upipe, uref, &upipe_udpsrc->upump);
+    /* the pump may have been released during the output */
+    if (likely(upipe_udpsrc->upump == upump))
+        upipe_udpsrc_uring_submit(upipe);
+}
+#endif
+
 /** @internal @This checks if the pump may be allocated.
  *
  * @param upipe description structure of the pipe
@@ -262,8 +774,11 @@ static void upipe_udpsrc_worker(struct upump *upump)
 static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format)
 {
     struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
-    if (flow_format != NULL)
+    if (flow_format != NULL) {
+        /* a new ubuf manager was provided */
+        upipe_udpsrc_flush_spares(upipe);
         upipe_udpsrc_store_flow_def(upipe, flow_format);
+    }
 
     upipe_udpsrc_check_upump_mgr(upipe);
     if (upipe_udpsrc->upump_mgr == NULL)
@@ -293,6 +808,22 @@ static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format)
 
     if (upipe_udpsrc->fd != -1 && upipe_udpsrc->upump == NULL) {
         struct upump *upump;
+#ifdef UPIPE_HAVE_LINUX_IO_URING_H
+        if (upipe_udpsrc->batch_size == 1 &&
+            upipe_udpsrc->upump_mgr->signature == UPUMP_URING_SIGNATURE) {
+            upump = upump_uring_alloc_recvmsg(upipe_udpsrc->upump_mgr,
+                                              upipe_udpsrc_uring_worker, upipe,
+                                              upipe->refcount, upipe_udpsrc->fd,
+                                              &upipe_udpsrc->uring_msg, 0);
+            if (unlikely(upump == NULL)) {
+                upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+                return UBASE_ERR_UPUMP;
+            }
+            upipe_udpsrc_replace_upump(upipe, upump);
+            upipe_udpsrc_uring_submit(upipe);
+            return UBASE_ERR_NONE;
+        }
+#endif
         upump = upump_alloc_fd_read(upipe_udpsrc->upump_mgr,
                                     upipe_udpsrc_worker, upipe, upipe->refcount,
                                     upipe_udpsrc->fd);
@@ -300,7 +831,7 @@ static int upipe_udpsrc_check(struct upipe *upipe, struct uref *flow_format)
             upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
             return UBASE_ERR_UPUMP;
         }
-        upipe_udpsrc_set_upump(upipe, upump);
+        upipe_udpsrc_replace_upump(upipe, upump);
         upump_start(upump);
     }
     return UBASE_ERR_NONE;
@@ -338,7 +869,7 @@ static int upipe_udpsrc_set_uri(struct upipe *upipe, const char *uri)
         ubase_clean_fd(&upipe_udpsrc->fd);
     }
     ubase_clean_str(&upipe_udpsrc->uri);
-    upipe_udpsrc_set_upump(upipe, NULL);
+    upipe_udpsrc_replace_upump(upipe, NULL);
 
     if (unlikely(uri == NULL))
         return UBASE_ERR_NONE;
@@ -357,6 +888,103 @@ static int upipe_udpsrc_set_uri(struct upipe *upipe, const char *uri)
         return UBASE_ERR_ALLOC;
     }
     upipe_notice_va(upipe, "opening udp socket %s", upipe_udpsrc->uri);
+    if (upipe_udpsrc->timestamping != UPIPE_UDPSRC_TIMESTAMPING_NONE)
+        return upipe_udpsrc_apply_timestamping(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the maximum number of datagrams received per
+ * wake-up.
+ *
+ * @param upipe description structure of the pipe
+ * @param batch_size maximum number of datagrams (between 1 and 64)
+ * @return an error code
+ */
+static int _upipe_udpsrc_set_batch_size(struct upipe *upipe,
+                                        unsigned int batch_size)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (unlikely(!batch_size || batch_size > UPIPE_UDPSRC_MAX_BATCH))
+        return UBASE_ERR_INVALID;
+#ifndef UPIPE_HAVE_RECVMMSG
+    if (batch_size > 1)
+        return UBASE_ERR_UNHANDLED;
+#endif
+    if (batch_size < upipe_udpsrc->nb_spares)
+        upipe_udpsrc_flush_spares(upipe);
+    upipe_udpsrc->batch_size = batch_size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the source of the cr_sys dates.
+ *
+ * @param upipe description structure of the pipe
+ * @param timestamping source of the dates
+ * @return an error code
+ */
+static int _upipe_udpsrc_set_timestamping(struct upipe *upipe,
+        enum upipe_udpsrc_timestamping timestamping)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    switch (timestamping) {
+        case UPIPE_UDPSRC_TIMESTAMPING_NONE:
+        case UPIPE_UDPSRC_TIMESTAMPING_SOFTWARE:
+        case UPIPE_UDPSRC_TIMESTAMPING_HARDWARE:
+            break;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+
+    enum upipe_udpsrc_timestamping previous = upipe_udpsrc->timestamping;
+    upipe_udpsrc->timestamping = timestamping;
+    int err = upipe_udpsrc_apply_timestamping(upipe);
+    if (unlikely(!ubase_check(err)))
+        upipe_udpsrc->timestamping = previous;
+    return err;
+}
+
+/** @internal @This enables or disables the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to enable the filter
+ * @return an error code
+ */
+static int _upipe_udpsrc_set_pid_filter(struct upipe *upipe, bool enabled)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (!enabled) {
+        free(upipe_udpsrc->pid_filter);
+        upipe_udpsrc->pid_filter = NULL;
+        return UBASE_ERR_NONE;
+    }
+    if (upipe_udpsrc->pid_filter != NULL)
+        return UBASE_ERR_NONE;
+
+    upipe_udpsrc->pid_filter = malloc(sizeof(struct uts_pid_filter));
+    if (unlikely(upipe_udpsrc->pid_filter == NULL))
+        return UBASE_ERR_ALLOC;
+    uts_pid_filter_init(upipe_udpsrc->pid_filter);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This selects or unselects a PID in the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to change
+ * @param selected true to select the PID
+ * @return an error code
+ */
+static int _upipe_udpsrc_set_pid(struct upipe *upipe, unsigned int pid,
+                                 bool selected)
+{
+    struct upipe_udpsrc *upipe_udpsrc = upipe_udpsrc_from_upipe(upipe);
+    if (unlikely(upipe_udpsrc->pid_filter == NULL ||
+                 pid >= UTS_PID_FILTER_PIDS))
+        return UBASE_ERR_INVALID;
+    if (selected)
+        uts_pid_filter_add(upipe_udpsrc->pid_filter, pid);
+    else
+        uts_pid_filter_del(upipe_udpsrc->pid_filter, pid);
     return UBASE_ERR_NONE;
 }
 
@@ -374,10 +1002,10 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
 
     switch (command) {
         case UPIPE_ATTACH_UPUMP_MGR:
-            upipe_udpsrc_set_upump(upipe, NULL);
+            upipe_udpsrc_replace_upump(upipe, NULL);
             return upipe_udpsrc_attach_upump_mgr(upipe);
         case UPIPE_ATTACH_UCLOCK:
-            upipe_udpsrc_set_upump(upipe, NULL);
+            upipe_udpsrc_replace_upump(upipe, NULL);
             upipe_udpsrc_require_uclock(upipe);
             return UBASE_ERR_NONE;
 
@@ -387,7 +1015,10 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
             return upipe_udpsrc_control_output(upipe, command, args);
 
         case UPIPE_GET_OUTPUT_SIZE:
+            return upipe_udpsrc_control_output_size(upipe, command, args);
         case UPIPE_SET_OUTPUT_SIZE:
+            /* spare urefs were allocated with the previous size */
+            upipe_udpsrc_flush_spares(upipe);
             return upipe_udpsrc_control_output_size(upipe, command, args);
 
         case UPIPE_GET_URI: {
@@ -406,10 +1037,51 @@ static int _upipe_udpsrc_control(struct upipe *upipe,
         }
         case UPIPE_UDPSRC_SET_FD: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
-            upipe_udpsrc_set_upump(upipe, NULL);
+            upipe_udpsrc_replace_upump(upipe, NULL);
             upipe_udpsrc->fd = va_arg(args, int );
+            if (upipe_udpsrc->timestamping != UPIPE_UDPSRC_TIMESTAMPING_NONE)
+                return upipe_udpsrc_apply_timestamping(upipe);
             return UBASE_ERR_NONE;
         }
+        case UPIPE_UDPSRC_GET_BATCH_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int *batch_size_p = va_arg(args, unsigned int *);
+            *batch_size_p = upipe_udpsrc->batch_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_SET_BATCH_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int batch_size = va_arg(args, unsigned int);
+            return _upipe_udpsrc_set_batch_size(upipe, batch_size);
+        }
+        case UPIPE_UDPSRC_GET_TIMESTAMPING: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            enum upipe_udpsrc_timestamping *timestamping_p =
+                va_arg(args, enum upipe_udpsrc_timestamping *);
+            *timestamping_p = upipe_udpsrc->timestamping;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_UDPSRC_SET_TIMESTAMPING: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            enum upipe_udpsrc_timestamping timestamping =
+                va_arg(args, enum upipe_udpsrc_timestamping);
+            return _upipe_udpsrc_set_timestamping(upipe, timestamping);
+        }
+        case UPIPE_UDPSRC_SET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            int enabled = va_arg(args, int);
+            return _upipe_udpsrc_set_pid_filter(upipe, !!enabled);
+        }
+        case UPIPE_UDPSRC_ADD_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            return _upipe_udpsrc_set_pid(upipe, pid, true);
+        }
+        case UPIPE_UDPSRC_DEL_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_UDPSRC_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            return _upipe_udpsrc_set_pid(upipe, pid, false);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -450,8 +1122,11 @@ static void upipe_udpsrc_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_udpsrc->uri);
+    free(upipe_udpsrc->pid_filter);
+    upipe_udpsrc_flush_spares(upipe);
     upipe_udpsrc_clean_output_size(upipe);
     upipe_udpsrc_clean_uclock(upipe);
+    upipe_udpsrc_replace_upump(upipe, NULL);
     upipe_udpsrc_clean_upump(upipe);
     upipe_udpsrc_clean_upump_mgr(upipe);
     upipe_udpsrc_clean_output(upipe);
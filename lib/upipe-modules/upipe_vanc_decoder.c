@@ -37,8 +37,13 @@
 #include "upipe/uref_pic_flow.h"
 #include "upipe/uref_pic.h"
 
+#include <string.h>
+
 #include <bitstream/smpte/291.h>
 
+/** number of DID/SDID pairs */
+#define NB_DIDS (256 * 256)
+
 /** @internal @This is the private context of a vanc decoder pipe. */
 struct upipe_vanc_decoder {
     /** pipe public structure */
@@ -59,6 +64,10 @@ struct upipe_vanc_decoder {
     struct urequest ubuf_mgr_request;
     /** ubuf flow format */
     struct uref *flow_format;
+    /** number of subscribed DID/SDID pairs */
+    unsigned int nb_dids;
+    /** bitmap of subscribed DID/SDID pairs */
+    uint64_t dids[NB_DIDS / 64];
 };
 
 UPIPE_HELPER_UPIPE(upipe_vanc_decoder, upipe, UPIPE_VANC_DECODER_SIGNATURE);
@@ -94,6 +103,10 @@ static struct upipe *upipe_vanc_decoder_alloc(struct upipe_mgr *mgr,
     upipe_vanc_decoder_init_output(upipe);
     upipe_vanc_decoder_init_ubuf_mgr(upipe);
 
+    struct upipe_vanc_decoder *vancd = upipe_vanc_decoder_from_upipe(upipe);
+    vancd->nb_dids = 0;
+    memset(vancd->dids, 0, sizeof (vancd->dids));
+
     upipe_throw_ready(upipe);
 
     return upipe;
@@ -112,6 +125,51 @@ static void upipe_vanc_decoder_free(struct upipe *upipe)
     upipe_vanc_decoder_free_void(upipe);
 }
 
+/** @internal @This checks if a packet type must be decoded.
+ *
+ * @param upipe description structure of the pipe
+ * @param did data identifier
+ * @param sdid secondary data identifier
+ * @return true if the packet must be decoded
+ */
+static bool upipe_vanc_decoder_check_did(struct upipe *upipe,
+                                         uint8_t did, uint8_t sdid)
+{
+    struct upipe_vanc_decoder *vancd = upipe_vanc_decoder_from_upipe(upipe);
+    unsigned int i = (did << 8) | sdid;
+    return !vancd->nb_dids ||
+           (vancd->dids[i / 64] & (UINT64_C(1) << (i % 64)));
+}
+
+/** @internal @This subscribes to or unsubscribes from a packet type.
+ *
+ * @param upipe description structure of the pipe
+ * @param did data identifier
+ * @param sdid secondary data identifier
+ * @param subscribe true to subscribe
+ * @return an error code
+ */
+static int upipe_vanc_decoder_set_did(struct upipe *upipe,
+                                      unsigned int did, unsigned int sdid,
+                                      bool subscribe)
+{
+    struct upipe_vanc_decoder *vancd = upipe_vanc_decoder_from_upipe(upipe);
+    if (unlikely(did > UINT8_MAX || sdid > UINT8_MAX))
+        return UBASE_ERR_INVALID;
+
+    unsigned int i = (did << 8) | sdid;
+    uint64_t mask = UINT64_C(1) << (i % 64);
+    bool subscribed = vancd->dids[i / 64] & mask;
+    if (subscribe && !subscribed) {
+        vancd->dids[i / 64] |= mask;
+        vancd->nb_dids++;
+    } else if (!subscribe && subscribed) {
+        vancd->dids[i / 64] &= ~mask;
+        vancd->nb_dids--;
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This is called when there is new data.
  *
  * @param upipe description structure of the pipe
@@ -169,6 +227,15 @@ static void upipe_vanc_decoder_input(struct upipe *upipe,
             goto ret;
         }
 
+        if (!upipe_vanc_decoder_check_did(upipe, did & 0xff, sdid & 0xff)) {
+            /* skip user data words, checksum and stuffing */
+            for (int i = 0; i < (dc & 0xff) + 1; i++)
+                ubits_get(&s, 10);
+            while (s.available)
+                ubits_get(&s, 1);
+            continue;
+        }
+
         struct uref *pic = uref_dup(uref);
         if (unlikely(!pic)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
@@ -189,6 +256,8 @@ static void upipe_vanc_decoder_input(struct upipe *upipe,
         if (unlikely(!ubase_check(uref_pic_plane_write(pic, "x10",
                             0, 0, -1, -1, &vanc_buf)))) {
             uref_free(pic);
+            upipe_throw_error(upipe, UBASE_ERR_ALLOC);
+            goto ret;
         }
         uint16_t *data = (uint16_t*)vanc_buf;
 
@@ -203,13 +272,15 @@ static void upipe_vanc_decoder_input(struct upipe *upipe,
             data[S291_HEADER_SIZE+i] = ubits_get(&s, 10);
         }
 
-        while (s.available) {
-            if (!ubits_get(&s, 1)) {
-                upipe_dbg(upipe, "Invalid byte align, skipping");
-                uref_pic_plane_unmap(pic, "x10", 0, 0, -1, -1);
-                uref_free(pic);
-                continue;
-            }
+        bool aligned = true;
+        while (s.available)
+            if (!ubits_get(&s, 1))
+                aligned = false;
+        if (!aligned) {
+            upipe_dbg(upipe, "Invalid byte align, skipping");
+            uref_pic_plane_unmap(pic, "x10", 0, 0, -1, -1);
+            uref_free(pic);
+            continue;
         }
 
         if (!s291_check_cs(data)) {
@@ -282,6 +353,14 @@ static int upipe_vanc_decoder_control(struct upipe *upipe,
         struct uref *flow_def = va_arg(args, struct uref *);
         return upipe_vanc_decoder_set_flow_def(upipe, flow_def);
     }
+    case UPIPE_VANC_DECODER_ADD_DID:
+    case UPIPE_VANC_DECODER_DEL_DID: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_VANC_DECODER_SIGNATURE)
+        unsigned int did = va_arg(args, unsigned int);
+        unsigned int sdid = va_arg(args, unsigned int);
+        return upipe_vanc_decoder_set_did(upipe, did, sdid,
+                                          cmd == UPIPE_VANC_DECODER_ADD_DID);
+    }
     }
     return UBASE_ERR_UNHANDLED;
 }
@@ -119,6 +119,36 @@ static void upipe_vblk_free(struct upipe *upipe)
     upipe_vblk_free_flow(upipe);
 }
 
+/** @internal @This releases the cached picture, unless it is still valid for
+ * a new output flow definition, so that changes of flow definition which do
+ * not affect the picture format do not cause a new allocation and clear.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def new output flow definition
+ */
+static void upipe_vblk_flush_pic(struct upipe *upipe, struct uref *flow_def)
+{
+    struct upipe_vblk *upipe_vblk = upipe_vblk_from_upipe(upipe);
+    struct uref *current = upipe_vblk->flow_def;
+    uint64_t align, current_align;
+
+    if (!upipe_vblk->ubuf)
+        return;
+
+    if (current && flow_def &&
+        uref_pic_flow_compare_format(current, flow_def) &&
+        !uref_pic_flow_cmp_hsize(current, flow_def) &&
+        !uref_pic_flow_cmp_vsize(current, flow_def) &&
+        !uref_pic_flow_cmp_full_range(current, flow_def) &&
+        (!ubase_check(uref_pic_flow_get_align(flow_def, &align)) ||
+         (ubase_check(uref_pic_flow_get_align(current, &current_align)) &&
+          !(current_align % align))))
+        return;
+
+    ubuf_free(upipe_vblk->ubuf);
+    upipe_vblk->ubuf = NULL;
+}
+
 /** @internal @This checks a flow definition validity.
  *
  * @param upipe description structure of the pipe
@@ -316,10 +346,7 @@ static int upipe_vblk_set_flow_def(struct upipe *upipe,
         uref_pic_delete_progressive(flow_def_dup);
     }
 
-    if (upipe_vblk->ubuf) {
-        ubuf_free(upipe_vblk->ubuf);
-        upipe_vblk->ubuf = NULL;
-    }
+    upipe_vblk_flush_pic(upipe, flow_def_dup);
 
     if (upipe_vblk->ubuf_mgr &&
         !ubase_check(ubuf_mgr_check(upipe_vblk->ubuf_mgr, flow_def_dup))) {
@@ -344,8 +371,10 @@ static int upipe_vblk_set_pic_real(struct upipe *upipe, struct uref *uref)
     struct upipe_vblk *upipe_vblk = upipe_vblk_from_upipe(upipe);
     if (upipe_vblk->ubuf)
         ubuf_free(upipe_vblk->ubuf);
+    upipe_vblk->ubuf = NULL;
     if (upipe_vblk->pic_attr)
         uref_free(upipe_vblk->pic_attr);
+    upipe_vblk->pic_attr = NULL;
     if (!uref)
         return UBASE_ERR_NONE;
 
@@ -393,8 +422,7 @@ static int upipe_vblk_check(struct upipe *upipe, struct uref *flow_format)
     struct upipe_vblk *upipe_vblk = upipe_vblk_from_upipe(upipe);
 
     if (flow_format) {
-        ubuf_free(upipe_vblk->ubuf);
-        upipe_vblk->ubuf = NULL;
+        upipe_vblk_flush_pic(upipe, flow_format);
         upipe_vblk_store_flow_def(upipe, flow_format);
     }
 
@@ -0,0 +1,675 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Bin pipe running a chain of linear subpipelines on several threads
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_bin_input.h"
+#include "upipe/upipe_helper_inner.h"
+#include "upipe/upipe_helper_uprobe.h"
+#include "upipe/upipe_helper_bin_output.h"
+#include "upipe-modules/upipe_queue_sink.h"
+#include "upipe-modules/upipe_queue_source.h"
+#include "upipe-modules/upipe_transfer.h"
+#include "upipe-modules/upipe_worker_chain.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+/** @internal @This is the private context of a worker chain manager. */
+struct upipe_wchain_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pointer to queue source manager */
+    struct upipe_mgr *qsrc_mgr;
+    /** pointer to queue sink manager */
+    struct upipe_mgr *qsink_mgr;
+
+    /** public upipe_mgr structure */
+    struct upipe_mgr mgr;
+};
+
+UBASE_FROM_TO(upipe_wchain_mgr, upipe_mgr, upipe_mgr, mgr)
+UBASE_FROM_TO(upipe_wchain_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This is the private context of a stage of a worker chain. */
+struct upipe_wchain_ctx {
+    /** probe for the input queue source of the stage */
+    struct uprobe in_qsrc_probe;
+    /** manager to transfer pipes to the stage thread */
+    struct upipe_mgr *xfer_mgr;
+    /** xfer pipe of the first remote pipe */
+    struct upipe *first_remote_xfer;
+    /** xfer pipe of the last remote pipe */
+    struct upipe *last_remote_xfer;
+};
+
+/** @internal @This is the private context of a worker chain pipe. */
+struct upipe_wchain {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of input bin requests */
+    struct uchain input_request_list;
+    /** list of output bin requests */
+    struct uchain output_request_list;
+    /** proxy probe */
+    struct uprobe proxy_probe;
+    /** probe for output queue source */
+    struct uprobe out_qsrc_probe;
+
+    /** input queue sink (first inner pipe of the bin) */
+    struct upipe *in_qsink;
+    /** output queue source (last inner pipe of the bin) */
+    struct upipe *out_qsrc;
+    /** output */
+    struct upipe *output;
+
+    /** number of stages */
+    unsigned int nb_stages;
+    /** array of stage contexts */
+    struct upipe_wchain_ctx *stages;
+
+    /** list of inner pipes that may require @ref upipe_attach_upump_mgr */
+    struct uchain upump_mgr_pipes;
+
+    /** true if @ref upipe_bin_freeze has been called */
+    bool frozen;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static int upipe_wchain_out_qsrc_probe(struct uprobe *uprobe,
+                                       struct upipe *inner,
+                                       int event, va_list args);
+
+UPIPE_HELPER_UPIPE(upipe_wchain, upipe, UPIPE_WCHAIN_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_wchain, urefcount, upipe_wchain_no_ref)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_wchain, urefcount_real, upipe_wchain_free)
+UPIPE_HELPER_INNER(upipe_wchain, in_qsink)
+UPIPE_HELPER_BIN_INPUT(upipe_wchain, in_qsink, input_request_list)
+UPIPE_HELPER_INNER(upipe_wchain, out_qsrc)
+UPIPE_HELPER_UPROBE(upipe_wchain, urefcount_real, proxy_probe, NULL)
+UPIPE_HELPER_UPROBE(upipe_wchain, urefcount_real, out_qsrc_probe,
+                    upipe_wchain_out_qsrc_probe)
+UPIPE_HELPER_BIN_OUTPUT(upipe_wchain, out_qsrc, output, output_request_list)
+
+/** @internal @This catches events coming from an input queue source pipe.
+ *
+ * @param uprobe pointer to the probe of the stage
+ * @param inner pointer to the inner pipe
+ * @param event event triggered by the inner pipe
+ * @param args arguments of the event
+ * @return an error code
+ */
+static int upipe_wchain_in_qsrc_probe(struct uprobe *uprobe,
+                                      struct upipe *inner,
+                                      int event, va_list args)
+{
+    if (event == UPROBE_SOURCE_END)
+        return UBASE_ERR_NONE;
+    return uprobe_throw_next(uprobe, inner, event, args);
+}
+
+/** @internal @This catches events coming from an output queue source pipe.
+ *
+ * @param uprobe pointer to the probe in upipe_wchain_alloc
+ * @param inner pointer to the inner pipe
+ * @param event event triggered by the inner pipe
+ * @param args arguments of the event
+ * @return an error code
+ */
+static int upipe_wchain_out_qsrc_probe(struct uprobe *uprobe,
+                                       struct upipe *inner,
+                                       int event, va_list args)
+{
+    if (event == UPROBE_SOURCE_END)
+        return UBASE_ERR_NONE;
+    return upipe_throw_proxy(
+        upipe_wchain_to_upipe(upipe_wchain_from_out_qsrc_probe(uprobe)),
+        inner, event, args);
+}
+
+/** @internal @This allocates a queue source and the queue sink feeding it.
+ *
+ * @param upipe description structure of the pipe
+ * @param qsrc_uprobe probe for the queue source (belongs to the callee)
+ * @param qsink_uprobe probe for the queue sink (belongs to the callee)
+ * @param queue_length number of packets in the queue
+ * @param qsrc_p filled in with the queue source
+ * @return pointer to the queue sink, or NULL in case of error
+ */
+static struct upipe *upipe_wchain_alloc_queue(struct upipe *upipe,
+                                              struct uprobe *qsrc_uprobe,
+                                              struct uprobe *qsink_uprobe,
+                                              unsigned int queue_length,
+                                              struct upipe **qsrc_p)
+{
+    struct upipe_wchain_mgr *wchain_mgr =
+        upipe_wchain_mgr_from_upipe_mgr(upipe->mgr);
+    assert(queue_length);
+
+    struct upipe *qsrc = upipe_qsrc_alloc(wchain_mgr->qsrc_mgr, qsrc_uprobe,
+            queue_length > UINT8_MAX ? UINT8_MAX : queue_length);
+    if (unlikely(qsrc == NULL)) {
+        uprobe_release(qsink_uprobe);
+        return NULL;
+    }
+
+    struct upipe *qsink = upipe_qsink_alloc(wchain_mgr->qsink_mgr,
+                                            qsink_uprobe, qsrc);
+    if (unlikely(qsink == NULL)) {
+        upipe_release(qsrc);
+        return NULL;
+    }
+    if (queue_length > UINT8_MAX)
+        upipe_set_max_length(qsink, queue_length - UINT8_MAX);
+
+    *qsrc_p = qsrc;
+    return qsink;
+}
+
+/** @internal @This transfers a pipe to the thread of a stage.
+ *
+ * @param upipe description structure of the pipe
+ * @param ctx context of the stage
+ * @param remote pipe to transfer (belongs to the callee)
+ * @param name name of the xfer pipe
+ * @return pointer to the xfer pipe, or NULL in case of error
+ */
+static struct upipe *upipe_wchain_xfer(struct upipe *upipe,
+                                       struct upipe_wchain_ctx *ctx,
+                                       struct upipe *remote, const char *name)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    struct upipe *xfer = upipe_xfer_alloc(ctx->xfer_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_wchain->proxy_probe),
+                             UPROBE_LOG_VERBOSE, name),
+            remote);
+    if (unlikely(xfer == NULL))
+        return NULL;
+    upipe_attach_upump_mgr(xfer);
+    ulist_add(&upipe_wchain->upump_mgr_pipes, upipe_to_uchain(xfer));
+    return xfer;
+}
+
+/** @internal @This allocates a worker chain pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *_upipe_wchain_alloc(struct upipe_mgr *mgr,
+                                         struct uprobe *uprobe,
+                                         uint32_t signature, va_list args)
+{
+    if (signature != UPIPE_WCHAIN_SIGNATURE) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    const struct upipe_wchain_stage *stages =
+        va_arg(args, const struct upipe_wchain_stage *);
+    unsigned int nb_stages = va_arg(args, unsigned int);
+    unsigned int out_queue_length = va_arg(args, unsigned int);
+    struct upipe *upipe = NULL;
+    struct upipe *qsink = NULL;
+
+    if (unlikely(stages == NULL || !nb_stages))
+        goto error;
+    for (unsigned int i = 0; i < nb_stages; i++)
+        if (unlikely(stages[i].upipe == NULL || stages[i].xfer_mgr == NULL))
+            goto error;
+
+    struct upipe_wchain *upipe_wchain = malloc(sizeof(struct upipe_wchain));
+    if (unlikely(upipe_wchain == NULL))
+        goto error;
+    upipe_wchain->stages = calloc(nb_stages, sizeof(struct upipe_wchain_ctx));
+    if (unlikely(upipe_wchain->stages == NULL)) {
+        free(upipe_wchain);
+        goto error;
+    }
+
+    upipe = upipe_wchain_to_upipe(upipe_wchain);
+    upipe_init(upipe, mgr, uprobe_use(uprobe));
+    upipe_wchain_init_urefcount(upipe);
+    upipe_wchain_init_urefcount_real(upipe);
+    upipe_wchain_init_proxy_probe(upipe);
+    upipe_wchain_init_out_qsrc_probe(upipe);
+    upipe_wchain_init_bin_input(upipe);
+    upipe_wchain_init_bin_output(upipe);
+    ulist_init(&upipe_wchain->upump_mgr_pipes);
+    upipe_wchain->nb_stages = nb_stages;
+    for (unsigned int i = 0; i < nb_stages; i++) {
+        struct upipe_wchain_ctx *ctx = &upipe_wchain->stages[i];
+        uprobe_init(&ctx->in_qsrc_probe, upipe_wchain_in_qsrc_probe,
+                    uprobe_use(stages[i].uprobe));
+        ctx->in_qsrc_probe.refcount =
+            upipe_wchain_to_urefcount_real(upipe_wchain);
+        ctx->xfer_mgr = upipe_mgr_use(stages[i].xfer_mgr);
+        ctx->first_remote_xfer = NULL;
+        ctx->last_remote_xfer = NULL;
+    }
+    upipe_wchain->frozen = false;
+    upipe_throw_ready(upipe);
+
+    /* output queue, fed by the last stage */
+    struct upipe *out_qsrc;
+    qsink = upipe_wchain_alloc_queue(upipe,
+            uprobe_pfx_alloc(uprobe_use(&upipe_wchain->out_qsrc_probe),
+                             UPROBE_LOG_VERBOSE, "out_qsrc"),
+            uprobe_pfx_alloc(uprobe_use(stages[nb_stages - 1].uprobe),
+                             UPROBE_LOG_VERBOSE, "out_qsink"),
+            out_queue_length, &out_qsrc);
+    if (unlikely(qsink == NULL))
+        goto error;
+    upipe_attach_upump_mgr(out_qsrc);
+    ulist_add(&upipe_wchain->upump_mgr_pipes, upipe_to_uchain(out_qsrc));
+    upipe_wchain_store_bin_output(upipe, upipe_use(out_qsrc));
+
+    /* stages, from the last one, so that each is connected to the queue
+     * sink of the next one */
+    for (unsigned int i = nb_stages; i-- > 0; ) {
+        struct upipe_wchain_ctx *ctx = &upipe_wchain->stages[i];
+        struct upipe *remote = stages[i].upipe;
+        struct upipe *last_remote = upipe_use(remote);
+        struct upipe *tmp;
+
+        /* upipe_get_output is a control command and may trigger a
+         * need_upump_mgr event */
+        uprobe_throw(upipe->uprobe, NULL, UPROBE_FREEZE_UPUMP_MGR);
+        while (ubase_check(upipe_get_output(last_remote, &tmp)) &&
+               tmp != NULL) {
+            upipe_use(tmp);
+            upipe_release(last_remote);
+            last_remote = tmp;
+        }
+        uprobe_throw(upipe->uprobe, NULL, UPROBE_THAW_UPUMP_MGR);
+
+        struct upipe *xfer = upipe_wchain_xfer(upipe, ctx,
+                upipe_use(last_remote), "stage_last_xfer");
+        if (unlikely(xfer == NULL)) {
+            upipe_release(last_remote);
+            goto error;
+        }
+        ctx->last_remote_xfer = upipe_use(xfer);
+        if (last_remote != remote) {
+            xfer = upipe_wchain_xfer(upipe, ctx, upipe_use(remote),
+                                     "stage_xfer");
+            if (unlikely(xfer == NULL)) {
+                upipe_release(last_remote);
+                goto error;
+            }
+        }
+        ctx->first_remote_xfer = upipe_use(xfer);
+        upipe_release(last_remote);
+
+        upipe_set_output(ctx->last_remote_xfer, qsink);
+        upipe_release(qsink);
+        qsink = NULL;
+
+        /* input queue, fed by the previous stage or by the main thread */
+        struct upipe *in_qsrc;
+        qsink = upipe_wchain_alloc_queue(upipe,
+                uprobe_pfx_alloc(uprobe_use(&ctx->in_qsrc_probe),
+                                 UPROBE_LOG_VERBOSE, "in_qsrc"),
+                uprobe_pfx_alloc(uprobe_use(i ? stages[i - 1].uprobe :
+                                            &upipe_wchain->proxy_probe),
+                                 UPROBE_LOG_VERBOSE, "in_qsink"),
+                stages[i].queue_length, &in_qsrc);
+        if (unlikely(qsink == NULL))
+            goto error;
+
+        struct upipe *in_qsrc_xfer = upipe_wchain_xfer(upipe, ctx, in_qsrc,
+                                                       "in_qsrc_xfer");
+        if (unlikely(in_qsrc_xfer == NULL))
+            goto error;
+        upipe_set_output(in_qsrc_xfer, remote);
+    }
+    upipe_wchain_store_bin_input(upipe, qsink);
+
+    for (unsigned int i = 0; i < nb_stages; i++) {
+        upipe_release(stages[i].upipe);
+        uprobe_release(stages[i].uprobe);
+    }
+    uprobe_release(uprobe);
+    return upipe;
+
+error:
+    upipe_release(qsink);
+    upipe_release(upipe);
+    for (unsigned int i = 0; stages != NULL && i < nb_stages; i++) {
+        upipe_release(stages[i].upipe);
+        uprobe_release(stages[i].uprobe);
+    }
+    uprobe_release(uprobe);
+    return NULL;
+}
+
+/** @internal @This checks whether a stage is the first one to run on its
+ * thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param stage index of the stage
+ * @return true if no previous stage uses the same xfer manager
+ */
+static bool upipe_wchain_first_on_thread(struct upipe *upipe,
+                                         unsigned int stage)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    for (unsigned int i = 0; i < stage; i++)
+        if (upipe_wchain->stages[i].xfer_mgr ==
+                upipe_wchain->stages[stage].xfer_mgr)
+            return false;
+    return true;
+}
+
+/** @internal @This thaws the threads of the given number of first stages.
+ *
+ * @param upipe description structure of the pipe
+ * @param nb_stages number of stages to thaw
+ * @return an error code
+ */
+static int upipe_wchain_thaw_stages(struct upipe *upipe,
+                                    unsigned int nb_stages)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    int err = UBASE_ERR_NONE;
+    for (unsigned int i = nb_stages; i-- > 0; ) {
+        if (!upipe_wchain_first_on_thread(upipe, i))
+            continue;
+        int ret = upipe_xfer_mgr_thaw(upipe_wchain->stages[i].xfer_mgr);
+        if (!ubase_check(ret))
+            err = ret;
+    }
+    return err;
+}
+
+/** @internal @This freezes the inner pipes of all stages.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_wchain_freeze(struct upipe *upipe)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    if (upipe_wchain->frozen)
+        return UBASE_ERR_NONE;
+
+    for (unsigned int i = 0; i < upipe_wchain->nb_stages; i++) {
+        if (!upipe_wchain_first_on_thread(upipe, i))
+            continue;
+        int err = upipe_xfer_mgr_freeze(upipe_wchain->stages[i].xfer_mgr);
+        if (unlikely(!ubase_check(err))) {
+            upipe_wchain_thaw_stages(upipe, i);
+            return err;
+        }
+    }
+    upipe_wchain->frozen = true;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This thaws the inner pipes of all stages.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_wchain_thaw(struct upipe *upipe)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    if (!upipe_wchain->frozen)
+        return UBASE_ERR_NONE;
+
+    UBASE_RETURN(upipe_wchain_thaw_stages(upipe, upipe_wchain->nb_stages));
+    upipe_wchain->frozen = false;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This flushes the queues of the chain, from the first stage to
+ * the last one, so that a flushed queue is not fed again with packets
+ * coming from an upstream queue that has not been flushed yet. The queues
+ * between stages can only be flushed if the xfer managers were allocated
+ * with a mutex.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_wchain_flush(struct upipe *upipe)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    if (upipe_wchain->in_qsink != NULL)
+        UBASE_RETURN(upipe_flush(upipe_wchain->in_qsink));
+
+    for (unsigned int i = 0; i + 1 < upipe_wchain->nb_stages; i++) {
+        struct upipe_wchain_ctx *ctx = &upipe_wchain->stages[i];
+        struct upipe *last_remote = NULL;
+        struct upipe *qsink = NULL;
+
+        if (!upipe_wchain->frozen)
+            UBASE_RETURN(upipe_xfer_mgr_freeze(ctx->xfer_mgr));
+        int err = upipe_xfer_get_remote(ctx->last_remote_xfer, &last_remote);
+        if (ubase_check(err) && last_remote != NULL)
+            err = upipe_get_output(last_remote, &qsink);
+        if (ubase_check(err) && qsink != NULL)
+            err = upipe_flush(qsink);
+        if (!upipe_wchain->frozen)
+            upipe_xfer_mgr_thaw(ctx->xfer_mgr);
+        UBASE_RETURN(err);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on an inner pipe of a
+ * stage.
+ *
+ * @param upipe description structure of the pipe
+ * @param remote_xfer xfer pipe of the inner pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_wchain_control_remote(struct upipe *upipe,
+                                       struct upipe *remote_xfer,
+                                       int command, va_list args)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    struct upipe *inner = NULL;
+    bool frozen = upipe_wchain->frozen;
+    int err = UBASE_ERR_UNHANDLED;
+
+    if (!frozen && !ubase_check(upipe_wchain_freeze(upipe)))
+        return err;
+
+    if (ubase_check(upipe_xfer_get_remote(remote_xfer, &inner)) && inner)
+        err = upipe_control_va(inner, command, args);
+
+    if (!frozen)
+        upipe_wchain_thaw(upipe);
+
+    return err;
+}
+
+/** @internal @This processes control commands on a worker chain pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_wchain_control(struct upipe *upipe, int command,
+                                va_list args)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    struct upipe_wchain_ctx *first = &upipe_wchain->stages[0];
+    struct upipe_wchain_ctx *last =
+        &upipe_wchain->stages[upipe_wchain->nb_stages - 1];
+
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR: {
+            struct uchain *uchain;
+            ulist_foreach (&upipe_wchain->upump_mgr_pipes, uchain) {
+                struct upipe *upump_mgr_pipe = upipe_from_uchain(uchain);
+                upipe_attach_upump_mgr(upump_mgr_pipe);
+            }
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_FLUSH:
+            return upipe_wchain_flush(upipe);
+        case UPIPE_BIN_FREEZE:
+            return upipe_wchain_freeze(upipe);
+        case UPIPE_BIN_THAW:
+            return upipe_wchain_thaw(upipe);
+        case UPIPE_BIN_GET_FIRST_INNER: {
+            struct upipe **p = va_arg(args, struct upipe **);
+            if (!upipe_wchain->frozen)
+                return UBASE_ERR_BUSY;
+            return upipe_xfer_get_remote(first->first_remote_xfer, p);
+        }
+        case UPIPE_BIN_GET_LAST_INNER: {
+            struct upipe **p = va_arg(args, struct upipe **);
+            if (!upipe_wchain->frozen)
+                return UBASE_ERR_BUSY;
+            return upipe_xfer_get_remote(last->last_remote_xfer, p);
+        }
+        default:
+            break;
+    }
+
+    UBASE_HANDLED_RETURN(upipe_wchain_control_bin_input(upipe, command, args));
+    UBASE_HANDLED_RETURN(upipe_wchain_control_bin_output(upipe, command,
+                                                         args));
+    UBASE_HANDLED_RETURN(upipe_wchain_control_remote(upipe,
+                first->first_remote_xfer, command, args));
+    UBASE_HANDLED_RETURN(upipe_wchain_control_remote(upipe,
+                last->last_remote_xfer, command, args));
+    return UBASE_ERR_UNHANDLED;
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe pipe to free
+ */
+static void upipe_wchain_free(struct upipe *upipe)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+
+    upipe_throw_dead(upipe);
+    for (unsigned int i = 0; i < upipe_wchain->nb_stages; i++) {
+        struct upipe_wchain_ctx *ctx = &upipe_wchain->stages[i];
+        uprobe_clean(&ctx->in_qsrc_probe);
+        upipe_mgr_release(ctx->xfer_mgr);
+    }
+    free(upipe_wchain->stages);
+    upipe_wchain_clean_proxy_probe(upipe);
+    upipe_wchain_clean_out_qsrc_probe(upipe);
+    upipe_wchain_clean_urefcount_real(upipe);
+    upipe_wchain_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_wchain);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_wchain_no_ref(struct upipe *upipe)
+{
+    struct upipe_wchain *upipe_wchain = upipe_wchain_from_upipe(upipe);
+    upipe_wchain_clean_bin_input(upipe);
+    upipe_wchain_clean_bin_output(upipe);
+    for (unsigned int i = 0; i < upipe_wchain->nb_stages; i++) {
+        struct upipe_wchain_ctx *ctx = &upipe_wchain->stages[i];
+        upipe_release(ctx->first_remote_xfer);
+        upipe_release(ctx->last_remote_xfer);
+        ctx->first_remote_xfer = NULL;
+        ctx->last_remote_xfer = NULL;
+    }
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_wchain->upump_mgr_pipes, uchain, uchain_tmp) {
+        struct upipe *upump_mgr_pipe = upipe_from_uchain(uchain);
+        ulist_delete(uchain);
+        upipe_release(upump_mgr_pipe);
+    }
+
+    upipe_wchain_release_urefcount_real(upipe);
+}
+
+/** @This frees a upipe manager.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_wchain_mgr_free(struct urefcount *urefcount)
+{
+    struct upipe_wchain_mgr *wchain_mgr =
+        upipe_wchain_mgr_from_urefcount(urefcount);
+    upipe_mgr_release(wchain_mgr->qsrc_mgr);
+    upipe_mgr_release(wchain_mgr->qsink_mgr);
+
+    urefcount_clean(urefcount);
+    free(wchain_mgr);
+}
+
+/** @This returns the management structure for all wchain pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_wchain_mgr_alloc(void)
+{
+    struct upipe_wchain_mgr *wchain_mgr =
+        malloc(sizeof(struct upipe_wchain_mgr));
+    if (unlikely(wchain_mgr == NULL))
+        return NULL;
+
+    memset(wchain_mgr, 0, sizeof(*wchain_mgr));
+    wchain_mgr->qsrc_mgr = upipe_qsrc_mgr_alloc();
+    wchain_mgr->qsink_mgr = upipe_qsink_mgr_alloc();
+
+    urefcount_init(upipe_wchain_mgr_to_urefcount(wchain_mgr),
+                   upipe_wchain_mgr_free);
+    wchain_mgr->mgr.refcount = upipe_wchain_mgr_to_urefcount(wchain_mgr);
+    wchain_mgr->mgr.signature = UPIPE_WCHAIN_SIGNATURE;
+    wchain_mgr->mgr.upipe_alloc = _upipe_wchain_alloc;
+    wchain_mgr->mgr.upipe_input = upipe_wchain_bin_input;
+    wchain_mgr->mgr.upipe_control = upipe_wchain_control;
+    wchain_mgr->mgr.upipe_mgr_control = NULL;
+    return upipe_wchain_mgr_to_upipe_mgr(wchain_mgr);
+}
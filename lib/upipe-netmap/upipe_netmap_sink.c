@@ -0,0 +1,735 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe sink module for netmap transmit rings
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_flow.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_upump_mgr.h"
+#include "upipe/upipe_helper_upump.h"
+#include "upipe/upipe_helper_input.h"
+#include "upipe/upipe_helper_uclock.h"
+#include "upipe-netmap/upipe_netmap_sink.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define NETMAP_WITH_LIBS
+#include <net/netmap.h>
+#include <net/netmap_user.h>
+
+#include <bitstream/ieee/ethernet.h>
+#include <bitstream/ietf/ip.h>
+#include <bitstream/ietf/udp.h>
+#include <bitstream/ietf/rtp.h>
+
+/** expected flow definition on all flows */
+#define EXPECTED_FLOW_DEF "block."
+/** flow definition of complete RTP packets */
+#define RTP_FLOW_DEF "block.rtp."
+/** tolerance for late packets */
+#define SYSTIME_TOLERANCE UCLOCK_FREQ
+/** datagrams due before now + this interval are queued in the ring */
+#define UPIPE_NETMAP_SINK_TICK (UCLOCK_FREQ / 1000)
+/** size of the headers written in front of the payload */
+#define UPIPE_NETMAP_SINK_HEADER_SIZE (ETHERNET_HEADER_LEN +                \
+        IP_HEADER_MINSIZE + UDP_HEADER_SIZE + RTP_HEADER_SIZE)
+/** default RTP payload type */
+#define UPIPE_NETMAP_SINK_DEFAULT_TYPE 98
+/** default RTP clock rate */
+#define UPIPE_NETMAP_SINK_DEFAULT_CLOCKRATE 27000000
+/** default size of the payload of a datagram */
+#define UPIPE_NETMAP_SINK_DEFAULT_PAYLOAD_SIZE 1376
+/** default TTL of the datagrams */
+#define UPIPE_NETMAP_SINK_DEFAULT_TTL 64
+
+/** @hidden */
+static bool upipe_netmap_sink_output(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p);
+
+/** @internal @This is the private context of a netmap sink pipe. */
+struct upipe_netmap_sink {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** pacing timer */
+    struct upump *upump;
+
+    /** uclock structure, if not NULL we are in live mode */
+    struct uclock *uclock;
+    /** uclock request */
+    struct urequest uclock_request;
+
+    /** delay applied to systime attribute when uclock is provided */
+    uint64_t latency;
+
+    /** temporary uref storage */
+    struct uchain urefs;
+    /** nb urefs in storage */
+    unsigned int nb_urefs;
+    /** max urefs in storage */
+    unsigned int max_urefs;
+    /** list of blockers */
+    struct uchain blockers;
+
+    /** netmap descriptor */
+    struct nm_desc *d;
+    /** uri */
+    char *uri;
+    /** netmap transmit ring */
+    unsigned int ring_idx;
+
+    /** template of the headers */
+    uint8_t header[UPIPE_NETMAP_SINK_HEADER_SIZE];
+    /** IP identification of the next datagram */
+    uint16_t ip_id;
+    /** RTP sequence number of the next datagram */
+    uint16_t seqnum;
+    /** RTP payload type */
+    uint8_t type;
+    /** RTP clock rate */
+    uint32_t clockrate;
+    /** size of the payload of a datagram */
+    unsigned int payload_size;
+    /** true if the urefs are complete RTP packets */
+    bool rtp;
+
+    /** number of datagrams of the current uref already queued */
+    unsigned int packet;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_netmap_sink, upipe, UPIPE_NETMAP_SINK_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_netmap_sink, urefcount, upipe_netmap_sink_free)
+UPIPE_HELPER_VOID(upipe_netmap_sink)
+UPIPE_HELPER_UPUMP_MGR(upipe_netmap_sink, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_netmap_sink, upump, upump_mgr)
+UPIPE_HELPER_INPUT(upipe_netmap_sink, urefs, nb_urefs, max_urefs, blockers,
+                   upipe_netmap_sink_output)
+UPIPE_HELPER_UCLOCK(upipe_netmap_sink, uclock, uclock_request, NULL,
+                    upipe_throw_provide_request, NULL)
+
+/** @internal @This allocates a netmap sink pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_netmap_sink_alloc(struct upipe_mgr *mgr,
+                                             struct uprobe *uprobe,
+                                             uint32_t signature, va_list args)
+{
+    struct upipe *upipe =
+        upipe_netmap_sink_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+    upipe_netmap_sink_init_urefcount(upipe);
+    upipe_netmap_sink_init_upump_mgr(upipe);
+    upipe_netmap_sink_init_upump(upipe);
+    upipe_netmap_sink_init_input(upipe);
+    upipe_netmap_sink_init_uclock(upipe);
+    upipe_netmap_sink->latency = 0;
+    upipe_netmap_sink->d = NULL;
+    upipe_netmap_sink->uri = NULL;
+    upipe_netmap_sink->ring_idx = 0;
+    memset(upipe_netmap_sink->header, 0, sizeof(upipe_netmap_sink->header));
+    upipe_netmap_sink->ip_id = 0;
+    upipe_netmap_sink->seqnum = 0;
+    upipe_netmap_sink->type = UPIPE_NETMAP_SINK_DEFAULT_TYPE;
+    upipe_netmap_sink->clockrate = UPIPE_NETMAP_SINK_DEFAULT_CLOCKRATE;
+    upipe_netmap_sink->payload_size = UPIPE_NETMAP_SINK_DEFAULT_PAYLOAD_SIZE;
+    upipe_netmap_sink->rtp = false;
+    upipe_netmap_sink->packet = 0;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This computes the checksum of an IPv4 header.
+ *
+ * @param ip pointer to the header
+ * @return checksum
+ */
+static uint16_t upipe_netmap_sink_ip_cksum(const uint8_t *ip)
+{
+    uint32_t sum = 0;
+    for (unsigned int i = 0; i < IP_HEADER_MINSIZE; i += 2)
+        sum += (ip[i] << 8) | ip[i + 1];
+    while (sum >> 16)
+        sum = (sum & 0xffff) + (sum >> 16);
+    return ~sum;
+}
+
+/** @internal @This writes a datagram in the next slot of the ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param txring transmit ring
+ * @param uref uref containing the payload
+ * @param offset offset of the payload in the uref
+ * @param size size of the payload
+ * @param timestamp RTP timestamp
+ * @param last true for the last datagram of the uref
+ * @return an error code
+ *
+ * If the urefs are complete RTP packets, the payload is written right after
+ * the UDP header, and timestamp and last are ignored.
+ */
+static int upipe_netmap_sink_write(struct upipe *upipe,
+                                   struct netmap_ring *txring,
+                                   struct uref *uref, size_t offset,
+                                   size_t size, uint32_t timestamp, bool last)
+{
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+    const uint32_t cur = txring->cur;
+    struct netmap_slot *slot = &txring->slot[cur];
+    uint8_t *buf = (uint8_t *)NETMAP_BUF(txring, slot->buf_idx);
+
+    size_t header_size = UPIPE_NETMAP_SINK_HEADER_SIZE;
+    if (upipe_netmap_sink->rtp)
+        header_size -= RTP_HEADER_SIZE;
+    memcpy(buf, upipe_netmap_sink->header, header_size);
+    UBASE_RETURN(uref_block_extract(uref, offset, size, buf + header_size))
+
+    uint8_t *ip = buf + ETHERNET_HEADER_LEN;
+    ip_set_len(ip, header_size - ETHERNET_HEADER_LEN + size);
+    ip_set_id(ip, upipe_netmap_sink->ip_id++);
+    ip_set_cksum(ip, upipe_netmap_sink_ip_cksum(ip));
+
+    uint8_t *udp = ip + IP_HEADER_MINSIZE;
+    udp_set_len(udp, header_size - ETHERNET_HEADER_LEN - IP_HEADER_MINSIZE +
+                     size);
+
+    if (!upipe_netmap_sink->rtp) {
+        uint8_t *rtp = udp + UDP_HEADER_SIZE;
+        rtp_set_seqnum(rtp, upipe_netmap_sink->seqnum++);
+        rtp_set_timestamp(rtp, timestamp);
+        if (last)
+            rtp_set_marker(rtp);
+    }
+
+    slot->len = header_size + size;
+    txring->head = txring->cur = nm_ring_next(txring, cur);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This is called when the next datagrams are due, or when the
+ * ring has room again.
+ *
+ * @param upump description structure of the timer
+ */
+static void upipe_netmap_sink_watcher(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_netmap_sink_set_upump(upipe, NULL);
+    upipe_netmap_sink_output_input(upipe);
+    upipe_netmap_sink_unblock_input(upipe);
+    if (upipe_netmap_sink_check_input(upipe)) {
+        /* All packets have been output, release again the pipe that has been
+         * used in @ref upipe_netmap_sink_input. */
+        upipe_release(upipe);
+    }
+}
+
+/** @internal @This queues the datagrams of a uref which are due in the
+ * transmit ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ * @return true if the uref was entirely processed
+ */
+static bool upipe_netmap_sink_output(struct upipe *upipe, struct uref *uref,
+                                     struct upump **upump_p)
+{
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+    const char *def;
+    if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        uint64_t latency = 0;
+        uref_clock_get_latency(uref, &latency);
+        if (latency > upipe_netmap_sink->latency)
+            upipe_netmap_sink->latency = latency;
+        upipe_netmap_sink->rtp =
+            ubase_check(uref_flow_match_def(uref, RTP_FLOW_DEF));
+        uref_free(uref);
+        return true;
+    }
+
+    if (unlikely(upipe_netmap_sink->d == NULL)) {
+        uref_free(uref);
+        upipe_warn(upipe, "received a buffer before opening a ring");
+        return true;
+    }
+
+    size_t uref_size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &uref_size)) ||
+                 !uref_size)) {
+        uref_free(uref);
+        upipe_netmap_sink->packet = 0;
+        return true;
+    }
+    if (unlikely(upipe_netmap_sink->rtp &&
+                 uref_size + UPIPE_NETMAP_SINK_HEADER_SIZE - RTP_HEADER_SIZE >
+                 NETMAP_BUF_SIZE)) {
+        upipe_warn_va(upipe, "dropping oversized RTP packet (%zu)", uref_size);
+        uref_free(uref);
+        return true;
+    }
+    /* RTP packets are sent as is */
+    size_t payload_size = upipe_netmap_sink->rtp ? uref_size :
+                          upipe_netmap_sink->payload_size;
+    unsigned int nb_packets = (uref_size + payload_size - 1) / payload_size;
+
+    /* datagrams are spread over the duration of the uref */
+    uint64_t systime = 0, duration = 0, now = 0;
+    bool paced = false;
+    if (upipe_netmap_sink->uclock != NULL) {
+        if (likely(ubase_check(uref_clock_get_cr_sys(uref, &systime)))) {
+            paced = true;
+            systime += upipe_netmap_sink->latency;
+            uref_clock_get_duration(uref, &duration);
+            now = uclock_now(upipe_netmap_sink->uclock);
+        } else
+            upipe_warn(upipe, "received non-dated buffer");
+    }
+    if (paced && !upipe_netmap_sink->packet &&
+        now > systime + duration + SYSTIME_TOLERANCE) {
+        upipe_warn_va(upipe, "dropping late buffer %"PRIu64" ms, "
+                      "latency %"PRIu64" ms",
+                      (now - systime) / (UCLOCK_FREQ / 1000),
+                      upipe_netmap_sink->latency / (UCLOCK_FREQ / 1000));
+        uref_free(uref);
+        return true;
+    }
+
+    uint64_t pts = 0;
+    if (unlikely(!ubase_check(uref_clock_get_pts_prog(uref, &pts))))
+        uref_clock_get_pts_sys(uref, &pts);
+    lldiv_t div = lldiv(pts, UCLOCK_FREQ);
+    uint32_t timestamp = div.quot * upipe_netmap_sink->clockrate +
+        ((uint64_t)div.rem * upipe_netmap_sink->clockrate) / UCLOCK_FREQ;
+
+    struct netmap_ring *txring = NETMAP_TXRING(upipe_netmap_sink->d->nifp,
+                                               upipe_netmap_sink->ring_idx);
+    uint64_t wait = 0;
+    bool queued = false;
+    while (upipe_netmap_sink->packet < nb_packets) {
+        unsigned int packet = upipe_netmap_sink->packet;
+        if (paced) {
+            uint64_t date = systime + duration * packet / nb_packets;
+            if (date > now + UPIPE_NETMAP_SINK_TICK) {
+                wait = date - now - UPIPE_NETMAP_SINK_TICK;
+                break;
+            }
+        }
+        if (!nm_ring_space(txring)) {
+            wait = UPIPE_NETMAP_SINK_TICK;
+            break;
+        }
+
+        size_t offset = (size_t)packet * payload_size;
+        size_t size = uref_size - offset < payload_size ?
+                      uref_size - offset : payload_size;
+        if (unlikely(!ubase_check(upipe_netmap_sink_write(upipe, txring,
+                            uref, offset, size, timestamp,
+                            packet == nb_packets - 1)))) {
+            upipe_warn(upipe, "cannot read ubuf buffer");
+            break;
+        }
+        upipe_netmap_sink->packet++;
+        queued = true;
+    }
+    if (queued)
+        ioctl(NETMAP_FD(upipe_netmap_sink->d), NIOCTXSYNC, NULL);
+
+    if (upipe_netmap_sink->packet < nb_packets && wait) {
+        upipe_netmap_sink_check_upump_mgr(upipe);
+        if (likely(upipe_netmap_sink->upump_mgr != NULL)) {
+            upipe_netmap_sink_wait_upump(upipe, wait,
+                                         upipe_netmap_sink_watcher);
+            return false;
+        }
+        upipe_warn(upipe, "no upump manager, dropping the end of a buffer");
+    }
+
+    upipe_netmap_sink->packet = 0;
+    uref_free(uref);
+    return true;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_netmap_sink_input(struct upipe *upipe, struct uref *uref,
+                                    struct upump **upump_p)
+{
+    if (!upipe_netmap_sink_check_input(upipe)) {
+        upipe_netmap_sink_hold_input(upipe, uref);
+        upipe_netmap_sink_block_input(upipe, upump_p);
+    } else if (!upipe_netmap_sink_output(upipe, uref, upump_p)) {
+        upipe_netmap_sink_hold_input(upipe, uref);
+        upipe_netmap_sink_block_input(upipe, upump_p);
+        /* Increment upipe refcount to avoid disappearing before all packets
+         * have been sent. */
+        upipe_use(upipe);
+    }
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_netmap_sink_set_flow_def(struct upipe *upipe,
+                                          struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    flow_def = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def)
+    upipe_input(upipe, flow_def, NULL);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This fills the template of the headers from the interface
+ * and the destination.
+ *
+ * @param upipe description structure of the pipe
+ * @param ifname name of the interface
+ * @param dst destination address and port
+ * @return an error code
+ */
+static int upipe_netmap_sink_set_header(struct upipe *upipe,
+                                        const char *ifname, const char *dst)
+{
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+    char addr[INET_ADDRSTRLEN];
+    unsigned int port;
+    struct in_addr dst_addr;
+    if (sscanf(dst, "%15[^:]:%u", addr, &port) != 2 || !port ||
+        port > UINT16_MAX || inet_pton(AF_INET, addr, &dst_addr) != 1) {
+        upipe_err_va(upipe, "invalid destination %s", dst);
+        return UBASE_ERR_INVALID;
+    }
+    if (!IN_MULTICAST(ntohl(dst_addr.s_addr))) {
+        /* there is no ARP resolution on a netmap ring */
+        upipe_err_va(upipe, "destination %s is not multicast", dst);
+        return UBASE_ERR_INVALID;
+    }
+
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    if (strlen(ifname) >= sizeof(ifr.ifr_name)) {
+        upipe_err_va(upipe, "invalid interface %s", ifname);
+        return UBASE_ERR_INVALID;
+    }
+    strcpy(ifr.ifr_name, ifname);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (unlikely(fd == -1)) {
+        upipe_err_va(upipe, "can't open socket (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+    uint8_t src_mac[6];
+    struct in_addr src_addr;
+    if (ioctl(fd, SIOCGIFHWADDR, &ifr) < 0) {
+        upipe_err_va(upipe, "can't get address of %s (%m)", ifname);
+        close(fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+    memcpy(src_mac, ifr.ifr_hwaddr.sa_data, sizeof(src_mac));
+    ifr.ifr_addr.sa_family = AF_INET;
+    if (ioctl(fd, SIOCGIFADDR, &ifr) < 0) {
+        upipe_err_va(upipe, "can't get IPv4 address of %s (%m)", ifname);
+        close(fd);
+        return UBASE_ERR_EXTERNAL;
+    }
+    src_addr = ((struct sockaddr_in *)&ifr.ifr_addr)->sin_addr;
+    close(fd);
+
+    uint8_t *header = upipe_netmap_sink->header;
+    memset(header, 0, UPIPE_NETMAP_SINK_HEADER_SIZE);
+
+    /* multicast MAC address, RFC 1112 */
+    uint32_t group = ntohl(dst_addr.s_addr);
+    header[0] = 0x01;
+    header[1] = 0x00;
+    header[2] = 0x5e;
+    header[3] = (group >> 16) & 0x7f;
+    header[4] = (group >> 8) & 0xff;
+    header[5] = group & 0xff;
+    memcpy(header + 6, src_mac, sizeof(src_mac));
+    ethernet_set_lentype(header, ETHERNET_TYPE_IP);
+
+    uint8_t *ip = header + ETHERNET_HEADER_LEN;
+    ip_set_version(ip, 4);
+    ip_set_ihl(ip, 5);
+    ip_set_tos(ip, 0);
+    ip_set_flag_df(ip, 1);
+    ip_set_ttl(ip, UPIPE_NETMAP_SINK_DEFAULT_TTL);
+    ip_set_proto(ip, IP_PROTO_UDP);
+    ip_set_srcaddr(ip, ntohl(src_addr.s_addr));
+    ip_set_dstaddr(ip, group);
+
+    uint8_t *udp = ip + IP_HEADER_MINSIZE;
+    udp_set_srcport(udp, port);
+    udp_set_dstport(udp, port);
+    udp_set_cksum(udp, 0);
+
+    uint8_t *rtp = udp + UDP_HEADER_SIZE;
+    rtp_set_hdr(rtp);
+    rtp_set_type(rtp, upipe_netmap_sink->type);
+    rtp_set_ssrc(rtp, (uint8_t *)&src_addr.s_addr);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the uri of the currently opened ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri_p filled in with the uri
+ * @return an error code
+ */
+static int upipe_netmap_sink_get_uri(struct upipe *upipe, const char **uri_p)
+{
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+    assert(uri_p != NULL);
+    *uri_p = upipe_netmap_sink->uri;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This asks to open the given netmap transmit ring.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri netmap port followed by @ and the destination
+ * @return an error code
+ */
+static int upipe_netmap_sink_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+
+    if (upipe_netmap_sink->d != NULL) {
+        nm_close(upipe_netmap_sink->d);
+        upipe_netmap_sink->d = NULL;
+    }
+    ubase_clean_str(&upipe_netmap_sink->uri);
+    upipe_netmap_sink_set_upump(upipe, NULL);
+    upipe_netmap_sink->packet = 0;
+
+    if (unlikely(uri == NULL))
+        return UBASE_ERR_NONE;
+
+    char ifname[IF_NAMESIZE];
+    const char *at = strchr(uri, '@');
+    if (at == NULL ||
+        sscanf(uri, "netmap:%15[^-]-%u/T", ifname,
+               &upipe_netmap_sink->ring_idx) != 2) {
+        upipe_err_va(upipe, "invalid netmap transmit uri %s", uri);
+        return UBASE_ERR_INVALID;
+    }
+    UBASE_RETURN(upipe_netmap_sink_set_header(upipe, ifname, at + 1))
+
+    char port[at - uri + 1];
+    memcpy(port, uri, at - uri);
+    port[at - uri] = '\0';
+    upipe_netmap_sink->d = nm_open(port, NULL, 0, 0);
+    if (unlikely(!upipe_netmap_sink->d)) {
+        upipe_err_va(upipe, "can't open netmap socket %s", port);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    upipe_netmap_sink->uri = strdup(uri);
+    if (unlikely(upipe_netmap_sink->uri == NULL)) {
+        nm_close(upipe_netmap_sink->d);
+        upipe_netmap_sink->d = NULL;
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    upipe_notice_va(upipe, "opening netmap socket %s ring %u",
+                    upipe_netmap_sink->uri, upipe_netmap_sink->ring_idx);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a netmap sink pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_netmap_sink_control(struct upipe *upipe,
+                                     int command, va_list args)
+{
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_netmap_sink_set_upump(upipe, NULL);
+            return upipe_netmap_sink_attach_upump_mgr(upipe);
+        case UPIPE_ATTACH_UCLOCK:
+            upipe_netmap_sink_set_upump(upipe, NULL);
+            upipe_netmap_sink_require_uclock(upipe);
+            return UBASE_ERR_NONE;
+
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *request = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, request);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_netmap_sink_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_GET_MAX_LENGTH: {
+            unsigned int *p = va_arg(args, unsigned int *);
+            return upipe_netmap_sink_get_max_length(upipe, p);
+        }
+        case UPIPE_SET_MAX_LENGTH: {
+            unsigned int max_length = va_arg(args, unsigned int);
+            return upipe_netmap_sink_set_max_length(upipe, max_length);
+        }
+
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            return upipe_netmap_sink_get_uri(upipe, uri_p);
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_netmap_sink_set_uri(upipe, uri);
+        }
+
+        case UPIPE_NETMAP_SINK_GET_RTP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SINK_SIGNATURE)
+            uint8_t *type_p = va_arg(args, uint8_t *);
+            uint32_t *clockrate_p = va_arg(args, uint32_t *);
+            *type_p = upipe_netmap_sink->type;
+            *clockrate_p = upipe_netmap_sink->clockrate;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NETMAP_SINK_SET_RTP: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SINK_SIGNATURE)
+            unsigned int type = va_arg(args, unsigned int);
+            uint32_t clockrate = va_arg(args, uint32_t);
+            if (type > 0x7f || !clockrate)
+                return UBASE_ERR_INVALID;
+            upipe_netmap_sink->type = type;
+            upipe_netmap_sink->clockrate = clockrate;
+            rtp_set_type(upipe_netmap_sink->header + ETHERNET_HEADER_LEN +
+                         IP_HEADER_MINSIZE + UDP_HEADER_SIZE, type);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NETMAP_SINK_GET_PAYLOAD_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SINK_SIGNATURE)
+            unsigned int *size_p = va_arg(args, unsigned int *);
+            *size_p = upipe_netmap_sink->payload_size;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_NETMAP_SINK_SET_PAYLOAD_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SINK_SIGNATURE)
+            unsigned int size = va_arg(args, unsigned int);
+            if (!size || size + UPIPE_NETMAP_SINK_HEADER_SIZE > NETMAP_BUF_SIZE)
+                return UBASE_ERR_INVALID;
+            upipe_netmap_sink->payload_size = size;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_netmap_sink_free(struct upipe *upipe)
+{
+    struct upipe_netmap_sink *upipe_netmap_sink =
+        upipe_netmap_sink_from_upipe(upipe);
+
+    if (upipe_netmap_sink->d != NULL)
+        nm_close(upipe_netmap_sink->d);
+
+    upipe_throw_dead(upipe);
+
+    free(upipe_netmap_sink->uri);
+    upipe_netmap_sink_clean_uclock(upipe);
+    upipe_netmap_sink_clean_upump(upipe);
+    upipe_netmap_sink_clean_upump_mgr(upipe);
+    upipe_netmap_sink_clean_input(upipe);
+    upipe_netmap_sink_clean_urefcount(upipe);
+    upipe_netmap_sink_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_netmap_sink_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_NETMAP_SINK_SIGNATURE,
+
+    .upipe_alloc = upipe_netmap_sink_alloc,
+    .upipe_input = upipe_netmap_sink_input,
+    .upipe_control = upipe_netmap_sink_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all netmap sinks
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_netmap_sink_mgr_alloc(void)
+{
+    return &upipe_netmap_sink_mgr;
+}
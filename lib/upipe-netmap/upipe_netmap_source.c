@@ -33,6 +33,7 @@
 #include "upipe/uref_clock.h"
 #include "upipe/upump.h"
 #include "upipe/ubuf.h"
+#include "upipe/uts_pid_filter.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -105,6 +106,9 @@ struct upipe_netmap_source {
     /** netmap ring **/
     unsigned int ring_idx;
 
+    /** TS PID filter, or NULL */
+    struct uts_pid_filter *pid_filter;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -151,6 +155,7 @@ static struct upipe *upipe_netmap_source_alloc(struct upipe_mgr *mgr,
     upipe_netmap_source_init_upump(upipe);
     upipe_netmap_source_init_uclock(upipe);
     upipe_netmap_source->uri = NULL;
+    upipe_netmap_source->pid_filter = NULL;
     upipe_netmap_source->d = NULL;
     upipe_throw_ready(upipe);
     return upipe;
@@ -181,9 +186,17 @@ static void upipe_netmap_source_worker(struct upump *upump)
             goto next;
 
         uint8_t *udp = ip_payload(ip);
-        const uint8_t *rtp = udp_payload(udp);
+        uint8_t *rtp = udp_payload(udp);
         uint16_t payload_len = udp_get_len(udp) - UDP_HEADER_SIZE;
 
+        if (upipe_netmap_source->pid_filter != NULL) {
+            /* filter in the netmap buffer, before allocating anything */
+            payload_len = uts_pid_filter_compact(
+                    upipe_netmap_source->pid_filter, rtp, payload_len);
+            if (!payload_len)
+                goto next;
+        }
+
         struct uref *uref = uref_block_alloc(upipe_netmap_source->uref_mgr,
                                              upipe_netmap_source->ubuf_mgr,
                                              payload_len);
@@ -355,11 +368,74 @@ static int _upipe_netmap_source_control(struct upipe *upipe,
             const char *uri = va_arg(args, const char *);
             return upipe_netmap_source_set_uri(upipe, uri);
         }
+        case UPIPE_NETMAP_SOURCE_SET_PID_FILTER: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SOURCE_SIGNATURE)
+            int enabled = va_arg(args, int);
+            return _upipe_netmap_source_set_pid_filter(upipe, !!enabled);
+        }
+        case UPIPE_NETMAP_SOURCE_ADD_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SOURCE_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            return _upipe_netmap_source_set_pid(upipe, pid, true);
+        }
+        case UPIPE_NETMAP_SOURCE_DEL_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_NETMAP_SOURCE_SIGNATURE)
+            unsigned int pid = va_arg(args, unsigned int);
+            return _upipe_netmap_source_set_pid(upipe, pid, false);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
 }
 
+/** @internal @This enables or disables the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to enable the filter
+ * @return an error code
+ */
+static int _upipe_netmap_source_set_pid_filter(struct upipe *upipe,
+                                               bool enabled)
+{
+    struct upipe_netmap_source *upipe_netmap_source =
+        upipe_netmap_source_from_upipe(upipe);
+    if (!enabled) {
+        free(upipe_netmap_source->pid_filter);
+        upipe_netmap_source->pid_filter = NULL;
+        return UBASE_ERR_NONE;
+    }
+    if (upipe_netmap_source->pid_filter != NULL)
+        return UBASE_ERR_NONE;
+
+    upipe_netmap_source->pid_filter = malloc(sizeof(struct uts_pid_filter));
+    if (unlikely(upipe_netmap_source->pid_filter == NULL))
+        return UBASE_ERR_ALLOC;
+    uts_pid_filter_init(upipe_netmap_source->pid_filter);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This selects or unselects a PID in the TS PID filter.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID to change
+ * @param selected true to select the PID
+ * @return an error code
+ */
+static int _upipe_netmap_source_set_pid(struct upipe *upipe, unsigned int pid,
+                                        bool selected)
+{
+    struct upipe_netmap_source *upipe_netmap_source =
+        upipe_netmap_source_from_upipe(upipe);
+    if (unlikely(upipe_netmap_source->pid_filter == NULL ||
+                 pid >= UTS_PID_FILTER_PIDS))
+        return UBASE_ERR_INVALID;
+    if (selected)
+        uts_pid_filter_add(upipe_netmap_source->pid_filter, pid);
+    else
+        uts_pid_filter_del(upipe_netmap_source->pid_filter, pid);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a netmap source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -388,6 +464,7 @@ static void upipe_netmap_source_free(struct upipe *upipe)
     upipe_throw_dead(upipe);
 
     free(upipe_netmap_source->uri);
+    free(upipe_netmap_source->pid_filter);
     upipe_netmap_source_clean_uclock(upipe);
     upipe_netmap_source_clean_upump(upipe);
     upipe_netmap_source_clean_upump_mgr(upipe);
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe pool of POSIX threads running event loops, shared by many
+ * pipelines
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/uprobe.h"
+#include "upipe/upipe.h"
+#include "upipe-pthread/upipe_pthread_pool.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/** @internal @This is the private structure of a pool of threads. */
+struct upipe_pthread_pool {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** index of the thread tried first for the next placement */
+    unsigned int next;
+    /** number of threads */
+    unsigned int nb_threads;
+    /** xfer managers of the threads */
+    struct upipe_mgr *xfer_mgrs[];
+};
+
+UBASE_FROM_TO(upipe_pthread_pool, urefcount, urefcount, urefcount)
+
+/** @internal @This frees a pool of threads.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_pthread_pool_free(struct urefcount *urefcount)
+{
+    struct upipe_pthread_pool *pool =
+        upipe_pthread_pool_from_urefcount(urefcount);
+    for (unsigned int i = 0; i < pool->nb_threads; i++)
+        upipe_mgr_release(pool->xfer_mgrs[i]);
+    urefcount_clean(&pool->urefcount);
+    free(pool);
+}
+
+struct upipe_pthread_pool *upipe_pthread_pool_alloc(unsigned int nb_threads,
+        unsigned int queue_length, uint16_t msg_pool_depth,
+        struct uprobe *uprobe_pthread_upump_mgr,
+        upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+        uint16_t upump_blocker_pool_depth,
+        const pthread_attr_t *restrict attr,
+        const struct upipe_pthread_sched *sched, const char *name)
+{
+    struct upipe_pthread_pool *pool = NULL;
+    if (unlikely(!nb_threads))
+        goto upipe_pthread_pool_alloc_err;
+
+    pool = malloc(sizeof(struct upipe_pthread_pool) +
+                  nb_threads * sizeof(struct upipe_mgr *));
+    if (unlikely(pool == NULL))
+        goto upipe_pthread_pool_alloc_err;
+    urefcount_init(&pool->urefcount, upipe_pthread_pool_free);
+    pool->next = 0;
+    pool->nb_threads = 0;
+
+    for (unsigned int i = 0; i < nb_threads; i++) {
+        char thread_name[16];
+        if (name != NULL)
+            snprintf(thread_name, sizeof(thread_name), "%s%u", name, i);
+
+        struct upipe_mgr *xfer_mgr = upipe_pthread_xfer_mgr_alloc_sched(
+                queue_length, msg_pool_depth,
+                uprobe_use(uprobe_pthread_upump_mgr), upump_mgr_alloc,
+                upump_pool_depth, upump_blocker_pool_depth, NULL, NULL,
+                attr, sched, name != NULL ? thread_name : NULL);
+        if (unlikely(xfer_mgr == NULL)) {
+            upipe_pthread_pool_release(pool);
+            pool = NULL;
+            goto upipe_pthread_pool_alloc_err;
+        }
+        pool->xfer_mgrs[pool->nb_threads++] = xfer_mgr;
+    }
+
+upipe_pthread_pool_alloc_err:
+    uprobe_release(uprobe_pthread_upump_mgr);
+    return pool;
+}
+
+struct upipe_mgr *upipe_pthread_pool_get_xfer_mgr(
+        struct upipe_pthread_pool *pool)
+{
+    /* every live xfer pipe holds a reference to its manager; ties are
+     * broken in a round-robin fashion */
+    unsigned int best = pool->next;
+    uint32_t best_load = UINT32_MAX;
+    for (unsigned int i = 0; i < pool->nb_threads; i++) {
+        unsigned int index = (pool->next + i) % pool->nb_threads;
+        struct upipe_mgr *xfer_mgr = pool->xfer_mgrs[index];
+        uint32_t load = uatomic_load(&xfer_mgr->refcount->refcount);
+        if (load < best_load) {
+            best = index;
+            best_load = load;
+        }
+    }
+    pool->next = (best + 1) % pool->nb_threads;
+    return upipe_mgr_use(pool->xfer_mgrs[best]);
+}
+
+unsigned int upipe_pthread_pool_get_nb_threads(
+        struct upipe_pthread_pool *pool)
+{
+    return pool->nb_threads;
+}
+
+struct upipe_pthread_pool *upipe_pthread_pool_use(
+        struct upipe_pthread_pool *pool)
+{
+    if (pool != NULL)
+        urefcount_use(&pool->urefcount);
+    return pool;
+}
+
+void upipe_pthread_pool_release(struct upipe_pthread_pool *pool)
+{
+    if (pool != NULL)
+        urefcount_release(&pool->urefcount);
+}
@@ -40,13 +40,23 @@
 #include "upipe-pthread/uprobe_pthread_upump_mgr.h"
 
 #include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <signal.h>
 #include <limits.h>
+#include <sched.h>
+
+/** set_mempolicy(2) policy preferring allocations on a node */
+#define UPIPE_PTHREAD_MPOL_PREFERRED 1
+/** maximum number of NUMA nodes */
+#define UPIPE_PTHREAD_MAX_NODES 256
 
 /** @internal @This is the private context for pthread. */
 struct upipe_pthread_ctx {
@@ -68,10 +78,110 @@ struct upipe_pthread_ctx {
     struct umutex *mutex;
     /** thread name */
     char *name;
-    /** thread priority value */
-    int priority;
+    /** scheduling parameters, with a private copy of the CPU array */
+    struct upipe_pthread_sched sched;
 };
 
+#ifdef __linux__
+/** @internal @This adds the CPUs of a NUMA node to a CPU set.
+ *
+ * @param numa_node NUMA node
+ * @param cpuset CPU set to fill in
+ * @return false in case of error
+ */
+static bool upipe_pthread_node_cpus(int numa_node, cpu_set_t *cpuset)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             numa_node);
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+        return false;
+
+    /* the list looks like "0-3,8-11" */
+    bool ret = false;
+    unsigned int first, last;
+    int c;
+    while (fscanf(file, "%u", &first) == 1) {
+        last = first;
+        if ((c = fgetc(file)) == '-') {
+            if (fscanf(file, "%u", &last) != 1)
+                break;
+            c = fgetc(file);
+        }
+        for (unsigned int cpu = first; cpu <= last && cpu < CPU_SETSIZE;
+             cpu++)
+            CPU_SET(cpu, cpuset);
+        ret = true;
+        if (c != ',')
+            break;
+    }
+    fclose(file);
+    return ret;
+}
+#endif
+
+/** @internal @This applies the scheduling parameters to the current thread.
+ *
+ * @param pthread_ctx private context of the thread
+ */
+static void upipe_pthread_sched_apply(struct upipe_pthread_ctx *pthread_ctx)
+{
+    const struct upipe_pthread_sched *sched = &pthread_ctx->sched;
+    struct uprobe *uprobe = pthread_ctx->uprobe_pthread_upump_mgr;
+
+    if (sched->priority != INT_MAX)
+        setpriority(PRIO_PROCESS, 0, sched->priority);
+
+#ifdef __linux__
+    if (sched->nb_cpus || sched->numa_node >= 0) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (unsigned int i = 0; i < sched->nb_cpus; i++)
+            if (sched->cpus[i] < CPU_SETSIZE)
+                CPU_SET(sched->cpus[i], &cpuset);
+        if (!sched->nb_cpus &&
+            !upipe_pthread_node_cpus(sched->numa_node, &cpuset))
+            uprobe_warn_va(uprobe, NULL, "unable to get CPUs of node %d",
+                           sched->numa_node);
+        else if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset),
+                                        &cpuset) != 0)
+            uprobe_warn(uprobe, NULL, "unable to set CPU affinity");
+    }
+
+#ifdef SYS_set_mempolicy
+    if (sched->numa_node >= 0) {
+        unsigned long nodemask[UPIPE_PTHREAD_MAX_NODES /
+                               (sizeof(unsigned long) * 8)] = { 0 };
+        unsigned int bits = sizeof(nodemask[0]) * 8;
+        bool bound = false;
+        if (sched->numa_node < UPIPE_PTHREAD_MAX_NODES) {
+            nodemask[sched->numa_node / bits] =
+                1UL << (sched->numa_node % bits);
+            /* allocations fall back to other nodes when the node is full */
+            bound = syscall(SYS_set_mempolicy, UPIPE_PTHREAD_MPOL_PREFERRED,
+                            nodemask, UPIPE_PTHREAD_MAX_NODES + 1) == 0;
+        }
+        if (!bound)
+            uprobe_warn_va(uprobe, NULL, "unable to bind memory to node %d",
+                           sched->numa_node);
+    }
+#endif
+#endif
+
+    if (sched->policy != -1) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = sched->sched_priority;
+        int err = pthread_setschedparam(pthread_self(), sched->policy,
+                                        &param);
+        if (err != 0)
+            uprobe_warn_va(uprobe, NULL,
+                           "unable to set scheduling policy (%s)",
+                           strerror(err));
+    }
+}
+
 /** @internal @This is the main function of the new thread.
  *
  * @param mgr pointer to a upipe pthread manager
@@ -100,8 +210,7 @@ static void *upipe_pthread_start(void *_pthread_ctx)
 
     pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, NULL);
 
-    if (pthread_ctx->priority != INT_MAX)
-        setpriority(PRIO_PROCESS, 0, pthread_ctx->priority);
+    upipe_pthread_sched_apply(pthread_ctx);
 
     /* spawn the upump manager */
     struct upump_mgr *upump_mgr =
@@ -160,6 +269,7 @@ static void upipe_pthread_stop(struct upump *upump)
     pthread_join(pthread_ctx->pthread_id, NULL);
     ueventfd_clean(&pthread_ctx->event);
     umutex_release(pthread_ctx->mutex);
+    free((unsigned int *)pthread_ctx->sched.cpus);
     free(pthread_ctx->name);
     free(pthread_ctx);
 }
@@ -178,17 +288,17 @@ static void upipe_pthread_stop(struct upump *upump)
  * @param mutex mutual exclusion pimitives to access the event loop, or NULL
  * @param pthread_id_p reference to created thread ID (may be NULL)
  * @param attr pthread attributes
+ * @param sched scheduling parameters, or NULL
  * @param name custom name or NULL
- * @param priority priority of the thread or INT_MAX to leave it unchanged
  * @return pointer to xfer manager
  */
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named(
-    uint8_t queue_length, uint16_t msg_pool_depth,
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_sched(
+    unsigned int queue_length, uint16_t msg_pool_depth,
     struct uprobe *uprobe_pthread_upump_mgr,
     upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
     uint16_t upump_blocker_pool_depth, struct umutex *mutex,
     pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
-    int priority, const char *name)
+    const struct upipe_pthread_sched *sched, const char *name)
 {
     struct upipe_pthread_ctx *pthread_ctx =
         malloc(sizeof(struct upipe_pthread_ctx));
@@ -223,7 +333,20 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named(
     pthread_ctx->upump_blocker_pool_depth = upump_blocker_pool_depth;
     pthread_ctx->mutex = umutex_use(mutex);
     pthread_ctx->name = name ? strdup(name) : NULL;
-    pthread_ctx->priority = priority;
+    if (sched != NULL)
+        pthread_ctx->sched = *sched;
+    else
+        upipe_pthread_sched_init(&pthread_ctx->sched);
+    pthread_ctx->sched.cpus = NULL;
+    if (pthread_ctx->sched.nb_cpus) {
+        unsigned int *cpus = malloc(sizeof(unsigned int) *
+                                    pthread_ctx->sched.nb_cpus);
+        if (unlikely(cpus == NULL))
+            goto upipe_pthread_xfer_mgr_alloc_err5;
+        memcpy(cpus, sched->cpus,
+               sizeof(unsigned int) * pthread_ctx->sched.nb_cpus);
+        pthread_ctx->sched.cpus = cpus;
+    }
 
     if (unlikely(pthread_create(&pthread_ctx->pthread_id, attr,
                                 upipe_pthread_start, pthread_ctx) != 0))
@@ -235,6 +358,8 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named(
     return xfer_mgr;
 
 upipe_pthread_xfer_mgr_alloc_err5:
+    free((unsigned int *)pthread_ctx->sched.cpus);
+    free(pthread_ctx->name);
     umutex_release(mutex);
     upipe_mgr_release(pthread_ctx->xfer_mgr);
     upipe_mgr_release(xfer_mgr);
@@ -249,7 +374,49 @@ upipe_pthread_xfer_mgr_alloc_err1:
     return NULL;
 }
 
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named(uint8_t queue_length,
+/** @This returns a management structure for transfer pipes, using a new
+ * pthread. You would need one management structure per target thread.
+ *
+ * @param queue_length maximum length of the internal queue of commands
+ * @param msg_pool_depth maximum number of messages in the pool
+ * @param uprobe_pthread_upump_mgr pointer to optional probe, that will be set
+ * with the created upump_mgr
+ * @param upump_mgr_alloc alloc function provided by the upump manager
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param mutex mutual exclusion pimitives to access the event loop, or NULL
+ * @param pthread_id_p reference to created thread ID (may be NULL)
+ * @param attr pthread attributes
+ * @param priority priority of the thread or INT_MAX to leave it unchanged
+ * @param name custom name or NULL
+ * @return pointer to xfer manager
+ */
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio_named(
+    unsigned int queue_length, uint16_t msg_pool_depth,
+    struct uprobe *uprobe_pthread_upump_mgr,
+    upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
+    uint16_t upump_blocker_pool_depth, struct umutex *mutex,
+    pthread_t *pthread_id_p, const pthread_attr_t *restrict attr,
+    int priority, const char *name)
+{
+    struct upipe_pthread_sched sched;
+    upipe_pthread_sched_init(&sched);
+    sched.priority = priority;
+    return upipe_pthread_xfer_mgr_alloc_sched(queue_length,
+                                              msg_pool_depth,
+                                              uprobe_pthread_upump_mgr,
+                                              upump_mgr_alloc,
+                                              upump_pool_depth,
+                                              upump_blocker_pool_depth,
+                                              mutex,
+                                              pthread_id_p,
+                                              attr,
+                                              &sched,
+                                              name);
+}
+
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named(unsigned int queue_length,
         uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -269,7 +436,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_named(uint8_t queue_length,
                                                    name);
 }
 
-struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
+struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(unsigned int queue_length,
         uint16_t msg_pool_depth, struct uprobe *uprobe_pthread_upump_mgr,
         upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
         uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -288,7 +455,7 @@ struct upipe_mgr *upipe_pthread_xfer_mgr_alloc(uint8_t queue_length,
 }
 
 struct upipe_mgr *upipe_pthread_xfer_mgr_alloc_prio(
-    uint8_t queue_length, uint16_t msg_pool_depth,
+    unsigned int queue_length, uint16_t msg_pool_depth,
     struct uprobe *uprobe_pthread_upump_mgr,
     upump_mgr_alloc upump_mgr_alloc, uint16_t upump_pool_depth,
     uint16_t upump_blocker_pool_depth, struct umutex *mutex,
@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short probe logging asynchronously from a background thread
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uatomic.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_helper_alloc.h"
+#include "upipe-pthread/uprobe_pthread_log.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+/** size of the text of a record, including the prefix tags */
+#define UPROBE_PTHREAD_LOG_TEXT_SIZE 248
+/** period at which the background thread collects the records, in ms */
+#define UPROBE_PTHREAD_LOG_PERIOD 20
+
+/** @This stores a log message. */
+struct uprobe_pthread_log_record {
+    /** log level of the message */
+    enum uprobe_log_level level;
+    /** length of the prefix tags at the beginning of the text */
+    uint16_t prefix_len;
+    /** prefix tags followed by the message */
+    char text[UPROBE_PTHREAD_LOG_TEXT_SIZE];
+};
+
+/** @This stores the ring of records of a thread. */
+struct uprobe_pthread_log_ring {
+    /** structure for the list of rings */
+    struct uchain uchain;
+    /** pointer to the probe */
+    struct uprobe_pthread_log *uprobe_pthread_log;
+    /** index of the next record to read */
+    uatomic_uint32_t head;
+    /** index of the next record to write */
+    uatomic_uint32_t tail;
+    /** number of records dropped since the last collection */
+    uatomic_uint32_t dropped;
+    /** set to 1 when the thread has exited */
+    uatomic_uint32_t exited;
+    /** records */
+    struct uprobe_pthread_log_record records[];
+};
+
+UBASE_FROM_TO(uprobe_pthread_log_ring, uchain, uchain, uchain)
+
+/** @internal @This returns the name of a log level.
+ *
+ * @param level log level
+ * @return name of the level
+ */
+static const char *uprobe_pthread_log_level(enum uprobe_log_level level)
+{
+    switch (level) {
+        case UPROBE_LOG_VERBOSE: return "verbose";
+        case UPROBE_LOG_DEBUG: return "debug";
+        case UPROBE_LOG_INFO: return "info";
+        case UPROBE_LOG_NOTICE: return "notice";
+        case UPROBE_LOG_WARNING: return "warning";
+        case UPROBE_LOG_ERROR: return "error";
+        default: break;
+    }
+    return "unknown";
+}
+
+/** @internal @This marks the ring of an exiting thread, so that the
+ * background thread frees it once it is empty.
+ *
+ * @param opaque pointer to the ring
+ */
+static void uprobe_pthread_log_destr(void *opaque)
+{
+    struct uprobe_pthread_log_ring *ring = opaque;
+    uatomic_store(&ring->exited, 1);
+}
+
+/** @internal @This returns the ring of the current thread, allocating it
+ * if needed.
+ *
+ * @param uprobe_pthread_log pointer to the probe
+ * @return pointer to the ring, or NULL in case of allocation error
+ */
+static struct uprobe_pthread_log_ring *
+    uprobe_pthread_log_ring(struct uprobe_pthread_log *uprobe_pthread_log)
+{
+    struct uprobe_pthread_log_ring *ring =
+        pthread_getspecific(uprobe_pthread_log->key);
+    if (likely(ring != NULL))
+        return ring;
+
+    ring = malloc(sizeof(struct uprobe_pthread_log_ring) +
+                  uprobe_pthread_log->ring_length *
+                  sizeof(struct uprobe_pthread_log_record));
+    if (unlikely(ring == NULL))
+        return NULL;
+    ring->uprobe_pthread_log = uprobe_pthread_log;
+    uatomic_init(&ring->head, 0);
+    uatomic_init(&ring->tail, 0);
+    uatomic_init(&ring->dropped, 0);
+    uatomic_init(&ring->exited, 0);
+    if (unlikely(pthread_setspecific(uprobe_pthread_log->key, ring) != 0)) {
+        free(ring);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&uprobe_pthread_log->mutex);
+    ulist_add(&uprobe_pthread_log->rings, &ring->uchain);
+    pthread_mutex_unlock(&uprobe_pthread_log->mutex);
+    return ring;
+}
+
+/** @internal @This frees a ring.
+ *
+ * @param ring pointer to the ring
+ */
+static void uprobe_pthread_log_ring_free(struct uprobe_pthread_log_ring *ring)
+{
+    uatomic_clean(&ring->head);
+    uatomic_clean(&ring->tail);
+    uatomic_clean(&ring->dropped);
+    uatomic_clean(&ring->exited);
+    free(ring);
+}
+
+/** @internal @This catches events thrown by pipes.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param event event thrown
+ * @param args optional event-specific parameters
+ * @return an error code
+ */
+static int uprobe_pthread_log_throw(struct uprobe *uprobe,
+                                    struct upipe *upipe,
+                                    int event, va_list args)
+{
+    struct uprobe_pthread_log *uprobe_pthread_log =
+        uprobe_pthread_log_from_uprobe(uprobe);
+    if (event != UPROBE_LOG)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct ulog *ulog = va_arg(args, struct ulog *);
+    if (uprobe_pthread_log->min_level > ulog->level)
+        return UBASE_ERR_NONE;
+
+    struct uprobe_pthread_log_ring *ring =
+        uprobe_pthread_log_ring(uprobe_pthread_log);
+    if (unlikely(ring == NULL))
+        return UBASE_ERR_ALLOC;
+
+    unsigned int length = uprobe_pthread_log->ring_length;
+    uint32_t tail = uatomic_load(&ring->tail);
+    uint32_t head = uatomic_load(&ring->head);
+    if (unlikely(tail - head >= length)) {
+        uatomic_fetch_add(&ring->dropped, 1);
+        return UBASE_ERR_NONE;
+    }
+
+    struct uprobe_pthread_log_record *record = &ring->records[tail % length];
+    record->level = ulog->level;
+    size_t len = 0;
+    struct uchain *uchain;
+    ulist_foreach_reverse(&ulog->prefixes, uchain) {
+        struct ulog_pfx *ulog_pfx = ulog_pfx_from_uchain(uchain);
+        int ret = snprintf(record->text + len, sizeof(record->text) - len,
+                           "[%s] ", ulog_pfx->tag);
+        if (ret < 0 || len + ret >= sizeof(record->text)) {
+            len = sizeof(record->text) - 1;
+            break;
+        }
+        len += ret;
+    }
+    record->prefix_len = len;
+    record->text[len] = '\0';
+    ulog_msg_print(ulog, record->text + len, sizeof(record->text) - len);
+    uatomic_store(&ring->tail, tail + 1);
+
+    if (unlikely(tail + 1 - head == (length + 1) / 2)) {
+        /* do not wait for the next period */
+        pthread_mutex_lock(&uprobe_pthread_log->mutex);
+        pthread_cond_signal(&uprobe_pthread_log->cond);
+        pthread_mutex_unlock(&uprobe_pthread_log->mutex);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This writes the pending records of a ring.
+ *
+ * @param uprobe_pthread_log pointer to the probe
+ * @param ring pointer to the ring
+ */
+static void uprobe_pthread_log_drain(
+        struct uprobe_pthread_log *uprobe_pthread_log,
+        struct uprobe_pthread_log_ring *ring)
+{
+    FILE *s = uprobe_pthread_log->stream;
+    unsigned int length = uprobe_pthread_log->ring_length;
+    uint32_t head = uatomic_load(&ring->head);
+    uint32_t tail = uatomic_load(&ring->tail);
+
+    for ( ; head != tail; head++) {
+        struct uprobe_pthread_log_record *record =
+            &ring->records[head % length];
+        const char *level = uprobe_pthread_log_level(record->level);
+        const char *msg = record->text + record->prefix_len;
+        do {
+            const char *p = strchr(msg, '\n');
+            int msg_len = p != NULL ? p - msg : (int)strlen(msg);
+            fprintf(s, "%s: %.*s%.*s\n", level, (int)record->prefix_len,
+                    record->text, msg_len, msg);
+            msg = p != NULL ? p + 1 : NULL;
+        } while (msg != NULL && *msg != '\0');
+        uatomic_store(&ring->head, head + 1);
+    }
+
+    uint32_t dropped = uatomic_load(&ring->dropped);
+    if (unlikely(dropped)) {
+        uatomic_fetch_sub(&ring->dropped, dropped);
+        fprintf(s, "warning: [uprobe_pthread_log] %"PRIu32
+                " message(s) dropped\n", dropped);
+    }
+}
+
+/** @internal @This is the function of the background thread.
+ *
+ * @param opaque pointer to the probe
+ * @return NULL
+ */
+static void *uprobe_pthread_log_run(void *opaque)
+{
+    struct uprobe_pthread_log *uprobe_pthread_log = opaque;
+
+    pthread_mutex_lock(&uprobe_pthread_log->mutex);
+    for ( ; ; ) {
+        bool quit = uprobe_pthread_log->quit;
+
+        /* the list only grows while unlocked, at its end */
+        struct uchain *uchain = uprobe_pthread_log->rings.next;
+        while (uchain != &uprobe_pthread_log->rings) {
+            struct uprobe_pthread_log_ring *ring =
+                uprobe_pthread_log_ring_from_uchain(uchain);
+            bool exited = uatomic_load(&ring->exited);
+            pthread_mutex_unlock(&uprobe_pthread_log->mutex);
+            uprobe_pthread_log_drain(uprobe_pthread_log, ring);
+            pthread_mutex_lock(&uprobe_pthread_log->mutex);
+
+            uchain = uchain->next;
+            if (exited) {
+                ulist_delete(&ring->uchain);
+                uprobe_pthread_log_ring_free(ring);
+            }
+        }
+        fflush(uprobe_pthread_log->stream);
+
+        if (quit)
+            break;
+
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += UPROBE_PTHREAD_LOG_PERIOD * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        if (!uprobe_pthread_log->quit)
+            pthread_cond_timedwait(&uprobe_pthread_log->cond,
+                                   &uprobe_pthread_log->mutex, &ts);
+    }
+    pthread_mutex_unlock(&uprobe_pthread_log->mutex);
+    return NULL;
+}
+
+/** @This initializes an already allocated uprobe_pthread_log structure, and
+ * starts its background thread.
+ *
+ * @param uprobe_pthread_log pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param stream stdio stream to which to log the messages
+ * @param min_level level at which to log the messages
+ * @param ring_length number of records buffered for each thread
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_pthread_log_init(
+        struct uprobe_pthread_log *uprobe_pthread_log,
+        struct uprobe *next, FILE *stream,
+        enum uprobe_log_level min_level, unsigned int ring_length)
+{
+    assert(uprobe_pthread_log != NULL);
+    struct uprobe *uprobe = uprobe_pthread_log_to_uprobe(uprobe_pthread_log);
+    if (unlikely(!ring_length))
+        return NULL;
+    uprobe_pthread_log->stream = stream;
+    uprobe_pthread_log->min_level = min_level;
+    uprobe_pthread_log->ring_length = ring_length;
+    uprobe_pthread_log->quit = false;
+    ulist_init(&uprobe_pthread_log->rings);
+
+    if (unlikely(pthread_key_create(&uprobe_pthread_log->key,
+                                    uprobe_pthread_log_destr) != 0))
+        return NULL;
+    if (unlikely(pthread_mutex_init(&uprobe_pthread_log->mutex, NULL) != 0))
+        goto uprobe_pthread_log_init_err_key;
+    if (unlikely(pthread_cond_init(&uprobe_pthread_log->cond, NULL) != 0))
+        goto uprobe_pthread_log_init_err_mutex;
+    if (unlikely(pthread_create(&uprobe_pthread_log->thread, NULL,
+                                uprobe_pthread_log_run,
+                                uprobe_pthread_log) != 0))
+        goto uprobe_pthread_log_init_err_cond;
+
+    uprobe_init(uprobe, uprobe_pthread_log_throw, next);
+    return uprobe;
+
+uprobe_pthread_log_init_err_cond:
+    pthread_cond_destroy(&uprobe_pthread_log->cond);
+uprobe_pthread_log_init_err_mutex:
+    pthread_mutex_destroy(&uprobe_pthread_log->mutex);
+uprobe_pthread_log_init_err_key:
+    pthread_key_delete(uprobe_pthread_log->key);
+    return NULL;
+}
+
+/** @This cleans a uprobe_pthread_log structure. The background thread is
+ * stopped after it has written all the pending records.
+ *
+ * @param uprobe_pthread_log structure to clean
+ */
+void uprobe_pthread_log_clean(struct uprobe_pthread_log *uprobe_pthread_log)
+{
+    assert(uprobe_pthread_log != NULL);
+    struct uprobe *uprobe = uprobe_pthread_log_to_uprobe(uprobe_pthread_log);
+
+    pthread_mutex_lock(&uprobe_pthread_log->mutex);
+    uprobe_pthread_log->quit = true;
+    pthread_cond_signal(&uprobe_pthread_log->cond);
+    pthread_mutex_unlock(&uprobe_pthread_log->mutex);
+    pthread_join(uprobe_pthread_log->thread, NULL);
+
+    /* POSIX doesn't call destructors on key deletion */
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&uprobe_pthread_log->rings, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        uprobe_pthread_log_ring_free(
+            uprobe_pthread_log_ring_from_uchain(uchain));
+    }
+    pthread_setspecific(uprobe_pthread_log->key, NULL);
+    pthread_key_delete(uprobe_pthread_log->key);
+    pthread_cond_destroy(&uprobe_pthread_log->cond);
+    pthread_mutex_destroy(&uprobe_pthread_log->mutex);
+    uprobe_clean(uprobe);
+}
+
+#define ARGS_DECL struct uprobe *next, FILE *stream, enum uprobe_log_level min_level, unsigned int ring_length
+#define ARGS next, stream, min_level, ring_length
+UPROBE_HELPER_ALLOC(uprobe_pthread_log)
+#undef ARGS
+#undef ARGS_DECL
@@ -50,6 +50,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include <inttypes.h>
+#include <math.h>
 
 #include <libavutil/opt.h>
 #include <libavutil/channel_layout.h>
@@ -102,6 +104,19 @@ struct upipe_swr {
     /** swresample context */
     struct SwrContext *swr;
 
+    /** input format the context was initialized with */
+    enum AVSampleFormat in_fmt;
+    /** input channels number the context was initialized with */
+    uint8_t in_chan;
+    /** input sample rate the context was initialized with */
+    uint64_t in_rate;
+    /** true if clock drift is compensated */
+    bool compensation;
+    /** drift rate set by the application, or 0/0 */
+    struct urational drift_rate;
+    /** fraction of sample not compensated yet */
+    double drift_residue;
+
     /** number of planes in input */
     uint8_t in_planes;
     /** number of planes in output */
@@ -128,6 +143,68 @@ UPIPE_HELPER_UBUF_MGR(upipe_swr, ubuf_mgr, flow_format, ubuf_mgr_request,
                       upipe_swr_unregister_output_request)
 UPIPE_HELPER_INPUT(upipe_swr, urefs, nb_urefs, max_urefs, blockers, upipe_swr_handle)
 
+/** @internal @This initializes the swresample context with the current
+ * options.
+ *
+ * @param upipe description structure of the pipe
+ * @return a negative value in case of error
+ */
+static int upipe_swr_init(struct upipe *upipe)
+{
+    struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
+    /* compensation needs the resampler even if the rates are the same */
+    av_opt_set_int(upipe_swr->swr, "flags",
+                   upipe_swr->compensation ? SWR_FLAG_RESAMPLE : 0, 0);
+    upipe_swr->drift_residue = 0.;
+    return swr_init(upipe_swr->swr);
+}
+
+/** @internal @This programs the compensation of the clock drift over the
+ * output samples of an input buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param in_samples number of input samples
+ * @param in_rate input sample rate
+ * @param out_rate output sample rate
+ * @return number of samples added (or removed if negative) to the output
+ */
+static int upipe_swr_compensate(struct upipe *upipe, struct uref *uref,
+                                size_t in_samples, int64_t in_rate,
+                                int64_t out_rate)
+{
+    struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
+    struct urational drift_rate = upipe_swr->drift_rate;
+    if (!drift_rate.num &&
+        !ubase_check(uref_clock_get_rate(uref, &drift_rate)))
+        return 0;
+    /* the drift is now accounted for */
+    uref_clock_delete_rate(uref);
+    if (!drift_rate.num || !drift_rate.den || !in_rate)
+        return 0;
+
+    double distance = (double)in_samples * out_rate / in_rate;
+    upipe_swr->drift_residue +=
+        distance * ((double)drift_rate.num / drift_rate.den - 1.);
+    int delta = lrint(upipe_swr->drift_residue);
+    if (!delta || distance < 1.)
+        return 0;
+    if (abs(delta) > distance / 10.) {
+        upipe_warn_va(upipe, "excessive drift %"PRId64"/%"PRIu64,
+                      drift_rate.num, drift_rate.den);
+        upipe_swr->drift_residue = 0.;
+        return 0;
+    }
+
+    if (unlikely(swr_set_compensation(upipe_swr->swr, delta,
+                                      lrint(distance)) < 0)) {
+        upipe_warn(upipe, "unable to compensate drift");
+        return 0;
+    }
+    upipe_swr->drift_residue -= delta;
+    return delta;
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -158,6 +235,18 @@ static bool upipe_swr_handle(struct upipe *upipe, struct uref *uref,
                     latency + FRAME_SIZE * UCLOCK_FREQ / in_rate);
         }
 
+        /* keep the context, and its history, if only attributes changed */
+        if (swr_is_initialized(upipe_swr->swr) &&
+            in_fmt == upipe_swr->in_fmt && in_chan == upipe_swr->in_chan &&
+            in_rate == upipe_swr->in_rate) {
+            uref = upipe_swr_store_flow_def_input(upipe, uref);
+            upipe_swr_require_ubuf_mgr(upipe, uref);
+            return true;
+        }
+        upipe_swr->in_fmt = in_fmt;
+        upipe_swr->in_chan = in_chan;
+        upipe_swr->in_rate = in_rate;
+
         av_opt_set_int(upipe_swr->swr, "in_sample_fmt", in_fmt, 0);
         av_opt_set_int(upipe_swr->swr, "used_channel_count", 0, 0);
         av_opt_set_int(upipe_swr->swr, "in_channel_count", in_chan, 0);
@@ -179,7 +268,7 @@ static bool upipe_swr_handle(struct upipe *upipe, struct uref *uref,
         }
 
         /* reinit swresample context */
-        if (swr_init(upipe_swr->swr) < 0) {
+        if (upipe_swr_init(upipe) < 0) {
             upipe_err_va(upipe, "failed to init swresample with format %s",
                          def);
             upipe_throw_fatal(upipe, UBASE_ERR_EXTERNAL);
@@ -209,10 +298,16 @@ static bool upipe_swr_handle(struct upipe *upipe, struct uref *uref,
     av_opt_get_int(upipe_swr->swr, "in_sample_rate", 0, &in_rate);
     av_opt_get_int(upipe_swr->swr, "out_sample_rate", 0, &out_rate);
 
+    /* stretch or shrink the output to follow the clock drift */
+    int drift = 0;
+    if (upipe_swr->compensation)
+        drift = upipe_swr_compensate(upipe, uref, in_samples,
+                                     in_rate, out_rate);
+
     /* out samples (needed for resampling) */
     out_samples = av_rescale_rnd(
                     swr_get_delay(upipe_swr->swr, in_rate) + in_samples,
-                    out_rate, in_rate, AV_ROUND_UP);
+                    out_rate, in_rate, AV_ROUND_UP) + abs(drift);
     //upipe_verbose_va(upipe, "in: %zu out: %"PRIu64, in_samples, out_samples);
 
     /* compute delay (see swresample.h for timebase) */
@@ -369,6 +464,29 @@ static int upipe_swr_set_flow_def(struct upipe *upipe, struct uref *flow_def)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This enables or disables clock drift compensation.
+ *
+ * @param upipe description structure of the pipe
+ * @param enabled true to compensate the clock drift
+ * @return an error code
+ */
+static int upipe_swr_set_compensation_real(struct upipe *upipe, bool enabled)
+{
+    struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
+    if (upipe_swr->compensation == enabled)
+        return UBASE_ERR_NONE;
+    upipe_swr->compensation = enabled;
+    if (!swr_is_initialized(upipe_swr->swr))
+        return UBASE_ERR_NONE;
+
+    /* the resampler must be enabled or disabled */
+    if (upipe_swr_init(upipe) < 0) {
+        upipe_err(upipe, "failed to init swresample");
+        return UBASE_ERR_EXTERNAL;
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -405,6 +523,21 @@ static int upipe_swr_control(struct upipe *upipe, int command, va_list args)
             return upipe_swr_set_flow_def(upipe, flow);
         }
 
+        case UPIPE_SWR_SET_COMPENSATION: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWR_SIGNATURE)
+            int enabled = va_arg(args, int);
+            return upipe_swr_set_compensation_real(upipe, !!enabled);
+        }
+        case UPIPE_SWR_SET_DRIFT_RATE: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWR_SIGNATURE)
+            const struct urational *drift_rate =
+                va_arg(args, const struct urational *);
+            struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
+            upipe_swr->drift_rate = drift_rate != NULL ? *drift_rate :
+                                    (struct urational){ 0, 0 };
+            return UBASE_ERR_NONE;
+        }
+
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -430,6 +563,12 @@ static struct upipe *upipe_swr_alloc(struct upipe_mgr *mgr,
 
     struct upipe_swr *upipe_swr = upipe_swr_from_upipe(upipe);
 
+    upipe_swr->in_fmt = AV_SAMPLE_FMT_NONE;
+    upipe_swr->in_chan = 0;
+    upipe_swr->in_rate = 0;
+    upipe_swr->compensation = false;
+    upipe_swr->drift_rate = (struct urational){ 0, 0 };
+    upipe_swr->drift_residue = 0.;
     upipe_swr->out_rate = 0;
     upipe_swr->out_chan = 0;
     upipe_swr->out_planes = 0;
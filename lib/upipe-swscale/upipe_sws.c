@@ -52,8 +52,14 @@
 #include <string.h>
 
 #include <libavutil/opt.h>
+#include <libavutil/frame.h>
 #include <libswscale/swscale.h>
 
+/** @internal @This is true if libswscale can scale slices of a picture
+ * concurrently (FFmpeg 5.0 and later). */
+#define UPIPE_SWS_SLICE_THREADS \
+    (LIBSWSCALE_VERSION_INT >= AV_VERSION_INT(6, 1, 100))
+
 /** @hidden */
 static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
                              struct upump **upump_p);
@@ -96,6 +102,8 @@ struct upipe_sws {
 
     /** swscale flags */
     int flags;
+    /** number of scaling threads (0 for automatic) */
+    unsigned int threads;
     /** swscale image conversion context [0] for progressive, [1,2] interlaced */
     struct SwsContext *convert_ctx[3];
     /** input pixel format */
@@ -158,6 +166,182 @@ static int upipe_sws_convert_color(struct upipe *upipe, struct uref *flow_def)
     return colorspace;
 }
 
+#if UPIPE_SWS_SLICE_THREADS
+/** @internal @This checks if an option of a swscale context has the given
+ * value.
+ *
+ * @param ctx swscale context
+ * @param name name of the option
+ * @param value expected value
+ * @return true if the option has the expected value
+ */
+static bool upipe_sws_opt_match(struct SwsContext *ctx, const char *name,
+                                int64_t value)
+{
+    int64_t current;
+    return av_opt_get_int(ctx, name, 0, &current) >= 0 && current == value;
+}
+
+/** @internal @This is the (no-op) free callback of the buffer references
+ * wrapping the planes of a picture, which stay owned by their ubuf.
+ *
+ * @param opaque unused
+ * @param data unused
+ */
+static void upipe_sws_buffer_free(void *opaque, uint8_t *data)
+{
+}
+
+/** @internal @This fills in a frame pointing to the planes of a picture.
+ *
+ * @param frame frame to fill in
+ * @param planes array of planes
+ * @param strides array of strides
+ * @param format pixel format
+ * @param width width of the picture
+ * @param height height of the picture
+ * @return an error code
+ */
+static int upipe_sws_wrap_frame(AVFrame *frame, uint8_t *const planes[],
+                                const int strides[], enum AVPixelFormat format,
+                                int width, int height)
+{
+    for (int i = 0; i < UPIPE_AV_MAX_PLANES && i < AV_NUM_DATA_POINTERS;
+         i++) {
+        frame->data[i] = planes[i];
+        frame->linesize[i] = strides[i];
+    }
+    frame->format = format;
+    frame->width = width;
+    frame->height = height;
+    /* a reference is required to prevent swscale from copying the frame */
+    frame->buf[0] = av_buffer_create(planes[0], 0, upipe_sws_buffer_free,
+                                     NULL, 0);
+    return frame->buf[0] != NULL ? UBASE_ERR_NONE : UBASE_ERR_ALLOC;
+}
+#endif
+
+/** @internal @This returns a swscale context matching the given sizes,
+ * reusing the given context if possible.
+ *
+ * @param upipe description structure of the pipe
+ * @param ctx previous swscale context, freed if it cannot be reused
+ * @param input_hsize input horizontal size
+ * @param input_vsize input vertical size
+ * @param output_hsize output horizontal size
+ * @param output_vsize output vertical size
+ * @return pointer to swscale context, or NULL in case of error
+ */
+static struct SwsContext *upipe_sws_get_context(struct upipe *upipe,
+        struct SwsContext *ctx, int input_hsize, int input_vsize,
+        int output_hsize, int output_vsize)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+#if UPIPE_SWS_SLICE_THREADS
+    if (upipe_sws->threads != 1) {
+        /* sws_getCachedContext() would drop the threads option, which is
+         * not compared since it is changed during initialization when
+         * automatic; new contexts are set up when it is modified. */
+        if (ctx != NULL &&
+            upipe_sws_opt_match(ctx, "srcw", input_hsize) &&
+            upipe_sws_opt_match(ctx, "srch", input_vsize) &&
+            upipe_sws_opt_match(ctx, "src_format", upipe_sws->input_pix_fmt) &&
+            upipe_sws_opt_match(ctx, "dstw", output_hsize) &&
+            upipe_sws_opt_match(ctx, "dsth", output_vsize) &&
+            upipe_sws_opt_match(ctx, "dst_format",
+                                upipe_sws->output_pix_fmt) &&
+            upipe_sws_opt_match(ctx, "sws_flags", upipe_sws->flags))
+            return ctx;
+
+        int64_t src_v_chr_pos = -513, dst_v_chr_pos = -513;
+        if (ctx != NULL) {
+            av_opt_get_int(ctx, "src_v_chr_pos", 0, &src_v_chr_pos);
+            av_opt_get_int(ctx, "dst_v_chr_pos", 0, &dst_v_chr_pos);
+            sws_freeContext(ctx);
+        }
+
+        ctx = sws_alloc_context();
+        if (unlikely(ctx == NULL))
+            return NULL;
+        av_opt_set_int(ctx, "srcw", input_hsize, 0);
+        av_opt_set_int(ctx, "srch", input_vsize, 0);
+        av_opt_set_int(ctx, "src_format", upipe_sws->input_pix_fmt, 0);
+        av_opt_set_int(ctx, "dstw", output_hsize, 0);
+        av_opt_set_int(ctx, "dsth", output_vsize, 0);
+        av_opt_set_int(ctx, "dst_format", upipe_sws->output_pix_fmt, 0);
+        av_opt_set_int(ctx, "sws_flags", upipe_sws->flags, 0);
+        av_opt_set_int(ctx, "src_v_chr_pos", src_v_chr_pos, 0);
+        av_opt_set_int(ctx, "dst_v_chr_pos", dst_v_chr_pos, 0);
+        av_opt_set_int(ctx, "threads", upipe_sws->threads, 0);
+        if (unlikely(sws_init_context(ctx, NULL, NULL) < 0)) {
+            sws_freeContext(ctx);
+            return NULL;
+        }
+        return ctx;
+    }
+#endif
+    return sws_getCachedContext(ctx,
+            input_hsize, input_vsize, upipe_sws->input_pix_fmt,
+            output_hsize, output_vsize, upipe_sws->output_pix_fmt,
+            upipe_sws->flags, NULL, NULL, NULL);
+}
+
+/** @internal @This scales a whole picture (or field). In threaded mode, the
+ * picture is cut into horizontal slices scaled by the libswscale worker
+ * pool, and this function returns once all slices are done.
+ *
+ * @param upipe description structure of the pipe
+ * @param ctx swscale context
+ * @param input_planes array of input planes
+ * @param input_strides array of input strides
+ * @param input_hsize input horizontal size
+ * @param input_vsize input vertical size
+ * @param output_planes array of output planes
+ * @param output_strides array of output strides
+ * @param output_hsize output horizontal size
+ * @param output_vsize output vertical size
+ * @return the height of the output picture, or a negative value in case of
+ * error
+ */
+static int upipe_sws_scale(struct upipe *upipe, struct SwsContext *ctx,
+                           const uint8_t *const input_planes[],
+                           const int input_strides[],
+                           int input_hsize, int input_vsize,
+                           uint8_t *const output_planes[],
+                           const int output_strides[],
+                           int output_hsize, int output_vsize)
+{
+#if UPIPE_SWS_SLICE_THREADS
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    if (upipe_sws->threads != 1) {
+        AVFrame *input = av_frame_alloc();
+        AVFrame *output = av_frame_alloc();
+        int ret = AVERROR(ENOMEM);
+        if (likely(input != NULL && output != NULL &&
+                   ubase_check(upipe_sws_wrap_frame(input,
+                           (uint8_t *const *)input_planes, input_strides,
+                           upipe_sws->input_pix_fmt,
+                           input_hsize, input_vsize)) &&
+                   ubase_check(upipe_sws_wrap_frame(output,
+                           output_planes, output_strides,
+                           upipe_sws->output_pix_fmt,
+                           output_hsize, output_vsize)))) {
+            ret = sws_frame_start(ctx, output, input);
+            if (ret >= 0)
+                ret = sws_send_slice(ctx, 0, input_vsize);
+            if (ret >= 0)
+                ret = sws_receive_slice(ctx, 0, output_vsize);
+            sws_frame_end(ctx);
+        }
+        av_frame_free(&input);
+        av_frame_free(&output);
+        return ret < 0 ? ret : output_vsize;
+    }
+#endif
+    return sws_scale(ctx, input_planes, input_strides, 0, input_vsize,
+                     output_planes, output_strides);
+}
+
 /** @internal @This handles data.
  *
  * @param upipe description structure of the pipe
@@ -207,10 +391,10 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
 
     int i;
     for (i = 0; i < 3; i++) {
-        upipe_sws->convert_ctx[i] = sws_getCachedContext(upipe_sws->convert_ctx[i],
-                    input_hsize, input_vsize >> !!i, upipe_sws->input_pix_fmt,
-                    output_hsize, output_vsize >> !!i, upipe_sws->output_pix_fmt,
-                    upipe_sws->flags, NULL, NULL, NULL);
+        upipe_sws->convert_ctx[i] = upipe_sws_get_context(upipe,
+                    upipe_sws->convert_ctx[i],
+                    input_hsize, input_vsize >> !!i,
+                    output_hsize, output_vsize >> !!i);
 
         if (unlikely(upipe_sws->convert_ctx[i] == NULL)) {
             upipe_err(upipe, "sws_getContext failed");
@@ -324,14 +508,18 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
     /* fire ! */
     int ret = 0, ret2 = 1;
     if (progressive) {
-        ret = sws_scale(upipe_sws->convert_ctx[0],
-                        input_planes, input_strides, 0, input_vsize,
-                        output_planes, output_strides);
+        ret = upipe_sws_scale(upipe, upipe_sws->convert_ctx[0],
+                              input_planes, input_strides,
+                              input_hsize, input_vsize,
+                              output_planes, output_strides,
+                              output_hsize, output_vsize);
     }
     else {
-        ret = sws_scale(upipe_sws->convert_ctx[1],
-                        input_planes, input_strides, 0, (input_vsize+1)/2,
-                        output_planes, output_strides);
+        ret = upipe_sws_scale(upipe, upipe_sws->convert_ctx[1],
+                              input_planes, input_strides,
+                              input_hsize, (input_vsize+1)/2,
+                              output_planes, output_strides,
+                              output_hsize, output_vsize >> 1);
 
         for (i = 0; i < UPIPE_AV_MAX_PLANES && input_planes[i]; i++) {
                 input_planes[i] += input_strides[i] >> 1;
@@ -340,9 +528,11 @@ static bool upipe_sws_handle(struct upipe *upipe, struct uref *uref,
                 output_planes[i] += output_strides[i] >> 1;
         }
 
-        ret2 = sws_scale(upipe_sws->convert_ctx[2],
-                         input_planes, input_strides, 0, input_vsize/2,
-                         output_planes, output_strides);
+        ret2 = upipe_sws_scale(upipe, upipe_sws->convert_ctx[2],
+                               input_planes, input_strides,
+                               input_hsize, input_vsize/2,
+                               output_planes, output_strides,
+                               output_hsize, output_vsize >> 1);
     }
 
     /* unmap pictures */
@@ -561,6 +751,59 @@ static int _upipe_sws_set_flags(struct upipe *upipe, int flags)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This gets the number of scaling threads.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads_p filled in with the number of threads
+ * @return an error code
+ */
+static int _upipe_sws_get_threads(struct upipe *upipe,
+                                  unsigned int *threads_p)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+    *threads_p = upipe_sws->threads;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the number of scaling threads. The swscale
+ * contexts are rebuilt on the next picture.
+ *
+ * @param upipe description structure of the pipe
+ * @param threads number of threads, 0 for automatic
+ * @return an error code
+ */
+static int _upipe_sws_set_threads(struct upipe *upipe, unsigned int threads)
+{
+    struct upipe_sws *upipe_sws = upipe_sws_from_upipe(upipe);
+#if !UPIPE_SWS_SLICE_THREADS
+    if (threads != 1) {
+        upipe_warn(upipe, "libswscale has no slice threading");
+        return UBASE_ERR_UNHANDLED;
+    }
+#endif
+    if (threads == upipe_sws->threads)
+        return UBASE_ERR_NONE;
+
+    /* force the allocation of new contexts */
+    for (int i = 0; i < 3; i++) {
+        struct SwsContext *ctx = sws_alloc_context();
+        UBASE_ALLOC_RETURN(ctx);
+        int64_t chr_pos;
+        if (av_opt_get_int(upipe_sws->convert_ctx[i], "src_v_chr_pos", 0,
+                           &chr_pos) >= 0)
+            av_opt_set_int(ctx, "src_v_chr_pos", chr_pos, 0);
+        if (av_opt_get_int(upipe_sws->convert_ctx[i], "dst_v_chr_pos", 0,
+                           &chr_pos) >= 0)
+            av_opt_set_int(ctx, "dst_v_chr_pos", chr_pos, 0);
+        sws_freeContext(upipe_sws->convert_ctx[i]);
+        upipe_sws->convert_ctx[i] = ctx;
+    }
+    upipe_sws->threads = threads;
+    upipe_sws->colorspace_invalid = false;
+    upipe_dbg_va(upipe, "setting threads to %u", threads);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a file source pipe, and
  * checks the status of the pipe afterwards.
  *
@@ -608,6 +851,16 @@ static int upipe_sws_control(struct upipe *upipe, int command, va_list args)
             int flags = va_arg(args, int);
             return _upipe_sws_set_flags(upipe, flags);
         }
+        case UPIPE_SWS_GET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int *threads_p = va_arg(args, unsigned int *);
+            return _upipe_sws_get_threads(upipe, threads_p);
+        }
+        case UPIPE_SWS_SET_THREADS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_SIGNATURE)
+            unsigned int threads = va_arg(args, unsigned int);
+            return _upipe_sws_set_threads(upipe, threads);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -656,6 +909,7 @@ static struct upipe *upipe_sws_alloc(struct upipe_mgr *mgr,
     }
 
     upipe_sws->flags = SWS_FULL_CHR_H_INP | SWS_ACCURATE_RND | SWS_LANCZOS;
+    upipe_sws->threads = 1;
 
     upipe_throw_ready(upipe);
 
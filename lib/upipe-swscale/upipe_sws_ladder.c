@@ -0,0 +1,680 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe swscale module computing a ladder of renditions in one pass
+ */
+
+#include "upipe/ulist.h"
+#include "upipe/uprobe.h"
+#include "upipe/uref.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_pic.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_dump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_flow.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_subpipe.h"
+#include "upipe/upipe_helper_ubuf_mgr.h"
+#include "upipe-swscale/upipe_sws_ladder.h"
+#include "upipe-av/upipe_av_pixfmt.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+#include <libswscale/swscale.h>
+
+/** @internal @This is the private context of a sws ladder pipe. */
+struct upipe_sws_ladder {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of output subpipes, by decreasing size */
+    struct uchain outputs;
+    /** input flow definition packet */
+    struct uref *flow_def;
+    /** input pixel format */
+    enum AVPixelFormat pix_fmt;
+    /** chroma map */
+    const char *chroma_map[UPIPE_AV_MAX_PLANES];
+    /** swscale flags */
+    int flags;
+
+    /** manager to create output subpipes */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_sws_ladder, upipe, UPIPE_SWS_LADDER_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_sws_ladder, urefcount, upipe_sws_ladder_no_input)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_sws_ladder, urefcount_real,
+                            upipe_sws_ladder_free)
+UPIPE_HELPER_VOID(upipe_sws_ladder)
+
+/** @internal @This is the private context of an output (rendition) of a sws
+ * ladder pipe. */
+struct upipe_sws_ladder_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** ubuf manager */
+    struct ubuf_mgr *ubuf_mgr;
+    /** flow format packet */
+    struct uref *flow_format;
+    /** ubuf manager request */
+    struct urequest ubuf_mgr_request;
+
+    /** horizontal size of the rendition */
+    uint64_t hsize;
+    /** vertical size of the rendition */
+    uint64_t vsize;
+    /** swscale contexts [0] for progressive, [1,2] interlaced */
+    struct SwsContext *convert_ctx[3];
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+/** @hidden */
+static int upipe_sws_ladder_sub_check(struct upipe *upipe,
+                                      struct uref *flow_format);
+
+UPIPE_HELPER_UPIPE(upipe_sws_ladder_sub, upipe,
+                   UPIPE_SWS_LADDER_OUTPUT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_sws_ladder_sub, urefcount,
+                       upipe_sws_ladder_sub_free)
+UPIPE_HELPER_FLOW(upipe_sws_ladder_sub, "pic.")
+UPIPE_HELPER_OUTPUT(upipe_sws_ladder_sub, output, flow_def, output_state,
+                    request_list)
+UPIPE_HELPER_UBUF_MGR(upipe_sws_ladder_sub, ubuf_mgr, flow_format,
+                      ubuf_mgr_request,
+                      upipe_sws_ladder_sub_check,
+                      upipe_sws_ladder_sub_register_output_request,
+                      upipe_sws_ladder_sub_unregister_output_request)
+
+UPIPE_HELPER_SUBPIPE(upipe_sws_ladder, upipe_sws_ladder_sub, output,
+                     sub_mgr, outputs, uchain)
+
+/** @internal @This compares two renditions, to sort them by decreasing
+ * size.
+ *
+ * @param uchain1 pointer to first rendition
+ * @param uchain2 pointer to second rendition
+ * @return an integer less than, equal to, or greater than zero if the first
+ * rendition is respectively larger than, as large as, or smaller than the
+ * second
+ */
+static int upipe_sws_ladder_sub_compare(struct uchain **uchain1,
+                                        struct uchain **uchain2)
+{
+    struct upipe_sws_ladder_sub *sub1 =
+        upipe_sws_ladder_sub_from_uchain(*uchain1);
+    struct upipe_sws_ladder_sub *sub2 =
+        upipe_sws_ladder_sub_from_uchain(*uchain2);
+    uint64_t size1 = sub1->hsize * sub1->vsize;
+    uint64_t size2 = sub2->hsize * sub2->vsize;
+    return size1 > size2 ? -1 : size1 < size2 ? 1 : 0;
+}
+
+/** @internal @This receives the result of ubuf manager requests.
+ *
+ * @param upipe description structure of the subpipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_sws_ladder_sub_check(struct upipe *upipe,
+                                      struct uref *flow_format)
+{
+    if (flow_format != NULL)
+        upipe_sws_ladder_sub_store_flow_def(upipe, flow_format);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This builds the flow definition of a rendition from the input
+ * flow definition.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_sws_ladder_sub_build_flow_def(struct upipe *upipe)
+{
+    struct upipe_sws_ladder_sub *sub = upipe_sws_ladder_sub_from_upipe(upipe);
+    struct upipe_sws_ladder *ladder =
+        upipe_sws_ladder_from_sub_mgr(upipe->mgr);
+    if (ladder->flow_def == NULL)
+        return;
+
+    struct uref *flow_def = uref_dup(ladder->flow_def);
+    if (unlikely(flow_def == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    uint64_t input_hsize, input_vsize;
+    if (ubase_check(uref_pic_flow_get_hsize(flow_def, &input_hsize)) &&
+        ubase_check(uref_pic_flow_get_vsize(flow_def, &input_vsize)) &&
+        input_hsize && input_vsize) {
+        uint64_t hsize_visible, vsize_visible;
+        if (ubase_check(uref_pic_flow_get_hsize_visible(flow_def,
+                                                        &hsize_visible)))
+            UBASE_FATAL(upipe, uref_pic_flow_set_hsize_visible(flow_def,
+                        hsize_visible * sub->hsize / input_hsize))
+        if (ubase_check(uref_pic_flow_get_vsize_visible(flow_def,
+                                                        &vsize_visible)))
+            UBASE_FATAL(upipe, uref_pic_flow_set_vsize_visible(flow_def,
+                        vsize_visible * sub->vsize / input_vsize))
+
+        struct urational sar;
+        if (ubase_check(uref_pic_flow_get_sar(flow_def, &sar))) {
+            sar.num *= input_hsize * sub->vsize;
+            sar.den *= input_vsize * sub->hsize;
+            urational_simplify(&sar);
+            UBASE_FATAL(upipe, uref_pic_flow_set_sar(flow_def, sar))
+        }
+    }
+    UBASE_FATAL(upipe, uref_pic_flow_set_hsize(flow_def, sub->hsize))
+    UBASE_FATAL(upipe, uref_pic_flow_set_vsize(flow_def, sub->vsize))
+
+    uint64_t align = 0;
+    if (!ubase_check(uref_pic_flow_get_align(flow_def, &align)) ||
+        align % 16)
+        UBASE_FATAL(upipe, uref_pic_flow_set_align(flow_def, 16))
+
+    upipe_sws_ladder_sub_demand_ubuf_mgr(upipe, flow_def);
+}
+
+/** @internal @This allocates an output subpipe of a sws ladder pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_sws_ladder_sub_alloc(struct upipe_mgr *mgr,
+                                                struct uprobe *uprobe,
+                                                uint32_t signature,
+                                                va_list args)
+{
+    struct uref *flow_def;
+    struct upipe *upipe = upipe_sws_ladder_sub_alloc_flow(mgr,
+                            uprobe, signature, args, &flow_def);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_sws_ladder_sub *sub = upipe_sws_ladder_sub_from_upipe(upipe);
+    upipe_sws_ladder_sub_init_urefcount(upipe);
+    upipe_sws_ladder_sub_init_output(upipe);
+    upipe_sws_ladder_sub_init_ubuf_mgr(upipe);
+    for (int i = 0; i < 3; i++)
+        sub->convert_ctx[i] = NULL;
+
+    if (unlikely(!ubase_check(uref_pic_flow_get_hsize(flow_def,
+                                                      &sub->hsize)) ||
+                 !ubase_check(uref_pic_flow_get_vsize(flow_def,
+                                                      &sub->vsize)) ||
+                 !sub->hsize || !sub->vsize)) {
+        uref_free(flow_def);
+        upipe_sws_ladder_sub_clean_ubuf_mgr(upipe);
+        upipe_sws_ladder_sub_clean_output(upipe);
+        upipe_sws_ladder_sub_clean_urefcount(upipe);
+        upipe_sws_ladder_sub_free_flow(upipe);
+        return NULL;
+    }
+    uref_free(flow_def);
+
+    upipe_sws_ladder_sub_init_sub(upipe);
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_sub_mgr(mgr);
+    ulist_sort(&ladder->outputs, upipe_sws_ladder_sub_compare);
+
+    upipe_throw_ready(upipe);
+    upipe_sws_ladder_sub_build_flow_def(upipe);
+    return upipe;
+}
+
+/** @internal @This scales a picture to the size of a rendition.
+ *
+ * @param upipe description structure of the subpipe
+ * @param src source picture
+ * @param src_hsize horizontal size of the source picture
+ * @param src_vsize vertical size of the source picture
+ * @param progressive false if the fields must be scaled separately
+ * @return pointer to the scaled picture, or NULL in case of error
+ */
+static struct ubuf *upipe_sws_ladder_sub_scale(struct upipe *upipe,
+                                               struct ubuf *src,
+                                               size_t src_hsize,
+                                               size_t src_vsize,
+                                               bool progressive)
+{
+    struct upipe_sws_ladder_sub *sub = upipe_sws_ladder_sub_from_upipe(upipe);
+    struct upipe_sws_ladder *ladder =
+        upipe_sws_ladder_from_sub_mgr(upipe->mgr);
+    if (unlikely(sub->ubuf_mgr == NULL))
+        return NULL;
+
+    if (sub->vsize % 2)
+        progressive = true;
+    for (int i = progressive ? 0 : 1; i < (progressive ? 1 : 3); i++) {
+        sub->convert_ctx[i] = sws_getCachedContext(sub->convert_ctx[i],
+                src_hsize, src_vsize >> !!i, ladder->pix_fmt,
+                sub->hsize, sub->vsize >> !!i, ladder->pix_fmt,
+                ladder->flags, NULL, NULL, NULL);
+        if (unlikely(sub->convert_ctx[i] == NULL)) {
+            upipe_err(upipe, "sws_getContext failed");
+            return NULL;
+        }
+    }
+
+    struct ubuf *ubuf = ubuf_pic_alloc(sub->ubuf_mgr, sub->hsize, sub->vsize);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    /* map pictures */
+    const uint8_t *input_planes[UPIPE_AV_MAX_PLANES + 1];
+    int input_strides[UPIPE_AV_MAX_PLANES + 1];
+    uint8_t *output_planes[UPIPE_AV_MAX_PLANES + 1];
+    int output_strides[UPIPE_AV_MAX_PLANES + 1];
+    int i, mapped = 0;
+    bool error = false;
+    for (i = 0; i < UPIPE_AV_MAX_PLANES && ladder->chroma_map[i] != NULL;
+         i++) {
+        size_t input_stride, output_stride;
+        if (unlikely(!ubase_check(ubuf_pic_plane_read(src,
+                            ladder->chroma_map[i], 0, 0, -1, -1,
+                            &input_planes[i])))) {
+            error = true;
+            break;
+        }
+        if (unlikely(!ubase_check(ubuf_pic_plane_write(ubuf,
+                            ladder->chroma_map[i], 0, 0, -1, -1,
+                            &output_planes[i])))) {
+            ubuf_pic_plane_unmap(src, ladder->chroma_map[i], 0, 0, -1, -1);
+            error = true;
+            break;
+        }
+        mapped++;
+        if (unlikely(!ubase_check(ubuf_pic_plane_size(src,
+                            ladder->chroma_map[i],
+                            &input_stride, NULL, NULL, NULL)) ||
+                     !ubase_check(ubuf_pic_plane_size(ubuf,
+                            ladder->chroma_map[i],
+                            &output_stride, NULL, NULL, NULL)))) {
+            error = true;
+            break;
+        }
+        input_strides[i] = input_stride * (1 + !progressive);
+        output_strides[i] = output_stride * (1 + !progressive);
+    }
+    for ( ; i < UPIPE_AV_MAX_PLANES + 1; i++) {
+        input_planes[i] = NULL;
+        input_strides[i] = 0;
+        output_planes[i] = NULL;
+        output_strides[i] = 0;
+    }
+
+    /* fire ! */
+    if (!error) {
+        int ret, ret2 = 1;
+        if (progressive) {
+            ret = sws_scale(sub->convert_ctx[0],
+                            input_planes, input_strides, 0, src_vsize,
+                            output_planes, output_strides);
+        } else {
+            ret = sws_scale(sub->convert_ctx[1],
+                            input_planes, input_strides, 0, src_vsize / 2,
+                            output_planes, output_strides);
+            for (i = 0; i < mapped; i++) {
+                input_planes[i] += input_strides[i] / 2;
+                output_planes[i] += output_strides[i] / 2;
+            }
+            ret2 = sws_scale(sub->convert_ctx[2],
+                             input_planes, input_strides, 0, src_vsize / 2,
+                             output_planes, output_strides);
+        }
+        error = ret <= 0 || ret2 <= 0;
+    }
+
+    /* unmap pictures */
+    for (i = 0; i < mapped; i++) {
+        ubuf_pic_plane_unmap(src, ladder->chroma_map[i], 0, 0, -1, -1);
+        ubuf_pic_plane_unmap(ubuf, ladder->chroma_map[i], 0, 0, -1, -1);
+    }
+
+    if (unlikely(error)) {
+        upipe_warn(upipe, "error during sws conversion");
+        ubuf_free(ubuf);
+        return NULL;
+    }
+    return ubuf;
+}
+
+/** @internal @This processes control commands on an output subpipe of a sws
+ * ladder pipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_sws_ladder_sub_control(struct upipe *upipe,
+                                        int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_sws_ladder_sub_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_sws_ladder_sub_control_output(upipe, command, args);
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees an output subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_sws_ladder_sub_free(struct upipe *upipe)
+{
+    struct upipe_sws_ladder_sub *sub = upipe_sws_ladder_sub_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    for (int i = 0; i < 3; i++)
+        sws_freeContext(sub->convert_ctx[i]);
+    upipe_sws_ladder_sub_clean_output(upipe);
+    upipe_sws_ladder_sub_clean_sub(upipe);
+    upipe_sws_ladder_sub_clean_ubuf_mgr(upipe);
+    upipe_sws_ladder_sub_clean_urefcount(upipe);
+    upipe_sws_ladder_sub_free_flow(upipe);
+}
+
+/** @internal @This initializes the output manager for a sws ladder pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_ladder_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &ladder->sub_mgr;
+    sub_mgr->refcount = upipe_sws_ladder_to_urefcount_real(ladder);
+    sub_mgr->signature = UPIPE_SWS_LADDER_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_sws_ladder_sub_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_sws_ladder_sub_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates a sws ladder pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_sws_ladder_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_sws_ladder_alloc_void(mgr, uprobe, signature,
+                                                      args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    upipe_sws_ladder_init_urefcount(upipe);
+    upipe_sws_ladder_init_urefcount_real(upipe);
+    upipe_sws_ladder_init_sub_outputs(upipe);
+    upipe_sws_ladder_init_sub_mgr(upipe);
+    ladder->flow_def = NULL;
+    ladder->pix_fmt = AV_PIX_FMT_NONE;
+    ladder->flags = SWS_FULL_CHR_H_INP | SWS_ACCURATE_RND | SWS_LANCZOS;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This receives pictures and scales them in cascade, each
+ * rendition being computed from the smallest rendition already computed
+ * which is at least as large.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_sws_ladder_input(struct upipe *upipe, struct uref *uref,
+                                   struct upump **upump_p)
+{
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    size_t hsize, vsize;
+    if (unlikely(ladder->flow_def == NULL || uref->ubuf == NULL ||
+                 !ubase_check(uref_pic_size(uref, &hsize, &vsize, NULL)))) {
+        upipe_warn(upipe, "invalid buffer received");
+        uref_free(uref);
+        return;
+    }
+
+    bool progressive = ubase_check(uref_pic_get_progressive(uref));
+    if (unlikely(!progressive && vsize % 2)) {
+        upipe_warn(upipe, "interlaced picture has odd vertical size");
+        progressive = true;
+    }
+
+    /* previous rendition, used as the source of the next one */
+    struct ubuf *prev = NULL;
+    size_t prev_hsize = 0, prev_vsize = 0;
+
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&ladder->outputs, uchain, uchain_tmp) {
+        struct upipe_sws_ladder_sub *sub =
+            upipe_sws_ladder_sub_from_uchain(uchain);
+        struct upipe *sub_pipe = upipe_sws_ladder_sub_to_upipe(sub);
+
+        struct ubuf *src = uref->ubuf;
+        size_t src_hsize = hsize, src_vsize = vsize;
+        if (prev != NULL && prev_hsize >= sub->hsize &&
+            prev_vsize >= sub->vsize) {
+            src = prev;
+            src_hsize = prev_hsize;
+            src_vsize = prev_vsize;
+        }
+
+        struct ubuf *ubuf = upipe_sws_ladder_sub_scale(sub_pipe, src,
+                src_hsize, src_vsize, progressive);
+        if (unlikely(ubuf == NULL))
+            continue;
+
+        ubuf_free(prev);
+        prev = ubuf_dup(ubuf);
+        prev_hsize = sub->hsize;
+        prev_vsize = sub->vsize;
+
+        struct uref *output = uref_fork(uref, ubuf);
+        if (unlikely(output == NULL)) {
+            ubuf_free(ubuf);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            break;
+        }
+        upipe_sws_ladder_sub_output(sub_pipe, output, upump_p);
+    }
+
+    ubuf_free(prev);
+    uref_free(uref);
+}
+
+/** @internal @This sets the input flow definition, and rebuilds the flow
+ * definitions of all renditions.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_sws_ladder_set_flow_def(struct upipe *upipe,
+                                         struct uref *flow_def)
+{
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+
+    UBASE_RETURN(uref_flow_match_def(flow_def, "pic."))
+    const char *chroma_map[UPIPE_AV_MAX_PLANES];
+    enum AVPixelFormat pix_fmt =
+        upipe_av_pixfmt_from_flow_def(flow_def, NULL, chroma_map);
+    if (pix_fmt == AV_PIX_FMT_NONE || !sws_isSupportedInput(pix_fmt) ||
+        !sws_isSupportedOutput(pix_fmt)) {
+        upipe_err(upipe, "incompatible flow def");
+        uref_dump(flow_def, upipe->uprobe);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup);
+    uref_free(ladder->flow_def);
+    ladder->flow_def = flow_def_dup;
+    ladder->pix_fmt = pix_fmt;
+    for (int i = 0; i < UPIPE_AV_MAX_PLANES; i++)
+        ladder->chroma_map[i] = chroma_map[i];
+
+    struct uchain *uchain;
+    ulist_foreach (&ladder->outputs, uchain) {
+        struct upipe_sws_ladder_sub *sub =
+            upipe_sws_ladder_sub_from_uchain(uchain);
+        upipe_sws_ladder_sub_build_flow_def(
+                upipe_sws_ladder_sub_to_upipe(sub));
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a sws ladder pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_sws_ladder_control(struct upipe *upipe,
+                                    int command, va_list args)
+{
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    UBASE_HANDLED_RETURN(
+        upipe_sws_ladder_control_outputs(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_provide_request(upipe, command, args);
+
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_sws_ladder_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_SWS_LADDER_GET_FLAGS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_LADDER_SIGNATURE)
+            int *flags_p = va_arg(args, int *);
+            *flags_p = ladder->flags;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SWS_LADDER_SET_FLAGS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_LADDER_SIGNATURE)
+            ladder->flags = va_arg(args, int);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a sws ladder pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_ladder_free(struct upipe *upipe)
+{
+    struct upipe_sws_ladder *ladder = upipe_sws_ladder_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    uref_free(ladder->flow_def);
+    upipe_sws_ladder_clean_sub_outputs(upipe);
+    upipe_sws_ladder_clean_urefcount_real(upipe);
+    upipe_sws_ladder_clean_urefcount(upipe);
+    upipe_sws_ladder_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_ladder_no_input(struct upipe *upipe)
+{
+    upipe_sws_ladder_throw_sub_outputs(upipe, UPROBE_SOURCE_END);
+    upipe_sws_ladder_release_urefcount_real(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_sws_ladder_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_SWS_LADDER_SIGNATURE,
+
+    .upipe_alloc = upipe_sws_ladder_alloc,
+    .upipe_input = upipe_sws_ladder_input,
+    .upipe_control = upipe_sws_ladder_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for sws ladder pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_sws_ladder_mgr_alloc(void)
+{
+    return &upipe_sws_ladder_mgr;
+}
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Bin pipe producing thumbnails from the random access points only
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uref.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_inner.h"
+#include "upipe/upipe_helper_uprobe.h"
+#include "upipe/upipe_helper_bin_input.h"
+#include "upipe/upipe_helper_bin_output.h"
+#include "upipe-swscale/upipe_sws_thumbs.h"
+#include "upipe-swscale/upipe_sws_rap_thumbs.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/** @internal @This is the private context of a rap thumbs manager. */
+struct upipe_sws_rap_thumbs_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** manager of decoder pipes */
+    struct upipe_mgr *dec_mgr;
+    /** manager of thumbnail scaler pipes */
+    struct upipe_mgr *thumbs_mgr;
+    /** manager of encoder pipes */
+    struct upipe_mgr *enc_mgr;
+
+    /** public upipe_mgr structure */
+    struct upipe_mgr mgr;
+};
+
+UBASE_FROM_TO(upipe_sws_rap_thumbs_mgr, upipe_mgr, upipe_mgr, mgr)
+UBASE_FROM_TO(upipe_sws_rap_thumbs_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This is the private context of a rap thumbs pipe. */
+struct upipe_sws_rap_thumbs {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** list of input bin requests */
+    struct uchain input_request_list;
+    /** list of output bin requests */
+    struct uchain output_request_list;
+    /** proxy probe */
+    struct uprobe proxy_probe;
+
+    /** decoder, as first inner pipe of the bin */
+    struct upipe *first_inner;
+    /** encoder, as last inner pipe of the bin */
+    struct upipe *last_inner;
+    /** output */
+    struct upipe *output;
+
+    /** minimum period between thumbnails */
+    uint64_t period;
+    /** DTS of the last decoded random access point */
+    uint64_t last_dts;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_sws_rap_thumbs, upipe, UPIPE_SWS_RAP_THUMBS_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_sws_rap_thumbs, urefcount,
+                       upipe_sws_rap_thumbs_no_ref)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_sws_rap_thumbs, urefcount_real,
+                            upipe_sws_rap_thumbs_free)
+UPIPE_HELPER_INNER(upipe_sws_rap_thumbs, first_inner)
+UPIPE_HELPER_BIN_INPUT(upipe_sws_rap_thumbs, first_inner, input_request_list)
+UPIPE_HELPER_INNER(upipe_sws_rap_thumbs, last_inner)
+UPIPE_HELPER_UPROBE(upipe_sws_rap_thumbs, urefcount_real, proxy_probe, NULL)
+UPIPE_HELPER_BIN_OUTPUT(upipe_sws_rap_thumbs, last_inner, output,
+                        output_request_list)
+
+/** @internal @This allocates a rap thumbs pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_sws_rap_thumbs_alloc_pipe(struct upipe_mgr *mgr,
+                                                     struct uprobe *uprobe,
+                                                     uint32_t signature,
+                                                     va_list args)
+{
+    struct upipe_sws_rap_thumbs_mgr *rap_thumbs_mgr =
+        upipe_sws_rap_thumbs_mgr_from_upipe_mgr(mgr);
+    if (signature != UPIPE_FLOW_SIGNATURE) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct uref *flow_def = va_arg(args, struct uref *);
+    uint64_t hsize, vsize;
+    if (unlikely(!ubase_check(uref_flow_match_def(flow_def, "pic.")) ||
+                 !ubase_check(uref_pic_flow_get_hsize(flow_def, &hsize)) ||
+                 !ubase_check(uref_pic_flow_get_vsize(flow_def, &vsize)))) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+
+    struct upipe_sws_rap_thumbs *upipe_sws_rap_thumbs =
+        malloc(sizeof(struct upipe_sws_rap_thumbs));
+    if (unlikely(upipe_sws_rap_thumbs == NULL)) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+
+    struct upipe *upipe = upipe_sws_rap_thumbs_to_upipe(upipe_sws_rap_thumbs);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_sws_rap_thumbs_init_urefcount(upipe);
+    upipe_sws_rap_thumbs_init_urefcount_real(upipe);
+    upipe_sws_rap_thumbs_init_proxy_probe(upipe);
+    upipe_sws_rap_thumbs_init_bin_input(upipe);
+    upipe_sws_rap_thumbs_init_bin_output(upipe);
+    upipe_sws_rap_thumbs->period = 0;
+    upipe_sws_rap_thumbs->last_dts = UINT64_MAX;
+    upipe_throw_ready(upipe);
+
+    struct upipe *dec = upipe_void_alloc(rap_thumbs_mgr->dec_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_sws_rap_thumbs->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "dec"));
+    if (unlikely(dec == NULL)) {
+        upipe_err(upipe, "unable to allocate decoder");
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_sws_rap_thumbs_store_bin_input(upipe, upipe_use(dec));
+
+    struct upipe *thumbs = upipe_flow_alloc_output(dec,
+            rap_thumbs_mgr->thumbs_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_sws_rap_thumbs->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "thumbs"),
+            flow_def);
+    upipe_release(dec);
+    if (unlikely(thumbs == NULL ||
+                 !ubase_check(upipe_sws_thumbs_set_size(thumbs, hsize, vsize,
+                                                        1, 1)))) {
+        upipe_err(upipe, "unable to allocate scaler");
+        upipe_release(thumbs);
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    struct uref *enc_flow_def = uref_dup(flow_def);
+    if (unlikely(enc_flow_def == NULL)) {
+        upipe_release(thumbs);
+        upipe_release(upipe);
+        return NULL;
+    }
+    uref_pic_flow_clear_format(enc_flow_def);
+    uref_flow_set_def(enc_flow_def, "block.mjpeg.pic.");
+    struct upipe *enc = upipe_flow_alloc_output(thumbs,
+            rap_thumbs_mgr->enc_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_sws_rap_thumbs->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "enc"),
+            enc_flow_def);
+    uref_free(enc_flow_def);
+    upipe_release(thumbs);
+    if (unlikely(enc == NULL)) {
+        upipe_err(upipe, "unable to allocate encoder");
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_sws_rap_thumbs_store_bin_output(upipe, enc);
+    return upipe;
+}
+
+/** @internal @This receives coded frames, and only forwards the random
+ * access points to the decoder.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_sws_rap_thumbs_input(struct upipe *upipe, struct uref *uref,
+                                       struct upump **upump_p)
+{
+    struct upipe_sws_rap_thumbs *upipe_sws_rap_thumbs =
+        upipe_sws_rap_thumbs_from_upipe(upipe);
+
+    if (!ubase_check(uref_flow_get_random(uref))) {
+        uref_free(uref);
+        return;
+    }
+
+    uint64_t dts;
+    if (upipe_sws_rap_thumbs->period &&
+        ubase_check(uref_clock_get_dts_prog(uref, &dts))) {
+        uint64_t last_dts = upipe_sws_rap_thumbs->last_dts;
+        if (last_dts != UINT64_MAX && dts >= last_dts &&
+            dts < last_dts + upipe_sws_rap_thumbs->period) {
+            uref_free(uref);
+            return;
+        }
+        upipe_sws_rap_thumbs->last_dts = dts;
+    }
+
+    upipe_sws_rap_thumbs_bin_input(upipe, uref, upump_p);
+}
+
+/** @internal @This processes control commands on a rap thumbs pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_sws_rap_thumbs_control(struct upipe *upipe, int command,
+                                        va_list args)
+{
+    struct upipe_sws_rap_thumbs *upipe_sws_rap_thumbs =
+        upipe_sws_rap_thumbs_from_upipe(upipe);
+
+    switch (command) {
+        case UPIPE_SWS_RAP_THUMBS_SET_PERIOD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_RAP_THUMBS_SIGNATURE)
+            upipe_sws_rap_thumbs->period = va_arg(args, uint64_t);
+            upipe_sws_rap_thumbs->last_dts = UINT64_MAX;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SWS_RAP_THUMBS_GET_PERIOD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_SWS_RAP_THUMBS_SIGNATURE)
+            uint64_t *period_p = va_arg(args, uint64_t *);
+            *period_p = upipe_sws_rap_thumbs->period;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_FLOW_DEF:
+            upipe_sws_rap_thumbs->last_dts = UINT64_MAX;
+            break;
+        default:
+            break;
+    }
+
+    UBASE_HANDLED_RETURN(
+        upipe_sws_rap_thumbs_control_bin_input(upipe, command, args));
+    return upipe_sws_rap_thumbs_control_bin_output(upipe, command, args);
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe pipe to free
+ */
+static void upipe_sws_rap_thumbs_free(struct upipe *upipe)
+{
+    struct upipe_sws_rap_thumbs *upipe_sws_rap_thumbs =
+        upipe_sws_rap_thumbs_from_upipe(upipe);
+
+    upipe_throw_dead(upipe);
+    upipe_sws_rap_thumbs_clean_proxy_probe(upipe);
+    upipe_sws_rap_thumbs_clean_urefcount_real(upipe);
+    upipe_sws_rap_thumbs_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_sws_rap_thumbs);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_sws_rap_thumbs_no_ref(struct upipe *upipe)
+{
+    upipe_sws_rap_thumbs_clean_bin_input(upipe);
+    upipe_sws_rap_thumbs_clean_bin_output(upipe);
+    upipe_sws_rap_thumbs_release_urefcount_real(upipe);
+}
+
+/** @This frees a upipe manager.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_sws_rap_thumbs_mgr_free(struct urefcount *urefcount)
+{
+    struct upipe_sws_rap_thumbs_mgr *rap_thumbs_mgr =
+        upipe_sws_rap_thumbs_mgr_from_urefcount(urefcount);
+    upipe_mgr_release(rap_thumbs_mgr->dec_mgr);
+    upipe_mgr_release(rap_thumbs_mgr->thumbs_mgr);
+    upipe_mgr_release(rap_thumbs_mgr->enc_mgr);
+
+    urefcount_clean(urefcount);
+    free(rap_thumbs_mgr);
+}
+
+/** @This returns the management structure for rap thumbs pipes.
+ *
+ * @param dec_mgr manager of decoder pipes
+ * @param enc_mgr manager of picture encoder pipes
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_sws_rap_thumbs_mgr_alloc(struct upipe_mgr *dec_mgr,
+                                                 struct upipe_mgr *enc_mgr)
+{
+    if (unlikely(dec_mgr == NULL || enc_mgr == NULL))
+        return NULL;
+
+    struct upipe_sws_rap_thumbs_mgr *rap_thumbs_mgr =
+        malloc(sizeof(struct upipe_sws_rap_thumbs_mgr));
+    if (unlikely(rap_thumbs_mgr == NULL))
+        return NULL;
+
+    rap_thumbs_mgr->dec_mgr = upipe_mgr_use(dec_mgr);
+    rap_thumbs_mgr->thumbs_mgr = upipe_sws_thumbs_mgr_alloc();
+    rap_thumbs_mgr->enc_mgr = upipe_mgr_use(enc_mgr);
+    urefcount_init(upipe_sws_rap_thumbs_mgr_to_urefcount(rap_thumbs_mgr),
+                   upipe_sws_rap_thumbs_mgr_free);
+
+    rap_thumbs_mgr->mgr.refcount =
+        upipe_sws_rap_thumbs_mgr_to_urefcount(rap_thumbs_mgr);
+    rap_thumbs_mgr->mgr.signature = UPIPE_SWS_RAP_THUMBS_SIGNATURE;
+    rap_thumbs_mgr->mgr.upipe_alloc = upipe_sws_rap_thumbs_alloc_pipe;
+    rap_thumbs_mgr->mgr.upipe_input = upipe_sws_rap_thumbs_input;
+    rap_thumbs_mgr->mgr.upipe_control = upipe_sws_rap_thumbs_control;
+    rap_thumbs_mgr->mgr.upipe_mgr_control = NULL;
+    return upipe_sws_rap_thumbs_mgr_to_upipe_mgr(rap_thumbs_mgr);
+}
@@ -51,6 +51,7 @@
 #include "upipe/upipe_helper_upump.h"
 
 #include "upipe-ts/upipe_rtp_fec.h"
+#include "upipe_rtp_fec_xor.h"
 
 #include <bitstream/ietf/rtp.h>
 #include <bitstream/mpeg/ts.h>
@@ -114,6 +115,8 @@ struct upipe_rtp_fec {
     struct upipe row_subpipe;
 
     struct uchain main_queue;
+    /** main packets of main_queue, indexed by sequence number */
+    struct uref *main_index[UINT16_MAX + 1];
     struct uchain col_queue;
     struct uchain row_queue;
 
@@ -196,17 +199,26 @@ static void upipe_rtp_fec_extract_parameters(struct uref *fec_uref,
     uref_block_peek_unmap(fec_uref, RTP_HEADER_SIZE, fec_header, peek);
 }
 
+/* Remove a main packet from the queue and the index */
+static void delete_main_uref(struct upipe_rtp_fec *upipe_rtp_fec,
+                             struct uref *uref)
+{
+    upipe_rtp_fec->main_index[(uint16_t)uref->priv] = NULL;
+    ulist_delete(uref_to_uchain(uref));
+}
+
 /* Delete main packets older than the reference point */
-static void clear_main_list(struct uchain *main_list, uint16_t snbase)
+static void clear_main_list(struct upipe_rtp_fec *upipe_rtp_fec,
+                            uint16_t snbase)
 {
     struct uchain *uchain, *uchain_tmp;
 
-    ulist_delete_foreach (main_list, uchain, uchain_tmp) {
+    ulist_delete_foreach (&upipe_rtp_fec->main_queue, uchain, uchain_tmp) {
         struct uref *uref = uref_from_uchain(uchain);
         if (!seq_num_lt(uref->priv, snbase))
             break;
 
-        ulist_delete(uchain);
+        delete_main_uref(upipe_rtp_fec, uref);
         uref_free(uref);
     }
 }
@@ -266,34 +278,65 @@ static void insert_ordered_uref(struct uchain *queue, struct uref *uref)
     ulist_add(queue, uref_to_uchain(uref));
 }
 
+/* Insert a main packet in the queue, ordered by sequence number.
+ * The index gives duplicates and the closest preceding packet without
+ * walking the queue. */
+static void insert_main_uref(struct upipe_rtp_fec *upipe_rtp_fec,
+                             struct uref *uref)
+{
+    struct uchain *queue = &upipe_rtp_fec->main_queue;
+    uint16_t new_seqnum = uref->priv;
+
+    /* Duplicate packet */
+    if (upipe_rtp_fec->main_index[new_seqnum]) {
+        uref_free(uref);
+        return;
+    }
+    upipe_rtp_fec->main_index[new_seqnum] = uref;
+
+    /* Add to end of queue */
+    struct uchain *last = ulist_peek_last(queue);
+    if (!last || seq_num_lt(uref_from_uchain(last)->priv, new_seqnum)) {
+        ulist_add(queue, uref_to_uchain(uref));
+        return;
+    }
+
+    uref_clock_delete_date_sys(uref);
+
+    uint16_t first_seqnum = uref_from_uchain(ulist_peek(queue))->priv;
+    if (seq_num_lt(new_seqnum, first_seqnum)) {
+        ulist_unshift(queue, uref_to_uchain(uref));
+        return;
+    }
+
+    /* the first packet is older, so this stops at the latest */
+    uint16_t seqnum = new_seqnum - 1;
+    while (!upipe_rtp_fec->main_index[seqnum])
+        seqnum--;
+    struct uchain *prev = uref_to_uchain(upipe_rtp_fec->main_index[seqnum]);
+    ulist_insert(prev, prev->next, uref_to_uchain(uref));
+}
+
 /* apply the correction from that fec packet */
 static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
         struct uref *fec_uref, uint16_t *seqnum_list, int items)
 {
     struct upipe_rtp_fec *upipe_rtp_fec = upipe_rtp_fec_from_upipe(upipe);
 
-    bool found_seqnum[FEC_MAX] = {0};
+    struct uref *urefs[FEC_MAX];
 
     /* Search to see if any packets are lost */
     int processed = 0;
-    struct uchain *uchain;
-    ulist_foreach (&upipe_rtp_fec->main_queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-        uint16_t seqnum = uref->priv;
-
-        for (int i = 0; i < items; i++) {
-            if (seqnum_list[i] == seqnum) {
-                processed++;
-                found_seqnum[i] = true;
-                break;
-            }
-        }
+    for (int i = 0; i < items; i++) {
+        urefs[i] = upipe_rtp_fec->main_index[seqnum_list[i]];
+        if (urefs[i])
+            processed++;
+    }
 
-        if (processed == items) {
-            upipe_verbose_va(upipe, "no packets lost");
-            uref_free(fec_uref);
-            return;
-        }
+    if (processed == items) {
+        upipe_verbose_va(upipe, "no packets lost");
+        uref_free(fec_uref);
+        return;
     }
 
     if (processed != items - 1) {
@@ -308,34 +351,57 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
     uint32_t ts_rec;
     upipe_rtp_fec_extract_parameters(fec_uref, &ts_rec, &length_rec);
 
-    /* Recoverable packet */
-    ulist_foreach (&upipe_rtp_fec->main_queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-
-        // TODO: only if in list?
+    /* Recoverable packet: map every source once for the whole group */
+    const uint8_t *srcs[FEC_MAX];
+    struct uref *mapped[FEC_MAX];
+    struct uref *segmented[FEC_MAX];
+    int nb_srcs = 0, nb_segmented = 0;
+    for (int i = 0; i < items; i++) {
+        struct uref *uref = urefs[i];
+        if (!uref)
+            continue;
 
-        uint8_t rtp_buffer[RTP_HEADER_SIZE];
-        const uint8_t *rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE,
-                rtp_buffer);
-        if (unlikely(rtp_header == NULL)) {
+        size_t uref_len = 0;
+        uref_block_size(uref, &uref_len);
+        if (unlikely(uref_len < RTP_HEADER_SIZE)) {
             upipe_warn(upipe, "invalid buffer");
             continue;
         }
 
-        uint32_t timestamp = rtp_get_timestamp(rtp_header);
-        uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
+        int read_size = uref_len;
+        const uint8_t *buffer;
+        if (unlikely(!ubase_check(uref_block_read(uref, 0, &read_size,
+                                                  &buffer)))) {
+            upipe_warn(upipe, "invalid buffer");
+            continue;
+        }
+        if (unlikely((size_t)read_size < uref_len)) {
+            /* segmented buffer, copied later */
+            uref_block_unmap(uref, 0);
+            uint8_t rtp_buffer[RTP_HEADER_SIZE];
+            buffer = uref_block_peek(uref, 0, RTP_HEADER_SIZE, rtp_buffer);
+            if (unlikely(buffer == NULL)) {
+                upipe_warn(upipe, "invalid buffer");
+                continue;
+            }
+            ts_rec ^= rtp_get_timestamp(buffer);
+            uref_block_peek_unmap(uref, 0, rtp_buffer, buffer);
+            length_rec ^= uref_len - RTP_HEADER_SIZE;
+            if (uref_len >= TS_SIZE * 7 + RTP_HEADER_SIZE)
+                segmented[nb_segmented++] = uref;
+            continue;
+        }
 
         /* Recover length and timestamp of missing packet */
-        for (int i = 0; i < items; i++) {
-            if (seqnum_list[i] == uref->priv) {
-                size_t uref_len = 0;
-                uref_block_size(uref, &uref_len);
-                uref_len -= RTP_HEADER_SIZE;
-
-                length_rec ^= uref_len;
-                ts_rec ^= timestamp;
-            }
+        ts_rec ^= rtp_get_timestamp(buffer);
+        length_rec ^= uref_len - RTP_HEADER_SIZE;
+
+        if (uref_len < TS_SIZE * 7 + RTP_HEADER_SIZE) {
+            uref_block_unmap(uref, 0);
+            continue;
         }
+        srcs[nb_srcs] = buffer;
+        mapped[nb_srcs++] = uref;
     }
 
     if (length_rec != 7 * TS_SIZE)
@@ -347,43 +413,39 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
     int size = length_rec + RTP_HEADER_SIZE;
     uref_block_write(fec_uref, 0, &size, &dst);
 
-    bool copy_header = true;
-
-    processed = 0;
-    ulist_foreach (&upipe_rtp_fec->main_queue, uchain) {
-        struct uref *uref = uref_from_uchain(uchain);
-        for (int i = 0; i < items; i++) {
-            if (seqnum_list[i] == uref->priv) {
-                size_t size = 0;
-                uref_block_size(uref, &size);
-                uint8_t payload_buf[TS_SIZE * 7 + RTP_HEADER_SIZE];
-
-                if(size < sizeof(payload_buf))
-                    continue;
-
-                // TODO: uref_block_read in a loop
-                const uint8_t *peek = uref_block_peek(uref, 0, size,
-                        payload_buf);
-                if (copy_header) {
-                    memcpy(dst, peek, RTP_HEADER_SIZE);
-                    copy_header = false;
-                }
-                for (int i = 0; i < size - RTP_HEADER_SIZE; i++)
-                    dst[RTP_HEADER_SIZE + i] ^= peek[RTP_HEADER_SIZE + i];
-                uref_block_peek_unmap(uref, RTP_HEADER_SIZE, payload_buf, peek);
-                processed++;
-                break;
-            }
-        }
-
-        if (processed == items-1)
-            break;
+    if (nb_srcs)
+        memcpy(dst, srcs[0], RTP_HEADER_SIZE);
+
+    int payload_size = size - RTP_HEADER_SIZE;
+    if (payload_size > TS_SIZE * 7)
+        payload_size = TS_SIZE * 7;
+    for (int i = 0; i < nb_srcs; i++)
+        srcs[i] += RTP_HEADER_SIZE;
+    if (payload_size > 0)
+        upipe_rtp_fec_xor(dst + RTP_HEADER_SIZE, srcs, nb_srcs,
+                          payload_size);
+
+    for (int i = 0; i < nb_srcs; i++)
+        uref_block_unmap(mapped[i], 0);
+
+    for (int i = 0; i < nb_segmented; i++) {
+        uint8_t payload_buf[TS_SIZE * 7 + RTP_HEADER_SIZE];
+        const uint8_t *peek = uref_block_peek(segmented[i], 0,
+                sizeof(payload_buf), payload_buf);
+        if (unlikely(peek == NULL))
+            continue;
+        if (!nb_srcs && !i)
+            memcpy(dst, peek, RTP_HEADER_SIZE);
+        const uint8_t *src = peek + RTP_HEADER_SIZE;
+        if (payload_size > 0)
+            upipe_rtp_fec_xor(dst + RTP_HEADER_SIZE, &src, 1, payload_size);
+        uref_block_peek_unmap(segmented[i], 0, payload_buf, peek);
     }
 
     /* Maybe possible to merge with above */
     uint16_t missing_seqnum = 0;
     for (int i = 0; i < items; i++)
-        if (!found_seqnum[i]) {
+        if (!urefs[i]) {
             missing_seqnum = seqnum_list[i];
             break;
         }
@@ -401,7 +463,7 @@ static void upipe_rtp_fec_correct_packets(struct upipe *upipe,
        (seq_num_lt(missing_seqnum, upipe_rtp_fec->last_send_seqnum) || upipe_rtp_fec->last_send_seqnum == missing_seqnum))
         uref_free(fec_uref);
     else
-        insert_ordered_uref(&upipe_rtp_fec->main_queue, fec_uref);
+        insert_main_uref(upipe_rtp_fec, fec_uref);
 }
 
 static void upipe_rtp_fec_apply_col_fec(struct upipe *upipe)
@@ -482,6 +544,7 @@ static void upipe_rtp_fec_clear_queue(struct uchain *queue)
 static void upipe_rtp_fec_clear(struct upipe_rtp_fec *upipe_rtp_fec)
 {
     upipe_rtp_fec_clear_queue(&upipe_rtp_fec->main_queue);
+    memset(upipe_rtp_fec->main_index, 0, sizeof(upipe_rtp_fec->main_index));
     upipe_rtp_fec_clear_queue(&upipe_rtp_fec->col_queue);
     upipe_rtp_fec_clear_queue(&upipe_rtp_fec->row_queue);
 }
@@ -511,7 +574,7 @@ static void upipe_rtp_fec_timer(struct upump *upump)
             uref_clock_set_date_sys(uref, date_sys, type);
         }
 
-        ulist_delete(uchain);
+        delete_main_uref(upipe_rtp_fec, uref);
         upipe_rtp_fec_output(upipe, uref, NULL);
 
         if (upipe_rtp_fec->last_send_seqnum != UINT32_MAX) {
@@ -569,7 +632,7 @@ static void upipe_rtp_fec_start_timer(struct upipe *upipe, uint16_t seqnum)
     struct upipe_rtp_fec *upipe_rtp_fec = upipe_rtp_fec_from_sub_mgr(upipe->mgr);
 
     /* Clear any old non-FEC packets */
-    clear_main_list(&upipe_rtp_fec->main_queue, upipe_rtp_fec->cur_matrix_snbase);
+    clear_main_list(upipe_rtp_fec, upipe_rtp_fec->cur_matrix_snbase);
 
     struct uchain *first_uchain = ulist_peek(&upipe_rtp_fec->main_queue);
     if (!first_uchain)
@@ -592,7 +655,7 @@ static void upipe_rtp_fec_start_timer(struct upipe *upipe, uint16_t seqnum)
 
     if (date_sys == UINT64_MAX) {
         /* First packet having an unusable date_sys is not useful */
-        ulist_delete(first_uchain);
+        delete_main_uref(upipe_rtp_fec, first_uref);
         uref_free(first_uref);
         first_uchain = ulist_peek(&upipe_rtp_fec->main_queue);
         if (first_uchain) {
@@ -688,7 +751,7 @@ static void upipe_rtp_fec_main_input(struct upipe *upipe, struct uref *uref)
         uint64_t date_sys = 0;
         uref_clock_get_date_sys(uref, &date_sys, &type);
 
-        insert_ordered_uref(&upipe_rtp_fec->main_queue, uref);
+        insert_main_uref(upipe_rtp_fec, uref);
 
         /* Owing to clock drift the latency of 2x the FEC matrix may increase
          * Build a continually updating duration and correct the latency if necessary.
@@ -0,0 +1,641 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe SMPTE 2022-1 FEC encoder
+ *
+ * Each incoming packet is xored into the parity of its column and into
+ * the parity of the current row as it passes, then forwarded. A column
+ * FEC packet is output when the last row of the matrix has been received,
+ * and a row FEC packet when the last column of a row has been received.
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uprobe.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_flow.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_output.h"
+
+#include "upipe-ts/upipe_rtp_fec_enc.h"
+#include "upipe_rtp_fec_xor.h"
+
+#include <string.h>
+#include <inttypes.h>
+
+#include <bitstream/ietf/rtp.h>
+#include <bitstream/smpte/2022_1_fec.h>
+
+/** maximum number of columns (L) */
+#define FEC_COLS_MAX 20
+/** maximum number of rows (D) */
+#define FEC_ROWS_MAX 20
+/** minimum number of rows (D) */
+#define FEC_ROWS_MIN 4
+/** maximum size of the matrix (L x D) */
+#define FEC_MATRIX_MAX 100
+/** largest RTP payload in an Ethernet frame */
+#define FEC_PAYLOAD_MAX (1500 - 20 - 8 - RTP_HEADER_SIZE)
+/** RTP payload type of FEC packets */
+#define FEC_RTP_TYPE 96
+/** default number of columns */
+#define DEFAULT_COLS 10
+/** default number of rows */
+#define DEFAULT_ROWS 10
+
+/** @internal @This is the parity of a row or a column being built. */
+struct upipe_rtp_fec_enc_parity {
+    /** sequence number of the first protected packet */
+    uint16_t snbase;
+    /** xor of the payload lengths */
+    uint16_t length_rec;
+    /** xor of the payload types */
+    uint8_t pt_rec;
+    /** xor of the timestamps */
+    uint32_t ts_rec;
+    /** size of the largest payload, the remainder of payload is zero */
+    int size;
+    /** xor of the payloads */
+    uint8_t payload[FEC_PAYLOAD_MAX];
+};
+
+/** @internal @This is the private context of a FEC output subpipe. */
+struct upipe_rtp_fec_enc_output {
+    /** RTP sequence number of the next FEC packet */
+    uint16_t seqnum;
+
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_rtp_fec_enc_output, upipe,
+                   UPIPE_RTP_FEC_ENC_OUTPUT_SIGNATURE)
+UPIPE_HELPER_OUTPUT(upipe_rtp_fec_enc_output, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This is the private context of a rtp fec enc pipe. */
+struct upipe_rtp_fec_enc {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** output pipe */
+    struct upipe *output;
+    /** flow_definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** manager of the subpipes */
+    struct upipe_mgr sub_mgr;
+    /** column FEC subpipe */
+    struct upipe_rtp_fec_enc_output col_output;
+    /** row FEC subpipe */
+    struct upipe_rtp_fec_enc_output row_output;
+
+    /** number of columns (L) */
+    unsigned int cols;
+    /** number of rows (D) */
+    unsigned int rows;
+    /** sequence number of the first packet of the matrix, or UINT32_MAX */
+    uint32_t snbase;
+    /** expected sequence number of the next packet */
+    uint16_t next_seqnum;
+
+    /** parity of each column */
+    struct upipe_rtp_fec_enc_parity col[FEC_COLS_MAX];
+    /** parity of the current row */
+    struct upipe_rtp_fec_enc_parity row;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_rtp_fec_enc, upipe, UPIPE_RTP_FEC_ENC_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_rtp_fec_enc, urefcount, upipe_rtp_fec_enc_free)
+UPIPE_HELPER_OUTPUT(upipe_rtp_fec_enc, output, flow_def, output_state,
+                    request_list)
+
+UBASE_FROM_TO(upipe_rtp_fec_enc, upipe_mgr, sub_mgr, sub_mgr)
+
+/** @internal @This starts the parity of a new row or column.
+ *
+ * @param parity parity to reset
+ * @param snbase sequence number of the first protected packet
+ */
+static void upipe_rtp_fec_enc_parity_reset(
+        struct upipe_rtp_fec_enc_parity *parity, uint16_t snbase)
+{
+    memset(parity->payload, 0, parity->size);
+    parity->snbase = snbase;
+    parity->length_rec = 0;
+    parity->pt_rec = 0;
+    parity->ts_rec = 0;
+    parity->size = 0;
+}
+
+/** @internal @This writes the SMPTE 2022-1 FEC header.
+ *
+ * @param p pointer to the FEC header
+ * @param parity parity of the protected packets
+ * @param d true for a row FEC packet
+ * @param offset distance between protected packets
+ * @param na number of protected packets
+ */
+static void upipe_rtp_fec_enc_set_header(uint8_t *p,
+        const struct upipe_rtp_fec_enc_parity *parity,
+        bool d, uint8_t offset, uint8_t na)
+{
+    p[0] = parity->snbase >> 8;
+    p[1] = parity->snbase;
+    p[2] = parity->length_rec >> 8;
+    p[3] = parity->length_rec;
+    /* E bit set, PT recovery */
+    p[4] = 0x80 | (parity->pt_rec & 0x7f);
+    /* mask is unused */
+    p[5] = p[6] = p[7] = 0;
+    p[8] = parity->ts_rec >> 24;
+    p[9] = parity->ts_rec >> 16;
+    p[10] = parity->ts_rec >> 8;
+    p[11] = parity->ts_rec;
+    /* X = 0, D, type = XOR, index = 0 */
+    p[12] = d ? 0x40 : 0;
+    p[13] = offset;
+    p[14] = na;
+    /* SNBase ext bits are unused */
+    p[15] = 0;
+}
+
+/** @internal @This builds a FEC packet from a parity.
+ *
+ * @param upipe description structure of the pipe
+ * @param output FEC output subpipe
+ * @param parity parity of the protected packets
+ * @param d true for a row FEC packet
+ * @param offset distance between protected packets
+ * @param na number of protected packets
+ * @param uref last protected packet
+ * @param timestamp RTP timestamp of the last protected packet
+ * @return FEC packet, or NULL in case of allocation error
+ */
+static struct uref *upipe_rtp_fec_enc_build(struct upipe *upipe,
+        struct upipe_rtp_fec_enc_output *output,
+        const struct upipe_rtp_fec_enc_parity *parity,
+        bool d, uint8_t offset, uint8_t na,
+        struct uref *uref, uint32_t timestamp)
+{
+    struct ubuf *ubuf = ubuf_block_alloc(uref->ubuf->mgr,
+            RTP_HEADER_SIZE + SMPTE_2022_FEC_HEADER_SIZE + parity->size);
+    if (unlikely(ubuf == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    struct uref *fec = uref_fork(uref, ubuf);
+    if (unlikely(fec == NULL)) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    uint8_t *buf;
+    int size = -1;
+    if (unlikely(!ubase_check(uref_block_write(fec, 0, &size, &buf)))) {
+        uref_free(fec);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return NULL;
+    }
+
+    memset(buf, 0, RTP_HEADER_SIZE);
+    rtp_set_hdr(buf);
+    rtp_set_type(buf, FEC_RTP_TYPE);
+    rtp_set_seqnum(buf, output->seqnum++);
+    rtp_set_timestamp(buf, timestamp);
+    buf += RTP_HEADER_SIZE;
+    upipe_rtp_fec_enc_set_header(buf, parity, d, offset, na);
+    buf += SMPTE_2022_FEC_HEADER_SIZE;
+    memcpy(buf, parity->payload, parity->size);
+    uref_block_unmap(fec, 0);
+    return fec;
+}
+
+/** @internal @This handles input packets.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_rtp_fec_enc_input(struct upipe *upipe, struct uref *uref,
+                                    struct upump **upump_p)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+
+    size_t size = 0;
+    uint8_t rtp_buffer[RTP_HEADER_SIZE];
+    const uint8_t *rtp_header = NULL;
+    if (likely(ubase_check(uref_block_size(uref, &size)) &&
+               size >= RTP_HEADER_SIZE &&
+               size <= RTP_HEADER_SIZE + FEC_PAYLOAD_MAX))
+        rtp_header = uref_block_peek(uref, 0, RTP_HEADER_SIZE, rtp_buffer);
+    if (unlikely(rtp_header == NULL)) {
+        upipe_warn(upipe, "invalid packet, restarting FEC matrix");
+        upipe_rtp_fec_enc->snbase = UINT32_MAX;
+        upipe_rtp_fec_enc_output(upipe, uref, upump_p);
+        return;
+    }
+    uint16_t seqnum = rtp_get_seqnum(rtp_header);
+    uint32_t timestamp = rtp_get_timestamp(rtp_header);
+    uint8_t pt = rtp_get_type(rtp_header);
+    uref_block_peek_unmap(uref, 0, rtp_buffer, rtp_header);
+
+    if (upipe_rtp_fec_enc->snbase != UINT32_MAX &&
+        seqnum != upipe_rtp_fec_enc->next_seqnum) {
+        upipe_warn_va(upipe, "expected seqnum %" PRIu16 ", got %" PRIu16
+                      ", restarting FEC matrix",
+                      upipe_rtp_fec_enc->next_seqnum, seqnum);
+        upipe_rtp_fec_enc->snbase = UINT32_MAX;
+    }
+    upipe_rtp_fec_enc->next_seqnum = seqnum + 1;
+
+    unsigned int cols = upipe_rtp_fec_enc->cols;
+    unsigned int rows = upipe_rtp_fec_enc->rows;
+    uint16_t pos = seqnum - upipe_rtp_fec_enc->snbase;
+    if (upipe_rtp_fec_enc->snbase == UINT32_MAX || pos >= cols * rows) {
+        upipe_rtp_fec_enc->snbase = seqnum;
+        pos = 0;
+    }
+    unsigned int col = pos % cols;
+    unsigned int row = pos / cols;
+
+    struct upipe_rtp_fec_enc_parity *col_parity = &upipe_rtp_fec_enc->col[col];
+    struct upipe_rtp_fec_enc_parity *row_parity = &upipe_rtp_fec_enc->row;
+    if (!row)
+        upipe_rtp_fec_enc_parity_reset(col_parity, seqnum);
+    if (!col)
+        upipe_rtp_fec_enc_parity_reset(row_parity, seqnum);
+
+    uint16_t length = size - RTP_HEADER_SIZE;
+    col_parity->length_rec ^= length;
+    col_parity->pt_rec ^= pt;
+    col_parity->ts_rec ^= timestamp;
+    if (col_parity->size < length)
+        col_parity->size = length;
+    row_parity->length_rec ^= length;
+    row_parity->pt_rec ^= pt;
+    row_parity->ts_rec ^= timestamp;
+    if (row_parity->size < length)
+        row_parity->size = length;
+
+    /* xor the payload segment by segment, without copying it */
+    int offset = RTP_HEADER_SIZE;
+    while ((size_t)offset < size) {
+        const uint8_t *buffer;
+        int read_size = -1;
+        if (unlikely(!ubase_check(uref_block_read(uref, offset, &read_size,
+                                                  &buffer)))) {
+            upipe_warn(upipe, "unable to read packet");
+            upipe_rtp_fec_enc->snbase = UINT32_MAX;
+            upipe_rtp_fec_enc_output(upipe, uref, upump_p);
+            return;
+        }
+        int payload_offset = offset - RTP_HEADER_SIZE;
+        upipe_rtp_fec_xor(col_parity->payload + payload_offset,
+                          &buffer, 1, read_size);
+        upipe_rtp_fec_xor(row_parity->payload + payload_offset,
+                          &buffer, 1, read_size);
+        uref_block_unmap(uref, offset);
+        offset += read_size;
+    }
+
+    struct uref *col_fec = NULL, *row_fec = NULL;
+    if (row == rows - 1)
+        col_fec = upipe_rtp_fec_enc_build(upipe,
+                &upipe_rtp_fec_enc->col_output, col_parity, false,
+                cols, rows, uref, timestamp);
+    if (col == cols - 1)
+        row_fec = upipe_rtp_fec_enc_build(upipe,
+                &upipe_rtp_fec_enc->row_output, row_parity, true,
+                1, cols, uref, timestamp);
+
+    upipe_rtp_fec_enc_output(upipe, uref, upump_p);
+    if (col_fec != NULL)
+        upipe_rtp_fec_enc_output_output(
+                upipe_rtp_fec_enc_output_to_upipe(
+                    &upipe_rtp_fec_enc->col_output), col_fec, upump_p);
+    if (row_fec != NULL)
+        upipe_rtp_fec_enc_output_output(
+                upipe_rtp_fec_enc_output_to_upipe(
+                    &upipe_rtp_fec_enc->row_output), row_fec, upump_p);
+}
+
+/** @internal @This sets the input flow definition, and forwards it to
+ * the main output and to the FEC subpipes.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_set_flow_def(struct upipe *upipe,
+                                          struct uref *flow_def)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+
+    UBASE_RETURN(uref_flow_match_def(flow_def, "block."))
+
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    struct uref *col_flow_def = uref_dup(flow_def);
+    struct uref *row_flow_def = uref_dup(flow_def);
+    if (unlikely(flow_def_dup == NULL || col_flow_def == NULL ||
+                 row_flow_def == NULL)) {
+        uref_free(flow_def_dup);
+        uref_free(col_flow_def);
+        uref_free(row_flow_def);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+
+    upipe_rtp_fec_enc_store_flow_def(upipe, flow_def_dup);
+    upipe_rtp_fec_enc_output_store_flow_def(
+            upipe_rtp_fec_enc_output_to_upipe(&upipe_rtp_fec_enc->col_output),
+            col_flow_def);
+    upipe_rtp_fec_enc_output_store_flow_def(
+            upipe_rtp_fec_enc_output_to_upipe(&upipe_rtp_fec_enc->row_output),
+            row_flow_def);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the size of the FEC matrix.
+ *
+ * @param upipe description structure of the pipe
+ * @param cols number of columns (L)
+ * @param rows number of rows (D)
+ * @return an error code
+ */
+static int _upipe_rtp_fec_enc_set_matrix(struct upipe *upipe,
+                                         unsigned int cols, unsigned int rows)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+
+    if (cols < 1 || cols > FEC_COLS_MAX ||
+        rows < FEC_ROWS_MIN || rows > FEC_ROWS_MAX ||
+        cols * rows > FEC_MATRIX_MAX) {
+        upipe_err_va(upipe, "invalid FEC matrix %ux%u", cols, rows);
+        return UBASE_ERR_INVALID;
+    }
+
+    upipe_rtp_fec_enc->cols = cols;
+    upipe_rtp_fec_enc->rows = rows;
+    upipe_rtp_fec_enc->snbase = UINT32_MAX;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a FEC output subpipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_output_control(struct upipe *upipe,
+                                            int command, va_list args)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_sub_mgr(upipe->mgr);
+
+    UBASE_HANDLED_RETURN(
+        upipe_rtp_fec_enc_output_control_output(upipe, command, args));
+    switch (command) {
+    case UPIPE_SUB_GET_SUPER: {
+        struct upipe **p = va_arg(args, struct upipe **);
+        *p = upipe_rtp_fec_enc_to_upipe(upipe_rtp_fec_enc);
+        return UBASE_ERR_NONE;
+    }
+
+    default:
+        return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This initializes a FEC output subpipe.
+ *
+ * @param upipe_rtp_fec_enc private context of the super pipe
+ * @param output private context of the subpipe
+ * @param uprobe structure used to raise events by the subpipe
+ */
+static void upipe_rtp_fec_enc_output_init(
+        struct upipe_rtp_fec_enc *upipe_rtp_fec_enc,
+        struct upipe_rtp_fec_enc_output *output, struct uprobe *uprobe)
+{
+    struct upipe *upipe = upipe_rtp_fec_enc_output_to_upipe(output);
+    upipe_init(upipe, &upipe_rtp_fec_enc->sub_mgr, uprobe);
+    upipe->refcount = upipe_rtp_fec_enc_to_urefcount(upipe_rtp_fec_enc);
+    upipe_rtp_fec_enc_output_init_output(upipe);
+    output->seqnum = 0;
+
+    upipe_throw_ready(upipe);
+}
+
+/** @internal @This cleans a FEC output subpipe.
+ *
+ * @param output private context of the subpipe
+ */
+static void upipe_rtp_fec_enc_output_clean(
+        struct upipe_rtp_fec_enc_output *output)
+{
+    struct upipe *upipe = upipe_rtp_fec_enc_output_to_upipe(output);
+    upipe_throw_dead(upipe);
+    upipe_rtp_fec_enc_output_clean_output(upipe);
+    upipe_clean(upipe);
+}
+
+/** @internal @This initializes the manager of the FEC output subpipes.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_fec_enc_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_rtp_fec_enc->sub_mgr;
+
+    upipe_mgr_init(sub_mgr);
+    sub_mgr->signature = UPIPE_RTP_FEC_ENC_OUTPUT_SIGNATURE;
+    sub_mgr->upipe_control = upipe_rtp_fec_enc_output_control;
+}
+
+/** @internal @This allocates a rtp fec enc pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *_upipe_rtp_fec_enc_alloc(struct upipe_mgr *mgr,
+                                              struct uprobe *uprobe,
+                                              uint32_t signature,
+                                              va_list args)
+{
+    if (signature != UPIPE_RTP_FEC_ENC_SIGNATURE)
+        return NULL;
+    struct uprobe *uprobe_col = va_arg(args, struct uprobe *);
+    struct uprobe *uprobe_row = va_arg(args, struct uprobe *);
+
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        calloc(1, sizeof(struct upipe_rtp_fec_enc));
+    if (unlikely(upipe_rtp_fec_enc == NULL)) {
+        uprobe_release(uprobe);
+        uprobe_release(uprobe_col);
+        uprobe_release(uprobe_row);
+        return NULL;
+    }
+
+    struct upipe *upipe = upipe_rtp_fec_enc_to_upipe(upipe_rtp_fec_enc);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_rtp_fec_enc_init_urefcount(upipe);
+    upipe_rtp_fec_enc_init_output(upipe);
+    upipe_rtp_fec_enc_init_sub_mgr(upipe);
+
+    upipe_rtp_fec_enc->cols = DEFAULT_COLS;
+    upipe_rtp_fec_enc->rows = DEFAULT_ROWS;
+    upipe_rtp_fec_enc->snbase = UINT32_MAX;
+    upipe_rtp_fec_enc->next_seqnum = 0;
+
+    upipe_rtp_fec_enc_output_init(upipe_rtp_fec_enc,
+                                  &upipe_rtp_fec_enc->col_output, uprobe_col);
+    upipe_rtp_fec_enc_output_init(upipe_rtp_fec_enc,
+                                  &upipe_rtp_fec_enc->row_output, uprobe_row);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This processes control commands on a rtp fec enc pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_rtp_fec_enc_control(struct upipe *upipe,
+                                     int command, va_list args)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+
+    UBASE_HANDLED_RETURN(
+        upipe_rtp_fec_enc_control_output(upipe, command, args));
+    switch (command) {
+    case UPIPE_SET_FLOW_DEF: {
+        struct uref *flow_def = va_arg(args, struct uref *);
+        return upipe_rtp_fec_enc_set_flow_def(upipe, flow_def);
+    }
+
+    case UPIPE_RTP_FEC_ENC_GET_COL_SUB: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+        struct upipe **upipe_p = va_arg(args, struct upipe **);
+        *upipe_p = upipe_rtp_fec_enc_output_to_upipe(
+                &upipe_rtp_fec_enc->col_output);
+        return UBASE_ERR_NONE;
+    }
+    case UPIPE_RTP_FEC_ENC_GET_ROW_SUB: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+        struct upipe **upipe_p = va_arg(args, struct upipe **);
+        *upipe_p = upipe_rtp_fec_enc_output_to_upipe(
+                &upipe_rtp_fec_enc->row_output);
+        return UBASE_ERR_NONE;
+    }
+    case UPIPE_RTP_FEC_ENC_SET_MATRIX: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+        unsigned int cols = va_arg(args, unsigned int);
+        unsigned int rows = va_arg(args, unsigned int);
+        return _upipe_rtp_fec_enc_set_matrix(upipe, cols, rows);
+    }
+    case UPIPE_RTP_FEC_ENC_GET_MATRIX: {
+        UBASE_SIGNATURE_CHECK(args, UPIPE_RTP_FEC_ENC_SIGNATURE)
+        unsigned int *cols_p = va_arg(args, unsigned int *);
+        unsigned int *rows_p = va_arg(args, unsigned int *);
+        if (cols_p != NULL)
+            *cols_p = upipe_rtp_fec_enc->cols;
+        if (rows_p != NULL)
+            *rows_p = upipe_rtp_fec_enc->rows;
+        return UBASE_ERR_NONE;
+    }
+
+    default:
+        return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_rtp_fec_enc_free(struct upipe *upipe)
+{
+    struct upipe_rtp_fec_enc *upipe_rtp_fec_enc =
+        upipe_rtp_fec_enc_from_upipe(upipe);
+
+    upipe_rtp_fec_enc_output_clean(&upipe_rtp_fec_enc->col_output);
+    upipe_rtp_fec_enc_output_clean(&upipe_rtp_fec_enc->row_output);
+
+    upipe_throw_dead(upipe);
+
+    upipe_rtp_fec_enc_clean_output(upipe);
+    upipe_rtp_fec_enc_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_rtp_fec_enc);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_rtp_fec_enc_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_RTP_FEC_ENC_SIGNATURE,
+
+    .upipe_alloc = _upipe_rtp_fec_enc_alloc,
+    .upipe_input = upipe_rtp_fec_enc_input,
+    .upipe_control = upipe_rtp_fec_enc_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for rtp fec enc pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_rtp_fec_enc_mgr_alloc(void)
+{
+    return &upipe_rtp_fec_enc_mgr;
+}
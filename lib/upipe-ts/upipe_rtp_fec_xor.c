@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe multi-source XOR kernels for SMPTE 2022-1 FEC recovery
+ *
+ * The destination is processed in chunks of several vectors, into which
+ * the matching chunks of all sources are xored before the chunk is stored
+ * back, so that the recovery of a packet from a whole FEC row or column
+ * does a single pass over the destination.
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ucpu.h"
+#include "upipe_rtp_fec_xor.h"
+
+#include <string.h>
+
+#ifdef UPIPE_RTP_FEC_XOR_X86
+#include <immintrin.h>
+#endif
+#ifdef UPIPE_RTP_FEC_XOR_NEON
+#include <arm_neon.h>
+#endif
+
+/** @internal @This xors the last octets of several source buffers into a
+ * destination buffer, one octet at a time.
+ *
+ * @param dst destination buffer, also the first operand
+ * @param srcs array of pointers to the source buffers
+ * @param nb_srcs number of source buffers
+ * @param i offset of the first octet to process
+ * @param len size of each buffer
+ */
+static inline void upipe_rtp_fec_xor_bytes(uint8_t *dst,
+                                           const uint8_t *const *srcs,
+                                           unsigned int nb_srcs,
+                                           uintptr_t i, uintptr_t len)
+{
+    for (; i < len; i++) {
+        uint8_t acc = dst[i];
+        for (unsigned int k = 0; k < nb_srcs; k++)
+            acc ^= srcs[k][i];
+        dst[i] = acc;
+    }
+}
+
+/** @This xors several source buffers into a destination buffer with the
+ * reference implementation.
+ *
+ * @param dst destination buffer, also the first operand
+ * @param srcs array of pointers to the source buffers
+ * @param nb_srcs number of source buffers
+ * @param len number of octets to process in each buffer
+ */
+void upipe_rtp_fec_xor_c(uint8_t *dst, const uint8_t *const *srcs,
+                         unsigned int nb_srcs, uintptr_t len)
+{
+    uintptr_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t acc, word;
+        memcpy(&acc, dst + i, sizeof(acc));
+        for (unsigned int k = 0; k < nb_srcs; k++) {
+            memcpy(&word, srcs[k] + i, sizeof(word));
+            acc ^= word;
+        }
+        memcpy(dst + i, &acc, sizeof(acc));
+    }
+    upipe_rtp_fec_xor_bytes(dst, srcs, nb_srcs, i, len);
+}
+
+#ifdef UPIPE_RTP_FEC_XOR_X86
+/** @This xors several source buffers into a destination buffer with SSE2.
+ *
+ * @param dst destination buffer, also the first operand
+ * @param srcs array of pointers to the source buffers
+ * @param nb_srcs number of source buffers
+ * @param len number of octets to process in each buffer
+ */
+__attribute__((target("sse2")))
+void upipe_rtp_fec_xor_sse2(uint8_t *dst, const uint8_t *const *srcs,
+                            unsigned int nb_srcs, uintptr_t len)
+{
+    uintptr_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(dst + i + 16));
+        __m128i a2 = _mm_loadu_si128((const __m128i *)(dst + i + 32));
+        __m128i a3 = _mm_loadu_si128((const __m128i *)(dst + i + 48));
+        for (unsigned int k = 0; k < nb_srcs; k++) {
+            const uint8_t *src = srcs[k] + i;
+            a0 = _mm_xor_si128(a0, _mm_loadu_si128((const __m128i *)src));
+            a1 = _mm_xor_si128(a1,
+                    _mm_loadu_si128((const __m128i *)(src + 16)));
+            a2 = _mm_xor_si128(a2,
+                    _mm_loadu_si128((const __m128i *)(src + 32)));
+            a3 = _mm_xor_si128(a3,
+                    _mm_loadu_si128((const __m128i *)(src + 48)));
+        }
+        _mm_storeu_si128((__m128i *)(dst + i), a0);
+        _mm_storeu_si128((__m128i *)(dst + i + 16), a1);
+        _mm_storeu_si128((__m128i *)(dst + i + 32), a2);
+        _mm_storeu_si128((__m128i *)(dst + i + 48), a3);
+    }
+    for (; i + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        for (unsigned int k = 0; k < nb_srcs; k++)
+            a = _mm_xor_si128(a,
+                    _mm_loadu_si128((const __m128i *)(srcs[k] + i)));
+        _mm_storeu_si128((__m128i *)(dst + i), a);
+    }
+    upipe_rtp_fec_xor_bytes(dst, srcs, nb_srcs, i, len);
+}
+
+/** @This xors several source buffers into a destination buffer with AVX2.
+ *
+ * @param dst destination buffer, also the first operand
+ * @param srcs array of pointers to the source buffers
+ * @param nb_srcs number of source buffers
+ * @param len number of octets to process in each buffer
+ */
+__attribute__((target("avx2")))
+void upipe_rtp_fec_xor_avx2(uint8_t *dst, const uint8_t *const *srcs,
+                            unsigned int nb_srcs, uintptr_t len)
+{
+    uintptr_t i = 0;
+    for (; i + 128 <= len; i += 128) {
+        __m256i a0 = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i a1 = _mm256_loadu_si256((const __m256i *)(dst + i + 32));
+        __m256i a2 = _mm256_loadu_si256((const __m256i *)(dst + i + 64));
+        __m256i a3 = _mm256_loadu_si256((const __m256i *)(dst + i + 96));
+        for (unsigned int k = 0; k < nb_srcs; k++) {
+            const uint8_t *src = srcs[k] + i;
+            a0 = _mm256_xor_si256(a0,
+                    _mm256_loadu_si256((const __m256i *)src));
+            a1 = _mm256_xor_si256(a1,
+                    _mm256_loadu_si256((const __m256i *)(src + 32)));
+            a2 = _mm256_xor_si256(a2,
+                    _mm256_loadu_si256((const __m256i *)(src + 64)));
+            a3 = _mm256_xor_si256(a3,
+                    _mm256_loadu_si256((const __m256i *)(src + 96)));
+        }
+        _mm256_storeu_si256((__m256i *)(dst + i), a0);
+        _mm256_storeu_si256((__m256i *)(dst + i + 32), a1);
+        _mm256_storeu_si256((__m256i *)(dst + i + 64), a2);
+        _mm256_storeu_si256((__m256i *)(dst + i + 96), a3);
+    }
+    for (; i + 32 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        for (unsigned int k = 0; k < nb_srcs; k++)
+            a = _mm256_xor_si256(a,
+                    _mm256_loadu_si256((const __m256i *)(srcs[k] + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), a);
+    }
+    upipe_rtp_fec_xor_bytes(dst, srcs, nb_srcs, i, len);
+}
+#endif
+
+#ifdef UPIPE_RTP_FEC_XOR_NEON
+/** @This xors several source buffers into a destination buffer with NEON.
+ *
+ * @param dst destination buffer, also the first operand
+ * @param srcs array of pointers to the source buffers
+ * @param nb_srcs number of source buffers
+ * @param len number of octets to process in each buffer
+ */
+void upipe_rtp_fec_xor_neon(uint8_t *dst, const uint8_t *const *srcs,
+                            unsigned int nb_srcs, uintptr_t len)
+{
+    uintptr_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        uint8x16_t a0 = vld1q_u8(dst + i);
+        uint8x16_t a1 = vld1q_u8(dst + i + 16);
+        uint8x16_t a2 = vld1q_u8(dst + i + 32);
+        uint8x16_t a3 = vld1q_u8(dst + i + 48);
+        for (unsigned int k = 0; k < nb_srcs; k++) {
+            const uint8_t *src = srcs[k] + i;
+            a0 = veorq_u8(a0, vld1q_u8(src));
+            a1 = veorq_u8(a1, vld1q_u8(src + 16));
+            a2 = veorq_u8(a2, vld1q_u8(src + 32));
+            a3 = veorq_u8(a3, vld1q_u8(src + 48));
+        }
+        vst1q_u8(dst + i, a0);
+        vst1q_u8(dst + i + 16, a1);
+        vst1q_u8(dst + i + 32, a2);
+        vst1q_u8(dst + i + 48, a3);
+    }
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t a = vld1q_u8(dst + i);
+        for (unsigned int k = 0; k < nb_srcs; k++)
+            a = veorq_u8(a, vld1q_u8(srcs[k] + i));
+        vst1q_u8(dst + i, a);
+    }
+    upipe_rtp_fec_xor_bytes(dst, srcs, nb_srcs, i, len);
+}
+#endif
+
+/** @internal @This lists the XOR kernels, best first. */
+static const struct ucpu_impl upipe_rtp_fec_xor_impls[] = {
+#ifdef UPIPE_RTP_FEC_XOR_X86
+    UCPU_IMPL(upipe_rtp_fec_xor, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_rtp_fec_xor, sse2, UCPU_SSE2),
+#endif
+#ifdef UPIPE_RTP_FEC_XOR_NEON
+    UCPU_IMPL(upipe_rtp_fec_xor, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(upipe_rtp_fec_xor, c, 0),
+};
+
+/** XOR kernel */
+struct ucpu_kernel upipe_rtp_fec_xor_kernel =
+    UCPU_KERNEL_INIT("rtp_fec_xor", upipe_rtp_fec_xor_impls);
+
+/** @This xors several source buffers into a destination buffer, using the
+ * fastest kernel supported by the CPU.
+ *
+ * @param dst destination buffer, also the first operand
+ * @param srcs array of pointers to the source buffers
+ * @param nb_srcs number of source buffers
+ * @param len number of octets to process in each buffer
+ */
+void upipe_rtp_fec_xor(uint8_t *dst, const uint8_t *const *srcs,
+                       unsigned int nb_srcs, uintptr_t len)
+{
+    if (!nb_srcs)
+        return;
+    UCPU_KERNEL_FUNC(&upipe_rtp_fec_xor_kernel,
+                     __typeof__(&upipe_rtp_fec_xor_c))(dst, srcs, nb_srcs,
+                                                       len);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe multi-source XOR kernels for SMPTE 2022-1 FEC recovery
+ */
+
+#ifndef _UPIPE_TS_UPIPE_RTP_FEC_XOR_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_RTP_FEC_XOR_H_
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+#define UPIPE_RTP_FEC_XOR_X86
+#elif defined(__ARM_NEON)
+/** @hidden */
+#define UPIPE_RTP_FEC_XOR_NEON
+#endif
+
+/* reference implementation, one machine word at a time */
+void upipe_rtp_fec_xor_c(uint8_t *dst, const uint8_t *const *srcs,
+                         unsigned int nb_srcs, uintptr_t len);
+
+#ifdef UPIPE_RTP_FEC_XOR_X86
+/* 64 octets per iteration, requires SSE2 */
+void upipe_rtp_fec_xor_sse2(uint8_t *dst, const uint8_t *const *srcs,
+                            unsigned int nb_srcs, uintptr_t len);
+/* 128 octets per iteration, requires AVX2 */
+void upipe_rtp_fec_xor_avx2(uint8_t *dst, const uint8_t *const *srcs,
+                            unsigned int nb_srcs, uintptr_t len);
+#endif
+
+#ifdef UPIPE_RTP_FEC_XOR_NEON
+/* 64 octets per iteration */
+void upipe_rtp_fec_xor_neon(uint8_t *dst, const uint8_t *const *srcs,
+                            unsigned int nb_srcs, uintptr_t len);
+#endif
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of upipe_rtp_fec_xor, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_rtp_fec_xor_kernel;
+
+/** @This xors several source buffers into a destination buffer, using the
+ * fastest kernel supported by the CPU. Each chunk of the destination is
+ * loaded and stored once, whatever the number of sources.
+ *
+ * @param dst destination buffer, also the first operand
+ * @param srcs array of pointers to the source buffers
+ * @param nb_srcs number of source buffers
+ * @param len number of octets to process in each buffer
+ */
+void upipe_rtp_fec_xor(uint8_t *dst, const uint8_t *const *srcs,
+                       unsigned int nb_srcs, uintptr_t len);
+
+#endif
@@ -0,0 +1,694 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module analyzing a transport stream without demultiplexing it
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_flow.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe-ts/upipe_ts_analyzer.h"
+#include "upipe_ts_crc32.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
+
+/** we only accept blocks */
+#define EXPECTED_FLOW_DEF "block."
+/** number of PIDs */
+#define MAX_PIDS 8192
+/** padding PID, which is not analyzed */
+#define PADDING_PID 8191
+/** 2^33 */
+#define POW2_33 UINT64_C(8589934592)
+/** PCR values wrap around at 2^33 * 300 */
+#define PCR_WRAP (POW2_33 * 300)
+/** number of consecutive sync bytes needed to acquire sync */
+#define SYNC_ACQUIRE 5
+/** number of consecutive corrupted sync bytes losing sync */
+#define SYNC_LOSE 2
+/** maximum interval between PAT or PMT sections */
+#define PSI_INTERVAL (UCLOCK_FREQ / 2)
+/** maximum interval between PCRs */
+#define PCR_INTERVAL (UCLOCK_FREQ / 25)
+/** maximum difference between consecutive PCRs, and maximum arrival
+ * interval of a PCR PID */
+#define PCR_DISCONTINUITY (UCLOCK_FREQ / 10)
+
+/** mask of the last continuity counter in the PID state */
+#define PID_CC_MASK 0xf
+/** a packet was already received on the PID */
+#define PID_SEEN 0x10
+/** the last packet was a duplicate */
+#define PID_DUPLICATE 0x20
+/** the PID carries a PMT */
+#define PID_PMT 0x40
+/** the PID carries PCRs */
+#define PID_PCR 0x80
+
+/** @internal @This is the state of a PMT PID. */
+struct upipe_ts_analyzer_pmt {
+    /** PID */
+    uint16_t pid;
+    /** arrival time of the last section */
+    uint64_t last_sys;
+};
+
+/** @internal @This is the state of a PCR PID. */
+struct upipe_ts_analyzer_pcr {
+    /** PID */
+    uint16_t pid;
+    /** last PCR value, in 27 MHz units */
+    uint64_t last_pcr;
+    /** arrival time of the last PCR */
+    uint64_t last_sys;
+};
+
+/** @internal @This is the private context of a ts_analyzer pipe. */
+struct upipe_ts_analyzer {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** number of consecutive packets with a valid sync byte */
+    unsigned int good_sync;
+    /** number of consecutive packets with a corrupted sync byte */
+    unsigned int bad_sync;
+    /** true while the sync is lost */
+    bool sync_lost;
+
+    /** arrival time of the last PAT section */
+    uint64_t pat_last_sys;
+    /** CRC of the last parsed PAT section */
+    uint32_t pat_crc;
+    /** true if pat_crc is valid */
+    bool pat_parsed;
+    /** PMT PIDs announced by the PAT */
+    struct upipe_ts_analyzer_pmt *pmts;
+    /** number of PMT PIDs */
+    unsigned int nb_pmts;
+    /** PCR PIDs */
+    struct upipe_ts_analyzer_pcr *pcrs;
+    /** number of PCR PIDs */
+    unsigned int nb_pcrs;
+
+    /** counters */
+    struct upipe_ts_analyzer_stats stats;
+    /** state of all PIDs */
+    uint8_t pids[MAX_PIDS];
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_ts_analyzer, upipe, UPIPE_TS_ANALYZER_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_ts_analyzer, urefcount, upipe_ts_analyzer_free)
+UPIPE_HELPER_VOID(upipe_ts_analyzer)
+UPIPE_HELPER_OUTPUT(upipe_ts_analyzer, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This allocates a ts_analyzer pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_ts_analyzer_alloc(struct upipe_mgr *mgr,
+                                             struct uprobe *uprobe,
+                                             uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_ts_analyzer_alloc_void(mgr, uprobe, signature,
+                                                       args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    upipe_ts_analyzer_init_urefcount(upipe);
+    upipe_ts_analyzer_init_output(upipe);
+    upipe_ts_analyzer->good_sync = SYNC_ACQUIRE;
+    upipe_ts_analyzer->bad_sync = 0;
+    upipe_ts_analyzer->sync_lost = false;
+    upipe_ts_analyzer->pat_last_sys = UINT64_MAX;
+    upipe_ts_analyzer->pat_crc = 0;
+    upipe_ts_analyzer->pat_parsed = false;
+    upipe_ts_analyzer->pmts = NULL;
+    upipe_ts_analyzer->nb_pmts = 0;
+    upipe_ts_analyzer->pcrs = NULL;
+    upipe_ts_analyzer->nb_pcrs = 0;
+    memset(&upipe_ts_analyzer->stats, 0, sizeof(upipe_ts_analyzer->stats));
+    memset(upipe_ts_analyzer->pids, 0, sizeof(upipe_ts_analyzer->pids));
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This counts and reports an error.
+ *
+ * @param upipe description structure of the pipe
+ * @param error type of error
+ * @param pid PID of the faulty packet
+ */
+static void upipe_ts_analyzer_error(struct upipe *upipe,
+                                    enum upipe_ts_analyzer_error error,
+                                    uint16_t pid)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    upipe_ts_analyzer->stats.errors[error]++;
+    upipe_throw(upipe, UPROBE_TS_ANALYZER_ERROR, UPIPE_TS_ANALYZER_SIGNATURE,
+                (unsigned int)error, (unsigned int)pid);
+}
+
+/** @internal @This returns the state of a PMT PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID
+ * @return pointer to the state, or NULL
+ */
+static struct upipe_ts_analyzer_pmt *
+    upipe_ts_analyzer_find_pmt(struct upipe *upipe, uint16_t pid)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    for (unsigned int i = 0; i < upipe_ts_analyzer->nb_pmts; i++)
+        if (upipe_ts_analyzer->pmts[i].pid == pid)
+            return &upipe_ts_analyzer->pmts[i];
+    return NULL;
+}
+
+/** @internal @This rebuilds the list of PMT PIDs from a PAT section.
+ *
+ * @param upipe description structure of the pipe
+ * @param section PAT section
+ * @param sys arrival time of the section
+ */
+static void upipe_ts_analyzer_parse_pat(struct upipe *upipe,
+                                        const uint8_t *section, uint64_t sys)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    unsigned int nb_pmts = 0;
+    const uint8_t *program;
+    int j = 0;
+    while ((program = pat_get_program((uint8_t *)section, j++)) != NULL)
+        if (patn_get_program(program))
+            nb_pmts++;
+
+    struct upipe_ts_analyzer_pmt *pmts = NULL;
+    if (nb_pmts) {
+        pmts = malloc(nb_pmts * sizeof(struct upipe_ts_analyzer_pmt));
+        if (unlikely(pmts == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+    }
+
+    unsigned int i = 0;
+    j = 0;
+    while ((program = pat_get_program((uint8_t *)section, j++)) != NULL) {
+        if (!patn_get_program(program))
+            continue;
+        uint16_t pid = patn_get_pid(program);
+        struct upipe_ts_analyzer_pmt *pmt =
+            upipe_ts_analyzer_find_pmt(upipe, pid);
+        pmts[i].pid = pid;
+        pmts[i].last_sys = pmt != NULL ? pmt->last_sys : sys;
+        i++;
+    }
+
+    for (i = 0; i < upipe_ts_analyzer->nb_pmts; i++)
+        upipe_ts_analyzer->pids[upipe_ts_analyzer->pmts[i].pid] &= ~PID_PMT;
+    for (i = 0; i < nb_pmts; i++)
+        upipe_ts_analyzer->pids[pmts[i].pid] |= PID_PMT;
+    free(upipe_ts_analyzer->pmts);
+    upipe_ts_analyzer->pmts = pmts;
+    upipe_ts_analyzer->nb_pmts = nb_pmts;
+}
+
+/** @internal @This returns the first PSI section starting in a packet.
+ *
+ * @param ts pointer to the TS packet
+ * @param offset offset of the payload
+ * @return pointer to the section, or NULL if no section header fits
+ */
+static const uint8_t *upipe_ts_analyzer_section(const uint8_t *ts,
+                                                unsigned int offset)
+{
+    if (!ts_get_unitstart(ts) || offset >= TS_SIZE)
+        return NULL;
+    offset += 1 + ts[offset];
+    if (offset + PSI_HEADER_SIZE > TS_SIZE)
+        return NULL;
+    return ts + offset;
+}
+
+/** @internal @This checks a packet of the PAT PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param ts pointer to the TS packet
+ * @param offset offset of the payload
+ * @param sys arrival time of the packet
+ */
+static void upipe_ts_analyzer_pat(struct upipe *upipe, const uint8_t *ts,
+                                  unsigned int offset, uint64_t sys)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    if (unlikely(ts_get_scrambling(ts))) {
+        upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_PAT, 0);
+        return;
+    }
+
+    const uint8_t *section = upipe_ts_analyzer_section(ts, offset);
+    if (section == NULL)
+        return;
+    if (unlikely(psi_get_tableid(section) != PAT_TABLE_ID)) {
+        upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_PAT, 0);
+        return;
+    }
+    upipe_ts_analyzer->pat_last_sys = sys;
+
+    /* only single-packet sections are parsed */
+    unsigned int length = psi_get_length(section) + PSI_HEADER_SIZE;
+    if (section + length > ts + TS_SIZE || length < PSI_CRC_SIZE)
+        return;
+    const uint8_t *crc = section + length - PSI_CRC_SIZE;
+    uint32_t pat_crc = ((uint32_t)crc[0] << 24) | (crc[1] << 16) |
+                       (crc[2] << 8) | crc[3];
+    if (upipe_ts_analyzer->pat_parsed && pat_crc == upipe_ts_analyzer->pat_crc)
+        return;
+    if (!pat_validate(section) || !upipe_ts_psi_check_crc(section))
+        return;
+
+    upipe_ts_analyzer_parse_pat(upipe, section, sys);
+    upipe_ts_analyzer->pat_crc = pat_crc;
+    upipe_ts_analyzer->pat_parsed = true;
+}
+
+/** @internal @This checks a packet of a PMT PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID of the packet
+ * @param ts pointer to the TS packet
+ * @param offset offset of the payload
+ * @param sys arrival time of the packet
+ */
+static void upipe_ts_analyzer_pmt(struct upipe *upipe, uint16_t pid,
+                                  const uint8_t *ts, unsigned int offset,
+                                  uint64_t sys)
+{
+    if (unlikely(ts_get_scrambling(ts))) {
+        upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_PMT, pid);
+        return;
+    }
+
+    const uint8_t *section = upipe_ts_analyzer_section(ts, offset);
+    if (section == NULL)
+        return;
+    if (unlikely(psi_get_tableid(section) != PMT_TABLE_ID)) {
+        upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_PMT, pid);
+        return;
+    }
+    struct upipe_ts_analyzer_pmt *pmt = upipe_ts_analyzer_find_pmt(upipe, pid);
+    if (pmt != NULL)
+        pmt->last_sys = sys;
+}
+
+/** @internal @This checks a PCR.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID of the packet
+ * @param ts pointer to the TS packet
+ * @param discontinuity true if the discontinuity indicator is set
+ * @param sys arrival time of the packet
+ */
+static void upipe_ts_analyzer_pcr(struct upipe *upipe, uint16_t pid,
+                                  const uint8_t *ts, bool discontinuity,
+                                  uint64_t sys)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    struct upipe_ts_analyzer_pcr *pcr = NULL;
+    if (likely(upipe_ts_analyzer->pids[pid] & PID_PCR)) {
+        for (unsigned int i = 0; i < upipe_ts_analyzer->nb_pcrs; i++)
+            if (upipe_ts_analyzer->pcrs[i].pid == pid) {
+                pcr = &upipe_ts_analyzer->pcrs[i];
+                break;
+            }
+    } else {
+        struct upipe_ts_analyzer_pcr *pcrs =
+            realloc(upipe_ts_analyzer->pcrs,
+                    (upipe_ts_analyzer->nb_pcrs + 1) *
+                    sizeof(struct upipe_ts_analyzer_pcr));
+        if (unlikely(pcrs == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_ts_analyzer->pcrs = pcrs;
+        pcr = &pcrs[upipe_ts_analyzer->nb_pcrs++];
+        pcr->pid = pid;
+        pcr->last_pcr = UINT64_MAX;
+        pcr->last_sys = UINT64_MAX;
+        upipe_ts_analyzer->pids[pid] |= PID_PCR;
+    }
+    assert(pcr != NULL);
+
+    uint64_t pcrval = tsaf_get_pcr(ts) * 300 + tsaf_get_pcrext(ts);
+    if (pcr->last_pcr != UINT64_MAX && !discontinuity) {
+        uint64_t delta = (pcrval + PCR_WRAP - pcr->last_pcr) % PCR_WRAP;
+        if (delta > PCR_DISCONTINUITY)
+            upipe_ts_analyzer_error(upipe,
+                    UPIPE_TS_ANALYZER_PCR_DISCONTINUITY, pid);
+        else if (delta > PCR_INTERVAL)
+            upipe_ts_analyzer_error(upipe,
+                    UPIPE_TS_ANALYZER_PCR_REPETITION, pid);
+        else if (pcr->last_sys != UINT64_MAX && sys != UINT64_MAX) {
+            uint64_t delta_sys = sys - pcr->last_sys;
+            uint64_t jitter = delta > delta_sys ? delta - delta_sys :
+                                                  delta_sys - delta;
+            if (jitter > upipe_ts_analyzer->stats.pcr_jitter_max)
+                upipe_ts_analyzer->stats.pcr_jitter_max = jitter;
+        }
+    }
+    pcr->last_pcr = pcrval;
+    pcr->last_sys = sys;
+}
+
+/** @internal @This checks a TS packet.
+ *
+ * @param upipe description structure of the pipe
+ * @param ts pointer to the TS packet
+ * @param sys arrival time of the packet
+ */
+static void upipe_ts_analyzer_packet(struct upipe *upipe, const uint8_t *ts,
+                                     uint64_t sys)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    if (unlikely(!ts_validate(ts))) {
+        upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_SYNC_BYTE,
+                                PADDING_PID);
+        upipe_ts_analyzer->good_sync = 0;
+        if (++upipe_ts_analyzer->bad_sync >= SYNC_LOSE &&
+            !upipe_ts_analyzer->sync_lost) {
+            upipe_ts_analyzer->sync_lost = true;
+            upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_SYNC_LOSS,
+                                    PADDING_PID);
+        }
+        return;
+    }
+    upipe_ts_analyzer->bad_sync = 0;
+    if (unlikely(upipe_ts_analyzer->sync_lost) &&
+        ++upipe_ts_analyzer->good_sync >= SYNC_ACQUIRE)
+        upipe_ts_analyzer->sync_lost = false;
+
+    uint16_t pid = ts_get_pid(ts);
+    if (unlikely(ts_get_transporterror(ts))) {
+        upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_TRANSPORT, pid);
+        return;
+    }
+    if (pid == PADDING_PID)
+        return;
+
+    uint8_t state = upipe_ts_analyzer->pids[pid];
+    uint8_t cc = ts_get_cc(ts);
+    bool has_payload = ts_has_payload(ts);
+    bool discontinuity = false;
+    unsigned int offset = TS_HEADER_SIZE;
+    uint8_t af_length = 0;
+    if (ts_has_adaptation(ts)) {
+        af_length = ts_get_adaptation(ts);
+        if (unlikely(af_length > TS_SIZE - TS_HEADER_SIZE - 1))
+            af_length = TS_SIZE - TS_HEADER_SIZE - 1;
+        if (af_length)
+            discontinuity = tsaf_has_discontinuity(ts);
+        offset += 1 + af_length;
+    }
+
+    bool duplicate = false;
+    if (likely((state & PID_SEEN) && !discontinuity)) {
+        uint8_t last_cc = state & PID_CC_MASK;
+        if (!has_payload) {
+            if (unlikely(cc != last_cc))
+                upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_CC, pid);
+        } else if (unlikely(cc == last_cc)) {
+            /* a packet may be sent twice, but only twice */
+            if (state & PID_DUPLICATE)
+                upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_CC, pid);
+            else
+                duplicate = true;
+        } else if (unlikely(cc != ((last_cc + 1) & PID_CC_MASK)))
+            upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_CC, pid);
+    }
+    upipe_ts_analyzer->pids[pid] = (state & (PID_PMT | PID_PCR)) | PID_SEEN |
+                                   (duplicate ? PID_DUPLICATE : 0) | cc;
+
+    if (af_length >= TS_HEADER_SIZE_PCR - TS_HEADER_SIZE - 1 &&
+        tsaf_has_pcr(ts))
+        upipe_ts_analyzer_pcr(upipe, pid, ts, discontinuity, sys);
+
+    if (!has_payload)
+        return;
+    if (pid == PAT_PID)
+        upipe_ts_analyzer_pat(upipe, ts, offset, sys);
+    else if (state & PID_PMT)
+        upipe_ts_analyzer_pmt(upipe, pid, ts, offset, sys);
+}
+
+/** @internal @This checks the repetition of the tables and PCRs, after
+ * a block was analyzed.
+ *
+ * @param upipe description structure of the pipe
+ * @param sys arrival time of the block
+ */
+static void upipe_ts_analyzer_check_timeouts(struct upipe *upipe, uint64_t sys)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    if (upipe_ts_analyzer->pat_last_sys == UINT64_MAX)
+        upipe_ts_analyzer->pat_last_sys = sys;
+    else if (sys > upipe_ts_analyzer->pat_last_sys + PSI_INTERVAL) {
+        upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_PAT, PAT_PID);
+        upipe_ts_analyzer->pat_last_sys = sys;
+    }
+
+    for (unsigned int i = 0; i < upipe_ts_analyzer->nb_pmts; i++) {
+        struct upipe_ts_analyzer_pmt *pmt = &upipe_ts_analyzer->pmts[i];
+        if (pmt->last_sys == UINT64_MAX)
+            pmt->last_sys = sys;
+        else if (sys > pmt->last_sys + PSI_INTERVAL) {
+            upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_PMT, pmt->pid);
+            pmt->last_sys = sys;
+        }
+    }
+
+    /* arrival times are only as precise as the network, so PCR PIDs
+     * are only reported here when they stop entirely */
+    for (unsigned int i = 0; i < upipe_ts_analyzer->nb_pcrs; i++) {
+        struct upipe_ts_analyzer_pcr *pcr = &upipe_ts_analyzer->pcrs[i];
+        if (pcr->last_sys != UINT64_MAX &&
+            sys > pcr->last_sys + PCR_DISCONTINUITY) {
+            upipe_ts_analyzer_error(upipe, UPIPE_TS_ANALYZER_PCR_REPETITION,
+                                    pcr->pid);
+            pcr->last_sys = sys;
+            pcr->last_pcr = UINT64_MAX;
+        }
+    }
+}
+
+/** @internal @This analyzes all the TS packets of a block in a single pass
+ * over its segments, and forwards it.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_analyzer_input(struct upipe *upipe, struct uref *uref,
+                                    struct upump **upump_p)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uint64_t sys = UINT64_MAX;
+    uref_clock_get_cr_sys(uref, &sys);
+
+    size_t offset = 0;
+    while (offset + TS_SIZE <= size) {
+        const uint8_t *buffer;
+        int read_size = -1;
+        if (unlikely(!ubase_check(uref_block_read(uref, offset, &read_size,
+                                                  &buffer)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+
+        if (likely(read_size >= TS_SIZE)) {
+            int end = read_size - read_size % TS_SIZE;
+            for (int i = 0; i < end; i += TS_SIZE)
+                upipe_ts_analyzer_packet(upipe, buffer + i, sys);
+            uref_block_unmap(uref, offset);
+            upipe_ts_analyzer->stats.packets += end / TS_SIZE;
+            offset += end;
+            continue;
+        }
+
+        /* the packet spans several segments */
+        uint8_t ts[TS_SIZE];
+        uref_block_unmap(uref, offset);
+        if (unlikely(!ubase_check(uref_block_extract(uref, offset, TS_SIZE,
+                                                     ts)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_ts_analyzer_packet(upipe, ts, sys);
+        upipe_ts_analyzer->stats.packets++;
+        offset += TS_SIZE;
+    }
+
+    if (sys != UINT64_MAX)
+        upipe_ts_analyzer_check_timeouts(upipe, sys);
+    upipe_ts_analyzer_output(upipe, uref, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_ts_analyzer_set_flow_def(struct upipe *upipe,
+                                          struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    struct uref *flow_def_dup;
+    if (unlikely((flow_def_dup = uref_dup(flow_def)) == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_ts_analyzer_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a ts_analyzer pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_ts_analyzer_control(struct upipe *upipe,
+                                     int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_ts_analyzer_control_output(upipe, command, args));
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_ts_analyzer_set_flow_def(upipe, flow_def);
+        }
+
+        case UPIPE_TS_ANALYZER_GET_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ANALYZER_SIGNATURE)
+            struct upipe_ts_analyzer_stats *stats =
+                va_arg(args, struct upipe_ts_analyzer_stats *);
+            *stats = upipe_ts_analyzer->stats;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_ANALYZER_RESET_STATS: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ANALYZER_SIGNATURE)
+            memset(&upipe_ts_analyzer->stats, 0,
+                   sizeof(upipe_ts_analyzer->stats));
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_analyzer_free(struct upipe *upipe)
+{
+    struct upipe_ts_analyzer *upipe_ts_analyzer =
+        upipe_ts_analyzer_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    free(upipe_ts_analyzer->pmts);
+    free(upipe_ts_analyzer->pcrs);
+    upipe_ts_analyzer_clean_output(upipe);
+    upipe_ts_analyzer_clean_urefcount(upipe);
+    upipe_ts_analyzer_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_ts_analyzer_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_TS_ANALYZER_SIGNATURE,
+
+    .upipe_alloc = upipe_ts_analyzer_alloc,
+    .upipe_input = upipe_ts_analyzer_input,
+    .upipe_control = upipe_ts_analyzer_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all ts_analyzer pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_analyzer_mgr_alloc(void)
+{
+    return &upipe_ts_analyzer_mgr;
+}
@@ -54,6 +54,8 @@
 #define EXPECTED_FLOW_DEF "block."
 /** we only output TS packets */
 #define OUTPUT_FLOW_DEF "block.mpegts."
+/** or blocks of several TS packets in packed mode */
+#define PACKED_OUTPUT_FLOW_DEF "block.mpegts.packed."
 /** TS synchronization word */
 #define TS_SYNC 0x47
 
@@ -73,6 +75,8 @@ struct upipe_ts_check {
 
     /** TS packet size */
     size_t output_size;
+    /** true if blocks of several packets are output */
+    bool packed;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -104,6 +108,8 @@ static struct upipe *upipe_ts_check_alloc(struct upipe_mgr *mgr,
     upipe_ts_check_init_urefcount(upipe);
     upipe_ts_check_init_output(upipe);
     upipe_ts_check_init_output_size(upipe, TS_SIZE);
+    struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
+    upipe_ts_check->packed = false;
     upipe_throw_ready(upipe);
     return upipe;
 }
@@ -138,6 +144,42 @@ static bool upipe_ts_check_check(struct upipe *upipe, struct uref *uref,
     return true;
 }
 
+/** @internal @This checks the sync words of all the packets of a block,
+ * and outputs the valid packets as a single block.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param size size of the block
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_check_input_packed(struct upipe *upipe,
+                                        struct uref *uref, size_t size,
+                                        struct upump **upump_p)
+{
+    size_t offset;
+    for (offset = 0; offset + TS_SIZE <= size; offset += TS_SIZE) {
+        uint8_t word;
+        if (unlikely(!ubase_check(uref_block_extract(uref, offset, 1,
+                                                     &word)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        if (word != TS_SYNC) {
+            upipe_warn_va(upipe, "invalid TS sync 0x%"PRIx8, word);
+            break;
+        }
+    }
+
+    if (unlikely(!offset)) {
+        uref_free(uref);
+        return;
+    }
+    if (offset < size)
+        uref_block_resize(uref, 0, offset);
+    upipe_ts_check_output(upipe, uref, upump_p);
+}
+
 /** @internal @This tries to find TS packets in the buffered input urefs.
  *
  * @param upipe description structure of the pipe
@@ -155,6 +197,11 @@ static void upipe_ts_check_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
+    if (upipe_ts_check->packed && upipe_ts_check->output_size == TS_SIZE) {
+        upipe_ts_check_input_packed(upipe, uref, size, upump_p);
+        return;
+    }
+
     while (size > upipe_ts_check->output_size) {
         struct uref *next = uref_block_split(uref, upipe_ts_check->output_size);
         if (unlikely(next == NULL)) {
@@ -174,6 +221,25 @@ static void upipe_ts_check_input(struct upipe *upipe, struct uref *uref,
         upipe_ts_check_check(upipe, uref, upump_p);
 }
 
+/** @internal @This sets the attributes of the output flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def output flow definition packet
+ * @return an error code
+ */
+static int upipe_ts_check_build_flow_def(struct upipe *upipe,
+                                         struct uref *flow_def)
+{
+    struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
+    if (upipe_ts_check->packed && upipe_ts_check->output_size == TS_SIZE) {
+        uref_block_flow_delete_size(flow_def);
+        return uref_flow_set_def(flow_def, PACKED_OUTPUT_FLOW_DEF);
+    }
+    UBASE_RETURN(uref_block_flow_set_size(flow_def,
+                                          upipe_ts_check->output_size))
+    return uref_flow_set_def(flow_def, OUTPUT_FLOW_DEF);
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -191,10 +257,39 @@ static int upipe_ts_check_set_flow_def(struct upipe *upipe,
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+    if (unlikely(!ubase_check(upipe_ts_check_build_flow_def(upipe,
+                                                            flow_def_dup)))) {
+        uref_free(flow_def_dup);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_ts_check_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This enables or disables packed output.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed true to output blocks of several packets
+ * @return an error code
+ */
+static int _upipe_ts_check_set_packed(struct upipe *upipe, bool packed)
+{
     struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
-    UBASE_RETURN(uref_block_flow_set_size(flow_def_dup,
-                                          upipe_ts_check->output_size))
-    UBASE_RETURN(uref_flow_set_def(flow_def_dup, OUTPUT_FLOW_DEF))
+    if (upipe_ts_check->packed == packed)
+        return UBASE_ERR_NONE;
+    upipe_ts_check->packed = packed;
+    if (upipe_ts_check->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    struct uref *flow_def_dup = uref_dup(upipe_ts_check->flow_def);
+    if (unlikely(flow_def_dup == NULL ||
+                 !ubase_check(upipe_ts_check_build_flow_def(upipe,
+                                                            flow_def_dup)))) {
+        if (flow_def_dup != NULL)
+            uref_free(flow_def_dup);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
     upipe_ts_check_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -212,11 +307,24 @@ static int upipe_ts_check_control(struct upipe *upipe,
     UBASE_HANDLED_RETURN(upipe_ts_check_control_output(upipe, command, args));
     UBASE_HANDLED_RETURN(
         upipe_ts_check_control_output_size(upipe, command, args));
+    struct upipe_ts_check *upipe_ts_check = upipe_ts_check_from_upipe(upipe);
     switch (command) {
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_ts_check_set_flow_def(upipe, flow_def);
         }
+
+        case UPIPE_TS_CHECK_GET_PACKED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_CHECK_SIGNATURE)
+            int *packed_p = va_arg(args, int *);
+            *packed_p = upipe_ts_check->packed ? 1 : 0;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_CHECK_SET_PACKED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_CHECK_SIGNATURE)
+            int packed = va_arg(args, int);
+            return _upipe_ts_check_set_packed(upipe, !!packed);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
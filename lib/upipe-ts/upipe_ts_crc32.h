@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe MPEG-2 CRC32 kernels for PSI sections
+ */
+
+#ifndef _UPIPE_TS_UPIPE_TS_CRC32_H_
+/** @hidden */
+#define _UPIPE_TS_UPIPE_TS_CRC32_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <bitstream/mpeg/psi.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+#define UPIPE_TS_CRC32_CLMUL
+#endif
+
+/* reference implementation, one table lookup per octet */
+uint32_t upipe_ts_crc32_c(uint32_t crc, const uint8_t *buf, uintptr_t len);
+
+#ifdef UPIPE_TS_CRC32_CLMUL
+/* folds 64 octets per iteration, requires PCLMULQDQ and SSSE3 */
+uint32_t upipe_ts_crc32_clmul(uint32_t crc, const uint8_t *buf, uintptr_t len);
+#endif
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of upipe_ts_crc32, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_ts_crc32_kernel;
+
+/** @This updates an MPEG-2 CRC32 (polynomial 0x04c11db7, not reflected),
+ * using the fastest kernel supported by the CPU.
+ *
+ * @param crc current CRC, 0xffffffff for a new computation
+ * @param buf pointer to the data
+ * @param len size of the data in octets
+ * @return updated CRC
+ */
+uint32_t upipe_ts_crc32(uint32_t crc, const uint8_t *buf, uintptr_t len);
+
+/** @This computes and writes the CRC32 of a PSI section. It is equivalent
+ * to psi_set_crc.
+ *
+ * @param section pointer to the PSI section
+ */
+static inline void upipe_ts_psi_set_crc(uint8_t *section)
+{
+    uint16_t end = psi_get_length(section) + PSI_HEADER_SIZE - PSI_CRC_SIZE;
+    uint32_t crc = upipe_ts_crc32(0xffffffff, section, end);
+    section[end] = crc >> 24;
+    section[end + 1] = crc >> 16;
+    section[end + 2] = crc >> 8;
+    section[end + 3] = crc;
+}
+
+/** @This checks the CRC32 of a PSI section. It is equivalent to
+ * psi_check_crc.
+ *
+ * @param section pointer to the PSI section
+ * @return false if the CRC is invalid
+ */
+static inline bool upipe_ts_psi_check_crc(const uint8_t *section)
+{
+    uint16_t end = psi_get_length(section) + PSI_HEADER_SIZE - PSI_CRC_SIZE;
+    uint32_t crc = upipe_ts_crc32(0xffffffff, section, end);
+    return section[end] == (uint8_t)(crc >> 24) &&
+           section[end + 1] == (uint8_t)(crc >> 16) &&
+           section[end + 2] == (uint8_t)(crc >> 8) &&
+           section[end + 3] == (uint8_t)crc;
+}
+
+#endif
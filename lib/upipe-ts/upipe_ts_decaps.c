@@ -108,8 +108,8 @@ static struct upipe *upipe_ts_decaps_alloc(struct upipe_mgr *mgr,
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
  */
-static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
-                                  struct upump **upump_p)
+static void upipe_ts_decaps_work(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
 {
     struct upipe_ts_decaps *upipe_ts_decaps = upipe_ts_decaps_from_upipe(upipe);
     uint8_t buffer[TS_HEADER_SIZE];
@@ -198,6 +198,7 @@ static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
         }
         upipe_warn_va(upipe, "potentially lost 16 packets");
         upipe_ts_decaps->lost += 16;
+        upipe_throw_discontinuity(upipe, 16);
         discontinuity = true;
     }
 
@@ -206,6 +207,7 @@ static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
         int lost = (0x10 + cc - upipe_ts_decaps->last_cc - 1) & 0xf;
         upipe_ts_decaps->lost += lost;
         upipe_warn_va(upipe, "potentially lost %d packets", lost);
+        upipe_throw_discontinuity(upipe, lost);
         discontinuity = true;
     }
     upipe_ts_decaps->last_cc = cc;
@@ -229,6 +231,37 @@ static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
     upipe_ts_decaps_output(upipe, uref, upump_p);
 }
 
+/** @internal @This receives TS packets. Blocks of several packets, coming
+ * from a packed input, are broken out into individual packets here.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_decaps_input(struct upipe *upipe, struct uref *uref,
+                                  struct upump **upump_p)
+{
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+
+    while (size > TS_SIZE) {
+        struct uref *next = uref_block_split(uref, TS_SIZE);
+        if (unlikely(next == NULL)) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_ts_decaps_work(upipe, uref, upump_p);
+        size -= TS_SIZE;
+        uref = next;
+    }
+    upipe_ts_decaps_work(upipe, uref, upump_p);
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
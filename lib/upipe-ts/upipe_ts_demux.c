@@ -45,6 +45,7 @@
 #include "upipe/uref.h"
 #include "upipe/uref_flow.h"
 #include "upipe/uref_clock.h"
+#include "upipe/uref_block.h"
 #include "upipe/uclock.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
@@ -118,6 +119,8 @@
 #define EITS_TABLEIDS 16
 /** teletext frame rate */
 #define TELX_FPS 25
+/** number of SI tables which may be decoded lazily */
+#define SI_TABLES 4
 
 /** @internal @This is the private context of a ts_demux manager. */
 struct upipe_ts_demux_mgr {
@@ -272,6 +275,8 @@ struct upipe_ts_demux {
 
     /** list of PIDs carrying PSI */
     struct uchain psi_pids;
+    /** list of PSI sections seeded from a snapshot */
+    struct uchain psi_snapshot;
     /** PID of the NIT */
     uint64_t nit_pid;
     /** true if the conformance is guessed from the stream */
@@ -282,6 +287,20 @@ struct upipe_ts_demux {
     bool eit_enabled;
     /** enable EITs table ID decoder */
     bool eits_enabled;
+    /** true if ts_sync or ts_check output blocks of several packets */
+    bool packed;
+    /** index of the shard of programs exposed by the demux */
+    unsigned int shard_index;
+    /** number of shards of programs */
+    unsigned int shard_count;
+    /** inactivity timeout of SI subscriptions, or 0 if SI decoding is not
+     * lazy */
+    uint64_t si_timeout;
+    /** mask of subscribed SI tables in lazy mode */
+    unsigned int si_subscribed;
+    /** date of the last subscription of each SI table, or UINT64_MAX if no
+     * date was received since */
+    uint64_t si_lease[SI_TABLES];
 
     /** probe to get new flow events from inner pipes created by psi_pid
      * objects */
@@ -322,6 +341,19 @@ UPIPE_HELPER_VOID(upipe_ts_demux)
 UPIPE_HELPER_OUTPUT(upipe_ts_demux, output, flow_def, output_state,
                     output_request_list)
 UPIPE_HELPER_SYNC(upipe_ts_demux, acquired)
+
+/** @internal @This checks if an SI table must be decoded.
+ *
+ * @param upipe_ts_demux private structure of the pipe
+ * @param table SI table
+ * @return true if the table is subscribed or SI decoding is not lazy
+ */
+static inline bool upipe_ts_demux_si_wanted(
+        struct upipe_ts_demux *upipe_ts_demux, enum upipe_ts_demux_si table)
+{
+    return !upipe_ts_demux->si_timeout ||
+           (upipe_ts_demux->si_subscribed & table);
+}
 UPIPE_HELPER_INNER(upipe_ts_demux, input)
 UPIPE_HELPER_BIN_INPUT(upipe_ts_demux, input, input_request_list)
 UPIPE_HELPER_UREF_MGR(upipe_ts_demux, uref_mgr, uref_mgr_request, NULL,
@@ -651,6 +683,42 @@ static void
     }
 }
 
+/** @internal @This feeds the sections of the PSI snapshot matching a table
+ * into the psi_split inner pipe of a PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param psi_pid psi_pid structure
+ * @param table_id table ID of the sections
+ * @param tableidext table ID extension of the sections, or -1 for any
+ */
+static void upipe_ts_demux_psi_pid_seed(struct upipe *upipe,
+                                        struct upipe_ts_demux_psi_pid *psi_pid,
+                                        uint8_t table_id, int tableidext)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_demux->psi_snapshot, uchain) {
+        struct uref *section = uref_from_uchain(uchain);
+        uint8_t buffer[PSI_HEADER_SIZE_SYNTAX1];
+        const uint8_t *header = uref_block_peek(section, 0,
+                PSI_HEADER_SIZE_SYNTAX1, buffer);
+        if (unlikely(header == NULL))
+            continue;
+        bool match = psi_get_tableid(header) == table_id &&
+            (tableidext < 0 || psi_get_tableidext(header) == tableidext);
+        uref_block_peek_unmap(section, 0, buffer, header);
+        if (!match)
+            continue;
+
+        struct uref *uref = uref_dup(section);
+        if (unlikely(uref == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+        upipe_input(psi_pid->psi_split, uref, NULL);
+    }
+}
+
 
 /*
  * upipe_ts_demux_output structure handling (derived from upipe structure)
@@ -1338,6 +1406,7 @@ static int upipe_ts_demux_configure_eit(struct upipe *upipe,
         upipe_ts_demux_mgr_from_upipe_mgr(upipe_ts_demux_to_upipe(demux)->mgr);
 
     if (!demux->eit_enabled ||
+        !upipe_ts_demux_si_wanted(demux, UPIPE_TS_DEMUX_SI_EIT) ||
         !ubase_check(uref_ts_flow_get_eit(flow_def))) {
         if (upipe_ts_demux_program->psi_split_output_eit != NULL) {
             upipe_release(upipe_ts_demux_program->psi_split_output_eit);
@@ -1425,6 +1494,7 @@ static int upipe_ts_demux_configure_eits(struct upipe *upipe,
         upipe_ts_demux_mgr_from_upipe_mgr(upipe_ts_demux_to_upipe(demux)->mgr);
 
     if (!demux->eits_enabled ||
+        !upipe_ts_demux_si_wanted(demux, UPIPE_TS_DEMUX_SI_EIT) ||
         !ubase_check(uref_ts_flow_get_eit_schedule(flow_def))) {
         if (upipe_ts_demux_program->psi_split_output_eits[n] != NULL) {
             upipe_release(upipe_ts_demux_program->psi_split_output_eits[n]);
@@ -1542,6 +1612,29 @@ static void upipe_ts_catd_parse_bissca_descs(struct upipe *upipe,
     uref_ts_flow_set_cat_esid_n(flow_def, esid_n);
 }
 
+/** @internal @This starts or stops the EIT decoders of a program after a
+ * change of SI subscriptions.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_demux_program_update_eit(struct upipe *upipe)
+{
+    struct upipe_ts_demux_program *upipe_ts_demux_program =
+        upipe_ts_demux_program_from_upipe(upipe);
+    struct uref *flow_def;
+    if (upipe_ts_demux_program->pmtd == NULL ||
+        !ubase_check(upipe_get_flow_def(upipe_ts_demux_program->pmtd,
+                                        &flow_def)) ||
+        flow_def == NULL)
+        return;
+
+    if (!ubase_check(upipe_ts_demux_configure_eit(upipe, flow_def)))
+        return;
+    for (uint8_t n = 0; n < EITS_TABLEIDS; n++)
+        if (!ubase_check(upipe_ts_demux_configure_eits(upipe, flow_def, n)))
+            return;
+}
+
 /** @internal @This catches new_flow_def events coming from pmtd inner pipe.
  *
  * @param upipe description structure of the pipe
@@ -2119,6 +2212,9 @@ static struct upipe *upipe_ts_demux_program_alloc(struct upipe_mgr *mgr,
         return upipe;
     }
     upipe_ts_demux_program_build_flow_def(upipe);
+    upipe_ts_demux_psi_pid_seed(upipe_ts_demux_to_upipe(demux),
+                                upipe_ts_demux_program->psi_pid_pmt,
+                                PMT_TABLE_ID, upipe_ts_demux_program->program);
 
     return upipe;
 }
@@ -2306,6 +2402,9 @@ static int upipe_ts_demux_build_pat_programs(struct upipe *upipe)
         uint64_t program_number;
         if (unlikely(!ubase_check(uref_flow_get_id(program, &program_number))))
             continue;
+        if (program_number % upipe_ts_demux->shard_count !=
+            upipe_ts_demux->shard_index)
+            continue;
 
         struct uref *uref = NULL;
         if (upipe_ts_demux->sdtd != NULL) {
@@ -2459,7 +2558,8 @@ static int upipe_ts_demux_psim_probe(struct uprobe *uprobe, struct upipe *psim,
 static void upipe_ts_demux_update_nit(struct upipe *upipe)
 {
     struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
-    if (upipe_ts_demux->conformance != UPIPE_TS_CONFORMANCE_DVB) {
+    if (upipe_ts_demux->conformance != UPIPE_TS_CONFORMANCE_DVB ||
+        !upipe_ts_demux_si_wanted(upipe_ts_demux, UPIPE_TS_DEMUX_SI_NIT)) {
         if (upipe_ts_demux->psi_split_output_nit != NULL) {
             upipe_release(upipe_ts_demux->psi_split_output_nit);
             upipe_ts_demux->psi_split_output_nit = NULL;
@@ -2533,7 +2633,8 @@ static void upipe_ts_demux_update_nit(struct upipe *upipe)
 static void upipe_ts_demux_update_sdt(struct upipe *upipe)
 {
     struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
-    if (upipe_ts_demux->conformance != UPIPE_TS_CONFORMANCE_DVB) {
+    if (upipe_ts_demux->conformance != UPIPE_TS_CONFORMANCE_DVB ||
+        !upipe_ts_demux_si_wanted(upipe_ts_demux, UPIPE_TS_DEMUX_SI_SDT)) {
         if (upipe_ts_demux->psi_split_output_sdt != NULL) {
             upipe_release(upipe_ts_demux->psi_split_output_sdt);
             upipe_ts_demux->psi_split_output_sdt = NULL;
@@ -2596,8 +2697,12 @@ static void upipe_ts_demux_update_sdt(struct upipe *upipe)
                    ts_demux_mgr->ts_sdtd_mgr,
                    uprobe_pfx_alloc(uprobe_use(&upipe_ts_demux->sdtd_probe),
                                     UPROBE_LOG_VERBOSE, "sdtd"));
-    if (unlikely(upipe_ts_demux->sdtd == NULL))
+    if (unlikely(upipe_ts_demux->sdtd == NULL)) {
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    upipe_ts_demux_psi_pid_seed(upipe, upipe_ts_demux->psi_pid_sdt,
+                                SDT_TABLE_ID_ACTUAL, -1);
 }
 
 /** @internal @This updates the TDT decoder.
@@ -2607,7 +2712,8 @@ static void upipe_ts_demux_update_sdt(struct upipe *upipe)
 static void upipe_ts_demux_update_tdt(struct upipe *upipe)
 {
     struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
-    if (upipe_ts_demux->conformance != UPIPE_TS_CONFORMANCE_DVB) {
+    if (upipe_ts_demux->conformance != UPIPE_TS_CONFORMANCE_DVB ||
+        !upipe_ts_demux_si_wanted(upipe_ts_demux, UPIPE_TS_DEMUX_SI_TDT)) {
         if (upipe_ts_demux->psi_split_output_tdt != NULL) {
             upipe_release(upipe_ts_demux->psi_split_output_tdt);
             upipe_ts_demux->psi_split_output_tdt = NULL;
@@ -2761,6 +2867,56 @@ static void upipe_ts_demux_conformance_change(struct upipe *upipe,
     upipe_ts_demux_update_tdt(upipe);
 }
 
+/** @internal @This starts or stops the SI decoders after a change of SI
+ * subscriptions.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_demux_update_si(struct upipe *upipe)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    upipe_ts_demux_update_nit(upipe);
+    upipe_ts_demux_update_sdt(upipe);
+    upipe_ts_demux_update_tdt(upipe);
+    upipe_ts_demux_build_flow_def(upipe);
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_demux->programs, uchain) {
+        struct upipe_ts_demux_program *program =
+            upipe_ts_demux_program_from_uchain(uchain);
+        upipe_ts_demux_program_update_eit(
+                upipe_ts_demux_program_to_upipe(program));
+    }
+}
+
+/** @internal @This expires the SI subscriptions which were not renewed
+ * within the timeout.
+ *
+ * @param upipe description structure of the pipe
+ * @param cr_sys date of the incoming packet
+ */
+static void upipe_ts_demux_expire_si(struct upipe *upipe, uint64_t cr_sys)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    unsigned int expired = 0;
+    for (int i = 0; i < SI_TABLES; i++) {
+        if (!(upipe_ts_demux->si_subscribed & (1 << i)))
+            continue;
+        if (upipe_ts_demux->si_lease[i] == UINT64_MAX ||
+            upipe_ts_demux->si_lease[i] > cr_sys)
+            upipe_ts_demux->si_lease[i] = cr_sys;
+        else if (cr_sys - upipe_ts_demux->si_lease[i] >
+                 upipe_ts_demux->si_timeout)
+            expired |= 1 << i;
+    }
+    if (likely(!expired))
+        return;
+
+    upipe_dbg_va(upipe, "SI subscriptions 0x%x expired", expired);
+    upipe_ts_demux->si_subscribed &= ~expired;
+    upipe_ts_demux_update_si(upipe);
+}
+
 /** @internal @This tries to guess the conformance of the stream from the
  * information that is available to us.
  *
@@ -2977,6 +3133,10 @@ static int upipe_ts_demux_catd_probe(struct uprobe *uprobe,
             if (upipe_ts_demux->private_key)
                 upipe_ts_emmd_set_private_key(upipe_ts_demux->emmd,
                         upipe_ts_demux->private_key);
+            /* keep RSA decryption off the demux thread */
+            if (!ubase_check(upipe_ts_emmd_set_async(upipe_ts_demux->emmd,
+                                                     true)))
+                upipe_warn(upipe, "EMM decryption is synchronous");
 #endif
             uref_free(flow_def);
 
@@ -3182,10 +3342,18 @@ static struct upipe *upipe_ts_demux_alloc(struct upipe_mgr *mgr,
     upipe_ts_demux->private_key = NULL;
 
     ulist_init(&upipe_ts_demux->psi_pids);
+    ulist_init(&upipe_ts_demux->psi_snapshot);
     upipe_ts_demux->conformance = UPIPE_TS_CONFORMANCE_DVB_NO_TABLES;
     upipe_ts_demux->auto_conformance = true;
     upipe_ts_demux->eit_enabled = true;
     upipe_ts_demux->eits_enabled = true;
+    upipe_ts_demux->packed = false;
+    upipe_ts_demux->shard_index = 0;
+    upipe_ts_demux->shard_count = 1;
+    upipe_ts_demux->si_timeout = 0;
+    upipe_ts_demux->si_subscribed = 0;
+    for (int i = 0; i < SI_TABLES; i++)
+        upipe_ts_demux->si_lease[i] = UINT64_MAX;
     upipe_ts_demux->nit_pid = 0;
     upipe_ts_demux->flow_def_input = NULL;
 
@@ -3369,6 +3537,10 @@ static int upipe_ts_demux_set_flow_def(struct upipe *upipe,
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             return UBASE_ERR_ALLOC;
         }
+        if (upipe_ts_demux->packed) {
+            upipe_ts_check_set_packed(input, true);
+            upipe_ts_sync_set_packed(input, true);
+        }
         upipe_ts_demux_store_bin_input(upipe, input);
         upipe_set_output(input, upipe_ts_demux->setrap);
 
@@ -3478,6 +3650,162 @@ static int _upipe_ts_demux_set_eits_enabled(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This enables or disables packed input. In packed mode, the
+ * ts_sync or ts_check inner pipe does not split its input into individual
+ * packets; packets are only broken out by ts_decaps.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed true to enable packed input
+ * @return an error code
+ */
+static int _upipe_ts_demux_set_packed(struct upipe *upipe, bool packed)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    upipe_ts_demux->packed = packed;
+    if (upipe_ts_demux->input != NULL) {
+        /* only one of them is the actual inner pipe */
+        upipe_ts_check_set_packed(upipe_ts_demux->input, packed);
+        upipe_ts_sync_set_packed(upipe_ts_demux->input, packed);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This restricts the programs exposed by the demux to a shard.
+ *
+ * @param upipe description structure of the pipe
+ * @param index index of the shard
+ * @param count number of shards
+ * @return an error code
+ */
+static int _upipe_ts_demux_set_program_shard(struct upipe *upipe,
+                                             unsigned int index,
+                                             unsigned int count)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    if (unlikely(!count || index >= count))
+        return UBASE_ERR_INVALID;
+    upipe_ts_demux->shard_index = index;
+    upipe_ts_demux->shard_count = count;
+    return upipe_ts_demux_build_pat_programs(upipe);
+}
+
+/** @internal @This enables or disables lazy SI decoding.
+ *
+ * @param upipe description structure of the pipe
+ * @param timeout inactivity timeout of subscriptions, or 0
+ * @return an error code
+ */
+static int _upipe_ts_demux_set_si_lazy(struct upipe *upipe, uint64_t timeout)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    bool changed = !upipe_ts_demux->si_timeout != !timeout;
+    upipe_ts_demux->si_timeout = timeout;
+    if (changed)
+        upipe_ts_demux_update_si(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This subscribes to SI tables in lazy mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param tables mask of SI tables
+ * @return an error code
+ */
+static int _upipe_ts_demux_subscribe_si(struct upipe *upipe,
+                                        unsigned int tables)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    if (unlikely(tables & ~((1 << SI_TABLES) - 1)))
+        return UBASE_ERR_INVALID;
+
+    for (int i = 0; i < SI_TABLES; i++)
+        if (tables & (1 << i))
+            upipe_ts_demux->si_lease[i] = UINT64_MAX;
+    if ((upipe_ts_demux->si_subscribed | tables) ==
+            upipe_ts_demux->si_subscribed)
+        return UBASE_ERR_NONE;
+
+    upipe_ts_demux->si_subscribed |= tables;
+    if (upipe_ts_demux->si_timeout)
+        upipe_ts_demux_update_si(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This releases the sections of the PSI snapshot.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_demux_clean_psi_snapshot(struct upipe *upipe)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&upipe_ts_demux->psi_snapshot, uchain, uchain_tmp) {
+        ulist_delete(uchain);
+        uref_free(uref_from_uchain(uchain));
+    }
+}
+
+/** @internal @This seeds the demux with a snapshot of PSI sections.
+ *
+ * @param upipe description structure of the pipe
+ * @param snapshot block containing concatenated PSI sections, or NULL
+ * @return an error code
+ */
+static int _upipe_ts_demux_set_psi_snapshot(struct upipe *upipe,
+                                            struct uref *snapshot)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    upipe_ts_demux_clean_psi_snapshot(upipe);
+    if (snapshot == NULL)
+        return UBASE_ERR_NONE;
+
+    size_t size;
+    UBASE_RETURN(uref_block_size(snapshot, &size))
+    size_t offset = 0;
+    while (offset + PSI_HEADER_SIZE_SYNTAX1 <= size) {
+        uint8_t buffer[PSI_HEADER_SIZE];
+        const uint8_t *header = uref_block_peek(snapshot, offset,
+                                                PSI_HEADER_SIZE, buffer);
+        if (unlikely(header == NULL))
+            break;
+        uint8_t table_id = psi_get_tableid(header);
+        size_t section_size = PSI_HEADER_SIZE + psi_get_length(header);
+        uref_block_peek_unmap(snapshot, offset, buffer, header);
+        if (unlikely(offset + section_size > size))
+            break;
+
+        if (table_id == PAT_TABLE_ID || table_id == PMT_TABLE_ID ||
+            table_id == SDT_TABLE_ID_ACTUAL) {
+            struct uref *section = uref_dup(snapshot);
+            if (unlikely(section == NULL ||
+                         !ubase_check(uref_block_resize(section, offset,
+                                                        section_size)))) {
+                if (section != NULL)
+                    uref_free(section);
+                upipe_ts_demux_clean_psi_snapshot(upipe);
+                return UBASE_ERR_ALLOC;
+            }
+            /* stale dates must not be taken as random access points */
+            uref_clock_delete_date_sys(section);
+            ulist_add(&upipe_ts_demux->psi_snapshot, uref_to_uchain(section));
+        } else
+            upipe_warn_va(upipe, "ignoring table 0x%"PRIx8" in PSI snapshot",
+                          table_id);
+        offset += section_size;
+    }
+    if (offset != size)
+        upipe_warn(upipe, "truncated PSI snapshot");
+
+    /* the PMTs are seeded when the programs are allocated */
+    if (upipe_ts_demux->psi_pid_pat != NULL)
+        upipe_ts_demux_psi_pid_seed(upipe, upipe_ts_demux->psi_pid_pat,
+                                    PAT_TABLE_ID, -1);
+    if (upipe_ts_demux->sdtd != NULL)
+        upipe_ts_demux_psi_pid_seed(upipe, upipe_ts_demux->psi_pid_sdt,
+                                    SDT_TABLE_ID_ACTUAL, -1);
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts_demux pipe.
  *
  * @param upipe description structure of the pipe
@@ -3550,6 +3878,32 @@ static int upipe_ts_demux_control(struct upipe *upipe,
             int enabled = va_arg(args, int);
             return _upipe_ts_demux_set_eits_enabled(upipe, !!enabled);
         }
+        case UPIPE_TS_DEMUX_SET_PACKED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE);
+            int packed = va_arg(args, int);
+            return _upipe_ts_demux_set_packed(upipe, !!packed);
+        }
+        case UPIPE_TS_DEMUX_SET_PROGRAM_SHARD: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE);
+            unsigned int index = va_arg(args, unsigned int);
+            unsigned int count = va_arg(args, unsigned int);
+            return _upipe_ts_demux_set_program_shard(upipe, index, count);
+        }
+        case UPIPE_TS_DEMUX_SET_PSI_SNAPSHOT: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE);
+            struct uref *snapshot = va_arg(args, struct uref *);
+            return _upipe_ts_demux_set_psi_snapshot(upipe, snapshot);
+        }
+        case UPIPE_TS_DEMUX_SET_SI_LAZY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE);
+            uint64_t timeout = va_arg(args, uint64_t);
+            return _upipe_ts_demux_set_si_lazy(upipe, timeout);
+        }
+        case UPIPE_TS_DEMUX_SUBSCRIBE_SI: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_DEMUX_SIGNATURE);
+            unsigned int tables = va_arg(args, unsigned int);
+            return _upipe_ts_demux_subscribe_si(upipe, tables);
+        }
 
         default:
             break;
@@ -3584,9 +3938,28 @@ static void upipe_ts_demux_free(struct urefcount *urefcount_real)
     urefcount_clean(urefcount_real);
     upipe_ts_demux_clean_urefcount(upipe);
     free(upipe_ts_demux->private_key);
+    upipe_ts_demux_clean_psi_snapshot(upipe);
     upipe_ts_demux_free_void(upipe);
 }
 
+/** @internal @This receives data and forwards it to the input inner pipe,
+ * after expiring the SI subscriptions in lazy mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_demux_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    struct upipe_ts_demux *upipe_ts_demux = upipe_ts_demux_from_upipe(upipe);
+    uint64_t cr_sys;
+    if (upipe_ts_demux->si_timeout && upipe_ts_demux->si_subscribed &&
+        ubase_check(uref_clock_get_cr_sys(uref, &cr_sys)))
+        upipe_ts_demux_expire_si(upipe, cr_sys);
+    upipe_ts_demux_bin_input(upipe, uref, upump_p);
+}
+
 /** @This is called when there is no external to the pipe anymore.
  *
  * @param upipe description structure of the pipe
@@ -3821,7 +4194,7 @@ struct upipe_mgr *upipe_ts_demux_mgr_alloc(void)
     ts_demux_mgr->mgr.refcount = upipe_ts_demux_mgr_to_urefcount(ts_demux_mgr);
     ts_demux_mgr->mgr.signature = UPIPE_TS_DEMUX_SIGNATURE;
     ts_demux_mgr->mgr.upipe_alloc = upipe_ts_demux_alloc;
-    ts_demux_mgr->mgr.upipe_input = upipe_ts_demux_bin_input;
+    ts_demux_mgr->mgr.upipe_input = upipe_ts_demux_input;
     ts_demux_mgr->mgr.upipe_control = upipe_ts_demux_control;
     ts_demux_mgr->mgr.upipe_mgr_control = upipe_ts_demux_mgr_control;
     return upipe_ts_demux_mgr_to_upipe_mgr(ts_demux_mgr);
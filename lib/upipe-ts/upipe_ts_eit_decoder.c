@@ -327,6 +327,12 @@ static void upipe_ts_eitd_input(struct upipe *upipe, struct uref *uref,
     struct upipe_ts_eitd *upipe_ts_eitd = upipe_ts_eitd_from_upipe(upipe);
     assert(upipe_ts_eitd->flow_def_input != NULL);
 
+    if (upipe_ts_psid_table_repeated(upipe_ts_eitd->eit, uref)) {
+        /* Unchanged section of the current EIT. */
+        uref_free(uref);
+        return;
+    }
+
     if (!upipe_ts_eitd_table_section(upipe_ts_eitd->next_eit, uref))
         return;
 
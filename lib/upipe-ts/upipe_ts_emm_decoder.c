@@ -28,6 +28,8 @@
 #include "upipe/uref.h"
 #include "upipe/uref_flow.h"
 #include "upipe/uref_block.h"
+#include "upipe/upump.h"
+#include "upipe/ueventfd.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -36,9 +38,12 @@
 #include "upipe/upipe_helper_output.h"
 #include "upipe/upipe_helper_ubuf_mgr.h"
 #include "upipe/upipe_helper_flow_def.h"
+#include "upipe/upipe_helper_upump_mgr.h"
+#include "upipe/upipe_helper_upump.h"
 #include "upipe-ts/upipe_ts_emm_decoder.h"
 #include "upipe-ts/uref_ts_flow.h"
 #include "upipe_ts_psi_decoder.h"
+#include "upipe_ts_crc32.h"
 
 #include <bitstream/ebu/biss.h>
 
@@ -46,6 +51,7 @@
 #include <libtasn1.h>
 
 #include <sys/stat.h>
+#include <pthread.h>
 
 #include "rsa_asn1.h"
 
@@ -55,6 +61,30 @@
 /** @hidden */
 static int upipe_ts_emmd_check(struct upipe *upipe, struct uref *flow_format);
 
+/** @internal @This is a block of session data waiting for decryption. */
+struct upipe_ts_emmd_esd {
+    /** decryption error, or 0 */
+    gcry_error_t err;
+    /** encrypted, then decrypted session data */
+    uint8_t esd[256];
+};
+
+/** @internal @This is a decryption job of the EMM thread. */
+struct upipe_ts_emmd_job {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** copy of the private key, or NULL */
+    gcry_sexp_t key;
+    /** flow definition to complete with the session data */
+    struct uref *flow_def;
+    /** number of session data blocks */
+    unsigned int nb;
+    /** session data blocks */
+    struct upipe_ts_emmd_esd *esds;
+};
+
+UBASE_FROM_TO(upipe_ts_emmd_job, uchain, uchain, uchain)
+
 /** @internal @This is the private context of a ts_emmd pipe. */
 struct upipe_ts_emmd {
     /** refcount management structure */
@@ -80,6 +110,30 @@ struct upipe_ts_emmd {
     /** attributes in the sequence header */
     struct uref *flow_def_attr;
 
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** watcher retrieving the jobs completed by the EMM thread */
+    struct upump *upump_async;
+
+    /** true if RSA decryption runs in the EMM thread */
+    bool async;
+    /** EMM thread */
+    pthread_t thread;
+    /** protects the following fields, shared with the EMM thread */
+    pthread_mutex_t mutex;
+    /** signals the EMM thread, or the end of a job */
+    pthread_cond_t cond;
+    /** jobs to run */
+    struct uchain async_jobs;
+    /** completed jobs */
+    struct uchain async_done;
+    /** number of jobs not yet completed */
+    unsigned int async_nb;
+    /** true if the EMM thread must exit once idle */
+    bool async_quit;
+    /** event signaling completed jobs */
+    struct ueventfd async_event;
+
     uint8_t ekid[8];
     gcry_sexp_t key;
     asn1_node asn;
@@ -164,6 +218,8 @@ UPIPE_HELPER_UBUF_MGR(upipe_ts_emmd, ubuf_mgr, flow_format, ubuf_mgr_request,
                       upipe_ts_emmd_register_output_request,
                       upipe_ts_emmd_unregister_output_request)
 UPIPE_HELPER_FLOW_DEF(upipe_ts_emmd, flow_def_input, flow_def_attr)
+UPIPE_HELPER_UPUMP_MGR(upipe_ts_emmd, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_ts_emmd, upump_async, upump_mgr)
 
 UPIPE_HELPER_SUBPIPE(upipe_ts_emmd, upipe_ts_emmd_ecm, ecm, sub_mgr, subs, uchain)
 
@@ -218,7 +274,11 @@ static struct upipe *upipe_ts_emmd_alloc(struct upipe_mgr *mgr,
     upipe_ts_emmd_init_output(upipe);
     upipe_ts_emmd_init_ubuf_mgr(upipe);
     upipe_ts_emmd_init_flow_def(upipe);
+    upipe_ts_emmd_init_upump_mgr(upipe);
+    upipe_ts_emmd_init_upump_async(upipe);
     upipe_ts_emmd_init_sub_mgr(upipe);
+    upipe_ts_emmd->key = NULL;
+    upipe_ts_emmd->async = false;
     upipe_ts_psid_table_init(upipe_ts_emmd->emm);
     upipe_ts_psid_table_init(upipe_ts_emmd->next_emm);
     upipe_throw_ready(upipe);
@@ -240,7 +300,7 @@ static bool upipe_ts_emmd_table_validate(struct upipe *upipe)
                                                   &section))))
             return false;
 
-        if (!bissca_emm_validate(section) || !psi_check_crc(section)) {
+        if (!bissca_emm_validate(section) || !upipe_ts_psi_check_crc(section)) {
             uref_block_unmap(section_uref, 0);
             return false;
         }
@@ -710,6 +770,8 @@ static int read_rsa_private_key(struct upipe *upipe, void *pk, int pk_len)
         gcry_mpi_release(q);
     }
 
+    if (upipe_ts_emmd->key)
+        gcry_sexp_release(upipe_ts_emmd->key);
     if (gcry_sexp_build(&upipe_ts_emmd->key, NULL,
                 "(private-key (rsa (n %b) (e %b) (d %b) (p %b) (q %b) (u %b)))",
                 s[1], num[1], s[2], num[2], s[3], num[3],
@@ -754,40 +816,355 @@ static int read_rsa_file(struct upipe *upipe, const char *file)
     return 0;
 }
 
-static int decrypt(struct upipe *upipe, uint8_t *esd, size_t n)
+/** @internal @This decrypts a block of session data in place. It may be
+ * called from the EMM thread, so it must not touch the pipe.
+ *
+ * @param key private key
+ * @param esd encrypted session data
+ * @param n size of the session data
+ * @return 0, or a libgcrypt error code
+ */
+static gcry_error_t decrypt(gcry_sexp_t key, uint8_t *esd, size_t n)
 {
-    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
-    int ret = 1;
+    if (key == NULL)
+        return gcry_error(GPG_ERR_NO_SECKEY);
 
     gcry_sexp_t data;
-    if (gcry_sexp_build(&data, NULL,
+    gcry_error_t err = gcry_sexp_build(&data, NULL,
                 "(enc-val(flags oaep)(hash-algo sha256)(rsa(a %b)))",
-                n, esd)) {
-        upipe_err_va(upipe, "Could not build data sexp");
-        return ret;
-    }
+                n, esd);
+    if (err)
+        return err;
 
     gcry_sexp_t plain = NULL;
-    gcry_error_t err = gcry_pk_decrypt(&plain, data, upipe_ts_emmd->key);
+    err = gcry_pk_decrypt(&plain, data, key);
     gcry_sexp_release(data);
-    if (err) {
-        upipe_err_va(upipe, "decrypt failed (0x%x)", err);
-        return ret;
-    }
+    if (err)
+        return err;
 
     gcry_sexp_t l = gcry_sexp_find_token(plain, "value", 0);
-    size_t len;
-    const char *skd = gcry_sexp_nth_data(l, 1, &len);
-    if (len > n) {
-        upipe_err_va(upipe, "decrypted data too big (%zu > %zu", len, n);
-    } else {
+    size_t len = 0;
+    const char *skd = l != NULL ? gcry_sexp_nth_data(l, 1, &len) : NULL;
+    if (skd == NULL)
+        err = gcry_error(GPG_ERR_INV_SEXP);
+    else if (len > n)
+        err = gcry_error(GPG_ERR_TOO_LARGE);
+    else
         memcpy(esd, skd, len);
-        ret = 0;
-    }
 
+    gcry_sexp_release(l);
     gcry_sexp_release(plain);
+    return err;
+}
 
-    return ret;
+/** @internal @This allocates a decryption job.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the job, or NULL in case of allocation error
+ */
+static struct upipe_ts_emmd_job *upipe_ts_emmd_job_alloc(struct upipe *upipe)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    struct upipe_ts_emmd_job *job = malloc(sizeof(*job));
+    if (unlikely(job == NULL))
+        return NULL;
+    uchain_init(&job->uchain);
+    job->key = NULL;
+    job->flow_def = NULL;
+    job->nb = 0;
+    job->esds = NULL;
+    /* the EMM thread works on its own copy of the key */
+    if (upipe_ts_emmd->key != NULL &&
+        gcry_sexp_build(&job->key, NULL, "%S", upipe_ts_emmd->key)) {
+        free(job);
+        return NULL;
+    }
+    return job;
+}
+
+/** @internal @This frees a decryption job.
+ *
+ * @param job job to free
+ */
+static void upipe_ts_emmd_job_free(struct upipe_ts_emmd_job *job)
+{
+    if (job->key != NULL)
+        gcry_sexp_release(job->key);
+    uref_free(job->flow_def);
+    free(job->esds);
+    free(job);
+}
+
+/** @internal @This adds a block of session data to a decryption job.
+ *
+ * @param job decryption job
+ * @param emm_n pointer to the EMM_n structure
+ * @return an error code
+ */
+static int upipe_ts_emmd_job_add(struct upipe_ts_emmd_job *job,
+                                 const uint8_t *emm_n)
+{
+    struct upipe_ts_emmd_esd *esds =
+        realloc(job->esds, (job->nb + 1) * sizeof(*esds));
+    UBASE_ALLOC_RETURN(esds)
+    job->esds = esds;
+    esds[job->nb].err = 0;
+    bissca_emmn_get_esd((uint8_t *)emm_n, esds[job->nb].esd);
+    job->nb++;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This runs the RSA decryption of a job. It may be called from
+ * the EMM thread.
+ *
+ * @param job decryption job
+ */
+static void upipe_ts_emmd_job_run(struct upipe_ts_emmd_job *job)
+{
+    for (unsigned int i = 0; i < job->nb; i++)
+        job->esds[i].err = decrypt(job->key, job->esds[i].esd,
+                                   sizeof(job->esds[i].esd));
+}
+
+/** @internal @This imports the decrypted session data of a job and outputs
+ * the new flow definition. The job is freed.
+ *
+ * @param upipe description structure of the pipe
+ * @param job completed job
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_emmd_job_complete(struct upipe *upipe,
+                                       struct upipe_ts_emmd_job *job,
+                                       struct upump **upump_p)
+{
+    for (unsigned int i = 0; i < job->nb; i++) {
+        const uint8_t *esd = job->esds[i].esd;
+        if (job->esds[i].err) {
+            upipe_err_va(upipe, "decryption failed (0x%x)", job->esds[i].err);
+            continue;
+        }
+
+        upipe_ts_emmd_parse_sd_descs(upipe, job->flow_def,
+                &esd[DESCS_HEADER_SIZE], descs_get_length(esd));
+    }
+
+    struct uref *flow_def = upipe_ts_emmd_store_flow_def_attr(upipe,
+                                                              job->flow_def);
+    job->flow_def = NULL;
+    upipe_ts_emmd_job_free(job);
+    if (unlikely(flow_def == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    upipe_ts_emmd_store_flow_def(upipe, flow_def);
+    /* Force sending flow def */
+    upipe_ts_emmd_output(upipe, NULL, upump_p);
+}
+
+/** @internal @This is the EMM thread. It runs the queued decryption jobs.
+ *
+ * @param arg pointer to the private structure of the pipe
+ * @return NULL
+ */
+static void *upipe_ts_emmd_thread(void *arg)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = arg;
+
+    pthread_mutex_lock(&upipe_ts_emmd->mutex);
+    for ( ; ; ) {
+        struct uchain *uchain = ulist_pop(&upipe_ts_emmd->async_jobs);
+        if (uchain == NULL) {
+            if (upipe_ts_emmd->async_quit)
+                break;
+            pthread_cond_wait(&upipe_ts_emmd->cond, &upipe_ts_emmd->mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&upipe_ts_emmd->mutex);
+
+        upipe_ts_emmd_job_run(upipe_ts_emmd_job_from_uchain(uchain));
+
+        pthread_mutex_lock(&upipe_ts_emmd->mutex);
+        ulist_add(&upipe_ts_emmd->async_done, uchain);
+        upipe_ts_emmd->async_nb--;
+        pthread_cond_broadcast(&upipe_ts_emmd->cond);
+        ueventfd_write(&upipe_ts_emmd->async_event);
+    }
+    pthread_mutex_unlock(&upipe_ts_emmd->mutex);
+    return NULL;
+}
+
+/** @internal @This completes the jobs run by the EMM thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_emmd_collect_async(struct upipe *upipe,
+                                        struct upump **upump_p)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    struct uchain jobs;
+    ulist_init(&jobs);
+
+    pthread_mutex_lock(&upipe_ts_emmd->mutex);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&upipe_ts_emmd->async_done)) != NULL)
+        ulist_add(&jobs, uchain);
+    pthread_mutex_unlock(&upipe_ts_emmd->mutex);
+
+    while ((uchain = ulist_pop(&jobs)) != NULL)
+        upipe_ts_emmd_job_complete(upipe,
+                upipe_ts_emmd_job_from_uchain(uchain), upump_p);
+}
+
+/** @internal @This waits for the EMM thread to run all queued jobs, and
+ * completes them.
+ *
+ * @param upipe description structure of the pipe
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_emmd_wait_async(struct upipe *upipe,
+                                     struct upump **upump_p)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    pthread_mutex_lock(&upipe_ts_emmd->mutex);
+    while (upipe_ts_emmd->async_nb)
+        pthread_cond_wait(&upipe_ts_emmd->cond, &upipe_ts_emmd->mutex);
+    pthread_mutex_unlock(&upipe_ts_emmd->mutex);
+    ueventfd_read(&upipe_ts_emmd->async_event);
+
+    upipe_ts_emmd_collect_async(upipe, upump_p);
+}
+
+/** @internal @This is called when the EMM thread completes a job.
+ *
+ * @param upump description structure of the watcher
+ */
+static void upipe_ts_emmd_watcher_async(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    ueventfd_read(&upipe_ts_emmd->async_event);
+    upipe_ts_emmd_collect_async(upipe, &upipe_ts_emmd->upump_async);
+}
+
+/** @internal @This allocates the watcher retrieving the jobs completed by
+ * the EMM thread, if an upump manager is available.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_emmd_poll_async(struct upipe *upipe)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    if (!upipe_ts_emmd->async || upipe_ts_emmd->upump_async != NULL ||
+        !ubase_check(upipe_ts_emmd_check_upump_mgr(upipe)))
+        return;
+
+    struct upump *upump = ueventfd_upump_alloc(&upipe_ts_emmd->async_event,
+            upipe_ts_emmd->upump_mgr, upipe_ts_emmd_watcher_async, upipe,
+            upipe->refcount);
+    if (unlikely(upump == NULL)) {
+        upipe_err(upipe, "can't create watcher");
+        upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+        return;
+    }
+    upipe_ts_emmd_set_upump_async(upipe, upump);
+    upump_start(upump);
+}
+
+/** @internal @This submits a decryption job, either to the EMM thread or
+ * synchronously.
+ *
+ * @param upipe description structure of the pipe
+ * @param job decryption job
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_emmd_push_job(struct upipe *upipe,
+                                   struct upipe_ts_emmd_job *job,
+                                   struct upump **upump_p)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    if (!upipe_ts_emmd->async || !job->nb) {
+        upipe_ts_emmd_job_run(job);
+        upipe_ts_emmd_job_complete(upipe, job, upump_p);
+        return;
+    }
+
+    upipe_ts_emmd_poll_async(upipe);
+
+    pthread_mutex_lock(&upipe_ts_emmd->mutex);
+    ulist_add(&upipe_ts_emmd->async_jobs, &job->uchain);
+    upipe_ts_emmd->async_nb++;
+    pthread_cond_broadcast(&upipe_ts_emmd->cond);
+    pthread_mutex_unlock(&upipe_ts_emmd->mutex);
+
+    if (upipe_ts_emmd->upump_async == NULL)
+        /* no event loop to retrieve the results */
+        upipe_ts_emmd_wait_async(upipe, upump_p);
+}
+
+/** @internal @This starts the EMM thread.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_ts_emmd_start_async(struct upipe *upipe)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    if (upipe_ts_emmd->async)
+        return UBASE_ERR_NONE;
+
+    if (unlikely(!ueventfd_init(&upipe_ts_emmd->async_event, false)))
+        return UBASE_ERR_EXTERNAL;
+    pthread_mutex_init(&upipe_ts_emmd->mutex, NULL);
+    pthread_cond_init(&upipe_ts_emmd->cond, NULL);
+    ulist_init(&upipe_ts_emmd->async_jobs);
+    ulist_init(&upipe_ts_emmd->async_done);
+    upipe_ts_emmd->async_nb = 0;
+    upipe_ts_emmd->async_quit = false;
+
+    if (unlikely(pthread_create(&upipe_ts_emmd->thread, NULL,
+                                upipe_ts_emmd_thread, upipe_ts_emmd) != 0)) {
+        upipe_err(upipe, "can't create EMM thread");
+        pthread_cond_destroy(&upipe_ts_emmd->cond);
+        pthread_mutex_destroy(&upipe_ts_emmd->mutex);
+        ueventfd_clean(&upipe_ts_emmd->async_event);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_ts_emmd->async = true;
+    upipe_ts_emmd_poll_async(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This stops the EMM thread once it has run all queued jobs.
+ * The completed jobs are output, or discarded if the pipe is being freed.
+ *
+ * @param upipe description structure of the pipe
+ * @param discard true to discard the completed jobs
+ */
+static void upipe_ts_emmd_stop_async(struct upipe *upipe, bool discard)
+{
+    struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
+    if (!upipe_ts_emmd->async)
+        return;
+
+    upipe_ts_emmd_set_upump_async(upipe, NULL);
+    pthread_mutex_lock(&upipe_ts_emmd->mutex);
+    upipe_ts_emmd->async_quit = true;
+    pthread_cond_broadcast(&upipe_ts_emmd->cond);
+    pthread_mutex_unlock(&upipe_ts_emmd->mutex);
+    pthread_join(upipe_ts_emmd->thread, NULL);
+
+    if (discard) {
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&upipe_ts_emmd->async_done)) != NULL)
+            upipe_ts_emmd_job_free(upipe_ts_emmd_job_from_uchain(uchain));
+    } else
+        upipe_ts_emmd_collect_async(upipe, NULL);
+
+    pthread_cond_destroy(&upipe_ts_emmd->cond);
+    pthread_mutex_destroy(&upipe_ts_emmd->mutex);
+    ueventfd_clean(&upipe_ts_emmd->async_event);
+    upipe_ts_emmd->async = false;
 }
 
 /** @internal @This parses a new PSI section.
@@ -824,7 +1201,11 @@ static void upipe_ts_emmd_input(struct upipe *upipe, struct uref *uref,
     }
 
     struct uref *flow_def = upipe_ts_emmd_alloc_flow_def_attr(upipe);
-    if (unlikely(flow_def == NULL)) {
+    struct upipe_ts_emmd_job *job = upipe_ts_emmd_job_alloc(upipe);
+    if (unlikely(flow_def == NULL || job == NULL)) {
+        uref_free(flow_def);
+        if (job != NULL)
+            upipe_ts_emmd_job_free(job);
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         uref_free(uref);
         return;
@@ -857,16 +1238,7 @@ static void upipe_ts_emmd_input(struct upipe *upipe, struct uref *uref,
                 continue;
             }
 
-            uint8_t esd[256];
-            bissca_emmn_get_esd(emm_n, esd);
-
-            if (decrypt(upipe, esd, sizeof(esd))) {
-                upipe_err_va(upipe, "decryption failed");
-                continue;
-            }
-
-            upipe_ts_emmd_parse_sd_descs(upipe, flow_def,
-                    &esd[DESCS_HEADER_SIZE], descs_get_length(esd));
+            UBASE_FATAL(upipe, upipe_ts_emmd_job_add(job, emm_n))
         }
 
         uref_block_unmap(section_uref, 0);
@@ -878,15 +1250,9 @@ static void upipe_ts_emmd_input(struct upipe *upipe, struct uref *uref,
     upipe_ts_psid_table_copy(upipe_ts_emmd->emm, upipe_ts_emmd->next_emm);
     upipe_ts_psid_table_init(upipe_ts_emmd->next_emm);
 
-    flow_def = upipe_ts_emmd_store_flow_def_attr(upipe, flow_def);
-    if (unlikely(flow_def == NULL)) {
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        uref_free(uref);
-        return;
-    }
-    upipe_ts_emmd_store_flow_def(upipe, flow_def);
-    /* Force sending flow def */
-    upipe_ts_emmd_output(upipe, NULL, upump_p);
+    /* RSA decryption is slow, it may be done by the EMM thread */
+    job->flow_def = flow_def;
+    upipe_ts_emmd_push_job(upipe, job, upump_p);
 }
 
 /** @internal @This receives an ubuf manager.
@@ -943,6 +1309,11 @@ static int upipe_ts_emmd_control(struct upipe *upipe, int command, va_list args)
     UBASE_HANDLED_RETURN(upipe_ts_emmd_control_ecms(upipe, command, args));
 
     switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_ts_emmd_set_upump_async(upipe, NULL);
+            UBASE_RETURN(upipe_ts_emmd_attach_upump_mgr(upipe))
+            upipe_ts_emmd_poll_async(upipe);
+            return UBASE_ERR_NONE;
         case UPIPE_SET_FLOW_DEF: {
             struct uref *flow_def = va_arg(args, struct uref *);
             return upipe_ts_emmd_set_flow_def(upipe, flow_def);
@@ -955,6 +1326,15 @@ static int upipe_ts_emmd_control(struct upipe *upipe, int command, va_list args)
             read_rsa_file(upipe, private_key);
             return UBASE_ERR_NONE;
         }
+        case UPIPE_TS_EMM_SET_ASYNC: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_EMMD_SIGNATURE);
+            int async = va_arg(args, int);
+            if (!async) {
+                upipe_ts_emmd_stop_async(upipe, false);
+                return UBASE_ERR_NONE;
+            }
+            return upipe_ts_emmd_start_async(upipe);
+        }
 
         default:
             return UBASE_ERR_UNHANDLED;
@@ -971,6 +1351,7 @@ static void upipe_ts_emmd_free(struct upipe *upipe)
 
     struct upipe_ts_emmd *upipe_ts_emmd = upipe_ts_emmd_from_upipe(upipe);
 
+    upipe_ts_emmd_stop_async(upipe, true);
     gcry_cipher_close(upipe_ts_emmd->aes);
 
     asn1_delete_structure(&upipe_ts_emmd->asn);
@@ -982,6 +1363,8 @@ static void upipe_ts_emmd_free(struct upipe *upipe)
     upipe_ts_emmd_clean_output(upipe);
     upipe_ts_emmd_clean_ubuf_mgr(upipe);
     upipe_ts_emmd_clean_flow_def(upipe);
+    upipe_ts_emmd_clean_upump_async(upipe);
+    upipe_ts_emmd_clean_upump_mgr(upipe);
     upipe_ts_emmd_clean_urefcount(upipe);
     upipe_ts_emmd_clean_sub_ecms(upipe);
     upipe_ts_emmd_free_void(upipe);
@@ -1055,7 +1438,7 @@ static bool upipe_ts_emmd_ecm_table_validate(struct upipe *upipe)
                                                   &section))))
             return false;
 
-        if (/*!ecm_validate(section) || */!psi_check_crc(section)) {
+        if (/*!ecm_validate(section) || */!upipe_ts_psi_check_crc(section)) {
             uref_block_unmap(section_uref, 0);
             return false;
         }
@@ -65,6 +65,10 @@
 #define PADDING_PID 8191
 /** TB buffer size in octets (T-STD model) */
 #define TB_SIZE 512
+/** max number of PSI sections kept in the packetization cache */
+#define PSI_CACHE_SIZE 64
+/** initial number of entries in the access unit index */
+#define AU_INDEX_SIZE 16
 /** define to get header verbosity */
 #undef VERBOSE_HEADERS
 /** define to get timing verbosity */
@@ -73,6 +77,37 @@
 /** @hidden */
 static int upipe_ts_encaps_check(struct upipe *upipe, struct uref *flow_format);
 
+/** @internal @This is a run of stuffing octets shared by all encaps pipes. */
+static const uint8_t upipe_ts_encaps_stuffing[TS_SIZE] = {
+    [0 ... TS_SIZE - 1] = 0xff
+};
+
+/** @internal @This is a PSI section already prepared for packetization. */
+struct upipe_ts_encaps_psi {
+    /** structure for chaining */
+    struct uchain uchain;
+    /** first octets of the source section, used as a key */
+    const uint8_t *key;
+    /** size of the source section */
+    size_t size;
+    /** pointer_field chained with a reference to the source section,
+     * keeping its buffer (and thus the key) alive */
+    struct ubuf *prepared;
+};
+
+UBASE_FROM_TO(upipe_ts_encaps_psi, uchain, uchain, uchain)
+
+/** @internal @This describes an access unit queued for splicing. */
+struct upipe_ts_encaps_au {
+    /** total size of the urefs of the access unit */
+    size_t size;
+    /** cr_sys of the last uref of the access unit */
+    uint64_t cr_sys;
+    /** last uref of the access unit, or the head of the queue if it is the
+     * current uref */
+    struct uchain *last;
+};
+
 /** @internal @This is the private context of a ts_encaps pipe. */
 struct upipe_ts_encaps {
     /** refcount management structure */
@@ -114,9 +149,23 @@ struct upipe_ts_encaps {
     struct uchain blockers;
     /** size of the current access unit */
     size_t au_size;
+    /** index of the access units starting in urefs (ring buffer) */
+    struct upipe_ts_encaps_au *aus;
+    /** number of allocated entries in aus (power of 2) */
+    unsigned int aus_size;
+    /** first entry of aus */
+    unsigned int aus_first;
+    /** number of used entries in aus */
+    unsigned int nb_aus;
+    /** access unit starting with the current uref */
+    struct upipe_ts_encaps_au au;
 
     /** PID */
     uint16_t pid;
+    /** pre-built TS header for this PID, without continuity counter */
+    uint8_t ts_template[TS_HEADER_SIZE];
+    /** pre-built TS header with an empty adaptation field for this PID */
+    uint8_t ts_af_template[TS_HEADER_SIZE_AF];
     /** octetrate */
     uint64_t octetrate;
     /** T-STD TB size */
@@ -139,9 +188,15 @@ struct upipe_ts_encaps {
     uint64_t pes_min_duration;
     /** PES alignment */
     bool pes_alignment;
+    /** true if PES may be started before the access unit is complete */
+    bool pes_partial;
 
     /** a padding packet for PSI streams */
     struct ubuf *padding;
+    /** list of prepared PSI sections, most recently used first */
+    struct uchain psi_cache;
+    /** number of entries in psi_cache */
+    unsigned int nb_psi_cache;
     /** last continuity counter for this PID */
     uint8_t last_cc;
     /** last time prepare was called */
@@ -188,6 +243,21 @@ UPIPE_HELPER_UBUF_MGR(upipe_ts_encaps, ubuf_mgr, flow_format, ubuf_mgr_request,
                       upipe_ts_encaps_unregister_output_request)
 UPIPE_HELPER_INPUT(upipe_ts_encaps, urefs, nb_urefs, max_urefs, blockers, NULL)
 
+/** @internal @This builds the TS header templates for the current PID.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_encaps_build_templates(struct upipe *upipe)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    ts_init(encaps->ts_template);
+    ts_set_pid(encaps->ts_template, encaps->pid);
+
+    ts_init(encaps->ts_af_template);
+    ts_set_pid(encaps->ts_af_template, encaps->pid);
+    ts_set_adaptation(encaps->ts_af_template, 1);
+}
+
 /** @internal @This allocates a ts_encaps pipe.
  *
  * @param mgr common management structure
@@ -216,6 +286,13 @@ static struct upipe *upipe_ts_encaps_alloc(struct upipe_mgr *mgr,
     upipe_ts_encaps->uref_dts_sys = UINT64_MAX;
     upipe_ts_encaps->uref_ready = false;
     upipe_ts_encaps->au_size = 0;
+    upipe_ts_encaps->aus = NULL;
+    upipe_ts_encaps->aus_size = 0;
+    upipe_ts_encaps->aus_first = 0;
+    upipe_ts_encaps->nb_aus = 0;
+    upipe_ts_encaps->au.size = 0;
+    upipe_ts_encaps->au.cr_sys = UINT64_MAX;
+    upipe_ts_encaps->au.last = &upipe_ts_encaps->urefs;
     upipe_ts_encaps->pid = 8192;
     upipe_ts_encaps->octetrate = 0;
     upipe_ts_encaps->tb_size = TB_SIZE;
@@ -227,7 +304,10 @@ static struct upipe *upipe_ts_encaps_alloc(struct upipe_mgr *mgr,
     upipe_ts_encaps->pes_header_size = 0;
     upipe_ts_encaps->pes_min_duration = 0;
     upipe_ts_encaps->pes_alignment = true;
+    upipe_ts_encaps->pes_partial = false;
     upipe_ts_encaps->padding = NULL;
+    ulist_init(&upipe_ts_encaps->psi_cache);
+    upipe_ts_encaps->nb_psi_cache = 0;
     upipe_ts_encaps->last_cc = 0;
     upipe_ts_encaps->last_splice = 0;
     upipe_ts_encaps->last_pcr = 0;
@@ -243,10 +323,112 @@ static struct upipe *upipe_ts_encaps_alloc(struct upipe_mgr *mgr,
     upipe_ts_encaps->last_cr_sys = upipe_ts_encaps->last_dts_sys =
         upipe_ts_encaps->last_pcr_sys = UINT64_MAX;
     upipe_ts_encaps->last_ready = false;
+    upipe_ts_encaps_build_templates(upipe);
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This returns the last access unit of the index.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the last entry
+ */
+static inline struct upipe_ts_encaps_au *
+    upipe_ts_encaps_last_au(struct upipe *upipe)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    assert(encaps->nb_aus);
+    return &encaps->aus[(encaps->aus_first + encaps->nb_aus - 1) &
+                        (encaps->aus_size - 1)];
+}
+
+/** @internal @This returns the first access unit of the index.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the first entry
+ */
+static inline struct upipe_ts_encaps_au *
+    upipe_ts_encaps_first_au(struct upipe *upipe)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    assert(encaps->nb_aus);
+    return &encaps->aus[encaps->aus_first];
+}
+
+/** @internal @This removes the first access unit of the index.
+ *
+ * @param upipe description structure of the pipe
+ */
+static inline void upipe_ts_encaps_shift_au(struct upipe *upipe)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    assert(encaps->nb_aus);
+    encaps->aus_first = (encaps->aus_first + 1) & (encaps->aus_size - 1);
+    encaps->nb_aus--;
+}
+
+/** @internal @This indexes a uref about to be queued, either as the start of
+ * a new access unit or as the continuation of the last one.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref about to be queued
+ * @param uref_size size of the uref
+ * @param cr_sys cr_sys of the uref
+ * @return an error code
+ */
+static int upipe_ts_encaps_index_au(struct upipe *upipe, struct uref *uref,
+                                    size_t uref_size, uint64_t cr_sys)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    struct upipe_ts_encaps_au *au;
+    if (!ubase_check(uref_block_get_start(uref))) {
+        au = encaps->nb_aus ? upipe_ts_encaps_last_au(upipe) : &encaps->au;
+        au->size += uref_size;
+        au->cr_sys = cr_sys;
+        au->last = uref_to_uchain(uref);
+        return UBASE_ERR_NONE;
+    }
+
+    if (unlikely(encaps->nb_aus == encaps->aus_size)) {
+        unsigned int aus_size = encaps->aus_size ? encaps->aus_size * 2 :
+                                AU_INDEX_SIZE;
+        struct upipe_ts_encaps_au *aus =
+            malloc(aus_size * sizeof (struct upipe_ts_encaps_au));
+        UBASE_ALLOC_RETURN(aus);
+        for (unsigned int i = 0; i < encaps->nb_aus; i++)
+            aus[i] = encaps->aus[(encaps->aus_first + i) &
+                                 (encaps->aus_size - 1)];
+        free(encaps->aus);
+        encaps->aus = aus;
+        encaps->aus_size = aus_size;
+        encaps->aus_first = 0;
+    }
+
+    encaps->nb_aus++;
+    au = upipe_ts_encaps_last_au(upipe);
+    au->size = uref_size;
+    au->cr_sys = cr_sys;
+    au->last = uref_to_uchain(uref);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This updates the index after a uref was dequeued.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref dequeued uref
+ */
+static void upipe_ts_encaps_unindex_au(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    if (!ubase_check(uref_block_get_start(uref)))
+        return;
+
+    encaps->au = *upipe_ts_encaps_first_au(upipe);
+    upipe_ts_encaps_shift_au(upipe);
+    if (encaps->au.last == uref_to_uchain(uref))
+        encaps->au.last = &encaps->urefs;
+}
+
 /** @This updates the status to the mux.
  *
  * @param upipe description structure of the pipe
@@ -371,11 +553,17 @@ static void upipe_ts_encaps_update_ready(struct upipe *upipe)
         }
     }
 
-    if (encaps->pes_alignment) {
+    if (encaps->pes_alignment || encaps->pes_partial) {
         uref_ready = true;
         goto upipe_ts_encaps_update_ready_done;
     }
 
+    if (!encaps->pes_min_duration) {
+        /* ready as soon as the next access unit or flow def is queued */
+        uref_ready = encaps->nb_aus > 0;
+        goto upipe_ts_encaps_update_ready_done;
+    }
+
     while (!ulist_is_last(&encaps->urefs, uchain)) {
         uchain = uchain->next;
         struct uref *uref = uref_from_uchain(uchain);
@@ -423,6 +611,7 @@ static void upipe_ts_encaps_promote_uref(struct upipe *upipe)
             encaps->need_ready = true;
             return;
         }
+        upipe_ts_encaps_unindex_au(upipe, uref);
         upipe_ts_encaps_unblock_input(upipe);
 
         bool has_cr = ubase_check(uref_block_get_end(uref));
@@ -437,6 +626,7 @@ static void upipe_ts_encaps_promote_uref(struct upipe *upipe)
             uint64_t pid = PADDING_PID;
             uref_ts_flow_get_pid(uref, &pid);
             encaps->pid = pid;
+            upipe_ts_encaps_build_templates(upipe);
             encaps->max_delay = T_STD_MAX_RETENTION;
             uref_ts_flow_get_max_delay(uref, &encaps->max_delay);
             if (ubase_ncmp(def, FLOW_DEF_PSI)) {
@@ -448,6 +638,8 @@ static void upipe_ts_encaps_promote_uref(struct upipe *upipe)
                                                   &encaps->pes_min_duration);
                 encaps->pes_alignment =
                     ubase_check(uref_ts_flow_get_pes_alignment(uref));
+                encaps->pes_partial =
+                    ubase_check(uref_ts_flow_get_pes_partial(uref));
             }
 
             upipe_ts_encaps_store_flow_def(upipe, uref);
@@ -514,12 +706,24 @@ static void upipe_ts_encaps_input(struct upipe *upipe, struct uref *uref,
                                   struct upump **upump_p)
 {
     struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
-    uref_block_set_start(uref);
+    uint64_t dts_prog;
+    /* In partial mode, a uref continues the current access unit unless it
+     * is flagged as a start or carries its own dates. */
+    if (!encaps->pes_partial ||
+        ubase_check(uref_clock_get_dts_prog(uref, &dts_prog)))
+        uref_block_set_start(uref);
     uref_block_set_end(uref);
     uref_attr_set_priv(uref, 0);
 
     const char *def;
     if (unlikely(ubase_check(uref_flow_get_def(uref, &def)))) {
+        uref_block_set_start(uref);
+        if (unlikely(!ubase_check(upipe_ts_encaps_index_au(upipe, uref, 0,
+                                                           UINT64_MAX)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
         upipe_ts_encaps_hold_input(upipe, uref);
         if (encaps->uref == NULL)
             upipe_ts_encaps_promote_uref(upipe);
@@ -565,6 +769,12 @@ static void upipe_ts_encaps_input(struct upipe *upipe, struct uref *uref,
         return;
     }
 
+    if (unlikely(!ubase_check(upipe_ts_encaps_index_au(upipe, uref, uref_size,
+                                                       cr_sys)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
     upipe_ts_encaps_hold_input(upipe, uref);
     upipe_ts_encaps_block_input(upipe, upump_p);
     if (encaps->uref == NULL)
@@ -806,7 +1016,10 @@ static struct ubuf *upipe_ts_encaps_build_pes(struct upipe *upipe,
     pes_init(buffer);
     pes_set_streamid(buffer, encaps->pes_id);
     size_t pes_length = payload_size + header_size - PES_HEADER_SIZE;
-    if (pes_length > UINT16_MAX) {
+    if (encaps->pes_partial)
+        /* the size of the access unit is not known yet */
+        pes_set_length(buffer, 0);
+    else if (pes_length > UINT16_MAX) {
         if (unlikely((encaps->pes_id & PES_STREAM_ID_VIDEO_MPEG) !=
                      PES_STREAM_ID_VIDEO_MPEG))
             upipe_warn(upipe, "PES length > 65535 for a non-video stream");
@@ -850,6 +1063,15 @@ static bool upipe_ts_encaps_count_pcr_au(struct upipe *upipe,
         return false;
 
     uint64_t last_pcr = encaps->last_pcr;
+    if (!encaps->pes_min_duration) {
+        /* cr_sys only increases inside an access unit */
+        while (last_pcr + encaps->pcr_interval <= encaps->au.cr_sys) {
+            last_pcr += encaps->pcr_interval;
+            (*nb_pcr_p)++;
+        }
+        return encaps->last_splice == encaps->last_pcr;
+    }
+
     struct uref *uref = encaps->uref;
     struct uchain *uchain = &encaps->urefs;
     for ( ; ; ) {
@@ -894,6 +1116,8 @@ static int upipe_ts_encaps_overlap_au(struct upipe *upipe,
     struct uref *uref_au2 = uref_from_uchain(uchain->next);
     ulist_insert(uchain, uchain->next, uref_to_uchain(uref_overlap));
     encaps->nb_urefs++;
+    /* the overlapped octets now start access unit 2 */
+    upipe_ts_encaps_first_au(upipe)->size += last_ts_size;
 
     uint64_t dts_sys = UINT64_MAX;
     uref_clock_get_dts_sys(uref_au1, &dts_sys);
@@ -937,6 +1161,105 @@ static int upipe_ts_encaps_overlap_au(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This frees an entry of the PSI cache.
+ *
+ * @param psi cache entry
+ */
+static void upipe_ts_encaps_psi_free(struct upipe_ts_encaps_psi *psi)
+{
+    ulist_delete(upipe_ts_encaps_psi_to_uchain(psi));
+    ubuf_free(psi->prepared);
+    free(psi);
+}
+
+/** @internal @This flushes the PSI cache.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_encaps_flush_psi(struct upipe *upipe)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&encaps->psi_cache, uchain, uchain_tmp) {
+        upipe_ts_encaps_psi_free(upipe_ts_encaps_psi_from_uchain(uchain));
+    }
+    encaps->nb_psi_cache = 0;
+}
+
+/** @internal @This returns the given section prefixed with a pointer_field.
+ * Generators repeat tables by duplicating the same section buffers, so
+ * repetitions are looked up in a cache and reuse the pointer_field chain
+ * built for the first occurrence of the table version.
+ *
+ * @param upipe description structure of the pipe
+ * @param section section to prepare
+ * @return pointer to the prepared buffer, or NULL in case of error
+ */
+static struct ubuf *upipe_ts_encaps_prepare_psi(struct upipe *upipe,
+                                                struct ubuf *section)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    size_t size;
+    const uint8_t *key;
+    int key_size = 1;
+    if (unlikely(!ubase_check(ubuf_block_size(section, &size)) || !size ||
+                 !ubase_check(ubuf_block_read(section, 0, &key_size, &key))))
+        return NULL;
+    ubuf_block_unmap(section, 0);
+
+    struct uchain *uchain;
+    ulist_foreach (&encaps->psi_cache, uchain) {
+        struct upipe_ts_encaps_psi *psi =
+            upipe_ts_encaps_psi_from_uchain(uchain);
+        if (psi->key == key && psi->size == size) {
+            if (uchain != encaps->psi_cache.next) {
+                ulist_delete(uchain);
+                ulist_unshift(&encaps->psi_cache, uchain);
+            }
+            return ubuf_dup(psi->prepared);
+        }
+    }
+
+#ifdef VERBOSE_HEADERS
+    upipe_verbose_va(upipe, "preparing PSI pointer_field");
+#endif
+    struct upipe_ts_encaps_psi *psi = malloc(sizeof(*psi));
+    if (unlikely(psi == NULL))
+        return NULL;
+    psi->prepared = ubuf_block_alloc(encaps->ubuf_mgr, 1);
+    uint8_t *buffer;
+    int buffer_size = -1;
+    if (unlikely(psi->prepared == NULL ||
+                 !ubase_check(ubuf_block_write(psi->prepared, 0, &buffer_size,
+                                               &buffer)))) {
+        ubuf_free(psi->prepared);
+        free(psi);
+        return NULL;
+    }
+    assert(buffer_size == 1);
+    buffer[0] = 0;
+    ubuf_block_unmap(psi->prepared, 0);
+
+    struct ubuf *dup = ubuf_dup(section);
+    if (unlikely(dup == NULL ||
+                 !ubase_check(ubuf_block_append(psi->prepared, dup)))) {
+        ubuf_free(dup);
+        ubuf_free(psi->prepared);
+        free(psi);
+        return NULL;
+    }
+
+    psi->key = key;
+    psi->size = size;
+    ulist_unshift(&encaps->psi_cache, upipe_ts_encaps_psi_to_uchain(psi));
+    if (++encaps->nb_psi_cache > PSI_CACHE_SIZE) {
+        upipe_ts_encaps_psi_free(
+            upipe_ts_encaps_psi_from_uchain(ulist_peek_last(&encaps->psi_cache)));
+        encaps->nb_psi_cache--;
+    }
+    return ubuf_dup(psi->prepared);
+}
+
 /** @internal @This prepares a new access unit for splicing.
  *
  * @param upipe description structure of the pipe
@@ -947,27 +1270,13 @@ static int upipe_ts_encaps_promote_au(struct upipe *upipe)
     struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
     if (encaps->psi) {
         /* Prepend pointer_field */
-#ifdef VERBOSE_HEADERS
-        upipe_verbose_va(upipe, "preparing PSI pointer_field");
-#endif
-        struct ubuf *ubuf = ubuf_block_alloc(encaps->ubuf_mgr, 1);
-        uint8_t *buffer;
-        int size = -1;
-        if (unlikely(ubuf == NULL ||
-                     !ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)))) {
-            ubuf_free(ubuf);
-            return UBASE_ERR_ALLOC;
-        }
-        assert(size == 1);
-        buffer[0] = 0;
-        ubuf_block_unmap(ubuf, 0);
         struct ubuf *section = uref_detach_ubuf(encaps->uref);
+        struct ubuf *ubuf = upipe_ts_encaps_prepare_psi(upipe, section);
+        ubuf_free(section);
+        if (unlikely(ubuf == NULL))
+            return UBASE_ERR_ALLOC;
         uref_attach_ubuf(encaps->uref, ubuf);
         uref_attr_set_priv(encaps->uref, 1);
-        if (unlikely(!ubase_check(uref_block_append(encaps->uref, section)))) {
-            ubuf_free(section);
-            return UBASE_ERR_ALLOC;
-        }
         encaps->uref_size++;
         encaps->au_size = encaps->uref_size;
         return UBASE_ERR_NONE;
@@ -976,17 +1285,21 @@ static int upipe_ts_encaps_promote_au(struct upipe *upipe)
     size_t au_size = encaps->uref_size;
     uint64_t duration = 0;
     struct uchain *uchain = &encaps->urefs;
-    if (encaps->pes_min_duration)
+    if (!encaps->pes_min_duration) {
+        /* the size and last uref of the access unit are indexed */
+        au_size = encaps->au.size;
+        uchain = encaps->au.last;
+    } else {
         uref_clock_get_duration(encaps->uref, &duration);
-    while (!ulist_is_last(&encaps->urefs, uchain)) {
-        if (ubase_check(uref_block_get_start(uref_from_uchain(uchain->next))))
-            break;
-        uchain = uchain->next;
-        struct uref *uref = uref_from_uchain(uchain);
-        size_t uref_size;
-        UBASE_RETURN(uref_block_size(uref, &uref_size));
-        au_size += uref_size;
-        if (encaps->pes_min_duration) {
+        while (!ulist_is_last(&encaps->urefs, uchain)) {
+            if (ubase_check(uref_block_get_start(
+                            uref_from_uchain(uchain->next))))
+                break;
+            uchain = uchain->next;
+            struct uref *uref = uref_from_uchain(uchain);
+            size_t uref_size;
+            UBASE_RETURN(uref_block_size(uref, &uref_size));
+            au_size += uref_size;
             uint64_t uref_duration = 0;
             uref_clock_get_duration(uref, &uref_duration);
             duration += uref_duration;
@@ -1019,12 +1332,15 @@ static int upipe_ts_encaps_promote_au(struct upipe *upipe)
         struct uref *uref = uref_from_uchain(uchain);
         duration += uref_duration;
         au_size += uref_size;
+        if (ubase_check(uref_block_get_start(uref)))
+            upipe_ts_encaps_shift_au(upipe);
         uref_block_delete_start(uref);
         upipe_verbose_va(upipe, "aggregating an access unit");
     }
 
     const char *def;
-    if (!encaps->pes_alignment && !ulist_is_last(&encaps->urefs, uchain) &&
+    if (!encaps->pes_alignment && !encaps->pes_partial &&
+        !ulist_is_last(&encaps->urefs, uchain) &&
         !ubase_check(uref_flow_get_def(uref_from_uchain(uchain->next), &def)) &&
         !ubase_check(uref_flow_get_random(uref_from_uchain(uchain->next))) &&
         !ubase_check(uref_flow_get_discontinuity(uref_from_uchain(uchain->next)))) {
@@ -1088,18 +1404,40 @@ static int upipe_ts_encaps_promote_au(struct upipe *upipe)
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This builds a TS header.
+/** @internal @This accounts for the parts of the current access unit
+ * received after it was promoted (partial mode only).
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_ts_encaps_extend_au(struct upipe *upipe)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    size_t au_size = encaps->uref_size;
+    struct uchain *uchain;
+    ulist_foreach (&encaps->urefs, uchain) {
+        struct uref *uref = uref_from_uchain(uchain);
+        if (ubase_check(uref_block_get_start(uref)))
+            break;
+        size_t uref_size;
+        UBASE_RETURN(uref_block_size(uref, &uref_size));
+        au_size += uref_size;
+    }
+    encaps->au_size = au_size;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This returns the size of the TS header for a packet.
  *
  * @param upipe description structure of the pipe
  * @param payload_size available size of the payload
- * @param start true if it's the first packet of the access unit
  * @param pcr_prog value of the PCR field, in 27 MHz units, or UINT64_MAX
  * @param random true if the packet is a random access point
  * @param discontinuity true if the packet must have the discontinuity flag
- * @return allocated TS header
+ * @return size of the TS header, in octets
  */
-static struct ubuf *upipe_ts_encaps_build_ts(struct upipe *upipe,
-                                             size_t payload_size, bool start,
+static size_t upipe_ts_encaps_ts_header_size(struct upipe *upipe,
+                                             size_t payload_size,
                                              uint64_t pcr_prog, bool random,
                                              bool discontinuity)
 {
@@ -1114,25 +1452,45 @@ static struct ubuf *upipe_ts_encaps_build_ts(struct upipe *upipe,
 
     if (!encaps->psi && payload_size < TS_SIZE - header_size)
         header_size = TS_SIZE - payload_size;
+    return header_size;
+}
 
+/** @internal @This writes a TS header into the given buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer buffer of at least header_size octets
+ * @param header_size size of the TS header
+ * @param payload_size available size of the payload
+ * @param start true if it's the first packet of the access unit
+ * @param pcr_prog value of the PCR field, in 27 MHz units, or UINT64_MAX
+ * @param random true if the packet is a random access point
+ * @param discontinuity true if the packet must have the discontinuity flag
+ */
+static void upipe_ts_encaps_write_ts(struct upipe *upipe, uint8_t *buffer,
+                                     size_t header_size, size_t payload_size,
+                                     bool start, uint64_t pcr_prog,
+                                     bool random, bool discontinuity)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
 #ifdef VERBOSE_HEADERS
     upipe_verbose_va(upipe, "preparing TS header (size %zu%s%s%s%s)",
             header_size, start ? ", start" : "", random ? ", random" : "",
             discontinuity ? ", disc" : "",
             pcr_prog != UINT64_MAX ? ", pcr" : "");
 #endif
-    struct ubuf *ubuf = ubuf_block_alloc(encaps->ubuf_mgr, header_size);
-    uint8_t *buffer;
-    int size = -1;
-    if (unlikely(ubuf == NULL ||
-                 !ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)))) {
-        ubuf_free(ubuf);
-        return NULL;
+    if (likely(header_size == TS_HEADER_SIZE))
+        memcpy(buffer, encaps->ts_template, TS_HEADER_SIZE);
+    else {
+        memcpy(buffer, encaps->ts_af_template,
+               header_size < TS_HEADER_SIZE_AF ? header_size :
+               TS_HEADER_SIZE_AF);
+        /* patch adaptation_field_length */
+        buffer[TS_HEADER_SIZE] = header_size - TS_HEADER_SIZE - 1;
+        if (header_size > TS_HEADER_SIZE_AF)
+            memcpy(buffer + TS_HEADER_SIZE_AF, upipe_ts_encaps_stuffing,
+                   header_size - TS_HEADER_SIZE_AF);
     }
-    assert(size == header_size);
 
-    ts_init(buffer);
-    ts_set_pid(buffer, encaps->pid);
     if (payload_size) {
         encaps->last_cc++;
         encaps->last_cc &= 0xf;
@@ -1143,7 +1501,6 @@ static struct ubuf *upipe_ts_encaps_build_ts(struct upipe *upipe,
         ts_set_unitstart(buffer);
 
     if (header_size > TS_HEADER_SIZE) {
-        ts_set_adaptation(buffer, header_size - TS_HEADER_SIZE - 1);
         if (discontinuity)
             tsaf_set_discontinuity(buffer);
         if (random)
@@ -1154,28 +1511,64 @@ static struct ubuf *upipe_ts_encaps_build_ts(struct upipe *upipe,
             tsaf_set_pcrext(buffer, pcr_prog % SCALE_33);
         }
     }
+}
 
+/** @internal @This builds a TS header.
+ *
+ * @param upipe description structure of the pipe
+ * @param payload_size available size of the payload
+ * @param start true if it's the first packet of the access unit
+ * @param pcr_prog value of the PCR field, in 27 MHz units, or UINT64_MAX
+ * @param random true if the packet is a random access point
+ * @param discontinuity true if the packet must have the discontinuity flag
+ * @return allocated TS header
+ */
+static struct ubuf *upipe_ts_encaps_build_ts(struct upipe *upipe,
+                                             size_t payload_size, bool start,
+                                             uint64_t pcr_prog, bool random,
+                                             bool discontinuity)
+{
+    struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+    size_t header_size = upipe_ts_encaps_ts_header_size(upipe, payload_size,
+            pcr_prog, random, discontinuity);
+
+    struct ubuf *ubuf = ubuf_block_alloc(encaps->ubuf_mgr, header_size);
+    uint8_t *buffer;
+    int size = -1;
+    if (unlikely(ubuf == NULL ||
+                 !ubase_check(ubuf_block_write(ubuf, 0, &size, &buffer)))) {
+        ubuf_free(ubuf);
+        return NULL;
+    }
+    assert(size == header_size);
+
+    upipe_ts_encaps_write_ts(upipe, buffer, header_size, payload_size, start,
+                             pcr_prog, random, discontinuity);
     ubuf_block_unmap(ubuf, 0);
     return ubuf;
 }
 
-/** @internal @This splices the input uref and appends to the given ubuf to
- * build a complete TS packet. For PSI sections it may also append padding.
+/** @internal @This splices the input uref and appends to the given ubuf, or
+ * copies into the given buffer, to build a complete TS packet. For PSI
+ * sections it may also append padding.
  *
  * @param upipe description structure of the pipe
- * @param ubuf_p appended with the payload of the packet
+ * @param ubuf_p appended with the payload of the packet, or NULL
+ * @param buffer if ubuf_p is NULL, TS packet written after the header
+ * @param ubuf_size if ubuf_p is NULL, size of the header already in buffer
  * @param dts_sys_p filled in with the DTS, or UINT64_MAX
  * @return an error code
  */
 static int upipe_ts_encaps_complete(struct upipe *upipe, struct ubuf **ubuf_p,
+                                    uint8_t *buffer, size_t ubuf_size,
                                     uint64_t *dts_sys_p)
 {
     struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
     encaps->need_status = true;
     *dts_sys_p = UINT64_MAX;
 
-    size_t ubuf_size;
-    UBASE_RETURN(ubuf_block_size(*ubuf_p, &ubuf_size));
+    if (ubuf_p != NULL)
+        UBASE_RETURN(ubuf_block_size(*ubuf_p, &ubuf_size));
     assert(ubuf_size < TS_SIZE);
 
     for ( ; ; ) {
@@ -1192,8 +1585,9 @@ static int upipe_ts_encaps_complete(struct upipe *upipe, struct ubuf **ubuf_p,
                 encaps->tb_rate;
 
         struct ubuf *payload = uref_detach_ubuf(encaps->uref);
+        size_t payload_size = uref_size;
         if (uref_size >= TS_SIZE - ubuf_size) {
-            size_t payload_size = TS_SIZE - ubuf_size;
+            payload_size = TS_SIZE - ubuf_size;
             assert(payload_size);
             uref_attach_ubuf(encaps->uref,
                              ubuf_block_split(payload, payload_size));
@@ -1209,8 +1603,15 @@ static int upipe_ts_encaps_complete(struct upipe *upipe, struct ubuf **ubuf_p,
             encaps->au_size -= uref_size;
         }
 
-        if (unlikely(payload == NULL ||
-                     !ubase_check(ubuf_block_append(*ubuf_p, payload)))) {
+        if (ubuf_p == NULL) {
+            int err = payload == NULL ? UBASE_ERR_ALLOC :
+                ubuf_block_extract(payload, 0, payload_size,
+                                   buffer + ubuf_size);
+            ubuf_free(payload);
+            UBASE_RETURN(err);
+        } else if (unlikely(payload == NULL ||
+                            !ubase_check(ubuf_block_append(*ubuf_p,
+                                                           payload)))) {
             ubuf_free(payload);
             ubuf_free(*ubuf_p);
             return UBASE_ERR_ALLOC;
@@ -1225,14 +1626,18 @@ static int upipe_ts_encaps_complete(struct upipe *upipe, struct ubuf **ubuf_p,
         }
 
         ubuf_size += uref_size;
-        if (encaps->uref == NULL ||
+        if (encaps->uref == NULL || !encaps->au_size ||
             ubase_check(uref_block_get_start(encaps->uref))) {
             assert(!encaps->au_size);
             break;
         }
     }
 
-    if (ubuf_size < TS_SIZE) {
+    if (ubuf_size < TS_SIZE && ubuf_p == NULL) {
+        /* With PSI, pad with 0xff */
+        memcpy(buffer + ubuf_size, upipe_ts_encaps_stuffing,
+               TS_SIZE - ubuf_size);
+    } else if (ubuf_size < TS_SIZE) {
         /* With PSI, pad with 0xff */
         struct ubuf *padding = ubuf_dup(encaps->padding);
         if (unlikely(padding == NULL ||
@@ -1248,17 +1653,21 @@ static int upipe_ts_encaps_complete(struct upipe *upipe, struct ubuf **ubuf_p,
     return UBASE_ERR_NONE;
 }
 
-/** @This returns a ubuf containing a TS packet, and the dts_sys of the packet.
+/** @This returns a ubuf containing a TS packet, or writes the TS packet into
+ * the given buffer, and the dts_sys of the packet. If both ubuf_p and buffer
+ * are NULL, late packets are flushed.
  *
  * @param upipe description structure of the pipe
  * @param cr_sys_min date at which the packet will be muxed
  * @param cr_sys_max maximum date allowed for muxing
  * @param ubuf_p filled in with a pointer to the ubuf (may be NULL)
+ * @param buffer buffer of TS_SIZE octets to write into (may be NULL)
  * @param dts_sys_p filled in with the dts_sys, or UINT64_MAX
  * @return an error code
  */
 static int _upipe_ts_encaps_splice(struct upipe *upipe, uint64_t cr_sys_min,
-        uint64_t cr_sys_max, struct ubuf **ubuf_p, uint64_t *dts_sys_p)
+        uint64_t cr_sys_max, struct ubuf **ubuf_p, uint8_t *buffer,
+        uint64_t *dts_sys_p)
 {
     struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
     if (encaps->ubuf_mgr == NULL)
@@ -1272,7 +1681,7 @@ static int _upipe_ts_encaps_splice(struct upipe *upipe, uint64_t cr_sys_min,
     }
     encaps->last_splice = cr_sys_min;
 
-    if (ubuf_p == NULL) {
+    if (ubuf_p == NULL && buffer == NULL) {
         /* Flush until cr_sys_min */
         while (encaps->uref != NULL) {
             if (encaps->uref_dts_sys != UINT64_MAX) {
@@ -1314,8 +1723,17 @@ static int _upipe_ts_encaps_splice(struct upipe *upipe, uint64_t cr_sys_min,
         if (unlikely(pcr_prog == UINT64_MAX))
             upipe_dbg(upipe, "adding unnecessary padding (internal error)");
 
-        *ubuf_p = upipe_ts_encaps_build_ts(upipe, 0, false, pcr_prog, false,
-                                           false);
+        if (ubuf_p != NULL)
+            *ubuf_p = upipe_ts_encaps_build_ts(upipe, 0, false, pcr_prog,
+                                               false, false);
+        else {
+            size_t header_size = upipe_ts_encaps_ts_header_size(upipe, 0,
+                    pcr_prog, false, false);
+            upipe_ts_encaps_write_ts(upipe, buffer, header_size, 0, false,
+                                     pcr_prog, false, false);
+            memcpy(buffer + header_size, upipe_ts_encaps_stuffing,
+                   TS_SIZE - header_size);
+        }
         *dts_sys_p = pcr_prog != UINT64_MAX ? cr_sys_min : UINT64_MAX;
         encaps->need_status = true;
         upipe_ts_encaps_check_status(upipe);
@@ -1325,19 +1743,33 @@ static int _upipe_ts_encaps_splice(struct upipe *upipe, uint64_t cr_sys_min,
     bool start = ubase_check(uref_block_get_start(encaps->uref));
     if (start) {
         UBASE_RETURN(upipe_ts_encaps_promote_au(upipe));
+    } else if (!encaps->au_size) {
+        assert(encaps->pes_partial);
+        UBASE_RETURN(upipe_ts_encaps_extend_au(upipe));
     }
     assert(encaps->uref_size);
     assert(encaps->au_size);
 
-    *ubuf_p = upipe_ts_encaps_build_ts(upipe, encaps->au_size, start, pcr_prog,
-            ubase_check(uref_flow_get_random(encaps->uref)),
-            ubase_check(uref_flow_get_discontinuity(encaps->uref)));
-    UBASE_ALLOC_RETURN(*ubuf_p);
+    bool random = ubase_check(uref_flow_get_random(encaps->uref));
+    bool discontinuity =
+        ubase_check(uref_flow_get_discontinuity(encaps->uref));
+    size_t header_size = 0;
+    if (ubuf_p != NULL) {
+        *ubuf_p = upipe_ts_encaps_build_ts(upipe, encaps->au_size, start,
+                                           pcr_prog, random, discontinuity);
+        UBASE_ALLOC_RETURN(*ubuf_p);
+    } else {
+        header_size = upipe_ts_encaps_ts_header_size(upipe, encaps->au_size,
+                pcr_prog, random, discontinuity);
+        upipe_ts_encaps_write_ts(upipe, buffer, header_size, encaps->au_size,
+                                 start, pcr_prog, random, discontinuity);
+    }
     uref_block_delete_start(encaps->uref);
     uref_flow_delete_random(encaps->uref);
     uref_flow_delete_discontinuity(encaps->uref);
 
-    UBASE_RETURN(upipe_ts_encaps_complete(upipe, ubuf_p, dts_sys_p));
+    UBASE_RETURN(upipe_ts_encaps_complete(upipe, ubuf_p, buffer, header_size,
+                                          dts_sys_p));
     if (pcr_prog != UINT64_MAX)
         *dts_sys_p = encaps->last_splice;
 
@@ -1384,8 +1816,11 @@ static int upipe_ts_encaps_control(struct upipe *upipe,
             unsigned int max_length = va_arg(args, unsigned int);
             return upipe_ts_encaps_set_max_length(upipe, max_length);
         }
-        case UPIPE_FLUSH:
+        case UPIPE_FLUSH: {
+            struct upipe_ts_encaps *encaps = upipe_ts_encaps_from_upipe(upipe);
+            encaps->aus_first = encaps->nb_aus = 0;
             return upipe_ts_encaps_flush_input(upipe);
+        }
 
         case UPIPE_TS_MUX_GET_CC: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
@@ -1428,7 +1863,16 @@ static int upipe_ts_encaps_control(struct upipe *upipe,
             struct ubuf **ubuf_p = va_arg(args, struct ubuf **);
             uint64_t *dts_sys_p = va_arg(args, uint64_t *);
             return _upipe_ts_encaps_splice(upipe, cr_sys_min, cr_sys_max,
-                                           ubuf_p, dts_sys_p);
+                                           ubuf_p, NULL, dts_sys_p);
+        }
+        case UPIPE_TS_ENCAPS_SPLICE_INTO: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ENCAPS_SIGNATURE)
+            uint64_t cr_sys_min = va_arg(args, uint64_t);
+            uint64_t cr_sys_max = va_arg(args, uint64_t);
+            uint8_t *buffer = va_arg(args, uint8_t *);
+            uint64_t *dts_sys_p = va_arg(args, uint64_t *);
+            return _upipe_ts_encaps_splice(upipe, cr_sys_min, cr_sys_max,
+                                           NULL, buffer, dts_sys_p);
         }
         case UPIPE_TS_ENCAPS_EOS: {
             UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ENCAPS_SIGNATURE)
@@ -1456,7 +1900,9 @@ static void upipe_ts_encaps_free(struct upipe *upipe)
 
     uref_free(upipe_ts_encaps->uref);
     ubuf_free(upipe_ts_encaps->padding);
+    upipe_ts_encaps_flush_psi(upipe);
     upipe_ts_encaps_clean_input(upipe);
+    free(upipe_ts_encaps->aus);
     upipe_ts_encaps_clean_output(upipe);
     upipe_ts_encaps_clean_ubuf_mgr(upipe);
     upipe_ts_encaps_clean_urefcount(upipe);
@@ -1476,6 +1922,7 @@ static const char *upipe_ts_encaps_command_str(int cmd)
     switch (cmd) {
         UBASE_CASE_TO_STR(UPIPE_TS_ENCAPS_SET_TB_SIZE);
         UBASE_CASE_TO_STR(UPIPE_TS_ENCAPS_SPLICE);
+        UBASE_CASE_TO_STR(UPIPE_TS_ENCAPS_SPLICE_INTO);
         UBASE_CASE_TO_STR(UPIPE_TS_ENCAPS_EOS);
         default: break;
     }
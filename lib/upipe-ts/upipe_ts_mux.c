@@ -38,6 +38,7 @@
  */
 
 #include "upipe/ulist.h"
+#include "upipe/uheap.h"
 #include "upipe/uprobe.h"
 #include "upipe/uprobe_prefix.h"
 #include "upipe/uref.h"
@@ -165,6 +166,8 @@
 #define MAX_TDT_INTERVAL (UCLOCK_FREQ * 30)
 /** default EITs octetrate */
 #define DEFAULT_EITS_OCTETRATE 0
+/** interval between spare octetrate reports */
+#define SPARE_OCTETRATE_INTERVAL UCLOCK_FREQ
 /** default AAC encapsulation */
 #define DEFAULT_AAC_ENCAPS UREF_MPGA_ENCAPS_ADTS
 /** default AAC signaling mode */
@@ -280,8 +283,6 @@ struct upipe_ts_mux {
     /** psi_pid structure for TDT */
     struct upipe_ts_mux_psi_pid *psi_pid_tdt;
 
-    /** one TS packet of padding */
-    struct ubuf *padding;
 
     /** input flow definition */
     struct uref *flow_def_input;
@@ -352,6 +353,8 @@ struct upipe_ts_mux {
     struct uchain psi_pids_splice;
     /** list of inputs that are actually PSI */
     struct uchain psi_inputs;
+    /** heap of inputs ordered by the date they must be spliced */
+    struct uheap inputs_heap;
     /** max latency of the subpipes */
     uint64_t latency;
     /** date of the current uref (system time, latency taken into account) */
@@ -360,8 +363,16 @@ struct upipe_ts_mux {
     uint64_t cr_sys_remainder;
     /** current aggregation */
     struct uref *uref;
+    /** mapped buffer of the current aggregation */
+    uint8_t *uref_buffer;
     /** size of current aggregation */
     size_t uref_size;
+    /** allocated size of the current aggregation */
+    size_t uref_mtu;
+    /** start of the current spare octetrate measurement (system time) */
+    uint64_t spare_cr_sys;
+    /** number of padding packets since spare_cr_sys */
+    uint64_t spare_packets;
     /** true during the preroll period */
     bool preroll;
 
@@ -558,6 +569,8 @@ struct upipe_ts_mux_input {
     uint64_t pcr_sys;
     /** true if the input is ready to output packet */
     bool ready;
+    /** node in the heap of inputs to splice */
+    struct uheap_node heap_node;
 
     /** psi_pid structure for PSI-based elementary streams */
     struct upipe_ts_mux_psi_pid *psi_pid;
@@ -567,6 +580,8 @@ struct upipe_ts_mux_input {
     int aac_encaps;
     /** AAC signaling mode */
     int aac_signaling;
+    /** number of slices per picture in low-latency mode, or 0 */
+    unsigned int slices;
 
     /** maximum retention delay */
     uint64_t max_delay;
@@ -588,6 +603,7 @@ UPIPE_HELPER_BIN_INPUT(upipe_ts_mux_input, input, input_request_list)
 
 UBASE_FROM_TO(upipe_ts_mux_input, urefcount, urefcount_real, urefcount_real)
 UBASE_FROM_TO(upipe_ts_mux_input, uchain, uchain_psi, uchain_psi)
+UBASE_FROM_TO(upipe_ts_mux_input, uheap_node, heap_node, heap_node)
 
 UPIPE_HELPER_SUBPIPE(upipe_ts_mux_program, upipe_ts_mux_input, input,
                      input_mgr, inputs, uchain)
@@ -925,6 +941,52 @@ static int upipe_ts_mux_input_probe(struct uprobe *uprobe, struct upipe *inner,
     return upipe_throw_proxy(upipe, inner, event, args);
 }
 
+/** @internal @This (re)schedules an input in the heap of inputs to splice.
+ * The key is the earliest date at which the input may be spliced, that is
+ * its cr_sys, unless its next PCR or its dts_sys (minus the muxing interval)
+ * is due sooner.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_input_schedule(struct upipe *upipe)
+{
+    struct upipe_ts_mux_input *input = upipe_ts_mux_input_from_upipe(upipe);
+    struct upipe_ts_mux_program *program =
+        upipe_ts_mux_program_from_input_mgr(upipe->mgr);
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_program_mgr(
+                upipe_ts_mux_program_to_upipe(program)->mgr);
+
+    uint64_t key = input->cr_sys;
+    if (input->pcr_sys < key)
+        key = input->pcr_sys;
+    if (input->dts_sys != UINT64_MAX) {
+        uint64_t dts_key = input->dts_sys > mux->interval ?
+                           input->dts_sys - mux->interval : 0;
+        if (dts_key < key)
+            key = dts_key;
+    }
+
+    if (key == UINT64_MAX || input->encaps == NULL)
+        uheap_delete(&mux->inputs_heap, &input->heap_node);
+    else if (unlikely(!uheap_update(&mux->inputs_heap, &input->heap_node,
+                                    key)))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+}
+
+/** @internal @This removes an input from the heap of inputs to splice.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_input_unschedule(struct upipe *upipe)
+{
+    struct upipe_ts_mux_input *input = upipe_ts_mux_input_from_upipe(upipe);
+    struct upipe_ts_mux_program *program =
+        upipe_ts_mux_program_from_input_mgr(upipe->mgr);
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_program_mgr(
+                upipe_ts_mux_program_to_upipe(program)->mgr);
+    uheap_delete(&mux->inputs_heap, &input->heap_node);
+}
+
 /** @internal @This catches the events from encaps inner pipes.
  *
  * @param uprobe pointer to the probe in upipe_ts_mux_input
@@ -952,6 +1014,7 @@ static int upipe_ts_mux_input_encaps_probe(struct uprobe *uprobe,
     upipe_ts_mux_input->dts_sys = va_arg(args, uint64_t);
     upipe_ts_mux_input->pcr_sys = va_arg(args, uint64_t);
     upipe_ts_mux_input->ready = !!va_arg(args, int);
+    upipe_ts_mux_input_schedule(upipe);
     return UBASE_ERR_NONE;
 }
 
@@ -998,10 +1061,12 @@ static struct upipe *upipe_ts_mux_input_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux_input->dts_sys = UINT64_MAX;
     upipe_ts_mux_input->pcr_sys = UINT64_MAX;
     upipe_ts_mux_input->ready = false;
+    uheap_node_init(&upipe_ts_mux_input->heap_node);
     upipe_ts_mux_input->psi_pid = NULL;
     upipe_ts_mux_input->scte35_interval = program->scte35_interval;
     upipe_ts_mux_input->aac_encaps = program->aac_encaps;
     upipe_ts_mux_input->aac_signaling = program->aac_signaling;
+    upipe_ts_mux_input->slices = 0;
     upipe_ts_mux_input->max_delay = program->max_delay;
     upipe_ts_mux_input->au_per_sec.num = upipe_ts_mux_input->au_per_sec.den = 0;
     upipe_ts_mux_input->original_au_per_sec.num =
@@ -1208,6 +1273,17 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
         pes_overhead += PES_HEADER_SIZE_PTSDTS *
             (au_per_sec.num + au_per_sec.den - 1) / au_per_sec.den;
 
+        if (input->slices) {
+            UBASE_FATAL(upipe, uref_ts_flow_set_pes_partial(flow_def_dup))
+            original_au_per_sec = au_per_sec;
+            original_au_per_sec.num *= input->slices;
+            urational_simplify(&original_au_per_sec);
+            /* TS padding overhead - each slice may end a packet */
+            pes_overhead += (TS_SIZE - TS_HEADER_SIZE) *
+                (original_au_per_sec.num + original_au_per_sec.den - 1) /
+                original_au_per_sec.den;
+        }
+
     } else if (strstr(def, ".sound.") != NULL) {
         input_type = UPIPE_TS_MUX_INPUT_AUDIO;
         uint64_t pes_min_duration = DEFAULT_AUDIO_PES_MIN_DURATION;
@@ -1310,6 +1386,7 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
         input->dts_sys = UINT64_MAX;
         input->pcr_sys = UINT64_MAX;
         input->ready = false;
+        upipe_ts_mux_input_unschedule(upipe);
         if (!ulist_is_in(upipe_ts_mux_input_to_uchain_psi(input)))
             ulist_add(&upipe_ts_mux->psi_inputs,
                       upipe_ts_mux_input_to_uchain_psi(input));
@@ -1411,10 +1488,11 @@ static int upipe_ts_mux_input_set_flow_def(struct upipe *upipe,
         upipe_ts_mux->latency = latency + input->buffer_duration;
         upipe_ts_mux_build_flow_def(upipe_ts_mux_to_upipe(upipe_ts_mux));
     }
-    if (upipe_ts_mux->live && au_per_sec.den) { /* live mode */
+    if (upipe_ts_mux->live && original_au_per_sec.den) { /* live mode */
         upipe_set_max_length(input->encaps,
-                (MIN_BUFFERING + upipe_ts_mux->latency) * au_per_sec.num /
-                au_per_sec.den / UCLOCK_FREQ);
+                (MIN_BUFFERING + upipe_ts_mux->latency) *
+                original_au_per_sec.num / original_au_per_sec.den /
+                UCLOCK_FREQ);
     } else /* file mode */
         upipe_set_max_length(input->encaps, UINT_MAX);
 
@@ -1553,6 +1631,39 @@ static int _upipe_ts_mux_input_set_aac_signaling(struct upipe *upipe,
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This returns the number of slices per picture in
+ * low-latency mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param slices_p filled in with the number of slices, or 0
+ * @return an error code
+ */
+static int _upipe_ts_mux_input_get_slices(struct upipe *upipe,
+                                          unsigned int *slices_p)
+{
+    struct upipe_ts_mux_input *upipe_ts_mux_input =
+        upipe_ts_mux_input_from_upipe(upipe);
+    assert(slices_p != NULL);
+    *slices_p = upipe_ts_mux_input->slices;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This sets the number of slices per picture in low-latency
+ * mode. It is only taken into account by the next flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param slices number of slices, or 0 to disable low-latency mode
+ * @return an error code
+ */
+static int _upipe_ts_mux_input_set_slices(struct upipe *upipe,
+                                          unsigned int slices)
+{
+    struct upipe_ts_mux_input *upipe_ts_mux_input =
+        upipe_ts_mux_input_from_upipe(upipe);
+    upipe_ts_mux_input->slices = slices;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This processes control commands on a ts_mux_input
  * pipe.
  *
@@ -1610,6 +1721,16 @@ static int upipe_ts_mux_input_control(struct upipe *upipe,
             int signaling = va_arg(args, int);
             return _upipe_ts_mux_input_set_aac_signaling(upipe, signaling);
         }
+        case UPIPE_TS_MUX_GET_SLICES: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            unsigned int *slices_p = va_arg(args, unsigned int *);
+            return _upipe_ts_mux_input_get_slices(upipe, slices_p);
+        }
+        case UPIPE_TS_MUX_SET_SLICES: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_MUX_SIGNATURE)
+            unsigned int slices = va_arg(args, unsigned int);
+            return _upipe_ts_mux_input_set_slices(upipe, slices);
+        }
 
         case UPIPE_GET_MAX_LENGTH:
         case UPIPE_SET_MAX_LENGTH:
@@ -1665,6 +1786,7 @@ static void upipe_ts_mux_input_free(struct urefcount *urefcount_real)
     struct upipe_ts_mux_program *program =
         upipe_ts_mux_program_from_input_mgr(upipe->mgr);
 
+    upipe_ts_mux_input_unschedule(upipe);
     upipe_ts_mux_input_clean_sub(upipe);
     if (!upipe_single(upipe_ts_mux_program_to_upipe(program)))
         upipe_ts_mux_program_change(upipe_ts_mux_program_to_upipe(program));
@@ -1695,11 +1817,13 @@ static void upipe_ts_mux_input_no_input(struct upipe *upipe)
     upipe_ts_mux_input->deleted = true;
     if (upipe_ts_mux_input->input_type == UPIPE_TS_MUX_INPUT_SCTE35) {
         ulist_delete(upipe_ts_mux_input_to_uchain_psi(upipe_ts_mux_input));
+        upipe_ts_mux_input_unschedule(upipe);
         upipe_release(upipe_ts_mux_input->encaps);
         upipe_ts_mux_input->encaps = NULL;
     } else {
         upipe_ts_encaps_eos(upipe_ts_mux_input->encaps);
         if (!upipe_ts_mux_input->ready) {
+            upipe_ts_mux_input_unschedule(upipe);
             upipe_release(upipe_ts_mux_input->encaps);
             upipe_ts_mux_input->encaps = NULL;
         }
@@ -2598,7 +2722,6 @@ static struct upipe *upipe_ts_mux_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux->psi_pid_sdt = NULL;
     upipe_ts_mux->psi_pid_eit = NULL;
     upipe_ts_mux->psi_pid_tdt = NULL;
-    upipe_ts_mux->padding = NULL;
 
     upipe_ts_mux->flow_def_input = NULL;
     upipe_ts_mux->auto_conformance = true;
@@ -2630,6 +2753,7 @@ static struct upipe *upipe_ts_mux_alloc(struct upipe_mgr *mgr,
 
     ulist_init(&upipe_ts_mux->psi_pids);
     ulist_init(&upipe_ts_mux->psi_pids_splice);
+    uheap_init(&upipe_ts_mux->inputs_heap);
     ulist_init(&upipe_ts_mux->psi_inputs);
     upipe_ts_mux->mode = UPIPE_TS_MUX_MODE_CBR;
     upipe_ts_mux->tb_size = T_STD_TS_BUFFER;
@@ -2638,7 +2762,11 @@ static struct upipe *upipe_ts_mux_alloc(struct upipe_mgr *mgr,
     upipe_ts_mux->cr_sys = UINT64_MAX;
     upipe_ts_mux->cr_sys_remainder = 0;
     upipe_ts_mux->uref = NULL;
+    upipe_ts_mux->uref_buffer = NULL;
+    upipe_ts_mux->uref_mtu = 0;
     upipe_ts_mux->uref_size = 0;
+    upipe_ts_mux->spare_cr_sys = UINT64_MAX;
+    upipe_ts_mux->spare_packets = 0;
     upipe_ts_mux->preroll = true;
 
     uprobe_init(&upipe_ts_mux->probe, upipe_ts_mux_probe, NULL);
@@ -2758,20 +2886,41 @@ static uint64_t upipe_ts_mux_show_increment(struct upipe *upipe)
         mux->total_octetrate;
 }
 
-/** @internal @This splices a ubuf to output.
+/** @internal @This reschedules all inputs, after a change of the muxing
+ * interval.
  *
  * @param upipe description structure of the pipe
- * @param ubuf_p filled in with the ubuf to output, or NULL if none is available
+ */
+static void upipe_ts_mux_schedule_inputs(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&mux->programs, uchain) {
+        struct upipe_ts_mux_program *program =
+            upipe_ts_mux_program_from_uchain(uchain);
+        struct uchain *uchain_input;
+        ulist_foreach (&program->inputs, uchain_input) {
+            struct upipe_ts_mux_input *input =
+                upipe_ts_mux_input_from_uchain(uchain_input);
+            upipe_ts_mux_input_schedule(upipe_ts_mux_input_to_upipe(input));
+        }
+    }
+}
+
+/** @internal @This splices a TS packet into the given buffer.
+ *
+ * @param upipe description structure of the pipe
+ * @param buffer buffer of TS_SIZE octets to write into
  * @param dts_sys_p filled with the dts_sys of the fragment
+ * @return false if no packet is available
  */
-static void upipe_ts_mux_splice(struct upipe *upipe, struct ubuf **ubuf_p,
+static bool upipe_ts_mux_splice(struct upipe *upipe, uint8_t *buffer,
                                 uint64_t *dts_sys_p)
 {
     struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
     uint64_t original_cr_sys = mux->cr_sys - mux->latency;
     struct uchain *uchain;
     int err;
-    *ubuf_p = NULL;
 
     /* Order of priority: 1. PSI */
     while (!ulist_empty(&mux->psi_pids_splice)) {
@@ -2790,65 +2939,54 @@ static void upipe_ts_mux_splice(struct upipe *upipe, struct ubuf **ubuf_p,
         if (psi_pid->cr_sys > original_cr_sys)
             break; /* Too soon */
 
-        err = upipe_ts_encaps_splice(psi_pid->encaps, original_cr_sys,
-                                     original_cr_sys + mux->interval,
-                                     ubuf_p, dts_sys_p);
+        err = upipe_ts_encaps_splice_into(psi_pid->encaps, original_cr_sys,
+                                          original_cr_sys + mux->interval,
+                                          buffer, dts_sys_p);
         if (!ubase_check(err)) {
             upipe_warn(upipe, "internal error in splice");
             upipe_throw_fatal(upipe, err);
+            return false;
         }
         /* No need to pop uchain as the probe does it for us. */
-        return;
+        return true;
     }
 
-    /* 2. Inputs */
-    uint64_t cr_sys = UINT64_MAX;
+    /* 2. Inputs, by increasing date */
     struct upipe_ts_mux_input *selected_input = NULL;
-    struct uchain *uchain_tmp;
-    ulist_delete_foreach (&mux->programs, uchain, uchain_tmp) {
-        struct upipe_ts_mux_program *program =
-            upipe_ts_mux_program_from_uchain(uchain);
-        upipe_use(upipe_ts_mux_program_to_upipe(program));
-
-        struct uchain *uchain_input, *uchain_tmp2;
-        ulist_delete_foreach (&program->inputs, uchain_input, uchain_tmp2) {
-            struct upipe_ts_mux_input *input =
-                upipe_ts_mux_input_from_uchain(uchain_input);
-            if (input->dts_sys < original_cr_sys) { /* flush */
-                upipe_ts_encaps_splice(input->encaps, original_cr_sys,
-                                       original_cr_sys + mux->interval,
-                                       NULL, NULL);
-
-                if (input->deleted && !input->ready) {
-                    /* This triggers the immediate deletion of the input. */
-                    upipe_release(input->encaps);
-                    continue;
-                }
-            }
-
-            if (input->dts_sys <= original_cr_sys + mux->interval ||
-                input->pcr_sys <= original_cr_sys) {
-                selected_input = input;
-                upipe_release(upipe_ts_mux_program_to_upipe(program));
-                goto upipe_ts_mux_splice_done;
-            }
-            if (input->cr_sys < cr_sys) {
-                selected_input = input;
-                cr_sys = input->cr_sys;
+    struct uheap_node *node;
+    while ((node = uheap_peek(&mux->inputs_heap)) != NULL) {
+        struct upipe_ts_mux_input *input =
+            upipe_ts_mux_input_from_heap_node(node);
+        if (input->dts_sys < original_cr_sys) { /* flush */
+            uint64_t dts_sys = input->dts_sys;
+            upipe_ts_encaps_splice(input->encaps, original_cr_sys,
+                                   original_cr_sys + mux->interval,
+                                   NULL, NULL);
+
+            if (input->deleted && !input->ready) {
+                /* This triggers the immediate deletion of the input. */
+                upipe_ts_mux_input_unschedule(
+                        upipe_ts_mux_input_to_upipe(input));
+                upipe_release(input->encaps);
+                continue;
             }
+            /* the flush rescheduled the input */
+            if (input->dts_sys != dts_sys)
+                continue;
         }
 
-        upipe_release(upipe_ts_mux_program_to_upipe(program));
+        if (node->key > original_cr_sys)
+            return false;
+        selected_input = input;
+        break;
     }
 
-    if (selected_input == NULL ||
-        selected_input->cr_sys > original_cr_sys)
-        return;
+    if (selected_input == NULL)
+        return false;
 
-upipe_ts_mux_splice_done:
-    err = upipe_ts_encaps_splice(selected_input->encaps, original_cr_sys,
-                                 original_cr_sys + mux->interval,
-                                 ubuf_p, dts_sys_p);
+    err = upipe_ts_encaps_splice_into(selected_input->encaps, original_cr_sys,
+                                      original_cr_sys + mux->interval,
+                                      buffer, dts_sys_p);
     if (!ubase_check(err)) {
         upipe_warn(upipe, "internal error in splice");
         upipe_throw_fatal(upipe, err);
@@ -2856,32 +2994,78 @@ upipe_ts_mux_splice_done:
 
     if (selected_input->deleted && !selected_input->ready) {
         /* This triggers the immediate deletion of the input. */
+        upipe_ts_mux_input_unschedule(
+                upipe_ts_mux_input_to_upipe(selected_input));
         upipe_release(selected_input->encaps);
     }
+    return ubase_check(err);
 }
 
-/** @internal @This appends a uref to our buffer.
+/** @internal @This returns true if the current aggregation is full.
  *
  * @param upipe description structure of the pipe
- * @param ubuf ubuf to append
- * @param dts_sys dts_sys associated with the ubuf
+ * @return true if the aggregation must be output
  */
-static void upipe_ts_mux_append(struct upipe *upipe, struct ubuf *ubuf,
-                                uint64_t dts_sys)
+static inline bool upipe_ts_mux_full(struct upipe *upipe)
 {
     struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    return mux->uref_size >= mux->mtu ||
+           (mux->uref != NULL && mux->uref_size >= mux->uref_mtu);
+}
+
+/** @internal @This returns the buffer where the next TS packet of the
+ * aggregation must be written, allocating an MTU-sized block if needed.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to TS_SIZE octets, or NULL in case of allocation failure
+ */
+static uint8_t *upipe_ts_mux_slot(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    if (mux->uref != NULL && !mux->uref_size && mux->uref_mtu != mux->mtu) {
+        /* the MTU changed since the allocation */
+        uref_block_unmap(mux->uref, 0);
+        uref_free(mux->uref);
+        mux->uref = NULL;
+    }
+
     if (mux->uref == NULL) {
-        mux->uref = uref_alloc(mux->uref_mgr);
-        if (unlikely(mux->uref == NULL)) {
+        mux->uref = uref_block_alloc(mux->uref_mgr, mux->ubuf_mgr, mux->mtu);
+        int size = -1;
+        if (unlikely(mux->uref == NULL ||
+                     !ubase_check(uref_block_write(mux->uref, 0, &size,
+                                                   &mux->uref_buffer)))) {
+            uref_free(mux->uref);
+            mux->uref = NULL;
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            ubuf_free(ubuf);
-            return;
+            return NULL;
+        }
+        if (unlikely(size != mux->mtu)) {
+            /* the ubuf manager didn't give a single segment */
+            uref_block_unmap(mux->uref, 0);
+            uref_free(mux->uref);
+            mux->uref = NULL;
+            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+            return NULL;
         }
+        mux->uref_mtu = mux->mtu;
+    }
+    return mux->uref_buffer + mux->uref_size;
+}
+
+/** @internal @This accounts for a TS packet written into the aggregation.
+ *
+ * @param upipe description structure of the pipe
+ * @param dts_sys dts_sys associated with the packet
+ */
+static void upipe_ts_mux_append(struct upipe *upipe, uint64_t dts_sys)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    if (!mux->uref_size) {
         uref_clock_set_cr_sys(mux->uref, mux->cr_sys - mux->latency);
         if (dts_sys != UINT64_MAX)
             uref_clock_set_cr_dts_delay(mux->uref,
                     dts_sys - (mux->cr_sys - mux->latency));
-        uref_attach_ubuf(mux->uref, ubuf);
     } else {
         uint64_t current_dts_sys;
         if (dts_sys != UINT64_MAX &&
@@ -2890,11 +3074,53 @@ static void upipe_ts_mux_append(struct upipe *upipe, struct ubuf *ubuf,
              current_dts_sys > dts_sys))
             uref_clock_set_cr_dts_delay(mux->uref,
                     dts_sys - (mux->cr_sys - mux->latency));
-        uref_block_append(mux->uref, ubuf);
     }
     mux->uref_size += TS_SIZE;
 }
 
+/** @internal @This appends a TS packet of padding to the aggregation.
+ *
+ * @param upipe description structure of the pipe
+ * @return false in case of allocation failure
+ */
+static bool upipe_ts_mux_append_padding(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    uint8_t *buffer = upipe_ts_mux_slot(upipe);
+    if (unlikely(buffer == NULL))
+        return false;
+    ts_pad(buffer);
+    upipe_ts_mux_append(upipe, UINT64_MAX);
+    mux->spare_packets++;
+    return true;
+}
+
+/** @internal @This reports the octetrate spent in padding, so that the
+ * application may hand it over to the encoders (statistical multiplexing).
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_mux_check_spare(struct upipe *upipe)
+{
+    struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
+    if (unlikely(mux->cr_sys == UINT64_MAX))
+        return;
+    if (mux->spare_cr_sys == UINT64_MAX || mux->cr_sys < mux->spare_cr_sys) {
+        mux->spare_cr_sys = mux->cr_sys;
+        mux->spare_packets = 0;
+        return;
+    }
+    if (mux->cr_sys - mux->spare_cr_sys < SPARE_OCTETRATE_INTERVAL)
+        return;
+
+    uint64_t spare_octetrate = mux->spare_packets * TS_SIZE * UCLOCK_FREQ /
+                               (mux->cr_sys - mux->spare_cr_sys);
+    mux->spare_cr_sys = mux->cr_sys;
+    mux->spare_packets = 0;
+    upipe_throw(upipe, UPROBE_TS_MUX_SPARE_OCTETRATE, UPIPE_TS_MUX_SIGNATURE,
+                spare_octetrate, mux->total_octetrate);
+}
+
 /** @internal @This completes a uref and outputs it.
  *
  * @param upipe description structure of the pipe
@@ -2904,8 +3130,13 @@ static void upipe_ts_mux_complete(struct upipe *upipe, struct upump **upump_p)
 {
     struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
     struct uref *uref = mux->uref;
+    uref_block_unmap(uref, 0);
+    if (mux->uref_size < mux->uref_mtu)
+        uref_block_resize(uref, 0, mux->uref_size);
     mux->uref = NULL;
+    mux->uref_buffer = NULL;
     mux->uref_size = 0;
+    upipe_ts_mux_check_spare(upipe);
     upipe_ts_mux_output(upipe, uref, upump_p);
 }
 
@@ -2925,14 +3156,14 @@ static void _upipe_ts_mux_watcher(struct upipe *upipe)
         if (mux->uref != NULL) /* capped VBR */
             uref_clock_set_cr_sys(mux->uref, mux->cr_sys - mux->latency);
 
-        while (mux->uref_size < mux->mtu) {
+        while (!upipe_ts_mux_full(upipe)) {
             nb_packets++;
-            struct ubuf *ubuf;
+            uint8_t *buffer = upipe_ts_mux_slot(upipe);
             uint64_t dts_sys;
-            upipe_ts_mux_splice(upipe, &ubuf, &dts_sys);
-            if (ubuf == NULL)
+            if (unlikely(buffer == NULL) ||
+                !upipe_ts_mux_splice(upipe, buffer, &dts_sys))
                 break;
-            upipe_ts_mux_append(upipe, ubuf, dts_sys);
+            upipe_ts_mux_append(upipe, dts_sys);
         }
 
         uint64_t dts_sys;
@@ -2940,16 +3171,14 @@ static void _upipe_ts_mux_watcher(struct upipe *upipe)
             (mux->uref != NULL &&
              ubase_check(uref_clock_get_dts_sys(mux->uref, &dts_sys)) &&
              dts_sys + mux->latency < upipe_ts_mux_show_increment(upipe))) {
-            while (mux->uref_size < mux->mtu) {
+            while (!upipe_ts_mux_full(upipe)) {
                 nb_packets++;
-                struct ubuf *ubuf = ubuf_dup(mux->padding);
-                if (ubuf == NULL)
+                if (!upipe_ts_mux_append_padding(upipe))
                     break;
-                upipe_ts_mux_append(upipe, ubuf, UINT64_MAX);
             }
         }
 
-        if (mux->uref_size >= mux->mtu)
+        if (upipe_ts_mux_full(upipe))
             upipe_ts_mux_complete(upipe, &mux->upump);
     }
 
@@ -3054,12 +3283,13 @@ static void upipe_ts_mux_work_file(struct upipe *upipe, struct upump **upump_p)
             upipe_ts_mux_prepare_psi(upipe, min_cr_sys, 0);
         }
 
-        struct ubuf *ubuf;
+        uint8_t *buffer = upipe_ts_mux_slot(upipe);
+        if (unlikely(buffer == NULL))
+            break;
         uint64_t dts_sys;
-        upipe_ts_mux_splice(upipe, &ubuf, &dts_sys);
-        if (ubuf != NULL) {
-            upipe_ts_mux_append(upipe, ubuf, dts_sys);
-            if (mux->uref_size >= mux->mtu) {
+        if (upipe_ts_mux_splice(upipe, buffer, &dts_sys)) {
+            upipe_ts_mux_append(upipe, dts_sys);
+            if (upipe_ts_mux_full(upipe)) {
                 upipe_ts_mux_complete(upipe, &mux->upump);
                 upipe_ts_mux_increment(upipe);
             }
@@ -3074,14 +3304,12 @@ static void upipe_ts_mux_work_file(struct upipe *upipe, struct upump **upump_p)
             continue;
         }
 
-        while (mux->uref_size < mux->mtu) {
-            struct ubuf *ubuf = ubuf_dup(mux->padding);
-            if (ubuf == NULL)
+        while (!upipe_ts_mux_full(upipe))
+            if (!upipe_ts_mux_append_padding(upipe))
                 break;
-            upipe_ts_mux_append(upipe, ubuf, UINT64_MAX);
-        }
 
-        upipe_ts_mux_complete(upipe, upump_p);
+        if (mux->uref_size)
+            upipe_ts_mux_complete(upipe, upump_p);
         upipe_ts_mux_increment(upipe);
     }
 #ifdef DEBUG_FILE
@@ -3145,7 +3373,7 @@ static void upipe_ts_mux_work_live(struct upipe *upipe, struct upump **upump_p)
 static void upipe_ts_mux_work(struct upipe *upipe, struct upump **upump_p)
 {
     struct upipe_ts_mux *mux = upipe_ts_mux_from_upipe(upipe);
-    if (unlikely(mux->flow_def == NULL || mux->padding == NULL ||
+    if (unlikely(mux->flow_def == NULL || mux->ubuf_mgr == NULL ||
                  !mux->interval))
         return;
 
@@ -3211,26 +3439,6 @@ static int upipe_ts_mux_check(struct upipe *upipe, struct uref *flow_format)
         return UBASE_ERR_NONE;
     }
 
-    if (mux->padding == NULL) {
-        mux->padding = ubuf_block_alloc(mux->ubuf_mgr, TS_SIZE);
-        if (unlikely(mux->padding == NULL)) {
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            return UBASE_ERR_ALLOC;
-        }
-
-        uint8_t *buffer;
-        int size = -1;
-        if (unlikely(!ubase_check(ubuf_block_write(mux->padding, 0, &size,
-                                                   &buffer)))) {
-            ubuf_free(mux->padding);
-            mux->padding = NULL;
-            return UBASE_ERR_ALLOC;
-        }
-        assert(size == TS_SIZE);
-        ts_pad(buffer);
-        ubuf_block_unmap(mux->padding, 0);
-    }
-
     if (mux->live && mux->sig != NULL)
         upipe_ts_mux_set_tdt_interval(mux->sig, mux->tdt_interval);
 
@@ -3335,6 +3543,7 @@ static void upipe_ts_mux_update(struct upipe *upipe)
     if (mux->total_octetrate) {
         mux->interval = (mux->mtu * UCLOCK_FREQ + mux->total_octetrate - 1) /
                         mux->total_octetrate;
+        upipe_ts_mux_schedule_inputs(upipe);
         upipe_ts_mux_set_pat_interval(mux->psig,
                 mux->interval < mux->pat_interval / 2 ?
                 mux->pat_interval - (mux->pat_interval % mux->interval) :
@@ -3716,10 +3925,12 @@ static int upipe_ts_mux_set_output_size(struct upipe *upipe, unsigned int mtu)
         return UBASE_ERR_INVALID;
     mtu -= mtu % TS_SIZE;
     upipe_ts_mux->mtu = mtu;
-    if (upipe_ts_mux->total_octetrate)
+    if (upipe_ts_mux->total_octetrate) {
         upipe_ts_mux->interval = (upipe_ts_mux->mtu * UCLOCK_FREQ +
                                   upipe_ts_mux->total_octetrate - 1) /
                                  upipe_ts_mux->total_octetrate;
+        upipe_ts_mux_schedule_inputs(upipe);
+    }
 
     upipe_ts_mux->tb_size = T_STD_TS_BUFFER + mtu - TS_SIZE;
 
@@ -4675,23 +4886,21 @@ static void upipe_ts_mux_free(struct urefcount *urefcount_real)
     struct upipe_ts_mux *mux = upipe_ts_mux_from_urefcount_real(urefcount_real);
     struct upipe *upipe = upipe_ts_mux_to_upipe(mux);
 
-    if (mux->uref != NULL) {
-        size_t uref_size;
-        while ((ubase_check(uref_block_size(mux->uref, &uref_size)) &&
-                uref_size < mux->mtu)) {
-            struct ubuf *ubuf = ubuf_dup(mux->padding);
-            if (ubuf == NULL)
+    if (mux->uref != NULL && mux->uref_size) {
+        while (!upipe_ts_mux_full(upipe))
+            if (!upipe_ts_mux_append_padding(upipe))
                 break;
-            upipe_ts_mux_append(upipe, ubuf, UINT64_MAX);
-        }
 
         upipe_ts_mux_complete(upipe, NULL);
+    } else if (mux->uref != NULL) {
+        uref_block_unmap(mux->uref, 0);
+        uref_free(mux->uref);
     }
 
     upipe_throw_dead(upipe);
 
-    ubuf_free(mux->padding);
     uref_free(mux->flow_def_input);
+    uheap_clean(&mux->inputs_heap);
     uprobe_clean(&mux->probe);
     urefcount_clean(urefcount_real);
     upipe_ts_mux_clean_inner_sink(upipe);
@@ -4842,6 +5051,9 @@ const char *upipe_ts_mux_command_str(int cmd)
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_ENCODING);
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_FREEZE_PSI);
         UBASE_CASE_TO_STR(UPIPE_TS_MUX_PREPARE);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_MAX_OCTETRATE);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_GET_SLICES);
+        UBASE_CASE_TO_STR(UPIPE_TS_MUX_SET_SLICES);
         default: break;
     }
     return NULL;
@@ -4856,6 +5068,7 @@ const char *upipe_ts_mux_event_str(int event)
 {
     switch (event) {
         UBASE_CASE_TO_STR(UPROBE_TS_MUX_LAST_CC);
+        UBASE_CASE_TO_STR(UPROBE_TS_MUX_SPARE_OCTETRATE);
         default: break;
     }
     return NULL;
@@ -39,6 +39,7 @@
 #include "upipe-ts/upipe_ts_nit_decoder.h"
 #include "upipe-ts/uref_ts_flow.h"
 #include "upipe_ts_psi_decoder.h"
+#include "upipe_ts_crc32.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -190,7 +191,7 @@ static bool upipe_ts_nitd_table_validate(struct upipe *upipe)
                                                   &section))))
             return false;
 
-        if (!nit_validate(section) || !psi_check_crc(section)) {
+        if (!nit_validate(section) || !upipe_ts_psi_check_crc(section)) {
             uref_block_unmap(section_uref, 0);
             return false;
         }
@@ -309,6 +310,12 @@ static void upipe_ts_nitd_input(struct upipe *upipe, struct uref *uref,
     struct upipe_ts_nitd *upipe_ts_nitd = upipe_ts_nitd_from_upipe(upipe);
     assert(upipe_ts_nitd->flow_def_input != NULL);
 
+    if (upipe_ts_psid_table_repeated(upipe_ts_nitd->nit, uref)) {
+        /* Unchanged section of the current NIT. */
+        uref_free(uref);
+        return;
+    }
+
     if (!upipe_ts_psid_table_section(upipe_ts_nitd->next_nit, uref))
         return;
 
@@ -24,9 +24,12 @@
  */
 
 #include "upipe/ubase.h"
+#include "upipe/uclock.h"
 #include "upipe/uref.h"
 #include "upipe/uref_flow.h"
 #include "upipe/uref_clock.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_block_flow.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_helper_upipe.h"
 #include "upipe/upipe_helper_urefcount.h"
@@ -38,8 +41,16 @@
 #include <stdbool.h>
 #include <stdarg.h>
 
+#include <bitstream/mpeg/ts.h>
+
 /** we only accept TS packets */
 #define EXPECTED_FLOW_DEF "block.mpegts."
+/** 2^33 */
+#define POW2_33 UINT64_C(8589934592)
+/** PCR wraparound, in 27 MHz units */
+#define PCR_WRAP (POW2_33 * 300)
+/** PCR PID meaning the first PID carrying a PCR */
+#define PCR_PID_AUTO 8192
 
 /** @internal @This is the private context of a ts_pcr_interpolator pipe. */
 struct upipe_ts_pcr_interpolator {
@@ -70,6 +81,15 @@ struct upipe_ts_pcr_interpolator {
     /** if next packet output should show discontinuity */
     bool discontinuity;
 
+    /** PCR PID in multiplex mode, or -1 */
+    int pcr_pid;
+    /** true if last_pcr is valid in multiplex mode */
+    bool has_last_pcr;
+    /** offset added to PCRs to unwrap them in multiplex mode */
+    uint64_t pcr_wrap;
+    /** octetrate exported in the output flow definition */
+    uint64_t octetrate;
+
     /** public upipe structure */
     struct upipe upipe;
 };
@@ -104,11 +124,187 @@ static struct upipe *upipe_ts_pcr_interpolator_alloc(struct upipe_mgr *mgr,
     upipe_ts_pcr_interpolator->pcr_packets = 0;
     upipe_ts_pcr_interpolator->pcr_delta = 0;
     upipe_ts_pcr_interpolator->discontinuity = true;
+    upipe_ts_pcr_interpolator->pcr_pid = -1;
+    upipe_ts_pcr_interpolator->has_last_pcr = false;
+    upipe_ts_pcr_interpolator->pcr_wrap = 0;
+    upipe_ts_pcr_interpolator->octetrate = 0;
 
     upipe_throw_ready(upipe);
     return upipe;
 }
 
+/** @internal @This resets the interpolation state of the multiplex mode.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_pcr_interpolator_reset_mux(struct upipe *upipe)
+{
+    struct upipe_ts_pcr_interpolator *upipe_ts_pcr_interpolator = upipe_ts_pcr_interpolator_from_upipe(upipe);
+    upipe_ts_pcr_interpolator->last_pcr = 0;
+    upipe_ts_pcr_interpolator->packets = 0;
+    upipe_ts_pcr_interpolator->pcr_packets = 0;
+    upipe_ts_pcr_interpolator->pcr_delta = 0;
+    upipe_ts_pcr_interpolator->has_last_pcr = false;
+    upipe_ts_pcr_interpolator->pcr_wrap = 0;
+    upipe_ts_pcr_interpolator->discontinuity = true;
+}
+
+/** @internal @This takes into account a new PCR in multiplex mode.
+ *
+ * @param upipe description structure of the pipe
+ * @param pcr PCR value in 27 MHz units
+ */
+static void upipe_ts_pcr_interpolator_mux_pcr(struct upipe *upipe,
+                                              uint64_t pcr)
+{
+    struct upipe_ts_pcr_interpolator *upipe_ts_pcr_interpolator = upipe_ts_pcr_interpolator_from_upipe(upipe);
+    uint64_t prog = pcr + upipe_ts_pcr_interpolator->pcr_wrap;
+
+    if (upipe_ts_pcr_interpolator->has_last_pcr) {
+        if (prog + PCR_WRAP / 2 < upipe_ts_pcr_interpolator->last_pcr) {
+            upipe_ts_pcr_interpolator->pcr_wrap += PCR_WRAP;
+            prog += PCR_WRAP;
+        }
+        if (unlikely(prog <= upipe_ts_pcr_interpolator->last_pcr ||
+                     !upipe_ts_pcr_interpolator->packets)) {
+            upipe_warn_va(upipe, "PCR going backwards, clearing state");
+            upipe_ts_pcr_interpolator_reset_mux(upipe);
+            prog = pcr;
+        } else {
+            upipe_ts_pcr_interpolator->pcr_delta =
+                prog - upipe_ts_pcr_interpolator->last_pcr;
+            upipe_ts_pcr_interpolator->pcr_packets =
+                upipe_ts_pcr_interpolator->packets;
+        }
+    }
+
+    upipe_ts_pcr_interpolator->last_pcr = prog;
+    upipe_ts_pcr_interpolator->has_last_pcr = true;
+    upipe_ts_pcr_interpolator->packets = 0;
+}
+
+/** @internal @This exports the current octetrate in the output flow
+ * definition, if it changed by more than 1%.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_pcr_interpolator_update_octetrate(struct upipe *upipe)
+{
+    struct upipe_ts_pcr_interpolator *upipe_ts_pcr_interpolator = upipe_ts_pcr_interpolator_from_upipe(upipe);
+    if (upipe_ts_pcr_interpolator->flow_def == NULL)
+        return;
+
+    uint64_t octetrate = (uint64_t)upipe_ts_pcr_interpolator->pcr_packets *
+        TS_SIZE * UCLOCK_FREQ / upipe_ts_pcr_interpolator->pcr_delta;
+    uint64_t last = upipe_ts_pcr_interpolator->octetrate;
+    if (last && octetrate * 100 <= last * 101 && octetrate * 100 >= last * 99)
+        return;
+
+    struct uref *flow_def = uref_dup(upipe_ts_pcr_interpolator->flow_def);
+    if (unlikely(flow_def == NULL)) {
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    UBASE_FATAL(upipe, uref_block_flow_set_octetrate(flow_def, octetrate))
+    upipe_ts_pcr_interpolator->octetrate = octetrate;
+    upipe_ts_pcr_interpolator_store_flow_def(upipe, flow_def);
+}
+
+/** @internal @This interpolates the cr_prog of blocks of TS packets of a
+ * whole multiplex, from the PCRs of a given PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_pcr_interpolator_input_mux(struct upipe *upipe,
+                                                struct uref *uref,
+                                                struct upump **upump_p)
+{
+    struct upipe_ts_pcr_interpolator *upipe_ts_pcr_interpolator = upipe_ts_pcr_interpolator_from_upipe(upipe);
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)) ||
+                 !size || size % TS_SIZE)) {
+        upipe_warn(upipe, "invalid TS block");
+        uref_free(uref);
+        return;
+    }
+
+    if (ubase_check(uref_flow_get_discontinuity(uref))) {
+        upipe_ts_pcr_interpolator_reset_mux(upipe);
+        upipe_notice_va(upipe, "Clearing state");
+    }
+
+    bool dated = false;
+    uint64_t cr_prog = 0;
+    for (size_t offset = 0; offset < size; offset += TS_SIZE) {
+        uint8_t buffer[TS_HEADER_SIZE_PCR];
+        const uint8_t *ts_header = uref_block_peek(uref, offset,
+                                                   TS_HEADER_SIZE_PCR, buffer);
+        if (unlikely(ts_header == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            uref_free(uref);
+            return;
+        }
+        uint16_t pid = ts_get_pid(ts_header);
+        bool has_af = ts_has_adaptation(ts_header) &&
+                      ts_get_adaptation(ts_header);
+        bool has_pcr = has_af &&
+            ts_get_adaptation(ts_header) >=
+                TS_HEADER_SIZE_PCR - TS_HEADER_SIZE - 1 &&
+            tsaf_has_pcr(ts_header);
+        bool discontinuity = has_af && tsaf_has_discontinuity(ts_header);
+        uint64_t pcr = has_pcr ?
+            tsaf_get_pcr(ts_header) * 300 + tsaf_get_pcrext(ts_header) : 0;
+        UBASE_FATAL(upipe, uref_block_peek_unmap(uref, offset, buffer,
+                                                 ts_header))
+
+        if (has_pcr &&
+            upipe_ts_pcr_interpolator->pcr_pid == PCR_PID_AUTO) {
+            upipe_notice_va(upipe, "using PCR PID %"PRIu16, pid);
+            upipe_ts_pcr_interpolator->pcr_pid = pid;
+        }
+        has_pcr = has_pcr && pid == upipe_ts_pcr_interpolator->pcr_pid;
+
+        upipe_ts_pcr_interpolator->packets++;
+        if (has_pcr) {
+            if (unlikely(discontinuity)) {
+                upipe_warn(upipe, "PCR discontinuity flagged");
+                upipe_ts_pcr_interpolator_reset_mux(upipe);
+            }
+            upipe_ts_pcr_interpolator_mux_pcr(upipe, pcr);
+        }
+
+        if (offset)
+            continue;
+        if (has_pcr) {
+            cr_prog = upipe_ts_pcr_interpolator->last_pcr;
+            dated = true;
+        } else if (upipe_ts_pcr_interpolator->pcr_packets) {
+            cr_prog = upipe_ts_pcr_interpolator->last_pcr +
+                upipe_ts_pcr_interpolator->pcr_delta *
+                upipe_ts_pcr_interpolator->packets /
+                upipe_ts_pcr_interpolator->pcr_packets;
+            dated = true;
+        }
+    }
+
+    if (!dated || !upipe_ts_pcr_interpolator->pcr_packets) {
+        uref_free(uref);
+        return;
+    }
+
+    uref_clock_set_date_prog(uref, cr_prog, UREF_DATE_CR);
+    upipe_throw_clock_ts(upipe, uref);
+    upipe_ts_pcr_interpolator_update_octetrate(upipe);
+
+    if (upipe_ts_pcr_interpolator->discontinuity) {
+        uref_flow_set_discontinuity(uref);
+        upipe_ts_pcr_interpolator->discontinuity = false;
+    }
+    upipe_ts_pcr_interpolator_output(upipe, uref, upump_p);
+}
+
 /** @internal @This interpolates the PCRs for packets without a PCR.
  *
  * @param upipe description structure of the pipe
@@ -119,6 +315,11 @@ static void upipe_ts_pcr_interpolator_input(struct upipe *upipe, struct uref *ur
                                   struct upump **upump_p)
 {
     struct upipe_ts_pcr_interpolator *upipe_ts_pcr_interpolator = upipe_ts_pcr_interpolator_from_upipe(upipe);
+    if (upipe_ts_pcr_interpolator->pcr_pid >= 0) {
+        upipe_ts_pcr_interpolator_input_mux(upipe, uref, upump_p);
+        return;
+    }
+
     bool discontinuity = ubase_check(uref_flow_get_discontinuity(uref));
     if (discontinuity) {
         upipe_ts_pcr_interpolator->last_pcr = 0;
@@ -220,6 +421,15 @@ static int upipe_ts_pcr_interpolator_control(struct upipe *upipe,
             urational->den = upipe_ts_pcr_interpolator->pcr_delta;
             return UBASE_ERR_NONE;
         }
+        case UPIPE_TS_PCR_INTERPOLATOR_SET_PCR_PID: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_PCR_INTERPOLATOR_SIGNATURE)
+            int pid = va_arg(args, int);
+            if (pid < -1 || pid > PCR_PID_AUTO)
+                return UBASE_ERR_INVALID;
+            upipe_ts_pcr_interpolator->pcr_pid = pid;
+            upipe_ts_pcr_interpolator_reset_mux(upipe);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -40,6 +40,7 @@
 #include <stdbool.h>
 #include <stdarg.h>
 #include <string.h>
+#include <assert.h>
 
 #include <bitstream/mpeg/pes.h>
 
@@ -151,7 +152,9 @@ static void upipe_ts_pesd_check_output(struct upipe *upipe,
     upipe_ts_pesd->next_uref = NULL;
 }
 
-/** @internal @This parses and removes the PES header of a packet.
+/** @internal @This parses and removes the PES header of a packet. The
+ * header, up to the timestamps, is mapped only once and parsed in place; it
+ * is only copied if it straddles several TS payloads.
  *
  * @param upipe description structure of the pipe
  * @param upump_p reference to pump that generated the buffer
@@ -159,15 +162,32 @@ static void upipe_ts_pesd_check_output(struct upipe *upipe,
 static void upipe_ts_pesd_decaps(struct upipe *upipe, struct upump **upump_p)
 {
     struct upipe_ts_pesd *upipe_ts_pesd = upipe_ts_pesd_from_upipe(upipe);
-    uint8_t buffer[PES_HEADER_SIZE];
+    size_t size = upipe_ts_pesd->next_uref_size;
+    if (size > PES_HEADER_SIZE_PTSDTS)
+        size = PES_HEADER_SIZE_PTSDTS;
+    if (unlikely(size < PES_HEADER_SIZE))
+        return;
+
+    uint8_t buffer[PES_HEADER_SIZE_PTSDTS];
     const uint8_t *pes_header = uref_block_peek(upipe_ts_pesd->next_uref,
-                                                0, PES_HEADER_SIZE, buffer);
+                                                0, size, buffer);
     if (unlikely(pes_header == NULL))
         return;
 
     bool validate = pes_validate(pes_header);
     uint8_t streamid = pes_get_streamid(pes_header);
     uint16_t length = pes_get_length(pes_header);
+    bool has_optional = size >= PES_HEADER_SIZE_NOPTS;
+    bool validate_header = has_optional && pes_validate_header(pes_header);
+    bool has_pts = has_optional && pes_has_pts(pes_header);
+    bool has_dts = has_optional && pes_has_dts(pes_header);
+    uint8_t headerlength = has_optional ? pes_get_headerlength(pes_header) : 0;
+    bool has_ts = has_pts && size >= PES_HEADER_SIZE_NOPTS +
+                                     PES_HEADER_TS_SIZE * (has_dts ? 2 : 1);
+    bool validate_ts = has_ts && pes_validate_pts(pes_header) &&
+                       (!has_dts || pes_validate_dts(pes_header));
+    uint64_t pts = has_ts ? pes_get_pts(pes_header) : 0;
+    uint64_t dts = has_ts && has_dts ? pes_get_dts(pes_header) : pts;
     UBASE_FATAL(upipe, uref_block_peek_unmap(upipe_ts_pesd->next_uref, 0,
                                              buffer, pes_header))
 
@@ -206,20 +226,10 @@ static void upipe_ts_pesd_decaps(struct upipe *upipe, struct upump **upump_p)
         return;
     }
 
-    uint8_t buffer2[PES_HEADER_SIZE_NOPTS - PES_HEADER_SIZE];
-    pes_header = uref_block_peek(upipe_ts_pesd->next_uref, PES_HEADER_SIZE,
-                                 PES_HEADER_OPTIONAL_SIZE, buffer2);
-    if (unlikely(pes_header == NULL))
+    if (unlikely(!has_optional))
         return;
 
-    validate = pes_validate_header(pes_header - PES_HEADER_SIZE);
-    bool has_pts = pes_has_pts(pes_header - PES_HEADER_SIZE);
-    bool has_dts = pes_has_dts(pes_header - PES_HEADER_SIZE);
-    uint8_t headerlength = pes_get_headerlength(pes_header - PES_HEADER_SIZE);
-    UBASE_FATAL(upipe, uref_block_peek_unmap(upipe_ts_pesd->next_uref,
-                PES_HEADER_SIZE, buffer2, pes_header))
-
-    if (unlikely(!validate)) {
+    if (unlikely(!validate_header)) {
         upipe_warn(upipe, "wrong PES optional header");
         upipe_ts_pesd_flush(upipe, true);
         return;
@@ -240,29 +250,9 @@ static void upipe_ts_pesd_decaps(struct upipe *upipe, struct upump **upump_p)
         return;
 
     if (has_pts) {
-        uint8_t buffer3[PES_HEADER_TS_SIZE * 2];
-        uint64_t pts, dts;
-        const uint8_t *ts_fields = uref_block_peek(upipe_ts_pesd->next_uref,
-                PES_HEADER_SIZE_NOPTS, PES_HEADER_TS_SIZE * (has_dts ? 2 : 1),
-                buffer3);
-        if (unlikely(ts_fields == NULL)) {
-            upipe_ts_pesd_flush(upipe, false);
-            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-            return;
-        }
-
-        validate = pes_validate_pts(ts_fields - PES_HEADER_SIZE_NOPTS);
-        pts = pes_get_pts(ts_fields - PES_HEADER_SIZE_NOPTS);
-        if (has_dts) {
-            validate = validate &&
-                       pes_validate_dts(ts_fields - PES_HEADER_SIZE_NOPTS);
-            dts = pes_get_dts(ts_fields - PES_HEADER_SIZE_NOPTS);
-        } else
-            dts = pts;
-        UBASE_FATAL(upipe, uref_block_peek_unmap(upipe_ts_pesd->next_uref,
-                                    PES_HEADER_SIZE_NOPTS, buffer3, ts_fields))
-
-        if (unlikely(!validate)) {
+        /* the whole header is there, so the timestamps were mapped */
+        assert(has_ts);
+        if (unlikely(!validate_ts)) {
             upipe_warn(upipe, "wrong PES timestamp syntax");
 #if 0
             /* disable this because it is a common syntax error */
@@ -49,6 +49,42 @@ static inline bool upipe_ts_psid_equal(struct uref *section1,
     return ubase_check(uref_block_equal(section1, section2));
 }
 
+/** @This checks whether a PSI section is a repetition of another one, by
+ * only comparing their sizes, syntax headers and CRC32 fields. This avoids
+ * mapping, merging and comparing whole sections that are carried over and
+ * over again without modification.
+ *
+ * @param section1 PSI section 1
+ * @param section2 PSI section 2
+ * @return true if the section is a repetition
+ */
+static inline bool upipe_ts_psid_repeated(struct uref *section1,
+                                          struct uref *section2)
+{
+    size_t size1, size2;
+    if (!ubase_check(uref_block_size(section1, &size1)) ||
+        !ubase_check(uref_block_size(section2, &size2)) ||
+        size1 != size2 || size1 < PSI_HEADER_SIZE_SYNTAX1 + PSI_CRC_SIZE)
+        return false;
+
+    uint8_t header1[PSI_HEADER_SIZE_SYNTAX1], header2[PSI_HEADER_SIZE_SYNTAX1];
+    uint8_t crc1[PSI_CRC_SIZE], crc2[PSI_CRC_SIZE];
+    if (!ubase_check(uref_block_extract(section1, 0, PSI_HEADER_SIZE_SYNTAX1,
+                                        header1)) ||
+        !ubase_check(uref_block_extract(section2, 0, PSI_HEADER_SIZE_SYNTAX1,
+                                        header2)) ||
+        !ubase_check(uref_block_extract(section1, size1 - PSI_CRC_SIZE,
+                                        PSI_CRC_SIZE, crc1)) ||
+        !ubase_check(uref_block_extract(section2, size2 - PSI_CRC_SIZE,
+                                        PSI_CRC_SIZE, crc2)))
+        return false;
+
+    /* sections without syntax do not carry a CRC */
+    return psi_get_syntax(header1) &&
+           !memcmp(header1, header2, PSI_HEADER_SIZE_SYNTAX1) &&
+           !memcmp(crc1, crc2, PSI_CRC_SIZE);
+}
+
 /** @This declares a PSI table in a structure.
  *
  * @param table name of the member
@@ -194,6 +230,28 @@ static inline bool upipe_ts_psid_table_section(struct uref **sections,
     return true;
 }
 
+/** @This checks whether a section is a repetition of the section with the
+ * same number in a valid PSI table (see @ref upipe_ts_psid_repeated).
+ *
+ * @param sections PSI table
+ * @param uref new section
+ * @return true if the section is a repetition
+ */
+static inline bool upipe_ts_psid_table_repeated(struct uref **sections,
+                                                struct uref *uref)
+{
+    if (!upipe_ts_psid_table_validate(sections))
+        return false;
+
+    uint8_t header[PSI_HEADER_SIZE_SYNTAX1];
+    if (unlikely(!ubase_check(uref_block_extract(uref, 0,
+                        PSI_HEADER_SIZE_SYNTAX1, header))))
+        return false;
+
+    struct uref *section = sections[psi_get_section(header)];
+    return section != NULL && upipe_ts_psid_repeated(section, uref);
+}
+
 /** @This returns a section from a PSI table.
  *
  * @param sections PSI table
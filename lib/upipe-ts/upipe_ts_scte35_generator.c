@@ -54,6 +54,7 @@
 #include <bitstream/scte/35.h>
 
 #include "upipe_ts_scte_common.h"
+#include "upipe_ts_crc32.h"
 
 /** T-STD TB octet rate for PSI tables */
 #define TB_RATE_PSI 125000
@@ -72,6 +73,8 @@ struct scte35_message {
     struct ubuf *immediate;
     /** SCTE-35 cr_sys */
     uint64_t cr_sys;
+    /** splice event ID, or UINT64_MAX */
+    uint64_t event_id;
 };
 
 UBASE_FROM_TO(scte35_message, uchain, uchain, uchain);
@@ -144,6 +147,7 @@ scte35_message_new(uint64_t cr_sys)
         return NULL;
     uchain_init(&msg->uchain);
     msg->cr_sys = cr_sys;
+    msg->event_id = UINT64_MAX;
     msg->ubuf = NULL;
     msg->immediate = NULL;
     return msg;
@@ -326,7 +330,7 @@ static void upipe_ts_scte35g_input_insert(struct upipe *upipe)
         scte35_set_desclength(scte35, 0);
         psi_set_length(scte35,
                 scte35_get_descl(scte35) + PSI_CRC_SIZE - scte35 - PSI_HEADER_SIZE);
-        psi_set_crc(scte35);
+        upipe_ts_psi_set_crc(scte35);
 
         uint16_t scte35_size = psi_get_length(scte35) + PSI_HEADER_SIZE;
         ubuf_block_unmap(ubuf, 0);
@@ -341,6 +345,16 @@ static void upipe_ts_scte35g_input_insert(struct upipe *upipe)
         pts_prog = UINT64_MAX;
     }
 
+    /* the new sections supersede the ones cached for the same event */
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach(&scte35g->scte35_sections, uchain, uchain_tmp) {
+        struct scte35_message *prev = scte35_message_from_uchain(uchain);
+        if (prev->event_id == event_id) {
+            ulist_delete(uchain);
+            scte35_message_del(prev);
+        }
+    }
+    msg->event_id = event_id;
     ulist_add(&scte35g->scte35_sections, &msg->uchain);
 
     /* Force sending the table immediately */
@@ -432,7 +446,7 @@ static void upipe_ts_scte35g_time_signal(struct upipe *upipe)
         psi_set_length(scte35,
                 scte35_get_descl(scte35) + PSI_CRC_SIZE - scte35 - PSI_HEADER_SIZE +
                 descl_length);
-        psi_set_crc(scte35);
+        upipe_ts_psi_set_crc(scte35);
 
         uint16_t scte35_size = psi_get_length(scte35) + PSI_HEADER_SIZE;
         ubuf_block_unmap(ubuf, 0);
@@ -487,7 +501,7 @@ static void upipe_ts_scte35g_build_null(struct upipe *upipe)
     scte35_set_desclength(scte35, 0);
     psi_set_length(scte35,
             scte35_get_descl(scte35) + PSI_CRC_SIZE - scte35 - PSI_HEADER_SIZE);
-    psi_set_crc(scte35);
+    upipe_ts_psi_set_crc(scte35);
 
     uint16_t scte35_size = psi_get_length(scte35) + PSI_HEADER_SIZE;
     ubuf_block_unmap(ubuf, 0);
@@ -522,7 +536,10 @@ static void upipe_ts_scte35g_flush(struct upipe *upipe)
                 upipe_ts_scte35g_input_insert(upipe);
                 break;
             case SCTE35_NULL_COMMAND:
-                upipe_ts_scte35g_build_null(upipe);
+                /* the null section does not depend on the input, so
+                 * heartbeats reuse the cached one */
+                if (scte35g->scte35_null_section == NULL)
+                    upipe_ts_scte35g_build_null(upipe);
                 break;
             case SCTE35_TIME_SIGNAL_COMMAND:
                 upipe_ts_scte35g_time_signal(upipe);
@@ -122,6 +122,31 @@ UBASE_FROM_TO(upipe_ts_scte35p_signal, uchain, uchain, uchain)
 static void upipe_ts_scte35p_signal_trigger(struct upipe *upipe,
         struct upipe_ts_scte35p_signal *signal, uint64_t skew);
 
+/** @internal @This allocates a timer to trigger an event or a signal. Timers
+ * of the timer wheel of the event loop are preferred, as all the pending
+ * splices then share a single timer of the event loop.
+ *
+ * @param upipe description structure of the pipe
+ * @param cb function to call when the timer triggers
+ * @param opaque opaque passed to the function
+ * @param timeout time after which the timer triggers
+ * @return pointer to the allocated timer, or NULL in case of error
+ */
+static struct upump *upipe_ts_scte35p_alloc_timer(struct upipe *upipe,
+                                                  upump_cb cb, void *opaque,
+                                                  uint64_t timeout)
+{
+    struct upipe_ts_scte35p *upipe_ts_scte35p =
+        upipe_ts_scte35p_from_upipe(upipe);
+    struct upump *upump =
+        upump_alloc_wheel_timer(upipe_ts_scte35p->upump_mgr, cb, opaque,
+                                upipe->refcount, timeout, 0);
+    if (upump == NULL)
+        upump = upump_alloc_timer(upipe_ts_scte35p->upump_mgr, cb, opaque,
+                                  upipe->refcount, timeout, 0);
+    return upump;
+}
+
 /** @internal @This allocates a ts_scte35p pipe.
  *
  * @param mgr common management structure
@@ -237,13 +262,11 @@ static void upipe_ts_scte35p_event_watcher(struct upump *upump)
 static void upipe_ts_scte35p_event_wait(struct upipe *upipe,
         struct upipe_ts_scte35p_event *event, uint64_t timeout)
 {
-    struct upipe_ts_scte35p *upipe_ts_scte35p =
-        upipe_ts_scte35p_from_upipe(upipe);
     upipe_dbg_va(upipe, "splice %"PRIu64" waiting %"PRIu64" ms",
                  event->event_id, timeout * 1000 / UCLOCK_FREQ);
 
-    struct upump *watcher = upump_alloc_timer(upipe_ts_scte35p->upump_mgr,
-            upipe_ts_scte35p_event_watcher, event, upipe->refcount, timeout, 0);
+    struct upump *watcher = upipe_ts_scte35p_alloc_timer(upipe,
+            upipe_ts_scte35p_event_watcher, event, timeout);
     if (unlikely(watcher == NULL)) {
         upipe_ts_scte35p_event_free(upipe, event);
         upipe_err(upipe, "can't create watcher");
@@ -432,8 +455,6 @@ static void upipe_ts_scte35p_signal_wait(struct upipe *upipe,
                                          struct upipe_ts_scte35p_signal *signal,
                                          uint64_t timeout)
 {
-    struct upipe_ts_scte35p *upipe_ts_scte35p =
-        upipe_ts_scte35p_from_upipe(upipe);
     upipe_dbg_va(upipe, "signal waiting %"PRIu64" ms",
                  timeout * 1000 / UCLOCK_FREQ);
 
@@ -443,9 +464,8 @@ static void upipe_ts_scte35p_signal_wait(struct upipe *upipe,
     }
     signal->upump = NULL;
 
-    struct upump *watcher = upump_alloc_timer(upipe_ts_scte35p->upump_mgr,
-            upipe_ts_scte35p_signal_watcher,
-            signal, upipe->refcount, timeout, 0);
+    struct upump *watcher = upipe_ts_scte35p_alloc_timer(upipe,
+            upipe_ts_scte35p_signal_watcher, signal, timeout);
     if (unlikely(watcher == NULL)) {
         upipe_ts_scte35p_signal_free(signal);
         upipe_err(upipe, "can't create watcher");
@@ -40,6 +40,7 @@
 #include "upipe-ts/upipe_ts_sdt_decoder.h"
 #include "upipe-ts/uref_ts_flow.h"
 #include "upipe_ts_psi_decoder.h"
+#include "upipe_ts_crc32.h"
 
 #include <stdlib.h>
 #include <stdbool.h>
@@ -216,7 +217,7 @@ static bool upipe_ts_sdtd_table_validate(struct upipe *upipe)
                                                   &section))))
             return false;
 
-        if (!sdt_validate(section) || !psi_check_crc(section)) {
+        if (!sdt_validate(section) || !upipe_ts_psi_check_crc(section)) {
             uref_block_unmap(section_uref, 0);
             return false;
         }
@@ -358,6 +359,12 @@ static void upipe_ts_sdtd_input(struct upipe *upipe, struct uref *uref,
     struct upipe_ts_sdtd *upipe_ts_sdtd = upipe_ts_sdtd_from_upipe(upipe);
     assert(upipe_ts_sdtd->flow_def_input != NULL);
 
+    if (upipe_ts_psid_table_repeated(upipe_ts_sdtd->sdt, uref)) {
+        /* Unchanged section of the current SDT. */
+        uref_free(uref);
+        return;
+    }
+
     if (!upipe_ts_psid_table_section(upipe_ts_sdtd->next_sdt, uref))
         return;
 
@@ -23,6 +23,7 @@
  */
 
 #include "upipe/ulist.h"
+#include "upipe/uvector_helper.h"
 #include "upipe/uprobe.h"
 #include "upipe/uref.h"
 #include "upipe/uref_block.h"
@@ -43,15 +44,17 @@
 
 #include <bitstream/mpeg/ts.h>
 
-/** we only accept blocks containing exactly one TS packet */
+/** we only accept blocks containing whole TS packets */
 #define EXPECTED_FLOW_DEF "block.mpegts."
 /** maximum number of PIDs */
 #define MAX_PIDS 8192
+/** number of PIDs extracted at once from multi-packet blocks */
+#define BATCH_PIDS 64
 
 /** @internal @This keeps internal information about a PID. */
 struct upipe_ts_split_pid {
     /** subs specific to that PID */
-    struct uchain subs;
+    struct uvector subs;
     /** true if we asked for this PID */
     bool set;
 };
@@ -91,8 +94,6 @@ struct upipe_ts_split_sub {
     struct urefcount urefcount;
     /** structure for double-linked lists, all subs */
     struct uchain uchain;
-    /** structure for double-linked lists, PID */
-    struct uchain uchain_pid;
 
     /** pipe acting as output */
     struct upipe *output;
@@ -115,7 +116,7 @@ UPIPE_HELPER_OUTPUT(upipe_ts_split_sub, output, flow_def, output_state, request_
 UPIPE_HELPER_SUBPIPE(upipe_ts_split, upipe_ts_split_sub, sub, sub_mgr,
                      subs, uchain)
 
-UBASE_FROM_TO(upipe_ts_split_sub, uchain, uchain_pid, uchain_pid)
+UVECTOR_HELPER(upipe_ts_split_pid, subs, upipe_ts_split_sub)
 
 /** @hidden */
 static void upipe_ts_split_pid_set(struct upipe *upipe, uint16_t pid,
@@ -145,7 +146,6 @@ static struct upipe *upipe_ts_split_sub_alloc(struct upipe_mgr *mgr,
     struct upipe_ts_split_sub *upipe_ts_split_sub =
         upipe_ts_split_sub_from_upipe(upipe);
     upipe_ts_split_sub_init_urefcount(upipe);
-    uchain_init(&upipe_ts_split_sub->uchain_pid);
     upipe_ts_split_sub_init_output(upipe);
     upipe_ts_split_sub_init_sub(upipe);
     upipe_ts_split_sub_store_flow_def(upipe, flow_def);
@@ -253,7 +253,7 @@ static struct upipe *upipe_ts_split_alloc(struct upipe_mgr *mgr,
 
     int i;
     for (i = 0; i < MAX_PIDS; i++) {
-        ulist_init(&upipe_ts_split->pids[i].subs);
+        upipe_ts_split_pid_init_subs(&upipe_ts_split->pids[i]);
         upipe_ts_split->pids[i].set = false;
     }
     upipe_throw_ready(upipe);
@@ -270,7 +270,7 @@ static void upipe_ts_split_pid_check(struct upipe *upipe, uint16_t pid)
 {
     assert(pid < MAX_PIDS);
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    if (!ulist_empty(&upipe_ts_split->pids[pid].subs)) {
+    if (!uvector_empty(&upipe_ts_split->pids[pid].subs)) {
         if (!upipe_ts_split->pids[pid].set) {
             upipe_ts_split->pids[pid].set = true;
             upipe_dbg_va(upipe, "throw ts split add pid %"PRIu16, pid);
@@ -298,8 +298,11 @@ static void upipe_ts_split_pid_set(struct upipe *upipe, uint16_t pid,
 {
     assert(pid < MAX_PIDS);
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    ulist_add(&upipe_ts_split->pids[pid].subs,
-              upipe_ts_split_sub_to_uchain_pid(output));
+    int err = upipe_ts_split_pid_add_subs(&upipe_ts_split->pids[pid], output);
+    if (unlikely(!ubase_check(err))) {
+        upipe_throw_fatal(upipe, err);
+        return;
+    }
     upipe_ts_split_pid_check(upipe, pid);
 }
 
@@ -314,41 +317,28 @@ static void upipe_ts_split_pid_unset(struct upipe *upipe, uint16_t pid,
 {
     assert(pid < MAX_PIDS);
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    struct uchain *uchain, *uchain_tmp;
-    ulist_delete_foreach (&upipe_ts_split->pids[pid].subs, uchain, uchain_tmp) {
-        if (output == upipe_ts_split_sub_from_uchain_pid(uchain)) {
-            ulist_delete(uchain);
-        }
-    }
+    upipe_ts_split_pid_delete_subs(&upipe_ts_split->pids[pid], output);
     upipe_ts_split_pid_check(upipe, pid);
 }
 
-/** @internal @This demuxes a TS packet to the appropriate output(s).
+/** @internal @This outputs a uref to all the outputs of a given PID.
  *
  * @param upipe description structure of the pipe
+ * @param pid PID of the packets contained in the uref
  * @param uref uref structure
  * @param upump_p reference to pump that generated the buffer
+ * @return false in case of allocation failure
  */
-static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
-                                 struct upump **upump_p)
+static bool upipe_ts_split_dispatch(struct upipe *upipe, uint16_t pid,
+                                    struct uref *uref, struct upump **upump_p)
 {
     struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
-    uint8_t buffer[TS_HEADER_SIZE];
-    const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
-                                               buffer);
-    if (unlikely(ts_header == NULL)) {
-        uref_free(uref);
-        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-        return;
-    }
-    uint16_t pid = ts_get_pid(ts_header);
-    UBASE_FATAL(upipe, uref_block_peek_unmap(uref, 0, buffer, ts_header))
-
-    struct uchain *uchain;
-    ulist_foreach (&upipe_ts_split->pids[pid].subs, uchain) {
-        struct upipe_ts_split_sub *output =
-                upipe_ts_split_sub_from_uchain_pid(uchain);
-        if (likely(uchain->next == NULL)) {
+    struct upipe_ts_split_pid *split_pid = &upipe_ts_split->pids[pid];
+    unsigned int last = upipe_ts_split_pid_size_subs(split_pid) - 1;
+    struct upipe_ts_split_sub *output;
+    uvector_helper_foreach (upipe_ts_split_pid, subs, split_pid, output) {
+        /* the last output gets the original uref */
+        if (likely(uvector_idx == last)) {
             upipe_ts_split_sub_output(upipe_ts_split_sub_to_upipe(output),
                                       uref, upump_p);
             uref = NULL;
@@ -360,13 +350,158 @@ static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
                         new_uref, upump_p);
             else {
                 uref_free(uref);
-                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
-                return;
+                return false;
             }
         }
     }
     if (uref != NULL)
         uref_free(uref);
+    return true;
+}
+
+/** @internal @This extracts the PIDs of a number of consecutive packets.
+ * Each segment of the block is mapped once, and the headers it contains are
+ * read in place; only headers straddling two segments are copied.
+ *
+ * @param uref uref structure
+ * @param first index of the first packet
+ * @param nb number of packets
+ * @param pids array written with the PIDs
+ * @return an error code
+ */
+static int upipe_ts_split_extract_pids(struct uref *uref, unsigned int first,
+                                       unsigned int nb, uint16_t *pids)
+{
+    unsigned int i = 0;
+    while (i < nb) {
+        int offset = (first + i) * TS_SIZE;
+        int size = -1;
+        const uint8_t *buffer;
+        UBASE_RETURN(uref_block_read(uref, offset, &size, &buffer))
+        int j = 0;
+        for ( ; i < nb && j + TS_HEADER_SIZE <= size; j += TS_SIZE)
+            pids[i++] = ts_get_pid(buffer + j);
+        UBASE_RETURN(uref_block_unmap(uref, offset))
+
+        if (i < nb && j < size) {
+            /* the header is split between two segments */
+            offset = (first + i) * TS_SIZE;
+            uint8_t header[TS_HEADER_SIZE];
+            const uint8_t *ts_header = uref_block_peek(uref, offset,
+                                                       TS_HEADER_SIZE, header);
+            if (unlikely(ts_header == NULL))
+                return UBASE_ERR_INVALID;
+            pids[i++] = ts_get_pid(ts_header);
+            UBASE_RETURN(uref_block_peek_unmap(uref, offset, header,
+                                               ts_header))
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This demuxes a block containing several TS packets. Runs of
+ * consecutive packets with the same PID are output as a single uref, so
+ * the per-packet cost is reduced to reading the PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param size size of the block
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_split_input_batch(struct upipe *upipe, struct uref *uref,
+                                       size_t size, struct upump **upump_p)
+{
+    struct upipe_ts_split *upipe_ts_split = upipe_ts_split_from_upipe(upipe);
+    unsigned int nb = size / TS_SIZE;
+    if (unlikely(size % TS_SIZE))
+        upipe_warn_va(upipe, "dropping %zu trailing octets",
+                      size % TS_SIZE);
+
+    uint16_t pids[BATCH_PIDS];
+    uint16_t run_pid = MAX_PIDS;
+    unsigned int run_start = 0;
+    for (unsigned int first = 0; first < nb; first += BATCH_PIDS) {
+        unsigned int count = nb - first;
+        if (count > BATCH_PIDS)
+            count = BATCH_PIDS;
+        if (unlikely(!ubase_check(upipe_ts_split_extract_pids(uref, first,
+                                                              count, pids)))) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+            return;
+        }
+
+        for (unsigned int i = 0; i < count; i++) {
+            if (likely(pids[i] == run_pid))
+                continue;
+
+            if (run_pid != MAX_PIDS &&
+                !uvector_empty(&upipe_ts_split->pids[run_pid].subs)) {
+                struct uref *run = uref_block_splice(uref,
+                        run_start * TS_SIZE,
+                        (first + i - run_start) * TS_SIZE);
+                if (unlikely(run == NULL ||
+                             !upipe_ts_split_dispatch(upipe, run_pid, run,
+                                                      upump_p))) {
+                    uref_free(uref);
+                    upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                    return;
+                }
+            }
+            run_pid = pids[i];
+            run_start = first + i;
+        }
+    }
+
+    /* the last run reuses the original uref */
+    if (run_pid == MAX_PIDS ||
+        uvector_empty(&upipe_ts_split->pids[run_pid].subs)) {
+        uref_free(uref);
+        return;
+    }
+    if (unlikely(!ubase_check(uref_block_resize(uref, run_start * TS_SIZE,
+                        (nb - run_start) * TS_SIZE)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        return;
+    }
+    if (unlikely(!upipe_ts_split_dispatch(upipe, run_pid, uref, upump_p)))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+}
+
+/** @internal @This demuxes TS packets to the appropriate output(s).
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_split_input(struct upipe *upipe, struct uref *uref,
+                                 struct upump **upump_p)
+{
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_INVALID);
+        return;
+    }
+    if (unlikely(size > TS_SIZE)) {
+        upipe_ts_split_input_batch(upipe, uref, size, upump_p);
+        return;
+    }
+
+    uint8_t buffer[TS_HEADER_SIZE];
+    const uint8_t *ts_header = uref_block_peek(uref, 0, TS_HEADER_SIZE,
+                                               buffer);
+    if (unlikely(ts_header == NULL)) {
+        uref_free(uref);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uint16_t pid = ts_get_pid(ts_header);
+    UBASE_FATAL(upipe, uref_block_peek_unmap(uref, 0, buffer, ts_header))
+
+    if (unlikely(!upipe_ts_split_dispatch(upipe, pid, uref, upump_p)))
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
 }
 
 /** @internal @This sets the input flow definition.
@@ -425,6 +560,8 @@ static void upipe_ts_split_free(struct urefcount *urefcount_real)
     struct upipe *upipe = upipe_ts_split_to_upipe(upipe_ts_split);
     upipe_throw_dead(upipe);
     upipe_ts_split_clean_sub_subs(upipe);
+    for (int i = 0; i < MAX_PIDS; i++)
+        upipe_ts_split_pid_clean_subs(&upipe_ts_split->pids[i]);
     urefcount_clean(urefcount_real);
     upipe_ts_split_clean_urefcount(upipe);
     upipe_ts_split_free_void(upipe);
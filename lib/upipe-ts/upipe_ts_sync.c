@@ -58,6 +58,8 @@
 #define EXPECTED_FLOW_DEF "block."
 /** when configured with standard TS size, we output TS packets */
 #define OUTPUT_FLOW_DEF "block.mpegts."
+/** or blocks of several TS packets in packed mode */
+#define PACKED_OUTPUT_FLOW_DEF "block.mpegts.packed."
 /** otherwise there is a suffix to decaps */
 #define SUFFIX_OUTPUT_FLOW_DEF "block.mpegtssuffix."
 /** TS synchronization word */
@@ -89,6 +91,8 @@ struct upipe_ts_sync {
     struct uchain urefs;
     /** true if we have thrown the sync_acquired event */
     bool acquired;
+    /** true if blocks of several packets are output */
+    bool packed;
 
     /** public upipe structure */
     struct upipe upipe;
@@ -127,6 +131,7 @@ static struct upipe *upipe_ts_sync_alloc(struct upipe_mgr *mgr,
     upipe_ts_sync_init_output_size(upipe, TS_SIZE);
     upipe_ts_sync->ts_sync = DEFAULT_TS_SYNC;
     upipe_ts_sync->next_uref = NULL;
+    upipe_ts_sync->packed = false;
     ulist_init(&upipe_ts_sync->urefs);
     upipe_throw_ready(upipe);
     return upipe;
@@ -174,6 +179,32 @@ static bool upipe_ts_sync_check(struct upipe *upipe, size_t *offset_p)
     return true;
 }
 
+/** @internal @This returns the number of packets that can be output at once
+ * in packed mode. The packets must all start in the same input uref, and be
+ * followed by the required number of sync words, so that a packed block is
+ * exactly the concatenation of the packets that would have been output one
+ * by one.
+ *
+ * @param upipe description structure of the pipe
+ * @return number of packets, at least 1
+ */
+static size_t upipe_ts_sync_count(struct upipe *upipe)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    size_t max = (upipe_ts_sync->next_uref_size + TS_SIZE - 1) / TS_SIZE;
+    /* upipe_ts_sync_check already found the first sync words */
+    size_t words = upipe_ts_sync->ts_sync;
+    while (words < max + upipe_ts_sync->ts_sync - 1) {
+        uint8_t word;
+        if (!ubase_check(uref_block_extract(upipe_ts_sync->next_uref,
+                                            words * TS_SIZE, 1, &word)) ||
+            word != TS_SYNC)
+            break;
+        words++;
+    }
+    return words - (upipe_ts_sync->ts_sync - 1);
+}
+
 /** @internal @This flushes all input buffers.
  *
  * @param upipe description structure of the pipe
@@ -232,8 +263,11 @@ static void upipe_ts_sync_input(struct upipe *upipe, struct uref *uref,
 
         /* upipe_ts_sync_check said there is at least one TS packet there. */
         upipe_ts_sync_sync_acquired(upipe);
+        size_t extracted = upipe_ts_sync->output_size;
+        if (upipe_ts_sync->packed && upipe_ts_sync->output_size == TS_SIZE)
+            extracted *= upipe_ts_sync_count(upipe);
         struct uref *output = upipe_ts_sync_extract_uref_stream(upipe,
-                                                    upipe_ts_sync->output_size);
+                                                                extracted);
         if (unlikely(output == NULL)) {
             upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
             continue;
@@ -242,6 +276,25 @@ static void upipe_ts_sync_input(struct upipe *upipe, struct uref *uref,
     }
 }
 
+/** @internal @This sets the attributes of the output flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def output flow definition packet
+ * @return an error code
+ */
+static int upipe_ts_sync_build_flow_def(struct upipe *upipe,
+                                        struct uref *flow_def)
+{
+    struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
+    if (upipe_ts_sync->packed && upipe_ts_sync->output_size == TS_SIZE) {
+        uref_block_flow_delete_size(flow_def);
+        return uref_flow_set_def(flow_def, PACKED_OUTPUT_FLOW_DEF);
+    }
+    UBASE_RETURN(uref_block_flow_set_size(flow_def,
+                                          upipe_ts_sync->output_size))
+    return uref_flow_set_def(flow_def, OUTPUT_FLOW_DEF);
+}
+
 /** @internal @This sets the input flow definition.
  *
  * @param upipe description structure of the pipe
@@ -259,10 +312,39 @@ static int upipe_ts_sync_set_flow_def(struct upipe *upipe,
         upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
         return UBASE_ERR_ALLOC;
     }
+    if (unlikely(!ubase_check(upipe_ts_sync_build_flow_def(upipe,
+                                                           flow_def_dup)))) {
+        uref_free(flow_def_dup);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_ts_sync_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This enables or disables packed output.
+ *
+ * @param upipe description structure of the pipe
+ * @param packed true to output blocks of several packets
+ * @return an error code
+ */
+static int _upipe_ts_sync_set_packed(struct upipe *upipe, bool packed)
+{
     struct upipe_ts_sync *upipe_ts_sync = upipe_ts_sync_from_upipe(upipe);
-    UBASE_RETURN(uref_block_flow_set_size(flow_def_dup,
-                                          upipe_ts_sync->output_size))
-    UBASE_RETURN(uref_flow_set_def(flow_def_dup, OUTPUT_FLOW_DEF))
+    if (upipe_ts_sync->packed == packed)
+        return UBASE_ERR_NONE;
+    upipe_ts_sync->packed = packed;
+    if (upipe_ts_sync->flow_def == NULL)
+        return UBASE_ERR_NONE;
+
+    struct uref *flow_def_dup = uref_dup(upipe_ts_sync->flow_def);
+    if (unlikely(flow_def_dup == NULL ||
+                 !ubase_check(upipe_ts_sync_build_flow_def(upipe,
+                                                           flow_def_dup)))) {
+        if (flow_def_dup != NULL)
+            uref_free(flow_def_dup);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
     upipe_ts_sync_store_flow_def(upipe, flow_def_dup);
     return UBASE_ERR_NONE;
 }
@@ -328,6 +410,19 @@ static int upipe_ts_sync_control(struct upipe *upipe,
             int sync = va_arg(args, int);
             return _upipe_ts_sync_set_sync(upipe, sync);
         }
+        case UPIPE_TS_SYNC_GET_PACKED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            int *packed_p = va_arg(args, int *);
+            struct upipe_ts_sync *upipe_ts_sync =
+                upipe_ts_sync_from_upipe(upipe);
+            *packed_p = upipe_ts_sync->packed ? 1 : 0;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_TS_SYNC_SET_PACKED: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_SYNC_SIGNATURE)
+            int packed = va_arg(args, int);
+            return _upipe_ts_sync_set_packed(upipe, !!packed);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
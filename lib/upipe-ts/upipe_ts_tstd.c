@@ -26,6 +26,7 @@
 #include "upipe/uclock.h"
 #include "upipe/uref.h"
 #include "upipe/uref_block.h"
+#include "upipe/uref_flow.h"
 #include "upipe/uref_clock.h"
 #include "upipe/uref_block_flow.h"
 #include "upipe/upipe.h"
@@ -114,6 +115,10 @@ static void upipe_ts_tstd_input(struct upipe *upipe, struct uref *uref,
         upipe_ts_tstd->fullness = upipe_ts_tstd->bs;
     }
 
+    if (ubase_check(uref_flow_get_random(uref)))
+        upipe_throw(upipe, UPROBE_TS_TSTD_FULLNESS, UPIPE_TS_TSTD_SIGNATURE,
+                    (uint64_t)upipe_ts_tstd->fullness, upipe_ts_tstd->bs);
+
     uint64_t delay = (upipe_ts_tstd->fullness * UCLOCK_FREQ) /
                      upipe_ts_tstd->octetrate;
     uref_clock_set_cr_dts_delay(uref, delay);
@@ -0,0 +1,523 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe module deriving a transport stream variant
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_flow.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_subpipe.h"
+#include "upipe-ts/upipe_ts_variant.h"
+#include "upipe-ts/uref_ts_flow.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include <bitstream/mpeg/ts.h>
+
+/** we only accept transport streams */
+#define EXPECTED_FLOW_DEF "block.mpegts."
+/** we only accept PSI sections on subpipes */
+#define EXPECTED_SUB_FLOW_DEF "block.mpegtspsi."
+/** PID for padding stream */
+#define PADDING_PID 8191
+/** maximum number of sections waiting on a subpipe */
+#define MAX_SECTIONS 256
+
+/** @internal @This is the private context of a ts_variant pipe. */
+struct upipe_ts_variant {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** output flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** list of subpipes */
+    struct uchain subs;
+    /** manager to create subpipes */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_ts_variant, upipe, UPIPE_TS_VARIANT_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_ts_variant, urefcount, upipe_ts_variant_free)
+UPIPE_HELPER_VOID(upipe_ts_variant)
+UPIPE_HELPER_OUTPUT(upipe_ts_variant, output, flow_def, output_state,
+                    request_list)
+
+/** @internal @This is the private context of a subpipe of a ts_variant
+ * pipe. */
+struct upipe_ts_variant_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** PID replaced by this subpipe, or UINT16_MAX */
+    uint16_t pid;
+    /** last continuity counter */
+    uint8_t last_cc;
+    /** list of sections waiting to be output */
+    struct uchain sections;
+    /** number of sections waiting to be output */
+    unsigned int nb_sections;
+    /** octets of the first section already output */
+    size_t section_offset;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_ts_variant_sub, upipe, UPIPE_TS_VARIANT_SUB_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_ts_variant_sub, urefcount,
+                       upipe_ts_variant_sub_free)
+UPIPE_HELPER_VOID(upipe_ts_variant_sub)
+
+UPIPE_HELPER_SUBPIPE(upipe_ts_variant, upipe_ts_variant_sub, sub, sub_mgr,
+                     subs, uchain)
+
+/** @internal @This allocates a subpipe of a ts_variant pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_ts_variant_sub_alloc(struct upipe_mgr *mgr,
+                                                struct uprobe *uprobe,
+                                                uint32_t signature,
+                                                va_list args)
+{
+    struct upipe *upipe = upipe_ts_variant_sub_alloc_void(mgr, uprobe,
+            signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_ts_variant_sub *sub = upipe_ts_variant_sub_from_upipe(upipe);
+    upipe_ts_variant_sub_init_urefcount(upipe);
+    upipe_ts_variant_sub_init_sub(upipe);
+    sub->pid = UINT16_MAX;
+    sub->last_cc = 0;
+    ulist_init(&sub->sections);
+    sub->nb_sections = 0;
+    sub->section_offset = 0;
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This drops the first waiting section of a subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_ts_variant_sub_pop(struct upipe *upipe)
+{
+    struct upipe_ts_variant_sub *sub = upipe_ts_variant_sub_from_upipe(upipe);
+    struct uchain *uchain = ulist_pop(&sub->sections);
+    if (uchain != NULL) {
+        uref_free(uref_from_uchain(uchain));
+        sub->nb_sections--;
+    }
+    sub->section_offset = 0;
+}
+
+/** @internal @This drops all waiting sections of a subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_ts_variant_sub_flush(struct upipe *upipe)
+{
+    struct upipe_ts_variant_sub *sub = upipe_ts_variant_sub_from_upipe(upipe);
+    while (!ulist_empty(&sub->sections))
+        upipe_ts_variant_sub_pop(upipe);
+}
+
+/** @internal @This receives a PSI section.
+ *
+ * @param upipe description structure of the subpipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_variant_sub_input(struct upipe *upipe, struct uref *uref,
+                                       struct upump **upump_p)
+{
+    struct upipe_ts_variant_sub *sub = upipe_ts_variant_sub_from_upipe(upipe);
+    size_t size;
+    if (unlikely(sub->pid == UINT16_MAX ||
+                 !ubase_check(uref_block_size(uref, &size)) || !size)) {
+        upipe_warn(upipe, "received invalid section");
+        uref_free(uref);
+        return;
+    }
+
+    if (unlikely(sub->nb_sections >= MAX_SECTIONS)) {
+        upipe_warn(upipe, "too many waiting sections, dropping one");
+        upipe_ts_variant_sub_pop(upipe);
+    }
+    ulist_add(&sub->sections, uref_to_uchain(uref));
+    sub->nb_sections++;
+}
+
+/** @internal @This writes the next TS packet of a subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param buffer buffer of TS_SIZE octets
+ */
+static void upipe_ts_variant_sub_splice(struct upipe *upipe, uint8_t *buffer)
+{
+    struct upipe_ts_variant_sub *sub = upipe_ts_variant_sub_from_upipe(upipe);
+    struct uref *uref = uref_from_uchain(ulist_peek(&sub->sections));
+    size_t size = 0;
+    uref_block_size(uref, &size);
+
+    ts_init(buffer);
+    ts_set_pid(buffer, sub->pid);
+    ts_set_payload(buffer);
+    sub->last_cc = (sub->last_cc + 1) & 0xf;
+    ts_set_cc(buffer, sub->last_cc);
+
+    uint8_t *payload = buffer + TS_HEADER_SIZE;
+    size_t available = TS_SIZE - TS_HEADER_SIZE;
+    if (!sub->section_offset) {
+        ts_set_unitstart(buffer);
+        *payload++ = 0; /* pointer_field */
+        available--;
+    }
+
+    size_t extracted = size - sub->section_offset;
+    if (extracted > available)
+        extracted = available;
+    if (unlikely(!ubase_check(uref_block_extract(uref, sub->section_offset,
+                                                 extracted, payload)))) {
+        upipe_warn(upipe, "unable to read section");
+        extracted = 0;
+        sub->section_offset = size;
+    }
+    memset(payload + extracted, 0xff, available - extracted);
+
+    sub->section_offset += extracted;
+    if (sub->section_offset >= size)
+        upipe_ts_variant_sub_pop(upipe);
+}
+
+/** @internal @This sets the input flow definition of a subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_ts_variant_sub_set_flow_def(struct upipe *upipe,
+                                             struct uref *flow_def)
+{
+    struct upipe_ts_variant_sub *sub = upipe_ts_variant_sub_from_upipe(upipe);
+    uint64_t pid;
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_SUB_FLOW_DEF))
+    UBASE_RETURN(uref_ts_flow_get_pid(flow_def, &pid))
+    if (pid >= PADDING_PID)
+        return UBASE_ERR_INVALID;
+
+    if (pid != sub->pid) {
+        upipe_ts_variant_sub_flush(upipe);
+        sub->pid = pid;
+        sub->last_cc = 0;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on a subpipe of a ts_variant
+ * pipe.
+ *
+ * @param upipe description structure of the subpipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_ts_variant_sub_control(struct upipe *upipe,
+                                        int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(
+        upipe_ts_variant_sub_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_ts_variant_sub_set_flow_def(upipe, flow_def);
+        }
+        case UPIPE_FLUSH:
+            upipe_ts_variant_sub_flush(upipe);
+            return UBASE_ERR_NONE;
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a subpipe.
+ *
+ * @param upipe description structure of the subpipe
+ */
+static void upipe_ts_variant_sub_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_ts_variant_sub_flush(upipe);
+    upipe_ts_variant_sub_clean_sub(upipe);
+    upipe_ts_variant_sub_clean_urefcount(upipe);
+    upipe_ts_variant_sub_free_void(upipe);
+}
+
+/** @internal @This initializes the subpipe manager for a ts_variant pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_variant_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_ts_variant *upipe_ts_variant =
+        upipe_ts_variant_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_ts_variant->sub_mgr;
+    sub_mgr->refcount = upipe_ts_variant_to_urefcount(upipe_ts_variant);
+    sub_mgr->signature = UPIPE_TS_VARIANT_SUB_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_ts_variant_sub_alloc;
+    sub_mgr->upipe_input = upipe_ts_variant_sub_input;
+    sub_mgr->upipe_control = upipe_ts_variant_sub_control;
+}
+
+/** @internal @This allocates a ts_variant pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_ts_variant_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_ts_variant_alloc_void(mgr, uprobe, signature,
+                                                      args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    upipe_ts_variant_init_urefcount(upipe);
+    upipe_ts_variant_init_output(upipe);
+    upipe_ts_variant_init_sub_subs(upipe);
+    upipe_ts_variant_init_sub_mgr(upipe);
+
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This returns the subpipe replacing the given PID.
+ *
+ * @param upipe description structure of the pipe
+ * @param pid PID of the packet
+ * @return pointer to the subpipe, or NULL
+ */
+static struct upipe_ts_variant_sub *
+    upipe_ts_variant_find_sub(struct upipe *upipe, uint16_t pid)
+{
+    struct upipe_ts_variant *upipe_ts_variant =
+        upipe_ts_variant_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_variant->subs, uchain) {
+        struct upipe_ts_variant_sub *sub =
+            upipe_ts_variant_sub_from_uchain(uchain);
+        if (sub->pid == pid)
+            return sub;
+    }
+    return NULL;
+}
+
+/** @internal @This returns a subpipe with waiting sections.
+ *
+ * @param upipe description structure of the pipe
+ * @return pointer to the subpipe, or NULL
+ */
+static struct upipe_ts_variant_sub *
+    upipe_ts_variant_find_waiting(struct upipe *upipe)
+{
+    struct upipe_ts_variant *upipe_ts_variant =
+        upipe_ts_variant_from_upipe(upipe);
+    struct uchain *uchain;
+    ulist_foreach (&upipe_ts_variant->subs, uchain) {
+        struct upipe_ts_variant_sub *sub =
+            upipe_ts_variant_sub_from_uchain(uchain);
+        if (!ulist_empty(&sub->sections))
+            return sub;
+    }
+    return NULL;
+}
+
+/** @internal @This receives data.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure
+ * @param upump_p reference to pump that generated the buffer
+ */
+static void upipe_ts_variant_input(struct upipe *upipe, struct uref *uref,
+                                   struct upump **upump_p)
+{
+    size_t size;
+    if (unlikely(!ubase_check(uref_block_size(uref, &size)))) {
+        upipe_warn(upipe, "received invalid buffer");
+        uref_free(uref);
+        return;
+    }
+
+    uint8_t *buffer = NULL;
+    for (size_t offset = 0; offset + TS_SIZE <= size; offset += TS_SIZE) {
+        uint8_t header_buffer[TS_HEADER_SIZE];
+        const uint8_t *header = uref_block_peek(uref, offset, TS_HEADER_SIZE,
+                                                header_buffer);
+        if (unlikely(header == NULL))
+            break;
+        uint16_t pid = ts_get_pid(header);
+        uref_block_peek_unmap(uref, offset, header_buffer, header);
+
+        struct upipe_ts_variant_sub *owner =
+            upipe_ts_variant_find_sub(upipe, pid);
+        if (owner == NULL && pid != PADDING_PID)
+            continue;
+
+        struct upipe_ts_variant_sub *sub = owner;
+        if (sub == NULL || ulist_empty(&sub->sections))
+            sub = upipe_ts_variant_find_waiting(upipe);
+        if (sub == NULL && owner == NULL)
+            continue; /* keep the padding packet */
+
+        if (buffer == NULL) {
+            /* copy-on-write of the shared buffer */
+            int write_size = -1;
+            if (unlikely(!ubase_check(uref_block_merge(uref, uref->ubuf->mgr,
+                                                       0, -1)) ||
+                         !ubase_check(uref_block_write(uref, 0, &write_size,
+                                                       &buffer)))) {
+                uref_free(uref);
+                upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+                return;
+            }
+        }
+
+        if (sub != NULL)
+            upipe_ts_variant_sub_splice(upipe_ts_variant_sub_to_upipe(sub),
+                                        buffer + offset);
+        else
+            ts_pad(buffer + offset);
+    }
+
+    if (buffer != NULL)
+        uref_block_unmap(uref, 0);
+    upipe_ts_variant_output(upipe, uref, upump_p);
+}
+
+/** @internal @This sets the input flow definition.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_def flow definition packet
+ * @return an error code
+ */
+static int upipe_ts_variant_set_flow_def(struct upipe *upipe,
+                                         struct uref *flow_def)
+{
+    if (flow_def == NULL)
+        return UBASE_ERR_INVALID;
+    UBASE_RETURN(uref_flow_match_def(flow_def, EXPECTED_FLOW_DEF))
+    struct uref *flow_def_dup = uref_dup(flow_def);
+    UBASE_ALLOC_RETURN(flow_def_dup)
+    upipe_ts_variant_store_flow_def(upipe, flow_def_dup);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_ts_variant_control(struct upipe *upipe,
+                                    int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_ts_variant_control_subs(upipe, command, args));
+    UBASE_HANDLED_RETURN(upipe_ts_variant_control_output(upipe, command, args));
+
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_ts_variant_set_flow_def(upipe, flow_def);
+        }
+
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_variant_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+
+    upipe_ts_variant_clean_sub_subs(upipe);
+    upipe_ts_variant_clean_output(upipe);
+    upipe_ts_variant_clean_urefcount(upipe);
+    upipe_ts_variant_free_void(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_ts_variant_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_TS_VARIANT_SIGNATURE,
+
+    .upipe_alloc = upipe_ts_variant_alloc,
+    .upipe_input = upipe_ts_variant_input,
+    .upipe_control = upipe_ts_variant_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all ts_variant pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_variant_mgr_alloc(void)
+{
+    return &upipe_ts_variant_mgr;
+}
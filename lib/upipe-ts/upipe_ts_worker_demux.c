@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Bin pipe demultiplexing a TS with a pool of worker threads
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_inner.h"
+#include "upipe/upipe_helper_bin_input.h"
+#include "upipe-modules/upipe_dup.h"
+#include "upipe-modules/upipe_worker_sink.h"
+#include "upipe-ts/upipe_ts_demux.h"
+#include "upipe-ts/upipe_ts_worker_demux.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/** @internal @This is the private context of a ts_wdemux manager. */
+struct upipe_ts_wdemux_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** pointer to ts_demux manager */
+    struct upipe_mgr *ts_demux_mgr;
+    /** pointer to dup manager */
+    struct upipe_mgr *dup_mgr;
+    /** number of workers */
+    unsigned int nb_workers;
+    /** array of wsink managers, one per worker */
+    struct upipe_mgr **wsink_mgrs;
+
+    /** public upipe_mgr structure */
+    struct upipe_mgr mgr;
+};
+
+UBASE_FROM_TO(upipe_ts_wdemux_mgr, upipe_mgr, upipe_mgr, mgr)
+UBASE_FROM_TO(upipe_ts_wdemux_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This is the private context of a ts_wdemux pipe. */
+struct upipe_ts_wdemux {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** proxy probe */
+    struct uprobe proxy_probe;
+
+    /** list of input bin requests */
+    struct uchain input_request_list;
+    /** dup inner pipe */
+    struct upipe *dup;
+    /** number of workers */
+    unsigned int nb_workers;
+    /** array of dup outputs, one per worker */
+    struct upipe **dup_outputs;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_ts_wdemux, upipe, UPIPE_TS_WDEMUX_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_ts_wdemux, urefcount, upipe_ts_wdemux_free)
+UPIPE_HELPER_INNER(upipe_ts_wdemux, dup)
+UPIPE_HELPER_BIN_INPUT(upipe_ts_wdemux, dup, input_request_list)
+
+/** @internal @This catches events coming from an inner pipe, and
+ * attaches them to the bin pipe.
+ *
+ * @param uprobe pointer to the probe in upipe_ts_wdemux_alloc
+ * @param inner pointer to the inner pipe
+ * @param event event triggered by the inner pipe
+ * @param args arguments of the event
+ * @return an error code
+ */
+static int upipe_ts_wdemux_proxy_probe(struct uprobe *uprobe,
+                                       struct upipe *inner,
+                                       int event, va_list args)
+{
+    struct upipe_ts_wdemux *s = container_of(uprobe, struct upipe_ts_wdemux,
+                                             proxy_probe);
+    struct upipe *upipe = upipe_ts_wdemux_to_upipe(s);
+    return upipe_throw_proxy(upipe, inner, event, args);
+}
+
+/** @internal @This allocates the ts_demux of a worker and transfers it to
+ * the remote thread.
+ *
+ * @param upipe description structure of the pipe
+ * @param index index of the worker
+ * @param uprobe_remote probe hierarchy to use on the remote thread
+ * @param input_queue_length number of packets in the queue
+ * @return pointer to the wsink pipe, or NULL in case of error
+ */
+static struct upipe *upipe_ts_wdemux_alloc_worker(struct upipe *upipe,
+        unsigned int index, struct uprobe *uprobe_remote,
+        unsigned int input_queue_length)
+{
+    struct upipe_ts_wdemux *upipe_ts_wdemux =
+        upipe_ts_wdemux_from_upipe(upipe);
+    struct upipe_ts_wdemux_mgr *ts_wdemux_mgr =
+        upipe_ts_wdemux_mgr_from_upipe_mgr(upipe->mgr);
+
+    struct upipe *demux = upipe_void_alloc(ts_wdemux_mgr->ts_demux_mgr,
+            uprobe_pfx_alloc_va(uprobe_use(uprobe_remote),
+                                UPROBE_LOG_VERBOSE, "demux %u", index));
+    if (unlikely(demux == NULL))
+        return NULL;
+
+    if (unlikely(!ubase_check(upipe_ts_demux_set_program_shard(demux,
+                        index, upipe_ts_wdemux->nb_workers)))) {
+        upipe_release(demux);
+        return NULL;
+    }
+
+    return upipe_wsink_alloc(ts_wdemux_mgr->wsink_mgrs[index],
+            uprobe_pfx_alloc_va(uprobe_use(&upipe_ts_wdemux->proxy_probe),
+                                UPROBE_LOG_VERBOSE, "wsink %u", index),
+            demux,
+            uprobe_pfx_alloc_va(uprobe_use(uprobe_remote),
+                                UPROBE_LOG_VERBOSE, "wsink_x %u", index),
+            input_queue_length);
+}
+
+/** @internal @This allocates a ts_wdemux pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *_upipe_ts_wdemux_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature, va_list args)
+{
+    struct upipe_ts_wdemux_mgr *ts_wdemux_mgr =
+        upipe_ts_wdemux_mgr_from_upipe_mgr(mgr);
+    if (unlikely(signature != UPIPE_TS_WDEMUX_SIGNATURE)) {
+        uprobe_release(uprobe);
+        return NULL;
+    }
+    struct uprobe *uprobe_remote = va_arg(args, struct uprobe *);
+    unsigned int input_queue_length = va_arg(args, unsigned int);
+
+    struct upipe_ts_wdemux *upipe_ts_wdemux =
+        malloc(sizeof(struct upipe_ts_wdemux));
+    if (unlikely(upipe_ts_wdemux == NULL)) {
+        uprobe_release(uprobe_remote);
+        uprobe_release(uprobe);
+        return NULL;
+    }
+
+    struct upipe *upipe = upipe_ts_wdemux_to_upipe(upipe_ts_wdemux);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_ts_wdemux_init_urefcount(upipe);
+    upipe_ts_wdemux_init_bin_input(upipe);
+    upipe_ts_wdemux->nb_workers = ts_wdemux_mgr->nb_workers;
+    upipe_ts_wdemux->dup_outputs =
+        calloc(upipe_ts_wdemux->nb_workers, sizeof(struct upipe *));
+
+    uprobe_init(&upipe_ts_wdemux->proxy_probe, upipe_ts_wdemux_proxy_probe,
+                NULL);
+    /* Because there is no buffering inside the dup inner pipe. */
+    upipe_ts_wdemux->proxy_probe.refcount = NULL;
+
+    upipe_throw_ready(upipe);
+
+    if (unlikely(upipe_ts_wdemux->dup_outputs == NULL)) {
+        uprobe_release(uprobe_remote);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        upipe_release(upipe);
+        return NULL;
+    }
+
+    struct upipe *dup = upipe_void_alloc(ts_wdemux_mgr->dup_mgr,
+            uprobe_pfx_alloc(uprobe_use(&upipe_ts_wdemux->proxy_probe),
+                             UPROBE_LOG_VERBOSE, "dup"));
+    if (unlikely(dup == NULL)) {
+        uprobe_release(uprobe_remote);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        upipe_release(upipe);
+        return NULL;
+    }
+    upipe_ts_wdemux_store_bin_input(upipe, dup);
+
+    for (unsigned int i = 0; i < upipe_ts_wdemux->nb_workers; i++) {
+        struct upipe *output = upipe_void_alloc_sub(dup,
+                uprobe_pfx_alloc_va(
+                    uprobe_use(&upipe_ts_wdemux->proxy_probe),
+                    UPROBE_LOG_VERBOSE, "dup %u", i));
+        if (unlikely(output == NULL)) {
+            uprobe_release(uprobe_remote);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            upipe_release(upipe);
+            return NULL;
+        }
+        upipe_ts_wdemux->dup_outputs[i] = output;
+
+        struct upipe *wsink = upipe_ts_wdemux_alloc_worker(upipe, i,
+                uprobe_remote, input_queue_length);
+        if (unlikely(wsink == NULL)) {
+            uprobe_release(uprobe_remote);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            upipe_release(upipe);
+            return NULL;
+        }
+        upipe_set_output(output, wsink);
+        upipe_release(wsink);
+    }
+
+    uprobe_release(uprobe_remote);
+    return upipe;
+}
+
+/** @internal @This processes control commands on a ts_wdemux pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_ts_wdemux_control(struct upipe *upipe,
+                                   int command, va_list args)
+{
+    return upipe_ts_wdemux_control_bin_input(upipe, command, args);
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_ts_wdemux_free(struct upipe *upipe)
+{
+    struct upipe_ts_wdemux *upipe_ts_wdemux =
+        upipe_ts_wdemux_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    if (upipe_ts_wdemux->dup_outputs != NULL)
+        for (unsigned int i = 0; i < upipe_ts_wdemux->nb_workers; i++)
+            upipe_release(upipe_ts_wdemux->dup_outputs[i]);
+    free(upipe_ts_wdemux->dup_outputs);
+    upipe_ts_wdemux_clean_bin_input(upipe);
+    uprobe_clean(&upipe_ts_wdemux->proxy_probe);
+    upipe_ts_wdemux_clean_urefcount(upipe);
+    upipe_clean(upipe);
+    free(upipe_ts_wdemux);
+}
+
+/** @This frees a upipe manager.
+ *
+ * @param urefcount pointer to urefcount structure
+ */
+static void upipe_ts_wdemux_mgr_free(struct urefcount *urefcount)
+{
+    struct upipe_ts_wdemux_mgr *ts_wdemux_mgr =
+        upipe_ts_wdemux_mgr_from_urefcount(urefcount);
+    for (unsigned int i = 0; i < ts_wdemux_mgr->nb_workers; i++)
+        upipe_mgr_release(ts_wdemux_mgr->wsink_mgrs[i]);
+    free(ts_wdemux_mgr->wsink_mgrs);
+    upipe_mgr_release(ts_wdemux_mgr->dup_mgr);
+    upipe_mgr_release(ts_wdemux_mgr->ts_demux_mgr);
+
+    urefcount_clean(urefcount);
+    free(ts_wdemux_mgr);
+}
+
+/** @This returns the management structure for all ts_wdemux pipes.
+ *
+ * @param ts_demux_mgr manager of the ts_demux pipes running on the workers
+ * @param xfer_mgrs array of managers to transfer pipes to the remote
+ * threads, one per worker
+ * @param nb_workers number of elements in xfer_mgrs
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_ts_wdemux_mgr_alloc(struct upipe_mgr *ts_demux_mgr,
+                                            struct upipe_mgr **xfer_mgrs,
+                                            unsigned int nb_workers)
+{
+    assert(ts_demux_mgr != NULL);
+    assert(xfer_mgrs != NULL);
+    if (unlikely(!nb_workers))
+        return NULL;
+
+    struct upipe_ts_wdemux_mgr *ts_wdemux_mgr =
+        malloc(sizeof(struct upipe_ts_wdemux_mgr));
+    if (unlikely(ts_wdemux_mgr == NULL))
+        return NULL;
+
+    ts_wdemux_mgr->wsink_mgrs = calloc(nb_workers, sizeof(struct upipe_mgr *));
+    if (unlikely(ts_wdemux_mgr->wsink_mgrs == NULL)) {
+        free(ts_wdemux_mgr);
+        return NULL;
+    }
+    ts_wdemux_mgr->nb_workers = nb_workers;
+    ts_wdemux_mgr->ts_demux_mgr = upipe_mgr_use(ts_demux_mgr);
+    ts_wdemux_mgr->dup_mgr = upipe_dup_mgr_alloc();
+
+    urefcount_init(upipe_ts_wdemux_mgr_to_urefcount(ts_wdemux_mgr),
+                   upipe_ts_wdemux_mgr_free);
+    ts_wdemux_mgr->mgr.refcount =
+        upipe_ts_wdemux_mgr_to_urefcount(ts_wdemux_mgr);
+    ts_wdemux_mgr->mgr.signature = UPIPE_TS_WDEMUX_SIGNATURE;
+    ts_wdemux_mgr->mgr.upipe_alloc = _upipe_ts_wdemux_alloc;
+    ts_wdemux_mgr->mgr.upipe_input = upipe_ts_wdemux_bin_input;
+    ts_wdemux_mgr->mgr.upipe_control = upipe_ts_wdemux_control;
+    ts_wdemux_mgr->mgr.upipe_mgr_control = NULL;
+
+    for (unsigned int i = 0; i < nb_workers; i++) {
+        ts_wdemux_mgr->wsink_mgrs[i] = upipe_wsink_mgr_alloc(xfer_mgrs[i]);
+        if (unlikely(ts_wdemux_mgr->wsink_mgrs[i] == NULL)) {
+            upipe_mgr_release(
+                    upipe_ts_wdemux_mgr_to_upipe_mgr(ts_wdemux_mgr));
+            return NULL;
+        }
+    }
+    return upipe_ts_wdemux_mgr_to_upipe_mgr(ts_wdemux_mgr);
+}
@@ -28,6 +28,7 @@
 
 #include "upipe/config.h"
 #include "upipe/ubase.h"
+#include "upipe/ucpu.h"
 #include "upipe/uref.h"
 #include "upipe/ubuf.h"
 #include "upipe/uref_pic_flow.h"
@@ -46,6 +47,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdarg.h>
+#include <string.h>
 #include <assert.h>
 
 #include "upipe-v210/upipe_v210dec.h"
@@ -60,6 +62,8 @@ static const char *v210_chroma_str = "u10y10v10y10u10y10v10y10u10y10v10y10";
 enum v210dec_output_type {
     V2D_OUTPUT_PLANAR_8 = 1,
     V2D_OUTPUT_PLANAR_10,
+    V2D_OUTPUT_PLANAR_420_8,
+    V2D_OUTPUT_PLANAR_420_10,
 };
 
 /** upipe_v210dec structure with v210dec parameters */
@@ -99,6 +103,10 @@ struct upipe_v210dec {
     void (*v210_to_planar_8)(const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
     /** 10-bit line packing function **/
     void (*v210_to_planar_10)(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
+    /** 8-bit 4:2:0 line pair packing function **/
+    void (*v210_to_planar_420_8)(const void *src0, const void *src1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uintptr_t pixels);
+    /** 10-bit 4:2:0 line pair packing function **/
+    void (*v210_to_planar_420_10)(const void *src0, const void *src1, uint16_t *y0, uint16_t *y1, uint16_t *u, uint16_t *v, uintptr_t pixels);
 
     /** output chroma map */
     const char *output_chroma_map[UPIPE_V210_MAX_PLANES+1];
@@ -164,26 +172,70 @@ static void v210dec_setup_asm(struct upipe *upipe, bool assembly)
 
     v210dec->v210_to_planar_8  = upipe_v210_to_planar_8_c;
     v210dec->v210_to_planar_10 = upipe_v210_to_planar_10_c;
+    v210dec->v210_to_planar_420_8  = upipe_v210_to_planar_420_8_c;
+    v210dec->v210_to_planar_420_10 = upipe_v210_to_planar_420_10_c;
 
     if (!assembly)
         return;
 
-#ifdef UPIPE_HAVE_X86ASM
-#if defined(__i686__) || defined(__x86_64__)
-    if (__builtin_cpu_supports("ssse3")) {
-        v210dec->v210_to_planar_8  = upipe_v210_to_planar_8_ssse3;
-        v210dec->v210_to_planar_10 = upipe_v210_to_planar_10_ssse3;
-    }
-    if (__builtin_cpu_supports("avx")) {
-        v210dec->v210_to_planar_8  = upipe_v210_to_planar_8_avx;
-        v210dec->v210_to_planar_10 = upipe_v210_to_planar_10_avx;
-    }
-    if (__builtin_cpu_supports("avx2")) {
-        v210dec->v210_to_planar_8  = upipe_v210_to_planar_8_avx2;
-        v210dec->v210_to_planar_10 = upipe_v210_to_planar_10_avx2;
-    }
-#endif
-#endif
+    v210dec->v210_to_planar_8 =
+        UCPU_KERNEL_FUNC(&upipe_v210_to_planar_8_kernel,
+                         __typeof__(v210dec->v210_to_planar_8));
+    v210dec->v210_to_planar_10 =
+        UCPU_KERNEL_FUNC(&upipe_v210_to_planar_10_kernel,
+                         __typeof__(v210dec->v210_to_planar_10));
+    v210dec->v210_to_planar_420_8 =
+        UCPU_KERNEL_FUNC(&upipe_v210_to_planar_420_8_kernel,
+                         __typeof__(v210dec->v210_to_planar_420_8));
+    v210dec->v210_to_planar_420_10 =
+        UCPU_KERNEL_FUNC(&upipe_v210_to_planar_420_10_kernel,
+                         __typeof__(v210dec->v210_to_planar_420_10));
+}
+
+/** @internal @This decodes the last (less than 6) pixels of a pair of lines
+ * to 8-bit 4:2:0.
+ *
+ * @param src0 first v210 line, at the start of the last block
+ * @param src1 second v210 line, at the start of the last block
+ * @param y0 first luma line
+ * @param y1 second luma line
+ * @param u chroma line
+ * @param v chroma line
+ * @param pixels number of remaining pixels
+ */
+static void v210dec_420_8_tail(const void *src0, const void *src1,
+                               uint8_t *y0, uint8_t *y1,
+                               uint8_t *u, uint8_t *v, int pixels)
+{
+    uint8_t y0_tmp[6], y1_tmp[6], u_tmp[3], v_tmp[3];
+    upipe_v210_to_planar_420_8_c(src0, src1, y0_tmp, y1_tmp, u_tmp, v_tmp, 6);
+    memcpy(y0, y0_tmp, pixels);
+    memcpy(y1, y1_tmp, pixels);
+    memcpy(u, u_tmp, (pixels + 1) / 2);
+    memcpy(v, v_tmp, (pixels + 1) / 2);
+}
+
+/** @internal @This decodes the last (less than 6) pixels of a pair of lines
+ * to 10-bit 4:2:0.
+ *
+ * @param src0 first v210 line, at the start of the last block
+ * @param src1 second v210 line, at the start of the last block
+ * @param y0 first luma line
+ * @param y1 second luma line
+ * @param u chroma line
+ * @param v chroma line
+ * @param pixels number of remaining pixels
+ */
+static void v210dec_420_10_tail(const void *src0, const void *src1,
+                                uint16_t *y0, uint16_t *y1,
+                                uint16_t *u, uint16_t *v, int pixels)
+{
+    uint16_t y0_tmp[6], y1_tmp[6], u_tmp[3], v_tmp[3];
+    upipe_v210_to_planar_420_10_c(src0, src1, y0_tmp, y1_tmp, u_tmp, v_tmp, 6);
+    memcpy(y0, y0_tmp, pixels * sizeof(*y0));
+    memcpy(y1, y1_tmp, pixels * sizeof(*y1));
+    memcpy(u, u_tmp, (pixels + 1) / 2 * sizeof(*u));
+    memcpy(v, v_tmp, (pixels + 1) / 2 * sizeof(*v));
 }
 
 /** @internal @This handles data.
@@ -335,6 +387,54 @@ static bool upipe_v210dec_handle(struct upipe *upipe, struct uref *uref,
             }
         } break;
 
+        case V2D_OUTPUT_PLANAR_420_8:
+        case V2D_OUTPUT_PLANAR_420_10: {
+            /* the chroma of interlaced pictures is averaged within each
+             * field, which requires the field height to be even */
+            bool fields = !ubase_check(uref_pic_get_progressive(uref)) &&
+                          !(input_vsize % 4);
+            int w = (output_hsize / 6) * 6;
+            int tail = output_hsize - w;
+
+            for (size_t row = 0; row < (input_vsize + 1) / 2; row++) {
+                size_t l0, l1;
+                if (fields) {
+                    l0 = (row / 2) * 4 + (row % 2);
+                    l1 = l0 + 2;
+                } else {
+                    l0 = row * 2;
+                    l1 = l0 + 1 < input_vsize ? l0 + 1 : l0;
+                }
+
+                const uint8_t *src0 = input_plane + l0 * input_stride;
+                const uint8_t *src1 = input_plane + l1 * input_stride;
+                uint8_t *y0 = output_planes[0] + l0 * output_strides[0];
+                uint8_t *y1 = output_planes[0] + l1 * output_strides[0];
+                uint8_t *u = output_planes[1] + row * output_strides[1];
+                uint8_t *v = output_planes[2] + row * output_strides[2];
+
+                if (v210dec->output_type == V2D_OUTPUT_PLANAR_420_8) {
+                    v210dec->v210_to_planar_420_8(src0, src1, y0, y1, u, v, w);
+                    if (tail)
+                        v210dec_420_8_tail(src0 + (w / 6) * 16,
+                                           src1 + (w / 6) * 16,
+                                           y0 + w, y1 + w,
+                                           u + w / 2, v + w / 2, tail);
+                } else {
+                    v210dec->v210_to_planar_420_10(src0, src1,
+                            (uint16_t *)y0, (uint16_t *)y1,
+                            (uint16_t *)u, (uint16_t *)v, w);
+                    if (tail)
+                        v210dec_420_10_tail(src0 + (w / 6) * 16,
+                                            src1 + (w / 6) * 16,
+                                            (uint16_t *)y0 + w,
+                                            (uint16_t *)y1 + w,
+                                            (uint16_t *)u + w / 2,
+                                            (uint16_t *)v + w / 2, tail);
+                }
+            }
+        } break;
+
         default:
             assert(0);
     }
@@ -486,6 +586,32 @@ static int upipe_v210dec_set_flow_def(struct upipe *upipe, struct uref *flow_def
             UBASE_RETURN(uref_pic_flow_set_hmappend(output_flow, 6 + 8));
         } break;
 
+        case V2D_OUTPUT_PLANAR_420_8: {
+            v210dec->output_chroma_map[0] = "y8";
+            v210dec->output_chroma_map[1] = "u8";
+            v210dec->output_chroma_map[2] = "v8";
+            uref_pic_flow_clear_format(output_flow);
+            UBASE_RETURN(uref_pic_flow_set_align(output_flow, 32));
+            UBASE_RETURN(uref_pic_flow_set_macropixel(output_flow, 1))
+            UBASE_RETURN(uref_pic_flow_add_plane(output_flow, 1, 1, 1, "y8"))
+            UBASE_RETURN(uref_pic_flow_add_plane(output_flow, 2, 2, 1, "u8"))
+            UBASE_RETURN(uref_pic_flow_add_plane(output_flow, 2, 2, 1, "v8"))
+            UBASE_RETURN(uref_pic_flow_set_hmappend(output_flow, 12 + 16));
+        } break;
+
+        case V2D_OUTPUT_PLANAR_420_10: {
+            v210dec->output_chroma_map[0] = "y10l";
+            v210dec->output_chroma_map[1] = "u10l";
+            v210dec->output_chroma_map[2] = "v10l";
+            uref_pic_flow_clear_format(output_flow);
+            UBASE_RETURN(uref_pic_flow_set_align(output_flow, 32));
+            UBASE_RETURN(uref_pic_flow_set_macropixel(output_flow, 1))
+            UBASE_RETURN(uref_pic_flow_add_plane(output_flow, 1, 1, 2, "y10l"))
+            UBASE_RETURN(uref_pic_flow_add_plane(output_flow, 2, 2, 2, "u10l"))
+            UBASE_RETURN(uref_pic_flow_add_plane(output_flow, 2, 2, 2, "v10l"))
+            UBASE_RETURN(uref_pic_flow_set_hmappend(output_flow, 6 + 8));
+        } break;
+
         default:
             upipe_err(upipe, "unknown output format");
             uref_dump(flow_def, upipe->uprobe);
@@ -599,6 +725,20 @@ static struct upipe *upipe_v210dec_alloc(struct upipe_mgr *manager,
         PRINT_OUTPUT_TYPE(V2D_OUTPUT_PLANAR_10);
     }
 
+    else if (ubase_check(uref_pic_flow_check_chroma(flow_def, 1, 1, 1, "y8")) &&
+             ubase_check(uref_pic_flow_check_chroma(flow_def, 2, 2, 1, "u8")) &&
+             ubase_check(uref_pic_flow_check_chroma(flow_def, 2, 2, 1, "v8"))) {
+        v210dec->output_type = V2D_OUTPUT_PLANAR_420_8;
+        PRINT_OUTPUT_TYPE(V2D_OUTPUT_PLANAR_420_8);
+    }
+
+    else if (ubase_check(uref_pic_flow_check_chroma(flow_def, 1, 1, 2, "y10l")) &&
+             ubase_check(uref_pic_flow_check_chroma(flow_def, 2, 2, 2, "u10l")) &&
+             ubase_check(uref_pic_flow_check_chroma(flow_def, 2, 2, 2, "v10l"))) {
+        v210dec->output_type = V2D_OUTPUT_PLANAR_420_10;
+        PRINT_OUTPUT_TYPE(V2D_OUTPUT_PLANAR_420_10);
+    }
+
     else {
         upipe_err(upipe, "unknown output format");
         upipe_v210dec_free_flow(upipe);
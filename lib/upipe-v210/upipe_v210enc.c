@@ -28,6 +28,7 @@
 
 #include "upipe/config.h"
 #include "upipe/ubase.h"
+#include "upipe/ucpu.h"
 #include "upipe/uref.h"
 #include "upipe/ubuf.h"
 #include "upipe/uref_pic_flow.h"
@@ -574,24 +575,12 @@ static struct upipe *upipe_v210enc_alloc(struct upipe_mgr *mgr,
 
     struct upipe_v210enc *upipe_v210enc = upipe_v210enc_from_upipe(upipe);
 
-    upipe_v210enc->pack_line_8  = upipe_planar_to_v210_8_c;
-    upipe_v210enc->pack_line_10 = upipe_planar_to_v210_10_c;
-
-#ifdef UPIPE_HAVE_X86ASM
-#if defined(__i686__) || defined(__x86_64__)
-    if (__builtin_cpu_supports("ssse3")) {
-        upipe_v210enc->pack_line_8  = upipe_planar_to_v210_8_ssse3;
-        upipe_v210enc->pack_line_10 = upipe_planar_to_v210_10_ssse3;
-    }
-    if (__builtin_cpu_supports("avx"))
-        upipe_v210enc->pack_line_8  = upipe_planar_to_v210_8_avx;
-
-    if (__builtin_cpu_supports("avx2")) {
-        upipe_v210enc->pack_line_8  = upipe_planar_to_v210_8_avx2;
-        upipe_v210enc->pack_line_10 = upipe_planar_to_v210_10_avx2;
-    }
-#endif
-#endif
+    upipe_v210enc->pack_line_8 =
+        UCPU_KERNEL_FUNC(&upipe_planar_to_v210_8_kernel,
+                         __typeof__(upipe_v210enc->pack_line_8));
+    upipe_v210enc->pack_line_10 =
+        UCPU_KERNEL_FUNC(&upipe_planar_to_v210_10_kernel,
+                         __typeof__(upipe_v210enc->pack_line_10));
 
     upipe_v210enc_init_urefcount(upipe);
     upipe_v210enc_init_ubuf_mgr(upipe);
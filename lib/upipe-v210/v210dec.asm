@@ -21,12 +21,12 @@
 
 %include "x86util.asm"
 
-SECTION_RODATA 32
+SECTION_RODATA 64
 
-v210_mask:        times 8 dd 0x3ff
-v210_mult:        times 2 dw 64, 4, 64, 4, 64, 4, 64, 4
-v210_luma_shuf:   times 2 db 8, 9, 0, 1, 2, 3,12,13, 4, 5, 6, 7,-1,-1,-1,-1
-v210_chroma_shuf: times 2 db 0, 1, 8, 9, 6, 7,-1,-1, 2, 3, 4, 5,12,13,-1,-1
+v210_mask:        times 16 dd 0x3ff
+v210_mult:        times 4 dw 64, 4, 64, 4, 64, 4, 64, 4
+v210_luma_shuf:   times 4 db 8, 9, 0, 1, 2, 3,12,13, 4, 5, 6, 7,-1,-1,-1,-1
+v210_chroma_shuf: times 4 db 0, 1, 8, 9, 6, 7,-1,-1, 2, 3, 4, 5,12,13,-1,-1
 
 v210_to_planar8_mask1:  times 16 db 0, 255
 v210_to_planar8_mask2:  times  8 db 0, 0, 255, 0
@@ -53,6 +53,11 @@ cglobal v210_to_planar_10, 5, 5, 7, src, y, u, v, pixels
     mova   m5, [v210_luma_shuf]
     mova   m6, [v210_chroma_shuf]
 
+%if mmsize == 64
+    cmp    pixelsq, -24
+    jg     .tail
+%endif
+
     .loop:
         movu   m0, [srcq]
 
@@ -63,23 +68,56 @@ cglobal v210_to_planar_10, 5, 5, 7, src, y, u, v, pixels
 
         shufps m2, m1, m0, 0x8d ; y1 y2 y4 y5 y0 __ y3 __
         pshufb m2, m5           ; y0 y1 y2 y3 y4 y5 __ __
-        movu   [yq + 2*pixelsq], m2
+        movu   [yq + 2*pixelsq], xm2
 
         shufps m1, m1, m0, 0xd8     ; u0 v0 v1 u2 u1 __ v2 __
         pshufb m1, m6           ; u0 u1 u2 __ v0 v1 v2 __
         movq   [uq + pixelsq], xm1
         movhps [vq + pixelsq], xm1
 
-    %if cpuflag(avx2)
-        vextracti128 [yq + 2*pixelsq + 12], m2, 1
-        vextracti128 xm0, m1, 1
-        movq   [uq + pixelsq + 6], xm0
-        movhps [vq + pixelsq + 6], xm0
-    %endif
+    %assign i 1
+    %rep mmsize/16 - 1
+        vextracti128 [yq + 2*pixelsq + 12*i], m2, i
+        vextracti128 xm0, m1, i
+        movq   [uq + pixelsq + 6*i], xm0
+        movhps [vq + pixelsq + 6*i], xm0
+    %assign i i+1
+    %endrep
 
         add srcq, mmsize
         add pixelsq, (6*mmsize)/16
+%if mmsize == 64
+        cmp pixelsq, -24
+    jle .loop
+
+    ; remaining pixels, 6 at a time so as not to write further than the
+    ; narrower variants
+    .tail:
+        test   pixelsq, pixelsq
+        jge    .end
+        movu   xm0, [srcq]
+
+        pmullw xm1, xm0, xm3
+        psrld  xm0, 10
+        psrlw  xm1, 6
+        pand   xm0, xm4
+
+        shufps xm2, xm1, xm0, 0x8d
+        pshufb xm2, xm5
+        movu   [yq + 2*pixelsq], xm2
+
+        shufps xm1, xm1, xm0, 0xd8
+        pshufb xm1, xm6
+        movq   [uq + pixelsq], xm1
+        movhps [vq + pixelsq], xm1
+
+        add srcq, 16
+        add pixelsq, 6
+    jl  .tail
+    .end:
+%else
     jl  .loop
+%endif
 RET
 
 %endmacro
@@ -90,6 +128,8 @@ INIT_XMM avx
 v210_to_planar_10
 INIT_YMM avx2
 v210_to_planar_10
+INIT_ZMM avx512
+v210_to_planar_10
 
 %macro v210_to_planar_8 0
 
@@ -143,3 +183,75 @@ INIT_XMM avx
 v210_to_planar_8
 INIT_YMM avx2
 v210_to_planar_8
+
+%if ARCH_X86_64
+%macro v210_to_planar_420_10 0
+
+; v210_to_planar_420_10(const uint32_t *src0, const uint32_t *src1,
+;                       uint16_t *y0, uint16_t *y1, uint16_t *u, uint16_t *v,
+;                       int64_t width)
+cglobal v210_to_planar_420_10, 7, 7, 9, src0, src1, y0, y1, u, v, pixels
+    lea    y0q, [y0q + 2*pixelsq]
+    lea    y1q, [y1q + 2*pixelsq]
+    add    uq, pixelsq
+    add    vq, pixelsq
+    neg    pixelsq
+
+    mova   m3, [v210_mult]
+    mova   m4, [v210_mask]
+    mova   m5, [v210_luma_shuf]
+    mova   m6, [v210_chroma_shuf]
+
+    .loop:
+        movu   m0, [src0q]
+
+        pmullw m1, m0, m3
+        psrld  m0, 10
+        psrlw  m1, 6            ; u0 v0 y1 y2 v1 u2 y4 y5
+        pand   m0, m4           ; y0 __ u1 __ y3 __ v2 __
+
+        shufps m2, m1, m0, 0x8d ; y1 y2 y4 y5 y0 __ y3 __
+        pshufb m2, m5           ; y0 y1 y2 y3 y4 y5 __ __
+        movu   [y0q + 2*pixelsq], xm2
+        shufps m1, m1, m0, 0xd8 ; u0 v0 v1 u2 u1 __ v2 __
+
+        movu   m0, [src1q]
+
+        pmullw m7, m0, m3
+        psrld  m0, 10
+        psrlw  m7, 6
+        pand   m0, m4
+
+        shufps m8, m7, m0, 0x8d
+        pshufb m8, m5
+        movu   [y1q + 2*pixelsq], xm8
+        shufps m7, m7, m0, 0xd8
+
+        pavgw  m1, m7
+        pshufb m1, m6           ; u0 u1 u2 __ v0 v1 v2 __
+        movq   [uq + pixelsq], xm1
+        movhps [vq + pixelsq], xm1
+
+%if cpuflag(avx2)
+        vextracti128 [y0q + 2*pixelsq + 12], m2, 1
+        vextracti128 [y1q + 2*pixelsq + 12], m8, 1
+        vextracti128 xm0, m1, 1
+        movq   [uq + pixelsq + 6], xm0
+        movhps [vq + pixelsq + 6], xm0
+%endif
+
+        add src0q, mmsize
+        add src1q, mmsize
+        add pixelsq, (6*mmsize)/16
+    jl  .loop
+RET
+
+%endmacro
+
+INIT_XMM ssse3
+v210_to_planar_420_10
+INIT_XMM avx
+v210_to_planar_420_10
+INIT_YMM avx2
+v210_to_planar_420_10
+%endif
@@ -28,6 +28,9 @@
 
 #include <stdint.h>
 
+#include "upipe/config.h"
+#include "upipe/ucpu.h"
+
 #include "v210dec.h"
 
 // TODO: handle endianness
@@ -79,3 +82,121 @@ void upipe_v210_to_planar_10_c(const void *src, uint16_t *y, uint16_t *u, uint16
         READ_PIXELS_10(y, v, y);
     }
 }
+
+/* average of the 10-bit fields at position shift of two v210 words */
+#define AVG_10(a, b, shift) \
+    (((((a) >> (shift)) & 1023) + (((b) >> (shift)) & 1023) + 1) >> 1)
+
+#define AVG_8(a, b, shift) \
+    (((((a) >> (shift)) & 1023) + (((b) >> (shift)) & 1023) + 4) >> 3)
+
+void upipe_v210_to_planar_420_8_c(const void *src0, const void *src1,
+                                  uint8_t *y0, uint8_t *y1,
+                                  uint8_t *u, uint8_t *v, uintptr_t pixels)
+{
+    const uint8_t *s0 = src0, *s1 = src1;
+
+    for(int i = 0; i < pixels-5; i += 6 ){
+        uint32_t a0 = rl32(s0), b0 = rl32(s0 + 4),
+                 c0 = rl32(s0 + 8), d0 = rl32(s0 + 12);
+        uint32_t a1 = rl32(s1), b1 = rl32(s1 + 4),
+                 c1 = rl32(s1 + 8), d1 = rl32(s1 + 12);
+        s0 += 16;
+        s1 += 16;
+
+        *y0++ = (a0 >> 12) & 255; *y1++ = (a1 >> 12) & 255;
+        *y0++ = (b0 >>  2) & 255; *y1++ = (b1 >>  2) & 255;
+        *y0++ = (b0 >> 22) & 255; *y1++ = (b1 >> 22) & 255;
+        *y0++ = (c0 >> 12) & 255; *y1++ = (c1 >> 12) & 255;
+        *y0++ = (d0 >>  2) & 255; *y1++ = (d1 >>  2) & 255;
+        *y0++ = (d0 >> 22) & 255; *y1++ = (d1 >> 22) & 255;
+
+        *u++ = AVG_8(a0, a1, 0);
+        *u++ = AVG_8(b0, b1, 10);
+        *u++ = AVG_8(c0, c1, 20);
+        *v++ = AVG_8(a0, a1, 20);
+        *v++ = AVG_8(c0, c1, 0);
+        *v++ = AVG_8(d0, d1, 10);
+    }
+}
+
+void upipe_v210_to_planar_420_10_c(const void *src0, const void *src1,
+                                   uint16_t *y0, uint16_t *y1,
+                                   uint16_t *u, uint16_t *v, uintptr_t pixels)
+{
+    const uint8_t *s0 = src0, *s1 = src1;
+
+    for(int i = 0; i < pixels-5; i += 6 ){
+        uint32_t a0 = rl32(s0), b0 = rl32(s0 + 4),
+                 c0 = rl32(s0 + 8), d0 = rl32(s0 + 12);
+        uint32_t a1 = rl32(s1), b1 = rl32(s1 + 4),
+                 c1 = rl32(s1 + 8), d1 = rl32(s1 + 12);
+        s0 += 16;
+        s1 += 16;
+
+        *y0++ = (a0 >> 10) & 1023; *y1++ = (a1 >> 10) & 1023;
+        *y0++ = (b0)       & 1023; *y1++ = (b1)       & 1023;
+        *y0++ = (b0 >> 20) & 1023; *y1++ = (b1 >> 20) & 1023;
+        *y0++ = (c0 >> 10) & 1023; *y1++ = (c1 >> 10) & 1023;
+        *y0++ = (d0)       & 1023; *y1++ = (d1)       & 1023;
+        *y0++ = (d0 >> 20) & 1023; *y1++ = (d1 >> 20) & 1023;
+
+        *u++ = AVG_10(a0, a1, 0);
+        *u++ = AVG_10(b0, b1, 10);
+        *u++ = AVG_10(c0, c1, 20);
+        *v++ = AVG_10(a0, a1, 20);
+        *v++ = AVG_10(c0, c1, 0);
+        *v++ = AVG_10(d0, d1, 10);
+    }
+}
+
+/* implementations of the kernels, best first */
+static const struct ucpu_impl upipe_v210_to_planar_10_impls[] = {
+#if defined(UPIPE_HAVE_X86ASM) && (defined(__i686__) || defined(__x86_64__))
+    UCPU_IMPL(upipe_v210_to_planar_10, avx512, UCPU_AVX512),
+    UCPU_IMPL(upipe_v210_to_planar_10, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_v210_to_planar_10, avx, UCPU_AVX),
+    UCPU_IMPL(upipe_v210_to_planar_10, ssse3, UCPU_SSSE3),
+#endif
+#ifdef UPIPE_HAVE_AARCH64ASM
+    UCPU_IMPL(upipe_v210_to_planar_10, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(upipe_v210_to_planar_10, c, 0),
+};
+
+struct ucpu_kernel upipe_v210_to_planar_10_kernel =
+    UCPU_KERNEL_INIT("v210_to_planar_10", upipe_v210_to_planar_10_impls);
+
+static const struct ucpu_impl upipe_v210_to_planar_8_impls[] = {
+#if defined(UPIPE_HAVE_X86ASM) && (defined(__i686__) || defined(__x86_64__))
+    UCPU_IMPL(upipe_v210_to_planar_8, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_v210_to_planar_8, avx, UCPU_AVX),
+    UCPU_IMPL(upipe_v210_to_planar_8, ssse3, UCPU_SSSE3),
+#endif
+    UCPU_IMPL(upipe_v210_to_planar_8, c, 0),
+};
+
+struct ucpu_kernel upipe_v210_to_planar_8_kernel =
+    UCPU_KERNEL_INIT("v210_to_planar_8", upipe_v210_to_planar_8_impls);
+
+static const struct ucpu_impl upipe_v210_to_planar_420_10_impls[] = {
+#if defined(UPIPE_HAVE_X86ASM) && defined(__x86_64__)
+    UCPU_IMPL(upipe_v210_to_planar_420_10, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_v210_to_planar_420_10, avx, UCPU_AVX),
+    UCPU_IMPL(upipe_v210_to_planar_420_10, ssse3, UCPU_SSSE3),
+#endif
+#ifdef UPIPE_HAVE_AARCH64ASM
+    UCPU_IMPL(upipe_v210_to_planar_420_10, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(upipe_v210_to_planar_420_10, c, 0),
+};
+
+struct ucpu_kernel upipe_v210_to_planar_420_10_kernel =
+    UCPU_KERNEL_INIT("v210_to_planar_420_10", upipe_v210_to_planar_420_10_impls);
+
+static const struct ucpu_impl upipe_v210_to_planar_420_8_impls[] = {
+    UCPU_IMPL(upipe_v210_to_planar_420_8, c, 0),
+};
+
+struct ucpu_kernel upipe_v210_to_planar_420_8_kernel =
+    UCPU_KERNEL_INIT("v210_to_planar_420_8", upipe_v210_to_planar_420_8_impls);
@@ -5,14 +5,38 @@
 void upipe_v210_to_planar_10_c(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
 void upipe_v210_to_planar_8_c(const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
 
+/* decode two lines at once, averaging their chroma (4:2:0 output) */
+void upipe_v210_to_planar_420_10_c(const void *src0, const void *src1, uint16_t *y0, uint16_t *y1, uint16_t *u, uint16_t *v, uintptr_t pixels);
+void upipe_v210_to_planar_420_8_c(const void *src0, const void *src1, uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v, uintptr_t pixels);
+
 /* process (6*mmsize)/16 pixels per iteration */
 void upipe_v210_to_planar_10_ssse3(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
 void upipe_v210_to_planar_10_avx  (const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
 void upipe_v210_to_planar_10_avx2 (const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
+void upipe_v210_to_planar_10_avx512(const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
+
+/* process 6 pixels at a time, without overrun */
+void upipe_v210_to_planar_10_neon (const void *src, uint16_t *y, uint16_t *u, uint16_t *v, uintptr_t pixels);
 
 /* process (6*mmsize)/16 pixels per iteration */
 void upipe_v210_to_planar_8_ssse3(const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
 void upipe_v210_to_planar_8_avx  (const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
 void upipe_v210_to_planar_8_avx2 (const void *src, uint8_t *y, uint8_t *u, uint8_t *v, uintptr_t pixels);
 
+/* process (6*mmsize)/16 pixels per iteration, x86_64 only */
+void upipe_v210_to_planar_420_10_ssse3(const void *src0, const void *src1, uint16_t *y0, uint16_t *y1, uint16_t *u, uint16_t *v, uintptr_t pixels);
+void upipe_v210_to_planar_420_10_avx  (const void *src0, const void *src1, uint16_t *y0, uint16_t *y1, uint16_t *u, uint16_t *v, uintptr_t pixels);
+void upipe_v210_to_planar_420_10_avx2 (const void *src0, const void *src1, uint16_t *y0, uint16_t *y1, uint16_t *u, uint16_t *v, uintptr_t pixels);
+
+/* process 6 pixels at a time, without overrun */
+void upipe_v210_to_planar_420_10_neon (const void *src0, const void *src1, uint16_t *y0, uint16_t *y1, uint16_t *u, uint16_t *v, uintptr_t pixels);
+
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of the kernels, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_v210_to_planar_10_kernel;
+extern struct ucpu_kernel upipe_v210_to_planar_8_kernel;
+extern struct ucpu_kernel upipe_v210_to_planar_420_10_kernel;
+extern struct ucpu_kernel upipe_v210_to_planar_420_8_kernel;
+
 #endif
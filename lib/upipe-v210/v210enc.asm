@@ -23,14 +23,14 @@
 
 SECTION_RODATA 64
 
-v210_enc_min_10: times 16 dw 0x0004
-v210_enc_max_10: times 16 dw 0x3fb
+v210_enc_min_10: times 32 dw 0x0004
+v210_enc_max_10: times 32 dw 0x3fb
 
-v210_enc_luma_mult_10: times 2 dw 4,1,16,4,1,16,0,0
-v210_enc_luma_shuf_10: times 2 db -1,0,1,-1,2,3,4,5,-1,6,7,-1,8,9,10,11
+v210_enc_luma_mult_10: times 4 dw 4,1,16,4,1,16,0,0
+v210_enc_luma_shuf_10: times 4 db -1,0,1,-1,2,3,4,5,-1,6,7,-1,8,9,10,11
 
-v210_enc_chroma_mult_10: times 2 dw 1,4,16,0,16,1,4,0
-v210_enc_chroma_shuf_10: times 2 db 0,1,8,9,-1,2,3,-1,10,11,4,5,-1,12,13,-1
+v210_enc_chroma_mult_10: times 4 dw 1,4,16,0,16,1,4,0
+v210_enc_chroma_shuf_10: times 4 db 0,1,8,9,-1,2,3,-1,10,11,4,5,-1,12,13,-1
 
 v210_enc_min_8: times 16 dw 0x0101
 v210_enc_max_8: times 16 dw 0xFEFE
@@ -56,21 +56,29 @@ cglobal planar_to_v210_10, 5, 5, 4+cpuflag(avx2), y, u, v, dst, width
 
     mova    m2, [v210_enc_min_10]
     mova    m3, [v210_enc_max_10]
+%if mmsize == 64
+    cmp     widthq, -24
+    jg      .tail
+%endif
 
 .loop:
     movu        xm0, [yq+2*widthq]
-%if cpuflag(avx2)
-    vinserti128 m0,   m0, [yq+widthq*2+12], 1
-%endif
+%assign i 1
+%rep mmsize/16 - 1
+    vinserti128 m0,   m0, [yq+widthq*2+12*i], i
+%assign i i+1
+%endrep
     CLIPW   m0, m2, m3
 
     movq         xm1, [uq+widthq]
     movhps       xm1, [vq+widthq]
-%if cpuflag(avx2)
-    movq         xm4, [uq+widthq+6]
-    movhps       xm4, [vq+widthq+6]
-    vinserti128  m1,   m1, xm4, 1
-%endif
+%assign i 1
+%rep mmsize/16 - 1
+    movq         xm4, [uq+widthq+6*i]
+    movhps       xm4, [vq+widthq+6*i]
+    vinserti128  m1,   m1, xm4, i
+%assign i i+1
+%endrep
     CLIPW   m1, m2, m3
 
     pmullw  m0, [v210_enc_luma_mult_10]
@@ -85,7 +93,39 @@ cglobal planar_to_v210_10, 5, 5, 4+cpuflag(avx2), y, u, v, dst, width
 
     add     dstq, mmsize
     add     widthq, (mmsize*3)/8
+%if mmsize == 64
+    cmp     widthq, -24
+    jle .loop
+
+    ; remaining pixels, 6 at a time so as not to read further than the
+    ; narrower variants
+.tail:
+    test    widthq, widthq
+    jge .end
+    movu    xm0, [yq+2*widthq]
+    CLIPW   xm0, xm2, xm3
+
+    movq    xm1, [uq+widthq]
+    movhps  xm1, [vq+widthq]
+    CLIPW   xm1, xm2, xm3
+
+    pmullw  xm0, [v210_enc_luma_mult_10]
+    pshufb  xm0, [v210_enc_luma_shuf_10]
+
+    pmullw  xm1, [v210_enc_chroma_mult_10]
+    pshufb  xm1, [v210_enc_chroma_shuf_10]
+
+    por     xm0, xm1
+
+    movu    [dstq], xm0
+
+    add     dstq, 16
+    add     widthq, 6
+    jl .tail
+.end:
+%else
     jl .loop
+%endif
 
     RET
 %endmacro
@@ -96,6 +136,9 @@ planar_to_v210_10
 INIT_YMM avx2
 planar_to_v210_10
 
+INIT_ZMM avx512
+planar_to_v210_10
+
 %macro planar_to_v210_8 0
 
 ; planar_to_v210_8(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, ptrdiff_t width)
@@ -28,7 +28,9 @@
 
 #include <stdint.h>
 
+#include "upipe/config.h"
 #include "upipe/ubase.h"
+#include "upipe/ucpu.h"
 
 #include "v210enc.h"
 
@@ -93,3 +95,31 @@ void upipe_planar_to_v210_10_c(const uint16_t *y, const uint16_t *u,
         WRITE_PIXELS(y, v, y);
     }
 }
+
+/* implementations of the kernels, best first */
+static const struct ucpu_impl upipe_planar_to_v210_10_impls[] = {
+#if defined(UPIPE_HAVE_X86ASM) && (defined(__i686__) || defined(__x86_64__))
+    UCPU_IMPL(upipe_planar_to_v210_10, avx512, UCPU_AVX512),
+    UCPU_IMPL(upipe_planar_to_v210_10, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_planar_to_v210_10, ssse3, UCPU_SSSE3),
+#endif
+#ifdef UPIPE_HAVE_AARCH64ASM
+    UCPU_IMPL(upipe_planar_to_v210_10, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(upipe_planar_to_v210_10, c, 0),
+};
+
+struct ucpu_kernel upipe_planar_to_v210_10_kernel =
+    UCPU_KERNEL_INIT("planar_to_v210_10", upipe_planar_to_v210_10_impls);
+
+static const struct ucpu_impl upipe_planar_to_v210_8_impls[] = {
+#if defined(UPIPE_HAVE_X86ASM) && (defined(__i686__) || defined(__x86_64__))
+    UCPU_IMPL(upipe_planar_to_v210_8, avx2, UCPU_AVX2),
+    UCPU_IMPL(upipe_planar_to_v210_8, avx, UCPU_AVX),
+    UCPU_IMPL(upipe_planar_to_v210_8, ssse3, UCPU_SSSE3),
+#endif
+    UCPU_IMPL(upipe_planar_to_v210_8, c, 0),
+};
+
+struct ucpu_kernel upipe_planar_to_v210_8_kernel =
+    UCPU_KERNEL_INIT("planar_to_v210_8", upipe_planar_to_v210_8_impls);
@@ -12,6 +12,10 @@ void upipe_planar_to_v210_10_avx2(const uint16_t *y, const uint16_t *u,
                                     const uint16_t *v, uint8_t *dst, ptrdiff_t pixels);
 void upipe_planar_to_v210_10_ssse3(const uint16_t *y, const uint16_t *u,
                                      const uint16_t *v, uint8_t *dst, ptrdiff_t pixels);
+void upipe_planar_to_v210_10_avx512(const uint16_t *y, const uint16_t *u,
+                                      const uint16_t *v, uint8_t *dst, ptrdiff_t pixels);
+void upipe_planar_to_v210_10_neon(const uint16_t *y, const uint16_t *u,
+                                    const uint16_t *v, uint8_t *dst, ptrdiff_t pixels);
 void upipe_planar_to_v210_8_ssse3(const uint8_t *y, const uint8_t *u,
                                     const uint8_t *v, uint8_t *dst, ptrdiff_t pixels);
 void upipe_planar_to_v210_8_avx(const uint8_t *y, const uint8_t *u,
@@ -19,4 +23,10 @@ void upipe_planar_to_v210_8_avx(const uint8_t *y, const uint8_t *u,
 void upipe_planar_to_v210_8_avx2(const uint8_t *y, const uint8_t *u,
                                    const uint8_t *v, uint8_t *dst, ptrdiff_t pixels);
 
+/** @hidden */
+struct ucpu_kernel;
+/* implementations of the kernels, see upipe/ucpu.h */
+extern struct ucpu_kernel upipe_planar_to_v210_10_kernel;
+extern struct ucpu_kernel upipe_planar_to_v210_8_kernel;
+
 #endif
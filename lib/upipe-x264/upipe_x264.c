@@ -68,6 +68,8 @@
 #define EXPECTED_FLOW "pic."
 #define OUT_FLOW "block.h264.pic."
 #define OUT_FLOW_MPEG2 "block.mpeg2video.pic."
+/** maximum lookahead of the low latency preset, in frames */
+#define UPIPE_X264_LOW_LOOKAHEAD 10
 
 /** @internal upipe_x264 private structure */
 struct upipe_x264 {
@@ -86,6 +88,10 @@ struct upipe_x264 {
     uint64_t sc_latency;
     /** true if the existing slice types must be enforced */
     bool slice_type_enforce;
+    /** pending target octetrate, applied on the next keyframe (or 0) */
+    uint64_t rate_octetrate;
+    /** pending buffer size, applied on the next keyframe (or 0) */
+    uint64_t rate_bs;
 
     /** x264 "PTS" */
     uint64_t x264_ts;
@@ -348,6 +354,83 @@ static int _upipe_x264_set_slice_type_enforce(struct upipe *upipe, bool enforce)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This applies the pending octetrate and buffer size.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_x264_apply_rate(struct upipe *upipe)
+{
+    struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+    x264_param_t *params = &upipe_x264->params;
+    params->rc.i_bitrate = upipe_x264->rate_octetrate / 125;
+    params->rc.i_vbv_max_bitrate = params->rc.i_bitrate;
+    if (upipe_x264->rate_bs)
+        params->rc.i_vbv_buffer_size = upipe_x264->rate_bs / 125;
+    upipe_x264->rate_octetrate = upipe_x264->rate_bs = 0;
+
+    upipe_verbose_va(upipe, "setting rate to %d kbit/s (VBV %d kbit)",
+                     params->rc.i_bitrate, params->rc.i_vbv_buffer_size);
+    if (upipe_x264->encoder != NULL &&
+        unlikely(!ubase_check(_upipe_x264_reconfigure(upipe))))
+        upipe_warn(upipe, "unable to apply new rate");
+}
+
+/** @internal @This sets the target octetrate and buffer size. The change
+ * is applied on the next keyframe, or immediately if the encoder is not
+ * open yet.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate target octetrate
+ * @param bs buffer size in octets, or 0 to keep the current one
+ * @return an error code
+ */
+static int _upipe_x264_set_rate(struct upipe *upipe,
+                                uint64_t octetrate, uint64_t bs)
+{
+    struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+    if (unlikely(octetrate < 125))
+        return UBASE_ERR_INVALID;
+    upipe_x264->rate_octetrate = octetrate;
+    upipe_x264->rate_bs = bs;
+    if (upipe_x264->encoder == NULL)
+        upipe_x264_apply_rate(upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This applies a latency preset to the parameters.
+ * upipe_x264_reconfigure must be called to apply changes.
+ *
+ * @param upipe description structure of the pipe
+ * @param latency latency preset
+ * @return an error code
+ */
+static int _upipe_x264_set_latency(struct upipe *upipe,
+                                   enum upipe_enc_latency latency)
+{
+    struct upipe_x264 *upipe_x264 = upipe_x264_from_upipe(upipe);
+    x264_param_t *params = &upipe_x264->params;
+    switch (latency) {
+        case UPIPE_ENC_LATENCY_ZERO:
+            /* same as the zerolatency tuning */
+            params->rc.i_lookahead = 0;
+            params->i_sync_lookahead = 0;
+            params->i_bframe = 0;
+            params->b_sliced_threads = 1;
+            params->b_vfr_input = 0;
+            params->rc.b_mb_tree = 0;
+            break;
+        case UPIPE_ENC_LATENCY_LOW:
+            if (params->rc.i_lookahead > UPIPE_X264_LOW_LOOKAHEAD)
+                params->rc.i_lookahead = UPIPE_X264_LOW_LOOKAHEAD;
+            params->i_sync_lookahead = 0;
+            params->i_bframe = 0;
+            break;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This allocates a filter pipe.
  *
  * @param mgr common management structure
@@ -372,6 +455,8 @@ static struct upipe *upipe_x264_alloc(struct upipe_mgr *mgr,
     upipe_x264->initial_latency = 0;
     upipe_x264->sc_latency = 0;
     upipe_x264->slice_type_enforce = false;
+    upipe_x264->rate_octetrate = 0;
+    upipe_x264->rate_bs = 0;
     upipe_x264->x264_ts = 0;
 
     upipe_x264_init_urefcount(upipe);
@@ -1026,6 +1111,8 @@ static bool upipe_x264_handle(struct upipe *upipe, struct uref *uref,
 
     if (pic.b_keyframe) {
         uref_flow_set_random(uref);
+        if (upipe_x264->rate_octetrate)
+            upipe_x264_apply_rate(upipe);
     }
 
     if (upipe_x264->flow_def == NULL)
@@ -1300,6 +1387,16 @@ static int upipe_x264_control(struct upipe *upipe, int command, va_list args)
             bool enforce = !(va_arg(args, int) == 0);
             return _upipe_x264_set_slice_type_enforce(upipe, enforce);
         }
+        case UPIPE_ENC_SET_RATE: {
+            uint64_t octetrate = va_arg(args, uint64_t);
+            uint64_t bs = va_arg(args, uint64_t);
+            return _upipe_x264_set_rate(upipe, octetrate, bs);
+        }
+        case UPIPE_ENC_SET_LATENCY: {
+            enum upipe_enc_latency latency =
+                va_arg(args, enum upipe_enc_latency);
+            return _upipe_x264_set_latency(upipe, latency);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
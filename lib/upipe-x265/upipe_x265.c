@@ -78,6 +78,8 @@
 
 #define EXPECTED_FLOW "pic."
 #define OUT_FLOW "block.hevc.pic."
+/** maximum lookahead of the low latency preset, in frames */
+#define UPIPE_X265_LOW_LOOKAHEAD 10
 
 // speed control presets
 //     ultrafast
@@ -128,6 +130,10 @@ struct upipe_x265 {
     uint64_t initial_latency;
     /** true if the existing slice types must be enforced */
     bool slice_type_enforce;
+    /** pending target octetrate, applied on the next keyframe (or 0) */
+    uint64_t rate_octetrate;
+    /** pending buffer size, applied on the next keyframe (or 0) */
+    uint64_t rate_bs;
     /** true if delayed frames are available */
     bool delayed_frames;
 
@@ -533,6 +539,79 @@ static int _upipe_x265_set_slice_type_enforce(struct upipe *upipe, bool enforce)
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This sets the target octetrate and buffer size. The change
+ * is applied on the next keyframe.
+ *
+ * @param upipe description structure of the pipe
+ * @param octetrate target octetrate
+ * @param bs buffer size in octets, or 0 to keep the current one
+ * @return an error code
+ */
+static int _upipe_x265_set_rate(struct upipe *upipe,
+                                uint64_t octetrate, uint64_t bs)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    if (unlikely(octetrate < 125))
+        return UBASE_ERR_INVALID;
+    upipe_x265->rate_octetrate = octetrate;
+    upipe_x265->rate_bs = bs;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This applies a latency preset to the parameters.
+ * upipe_x265_reconfigure must be called to apply changes.
+ *
+ * @param upipe description structure of the pipe
+ * @param latency latency preset
+ * @return an error code
+ */
+static int _upipe_x265_set_latency(struct upipe *upipe,
+                                   enum upipe_enc_latency latency)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    x265_param *params = &upipe_x265->params;
+    switch (latency) {
+        case UPIPE_ENC_LATENCY_ZERO:
+            /* same as the zerolatency tuning */
+            params->lookaheadDepth = 0;
+            params->bFrameAdaptive = 0;
+            params->bframes = 0;
+            params->scenecutThreshold = 0;
+            params->rc.cuTree = 0;
+            params->frameNumThreads = 1;
+            break;
+        case UPIPE_ENC_LATENCY_LOW:
+            if (params->lookaheadDepth > UPIPE_X265_LOW_LOOKAHEAD)
+                params->lookaheadDepth = UPIPE_X265_LOW_LOOKAHEAD;
+            params->bFrameAdaptive = 0;
+            params->bframes = 0;
+            break;
+        default:
+            return UBASE_ERR_INVALID;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This applies the pending octetrate and buffer size.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_x265_apply_rate(struct upipe *upipe)
+{
+    struct upipe_x265 *upipe_x265 = upipe_x265_from_upipe(upipe);
+    x265_param *params = &upipe_x265->params;
+    params->rc.bitrate = upipe_x265->rate_octetrate / 125;
+    params->rc.vbvMaxBitrate = params->rc.bitrate;
+    if (upipe_x265->rate_bs)
+        params->rc.vbvBufferSize = upipe_x265->rate_bs / 125;
+    upipe_x265->rate_octetrate = upipe_x265->rate_bs = 0;
+
+    upipe_verbose_va(upipe, "setting rate to %d kbit/s (VBV %d kbit)",
+                     params->rc.bitrate, params->rc.vbvBufferSize);
+    if (unlikely(!ubase_check(_upipe_x265_reconfigure(upipe))))
+        upipe_warn(upipe, "unable to apply new rate");
+}
+
 /** @internal @This allocates a filter pipe.
  *
  * @param mgr common management structure
@@ -560,10 +639,12 @@ static struct upipe *upipe_x265_alloc(struct upipe_mgr *mgr,
     upipe_x265->profile = NULL;
     ulist_init(&upipe_x265->options);
     upipe_x265->input_latency = 0;
-    upipe_x265->latency_frames = 3;
+    upipe_x265->latency_frames = 1;
     upipe_x265->initial_latency = 0;
     upipe_x265->sc_latency = 0;
     upipe_x265->slice_type_enforce = false;
+    upipe_x265->rate_octetrate = 0;
+    upipe_x265->rate_bs = 0;
     upipe_x265->delayed_frames = true;
 
     upipe_x265_init_urefcount(upipe);
@@ -787,10 +868,15 @@ static void upipe_x265_build_flow_def(struct upipe *upipe)
         return;
     }
 
-    /* find latency */
-    upipe_notice_va(upipe, "latency: %d frames", upipe_x265->latency_frames);
+    /* find latency: frames held by the lookahead and the frame threads,
+     * or the delay actually observed if it is larger */
+    int latency_frames = upipe_x265->params.lookaheadDepth +
+                         upipe_x265->params.frameNumThreads;
+    if (latency_frames < upipe_x265->latency_frames)
+        latency_frames = upipe_x265->latency_frames;
+    upipe_notice_va(upipe, "latency: %d frames", latency_frames);
     uint64_t latency = upipe_x265->input_latency +
-            (uint64_t)upipe_x265->latency_frames * UCLOCK_FREQ *
+            (uint64_t)latency_frames * UCLOCK_FREQ *
             upipe_x265->params.fpsDenom / upipe_x265->params.fpsNum;
 
     upipe_x265->initial_latency = latency;
@@ -1210,8 +1296,11 @@ err_invalid:
             uclock_now(upipe_x265->uclock);
     }
 
-    if (IS_X265_TYPE_I(pic.sliceType))
+    if (IS_X265_TYPE_I(pic.sliceType)) {
         uref_flow_set_random(uref);
+        if (upipe_x265->rate_octetrate)
+            upipe_x265_apply_rate(upipe);
+    }
 
     if (upipe_x265->flow_def == NULL)
         upipe_x265_build_flow_def(upipe);
@@ -1501,6 +1590,16 @@ static int upipe_x265_control(struct upipe *upipe, int command, va_list args)
             upipe_x265->profile = profile_dup;
             return UBASE_ERR_NONE;
         }
+        case UPIPE_ENC_SET_RATE: {
+            uint64_t octetrate = va_arg(args, uint64_t);
+            uint64_t bs = va_arg(args, uint64_t);
+            return _upipe_x265_set_rate(upipe, octetrate, bs);
+        }
+        case UPIPE_ENC_SET_LATENCY: {
+            enum upipe_enc_latency latency =
+                va_arg(args, enum upipe_enc_latency);
+            return _upipe_x265_set_latency(upipe, latency);
+        }
         case UPIPE_SET_OPTION: {
             const char *name = va_arg(args, const char *);
             const char *value = va_arg(args, const char *);
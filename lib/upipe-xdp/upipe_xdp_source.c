@@ -0,0 +1,1461 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short Upipe source module for AF_XDP sockets
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uatomic.h"
+#include "upipe/urefcount.h"
+#include "upipe/upool.h"
+#include "upipe/umpmc.h"
+#include "upipe/uprobe.h"
+#include "upipe/uclock.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/ubuf_block_common.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_clock.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_helper_upipe.h"
+#include "upipe/upipe_helper_urefcount.h"
+#include "upipe/upipe_helper_urefcount_real.h"
+#include "upipe/upipe_helper_void.h"
+#include "upipe/upipe_helper_uref_mgr.h"
+#include "upipe/upipe_helper_uclock.h"
+#include "upipe/upipe_helper_upump_mgr.h"
+#include "upipe/upipe_helper_upump.h"
+#include "upipe/upipe_helper_output.h"
+#include "upipe/upipe_helper_subpipe.h"
+#include "upipe-xdp/upipe_xdp_source.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <net/ethernet.h>
+#include <arpa/inet.h>
+
+#include <linux/if_link.h>
+#include <linux/if_xdp.h>
+#include <linux/bpf.h>
+
+/** number of descriptors in the receive ring */
+#define UPIPE_XDPSRC_RING_SIZE 2048
+/** number of frames in the UMEM area, and of descriptors in the fill ring */
+#define UPIPE_XDPSRC_NB_FRAMES (2 * UPIPE_XDPSRC_RING_SIZE)
+/** size of a UMEM frame */
+#define UPIPE_XDPSRC_FRAME_SIZE 4096
+/** number of descriptors in the completion ring, which is not used */
+#define UPIPE_XDPSRC_COMPLETION_SIZE 64
+/** maximum number of frames given back to the fill ring at once */
+#define UPIPE_XDPSRC_REFILL_BATCH 64
+/** depth of the pool of ubuf structures */
+#define UPIPE_XDPSRC_UBUF_POOL_DEPTH 1024
+/** maximum number of UDP ports redirected by the XDP program */
+#define UPIPE_XDPSRC_MAX_PORTS 256
+/** size of the log of the BPF verifier */
+#define UPIPE_XDPSRC_BPF_LOG_SIZE 4096
+
+/** @internal @This is a frame of the UMEM area. */
+struct upipe_xdpsrc_frame {
+    /** number of ubufs pointing to the frame */
+    uatomic_uint32_t refcount;
+    /** offset of the frame in the UMEM area */
+    uint64_t addr;
+};
+
+/** @internal @This is a block ubuf pointing into a UMEM frame. */
+struct upipe_xdpsrc_ubuf {
+    /** pointer to the frame */
+    struct upipe_xdpsrc_frame *frame;
+
+    /** common block structure */
+    struct ubuf_block ubuf_block;
+};
+
+UBASE_FROM_TO(upipe_xdpsrc_ubuf, ubuf, ubuf, ubuf_block.ubuf)
+
+/** @internal @This is the UMEM area registered with the socket. It is also
+ * the ubuf manager of the received blocks, so that it is kept until the last
+ * block is freed. */
+struct upipe_xdpsrc_umem {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** UMEM area */
+    uint8_t *area;
+    /** frames of the area */
+    struct upipe_xdpsrc_frame frames[UPIPE_XDPSRC_NB_FRAMES];
+    /** frames which were freed and may be given back to the fill ring */
+    struct umpmc recycle;
+    /** pool of ubuf structures */
+    struct upool ubuf_pool;
+
+    /** common management structure */
+    struct ubuf_mgr mgr;
+
+    /** extra space for umpmc and upool */
+    uint8_t extra[];
+};
+
+UBASE_FROM_TO(upipe_xdpsrc_umem, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(upipe_xdpsrc_umem, ubuf_mgr, ubuf_mgr, mgr)
+UBASE_FROM_TO(upipe_xdpsrc_umem, upool, ubuf_pool, ubuf_pool)
+
+/** @internal @This is a ring shared with the kernel. */
+struct upipe_xdpsrc_ring {
+    /** mapped memory */
+    void *map;
+    /** size of the mapped memory */
+    size_t map_size;
+    /** producer index */
+    uint32_t *producer;
+    /** consumer index */
+    uint32_t *consumer;
+    /** flags */
+    uint32_t *flags;
+    /** descriptors */
+    void *descs;
+    /** number of descriptors minus one */
+    uint32_t mask;
+};
+
+/** @hidden */
+static int upipe_xdpsrc_check(struct upipe *upipe, struct uref *flow_format);
+
+/** @internal @This is the private context of an xdp source pipe. */
+struct upipe_xdpsrc {
+    /** real refcount management structure */
+    struct urefcount urefcount_real;
+    /** refcount management structure exported to the public structure */
+    struct urefcount urefcount;
+
+    /** uref manager */
+    struct uref_mgr *uref_mgr;
+    /** uref manager request */
+    struct urequest uref_mgr_request;
+
+    /** uclock structure, if not NULL we are in live mode */
+    struct uclock *uclock;
+    /** uclock request */
+    struct urequest uclock_request;
+
+    /** upump manager */
+    struct upump_mgr *upump_mgr;
+    /** read watcher */
+    struct upump *upump;
+
+    /** uri */
+    char *uri;
+    /** interface index */
+    unsigned int ifindex;
+    /** receive queue */
+    unsigned int queue;
+
+    /** AF_XDP socket */
+    int fd;
+    /** true if the socket is bound in zero-copy mode */
+    bool zerocopy;
+    /** UMEM area */
+    struct upipe_xdpsrc_umem *umem;
+    /** receive ring */
+    struct upipe_xdpsrc_ring rx;
+    /** fill ring */
+    struct upipe_xdpsrc_ring fill;
+
+    /** BPF map of AF_XDP sockets */
+    int xsks_map_fd;
+    /** BPF map of redirected UDP ports */
+    int ports_map_fd;
+    /** XDP program */
+    int prog_fd;
+    /** link attaching the XDP program to the interface */
+    int link_fd;
+
+    /** list of subs */
+    struct uchain subs;
+    /** manager to create subs */
+    struct upipe_mgr sub_mgr;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_xdpsrc, upipe, UPIPE_XDPSRC_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_xdpsrc, urefcount, upipe_xdpsrc_no_ref)
+UPIPE_HELPER_UREFCOUNT_REAL(upipe_xdpsrc, urefcount_real, upipe_xdpsrc_free)
+UPIPE_HELPER_VOID(upipe_xdpsrc)
+
+UPIPE_HELPER_UREF_MGR(upipe_xdpsrc, uref_mgr, uref_mgr_request,
+                      upipe_xdpsrc_check,
+                      upipe_throw_provide_request, NULL)
+UPIPE_HELPER_UCLOCK(upipe_xdpsrc, uclock, uclock_request, upipe_xdpsrc_check,
+                    upipe_throw_provide_request, NULL)
+
+UPIPE_HELPER_UPUMP_MGR(upipe_xdpsrc, upump_mgr)
+UPIPE_HELPER_UPUMP(upipe_xdpsrc, upump, upump_mgr)
+
+/** @internal @This is the private context of an output of an xdp source
+ * pipe. */
+struct upipe_xdpsrc_sub {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** structure for double-linked lists */
+    struct uchain uchain;
+
+    /** pipe acting as output */
+    struct upipe *output;
+    /** flow definition packet */
+    struct uref *flow_def;
+    /** output state */
+    enum upipe_helper_output_state output_state;
+    /** list of output requests */
+    struct uchain request_list;
+
+    /** uri */
+    char *uri;
+    /** destination address, or INADDR_ANY */
+    struct in_addr addr;
+    /** destination port, or 0 if no uri was set */
+    uint16_t port;
+    /** socket used to join the multicast group, or -1 */
+    int fd;
+
+    /** public upipe structure */
+    struct upipe upipe;
+};
+
+UPIPE_HELPER_UPIPE(upipe_xdpsrc_sub, upipe, UPIPE_XDPSRC_SUB_SIGNATURE)
+UPIPE_HELPER_UREFCOUNT(upipe_xdpsrc_sub, urefcount, upipe_xdpsrc_sub_free)
+UPIPE_HELPER_VOID(upipe_xdpsrc_sub)
+UPIPE_HELPER_OUTPUT(upipe_xdpsrc_sub, output, flow_def, output_state,
+                    request_list)
+
+UPIPE_HELPER_SUBPIPE(upipe_xdpsrc, upipe_xdpsrc_sub, sub, sub_mgr, subs,
+                     uchain)
+
+/** @internal @This is a wrapper for the bpf system call.
+ *
+ * @param cmd command
+ * @param attr attributes of the command
+ * @return the return value of the system call
+ */
+static inline int upipe_xdpsrc_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+/** @internal @This gives a frame back if it is not referenced anymore.
+ *
+ * @param umem pointer to UMEM area
+ * @param frame pointer to frame
+ */
+static inline void upipe_xdpsrc_frame_release(struct upipe_xdpsrc_umem *umem,
+                                              struct upipe_xdpsrc_frame *frame)
+{
+    if (uatomic_fetch_sub(&frame->refcount, 1) == 1) {
+        /* the ring can hold all the frames */
+        bool ret = umpmc_push(&umem->recycle, frame);
+        assert(ret);
+        (void)ret;
+    }
+}
+
+/** @internal @This allocates a block ubuf pointing into a received frame.
+ *
+ * @param umem pointer to UMEM area
+ * @param frame pointer to referenced frame
+ * @param offset offset of the data in the frame
+ * @param size size of the data
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *upipe_xdpsrc_ubuf_alloc(struct upipe_xdpsrc_umem *umem,
+                                            struct upipe_xdpsrc_frame *frame,
+                                            size_t offset, size_t size)
+{
+    struct upipe_xdpsrc_ubuf *xdp_ubuf =
+        upool_alloc(&umem->ubuf_pool, struct upipe_xdpsrc_ubuf *);
+    if (unlikely(xdp_ubuf == NULL))
+        return NULL;
+
+    struct ubuf *ubuf = upipe_xdpsrc_ubuf_to_ubuf(xdp_ubuf);
+    xdp_ubuf->frame = frame;
+    ubuf_block_common_init(ubuf, false);
+    ubuf_block_common_set(ubuf, offset, size);
+    ubuf_block_common_set_buffer(ubuf, umem->area + frame->addr);
+    return ubuf;
+}
+
+/** @This refuses to allocate blocks, as UMEM frames are only filled by the
+ * kernel.
+ *
+ * @param mgr common management structure
+ * @param signature type of allocation
+ * @param args optional arguments
+ * @return NULL
+ */
+static struct ubuf *upipe_xdpsrc_umem_alloc_ubuf(struct ubuf_mgr *mgr,
+                                                 uint32_t signature,
+                                                 va_list args)
+{
+    return NULL;
+}
+
+/** @This creates a new reference to the same frame.
+ *
+ * @param ubuf pointer to ubuf
+ * @param new_ubuf_p reference written with a pointer to the newly allocated
+ * ubuf
+ * @param offset offset in the buffer, or 0 for a duplicate
+ * @param size final size of the buffer, or -1 for a duplicate
+ * @return an error code
+ */
+static int upipe_xdpsrc_ubuf_splice(struct ubuf *ubuf,
+                                    struct ubuf **new_ubuf_p,
+                                    int offset, int size)
+{
+    assert(new_ubuf_p != NULL);
+    struct upipe_xdpsrc_umem *umem = upipe_xdpsrc_umem_from_ubuf_mgr(ubuf->mgr);
+    struct upipe_xdpsrc_ubuf *xdp_ubuf = upipe_xdpsrc_ubuf_from_ubuf(ubuf);
+    struct upipe_xdpsrc_frame *frame = xdp_ubuf->frame;
+    uatomic_fetch_add(&frame->refcount, 1);
+    struct ubuf *new_ubuf = upipe_xdpsrc_ubuf_alloc(umem, frame, 0, 0);
+    if (unlikely(new_ubuf == NULL)) {
+        upipe_xdpsrc_frame_release(umem, frame);
+        return UBASE_ERR_ALLOC;
+    }
+
+    int err = size < 0 ? ubuf_block_common_dup(ubuf, new_ubuf) :
+              ubuf_block_common_splice(ubuf, new_ubuf, offset, size);
+    if (unlikely(!ubase_check(err))) {
+        ubuf_free(new_ubuf);
+        return UBASE_ERR_INVALID;
+    }
+    *new_ubuf_p = new_ubuf;
+    return UBASE_ERR_NONE;
+}
+
+/** @This handles control commands of received blocks.
+ *
+ * @param ubuf pointer to ubuf
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_xdpsrc_ubuf_control(struct ubuf *ubuf, int command,
+                                     va_list args)
+{
+    switch (command) {
+        case UBUF_DUP: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            return upipe_xdpsrc_ubuf_splice(ubuf, new_ubuf_p, 0, -1);
+        }
+        case UBUF_SINGLE: {
+            struct upipe_xdpsrc_ubuf *xdp_ubuf =
+                upipe_xdpsrc_ubuf_from_ubuf(ubuf);
+            return uatomic_load(&xdp_ubuf->frame->refcount) == 1 ?
+                   UBASE_ERR_NONE : UBASE_ERR_BUSY;
+        }
+        case UBUF_SPLICE_BLOCK: {
+            struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
+            int offset = va_arg(args, int);
+            int size = va_arg(args, int);
+            return upipe_xdpsrc_ubuf_splice(ubuf, new_ubuf_p, offset, size);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a received block, and gives its frame back if it is not
+ * referenced anymore.
+ *
+ * @param ubuf pointer to ubuf
+ */
+static void upipe_xdpsrc_ubuf_free(struct ubuf *ubuf)
+{
+    struct upipe_xdpsrc_umem *umem = upipe_xdpsrc_umem_from_ubuf_mgr(ubuf->mgr);
+    struct upipe_xdpsrc_ubuf *xdp_ubuf = upipe_xdpsrc_ubuf_from_ubuf(ubuf);
+    ubuf_block_common_clean(ubuf);
+    upipe_xdpsrc_frame_release(umem, xdp_ubuf->frame);
+    upool_free(&umem->ubuf_pool, xdp_ubuf);
+}
+
+/** @internal @This allocates a ubuf structure for the pool.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upipe_xdpsrc_ubuf or NULL in case of allocation error
+ */
+static void *upipe_xdpsrc_ubuf_alloc_inner(struct upool *upool)
+{
+    struct upipe_xdpsrc_umem *umem = upipe_xdpsrc_umem_from_ubuf_pool(upool);
+    struct upipe_xdpsrc_ubuf *xdp_ubuf =
+        malloc(sizeof(struct upipe_xdpsrc_ubuf));
+    if (unlikely(xdp_ubuf == NULL))
+        return NULL;
+    upipe_xdpsrc_ubuf_to_ubuf(xdp_ubuf)->mgr =
+        upipe_xdpsrc_umem_to_ubuf_mgr(umem);
+    return xdp_ubuf;
+}
+
+/** @internal @This frees a ubuf structure of the pool.
+ *
+ * @param upool pointer to upool
+ * @param xdp_ubuf pointer to upipe_xdpsrc_ubuf
+ */
+static void upipe_xdpsrc_ubuf_free_inner(struct upool *upool, void *xdp_ubuf)
+{
+    free(xdp_ubuf);
+}
+
+/** @This handles manager control commands.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_xdpsrc_umem_control(struct ubuf_mgr *mgr,
+                                     int command, va_list args)
+{
+    struct upipe_xdpsrc_umem *umem = upipe_xdpsrc_umem_from_ubuf_mgr(mgr);
+    switch (command) {
+        case UBUF_MGR_VACUUM:
+            upool_vacuum(&umem->ubuf_pool);
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This frees the UMEM area when neither the pipe nor a block
+ * refers to it anymore.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upipe_xdpsrc_umem_free(struct urefcount *urefcount)
+{
+    struct upipe_xdpsrc_umem *umem =
+        upipe_xdpsrc_umem_from_urefcount(urefcount);
+    upool_clean(&umem->ubuf_pool);
+    umpmc_clean(&umem->recycle);
+    for (unsigned int i = 0; i < UPIPE_XDPSRC_NB_FRAMES; i++)
+        uatomic_clean(&umem->frames[i].refcount);
+    munmap(umem->area, UPIPE_XDPSRC_NB_FRAMES * UPIPE_XDPSRC_FRAME_SIZE);
+    urefcount_clean(urefcount);
+    free(umem);
+}
+
+/** @internal @This allocates a UMEM area, with all its frames ready to be
+ * given to the fill ring.
+ *
+ * @return pointer to UMEM area, or NULL in case of allocation error
+ */
+static struct upipe_xdpsrc_umem *upipe_xdpsrc_umem_alloc(void)
+{
+    struct upipe_xdpsrc_umem *umem =
+        malloc(sizeof(struct upipe_xdpsrc_umem) +
+               umpmc_sizeof(UPIPE_XDPSRC_NB_FRAMES) +
+               upool_sizeof(UPIPE_XDPSRC_UBUF_POOL_DEPTH));
+    if (unlikely(umem == NULL))
+        return NULL;
+
+    umem->area = mmap(NULL, UPIPE_XDPSRC_NB_FRAMES * UPIPE_XDPSRC_FRAME_SIZE,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (unlikely(umem->area == MAP_FAILED)) {
+        free(umem);
+        return NULL;
+    }
+
+    urefcount_init(upipe_xdpsrc_umem_to_urefcount(umem),
+                   upipe_xdpsrc_umem_free);
+    umem->mgr.refcount = upipe_xdpsrc_umem_to_urefcount(umem);
+    umem->mgr.signature = UBUF_ALLOC_BLOCK;
+    umem->mgr.ubuf_alloc = upipe_xdpsrc_umem_alloc_ubuf;
+    umem->mgr.ubuf_control = upipe_xdpsrc_ubuf_control;
+    umem->mgr.ubuf_free = upipe_xdpsrc_ubuf_free;
+    umem->mgr.ubuf_mgr_control = upipe_xdpsrc_umem_control;
+
+    umpmc_init(&umem->recycle, UPIPE_XDPSRC_NB_FRAMES, umem->extra);
+    upool_init(&umem->ubuf_pool, umem->mgr.refcount,
+               UPIPE_XDPSRC_UBUF_POOL_DEPTH,
+               umem->extra + umpmc_sizeof(UPIPE_XDPSRC_NB_FRAMES),
+               upipe_xdpsrc_ubuf_alloc_inner, upipe_xdpsrc_ubuf_free_inner);
+
+    for (unsigned int i = 0; i < UPIPE_XDPSRC_NB_FRAMES; i++) {
+        struct upipe_xdpsrc_frame *frame = &umem->frames[i];
+        uatomic_init(&frame->refcount, 0);
+        frame->addr = (uint64_t)i * UPIPE_XDPSRC_FRAME_SIZE;
+        bool ret = umpmc_push(&umem->recycle, frame);
+        assert(ret);
+        (void)ret;
+    }
+    return umem;
+}
+
+/** @internal @This allocates an output subpipe of an xdp source pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_xdpsrc_sub_alloc(struct upipe_mgr *mgr,
+                                            struct uprobe *uprobe,
+                                            uint32_t signature, va_list args)
+{
+    struct upipe *upipe =
+        upipe_xdpsrc_sub_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_xdpsrc_sub *upipe_xdpsrc_sub =
+        upipe_xdpsrc_sub_from_upipe(upipe);
+    upipe_xdpsrc_sub_init_urefcount(upipe);
+    upipe_xdpsrc_sub_init_output(upipe);
+    upipe_xdpsrc_sub_init_sub(upipe);
+    upipe_xdpsrc_sub->uri = NULL;
+    upipe_xdpsrc_sub->addr.s_addr = htonl(INADDR_ANY);
+    upipe_xdpsrc_sub->port = 0;
+    upipe_xdpsrc_sub->fd = -1;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This redirects or stops redirecting a UDP port to the socket,
+ * depending on whether a sub-pipe still uses it.
+ *
+ * @param upipe description structure of the pipe
+ * @param port UDP port
+ */
+static void upipe_xdpsrc_update_port(struct upipe *upipe, uint16_t port)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    if (upipe_xdpsrc->ports_map_fd == -1 || !port)
+        return;
+
+    bool used = false;
+    struct uchain *uchain;
+    ulist_foreach (&upipe_xdpsrc->subs, uchain) {
+        struct upipe_xdpsrc_sub *sub = upipe_xdpsrc_sub_from_uchain(uchain);
+        if (sub->port == port) {
+            used = true;
+            break;
+        }
+    }
+
+    /* the program compares the port as loaded from the packet */
+    uint32_t key = htons(port);
+    uint32_t value = 1;
+    union bpf_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = upipe_xdpsrc->ports_map_fd;
+    attr.key = (uintptr_t)&key;
+    if (used) {
+        attr.value = (uintptr_t)&value;
+        attr.flags = BPF_ANY;
+        if (unlikely(upipe_xdpsrc_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0))
+            upipe_warn_va(upipe, "can't redirect port %"PRIu16" (%m)", port);
+    } else
+        upipe_xdpsrc_bpf(BPF_MAP_DELETE_ELEM, &attr);
+}
+
+/** @internal @This leaves the multicast group of a sub-pipe.
+ *
+ * @param upipe description structure of the sub-pipe
+ */
+static void upipe_xdpsrc_sub_leave(struct upipe *upipe)
+{
+    struct upipe_xdpsrc_sub *upipe_xdpsrc_sub =
+        upipe_xdpsrc_sub_from_upipe(upipe);
+    ubase_clean_fd(&upipe_xdpsrc_sub->fd);
+}
+
+/** @internal @This joins the multicast group of a sub-pipe on the
+ * interface, so that the interface accepts the datagrams.
+ *
+ * @param upipe description structure of the sub-pipe
+ */
+static void upipe_xdpsrc_sub_join(struct upipe *upipe)
+{
+    struct upipe_xdpsrc_sub *upipe_xdpsrc_sub =
+        upipe_xdpsrc_sub_from_upipe(upipe);
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_sub_mgr(upipe->mgr);
+    upipe_xdpsrc_sub_leave(upipe);
+    if (upipe_xdpsrc->fd == -1 ||
+        !IN_MULTICAST(ntohl(upipe_xdpsrc_sub->addr.s_addr)))
+        return;
+
+    struct ip_mreqn mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.imr_multiaddr = upipe_xdpsrc_sub->addr;
+    mreq.imr_ifindex = upipe_xdpsrc->ifindex;
+    upipe_xdpsrc_sub->fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (unlikely(upipe_xdpsrc_sub->fd == -1 ||
+                 setsockopt(upipe_xdpsrc_sub->fd, IPPROTO_IP,
+                            IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0)) {
+        upipe_warn_va(upipe, "can't join multicast group %s (%m)",
+                      upipe_xdpsrc_sub->uri);
+        ubase_clean_fd(&upipe_xdpsrc_sub->fd);
+    }
+}
+
+/** @internal @This sets the destination of the datagrams output by a
+ * sub-pipe.
+ *
+ * @param upipe description structure of the sub-pipe
+ * @param uri destination address and port, or NULL
+ * @return an error code
+ */
+static int upipe_xdpsrc_sub_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_xdpsrc_sub *upipe_xdpsrc_sub =
+        upipe_xdpsrc_sub_from_upipe(upipe);
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_sub_mgr(upipe->mgr);
+    uint16_t old_port = upipe_xdpsrc_sub->port;
+
+    upipe_xdpsrc_sub_leave(upipe);
+    ubase_clean_str(&upipe_xdpsrc_sub->uri);
+    upipe_xdpsrc_sub->addr.s_addr = htonl(INADDR_ANY);
+    upipe_xdpsrc_sub->port = 0;
+    upipe_xdpsrc_update_port(upipe_xdpsrc_to_upipe(upipe_xdpsrc), old_port);
+
+    if (uri == NULL)
+        return UBASE_ERR_NONE;
+
+    const char *colon = strrchr(uri, ':');
+    char *end;
+    unsigned long port = colon != NULL ? strtoul(colon + 1, &end, 10) : 0;
+    if (colon == NULL || !port || port > UINT16_MAX || *end) {
+        upipe_err_va(upipe, "invalid uri %s", uri);
+        return UBASE_ERR_INVALID;
+    }
+    if (colon != uri) {
+        char addr[colon - uri + 1];
+        memcpy(addr, uri, colon - uri);
+        addr[colon - uri] = '\0';
+        if (inet_pton(AF_INET, addr, &upipe_xdpsrc_sub->addr) != 1) {
+            upipe_err_va(upipe, "invalid address %s", addr);
+            return UBASE_ERR_INVALID;
+        }
+    }
+
+    upipe_xdpsrc_sub->uri = strdup(uri);
+    if (unlikely(upipe_xdpsrc_sub->uri == NULL)) {
+        upipe_xdpsrc_sub->addr.s_addr = htonl(INADDR_ANY);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_xdpsrc_sub->port = port;
+    upipe_xdpsrc_update_port(upipe_xdpsrc_to_upipe(upipe_xdpsrc), port);
+    upipe_xdpsrc_sub_join(upipe);
+    upipe_notice_va(upipe, "receiving %s", uri);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on an output subpipe of an
+ * xdp source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_xdpsrc_sub_control(struct upipe *upipe,
+                                    int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_xdpsrc_sub_control_super(upipe, command, args));
+    switch (command) {
+        case UPIPE_GET_FLOW_DEF:
+        case UPIPE_GET_OUTPUT:
+        case UPIPE_SET_OUTPUT:
+            return upipe_xdpsrc_sub_control_output(upipe, command, args);
+
+        case UPIPE_GET_URI: {
+            struct upipe_xdpsrc_sub *upipe_xdpsrc_sub =
+                upipe_xdpsrc_sub_from_upipe(upipe);
+            const char **uri_p = va_arg(args, const char **);
+            *uri_p = upipe_xdpsrc_sub->uri;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_xdpsrc_sub_set_uri(upipe, uri);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @This frees a sub-pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdpsrc_sub_free(struct upipe *upipe)
+{
+    struct upipe_xdpsrc_sub *upipe_xdpsrc_sub =
+        upipe_xdpsrc_sub_from_upipe(upipe);
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_sub_mgr(upipe->mgr);
+    uint16_t port = upipe_xdpsrc_sub->port;
+    upipe_throw_dead(upipe);
+
+    upipe_xdpsrc_sub_leave(upipe);
+    free(upipe_xdpsrc_sub->uri);
+    upipe_xdpsrc_sub_clean_output(upipe);
+    upipe_xdpsrc_sub_clean_sub(upipe);
+    upipe_xdpsrc_update_port(upipe_xdpsrc_to_upipe(upipe_xdpsrc), port);
+    upipe_xdpsrc_sub_clean_urefcount(upipe);
+    upipe_xdpsrc_sub_free_void(upipe);
+}
+
+/** @internal @This initializes the output manager for an xdp source pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdpsrc_init_sub_mgr(struct upipe *upipe)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    struct upipe_mgr *sub_mgr = &upipe_xdpsrc->sub_mgr;
+    sub_mgr->refcount = upipe_xdpsrc_to_urefcount_real(upipe_xdpsrc);
+    sub_mgr->signature = UPIPE_XDPSRC_SUB_SIGNATURE;
+    sub_mgr->upipe_alloc = upipe_xdpsrc_sub_alloc;
+    sub_mgr->upipe_input = NULL;
+    sub_mgr->upipe_control = upipe_xdpsrc_sub_control;
+    sub_mgr->upipe_mgr_control = NULL;
+}
+
+/** @internal @This allocates an xdp source pipe.
+ *
+ * @param mgr common management structure
+ * @param uprobe structure used to raise events
+ * @param signature signature of the pipe allocator
+ * @param args optional arguments
+ * @return pointer to upipe or NULL in case of allocation error
+ */
+static struct upipe *upipe_xdpsrc_alloc(struct upipe_mgr *mgr,
+                                        struct uprobe *uprobe,
+                                        uint32_t signature, va_list args)
+{
+    struct upipe *upipe = upipe_xdpsrc_alloc_void(mgr, uprobe, signature, args);
+    if (unlikely(upipe == NULL))
+        return NULL;
+
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    upipe_xdpsrc_init_urefcount(upipe);
+    upipe_xdpsrc_init_urefcount_real(upipe);
+    upipe_xdpsrc_init_uref_mgr(upipe);
+    upipe_xdpsrc_init_uclock(upipe);
+    upipe_xdpsrc_init_upump_mgr(upipe);
+    upipe_xdpsrc_init_upump(upipe);
+    upipe_xdpsrc_init_sub_subs(upipe);
+    upipe_xdpsrc_init_sub_mgr(upipe);
+    upipe_xdpsrc->uri = NULL;
+    upipe_xdpsrc->ifindex = 0;
+    upipe_xdpsrc->queue = 0;
+    upipe_xdpsrc->fd = -1;
+    upipe_xdpsrc->zerocopy = false;
+    upipe_xdpsrc->umem = NULL;
+    memset(&upipe_xdpsrc->rx, 0, sizeof(upipe_xdpsrc->rx));
+    memset(&upipe_xdpsrc->fill, 0, sizeof(upipe_xdpsrc->fill));
+    upipe_xdpsrc->xsks_map_fd = -1;
+    upipe_xdpsrc->ports_map_fd = -1;
+    upipe_xdpsrc->prog_fd = -1;
+    upipe_xdpsrc->link_fd = -1;
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** @internal @This gives the frames which were freed back to the fill ring,
+ * and wakes the driver up if it asked for it.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdpsrc_refill(struct upipe *upipe)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    struct upipe_xdpsrc_ring *fill = &upipe_xdpsrc->fill;
+    uint64_t *addrs = fill->descs;
+    uint32_t producer = *fill->producer;
+    bool refilled = false;
+
+    /* the fill ring has room for all the frames */
+    for ( ; ; ) {
+        void *frames[UPIPE_XDPSRC_REFILL_BATCH];
+        unsigned int nb = umpmc_pop_batch(&upipe_xdpsrc->umem->recycle,
+                                          frames, UPIPE_XDPSRC_REFILL_BATCH);
+        if (!nb)
+            break;
+        for (unsigned int i = 0; i < nb; i++) {
+            struct upipe_xdpsrc_frame *frame = frames[i];
+            addrs[producer++ & fill->mask] = frame->addr;
+        }
+        refilled = true;
+    }
+    if (!refilled)
+        return;
+
+    __atomic_store_n(fill->producer, producer, __ATOMIC_RELEASE);
+    if (__atomic_load_n(fill->flags, __ATOMIC_ACQUIRE) & XDP_RING_NEED_WAKEUP)
+        recvfrom(upipe_xdpsrc->fd, NULL, 0, MSG_DONTWAIT, NULL, NULL);
+}
+
+/** @internal @This outputs a received frame to the sub-pipe matching its
+ * destination, or gives it back.
+ *
+ * @param upipe description structure of the pipe
+ * @param frame pointer to referenced frame
+ * @param desc descriptor of the received packet
+ * @param systime date of the wake-up
+ */
+static void upipe_xdpsrc_demux(struct upipe *upipe,
+                               struct upipe_xdpsrc_frame *frame,
+                               const struct xdp_desc *desc, uint64_t systime)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    struct upipe_xdpsrc_umem *umem = upipe_xdpsrc->umem;
+    const uint8_t *packet = umem->area + desc->addr;
+    size_t len = desc->len;
+
+    struct ether_header eth;
+    struct iphdr ip;
+    struct udphdr udp;
+    if (unlikely(len < sizeof(eth) + sizeof(ip)))
+        goto drop;
+    memcpy(&eth, packet, sizeof(eth));
+    memcpy(&ip, packet + sizeof(eth), sizeof(ip));
+    size_t ip_len = ip.ihl * 4;
+    size_t header_len = sizeof(eth) + ip_len + sizeof(udp);
+    if (unlikely(eth.ether_type != htons(ETHERTYPE_IP) || ip.version != 4 ||
+                 ip_len < sizeof(ip) || ip.protocol != IPPROTO_UDP ||
+                 (ip.frag_off & htons(IP_MF | IP_OFFMASK)) ||
+                 len < header_len))
+        goto drop;
+    memcpy(&udp, packet + sizeof(eth) + ip_len, sizeof(udp));
+    size_t udp_len = ntohs(udp.len);
+    if (unlikely(udp_len < sizeof(udp) ||
+                 len < header_len - sizeof(udp) + udp_len))
+        goto drop;
+
+    uint16_t port = ntohs(udp.dest);
+    struct upipe_xdpsrc_sub *sub = NULL;
+    struct uchain *uchain;
+    ulist_foreach (&upipe_xdpsrc->subs, uchain) {
+        struct upipe_xdpsrc_sub *sub_iter =
+            upipe_xdpsrc_sub_from_uchain(uchain);
+        if (sub_iter->port == port &&
+            (sub_iter->addr.s_addr == htonl(INADDR_ANY) ||
+             sub_iter->addr.s_addr == ip.daddr)) {
+            sub = sub_iter;
+            break;
+        }
+    }
+    if (sub == NULL)
+        goto drop;
+
+    struct upipe *sub_upipe = upipe_xdpsrc_sub_to_upipe(sub);
+    if (unlikely(sub->flow_def == NULL)) {
+        struct uref *flow_def =
+            uref_block_flow_alloc_def(upipe_xdpsrc->uref_mgr, NULL);
+        if (unlikely(flow_def == NULL))
+            goto fatal;
+        upipe_xdpsrc_sub_store_flow_def(sub_upipe, flow_def);
+    }
+
+    struct ubuf *ubuf = upipe_xdpsrc_ubuf_alloc(umem, frame,
+            desc->addr - frame->addr + header_len, udp_len - sizeof(udp));
+    if (unlikely(ubuf == NULL))
+        goto fatal;
+    struct uref *uref = uref_alloc(upipe_xdpsrc->uref_mgr);
+    if (unlikely(uref == NULL)) {
+        ubuf_free(ubuf);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return;
+    }
+    uref_attach_ubuf(uref, ubuf);
+    if (likely(upipe_xdpsrc->uclock != NULL))
+        uref_clock_set_cr_sys(uref, systime);
+    upipe_xdpsrc_sub_output(sub_upipe, uref, &upipe_xdpsrc->upump);
+    return;
+
+fatal:
+    upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+drop:
+    upipe_xdpsrc_frame_release(umem, frame);
+}
+
+/** @internal @This reads the packets of the receive ring and outputs them.
+ *
+ * @param upump description structure of the read watcher
+ */
+static void upipe_xdpsrc_worker(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    struct upipe_xdpsrc_ring *rx = &upipe_xdpsrc->rx;
+    const struct xdp_desc *descs = rx->descs;
+
+    uint64_t systime = 0; /* to keep gcc quiet */
+    if (likely(upipe_xdpsrc->uclock != NULL))
+        systime = uclock_now(upipe_xdpsrc->uclock);
+
+    uint32_t consumer = *rx->consumer;
+    uint32_t producer = __atomic_load_n(rx->producer, __ATOMIC_ACQUIRE);
+    while (consumer != producer) {
+        struct xdp_desc desc = descs[consumer++ & rx->mask];
+        /* release the descriptor before the frame goes downstream */
+        __atomic_store_n(rx->consumer, consumer, __ATOMIC_RELEASE);
+
+        struct upipe_xdpsrc_frame *frame =
+            &upipe_xdpsrc->umem->frames[desc.addr / UPIPE_XDPSRC_FRAME_SIZE];
+        uatomic_store(&frame->refcount, 1);
+        upipe_xdpsrc_demux(upipe, frame, &desc, systime);
+
+        if (unlikely(upipe_xdpsrc->upump == NULL))
+            /* the socket was closed during output */
+            return;
+    }
+    upipe_xdpsrc_refill(upipe);
+}
+
+/** @internal @This checks if the pump may be allocated.
+ *
+ * @param upipe description structure of the pipe
+ * @param flow_format amended flow format
+ * @return an error code
+ */
+static int upipe_xdpsrc_check(struct upipe *upipe, struct uref *flow_format)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    if (flow_format != NULL)
+        uref_free(flow_format);
+
+    upipe_xdpsrc_check_upump_mgr(upipe);
+    if (upipe_xdpsrc->upump_mgr == NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_xdpsrc->uref_mgr == NULL) {
+        upipe_xdpsrc_require_uref_mgr(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    if (upipe_xdpsrc->uclock == NULL &&
+        urequest_get_opaque(&upipe_xdpsrc->uclock_request, struct upipe *)
+            != NULL)
+        return UBASE_ERR_NONE;
+
+    if (upipe_xdpsrc->fd != -1 && upipe_xdpsrc->upump == NULL) {
+        struct upump *upump;
+        upump = upump_alloc_fd_read(upipe_xdpsrc->upump_mgr,
+                                    upipe_xdpsrc_worker, upipe,
+                                    upipe->refcount, upipe_xdpsrc->fd);
+        if (unlikely(upump == NULL)) {
+            upipe_throw_fatal(upipe, UBASE_ERR_UPUMP);
+            return UBASE_ERR_UPUMP;
+        }
+        upipe_xdpsrc_set_upump(upipe, upump);
+        upump_start(upump);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This unmaps a ring.
+ *
+ * @param ring pointer to ring
+ */
+static void upipe_xdpsrc_unmap_ring(struct upipe_xdpsrc_ring *ring)
+{
+    if (ring->map != NULL)
+        munmap(ring->map, ring->map_size);
+    memset(ring, 0, sizeof(*ring));
+}
+
+/** @internal @This maps a ring of the socket.
+ *
+ * @param upipe description structure of the pipe
+ * @param ring pointer to ring
+ * @param off offsets of the ring
+ * @param pgoff page offset of the ring
+ * @param desc_size size of a descriptor
+ * @param size number of descriptors
+ * @return an error code
+ */
+static int upipe_xdpsrc_map_ring(struct upipe *upipe,
+                                 struct upipe_xdpsrc_ring *ring,
+                                 const struct xdp_ring_offset *off,
+                                 off_t pgoff, size_t desc_size, uint32_t size)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    ring->map_size = off->desc + size * desc_size;
+    ring->map = mmap(NULL, ring->map_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, upipe_xdpsrc->fd, pgoff);
+    if (unlikely(ring->map == MAP_FAILED)) {
+        ring->map = NULL;
+        upipe_err_va(upipe, "can't map ring (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+    uint8_t *map = ring->map;
+    ring->producer = (uint32_t *)(map + off->producer);
+    ring->consumer = (uint32_t *)(map + off->consumer);
+    ring->flags = (uint32_t *)(map + off->flags);
+    ring->descs = map + off->desc;
+    ring->mask = size - 1;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This creates an AF_XDP socket with its UMEM area and rings,
+ * and binds it to the receive queue.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_xdpsrc_open_socket(struct upipe *upipe)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    upipe_xdpsrc->umem = upipe_xdpsrc_umem_alloc();
+    if (unlikely(upipe_xdpsrc->umem == NULL)) {
+        upipe_err(upipe, "can't allocate UMEM area");
+        return UBASE_ERR_ALLOC;
+    }
+
+    upipe_xdpsrc->fd = socket(AF_XDP, SOCK_RAW, 0);
+    if (unlikely(upipe_xdpsrc->fd == -1)) {
+        upipe_err_va(upipe, "can't open AF_XDP socket (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct xdp_umem_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.addr = (uintptr_t)upipe_xdpsrc->umem->area;
+    reg.len = UPIPE_XDPSRC_NB_FRAMES * UPIPE_XDPSRC_FRAME_SIZE;
+    reg.chunk_size = UPIPE_XDPSRC_FRAME_SIZE;
+    reg.headroom = 0;
+    int fill_size = UPIPE_XDPSRC_NB_FRAMES;
+    int completion_size = UPIPE_XDPSRC_COMPLETION_SIZE;
+    int rx_size = UPIPE_XDPSRC_RING_SIZE;
+    if (unlikely(setsockopt(upipe_xdpsrc->fd, SOL_XDP, XDP_UMEM_REG,
+                            &reg, sizeof(reg)) < 0 ||
+                 setsockopt(upipe_xdpsrc->fd, SOL_XDP, XDP_UMEM_FILL_RING,
+                            &fill_size, sizeof(fill_size)) < 0 ||
+                 setsockopt(upipe_xdpsrc->fd, SOL_XDP,
+                            XDP_UMEM_COMPLETION_RING, &completion_size,
+                            sizeof(completion_size)) < 0 ||
+                 setsockopt(upipe_xdpsrc->fd, SOL_XDP, XDP_RX_RING,
+                            &rx_size, sizeof(rx_size)) < 0)) {
+        upipe_err_va(upipe, "can't register UMEM area (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    struct xdp_mmap_offsets off;
+    socklen_t optlen = sizeof(off);
+    if (unlikely(getsockopt(upipe_xdpsrc->fd, SOL_XDP, XDP_MMAP_OFFSETS,
+                            &off, &optlen) < 0)) {
+        upipe_err_va(upipe, "can't get ring offsets (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+    UBASE_RETURN(upipe_xdpsrc_map_ring(upipe, &upipe_xdpsrc->rx, &off.rx,
+                                       XDP_PGOFF_RX_RING,
+                                       sizeof(struct xdp_desc), rx_size))
+    UBASE_RETURN(upipe_xdpsrc_map_ring(upipe, &upipe_xdpsrc->fill, &off.fr,
+                                       XDP_UMEM_PGOFF_FILL_RING,
+                                       sizeof(uint64_t), fill_size))
+    upipe_xdpsrc_refill(upipe);
+
+    struct sockaddr_xdp sxdp;
+    memset(&sxdp, 0, sizeof(sxdp));
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = upipe_xdpsrc->ifindex;
+    sxdp.sxdp_queue_id = upipe_xdpsrc->queue;
+    sxdp.sxdp_flags = XDP_ZEROCOPY | XDP_USE_NEED_WAKEUP;
+    upipe_xdpsrc->zerocopy = true;
+    if (bind(upipe_xdpsrc->fd, (struct sockaddr *)&sxdp, sizeof(sxdp)) < 0) {
+        sxdp.sxdp_flags = XDP_COPY | XDP_USE_NEED_WAKEUP;
+        upipe_xdpsrc->zerocopy = false;
+        if (unlikely(bind(upipe_xdpsrc->fd, (struct sockaddr *)&sxdp,
+                          sizeof(sxdp)) < 0)) {
+            upipe_err_va(upipe, "can't bind AF_XDP socket (%m)");
+            return UBASE_ERR_EXTERNAL;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This creates the BPF maps, loads the XDP program redirecting
+ * the UDP datagrams sent to the ports of the sub-pipes to the socket, and
+ * attaches it to the interface.
+ *
+ * @param upipe description structure of the pipe
+ * @return an error code
+ */
+static int upipe_xdpsrc_load_program(struct upipe *upipe)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_XSKMAP;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = upipe_xdpsrc->queue + 1;
+    upipe_xdpsrc->xsks_map_fd = upipe_xdpsrc_bpf(BPF_MAP_CREATE, &attr);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_HASH;
+    attr.key_size = sizeof(uint32_t);
+    attr.value_size = sizeof(uint32_t);
+    attr.max_entries = UPIPE_XDPSRC_MAX_PORTS;
+    upipe_xdpsrc->ports_map_fd = upipe_xdpsrc_bpf(BPF_MAP_CREATE, &attr);
+    if (unlikely(upipe_xdpsrc->xsks_map_fd < 0 ||
+                 upipe_xdpsrc->ports_map_fd < 0)) {
+        upipe_err_va(upipe, "can't create BPF maps (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    uint32_t key = upipe_xdpsrc->queue;
+    uint32_t value = upipe_xdpsrc->fd;
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = upipe_xdpsrc->xsks_map_fd;
+    attr.key = (uintptr_t)&key;
+    attr.value = (uintptr_t)&value;
+    attr.flags = BPF_ANY;
+    if (unlikely(upipe_xdpsrc_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0)) {
+        upipe_err_va(upipe, "can't register AF_XDP socket (%m)");
+        return UBASE_ERR_EXTERNAL;
+    }
+
+#define INSN(c, d, s, o, i)                                                 \
+    ((struct bpf_insn){ .code = (c), .dst_reg = (d), .src_reg = (s),        \
+                        .off = (o), .imm = (i) })
+    /* Ethernet (14) + IPv4 without options (20) + UDP (8) */
+    const struct bpf_insn insns[] = {
+        /* 0: r6 = ctx */
+        INSN(BPF_ALU64 | BPF_MOV | BPF_X, 6, 1, 0, 0),
+        /* 1-2: r2 = data, r3 = data_end */
+        INSN(BPF_LDX | BPF_MEM | BPF_W, 2, 6, offsetof(struct xdp_md, data),
+             0),
+        INSN(BPF_LDX | BPF_MEM | BPF_W, 3, 6,
+             offsetof(struct xdp_md, data_end), 0),
+        /* 3-5: if (data + 42 > data_end) goto pass */
+        INSN(BPF_ALU64 | BPF_MOV | BPF_X, 4, 2, 0, 0),
+        INSN(BPF_ALU64 | BPF_ADD | BPF_K, 4, 0, 0, 42),
+        INSN(BPF_JMP | BPF_JGT | BPF_X, 4, 3, 23, 0),
+        /* 6-7: ethertype */
+        INSN(BPF_LDX | BPF_MEM | BPF_H, 5, 2, 12, 0),
+        INSN(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 21, htons(ETHERTYPE_IP)),
+        /* 8-9: version and header length */
+        INSN(BPF_LDX | BPF_MEM | BPF_B, 5, 2, 14, 0),
+        INSN(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 19, 0x45),
+        /* 10-11: protocol */
+        INSN(BPF_LDX | BPF_MEM | BPF_B, 5, 2, 23, 0),
+        INSN(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 17, IPPROTO_UDP),
+        /* 12-14: fragments */
+        INSN(BPF_LDX | BPF_MEM | BPF_H, 5, 2, 20, 0),
+        INSN(BPF_ALU64 | BPF_AND | BPF_K, 5, 0, 0, htons(IP_MF | IP_OFFMASK)),
+        INSN(BPF_JMP | BPF_JNE | BPF_K, 5, 0, 14, 0),
+        /* 15-22: if (!map_lookup_elem(ports, &dest)) goto pass */
+        INSN(BPF_LDX | BPF_MEM | BPF_H, 5, 2, 36, 0),
+        INSN(BPF_STX | BPF_MEM | BPF_W, 10, 5, -4, 0),
+        INSN(BPF_ALU64 | BPF_MOV | BPF_X, 2, 10, 0, 0),
+        INSN(BPF_ALU64 | BPF_ADD | BPF_K, 2, 0, 0, -4),
+        INSN(BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0,
+             upipe_xdpsrc->ports_map_fd),
+        INSN(0, 0, 0, 0, 0),
+        INSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem),
+        INSN(BPF_JMP | BPF_JEQ | BPF_K, 0, 0, 6, 0),
+        /* 23-28: return redirect_map(xsks, rx_queue_index, XDP_PASS) */
+        INSN(BPF_LDX | BPF_MEM | BPF_W, 2, 6,
+             offsetof(struct xdp_md, rx_queue_index), 0),
+        INSN(BPF_LD | BPF_DW | BPF_IMM, 1, BPF_PSEUDO_MAP_FD, 0,
+             upipe_xdpsrc->xsks_map_fd),
+        INSN(0, 0, 0, 0, 0),
+        INSN(BPF_ALU64 | BPF_MOV | BPF_K, 3, 0, 0, XDP_PASS),
+        INSN(BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+        INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+        /* 29-30: pass: return XDP_PASS */
+        INSN(BPF_ALU64 | BPF_MOV | BPF_K, 0, 0, 0, XDP_PASS),
+        INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+    };
+#undef INSN
+
+    char log[UPIPE_XDPSRC_BPF_LOG_SIZE];
+    log[0] = '\0';
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_XDP;
+    attr.insns = (uintptr_t)insns;
+    attr.insn_cnt = UBASE_ARRAY_SIZE(insns);
+    attr.license = (uintptr_t)"LGPL";
+    attr.log_buf = (uintptr_t)log;
+    attr.log_size = sizeof(log);
+    attr.log_level = 1;
+    upipe_xdpsrc->prog_fd = upipe_xdpsrc_bpf(BPF_PROG_LOAD, &attr);
+    if (unlikely(upipe_xdpsrc->prog_fd < 0)) {
+        upipe_err_va(upipe, "can't load XDP program (%m)");
+        if (log[0])
+            upipe_dbg_va(upipe, "%s", log);
+        return UBASE_ERR_EXTERNAL;
+    }
+
+    /* try native mode first */
+    memset(&attr, 0, sizeof(attr));
+    attr.link_create.prog_fd = upipe_xdpsrc->prog_fd;
+    attr.link_create.target_ifindex = upipe_xdpsrc->ifindex;
+    attr.link_create.attach_type = BPF_XDP;
+    attr.link_create.flags = XDP_FLAGS_DRV_MODE;
+    upipe_xdpsrc->link_fd = upipe_xdpsrc_bpf(BPF_LINK_CREATE, &attr);
+    if (upipe_xdpsrc->link_fd < 0) {
+        attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+        upipe_xdpsrc->link_fd = upipe_xdpsrc_bpf(BPF_LINK_CREATE, &attr);
+        if (unlikely(upipe_xdpsrc->link_fd < 0)) {
+            upipe_err_va(upipe, "can't attach XDP program (%m)");
+            return UBASE_ERR_EXTERNAL;
+        }
+        upipe_warn(upipe, "XDP program attached in generic mode");
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This closes the socket and detaches the XDP program.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdpsrc_close(struct upipe *upipe)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    upipe_xdpsrc_set_upump(upipe, NULL);
+    if (upipe_xdpsrc->fd != -1 && upipe_xdpsrc->uri != NULL)
+        upipe_notice_va(upipe, "closing AF_XDP socket %s", upipe_xdpsrc->uri);
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_xdpsrc->subs, uchain) {
+        struct upipe_xdpsrc_sub *sub = upipe_xdpsrc_sub_from_uchain(uchain);
+        upipe_xdpsrc_sub_leave(upipe_xdpsrc_sub_to_upipe(sub));
+    }
+
+    ubase_clean_fd(&upipe_xdpsrc->link_fd);
+    ubase_clean_fd(&upipe_xdpsrc->prog_fd);
+    ubase_clean_fd(&upipe_xdpsrc->ports_map_fd);
+    ubase_clean_fd(&upipe_xdpsrc->xsks_map_fd);
+    upipe_xdpsrc_unmap_ring(&upipe_xdpsrc->rx);
+    upipe_xdpsrc_unmap_ring(&upipe_xdpsrc->fill);
+    ubase_clean_fd(&upipe_xdpsrc->fd);
+    if (upipe_xdpsrc->umem != NULL) {
+        urefcount_release(upipe_xdpsrc_umem_to_urefcount(upipe_xdpsrc->umem));
+        upipe_xdpsrc->umem = NULL;
+    }
+    upipe_xdpsrc->zerocopy = false;
+}
+
+/** @internal @This returns the uri of the currently opened interface.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri_p filled in with the uri
+ * @return an error code
+ */
+static int upipe_xdpsrc_get_uri(struct upipe *upipe, const char **uri_p)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    assert(uri_p != NULL);
+    *uri_p = upipe_xdpsrc->uri;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This asks to open the given interface and receive queue.
+ *
+ * @param upipe description structure of the pipe
+ * @param uri interface name, optionally followed by /queue
+ * @return an error code
+ */
+static int upipe_xdpsrc_set_uri(struct upipe *upipe, const char *uri)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    upipe_xdpsrc_close(upipe);
+    ubase_clean_str(&upipe_xdpsrc->uri);
+
+    if (unlikely(uri == NULL))
+        return UBASE_ERR_NONE;
+
+    char ifname[IF_NAMESIZE];
+    const char *slash = strchr(uri, '/');
+    size_t ifname_len = slash != NULL ? (size_t)(slash - uri) : strlen(uri);
+    unsigned long queue = 0;
+    char *end = NULL;
+    if (slash != NULL)
+        queue = strtoul(slash + 1, &end, 10);
+    if (!ifname_len || ifname_len >= IF_NAMESIZE ||
+        (slash != NULL && (end == slash + 1 || *end || queue > UINT16_MAX))) {
+        upipe_err_va(upipe, "invalid AF_XDP uri %s", uri);
+        return UBASE_ERR_INVALID;
+    }
+    memcpy(ifname, uri, ifname_len);
+    ifname[ifname_len] = '\0';
+    upipe_xdpsrc->ifindex = if_nametoindex(ifname);
+    if (unlikely(!upipe_xdpsrc->ifindex)) {
+        upipe_err_va(upipe, "unknown interface %s", ifname);
+        return UBASE_ERR_EXTERNAL;
+    }
+    upipe_xdpsrc->queue = queue;
+
+    int err = upipe_xdpsrc_open_socket(upipe);
+    if (ubase_check(err))
+        err = upipe_xdpsrc_load_program(upipe);
+    if (unlikely(!ubase_check(err))) {
+        upipe_xdpsrc_close(upipe);
+        return err;
+    }
+
+    upipe_xdpsrc->uri = strdup(uri);
+    if (unlikely(upipe_xdpsrc->uri == NULL)) {
+        upipe_xdpsrc_close(upipe);
+        upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+        return UBASE_ERR_ALLOC;
+    }
+    upipe_notice_va(upipe, "opening AF_XDP socket %s (%s mode)",
+                    upipe_xdpsrc->uri,
+                    upipe_xdpsrc->zerocopy ? "zero-copy" : "copy");
+
+    struct uchain *uchain;
+    ulist_foreach (&upipe_xdpsrc->subs, uchain) {
+        struct upipe_xdpsrc_sub *sub = upipe_xdpsrc_sub_from_uchain(uchain);
+        upipe_xdpsrc_update_port(upipe, sub->port);
+        upipe_xdpsrc_sub_join(upipe_xdpsrc_sub_to_upipe(sub));
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This processes control commands on an xdp source pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int _upipe_xdpsrc_control(struct upipe *upipe,
+                                 int command, va_list args)
+{
+    UBASE_HANDLED_RETURN(upipe_xdpsrc_control_subs(upipe, command, args));
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            upipe_xdpsrc_set_upump(upipe, NULL);
+            return upipe_xdpsrc_attach_upump_mgr(upipe);
+        case UPIPE_ATTACH_UCLOCK:
+            upipe_xdpsrc_set_upump(upipe, NULL);
+            upipe_xdpsrc_require_uclock(upipe);
+            return UBASE_ERR_NONE;
+
+        case UPIPE_GET_URI: {
+            const char **uri_p = va_arg(args, const char **);
+            return upipe_xdpsrc_get_uri(upipe, uri_p);
+        }
+        case UPIPE_SET_URI: {
+            const char *uri = va_arg(args, const char *);
+            return upipe_xdpsrc_set_uri(upipe, uri);
+        }
+        case UPIPE_XDPSRC_GET_ZEROCOPY: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_XDPSRC_SIGNATURE)
+            struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+            int *zerocopy_p = va_arg(args, int *);
+            *zerocopy_p = upipe_xdpsrc->zerocopy;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This processes control commands on an xdp source pipe, and
+ * checks the status of the pipe afterwards.
+ *
+ * @param upipe description structure of the pipe
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upipe_xdpsrc_control(struct upipe *upipe, int command, va_list args)
+{
+    UBASE_RETURN(_upipe_xdpsrc_control(upipe, command, args));
+
+    return upipe_xdpsrc_check(upipe, NULL);
+}
+
+/** @This frees a upipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdpsrc_free(struct upipe *upipe)
+{
+    struct upipe_xdpsrc *upipe_xdpsrc = upipe_xdpsrc_from_upipe(upipe);
+    upipe_throw_dead(upipe);
+
+    free(upipe_xdpsrc->uri);
+    upipe_xdpsrc_clean_sub_subs(upipe);
+    upipe_xdpsrc_clean_upump(upipe);
+    upipe_xdpsrc_clean_upump_mgr(upipe);
+    upipe_xdpsrc_clean_uclock(upipe);
+    upipe_xdpsrc_clean_uref_mgr(upipe);
+    upipe_xdpsrc_clean_urefcount_real(upipe);
+    upipe_xdpsrc_clean_urefcount(upipe);
+    upipe_xdpsrc_free_void(upipe);
+}
+
+/** @This is called when there is no external reference to the pipe anymore.
+ *
+ * @param upipe description structure of the pipe
+ */
+static void upipe_xdpsrc_no_ref(struct upipe *upipe)
+{
+    upipe_xdpsrc_close(upipe);
+    upipe_xdpsrc_throw_sub_subs(upipe, UPROBE_SOURCE_END);
+    upipe_xdpsrc_release_urefcount_real(upipe);
+}
+
+/** module manager static descriptor */
+static struct upipe_mgr upipe_xdpsrc_mgr = {
+    .refcount = NULL,
+    .signature = UPIPE_XDPSRC_SIGNATURE,
+
+    .upipe_alloc = upipe_xdpsrc_alloc,
+    .upipe_input = NULL,
+    .upipe_control = upipe_xdpsrc_control,
+
+    .upipe_mgr_control = NULL
+};
+
+/** @This returns the management structure for all xdp source pipes.
+ *
+ * @return pointer to manager
+ */
+struct upipe_mgr *upipe_xdpsrc_mgr_alloc(void)
+{
+    return &upipe_xdpsrc_mgr;
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe buffer handling for block managers
+ * This file defines the start code scanners of the block-specific API.
+ *
+ * The SIMD kernels compare 16 or 32 candidate positions at once against
+ * the three octets of the start code, so that payloads with many zero
+ * octets do not fall back to octet-per-octet checks.
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/ucpu.h"
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/** @hidden */
+#define UBUF_BLOCK_SCAN_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+/** @hidden */
+#define UBUF_BLOCK_SCAN_NEON
+#include <arm_neon.h>
+#endif
+
+/** @internal @This scans for a start code, one candidate at a time.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @return pointer to the start code, or end if not found
+ */
+/* Skipping logic from libav/libavcodec/mpegvideo.c, published under
+ * LGPL 2.1+ */
+static const uint8_t *ubuf_block_scan_startcode_c(const uint8_t *p,
+                                                  const uint8_t *end)
+{
+    /* q points to the last octet of the candidate */
+    const uint8_t *q = p + 2;
+    while (q < end) {
+        if      (q[0] > 1              ) q += 3;
+        else if (q[-1]                 ) q += 2;
+        else if (q[-2] | (q[0] - 1)    ) q++;
+        else
+            return q - 2;
+    }
+    return end;
+}
+
+#ifdef UBUF_BLOCK_SCAN_X86
+/** @internal @This scans for a start code, 16 candidates at a time.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @return pointer to the start code, or end if not found
+ */
+__attribute__((target("sse2")))
+static const uint8_t *ubuf_block_scan_startcode_sse2(const uint8_t *p,
+                                                     const uint8_t *end)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    while (end - p >= 16 + 2) {
+        __m128i a = _mm_loadu_si128((const __m128i *)p);
+        __m128i b = _mm_loadu_si128((const __m128i *)(p + 1));
+        __m128i c = _mm_loadu_si128((const __m128i *)(p + 2));
+        __m128i m = _mm_and_si128(_mm_cmpeq_epi8(a, zero),
+                                  _mm_cmpeq_epi8(b, zero));
+        m = _mm_and_si128(m, _mm_cmpeq_epi8(c, one));
+        int mask = _mm_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return ubuf_block_scan_startcode_c(p, end);
+}
+
+/** @internal @This scans for a start code, 32 candidates at a time.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @return pointer to the start code, or end if not found
+ */
+__attribute__((target("avx2")))
+static const uint8_t *ubuf_block_scan_startcode_avx2(const uint8_t *p,
+                                                     const uint8_t *end)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    while (end - p >= 32 + 2) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)p);
+        __m256i b = _mm256_loadu_si256((const __m256i *)(p + 1));
+        __m256i c = _mm256_loadu_si256((const __m256i *)(p + 2));
+        __m256i m = _mm256_and_si256(_mm256_cmpeq_epi8(a, zero),
+                                     _mm256_cmpeq_epi8(b, zero));
+        m = _mm256_and_si256(m, _mm256_cmpeq_epi8(c, one));
+        uint32_t mask = _mm256_movemask_epi8(m);
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return ubuf_block_scan_startcode_c(p, end);
+}
+#endif
+
+#ifdef UBUF_BLOCK_SCAN_NEON
+/** @internal @This scans for a start code, 16 candidates at a time.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @return pointer to the start code, or end if not found
+ */
+static const uint8_t *ubuf_block_scan_startcode_neon(const uint8_t *p,
+                                                     const uint8_t *end)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    while (end - p >= 16 + 2) {
+        uint8x16_t a = vld1q_u8(p);
+        uint8x16_t b = vld1q_u8(p + 1);
+        uint8x16_t c = vld1q_u8(p + 2);
+        uint8x16_t m = vandq_u8(vceqq_u8(a, zero), vceqq_u8(b, zero));
+        m = vandq_u8(m, vceqq_u8(c, one));
+        uint64x2_t m64 = vreinterpretq_u64_u8(m);
+        if (vgetq_lane_u64(m64, 0) | vgetq_lane_u64(m64, 1))
+            /* there is no cheap movemask, locate the match in scalar */
+            return ubuf_block_scan_startcode_c(p, p + 16 + 2);
+        p += 16;
+    }
+    return ubuf_block_scan_startcode_c(p, end);
+}
+#endif
+
+/** @internal @This lists the start code scanners, best first. */
+static const struct ucpu_impl ubuf_block_scan_startcode_impls[] = {
+#if defined(UBUF_BLOCK_SCAN_X86)
+    UCPU_IMPL(ubuf_block_scan_startcode, avx2, UCPU_AVX2),
+    UCPU_IMPL(ubuf_block_scan_startcode, sse2, UCPU_SSE2),
+#elif defined(UBUF_BLOCK_SCAN_NEON)
+    UCPU_IMPL(ubuf_block_scan_startcode, neon, UCPU_NEON),
+#endif
+    UCPU_IMPL(ubuf_block_scan_startcode, c, 0),
+};
+
+/** start code scanner kernel */
+struct ucpu_kernel ubuf_block_scan_startcode_kernel =
+    UCPU_KERNEL_INIT("scan_startcode", ubuf_block_scan_startcode_impls);
+
+/** @This scans a linear buffer for an MPEG-style 3-octet start code
+ * (00 00 01), using the fastest kernel supported by the CPU.
+ *
+ * @param p linear buffer
+ * @param end end of linear buffer
+ * @return pointer to the first octet of the first start code lying entirely
+ * in the buffer, or end if none was found
+ */
+const uint8_t *ubuf_block_scan_startcode(const uint8_t *p, const uint8_t *end)
+{
+    if (end - p < 16 + 2)
+        return ubuf_block_scan_startcode_c(p, end);
+    return UCPU_KERNEL_FUNC(&ubuf_block_scan_startcode_kernel,
+                            __typeof__(&ubuf_block_scan_startcode_c))(p, end);
+}
@@ -52,6 +52,10 @@
 #define UBUF_DEFAULT_PREPEND        32
 /** default minimum extra space after buffer when unspecified */
 #define UBUF_DEFAULT_APPEND         0
+/** number of structures fetched at once from the pools in batch mode */
+#define UBUF_BLOCK_MEM_BATCH        32
+/** alignment of slabs (cache line) */
+#define UBUF_BLOCK_MEM_SLAB_ALIGN   64
 
 /** @This is a super-set of the @ref ubuf (and @ref ubuf_block)
  * structure with private fields pointing to shared data. */
@@ -65,6 +69,22 @@ struct ubuf_block_mem {
 
 UBASE_FROM_TO(ubuf_block_mem, ubuf, ubuf, ubuf_block.ubuf)
 
+/** @This is a slab holding a small block ubuf, its shared structure and its
+ * buffer in a single allocation. The slab lives as long as the shared
+ * structure, so it may outlive its own ubuf structure if the block was
+ * duplicated. */
+struct ubuf_block_mem_slab {
+    /** ubuf structure */
+    struct ubuf_block_mem block_mem;
+    /** shared structure */
+    struct ubuf_mem_shared shared;
+
+    /** buffer space */
+    uint8_t buffer[] __attribute__ ((aligned (UBUF_BLOCK_MEM_SLAB_ALIGN)));
+};
+
+UBASE_FROM_TO(ubuf_block_mem_slab, ubuf_mem_shared, ubuf_mem_shared, shared)
+
 /** @This is a super-set of the ubuf_mgr structure with additional local
  * members. */
 struct ubuf_block_mem_mgr {
@@ -84,6 +104,12 @@ struct ubuf_block_mem_mgr {
     struct upool ubuf_pool;
     /** ubuf shared pool */
     struct upool shared_pool;
+    /** maximum size of a block allocated in a slab, or 0 */
+    size_t slab_size;
+    /** size of the buffer space of slabs */
+    size_t slab_capacity;
+    /** pool of slabs */
+    struct upool slab_pool;
     /** umem allocator */
     struct umem_mgr *umem_mgr;
 
@@ -97,9 +123,132 @@ struct ubuf_block_mem_mgr {
 UBASE_FROM_TO(ubuf_block_mem_mgr, ubuf_mgr, ubuf_mgr, mgr)
 UBASE_FROM_TO(ubuf_block_mem_mgr, urefcount, urefcount, urefcount)
 UBASE_FROM_TO(ubuf_block_mem_mgr, upool, ubuf_pool, ubuf_pool)
+UBASE_FROM_TO(ubuf_block_mem_mgr, upool, slab_pool, slab_pool)
 
 UBUF_MEM_MGR_HELPER_POOL(ubuf_block_mem, ubuf_pool, shared_pool, shared)
 
+/** @internal @This allocates the umem buffer of a new block ubuf, and sets
+ * the block to point to it.
+ *
+ * @param mgr common management structure
+ * @param block_mem pointer to ubuf_block_mem, with a shared structure
+ * @param size size of the block
+ * @return an error code
+ */
+static int ubuf_block_mem_alloc_buffer(struct ubuf_mgr *mgr,
+                                       struct ubuf_block_mem *block_mem,
+                                       int size)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    struct ubuf *ubuf = ubuf_block_mem_to_ubuf(block_mem);
+    size_t buffer_size = size + block_mem_mgr->prepend + block_mem_mgr->align +
+        block_mem_mgr->append;
+    if (unlikely(!umem_alloc(block_mem_mgr->umem_mgr, &block_mem->shared->umem,
+                             buffer_size)))
+        return UBASE_ERR_ALLOC;
+
+    size_t offset = block_mem_mgr->prepend + block_mem_mgr->align;
+    if (block_mem_mgr->align)
+        offset -= ((uintptr_t)ubuf_mem_shared_buffer(block_mem->shared) +
+                  offset + block_mem_mgr->align_offset) % block_mem_mgr->align;
+    ubuf_block_common_set(ubuf, offset, size);
+    ubuf_block_common_set_buffer(ubuf,
+                                 ubuf_mem_shared_buffer(block_mem->shared));
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This checks if the shared structure of a block is in a slab.
+ *
+ * @param mgr common management structure
+ * @param shared pointer to shared structure
+ * @return true if the shared structure is in a slab
+ */
+static inline bool ubuf_block_mem_is_slab(struct ubuf_mgr *mgr,
+                                          struct ubuf_mem_shared *shared)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    return shared->pool == &block_mem_mgr->slab_pool;
+}
+
+/** @internal @This initializes a block ubuf from a slab.
+ *
+ * @param mgr common management structure
+ * @param slab pointer to slab, fetched from the pool
+ * @param size size of the block
+ * @return pointer to ubuf
+ */
+static struct ubuf *ubuf_block_mem_slab_init(struct ubuf_mgr *mgr,
+                                             struct ubuf_block_mem_slab *slab,
+                                             int size)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    struct ubuf *ubuf = ubuf_block_mem_to_ubuf(&slab->block_mem);
+    uatomic_store(&slab->shared.refcount, 1);
+    slab->block_mem.shared = &slab->shared;
+    ubuf_block_common_init(ubuf, false);
+    ubuf_block_common_set_refcount(ubuf, &slab->shared.refcount);
+
+    size_t offset = block_mem_mgr->prepend + block_mem_mgr->align;
+    if (block_mem_mgr->align)
+        offset -= ((uintptr_t)slab->buffer + offset +
+                   block_mem_mgr->align_offset) % block_mem_mgr->align;
+    ubuf_block_common_set(ubuf, offset, size);
+    ubuf_block_common_set_buffer(ubuf, slab->buffer);
+    return ubuf;
+}
+
+/** @hidden */
+static void *ubuf_block_mem_slab_alloc_inner(struct upool *upool);
+/** @hidden */
+static void ubuf_block_mem_slab_free_inner(struct upool *upool, void *_slab);
+
+/** @internal @This checks that a slab fetched from the pool is large enough
+ * for the current slab size, and replaces it otherwise.
+ *
+ * @param mgr common management structure
+ * @param slab pointer to slab fetched from the pool
+ * @return pointer to a suitable slab, or NULL in case of allocation error
+ */
+static struct ubuf_block_mem_slab *
+    ubuf_block_mem_slab_check(struct ubuf_mgr *mgr,
+                              struct ubuf_block_mem_slab *slab)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    if (likely(slab->shared.umem.size >= block_mem_mgr->slab_capacity))
+        return slab;
+
+    /* the slab size was changed since the slab was allocated */
+    ubuf_block_mem_slab_free_inner(&block_mem_mgr->slab_pool, slab);
+    slab = ubuf_block_mem_slab_alloc_inner(&block_mem_mgr->slab_pool);
+    if (unlikely(slab == NULL))
+        upool_release(&block_mem_mgr->slab_pool);
+    return slab;
+}
+
+/** @internal @This allocates a block ubuf in a slab.
+ *
+ * @param mgr common management structure
+ * @param size size of the block
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_block_mem_slab_alloc(struct ubuf_mgr *mgr, int size)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    struct ubuf_block_mem_slab *slab =
+        upool_alloc(&block_mem_mgr->slab_pool, struct ubuf_block_mem_slab *);
+    if (unlikely(slab == NULL))
+        return NULL;
+    slab = ubuf_block_mem_slab_check(mgr, slab);
+    if (unlikely(slab == NULL))
+        return NULL;
+    return ubuf_block_mem_slab_init(mgr, slab, size);
+}
+
 /** @This allocates a ubuf, a shared structure and a umem buffer.
  *
  * @param mgr common management structure
@@ -150,6 +299,10 @@ static struct ubuf *ubuf_block_mem_alloc(struct ubuf_mgr *mgr,
 
     struct ubuf_block_mem_mgr *block_mem_mgr =
         ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    if (signature == UBUF_ALLOC_BLOCK &&
+        (size_t)size <= block_mem_mgr->slab_size)
+        return ubuf_block_mem_slab_alloc(mgr, size);
+
     struct ubuf_block_mem *block_mem = ubuf_block_mem_alloc_pool(mgr);
     if (unlikely(block_mem == NULL))
         return NULL;
@@ -160,6 +313,7 @@ static struct ubuf *ubuf_block_mem_alloc(struct ubuf_mgr *mgr,
     if (signature != UBUF_ALLOC_BLOCK) {
         /* We reuse a shared structure. */
         block_mem->shared = ubuf_mem_shared_use(shared_orig);
+        ubuf_block_common_set_refcount(ubuf, &block_mem->shared->refcount);
         ubuf_block_common_set(ubuf, offset_orig, size_orig);
         ubuf_block_common_set_buffer(ubuf,
                                      ubuf_mem_shared_buffer(block_mem->shared));
@@ -171,26 +325,89 @@ static struct ubuf *ubuf_block_mem_alloc(struct ubuf_mgr *mgr,
         ubuf_block_mem_free_pool(mgr, block_mem);
         return NULL;
     }
+    ubuf_block_common_set_refcount(ubuf, &block_mem->shared->refcount);
 
-    size_t buffer_size = size + block_mem_mgr->prepend + block_mem_mgr->align +
-        block_mem_mgr->append;
-    if (unlikely(!umem_alloc(block_mem_mgr->umem_mgr, &block_mem->shared->umem,
-                             buffer_size))) {
+    if (unlikely(!ubase_check(ubuf_block_mem_alloc_buffer(mgr, block_mem,
+                                                          size)))) {
         ubuf_block_mem_shared_free_pool(block_mem->shared);
         ubuf_block_mem_free_pool(mgr, block_mem);
         return NULL;
     }
-
-    size_t offset = block_mem_mgr->prepend + block_mem_mgr->align;
-    if (block_mem_mgr->align)
-        offset -= ((uintptr_t)ubuf_mem_shared_buffer(block_mem->shared) +
-                  offset + block_mem_mgr->align_offset) % block_mem_mgr->align;
-    ubuf_block_common_set(ubuf, offset, size);
-    ubuf_block_common_set_buffer(ubuf,
-                                 ubuf_mem_shared_buffer(block_mem->shared));
     return ubuf;
 }
 
+/** @This allocates several block ubufs of the same size, fetching the
+ * structures from the pools in batches.
+ *
+ * @param mgr common management structure
+ * @param size size of each block
+ * @param ubufs array written with the allocated ubufs
+ * @param nb number of ubufs to allocate
+ * @param count_p filled in with the number of allocated ubufs
+ * @return an error code
+ */
+static int ubuf_block_mem_alloc_batch(struct ubuf_mgr *mgr, int size,
+                                      struct ubuf **ubufs, unsigned int nb,
+                                      unsigned int *count_p)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    if (unlikely(size < 0))
+        return UBASE_ERR_INVALID;
+
+    unsigned int count = 0;
+    if ((size_t)size <= block_mem_mgr->slab_size) {
+        void **slabs = (void **)ubufs;
+        unsigned int nb_slabs = upool_alloc_batch(&block_mem_mgr->slab_pool,
+                                                  slabs, nb);
+        for (count = 0; count < nb_slabs; count++) {
+            struct ubuf_block_mem_slab *slab =
+                ubuf_block_mem_slab_check(mgr, slabs[count]);
+            if (unlikely(slab == NULL))
+                break;
+            ubufs[count] = ubuf_block_mem_slab_init(mgr, slab, size);
+        }
+        for (unsigned int i = count + 1; i < nb_slabs; i++)
+            upool_free(&block_mem_mgr->slab_pool, slabs[i]);
+        *count_p = count;
+        return UBASE_ERR_NONE;
+    }
+
+    while (count < nb) {
+        void *mems[UBUF_BLOCK_MEM_BATCH];
+        void *shareds[UBUF_BLOCK_MEM_BATCH];
+        unsigned int chunk = nb - count < UBUF_BLOCK_MEM_BATCH ?
+                             nb - count : UBUF_BLOCK_MEM_BATCH;
+        unsigned int nb_mems = upool_alloc_batch(&block_mem_mgr->ubuf_pool,
+                                                 mems, chunk);
+        unsigned int nb_shareds =
+            upool_alloc_batch(&block_mem_mgr->shared_pool, shareds, nb_mems);
+
+        unsigned int i;
+        for (i = 0; i < nb_shareds; i++) {
+            struct ubuf_block_mem *block_mem = mems[i];
+            struct ubuf *ubuf = ubuf_block_mem_to_ubuf(block_mem);
+            block_mem->shared = shareds[i];
+            uatomic_store(&block_mem->shared->refcount, 1);
+            ubuf_block_common_init(ubuf, false);
+            ubuf_block_common_set_refcount(ubuf, &block_mem->shared->refcount);
+            if (unlikely(!ubase_check(ubuf_block_mem_alloc_buffer(mgr,
+                                            block_mem, size))))
+                break;
+            ubufs[count++] = ubuf;
+        }
+
+        for (unsigned int j = i; j < nb_shareds; j++)
+            ubuf_block_mem_shared_free_pool(shareds[j]);
+        for (unsigned int j = i; j < nb_mems; j++)
+            ubuf_block_mem_free_pool(mgr, mems[j]);
+        if (unlikely(i < chunk))
+            break;
+    }
+    *count_p = count;
+    return UBASE_ERR_NONE;
+}
+
 /** @This asks for the creation of a new reference to the same buffer space.
  *
  * @param ubuf pointer to ubuf
@@ -215,6 +432,24 @@ static int ubuf_block_mem_dup(struct ubuf *ubuf, struct ubuf **new_ubuf_p)
 
     struct ubuf_block_mem *block_mem = ubuf_block_mem_from_ubuf(ubuf);
     new_block->shared = ubuf_mem_shared_use(block_mem->shared);
+    ubuf_block_common_set_refcount(new_ubuf, &new_block->shared->refcount);
+    return UBASE_ERR_NONE;
+}
+
+/** @This returns the size of the buffer space after the end of the block.
+ *
+ * @param ubuf pointer to ubuf
+ * @param tailroom_p reference written with the size of the available space
+ * @return an error code
+ */
+static int ubuf_block_mem_tailroom(struct ubuf *ubuf, size_t *tailroom_p)
+{
+    struct ubuf_block_mem *block_mem = ubuf_block_mem_from_ubuf(ubuf);
+    struct ubuf_block *block = &block_mem->ubuf_block;
+    uint8_t *end = block->buffer + block->offset + block->size;
+    uint8_t *buffer_end = ubuf_mem_shared_buffer(block_mem->shared) +
+                          ubuf_mem_shared_size(block_mem->shared);
+    *tailroom_p = buffer_end > end ? buffer_end - end : 0;
     return UBASE_ERR_NONE;
 }
 
@@ -258,6 +493,7 @@ static int ubuf_block_mem_splice(struct ubuf *ubuf, struct ubuf **new_ubuf_p,
 
     struct ubuf_block_mem *block_mem = ubuf_block_mem_from_ubuf(ubuf);
     new_block->shared = ubuf_mem_shared_use(block_mem->shared);
+    ubuf_block_common_set_refcount(new_ubuf, &new_block->shared->refcount);
     return UBASE_ERR_NONE;
 }
 
@@ -277,6 +513,10 @@ static int ubuf_block_mem_control(struct ubuf *ubuf, int command, va_list args)
         }
         case UBUF_SINGLE:
             return ubuf_block_mem_single(ubuf);
+        case UBUF_TAILROOM_BLOCK: {
+            size_t *tailroom_p = va_arg(args, size_t *);
+            return ubuf_block_mem_tailroom(ubuf, tailroom_p);
+        }
 
         case UBUF_SPLICE_BLOCK: {
             struct ubuf **new_ubuf_p = va_arg(args, struct ubuf **);
@@ -297,12 +537,23 @@ static void ubuf_block_mem_free(struct ubuf *ubuf)
 {
     struct ubuf_mgr *mgr = ubuf->mgr;
     struct ubuf_block_mem *block_mem = ubuf_block_mem_from_ubuf(ubuf);
+    struct ubuf_mem_shared *shared = block_mem->shared;
 
     ubuf_block_common_clean(ubuf);
 
-    if (unlikely(ubuf_mem_shared_release(block_mem->shared))) {
-        umem_free(&block_mem->shared->umem);
-        ubuf_block_mem_shared_free_pool(block_mem->shared);
+    if (ubuf_block_mem_is_slab(mgr, shared)) {
+        struct ubuf_block_mem_slab *slab =
+            ubuf_block_mem_slab_from_ubuf_mem_shared(shared);
+        if (block_mem != &slab->block_mem)
+            ubuf_block_mem_free_pool(mgr, block_mem);
+        if (unlikely(ubuf_mem_shared_release(shared)))
+            upool_free(shared->pool, slab);
+        return;
+    }
+
+    if (unlikely(ubuf_mem_shared_release(shared))) {
+        umem_free(&shared->umem);
+        ubuf_block_mem_shared_free_pool(shared);
     }
     ubuf_block_mem_free_pool(mgr, block_mem);
 }
@@ -336,6 +587,63 @@ static void ubuf_block_mem_free_inner(struct upool *upool, void *_block_mem)
     free(block_mem);
 }
 
+/** @internal @This allocates a slab.
+ *
+ * @param upool pointer to upool
+ * @return pointer to ubuf_block_mem_slab or NULL in case of allocation error
+ */
+static void *ubuf_block_mem_slab_alloc_inner(struct upool *upool)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_slab_pool(upool);
+    struct ubuf_block_mem_slab *slab;
+    size_t size = sizeof(struct ubuf_block_mem_slab) +
+                  block_mem_mgr->slab_capacity;
+    if (unlikely(posix_memalign((void **)&slab, UBUF_BLOCK_MEM_SLAB_ALIGN,
+                                size)))
+        return NULL;
+    struct ubuf *ubuf = ubuf_block_mem_to_ubuf(&slab->block_mem);
+    ubuf->mgr = ubuf_block_mem_mgr_to_ubuf_mgr(block_mem_mgr);
+    slab->shared.pool = upool;
+    slab->shared.umem.mgr = NULL;
+    slab->shared.umem.buffer = slab->buffer;
+    slab->shared.umem.size = slab->shared.umem.real_size =
+        block_mem_mgr->slab_capacity;
+    uatomic_init(&slab->shared.refcount, 1);
+    return slab;
+}
+
+/** @internal @This frees a slab.
+ *
+ * @param upool pointer to upool
+ * @param _slab pointer to a ubuf_block_mem_slab structure to free
+ */
+static void ubuf_block_mem_slab_free_inner(struct upool *upool, void *_slab)
+{
+    struct ubuf_block_mem_slab *slab = (struct ubuf_block_mem_slab *)_slab;
+    uatomic_clean(&slab->shared.refcount);
+    free(slab);
+}
+
+/** @internal @This sets the maximum size of blocks allocated in slabs.
+ *
+ * @param mgr pointer to ubuf manager
+ * @param slab_size maximum size of a block, or 0 to disable slabs
+ * @return an error code
+ */
+static int _ubuf_block_mem_mgr_set_slab_size(struct ubuf_mgr *mgr,
+                                             size_t slab_size)
+{
+    struct ubuf_block_mem_mgr *block_mem_mgr =
+        ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+    upool_vacuum(&block_mem_mgr->slab_pool);
+    block_mem_mgr->slab_size = slab_size;
+    block_mem_mgr->slab_capacity = slab_size ?
+        slab_size + block_mem_mgr->prepend + block_mem_mgr->align +
+        block_mem_mgr->append : 0;
+    return UBASE_ERR_NONE;
+}
+
 /** @This checks if the given flow format can be allocated with the manager.
  *
  * @param mgr pointer to ubuf manager
@@ -379,9 +687,42 @@ static int ubuf_block_mem_mgr_control(struct ubuf_mgr *mgr,
             return ubuf_block_mem_mgr_check(mgr, flow_format);
         }
         case UBUF_MGR_VACUUM: {
+            struct ubuf_block_mem_mgr *block_mem_mgr =
+                ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
             ubuf_block_mem_mgr_vacuum_pool(mgr);
+            upool_vacuum(&block_mem_mgr->slab_pool);
+            return UBASE_ERR_NONE;
+        }
+        case UBUF_MGR_GET_STATS: {
+            struct ubuf_block_mem_mgr *block_mem_mgr =
+                ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+            struct ualloc_stats *stats = va_arg(args, struct ualloc_stats *);
+            ubuf_block_mem_mgr_get_stats_pool(mgr, stats);
+            upool_get_stats(&block_mem_mgr->slab_pool, stats,
+                            sizeof(struct ubuf_block_mem_slab) +
+                            block_mem_mgr->slab_size);
+            return UBASE_ERR_NONE;
+        }
+        case UBUF_MGR_SET_POOL_LIMIT: {
+            struct ubuf_block_mem_mgr *block_mem_mgr =
+                ubuf_block_mem_mgr_from_ubuf_mgr(mgr);
+            unsigned int limit = va_arg(args, unsigned int);
+            ubuf_block_mem_mgr_set_limit_pool(mgr, limit);
+            upool_set_limit(&block_mem_mgr->slab_pool, limit);
             return UBASE_ERR_NONE;
         }
+        case UBUF_MGR_ALLOC_BLOCK_BATCH: {
+            int size = va_arg(args, int);
+            struct ubuf **ubufs = va_arg(args, struct ubuf **);
+            unsigned int nb = va_arg(args, unsigned int);
+            unsigned int *count_p = va_arg(args, unsigned int *);
+            return ubuf_block_mem_alloc_batch(mgr, size, ubufs, nb, count_p);
+        }
+        case UBUF_BLOCK_MEM_MGR_SET_SLAB_SIZE: {
+            UBASE_SIGNATURE_CHECK(args, UBUF_BLOCK_MEM_SIGNATURE)
+            size_t slab_size = va_arg(args, size_t);
+            return _ubuf_block_mem_mgr_set_slab_size(mgr, slab_size);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -397,6 +738,7 @@ static void ubuf_block_mem_mgr_free(struct urefcount *urefcount)
         ubuf_block_mem_mgr_from_urefcount(urefcount);
     struct ubuf_mgr *mgr = ubuf_block_mem_mgr_to_ubuf_mgr(block_mem_mgr);
     ubuf_block_mem_mgr_clean_pool(mgr);
+    upool_clean(&block_mem_mgr->slab_pool);
     umem_mgr_release(block_mem_mgr->umem_mgr);
 
     urefcount_clean(urefcount);
@@ -428,7 +770,8 @@ struct ubuf_mgr *ubuf_block_mem_mgr_alloc(uint16_t ubuf_pool_depth,
     struct ubuf_block_mem_mgr *block_mem_mgr =
         malloc(sizeof(struct ubuf_block_mem_mgr) +
                ubuf_block_mem_mgr_sizeof_pool(ubuf_pool_depth,
-                                              shared_pool_depth));
+                                              shared_pool_depth) +
+               upool_sizeof(ubuf_pool_depth));
     if (unlikely(block_mem_mgr == NULL))
         return NULL;
 
@@ -436,6 +779,8 @@ struct ubuf_mgr *ubuf_block_mem_mgr_alloc(uint16_t ubuf_pool_depth,
     block_mem_mgr->append = append >= 0 ? append : UBUF_DEFAULT_APPEND;
     block_mem_mgr->align = align > 0 ? align : UBUF_DEFAULT_ALIGN;
     block_mem_mgr->align_offset = align_offset;
+    block_mem_mgr->slab_size = 0;
+    block_mem_mgr->slab_capacity = 0;
 
     urefcount_init(ubuf_block_mem_mgr_to_urefcount(block_mem_mgr),
                    ubuf_block_mem_mgr_free);
@@ -450,6 +795,11 @@ struct ubuf_mgr *ubuf_block_mem_mgr_alloc(uint16_t ubuf_pool_depth,
     ubuf_block_mem_mgr_init_pool(ubuf_block_mem_mgr_to_ubuf_mgr(block_mem_mgr),
             ubuf_pool_depth, shared_pool_depth, block_mem_mgr->upool_extra,
             ubuf_block_mem_alloc_inner, ubuf_block_mem_free_inner);
+    upool_init(&block_mem_mgr->slab_pool, block_mem_mgr->mgr.refcount,
+               ubuf_pool_depth, block_mem_mgr->upool_extra +
+               ubuf_block_mem_mgr_sizeof_pool(ubuf_pool_depth,
+                                              shared_pool_depth),
+               ubuf_block_mem_slab_alloc_inner, ubuf_block_mem_slab_free_inner);
 
     block_mem_mgr->umem_mgr = umem_mgr;
     umem_mgr_use(umem_mgr);
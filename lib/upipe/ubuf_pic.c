@@ -70,6 +70,15 @@ int ubuf_pic_plane_clear(struct ubuf *ubuf, const char *chroma,
     } else if (MATCH("u8") || MATCH("v8") || MATCH("u8v8")) {
         SET_COLOR(0x80);
 
+    } else if (MATCH("u8y8v8y8")) {
+        SET_COLOR(0x80, fullrange ? 0 : 16);
+
+    } else if (MATCH("y8u8y8v8")) {
+        SET_COLOR(fullrange ? 0 : 16, 0x80);
+
+    } else if (MATCH("u10y10v10y10")) {
+        SET_COLOR(0x00, 0x02, fullrange ? 0x00 : 0x40, 0x00);
+
     } else if (MATCH("y10l")) {
         SET_COLOR(fullrange ? 0 : 0x40, 0x00);
 
@@ -144,8 +153,17 @@ int ubuf_pic_plane_set_color(struct ubuf *ubuf, const char *chroma,
             buf += stride;
         }
     } else {
-        for (size_t i = 0; i < mem_width; i += pattern_size)
-            memcpy(buf + i, pattern, pattern_size);
+        /* fill the first line by doubling the initialized area, so that
+         * most of the line is written by a few large (vectorized) copies
+         * instead of one small copy per pattern */
+        size_t filled = pattern_size < mem_width ? pattern_size : mem_width;
+        memcpy(buf, pattern, filled);
+        while (filled < mem_width) {
+            size_t size = filled < mem_width - filled ?
+                          filled : mem_width - filled;
+            memcpy(buf + filled, buf, size);
+            filled += size;
+        }
 
         for (int i = 1; i < height / vsub; i++) {
             memcpy(buf + stride, buf, mem_width);
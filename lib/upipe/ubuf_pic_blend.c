@@ -0,0 +1,485 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe line kernels for picture blending
+ *
+ * The SIMD kernels only handle alpha planes subsampled by 1 or 2, and
+ * leave other subsamplings and the end of the line to the C kernels.
+ */
+
+#include "upipe/ucpu.h"
+#include "upipe/ubuf_pic_blend.h"
+
+#ifdef UBUF_PIC_BLEND_X86
+#include <immintrin.h>
+#endif
+
+#ifdef UBUF_PIC_BLEND_NEON
+#include <arm_neon.h>
+#endif
+
+/** @internal @This returns the opacity of sample i of a line. */
+#define ALPHA(alpha_plane, hsub, alpha, i)                                  \
+    ((alpha) == 0xff ? (alpha_plane)[(i) * (hsub)] :                        \
+     (alpha_plane)[(i) * (hsub)] * (alpha) / 0xff)
+
+void ubuf_pic_blend_8_c(uint8_t *dst, const uint8_t *src,
+                        uint8_t alpha, uintptr_t len)
+{
+    for (uintptr_t i = 0; i < len; i++)
+        dst[i] = (dst[i] * (0xff - alpha) + src[i] * alpha) / 0xff;
+}
+
+void ubuf_pic_blend_alpha_8_c(uint8_t *dst, const uint8_t *src,
+                              const uint8_t *alpha_plane, uintptr_t hsub,
+                              uint8_t alpha, uintptr_t len)
+{
+    for (uintptr_t i = 0; i < len; i++) {
+        unsigned a = ALPHA(alpha_plane, hsub, alpha, i);
+        dst[i] = (dst[i] * (0xff - a) + src[i] * a) / 0xff;
+    }
+}
+
+void ubuf_pic_key_alpha_8_c(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *alpha_plane, uintptr_t hsub,
+                            uint8_t alpha, uint8_t threshold, uintptr_t len)
+{
+    for (uintptr_t i = 0; i < len; i++)
+        if (ALPHA(alpha_plane, hsub, alpha, i) > threshold)
+            dst[i] = src[i];
+}
+
+void ubuf_pic_average_8_c(uint8_t *dst, const uint8_t *src1,
+                          const uint8_t *src2, uintptr_t len)
+{
+    for (uintptr_t i = 0; i < len; i++)
+        dst[i] = (src1[i] + src2[i]) >> 1;
+}
+
+void ubuf_pic_blend_16_c(uint16_t *dst, const uint16_t *src,
+                         uint8_t alpha, uintptr_t len)
+{
+    uint32_t w = alpha + (alpha >> 7);
+    for (uintptr_t i = 0; i < len; i++)
+        dst[i] = (dst[i] * (256 - w) + src[i] * w) >> 8;
+}
+
+void ubuf_pic_blend_alpha_16_c(uint16_t *dst, const uint16_t *src,
+                               const uint8_t *alpha_plane, uintptr_t hsub,
+                               uint8_t alpha, uintptr_t len)
+{
+    for (uintptr_t i = 0; i < len; i++) {
+        uint32_t a = ALPHA(alpha_plane, hsub, alpha, i);
+        uint32_t w = a + (a >> 7);
+        dst[i] = (dst[i] * (256 - w) + src[i] * w) >> 8;
+    }
+}
+
+void ubuf_pic_key_alpha_16_c(uint16_t *dst, const uint16_t *src,
+                             const uint8_t *alpha_plane, uintptr_t hsub,
+                             uint8_t alpha, uint8_t threshold, uintptr_t len)
+{
+    for (uintptr_t i = 0; i < len; i++)
+        if (ALPHA(alpha_plane, hsub, alpha, i) > threshold)
+            dst[i] = src[i];
+}
+
+void ubuf_pic_average_16_c(uint16_t *dst, const uint16_t *src1,
+                           const uint16_t *src2, uintptr_t len)
+{
+    for (uintptr_t i = 0; i < len; i++)
+        dst[i] = (src1[i] + src2[i]) >> 1;
+}
+
+#ifdef UBUF_PIC_BLEND_X86
+#define TARGET          __attribute__((target("sse2")))
+#define FN(name)        name##_sse2
+#define V               __m128i
+#define N               16
+#define LD(p)           _mm_loadu_si128((const __m128i *)(p))
+#define ST(p, x)        _mm_storeu_si128((__m128i *)(p), x)
+#define LDHALF16(p)     _mm_unpacklo_epi8(                                  \
+                            _mm_loadl_epi64((const __m128i *)(p)),          \
+                            _mm_setzero_si128())
+#define ZERO()          _mm_setzero_si128()
+#define SET8(x)         _mm_set1_epi8(x)
+#define SET16(x)        _mm_set1_epi16(x)
+#define SET32(x)        _mm_set1_epi32(x)
+#define AND(a, b)       _mm_and_si128(a, b)
+#define ANDN(a, b)      _mm_andnot_si128(a, b)
+#define OR(a, b)        _mm_or_si128(a, b)
+#define XOR(a, b)       _mm_xor_si128(a, b)
+#define SUB8(a, b)      _mm_sub_epi8(a, b)
+#define ADD16(a, b)     _mm_add_epi16(a, b)
+#define SUB16(a, b)     _mm_sub_epi16(a, b)
+#define ADD32(a, b)     _mm_add_epi32(a, b)
+#define SUB32(a, b)     _mm_sub_epi32(a, b)
+#define MULLO16(a, b)   _mm_mullo_epi16(a, b)
+#define MULHI16U(a, b)  _mm_mulhi_epu16(a, b)
+#define SRLI16(a, n)    _mm_srli_epi16(a, n)
+#define SRLI32(a, n)    _mm_srli_epi32(a, n)
+#define UNPLO8(a, b)    _mm_unpacklo_epi8(a, b)
+#define UNPHI8(a, b)    _mm_unpackhi_epi8(a, b)
+#define UNPLO16(a, b)   _mm_unpacklo_epi16(a, b)
+#define UNPHI16(a, b)   _mm_unpackhi_epi16(a, b)
+#define PACKUS16(a, b)  _mm_packus_epi16(a, b)
+#define PACKS32(a, b)   _mm_packs_epi32(a, b)
+#define PERM(x)         (x)
+#define MAXU8(a, b)     _mm_max_epu8(a, b)
+#define CMPEQ8(a, b)    _mm_cmpeq_epi8(a, b)
+#define CMPGT16(a, b)   _mm_cmpgt_epi16(a, b)
+#define AVGU8(a, b)     _mm_avg_epu8(a, b)
+#define AVGU16(a, b)    _mm_avg_epu16(a, b)
+#include "ubuf_pic_blend_template.h"
+#undef TARGET
+#undef FN
+#undef V
+#undef N
+#undef LD
+#undef ST
+#undef LDHALF16
+#undef ZERO
+#undef SET8
+#undef SET16
+#undef SET32
+#undef AND
+#undef ANDN
+#undef OR
+#undef XOR
+#undef SUB8
+#undef ADD16
+#undef SUB16
+#undef ADD32
+#undef SUB32
+#undef MULLO16
+#undef MULHI16U
+#undef SRLI16
+#undef SRLI32
+#undef UNPLO8
+#undef UNPHI8
+#undef UNPLO16
+#undef UNPHI16
+#undef PACKUS16
+#undef PACKS32
+#undef PERM
+#undef MAXU8
+#undef CMPEQ8
+#undef CMPGT16
+#undef AVGU8
+#undef AVGU16
+
+#define TARGET          __attribute__((target("avx2")))
+#define FN(name)        name##_avx2
+#define V               __m256i
+#define N               32
+#define LD(p)           _mm256_loadu_si256((const __m256i *)(p))
+#define ST(p, x)        _mm256_storeu_si256((__m256i *)(p), x)
+#define LDHALF16(p)     _mm256_cvtepu8_epi16(                               \
+                            _mm_loadu_si128((const __m128i *)(p)))
+#define ZERO()          _mm256_setzero_si256()
+#define SET8(x)         _mm256_set1_epi8(x)
+#define SET16(x)        _mm256_set1_epi16(x)
+#define SET32(x)        _mm256_set1_epi32(x)
+#define AND(a, b)       _mm256_and_si256(a, b)
+#define ANDN(a, b)      _mm256_andnot_si256(a, b)
+#define OR(a, b)        _mm256_or_si256(a, b)
+#define XOR(a, b)       _mm256_xor_si256(a, b)
+#define SUB8(a, b)      _mm256_sub_epi8(a, b)
+#define ADD16(a, b)     _mm256_add_epi16(a, b)
+#define SUB16(a, b)     _mm256_sub_epi16(a, b)
+#define ADD32(a, b)     _mm256_add_epi32(a, b)
+#define SUB32(a, b)     _mm256_sub_epi32(a, b)
+#define MULLO16(a, b)   _mm256_mullo_epi16(a, b)
+#define MULHI16U(a, b)  _mm256_mulhi_epu16(a, b)
+#define SRLI16(a, n)    _mm256_srli_epi16(a, n)
+#define SRLI32(a, n)    _mm256_srli_epi32(a, n)
+#define UNPLO8(a, b)    _mm256_unpacklo_epi8(a, b)
+#define UNPHI8(a, b)    _mm256_unpackhi_epi8(a, b)
+#define UNPLO16(a, b)   _mm256_unpacklo_epi16(a, b)
+#define UNPHI16(a, b)   _mm256_unpackhi_epi16(a, b)
+#define PACKUS16(a, b)  _mm256_packus_epi16(a, b)
+#define PACKS32(a, b)   _mm256_packs_epi32(a, b)
+/* packing two vectors interleaves their 128-bit lanes */
+#define PERM(x)         _mm256_permute4x64_epi64(x, 0xd8)
+#define MAXU8(a, b)     _mm256_max_epu8(a, b)
+#define CMPEQ8(a, b)    _mm256_cmpeq_epi8(a, b)
+#define CMPGT16(a, b)   _mm256_cmpgt_epi16(a, b)
+#define AVGU8(a, b)     _mm256_avg_epu8(a, b)
+#define AVGU16(a, b)    _mm256_avg_epu16(a, b)
+#include "ubuf_pic_blend_template.h"
+#endif
+
+#ifdef UBUF_PIC_BLEND_NEON
+/** @internal @This divides 16-bit lanes by 255, rounding down. */
+static inline uint16x8_t div255_neon(uint16x8_t x)
+{
+    return vshrq_n_u16(vaddq_u16(vaddq_u16(x, vdupq_n_u16(1)),
+                                 vshrq_n_u16(x, 8)), 8);
+}
+
+/** @internal @This scales 8-bit opacities by alpha / 255. */
+static inline uint8x16_t scale_alpha_8_neon(uint8x16_t a, uint8_t alpha)
+{
+    if (alpha == 0xff)
+        return a;
+    uint8x8_t mul = vdup_n_u8(alpha);
+    return vcombine_u8(
+            vmovn_u16(div255_neon(vmull_u8(vget_low_u8(a), mul))),
+            vmovn_u16(div255_neon(vmull_u8(vget_high_u8(a), mul))));
+}
+
+/** @internal @This loads the opacities of 16 8-bit samples. */
+static inline uint8x16_t load_alpha_8_neon(const uint8_t *alpha_plane,
+                                           uintptr_t hsub, uint8_t alpha)
+{
+    uint8x16_t a = hsub == 1 ? vld1q_u8(alpha_plane) :
+                   vld2q_u8(alpha_plane).val[0];
+    return scale_alpha_8_neon(a, alpha);
+}
+
+/** @internal @This loads the opacities of 8 16-bit samples. */
+static inline uint16x8_t load_alpha_16_neon(const uint8_t *alpha_plane,
+                                            uintptr_t hsub, uint8_t alpha)
+{
+    uint16x8_t a = vmovl_u8(hsub == 1 ? vld1_u8(alpha_plane) :
+                            vld2_u8(alpha_plane).val[0]);
+    if (alpha != 0xff)
+        a = div255_neon(vmulq_u16(a, vdupq_n_u16(alpha)));
+    return a;
+}
+
+/** @internal @This blends 16 8-bit samples with opacities a. */
+static inline uint8x16_t blend_8_neon(uint8x16_t d, uint8x16_t s,
+                                      uint8x16_t a)
+{
+    uint8x16_t ia = vmvnq_u8(a);
+    uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(d), vget_low_u8(ia)),
+                             vget_low_u8(s), vget_low_u8(a));
+    uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(d), vget_high_u8(ia)),
+                             vget_high_u8(s), vget_high_u8(a));
+    return vcombine_u8(vmovn_u16(div255_neon(lo)),
+                       vmovn_u16(div255_neon(hi)));
+}
+
+/** @internal @This blends 8 16-bit samples with weights w (0 to 256). */
+static inline uint16x8_t blend_16_neon(uint16x8_t d, uint16x8_t s,
+                                       uint16x8_t w)
+{
+    uint16x8_t iw = vsubq_u16(vdupq_n_u16(256), w);
+    uint32x4_t lo = vmlal_u16(vmull_u16(vget_low_u16(d), vget_low_u16(iw)),
+                              vget_low_u16(s), vget_low_u16(w));
+    uint32x4_t hi = vmlal_u16(vmull_u16(vget_high_u16(d), vget_high_u16(iw)),
+                              vget_high_u16(s), vget_high_u16(w));
+    return vcombine_u16(vshrn_n_u32(lo, 8), vshrn_n_u32(hi, 8));
+}
+
+void ubuf_pic_blend_8_neon(uint8_t *dst, const uint8_t *src,
+                           uint8_t alpha, uintptr_t len)
+{
+    uint8x16_t a = vdupq_n_u8(alpha);
+    for (; len >= 16; len -= 16, dst += 16, src += 16)
+        vst1q_u8(dst, blend_8_neon(vld1q_u8(dst), vld1q_u8(src), a));
+    ubuf_pic_blend_8_c(dst, src, alpha, len);
+}
+
+void ubuf_pic_blend_alpha_8_neon(uint8_t *dst, const uint8_t *src,
+                                 const uint8_t *alpha_plane, uintptr_t hsub,
+                                 uint8_t alpha, uintptr_t len)
+{
+    if (hsub > 2)
+        goto tail;
+    for (; len >= 16; len -= 16, dst += 16, src += 16,
+                      alpha_plane += 16 * hsub)
+        vst1q_u8(dst, blend_8_neon(vld1q_u8(dst), vld1q_u8(src),
+                    load_alpha_8_neon(alpha_plane, hsub, alpha)));
+tail:
+    ubuf_pic_blend_alpha_8_c(dst, src, alpha_plane, hsub, alpha, len);
+}
+
+void ubuf_pic_key_alpha_8_neon(uint8_t *dst, const uint8_t *src,
+                               const uint8_t *alpha_plane, uintptr_t hsub,
+                               uint8_t alpha, uint8_t threshold,
+                               uintptr_t len)
+{
+    uint8x16_t t = vdupq_n_u8(threshold);
+    if (hsub > 2)
+        goto tail;
+    for (; len >= 16; len -= 16, dst += 16, src += 16,
+                      alpha_plane += 16 * hsub) {
+        uint8x16_t mask =
+            vcgtq_u8(load_alpha_8_neon(alpha_plane, hsub, alpha), t);
+        vst1q_u8(dst, vbslq_u8(mask, vld1q_u8(src), vld1q_u8(dst)));
+    }
+tail:
+    ubuf_pic_key_alpha_8_c(dst, src, alpha_plane, hsub, alpha, threshold,
+                           len);
+}
+
+void ubuf_pic_average_8_neon(uint8_t *dst, const uint8_t *src1,
+                             const uint8_t *src2, uintptr_t len)
+{
+    for (; len >= 16; len -= 16, dst += 16, src1 += 16, src2 += 16)
+        vst1q_u8(dst, vhaddq_u8(vld1q_u8(src1), vld1q_u8(src2)));
+    ubuf_pic_average_8_c(dst, src1, src2, len);
+}
+
+void ubuf_pic_blend_16_neon(uint16_t *dst, const uint16_t *src,
+                            uint8_t alpha, uintptr_t len)
+{
+    uint16x8_t w = vdupq_n_u16(alpha + (alpha >> 7));
+    for (; len >= 8; len -= 8, dst += 8, src += 8)
+        vst1q_u16(dst, blend_16_neon(vld1q_u16(dst), vld1q_u16(src), w));
+    ubuf_pic_blend_16_c(dst, src, alpha, len);
+}
+
+void ubuf_pic_blend_alpha_16_neon(uint16_t *dst, const uint16_t *src,
+                                  const uint8_t *alpha_plane, uintptr_t hsub,
+                                  uint8_t alpha, uintptr_t len)
+{
+    if (hsub > 2)
+        goto tail;
+    for (; len >= 8; len -= 8, dst += 8, src += 8, alpha_plane += 8 * hsub) {
+        uint16x8_t a = load_alpha_16_neon(alpha_plane, hsub, alpha);
+        vst1q_u16(dst, blend_16_neon(vld1q_u16(dst), vld1q_u16(src),
+                                     vsraq_n_u16(a, a, 7)));
+    }
+tail:
+    ubuf_pic_blend_alpha_16_c(dst, src, alpha_plane, hsub, alpha, len);
+}
+
+void ubuf_pic_key_alpha_16_neon(uint16_t *dst, const uint16_t *src,
+                                const uint8_t *alpha_plane, uintptr_t hsub,
+                                uint8_t alpha, uint8_t threshold,
+                                uintptr_t len)
+{
+    uint16x8_t t = vdupq_n_u16(threshold);
+    if (hsub > 2)
+        goto tail;
+    for (; len >= 8; len -= 8, dst += 8, src += 8, alpha_plane += 8 * hsub) {
+        uint16x8_t mask =
+            vcgtq_u16(load_alpha_16_neon(alpha_plane, hsub, alpha), t);
+        vst1q_u16(dst, vbslq_u16(mask, vld1q_u16(src), vld1q_u16(dst)));
+    }
+tail:
+    ubuf_pic_key_alpha_16_c(dst, src, alpha_plane, hsub, alpha, threshold,
+                            len);
+}
+
+void ubuf_pic_average_16_neon(uint16_t *dst, const uint16_t *src1,
+                              const uint16_t *src2, uintptr_t len)
+{
+    for (; len >= 8; len -= 8, dst += 8, src1 += 8, src2 += 8)
+        vst1q_u16(dst, vhaddq_u16(vld1q_u16(src1), vld1q_u16(src2)));
+    ubuf_pic_average_16_c(dst, src1, src2, len);
+}
+#endif
+
+#ifdef UBUF_PIC_BLEND_X86
+#define SIMD_IMPLS(name)                                                    \
+    UCPU_IMPL(name, avx2, UCPU_AVX2),                                       \
+    UCPU_IMPL(name, sse2, UCPU_SSE2),
+#elif defined(UBUF_PIC_BLEND_NEON)
+#define SIMD_IMPLS(name)                                                    \
+    UCPU_IMPL(name, neon, UCPU_NEON),
+#else
+#define SIMD_IMPLS(name)
+#endif
+
+/** @internal @This defines the implementations of a kernel. */
+#define KERNEL(name)                                                        \
+static const struct ucpu_impl name##_impls[] = {                            \
+    SIMD_IMPLS(name)                                                        \
+    UCPU_IMPL(name, c, 0),                                                  \
+};                                                                          \
+struct ucpu_kernel name##_kernel = UCPU_KERNEL_INIT(#name, name##_impls);
+
+KERNEL(ubuf_pic_blend_8)
+KERNEL(ubuf_pic_blend_alpha_8)
+KERNEL(ubuf_pic_key_alpha_8)
+KERNEL(ubuf_pic_average_8)
+KERNEL(ubuf_pic_blend_16)
+KERNEL(ubuf_pic_blend_alpha_16)
+KERNEL(ubuf_pic_key_alpha_16)
+KERNEL(ubuf_pic_average_16)
+
+/** @internal @This calls the fastest kernel supported by the CPU. */
+#define DISPATCH(name, args)                                                \
+    UCPU_KERNEL_FUNC(&name##_kernel, __typeof__(&name##_c)) args;
+
+void ubuf_pic_blend_8(uint8_t *dst, const uint8_t *src,
+                      uint8_t alpha, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_blend_8, (dst, src, alpha, len))
+}
+
+void ubuf_pic_blend_alpha_8(uint8_t *dst, const uint8_t *src,
+                            const uint8_t *alpha_plane, uintptr_t hsub,
+                            uint8_t alpha, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_blend_alpha_8,
+             (dst, src, alpha_plane, hsub, alpha, len))
+}
+
+void ubuf_pic_key_alpha_8(uint8_t *dst, const uint8_t *src,
+                          const uint8_t *alpha_plane, uintptr_t hsub,
+                          uint8_t alpha, uint8_t threshold, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_key_alpha_8,
+             (dst, src, alpha_plane, hsub, alpha, threshold, len))
+}
+
+void ubuf_pic_average_8(uint8_t *dst, const uint8_t *src1,
+                        const uint8_t *src2, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_average_8, (dst, src1, src2, len))
+}
+
+void ubuf_pic_blend_16(uint16_t *dst, const uint16_t *src,
+                       uint8_t alpha, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_blend_16, (dst, src, alpha, len))
+}
+
+void ubuf_pic_blend_alpha_16(uint16_t *dst, const uint16_t *src,
+                             const uint8_t *alpha_plane, uintptr_t hsub,
+                             uint8_t alpha, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_blend_alpha_16,
+             (dst, src, alpha_plane, hsub, alpha, len))
+}
+
+void ubuf_pic_key_alpha_16(uint16_t *dst, const uint16_t *src,
+                           const uint8_t *alpha_plane, uintptr_t hsub,
+                           uint8_t alpha, uint8_t threshold, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_key_alpha_16,
+             (dst, src, alpha_plane, hsub, alpha, threshold, len))
+}
+
+void ubuf_pic_average_16(uint16_t *dst, const uint16_t *src1,
+                         const uint16_t *src2, uintptr_t len)
+{
+    DISPATCH(ubuf_pic_average_16, (dst, src1, src2, len))
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe x86 line kernels for picture blending
+ * This file is included once per instruction set by ubuf_pic_blend.c, with
+ * the following macros defined: TARGET (function attribute), FN (suffixes
+ * a function name), V (vector type), N (vector size in octets), and the
+ * vector operations used below.
+ */
+
+/** @internal @This divides 16-bit lanes by 255, rounding down (exact for
+ * values up to 65534). */
+TARGET static inline V FN(div255)(V x)
+{
+    return SRLI16(ADD16(ADD16(x, SET16(1)), SRLI16(x, 8)), 8);
+}
+
+/** @internal @This loads the alpha values of N 8-bit samples. */
+TARGET static inline V FN(load_alpha_8)(const uint8_t *alpha_plane,
+                                        uintptr_t hsub)
+{
+    if (hsub == 1)
+        return LD(alpha_plane);
+    V mask = SET16(0xff);
+    return PERM(PACKUS16(AND(LD(alpha_plane), mask),
+                         AND(LD(alpha_plane + N), mask)));
+}
+
+/** @internal @This loads the alpha values of N/2 16-bit samples. */
+TARGET static inline V FN(load_alpha_16)(const uint8_t *alpha_plane,
+                                         uintptr_t hsub)
+{
+    if (hsub == 1)
+        return LDHALF16(alpha_plane);
+    return AND(LD(alpha_plane), SET16(0xff));
+}
+
+/** @internal @This blends N 8-bit samples with the alpha values in the
+ * 16-bit lanes of alpha_lo and alpha_hi. */
+TARGET static inline V FN(blend_8)(V d, V s, V alpha_lo, V alpha_hi)
+{
+    V z = ZERO(), c255 = SET16(255);
+    V lo = ADD16(MULLO16(UNPLO8(d, z), SUB16(c255, alpha_lo)),
+                 MULLO16(UNPLO8(s, z), alpha_lo));
+    V hi = ADD16(MULLO16(UNPHI8(d, z), SUB16(c255, alpha_hi)),
+                 MULLO16(UNPHI8(s, z), alpha_hi));
+    return PACKUS16(FN(div255)(lo), FN(div255)(hi));
+}
+
+/** @internal @This blends N/2 16-bit samples with the weights (0 to 256) in
+ * the 16-bit lanes of w. */
+TARGET static inline V FN(blend_16)(V d, V s, V w)
+{
+    V iw = SUB16(SET16(256), w);
+    V dl = MULLO16(d, iw), dh = MULHI16U(d, iw);
+    V sl = MULLO16(s, w), sh = MULHI16U(s, w);
+    V lo = SRLI32(ADD32(UNPLO16(dl, dh), UNPLO16(sl, sh)), 8);
+    V hi = SRLI32(ADD32(UNPHI16(dl, dh), UNPHI16(sl, sh)), 8);
+    /* the results fit in 16 bits, pack them with signed saturation */
+    V bias = SET32(0x8000);
+    return XOR(PACKS32(SUB32(lo, bias), SUB32(hi, bias)), SET16(0x8000));
+}
+
+TARGET void FN(ubuf_pic_blend_8)(uint8_t *dst, const uint8_t *src,
+                                 uint8_t alpha, uintptr_t len)
+{
+    V a = SET16(alpha);
+    for (; len >= N; len -= N, dst += N, src += N)
+        ST(dst, FN(blend_8)(LD(dst), LD(src), a, a));
+    ubuf_pic_blend_8_c(dst, src, alpha, len);
+}
+
+TARGET void FN(ubuf_pic_blend_alpha_8)(uint8_t *dst, const uint8_t *src,
+                                       const uint8_t *alpha_plane,
+                                       uintptr_t hsub, uint8_t alpha,
+                                       uintptr_t len)
+{
+    V z = ZERO(), mul = SET16(alpha);
+    if (hsub > 2)
+        goto tail;
+    for (; len >= N; len -= N, dst += N, src += N, alpha_plane += N * hsub) {
+        V a = FN(load_alpha_8)(alpha_plane, hsub);
+        V alpha_lo = UNPLO8(a, z), alpha_hi = UNPHI8(a, z);
+        if (alpha != 0xff) {
+            alpha_lo = FN(div255)(MULLO16(alpha_lo, mul));
+            alpha_hi = FN(div255)(MULLO16(alpha_hi, mul));
+        }
+        ST(dst, FN(blend_8)(LD(dst), LD(src), alpha_lo, alpha_hi));
+    }
+tail:
+    ubuf_pic_blend_alpha_8_c(dst, src, alpha_plane, hsub, alpha, len);
+}
+
+TARGET void FN(ubuf_pic_key_alpha_8)(uint8_t *dst, const uint8_t *src,
+                                     const uint8_t *alpha_plane,
+                                     uintptr_t hsub, uint8_t alpha,
+                                     uint8_t threshold, uintptr_t len)
+{
+    V z = ZERO(), mul = SET16(alpha), min = SET8(threshold + 1);
+    if (threshold == 0xff)
+        return;
+    if (hsub > 2)
+        goto tail;
+    for (; len >= N; len -= N, dst += N, src += N, alpha_plane += N * hsub) {
+        V a = FN(load_alpha_8)(alpha_plane, hsub);
+        if (alpha != 0xff)
+            a = PACKUS16(FN(div255)(MULLO16(UNPLO8(a, z), mul)),
+                         FN(div255)(MULLO16(UNPHI8(a, z), mul)));
+        V mask = CMPEQ8(MAXU8(a, min), a);
+        ST(dst, OR(AND(mask, LD(src)), ANDN(mask, LD(dst))));
+    }
+tail:
+    ubuf_pic_key_alpha_8_c(dst, src, alpha_plane, hsub, alpha, threshold,
+                           len);
+}
+
+TARGET void FN(ubuf_pic_average_8)(uint8_t *dst, const uint8_t *src1,
+                                   const uint8_t *src2, uintptr_t len)
+{
+    V one = SET8(1);
+    for (; len >= N; len -= N, dst += N, src1 += N, src2 += N) {
+        V a = LD(src1), b = LD(src2);
+        /* pavgb rounds up, remove the carry of odd sums */
+        ST(dst, SUB8(AVGU8(a, b), AND(XOR(a, b), one)));
+    }
+    ubuf_pic_average_8_c(dst, src1, src2, len);
+}
+
+TARGET void FN(ubuf_pic_blend_16)(uint16_t *dst, const uint16_t *src,
+                                  uint8_t alpha, uintptr_t len)
+{
+    V w = SET16(alpha + (alpha >> 7));
+    for (; len >= N / 2; len -= N / 2, dst += N / 2, src += N / 2)
+        ST(dst, FN(blend_16)(LD(dst), LD(src), w));
+    ubuf_pic_blend_16_c(dst, src, alpha, len);
+}
+
+TARGET void FN(ubuf_pic_blend_alpha_16)(uint16_t *dst, const uint16_t *src,
+                                        const uint8_t *alpha_plane,
+                                        uintptr_t hsub, uint8_t alpha,
+                                        uintptr_t len)
+{
+    V mul = SET16(alpha);
+    if (hsub > 2)
+        goto tail;
+    for (; len >= N / 2; len -= N / 2, dst += N / 2, src += N / 2,
+                         alpha_plane += N / 2 * hsub) {
+        V a = FN(load_alpha_16)(alpha_plane, hsub);
+        if (alpha != 0xff)
+            a = FN(div255)(MULLO16(a, mul));
+        ST(dst, FN(blend_16)(LD(dst), LD(src), ADD16(a, SRLI16(a, 7))));
+    }
+tail:
+    ubuf_pic_blend_alpha_16_c(dst, src, alpha_plane, hsub, alpha, len);
+}
+
+TARGET void FN(ubuf_pic_key_alpha_16)(uint16_t *dst, const uint16_t *src,
+                                      const uint8_t *alpha_plane,
+                                      uintptr_t hsub, uint8_t alpha,
+                                      uint8_t threshold, uintptr_t len)
+{
+    V mul = SET16(alpha), t = SET16(threshold);
+    if (hsub > 2)
+        goto tail;
+    for (; len >= N / 2; len -= N / 2, dst += N / 2, src += N / 2,
+                         alpha_plane += N / 2 * hsub) {
+        V a = FN(load_alpha_16)(alpha_plane, hsub);
+        if (alpha != 0xff)
+            a = FN(div255)(MULLO16(a, mul));
+        V mask = CMPGT16(a, t);
+        ST(dst, OR(AND(mask, LD(src)), ANDN(mask, LD(dst))));
+    }
+tail:
+    ubuf_pic_key_alpha_16_c(dst, src, alpha_plane, hsub, alpha, threshold,
+                            len);
+}
+
+TARGET void FN(ubuf_pic_average_16)(uint16_t *dst, const uint16_t *src1,
+                                    const uint16_t *src2, uintptr_t len)
+{
+    V one = SET16(1);
+    for (; len >= N / 2; len -= N / 2, dst += N / 2, src1 += N / 2,
+                         src2 += N / 2) {
+        V a = LD(src1), b = LD(src2);
+        ST(dst, SUB16(AVGU16(a, b), AND(XOR(a, b), one)));
+    }
+    ubuf_pic_average_16_c(dst, src1, src2, len);
+}
@@ -304,7 +304,7 @@ int ubuf_pic_common_split_fields(struct ubuf *ubuf, struct ubuf **odd,
         return UBASE_ERR_ALLOC;
 
     *even = ubuf_dup(ubuf);
-    if (!*odd) {
+    if (!*even) {
         ubuf_free(*odd);
         return UBASE_ERR_ALLOC;
     }
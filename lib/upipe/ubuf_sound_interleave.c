@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe kernels for interleaved sound buffers
+ *
+ * The SIMD kernels transpose blocks of four channels, so a channel count
+ * which is not a multiple of four is entirely handled in C, as are the
+ * samples after the last full block.
+ */
+
+#include "upipe/ucpu.h"
+#include "upipe/ubuf_sound_interleave.h"
+
+#include <string.h>
+
+#ifdef UBUF_SOUND_INTERLEAVE_X86
+#include <immintrin.h>
+#endif
+
+#ifdef UBUF_SOUND_INTERLEAVE_NEON
+#include <arm_neon.h>
+#endif
+
+/** @internal @This deinterleaves samples from start to samples.
+ *
+ * @param dst array of channels plane pointers, NULL for channels to skip
+ * @param src packed samples
+ * @param size size of a sample of one channel in octets
+ * @param channels number of channels in src
+ * @param start first sample to deinterleave
+ * @param samples number of samples per channel
+ */
+static inline void deinterleave_c(uint8_t *const *dst, const uint8_t *src,
+                                  uint8_t size, uint8_t channels,
+                                  uintptr_t start, uintptr_t samples)
+{
+    for (uint8_t c = 0; c < channels; c++) {
+        if (dst[c] == NULL)
+            continue;
+        const uint8_t *in = src + (start * channels + c) * size;
+        uint8_t *out = dst[c] + start * size;
+        for (uintptr_t i = start; i < samples; i++) {
+            memcpy(out, in, size);
+            in += channels * size;
+            out += size;
+        }
+    }
+}
+
+void ubuf_sound_deinterleave_16_c(uint8_t *const *dst, const uint8_t *src,
+                                  uint8_t channels, uintptr_t samples)
+{
+    deinterleave_c(dst, src, 2, channels, 0, samples);
+}
+
+void ubuf_sound_deinterleave_32_c(uint8_t *const *dst, const uint8_t *src,
+                                  uint8_t channels, uintptr_t samples)
+{
+    deinterleave_c(dst, src, 4, channels, 0, samples);
+}
+
+#ifdef UBUF_SOUND_INTERLEAVE_X86
+__attribute__((target("sse2")))
+void ubuf_sound_deinterleave_16_sse2(uint8_t *const *dst, const uint8_t *src,
+                                     uint8_t channels, uintptr_t samples)
+{
+    uintptr_t stride = channels * 2;
+    uintptr_t i = 0;
+
+    if (channels % 4)
+        goto tail;
+
+    /* 8 samples of 4 channels per block */
+    for (; i + 8 <= samples; i += 8) {
+        const uint8_t *in = src + i * stride;
+        for (uint8_t c = 0; c < channels; c += 4, in += 8) {
+            if (!dst[c] && !dst[c + 1] && !dst[c + 2] && !dst[c + 3])
+                continue;
+            __m128i r[8];
+            for (int k = 0; k < 8; k++)
+                r[k] = _mm_loadl_epi64((const __m128i *)(in + k * stride));
+            __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+            __m128i t1 = _mm_unpacklo_epi16(r[2], r[3]);
+            __m128i t2 = _mm_unpacklo_epi16(r[4], r[5]);
+            __m128i t3 = _mm_unpacklo_epi16(r[6], r[7]);
+            __m128i u0 = _mm_unpacklo_epi32(t0, t1);
+            __m128i u1 = _mm_unpackhi_epi32(t0, t1);
+            __m128i u2 = _mm_unpacklo_epi32(t2, t3);
+            __m128i u3 = _mm_unpackhi_epi32(t2, t3);
+            __m128i out[4] = {
+                _mm_unpacklo_epi64(u0, u2), _mm_unpackhi_epi64(u0, u2),
+                _mm_unpacklo_epi64(u1, u3), _mm_unpackhi_epi64(u1, u3),
+            };
+            for (int k = 0; k < 4; k++)
+                if (dst[c + k])
+                    _mm_storeu_si128((__m128i *)(dst[c + k] + i * 2),
+                                     out[k]);
+        }
+    }
+tail:
+    deinterleave_c(dst, src, 2, channels, i, samples);
+}
+
+__attribute__((target("sse2")))
+void ubuf_sound_deinterleave_32_sse2(uint8_t *const *dst, const uint8_t *src,
+                                     uint8_t channels, uintptr_t samples)
+{
+    uintptr_t stride = channels * 4;
+    uintptr_t i = 0;
+
+    if (channels % 4)
+        goto tail;
+
+    /* 4 samples of 4 channels per block */
+    for (; i + 4 <= samples; i += 4) {
+        const uint8_t *in = src + i * stride;
+        for (uint8_t c = 0; c < channels; c += 4, in += 16) {
+            if (!dst[c] && !dst[c + 1] && !dst[c + 2] && !dst[c + 3])
+                continue;
+            __m128i r0 = _mm_loadu_si128((const __m128i *)in);
+            __m128i r1 = _mm_loadu_si128((const __m128i *)(in + stride));
+            __m128i r2 = _mm_loadu_si128((const __m128i *)(in + 2 * stride));
+            __m128i r3 = _mm_loadu_si128((const __m128i *)(in + 3 * stride));
+            __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+            __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+            __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+            __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+            __m128i out[4] = {
+                _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1),
+                _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3),
+            };
+            for (int k = 0; k < 4; k++)
+                if (dst[c + k])
+                    _mm_storeu_si128((__m128i *)(dst[c + k] + i * 4),
+                                     out[k]);
+        }
+    }
+tail:
+    deinterleave_c(dst, src, 4, channels, i, samples);
+}
+#endif
+
+#ifdef UBUF_SOUND_INTERLEAVE_NEON
+void ubuf_sound_deinterleave_16_neon(uint8_t *const *dst, const uint8_t *src,
+                                     uint8_t channels, uintptr_t samples)
+{
+    uintptr_t stride = channels * 2;
+    uintptr_t i = 0;
+
+    if (channels % 4)
+        goto tail;
+
+    /* 4 samples of 4 channels per block */
+    for (; i + 4 <= samples; i += 4) {
+        const uint8_t *in = src + i * stride;
+        for (uint8_t c = 0; c < channels; c += 4, in += 8) {
+            if (!dst[c] && !dst[c + 1] && !dst[c + 2] && !dst[c + 3])
+                continue;
+            uint16x4x2_t a = vtrn_u16(
+                    vld1_u16((const uint16_t *)in),
+                    vld1_u16((const uint16_t *)(in + stride)));
+            uint16x4x2_t b = vtrn_u16(
+                    vld1_u16((const uint16_t *)(in + 2 * stride)),
+                    vld1_u16((const uint16_t *)(in + 3 * stride)));
+            uint32x2x2_t even = vtrn_u32(vreinterpret_u32_u16(a.val[0]),
+                                         vreinterpret_u32_u16(b.val[0]));
+            uint32x2x2_t odd = vtrn_u32(vreinterpret_u32_u16(a.val[1]),
+                                        vreinterpret_u32_u16(b.val[1]));
+            uint32x2_t out[4] = {
+                even.val[0], odd.val[0], even.val[1], odd.val[1],
+            };
+            for (int k = 0; k < 4; k++)
+                if (dst[c + k])
+                    vst1_u32((uint32_t *)(dst[c + k] + i * 2), out[k]);
+        }
+    }
+tail:
+    deinterleave_c(dst, src, 2, channels, i, samples);
+}
+
+void ubuf_sound_deinterleave_32_neon(uint8_t *const *dst, const uint8_t *src,
+                                     uint8_t channels, uintptr_t samples)
+{
+    uintptr_t stride = channels * 4;
+    uintptr_t i = 0;
+
+    if (channels % 4)
+        goto tail;
+
+    /* 4 samples of 4 channels per block */
+    for (; i + 4 <= samples; i += 4) {
+        const uint8_t *in = src + i * stride;
+        for (uint8_t c = 0; c < channels; c += 4, in += 16) {
+            if (!dst[c] && !dst[c + 1] && !dst[c + 2] && !dst[c + 3])
+                continue;
+            uint32x4x2_t a = vtrnq_u32(
+                    vld1q_u32((const uint32_t *)in),
+                    vld1q_u32((const uint32_t *)(in + stride)));
+            uint32x4x2_t b = vtrnq_u32(
+                    vld1q_u32((const uint32_t *)(in + 2 * stride)),
+                    vld1q_u32((const uint32_t *)(in + 3 * stride)));
+            uint32x4_t out[4] = {
+                vcombine_u32(vget_low_u32(a.val[0]), vget_low_u32(b.val[0])),
+                vcombine_u32(vget_low_u32(a.val[1]), vget_low_u32(b.val[1])),
+                vcombine_u32(vget_high_u32(a.val[0]),
+                             vget_high_u32(b.val[0])),
+                vcombine_u32(vget_high_u32(a.val[1]),
+                             vget_high_u32(b.val[1])),
+            };
+            for (int k = 0; k < 4; k++)
+                if (dst[c + k])
+                    vst1q_u32((uint32_t *)(dst[c + k] + i * 4), out[k]);
+        }
+    }
+tail:
+    deinterleave_c(dst, src, 4, channels, i, samples);
+}
+#endif
+
+#ifdef UBUF_SOUND_INTERLEAVE_X86
+#define SIMD_IMPLS(name)                                                    \
+    UCPU_IMPL(name, sse2, UCPU_SSE2),
+#elif defined(UBUF_SOUND_INTERLEAVE_NEON)
+#define SIMD_IMPLS(name)                                                    \
+    UCPU_IMPL(name, neon, UCPU_NEON),
+#else
+#define SIMD_IMPLS(name)
+#endif
+
+/** @internal @This defines the implementations of a kernel. */
+#define KERNEL(name)                                                        \
+static const struct ucpu_impl name##_impls[] = {                            \
+    SIMD_IMPLS(name)                                                        \
+    UCPU_IMPL(name, c, 0),                                                  \
+};                                                                          \
+struct ucpu_kernel name##_kernel = UCPU_KERNEL_INIT(#name, name##_impls);
+
+KERNEL(ubuf_sound_deinterleave_16)
+KERNEL(ubuf_sound_deinterleave_32)
+
+void ubuf_sound_deinterleave_16(uint8_t *const *dst, const uint8_t *src,
+                                uint8_t channels, uintptr_t samples)
+{
+    UCPU_KERNEL_FUNC(&ubuf_sound_deinterleave_16_kernel,
+                     __typeof__(&ubuf_sound_deinterleave_16_c))(dst, src,
+                                                                channels,
+                                                                samples);
+}
+
+void ubuf_sound_deinterleave_32(uint8_t *const *dst, const uint8_t *src,
+                                uint8_t channels, uintptr_t samples)
+{
+    UCPU_KERNEL_FUNC(&ubuf_sound_deinterleave_32_kernel,
+                     __typeof__(&ubuf_sound_deinterleave_32_c))(dst, src,
+                                                                channels,
+                                                                samples);
+}
+
+void ubuf_sound_deinterleave(uint8_t *const *dst, const uint8_t *src,
+                             uint8_t channel_size, uint8_t channels,
+                             uintptr_t samples)
+{
+    switch (channel_size) {
+        case 2:
+            ubuf_sound_deinterleave_16(dst, src, channels, samples);
+            break;
+        case 4:
+            ubuf_sound_deinterleave_32(dst, src, channels, samples);
+            break;
+        default:
+            deinterleave_c(dst, src, channel_size, channels, 0, samples);
+            break;
+    }
+}
+
+void ubuf_sound_select(uint8_t *dst, const uint8_t *src,
+                       uint8_t channel_size, uint8_t channels,
+                       uint64_t mask, uintptr_t samples)
+{
+    /* copy runs of consecutive channels */
+    struct {
+        uint8_t offset;
+        uint16_t size;
+    } runs[64];
+    unsigned nb_runs = 0;
+    uintptr_t out_size = 0;
+
+    for (uint8_t c = 0; c < channels && c < 64; c++) {
+        if (!(mask & (UINT64_C(1) << c)))
+            continue;
+        if (nb_runs && runs[nb_runs - 1].offset +
+                       runs[nb_runs - 1].size / channel_size == c)
+            runs[nb_runs - 1].size += channel_size;
+        else {
+            runs[nb_runs].offset = c;
+            runs[nb_runs].size = channel_size;
+            nb_runs++;
+        }
+        out_size += channel_size;
+    }
+
+    uintptr_t in_size = channels * channel_size;
+    if (nb_runs == 1 && out_size == in_size) {
+        memcpy(dst, src, samples * in_size);
+        return;
+    }
+
+    for (uintptr_t i = 0; i < samples; i++) {
+        uint8_t *out = dst;
+        for (unsigned r = 0; r < nb_runs; r++) {
+            memcpy(out, src + runs[r].offset * channel_size, runs[r].size);
+            out += runs[r].size;
+        }
+        dst += out_size;
+        src += in_size;
+    }
+}
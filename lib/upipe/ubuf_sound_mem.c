@@ -430,6 +430,16 @@ static int ubuf_sound_mem_mgr_control(struct ubuf_mgr *mgr,
             ubuf_sound_mem_mgr_vacuum_pool(mgr);
             return UBASE_ERR_NONE;
         }
+        case UBUF_MGR_GET_STATS: {
+            struct ualloc_stats *stats = va_arg(args, struct ualloc_stats *);
+            ubuf_sound_mem_mgr_get_stats_pool(mgr, stats);
+            return UBASE_ERR_NONE;
+        }
+        case UBUF_MGR_SET_POOL_LIMIT: {
+            unsigned int limit = va_arg(args, unsigned int);
+            ubuf_sound_mem_mgr_set_limit_pool(mgr, limit);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe ubuf manager tracking the lifetime of ubufs
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/ubuf_track.h"
+#include "utrack.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/** @This is a super-set of the ubuf_mgr structure with additional local
+ * members */
+struct ubuf_track_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** manager allocating the ubufs */
+    struct ubuf_mgr *ubuf_mgr;
+    /** tracker of the live ubufs */
+    struct utrack utrack;
+
+    /** common management structure */
+    struct ubuf_mgr mgr;
+};
+
+UBASE_FROM_TO(ubuf_track_mgr, ubuf_mgr, ubuf_mgr, mgr)
+UBASE_FROM_TO(ubuf_track_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This makes a ubuf of the wrapped manager come back to the
+ * tracking manager, and records it if it is sampled.
+ *
+ * @param mgr common management structure
+ * @param ubuf pointer to ubuf allocated by the wrapped manager
+ * @param site return address of the allocation
+ */
+static void ubuf_track_adopt(struct ubuf_mgr *mgr, struct ubuf *ubuf,
+                             const void *site)
+{
+    struct ubuf_track_mgr *track_mgr = ubuf_track_mgr_from_ubuf_mgr(mgr);
+    ubuf->mgr = ubuf_mgr_use(mgr);
+    if (likely(!utrack_sampled(&track_mgr->utrack, ubuf)))
+        return;
+
+    size_t size = 0;
+    ubuf_block_size(ubuf, &size);
+    utrack_add(&track_mgr->utrack, ubuf, site, size);
+}
+
+/** @This allocates a ubuf with the wrapped manager.
+ *
+ * @param mgr common management structure
+ * @param signature type of allocation
+ * @param args optional arguments
+ * @return pointer to ubuf or NULL in case of allocation error
+ */
+static struct ubuf *ubuf_track_alloc(struct ubuf_mgr *mgr,
+                                     uint32_t signature, va_list args)
+{
+    struct ubuf_track_mgr *track_mgr = ubuf_track_mgr_from_ubuf_mgr(mgr);
+    struct ubuf *ubuf = track_mgr->ubuf_mgr->ubuf_alloc(track_mgr->ubuf_mgr,
+                                                        signature, args);
+    if (unlikely(ubuf == NULL))
+        return NULL;
+    ubuf_track_adopt(mgr, ubuf, __builtin_return_address(0));
+    return ubuf;
+}
+
+/** @This processes control commands on a ubuf, with the wrapped manager.
+ * Duplicates are tracked as well.
+ *
+ * @param ubuf pointer to ubuf
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_track_control(struct ubuf *ubuf, int command, va_list args)
+{
+    struct ubuf_mgr *mgr = ubuf->mgr;
+    struct ubuf_track_mgr *track_mgr = ubuf_track_mgr_from_ubuf_mgr(mgr);
+    struct ubuf **new_ubuf_p = NULL;
+    if (command == UBUF_DUP || command == UBUF_SPLICE_BLOCK) {
+        va_list args_copy;
+        va_copy(args_copy, args);
+        new_ubuf_p = va_arg(args_copy, struct ubuf **);
+        va_end(args_copy);
+    }
+
+    /* the wrapped manager finds its own structures from ubuf->mgr */
+    ubuf->mgr = track_mgr->ubuf_mgr;
+    int err = ubuf_control_va(ubuf, command, args);
+    ubuf->mgr = mgr;
+
+    if (new_ubuf_p != NULL && ubase_check(err) && *new_ubuf_p != NULL &&
+        (*new_ubuf_p)->mgr == track_mgr->ubuf_mgr)
+        ubuf_track_adopt(mgr, *new_ubuf_p, __builtin_return_address(0));
+    return err;
+}
+
+/** @This frees a ubuf with the wrapped manager.
+ *
+ * @param ubuf pointer to ubuf
+ */
+static void ubuf_track_free(struct ubuf *ubuf)
+{
+    struct ubuf_mgr *mgr = ubuf->mgr;
+    struct ubuf_track_mgr *track_mgr = ubuf_track_mgr_from_ubuf_mgr(mgr);
+    if (unlikely(utrack_sampled(&track_mgr->utrack, ubuf)))
+        utrack_remove(&track_mgr->utrack, ubuf);
+
+    ubuf->mgr = track_mgr->ubuf_mgr;
+    ubuf->mgr->ubuf_free(ubuf);
+    ubuf_mgr_release(mgr);
+}
+
+/** @This processes control commands on a ubuf_track_mgr.
+ *
+ * @param mgr pointer to a ubuf_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int ubuf_track_mgr_control(struct ubuf_mgr *mgr,
+                                  int command, va_list args)
+{
+    struct ubuf_track_mgr *track_mgr = ubuf_track_mgr_from_ubuf_mgr(mgr);
+    switch (command) {
+        case UBUF_MGR_ALLOC_BLOCK_BATCH:
+            /* fall back to individual allocations, which are tracked */
+            return UBASE_ERR_UNHANDLED;
+        case UBUF_TRACK_MGR_DUMP: {
+            UBASE_SIGNATURE_CHECK(args, UBUF_TRACK_SIGNATURE)
+            FILE *file = va_arg(args, FILE *);
+            return utrack_dump(&track_mgr->utrack, file, "ubufs");
+        }
+        default:
+            return ubuf_mgr_control_va(track_mgr->ubuf_mgr, command, args);
+    }
+}
+
+/** @This frees a ubuf_track_mgr.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void ubuf_track_mgr_free(struct urefcount *urefcount)
+{
+    struct ubuf_track_mgr *track_mgr =
+        ubuf_track_mgr_from_urefcount(urefcount);
+    ubuf_mgr_release(track_mgr->ubuf_mgr);
+    utrack_clean(&track_mgr->utrack);
+    urefcount_clean(urefcount);
+    free(track_mgr);
+}
+
+/** @This allocates a ubuf manager tracking the ubufs allocated with another
+ * manager.
+ *
+ * @param ubuf_mgr ubuf manager allocating the ubufs
+ * @param period one ubuf out of period is sampled (1 to track all ubufs)
+ * @return pointer to manager, or NULL in case of error
+ */
+struct ubuf_mgr *ubuf_track_mgr_alloc(struct ubuf_mgr *ubuf_mgr,
+                                      unsigned int period)
+{
+    assert(ubuf_mgr != NULL);
+    struct ubuf_track_mgr *track_mgr = malloc(sizeof(struct ubuf_track_mgr));
+    if (unlikely(track_mgr == NULL))
+        return NULL;
+
+    track_mgr->ubuf_mgr = ubuf_mgr_use(ubuf_mgr);
+    utrack_init(&track_mgr->utrack, period);
+    urefcount_init(ubuf_track_mgr_to_urefcount(track_mgr),
+                   ubuf_track_mgr_free);
+    track_mgr->mgr.refcount = ubuf_track_mgr_to_urefcount(track_mgr);
+    track_mgr->mgr.signature = ubuf_mgr->signature;
+    track_mgr->mgr.ubuf_alloc = ubuf_track_alloc;
+    track_mgr->mgr.ubuf_control = ubuf_track_control;
+    track_mgr->mgr.ubuf_free = ubuf_track_free;
+    track_mgr->mgr.ubuf_mgr_control = ubuf_track_mgr_control;
+    return ubuf_track_mgr_to_ubuf_mgr(track_mgr);
+}
@@ -25,11 +25,20 @@
 
 /** @file
  * @short Upipe NIC PTP implementation of uclock
+ *
+ * The PTP hardware clock of the NIC is not read for every timestamp.
+ * Instead it is periodically compared to a fast local clock, and a PI servo
+ * disciplines the conversion from the local clock to the PTP time scale.
+ * The conversion parameters are published with a seqlock so that readers
+ * never take a lock nor do a system call in the common case.
  */
 
 #include "upipe/ubase.h"
 #include "upipe/urefcount.h"
+#include "upipe/uatomic.h"
 #include "upipe/uclock.h"
+#include "upipe/uclock_std.h"
+#include "upipe/uclock_tsc.h"
 #include "upipe/uclock_ptp.h"
 
 #include <stdbool.h>
@@ -44,6 +53,27 @@
 #include <stdlib.h>
 #include <time.h>
 
+/** period between two samples of the PTP hardware clock */
+#define UCLOCK_PTP_PERIOD (UCLOCK_FREQ / 8)
+/** offset above which the clock is stepped instead of slewed */
+#define UCLOCK_PTP_STEP (UCLOCK_FREQ / 1000)
+/** proportional constant of the servo */
+#define UCLOCK_PTP_KP 0.7
+/** integral constant of the servo */
+#define UCLOCK_PTP_KI 0.3
+/** maximum frequency correction of the servo (500 ppm) */
+#define UCLOCK_PTP_MAX_FREQ 0.0005
+
+/** conversion parameters from the local clock to the PTP clock */
+struct uclock_ptp_params {
+    /** local clock at the anchor point */
+    uint64_t local;
+    /** PTP clock at the anchor point, or UINT64_MAX if not sampled yet */
+    uint64_t ptp;
+    /** relative frequency difference between the PTP and local clocks */
+    double rate;
+};
+
 /** super-set of the uclock structure with additional local members */
 struct uclock_ptp {
     /** refcount management structure */
@@ -60,6 +90,22 @@ struct uclock_ptp {
     struct ifreq ifr[2];
 #endif
 
+    /** fast local clock */
+    struct uclock *local;
+    /** sequence number of the seqlock protecting params */
+    uatomic_uint32_t seq;
+    /** published conversion parameters */
+    struct uclock_ptp_params params;
+    /** set while a thread samples the PTP hardware clock */
+    uatomic_uint32_t lock;
+
+    /** local clock at the last sample */
+    uint64_t last_sample;
+    /** interface used for the last sample */
+    int last_idx;
+    /** integral term of the servo */
+    double freq;
+
     /** structure exported to modules */
     struct uclock uclock;
 };
@@ -83,27 +129,136 @@ static bool uclock_ptp_intf_up(struct uclock *uclock, int i)
     return false;
 }
 
-/** @This returns the current time in the given clock.
+#define CLOCKFD 3
+#define FD_TO_CLOCKID(fd) ((~(clockid_t) (fd) << 3) | CLOCKFD)
+
+/** @internal @This reads the conversion parameters.
  *
- * @param uclock utility structure passed to the module
- * @return current system time in 27 MHz ticks
+ * @param ptp private structure
+ * @param params filled in with the current parameters
  */
-static uint64_t uclock_ptp_now(struct uclock *uclock)
+static void uclock_ptp_read_params(struct uclock_ptp *ptp,
+                                   struct uclock_ptp_params *params)
 {
-    struct uclock_ptp *ptp = uclock_ptp_from_uclock(uclock);
+    uint32_t seq;
+    do {
+        while ((seq = uatomic_load(&ptp->seq)) & 1);
+        uatomic_fence();
+        *params = ptp->params;
+        uatomic_fence();
+    } while (uatomic_load(&ptp->seq) != seq);
+}
 
-#define CLOCKFD 3
-#define FD_TO_CLOCKID(fd) ((~(clockid_t) (fd) << 3) | CLOCKFD)
+/** @internal @This publishes new conversion parameters. It must only be
+ * called with the sampling lock held.
+ *
+ * @param ptp private structure
+ * @param params new parameters
+ */
+static void uclock_ptp_write_params(struct uclock_ptp *ptp,
+                                    const struct uclock_ptp_params *params)
+{
+    uatomic_fetch_add(&ptp->seq, 1);
+    uatomic_fence();
+    ptp->params = *params;
+    uatomic_fence();
+    uatomic_fetch_add(&ptp->seq, 1);
+}
 
-    int idx = uclock_ptp_intf_up(uclock, 0) ? 0 : 1;
+/** @internal @This converts a local time to the PTP time scale.
+ *
+ * @param params conversion parameters
+ * @param local local time in 27 MHz ticks
+ * @return PTP time in 27 MHz ticks
+ */
+static inline uint64_t uclock_ptp_convert(const struct uclock_ptp_params *params,
+                                          uint64_t local)
+{
+    int64_t delta = local - params->local;
+    return params->ptp + delta + (int64_t)(delta * params->rate);
+}
 
-    struct timespec ts;
-    if (unlikely(clock_gettime(FD_TO_CLOCKID(ptp->fd[idx]), &ts) == -1))
-        return UINT64_MAX;
+/** @internal @This samples the PTP hardware clock and runs the servo.
+ *
+ * @param ptp private structure
+ */
+static void uclock_ptp_discipline(struct uclock_ptp *ptp)
+{
+    uint32_t unlocked = 0;
+    if (!uatomic_compare_exchange(&ptp->lock, &unlocked, 1))
+        /* another thread is already sampling */
+        return;
+
+    struct uclock_ptp_params params = ptp->params;
+    uint64_t before = uclock_now(ptp->local);
+    if (params.ptp != UINT64_MAX &&
+        before - ptp->last_sample < UCLOCK_PTP_PERIOD) {
+        uatomic_store(&ptp->lock, 0);
+        return;
+    }
 
-    uint64_t now = ts.tv_sec * UCLOCK_FREQ +
+    int idx = uclock_ptp_intf_up(&ptp->uclock, 0) ? 0 : 1;
+    struct timespec ts;
+    if (unlikely(clock_gettime(FD_TO_CLOCKID(ptp->fd[idx]), &ts) == -1)) {
+        uatomic_store(&ptp->lock, 0);
+        return;
+    }
+    uint64_t after = uclock_now(ptp->local);
+    uint64_t local = before + (after - before) / 2;
+    uint64_t phc = ts.tv_sec * UCLOCK_FREQ +
                    ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
-    return now;
+
+    int64_t offset = 0;
+    uint64_t predicted = 0;
+    if (params.ptp != UINT64_MAX && idx == ptp->last_idx) {
+        predicted = uclock_ptp_convert(&params, local);
+        offset = phc - predicted;
+    }
+
+    if (params.ptp == UINT64_MAX || idx != ptp->last_idx ||
+        offset > UCLOCK_PTP_STEP || offset < -UCLOCK_PTP_STEP) {
+        /* first sample, interface switch or too large an offset */
+        params.ptp = phc;
+        params.rate = ptp->freq;
+    } else {
+        double interval = local - ptp->last_sample;
+        ptp->freq += UCLOCK_PTP_KI * offset / interval;
+        if (ptp->freq > UCLOCK_PTP_MAX_FREQ)
+            ptp->freq = UCLOCK_PTP_MAX_FREQ;
+        else if (ptp->freq < -UCLOCK_PTP_MAX_FREQ)
+            ptp->freq = -UCLOCK_PTP_MAX_FREQ;
+        params.ptp = predicted;
+        params.rate = ptp->freq + UCLOCK_PTP_KP * offset / interval;
+    }
+    params.local = local;
+    ptp->last_sample = local;
+    ptp->last_idx = idx;
+
+    uclock_ptp_write_params(ptp, &params);
+    uatomic_store(&ptp->lock, 0);
+}
+
+/** @This returns the current time in the given clock.
+ *
+ * @param uclock utility structure passed to the module
+ * @return current system time in 27 MHz ticks
+ */
+static uint64_t uclock_ptp_now(struct uclock *uclock)
+{
+    struct uclock_ptp *ptp = uclock_ptp_from_uclock(uclock);
+    struct uclock_ptp_params params;
+
+    uint64_t local = uclock_now(ptp->local);
+    uclock_ptp_read_params(ptp, &params);
+    if (unlikely(params.ptp == UINT64_MAX ||
+                 (int64_t)(local - params.local) >= UCLOCK_PTP_PERIOD)) {
+        uclock_ptp_discipline(ptp);
+        local = uclock_now(ptp->local);
+        uclock_ptp_read_params(ptp, &params);
+        if (unlikely(params.ptp == UINT64_MAX))
+            return UINT64_MAX;
+    }
+    return uclock_ptp_convert(&params, local);
 }
 
 /** @This frees a uclock.
@@ -114,6 +269,9 @@ static void uclock_ptp_free(struct urefcount *urefcount)
 {
     struct uclock_ptp *ptp = uclock_ptp_from_urefcount(urefcount);
     urefcount_clean(urefcount);
+    uclock_release(ptp->local);
+    uatomic_clean(&ptp->seq);
+    uatomic_clean(&ptp->lock);
     for (int i = 0; i < 2; i++) {
         ubase_clean_fd(&ptp->fd[i]);
 #ifdef __linux__
@@ -191,6 +349,18 @@ struct uclock *uclock_ptp_alloc(struct uprobe *uprobe, const char *interface[2])
     ptp->uclock.uclock_to_real = NULL;
     ptp->uclock.uclock_from_real = NULL;
 
+    ptp->local = uclock_tsc_alloc(0);
+    if (ptp->local == NULL)
+        ptp->local = uclock_std_alloc(0);
+    uatomic_init(&ptp->seq, 0);
+    uatomic_init(&ptp->lock, 0);
+    ptp->params.local = 0;
+    ptp->params.ptp = UINT64_MAX;
+    ptp->params.rate = 0.;
+    ptp->last_sample = 0;
+    ptp->last_idx = 0;
+    ptp->freq = 0.;
+
     for (int i = 0; i < 2; i++) {
         ptp->fd[i] = -1;
 #ifdef __linux__
@@ -198,6 +368,11 @@ struct uclock *uclock_ptp_alloc(struct uprobe *uprobe, const char *interface[2])
 #endif
     }
 
+    if (unlikely(ptp->local == NULL)) {
+        uprobe_err(uprobe, NULL, "unable to allocate local clock");
+        goto err;
+    }
+
     for (int i = 0; i < 2 && interface[i]; i++) {
 #ifdef __linux__
         ptp->if_fd[i] = socket(AF_INET, SOCK_DGRAM, 0);
@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe implementation of uclock using the CPU cycle counter
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/uatomic.h"
+#include "upipe/uclock.h"
+#include "upipe/uclock_tsc.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define UCLOCK_TSC_SUPPORTED
+#elif defined(__aarch64__)
+#define UCLOCK_TSC_SUPPORTED
+#endif
+
+#ifdef UCLOCK_TSC_SUPPORTED
+
+/** fixed-point shift of the counter to 27 MHz multiplier */
+#define UCLOCK_TSC_SHIFT 32
+/** duration of the initial calibration, in ns (only for x86) */
+#define UCLOCK_TSC_CALIBRATION UINT64_C(20000000)
+/** number of samples taken when reading the system clock */
+#define UCLOCK_TSC_SAMPLES 3
+/** error above which the clock is stepped instead of slewed */
+#define UCLOCK_TSC_MAX_SLEW (UCLOCK_FREQ / 1000)
+
+/** conversion parameters from counter to 27 MHz ticks */
+struct uclock_tsc_cal {
+    /** counter value at the anchor point */
+    uint64_t counter;
+    /** clock value at the anchor point, in 27 MHz ticks */
+    uint64_t ticks;
+    /** 27 MHz ticks per counter tick, shifted by UCLOCK_TSC_SHIFT */
+    uint64_t mult;
+};
+
+/** super-set of the uclock structure with additional local members */
+struct uclock_tsc {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** flags at the creation of this clock */
+    enum uclock_std_flags flags;
+    /** number of counter ticks between two corrections */
+    uint64_t period;
+    /** counter value at the last system clock sample */
+    uint64_t ref_counter;
+    /** system clock at the last sample, in 27 MHz ticks */
+    uint64_t ref_sys;
+
+    /** double-buffered conversion parameters */
+    struct uclock_tsc_cal cal[2];
+    /** index of the current conversion parameters */
+    uatomic_uint32_t cal_idx;
+    /** set while a thread corrects the conversion parameters */
+    uatomic_uint32_t lock;
+
+    /** structure exported to modules */
+    struct uclock uclock;
+};
+
+UBASE_FROM_TO(uclock_tsc, uclock, uclock, uclock)
+UBASE_FROM_TO(uclock_tsc, urefcount, urefcount, urefcount)
+
+/** @internal @This reads the CPU counter.
+ *
+ * @return counter value
+ */
+static inline uint64_t uclock_tsc_counter(void)
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    uint64_t counter;
+    __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r" (counter)
+                         :: "memory");
+    return counter;
+#endif
+}
+
+/** @internal @This converts a counter delta to 27 MHz ticks.
+ *
+ * @param delta counter delta
+ * @param mult multiplier shifted by UCLOCK_TSC_SHIFT
+ * @return number of 27 MHz ticks
+ */
+static inline uint64_t uclock_tsc_scale(uint64_t delta, uint64_t mult)
+{
+    return ((unsigned __int128)delta * mult) >> UCLOCK_TSC_SHIFT;
+}
+
+/** @internal @This reads a system clock.
+ *
+ * @param flags type of clock
+ * @return system time in 27 MHz ticks
+ */
+static uint64_t uclock_tsc_sys(enum uclock_std_flags flags)
+{
+    struct timespec ts;
+    if (unlikely(clock_gettime((flags & UCLOCK_FLAG_REALTIME) ?
+                               CLOCK_REALTIME : CLOCK_MONOTONIC, &ts) == -1))
+        return UINT64_MAX;
+    return ts.tv_sec * UCLOCK_FREQ +
+           ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @internal @This samples the counter and the system clock at the same
+ * time, keeping the tightest of a few attempts.
+ *
+ * @param flags type of clock
+ * @param counter_p filled in with the counter value
+ * @param sys_p filled in with the system time in 27 MHz ticks
+ */
+static void uclock_tsc_sample(enum uclock_std_flags flags,
+                              uint64_t *counter_p, uint64_t *sys_p)
+{
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < UCLOCK_TSC_SAMPLES; i++) {
+        uint64_t before = uclock_tsc_counter();
+        uint64_t sys = uclock_tsc_sys(flags);
+        uint64_t after = uclock_tsc_counter();
+        if (after - before < best) {
+            best = after - before;
+            *counter_p = before + best / 2;
+            *sys_p = sys;
+        }
+    }
+}
+
+/** @internal @This corrects the conversion parameters against the system
+ * clock. The clock is slewed over the next period to catch up with the
+ * system clock, so that it stays continuous, unless the error is too large.
+ *
+ * @param tsc private structure
+ */
+static void uclock_tsc_correct(struct uclock_tsc *tsc)
+{
+    uint32_t unlocked = 0;
+    if (!uatomic_compare_exchange(&tsc->lock, &unlocked, 1))
+        /* another thread is already doing it */
+        return;
+
+    uint32_t idx = uatomic_load(&tsc->cal_idx);
+    const struct uclock_tsc_cal *cal = &tsc->cal[idx & 1];
+    uint64_t counter, sys;
+    uclock_tsc_sample(tsc->flags, &counter, &sys);
+    if (unlikely(sys == UINT64_MAX ||
+                 counter - cal->counter < tsc->period ||
+                 counter == tsc->ref_counter)) {
+        uatomic_store(&tsc->lock, 0);
+        return;
+    }
+
+    /* measured rate since the last correction */
+    uint64_t mult = ((unsigned __int128)(sys - tsc->ref_sys) <<
+                     UCLOCK_TSC_SHIFT) / (counter - tsc->ref_counter);
+    uint64_t ticks = cal->ticks + uclock_tsc_scale(counter - cal->counter,
+                                                   cal->mult);
+    int64_t error = sys - ticks;
+    if (error > UCLOCK_TSC_MAX_SLEW || error < -UCLOCK_TSC_MAX_SLEW)
+        ticks = sys;
+    else {
+        __int128 slew = ((__int128)error << UCLOCK_TSC_SHIFT) / tsc->period;
+        if (slew > 0 || (uint64_t)-slew < mult / 2)
+            mult += slew;
+    }
+
+    struct uclock_tsc_cal *next = &tsc->cal[(idx + 1) & 1];
+    next->counter = counter;
+    next->ticks = ticks;
+    next->mult = mult;
+    tsc->ref_counter = counter;
+    tsc->ref_sys = sys;
+    uatomic_store(&tsc->cal_idx, idx + 1);
+    uatomic_store(&tsc->lock, 0);
+}
+
+/** @This returns the current system time.
+ *
+ * @param uclock utility structure passed to the module
+ * @return current system time in 27 MHz ticks
+ */
+static uint64_t uclock_tsc_now(struct uclock *uclock)
+{
+    struct uclock_tsc *tsc = uclock_tsc_from_uclock(uclock);
+    uint32_t idx = uatomic_load(&tsc->cal_idx);
+    const struct uclock_tsc_cal *cal = &tsc->cal[idx & 1];
+    uint64_t delta = uclock_tsc_counter() - cal->counter;
+    if (unlikely(delta >= tsc->period)) {
+        uclock_tsc_correct(tsc);
+        idx = uatomic_load(&tsc->cal_idx);
+        cal = &tsc->cal[idx & 1];
+        delta = uclock_tsc_counter() - cal->counter;
+    }
+    return cal->ticks + uclock_tsc_scale(delta, cal->mult);
+}
+
+/** @This converts a system time to Epoch-based real time (from
+ * 1970-01-01 00:00:00 +0000). The scale is in units of @ref #UCLOCK_FREQ,
+ * divide by it to get standard time_t.
+ *
+ * @param uclock pointer to uclock
+ * @param systime system time in 27 MHz ticks
+ * @return number of ticks since the Epoch, or UINT64_MAX if unsupported
+ */
+static uint64_t uclock_tsc_to_real(struct uclock *uclock, uint64_t systime)
+{
+    struct uclock_tsc *tsc = uclock_tsc_from_uclock(uclock);
+
+    if (tsc->flags & UCLOCK_FLAG_REALTIME)
+        return systime;
+
+    uint64_t now = uclock_tsc_now(uclock);
+    uint64_t ref = uclock_tsc_sys(UCLOCK_FLAG_REALTIME);
+    return ref + systime - now;
+}
+
+/** @This converts Epoch-based real time (from * 1970-01-01 00:00:00 +0000)
+ * to real time. The scale has to be passed in units of @ref #UCLOCK_FREQ.
+ *
+ * @param uclock pointer to uclock
+ * @param real number of ticks since the Epoch
+ * @return system time in 27 MHz ticks, or UINT64_MAX if unsupported
+ */
+static uint64_t uclock_tsc_from_real(struct uclock *uclock, uint64_t real)
+{
+    struct uclock_tsc *tsc = uclock_tsc_from_uclock(uclock);
+
+    if (tsc->flags & UCLOCK_FLAG_REALTIME)
+        return real;
+
+    uint64_t now = uclock_tsc_now(uclock);
+    uint64_t ref = uclock_tsc_sys(UCLOCK_FLAG_REALTIME);
+    return now + real - ref;
+}
+
+/** @This frees a uclock.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void uclock_tsc_free(struct urefcount *urefcount)
+{
+    struct uclock_tsc *tsc = uclock_tsc_from_urefcount(urefcount);
+    uatomic_clean(&tsc->cal_idx);
+    uatomic_clean(&tsc->lock);
+    urefcount_clean(urefcount);
+    free(tsc);
+}
+
+/** @internal @This returns the initial counter multiplier.
+ *
+ * @param flags type of clock
+ * @return multiplier shifted by UCLOCK_TSC_SHIFT, or 0 if the counter is
+ * not usable
+ */
+static uint64_t uclock_tsc_calibrate(enum uclock_std_flags flags)
+{
+#if defined(__x86_64__)
+    /* the TSC must run at a constant rate in all ACPI P-, C- and T-states */
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) ||
+        eax < 0x80000007 ||
+        !__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+        !(edx & (1 << 8)))
+        return 0;
+
+    uint64_t counter0, sys0, counter1, sys1;
+    uclock_tsc_sample(flags, &counter0, &sys0);
+    struct timespec ts = {
+        .tv_sec = 0,
+        .tv_nsec = UCLOCK_TSC_CALIBRATION
+    };
+    while (nanosleep(&ts, &ts) == -1);
+    uclock_tsc_sample(flags, &counter1, &sys1);
+    if (unlikely(sys0 == UINT64_MAX || sys1 == UINT64_MAX ||
+                 sys1 <= sys0 || counter1 <= counter0))
+        return 0;
+    return ((unsigned __int128)(sys1 - sys0) << UCLOCK_TSC_SHIFT) /
+           (counter1 - counter0);
+#else
+    uint64_t freq;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r" (freq));
+    if (unlikely(!freq))
+        return 0;
+    return ((unsigned __int128)UCLOCK_FREQ << UCLOCK_TSC_SHIFT) / freq;
+#endif
+}
+
+/** @This allocates a new uclock structure based on the CPU cycle counter.
+ *
+ * @param flags flags for the creation of a uclock structure
+ * @return pointer to uclock, or NULL if no suitable counter is available
+ */
+struct uclock *uclock_tsc_alloc(enum uclock_std_flags flags)
+{
+    uint64_t mult = uclock_tsc_calibrate(flags);
+    if (unlikely(!mult))
+        return NULL;
+
+    uint64_t counter, sys;
+    uclock_tsc_sample(flags, &counter, &sys);
+    if (unlikely(sys == UINT64_MAX))
+        return NULL;
+
+    struct uclock_tsc *tsc = malloc(sizeof(struct uclock_tsc));
+    if (unlikely(tsc == NULL))
+        return NULL;
+    tsc->flags = flags;
+    /* correct the parameters about every second */
+    tsc->period = ((unsigned __int128)UCLOCK_FREQ << UCLOCK_TSC_SHIFT) / mult;
+    tsc->ref_counter = counter;
+    tsc->ref_sys = sys;
+    tsc->cal[0].counter = counter;
+    tsc->cal[0].ticks = sys;
+    tsc->cal[0].mult = mult;
+    tsc->cal[1] = tsc->cal[0];
+    uatomic_init(&tsc->cal_idx, 0);
+    uatomic_init(&tsc->lock, 0);
+    urefcount_init(uclock_tsc_to_urefcount(tsc), uclock_tsc_free);
+    tsc->uclock.refcount = uclock_tsc_to_urefcount(tsc);
+    tsc->uclock.uclock_now = uclock_tsc_now;
+    tsc->uclock.uclock_to_real = uclock_tsc_to_real;
+    tsc->uclock.uclock_from_real = uclock_tsc_from_real;
+    return uclock_tsc_to_uclock(tsc);
+}
+
+#else
+
+/** @This allocates a new uclock structure based on the CPU cycle counter.
+ *
+ * @param flags flags for the creation of a uclock structure
+ * @return NULL as no suitable counter is supported on this architecture
+ */
+struct uclock *uclock_tsc_alloc(enum uclock_std_flags flags)
+{
+    return NULL;
+}
+
+#endif
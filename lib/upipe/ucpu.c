@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe runtime CPU dispatch
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ucpu.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+/** @hidden */
+#define UCPU_UNKNOWN UINT32_MAX
+
+/** flags supported by the CPU, probed once */
+static uint32_t ucpu_supported = UCPU_UNKNOWN;
+/** flags allowed by ucpu_set_mask */
+static uint32_t ucpu_mask = UINT32_MAX;
+/** list of selected kernels */
+static struct ucpu_kernel *ucpu_kernels = NULL;
+
+/** @internal @This maps flag names, as used in UPIPE_CPU_FLAGS. */
+static const struct {
+    const char *name;
+    uint32_t flag;
+} ucpu_flag_names[] = {
+    { "sse2", UCPU_SSE2 },
+    { "ssse3", UCPU_SSSE3 },
+    { "pclmul", UCPU_PCLMUL },
+    { "avx", UCPU_AVX },
+    { "avx2", UCPU_AVX2 },
+    { "avx512", UCPU_AVX512 },
+    { "neon", UCPU_NEON },
+    { "aes", UCPU_AES },
+};
+
+/** @internal @This probes the flags supported by the CPU.
+ *
+ * @return CPU flags
+ */
+static uint32_t ucpu_probe(void)
+{
+    uint32_t flags = 0;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2"))
+        flags |= UCPU_SSE2;
+    if (__builtin_cpu_supports("ssse3"))
+        flags |= UCPU_SSSE3;
+    if (__builtin_cpu_supports("pclmul"))
+        flags |= UCPU_PCLMUL;
+    if (__builtin_cpu_supports("avx"))
+        flags |= UCPU_AVX;
+    if (__builtin_cpu_supports("avx2"))
+        flags |= UCPU_AVX2;
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw"))
+        flags |= UCPU_AVX512;
+    if (__builtin_cpu_supports("aes"))
+        flags |= UCPU_AES;
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+    /* Advanced SIMD is mandatory on AArch64, and required by the build
+     * on ARM */
+    flags |= UCPU_NEON;
+#if defined(__aarch64__) && defined(__linux__)
+    if (getauxval(AT_HWCAP) & HWCAP_AES)
+        flags |= UCPU_AES;
+#endif
+#endif
+
+    const char *env = getenv("UPIPE_CPU_FLAGS");
+    if (env != NULL) {
+        uint32_t allowed = 0;
+        while (*env) {
+            size_t len = strcspn(env, ",");
+            for (int i = 0; i < UBASE_ARRAY_SIZE(ucpu_flag_names); i++)
+                if (strlen(ucpu_flag_names[i].name) == len &&
+                    !strncmp(ucpu_flag_names[i].name, env, len))
+                    allowed |= ucpu_flag_names[i].flag;
+            env += len;
+            if (*env == ',')
+                env++;
+        }
+        flags &= allowed;
+    }
+    return flags;
+}
+
+/** @This returns the CPU flags that kernels may use, which are the flags
+ * supported by the CPU restricted by UPIPE_CPU_FLAGS and @ref ucpu_set_mask.
+ *
+ * @return CPU flags
+ */
+uint32_t ucpu_get_flags(void)
+{
+    uint32_t flags = __atomic_load_n(&ucpu_supported, __ATOMIC_RELAXED);
+    if (unlikely(flags == UCPU_UNKNOWN)) {
+        /* concurrent probes give the same result */
+        flags = ucpu_probe();
+        __atomic_store_n(&ucpu_supported, flags, __ATOMIC_RELAXED);
+    }
+    return flags & __atomic_load_n(&ucpu_mask, __ATOMIC_RELAXED);
+}
+
+/** @This restricts the CPU flags that kernels may use, and resets the
+ * selected implementations. This is meant for tests and should be called
+ * before any kernel is in use.
+ *
+ * @param mask CPU flags to allow
+ */
+void ucpu_set_mask(uint32_t mask)
+{
+    __atomic_store_n(&ucpu_mask, mask, __ATOMIC_RELAXED);
+    struct ucpu_kernel *kernel = NULL;
+    while ((kernel = ucpu_kernel_iterate(kernel)) != NULL)
+        __atomic_store_n(&kernel->selected, NULL, __ATOMIC_RELEASE);
+}
+
+/** @This returns the best implementation of a kernel for the given flags,
+ * without selecting it.
+ *
+ * @param kernel description of the kernel
+ * @param flags CPU flags
+ * @return implementation
+ */
+const struct ucpu_impl *ucpu_kernel_find(const struct ucpu_kernel *kernel,
+                                         uint32_t flags)
+{
+    for (unsigned i = 0; i < kernel->nb_impls; i++)
+        if ((kernel->impls[i].flags & flags) == kernel->impls[i].flags)
+            return &kernel->impls[i];
+    /* the last implementation is the portable one */
+    return &kernel->impls[kernel->nb_impls - 1];
+}
+
+/** @internal @This selects the implementation of a kernel for the running
+ * CPU, and adds the kernel to the list of selected kernels.
+ *
+ * @param kernel description of the kernel
+ * @return selected implementation
+ */
+const struct ucpu_impl *ucpu_kernel_select(struct ucpu_kernel *kernel)
+{
+    const struct ucpu_impl *impl = ucpu_kernel_find(kernel, ucpu_get_flags());
+
+    if (!__atomic_exchange_n(&kernel->registered, 1, __ATOMIC_ACQ_REL)) {
+        struct ucpu_kernel *head = __atomic_load_n(&ucpu_kernels,
+                                                   __ATOMIC_ACQUIRE);
+        do {
+            kernel->next = head;
+        } while (!__atomic_compare_exchange_n(&ucpu_kernels, &head, kernel,
+                                              false, __ATOMIC_ACQ_REL,
+                                              __ATOMIC_ACQUIRE));
+    }
+
+    __atomic_store_n(&kernel->selected, impl, __ATOMIC_RELEASE);
+    return impl;
+}
+
+/** @This iterates over the kernels selected so far in the process.
+ *
+ * @param kernel previous kernel, or NULL to get the first one
+ * @return next kernel, or NULL at the end of the list
+ */
+struct ucpu_kernel *ucpu_kernel_iterate(struct ucpu_kernel *kernel)
+{
+    if (kernel == NULL)
+        return __atomic_load_n(&ucpu_kernels, __ATOMIC_ACQUIRE);
+    return kernel->next;
+}
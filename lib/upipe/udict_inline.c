@@ -28,13 +28,24 @@
  * This manager stores all attributes inline inside a single umem block.
  * This is designed in order to minimize calls to memory allocators, and
  * to transmit dictionaries over streams.
+ *
+ * When a dictionary holds more than a given number of attributes, a small
+ * open-addressed hash index of the attributes is lazily built alongside the
+ * packed buffer, and deleted attributes are replaced with tombstones instead
+ * of being moved, so that the index stays valid. Attributes accessed with
+ * names interned in the global key registry are then compared by ID.
+ *
+ * Duplicated dictionaries share the same buffer, which is reference counted
+ * and only copied when one of the dictionaries is modified.
  */
 
 #include "upipe/ubase.h"
+#include "upipe/uatomic.h"
 #include "upipe/urefcount.h"
 #include "upipe/upool.h"
 #include "upipe/umem.h"
 #include "upipe/udict.h"
+#include "upipe/udict_key.h"
 #include "upipe/udict_inline.h"
 
 #include <stdlib.h>
@@ -46,6 +57,19 @@
 #define UDICT_MIN_SIZE 128
 /** default extra space added on udict expansion */
 #define UDICT_EXTRA_SIZE 64
+/** default number of attributes above which an index is built */
+#define UDICT_INDEX_THRESHOLD 16
+/** minimal number of slots of the index */
+#define UDICT_INDEX_MIN_SLOTS 32
+/** marks an empty slot of the index */
+#define UDICT_INDEX_EMPTY UINT32_MAX
+/** marks a slot of the index whose attribute was deleted */
+#define UDICT_INDEX_DELETED (UINT32_MAX - 1)
+
+/** @internal @This is a padding octet, replacing a deleted attribute */
+#define UDICT_INLINE_PAD 0xe
+/** @internal @This is a deleted attribute, followed by its size (16 bits) */
+#define UDICT_INLINE_TOMBSTONE 0xf
 
 /** @internal @This represents a shorthand attribute type. */
 struct inline_shorthand {
@@ -118,6 +142,9 @@ struct udict_inline_mgr {
     /** extra space added when the umem is expanded */
     size_t extra_size;
 
+    /** number of attributes above which an index is built, or 0 */
+    unsigned int index_threshold;
+
     /** udict pool */
     struct upool udict_pool;
     /** umem allocator */
@@ -135,12 +162,36 @@ UBASE_FROM_TO(udict_inline_mgr, udict_mgr, udict_mgr, mgr)
 UBASE_FROM_TO(udict_inline_mgr, urefcount, urefcount, urefcount)
 UBASE_FROM_TO(udict_inline_mgr, upool, udict_pool, udict_pool)
 
+/** @internal @This is a slot of the attribute index. */
+struct udict_inline_slot {
+    /** hash of the name and type of the attribute */
+    uint32_t hash;
+    /** offset of the attribute in the buffer, or UDICT_INDEX_EMPTY, or
+     * UDICT_INDEX_DELETED */
+    uint32_t offset;
+    /** ID of the interned key of the attribute, or 0 if unknown */
+    uint32_t key_id;
+};
+
 /** super-set of the udict structure with additional local members */
 struct udict_inline {
     /** umem structure pointing to buffer */
     struct umem umem;
     /** used size */
     size_t size;
+    /** number of attributes */
+    unsigned int nb_attrs;
+    /** number of octets used by deleted attributes */
+    size_t holes;
+
+    /** attribute index (kept allocated while the structure is pooled) */
+    struct udict_inline_slot *index;
+    /** number of allocated slots in the index */
+    unsigned int index_slots;
+    /** number of non-empty slots in the index */
+    unsigned int index_used;
+    /** true if the index is valid */
+    bool indexed;
 
     /** common structure */
     struct udict udict;
@@ -148,6 +199,58 @@ struct udict_inline {
 
 UBASE_FROM_TO(udict_inline, udict, udict, udict)
 
+/** @internal @This is the size of the header of the umem buffer, holding the
+ * number of udicts sharing the buffer. */
+#define UDICT_INLINE_HEADER_SIZE \
+    ((sizeof(uatomic_uint32_t) + sizeof(uint64_t) - 1) & \
+     ~(sizeof(uint64_t) - 1))
+
+/** @internal @This returns the number of udicts sharing the buffer.
+ *
+ * @param inl pointer to the udict_inline
+ * @return pointer to the refcount of the buffer
+ */
+static inline uatomic_uint32_t *udict_inline_refcount(struct udict_inline *inl)
+{
+    return (uatomic_uint32_t *)umem_buffer(&inl->umem);
+}
+
+/** @internal @This returns a pointer to the attributes.
+ *
+ * @param inl pointer to the udict_inline
+ * @return pointer to the first attribute
+ */
+static inline uint8_t *udict_inline_buffer(struct udict_inline *inl)
+{
+    return umem_buffer(&inl->umem) + UDICT_INLINE_HEADER_SIZE;
+}
+
+/** @internal @This returns the space available for attributes.
+ *
+ * @param inl pointer to the udict_inline
+ * @return size of the attribute space
+ */
+static inline size_t udict_inline_capacity(struct udict_inline *inl)
+{
+    return umem_size(&inl->umem) - UDICT_INLINE_HEADER_SIZE;
+}
+
+/** @internal @This allocates a udict_inline from the pool, without buffer.
+ *
+ * @param inline_mgr pointer to the udict_inline_mgr
+ * @return pointer to udict_inline or NULL in case of allocation error
+ */
+static struct udict_inline *
+    udict_inline_alloc_pool(struct udict_inline_mgr *inline_mgr)
+{
+    struct udict_inline *inl = upool_alloc(&inline_mgr->udict_pool,
+                                           struct udict_inline *);
+    if (unlikely(inl == NULL))
+        return NULL;
+    inl->indexed = false;
+    return inl;
+}
+
 /** @This allocates a udict with attributes space.
  *
  * @param mgr common management structure
@@ -157,25 +260,31 @@ UBASE_FROM_TO(udict_inline, udict, udict, udict)
 static struct udict *udict_inline_alloc(struct udict_mgr *mgr, size_t size)
 {
     struct udict_inline_mgr *inline_mgr = udict_inline_mgr_from_udict_mgr(mgr);
-    struct udict_inline *inl = upool_alloc(&inline_mgr->udict_pool,
-                                           struct udict_inline *);
+    struct udict_inline *inl = udict_inline_alloc_pool(inline_mgr);
+    if (unlikely(inl == NULL))
+        return NULL;
     struct udict *udict = udict_inline_to_udict(inl);
 
     if (size < inline_mgr->min_size)
         size = inline_mgr->min_size;
-    if (unlikely(!umem_alloc(inline_mgr->umem_mgr, &inl->umem, size))) {
+    if (unlikely(!umem_alloc(inline_mgr->umem_mgr, &inl->umem,
+                             size + UDICT_INLINE_HEADER_SIZE))) {
         upool_free(&inline_mgr->udict_pool, inl);
         return NULL;
     }
 
-    uint8_t *buffer = umem_buffer(&inl->umem);
+    uatomic_init(udict_inline_refcount(inl), 1);
+    uint8_t *buffer = udict_inline_buffer(inl);
     buffer[0] = UDICT_TYPE_END;
     inl->size = 1;
+    inl->nb_attrs = 0;
+    inl->holes = 0;
 
     return udict;
 }
 
-/** @This duplicates a given udict.
+/** @This duplicates a given udict. The attribute buffer is shared between
+ * both udicts, and copied on the first write to either of them.
  *
  * @param udict pointer to udict
  * @param new_udict_p reference written with a pointer to the newly allocated
@@ -185,16 +294,55 @@ static struct udict *udict_inline_alloc(struct udict_mgr *mgr, size_t size)
 static int udict_inline_dup(struct udict *udict, struct udict **new_udict_p)
 {
     assert(new_udict_p != NULL);
+    struct udict_inline_mgr *inline_mgr =
+        udict_inline_mgr_from_udict_mgr(udict->mgr);
     struct udict_inline *inl = udict_inline_from_udict(udict);
-    struct udict *new_udict = udict_inline_alloc(udict->mgr, inl->size);
-    if (unlikely(new_udict == NULL))
+    struct udict_inline *new_inl = udict_inline_alloc_pool(inline_mgr);
+    if (unlikely(new_inl == NULL))
         return UBASE_ERR_ALLOC;
 
-    *new_udict_p = new_udict;
-
-    struct udict_inline *new_inl = udict_inline_from_udict(new_udict);
-    memcpy(umem_buffer(&new_inl->umem), umem_buffer(&inl->umem), inl->size);
+    uatomic_fetch_add(udict_inline_refcount(inl), 1);
+    new_inl->umem = inl->umem;
     new_inl->size = inl->size;
+    new_inl->nb_attrs = inl->nb_attrs;
+    new_inl->holes = inl->holes;
+    *new_udict_p = udict_inline_to_udict(new_inl);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This releases the attribute buffer, and frees it if it is not
+ * shared anymore.
+ *
+ * @param inl pointer to the udict_inline
+ */
+static void udict_inline_release(struct udict_inline *inl)
+{
+    if (uatomic_fetch_sub(udict_inline_refcount(inl), 1) == 1) {
+        uatomic_clean(udict_inline_refcount(inl));
+        umem_free(&inl->umem);
+    }
+}
+
+/** @internal @This makes sure the attribute buffer is not shared with other
+ * udicts before it is written. Offsets of the attributes are kept, so the
+ * index remains valid.
+ *
+ * @param inl pointer to the udict_inline
+ * @return an error code
+ */
+static int udict_inline_unshare(struct udict_inline *inl)
+{
+    if (likely(uatomic_load(udict_inline_refcount(inl)) == 1))
+        return UBASE_ERR_NONE;
+
+    struct umem umem;
+    if (unlikely(!umem_alloc(inl->umem.mgr, &umem, umem_size(&inl->umem))))
+        return UBASE_ERR_ALLOC;
+    memcpy(umem_buffer(&umem) + UDICT_INLINE_HEADER_SIZE,
+           udict_inline_buffer(inl), inl->size);
+    udict_inline_release(inl);
+    inl->umem = umem;
+    uatomic_init(udict_inline_refcount(inl), 1);
     return UBASE_ERR_NONE;
 }
 
@@ -221,6 +369,8 @@ static uint8_t *udict_inline_next(uint8_t *attr)
 {
     if (*attr == UDICT_TYPE_END)
         return NULL;
+    if (unlikely(*attr == UDICT_INLINE_PAD))
+        return attr + 1;
 
     if (likely(*attr > UDICT_TYPE_SHORTHAND)) {
         const struct inline_shorthand *shorthand =
@@ -236,6 +386,181 @@ static uint8_t *udict_inline_next(uint8_t *attr)
     return attr + 3 + size;
 }
 
+/** @internal @This checks if an attribute is a deleted attribute.
+ *
+ * @param attr pointer to the attribute
+ * @return true if the attribute was deleted
+ */
+static inline bool udict_inline_is_hole(const uint8_t *attr)
+{
+    return *attr == UDICT_INLINE_PAD || *attr == UDICT_INLINE_TOMBSTONE;
+}
+
+/** @internal @This computes the hash of an attribute for the index.
+ *
+ * @param name name of the attribute (ignored for shorthands)
+ * @param type type of the attribute
+ * @param key interned key of the attribute, or NULL
+ * @return hash of the attribute
+ */
+static inline uint32_t udict_inline_hash(const char *name,
+                                         enum udict_type type,
+                                         const struct udict_key *key)
+{
+    uint32_t hash = UINT32_C(0x9e3779b1) * type;
+    if (type < UDICT_TYPE_SHORTHAND)
+        hash ^= key != NULL ? key->hash : udict_key_hash(name);
+    return hash;
+}
+
+/** @internal @This returns the interned key of an attribute.
+ *
+ * @param name name of the attribute
+ * @param type type of the attribute
+ * @return pointer to the interned key, or NULL
+ */
+static inline const struct udict_key *udict_inline_key(const char *name,
+                                                       enum udict_type type)
+{
+    return type < UDICT_TYPE_SHORTHAND ? udict_key_get(name) : NULL;
+}
+
+/** @internal @This inserts an attribute into the index. There must be at
+ * least one empty slot.
+ *
+ * @param inl pointer to the udict_inline
+ * @param attr pointer to the attribute
+ * @param key interned key of the attribute, or NULL if unknown
+ */
+static void udict_inline_index_insert(struct udict_inline *inl, uint8_t *attr,
+                                      const struct udict_key *key)
+{
+    uint32_t hash = udict_inline_hash((const char *)(attr + 3), *attr, key);
+    unsigned int mask = inl->index_slots - 1;
+    unsigned int i = hash & mask;
+    while (inl->index[i].offset != UDICT_INDEX_EMPTY &&
+           inl->index[i].offset != UDICT_INDEX_DELETED)
+        i = (i + 1) & mask;
+
+    if (inl->index[i].offset == UDICT_INDEX_EMPTY)
+        inl->index_used++;
+    inl->index[i].hash = hash;
+    inl->index[i].offset = attr - udict_inline_buffer(inl);
+    inl->index[i].key_id = key != NULL ? key->id : 0;
+}
+
+/** @internal @This (re)builds the index of attributes.
+ *
+ * @param inl pointer to the udict_inline
+ * @return false in case of allocation error (the index is then disabled)
+ */
+static bool udict_inline_index_build(struct udict_inline *inl)
+{
+    unsigned int slots = UDICT_INDEX_MIN_SLOTS;
+    while (slots < inl->nb_attrs * 2)
+        slots *= 2;
+    if (slots > inl->index_slots) {
+        struct udict_inline_slot *index =
+            realloc(inl->index, slots * sizeof(struct udict_inline_slot));
+        if (unlikely(index == NULL)) {
+            inl->indexed = false;
+            return false;
+        }
+        inl->index = index;
+        inl->index_slots = slots;
+    }
+
+    for (unsigned int i = 0; i < inl->index_slots; i++)
+        inl->index[i].offset = UDICT_INDEX_EMPTY;
+    inl->index_used = 0;
+
+    uint8_t *attr = udict_inline_buffer(inl);
+    while (attr != NULL && *attr != UDICT_TYPE_END) {
+        if (!udict_inline_is_hole(attr))
+            udict_inline_index_insert(inl, attr, NULL);
+        attr = udict_inline_next(attr);
+    }
+    inl->indexed = true;
+    return true;
+}
+
+/** @internal @This builds the index if the number of attributes goes past
+ * the threshold.
+ *
+ * @param udict pointer to the udict
+ */
+static void udict_inline_index_check(struct udict *udict)
+{
+    struct udict_inline *inl = udict_inline_from_udict(udict);
+    struct udict_inline_mgr *inline_mgr =
+        udict_inline_mgr_from_udict_mgr(udict->mgr);
+    if (inline_mgr->index_threshold &&
+        inl->nb_attrs > inline_mgr->index_threshold)
+        udict_inline_index_build(inl);
+}
+
+/** @internal @This adds a newly written attribute to the index, and builds
+ * the index if the number of attributes goes past the threshold.
+ *
+ * @param udict pointer to the udict
+ * @param attr pointer to the attribute
+ * @param name name of the attribute, possibly interned
+ */
+static void udict_inline_index_add(struct udict *udict, uint8_t *attr,
+                                   const char *name)
+{
+    struct udict_inline *inl = udict_inline_from_udict(udict);
+    inl->nb_attrs++;
+    if (!inl->indexed) {
+        udict_inline_index_check(udict);
+        return;
+    }
+
+    if ((inl->index_used + 1) * 4 > inl->index_slots * 3)
+        udict_inline_index_build(inl);
+    else
+        udict_inline_index_insert(inl, attr, udict_inline_key(name, *attr));
+}
+
+/** @internal @This finds an attribute in the index.
+ *
+ * @param inl pointer to the udict_inline
+ * @param name name of the attribute
+ * @param type type of the attribute
+ * @return pointer to the slot of the attribute, or NULL
+ */
+static struct udict_inline_slot *
+    udict_inline_index_find(struct udict_inline *inl, const char *name,
+                            enum udict_type type)
+{
+    const struct udict_key *key = udict_inline_key(name, type);
+    uint32_t hash = udict_inline_hash(name, type, key);
+    unsigned int mask = inl->index_slots - 1;
+    uint8_t *buffer = udict_inline_buffer(inl);
+    for (unsigned int i = hash & mask; inl->index[i].offset != UDICT_INDEX_EMPTY;
+         i = (i + 1) & mask) {
+        struct udict_inline_slot *slot = &inl->index[i];
+        if (slot->offset == UDICT_INDEX_DELETED || slot->hash != hash)
+            continue;
+        uint8_t *attr = buffer + slot->offset;
+        if (*attr != type)
+            continue;
+        if (type > UDICT_TYPE_SHORTHAND)
+            return slot;
+        if (key != NULL && slot->key_id) {
+            if (slot->key_id == key->id)
+                return slot;
+            continue;
+        }
+        if (!strcmp((const char *)(attr + 3), name)) {
+            if (key != NULL)
+                slot->key_id = key->id;
+            return slot;
+        }
+    }
+    return NULL;
+}
+
 /** @internal @This finds an attribute (shorthand or not) of the given name
  * and type and returns a pointer to its beginning.
  *
@@ -255,7 +580,16 @@ static uint8_t *udict_inline_find(struct udict *udict, const char *name,
         inline_mgr->stats[type - UDICT_TYPE_SHORTHAND - 1]++;
     }
 #endif
-    uint8_t *attr = umem_buffer(&inl->umem);
+    if (unlikely(!inl->indexed))
+        /* duplicated udicts are indexed lazily */
+        udict_inline_index_check(udict);
+    if (inl->indexed && type != UDICT_TYPE_END) {
+        struct udict_inline_slot *slot =
+            udict_inline_index_find(inl, name, type);
+        return slot != NULL ? udict_inline_buffer(inl) + slot->offset : NULL;
+    }
+
+    uint8_t *attr = udict_inline_buffer(inl);
     while (attr != NULL) {
         if (*attr == type &&
              (type > UDICT_TYPE_SHORTHAND || type == UDICT_TYPE_END ||
@@ -288,7 +622,9 @@ static void udict_inline_iterate(struct udict *udict, const char **name_p,
         if (likely(attr != NULL))
             attr = udict_inline_next(attr);
     } else
-        attr = umem_buffer(&inl->umem);
+        attr = udict_inline_buffer(inl);
+    while (attr != NULL && udict_inline_is_hole(attr))
+        attr = udict_inline_next(attr);
     if (unlikely(attr == NULL || *attr == UDICT_TYPE_END)) {
         *type_p = UDICT_TYPE_END;
         return;
@@ -365,7 +701,9 @@ static int udict_inline_get(struct udict *udict, const char *name,
     return UBASE_ERR_NONE;
 }
 
-/** @internal @This deletes an attribute.
+/** @internal @This deletes an attribute. If the udict is indexed, the
+ * attribute is replaced with a tombstone so that the offsets of the other
+ * attributes are kept.
  *
  * @param udict pointer to the udict
  * @param name name of the attribute
@@ -380,13 +718,59 @@ static int udict_inline_delete(struct udict *udict, const char *name,
     uint8_t *attr = udict_inline_find(udict, name, type);
     if (unlikely(attr == NULL))
         return UBASE_ERR_INVALID;
+    size_t offset = attr - udict_inline_buffer(inl);
+    UBASE_RETURN(udict_inline_unshare(inl))
+    attr = udict_inline_buffer(inl) + offset;
 
     uint8_t *end = udict_inline_next(attr);
-    memmove(attr, end, umem_buffer(&inl->umem) + inl->size - end);
-    inl->size -= end - attr;
+    inl->nb_attrs--;
+    if (!inl->indexed) {
+        memmove(attr, end, udict_inline_buffer(inl) + inl->size - end);
+        inl->size -= end - attr;
+        return UBASE_ERR_NONE;
+    }
+
+    struct udict_inline_slot *slot = udict_inline_index_find(inl, name, type);
+    assert(slot != NULL);
+    slot->offset = UDICT_INDEX_DELETED;
+
+    size_t hole = end - attr;
+    inl->holes += hole;
+    if (hole < 3)
+        memset(attr, UDICT_INLINE_PAD, hole);
+    else {
+        attr[0] = UDICT_INLINE_TOMBSTONE;
+        attr[1] = (hole - 3) >> 8;
+        attr[2] = (hole - 3) & 0xff;
+    }
     return UBASE_ERR_NONE;
 }
 
+/** @internal @This removes deleted attributes from the buffer, and rebuilds
+ * the index.
+ *
+ * @param inl pointer to the udict_inline
+ */
+static void udict_inline_compact(struct udict_inline *inl)
+{
+    uint8_t *buffer = udict_inline_buffer(inl);
+    uint8_t *attr = buffer;
+    uint8_t *out = buffer;
+    while (attr != NULL && *attr != UDICT_TYPE_END) {
+        uint8_t *next = udict_inline_next(attr);
+        if (!udict_inline_is_hole(attr)) {
+            memmove(out, attr, next - attr);
+            out += next - attr;
+        }
+        attr = next;
+    }
+    *out++ = UDICT_TYPE_END;
+    inl->size = out - buffer;
+    inl->holes = 0;
+    if (inl->indexed)
+        udict_inline_index_build(inl);
+}
+
 /** @internal @This adds or changes an attribute (excluding the value itself).
  *
  * @param udict pointer to the udict
@@ -409,6 +793,7 @@ static int udict_inline_set(struct udict *udict, const char *name,
             return UBASE_ERR_INVALID;
         base_type = shorthand->base_type;
     }
+    UBASE_RETURN(udict_inline_unshare(inl))
 
     /* check if it already exists */
     size_t current_size;
@@ -444,19 +829,25 @@ static int udict_inline_set(struct udict *udict, const char *name,
     }
 
     /* check total attributes size */
-    attr = umem_buffer(&inl->umem) + inl->size - 1;
-    size_t total_size = (attr - umem_buffer(&inl->umem)) + header_size +
+    if (unlikely(inl->holes &&
+                 inl->size + header_size + attr_size >=
+                 udict_inline_capacity(inl)))
+        udict_inline_compact(inl);
+    attr = udict_inline_buffer(inl) + inl->size - 1;
+    size_t total_size = (attr - udict_inline_buffer(inl)) + header_size +
                         attr_size + 1;
-    if (unlikely(total_size >= umem_size(&inl->umem))) {
+    if (unlikely(total_size >= udict_inline_capacity(inl))) {
         struct udict_inline_mgr *inline_mgr =
             udict_inline_mgr_from_udict_mgr(udict->mgr);
-        if (unlikely(!umem_realloc(&inl->umem, total_size +
+        if (unlikely(!umem_realloc(&inl->umem, UDICT_INLINE_HEADER_SIZE +
+                                               total_size +
                                                inline_mgr->extra_size)))
             return UBASE_ERR_ALLOC;
 
-        attr = umem_buffer(&inl->umem) + inl->size - 1;
+        attr = udict_inline_buffer(inl) + inl->size - 1;
     }
     assert(*attr == UDICT_TYPE_END);
+    uint8_t *header = attr;
 
     /* write attribute header */
     if (unlikely(shorthand == NULL)) {
@@ -481,6 +872,7 @@ static int udict_inline_set(struct udict *udict, const char *name,
     if (attr_p != NULL)
         *attr_p = attr;
     inl->size += header_size + attr_size;
+    udict_inline_index_add(udict, header, name);
     return UBASE_ERR_NONE;
 }
 
@@ -566,7 +958,7 @@ static void udict_inline_free(struct udict *udict)
         udict_inline_mgr_from_udict_mgr(udict->mgr);
     struct udict_inline *inl = udict_inline_from_udict(udict);
 
-    umem_free(&inl->umem);
+    udict_inline_release(inl);
     upool_free(&inline_mgr->udict_pool, inl);
 }
 
@@ -584,6 +976,8 @@ static void *udict_inline_alloc_inner(struct upool *upool)
         return NULL;
     struct udict *udict = udict_inline_to_udict(inl);
     udict->mgr = udict_inline_mgr_to_udict_mgr(inline_mgr);
+    inl->index = NULL;
+    inl->index_slots = 0;
     return inl;
 }
 
@@ -592,8 +986,10 @@ static void *udict_inline_alloc_inner(struct upool *upool)
  * @param upool pointer to upool
  * @param inl pointer to a udict_inline structure to free
  */
-static void udict_inline_free_inner(struct upool *upool, void *inl)
+static void udict_inline_free_inner(struct upool *upool, void *_inl)
 {
+    struct udict_inline *inl = _inl;
+    free(inl->index);
     free(inl);
 }
 
@@ -608,6 +1004,24 @@ static void udict_inline_mgr_vacuum(struct udict_mgr *mgr)
     upool_vacuum(&inline_mgr->udict_pool);
 }
 
+/** @internal @This returns the allocation statistics of the pool of udict
+ * structures. Attribute buffers are accounted for by the umem manager.
+ *
+ * @param mgr pointer to udict manager
+ * @param stats filled in with the allocation statistics
+ * @return an error code
+ */
+static int udict_inline_mgr_get_stats(struct udict_mgr *mgr,
+                                      struct ualloc_stats *stats)
+{
+    struct udict_inline_mgr *inline_mgr = udict_inline_mgr_from_udict_mgr(mgr);
+    assert(stats != NULL);
+    ualloc_stats_init(stats);
+    upool_get_stats(&inline_mgr->udict_pool, stats,
+                    sizeof(struct udict_inline));
+    return UBASE_ERR_NONE;
+}
+
 /** @This processes control commands on a udict_std_mgr.
  *
  * @param mgr pointer to a udict_mgr structure
@@ -622,6 +1036,17 @@ static int udict_inline_mgr_control(struct udict_mgr *mgr,
         case UDICT_MGR_VACUUM:
             udict_inline_mgr_vacuum(mgr);
             return UBASE_ERR_NONE;
+        case UDICT_MGR_GET_STATS: {
+            struct ualloc_stats *stats = va_arg(args, struct ualloc_stats *);
+            return udict_inline_mgr_get_stats(mgr, stats);
+        }
+        case UDICT_INLINE_MGR_SET_INDEX_THRESHOLD: {
+            UBASE_SIGNATURE_CHECK(args, UDICT_INLINE_SIGNATURE)
+            struct udict_inline_mgr *inline_mgr =
+                udict_inline_mgr_from_udict_mgr(mgr);
+            inline_mgr->index_threshold = va_arg(args, unsigned int);
+            return UBASE_ERR_NONE;
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
@@ -690,6 +1115,7 @@ struct udict_mgr *udict_inline_mgr_alloc(uint16_t udict_pool_depth,
 
     inline_mgr->min_size = min_size > 0 ? min_size : UDICT_MIN_SIZE;
     inline_mgr->extra_size = extra_size > 0 ? extra_size : UDICT_EXTRA_SIZE;
+    inline_mgr->index_threshold = UDICT_INDEX_THRESHOLD;
 
 #ifdef STATS
     int i;
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe global registry of interned attribute keys
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/udict_key.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <pthread.h>
+
+/** @internal @This is the size of the memory area storing interned keys. */
+#define UDICT_KEY_POOL_SIZE (64 * 1024)
+
+/** @internal @This protects insertions in the registry. */
+static pthread_mutex_t udict_key_lock = PTHREAD_MUTEX_INITIALIZER;
+/** @internal @This is the number of interned keys. */
+static unsigned int udict_key_nb;
+/** @internal @This is the used size of the pool. */
+static size_t udict_key_pool_size;
+/** @internal @This stores the interned keys, indexed by ID - 1. */
+static struct udict_key *udict_key_keys[UDICT_KEY_MAX];
+/** @internal @This is the memory area storing interned keys, so that
+ * canonical names can be recognized by their address. */
+static uint8_t udict_key_pool[UDICT_KEY_POOL_SIZE]
+    __attribute__ ((aligned (sizeof(uint32_t))));
+
+/** @This interns an attribute name. This function is thread-safe. Interning
+ * the same name twice returns the same pointer.
+ *
+ * @param name name of the attribute
+ * @return canonical name of the attribute, or name itself if the registry
+ * is full
+ */
+const char *udict_key_intern(const char *name)
+{
+    if (unlikely(udict_key_get(name) != NULL))
+        return name;
+
+    uint32_t hash = udict_key_hash(name);
+    const char *canonical = name;
+
+    pthread_mutex_lock(&udict_key_lock);
+    for (unsigned int i = 0; i < udict_key_nb; i++) {
+        struct udict_key *key = udict_key_keys[i];
+        if (key->hash == hash && !strcmp(key->name, name)) {
+            canonical = key->name;
+            goto unlock;
+        }
+    }
+
+    size_t len = strlen(name);
+    size_t size = (sizeof(struct udict_key) + len + 1 + sizeof(uint32_t) - 1) &
+                  ~(sizeof(uint32_t) - 1);
+    if (unlikely(udict_key_nb >= UDICT_KEY_MAX ||
+                 udict_key_pool_size + size > UDICT_KEY_POOL_SIZE))
+        goto unlock;
+
+    struct udict_key *key =
+        (struct udict_key *)(udict_key_pool + udict_key_pool_size);
+    udict_key_pool_size += size;
+    key->hash = hash;
+    key->id = udict_key_nb + 1;
+    memcpy(key->name, name, len + 1);
+    udict_key_keys[udict_key_nb] = key;
+    __atomic_store_n(&udict_key_nb, udict_key_nb + 1, __ATOMIC_RELEASE);
+    canonical = key->name;
+
+unlock:
+    pthread_mutex_unlock(&udict_key_lock);
+    return canonical;
+}
+
+/** @This returns the interned key of a canonical name.
+ *
+ * @param name canonical name, as returned by @ref udict_key_intern, or any
+ * other string
+ * @return pointer to the interned key, or NULL if name is not a canonical
+ * name
+ */
+const struct udict_key *udict_key_get(const char *name)
+{
+    /* keys are never released, so they are only appended and it is safe to
+     * read the registry without the lock */
+    unsigned int nb = __atomic_load_n(&udict_key_nb, __ATOMIC_ACQUIRE);
+    if (name == NULL || !nb)
+        return NULL;
+
+    const uint8_t *p = (const uint8_t *)name - offsetof(struct udict_key, name);
+    if (p < udict_key_pool || p >= udict_key_pool + UDICT_KEY_POOL_SIZE ||
+        (p - udict_key_pool) % sizeof(uint32_t))
+        return NULL;
+
+    const struct udict_key *key = (const struct udict_key *)p;
+    if (key->id < 1 || key->id > nb || udict_key_keys[key->id - 1] != key)
+        return NULL;
+    return key;
+}
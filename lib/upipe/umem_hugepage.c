@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe hugepage- and NUMA-aware memory allocator
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/ulifo.h"
+#include "upipe/umem.h"
+#include "upipe/umem_hugepage.h"
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+/** mbind(2) policy restricting allocations to a set of nodes */
+#define UMEM_HUGEPAGE_MPOL_BIND 2
+
+/** @This defines the private data structures of the umem hugepage
+ * manager. */
+struct umem_hugepage_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** common management structure */
+    struct umem_mgr mgr;
+
+    /** pointer to the arena */
+    uint8_t *arena;
+    /** size of the arena */
+    size_t arena_size;
+    /** size (in octets) of buffers of pools[0] */
+    size_t pool0_size;
+    /** number of pools of buffers */
+    size_t nb_pools;
+    /** buffer pools */
+    struct ulifo pools[];
+};
+
+UBASE_FROM_TO(umem_hugepage_mgr, umem_mgr, umem_mgr, mgr)
+UBASE_FROM_TO(umem_hugepage_mgr, urefcount, urefcount, urefcount)
+
+/** @internal @This returns the nearest bigger size to allocate for a umem of
+ * the given size to fit into and returns the index of the appropriate pool.
+ *
+ * @param hp_mgr description structure of the umem mgr
+ * @param wanted desired size of the umem
+ * @param real_p reference written with the actual size of the future buffer
+ * @return index of the pool in which to find appropriate buffers
+ */
+static unsigned int umem_hugepage_find(struct umem_hugepage_mgr *hp_mgr,
+                                       size_t wanted, size_t *real_p)
+{
+    size_t size = hp_mgr->pool0_size;
+    unsigned int pool;
+
+    for (pool = 0; pool < hp_mgr->nb_pools; pool++)
+        if (wanted <= (size << pool))
+            break;
+    if (likely(real_p != NULL))
+        *real_p = pool < hp_mgr->nb_pools ? size << pool : wanted;
+    return pool;
+}
+
+/** @internal @This checks if a buffer was carved from the arena.
+ *
+ * @param hp_mgr description structure of the umem mgr
+ * @param buffer pointer to the buffer
+ * @return true if the buffer belongs to the arena
+ */
+static inline bool umem_hugepage_in_arena(struct umem_hugepage_mgr *hp_mgr,
+                                          uint8_t *buffer)
+{
+    return buffer >= hp_mgr->arena &&
+           buffer < hp_mgr->arena + hp_mgr->arena_size;
+}
+
+/** @This allocates a new umem buffer space.
+ *
+ * @param mgr management structure
+ * @param umem caller-allocated structure, filled in with the required pointer
+ * and size (previous content is discarded)
+ * @param size requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_hugepage_alloc(struct umem_mgr *mgr, struct umem *umem,
+                                size_t size)
+{
+    struct umem_hugepage_mgr *hp_mgr = umem_hugepage_mgr_from_umem_mgr(mgr);
+    size_t real_size;
+    unsigned int pool = umem_hugepage_find(hp_mgr, size, &real_size);
+    uint8_t *buffer = NULL;
+
+    if (likely(pool < hp_mgr->nb_pools))
+        buffer = ulifo_pop(&hp_mgr->pools[pool], uint8_t *);
+    if (unlikely(buffer == NULL))
+        buffer = malloc(real_size);
+    if (unlikely(buffer == NULL))
+        return false;
+
+    umem->buffer = buffer;
+    umem->size = size;
+    umem->real_size = real_size;
+    umem->mgr = mgr;
+    return true;
+}
+
+/** @This frees a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc
+ */
+static void umem_hugepage_free(struct umem *umem)
+{
+    struct umem_hugepage_mgr *hp_mgr =
+        umem_hugepage_mgr_from_umem_mgr(umem->mgr);
+
+    if (likely(umem_hugepage_in_arena(hp_mgr, umem->buffer))) {
+        unsigned int pool = umem_hugepage_find(hp_mgr, umem->real_size, NULL);
+        /* the pool was sized to hold all its buffers */
+        ulifo_push(&hp_mgr->pools[pool], umem->buffer);
+    } else
+        free(umem->buffer);
+    umem->buffer = NULL;
+    umem->mgr = NULL;
+}
+
+/** @This resizes a umem.
+ *
+ * @param umem caller-allocated structure, previously successfully passed to
+ * @ref umem_alloc, and filled in with the new pointer and size
+ * @param new_size new requested size of the umem
+ * @return false if the memory couldn't be allocated (umem left untouched)
+ */
+static bool umem_hugepage_realloc(struct umem *umem, size_t new_size)
+{
+    if (likely(new_size <= umem->real_size)) {
+        umem->size = new_size;
+        return true;
+    }
+
+    struct umem new_umem;
+    if (!umem_hugepage_alloc(umem->mgr, &new_umem, new_size))
+        return false;
+    memcpy(new_umem.buffer, umem->buffer, umem->size);
+    umem_hugepage_free(umem);
+    *umem = new_umem;
+    return true;
+}
+
+/** @This frees a umem manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void umem_hugepage_mgr_free(struct urefcount *urefcount)
+{
+    struct umem_hugepage_mgr *hp_mgr =
+        umem_hugepage_mgr_from_urefcount(urefcount);
+
+    for (unsigned int i = 0; i < hp_mgr->nb_pools; i++) {
+        while (ulifo_pop(&hp_mgr->pools[i], uint8_t *) != NULL);
+        ulifo_clean(&hp_mgr->pools[i]);
+    }
+    if (hp_mgr->arena != NULL)
+        munmap(hp_mgr->arena, hp_mgr->arena_size);
+
+    urefcount_clean(urefcount);
+    free(hp_mgr);
+}
+
+/** @internal @This maps the arena, binds it to the given NUMA node and
+ * faults all pages in.
+ *
+ * @param hp_mgr description structure of the umem mgr
+ * @param page_size size of the hugepages, or 0
+ * @param numa_node NUMA node, or -1
+ * @return false in case of error
+ */
+static bool umem_hugepage_map(struct umem_hugepage_mgr *hp_mgr,
+                              size_t page_size, int numa_node)
+{
+    size_t sys_page_size = sysconf(_SC_PAGESIZE);
+    void *arena = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (page_size) {
+        size_t size = (hp_mgr->arena_size + page_size - 1) &
+                      ~(page_size - 1);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                    (__builtin_ctzll(page_size) << MAP_HUGE_SHIFT);
+        arena = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (arena != MAP_FAILED)
+            hp_mgr->arena_size = size;
+    }
+#endif
+
+    if (arena == MAP_FAILED) {
+        hp_mgr->arena_size = (hp_mgr->arena_size + sys_page_size - 1) &
+                             ~(sys_page_size - 1);
+        arena = mmap(NULL, hp_mgr->arena_size, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (unlikely(arena == MAP_FAILED))
+            return false;
+#ifdef MADV_HUGEPAGE
+        if (page_size)
+            madvise(arena, hp_mgr->arena_size, MADV_HUGEPAGE);
+#endif
+        page_size = sys_page_size;
+    }
+    hp_mgr->arena = arena;
+
+#if defined(__linux__) && defined(SYS_mbind)
+    if (numa_node >= 0) {
+        unsigned long nodemask[4] = { 0 };
+        unsigned int bits = sizeof(nodemask[0]) * 8;
+        if (unlikely(numa_node >= UBASE_ARRAY_SIZE(nodemask) * bits))
+            return false;
+        nodemask[numa_node / bits] = 1UL << (numa_node % bits);
+        /* not fatal: the kernel may lack NUMA support */
+        syscall(SYS_mbind, arena, hp_mgr->arena_size,
+                UMEM_HUGEPAGE_MPOL_BIND, nodemask,
+                UBASE_ARRAY_SIZE(nodemask) * bits + 1, 0);
+    }
+#endif
+
+    /* pre-fault the pages once bound, to avoid faults in the data path */
+    for (size_t offset = 0; offset < hp_mgr->arena_size; offset += page_size)
+        hp_mgr->arena[offset] = 0;
+    return true;
+}
+
+/** @This allocates a new instance of the umem hugepage manager, carving
+ * buffers out of a pre-faulted arena.
+ *
+ * @param page_size size of the hugepages backing the arena
+ * (@ref UMEM_HUGEPAGE_2M or @ref UMEM_HUGEPAGE_1G), or 0 to use normal pages;
+ * if hugepages cannot be reserved, the arena falls back to normal pages
+ * with transparent hugepages advised
+ * @param numa_node NUMA node to bind the arena to, or -1 for the default
+ * memory policy
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the number of buffers to
+ * carve in the arena for the pool (unsigned int); larger buffers will be
+ * directly managed with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_hugepage_mgr_alloc(size_t page_size, int numa_node,
+                                         size_t pool0_size,
+                                         size_t nb_pools, ...)
+{
+    assert(!(page_size & (page_size - 1)));
+    assert(!(pool0_size & (pool0_size - 1)));
+
+    size_t alloc_size = sizeof(struct umem_hugepage_mgr) +
+                        sizeof(struct ulifo) * nb_pools;
+    size_t arena_size = 0;
+    unsigned int pools_depths[nb_pools];
+    va_list args;
+    va_start(args, nb_pools);
+    for (unsigned int i = 0; i < nb_pools; i++) {
+        pools_depths[i] = va_arg(args, unsigned int);
+        assert(pools_depths[i] <= UINT16_MAX);
+        alloc_size += ulifo_sizeof(pools_depths[i]);
+        arena_size += (pool0_size << i) * pools_depths[i];
+    }
+    va_end(args);
+
+    struct umem_hugepage_mgr *hp_mgr = malloc(alloc_size);
+    if (unlikely(hp_mgr == NULL))
+        return NULL;
+
+    hp_mgr->pool0_size = pool0_size;
+    hp_mgr->nb_pools = nb_pools;
+    hp_mgr->arena = NULL;
+    hp_mgr->arena_size = arena_size;
+    if (arena_size && unlikely(!umem_hugepage_map(hp_mgr, page_size,
+                                                  numa_node))) {
+        if (hp_mgr->arena != NULL)
+            munmap(hp_mgr->arena, hp_mgr->arena_size);
+        free(hp_mgr);
+        return NULL;
+    }
+
+    void *extra = (void *)hp_mgr + sizeof(struct umem_hugepage_mgr) +
+                  sizeof(struct ulifo) * nb_pools;
+    /* carve the largest buffers first so that all buffers are naturally
+     * aligned on their size */
+    uint8_t *buffer = hp_mgr->arena;
+    for (int i = nb_pools - 1; i >= 0; i--) {
+        void *pool_extra = extra;
+        for (int j = 0; j < i; j++)
+            pool_extra += ulifo_sizeof(pools_depths[j]);
+        ulifo_init(&hp_mgr->pools[i], pools_depths[i], pool_extra);
+        for (unsigned int j = 0; j < pools_depths[i]; j++) {
+            ulifo_push(&hp_mgr->pools[i], buffer);
+            buffer += pool0_size << i;
+        }
+    }
+
+    urefcount_init(umem_hugepage_mgr_to_urefcount(hp_mgr),
+                   umem_hugepage_mgr_free);
+    hp_mgr->mgr.refcount = umem_hugepage_mgr_to_urefcount(hp_mgr);
+    hp_mgr->mgr.umem_alloc = umem_hugepage_alloc;
+    hp_mgr->mgr.umem_realloc = umem_hugepage_realloc;
+    hp_mgr->mgr.umem_free = umem_hugepage_free;
+    hp_mgr->mgr.umem_mgr_vacuum = NULL;
+    hp_mgr->mgr.umem_mgr_control = NULL;
+
+    return umem_hugepage_mgr_to_umem_mgr(hp_mgr);
+}
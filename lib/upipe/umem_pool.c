@@ -25,6 +25,7 @@
 
 #include "upipe/ubase.h"
 #include "upipe/urefcount.h"
+#include "upipe/uatomic.h"
 #include "upipe/ulifo.h"
 #include "upipe/umem.h"
 #include "upipe/umem_pool.h"
@@ -32,6 +33,30 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <pthread.h>
+
+/** @This defines a per-thread magazine of buffers of a given size. */
+struct umem_pool_magazine {
+    /** number of buffers currently in the magazine */
+    unsigned int count;
+    /** array of 2 * cache_depth buffers */
+    uint8_t **buffers;
+    /** allocation counters of the magazine */
+    struct ualloc_counters counters;
+};
+
+/** @This defines the per-thread cache of a umem pool manager. */
+struct umem_pool_cache {
+    /** next cache in the registry of the manager */
+    struct umem_pool_cache *next;
+    /** pointer to the manager */
+    struct umem_pool_mgr *pool_mgr;
+    /** true once the owner thread has exited, so that another thread may
+     * take over the cache */
+    uatomic_uint32_t dead;
+    /** magazines, one per pool */
+    struct umem_pool_magazine magazines[];
+};
 
 /** @This defines the private data structures of the umem pool manager. */
 struct umem_pool_mgr {
@@ -45,6 +70,16 @@ struct umem_pool_mgr {
     size_t pool0_size;
     /** number of pools of buffers */
     size_t nb_pools;
+    /** number of buffers moved at once between a per-thread magazine and
+     * the shared pool, or 0 if per-thread caches are disabled */
+    unsigned int cache_depth;
+    /** key to the per-thread caches */
+    pthread_key_t cache_key;
+    /** registry of all per-thread caches (struct umem_pool_cache *) */
+    uatomic_ptr_t caches;
+    /** allocation counters of the shared pools, plus one for buffers too
+     * large to be pooled */
+    struct ualloc_counters *counters;
     /** buffer pools */
     struct ulifo pools[];
 };
@@ -75,6 +110,178 @@ static unsigned int umem_pool_find(struct umem_mgr *mgr, size_t wanted,
     return pool;
 }
 
+/** @internal @This flushes buffers from a magazine to the shared pool, or
+ * releases them to the system if the shared pool is full.
+ *
+ * @param pool_mgr pointer to the umem pool manager
+ * @param pool index of the pool
+ * @param magazine pointer to the magazine
+ * @param keep number of buffers to keep in the magazine
+ */
+static void umem_pool_magazine_flush(struct umem_pool_mgr *pool_mgr,
+                                     unsigned int pool,
+                                     struct umem_pool_magazine *magazine,
+                                     unsigned int keep)
+{
+    if (magazine->count <= keep)
+        return;
+    ualloc_counters_take(&magazine->counters, magazine->count - keep);
+
+    while (magazine->count > keep) {
+        uint8_t *buffer = magazine->buffers[--magazine->count];
+        if (likely(ulifo_push(&pool_mgr->pools[pool], buffer)))
+            ualloc_counters_put(&pool_mgr->counters[pool], 1);
+        else {
+            ualloc_counters_overflow(&pool_mgr->counters[pool]);
+            free(buffer);
+        }
+    }
+}
+
+/** @internal @This is called when a thread using a per-thread cache exits.
+ * The buffers are given back to the shared pools, and the structure is
+ * marked dead, to be reused by the next thread needing a cache. It stays in
+ * the registry until the manager is freed, so the registry is bounded by the
+ * maximum number of threads using the manager at the same time.
+ *
+ * @param opaque pointer to the per-thread cache
+ */
+static void umem_pool_cache_exit(void *opaque)
+{
+    struct umem_pool_cache *cache = opaque;
+    struct umem_pool_mgr *pool_mgr = cache->pool_mgr;
+
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++)
+        umem_pool_magazine_flush(pool_mgr, i, &cache->magazines[i], 0);
+    uatomic_store(&cache->dead, 1);
+}
+
+/** @internal @This returns the per-thread cache of the calling thread,
+ * allocating it if needed.
+ *
+ * @param pool_mgr pointer to the umem pool manager
+ * @return pointer to the per-thread cache, or NULL if caches are disabled
+ * or in case of allocation failure
+ */
+static struct umem_pool_cache *
+    umem_pool_cache_get(struct umem_pool_mgr *pool_mgr)
+{
+    if (!pool_mgr->cache_depth)
+        return NULL;
+
+    struct umem_pool_cache *cache = pthread_getspecific(pool_mgr->cache_key);
+    if (likely(cache != NULL))
+        return cache;
+
+    /* take over the cache of an exited thread */
+    for (cache = uatomic_ptr_load_ptr(&pool_mgr->caches,
+                                      struct umem_pool_cache *);
+         cache != NULL; cache = cache->next) {
+        uint32_t dead = 1;
+        if (uatomic_compare_exchange(&cache->dead, &dead, 0)) {
+            if (unlikely(pthread_setspecific(pool_mgr->cache_key,
+                                             cache) != 0)) {
+                uatomic_store(&cache->dead, 1);
+                return NULL;
+            }
+            return cache;
+        }
+    }
+
+    size_t nb_buffers = 2 * pool_mgr->cache_depth;
+    cache = malloc(sizeof(struct umem_pool_cache) +
+                   pool_mgr->nb_pools * (sizeof(struct umem_pool_magazine) +
+                                         nb_buffers * sizeof(uint8_t *)));
+    if (unlikely(cache == NULL))
+        return NULL;
+
+    cache->pool_mgr = pool_mgr;
+    uatomic_init(&cache->dead, 0);
+    uint8_t **buffers = (uint8_t **)&cache->magazines[pool_mgr->nb_pools];
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+        cache->magazines[i].count = 0;
+        cache->magazines[i].buffers = buffers;
+        ualloc_counters_init(&cache->magazines[i].counters);
+        buffers += nb_buffers;
+    }
+
+    if (unlikely(pthread_setspecific(pool_mgr->cache_key, cache) != 0)) {
+        free(cache);
+        return NULL;
+    }
+
+    struct umem_pool_cache *head =
+        uatomic_ptr_load_ptr(&pool_mgr->caches, struct umem_pool_cache *);
+    do {
+        cache->next = head;
+    } while (unlikely(!uatomic_ptr_compare_exchange_ptr(&pool_mgr->caches,
+                                                        &head, cache)));
+    return cache;
+}
+
+/** @internal @This pops a buffer of the given pool, first from the
+ * per-thread cache if enabled, refilling it from the shared pool if it is
+ * empty.
+ *
+ * @param pool_mgr pointer to the umem pool manager
+ * @param pool index of the pool
+ * @return pointer to a buffer, or NULL if none is available
+ */
+static uint8_t *umem_pool_pop(struct umem_pool_mgr *pool_mgr,
+                              unsigned int pool)
+{
+    struct umem_pool_cache *cache = umem_pool_cache_get(pool_mgr);
+    if (cache == NULL) {
+        uint8_t *buffer = ulifo_pop(&pool_mgr->pools[pool], uint8_t *);
+        if (likely(buffer != NULL))
+            ualloc_counters_hit(&pool_mgr->counters[pool], 1);
+        return buffer;
+    }
+
+    struct umem_pool_magazine *magazine = &cache->magazines[pool];
+    if (unlikely(!magazine->count)) {
+        uint8_t *buffer;
+        while (magazine->count < pool_mgr->cache_depth &&
+               (buffer = ulifo_pop(&pool_mgr->pools[pool], uint8_t *)) != NULL)
+            magazine->buffers[magazine->count++] = buffer;
+        if (unlikely(!magazine->count))
+            return NULL;
+        ualloc_counters_take(&pool_mgr->counters[pool], magazine->count);
+        ualloc_counters_put(&magazine->counters, magazine->count);
+    }
+    ualloc_counters_hit(&magazine->counters, 1);
+    return magazine->buffers[--magazine->count];
+}
+
+/** @internal @This pushes a buffer to the given pool, first to the
+ * per-thread cache if enabled, flushing half of it to the shared pool if it
+ * is full.
+ *
+ * @param pool_mgr pointer to the umem pool manager
+ * @param pool index of the pool
+ * @param buffer pointer to the buffer
+ * @return false if the buffer couldn't be kept
+ */
+static bool umem_pool_push(struct umem_pool_mgr *pool_mgr, unsigned int pool,
+                           uint8_t *buffer)
+{
+    struct umem_pool_cache *cache = umem_pool_cache_get(pool_mgr);
+    if (cache == NULL) {
+        if (unlikely(!ulifo_push(&pool_mgr->pools[pool], buffer)))
+            return false;
+        ualloc_counters_put(&pool_mgr->counters[pool], 1);
+        return true;
+    }
+
+    struct umem_pool_magazine *magazine = &cache->magazines[pool];
+    if (unlikely(magazine->count >= 2 * pool_mgr->cache_depth))
+        umem_pool_magazine_flush(pool_mgr, pool, magazine,
+                                 pool_mgr->cache_depth);
+    magazine->buffers[magazine->count++] = buffer;
+    ualloc_counters_put(&magazine->counters, 1);
+    return true;
+}
+
 /** @This allocates a new umem buffer space.
  *
  * @param mgr management structure
@@ -92,9 +299,11 @@ static bool umem_pool_alloc(struct umem_mgr *mgr, struct umem *umem,
     uint8_t *buffer = NULL;
 
     if (likely(pool < pool_mgr->nb_pools))
-        buffer = ulifo_pop(&pool_mgr->pools[pool], uint8_t *);
-    if (unlikely(buffer == NULL))
+        buffer = umem_pool_pop(pool_mgr, pool);
+    if (unlikely(buffer == NULL)) {
+        ualloc_counters_miss(&pool_mgr->counters[pool]);
         buffer = malloc(real_size);
+    }
     if (unlikely(buffer == NULL))
         return false;
 
@@ -118,8 +327,10 @@ static void umem_pool_free(struct umem *umem)
     unsigned int pool = umem_pool_find(umem->mgr, umem->real_size, NULL);
 
     if (unlikely(pool >= pool_mgr->nb_pools ||
-                 !ulifo_push(&pool_mgr->pools[pool], umem->buffer)))
+                 !umem_pool_push(pool_mgr, pool, umem->buffer))) {
+        ualloc_counters_overflow(&pool_mgr->counters[pool]);
         free(umem->buffer);
+    }
     umem->buffer = NULL;
     umem->mgr = NULL;
 }
@@ -150,7 +361,10 @@ static bool umem_pool_realloc(struct umem *umem, size_t new_size)
 }
 
 /** @This instructs an existing umem manager to release all structures
- * currently kept in pools. It is intended as a debug tool only.
+ * currently kept in pools. It is intended as a debug tool only. Only the
+ * per-thread cache of the calling thread is released: the magazines of the
+ * other live threads are owned by them and are not reclaimed, while those of
+ * exited threads were already flushed to the shared pools.
  *
  * @param mgr pointer to umem manager
  */
@@ -158,10 +372,73 @@ static void umem_pool_mgr_vacuum(struct umem_mgr *mgr)
 {
     struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(mgr);
 
+    if (pool_mgr->cache_depth) {
+        struct umem_pool_cache *cache =
+            pthread_getspecific(pool_mgr->cache_key);
+        if (cache != NULL)
+            for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+                struct umem_pool_magazine *magazine = &cache->magazines[i];
+                ualloc_counters_take(&magazine->counters, magazine->count);
+                while (magazine->count)
+                    free(magazine->buffers[--magazine->count]);
+            }
+    }
+
     for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
         uint8_t *buffer;
-        while ((buffer = ulifo_pop(&pool_mgr->pools[i], uint8_t *)) != NULL)
+        while ((buffer = ulifo_pop(&pool_mgr->pools[i], uint8_t *)) != NULL) {
+            ualloc_counters_take(&pool_mgr->counters[i], 1);
             free(buffer);
+        }
+    }
+}
+
+/** @internal @This returns the allocation statistics of the manager. In
+ * case per-thread caches are used, the high-water mark is the sum of the
+ * marks of the shared pools and of the magazines, and is an upper bound.
+ *
+ * @param pool_mgr pointer to the umem pool manager
+ * @param stats filled in with the allocation statistics
+ * @return an error code
+ */
+static int umem_pool_mgr_get_stats(struct umem_pool_mgr *pool_mgr,
+                                   struct ualloc_stats *stats)
+{
+    assert(stats != NULL);
+    ualloc_stats_init(stats);
+    for (unsigned int i = 0; i < pool_mgr->nb_pools; i++)
+        ualloc_counters_add(stats, &pool_mgr->counters[i],
+                            pool_mgr->pool0_size << i);
+    ualloc_counters_add(stats, &pool_mgr->counters[pool_mgr->nb_pools], 0);
+
+    struct umem_pool_cache *cache =
+        uatomic_ptr_load_ptr(&pool_mgr->caches, struct umem_pool_cache *);
+    for ( ; cache != NULL; cache = cache->next)
+        for (unsigned int i = 0; i < pool_mgr->nb_pools; i++)
+            ualloc_counters_add(stats, &cache->magazines[i].counters,
+                                pool_mgr->pool0_size << i);
+    return UBASE_ERR_NONE;
+}
+
+/** @This processes control commands on a umem pool manager.
+ *
+ * @param mgr pointer to umem manager
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int umem_pool_mgr_control(struct umem_mgr *mgr,
+                                 int command, va_list args)
+{
+    struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_umem_mgr(mgr);
+
+    switch (command) {
+        case UMEM_MGR_GET_STATS: {
+            struct ualloc_stats *stats = va_arg(args, struct ualloc_stats *);
+            return umem_pool_mgr_get_stats(pool_mgr, stats);
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
     }
 }
 
@@ -172,39 +449,61 @@ static void umem_pool_mgr_vacuum(struct umem_mgr *mgr)
 static void umem_pool_mgr_free(struct urefcount *urefcount)
 {
     struct umem_pool_mgr *pool_mgr = umem_pool_mgr_from_urefcount(urefcount);
+
+    if (pool_mgr->cache_depth) {
+        pthread_key_delete(pool_mgr->cache_key);
+        struct umem_pool_cache *cache =
+            uatomic_ptr_load_ptr(&pool_mgr->caches, struct umem_pool_cache *);
+        while (cache != NULL) {
+            struct umem_pool_cache *next = cache->next;
+            for (unsigned int i = 0; i < pool_mgr->nb_pools; i++) {
+                struct umem_pool_magazine *magazine = &cache->magazines[i];
+                while (magazine->count)
+                    free(magazine->buffers[--magazine->count]);
+                ualloc_counters_clean(&magazine->counters);
+            }
+            uatomic_clean(&cache->dead);
+            free(cache);
+            cache = next;
+        }
+    }
+    uatomic_ptr_clean(&pool_mgr->caches);
+
     umem_pool_mgr_vacuum(umem_pool_mgr_to_umem_mgr(pool_mgr));
 
     for (unsigned int i = 0; i < pool_mgr->nb_pools; i++)
         ulifo_clean(&pool_mgr->pools[i]);
+    for (unsigned int i = 0; i <= pool_mgr->nb_pools; i++)
+        ualloc_counters_clean(&pool_mgr->counters[i]);
 
     urefcount_clean(urefcount);
     free(pool_mgr);
 }
 
-/** @This allocates a new instance of the umem pool manager allocating buffers
- * from application memory, using pools in power of 2's.
+/** @internal @This allocates a new instance of the umem pool manager
+ * allocating buffers from application memory, using pools in power of 2's.
  *
  * @param pool0_size size (in octets) of the smallest allocatable buffer; it
  * must be a power of 2
- * @param nb_pools number of buffer pools to maintain, with sizes in power of
- * 2's increments, followed, for each pool, by the maximum number of buffers
- * to keep in the pool (unsigned int); larger buffers will be directly managed
- * with malloc() and free()
+ * @param cache_depth number of buffers moved at once between per-thread
+ * magazines and the shared pools, or 0 to disable per-thread caches
+ * @param nb_pools number of buffer pools to maintain
+ * @param args list of maximum number of buffers to keep in each pool
  * @return pointer to manager, or NULL in case of error
  */
-struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
+static struct umem_mgr *umem_pool_mgr_alloc_va(size_t pool0_size,
+                                               unsigned int cache_depth,
+                                               size_t nb_pools, va_list args)
 {
     size_t alloc_size = sizeof(struct umem_pool_mgr) +
                         sizeof(struct ulifo) * nb_pools;
     unsigned int pools_depths[nb_pools];
-    va_list args;
-    va_start(args, nb_pools);
     for (unsigned int i = 0; i < nb_pools; i++) {
         pools_depths[i] = va_arg(args, unsigned int);
         assert(pools_depths[i] <= UINT16_MAX);
         alloc_size += ulifo_sizeof(pools_depths[i]);
     }
-    va_end(args);
+    alloc_size += sizeof(struct ualloc_counters) * (nb_pools + 1);
 
     struct umem_pool_mgr *pool_mgr = malloc(alloc_size);
     if (unlikely(pool_mgr == NULL))
@@ -212,6 +511,14 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
 
     pool_mgr->pool0_size = pool0_size;
     pool_mgr->nb_pools = nb_pools;
+    pool_mgr->cache_depth = cache_depth;
+    if (cache_depth &&
+        unlikely(pthread_key_create(&pool_mgr->cache_key,
+                                    umem_pool_cache_exit) != 0)) {
+        free(pool_mgr);
+        return NULL;
+    }
+    uatomic_ptr_init(&pool_mgr->caches, NULL);
 
     void *extra = (void *)pool_mgr + sizeof(struct umem_pool_mgr) +
                   sizeof(struct ulifo) * nb_pools;
@@ -221,26 +528,82 @@ struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
         extra += ulifo_sizeof(pools_depths[i]);
     }
 
+    pool_mgr->counters = extra;
+    for (unsigned int i = 0; i <= nb_pools; i++)
+        ualloc_counters_init(&pool_mgr->counters[i]);
+
     urefcount_init(umem_pool_mgr_to_urefcount(pool_mgr), umem_pool_mgr_free);
     pool_mgr->mgr.refcount = umem_pool_mgr_to_urefcount(pool_mgr);
     pool_mgr->mgr.umem_alloc = umem_pool_alloc;
     pool_mgr->mgr.umem_realloc = umem_pool_realloc;
     pool_mgr->mgr.umem_free = umem_pool_free;
     pool_mgr->mgr.umem_mgr_vacuum = umem_pool_mgr_vacuum;
+    pool_mgr->mgr.umem_mgr_control = umem_pool_mgr_control;
 
     return umem_pool_mgr_to_umem_mgr(pool_mgr);
 }
 
 /** @This allocates a new instance of the umem pool manager allocating buffers
- * from application memory, using pools in power of 2's, with a simpler API.
+ * from application memory, using pools in power of 2's.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to keep in the pool (unsigned int); larger buffers will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc(size_t pool0_size, size_t nb_pools, ...)
+{
+    va_list args;
+    va_start(args, nb_pools);
+    struct umem_mgr *mgr = umem_pool_mgr_alloc_va(pool0_size, 0, nb_pools,
+                                                  args);
+    va_end(args);
+    return mgr;
+}
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using pools in power of 2's, and keeping a small
+ * magazine of buffers per thread and per pool in front of the shared pools.
+ *
+ * @param pool0_size size (in octets) of the smallest allocatable buffer; it
+ * must be a power of 2
+ * @param cache_depth number of buffers moved at once between a per-thread
+ * magazine and the shared pool (a magazine holds up to twice this number)
+ * @param nb_pools number of buffer pools to maintain, with sizes in power of
+ * 2's increments, followed, for each pool, by the maximum number of buffers
+ * to keep in the pool (unsigned int); larger buffers will be directly managed
+ * with malloc() and free()
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_cached(size_t pool0_size,
+                                            unsigned int cache_depth,
+                                            size_t nb_pools, ...)
+{
+    va_list args;
+    va_start(args, nb_pools);
+    struct umem_mgr *mgr = umem_pool_mgr_alloc_va(pool0_size, cache_depth,
+                                                  nb_pools, args);
+    va_end(args);
+    return mgr;
+}
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using pools in power of 2's, with a simpler API,
+ * and keeping a small magazine of buffers per thread and per pool.
  *
  * @param base_pools_depth number of buffers to keep in the pool for the smaller
  * buffers; for larger buffers the same number is used, divided by 2, 4, or 8
+ * @param cache_depth number of buffers moved at once between a per-thread
+ * magazine and the shared pool, or 0 to disable per-thread caches
  * @return pointer to manager, or NULL in case of error
  */
-struct umem_mgr *umem_pool_mgr_alloc_simple(uint16_t base_pools_depth)
+struct umem_mgr *umem_pool_mgr_alloc_simple_cached(uint16_t base_pools_depth,
+                                                   unsigned int cache_depth)
 {
-    return umem_pool_mgr_alloc(32, 18,
+    return umem_pool_mgr_alloc_cached(32, cache_depth, 18,
                                base_pools_depth, /* 32 */
                                base_pools_depth, /* 64 */
                                base_pools_depth, /* 128 */
@@ -260,3 +623,15 @@ struct umem_mgr *umem_pool_mgr_alloc_simple(uint16_t base_pools_depth)
                                base_pools_depth / 8, /* 2 Mi */
                                base_pools_depth / 8); /* 4 Mi */
 }
+
+/** @This allocates a new instance of the umem pool manager allocating buffers
+ * from application memory, using pools in power of 2's, with a simpler API.
+ *
+ * @param base_pools_depth number of buffers to keep in the pool for the smaller
+ * buffers; for larger buffers the same number is used, divided by 2, 4, or 8
+ * @return pointer to manager, or NULL in case of error
+ */
+struct umem_mgr *umem_pool_mgr_alloc_simple(uint16_t base_pools_depth)
+{
+    return umem_pool_mgr_alloc_simple_cached(base_pools_depth, 0);
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe global registry of shared managers
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/urefcount.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+#include "upipe/umgr_registry.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/** @internal @This is a registered manager. */
+struct umgr_registry_entry {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** pointer to the manager */
+    void *mgr;
+    /** refcount management structure of the manager */
+    struct urefcount *refcount;
+    /** name of the manager */
+    char name[];
+};
+
+UBASE_FROM_TO(umgr_registry_entry, uchain, uchain, uchain)
+
+/** @internal @This protects the registry. */
+static pthread_mutex_t umgr_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+/** @internal @This is the list of registered managers. */
+static struct uchain umgr_registry_list =
+    { &umgr_registry_list, &umgr_registry_list };
+
+/** @internal @This looks up a registered manager. The lock must be held.
+ *
+ * @param name name of the manager
+ * @return pointer to the registered entry, or NULL
+ */
+static struct umgr_registry_entry *umgr_registry_find(const char *name)
+{
+    struct uchain *uchain;
+    ulist_foreach (&umgr_registry_list, uchain) {
+        struct umgr_registry_entry *entry =
+            umgr_registry_entry_from_uchain(uchain);
+        if (!strcmp(entry->name, name))
+            return entry;
+    }
+    return NULL;
+}
+
+/** @This returns the manager registered under a name, allocating it on first
+ * use. This function is thread-safe.
+ *
+ * @param name name of the manager
+ * @param alloc function allocating the manager
+ * @param opaque opaque passed to alloc
+ * @return pointer to the manager, with a new reference for the caller, or
+ * NULL in case of error
+ */
+void *umgr_registry_get(const char *name, umgr_registry_alloc alloc,
+                        void *opaque)
+{
+    pthread_mutex_lock(&umgr_registry_lock);
+    struct umgr_registry_entry *entry = umgr_registry_find(name);
+    if (entry != NULL) {
+        urefcount_use(entry->refcount);
+        void *mgr = entry->mgr;
+        pthread_mutex_unlock(&umgr_registry_lock);
+        return mgr;
+    }
+    pthread_mutex_unlock(&umgr_registry_lock);
+
+    /* allocate outside of the lock, as the manager may itself use other
+     * registered managers */
+    size_t len = strlen(name);
+    struct umgr_registry_entry *new_entry =
+        malloc(sizeof(*new_entry) + len + 1);
+    if (unlikely(new_entry == NULL))
+        return NULL;
+    new_entry->refcount = NULL;
+    new_entry->mgr = alloc(opaque, &new_entry->refcount);
+    if (unlikely(new_entry->mgr == NULL)) {
+        free(new_entry);
+        return NULL;
+    }
+    memcpy(new_entry->name, name, len + 1);
+    uchain_init(&new_entry->uchain);
+
+    pthread_mutex_lock(&umgr_registry_lock);
+    entry = umgr_registry_find(name);
+    if (entry == NULL) {
+        entry = new_entry;
+        new_entry = NULL;
+        ulist_add(&umgr_registry_list, &entry->uchain);
+    }
+    urefcount_use(entry->refcount);
+    void *mgr = entry->mgr;
+    pthread_mutex_unlock(&umgr_registry_lock);
+
+    if (new_entry != NULL) {
+        /* another thread registered the manager first */
+        urefcount_release(new_entry->refcount);
+        free(new_entry);
+    }
+    return mgr;
+}
+
+/** @internal @This allocates a registered upipe manager.
+ *
+ * @param opaque pointer to the allocation function
+ * @param refcount_p filled in with the refcount management structure
+ * @return pointer to the manager
+ */
+static void *umgr_registry_alloc_upipe_mgr(void *opaque,
+                                           struct urefcount **refcount_p)
+{
+    struct upipe_mgr *(**alloc)(void) = opaque;
+    struct upipe_mgr *mgr = (*alloc)();
+    if (mgr != NULL)
+        *refcount_p = mgr->refcount;
+    return mgr;
+}
+
+/** @This returns the upipe manager registered under a name, allocating it
+ * on first use. This function is thread-safe.
+ *
+ * @param name name of the manager
+ * @param alloc function allocating the manager, for instance
+ * upipe_ts_demux_mgr_alloc
+ * @return pointer to the manager, to release with upipe_mgr_release, or NULL
+ * in case of error
+ */
+struct upipe_mgr *umgr_registry_upipe_mgr(const char *name,
+                                          struct upipe_mgr *(*alloc)(void))
+{
+    return umgr_registry_get(name, umgr_registry_alloc_upipe_mgr, &alloc);
+}
+
+/** @internal @This allocates the shared umem manager.
+ *
+ * @param opaque unused
+ * @param refcount_p filled in with the refcount management structure
+ * @return pointer to the manager
+ */
+static void *umgr_registry_alloc_umem_mgr(void *opaque,
+                                          struct urefcount **refcount_p)
+{
+    struct umem_mgr *mgr = umem_alloc_mgr_alloc();
+    if (mgr != NULL)
+        *refcount_p = mgr->refcount;
+    return mgr;
+}
+
+/** @This returns the shared umem manager (using malloc()).
+ *
+ * @return pointer to the manager, to release with umem_mgr_release, or NULL
+ * in case of error
+ */
+struct umem_mgr *umgr_registry_umem_mgr(void)
+{
+    return umgr_registry_get("umem_alloc", umgr_registry_alloc_umem_mgr,
+                             NULL);
+}
+
+/** @internal @This allocates the shared udict manager.
+ *
+ * @param opaque unused
+ * @param refcount_p filled in with the refcount management structure
+ * @return pointer to the manager
+ */
+static void *umgr_registry_alloc_udict_mgr(void *opaque,
+                                           struct urefcount **refcount_p)
+{
+    struct umem_mgr *umem_mgr = umgr_registry_umem_mgr();
+    if (unlikely(umem_mgr == NULL))
+        return NULL;
+    struct udict_mgr *mgr =
+        udict_inline_mgr_alloc(UMGR_REGISTRY_UDICT_POOL_DEPTH, umem_mgr,
+                               -1, -1);
+    umem_mgr_release(umem_mgr);
+    if (mgr != NULL)
+        *refcount_p = mgr->refcount;
+    return mgr;
+}
+
+/** @This returns the shared inline udict manager.
+ *
+ * @return pointer to the manager, to release with udict_mgr_release, or NULL
+ * in case of error
+ */
+struct udict_mgr *umgr_registry_udict_mgr(void)
+{
+    return umgr_registry_get("udict_inline", umgr_registry_alloc_udict_mgr,
+                             NULL);
+}
+
+/** @internal @This allocates the shared uref manager.
+ *
+ * @param opaque unused
+ * @param refcount_p filled in with the refcount management structure
+ * @return pointer to the manager
+ */
+static void *umgr_registry_alloc_uref_mgr(void *opaque,
+                                          struct urefcount **refcount_p)
+{
+    struct udict_mgr *udict_mgr = umgr_registry_udict_mgr();
+    if (unlikely(udict_mgr == NULL))
+        return NULL;
+    struct uref_mgr *mgr =
+        uref_std_mgr_alloc(UMGR_REGISTRY_UREF_POOL_DEPTH, udict_mgr, 0);
+    udict_mgr_release(udict_mgr);
+    if (mgr != NULL)
+        *refcount_p = mgr->refcount;
+    return mgr;
+}
+
+/** @This returns the shared standard uref manager.
+ *
+ * @return pointer to the manager, to release with uref_mgr_release, or NULL
+ * in case of error
+ */
+struct uref_mgr *umgr_registry_uref_mgr(void)
+{
+    return umgr_registry_get("uref_std", umgr_registry_alloc_uref_mgr, NULL);
+}
+
+/** @This releases the references held by the registry. Managers still used
+ * by pipelines are only freed when they are released. Later calls allocate
+ * new managers.
+ */
+void umgr_registry_clean(void)
+{
+    struct uchain list;
+    ulist_init(&list);
+
+    pthread_mutex_lock(&umgr_registry_lock);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&umgr_registry_list)) != NULL)
+        ulist_add(&list, uchain);
+    pthread_mutex_unlock(&umgr_registry_lock);
+
+    /* release outside of the lock, as freeing a manager may release other
+     * registered managers */
+    while ((uchain = ulist_pop(&list)) != NULL) {
+        struct umgr_registry_entry *entry =
+            umgr_registry_entry_from_uchain(uchain);
+        urefcount_release(entry->refcount);
+        free(entry);
+    }
+}
@@ -32,9 +32,12 @@
 #include "upipe/ubase.h"
 #include "upipe/upipe.h"
 #include "upipe/upipe_dump.h"
+#include "upipe/upipe_stats.h"
 #include "upipe/uprobe_prefix.h"
+#include "upipe/upump.h"
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <assert.h>
 
 /** @This is a structure allocated per pipe. */
@@ -56,8 +59,9 @@ UBASE_FROM_TO(upipe_dump_ctx, uchain, uchain, uchain)
 /** @hidden */
 static void upipe_dump_pipe(upipe_dump_pipe_label pipe_label,
                             upipe_dump_flow_def_label flow_def_label,
-                            FILE *file, struct upipe *upipe, uint64_t *uid_p,
-                            struct uchain *list, struct upipe *last_output);
+                            bool stats, FILE *file, struct upipe *upipe,
+                            uint64_t *uid_p, struct uchain *list,
+                            struct upipe *last_output);
 
 /** @This converts a pipe to a label (default function).
  *
@@ -109,6 +113,92 @@ char *upipe_dump_flow_def_label_default(struct uref *flow_def)
     return string;
 }
 
+/** @internal @This appends a formatted string to a label.
+ *
+ * @param label allocated label, freed by this function
+ * @param format format of the string to append, followed by its arguments
+ * @return allocated string
+ */
+static char *upipe_dump_append(char *label, const char *format, ...)
+{
+    char *append, *string;
+    va_list args;
+    va_start(args, format);
+    int err = vasprintf(&append, format, args);
+    va_end(args);
+    if (err == -1)
+        return label;
+    if (asprintf(&string, "%s%s", label, append) == -1)
+        string = label;
+    else
+        free(label);
+    free(append);
+    return string;
+}
+
+/** @internal @This appends the statistics of a pipe to its label, and
+ * returns a fill color showing the share of a CPU it takes.
+ *
+ * @param upipe upipe structure
+ * @param label allocated label, freed by this function
+ * @param color filled in with the fill color attribute, or left unchanged
+ * @return allocated string
+ */
+static char *upipe_dump_stats_label(struct upipe *upipe, char *label,
+                                    char color[32])
+{
+    struct upipe_stats stats;
+    if (label == NULL || !ubase_check(upipe_get_stats(upipe, &stats)))
+        return label;
+
+    if (stats.duration) {
+        uint64_t self = stats.time - stats.children_time;
+        double load = (double)self / stats.duration;
+        label = upipe_dump_append(label,
+                "\\n%"PRIu64" urefs/s, %"PRIu64" kbit/s"
+                "\\nself %.1f%%, avg %.1f us, max %.1f us",
+                upipe_stats_rate(&stats, stats.urefs),
+                upipe_stats_rate(&stats, stats.octets) * 8 / 1000,
+                load * 100.,
+                stats.urefs ? (double)stats.time * 1000000 / UCLOCK_FREQ /
+                              stats.urefs : 0.,
+                (double)stats.max_time * 1000000 / UCLOCK_FREQ);
+        if (stats.thread)
+            label = upipe_dump_append(label, "\\nthread %"PRIu64", %p",
+                                      stats.thread, stats.upump_mgr);
+
+        /* from light grey when idle to red at half a CPU */
+        double heat = load * 2 > 1. ? 1. : load * 2;
+        snprintf(color, 32, ", fillcolor=\"#%02x%02x%02x\"",
+                 (unsigned int)(0xf6 + (0xff - 0xf6) * heat),
+                 (unsigned int)(0xf6 - (0xf6 - 0x30) * heat),
+                 (unsigned int)(0xf6 - (0xf6 - 0x30) * heat));
+    }
+    if (stats.queue_length != UINT64_MAX)
+        label = upipe_dump_append(label, "\\nqueue %"PRIu64,
+                                  stats.queue_length);
+    return label;
+}
+
+/** @internal @This appends the input rate of the output of an edge to its
+ * label.
+ *
+ * @param output output pipe of the edge
+ * @param label allocated label, freed by this function
+ * @return allocated string
+ */
+static char *upipe_dump_stats_edge(struct upipe *output, char *label)
+{
+    struct upipe_stats stats;
+    if (label == NULL || !ubase_check(upipe_stats_collect(output, &stats)) ||
+        !stats.duration)
+        return label;
+    return upipe_dump_append(label,
+                             "%"PRIu64" urefs/s\\l%"PRIu64" kbit/s\\l",
+                             upipe_stats_rate(&stats, stats.urefs),
+                             upipe_stats_rate(&stats, stats.octets) * 8 / 1000);
+}
+
 /** @internal @This finds in the list of a pipe has already been printed.
  *
  * @param upipe first pipe of the pipeline
@@ -129,6 +219,7 @@ static bool upipe_dump_find(struct upipe *upipe, struct uchain *list)
  *
  * @param pipe_label function to print pipe labels
  * @param flow_def_label function to print flow_def labels
+ * @param stats true to annotate the graph with the statistics of the pipes
  * @param file file pointer to write to
  * @param upipe upipe to dump
  * @param uid_p pointer to unique ID
@@ -137,13 +228,17 @@ static bool upipe_dump_find(struct upipe *upipe, struct uchain *list)
  */
 static void upipe_dump_pipe(upipe_dump_pipe_label pipe_label,
                             upipe_dump_flow_def_label flow_def_label,
-                            FILE *file, struct upipe *upipe, uint64_t *uid_p,
-                            struct uchain *list, struct upipe *last_output)
+                            bool stats, FILE *file, struct upipe *upipe,
+                            uint64_t *uid_p, struct uchain *list,
+                            struct upipe *last_output)
 {
     if (upipe_dump_find(upipe, list))
         return;
 
     char *label = pipe_label(upipe);
+    char color[32] = "";
+    if (stats)
+        label = upipe_dump_stats_label(upipe, label, color);
 
     /* Prepare context. */
     struct upipe_dump_ctx *ctx = malloc(sizeof(struct upipe_dump_ctx));
@@ -158,7 +253,7 @@ static void upipe_dump_pipe(upipe_dump_pipe_label pipe_label,
     /* Iterate over subpipes. */
     struct upipe *sub = NULL;
     while (ubase_check(upipe_iterate_sub(upipe, &sub)) && sub != NULL) {
-        upipe_dump_pipe(pipe_label, flow_def_label, file, sub,
+        upipe_dump_pipe(pipe_label, flow_def_label, stats, file, sub,
                         uid_p, list, last_output);
 
         struct upipe_dump_ctx *sub_ctx =
@@ -191,10 +286,10 @@ static void upipe_dump_pipe(upipe_dump_pipe_label pipe_label,
         fprintf(file, "pipe%"PRIu64" [label=\"output\", style=\"dashed,filled\"];\n",
                 ctx->output_uid);
 
-        upipe_dump_pipe(pipe_label, flow_def_label, file, first_inner,
-                        uid_p, list, last_inner);
-        upipe_dump_pipe(pipe_label, flow_def_label, file, last_inner,
-                        uid_p, list, last_inner);
+        upipe_dump_pipe(pipe_label, flow_def_label, stats, file,
+                        first_inner, uid_p, list, last_inner);
+        upipe_dump_pipe(pipe_label, flow_def_label, stats, file,
+                        last_inner, uid_p, list, last_inner);
 
         struct upipe_dump_ctx *first_ctx =
                 upipe_get_opaque(first_inner, struct upipe_dump_ctx *);
@@ -208,7 +303,8 @@ static void upipe_dump_pipe(upipe_dump_pipe_label pipe_label,
 
     } else {
         ctx->output_uid = ctx->input_uid;
-        fprintf(file, "pipe%"PRIu64" [label=\"%s\"];\n", ctx->input_uid, label);
+        fprintf(file, "pipe%"PRIu64" [label=\"%s\"%s];\n", ctx->input_uid,
+                label, color);
     }
     upipe_bin_thaw(upipe);
     free(label);
@@ -222,12 +318,14 @@ static void upipe_dump_pipe(upipe_dump_pipe_label pipe_label,
     if (output == NULL)
         goto upipe_dump_pipe_end;
 
-    upipe_dump_pipe(pipe_label, flow_def_label, file, output,
+    upipe_dump_pipe(pipe_label, flow_def_label, stats, file, output,
                     uid_p, list, last_output);
 
     struct uref *flow_def = NULL;
     upipe_get_flow_def(upipe, &flow_def);
     label = flow_def_label(flow_def);
+    if (stats)
+        label = upipe_dump_stats_edge(output, label);
 
     struct upipe_dump_ctx *output_ctx =
             upipe_get_opaque(output, struct upipe_dump_ctx *);
@@ -239,76 +337,136 @@ upipe_dump_pipe_end:
     fprintf(file, "#end pipe%"PRIu64"\n", ctx->input_uid);
 }
 
-/** @This dumps a pipeline in dot format.
+/** @internal @This starts the dump of a pipeline.
  *
- * @param pipe_label function to print pipe labels
- * @param flow_def_label function to print flow_def labels
  * @param file file pointer to write to
- * @param ulist list of sources pipes in ulist format
- * @param args list of sources pipes terminated with NULL
  */
-void upipe_dump_va(upipe_dump_pipe_label pipe_label,
-                   upipe_dump_flow_def_label flow_def_label,
-                   FILE *file, struct uchain *ulist, va_list args)
+static void upipe_dump_begin(FILE *file)
 {
-    pipe_label = pipe_label ?: upipe_dump_upipe_label_default;
-    flow_def_label = flow_def_label ?: upipe_dump_flow_def_label_default;
-
-    uint64_t uid = 0;
-    struct uchain list;
-    struct uchain *uchain, *uchain_tmp;
-    ulist_init(&list);
-
     fprintf(file, "digraph \"upipe dump\" {\n");
     fprintf(file, "graph [bgcolor=\"#00000000\", fontname=\"Arial\", fontsize=10, fontcolor=\"#0e0e0e\"];\n");
     fprintf(file, "edge [penwidth=1, color=\"#0e0e0e\", fontname=\"Arial\", fontsize=7, fontcolor=\"#0e0e0e\"];\n");
     fprintf(file, "node [shape=\"box\", style=\"filled\", color=\"#0e0e0e\", fillcolor=\"#f6f6f6\", fontname=\"Arial\", fontsize=10, fontcolor=\"#0e0e0e\"];\n");
     fprintf(file, "newrank=true;\n"); /* for rank=same */
+}
 
-    if (ulist != NULL) {
-        ulist_foreach (ulist, uchain) {
-            struct upipe *source = upipe_from_uchain(uchain);
-            upipe_dump_pipe(pipe_label, flow_def_label, file, source,
-                            &uid, &list, false);
-        }
-    }
-
-    struct upipe *source;
-    while ((source = va_arg(args, struct upipe *)) != NULL)
-        upipe_dump_pipe(pipe_label, flow_def_label, file, source,
-                        &uid, &list, false);
+/** @internal @This ends the dump of a pipeline, after the sources.
+ *
+ * @param pipe_label function to print pipe labels
+ * @param flow_def_label function to print flow_def labels
+ * @param stats true to annotate the graph with the statistics of the pipes
+ * @param file file pointer to write to
+ * @param uid_p pointer to unique ID
+ * @param list list of already printed pipes
+ */
+static void upipe_dump_end(upipe_dump_pipe_label pipe_label,
+                           upipe_dump_flow_def_label flow_def_label,
+                           bool stats, FILE *file, uint64_t *uid_p,
+                           struct uchain *list)
+{
+    struct uchain *uchain, *uchain_tmp;
 
     /* Walk through the super-pipes that we may have forgotten. */
     fprintf(file, "#super-pipes\n");
     uint64_t last_uid;
     do {
-        last_uid = uid;
-        ulist_foreach (&list, uchain) {
+        last_uid = *uid_p;
+        ulist_foreach (list, uchain) {
             struct upipe *upipe = upipe_dump_ctx_from_uchain(uchain)->upipe;
             struct upipe *super = NULL;
             while (ubase_check(upipe_sub_get_super(upipe, &upipe)) &&
                    upipe != NULL)
                 super = upipe;
             if (super != NULL)
-                upipe_dump_pipe(pipe_label, flow_def_label, file, super,
-                                &uid, &list, false);
+                upipe_dump_pipe(pipe_label, flow_def_label, stats, file,
+                                super, uid_p, list, false);
         }
-    } while (last_uid != uid);
+    } while (last_uid != *uid_p);
 
     fprintf(file, "}\n");
 
     /* Clean up. */
-    ulist_delete_foreach (&list, uchain, uchain_tmp) {
+    ulist_delete_foreach (list, uchain, uchain_tmp) {
         struct upipe_dump_ctx *ctx = upipe_dump_ctx_from_uchain(uchain);
         ctx->upipe->opaque = ctx->original_opaque;
-        uid--;
+        (*uid_p)--;
         if (ctx->output_uid != ctx->input_uid)
-            uid--;
+            (*uid_p)--;
         free(ctx);
     }
-    assert(!uid);
+    assert(!*uid_p);
+}
+
+/** @internal @This dumps a pipeline in dot format.
+ *
+ * @param pipe_label function to print pipe labels
+ * @param flow_def_label function to print flow_def labels
+ * @param stats true to annotate the graph with the statistics of the pipes
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ */
+static void _upipe_dump_va(upipe_dump_pipe_label pipe_label,
+                           upipe_dump_flow_def_label flow_def_label,
+                           bool stats, FILE *file, struct uchain *ulist,
+                           va_list args)
+{
+    pipe_label = pipe_label ?: upipe_dump_upipe_label_default;
+    flow_def_label = flow_def_label ?: upipe_dump_flow_def_label_default;
+
+    uint64_t uid = 0;
+    struct uchain list;
+    struct uchain *uchain;
+    ulist_init(&list);
+
+    upipe_dump_begin(file);
+
+    if (ulist != NULL) {
+        ulist_foreach (ulist, uchain) {
+            struct upipe *source = upipe_from_uchain(uchain);
+            upipe_dump_pipe(pipe_label, flow_def_label, stats, file, source,
+                            &uid, &list, false);
+        }
+    }
+
+    struct upipe *source;
+    while ((source = va_arg(args, struct upipe *)) != NULL)
+        upipe_dump_pipe(pipe_label, flow_def_label, stats, file, source,
+                        &uid, &list, false);
+
+    upipe_dump_end(pipe_label, flow_def_label, stats, file, &uid, &list);
+}
+
+/** @This dumps a pipeline in dot format.
+ *
+ * @param pipe_label function to print pipe labels
+ * @param flow_def_label function to print flow_def labels
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ */
+void upipe_dump_va(upipe_dump_pipe_label pipe_label,
+                   upipe_dump_flow_def_label flow_def_label,
+                   FILE *file, struct uchain *ulist, va_list args)
+{
+    _upipe_dump_va(pipe_label, flow_def_label, false, file, ulist, args);
 }
 
+/** @This dumps a pipeline in dot format, annotated with the statistics of
+ * the pipes.
+ *
+ * @param pipe_label function to print pipe labels
+ * @param flow_def_label function to print flow_def labels
+ * @param file file pointer to write to
+ * @param ulist list of sources pipes in ulist format
+ * @param args list of sources pipes terminated with NULL
+ */
+void upipe_dump_stats_va(upipe_dump_pipe_label pipe_label,
+                         upipe_dump_flow_def_label flow_def_label,
+                         FILE *file, struct uchain *ulist, va_list args)
+{
+    _upipe_dump_va(pipe_label, flow_def_label, true, file, ulist, args);
+}
 
 /** @This opens a file and dumps a pipeline in dot format.
  *
@@ -331,3 +489,113 @@ int upipe_dump_open_va(upipe_dump_pipe_label pipe_label,
     fclose(file);
     return UBASE_ERR_NONE;
 }
+
+/** @This is a watcher dumping a pipeline with its statistics on a signal. */
+struct upipe_dump_watcher {
+    /** signal watcher */
+    struct upump *upump;
+    /** path of the file to write to */
+    char *path;
+    /** list of sources pipes in ulist format, or NULL */
+    struct uchain *ulist;
+    /** number of other source pipes */
+    unsigned int nb_sources;
+    /** other source pipes */
+    struct upipe *sources[];
+};
+
+/** @internal @This dumps the pipeline of a watcher.
+ *
+ * @param upump description structure of the signal watcher
+ */
+static void upipe_dump_watcher_cb(struct upump *upump)
+{
+    struct upipe_dump_watcher *watcher =
+        upump_get_opaque(upump, struct upipe_dump_watcher *);
+    FILE *file = fopen(watcher->path, "w");
+    if (file == NULL)
+        return;
+
+    uint64_t uid = 0;
+    struct uchain list;
+    struct uchain *uchain;
+    ulist_init(&list);
+
+    upipe_dump_begin(file);
+    if (watcher->ulist != NULL) {
+        ulist_foreach (watcher->ulist, uchain) {
+            struct upipe *source = upipe_from_uchain(uchain);
+            upipe_dump_pipe(upipe_dump_upipe_label_default,
+                            upipe_dump_flow_def_label_default, true, file,
+                            source, &uid, &list, false);
+        }
+    }
+    for (unsigned int i = 0; i < watcher->nb_sources; i++)
+        upipe_dump_pipe(upipe_dump_upipe_label_default,
+                        upipe_dump_flow_def_label_default, true, file,
+                        watcher->sources[i], &uid, &list, false);
+    upipe_dump_end(upipe_dump_upipe_label_default,
+                   upipe_dump_flow_def_label_default, true, file, &uid, &list);
+    fclose(file);
+}
+
+/** @This allocates a watcher which dumps a pipeline in dot format, annotated
+ * with the statistics of the pipes, each time the process receives a signal.
+ *
+ * @param upump_mgr event loop to watch the signal on
+ * @param signal signal to watch, for instance SIGUSR1
+ * @param path path of the file to write to
+ * @param ulist list of sources pipes in ulist format, which must outlive the
+ * watcher, or NULL
+ * @param args list of sources pipes terminated with NULL
+ * @return pointer to the watcher, or NULL in case of error
+ */
+struct upipe_dump_watcher *upipe_dump_watcher_alloc_va(
+        struct upump_mgr *upump_mgr, int signal, const char *path,
+        struct uchain *ulist, va_list args)
+{
+    va_list args_copy;
+    unsigned int nb_sources = 0;
+    va_copy(args_copy, args);
+    while (va_arg(args_copy, struct upipe *) != NULL)
+        nb_sources++;
+    va_end(args_copy);
+
+    struct upipe_dump_watcher *watcher =
+        malloc(sizeof(struct upipe_dump_watcher) +
+               nb_sources * sizeof(struct upipe *));
+    if (unlikely(watcher == NULL))
+        return NULL;
+    watcher->path = strdup(path);
+    watcher->upump = upump_alloc_signal(upump_mgr, upipe_dump_watcher_cb,
+                                        watcher, NULL, signal);
+    if (unlikely(watcher->path == NULL || watcher->upump == NULL)) {
+        if (watcher->upump != NULL)
+            upump_free(watcher->upump);
+        free(watcher->path);
+        free(watcher);
+        return NULL;
+    }
+    watcher->ulist = ulist;
+    watcher->nb_sources = nb_sources;
+    for (unsigned int i = 0; i < nb_sources; i++)
+        watcher->sources[i] = upipe_use(va_arg(args, struct upipe *));
+    upump_start(watcher->upump);
+    return watcher;
+}
+
+/** @This frees a watcher, and releases its source pipes.
+ *
+ * @param watcher pointer to the watcher
+ */
+void upipe_dump_watcher_free(struct upipe_dump_watcher *watcher)
+{
+    if (watcher == NULL)
+        return;
+    upump_stop(watcher->upump);
+    upump_free(watcher->upump);
+    for (unsigned int i = 0; i < watcher->nb_sources; i++)
+        upipe_release(watcher->sources[i]);
+    free(watcher->path);
+    free(watcher);
+}
@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short Upipe input statistics of pipes
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+/** @This is the private state of the input statistics of a pipe. */
+struct upipe_stats_state {
+    /** date of the activation */
+    uint64_t start;
+    /** cumulative statistics */
+    struct upipe_stats total;
+
+    /** period of the events, or 0 */
+    uint64_t period;
+    /** date of the beginning of the current period */
+    uint64_t period_start;
+    /** statistics of the current period */
+    struct upipe_stats current;
+
+    /** name of the stage of latency traces, or NULL */
+    char *stage;
+    /** sampling period of the traces started by the pipe, or 0 */
+    unsigned int sample;
+    /** number of untraced urefs since the last trace started */
+    unsigned int sampled;
+    /** true if the traced urefs are reported */
+    bool report;
+};
+
+/** time spent in the input functions of instrumented pipes called from the
+ * input function being measured in this thread */
+static __thread uint64_t upipe_stats_children = 0;
+/** identifier of this thread, or 0 if not yet retrieved */
+static __thread uint64_t upipe_stats_thread = 0;
+
+/** @internal @This returns the identifier of the current thread.
+ *
+ * @return thread identifier
+ */
+static uint64_t upipe_stats_thread_id(void)
+{
+    if (unlikely(!upipe_stats_thread)) {
+#ifdef __linux__
+        upipe_stats_thread = syscall(SYS_gettid);
+#else
+        upipe_stats_thread = (uintptr_t)pthread_self();
+#endif
+    }
+    return upipe_stats_thread;
+}
+
+/** @internal @This returns the monotonic date, in 27 MHz units.
+ *
+ * @return current date
+ */
+static uint64_t upipe_stats_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * UCLOCK_FREQ +
+           ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @internal @This resets statistics.
+ *
+ * @param stats statistics
+ */
+static void upipe_stats_reset(struct upipe_stats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->queue_length = UINT64_MAX;
+}
+
+/** @internal @This accounts for a call to the input function.
+ *
+ * @param stats statistics
+ * @param octets number of octets of the uref
+ * @param time time spent in the input function
+ * @param children_time time spent in the input functions of children
+ */
+static void upipe_stats_account(struct upipe_stats *stats, uint64_t octets,
+                                uint64_t time, uint64_t children_time)
+{
+    stats->urefs++;
+    stats->octets += octets;
+    stats->time += time;
+    stats->children_time += children_time;
+    if (time > stats->max_time)
+        stats->max_time = time;
+}
+
+/** @This enables the input statistics of a pipe, or resets them if they
+ * were already enabled. This must be called from the thread of the pipe.
+ *
+ * @param upipe description structure of the pipe
+ * @param period period of the @ref UPROBE_STATS events, in 27 MHz units,
+ * or 0 to disable the events
+ * @return an error code
+ */
+int upipe_stats_enable(struct upipe *upipe, uint64_t period)
+{
+    struct upipe_stats_state *state = upipe->stats;
+    if (state == NULL) {
+        state = malloc(sizeof(struct upipe_stats_state));
+        UBASE_ALLOC_RETURN(state)
+        state->stage = NULL;
+        state->sample = state->sampled = 0;
+        state->report = false;
+    }
+    state->start = state->period_start = upipe_stats_now();
+    state->period = period;
+    upipe_stats_reset(&state->total);
+    upipe_stats_reset(&state->current);
+    upipe->stats = state;
+    return UBASE_ERR_NONE;
+}
+
+/** @This disables the input statistics of a pipe.
+ *
+ * @param upipe description structure of the pipe
+ */
+void upipe_stats_disable(struct upipe *upipe)
+{
+    if (upipe->stats != NULL)
+        free(upipe->stats->stage);
+    free(upipe->stats);
+    upipe->stats = NULL;
+}
+
+/** @This declares a pipe as a stage of latency traces.
+ *
+ * @param upipe description structure of the pipe
+ * @param stage name of the stage, or NULL to stop stamping urefs
+ * @param sample sampling period of the traces started by the pipe, or 0
+ * @param report true to report the traced urefs
+ * @return an error code
+ */
+int upipe_stats_trace(struct upipe *upipe, const char *stage,
+                      unsigned int sample, bool report)
+{
+    if (stage != NULL && strlen(stage) > UINT8_MAX)
+        return UBASE_ERR_INVALID;
+    if (upipe->stats == NULL)
+        UBASE_RETURN(upipe_stats_enable(upipe, 0))
+
+    struct upipe_stats_state *state = upipe->stats;
+    char *dup = NULL;
+    if (stage != NULL) {
+        dup = strdup(stage);
+        UBASE_ALLOC_RETURN(dup)
+    }
+    free(state->stage);
+    state->stage = dup;
+    state->sample = sample;
+    state->sampled = 0;
+    state->report = report;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This appends a stamp to a latency trace.
+ *
+ * @param trace latency trace
+ * @param size_p size of the latency trace, incremented
+ * @param stage name of the stage
+ * @param date date of the stamp
+ * @return false if the latency trace is full
+ */
+static bool upipe_stats_trace_stamp(uint8_t *trace, size_t *size_p,
+                                    const char *stage, uint64_t date)
+{
+    size_t len = strlen(stage);
+    size_t size = *size_p;
+    if (size + 9 + len > UPIPE_STATS_TRACE_SIZE)
+        return false;
+    for (int i = 7; i >= 0; i--) {
+        trace[size + i] = date & 0xff;
+        date >>= 8;
+    }
+    trace[size + 8] = len;
+    memcpy(trace + size + 9, stage, len);
+    *size_p = size + 9 + len;
+    return true;
+}
+
+/** @internal @This stamps a uref entering a stage of latency traces, and
+ * starts or reports its trace.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure entering the pipe
+ */
+static void upipe_stats_trace_input(struct upipe *upipe, struct uref *uref)
+{
+    struct upipe_stats_state *state = upipe->stats;
+    uint8_t trace[UPIPE_STATS_TRACE_SIZE];
+    size_t size = 0;
+    const uint8_t *prev;
+    if (ubase_check(uref_stats_get_trace(uref, &prev, &size))) {
+        if (unlikely(size > UPIPE_STATS_TRACE_SIZE))
+            return;
+        memcpy(trace, prev, size);
+    } else {
+        if (!state->sample || ++state->sampled < state->sample)
+            return;
+        state->sampled = 0;
+        uint64_t cr_sys;
+        if (ubase_check(uref_clock_get_cr_sys(uref, &cr_sys)))
+            upipe_stats_trace_stamp(trace, &size, "cr_sys", cr_sys);
+    }
+
+    if (!upipe_stats_trace_stamp(trace, &size, state->stage,
+                                 upipe_stats_now()) ||
+        !ubase_check(uref_stats_set_trace(uref, trace, size)))
+        return;
+    if (state->report)
+        upipe_throw_trace(upipe, uref);
+}
+
+/** @internal @This fills in the input statistics of a pipe since they were
+ * enabled, except the module-specific fields.
+ *
+ * @param upipe description structure of the pipe
+ * @param stats filled in with the statistics
+ * @return an error code, UBASE_ERR_INVALID if statistics are disabled
+ */
+int upipe_stats_collect(struct upipe *upipe, struct upipe_stats *stats)
+{
+    struct upipe_stats_state *state = upipe->stats;
+    if (state == NULL) {
+        upipe_stats_reset(stats);
+        return UBASE_ERR_INVALID;
+    }
+    *stats = state->total;
+    stats->duration = upipe_stats_now() - state->start;
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This calls the input function of a pipe, and accounts for the
+ * uref and the time spent in its input statistics.
+ *
+ * @param upipe description structure of the pipe
+ * @param uref uref structure to send
+ * @param upump_p reference to the pump that generated the buffer
+ */
+void upipe_stats_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    size_t octets = 0;
+    if (uref->ubuf != NULL)
+        uref_block_size(uref, &octets);
+    struct upump_mgr *upump_mgr = upump_p != NULL && *upump_p != NULL ?
+                                  (*upump_p)->mgr : NULL;
+
+    if (upipe->stats->stage != NULL)
+        upipe_stats_trace_input(upipe, uref);
+
+    uint64_t parent_children = upipe_stats_children;
+    upipe_stats_children = 0;
+    uint64_t begin = upipe_stats_now();
+    upipe->mgr->upipe_input(upipe, uref, upump_p);
+    uint64_t end = upipe_stats_now();
+    uint64_t time = end - begin;
+    uint64_t children_time = upipe_stats_children;
+    upipe_stats_children = parent_children + time;
+
+    struct upipe_stats_state *state = upipe->stats;
+    if (unlikely(state == NULL))
+        /* disabled from the input function */
+        return;
+    upipe_stats_account(&state->total, octets, time, children_time);
+    state->total.thread = upipe_stats_thread_id();
+    state->total.upump_mgr = upump_mgr;
+    if (!state->period)
+        return;
+
+    upipe_stats_account(&state->current, octets, time, children_time);
+    state->current.thread = state->total.thread;
+    state->current.upump_mgr = upump_mgr;
+    if (end - state->period_start < state->period)
+        return;
+    state->current.duration = end - state->period_start;
+    upipe_control_nodbg(upipe, UPIPE_GET_STATS, &state->current);
+    upipe_throw_stats(upipe, &state->current);
+    if (upipe->stats == state) {
+        state->period_start = end;
+        upipe_stats_reset(&state->current);
+    }
+}
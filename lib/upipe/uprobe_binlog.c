@@ -0,0 +1,839 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe writing log events to a binary ring file
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_binlog.h"
+#include "upipe/uprobe_helper_alloc.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** magic number at the beginning of a log file */
+#define UPROBE_BINLOG_MAGIC "UPBINLOG"
+/** version of the format of the file */
+#define UPROBE_BINLOG_VERSION 1
+/** size reserved for the header of the file */
+#define UPROBE_BINLOG_HEADER_SIZE 4096
+/** size of the table of strings of the file */
+#define UPROBE_BINLOG_STRINGS_SIZE (1024 * 1024)
+/** number of slots of the hash table of the strings */
+#define UPROBE_BINLOG_SLOTS 16384
+/** maximum size of a record */
+#define UPROBE_BINLOG_RECORD_MAX 8192
+/** maximum size of a string argument */
+#define UPROBE_BINLOG_STRING_MAX 1024
+/** flag of the records carrying a formatted message */
+#define UPROBE_BINLOG_TEXT 0x1
+
+/** @internal @This is the header of a log file. */
+struct uprobe_binlog_header {
+    /** magic number */
+    char magic[8];
+    /** version of the format */
+    uint32_t version;
+    /** size of the header */
+    uint32_t header_size;
+    /** size of the table of strings, following the header */
+    uint64_t strings_size;
+    /** used size of the table of strings */
+    uint64_t strings_used;
+    /** size of the ring of records, following the table of strings */
+    uint64_t ring_size;
+    /** offset of the oldest record in the ring */
+    uint64_t head;
+    /** offset of the next record in the ring */
+    uint64_t tail;
+    /** number of records in the ring */
+    uint64_t count;
+    /** number of records overwritten */
+    uint64_t overwritten;
+};
+
+/** @internal @This is the header of a record, followed by the offsets of
+ * the prefixes in the table of strings and by the encoded arguments, or by
+ * the formatted message. A record of size 0 marks the end of the ring. */
+struct uprobe_binlog_record {
+    /** size of the record, padded to 8 octets */
+    uint32_t size;
+    /** log level */
+    uint8_t level;
+    /** number of prefixes */
+    uint8_t nb_prefixes;
+    /** flags */
+    uint16_t flags;
+    /** offset of the format string in the table of strings */
+    uint32_t format;
+    /** size of the payload */
+    uint32_t payload_size;
+    /** date of the message, in nanoseconds since the Epoch */
+    uint64_t date;
+};
+
+/** @internal @This is the type of an argument of a format string. */
+enum uprobe_binlog_arg {
+    /** no argument */
+    UPROBE_BINLOG_ARG_NONE,
+    /** int, or smaller promoted integer */
+    UPROBE_BINLOG_ARG_INT,
+    /** long */
+    UPROBE_BINLOG_ARG_LONG,
+    /** long long */
+    UPROBE_BINLOG_ARG_LLONG,
+    /** size_t */
+    UPROBE_BINLOG_ARG_SIZE,
+    /** intmax_t */
+    UPROBE_BINLOG_ARG_INTMAX,
+    /** ptrdiff_t */
+    UPROBE_BINLOG_ARG_PTRDIFF,
+    /** double */
+    UPROBE_BINLOG_ARG_DOUBLE,
+    /** long double */
+    UPROBE_BINLOG_ARG_LDOUBLE,
+    /** string */
+    UPROBE_BINLOG_ARG_STRING,
+    /** pointer */
+    UPROBE_BINLOG_ARG_POINTER,
+    /** unsupported conversion */
+    UPROBE_BINLOG_ARG_ERROR
+};
+
+/** level names */
+static const char *uprobe_binlog_levels[] = {
+    [UPROBE_LOG_VERBOSE] = "verbose",
+    [UPROBE_LOG_DEBUG] = "debug",
+    [UPROBE_LOG_INFO] = "info",
+    [UPROBE_LOG_NOTICE] = "notice",
+    [UPROBE_LOG_WARNING] = "warning",
+    [UPROBE_LOG_ERROR] = "error",
+};
+
+/** @internal @This parses a conversion specification of a format string.
+ *
+ * @param p pointer to the character following the '%'
+ * @param stars_p filled in with the number of '*' width and precision
+ * @param arg_p filled in with the type of the argument
+ * @return pointer to the character following the conversion specification
+ */
+static const char *uprobe_binlog_parse(const char *p, unsigned int *stars_p,
+                                       enum uprobe_binlog_arg *arg_p)
+{
+    unsigned int stars = 0;
+    while (*p && strchr("-+ #0'", *p))
+        p++;
+    if (*p == '*') {
+        stars++;
+        p++;
+    } else
+        while (*p >= '0' && *p <= '9')
+            p++;
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            stars++;
+            p++;
+        } else
+            while (*p >= '0' && *p <= '9')
+                p++;
+    }
+
+    enum uprobe_binlog_arg length = UPROBE_BINLOG_ARG_INT;
+    bool wide = false;
+    switch (*p) {
+        case 'h':
+            p += p[1] == 'h' ? 2 : 1;
+            break;
+        case 'l':
+            if (p[1] == 'l') {
+                length = UPROBE_BINLOG_ARG_LLONG;
+                p += 2;
+            } else {
+                length = UPROBE_BINLOG_ARG_LONG;
+                wide = true;
+                p++;
+            }
+            break;
+        case 'q':
+            length = UPROBE_BINLOG_ARG_LLONG;
+            p++;
+            break;
+        case 'j':
+            length = UPROBE_BINLOG_ARG_INTMAX;
+            p++;
+            break;
+        case 'z':
+            length = UPROBE_BINLOG_ARG_SIZE;
+            p++;
+            break;
+        case 't':
+            length = UPROBE_BINLOG_ARG_PTRDIFF;
+            p++;
+            break;
+        case 'L':
+            length = UPROBE_BINLOG_ARG_LDOUBLE;
+            p++;
+            break;
+        default:
+            break;
+    }
+
+    *stars_p = stars;
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            *arg_p = length == UPROBE_BINLOG_ARG_LDOUBLE ?
+                     UPROBE_BINLOG_ARG_ERROR : length;
+            break;
+        case 'c':
+            *arg_p = wide ? UPROBE_BINLOG_ARG_ERROR : UPROBE_BINLOG_ARG_INT;
+            break;
+        case 's':
+            *arg_p = wide ? UPROBE_BINLOG_ARG_ERROR :
+                     UPROBE_BINLOG_ARG_STRING;
+            break;
+        case 'p':
+            *arg_p = UPROBE_BINLOG_ARG_POINTER;
+            break;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A':
+            *arg_p = length == UPROBE_BINLOG_ARG_LDOUBLE ?
+                     UPROBE_BINLOG_ARG_LDOUBLE : UPROBE_BINLOG_ARG_DOUBLE;
+            break;
+        case '%':
+            *arg_p = stars ? UPROBE_BINLOG_ARG_ERROR : UPROBE_BINLOG_ARG_NONE;
+            break;
+        default:
+            *arg_p = UPROBE_BINLOG_ARG_ERROR;
+            return p;
+    }
+    return p + 1;
+}
+
+/** @internal @This encodes the arguments of a format string.
+ *
+ * @param format format string
+ * @param args arguments of the format string
+ * @param buffer buffer to write to
+ * @param size size of the buffer
+ * @return size of the encoded arguments, or -1 if they cannot be encoded
+ */
+static int uprobe_binlog_encode(const char *format, va_list args,
+                                uint8_t *buffer, size_t size)
+{
+    size_t offset = 0;
+    const char *p = format;
+    while ((p = strchr(p, '%')) != NULL) {
+        unsigned int stars;
+        enum uprobe_binlog_arg arg;
+        p = uprobe_binlog_parse(p + 1, &stars, &arg);
+        if (arg == UPROBE_BINLOG_ARG_ERROR)
+            return -1;
+
+        for (unsigned int i = 0; i < stars; i++) {
+            int32_t value = va_arg(args, int);
+            if (offset + sizeof(value) > size)
+                return -1;
+            memcpy(buffer + offset, &value, sizeof(value));
+            offset += sizeof(value);
+        }
+
+        uint64_t value;
+        double d;
+        switch (arg) {
+            case UPROBE_BINLOG_ARG_NONE:
+                continue;
+            case UPROBE_BINLOG_ARG_INT:
+                value = va_arg(args, int);
+                break;
+            case UPROBE_BINLOG_ARG_LONG:
+                value = va_arg(args, long);
+                break;
+            case UPROBE_BINLOG_ARG_LLONG:
+                value = va_arg(args, long long);
+                break;
+            case UPROBE_BINLOG_ARG_SIZE:
+                value = va_arg(args, size_t);
+                break;
+            case UPROBE_BINLOG_ARG_INTMAX:
+                value = va_arg(args, intmax_t);
+                break;
+            case UPROBE_BINLOG_ARG_PTRDIFF:
+                value = va_arg(args, ptrdiff_t);
+                break;
+            case UPROBE_BINLOG_ARG_POINTER:
+                value = (uintptr_t)va_arg(args, void *);
+                break;
+            case UPROBE_BINLOG_ARG_DOUBLE:
+                d = va_arg(args, double);
+                memcpy(&value, &d, sizeof(value));
+                break;
+            case UPROBE_BINLOG_ARG_LDOUBLE:
+                d = va_arg(args, long double);
+                memcpy(&value, &d, sizeof(value));
+                break;
+            case UPROBE_BINLOG_ARG_STRING: {
+                const char *string = va_arg(args, const char *);
+                if (string == NULL)
+                    string = "(null)";
+                uint16_t len = strnlen(string, UPROBE_BINLOG_STRING_MAX);
+                if (offset + sizeof(len) + len > size)
+                    return -1;
+                memcpy(buffer + offset, &len, sizeof(len));
+                memcpy(buffer + offset + sizeof(len), string, len);
+                offset += sizeof(len) + len;
+                continue;
+            }
+            default:
+                return -1;
+        }
+        if (offset + sizeof(value) > size)
+            return -1;
+        memcpy(buffer + offset, &value, sizeof(value));
+        offset += sizeof(value);
+    }
+    return offset;
+}
+
+/** @internal @This returns the header of the log file.
+ *
+ * @param map mapping of the log file
+ * @return pointer to the header
+ */
+static inline struct uprobe_binlog_header *
+    uprobe_binlog_header(uint8_t *map)
+{
+    return (struct uprobe_binlog_header *)map;
+}
+
+/** @internal @This returns the offset of a string in the table of strings,
+ * adding it if needed. The mutex must be held.
+ *
+ * @param uprobe_binlog private structure of the probe
+ * @param string string to look up
+ * @param offset_p filled in with the offset of the string
+ * @return false if the table is full
+ */
+static bool uprobe_binlog_intern(struct uprobe_binlog *uprobe_binlog,
+                                 const char *string, uint32_t *offset_p)
+{
+    struct uprobe_binlog_header *header =
+        uprobe_binlog_header(uprobe_binlog->map);
+    uint8_t *strings = uprobe_binlog->map + UPROBE_BINLOG_HEADER_SIZE;
+    size_t len = strlen(string);
+
+    /* FNV-1a */
+    uint32_t hash = 2166136261U;
+    for (size_t i = 0; i < len; i++)
+        hash = (hash ^ (uint8_t)string[i]) * 16777619U;
+
+    for (unsigned int i = 0; i < UPROBE_BINLOG_SLOTS; i++) {
+        uint32_t *slot =
+            &uprobe_binlog->strings[(hash + i) % UPROBE_BINLOG_SLOTS];
+        if (*slot) {
+            /* slots store the offset plus one */
+            uint32_t offset = *slot - 1;
+            uint32_t slot_len;
+            memcpy(&slot_len, strings + offset, sizeof(slot_len));
+            if (slot_len == len &&
+                !memcmp(strings + offset + sizeof(slot_len), string, len)) {
+                *offset_p = offset;
+                return true;
+            }
+            continue;
+        }
+
+        uint64_t offset = header->strings_used;
+        uint64_t entry = (sizeof(uint32_t) + len + 1 + 3) & ~UINT64_C(3);
+        if (offset + entry > header->strings_size)
+            return false;
+        uint32_t entry_len = len;
+        memcpy(strings + offset, &entry_len, sizeof(entry_len));
+        memcpy(strings + offset + sizeof(entry_len), string, len + 1);
+        header->strings_used = offset + entry;
+        *slot = offset + 1;
+        *offset_p = offset;
+        return true;
+    }
+    return false;
+}
+
+/** @internal @This drops the oldest record of the ring. The mutex must be
+ * held.
+ *
+ * @param header header of the log file
+ * @param ring pointer to the ring
+ */
+static void uprobe_binlog_evict(struct uprobe_binlog_header *header,
+                                uint8_t *ring)
+{
+    uint32_t size = 0;
+    if (header->head + sizeof(size) <= header->ring_size)
+        memcpy(&size, ring + header->head, sizeof(size));
+    if (!size) {
+        /* end of the ring */
+        header->head = 0;
+        return;
+    }
+    header->head += size;
+    header->count--;
+    header->overwritten++;
+}
+
+/** @internal @This writes a record to the ring, overwriting the oldest
+ * records if needed. The mutex must be held.
+ *
+ * @param uprobe_binlog private structure of the probe
+ * @param record record to write
+ */
+static void uprobe_binlog_write(struct uprobe_binlog *uprobe_binlog,
+                                const struct uprobe_binlog_record *record)
+{
+    struct uprobe_binlog_header *header =
+        uprobe_binlog_header(uprobe_binlog->map);
+    uint8_t *ring = uprobe_binlog->map + UPROBE_BINLOG_HEADER_SIZE +
+                    header->strings_size;
+    uint64_t size = record->size;
+
+    if (header->tail + size > header->ring_size) {
+        /* drop the records up to the end of the ring, and wrap */
+        while (header->count && header->head >= header->tail)
+            uprobe_binlog_evict(header, ring);
+        if (header->tail + sizeof(uint32_t) <= header->ring_size)
+            memset(ring + header->tail, 0, sizeof(uint32_t));
+        header->tail = 0;
+    }
+    while (header->count && header->head >= header->tail &&
+           header->head < header->tail + size)
+        uprobe_binlog_evict(header, ring);
+    if (!header->count)
+        header->head = header->tail;
+
+    memcpy(ring + header->tail, record, size);
+    header->tail += size;
+    header->count++;
+}
+
+/* ignore format-nonliteral warnings on vsnprintf */
+UBASE_PRAGMA_GCC(diagnostic push)
+UBASE_PRAGMA_GCC(diagnostic ignored "-Wformat-nonliteral")
+UBASE_PRAGMA_CLANG(diagnostic push)
+UBASE_PRAGMA_CLANG(diagnostic ignored "-Wformat-nonliteral")
+
+/** @internal @This catches events thrown by pipes.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param event event thrown
+ * @param args optional event-specific parameters
+ * @return an error code
+ */
+static int uprobe_binlog_throw(struct uprobe *uprobe, struct upipe *upipe,
+                               int event, va_list args)
+{
+    struct uprobe_binlog *uprobe_binlog = uprobe_binlog_from_uprobe(uprobe);
+    if (event != UPROBE_LOG)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    struct ulog *ulog = va_arg(args, struct ulog *);
+    if (uprobe_binlog->min_level > ulog->level)
+        return UBASE_ERR_NONE;
+
+    uint64_t buffer[UPROBE_BINLOG_RECORD_MAX / sizeof(uint64_t)];
+    struct uprobe_binlog_record *record =
+        (struct uprobe_binlog_record *)buffer;
+    uint8_t *payload = (uint8_t *)buffer + sizeof(*record);
+    size_t payload_max = sizeof(buffer) - sizeof(*record);
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    record->level = ulog->level;
+    record->flags = 0;
+    record->format = 0;
+    record->date = (uint64_t)ts.tv_sec * UINT64_C(1000000000) + ts.tv_nsec;
+
+    const char *tags[UINT8_MAX];
+    unsigned int nb_tags = 0;
+    struct uchain *uchain;
+    ulist_foreach_reverse(&ulog->prefixes, uchain) {
+        if (nb_tags >= UBASE_ARRAY_SIZE(tags))
+            break;
+        tags[nb_tags++] = ulog_pfx_from_uchain(uchain)->tag;
+    }
+    record->nb_prefixes = nb_tags;
+
+    size_t prefixes_size = nb_tags * sizeof(uint32_t);
+    va_list ap;
+    va_copy(ap, *ulog->args);
+    int encoded = uprobe_binlog_encode(ulog->format, ap,
+                                       payload + prefixes_size,
+                                       payload_max - prefixes_size);
+    va_end(ap);
+
+    pthread_mutex_lock(&uprobe_binlog->mutex);
+    bool interned = encoded >= 0 &&
+        uprobe_binlog_intern(uprobe_binlog, ulog->format, &record->format);
+    for (unsigned int i = 0; interned && i < nb_tags; i++) {
+        uint32_t offset;
+        interned = uprobe_binlog_intern(uprobe_binlog, tags[i], &offset);
+        memcpy(payload + i * sizeof(uint32_t), &offset, sizeof(offset));
+    }
+
+    if (interned)
+        record->payload_size = prefixes_size + encoded;
+    else {
+        /* write the formatted message */
+        size_t len = 0;
+        for (unsigned int i = 0; i < nb_tags; i++) {
+            int ret = snprintf((char *)payload + len, payload_max - len,
+                               "[%s] ", tags[i]);
+            if (ret > 0)
+                len += ret;
+            if (len >= payload_max)
+                len = payload_max - 1;
+        }
+        va_copy(ap, *ulog->args);
+        int ret = vsnprintf((char *)payload + len, payload_max - len,
+                            ulog->format, ap);
+        va_end(ap);
+        if (ret > 0)
+            len += ret;
+        if (len >= payload_max)
+            len = payload_max - 1;
+        record->flags = UPROBE_BINLOG_TEXT;
+        record->nb_prefixes = 0;
+        record->payload_size = len;
+    }
+    record->size = (sizeof(*record) + record->payload_size + 7) & ~7U;
+
+    uprobe_binlog_write(uprobe_binlog, record);
+    pthread_mutex_unlock(&uprobe_binlog->mutex);
+    return UBASE_ERR_NONE;
+}
+
+/** @internal @This prints a message encoded in a record.
+ *
+ * @param file stream to write to
+ * @param format format string
+ * @param payload encoded arguments
+ * @param size size of the encoded arguments
+ * @return false if the record is corrupted
+ */
+static bool uprobe_binlog_print(FILE *file, const char *format,
+                                const uint8_t *payload, size_t size)
+{
+    size_t offset = 0;
+    const char *p = format;
+    const char *next;
+    while ((next = strchr(p, '%')) != NULL) {
+        fwrite(p, 1, next - p, file);
+
+        unsigned int stars;
+        enum uprobe_binlog_arg arg;
+        p = uprobe_binlog_parse(next + 1, &stars, &arg);
+        if (arg == UPROBE_BINLOG_ARG_ERROR)
+            return false;
+        if (arg == UPROBE_BINLOG_ARG_NONE) {
+            fputc('%', file);
+            continue;
+        }
+
+        /* rebuild the specification with the width and precision */
+        char spec[64];
+        size_t len = 0;
+        for (const char *s = next; s < p && len < sizeof(spec) - 16; s++) {
+            if (*s != '*') {
+                spec[len++] = *s;
+                continue;
+            }
+            int32_t value;
+            if (offset + sizeof(value) > size)
+                return false;
+            memcpy(&value, payload + offset, sizeof(value));
+            offset += sizeof(value);
+            len += snprintf(spec + len, sizeof(spec) - len, "%"PRId32,
+                            value);
+        }
+        spec[len] = '\0';
+
+        if (arg == UPROBE_BINLOG_ARG_STRING) {
+            uint16_t string_len;
+            if (offset + sizeof(string_len) > size)
+                return false;
+            memcpy(&string_len, payload + offset, sizeof(string_len));
+            offset += sizeof(string_len);
+            if (offset + string_len > size)
+                return false;
+            char string[string_len + 1];
+            memcpy(string, payload + offset, string_len);
+            string[string_len] = '\0';
+            offset += string_len;
+            fprintf(file, spec, string);
+            continue;
+        }
+
+        uint64_t value;
+        double d;
+        if (offset + sizeof(value) > size)
+            return false;
+        memcpy(&value, payload + offset, sizeof(value));
+        offset += sizeof(value);
+        switch (arg) {
+            case UPROBE_BINLOG_ARG_INT:
+                fprintf(file, spec, (int)value);
+                break;
+            case UPROBE_BINLOG_ARG_LONG:
+                fprintf(file, spec, (long)value);
+                break;
+            case UPROBE_BINLOG_ARG_LLONG:
+                fprintf(file, spec, (long long)value);
+                break;
+            case UPROBE_BINLOG_ARG_SIZE:
+                fprintf(file, spec, (size_t)value);
+                break;
+            case UPROBE_BINLOG_ARG_INTMAX:
+                fprintf(file, spec, (intmax_t)value);
+                break;
+            case UPROBE_BINLOG_ARG_PTRDIFF:
+                fprintf(file, spec, (ptrdiff_t)value);
+                break;
+            case UPROBE_BINLOG_ARG_POINTER:
+                fprintf(file, spec, (void *)(uintptr_t)value);
+                break;
+            case UPROBE_BINLOG_ARG_DOUBLE:
+                memcpy(&d, &value, sizeof(d));
+                fprintf(file, spec, d);
+                break;
+            case UPROBE_BINLOG_ARG_LDOUBLE:
+                memcpy(&d, &value, sizeof(d));
+                fprintf(file, spec, (long double)d);
+                break;
+            default:
+                return false;
+        }
+    }
+    fputs(p, file);
+    return true;
+}
+
+UBASE_PRAGMA_CLANG(diagnostic pop)
+UBASE_PRAGMA_GCC(diagnostic pop)
+
+/** @This decodes a log file written by a uprobe_binlog, and prints the
+ * messages it holds from the oldest to the newest.
+ *
+ * @param path path of the log file
+ * @param file stream to write to
+ * @return an error code
+ */
+int uprobe_binlog_dump(const char *path, FILE *file)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return UBASE_ERR_EXTERNAL;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < UPROBE_BINLOG_HEADER_SIZE) {
+        close(fd);
+        return UBASE_ERR_INVALID;
+    }
+    size_t map_size = st.st_size;
+    uint8_t *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return UBASE_ERR_EXTERNAL;
+
+    /* take a copy of the header, as the file may still be written */
+    struct uprobe_binlog_header header;
+    memcpy(&header, map, sizeof(header));
+    if (memcmp(header.magic, UPROBE_BINLOG_MAGIC, sizeof(header.magic)) ||
+        header.version != UPROBE_BINLOG_VERSION ||
+        header.header_size != UPROBE_BINLOG_HEADER_SIZE ||
+        header.strings_used > header.strings_size ||
+        header.strings_size > map_size - UPROBE_BINLOG_HEADER_SIZE ||
+        header.ring_size > map_size - UPROBE_BINLOG_HEADER_SIZE -
+                           header.strings_size) {
+        munmap(map, map_size);
+        return UBASE_ERR_INVALID;
+    }
+    const uint8_t *strings = map + UPROBE_BINLOG_HEADER_SIZE;
+    const uint8_t *ring = strings + header.strings_size;
+
+    int err = UBASE_ERR_NONE;
+    uint64_t head = header.head;
+    bool wrapped = false;
+    for (uint64_t i = 0; i < header.count; i++) {
+        struct uprobe_binlog_record record;
+        uint32_t size = 0;
+        if (head + sizeof(size) <= header.ring_size)
+            memcpy(&size, ring + head, sizeof(size));
+        if (!size && !wrapped && head) {
+            /* end of the ring */
+            wrapped = true;
+            head = 0;
+            memcpy(&size, ring, sizeof(size));
+        }
+        if (head + size > header.ring_size || size < sizeof(record)) {
+            err = UBASE_ERR_INVALID;
+            break;
+        }
+        memcpy(&record, ring + head, sizeof(record));
+        const uint8_t *payload = ring + head + sizeof(record);
+        head += size;
+        if (record.payload_size > size - sizeof(record) ||
+            record.nb_prefixes * sizeof(uint32_t) > record.payload_size) {
+            err = UBASE_ERR_INVALID;
+            break;
+        }
+
+        fprintf(file, "%"PRIu64".%09"PRIu64" %s: ",
+                record.date / UINT64_C(1000000000),
+                record.date % UINT64_C(1000000000),
+                record.level < UBASE_ARRAY_SIZE(uprobe_binlog_levels) ?
+                uprobe_binlog_levels[record.level] : "unknown");
+        if (record.flags & UPROBE_BINLOG_TEXT) {
+            fwrite(payload, 1, record.payload_size, file);
+            fputc('\n', file);
+            continue;
+        }
+
+        bool valid = record.format + sizeof(uint32_t) <= header.strings_used;
+        for (unsigned int j = 0; valid && j < record.nb_prefixes; j++) {
+            uint32_t offset;
+            memcpy(&offset, payload + j * sizeof(uint32_t), sizeof(offset));
+            valid = offset + sizeof(uint32_t) <= header.strings_used;
+            if (valid)
+                fprintf(file, "[%s] ",
+                        (const char *)strings + offset + sizeof(uint32_t));
+        }
+        size_t prefixes_size = record.nb_prefixes * sizeof(uint32_t);
+        if (!valid ||
+            !uprobe_binlog_print(file,
+                (const char *)strings + record.format + sizeof(uint32_t),
+                payload + prefixes_size,
+                record.payload_size - prefixes_size)) {
+            fputc('\n', file);
+            err = UBASE_ERR_INVALID;
+            break;
+        }
+        fputc('\n', file);
+    }
+
+    munmap(map, map_size);
+    return err;
+}
+
+/** @This initializes an already allocated uprobe_binlog structure.
+ *
+ * @param uprobe_binlog pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param path path of the log file, created or truncated
+ * @param ring_size size of the ring of messages in the file, in octets
+ * @param min_level minimum level of logged messages
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_binlog_init(struct uprobe_binlog *uprobe_binlog,
+                                  struct uprobe *next, const char *path,
+                                  size_t ring_size,
+                                  enum uprobe_log_level min_level)
+{
+    assert(uprobe_binlog != NULL);
+    struct uprobe *uprobe = uprobe_binlog_to_uprobe(uprobe_binlog);
+    ring_size &= ~(size_t)7;
+    if (unlikely(ring_size < 2 * UPROBE_BINLOG_RECORD_MAX))
+        return NULL;
+
+    uprobe_binlog->strings = calloc(UPROBE_BINLOG_SLOTS, sizeof(uint32_t));
+    if (unlikely(uprobe_binlog->strings == NULL))
+        return NULL;
+
+    uprobe_binlog->size = UPROBE_BINLOG_HEADER_SIZE +
+                          UPROBE_BINLOG_STRINGS_SIZE + ring_size;
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (unlikely(fd < 0)) {
+        free(uprobe_binlog->strings);
+        return NULL;
+    }
+    if (unlikely(ftruncate(fd, uprobe_binlog->size) < 0)) {
+        close(fd);
+        free(uprobe_binlog->strings);
+        return NULL;
+    }
+    uprobe_binlog->map = mmap(NULL, uprobe_binlog->size,
+                              PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (unlikely(uprobe_binlog->map == MAP_FAILED)) {
+        free(uprobe_binlog->strings);
+        return NULL;
+    }
+
+    struct uprobe_binlog_header *header =
+        uprobe_binlog_header(uprobe_binlog->map);
+    header->version = UPROBE_BINLOG_VERSION;
+    header->header_size = UPROBE_BINLOG_HEADER_SIZE;
+    header->strings_size = UPROBE_BINLOG_STRINGS_SIZE;
+    header->strings_used = 0;
+    header->ring_size = ring_size;
+    header->head = header->tail = 0;
+    header->count = header->overwritten = 0;
+    memcpy(header->magic, UPROBE_BINLOG_MAGIC, sizeof(header->magic));
+
+    uprobe_binlog->min_level = min_level;
+    pthread_mutex_init(&uprobe_binlog->mutex, NULL);
+    uprobe_init(uprobe, uprobe_binlog_throw, next);
+    return uprobe;
+}
+
+/** @This cleans a uprobe_binlog structure.
+ *
+ * @param uprobe_binlog structure to clean
+ */
+void uprobe_binlog_clean(struct uprobe_binlog *uprobe_binlog)
+{
+    assert(uprobe_binlog != NULL);
+    struct uprobe *uprobe = uprobe_binlog_to_uprobe(uprobe_binlog);
+    munmap(uprobe_binlog->map, uprobe_binlog->size);
+    free(uprobe_binlog->strings);
+    pthread_mutex_destroy(&uprobe_binlog->mutex);
+    uprobe_clean(uprobe);
+}
+
+#define ARGS_DECL struct uprobe *next, const char *path, size_t ring_size, \
+                  enum uprobe_log_level min_level
+#define ARGS next, path, ring_size, min_level
+UPROBE_HELPER_ALLOC(uprobe_binlog)
+#undef ARGS
+#undef ARGS_DECL
@@ -45,6 +45,7 @@
 #include "upipe/upipe.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <stdarg.h>
 #include <math.h>
 #include <assert.h>
@@ -74,6 +75,60 @@
 /** debug print periodicity */
 #define PRINT_PERIODICITY (60 * UCLOCK_FREQ)
 
+/** @internal @This compares two jitter samples.
+ *
+ * @param a pointer to first sample
+ * @param b pointer to second sample
+ * @return an integer less than, equal to, or greater than zero
+ */
+static int uprobe_dejitter_compare(const void *a, const void *b)
+{
+    int32_t x = *(const int32_t *)a;
+    int32_t y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/** @internal @This adds a jitter sample and updates the adaptive latency
+ * margin.
+ *
+ * @param uprobe_dejitter pointer to probe
+ * @param jitter deviation of the last clock reference from the average
+ * @param elapsed stream time elapsed since the previous clock reference
+ */
+static void uprobe_dejitter_adapt(struct uprobe_dejitter *uprobe_dejitter,
+                                  double jitter, uint64_t elapsed)
+{
+    if (jitter > INT32_MAX)
+        jitter = INT32_MAX;
+    else if (jitter < INT32_MIN)
+        jitter = INT32_MIN;
+    uprobe_dejitter->jitter[uprobe_dejitter->jitter_idx] = jitter;
+    uprobe_dejitter->jitter_idx =
+        (uprobe_dejitter->jitter_idx + 1) % UPROBE_DEJITTER_WINDOW;
+    if (uprobe_dejitter->jitter_count < UPROBE_DEJITTER_WINDOW)
+        uprobe_dejitter->jitter_count++;
+
+    unsigned int count = uprobe_dejitter->jitter_count;
+    int32_t sorted[UPROBE_DEJITTER_WINDOW];
+    memcpy(sorted, uprobe_dejitter->jitter, count * sizeof(int32_t));
+    qsort(sorted, count, sizeof(int32_t), uprobe_dejitter_compare);
+    double target = sorted[(count - 1) * uprobe_dejitter->percentile / 100];
+    if (target < uprobe_dejitter->min_margin)
+        target = uprobe_dejitter->min_margin;
+    if (target > uprobe_dejitter->max_margin)
+        target = uprobe_dejitter->max_margin;
+
+    /* grow at once to avoid late packets, but shrink no faster than the
+     * standard drift so that the PLL does not need to go desperate */
+    double slew = (double)elapsed * PLL_STANDARD / UCLOCK_FREQ;
+    if (target >= uprobe_dejitter->margin || count == 1)
+        uprobe_dejitter->margin = target;
+    else if (uprobe_dejitter->margin - target > slew)
+        uprobe_dejitter->margin -= slew;
+    else
+        uprobe_dejitter->margin = target;
+}
+
 /** @internal @This catches clock_ref events thrown by pipes.
  *
  * @param uprobe pointer to probe
@@ -131,8 +186,16 @@ static int uprobe_dejitter_clock_ref(struct uprobe *uprobe, struct upipe *upipe,
     if (uprobe_dejitter->deviation < uprobe_dejitter->minimum_deviation)
         uprobe_dejitter->deviation = uprobe_dejitter->minimum_deviation;
 
+    if (uprobe_dejitter->percentile)
+        uprobe_dejitter_adapt(uprobe_dejitter, deviation,
+                              uprobe_dejitter->offset_count > 1 &&
+                              cr_prog > uprobe_dejitter->last_cr_prog ?
+                              cr_prog - uprobe_dejitter->last_cr_prog : 0);
+    else
+        uprobe_dejitter->margin = 3 * uprobe_dejitter->deviation;
+
     int64_t wanted_offset = uprobe_dejitter->offset +
-                            3 * uprobe_dejitter->deviation;
+                            uprobe_dejitter->margin;
     if (uprobe_dejitter->offset_count == 1) {
         uprobe_dejitter->last_cr_prog = cr_prog;
         uprobe_dejitter->last_cr_sys = cr_prog + wanted_offset;
@@ -194,10 +257,11 @@ static int uprobe_dejitter_clock_ref(struct uprobe *uprobe, struct upipe *upipe,
 
     if (cr_sys > uprobe_dejitter->last_print + PRINT_PERIODICITY) {
         upipe_dbg_va(upipe,
-                "dejitter drift %f error %"PRId64" deviation %g",
+                "dejitter drift %f error %"PRId64" deviation %g margin %g",
                 (double)uprobe_dejitter->drift_rate.num /
                 uprobe_dejitter->drift_rate.den,
-                error_offset, uprobe_dejitter->deviation);
+                error_offset, uprobe_dejitter->deviation,
+                uprobe_dejitter->margin);
         uprobe_dejitter->last_print = cr_sys;
     }
 
@@ -308,6 +372,30 @@ void uprobe_dejitter_set_minimum_deviation(struct uprobe *uprobe,
         uprobe_dejitter->deviation = deviation;
 }
 
+/** @This enables adaptive latency. Instead of three times the deviation,
+ * the latency margin is the given percentile of the jitter measured over
+ * the last @ref UPROBE_DEJITTER_WINDOW clock references, within bounds.
+ *
+ * @param uprobe pointer to probe
+ * @param percentile percentile of the jitter to cover (1 to 100), or 0 to
+ * disable adaptive latency
+ * @param min_margin minimum latency margin
+ * @param max_margin maximum latency margin
+ */
+void uprobe_dejitter_set_adaptive(struct uprobe *uprobe,
+                                  unsigned int percentile,
+                                  uint64_t min_margin, uint64_t max_margin)
+{
+    struct uprobe_dejitter *uprobe_dejitter =
+        uprobe_dejitter_from_uprobe(uprobe);
+    uprobe_dejitter->percentile = percentile > 100 ? 100 : percentile;
+    uprobe_dejitter->min_margin = min_margin;
+    uprobe_dejitter->max_margin = max_margin > min_margin ? max_margin :
+                                  min_margin;
+    uprobe_dejitter->jitter_count = 0;
+    uprobe_dejitter->jitter_idx = 0;
+}
+
 /** @This initializes an already allocated uprobe_dejitter structure.
  *
  * @param uprobe_pfx pointer to the already allocated structure
@@ -325,6 +413,8 @@ struct uprobe *uprobe_dejitter_init(struct uprobe_dejitter *uprobe_dejitter,
     uprobe_dejitter->drift_rate.num = uprobe_dejitter->drift_rate.den = 1;
     uprobe_dejitter->last_print = 0;
     uprobe_dejitter->minimum_deviation = 0;
+    uprobe_dejitter->margin = 0;
+    uprobe_dejitter_set_adaptive(uprobe, 0, 0, MAX_JITTER);
     uprobe_dejitter_set(uprobe, enabled, deviation);
     uprobe_init(uprobe, uprobe_dejitter_throw, next);
     return uprobe;
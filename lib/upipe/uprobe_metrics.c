@@ -0,0 +1,744 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe exporting counters of pipe events in the Prometheus format
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uatomic.h"
+#include "upipe/uclock.h"
+#include "upipe/ulog.h"
+#include "upipe/ualloc_stats.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_stats.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_metrics.h"
+#include "upipe/uprobe_helper_alloc.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+/** number of entries of a shard */
+#define UPROBE_METRICS_SHARD_SIZE 512
+/** maximum length of a label, including the terminating zero */
+#define UPROBE_METRICS_LABEL_SIZE 48
+/** maximum size of an HTTP request */
+#define UPROBE_METRICS_REQUEST_SIZE 2048
+
+/** @internal @This enumerates the exported metrics. */
+enum uprobe_metrics_id {
+    UPROBE_METRICS_FATAL,
+    UPROBE_METRICS_ERROR,
+    UPROBE_METRICS_LOG_ERROR,
+    UPROBE_METRICS_LOG_WARNING,
+    UPROBE_METRICS_SYNC_LOST,
+    UPROBE_METRICS_SYNC_ACQUIRED,
+    UPROBE_METRICS_SOURCE_END,
+    UPROBE_METRICS_SINK_END,
+    UPROBE_METRICS_STALLED,
+    UPROBE_METRICS_DISCONTINUITY,
+    UPROBE_METRICS_LOST,
+    UPROBE_METRICS_SLOW_UPUMP,
+    UPROBE_METRICS_INPUT_UREFS,
+    UPROBE_METRICS_INPUT_OCTETS,
+    UPROBE_METRICS_INPUT_TIME,
+    UPROBE_METRICS_ALLOC_HITS,
+    UPROBE_METRICS_ALLOC_MISSES,
+    UPROBE_METRICS_ALLOC_RETAINED,
+
+    UPROBE_METRICS_NB
+};
+
+/** @internal @This describes the exported metrics. */
+static const struct {
+    /** name of the metric */
+    const char *name;
+    /** description of the metric */
+    const char *help;
+    /** true for a gauge, false for a counter */
+    bool gauge;
+    /** name of the label */
+    const char *label;
+    /** true if the values are in 27 MHz units */
+    bool time;
+} uprobe_metrics_defs[UPROBE_METRICS_NB] = {
+    { "upipe_fatal_errors_total", "Fatal errors thrown by pipes.",
+      false, "pipe", false },
+    { "upipe_errors_total", "Errors thrown by pipes.",
+      false, "pipe", false },
+    { "upipe_log_errors_total", "Error messages logged by pipes.",
+      false, "pipe", false },
+    { "upipe_log_warnings_total", "Warning messages logged by pipes.",
+      false, "pipe", false },
+    { "upipe_sync_lost_total", "Losses of synchronization.",
+      false, "pipe", false },
+    { "upipe_sync_acquired_total", "Acquisitions of synchronization.",
+      false, "pipe", false },
+    { "upipe_source_ends_total", "Ends of sources.",
+      false, "pipe", false },
+    { "upipe_sink_ends_total", "Ends of sinks.",
+      false, "pipe", false },
+    { "upipe_stalls_total", "Stalls of queues.",
+      false, "pipe", false },
+    { "upipe_discontinuities_total",
+      "Discontinuities such as continuity counter errors.",
+      false, "pipe", false },
+    { "upipe_lost_units_total", "Units presumed lost in discontinuities.",
+      false, "pipe", false },
+    { "upipe_slow_callbacks_total",
+      "Event loop callbacks which ran for too long or fired late.",
+      false, "pipe", false },
+    { "upipe_input_urefs_total", "Buffers received by instrumented pipes.",
+      false, "pipe", false },
+    { "upipe_input_octets_total", "Octets received by instrumented pipes.",
+      false, "pipe", false },
+    { "upipe_input_seconds_total",
+      "Time spent in the input of instrumented pipes.",
+      false, "pipe", true },
+    { "upipe_alloc_hits_total", "Allocations served from pools.",
+      false, "pool", false },
+    { "upipe_alloc_misses_total", "Allocations which missed pools.",
+      false, "pool", false },
+    { "upipe_alloc_retained_octets", "Octets retained in pools.",
+      true, "pool", false },
+};
+
+/** @internal @This is a counter of a shard. */
+struct uprobe_metrics_entry {
+    /** identifier of the metric plus one, or 0 if the entry is free */
+    uatomic_uint32_t state;
+    /** value of the label */
+    char label[UPROBE_METRICS_LABEL_SIZE];
+    /** value, only written by the thread of the shard */
+    uint64_t value;
+};
+
+/** @internal @This is the set of counters of a thread. */
+struct uprobe_metrics_shard {
+    /** next shard, constant once the shard is published */
+    struct uprobe_metrics_shard *next;
+    /** number of updates dropped because the shard was full */
+    uint64_t overflows;
+    /** hash table of counters, with linear probing */
+    struct uprobe_metrics_entry entries[UPROBE_METRICS_SHARD_SIZE];
+};
+
+/** @internal @This is a pending HTTP connection. */
+struct uprobe_metrics_conn {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** pointer to the probe */
+    struct uprobe_metrics *uprobe_metrics;
+    /** socket */
+    int fd;
+    /** pump watching the socket */
+    struct upump *upump;
+    /** size of the request received so far */
+    size_t size;
+    /** request received so far */
+    char request[UPROBE_METRICS_REQUEST_SIZE];
+};
+
+UBASE_FROM_TO(uprobe_metrics_conn, uchain, uchain, uchain)
+
+/** @internal @This returns the shard of the current thread, allocating it
+ * if needed.
+ *
+ * @param uprobe_metrics private structure of the probe
+ * @return pointer to the shard, or NULL in case of allocation error
+ */
+static struct uprobe_metrics_shard *
+    uprobe_metrics_shard(struct uprobe_metrics *uprobe_metrics)
+{
+    struct uprobe_metrics_shard *shard =
+        pthread_getspecific(uprobe_metrics->key);
+    if (likely(shard != NULL))
+        return shard;
+
+    shard = malloc(sizeof(struct uprobe_metrics_shard));
+    if (unlikely(shard == NULL))
+        return NULL;
+    shard->overflows = 0;
+    for (int i = 0; i < UPROBE_METRICS_SHARD_SIZE; i++)
+        uatomic_init(&shard->entries[i].state, 0);
+
+    void *head = uatomic_ptr_load(&uprobe_metrics->shards);
+    do
+        shard->next = head;
+    while (!uatomic_ptr_compare_exchange(&uprobe_metrics->shards, &head,
+                                         shard));
+    pthread_setspecific(uprobe_metrics->key, shard);
+    return shard;
+}
+
+/** @internal @This returns the counter of a metric in the shard of the
+ * current thread, allocating it if needed.
+ *
+ * @param uprobe_metrics private structure of the probe
+ * @param id identifier of the metric
+ * @param label value of the label
+ * @return pointer to the counter, or NULL if it could not be allocated
+ */
+static uint64_t *uprobe_metrics_get(struct uprobe_metrics *uprobe_metrics,
+                                    enum uprobe_metrics_id id,
+                                    const char *label)
+{
+    struct uprobe_metrics_shard *shard = uprobe_metrics_shard(uprobe_metrics);
+    if (unlikely(shard == NULL))
+        return NULL;
+
+    uint32_t hash = 2166136261U ^ id;
+    for (const char *c = label; *c; c++)
+        hash = (hash ^ (uint8_t)*c) * 16777619U;
+
+    for (int i = 0; i < UPROBE_METRICS_SHARD_SIZE; i++) {
+        struct uprobe_metrics_entry *entry =
+            &shard->entries[(hash + i) % UPROBE_METRICS_SHARD_SIZE];
+        uint32_t state = uatomic_load(&entry->state);
+        if (state == id + 1 && !strcmp(entry->label, label))
+            return &entry->value;
+        if (!state) {
+            /* only this thread writes the shard, publish the entry once
+             * it is complete */
+            strcpy(entry->label, label);
+            entry->value = 0;
+            uatomic_store(&entry->state, id + 1);
+            return &entry->value;
+        }
+    }
+    shard->overflows++;
+    return NULL;
+}
+
+/** @internal @This adds to the counter of a metric.
+ *
+ * @param uprobe_metrics private structure of the probe
+ * @param id identifier of the metric
+ * @param label value of the label
+ * @param value value to add
+ */
+static void uprobe_metrics_add(struct uprobe_metrics *uprobe_metrics,
+                               enum uprobe_metrics_id id, const char *label,
+                               uint64_t value)
+{
+    uint64_t *counter = uprobe_metrics_get(uprobe_metrics, id, label);
+    if (likely(counter != NULL))
+        *counter += value;
+}
+
+/** @internal @This sets the counter of a metric.
+ *
+ * @param uprobe_metrics private structure of the probe
+ * @param id identifier of the metric
+ * @param label value of the label
+ * @param value new value
+ */
+static void uprobe_metrics_set(struct uprobe_metrics *uprobe_metrics,
+                               enum uprobe_metrics_id id, const char *label,
+                               uint64_t value)
+{
+    uint64_t *counter = uprobe_metrics_get(uprobe_metrics, id, label);
+    if (likely(counter != NULL))
+        *counter = value;
+}
+
+/** @internal @This builds the label of a pipe, from the name of its prefix
+ * probe or from the signature of its manager.
+ *
+ * @param upipe description structure of the pipe, or NULL
+ * @param label filled in with the label
+ */
+static void uprobe_metrics_pipe_label(struct upipe *upipe, char *label)
+{
+    const char *name = upipe != NULL && upipe->uprobe != NULL ?
+                       uprobe_pfx_get_name(upipe->uprobe) : NULL;
+    if (name != NULL) {
+        snprintf(label, UPROBE_METRICS_LABEL_SIZE, "%s", name);
+        return;
+    }
+    if (upipe == NULL || upipe->mgr == NULL) {
+        label[0] = '\0';
+        return;
+    }
+
+    memcpy(label, &upipe->mgr->signature, 4);
+    for (int i = 0; i < 4; i++)
+        if (label[i] < 0x20 || label[i] > 0x7e)
+            label[i] = '?';
+    label[4] = '\0';
+}
+
+/** @internal @This catches events thrown by pipes.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param event event thrown
+ * @param args optional event-specific parameters
+ * @return an error code
+ */
+static int uprobe_metrics_throw(struct uprobe *uprobe, struct upipe *upipe,
+                                int event, va_list args)
+{
+    struct uprobe_metrics *uprobe_metrics =
+        uprobe_metrics_from_uprobe(uprobe);
+    enum uprobe_metrics_id id;
+    switch (event) {
+        case UPROBE_FATAL: id = UPROBE_METRICS_FATAL; break;
+        case UPROBE_ERROR: id = UPROBE_METRICS_ERROR; break;
+        case UPROBE_SYNC_LOST: id = UPROBE_METRICS_SYNC_LOST; break;
+        case UPROBE_SYNC_ACQUIRED: id = UPROBE_METRICS_SYNC_ACQUIRED; break;
+        case UPROBE_SOURCE_END: id = UPROBE_METRICS_SOURCE_END; break;
+        case UPROBE_SINK_END: id = UPROBE_METRICS_SINK_END; break;
+        case UPROBE_STALLED: id = UPROBE_METRICS_STALLED; break;
+        case UPROBE_DISCONTINUITY: id = UPROBE_METRICS_DISCONTINUITY; break;
+        case UPROBE_SLOW_UPUMP: id = UPROBE_METRICS_SLOW_UPUMP; break;
+        case UPROBE_LOG: id = UPROBE_METRICS_LOG_ERROR; break;
+        case UPROBE_STATS: id = UPROBE_METRICS_INPUT_UREFS; break;
+        case UPROBE_ALLOC_STATS: id = UPROBE_METRICS_ALLOC_HITS; break;
+        default:
+            return uprobe_throw_next(uprobe, upipe, event, args);
+    }
+
+    char label[UPROBE_METRICS_LABEL_SIZE];
+    va_list args_copy;
+    va_copy(args_copy, args);
+    switch (event) {
+        case UPROBE_LOG: {
+            struct ulog *ulog = va_arg(args_copy, struct ulog *);
+            if (ulog->level != UPROBE_LOG_ERROR &&
+                ulog->level != UPROBE_LOG_WARNING)
+                break;
+            uprobe_metrics_pipe_label(upipe, label);
+            uprobe_metrics_add(uprobe_metrics,
+                               ulog->level == UPROBE_LOG_ERROR ?
+                               UPROBE_METRICS_LOG_ERROR :
+                               UPROBE_METRICS_LOG_WARNING, label, 1);
+            break;
+        }
+        case UPROBE_DISCONTINUITY: {
+            uint64_t lost = va_arg(args_copy, uint64_t);
+            uprobe_metrics_pipe_label(upipe, label);
+            uprobe_metrics_add(uprobe_metrics, id, label, 1);
+            uprobe_metrics_add(uprobe_metrics, UPROBE_METRICS_LOST, label,
+                               lost);
+            break;
+        }
+        case UPROBE_STATS: {
+            const struct upipe_stats *stats =
+                va_arg(args_copy, const struct upipe_stats *);
+            uprobe_metrics_pipe_label(upipe, label);
+            uprobe_metrics_add(uprobe_metrics, UPROBE_METRICS_INPUT_UREFS,
+                               label, stats->urefs);
+            uprobe_metrics_add(uprobe_metrics, UPROBE_METRICS_INPUT_OCTETS,
+                               label, stats->octets);
+            uprobe_metrics_add(uprobe_metrics, UPROBE_METRICS_INPUT_TIME,
+                               label, stats->time);
+            break;
+        }
+        case UPROBE_ALLOC_STATS: {
+            const char *name = va_arg(args_copy, const char *);
+            const struct ualloc_stats *stats =
+                va_arg(args_copy, const struct ualloc_stats *);
+            snprintf(label, sizeof(label), "%s", name);
+            uprobe_metrics_set(uprobe_metrics, UPROBE_METRICS_ALLOC_HITS,
+                               label, stats->hits);
+            uprobe_metrics_set(uprobe_metrics, UPROBE_METRICS_ALLOC_MISSES,
+                               label, stats->misses);
+            uprobe_metrics_set(uprobe_metrics, UPROBE_METRICS_ALLOC_RETAINED,
+                               label, stats->retained_bytes);
+            break;
+        }
+        default:
+            uprobe_metrics_pipe_label(upipe, label);
+            uprobe_metrics_add(uprobe_metrics, id, label, 1);
+            break;
+    }
+    va_end(args_copy);
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+/** @internal @This is a sample aggregated over all shards. */
+struct uprobe_metrics_sample {
+    /** identifier of the metric */
+    unsigned int id;
+    /** value of the label */
+    const char *label;
+    /** value */
+    uint64_t value;
+};
+
+/** @internal @This compares two samples.
+ *
+ * @param a pointer to the first sample
+ * @param b pointer to the second sample
+ * @return an integer less than, equal to or greater than zero
+ */
+static int uprobe_metrics_sample_cmp(const void *a, const void *b)
+{
+    const struct uprobe_metrics_sample *sa = a, *sb = b;
+    if (sa->id != sb->id)
+        return sa->id < sb->id ? -1 : 1;
+    return strcmp(sa->label, sb->label);
+}
+
+/** @internal @This writes a label value, escaped.
+ *
+ * @param file stream to write to
+ * @param label value of the label
+ */
+static void uprobe_metrics_print_label(FILE *file, const char *label)
+{
+    for (const char *c = label; *c; c++) {
+        if (*c == '\\' || *c == '"')
+            fputc('\\', file);
+        if (*c == '\n')
+            fputs("\\n", file);
+        else
+            fputc(*c, file);
+    }
+}
+
+/** @This writes the current metrics in the Prometheus text exposition
+ * format.
+ *
+ * @param uprobe pointer to probe
+ * @param file stream to write to
+ * @return an error code
+ */
+int uprobe_metrics_print(struct uprobe *uprobe, FILE *file)
+{
+    struct uprobe_metrics *uprobe_metrics =
+        uprobe_metrics_from_uprobe(uprobe);
+    struct uprobe_metrics_shard *shards =
+        uatomic_ptr_load_ptr(&uprobe_metrics->shards,
+                             struct uprobe_metrics_shard *);
+    size_t nb = 0;
+    uint64_t overflows = 0;
+    for (struct uprobe_metrics_shard *shard = shards; shard != NULL;
+         shard = shard->next)
+        nb += UPROBE_METRICS_SHARD_SIZE;
+
+    struct uprobe_metrics_sample *samples =
+        malloc(nb * sizeof(struct uprobe_metrics_sample) + 1);
+    UBASE_ALLOC_RETURN(samples)
+    nb = 0;
+    for (struct uprobe_metrics_shard *shard = shards; shard != NULL;
+         shard = shard->next) {
+        overflows += shard->overflows;
+        for (int i = 0; i < UPROBE_METRICS_SHARD_SIZE; i++) {
+            struct uprobe_metrics_entry *entry = &shard->entries[i];
+            uint32_t state = uatomic_load(&entry->state);
+            if (!state)
+                continue;
+            samples[nb].id = state - 1;
+            samples[nb].label = entry->label;
+            samples[nb].value = entry->value;
+            nb++;
+        }
+    }
+    qsort(samples, nb, sizeof(struct uprobe_metrics_sample),
+          uprobe_metrics_sample_cmp);
+
+    unsigned int id = UPROBE_METRICS_NB;
+    for (size_t i = 0; i < nb; i++) {
+        uint64_t value = samples[i].value;
+        while (i + 1 < nb && !uprobe_metrics_sample_cmp(&samples[i],
+                                                        &samples[i + 1]))
+            value += samples[++i].value;
+
+        if (samples[i].id != id) {
+            id = samples[i].id;
+            fprintf(file, "# HELP %s %s\n# TYPE %s %s\n",
+                    uprobe_metrics_defs[id].name,
+                    uprobe_metrics_defs[id].help,
+                    uprobe_metrics_defs[id].name,
+                    uprobe_metrics_defs[id].gauge ? "gauge" : "counter");
+        }
+        fprintf(file, "%s{%s=\"", uprobe_metrics_defs[id].name,
+                uprobe_metrics_defs[id].label);
+        uprobe_metrics_print_label(file, samples[i].label);
+        if (uprobe_metrics_defs[id].time)
+            fprintf(file, "\"} %.6f\n", (double)value / UCLOCK_FREQ);
+        else
+            fprintf(file, "\"} %"PRIu64"\n", value);
+    }
+    free(samples);
+
+    fprintf(file, "# HELP upipe_metrics_overflows_total "
+            "Updates dropped because a shard was full.\n"
+            "# TYPE upipe_metrics_overflows_total counter\n"
+            "upipe_metrics_overflows_total %"PRIu64"\n", overflows);
+    return ferror(file) ? UBASE_ERR_EXTERNAL : UBASE_ERR_NONE;
+}
+
+/** @internal @This closes an HTTP connection.
+ *
+ * @param conn pending connection
+ */
+static void uprobe_metrics_conn_free(struct uprobe_metrics_conn *conn)
+{
+    ulist_delete(&conn->uchain);
+    upump_stop(conn->upump);
+    upump_free(conn->upump);
+    close(conn->fd);
+    free(conn);
+}
+
+/** @internal @This writes a buffer to a socket, giving up after a
+ * timeout.
+ *
+ * @param fd socket
+ * @param buffer buffer to write
+ * @param size size of the buffer
+ * @return false in case of error
+ */
+static bool uprobe_metrics_conn_write(int fd, const char *buffer, size_t size)
+{
+    while (size) {
+        ssize_t ret = send(fd, buffer, size, 0);
+        if (ret < 0)
+            return false;
+        buffer += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+/** @internal @This answers an HTTP request.
+ *
+ * @param conn pending connection
+ */
+static void uprobe_metrics_conn_answer(struct uprobe_metrics_conn *conn)
+{
+    char *body = NULL;
+    size_t size = 0;
+    bool get = !strncmp(conn->request, "GET ", 4);
+    FILE *file = open_memstream(&body, &size);
+    if (unlikely(file == NULL))
+        return;
+    if (get)
+        uprobe_metrics_print(
+                uprobe_metrics_to_uprobe(conn->uprobe_metrics), file);
+    fclose(file);
+
+    char header[256];
+    int len = snprintf(header, sizeof(header),
+            "HTTP/1.0 %s\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: %zu\r\n"
+            "Connection: close\r\n\r\n",
+            get ? "200 OK" : "405 Method Not Allowed", size);
+
+    /* the answer is small, write it at once with a bounded wait */
+    struct timeval tv = { .tv_sec = 1, .tv_usec = 0 };
+    fcntl(conn->fd, F_SETFL, fcntl(conn->fd, F_GETFL) & ~O_NONBLOCK);
+    setsockopt(conn->fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    if (uprobe_metrics_conn_write(conn->fd, header, len))
+        uprobe_metrics_conn_write(conn->fd, body, size);
+    free(body);
+}
+
+/** @internal @This reads an HTTP request, and answers it once complete.
+ *
+ * @param upump description structure of the pump
+ */
+static void uprobe_metrics_conn_read(struct upump *upump)
+{
+    struct uprobe_metrics_conn *conn =
+        upump_get_opaque(upump, struct uprobe_metrics_conn *);
+    ssize_t ret = recv(conn->fd, conn->request + conn->size,
+                       sizeof(conn->request) - 1 - conn->size, 0);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+                    errno == EINTR))
+        return;
+    if (ret > 0) {
+        conn->size += ret;
+        conn->request[conn->size] = '\0';
+        if (strstr(conn->request, "\r\n\r\n") == NULL &&
+            conn->size < sizeof(conn->request) - 1)
+            return;
+        uprobe_metrics_conn_answer(conn);
+    }
+    uprobe_metrics_conn_free(conn);
+}
+
+/** @internal @This accepts an HTTP connection.
+ *
+ * @param upump description structure of the pump
+ */
+static void uprobe_metrics_accept(struct upump *upump)
+{
+    struct uprobe_metrics *uprobe_metrics =
+        upump_get_opaque(upump, struct uprobe_metrics *);
+    int fd = accept(uprobe_metrics->fd, NULL, NULL);
+    if (fd < 0)
+        return;
+
+    struct uprobe_metrics_conn *conn =
+        malloc(sizeof(struct uprobe_metrics_conn));
+    if (unlikely(conn == NULL)) {
+        close(fd);
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    conn->uprobe_metrics = uprobe_metrics;
+    conn->fd = fd;
+    conn->size = 0;
+    conn->upump = upump_alloc_fd_read(upump->mgr, uprobe_metrics_conn_read,
+                                      conn, NULL, fd);
+    if (unlikely(conn->upump == NULL)) {
+        close(fd);
+        free(conn);
+        return;
+    }
+    uchain_init(&conn->uchain);
+    ulist_add(&uprobe_metrics->conns, &conn->uchain);
+    upump_start(conn->upump);
+}
+
+/** @This starts a minimal HTTP listener answering every GET request with
+ * the current metrics.
+ *
+ * @param uprobe pointer to probe
+ * @param upump_mgr manager of the pumps of the listener
+ * @param node address to bind to, or NULL for all addresses
+ * @param service port to bind to
+ * @return an error code
+ */
+int uprobe_metrics_listen(struct uprobe *uprobe, struct upump_mgr *upump_mgr,
+                          const char *node, const char *service)
+{
+    struct uprobe_metrics *uprobe_metrics =
+        uprobe_metrics_from_uprobe(uprobe);
+    if (uprobe_metrics->fd != -1)
+        return UBASE_ERR_BUSY;
+
+    struct addrinfo hints, *res;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(node, service, &hints, &res))
+        return UBASE_ERR_INVALID;
+
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+        int opt = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        if (!bind(fd, ai->ai_addr, ai->ai_addrlen) && !listen(fd, 16))
+            break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0)
+        return UBASE_ERR_EXTERNAL;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    uprobe_metrics->upump = upump_alloc_fd_read(upump_mgr,
+            uprobe_metrics_accept, uprobe_metrics, NULL, fd);
+    if (unlikely(uprobe_metrics->upump == NULL)) {
+        close(fd);
+        return UBASE_ERR_UPUMP;
+    }
+    uprobe_metrics->fd = fd;
+    upump_start(uprobe_metrics->upump);
+    return UBASE_ERR_NONE;
+}
+
+/** @This initializes an already allocated uprobe_metrics structure.
+ *
+ * @param uprobe_metrics pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_metrics_init(struct uprobe_metrics *uprobe_metrics,
+                                   struct uprobe *next)
+{
+    assert(uprobe_metrics != NULL);
+    struct uprobe *uprobe = uprobe_metrics_to_uprobe(uprobe_metrics);
+    if (unlikely(pthread_key_create(&uprobe_metrics->key, NULL)))
+        return NULL;
+    uatomic_ptr_init(&uprobe_metrics->shards, NULL);
+    uprobe_metrics->fd = -1;
+    uprobe_metrics->upump = NULL;
+    ulist_init(&uprobe_metrics->conns);
+    uprobe_init(uprobe, uprobe_metrics_throw, next);
+    return uprobe;
+}
+
+/** @This cleans a uprobe_metrics structure.
+ *
+ * @param uprobe_metrics structure to clean
+ */
+void uprobe_metrics_clean(struct uprobe_metrics *uprobe_metrics)
+{
+    assert(uprobe_metrics != NULL);
+    struct uprobe *uprobe = uprobe_metrics_to_uprobe(uprobe_metrics);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&uprobe_metrics->conns, uchain, uchain_tmp)
+        uprobe_metrics_conn_free(uprobe_metrics_conn_from_uchain(uchain));
+    if (uprobe_metrics->upump != NULL) {
+        upump_stop(uprobe_metrics->upump);
+        upump_free(uprobe_metrics->upump);
+        close(uprobe_metrics->fd);
+    }
+
+    struct uprobe_metrics_shard *shard =
+        uatomic_ptr_load_ptr(&uprobe_metrics->shards,
+                             struct uprobe_metrics_shard *);
+    while (shard != NULL) {
+        struct uprobe_metrics_shard *next = shard->next;
+        for (int i = 0; i < UPROBE_METRICS_SHARD_SIZE; i++)
+            uatomic_clean(&shard->entries[i].state);
+        free(shard);
+        shard = next;
+    }
+    uatomic_ptr_clean(&uprobe_metrics->shards);
+    pthread_key_delete(uprobe_metrics->key);
+    uprobe_clean(uprobe);
+}
+
+#define ARGS_DECL struct uprobe *next
+#define ARGS next
+UPROBE_HELPER_ALLOC(uprobe_metrics)
+#undef ARGS
+#undef ARGS_DECL
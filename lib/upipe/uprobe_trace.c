@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short probe aggregating latency traces into per-stage breakdowns
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_trace.h"
+#include "upipe/uprobe_helper_alloc.h"
+#include "upipe/upipe_stats.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+
+/** @internal @This is the latency between two consecutive stages. */
+struct uprobe_trace_hop {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** name of the former stage */
+    char *from;
+    /** name of the latter stage */
+    char *to;
+    /** number of traces since the last breakdown */
+    uint64_t count;
+    /** sum of the latencies since the last breakdown */
+    uint64_t sum;
+    /** maximum latency since the last breakdown */
+    uint64_t max;
+};
+
+UBASE_FROM_TO(uprobe_trace_hop, uchain, uchain, uchain)
+
+/** @internal @This finds or allocates the hop between two stages.
+ *
+ * @param uprobe_trace private structure of the probe
+ * @param from name of the former stage
+ * @param from_len length of the name of the former stage
+ * @param to name of the latter stage
+ * @param to_len length of the name of the latter stage
+ * @return pointer to hop, or NULL in case of allocation error
+ */
+static struct uprobe_trace_hop *
+    uprobe_trace_hop_get(struct uprobe_trace *uprobe_trace,
+                         const char *from, size_t from_len,
+                         const char *to, size_t to_len)
+{
+    struct uchain *uchain;
+    ulist_foreach (&uprobe_trace->hops, uchain) {
+        struct uprobe_trace_hop *hop = uprobe_trace_hop_from_uchain(uchain);
+        if (!strncmp(hop->from, from, from_len) && !hop->from[from_len] &&
+            !strncmp(hop->to, to, to_len) && !hop->to[to_len])
+            return hop;
+    }
+
+    struct uprobe_trace_hop *hop = malloc(sizeof(struct uprobe_trace_hop));
+    if (unlikely(hop == NULL))
+        return NULL;
+    hop->from = strndup(from, from_len);
+    hop->to = strndup(to, to_len);
+    if (unlikely(hop->from == NULL || hop->to == NULL)) {
+        free(hop->from);
+        free(hop->to);
+        free(hop);
+        return NULL;
+    }
+    hop->count = hop->sum = hop->max = 0;
+    uchain_init(&hop->uchain);
+    ulist_add(&uprobe_trace->hops, &hop->uchain);
+    return hop;
+}
+
+/** @internal @This accumulates a latency.
+ *
+ * @param count_p pointer to the number of latencies
+ * @param sum_p pointer to the sum of latencies
+ * @param max_p pointer to the maximum latency
+ * @param latency latency to accumulate
+ */
+static void uprobe_trace_account(uint64_t *count_p, uint64_t *sum_p,
+                                 uint64_t *max_p, uint64_t latency)
+{
+    (*count_p)++;
+    *sum_p += latency;
+    if (latency > *max_p)
+        *max_p = latency;
+}
+
+/** @internal @This logs the breakdown of the latencies and resets them.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to the reporting pipe
+ */
+static void uprobe_trace_report(struct uprobe *uprobe, struct upipe *upipe)
+{
+    struct uprobe_trace *uprobe_trace = uprobe_trace_from_uprobe(uprobe);
+    struct uchain *uchain;
+    ulist_foreach (&uprobe_trace->hops, uchain) {
+        struct uprobe_trace_hop *hop = uprobe_trace_hop_from_uchain(uchain);
+        if (!hop->count)
+            continue;
+        uprobe_notice_va(uprobe, upipe,
+                "latency %s -> %s: avg %.3f ms, max %.3f ms (%"PRIu64")",
+                hop->from, hop->to,
+                (double)hop->sum / hop->count * 1000 / UCLOCK_FREQ,
+                (double)hop->max * 1000 / UCLOCK_FREQ, hop->count);
+        hop->count = hop->sum = hop->max = 0;
+    }
+    uprobe_notice_va(uprobe, upipe,
+            "latency end-to-end: avg %.3f ms, max %.3f ms (%u)",
+            (double)uprobe_trace->sum / uprobe_trace->count * 1000 /
+            UCLOCK_FREQ,
+            (double)uprobe_trace->max * 1000 / UCLOCK_FREQ,
+            uprobe_trace->count);
+    uprobe_trace->count = 0;
+    uprobe_trace->sum = uprobe_trace->max = 0;
+}
+
+/** @internal @This catches events thrown by pipes.
+ *
+ * @param uprobe pointer to probe
+ * @param upipe pointer to pipe throwing the event
+ * @param event event thrown
+ * @param args optional event-specific parameters
+ * @return an error code
+ */
+static int uprobe_trace_throw(struct uprobe *uprobe, struct upipe *upipe,
+                              int event, va_list args)
+{
+    struct uprobe_trace *uprobe_trace = uprobe_trace_from_uprobe(uprobe);
+    if (event != UPROBE_TRACE)
+        return uprobe_throw_next(uprobe, upipe, event, args);
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    struct uref *uref = va_arg(args_copy, struct uref *);
+    va_end(args_copy);
+
+    const uint8_t *trace;
+    size_t size;
+    UBASE_RETURN(uref_stats_get_trace(uref, &trace, &size))
+
+    size_t offset = 0;
+    const char *stage, *prev_stage = NULL;
+    size_t stage_len, prev_stage_len = 0;
+    uint64_t date, prev_date = 0, first_date = 0;
+    while (upipe_stats_trace_iterate(trace, size, &offset,
+                                     &stage, &stage_len, &date)) {
+        if (prev_stage == NULL)
+            first_date = date;
+        else {
+            struct uprobe_trace_hop *hop =
+                uprobe_trace_hop_get(uprobe_trace, prev_stage, prev_stage_len,
+                                     stage, stage_len);
+            if (unlikely(hop == NULL))
+                return UBASE_ERR_ALLOC;
+            uprobe_trace_account(&hop->count, &hop->sum, &hop->max,
+                                 date > prev_date ? date - prev_date : 0);
+        }
+        prev_stage = stage;
+        prev_stage_len = stage_len;
+        prev_date = date;
+    }
+    if (prev_stage == NULL)
+        return UBASE_ERR_INVALID;
+
+    uint64_t latency = prev_date > first_date ? prev_date - first_date : 0;
+    uprobe_trace->count++;
+    uprobe_trace->sum += latency;
+    if (latency > uprobe_trace->max)
+        uprobe_trace->max = latency;
+    if (uprobe_trace->count >= uprobe_trace->period)
+        uprobe_trace_report(uprobe, upipe);
+    return UBASE_ERR_NONE;
+}
+
+/** @This initializes an already allocated uprobe_trace structure.
+ *
+ * @param uprobe_trace pointer to the already allocated structure
+ * @param next next probe to test if this one doesn't catch the event
+ * @param period number of traces between two breakdowns, or 0 for the
+ * default
+ * @return pointer to uprobe, or NULL in case of error
+ */
+struct uprobe *uprobe_trace_init(struct uprobe_trace *uprobe_trace,
+                                 struct uprobe *next, unsigned int period)
+{
+    assert(uprobe_trace != NULL);
+    struct uprobe *uprobe = uprobe_trace_to_uprobe(uprobe_trace);
+    uprobe_trace->period = period ? period : UPROBE_TRACE_DEF_PERIOD;
+    uprobe_trace->count = 0;
+    uprobe_trace->sum = uprobe_trace->max = 0;
+    ulist_init(&uprobe_trace->hops);
+    uprobe_init(uprobe, uprobe_trace_throw, next);
+    return uprobe;
+}
+
+/** @This cleans a uprobe_trace structure.
+ *
+ * @param uprobe_trace structure to clean
+ */
+void uprobe_trace_clean(struct uprobe_trace *uprobe_trace)
+{
+    assert(uprobe_trace != NULL);
+    struct uprobe *uprobe = uprobe_trace_to_uprobe(uprobe_trace);
+    struct uchain *uchain, *uchain_tmp;
+    ulist_delete_foreach (&uprobe_trace->hops, uchain, uchain_tmp) {
+        struct uprobe_trace_hop *hop = uprobe_trace_hop_from_uchain(uchain);
+        ulist_delete(uchain);
+        free(hop->from);
+        free(hop->to);
+        free(hop);
+    }
+    uprobe_clean(uprobe);
+}
+
+#define ARGS_DECL struct uprobe *next, unsigned int period
+#define ARGS next, period
+UPROBE_HELPER_ALLOC(uprobe_trace)
+#undef ARGS
+#undef ARGS_DECL
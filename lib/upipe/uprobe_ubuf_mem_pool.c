@@ -31,6 +31,7 @@
 #include "upipe/umem.h"
 #include "upipe/ubuf.h"
 #include "upipe/ubuf_mem.h"
+#include "upipe/ualloc_stats.h"
 #include "upipe/uprobe.h"
 #include "upipe/uprobe_ubuf_mem_pool.h"
 #include "upipe/uprobe_helper_alloc.h"
@@ -38,6 +39,11 @@
 #include <stdlib.h>
 #include <stdarg.h>
 
+/** initial and minimal depth of a pool in adaptive mode */
+#define ADAPTIVE_MIN_LIMIT 4
+/** a pool grows when more than 1/ADAPTIVE_MISS_RATIO of its allocations miss */
+#define ADAPTIVE_MISS_RATIO 16
+
 /** @This is a manager registered into the probe as a thread-safe linked list.
  */
 struct uprobe_ubuf_mem_pool_element {
@@ -45,8 +51,31 @@ struct uprobe_ubuf_mem_pool_element {
     struct ubuf_mgr *ubuf_mgr;
     /** pointer to next element */
     uatomic_ptr_t next;
+
+    /** current depth of the pools */
+    unsigned int limit;
+    /** number of allocations at the previous adaptation */
+    uint32_t last_allocs;
+    /** number of misses at the previous adaptation */
+    uint32_t last_misses;
+    /** date of the last adaptation with allocations, or UINT64_MAX */
+    uint64_t last_activity;
 };
 
+/** @internal @This returns the maximum depth of the pools.
+ *
+ * @param uprobe_ubuf_mem_pool pointer to probe
+ * @return maximum depth of the pools
+ */
+static inline unsigned int
+    uprobe_ubuf_mem_pool_max_limit(struct uprobe_ubuf_mem_pool *uprobe_ubuf_mem_pool)
+{
+    return uprobe_ubuf_mem_pool->ubuf_pool_depth >
+           uprobe_ubuf_mem_pool->shared_pool_depth ?
+           uprobe_ubuf_mem_pool->ubuf_pool_depth :
+           uprobe_ubuf_mem_pool->shared_pool_depth;
+}
+
 /** @internal @This catches events thrown by pipes.
  *
  * @param uprobe pointer to probe
@@ -113,6 +142,14 @@ static int uprobe_ubuf_mem_pool_throw(struct uprobe *uprobe,
 
         new_elem->ubuf_mgr = ubuf_mgr;
         uatomic_ptr_init(&new_elem->next, NULL);
+        new_elem->limit = uprobe_ubuf_mem_pool_max_limit(uprobe_ubuf_mem_pool);
+        new_elem->last_allocs = new_elem->last_misses = 0;
+        new_elem->last_activity = UINT64_MAX;
+        if (uprobe_ubuf_mem_pool->budget &&
+            new_elem->limit > ADAPTIVE_MIN_LIMIT) {
+            new_elem->limit = ADAPTIVE_MIN_LIMIT;
+            ubuf_mgr_set_pool_limit(ubuf_mgr, new_elem->limit);
+        }
         if (likely(uatomic_ptr_compare_exchange_ptr(elem_p, &elem, new_elem)))
             return urequest_provide_ubuf_mgr(urequest, ubuf_mgr_use(ubuf_mgr),
                                              uref);
@@ -144,6 +181,8 @@ struct uprobe *
     uprobe_ubuf_mem_pool->umem_mgr = umem_mgr_use(umem_mgr);
     uprobe_ubuf_mem_pool->ubuf_pool_depth = ubuf_pool_depth;
     uprobe_ubuf_mem_pool->shared_pool_depth = shared_pool_depth;
+    uprobe_ubuf_mem_pool->budget = 0;
+    uprobe_ubuf_mem_pool->idle_timeout = UINT64_MAX;
     uatomic_ptr_init(&uprobe_ubuf_mem_pool->first, NULL);
     uprobe_init(uprobe, uprobe_ubuf_mem_pool_throw, next);
     return uprobe;
@@ -206,3 +245,93 @@ void uprobe_ubuf_mem_pool_set(struct uprobe *uprobe, struct umem_mgr *umem_mgr)
     umem_mgr_release(uprobe_ubuf_mem_pool->umem_mgr);
     uprobe_ubuf_mem_pool->umem_mgr = umem_mgr_use(umem_mgr);
 }
+
+/** @This enables the adaptive sizing of the pools of the managers.
+ *
+ * @param uprobe pointer to probe
+ * @param budget memory budget of the pools, in octets, or 0 to disable
+ * @param idle_timeout delay after which the pools of an idle manager are
+ * released
+ */
+void uprobe_ubuf_mem_pool_set_adaptive(struct uprobe *uprobe, uint64_t budget,
+                                       uint64_t idle_timeout)
+{
+    struct uprobe_ubuf_mem_pool *uprobe_ubuf_mem_pool =
+        uprobe_ubuf_mem_pool_from_uprobe(uprobe);
+    uprobe_ubuf_mem_pool->budget = budget;
+    uprobe_ubuf_mem_pool->idle_timeout = idle_timeout;
+}
+
+/** @This adapts the depth of the pools of the managers to their allocation
+ * rate since the previous call.
+ *
+ * @param uprobe pointer to probe
+ * @param now current date
+ */
+void uprobe_ubuf_mem_pool_adapt(struct uprobe *uprobe, uint64_t now)
+{
+    struct uprobe_ubuf_mem_pool *uprobe_ubuf_mem_pool =
+        uprobe_ubuf_mem_pool_from_uprobe(uprobe);
+    if (!uprobe_ubuf_mem_pool->budget)
+        return;
+
+    unsigned int max_limit =
+        uprobe_ubuf_mem_pool_max_limit(uprobe_ubuf_mem_pool);
+    uint64_t retained_bytes = 0;
+    struct uprobe_ubuf_mem_pool_element *elem =
+        uatomic_ptr_load_ptr(&uprobe_ubuf_mem_pool->first,
+                             struct uprobe_ubuf_mem_pool_element *);
+    for ( ; elem != NULL;
+          elem = uatomic_ptr_load_ptr(&elem->next,
+                        struct uprobe_ubuf_mem_pool_element *)) {
+        struct ualloc_stats stats;
+        ualloc_stats_init(&stats);
+        if (ubase_check(ubuf_mgr_get_stats(elem->ubuf_mgr, &stats)))
+            retained_bytes += stats.retained_bytes;
+    }
+    bool over_budget = retained_bytes > uprobe_ubuf_mem_pool->budget;
+
+    elem = uatomic_ptr_load_ptr(&uprobe_ubuf_mem_pool->first,
+                                struct uprobe_ubuf_mem_pool_element *);
+    for ( ; elem != NULL;
+          elem = uatomic_ptr_load_ptr(&elem->next,
+                        struct uprobe_ubuf_mem_pool_element *)) {
+        struct ualloc_stats stats;
+        ualloc_stats_init(&stats);
+        if (!ubase_check(ubuf_mgr_get_stats(elem->ubuf_mgr, &stats)))
+            continue;
+
+        /* counters wrap around at 2^32 */
+        uint32_t allocs = (uint32_t)(stats.hits + stats.misses) -
+                          elem->last_allocs;
+        uint32_t misses = (uint32_t)stats.misses - elem->last_misses;
+        elem->last_allocs = stats.hits + stats.misses;
+        elem->last_misses = stats.misses;
+        if (allocs || elem->last_activity == UINT64_MAX)
+            elem->last_activity = now;
+
+        unsigned int limit = elem->limit;
+        if (over_budget) {
+            limit /= 2;
+        } else if (!allocs) {
+            if (now - elem->last_activity >=
+                    uprobe_ubuf_mem_pool->idle_timeout)
+                limit = 0;
+        } else if (misses > allocs / ADAPTIVE_MISS_RATIO) {
+            limit = limit < ADAPTIVE_MIN_LIMIT / 2 ?
+                    ADAPTIVE_MIN_LIMIT : limit * 2;
+        } else if (!misses && stats.retained > limit) {
+            limit -= limit / 4;
+        }
+        if (limit > max_limit)
+            limit = max_limit;
+        if (allocs && limit < ADAPTIVE_MIN_LIMIT && !over_budget)
+            limit = ADAPTIVE_MIN_LIMIT < max_limit ?
+                    ADAPTIVE_MIN_LIMIT : max_limit;
+
+        if (limit != elem->limit) {
+            elem->limit = limit;
+            ubuf_mgr_set_pool_limit(elem->ubuf_mgr, limit);
+        }
+    }
+}
@@ -32,8 +32,65 @@
 #include "upipe/upool.h"
 #include "upipe/upump_common.h"
 #include "upipe/upump_blocker.h"
+#include "upipe/uclock_std.h"
+#include "upipe/uprobe.h"
+#include "upipe/upipe.h"
+#include "upipe/usdt.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** number of bits of the index of a slot of the timer wheel */
+#define UPUMP_WHEEL_BITS 8
+/** number of slots per level of the timer wheel */
+#define UPUMP_WHEEL_SLOTS (1 << UPUMP_WHEEL_BITS)
+/** mask of the index of a slot of the timer wheel */
+#define UPUMP_WHEEL_MASK (UPUMP_WHEEL_SLOTS - 1)
+/** number of levels of the timer wheel, covering 2^32 microseconds */
+#define UPUMP_WHEEL_LEVELS 4
+/** number of words of the bitmap of a level */
+#define UPUMP_WHEEL_WORDS (UPUMP_WHEEL_SLOTS / 64)
+/** level of the timers on the list of expired timers */
+#define UPUMP_WHEEL_EXPIRED UINT8_MAX
+/** number of clock ticks in a microsecond */
+#define UPUMP_WHEEL_TICKS (UCLOCK_FREQ / 1000000)
+
+/** @This stores a hierarchical timer wheel, with a resolution of one
+ * microsecond. Slots of level n span 2^(8n) microseconds, and the timers of
+ * a slot of an upper level are moved to the lower levels when the wheel
+ * enters the slot. Only the instants where a slot has to be expired or moved
+ * are processed, and a single timer of the event loop is armed on the next
+ * one.
+ */
+struct upump_common_wheel {
+    /** pointer to the common manager */
+    struct upump_common_mgr *common_mgr;
+    /** system clock, if the manager does not provide one */
+    struct uclock *uclock_std;
+    /** next instant to process, in microseconds */
+    uint64_t current;
+    /** timer of the event loop driving the wheel, or NULL */
+    struct upump *driver;
+    /** deadline of the driving timer, or UINT64_MAX if it is not armed */
+    uint64_t driver_deadline;
+    /** blocking status of the driving timer */
+    bool driver_blocking;
+    /** true while expired timers are dispatched */
+    bool dispatching;
+    /** number of armed timers */
+    unsigned int nb_timers;
+    /** number of armed blocking timers */
+    unsigned int nb_blocking;
+    /** list of expired timers to dispatch */
+    struct uchain expired;
+    /** bitmaps of the non-empty slots */
+    uint64_t bitmaps[UPUMP_WHEEL_LEVELS][UPUMP_WHEEL_WORDS];
+    /** lists of timers */
+    struct uchain slots[UPUMP_WHEEL_LEVELS][UPUMP_WHEEL_SLOTS];
+};
+
+UBASE_FROM_TO(upump_common, uchain, wheel_uchain, wheel_timer.uchain)
 
 /** @This stores extra opaque structures for blockers.
  */
@@ -48,6 +105,9 @@ struct upump_blocker_common {
 UBASE_FROM_TO(upump_blocker_common, upump_blocker, upump_blocker, blocker)
 UBASE_FROM_TO(upump_blocker_common, uchain, uchain, uchain)
 
+static void upump_common_real_start(struct upump *upump, bool status);
+static void upump_common_real_stop(struct upump *upump, bool status);
+
 /** @This allocates and initializes a blocker.
  *
  * @param upump description structure of the pump
@@ -71,11 +131,8 @@ struct upump_blocker *upump_common_blocker_alloc(struct upump *upump)
     bool was_blocked = !ulist_empty(&common->blockers);
     ulist_add(&common->blockers,
               upump_blocker_common_to_uchain(blocker_common));
-    if (common->started && !was_blocked) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(upump->mgr);
-        common_mgr->upump_real_stop(upump, common->status);
-    }
+    if (common->started && !was_blocked)
+        upump_common_real_stop(upump, common->status);
     return blocker;
 }
 
@@ -92,11 +149,8 @@ void upump_common_blocker_free(struct upump_blocker *blocker)
     struct upump_common *common = upump_common_from_upump(blocker->upump);
 
     ulist_delete(upump_blocker_common_to_uchain(blocker_common));
-    if (common->started && ulist_empty(&common->blockers)) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(blocker->upump->mgr);
-        common_mgr->upump_real_start(blocker->upump, common->status);
-    }
+    if (common->started && ulist_empty(&common->blockers))
+        upump_common_real_start(blocker->upump, common->status);
 
     upool_free(&common_mgr->upump_blocker_pool, blocker_common);
 }
@@ -132,6 +186,530 @@ void upump_common_init(struct upump *upump)
     common->started = false;
     common->status = true;
     ulist_init(&common->blockers);
+    common->timer = false;
+    common->timer_deadline = 0;
+    common->wheel = false;
+    uchain_init(&common->wheel_timer.uchain);
+    common->wheel_timer.armed = false;
+    common->wheel_timer.blocking = false;
+}
+
+/** @This initializes the common part of a pump as a timer of the event loop
+ * (@ref UPUMP_TYPE_TIMER). It must be called after @ref upump_common_init.
+ *
+ * @param upump description structure of the pump
+ * @param after time after which it triggers, in 27 MHz ticks
+ * @param repeat period of the timer, in 27 MHz ticks (0 to disable)
+ */
+void upump_common_init_timer(struct upump *upump,
+                             uint64_t after, uint64_t repeat)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    common->timer = true;
+    common->timer_after = after;
+    common->timer_repeat = repeat;
+}
+
+/** @This initializes the common part of a pump as a timer of the timer wheel
+ * (@ref UPUMP_TYPE_WHEEL_TIMER). It must be called after
+ * @ref upump_common_init.
+ *
+ * @param upump description structure of the pump
+ * @param after time after which it triggers, in 27 MHz ticks
+ * @param repeat period of the timer, in 27 MHz ticks (0 to disable)
+ */
+void upump_common_init_wheel_timer(struct upump *upump,
+                                   uint64_t after, uint64_t repeat)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    upump_common_init_timer(upump, after, repeat);
+    common->wheel = true;
+    /* round up so that timers never trigger early */
+    common->wheel_timer.after =
+        (after + UPUMP_WHEEL_TICKS - 1) / UPUMP_WHEEL_TICKS;
+    common->wheel_timer.repeat =
+        (repeat + UPUMP_WHEEL_TICKS - 1) / UPUMP_WHEEL_TICKS;
+    common->wheel_timer.deadline = 0;
+}
+
+/** @internal @This returns the current time of the timer wheel.
+ *
+ * @param wheel pointer to the timer wheel
+ * @return current time in microseconds
+ */
+static uint64_t upump_common_wheel_now(struct upump_common_wheel *wheel)
+{
+    struct uclock *uclock = wheel->common_mgr->uclock;
+    if (uclock == NULL)
+        uclock = wheel->uclock_std;
+    return uclock_now(uclock) / UPUMP_WHEEL_TICKS;
+}
+
+/** @internal @This returns the first non-empty slot of a level, starting
+ * from a given index.
+ *
+ * @param bitmap bitmap of the non-empty slots of the level
+ * @param from index of the first slot to consider
+ * @return index of the slot, or -1 if there is none
+ */
+static int upump_common_wheel_find(const uint64_t *bitmap, unsigned int from)
+{
+    for (unsigned int word = from / 64; word < UPUMP_WHEEL_WORDS; word++) {
+        uint64_t bits = bitmap[word];
+        if (word == from / 64)
+            bits &= UINT64_MAX << (from % 64);
+        if (bits)
+            return word * 64 + __builtin_ctzll(bits);
+    }
+    return -1;
+}
+
+/** @internal @This inserts an armed timer in the slot matching its
+ * deadline.
+ *
+ * @param wheel pointer to the timer wheel
+ * @param common pointer to the common part of the pump
+ */
+static void upump_common_wheel_insert(struct upump_common_wheel *wheel,
+                                      struct upump_common *common)
+{
+    struct upump_common_wheel_timer *timer = &common->wheel_timer;
+    uint64_t deadline = timer->deadline > wheel->current ?
+                        timer->deadline : wheel->current;
+    uint64_t delta = deadline - wheel->current;
+    unsigned int level = 0;
+    while (level < UPUMP_WHEEL_LEVELS - 1 &&
+           delta >> (UPUMP_WHEEL_BITS * (level + 1)))
+        level++;
+    if (delta >> (UPUMP_WHEEL_BITS * UPUMP_WHEEL_LEVELS))
+        /* beyond the wheel, the timer will be moved again from the last
+         * slot */
+        deadline = wheel->current +
+            (UINT64_C(1) << (UPUMP_WHEEL_BITS * UPUMP_WHEEL_LEVELS)) - 1;
+
+    unsigned int slot = (deadline >> (UPUMP_WHEEL_BITS * level)) &
+                        UPUMP_WHEEL_MASK;
+    timer->level = level;
+    timer->slot = slot;
+    ulist_add(&wheel->slots[level][slot], &timer->uchain);
+    wheel->bitmaps[level][slot / 64] |= UINT64_C(1) << (slot % 64);
+}
+
+/** @internal @This removes an armed timer from its slot.
+ *
+ * @param wheel pointer to the timer wheel
+ * @param common pointer to the common part of the pump
+ */
+static void upump_common_wheel_remove(struct upump_common_wheel *wheel,
+                                      struct upump_common *common)
+{
+    struct upump_common_wheel_timer *timer = &common->wheel_timer;
+    ulist_delete(&timer->uchain);
+    if (timer->level != UPUMP_WHEEL_EXPIRED &&
+        ulist_empty(&wheel->slots[timer->level][timer->slot]))
+        wheel->bitmaps[timer->level][timer->slot / 64] &=
+            ~(UINT64_C(1) << (timer->slot % 64));
+}
+
+/** @internal @This returns the next instant the wheel has to process.
+ *
+ * @param wheel pointer to the timer wheel
+ * @return next instant in microseconds, or UINT64_MAX if the wheel is empty
+ */
+static uint64_t upump_common_wheel_next(struct upump_common_wheel *wheel)
+{
+    uint64_t next = UINT64_MAX;
+    for (unsigned int level = 0; level < UPUMP_WHEEL_LEVELS; level++) {
+        unsigned int shift = UPUMP_WHEEL_BITS * level;
+        uint64_t base = wheel->current >> shift;
+        unsigned int index = base & UPUMP_WHEEL_MASK;
+        /* the current slot of an upper level is only processed if the wheel
+         * has not entered it yet */
+        bool entering = !(wheel->current & ((UINT64_C(1) << shift) - 1));
+        int slot = upump_common_wheel_find(wheel->bitmaps[level],
+                                           entering ? index : index + 1);
+        if (slot < 0) {
+            slot = upump_common_wheel_find(wheel->bitmaps[level], 0);
+            if (slot < 0)
+                continue;
+            base += UPUMP_WHEEL_SLOTS;
+        }
+        uint64_t date = (base - index + slot) << shift;
+        if (date < next)
+            next = date;
+    }
+    return next;
+}
+
+/** @internal @This processes an instant, moving the timers of the upper
+ * levels and queueing the expired timers.
+ *
+ * @param wheel pointer to the timer wheel
+ * @param date instant to process, in microseconds
+ */
+static void upump_common_wheel_process(struct upump_common_wheel *wheel,
+                                       uint64_t date)
+{
+    wheel->current = date;
+    for (unsigned int level = UPUMP_WHEEL_LEVELS - 1; level > 0; level--) {
+        unsigned int shift = UPUMP_WHEEL_BITS * level;
+        if (date & ((UINT64_C(1) << shift) - 1))
+            continue;
+
+        unsigned int slot = (date >> shift) & UPUMP_WHEEL_MASK;
+        struct uchain timers;
+        ulist_init(&timers);
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&wheel->slots[level][slot])) != NULL)
+            ulist_add(&timers, uchain);
+        wheel->bitmaps[level][slot / 64] &= ~(UINT64_C(1) << (slot % 64));
+        while ((uchain = ulist_pop(&timers)) != NULL)
+            upump_common_wheel_insert(wheel,
+                                      upump_common_from_wheel_uchain(uchain));
+    }
+
+    unsigned int slot = date & UPUMP_WHEEL_MASK;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&wheel->slots[0][slot])) != NULL) {
+        upump_common_from_wheel_uchain(uchain)->wheel_timer.level =
+            UPUMP_WHEEL_EXPIRED;
+        ulist_add(&wheel->expired, uchain);
+    }
+    wheel->bitmaps[0][slot / 64] &= ~(UINT64_C(1) << (slot % 64));
+    wheel->current = date + 1;
+}
+
+static void upump_common_wheel_cb(struct upump *driver);
+
+/** @internal @This arms the timer of the event loop on the next instant
+ * to process, or frees it if the wheel is empty.
+ *
+ * @param wheel pointer to the timer wheel
+ */
+static void upump_common_wheel_schedule(struct upump_common_wheel *wheel)
+{
+    if (wheel->dispatching)
+        return;
+
+    struct upump *driver = wheel->driver;
+    uint64_t next = upump_common_wheel_next(wheel);
+    if (next == UINT64_MAX) {
+        wheel->driver = NULL;
+        wheel->driver_deadline = UINT64_MAX;
+        /* the timer holds a reference to the manager, so free it last */
+        if (driver != NULL)
+            upump_free(driver);
+        return;
+    }
+
+    bool blocking = wheel->nb_blocking > 0;
+    if (next >= wheel->driver_deadline && blocking == wheel->driver_blocking)
+        return;
+
+    uint64_t now = upump_common_wheel_now(wheel);
+    uint64_t after = next > now ? (next - now) * UPUMP_WHEEL_TICKS : 0;
+    wheel->driver =
+        upump_alloc_timer(upump_common_mgr_to_upump_mgr(wheel->common_mgr),
+                          upump_common_wheel_cb, wheel, NULL, after, 0);
+    if (driver != NULL)
+        upump_free(driver);
+    if (unlikely(wheel->driver == NULL)) {
+        wheel->driver_deadline = UINT64_MAX;
+        return;
+    }
+    wheel->driver_deadline = next;
+    wheel->driver_blocking = blocking;
+    upump_set_status(wheel->driver, blocking);
+    upump_start(wheel->driver);
+}
+
+/** @internal @This is called when the timer of the event loop triggers, and
+ * dispatches all the expired timers.
+ *
+ * @param driver timer of the event loop
+ */
+static void upump_common_wheel_cb(struct upump *driver)
+{
+    struct upump_common_wheel *wheel = driver->opaque;
+    uint64_t now = upump_common_wheel_now(wheel);
+    wheel->driver_deadline = UINT64_MAX;
+
+    uint64_t date;
+    while ((date = upump_common_wheel_next(wheel)) <= now)
+        upump_common_wheel_process(wheel, date);
+    if (wheel->current <= now)
+        wheel->current = now + 1;
+
+    wheel->dispatching = true;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&wheel->expired)) != NULL) {
+        struct upump_common *common = upump_common_from_wheel_uchain(uchain);
+        struct upump_common_wheel_timer *timer = &common->wheel_timer;
+        if (timer->repeat) {
+            /* do not try to catch up if the event loop was late */
+            timer->deadline += timer->repeat;
+            if (timer->deadline < now)
+                timer->deadline = now;
+            upump_common_wheel_insert(wheel, common);
+        } else {
+            timer->armed = false;
+            wheel->nb_timers--;
+            if (timer->blocking)
+                wheel->nb_blocking--;
+        }
+        upump_common_dispatch(upump_common_to_upump(common));
+    }
+    wheel->dispatching = false;
+    upump_common_wheel_schedule(wheel);
+}
+
+/** @internal @This returns the timer wheel of a manager, allocating it if
+ * needed.
+ *
+ * @param common_mgr pointer to the common manager
+ * @return pointer to the timer wheel, or NULL in case of allocation error
+ */
+static struct upump_common_wheel *
+    upump_common_wheel_get(struct upump_common_mgr *common_mgr)
+{
+    if (likely(common_mgr->wheel != NULL))
+        return common_mgr->wheel;
+
+    struct upump_common_wheel *wheel =
+        malloc(sizeof(struct upump_common_wheel));
+    if (unlikely(wheel == NULL))
+        return NULL;
+    wheel->uclock_std = NULL;
+    if (common_mgr->uclock == NULL) {
+        wheel->uclock_std = uclock_std_alloc(0);
+        if (unlikely(wheel->uclock_std == NULL)) {
+            free(wheel);
+            return NULL;
+        }
+    }
+    wheel->common_mgr = common_mgr;
+    wheel->current = 0;
+    wheel->driver = NULL;
+    wheel->driver_deadline = UINT64_MAX;
+    wheel->driver_blocking = false;
+    wheel->dispatching = false;
+    wheel->nb_timers = 0;
+    wheel->nb_blocking = 0;
+    ulist_init(&wheel->expired);
+    for (unsigned int level = 0; level < UPUMP_WHEEL_LEVELS; level++) {
+        for (unsigned int word = 0; word < UPUMP_WHEEL_WORDS; word++)
+            wheel->bitmaps[level][word] = 0;
+        for (unsigned int slot = 0; slot < UPUMP_WHEEL_SLOTS; slot++)
+            ulist_init(&wheel->slots[level][slot]);
+    }
+    common_mgr->wheel = wheel;
+    return wheel;
+}
+
+/** @internal @This arms a timer of the timer wheel.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ * @param delay delay before the timer triggers, in microseconds
+ */
+static void upump_common_wheel_start(struct upump *upump, bool status,
+                                     uint64_t delay)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_wheel_timer *timer = &common->wheel_timer;
+    struct upump_common_wheel *wheel =
+        upump_common_wheel_get(upump_common_mgr_from_upump_mgr(upump->mgr));
+    if (unlikely(wheel == NULL))
+        return;
+
+    uint64_t now = upump_common_wheel_now(wheel);
+    if (!wheel->nb_timers && wheel->current < now)
+        /* the wheel is empty, skip the elapsed time */
+        wheel->current = now;
+    timer->deadline = now + delay;
+    upump_common_wheel_insert(wheel, common);
+    timer->armed = true;
+    timer->blocking = status;
+    wheel->nb_timers++;
+    if (status)
+        wheel->nb_blocking++;
+    upump_common_wheel_schedule(wheel);
+}
+
+/** @internal @This disarms a timer of the timer wheel.
+ *
+ * @param upump description structure of the pump
+ * @param schedule true to update the timer of the event loop
+ */
+static void upump_common_wheel_stop(struct upump *upump, bool schedule)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_wheel_timer *timer = &common->wheel_timer;
+    struct upump_common_wheel *wheel =
+        upump_common_mgr_from_upump_mgr(upump->mgr)->wheel;
+    if (!timer->armed)
+        return;
+
+    upump_common_wheel_remove(wheel, common);
+    timer->armed = false;
+    wheel->nb_timers--;
+    if (timer->blocking)
+        wheel->nb_blocking--;
+    if (schedule)
+        upump_common_wheel_schedule(wheel);
+}
+
+/** @internal @This returns the current time of the monitoring of the event
+ * loop.
+ *
+ * @param common_mgr pointer to the common manager
+ * @return current time in 27 MHz ticks
+ */
+static uint64_t upump_common_monitor_now(struct upump_common_mgr *common_mgr)
+{
+    if (common_mgr->uclock != NULL)
+        return uclock_now(common_mgr->uclock);
+    struct timespec ts;
+    if (unlikely(clock_gettime(CLOCK_MONOTONIC, &ts) == -1))
+        return 0;
+    return ts.tv_sec * UCLOCK_FREQ +
+           ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @internal @This records the expected expiry of a timer which is being
+ * armed, if the event loop is monitored.
+ *
+ * @param upump description structure of the pump
+ * @param delay delay before the timer triggers, in 27 MHz ticks
+ */
+static void upump_common_monitor_arm(struct upump *upump, uint64_t delay)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (!common->timer || !common_mgr->monitor_threshold)
+        return;
+    common->timer_deadline = upump_common_monitor_now(common_mgr) + delay;
+}
+
+/** @internal @This really starts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_common_real_start(struct upump *upump, bool status)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    upump_common_monitor_arm(upump, common->timer_after);
+    if (common->wheel) {
+        upump_common_wheel_start(upump, status, common->wheel_timer.after);
+        return;
+    }
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    common_mgr->upump_real_start(upump, status);
+}
+
+/** @internal @This really restarts a pump. Timers of the timer wheel are
+ * rearmed with their period, or their initial delay if they have none.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_common_real_restart(struct upump *upump, bool status)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    upump_common_monitor_arm(upump, common->timer_repeat ?:
+                                    common->timer_after);
+    if (common->wheel) {
+        upump_common_wheel_stop(upump, false);
+        upump_common_wheel_start(upump, status,
+                                 common->wheel_timer.repeat ?:
+                                 common->wheel_timer.after);
+        return;
+    }
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    common_mgr->upump_real_restart(upump, status);
+}
+
+/** @internal @This really stops a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_common_real_stop(struct upump *upump, bool status)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    if (common->wheel) {
+        upump_common_wheel_stop(upump, true);
+        return;
+    }
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    common_mgr->upump_real_stop(upump, status);
+}
+
+/** @internal @This dispatches a pump while monitoring the event loop. The
+ * pump may be freed by its callback, so everything needed afterwards is
+ * read before.
+ *
+ * @param upump description structure of the pump
+ * @param common_mgr pointer to the common manager
+ */
+static void upump_common_dispatch_monitor(struct upump *upump,
+        struct upump_common_mgr *common_mgr)
+{
+    struct upump_common *common = upump_common_from_upump(upump);
+    struct upump_mgr *mgr = upump_mgr_use(upump->mgr);
+    struct upipe *upipe = upump->upipe;
+    struct urefcount *refcount = urefcount_use(upump->refcount);
+    uint64_t nested = common_mgr->monitor_nested;
+    common_mgr->monitor_nested = 0;
+
+    uint64_t begin = upump_common_monitor_now(common_mgr);
+    uint64_t lag = 0;
+    if (common->timer_deadline) {
+        if (begin > common->timer_deadline)
+            lag = begin - common->timer_deadline;
+        if (common->timer_repeat) {
+            common->timer_deadline += common->timer_repeat;
+            /* like the event loops, do not try to catch up */
+            if (common->timer_deadline < begin)
+                common->timer_deadline = begin;
+        } else
+            common->timer_deadline = 0;
+        common_mgr->health.timers++;
+        common_mgr->health.lag += lag;
+        if (lag > common_mgr->health.max_lag)
+            common_mgr->health.max_lag = lag;
+    }
+
+    UPIPE_USDT(dispatch, upump, upump->cb);
+    upump->cb(upump);
+    UPIPE_USDT(dispatch_end, upump);
+
+    uint64_t end = upump_common_monitor_now(common_mgr);
+    uint64_t duration = end > begin ? end - begin : 0;
+    uint64_t time = duration > common_mgr->monitor_nested ?
+                    duration - common_mgr->monitor_nested : 0;
+    common_mgr->monitor_nested = nested + duration;
+    common_mgr->health.dispatches++;
+    common_mgr->health.time += time;
+    if (time > common_mgr->health.max_time)
+        common_mgr->health.max_time = time;
+
+    uint64_t threshold = common_mgr->monitor_threshold;
+    if (threshold && (time > threshold || lag > threshold)) {
+        common_mgr->health.slow++;
+        if (upipe != NULL)
+            upipe_throw_slow_upump(upipe, time, lag);
+        else if (common_mgr->monitor_uprobe != NULL)
+            uprobe_throw(common_mgr->monitor_uprobe, NULL,
+                         UPROBE_SLOW_UPUMP, time, lag);
+    }
+    urefcount_release(refcount);
+    upump_mgr_release(mgr);
 }
 
 /** @This dispatches a pump.
@@ -140,8 +718,17 @@ void upump_common_init(struct upump *upump)
  */
 void upump_common_dispatch(struct upump *upump)
 {
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_mgr(upump->mgr);
+    if (unlikely(common_mgr->monitor_threshold)) {
+        upump_common_dispatch_monitor(upump, common_mgr);
+        return;
+    }
+
     struct urefcount *refcount = urefcount_use(upump->refcount);
+    UPIPE_USDT(dispatch, upump, upump->cb);
     upump->cb(upump);
+    UPIPE_USDT(dispatch_end, upump);
     urefcount_release(refcount);
 }
 
@@ -155,11 +742,8 @@ void upump_common_start(struct upump *upump)
     if (common->started)
         return;
     common->started = true;
-    if (ulist_empty(&common->blockers)) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(upump->mgr);
-        common_mgr->upump_real_start(upump, common->status);
-    }
+    if (ulist_empty(&common->blockers))
+        upump_common_real_start(upump, common->status);
 }
 
 /** @This restarts a pump if allowed.
@@ -170,11 +754,8 @@ void upump_common_restart(struct upump *upump)
 {
     struct upump_common *common = upump_common_from_upump(upump);
     common->started = true;
-    if (ulist_empty(&common->blockers)) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(upump->mgr);
-        common_mgr->upump_real_restart(upump, common->status);
-    }
+    if (ulist_empty(&common->blockers))
+        upump_common_real_restart(upump, common->status);
 }
 
 /** @This stops a pump if needed.
@@ -187,11 +768,8 @@ void upump_common_stop(struct upump *upump)
     if (!common->started)
         return;
     common->started = false;
-    if (ulist_empty(&common->blockers)) {
-        struct upump_common_mgr *common_mgr =
-            upump_common_mgr_from_upump_mgr(upump->mgr);
-        common_mgr->upump_real_stop(upump, common->status);
-    }
+    if (ulist_empty(&common->blockers))
+        upump_common_real_stop(upump, common->status);
 }
 
 /** @This gets the blocking status of a pump.
@@ -266,6 +844,43 @@ void upump_common_mgr_vacuum(struct upump_mgr *mgr)
     upool_vacuum(&common_mgr->upump_blocker_pool);
 }
 
+/** @This processes the control commands common to all managers,
+ * @ref UPUMP_MGR_SET_MONITOR and @ref UPUMP_MGR_GET_HEALTH.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_common_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+int upump_common_mgr_control(struct upump_mgr *mgr, int command, va_list args)
+{
+    struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    switch (command) {
+        case UPUMP_MGR_SET_MONITOR: {
+            uint64_t threshold = va_arg(args, uint64_t);
+            struct uprobe *uprobe = va_arg(args, struct uprobe *);
+            uprobe_release(common_mgr->monitor_uprobe);
+            common_mgr->monitor_uprobe = uprobe_use(uprobe);
+            if (threshold && !common_mgr->monitor_threshold)
+                memset(&common_mgr->health, 0,
+                       sizeof(struct upump_mgr_health));
+            common_mgr->monitor_threshold = threshold;
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_MGR_GET_HEALTH: {
+            struct upump_mgr_health *health =
+                va_arg(args, struct upump_mgr_health *);
+            if (!common_mgr->monitor_threshold)
+                return UBASE_ERR_INVALID;
+            *health = common_mgr->health;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
 /** @This cleans up the common parts of a upump_common_mgr structure.
  * Note that all pumps have to be stopped before.
  *
@@ -275,6 +890,11 @@ void upump_common_mgr_vacuum(struct upump_mgr *mgr)
 void upump_common_mgr_clean(struct upump_mgr *mgr)
 {
     struct upump_common_mgr *common_mgr = upump_common_mgr_from_upump_mgr(mgr);
+    if (common_mgr->wheel != NULL) {
+        uclock_release(common_mgr->wheel->uclock_std);
+        free(common_mgr->wheel);
+    }
+    uprobe_release(common_mgr->monitor_uprobe);
     upool_clean(&common_mgr->upump_pool);
     upool_clean(&common_mgr->upump_blocker_pool);
 }
@@ -309,6 +929,12 @@ void upump_common_mgr_init(struct upump_mgr *mgr,
     common_mgr->upump_real_start = upump_real_start;
     common_mgr->upump_real_stop = upump_real_stop;
     common_mgr->upump_real_restart = upump_real_restart;
+    common_mgr->uclock = NULL;
+    common_mgr->wheel = NULL;
+    common_mgr->monitor_threshold = 0;
+    common_mgr->monitor_uprobe = NULL;
+    memset(&common_mgr->health, 0, sizeof(struct upump_mgr_health));
+    common_mgr->monitor_nested = 0;
 
     upool_init(&common_mgr->upump_pool, mgr->refcount, upump_pool_depth,
                pool_extra, upump_alloc_inner, upump_free_inner);
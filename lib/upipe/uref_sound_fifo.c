@@ -0,0 +1,381 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe FIFO of sound urefs, cut into fixed-size periods
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_sound.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_sound.h"
+#include "upipe/uref_sound_fifo.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/** @This initializes a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ * @param rate sample rate, or 0 if the urefs are not to be dated
+ */
+void uref_sound_fifo_init(struct uref_sound_fifo *fifo, uint64_t rate)
+{
+    ulist_init(&fifo->urefs);
+    fifo->samples = 0;
+    fifo->rate = rate;
+    fifo->silence = NULL;
+}
+
+/** @This frees all urefs queued in a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ */
+void uref_sound_fifo_flush(struct uref_sound_fifo *fifo)
+{
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&fifo->urefs)) != NULL)
+        uref_free(uref_from_uchain(uchain));
+    fifo->samples = 0;
+}
+
+/** @This cleans up a sound FIFO, and releases the buffer of silence.
+ *
+ * @param fifo pointer to the FIFO
+ */
+void uref_sound_fifo_clean(struct uref_sound_fifo *fifo)
+{
+    uref_sound_fifo_flush(fifo);
+    if (fifo->silence != NULL)
+        ubuf_free(fifo->silence);
+    fifo->silence = NULL;
+}
+
+/** @This queues a sound uref at the end of a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ * @param uref sound uref, belonging to the FIFO afterwards
+ * @return an error code
+ */
+int uref_sound_fifo_push(struct uref_sound_fifo *fifo, struct uref *uref)
+{
+    size_t samples;
+    if (unlikely(!ubase_check(uref_sound_size(uref, &samples, NULL)))) {
+        uref_free(uref);
+        return UBASE_ERR_INVALID;
+    }
+    fifo->samples += samples;
+    ulist_add(&fifo->urefs, uref_to_uchain(uref));
+    return UBASE_ERR_NONE;
+}
+
+/** @This dequeues the first uref of a sound FIFO, whatever its size.
+ *
+ * @param fifo pointer to the FIFO
+ * @return pointer to the uref, or NULL if the FIFO is empty
+ */
+struct uref *uref_sound_fifo_pop_uref(struct uref_sound_fifo *fifo)
+{
+    struct uchain *uchain = ulist_pop(&fifo->urefs);
+    if (uchain == NULL)
+        return NULL;
+    struct uref *uref = uref_from_uchain(uchain);
+    size_t samples = 0;
+    uref_sound_size(uref, &samples, NULL);
+    fifo->samples -= samples;
+    return uref;
+}
+
+/** @internal @This removes samples from the head of a uref, and dates the
+ * remainder accordingly.
+ *
+ * @param fifo pointer to the FIFO
+ * @param uref sound uref
+ * @param samples number of samples to remove
+ */
+static void uref_sound_fifo_consume(struct uref_sound_fifo *fifo,
+                                    struct uref *uref, size_t samples)
+{
+    uref_sound_resize(uref, samples, -1);
+    fifo->samples -= samples;
+    if (!fifo->rate)
+        return;
+
+    uint64_t delay = samples * UCLOCK_FREQ / fifo->rate;
+    uref_clock_add_date_sys(uref, delay);
+    uref_clock_add_date_prog(uref, delay);
+    uref_clock_add_date_orig(uref, delay);
+    uint64_t duration;
+    if (ubase_check(uref_clock_get_duration(uref, &duration)))
+        uref_clock_set_duration(uref, duration > delay ? duration - delay : 0);
+}
+
+/** @internal @This copies samples from the head of a sound FIFO into a new
+ * buffer.
+ *
+ * @param fifo pointer to the FIFO
+ * @param uref uref receiving the buffer
+ * @param ubuf_mgr manager of the buffer
+ * @param samples number of samples to dequeue
+ * @return an error code
+ */
+static int uref_sound_fifo_copy(struct uref_sound_fifo *fifo,
+                                struct uref *uref, struct ubuf_mgr *ubuf_mgr,
+                                size_t samples)
+{
+    struct ubuf *ubuf = ubuf_sound_alloc(ubuf_mgr, samples);
+    UBASE_ALLOC_RETURN(ubuf);
+    uref_attach_ubuf(uref, ubuf);
+
+    uint8_t sample_size;
+    UBASE_RETURN(ubuf_sound_size(ubuf, NULL, &sample_size))
+
+    size_t offset = 0;
+    while (offset < samples) {
+        struct uref *src = uref_sound_fifo_peek(fifo);
+        if (src == NULL)
+            break;
+        size_t src_samples = 0;
+        uref_sound_size(src, &src_samples, NULL);
+        size_t size = samples - offset;
+        if (size > src_samples)
+            size = src_samples;
+
+        const char *channel = NULL;
+        while (ubase_check(ubuf_sound_iterate_plane(ubuf, &channel)) &&
+               channel != NULL) {
+            uint8_t *dst_buf;
+            const uint8_t *src_buf;
+            if (unlikely(!ubase_check(ubuf_sound_plane_write_uint8_t(ubuf,
+                                channel, offset, size, &dst_buf))))
+                return UBASE_ERR_INVALID;
+            if (likely(ubase_check(uref_sound_plane_read_uint8_t(src,
+                                channel, 0, size, &src_buf)))) {
+                memcpy(dst_buf, src_buf, size * sample_size);
+                uref_sound_plane_unmap(src, channel, 0, size);
+            } else
+                memset(dst_buf, 0, size * sample_size);
+            ubuf_sound_plane_unmap(ubuf, channel, offset, size);
+        }
+
+        offset += size;
+        if (size == src_samples)
+            uref_free(uref_sound_fifo_pop_uref(fifo));
+        else
+            uref_sound_fifo_consume(fifo, src, size);
+    }
+
+    /* the FIFO ran short */
+    if (offset < samples) {
+        const char *channel = NULL;
+        while (ubase_check(ubuf_sound_iterate_plane(ubuf, &channel)) &&
+               channel != NULL) {
+            uint8_t *dst_buf;
+            if (likely(ubase_check(ubuf_sound_plane_write_uint8_t(ubuf,
+                                channel, offset, -1, &dst_buf)))) {
+                memset(dst_buf, 0, (samples - offset) * sample_size);
+                ubuf_sound_plane_unmap(ubuf, channel, offset, -1);
+            }
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** @This dequeues a given number of samples from a sound FIFO. If the first
+ * uref holds enough samples, the returned uref shares its buffer and no
+ * sample is copied. Otherwise a new buffer is allocated from the given
+ * manager, and the samples of the following urefs are copied into it. If
+ * the FIFO runs short, the end of the buffer is filled with zeros.
+ *
+ * @param fifo pointer to the FIFO
+ * @param ubuf_mgr manager of the copied buffers, or NULL to use the manager
+ * of the first uref
+ * @param samples number of samples to dequeue
+ * @return pointer to the uref, or NULL if the FIFO is empty or in case of
+ * allocation error
+ */
+struct uref *uref_sound_fifo_pop(struct uref_sound_fifo *fifo,
+                                 struct ubuf_mgr *ubuf_mgr, size_t samples)
+{
+    struct uref *src = uref_sound_fifo_peek(fifo);
+    if (src == NULL || !samples)
+        return NULL;
+
+    size_t src_samples = 0;
+    uref_sound_size(src, &src_samples, NULL);
+    if (src_samples == samples)
+        return uref_sound_fifo_pop_uref(fifo);
+
+    struct uref *uref;
+    if (src_samples > samples) {
+        /* share the buffer of the first uref */
+        uref = uref_dup(src);
+        if (unlikely(uref == NULL))
+            return NULL;
+        uref_sound_resize(uref, 0, samples);
+        uref_sound_fifo_consume(fifo, src, samples);
+    } else {
+        uref = uref_dup_inner(src);
+        if (unlikely(uref == NULL))
+            return NULL;
+        if (ubuf_mgr == NULL)
+            ubuf_mgr = src->ubuf->mgr;
+        if (unlikely(!ubase_check(uref_sound_fifo_copy(fifo, uref, ubuf_mgr,
+                                                       samples)))) {
+            uref_free(uref);
+            return NULL;
+        }
+    }
+
+    if (fifo->rate)
+        uref_clock_set_duration(uref, samples * UCLOCK_FREQ / fifo->rate);
+    return uref;
+}
+
+/** @This drops a given number of samples from the head of a sound FIFO.
+ *
+ * @param fifo pointer to the FIFO
+ * @param samples number of samples to drop
+ */
+void uref_sound_fifo_drop(struct uref_sound_fifo *fifo, size_t samples)
+{
+    while (samples) {
+        struct uref *src = uref_sound_fifo_peek(fifo);
+        if (src == NULL)
+            break;
+        size_t src_samples = 0;
+        uref_sound_size(src, &src_samples, NULL);
+        if (src_samples <= samples) {
+            uref_free(uref_sound_fifo_pop_uref(fifo));
+            samples -= src_samples;
+        } else {
+            uref_sound_fifo_consume(fifo, src, samples);
+            samples = 0;
+        }
+    }
+}
+
+/** @This maps the first samples of a sound FIFO for reading, if they are
+ * contiguous in the first uref.
+ *
+ * @param fifo pointer to the FIFO
+ * @param samples number of samples to map
+ * @param buffers_p filled in with pointers to the planes
+ * @param planes number of planes
+ * @return an error code, UBASE_ERR_INVALID if the samples are not
+ * contiguous
+ */
+int uref_sound_fifo_read(struct uref_sound_fifo *fifo, size_t samples,
+                         const uint8_t *buffers_p[], uint8_t planes)
+{
+    struct uref *src = uref_sound_fifo_peek(fifo);
+    size_t src_samples;
+    if (src == NULL ||
+        !ubase_check(uref_sound_size(src, &src_samples, NULL)) ||
+        src_samples < samples)
+        return UBASE_ERR_INVALID;
+    return uref_sound_read_uint8_t(src, 0, samples, buffers_p, planes);
+}
+
+/** @This unmaps the samples mapped by @ref uref_sound_fifo_read.
+ *
+ * @param fifo pointer to the FIFO
+ * @param samples number of samples mapped
+ * @param planes number of planes
+ * @return an error code
+ */
+int uref_sound_fifo_unmap(struct uref_sound_fifo *fifo, size_t samples,
+                          uint8_t planes)
+{
+    struct uref *src = uref_sound_fifo_peek(fifo);
+    if (src == NULL)
+        return UBASE_ERR_INVALID;
+    return uref_sound_unmap(src, 0, samples, planes);
+}
+
+/** @This returns a uref of silence. All such urefs share the same zeroed
+ * buffer, which is only reallocated when a larger one is needed, so they
+ * must not be written to.
+ *
+ * @param fifo pointer to the FIFO
+ * @param uref_mgr management structure for the uref
+ * @param ubuf_mgr management structure for the buffer of silence
+ * @param samples number of samples
+ * @return pointer to the uref, or NULL in case of allocation error
+ */
+struct uref *uref_sound_fifo_silence(struct uref_sound_fifo *fifo,
+                                     struct uref_mgr *uref_mgr,
+                                     struct ubuf_mgr *ubuf_mgr,
+                                     size_t samples)
+{
+    size_t silence_samples = 0;
+    if (fifo->silence != NULL &&
+        (fifo->silence->mgr != ubuf_mgr ||
+         !ubase_check(ubuf_sound_size(fifo->silence, &silence_samples,
+                                      NULL)) ||
+         silence_samples < samples)) {
+        ubuf_free(fifo->silence);
+        fifo->silence = NULL;
+    }
+
+    if (fifo->silence == NULL) {
+        struct ubuf *silence = ubuf_sound_alloc(ubuf_mgr, samples);
+        if (unlikely(silence == NULL))
+            return NULL;
+        uint8_t sample_size;
+        ubuf_sound_size(silence, NULL, &sample_size);
+        const char *channel = NULL;
+        while (ubase_check(ubuf_sound_iterate_plane(silence, &channel)) &&
+               channel != NULL) {
+            uint8_t *buf;
+            if (unlikely(!ubase_check(ubuf_sound_plane_write_uint8_t(silence,
+                                channel, 0, -1, &buf)))) {
+                ubuf_free(silence);
+                return NULL;
+            }
+            memset(buf, 0, samples * sample_size);
+            ubuf_sound_plane_unmap(silence, channel, 0, -1);
+        }
+        fifo->silence = silence;
+    }
+
+    struct uref *uref = uref_alloc(uref_mgr);
+    if (unlikely(uref == NULL))
+        return NULL;
+    struct ubuf *ubuf = ubuf_dup(fifo->silence);
+    if (unlikely(ubuf == NULL)) {
+        uref_free(uref);
+        return NULL;
+    }
+    ubuf_sound_resize(ubuf, 0, samples);
+    uref_attach_ubuf(uref, ubuf);
+    if (fifo->rate)
+        uref_clock_set_duration(uref, samples * UCLOCK_FREQ / fifo->rate);
+    return uref;
+}
@@ -71,6 +71,26 @@ static struct uref *uref_std_alloc(struct uref_mgr *mgr)
     return uref;
 }
 
+/** @This allocates several urefs at once.
+ *
+ * @param mgr common management structure
+ * @param urefs array written with the allocated urefs
+ * @param nb number of urefs to allocate
+ * @param count_p filled in with the number of allocated urefs
+ * @return an error code
+ */
+static int uref_std_alloc_batch(struct uref_mgr *mgr, struct uref **urefs,
+                                unsigned int nb, unsigned int *count_p)
+{
+    struct uref_std_mgr *std_mgr = uref_std_mgr_from_uref_mgr(mgr);
+    unsigned int count = upool_alloc_batch(&std_mgr->uref_pool,
+                                           (void **)urefs, nb);
+    for (unsigned int i = 0; i < count; i++)
+        uchain_init(&urefs[i]->uchain);
+    *count_p = count;
+    return UBASE_ERR_NONE;
+}
+
 /** @This recycles or frees a uref.
  *
  * @param uref pointer to a uref structure
@@ -130,6 +150,12 @@ static int uref_std_mgr_control(struct uref_mgr *mgr, int command, va_list args)
         case UREF_MGR_VACUUM:
             uref_std_mgr_vacuum(mgr);
             return UBASE_ERR_NONE;
+        case UREF_MGR_ALLOC_BATCH: {
+            struct uref **urefs = va_arg(args, struct uref **);
+            unsigned int nb = va_arg(args, unsigned int);
+            unsigned int *count_p = va_arg(args, unsigned int *);
+            return uref_std_alloc_batch(mgr, urefs, nb, count_p);
+        }
         default:
             return UBASE_ERR_UNHANDLED;
     }
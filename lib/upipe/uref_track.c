@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe uref manager tracking the lifetime of urefs
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/uref.h"
+#include "upipe/uref_track.h"
+#include "utrack.h"
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+
+/** @This is a super-set of the uref_mgr structure with additional local
+ * members */
+struct uref_track_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** manager allocating the urefs */
+    struct uref_mgr *uref_mgr;
+    /** tracker of the live urefs */
+    struct utrack utrack;
+
+    /** common management structure */
+    struct uref_mgr mgr;
+};
+
+UBASE_FROM_TO(uref_track_mgr, uref_mgr, uref_mgr, mgr)
+UBASE_FROM_TO(uref_track_mgr, urefcount, urefcount, urefcount)
+
+/** @This allocates a uref with the wrapped manager, and records it if it is
+ * sampled.
+ *
+ * @param mgr common management structure
+ * @return pointer to uref or NULL in case of allocation error
+ */
+static struct uref *uref_track_alloc(struct uref_mgr *mgr)
+{
+    struct uref_track_mgr *track_mgr = uref_track_mgr_from_uref_mgr(mgr);
+    struct uref *uref = track_mgr->uref_mgr->uref_alloc(track_mgr->uref_mgr);
+    if (unlikely(uref == NULL))
+        return NULL;
+
+    /* the uref comes back to us when it is freed or duplicated */
+    uref->mgr = uref_mgr_use(mgr);
+    if (unlikely(utrack_sampled(&track_mgr->utrack, uref)))
+        utrack_add(&track_mgr->utrack, uref, __builtin_return_address(0), 0);
+    return uref;
+}
+
+/** @This frees a uref with the wrapped manager.
+ *
+ * @param uref pointer to uref
+ */
+static void uref_track_free(struct uref *uref)
+{
+    struct uref_mgr *mgr = uref->mgr;
+    struct uref_track_mgr *track_mgr = uref_track_mgr_from_uref_mgr(mgr);
+    if (unlikely(utrack_sampled(&track_mgr->utrack, uref)))
+        utrack_remove(&track_mgr->utrack, uref);
+
+    uref->mgr = track_mgr->uref_mgr;
+    uref->mgr->uref_free(uref);
+    uref_mgr_release(mgr);
+}
+
+/** @This processes control commands on a uref_track_mgr.
+ *
+ * @param mgr pointer to a uref_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int uref_track_mgr_control(struct uref_mgr *mgr,
+                                  int command, va_list args)
+{
+    struct uref_track_mgr *track_mgr = uref_track_mgr_from_uref_mgr(mgr);
+    switch (command) {
+        case UREF_MGR_ALLOC_BATCH:
+            /* fall back to individual allocations, which are tracked */
+            return UBASE_ERR_UNHANDLED;
+        case UREF_TRACK_MGR_DUMP: {
+            UBASE_SIGNATURE_CHECK(args, UREF_TRACK_SIGNATURE)
+            FILE *file = va_arg(args, FILE *);
+            return utrack_dump(&track_mgr->utrack, file, "urefs");
+        }
+        default:
+            return uref_mgr_control_va(track_mgr->uref_mgr, command, args);
+    }
+}
+
+/** @This frees a uref_track_mgr.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void uref_track_mgr_free(struct urefcount *urefcount)
+{
+    struct uref_track_mgr *track_mgr =
+        uref_track_mgr_from_urefcount(urefcount);
+    uref_mgr_release(track_mgr->uref_mgr);
+    utrack_clean(&track_mgr->utrack);
+    urefcount_clean(urefcount);
+    free(track_mgr);
+}
+
+/** @This allocates a uref manager tracking the urefs allocated with another
+ * manager.
+ *
+ * @param uref_mgr uref manager allocating the urefs
+ * @param period one uref out of period is sampled (1 to track all urefs)
+ * @return pointer to manager, or NULL in case of error
+ */
+struct uref_mgr *uref_track_mgr_alloc(struct uref_mgr *uref_mgr,
+                                      unsigned int period)
+{
+    assert(uref_mgr != NULL);
+    struct uref_track_mgr *track_mgr = malloc(sizeof(struct uref_track_mgr));
+    if (unlikely(track_mgr == NULL))
+        return NULL;
+
+    track_mgr->uref_mgr = uref_mgr_use(uref_mgr);
+    utrack_init(&track_mgr->utrack, period);
+    urefcount_init(uref_track_mgr_to_urefcount(track_mgr),
+                   uref_track_mgr_free);
+    track_mgr->mgr.refcount = uref_track_mgr_to_urefcount(track_mgr);
+    track_mgr->mgr.control_attr_size = uref_mgr->control_attr_size;
+    track_mgr->mgr.udict_mgr = uref_mgr->udict_mgr;
+    track_mgr->mgr.uref_alloc = uref_track_alloc;
+    track_mgr->mgr.uref_free = uref_track_free;
+    track_mgr->mgr.uref_mgr_control = uref_track_mgr_control;
+    return uref_track_mgr_to_uref_mgr(track_mgr);
+}
@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe internal sampled tracker of live objects
+ */
+
+#define _GNU_SOURCE
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/uclock.h"
+#include "utrack.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <dlfcn.h>
+
+/** number of age classes of the histogram */
+#define UTRACK_AGES 4
+
+/** upper bounds of the age classes */
+static const uint64_t utrack_ages[UTRACK_AGES] = {
+    UCLOCK_FREQ, 10 * UCLOCK_FREQ, 60 * UCLOCK_FREQ, UINT64_MAX
+};
+
+/** @internal @This is the record of a live sampled object. */
+struct utrack_record {
+    /** structure for double-linked lists */
+    struct uchain uchain;
+    /** pointer to object */
+    const void *object;
+    /** return address of the allocation */
+    const void *site;
+    /** date of the allocation */
+    uint64_t date;
+    /** size of the object, in octets */
+    uint64_t size;
+};
+
+UBASE_FROM_TO(utrack_record, uchain, uchain, uchain)
+
+/** @internal @This aggregates the live records of an allocation site. */
+struct utrack_site {
+    /** return address of the allocation */
+    const void *site;
+    /** number of records */
+    uint64_t count;
+    /** cumulated size */
+    uint64_t size;
+    /** number of records per age class */
+    uint64_t ages[UTRACK_AGES];
+    /** age of the oldest record */
+    uint64_t oldest;
+};
+
+/** @internal @This returns the current monotonic time.
+ *
+ * @return current time in 27 MHz ticks
+ */
+static uint64_t utrack_now(void)
+{
+    struct timespec ts;
+    if (unlikely(clock_gettime(CLOCK_MONOTONIC, &ts) == -1))
+        return 0;
+    return ts.tv_sec * UCLOCK_FREQ +
+           ts.tv_nsec * UCLOCK_FREQ / UINT64_C(1000000000);
+}
+
+/** @This initializes a tracker.
+ *
+ * @param utrack pointer to tracker
+ * @param period sampling period
+ */
+void utrack_init(struct utrack *utrack, unsigned int period)
+{
+    utrack->period = period;
+    pthread_mutex_init(&utrack->mutex, NULL);
+    utrack->nb_records = 0;
+    for (unsigned int i = 0; i < UTRACK_BUCKETS; i++)
+        ulist_init(&utrack->buckets[i]);
+}
+
+/** @This cleans up a tracker, forgetting the remaining records.
+ *
+ * @param utrack pointer to tracker
+ */
+void utrack_clean(struct utrack *utrack)
+{
+    for (unsigned int i = 0; i < UTRACK_BUCKETS; i++) {
+        struct uchain *uchain, *uchain_tmp;
+        ulist_delete_foreach(&utrack->buckets[i], uchain, uchain_tmp) {
+            ulist_delete(uchain);
+            free(utrack_record_from_uchain(uchain));
+        }
+    }
+    pthread_mutex_destroy(&utrack->mutex);
+}
+
+/** @This records a sampled object.
+ *
+ * @param utrack pointer to tracker
+ * @param object pointer to object
+ * @param site return address of the allocation
+ * @param size size of the object, in octets, or 0
+ */
+void utrack_add(struct utrack *utrack, const void *object,
+                const void *site, uint64_t size)
+{
+    struct utrack_record *record = malloc(sizeof(struct utrack_record));
+    if (unlikely(record == NULL))
+        return;
+    uchain_init(&record->uchain);
+    record->object = object;
+    record->site = site;
+    record->date = utrack_now();
+    record->size = size;
+
+    pthread_mutex_lock(&utrack->mutex);
+    ulist_add(&utrack->buckets[utrack_hash(object) % UTRACK_BUCKETS],
+              utrack_record_to_uchain(record));
+    utrack->nb_records++;
+    pthread_mutex_unlock(&utrack->mutex);
+}
+
+/** @This forgets a sampled object.
+ *
+ * @param utrack pointer to tracker
+ * @param object pointer to object
+ */
+void utrack_remove(struct utrack *utrack, const void *object)
+{
+    struct utrack_record *found = NULL;
+    pthread_mutex_lock(&utrack->mutex);
+    struct uchain *bucket =
+        &utrack->buckets[utrack_hash(object) % UTRACK_BUCKETS];
+    struct uchain *uchain;
+    ulist_foreach(bucket, uchain) {
+        struct utrack_record *record = utrack_record_from_uchain(uchain);
+        if (record->object == object) {
+            ulist_delete(uchain);
+            utrack->nb_records--;
+            found = record;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&utrack->mutex);
+    free(found);
+}
+
+/** @internal @This compares two allocation sites by decreasing count.
+ *
+ * @param a pointer to first site
+ * @param b pointer to second site
+ * @return an integer less than, equal to, or greater than zero
+ */
+static int utrack_site_cmp(const void *a, const void *b)
+{
+    const struct utrack_site *site_a = a, *site_b = b;
+    if (site_a->count != site_b->count)
+        return site_a->count > site_b->count ? -1 : 1;
+    return 0;
+}
+
+/** @internal @This prints the name of an allocation site.
+ *
+ * @param file file to print to
+ * @param site return address of the allocation
+ */
+static void utrack_print_site(FILE *file, const void *site)
+{
+    Dl_info info;
+    if (!dladdr(site, &info)) {
+        fprintf(file, "%p", site);
+        return;
+    }
+    if (info.dli_sname != NULL) {
+        fprintf(file, "%s+0x%tx", info.dli_sname,
+                (const char *)site - (const char *)info.dli_saddr);
+        return;
+    }
+    if (info.dli_fname != NULL) {
+        const char *name = strrchr(info.dli_fname, '/');
+        fprintf(file, "%s+0x%tx", name != NULL ? name + 1 : info.dli_fname,
+                (const char *)site - (const char *)info.dli_fbase);
+        return;
+    }
+    fprintf(file, "%p", site);
+}
+
+/** @This prints a histogram of the live sampled objects by allocation site
+ * and age.
+ *
+ * @param utrack pointer to tracker
+ * @param file file to print to
+ * @param name name of the objects
+ * @return an error code
+ */
+int utrack_dump(struct utrack *utrack, FILE *file, const char *name)
+{
+    uint64_t now = utrack_now();
+    pthread_mutex_lock(&utrack->mutex);
+    uint64_t nb_records = utrack->nb_records;
+    struct utrack_site *sites =
+        malloc(sizeof(struct utrack_site) * (nb_records ?: 1));
+    if (unlikely(sites == NULL)) {
+        pthread_mutex_unlock(&utrack->mutex);
+        return UBASE_ERR_ALLOC;
+    }
+
+    /* sites are few, so a linear search is enough */
+    unsigned int nb_sites = 0;
+    for (unsigned int i = 0; i < UTRACK_BUCKETS; i++) {
+        struct uchain *uchain;
+        ulist_foreach(&utrack->buckets[i], uchain) {
+            struct utrack_record *record = utrack_record_from_uchain(uchain);
+            struct utrack_site *site = NULL;
+            for (unsigned int j = 0; j < nb_sites; j++)
+                if (sites[j].site == record->site) {
+                    site = &sites[j];
+                    break;
+                }
+            if (site == NULL) {
+                site = &sites[nb_sites++];
+                memset(site, 0, sizeof(struct utrack_site));
+                site->site = record->site;
+            }
+
+            uint64_t age = now > record->date ? now - record->date : 0;
+            site->count++;
+            site->size += record->size;
+            unsigned int j = 0;
+            while (age >= utrack_ages[j])
+                j++;
+            site->ages[j]++;
+            if (age > site->oldest)
+                site->oldest = age;
+        }
+    }
+    pthread_mutex_unlock(&utrack->mutex);
+
+    qsort(sites, nb_sites, sizeof(struct utrack_site), utrack_site_cmp);
+    fprintf(file, "live %s: %"PRIu64" sampled 1/%u\n", name, nb_records,
+            utrack->period ?: 1);
+    fprintf(file, "%8s %12s %8s %8s %8s %8s %10s  site\n", "count", "octets",
+            "<1s", "<10s", "<1min", ">=1min", "oldest(s)");
+    for (unsigned int i = 0; i < nb_sites; i++) {
+        struct utrack_site *site = &sites[i];
+        fprintf(file, "%8"PRIu64" %12"PRIu64, site->count, site->size);
+        for (unsigned int j = 0; j < UTRACK_AGES; j++)
+            fprintf(file, " %8"PRIu64, site->ages[j]);
+        fprintf(file, " %10.3f  ", (double)site->oldest / UCLOCK_FREQ);
+        utrack_print_site(file, site->site);
+        fprintf(file, "\n");
+    }
+    free(sites);
+    return UBASE_ERR_NONE;
+}
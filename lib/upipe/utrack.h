@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short Upipe internal sampled tracker of live objects, shared by the
+ * tracking uref and ubuf managers
+ */
+
+#ifndef _UPIPE_UTRACK_H_
+/** @hidden */
+#define _UPIPE_UTRACK_H_
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/** number of hash buckets of the live records */
+#define UTRACK_BUCKETS 1024
+
+/** @This is a sampled tracker of live objects. */
+struct utrack {
+    /** one object out of period is sampled */
+    unsigned int period;
+    /** mutual exclusion on the records */
+    pthread_mutex_t mutex;
+    /** number of live records */
+    uint64_t nb_records;
+    /** live records, hashed by object */
+    struct uchain buckets[UTRACK_BUCKETS];
+};
+
+/** @This returns a hash of the address of an object.
+ *
+ * @param object pointer to object
+ * @return hash
+ */
+static inline uint32_t utrack_hash(const void *object)
+{
+    return ((uintptr_t)object * UINT64_C(0x9e3779b97f4a7c15)) >> 32;
+}
+
+/** @This checks if an object is sampled. The decision only depends on the
+ * address of the object, so that freeing an object which is not sampled
+ * costs no lookup. Pooled objects keep their addresses, but leaked objects
+ * are replaced by new ones, so leaks are still sampled with the expected
+ * period.
+ *
+ * @param utrack pointer to tracker
+ * @param object pointer to object
+ * @return true if the object is sampled
+ */
+static inline bool utrack_sampled(const struct utrack *utrack,
+                                  const void *object)
+{
+    return utrack->period <= 1 ||
+           !((utrack_hash(object) >> 10) % utrack->period);
+}
+
+/** @This initializes a tracker.
+ *
+ * @param utrack pointer to tracker
+ * @param period sampling period
+ */
+void utrack_init(struct utrack *utrack, unsigned int period);
+
+/** @This cleans up a tracker, forgetting the remaining records.
+ *
+ * @param utrack pointer to tracker
+ */
+void utrack_clean(struct utrack *utrack);
+
+/** @This records a sampled object.
+ *
+ * @param utrack pointer to tracker
+ * @param object pointer to object
+ * @param site return address of the allocation
+ * @param size size of the object, in octets, or 0
+ */
+void utrack_add(struct utrack *utrack, const void *object,
+                const void *site, uint64_t size);
+
+/** @This forgets a sampled object.
+ *
+ * @param utrack pointer to tracker
+ * @param object pointer to object
+ */
+void utrack_remove(struct utrack *utrack, const void *object);
+
+/** @This prints a histogram of the live sampled objects by allocation site
+ * and age.
+ *
+ * @param utrack pointer to tracker
+ * @param file file to print to
+ * @param name name of the objects
+ * @return an error code
+ */
+int utrack_dump(struct utrack *utrack, FILE *file, const char *name);
+
+#endif
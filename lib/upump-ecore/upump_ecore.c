@@ -206,6 +206,10 @@ static struct upump *upump_ecore_alloc(struct upump_mgr *mgr,
 
     upump_mgr_use(mgr);
     upump_common_init(upump);
+    if (event == UPUMP_TYPE_TIMER)
+        upump_common_init_timer(upump, (uint64_t)(ecore_timer_interval_get(
+                                    upump_ecore->timer) * UCLOCK_FREQ),
+                                upump_ecore->repeat);
 
     return upump;
 }
@@ -439,7 +443,7 @@ static int upump_ecore_mgr_control(struct upump_mgr *mgr,
             upump_common_mgr_vacuum(mgr);
             return UBASE_ERR_NONE;
         default:
-            return UBASE_ERR_UNHANDLED;
+            return upump_common_mgr_control(mgr, command, args);
     }
 }
 
@@ -192,6 +192,8 @@ static struct upump *upump_ev_alloc(struct upump_mgr *mgr,
                            signal);
             break;
         }
+        case UPUMP_TYPE_WHEEL_TIMER:
+            break;
         default:
             free(upump_ev);
             return NULL;
@@ -199,6 +201,15 @@ static struct upump *upump_ev_alloc(struct upump_mgr *mgr,
     upump_ev->event = event;
 
     upump_common_init(upump);
+    if (event == UPUMP_TYPE_TIMER)
+        upump_common_init_timer(upump, upump_ev->timer.after,
+                                (uint64_t)(upump_ev->ev_timer.repeat *
+                                           UCLOCK_FREQ));
+    if (event == UPUMP_TYPE_WHEEL_TIMER) {
+        uint64_t after = va_arg(args, uint64_t);
+        uint64_t repeat = va_arg(args, uint64_t);
+        upump_common_init_wheel_timer(upump, after, repeat);
+    }
 
     return upump;
 }
@@ -456,7 +467,7 @@ static int upump_ev_mgr_control(struct upump_mgr *mgr,
             upump_common_mgr_vacuum(mgr);
             return UBASE_ERR_NONE;
         default:
-            return UBASE_ERR_UNHANDLED;
+            return upump_common_mgr_control(mgr, command, args);
     }
 }
 
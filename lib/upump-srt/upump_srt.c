@@ -29,6 +29,7 @@
 
 #include "upipe/ubase.h"
 #include "upipe/urefcount.h"
+#include "upipe/uatomic.h"
 #include "upipe/uclock.h"
 #include "upipe/upump.h"
 #include "upipe/upump_common.h"
@@ -36,6 +37,7 @@
 
 #include <stdlib.h>
 #include <signal.h>
+#include <unistd.h>
 #include <sys/timerfd.h>
 #include <sys/signalfd.h>
 
@@ -55,6 +57,20 @@ struct upump_srt_mgr {
     bool running;
     /** list of allocated upump structures */
     struct uchain upumps;
+    /** number of started pumps watched by the srt epoll */
+    unsigned int watched;
+    /** number of started pumps watching srt sockets */
+    uatomic_uint32_t load;
+    /** size of the arrays of ready sockets */
+    int nfds;
+    /** ready srt sockets for reading */
+    SRTSOCKET *rfds;
+    /** ready srt sockets for writing */
+    SRTSOCKET *wfds;
+    /** ready system sockets for reading */
+    int *lrfds;
+    /** ready system sockets for writing */
+    int *lwfds;
 
     /** common structure */
     struct upump_common_mgr common_mgr;
@@ -93,6 +109,8 @@ struct upump_srt {
 
     /** upump should be freed after upumps list traversal */
     bool free;
+    /** upump is watched by the srt epoll */
+    bool watched;
 
     /** common structure */
     struct upump_common common;
@@ -185,9 +203,13 @@ static struct upump *upump_srt_alloc(struct upump_mgr *mgr,
     uchain_init(&upump_srt->uchain);
     upump_srt->event = event;
     upump_srt->free = false;
+    upump_srt->watched = false;
     ulist_add(&srt_mgr->upumps, &upump_srt->uchain);
 
     upump_common_init(upump);
+    if (event == UPUMP_TYPE_TIMER)
+        upump_common_init_timer(upump, upump_srt->timer.after,
+                                upump_srt->timer.repeat);
 
     return upump;
 }
@@ -223,6 +245,33 @@ static struct upump_srt *upump_srt_lookup(struct upump_mgr *mgr,
     return NULL;
 }
 
+/** @This accounts for a pump being added to or removed from the srt epoll.
+ *
+ * @param srt_mgr description structure of the event loop
+ * @param upump_srt description structure of the pump
+ * @param watched true if the pump is now watched
+ */
+static void upump_srt_set_watched(struct upump_srt_mgr *srt_mgr,
+                                  struct upump_srt *upump_srt, bool watched)
+{
+    if (upump_srt->watched == watched)
+        return;
+    upump_srt->watched = watched;
+
+    if (watched)
+        srt_mgr->watched++;
+    else
+        srt_mgr->watched--;
+
+    if (upump_srt->event == UPUMP_SRT_TYPE_READ ||
+        upump_srt->event == UPUMP_SRT_TYPE_WRITE) {
+        if (watched)
+            uatomic_fetch_add(&srt_mgr->load, 1);
+        else
+            uatomic_fetch_sub(&srt_mgr->load, 1);
+    }
+}
+
 /** @This starts a pump.
  *
  * @param upump description structure of the pump
@@ -327,6 +376,9 @@ static void upump_srt_real_start(struct upump *upump, bool status)
             }
             break;
     }
+
+    if (upump_srt->event != UPUMP_TYPE_IDLER)
+        upump_srt_set_watched(srt_mgr, upump_srt, true);
 }
 
 /** @This stops a pump.
@@ -339,6 +391,8 @@ static void upump_srt_real_stop(struct upump *upump, bool status)
     struct upump_srt *upump_srt = upump_srt_from_upump(upump);
     struct upump_srt_mgr *srt_mgr = upump_srt_mgr_from_upump_mgr(upump->mgr);
 
+    upump_srt_set_watched(srt_mgr, upump_srt, false);
+
     switch (upump_srt->event) {
         case UPUMP_TYPE_IDLER:
             srt_mgr->idlers--;
@@ -524,6 +578,54 @@ static int upump_srt_control(struct upump *upump, int command, va_list args)
     }
 }
 
+/** @internal @This compares two sockets.
+ *
+ * @param a pointer to the first socket
+ * @param b pointer to the second socket
+ * @return an integer less than, equal to, or greater than zero
+ */
+static int upump_srt_cmp(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/** @internal @This checks whether a socket was reported as ready.
+ *
+ * @param fds sorted array of ready sockets
+ * @param num number of ready sockets
+ * @param fd socket to look for
+ * @return true if the socket is ready
+ */
+static bool upump_srt_ready(const int *fds, int num, int fd)
+{
+    return num > 0 &&
+        bsearch(&fd, fds, num, sizeof(*fds), upump_srt_cmp) != NULL;
+}
+
+/** @internal @This resizes the arrays of ready sockets so that a single
+ * wait reports all the watched sockets.
+ *
+ * @param srt_mgr description structure of the event loop
+ * @return an error code
+ */
+static int upump_srt_mgr_resize(struct upump_srt_mgr *srt_mgr)
+{
+    int nfds = srt_mgr->watched > 16 ? srt_mgr->watched : 16;
+    if (likely(nfds <= srt_mgr->nfds))
+        return UBASE_ERR_NONE;
+
+    int *fds = realloc(srt_mgr->rfds, 4 * nfds * sizeof(int));
+    UBASE_ALLOC_RETURN(fds);
+    srt_mgr->rfds = fds;
+    srt_mgr->wfds = fds + nfds;
+    srt_mgr->lrfds = fds + 2 * nfds;
+    srt_mgr->lwfds = fds + 3 * nfds;
+    srt_mgr->nfds = nfds;
+    return UBASE_ERR_NONE;
+}
+
 /** @internal @This runs an event loop.
  *
  * @param mgr pointer to a upump_mgr structure
@@ -537,20 +639,20 @@ static int upump_srt_mgr_run(struct upump_mgr *mgr, struct umutex *mutex)
     if (mutex != NULL)
         return UBASE_ERR_INVALID;
 
-    SRTSOCKET rfds[16];
-    SRTSOCKET wfds[16];
-    int lrfds[16];
-    int lwfds[16];
     int blocking;
 
     do {
-        int rnum = UBASE_ARRAY_SIZE(rfds);
-        int wnum = UBASE_ARRAY_SIZE(wfds);
-        int lrnum = UBASE_ARRAY_SIZE(lrfds);
-        int lwnum = UBASE_ARRAY_SIZE(lwfds);
-        int ret = srt_epoll_wait(srt_mgr->epoll_id, rfds, &rnum, wfds, &wnum,
+        UBASE_RETURN(upump_srt_mgr_resize(srt_mgr))
+
+        int rnum = srt_mgr->nfds;
+        int wnum = srt_mgr->nfds;
+        int lrnum = srt_mgr->nfds;
+        int lwnum = srt_mgr->nfds;
+        int ret = srt_epoll_wait(srt_mgr->epoll_id,
+                                 srt_mgr->rfds, &rnum, srt_mgr->wfds, &wnum,
                                  srt_mgr->idlers > 0 ? 0 : -1,
-                                 lrfds, &lrnum, lwfds, &lwnum);
+                                 srt_mgr->lrfds, &lrnum,
+                                 srt_mgr->lwfds, &lwnum);
 
         bool dispatch_idlers = ret == 0 && srt_mgr->idlers > 0;
 
@@ -560,6 +662,14 @@ static int upump_srt_mgr_run(struct upump_mgr *mgr, struct umutex *mutex)
             dispatch_idlers = true;
         }
 
+        if (!dispatch_idlers) {
+            /* sort ready sockets to look pumps up in logarithmic time */
+            qsort(srt_mgr->rfds, rnum, sizeof(int), upump_srt_cmp);
+            qsort(srt_mgr->wfds, wnum, sizeof(int), upump_srt_cmp);
+            qsort(srt_mgr->lrfds, lrnum, sizeof(int), upump_srt_cmp);
+            qsort(srt_mgr->lwfds, lwnum, sizeof(int), upump_srt_cmp);
+        }
+
         srt_mgr->running = true;
 
         struct uchain *uchain;
@@ -580,45 +690,37 @@ static int upump_srt_mgr_run(struct upump_mgr *mgr, struct umutex *mutex)
                 case UPUMP_TYPE_TIMER:
                 case UPUMP_TYPE_SIGNAL:
                 case UPUMP_TYPE_FD_READ:
-                    for (int i = 0; i < lrnum; i++)
-                        if (lrfds[i] == upump_srt->fd) {
-                            if (upump_srt->event == UPUMP_TYPE_TIMER) {
-                                uint64_t expirations;
-                                if (read(upump_srt->fd, &expirations,
-                                         sizeof (expirations)) == -1)
-                                    break;
-                                if (upump_srt->timer.repeat == 0)
-                                    upump_srt->timer.expired = true;
-                            } else if (upump_srt->event == UPUMP_TYPE_SIGNAL) {
-                                struct signalfd_siginfo siginfo;
-                                if (read(upump_srt->fd, &siginfo,
-                                         sizeof (siginfo)) == -1)
-                                    break;
-                            }
-                            upump_common_dispatch(upump);
+                    if (!upump_srt_ready(srt_mgr->lrfds, lrnum,
+                                         upump_srt->fd))
+                        break;
+                    if (upump_srt->event == UPUMP_TYPE_TIMER) {
+                        uint64_t expirations;
+                        if (read(upump_srt->fd, &expirations,
+                                 sizeof (expirations)) == -1)
+                            break;
+                        if (upump_srt->timer.repeat == 0)
+                            upump_srt->timer.expired = true;
+                    } else if (upump_srt->event == UPUMP_TYPE_SIGNAL) {
+                        struct signalfd_siginfo siginfo;
+                        if (read(upump_srt->fd, &siginfo,
+                                 sizeof (siginfo)) == -1)
                             break;
-                        }
+                    }
+                    upump_common_dispatch(upump);
                     break;
                 case UPUMP_TYPE_FD_WRITE:
-                    for (int i = 0; i < lwnum; i++)
-                        if (lwfds[i] == upump_srt->fd) {
-                            upump_common_dispatch(upump);
-                            break;
-                        }
+                    if (upump_srt_ready(srt_mgr->lwfds, lwnum, upump_srt->fd))
+                        upump_common_dispatch(upump);
                     break;
                 case UPUMP_SRT_TYPE_READ:
-                    for (int i = 0; i < rnum; i++)
-                        if (rfds[i] == upump_srt->socket) {
-                            upump_common_dispatch(upump);
-                            break;
-                        }
+                    if (upump_srt_ready(srt_mgr->rfds, rnum,
+                                        upump_srt->socket))
+                        upump_common_dispatch(upump);
                     break;
                 case UPUMP_SRT_TYPE_WRITE:
-                    for (int i = 0; i < wnum; i++)
-                        if (wfds[i] == upump_srt->socket) {
-                            upump_common_dispatch(upump);
-                            break;
-                        }
+                    if (upump_srt_ready(srt_mgr->wfds, wnum,
+                                        upump_srt->socket))
+                        upump_common_dispatch(upump);
                     break;
             }
         }
@@ -672,8 +774,15 @@ static int upump_srt_mgr_control(struct upump_mgr *mgr,
         case UPUMP_MGR_VACUUM:
             upump_common_mgr_vacuum(mgr);
             return UBASE_ERR_NONE;
+        case UPUMP_SRT_MGR_GET_LOAD: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_SRT_SIGNATURE)
+            unsigned int *load_p = va_arg(args, unsigned int *);
+            struct upump_srt_mgr *srt_mgr = upump_srt_mgr_from_upump_mgr(mgr);
+            *load_p = uatomic_load(&srt_mgr->load);
+            return UBASE_ERR_NONE;
+        }
         default:
-            return UBASE_ERR_UNHANDLED;
+            return upump_common_mgr_control(mgr, command, args);
     }
 }
 
@@ -686,6 +795,8 @@ static void upump_srt_mgr_free(struct urefcount *urefcount)
     struct upump_srt_mgr *srt_mgr = upump_srt_mgr_from_urefcount(urefcount);
     upump_common_mgr_clean(upump_srt_mgr_to_upump_mgr(srt_mgr));
     srt_epoll_release(srt_mgr->epoll_id);
+    uatomic_clean(&srt_mgr->load);
+    free(srt_mgr->rfds);
     free(srt_mgr);
 }
 
@@ -727,6 +838,11 @@ struct upump_mgr *upump_srt_mgr_alloc(uint16_t upump_pool_depth,
                           upump_srt_alloc_inner, upump_srt_free_inner);
 
     ulist_init(&srt_mgr->upumps);
+    srt_mgr->watched = 0;
+    uatomic_init(&srt_mgr->load, 0);
+    srt_mgr->nfds = 0;
+    srt_mgr->rfds = srt_mgr->wfds = NULL;
+    srt_mgr->lrfds = srt_mgr->lwfds = NULL;
     srt_mgr->idlers = 0;
     srt_mgr->running = false;
     return mgr;
@@ -0,0 +1,1003 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short implementation of a Upipe event loop using io_uring
+ *
+ * Timers are implemented with timeout requests on an absolute monotonic
+ * deadline, file descriptor watchers and signals with one-shot poll requests
+ * which are rearmed after the callback, so that watchers keep their
+ * level-triggered semantics. Requests are queued in the submission ring and
+ * submitted all at once when the loop waits for completions.
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/urefcount.h"
+#include "upipe/uclock.h"
+#include "upipe/umutex.h"
+#include "upipe/upump.h"
+#include "upipe/upump_common.h"
+#include "upump-uring/upump_uring.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/signalfd.h>
+
+#include <linux/io_uring.h>
+
+/** number of entries of the submission ring */
+#define UPUMP_URING_ENTRIES 256
+
+/** @This stores management parameters and local structures.
+ */
+struct upump_uring_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+
+    /** io_uring file descriptor */
+    int fd;
+    /** mapping of the submission ring */
+    void *sq_ring;
+    /** size of the mapping of the submission ring */
+    size_t sq_ring_size;
+    /** mapping of the completion ring */
+    void *cq_ring;
+    /** size of the mapping of the completion ring */
+    size_t cq_ring_size;
+    /** mapping of the submission queue entries */
+    struct io_uring_sqe *sqes;
+    /** size of the mapping of the submission queue entries */
+    size_t sqes_size;
+
+    /** pointer to the head of the submission ring */
+    unsigned *sq_head;
+    /** pointer to the tail of the submission ring */
+    unsigned *sq_tail;
+    /** mask of the submission ring */
+    unsigned sq_mask;
+    /** number of entries of the submission ring */
+    unsigned sq_entries;
+    /** pointer to the head of the completion ring */
+    unsigned *cq_head;
+    /** pointer to the tail of the completion ring */
+    unsigned *cq_tail;
+    /** mask of the completion ring */
+    unsigned cq_mask;
+    /** completion queue entries */
+    struct io_uring_cqe *cqes;
+    /** number of queued requests not yet submitted */
+    unsigned to_submit;
+
+    /** list of started idlers */
+    struct uchain idlers;
+    /** list of pumps with a completed request, to dispatch */
+    struct uchain ready;
+    /** number of active blocking pumps */
+    unsigned blocking;
+    /** pump being dispatched, or NULL if it was freed by its callback */
+    struct upump_uring *dispatched;
+
+    /** common structure */
+    struct upump_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(upump_uring_mgr, upump_mgr, upump_mgr, common_mgr.mgr)
+UBASE_FROM_TO(upump_uring_mgr, urefcount, urefcount, urefcount)
+
+/** @This stores local structures.
+ */
+struct upump_uring {
+    /** structure for the idlers or ready list */
+    struct uchain uchain;
+
+    /** type of event to watch */
+    int event;
+    /** file descriptor */
+    int fd;
+
+    /** private structure */
+    union {
+        struct {
+            uint64_t after;
+            uint64_t repeat;
+            /** absolute monotonic deadline in nanoseconds */
+            uint64_t deadline;
+            /** deadline passed to the kernel */
+            struct __kernel_timespec ts;
+        } timer;
+        struct {
+            void *buffer;
+            size_t size;
+            int64_t offset;
+        } rw;
+        struct {
+            struct msghdr *msghdr;
+            int flags;
+        } recvmsg;
+    };
+
+    /** result of the last completed request */
+    ssize_t result;
+    /** true if the pump was started by the common layer */
+    bool active;
+    /** true if a request is pending in the ring */
+    bool inflight;
+    /** true if the request must be resubmitted once the pending one
+     * completes */
+    bool rearm;
+    /** true if the pump is accounted in the blocking counter */
+    bool blocking;
+
+    /** common structure */
+    struct upump_common common;
+};
+
+UBASE_FROM_TO(upump_uring, upump, upump, common.upump)
+UBASE_FROM_TO(upump_uring, uchain, uchain, uchain)
+
+/** @internal @This wraps the io_uring_setup system call. */
+static inline int upump_uring_setup(unsigned entries,
+                                    struct io_uring_params *params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+/** @internal @This wraps the io_uring_enter system call. */
+static inline int upump_uring_enter(int fd, unsigned to_submit,
+                                    unsigned min_complete, unsigned flags)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   NULL, 0);
+}
+
+/** @internal @This submits queued requests, and optionally waits for a
+ * completion.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @param wait true to wait for at least one completion
+ * @return false in case of fatal error
+ */
+static bool upump_uring_submit(struct upump_uring_mgr *uring_mgr, bool wait)
+{
+    if (!uring_mgr->to_submit && !wait)
+        return true;
+    int ret = upump_uring_enter(uring_mgr->fd, uring_mgr->to_submit,
+                                wait ? 1 : 0,
+                                wait ? IORING_ENTER_GETEVENTS : 0);
+    if (ret < 0)
+        return errno == EINTR || errno == EAGAIN || errno == EBUSY;
+    uring_mgr->to_submit -= ret;
+    return true;
+}
+
+/** @internal @This returns the next free submission queue entry, submitting
+ * pending requests if the ring is full.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return pointer to a cleared entry, or NULL if the ring is full
+ */
+static struct io_uring_sqe *upump_uring_get_sqe(
+        struct upump_uring_mgr *uring_mgr)
+{
+    unsigned tail = *uring_mgr->sq_tail;
+    if (tail - __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE) >=
+        uring_mgr->sq_entries) {
+        upump_uring_submit(uring_mgr, false);
+        if (tail - __atomic_load_n(uring_mgr->sq_head, __ATOMIC_ACQUIRE) >=
+            uring_mgr->sq_entries)
+            return NULL;
+    }
+    struct io_uring_sqe *sqe = &uring_mgr->sqes[tail & uring_mgr->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+/** @internal @This queues the entry returned by @ref upump_uring_get_sqe.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_commit_sqe(struct upump_uring_mgr *uring_mgr)
+{
+    __atomic_store_n(uring_mgr->sq_tail, *uring_mgr->sq_tail + 1,
+                     __ATOMIC_RELEASE);
+    uring_mgr->to_submit++;
+}
+
+/** @internal @This updates the blocking counter of the manager.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ * @param blocking true if the pump prevents the loop from exiting
+ */
+static void upump_uring_set_blocking(struct upump_uring *upump_uring,
+                                     bool blocking)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump_uring->common.upump.mgr);
+    if (upump_uring->blocking == blocking)
+        return;
+    upump_uring->blocking = blocking;
+    if (blocking)
+        uring_mgr->blocking++;
+    else
+        uring_mgr->blocking--;
+}
+
+/** @internal @This sets the deadline of a timer from now.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ * @param delay delay in units of clock frequency
+ */
+static void upump_uring_set_deadline(struct upump_uring *upump_uring,
+                                     uint64_t delay)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    upump_uring->timer.deadline = (uint64_t)ts.tv_sec * 1000000000 +
+        ts.tv_nsec + (delay / UCLOCK_FREQ) * 1000000000 +
+        ((delay % UCLOCK_FREQ) * 1000000000) / UCLOCK_FREQ;
+}
+
+/** @internal @This submits the request of a pump.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ */
+static void upump_uring_arm(struct upump_uring *upump_uring)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump_uring->common.upump.mgr);
+    struct io_uring_sqe *sqe = upump_uring_get_sqe(uring_mgr);
+    if (unlikely(sqe == NULL))
+        return;
+
+    sqe->fd = upump_uring->fd;
+    sqe->user_data = (uintptr_t)upump_uring;
+    uint32_t poll_events = 0;
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_TIMER:
+            upump_uring->timer.ts.tv_sec =
+                upump_uring->timer.deadline / 1000000000;
+            upump_uring->timer.ts.tv_nsec =
+                upump_uring->timer.deadline % 1000000000;
+            sqe->opcode = IORING_OP_TIMEOUT;
+            sqe->fd = -1;
+            sqe->addr = (uintptr_t)&upump_uring->timer.ts;
+            sqe->len = 1;
+            sqe->timeout_flags = IORING_TIMEOUT_ABS;
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_SIGNAL:
+            poll_events = POLLIN;
+            break;
+        case UPUMP_TYPE_FD_WRITE:
+            poll_events = POLLOUT;
+            break;
+        case UPUMP_URING_TYPE_READ:
+        case UPUMP_URING_TYPE_WRITE:
+            sqe->opcode = upump_uring->event == UPUMP_URING_TYPE_READ ?
+                          IORING_OP_READ : IORING_OP_WRITE;
+            sqe->addr = (uintptr_t)upump_uring->rw.buffer;
+            sqe->len = upump_uring->rw.size;
+            sqe->off = upump_uring->rw.offset;
+            break;
+        case UPUMP_URING_TYPE_RECVMSG:
+            sqe->opcode = IORING_OP_RECVMSG;
+            sqe->addr = (uintptr_t)upump_uring->recvmsg.msghdr;
+            sqe->len = 1;
+            sqe->msg_flags = upump_uring->recvmsg.flags;
+            break;
+    }
+    if (poll_events) {
+        sqe->opcode = IORING_OP_POLL_ADD;
+#ifdef UPIPE_WORDS_BIGENDIAN
+        poll_events = (poll_events << 16) | (poll_events >> 16);
+#endif
+        sqe->poll32_events = poll_events;
+    }
+    upump_uring_commit_sqe(uring_mgr);
+    upump_uring->inflight = true;
+    upump_uring->rearm = false;
+}
+
+/** @internal @This cancels the pending request of a pump. The pump stays
+ * in flight until the completion of the cancelled request is reaped.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ */
+static void upump_uring_cancel(struct upump_uring *upump_uring)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump_uring->common.upump.mgr);
+    struct io_uring_sqe *sqe = upump_uring_get_sqe(uring_mgr);
+    if (unlikely(sqe == NULL))
+        return;
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_TIMER:
+            sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+        case UPUMP_TYPE_SIGNAL:
+            sqe->opcode = IORING_OP_POLL_REMOVE;
+            break;
+        default:
+            sqe->opcode = IORING_OP_ASYNC_CANCEL;
+            break;
+    }
+    sqe->fd = -1;
+    sqe->addr = (uintptr_t)upump_uring;
+    /* the completion of the cancel request itself is ignored */
+    sqe->user_data = 0;
+    upump_uring_commit_sqe(uring_mgr);
+}
+
+/** @internal @This reaps the completion ring, and queues the pumps whose
+ * request completed on the ready list.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_reap(struct upump_uring_mgr *uring_mgr)
+{
+    unsigned head = *uring_mgr->cq_head;
+    unsigned tail = __atomic_load_n(uring_mgr->cq_tail, __ATOMIC_ACQUIRE);
+
+    for ( ; head != tail; head++) {
+        struct io_uring_cqe *cqe = &uring_mgr->cqes[head & uring_mgr->cq_mask];
+        struct upump_uring *upump_uring =
+            (struct upump_uring *)(uintptr_t)cqe->user_data;
+        if (upump_uring == NULL)
+            continue;
+
+        upump_uring->inflight = false;
+        if (!upump_uring->active)
+            continue;
+        if (upump_uring->rearm) {
+            upump_uring_arm(upump_uring);
+            continue;
+        }
+        upump_uring->result = cqe->res;
+        if (upump_uring->uchain.next == NULL)
+            ulist_add(&uring_mgr->ready, &upump_uring->uchain);
+    }
+
+    __atomic_store_n(uring_mgr->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/** @internal @This dispatches a pump from the ready list.
+ *
+ * @param upump_uring pointer to a upump_uring structure
+ */
+static void upump_uring_dispatch(struct upump_uring *upump_uring)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump_uring->common.upump.mgr);
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_TIMER:
+            if (!upump_uring->timer.repeat)
+                upump_uring_set_blocking(upump_uring, false);
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            struct signalfd_siginfo siginfo;
+            if (read(upump_uring->fd, &siginfo, sizeof (siginfo)) == -1) {
+                upump_uring_arm(upump_uring);
+                return;
+            }
+            break;
+        }
+        case UPUMP_URING_TYPE_READ:
+        case UPUMP_URING_TYPE_WRITE:
+        case UPUMP_URING_TYPE_RECVMSG:
+            upump_uring_set_blocking(upump_uring, false);
+            break;
+        default:
+            break;
+    }
+
+    uring_mgr->dispatched = upump_uring;
+    upump_common_dispatch(upump_uring_to_upump(upump_uring));
+    if (uring_mgr->dispatched == NULL)
+        /* freed by the callback */
+        return;
+    uring_mgr->dispatched = NULL;
+
+    if (!upump_uring->active || upump_uring->inflight ||
+        upump_uring->uchain.next != NULL)
+        return;
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_TIMER:
+            if (upump_uring->timer.repeat) {
+                upump_uring->timer.deadline +=
+                    (upump_uring->timer.repeat / UCLOCK_FREQ) * 1000000000 +
+                    ((upump_uring->timer.repeat % UCLOCK_FREQ) * 1000000000) /
+                    UCLOCK_FREQ;
+                upump_uring_arm(upump_uring);
+            }
+            break;
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+        case UPUMP_TYPE_SIGNAL:
+            upump_uring_arm(upump_uring);
+            break;
+        default:
+            break;
+    }
+}
+
+/** @internal @This dispatches all started idlers once.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_dispatch_idlers(struct upump_uring_mgr *uring_mgr)
+{
+    struct uchain idlers;
+    ulist_init(&idlers);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&uring_mgr->idlers)) != NULL)
+        ulist_add(&idlers, uchain);
+
+    while ((uchain = ulist_pop(&idlers)) != NULL) {
+        /* put it back first, so that the callback may stop it */
+        ulist_add(&uring_mgr->idlers, uchain);
+        upump_common_dispatch(
+            upump_uring_to_upump(upump_uring_from_uchain(uchain)));
+    }
+}
+
+/** @This allocates a new upump_uring.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_uring_mgr structure
+ * @param event type of event to watch for
+ * @param args optional parameters depending on event type
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static struct upump *upump_uring_alloc(struct upump_mgr *mgr,
+                                       int event, va_list args)
+{
+    if (event >= UPUMP_TYPE_LOCAL) {
+        unsigned int signature = va_arg(args, unsigned int);
+        if (signature != mgr->signature)
+            return NULL;
+    }
+
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+    struct upump_uring *upump_uring =
+        upool_alloc(&uring_mgr->common_mgr.upump_pool, struct upump_uring *);
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+
+    switch (event) {
+        case UPUMP_TYPE_IDLER:
+            upump_uring->fd = -1;
+            break;
+        case UPUMP_TYPE_TIMER: {
+            uint64_t after = va_arg(args, uint64_t);
+            uint64_t repeat = va_arg(args, uint64_t);
+            if (after == 0)
+                after = repeat;
+            upump_uring->fd = -1;
+            upump_uring->timer.after = after;
+            upump_uring->timer.repeat = repeat;
+            break;
+        }
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            upump_uring->fd = va_arg(args, int);
+            break;
+        case UPUMP_TYPE_SIGNAL: {
+            int signal = va_arg(args, int);
+            sigset_t mask;
+            sigemptyset(&mask);
+            sigaddset(&mask, signal);
+            int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+            if (fd == -1) {
+                upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+                return NULL;
+            }
+            upump_uring->fd = fd;
+            break;
+        }
+        case UPUMP_URING_TYPE_READ:
+        case UPUMP_URING_TYPE_WRITE:
+            upump_uring->fd = va_arg(args, int);
+            upump_uring->rw.buffer = va_arg(args, void *);
+            upump_uring->rw.size = va_arg(args, size_t);
+            upump_uring->rw.offset = va_arg(args, int64_t);
+            break;
+        case UPUMP_URING_TYPE_RECVMSG:
+            upump_uring->fd = va_arg(args, int);
+            upump_uring->recvmsg.msghdr = va_arg(args, struct msghdr *);
+            upump_uring->recvmsg.flags = va_arg(args, int);
+            break;
+        case UPUMP_TYPE_WHEEL_TIMER:
+            upump_uring->fd = -1;
+            break;
+        default:
+            upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+            return NULL;
+    }
+    uchain_init(&upump_uring->uchain);
+    upump_uring->event = event;
+    upump_uring->result = 0;
+    upump_uring->active = false;
+    upump_uring->inflight = false;
+    upump_uring->rearm = false;
+    upump_uring->blocking = false;
+
+    upump_common_init(upump);
+    if (event == UPUMP_TYPE_TIMER)
+        upump_common_init_timer(upump, upump_uring->timer.after,
+                                upump_uring->timer.repeat);
+    if (event == UPUMP_TYPE_WHEEL_TIMER) {
+        uint64_t after = va_arg(args, uint64_t);
+        uint64_t repeat = va_arg(args, uint64_t);
+        upump_common_init_wheel_timer(upump, after, repeat);
+    }
+
+    return upump;
+}
+
+/** @This starts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_start(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+
+    upump_uring->active = true;
+    upump_uring_set_blocking(upump_uring, status);
+    if (upump_uring->event == UPUMP_TYPE_IDLER) {
+        ulist_add(&uring_mgr->idlers, &upump_uring->uchain);
+        return;
+    }
+    if (upump_uring->event == UPUMP_TYPE_TIMER)
+        upump_uring_set_deadline(upump_uring, upump_uring->timer.after);
+
+    if (upump_uring->inflight)
+        /* a cancelled request is still pending */
+        upump_uring->rearm = true;
+    else
+        upump_uring_arm(upump_uring);
+}
+
+/** @This stops a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_stop(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+
+    upump_uring->active = false;
+    upump_uring->rearm = false;
+    upump_uring_set_blocking(upump_uring, false);
+    if (upump_uring->uchain.next != NULL)
+        ulist_delete(&upump_uring->uchain);
+    if (upump_uring->inflight)
+        upump_uring_cancel(upump_uring);
+}
+
+/** @This restarts a pump. Timers are reset, and completed requests are
+ * submitted again.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_uring_real_restart(struct upump *upump, bool status)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+
+    if (!upump_uring->active) {
+        upump_uring_real_start(upump, status);
+        return;
+    }
+    if (upump_uring->event == UPUMP_TYPE_IDLER)
+        return;
+
+    upump_uring_set_blocking(upump_uring, status);
+    if (upump_uring->uchain.next != NULL)
+        ulist_delete(&upump_uring->uchain);
+
+    switch (upump_uring->event) {
+        case UPUMP_TYPE_TIMER: {
+            uint64_t value = upump_uring->timer.repeat ?:
+                             upump_uring->timer.after;
+            upump_uring_set_deadline(upump_uring, value);
+            break;
+        }
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+        case UPUMP_TYPE_SIGNAL:
+            if (upump_uring->inflight)
+                /* the pending poll request is still valid */
+                return;
+            break;
+        default:
+            break;
+    }
+
+    if (upump_uring->inflight) {
+        if (!upump_uring->rearm) {
+            upump_uring_cancel(upump_uring);
+            upump_uring->rearm = true;
+        }
+    } else
+        upump_uring_arm(upump_uring);
+}
+
+/** @This releases the memory space previously used by a pump.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_uring_free(struct upump *upump)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_upump_mgr(upump->mgr);
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+    upump_stop(upump);
+    upump_common_clean(upump);
+
+    /* the kernel may still reference the pump until the cancelled request
+     * completes */
+    while (upump_uring->inflight) {
+        if (unlikely(!upump_uring_submit(uring_mgr, true)))
+            break;
+        upump_uring_reap(uring_mgr);
+    }
+
+    if (upump_uring->event == UPUMP_TYPE_SIGNAL)
+        close(upump_uring->fd);
+    if (uring_mgr->dispatched == upump_uring)
+        uring_mgr->dispatched = NULL;
+    upool_free(&uring_mgr->common_mgr.upump_pool, upump_uring);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upump_uring or NULL in case of allocation error
+ */
+static void *upump_uring_alloc_inner(struct upool *upool)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_pool(upool);
+    struct upump_uring *upump_uring = malloc(sizeof(struct upump_uring));
+    if (unlikely(upump_uring == NULL))
+        return NULL;
+    struct upump *upump = upump_uring_to_upump(upump_uring);
+    upump->mgr = upump_common_mgr_to_upump_mgr(common_mgr);
+    return upump_uring;
+}
+
+/** @internal @This frees a upump_uring.
+ *
+ * @param upool pointer to upool
+ * @param upump_uring pointer to a upump_uring structure to free
+ */
+static void upump_uring_free_inner(struct upool *upool, void *upump_uring)
+{
+    free(upump_uring);
+}
+
+/** @This processes control commands on a upump_uring.
+ *
+ * @param upump description structure of the pump
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_uring_control(struct upump *upump, int command, va_list args)
+{
+    struct upump_uring *upump_uring = upump_uring_from_upump(upump);
+
+    switch (command) {
+        case UPUMP_START:
+            upump_common_start(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_RESTART:
+            upump_common_restart(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_STOP:
+            upump_common_stop(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_FREE:
+            upump_uring_free(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_GET_STATUS: {
+            int *status_p = va_arg(args, int *);
+            upump_common_get_status(upump, status_p);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_SET_STATUS: {
+            int status = va_arg(args, int);
+            upump_common_set_status(upump, status);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_ALLOC_BLOCKER: {
+            struct upump_blocker **p = va_arg(args, struct upump_blocker **);
+            *p = upump_common_blocker_alloc(upump);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_FREE_BLOCKER: {
+            struct upump_blocker *blocker =
+                va_arg(args, struct upump_blocker *);
+            upump_common_blocker_free(blocker);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_URING_GET_RESULT: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_URING_SIGNATURE)
+            ssize_t *result_p = va_arg(args, ssize_t *);
+            if (upump_uring->event < UPUMP_URING_TYPE_READ)
+                return UBASE_ERR_INVALID;
+            *result_p = upump_uring->result;
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_URING_SET_BUFFER: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_URING_SIGNATURE)
+            void *buffer = va_arg(args, void *);
+            size_t size = va_arg(args, size_t);
+            int64_t offset = va_arg(args, int64_t);
+            if (upump_uring->event != UPUMP_URING_TYPE_READ &&
+                upump_uring->event != UPUMP_URING_TYPE_WRITE)
+                return UBASE_ERR_INVALID;
+            upump_uring->rw.buffer = buffer;
+            upump_uring->rw.size = size;
+            upump_uring->rw.offset = offset;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This runs an event loop.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param mutex mutual exclusion primitives to access the event loop
+ * @return an error code
+ */
+static int upump_uring_mgr_run(struct upump_mgr *mgr, struct umutex *mutex)
+{
+    struct upump_uring_mgr *uring_mgr = upump_uring_mgr_from_upump_mgr(mgr);
+
+    if (mutex != NULL)
+        umutex_lock(mutex);
+
+    while (uring_mgr->blocking > 0) {
+        bool wait = ulist_empty(&uring_mgr->ready) &&
+                    ulist_empty(&uring_mgr->idlers);
+
+        if (wait && mutex != NULL)
+            umutex_unlock(mutex);
+        bool ret = upump_uring_submit(uring_mgr, wait);
+        if (wait && mutex != NULL)
+            umutex_lock(mutex);
+        if (unlikely(!ret)) {
+            if (mutex != NULL)
+                umutex_unlock(mutex);
+            return UBASE_ERR_EXTERNAL;
+        }
+
+        upump_uring_reap(uring_mgr);
+
+        if (ulist_empty(&uring_mgr->ready)) {
+            upump_uring_dispatch_idlers(uring_mgr);
+            continue;
+        }
+
+        struct uchain *uchain;
+        while ((uchain = ulist_pop(&uring_mgr->ready)) != NULL)
+            upump_uring_dispatch(upump_uring_from_uchain(uchain));
+    }
+
+    if (mutex != NULL)
+        umutex_unlock(mutex);
+    return UBASE_ERR_NONE;
+}
+
+/** @This processes control commands on a upump_uring_mgr.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_uring_mgr_control(struct upump_mgr *mgr,
+                                   int command, va_list args)
+{
+    switch (command) {
+        case UPUMP_MGR_RUN: {
+            struct umutex *mutex = va_arg(args, struct umutex *);
+            return upump_uring_mgr_run(mgr, mutex);
+        }
+        case UPUMP_MGR_VACUUM:
+            upump_common_mgr_vacuum(mgr);
+            return UBASE_ERR_NONE;
+        default:
+            return upump_common_mgr_control(mgr, command, args);
+    }
+}
+
+/** @internal @This unmaps the rings and closes the io_uring.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ */
+static void upump_uring_mgr_clean(struct upump_uring_mgr *uring_mgr)
+{
+    if (uring_mgr->sqes != NULL)
+        munmap(uring_mgr->sqes, uring_mgr->sqes_size);
+    if (uring_mgr->cq_ring != NULL && uring_mgr->cq_ring != uring_mgr->sq_ring)
+        munmap(uring_mgr->cq_ring, uring_mgr->cq_ring_size);
+    if (uring_mgr->sq_ring != NULL)
+        munmap(uring_mgr->sq_ring, uring_mgr->sq_ring_size);
+    close(uring_mgr->fd);
+}
+
+/** @This frees a upump manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_uring_mgr_free(struct urefcount *urefcount)
+{
+    struct upump_uring_mgr *uring_mgr =
+        upump_uring_mgr_from_urefcount(urefcount);
+    upump_common_mgr_clean(upump_uring_mgr_to_upump_mgr(uring_mgr));
+    upump_uring_mgr_clean(uring_mgr);
+    free(uring_mgr);
+}
+
+/** @internal @This sets up the io_uring and maps its rings.
+ *
+ * @param uring_mgr pointer to a upump_uring_mgr structure
+ * @return false in case of error
+ */
+static bool upump_uring_mgr_setup(struct upump_uring_mgr *uring_mgr)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    uring_mgr->sq_ring = uring_mgr->cq_ring = NULL;
+    uring_mgr->sqes = NULL;
+    uring_mgr->fd = upump_uring_setup(UPUMP_URING_ENTRIES, &params);
+    if (unlikely(uring_mgr->fd < 0))
+        return false;
+
+    uring_mgr->sq_ring_size = params.sq_off.array +
+                              params.sq_entries * sizeof(unsigned);
+    uring_mgr->cq_ring_size = params.cq_off.cqes +
+                              params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (uring_mgr->cq_ring_size > uring_mgr->sq_ring_size)
+            uring_mgr->sq_ring_size = uring_mgr->cq_ring_size;
+        uring_mgr->cq_ring_size = uring_mgr->sq_ring_size;
+    }
+
+    void *sq_ring = mmap(NULL, uring_mgr->sq_ring_size,
+                         PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                         uring_mgr->fd, IORING_OFF_SQ_RING);
+    if (unlikely(sq_ring == MAP_FAILED))
+        goto upump_uring_mgr_setup_err;
+    uring_mgr->sq_ring = sq_ring;
+
+    void *cq_ring = sq_ring;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)) {
+        cq_ring = mmap(NULL, uring_mgr->cq_ring_size,
+                       PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       uring_mgr->fd, IORING_OFF_CQ_RING);
+        if (unlikely(cq_ring == MAP_FAILED))
+            goto upump_uring_mgr_setup_err;
+    }
+    uring_mgr->cq_ring = cq_ring;
+
+    uring_mgr->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, uring_mgr->sqes_size,
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      uring_mgr->fd, IORING_OFF_SQES);
+    if (unlikely(sqes == MAP_FAILED))
+        goto upump_uring_mgr_setup_err;
+    uring_mgr->sqes = sqes;
+
+    uint8_t *sq = sq_ring;
+    uint8_t *cq = cq_ring;
+    uring_mgr->sq_head = (unsigned *)(sq + params.sq_off.head);
+    uring_mgr->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    uring_mgr->sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+    uring_mgr->sq_entries = params.sq_entries;
+    uring_mgr->cq_head = (unsigned *)(cq + params.cq_off.head);
+    uring_mgr->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    uring_mgr->cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+    uring_mgr->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    uring_mgr->to_submit = 0;
+
+    /* submission queue entries are always used in ring order */
+    unsigned *sq_array = (unsigned *)(sq + params.sq_off.array);
+    for (unsigned i = 0; i < params.sq_entries; i++)
+        sq_array[i] = i;
+    return true;
+
+upump_uring_mgr_setup_err:
+    upump_uring_mgr_clean(uring_mgr);
+    return false;
+}
+
+/** @This allocates and initializes a upump_uring_mgr structure.
+ *
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @return pointer to the wrapped upump_mgr structure
+ */
+struct upump_mgr *upump_uring_mgr_alloc(uint16_t upump_pool_depth,
+                                        uint16_t upump_blocker_pool_depth)
+{
+    struct upump_uring_mgr *uring_mgr =
+        malloc(sizeof(struct upump_uring_mgr) +
+               upump_common_mgr_sizeof(upump_pool_depth,
+                                       upump_blocker_pool_depth));
+    if (unlikely(uring_mgr == NULL))
+        return NULL;
+
+    if (unlikely(!upump_uring_mgr_setup(uring_mgr))) {
+        free(uring_mgr);
+        return NULL;
+    }
+
+    struct upump_mgr *mgr = upump_uring_mgr_to_upump_mgr(uring_mgr);
+    mgr->signature = UPUMP_URING_SIGNATURE;
+    urefcount_init(upump_uring_mgr_to_urefcount(uring_mgr),
+                   upump_uring_mgr_free);
+    uring_mgr->common_mgr.mgr.refcount =
+        upump_uring_mgr_to_urefcount(uring_mgr);
+    uring_mgr->common_mgr.mgr.upump_alloc = upump_uring_alloc;
+    uring_mgr->common_mgr.mgr.upump_control = upump_uring_control;
+    uring_mgr->common_mgr.mgr.upump_mgr_control = upump_uring_mgr_control;
+    upump_common_mgr_init(mgr, upump_pool_depth, upump_blocker_pool_depth,
+                          uring_mgr->upool_extra,
+                          upump_uring_real_start, upump_uring_real_stop,
+                          upump_uring_real_restart,
+                          upump_uring_alloc_inner, upump_uring_free_inner);
+
+    ulist_init(&uring_mgr->idlers);
+    ulist_init(&uring_mgr->ready);
+    uring_mgr->blocking = 0;
+    uring_mgr->dispatched = NULL;
+    return mgr;
+}
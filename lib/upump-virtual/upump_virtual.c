@@ -0,0 +1,703 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short implementation of a Upipe event loop running on virtual time
+ *
+ * Each iteration of the loop dispatches, in order of priority, the timers
+ * whose deadline has passed, the file descriptors polled ready without
+ * waiting, and the started idlers. When there is nothing to dispatch, the
+ * virtual clock jumps to the deadline of the next timer instead of sleeping.
+ * Timers with the same deadline fire in the order they were armed, so that
+ * the same pipeline always sees the same sequence of events.
+ */
+
+#include "upipe/ubase.h"
+#include "upipe/ulist.h"
+#include "upipe/urefcount.h"
+#include "upipe/uclock.h"
+#include "upipe/umutex.h"
+#include "upipe/upump.h"
+#include "upipe/upump_common.h"
+#include "upump-virtual/upump_virtual.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+
+/** @This stores management parameters and local structures.
+ */
+struct upump_virtual_mgr {
+    /** refcount management structure */
+    struct urefcount urefcount;
+    /** virtual clock */
+    struct uclock uclock;
+    /** current virtual time */
+    uint64_t now;
+
+    /** list of started timers, sorted by deadline */
+    struct uchain timers;
+    /** list of started file descriptor watchers */
+    struct uchain fds;
+    /** list of started idlers */
+    struct uchain idlers;
+    /** list of pumps to dispatch */
+    struct uchain ready;
+    /** number of active blocking pumps */
+    unsigned blocking;
+
+    /** array of file descriptors to poll */
+    struct pollfd *pollfds;
+    /** allocated size of the array */
+    unsigned pollfds_size;
+
+    /** common structure */
+    struct upump_common_mgr common_mgr;
+
+    /** extra space for upool */
+    uint8_t upool_extra[];
+};
+
+UBASE_FROM_TO(upump_virtual_mgr, upump_mgr, upump_mgr, common_mgr.mgr)
+UBASE_FROM_TO(upump_virtual_mgr, urefcount, urefcount, urefcount)
+UBASE_FROM_TO(upump_virtual_mgr, uclock, uclock, uclock)
+
+/** @This stores local structures.
+ */
+struct upump_virtual {
+    /** structure for the timers, fds or idlers list */
+    struct uchain uchain;
+    /** structure for the ready list */
+    struct uchain ready;
+
+    /** type of event to watch */
+    int event;
+
+    /** private structure */
+    union {
+        struct {
+            uint64_t after;
+            uint64_t repeat;
+            /** absolute virtual deadline */
+            uint64_t deadline;
+        } timer;
+        /** file descriptor */
+        int fd;
+    };
+
+    /** true if the pump was started by the common layer */
+    bool active;
+    /** true if the pump is accounted in the blocking counter */
+    bool blocking;
+
+    /** common structure */
+    struct upump_common common;
+};
+
+UBASE_FROM_TO(upump_virtual, upump, upump, common.upump)
+UBASE_FROM_TO(upump_virtual, uchain, uchain, uchain)
+UBASE_FROM_TO(upump_virtual, uchain, ready, ready)
+
+/** @internal @This returns the current virtual time.
+ *
+ * @param uclock pointer to the uclock structure of the manager
+ * @return current virtual time in 27 MHz ticks
+ */
+static uint64_t upump_virtual_now(struct uclock *uclock)
+{
+    return upump_virtual_mgr_from_uclock(uclock)->now;
+}
+
+/** @internal @This updates the blocking counter of the manager.
+ *
+ * @param upump_virtual pointer to a upump_virtual structure
+ * @param blocking true if the pump prevents the loop from exiting
+ */
+static void upump_virtual_set_blocking(struct upump_virtual *upump_virtual,
+                                       bool blocking)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(upump_virtual->common.upump.mgr);
+    if (upump_virtual->blocking == blocking)
+        return;
+    upump_virtual->blocking = blocking;
+    if (blocking)
+        virtual_mgr->blocking++;
+    else
+        virtual_mgr->blocking--;
+}
+
+/** @internal @This compares the deadlines of two timers.
+ *
+ * @param uchain1 pointer to the uchain of the first timer
+ * @param uchain2 pointer to the uchain of the second timer
+ * @return an integer less than, equal to, or greater than zero
+ */
+static int upump_virtual_compare(struct uchain *uchain1,
+                                 struct uchain *uchain2)
+{
+    uint64_t deadline1 = upump_virtual_from_uchain(uchain1)->timer.deadline;
+    uint64_t deadline2 = upump_virtual_from_uchain(uchain2)->timer.deadline;
+    return deadline1 < deadline2 ? -1 : deadline1 > deadline2;
+}
+
+/** @internal @This inserts a timer in the sorted list of timers, after the
+ * timers with the same deadline.
+ *
+ * @param upump_virtual pointer to a upump_virtual structure
+ * @param deadline absolute virtual deadline
+ */
+static void upump_virtual_arm(struct upump_virtual *upump_virtual,
+                              uint64_t deadline)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(upump_virtual->common.upump.mgr);
+    upump_virtual->timer.deadline = deadline;
+    ulist_bubble(&virtual_mgr->timers, &upump_virtual->uchain,
+                 upump_virtual_compare);
+}
+
+/** @internal @This dispatches the timers whose deadline has passed.
+ *
+ * @param virtual_mgr pointer to a upump_virtual_mgr structure
+ * @return true if at least one timer was dispatched
+ */
+static bool upump_virtual_dispatch_timers(
+        struct upump_virtual_mgr *virtual_mgr)
+{
+    bool dispatched = false;
+    struct uchain *uchain;
+    while ((uchain = ulist_peek(&virtual_mgr->timers)) != NULL) {
+        struct upump_virtual *upump_virtual =
+            upump_virtual_from_uchain(uchain);
+        if (upump_virtual->timer.deadline > virtual_mgr->now)
+            break;
+
+        ulist_delete(uchain);
+        if (upump_virtual->timer.repeat)
+            upump_virtual_arm(upump_virtual, upump_virtual->timer.deadline +
+                                             upump_virtual->timer.repeat);
+        else {
+            /* one-shot timers are stopped, as with the other event loops */
+            upump_virtual->active = false;
+            upump_virtual_set_blocking(upump_virtual, false);
+        }
+        upump_common_dispatch(upump_virtual_to_upump(upump_virtual));
+        dispatched = true;
+    }
+    return dispatched;
+}
+
+/** @internal @This polls the started file descriptor watchers and queues
+ * the ready ones.
+ *
+ * @param virtual_mgr pointer to a upump_virtual_mgr structure
+ * @param timeout poll timeout in milliseconds, or -1 to wait forever
+ * @param mutex mutual exclusion primitives to release while waiting, or NULL
+ * @return false in case of fatal error
+ */
+static bool upump_virtual_poll(struct upump_virtual_mgr *virtual_mgr,
+                               int timeout, struct umutex *mutex)
+{
+    unsigned nfds = 0;
+    struct uchain *uchain;
+    ulist_foreach (&virtual_mgr->fds, uchain)
+        nfds++;
+    if (!nfds)
+        return true;
+
+    if (nfds > virtual_mgr->pollfds_size) {
+        struct pollfd *pollfds = realloc(virtual_mgr->pollfds,
+                                         nfds * sizeof(struct pollfd));
+        if (unlikely(pollfds == NULL))
+            return false;
+        virtual_mgr->pollfds = pollfds;
+        virtual_mgr->pollfds_size = nfds;
+    }
+
+    unsigned i = 0;
+    ulist_foreach (&virtual_mgr->fds, uchain) {
+        struct upump_virtual *upump_virtual =
+            upump_virtual_from_uchain(uchain);
+        virtual_mgr->pollfds[i].fd = upump_virtual->fd;
+        virtual_mgr->pollfds[i].events =
+            upump_virtual->event == UPUMP_TYPE_FD_READ ? POLLIN : POLLOUT;
+        virtual_mgr->pollfds[i].revents = 0;
+        i++;
+    }
+
+    if (timeout && mutex != NULL)
+        umutex_unlock(mutex);
+    int ret = poll(virtual_mgr->pollfds, nfds, timeout);
+    if (timeout && mutex != NULL)
+        umutex_lock(mutex);
+    if (ret < 0)
+        return errno == EINTR || errno == EAGAIN;
+    if (!ret)
+        return true;
+
+    /* the list was not modified while polling */
+    i = 0;
+    ulist_foreach (&virtual_mgr->fds, uchain) {
+        struct upump_virtual *upump_virtual =
+            upump_virtual_from_uchain(uchain);
+        if (virtual_mgr->pollfds[i++].revents)
+            ulist_add(&virtual_mgr->ready, &upump_virtual->ready);
+    }
+    return true;
+}
+
+/** @internal @This dispatches the queued file descriptor watchers.
+ *
+ * @param virtual_mgr pointer to a upump_virtual_mgr structure
+ * @return true if at least one watcher was dispatched
+ */
+static bool upump_virtual_dispatch_ready(
+        struct upump_virtual_mgr *virtual_mgr)
+{
+    bool dispatched = false;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&virtual_mgr->ready)) != NULL) {
+        upump_common_dispatch(
+            upump_virtual_to_upump(upump_virtual_from_ready(uchain)));
+        dispatched = true;
+    }
+    return dispatched;
+}
+
+/** @internal @This dispatches all started idlers once.
+ *
+ * @param virtual_mgr pointer to a upump_virtual_mgr structure
+ */
+static void upump_virtual_dispatch_idlers(
+        struct upump_virtual_mgr *virtual_mgr)
+{
+    struct uchain idlers;
+    ulist_init(&idlers);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&virtual_mgr->idlers)) != NULL)
+        ulist_add(&idlers, uchain);
+
+    while ((uchain = ulist_pop(&idlers)) != NULL) {
+        /* put it back first, so that the callback may stop it */
+        ulist_add(&virtual_mgr->idlers, uchain);
+        upump_common_dispatch(
+            upump_virtual_to_upump(upump_virtual_from_uchain(uchain)));
+    }
+}
+
+/** @This allocates a new upump_virtual.
+ *
+ * @param mgr pointer to a upump_mgr structure wrapped into a
+ * upump_virtual_mgr structure
+ * @param event type of event to watch for
+ * @param args optional parameters depending on event type
+ * @return pointer to allocated pump, or NULL in case of failure
+ */
+static struct upump *upump_virtual_alloc(struct upump_mgr *mgr,
+                                         int event, va_list args)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(mgr);
+    struct upump_virtual *upump_virtual;
+
+    switch (event) {
+        case UPUMP_TYPE_IDLER:
+        case UPUMP_TYPE_TIMER:
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+        case UPUMP_TYPE_WHEEL_TIMER:
+            break;
+        default:
+            /* signals cannot be replayed */
+            return NULL;
+    }
+
+    upump_virtual = upool_alloc(&virtual_mgr->common_mgr.upump_pool,
+                                struct upump_virtual *);
+    if (unlikely(upump_virtual == NULL))
+        return NULL;
+    struct upump *upump = upump_virtual_to_upump(upump_virtual);
+
+    switch (event) {
+        case UPUMP_TYPE_TIMER: {
+            uint64_t after = va_arg(args, uint64_t);
+            uint64_t repeat = va_arg(args, uint64_t);
+            if (after == 0)
+                after = repeat;
+            upump_virtual->timer.after = after;
+            upump_virtual->timer.repeat = repeat;
+            upump_virtual->timer.deadline = 0;
+            break;
+        }
+        case UPUMP_TYPE_FD_READ:
+        case UPUMP_TYPE_FD_WRITE:
+            upump_virtual->fd = va_arg(args, int);
+            break;
+        default:
+            break;
+    }
+    uchain_init(&upump_virtual->uchain);
+    uchain_init(&upump_virtual->ready);
+    upump_virtual->event = event;
+    upump_virtual->active = false;
+    upump_virtual->blocking = false;
+
+    upump_common_init(upump);
+    if (event == UPUMP_TYPE_TIMER)
+        upump_common_init_timer(upump, upump_virtual->timer.after,
+                                upump_virtual->timer.repeat);
+    if (event == UPUMP_TYPE_WHEEL_TIMER) {
+        uint64_t after = va_arg(args, uint64_t);
+        uint64_t repeat = va_arg(args, uint64_t);
+        upump_common_init_wheel_timer(upump, after, repeat);
+    }
+
+    return upump;
+}
+
+/** @This starts a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_virtual_real_start(struct upump *upump, bool status)
+{
+    struct upump_virtual *upump_virtual = upump_virtual_from_upump(upump);
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(upump->mgr);
+
+    upump_virtual->active = true;
+    upump_virtual_set_blocking(upump_virtual, status);
+    switch (upump_virtual->event) {
+        case UPUMP_TYPE_IDLER:
+            ulist_add(&virtual_mgr->idlers, &upump_virtual->uchain);
+            break;
+        case UPUMP_TYPE_TIMER:
+            upump_virtual_arm(upump_virtual,
+                              virtual_mgr->now + upump_virtual->timer.after);
+            break;
+        default:
+            ulist_add(&virtual_mgr->fds, &upump_virtual->uchain);
+            break;
+    }
+}
+
+/** @This stops a pump.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_virtual_real_stop(struct upump *upump, bool status)
+{
+    struct upump_virtual *upump_virtual = upump_virtual_from_upump(upump);
+
+    upump_virtual->active = false;
+    upump_virtual_set_blocking(upump_virtual, false);
+    if (upump_virtual->uchain.next != NULL)
+        ulist_delete(&upump_virtual->uchain);
+    if (upump_virtual->ready.next != NULL)
+        ulist_delete(&upump_virtual->ready);
+}
+
+/** @This restarts a pump. Timers are reset from the current virtual time.
+ *
+ * @param upump description structure of the pump
+ * @param status blocking status of the pump
+ */
+static void upump_virtual_real_restart(struct upump *upump, bool status)
+{
+    struct upump_virtual *upump_virtual = upump_virtual_from_upump(upump);
+
+    if (!upump_virtual->active) {
+        upump_virtual_real_start(upump, status);
+        return;
+    }
+
+    upump_virtual_set_blocking(upump_virtual, status);
+    if (upump_virtual->event != UPUMP_TYPE_TIMER)
+        return;
+
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(upump->mgr);
+    ulist_delete(&upump_virtual->uchain);
+    upump_virtual_arm(upump_virtual, virtual_mgr->now +
+                      (upump_virtual->timer.repeat ?:
+                       upump_virtual->timer.after));
+}
+
+/** @This releases the memory space previously used by a pump.
+ *
+ * @param upump description structure of the pump
+ */
+static void upump_virtual_free(struct upump *upump)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(upump->mgr);
+    struct upump_virtual *upump_virtual = upump_virtual_from_upump(upump);
+    upump_stop(upump);
+    upump_common_clean(upump);
+    upool_free(&virtual_mgr->common_mgr.upump_pool, upump_virtual);
+}
+
+/** @internal @This allocates the data structure.
+ *
+ * @param upool pointer to upool
+ * @return pointer to upump_virtual or NULL in case of allocation error
+ */
+static void *upump_virtual_alloc_inner(struct upool *upool)
+{
+    struct upump_common_mgr *common_mgr =
+        upump_common_mgr_from_upump_pool(upool);
+    struct upump_virtual *upump_virtual =
+        malloc(sizeof(struct upump_virtual));
+    if (unlikely(upump_virtual == NULL))
+        return NULL;
+    struct upump *upump = upump_virtual_to_upump(upump_virtual);
+    upump->mgr = upump_common_mgr_to_upump_mgr(common_mgr);
+    return upump_virtual;
+}
+
+/** @internal @This frees a upump_virtual.
+ *
+ * @param upool pointer to upool
+ * @param upump_virtual pointer to a upump_virtual structure to free
+ */
+static void upump_virtual_free_inner(struct upool *upool, void *upump_virtual)
+{
+    free(upump_virtual);
+}
+
+/** @This processes control commands on a upump_virtual.
+ *
+ * @param upump description structure of the pump
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_virtual_control(struct upump *upump, int command,
+                                 va_list args)
+{
+    switch (command) {
+        case UPUMP_START:
+            upump_common_start(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_RESTART:
+            upump_common_restart(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_STOP:
+            upump_common_stop(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_FREE:
+            upump_virtual_free(upump);
+            return UBASE_ERR_NONE;
+        case UPUMP_GET_STATUS: {
+            int *status_p = va_arg(args, int *);
+            upump_common_get_status(upump, status_p);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_SET_STATUS: {
+            int status = va_arg(args, int);
+            upump_common_set_status(upump, status);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_ALLOC_BLOCKER: {
+            struct upump_blocker **p = va_arg(args, struct upump_blocker **);
+            *p = upump_common_blocker_alloc(upump);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_FREE_BLOCKER: {
+            struct upump_blocker *blocker =
+                va_arg(args, struct upump_blocker *);
+            upump_common_blocker_free(blocker);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** @internal @This runs an event loop.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param mutex mutual exclusion primitives to access the event loop
+ * @return an error code
+ */
+static int upump_virtual_mgr_run(struct upump_mgr *mgr, struct umutex *mutex)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(mgr);
+    int err = UBASE_ERR_NONE;
+
+    if (mutex != NULL)
+        umutex_lock(mutex);
+
+    while (virtual_mgr->blocking > 0) {
+        if (upump_virtual_dispatch_timers(virtual_mgr))
+            continue;
+
+        if (unlikely(!upump_virtual_poll(virtual_mgr, 0, mutex))) {
+            err = UBASE_ERR_EXTERNAL;
+            break;
+        }
+        if (upump_virtual_dispatch_ready(virtual_mgr))
+            continue;
+
+        if (!ulist_empty(&virtual_mgr->idlers)) {
+            upump_virtual_dispatch_idlers(virtual_mgr);
+            continue;
+        }
+
+        struct uchain *uchain = ulist_peek(&virtual_mgr->timers);
+        if (uchain != NULL) {
+            /* nothing else to do, jump to the next deadline */
+            virtual_mgr->now =
+                upump_virtual_from_uchain(uchain)->timer.deadline;
+            continue;
+        }
+
+        /* only file descriptors are left, wait for them */
+        if (unlikely(!upump_virtual_poll(virtual_mgr, -1, mutex))) {
+            err = UBASE_ERR_EXTERNAL;
+            break;
+        }
+        upump_virtual_dispatch_ready(virtual_mgr);
+    }
+
+    if (mutex != NULL)
+        umutex_unlock(mutex);
+    return err;
+}
+
+/** @This processes control commands on a upump_virtual_mgr.
+ *
+ * @param mgr pointer to a upump_mgr structure
+ * @param command type of command to process
+ * @param args arguments of the command
+ * @return an error code
+ */
+static int upump_virtual_mgr_control(struct upump_mgr *mgr,
+                                     int command, va_list args)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_upump_mgr(mgr);
+
+    switch (command) {
+        case UPUMP_MGR_RUN: {
+            struct umutex *mutex = va_arg(args, struct umutex *);
+            return upump_virtual_mgr_run(mgr, mutex);
+        }
+        case UPUMP_MGR_VACUUM:
+            upump_common_mgr_vacuum(mgr);
+            return UBASE_ERR_NONE;
+        case UPUMP_VIRTUAL_MGR_GET_UCLOCK: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_VIRTUAL_SIGNATURE)
+            struct uclock **uclock_p = va_arg(args, struct uclock **);
+            *uclock_p = upump_virtual_mgr_to_uclock(virtual_mgr);
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_VIRTUAL_MGR_GET_TIME: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_VIRTUAL_SIGNATURE)
+            uint64_t *now_p = va_arg(args, uint64_t *);
+            *now_p = virtual_mgr->now;
+            return UBASE_ERR_NONE;
+        }
+        case UPUMP_VIRTUAL_MGR_SET_TIME: {
+            UBASE_SIGNATURE_CHECK(args, UPUMP_VIRTUAL_SIGNATURE)
+            uint64_t now = va_arg(args, uint64_t);
+            if (now < virtual_mgr->now)
+                return UBASE_ERR_INVALID;
+            virtual_mgr->now = now;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return upump_common_mgr_control(mgr, command, args);
+    }
+}
+
+/** @This frees a upump manager.
+ *
+ * @param urefcount pointer to urefcount
+ */
+static void upump_virtual_mgr_free(struct urefcount *urefcount)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        upump_virtual_mgr_from_urefcount(urefcount);
+    upump_common_mgr_clean(upump_virtual_mgr_to_upump_mgr(virtual_mgr));
+    free(virtual_mgr->pollfds);
+    free(virtual_mgr);
+}
+
+/** @This allocates and initializes a upump_virtual_mgr structure.
+ *
+ * @param upump_pool_depth maximum number of upump structures in the pool
+ * @param upump_blocker_pool_depth maximum number of upump_blocker structures in
+ * the pool
+ * @param now initial virtual time, in 27 MHz ticks
+ * @return pointer to the wrapped upump_mgr structure
+ */
+struct upump_mgr *upump_virtual_mgr_alloc(uint16_t upump_pool_depth,
+                                          uint16_t upump_blocker_pool_depth,
+                                          uint64_t now)
+{
+    struct upump_virtual_mgr *virtual_mgr =
+        malloc(sizeof(struct upump_virtual_mgr) +
+               upump_common_mgr_sizeof(upump_pool_depth,
+                                       upump_blocker_pool_depth));
+    if (unlikely(virtual_mgr == NULL))
+        return NULL;
+
+    struct upump_mgr *mgr = upump_virtual_mgr_to_upump_mgr(virtual_mgr);
+    mgr->signature = UPUMP_VIRTUAL_SIGNATURE;
+    urefcount_init(upump_virtual_mgr_to_urefcount(virtual_mgr),
+                   upump_virtual_mgr_free);
+    virtual_mgr->common_mgr.mgr.refcount =
+        upump_virtual_mgr_to_urefcount(virtual_mgr);
+    virtual_mgr->common_mgr.mgr.upump_alloc = upump_virtual_alloc;
+    virtual_mgr->common_mgr.mgr.upump_control = upump_virtual_control;
+    virtual_mgr->common_mgr.mgr.upump_mgr_control = upump_virtual_mgr_control;
+    upump_common_mgr_init(mgr, upump_pool_depth, upump_blocker_pool_depth,
+                          virtual_mgr->upool_extra,
+                          upump_virtual_real_start, upump_virtual_real_stop,
+                          upump_virtual_real_restart,
+                          upump_virtual_alloc_inner,
+                          upump_virtual_free_inner);
+
+    virtual_mgr->uclock.refcount = upump_virtual_mgr_to_urefcount(virtual_mgr);
+    virtual_mgr->uclock.uclock_now = upump_virtual_now;
+    virtual_mgr->uclock.uclock_to_real = NULL;
+    virtual_mgr->uclock.uclock_from_real = NULL;
+    virtual_mgr->now = now;
+    /* timers of the wheel run on virtual time as well */
+    virtual_mgr->common_mgr.uclock = upump_virtual_mgr_to_uclock(virtual_mgr);
+
+    ulist_init(&virtual_mgr->timers);
+    ulist_init(&virtual_mgr->fds);
+    ulist_init(&virtual_mgr->idlers);
+    ulist_init(&virtual_mgr->ready);
+    virtual_mgr->blocking = 0;
+    virtual_mgr->pollfds = NULL;
+    virtual_mgr->pollfds_size = 0;
+    return mgr;
+}
@@ -22,12 +22,17 @@ local count_mgr = upipe {
         pipe.props.duration = 0
     end,
 
-    input = function (pipe, ref, pump)
-        local duration = ref:clock_get_duration()
-        if duration then
-            pipe.props.duration = pipe.props.duration + duration
+    input_batch = function (pipe, refs, nb)
+        local total = 0
+        for i = 0, nb - 1 do
+            local ref = refs[i]
+            local duration = ref:clock_get_duration()
+            if duration then
+                total = total + duration
+            end
+            ref:free()
         end
-        ref:free()
+        pipe.props.duration = pipe.props.duration + total
     end,
 
     control = {
@@ -34,6 +34,10 @@ struct upipe_helper_mgr {
 
     // uref_stream
     void (*stream_append_cb)(struct upipe *);
+
+    // input_batch
+    void (*input_batch)(struct upipe *, struct uref **, unsigned int);
+    unsigned int batch_size;
 };
 
 struct upipe_helper {
@@ -97,6 +101,11 @@ struct upipe_helper {
 
     // upump
     struct upump *upump;
+
+    // input_batch
+    struct uref **batch;
+    unsigned int batch_nb;
+    struct upump *upump_batch;
 };
 
 static struct upipe_helper_mgr *upipe_helper_mgr(struct upipe *upipe)
@@ -195,3 +204,98 @@ UPIPE_HELPER_UREF_STREAM(upipe_helper, next_uref, next_uref_size, stream_urefs,
                          append_cb);
 UPIPE_HELPER_FLOW_DEF(upipe_helper, flow_def_input, flow_def_attr);
 UPIPE_HELPER_UPUMP(upipe_helper, upump, upump_mgr);
+UPIPE_HELPER_UPUMP(upipe_helper, upump_batch, upump_mgr);
+
+#undef static
+#undef inline
+
+/* Batched input: urefs are queued on the C side and handed to the Lua
+ * input_batch callback as an array, once per batch_size urefs or once per
+ * event loop iteration, so that the C/Lua boundary is only crossed once per
+ * batch. */
+
+void upipe_helper_init_batch(struct upipe *upipe)
+{
+    struct upipe_helper *upipe_helper = upipe_helper_from_upipe(upipe);
+    upipe_helper->batch = NULL;
+    upipe_helper->batch_nb = 0;
+    upipe_helper_init_upump_batch(upipe);
+}
+
+void upipe_helper_flush_batch(struct upipe *upipe)
+{
+    struct upipe_helper_mgr *mgr = upipe_helper_mgr(upipe);
+    struct upipe_helper *upipe_helper = upipe_helper_from_upipe(upipe);
+
+    upipe_helper_set_upump_batch(upipe, NULL);
+    unsigned int nb = upipe_helper->batch_nb;
+    if (!nb)
+        return;
+    upipe_helper->batch_nb = 0;
+
+    if (mgr->input_batch == NULL) {
+        for (unsigned int i = 0; i < nb; i++)
+            uref_free(upipe_helper->batch[i]);
+        return;
+    }
+
+    upipe_use(upipe);
+    mgr->input_batch(upipe, upipe_helper->batch, nb);
+    upipe_release(upipe);
+}
+
+static void upipe_helper_batch_idler(struct upump *upump)
+{
+    struct upipe *upipe = upump_get_opaque(upump, struct upipe *);
+    upipe_helper_flush_batch(upipe);
+}
+
+void upipe_helper_input_batch(struct upipe *upipe, struct uref *uref,
+                              struct upump **upump_p)
+{
+    struct upipe_helper_mgr *mgr = upipe_helper_mgr(upipe);
+    struct upipe_helper *upipe_helper = upipe_helper_from_upipe(upipe);
+    unsigned int batch_size = mgr->batch_size ? mgr->batch_size : 1;
+
+    if (upipe_helper->batch == NULL) {
+        upipe_helper->batch = malloc(batch_size * sizeof(struct uref *));
+        if (unlikely(upipe_helper->batch == NULL)) {
+            uref_free(uref);
+            upipe_throw_fatal(upipe, UBASE_ERR_ALLOC);
+            return;
+        }
+    }
+
+    upipe_helper->batch[upipe_helper->batch_nb++] = uref;
+    if (upipe_helper->batch_nb >= batch_size) {
+        upipe_helper_flush_batch(upipe);
+        return;
+    }
+
+    if (upipe_helper->upump_batch != NULL)
+        return;
+
+    /* flush the batch once the event loop is idle */
+    struct upump *upump = NULL;
+    if (ubase_check(upipe_helper_check_upump_mgr(upipe)))
+        upump = upump_alloc_idler(upipe_helper->upump_mgr,
+                                  upipe_helper_batch_idler, upipe,
+                                  upipe->refcount);
+    if (upump == NULL) {
+        upipe_helper_flush_batch(upipe);
+        return;
+    }
+    upipe_helper_set_upump_batch(upipe, upump);
+    upump_start(upump);
+}
+
+void upipe_helper_clean_batch(struct upipe *upipe)
+{
+    struct upipe_helper *upipe_helper = upipe_helper_from_upipe(upipe);
+    upipe_helper_clean_upump_batch(upipe);
+    for (unsigned int i = 0; i < upipe_helper->batch_nb; i++)
+        uref_free(upipe_helper->batch[i]);
+    free(upipe_helper->batch);
+    upipe_helper->batch = NULL;
+    upipe_helper->batch_nb = 0;
+}
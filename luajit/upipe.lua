@@ -584,6 +584,13 @@ local function upipe_helper_alloc(cb)
         h_mgr.output = cb.input_output
     end
 
+    if cb.input_batch then
+        h_mgr.input_batch = function (pipe, refs, nb)
+            xpcall(cb.input_batch, dump_traceback, pipe, refs, nb)
+        end
+        h_mgr.batch_size = cb.batch_size or 32
+    end
+
     local _control = {}
 
     local mgr = h_mgr.mgr
@@ -607,6 +614,7 @@ local function upipe_helper_alloc(cb)
             pipe:helper_init_uref_stream()
             pipe:helper_init_flow_def()
             pipe:helper_init_upump()
+            pipe:helper_init_batch()
             pipe:throw_ready()
             pipe.props.helper = h_pipe
             if cb.sub_mgr then
@@ -633,7 +641,10 @@ local function upipe_helper_alloc(cb)
         end
     end
 
-    if cb.input_output then
+    if cb.input_batch then
+        -- urefs are queued in C and only cross into Lua once per batch
+        mgr.upipe_input = C.upipe_helper_input_batch
+    elseif cb.input_output then
         mgr.upipe_input = function (pipe, ref, pump_p)
             if not C.upipe_helper_check_input(pipe) then
                 C.upipe_helper_hold_input(pipe, ref)
@@ -763,6 +774,7 @@ local function upipe_helper_alloc(cb)
         end
         pipe:throw_dead()
         props[k] = nil
+        pipe:helper_clean_batch()
         pipe:helper_clean_upump()
         pipe:helper_clean_flow_def()
         pipe:helper_clean_uref_stream()
@@ -787,9 +799,12 @@ local function upipe_helper_alloc(cb)
         local mgr = h_mgr.mgr
         mgr.upipe_alloc:free()
         mgr.upipe_control:free()
-        if mgr.upipe_input ~= nil then
+        if mgr.upipe_input ~= nil and not cb.input_batch then
             mgr.upipe_input:free()
         end
+        if cb.input_batch then
+            h_mgr.input_batch:free()
+        end
         h_mgr.refcount_cb:free()
         refcount_cb:free()
         C.free(ffi.cast("void *", h_mgr))
@@ -826,7 +841,9 @@ return setmetatable({
     sigs = sigs,
     mgr = alloc("upipe_mgr"),
     iterator = iterator,
-    default_probe = default_probe
+    default_probe = default_probe,
+    -- interns an attribute name, so that lookups compare keys by ID
+    attr_key = function (name) return C.udict_key_intern(name) end
 }, {
     __index = mgr_mt.__index,
     __call = function (_, cb)
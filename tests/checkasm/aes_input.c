@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "upipe/ucpu.h"
+#include "lib/upipe-modules/upipe_aes_cbc.h"
+
+/* 64 TS packets */
+#define NUM_BLOCKS 752
+
+/* NIST SP 800-38A F.2.1, CBC-AES128, first block */
+static const uint8_t kat_key[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+static const uint8_t kat_iv[16] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+static const uint8_t kat_cipher[16] = {
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d
+};
+static const uint8_t kat_plain[16] = {
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a
+};
+
+static void randomize_buffers(uint8_t *src0, uint8_t *src1, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        uint8_t byte = rnd();
+        src0[i] = byte;
+        src1[i] = byte;
+    }
+}
+
+void checkasm_check_aes_input(void)
+{
+    struct {
+        void (*decrypt)(uint8_t round_keys[11][4][4], uint8_t iv[16],
+                        uint8_t *buf, uintptr_t len);
+    } s = {
+        .decrypt = upipe_aes_cbc_decrypt_c,
+    };
+    uint32_t cpu_flags = checkasm_get_ucpu_flags();
+
+    s.decrypt = (__typeof__(s.decrypt))
+        ucpu_kernel_find(&upipe_aes_cbc_decrypt_kernel, cpu_flags)->func;
+
+    if (check_func(s.decrypt, "aes_cbc_decrypt")) {
+        uint8_t round_keys[11][4][4];
+        uint8_t iv0[16], iv1[16];
+        uint8_t src0[NUM_BLOCKS * 16];
+        uint8_t src1[NUM_BLOCKS * 16];
+        declare_func(void, uint8_t round_keys[11][4][4], uint8_t iv[16],
+                     uint8_t *buf, uintptr_t len);
+
+        /* known answer */
+        upipe_aes_key_expansion(kat_key, round_keys);
+        memcpy(iv1, kat_iv, sizeof (iv1));
+        memcpy(src1, kat_cipher, sizeof (kat_cipher));
+        call_new(round_keys, iv1, src1, sizeof (kat_cipher));
+        if (memcmp(src1, kat_plain, sizeof (kat_plain)) ||
+            memcmp(iv1, kat_cipher, sizeof (kat_cipher)))
+            fail();
+
+        randomize_buffers((uint8_t *)round_keys, (uint8_t *)round_keys,
+                          sizeof (round_keys));
+        randomize_buffers(iv0, iv1, sizeof (iv0));
+        randomize_buffers(src0, src1, sizeof (src0));
+        /* cover every tail length and misalignment, chaining the calls */
+        for (uintptr_t blocks = 0; blocks <= 16; blocks++) {
+            call_ref(round_keys, iv0, src0 + blocks, blocks * 16);
+            call_new(round_keys, iv1, src1 + blocks, blocks * 16);
+            if (memcmp(src0, src1, sizeof (src0)) ||
+                memcmp(iv0, iv1, sizeof (iv0)))
+                fail();
+        }
+        call_ref(round_keys, iv0, src0, sizeof (src0));
+        call_new(round_keys, iv1, src1, sizeof (src1));
+        if (memcmp(src0, src1, sizeof (src0)) ||
+            memcmp(iv0, iv1, sizeof (iv0)))
+            fail();
+        checkasm_set_bench_units(sizeof (src1), "byte");
+        bench_new(round_keys, iv1, src1, sizeof (src1));
+    }
+    report("aes_cbc_decrypt");
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "upipe/ucpu.h"
+#include "upipe/ubuf_pic_blend.h"
+
+/* one line of 1920 4:2:2 samples, with some room for misalignment */
+#define WIDTH 1920
+#define BUF_SIZE (2 * WIDTH + 64)
+
+static void randomize_buffers(uint8_t *buf0, uint8_t *buf1)
+{
+    for (int i = 0; i < BUF_SIZE; i++) {
+        uint8_t byte = rnd();
+        buf0[i] = byte;
+        buf1[i] = byte;
+    }
+}
+
+static void randomize_alpha(uint8_t *alpha)
+{
+    /* make sure fully opaque and transparent pixels are covered */
+    for (int i = 0; i < BUF_SIZE; i++) {
+        uint32_t r = rnd();
+        alpha[i] = (r & 3) == 0 ? 0 : (r & 3) == 1 ? 0xff : r >> 8;
+    }
+}
+
+void checkasm_check_blend_input(void)
+{
+    struct {
+        void (*blend_alpha_8)(uint8_t *, const uint8_t *, const uint8_t *,
+                              uintptr_t, uint8_t, uintptr_t);
+        void (*key_alpha_8)(uint8_t *, const uint8_t *, const uint8_t *,
+                            uintptr_t, uint8_t, uint8_t, uintptr_t);
+        void (*average_8)(uint8_t *, const uint8_t *, const uint8_t *,
+                          uintptr_t);
+        void (*blend_alpha_16)(uint16_t *, const uint16_t *, const uint8_t *,
+                               uintptr_t, uint8_t, uintptr_t);
+        void (*average_16)(uint16_t *, const uint16_t *, const uint16_t *,
+                           uintptr_t);
+    } s = {
+        .blend_alpha_8 = ubuf_pic_blend_alpha_8_c,
+        .key_alpha_8 = ubuf_pic_key_alpha_8_c,
+        .average_8 = ubuf_pic_average_8_c,
+        .blend_alpha_16 = ubuf_pic_blend_alpha_16_c,
+        .average_16 = ubuf_pic_average_16_c,
+    };
+    uint32_t cpu_flags = checkasm_get_ucpu_flags();
+
+#define FIND(name)                                                          \
+    s.name = (__typeof__(s.name))                                           \
+        ucpu_kernel_find(&ubuf_pic_##name##_kernel, cpu_flags)->func
+    FIND(blend_alpha_8);
+    FIND(key_alpha_8);
+    FIND(average_8);
+    FIND(blend_alpha_16);
+    FIND(average_16);
+#undef FIND
+
+    uint8_t dst0[BUF_SIZE], dst1[BUF_SIZE];
+    uint8_t src[BUF_SIZE], src2[BUF_SIZE], alpha_plane[2 * BUF_SIZE];
+    uint16_t wdst0[BUF_SIZE / 2], wdst1[BUF_SIZE / 2];
+    uint16_t wsrc[BUF_SIZE / 2], wsrc2[BUF_SIZE / 2];
+
+    randomize_buffers(src, dst0);
+    randomize_buffers(src2, dst0);
+    randomize_buffers((uint8_t *)wsrc, dst0);
+    randomize_buffers((uint8_t *)wsrc2, dst0);
+    randomize_alpha(alpha_plane);
+    randomize_alpha(alpha_plane + BUF_SIZE);
+
+    if (check_func(s.blend_alpha_8, "blend_alpha_8")) {
+        declare_func(void, uint8_t *dst, const uint8_t *src,
+                     const uint8_t *alpha_plane, uintptr_t hsub,
+                     uint8_t alpha, uintptr_t len);
+
+        for (uintptr_t hsub = 1; hsub <= 2; hsub++) {
+            /* cover every tail length and misalignment */
+            for (uintptr_t len = 0; len <= 128; len++) {
+                uint8_t alpha = len & 1 ? 0xff : rnd();
+                randomize_buffers(dst0, dst1);
+                call_ref(dst0 + (len & 15), src, alpha_plane + (len & 7),
+                         hsub, alpha, len);
+                call_new(dst1 + (len & 15), src, alpha_plane + (len & 7),
+                         hsub, alpha, len);
+                if (memcmp(dst0, dst1, sizeof dst0))
+                    fail();
+            }
+        }
+        checkasm_set_bench_units(WIDTH / 2, "pixel");
+        bench_new(dst1, src, alpha_plane, 2, 0x80, WIDTH / 2);
+    }
+    report("blend_alpha_8");
+
+    if (check_func(s.key_alpha_8, "key_alpha_8")) {
+        declare_func(void, uint8_t *dst, const uint8_t *src,
+                     const uint8_t *alpha_plane, uintptr_t hsub,
+                     uint8_t alpha, uint8_t threshold, uintptr_t len);
+
+        for (uintptr_t hsub = 1; hsub <= 2; hsub++) {
+            for (uintptr_t len = 0; len <= 128; len++) {
+                uint8_t alpha = len & 1 ? 0xff : rnd();
+                uint8_t threshold = len & 2 ? 0 : rnd();
+                randomize_buffers(dst0, dst1);
+                call_ref(dst0 + (len & 15), src, alpha_plane + (len & 7),
+                         hsub, alpha, threshold, len);
+                call_new(dst1 + (len & 15), src, alpha_plane + (len & 7),
+                         hsub, alpha, threshold, len);
+                if (memcmp(dst0, dst1, sizeof dst0))
+                    fail();
+            }
+        }
+        checkasm_set_bench_units(WIDTH / 2, "pixel");
+        bench_new(dst1, src, alpha_plane, 2, 0xff, 0x80, WIDTH / 2);
+    }
+    report("key_alpha_8");
+
+    if (check_func(s.average_8, "average_8")) {
+        declare_func(void, uint8_t *dst, const uint8_t *src1,
+                     const uint8_t *src2, uintptr_t len);
+
+        for (uintptr_t len = 0; len <= 128; len++) {
+            memset(dst0, 0, sizeof dst0);
+            memset(dst1, 0, sizeof dst1);
+            call_ref(dst0 + (len & 15), src, src2 + (len & 7), len);
+            call_new(dst1 + (len & 15), src, src2 + (len & 7), len);
+            if (memcmp(dst0, dst1, sizeof dst0))
+                fail();
+        }
+        checkasm_set_bench_units(2 * WIDTH, "byte");
+        bench_new(dst1, src, src2, 2 * WIDTH);
+    }
+    report("average_8");
+
+    if (check_func(s.blend_alpha_16, "blend_alpha_16")) {
+        declare_func(void, uint16_t *dst, const uint16_t *src,
+                     const uint8_t *alpha_plane, uintptr_t hsub,
+                     uint8_t alpha, uintptr_t len);
+
+        for (uintptr_t hsub = 1; hsub <= 2; hsub++) {
+            for (uintptr_t len = 0; len <= 64; len++) {
+                uint8_t alpha = len & 1 ? 0xff : rnd();
+                randomize_buffers((uint8_t *)wdst0, (uint8_t *)wdst1);
+                call_ref(wdst0 + (len & 7), wsrc, alpha_plane + (len & 7),
+                         hsub, alpha, len);
+                call_new(wdst1 + (len & 7), wsrc, alpha_plane + (len & 7),
+                         hsub, alpha, len);
+                if (memcmp(wdst0, wdst1, sizeof wdst0))
+                    fail();
+            }
+        }
+        checkasm_set_bench_units(WIDTH / 2, "pixel");
+        bench_new(wdst1, wsrc, alpha_plane, 2, 0x80, WIDTH / 2);
+    }
+    report("blend_alpha_16");
+
+    if (check_func(s.average_16, "average_16")) {
+        declare_func(void, uint16_t *dst, const uint16_t *src1,
+                     const uint16_t *src2, uintptr_t len);
+
+        for (uintptr_t len = 0; len <= 64; len++) {
+            memset(wdst0, 0, sizeof wdst0);
+            memset(wdst1, 0, sizeof wdst1);
+            call_ref(wdst0 + (len & 7), wsrc, wsrc2 + (len & 3), len);
+            call_new(wdst1 + (len & 7), wsrc, wsrc2 + (len & 3), len);
+            if (memcmp(wdst0, wdst1, sizeof wdst0))
+                fail();
+        }
+        checkasm_set_bench_units(WIDTH, "sample");
+        bench_new(wdst1, wsrc, wsrc2, WIDTH);
+    }
+    report("average_16");
+}
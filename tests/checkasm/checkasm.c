@@ -40,6 +40,7 @@
 #include <libavutil/random_seed.h>
 
 #include "upipe/ubase.h"
+#include "upipe/ucpu.h"
 
 #if HAVE_IO_H
 #include <io.h>
@@ -75,9 +76,16 @@ static const struct {
     const char *name;
     void (*func)(void);
 } tests[] = {
+    { "aes_input", checkasm_check_aes_input },
+    { "blend_input", checkasm_check_blend_input },
+    { "crc32_input", checkasm_check_crc32_input },
+    { "fec_xor_input", checkasm_check_fec_xor_input },
+    { "htons_input", checkasm_check_htons_input },
+    { "pack10bit_input", checkasm_check_pack10bit_input },
     { "planar10_input", checkasm_check_planar10_input },
     { "planar8_input", checkasm_check_planar8_input },
     { "sdi_input", checkasm_check_sdi_input },
+    { "sound_input", checkasm_check_sound_input },
     { "uyvy_input", checkasm_check_uyvy_input },
     { "v210_input", checkasm_check_v210_input },
     { NULL, NULL }
@@ -142,10 +150,19 @@ typedef struct CheckasmFuncVersion {
 typedef struct CheckasmFunc {
     struct CheckasmFunc *child[2];
     CheckasmFuncVersion versions;
+    unsigned bench_units; /* work done by one call, 0 if unknown */
+    const char *bench_unit;
     uint8_t color; /* 0 = red, 1 = black */
     char name[1];
 } CheckasmFunc;
 
+/* Benchmark result loaded from a --baseline file */
+typedef struct CheckasmBaseline {
+    char name[256];
+    char cpu[16];
+    double cycles;
+} CheckasmBaseline;
+
 /* Internal state */
 static struct {
     CheckasmFunc *funcs;
@@ -160,6 +177,12 @@ static struct {
     /* perf */
     int nop_time;
     int sysfd;
+    const char *json_path;
+    FILE *json;
+    CheckasmBaseline *baseline;
+    int num_baseline;
+    int regression_pct;
+    int num_regressed;
 
     int cpu_flag;
     const char *cpu_flag_name;
@@ -376,6 +399,46 @@ static int measure_nop_time(void)
     return nop_sum / 500;
 }
 
+/* Find the cycles of a function in the baseline, or a negative value */
+static double baseline_cycles(const char *name, const char *cpu)
+{
+    for (int i = 0; i < state.num_baseline; i++)
+        if (!strcmp(state.baseline[i].name, name) &&
+            !strcmp(state.baseline[i].cpu, cpu))
+            return state.baseline[i].cycles;
+    return -1.;
+}
+
+/* Load a file written by --json, one result per line */
+static int load_baseline(const char *path)
+{
+    char line[512];
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "checkasm: couldn't open baseline %s\n", path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file)) {
+        CheckasmBaseline b;
+        if (sscanf(line, " { \"name\": \"%255[^\"]\", \"cpu\": \"%15[^\"]\", "
+                   "\"cycles\": %lf", b.name, b.cpu, &b.cycles) != 3)
+            continue;
+
+        CheckasmBaseline *baseline = realloc(state.baseline,
+                (state.num_baseline + 1) * sizeof(CheckasmBaseline));
+        if (!baseline) {
+            fclose(file);
+            return -1;
+        }
+        state.baseline = baseline;
+        state.baseline[state.num_baseline++] = b;
+    }
+
+    fclose(file);
+    return 0;
+}
+
 /* Print benchmark results */
 static void print_benchs(CheckasmFunc *f)
 {
@@ -388,8 +451,33 @@ static void print_benchs(CheckasmFunc *f)
             do {
                 CheckasmPerf *p = &v->perf;
                 if (p->iterations) {
+                    const char *cpu = cpu_suffix(v->cpu);
                     int decicycles = (10*p->cycles/p->iterations - state.nop_time) / 4;
-                    printf("%s_%s: %d.%d\n", f->name, cpu_suffix(v->cpu), decicycles/10, decicycles%10);
+                    double cycles = decicycles / 10.;
+                    printf("%s_%s: %d.%d", f->name, cpu, decicycles/10, decicycles%10);
+                    if (f->bench_units)
+                        printf(" (%.3f/%s)", cycles / f->bench_units, f->bench_unit);
+
+                    double base = baseline_cycles(f->name, cpu);
+                    if (base > 0.) {
+                        int pct = (int)(100. * (cycles - base) / base);
+                        if (pct > state.regression_pct) {
+                            color_printf(COLOR_RED, " REGRESSED +%d%%", pct);
+                            state.num_regressed++;
+                        } else
+                            printf(" %+d%%", pct);
+                    }
+                    printf("\n");
+
+                    if (state.json) {
+                        fprintf(state.json, "%s{ \"name\": \"%s\", \"cpu\": \"%s\", "
+                                "\"cycles\": %.1f, \"units\": %u, \"unit\": \"%s\", "
+                                "\"cycles_per_unit\": %.4f }",
+                                ftell(state.json) > 2 ? ",\n" : "",
+                                f->name, cpu, cycles, f->bench_units,
+                                f->bench_unit ? f->bench_unit : "",
+                                f->bench_units ? cycles / f->bench_units : 0.);
+                    }
                 }
             } while ((v = v->next));
         }
@@ -563,6 +651,8 @@ int main(int argc, char *argv[])
     unsigned int seed = av_get_random_seed();
     int i, ret = 0;
 
+    state.regression_pct = 10;
+
 #if ARCH_ARM && HAVE_ARMV5TE_EXTERNAL
     if (have_vfp(av_get_cpu_flags()) || have_neon(av_get_cpu_flags()))
         checkasm_checked_call = checkasm_checked_call_vfp;
@@ -587,6 +677,13 @@ int main(int argc, char *argv[])
                 state.bench_pattern_len = strlen(state.bench_pattern);
             } else
                 state.bench_pattern = "";
+        } else if (!strncmp(argv[1], "--json=", 7)) {
+            state.json_path = argv[1] + 7;
+        } else if (!strncmp(argv[1], "--baseline=", 11)) {
+            if (load_baseline(argv[1] + 11) < 0)
+                return 1;
+        } else if (!strncmp(argv[1], "--regression=", 13)) {
+            state.regression_pct = atoi(argv[1] + 13);
         } else if (!strncmp(argv[1], "--test=", 7)) {
             state.test_name = argv[1] + 7;
         } else if (!strcmp(argv[1], "--verbose") || !strcmp(argv[1], "-v")) {
@@ -612,11 +709,28 @@ int main(int argc, char *argv[])
     } else {
         fprintf(stderr, "checkasm: all %d tests passed\n", state.num_checked);
         if (state.bench_pattern) {
+            if (state.json_path &&
+                !(state.json = fopen(state.json_path, "w")))
+                fprintf(stderr, "checkasm: couldn't open %s\n", state.json_path);
+            if (state.json)
+                fprintf(state.json, "[\n");
+
             print_benchs(state.funcs);
+
+            if (state.json) {
+                fprintf(state.json, "\n]\n");
+                fclose(state.json);
+            }
+            if (state.num_regressed) {
+                fprintf(stderr, "checkasm: %d benchmarks regressed by more than %d%%\n",
+                        state.num_regressed, state.regression_pct);
+                ret = 1;
+            }
         }
     }
 
     destroy_func_tree(state.funcs);
+    free(state.baseline);
     bench_uninit();
     return ret;
 }
@@ -670,6 +784,46 @@ void *checkasm_check_func(void *func, const char *name, ...)
     return ref;
 }
 
+/* Translate the CPU flags being tested to upipe/ucpu.h flags, so that kernels
+ * can be looked up in their implementation tables */
+uint32_t checkasm_get_ucpu_flags(void)
+{
+    int cpu_flags = av_get_cpu_flags();
+    uint32_t flags = 0;
+
+#if ARCH_X86
+    if (cpu_flags & AV_CPU_FLAG_SSE2)
+        flags |= UCPU_SSE2;
+    if (cpu_flags & AV_CPU_FLAG_SSSE3) {
+        flags |= UCPU_SSSE3;
+        /* not tracked by libavutil */
+        if (__builtin_cpu_supports("pclmul"))
+            flags |= UCPU_PCLMUL;
+    }
+    if (cpu_flags & AV_CPU_FLAG_AVX)
+        flags |= UCPU_AVX;
+    if (cpu_flags & AV_CPU_FLAG_AVX2)
+        flags |= UCPU_AVX2;
+#ifdef AV_CPU_FLAG_AVX512
+    if (cpu_flags & AV_CPU_FLAG_AVX512)
+        flags |= UCPU_AVX512;
+#endif
+#ifdef AV_CPU_FLAG_AESNI
+    if (cpu_flags & AV_CPU_FLAG_AESNI)
+        flags |= UCPU_AES;
+#endif
+#endif
+#if ARCH_AARCH64
+    if (cpu_flags & AV_CPU_FLAG_NEON) {
+        flags |= UCPU_NEON;
+        /* not tracked by libavutil */
+        flags |= ucpu_get_flags() & UCPU_AES;
+    }
+#endif
+
+    return flags;
+}
+
 /* Decide whether or not the current function needs to be benchmarked */
 int checkasm_bench_func(void)
 {
@@ -704,6 +858,14 @@ CheckasmPerf *checkasm_get_perf_context(void)
     return perf;
 }
 
+/* Record the amount of work done by one call of the function being
+ * benchmarked, to report cycles per unit */
+void checkasm_set_bench_units(unsigned units, const char *unit)
+{
+    state.current_func->bench_units = units;
+    state.current_func->bench_unit = unit;
+}
+
 /* Print the outcome of all tests performed since the last time this function was called */
 void checkasm_report(const char *name, ...)
 {
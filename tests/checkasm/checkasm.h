@@ -73,9 +73,16 @@
 #define HAVE_RDTSC 0
 #include "timer.h"
 
+void checkasm_check_aes_input(void);
+void checkasm_check_blend_input(void);
+void checkasm_check_crc32_input(void);
+void checkasm_check_fec_xor_input(void);
+void checkasm_check_htons_input(void);
+void checkasm_check_pack10bit_input(void);
 void checkasm_check_planar10_input(void);
 void checkasm_check_planar8_input(void);
 void checkasm_check_sdi_input(void);
+void checkasm_check_sound_input(void);
 void checkasm_check_uyvy_input(void);
 void checkasm_check_v210_input(void);
 
@@ -86,6 +93,8 @@ int checkasm_bench_func(void);
 void checkasm_fail_func(const char *msg, ...) av_printf_format(1, 2);
 struct CheckasmPerf *checkasm_get_perf_context(void);
 void checkasm_report(const char *name, ...) av_printf_format(1, 2);
+void checkasm_set_bench_units(unsigned units, const char *unit);
+uint32_t checkasm_get_ucpu_flags(void);
 
 /* float compare utilities */
 int float_near_ulp(float a, float b, unsigned max_ulp);
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "upipe/ucpu.h"
+#ifdef HAVE_BITSTREAM_COMMON_H
+#include "lib/upipe-ts/upipe_ts_crc32.h"
+#endif
+
+/* maximum size of a private section */
+#define NUM_SAMPLES 4096
+
+static void randomize_buffers(uint8_t *src0, uint8_t *src1)
+{
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        uint8_t byte = rnd();
+        src0[i] = byte;
+        src1[i] = byte;
+    }
+}
+
+void checkasm_check_crc32_input(void)
+{
+    struct {
+        uint32_t (*crc32)(uint32_t crc, const uint8_t *buf, uintptr_t len);
+    } s = {
+#ifdef HAVE_BITSTREAM_COMMON_H
+        .crc32 = upipe_ts_crc32_c,
+#endif
+    };
+
+#ifdef HAVE_BITSTREAM_COMMON_H
+    s.crc32 = (__typeof__(s.crc32))
+        ucpu_kernel_find(&upipe_ts_crc32_kernel,
+                         checkasm_get_ucpu_flags())->func;
+#endif
+
+    if (check_func(s.crc32, "crc32_mpeg2")) {
+        uint8_t src0[NUM_SAMPLES];
+        uint8_t src1[NUM_SAMPLES];
+        declare_func(uint32_t, uint32_t crc, const uint8_t *buf, uintptr_t len);
+
+        randomize_buffers(src0, src1);
+        /* cover every tail length, then the largest section */
+        for (uintptr_t len = 0; len <= 256; len++) {
+            uint32_t crc = rnd();
+            if (call_ref(crc, src0 + (len & 15), len) !=
+                call_new(crc, src1 + (len & 15), len))
+                fail();
+        }
+        if (call_ref(0xffffffff, src0, NUM_SAMPLES) !=
+            call_new(0xffffffff, src1, NUM_SAMPLES))
+            fail();
+        if (memcmp(src0, src1, sizeof src0))
+            fail();
+        checkasm_set_bench_units(NUM_SAMPLES, "byte");
+        bench_new(0xffffffff, src1, NUM_SAMPLES);
+    }
+    report("crc32_mpeg2");
+}
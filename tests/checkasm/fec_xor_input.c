@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "upipe/ucpu.h"
+#ifdef HAVE_BITSTREAM_COMMON_H
+#include "lib/upipe-ts/upipe_rtp_fec_xor.h"
+#endif
+
+/* payload of an RTP packet carrying 7 TS packets */
+#define NUM_SAMPLES 1316
+/* largest FEC row or column checked */
+#define NUM_SOURCES 20
+
+static void randomize_buffers(uint8_t *dst0, uint8_t *dst1,
+                              uint8_t src[][NUM_SAMPLES + 16])
+{
+    for (int i = 0; i < NUM_SAMPLES + 16; i++) {
+        uint8_t byte = rnd();
+        dst0[i] = byte;
+        dst1[i] = byte;
+        for (int k = 0; k < NUM_SOURCES; k++)
+            src[k][i] = rnd();
+    }
+}
+
+void checkasm_check_fec_xor_input(void)
+{
+    struct {
+        void (*xor)(uint8_t *dst, const uint8_t *const *srcs,
+                    unsigned int nb_srcs, uintptr_t len);
+    } s = {
+#ifdef HAVE_BITSTREAM_COMMON_H
+        .xor = upipe_rtp_fec_xor_c,
+#endif
+    };
+
+#ifdef HAVE_BITSTREAM_COMMON_H
+    s.xor = (__typeof__(s.xor))
+        ucpu_kernel_find(&upipe_rtp_fec_xor_kernel,
+                         checkasm_get_ucpu_flags())->func;
+#endif
+
+    if (check_func(s.xor, "rtp_fec_xor")) {
+        uint8_t dst0[NUM_SAMPLES + 16];
+        uint8_t dst1[NUM_SAMPLES + 16];
+        uint8_t src[NUM_SOURCES][NUM_SAMPLES + 16];
+        const uint8_t *srcs[NUM_SOURCES];
+        declare_func(void, uint8_t *dst, const uint8_t *const *srcs,
+                     unsigned int nb_srcs, uintptr_t len);
+
+        randomize_buffers(dst0, dst1, src);
+        /* cover every tail length and misalignment */
+        for (uintptr_t len = 0; len <= 160; len++) {
+            unsigned int nb_srcs = 1 + len % NUM_SOURCES;
+            for (unsigned int k = 0; k < nb_srcs; k++)
+                srcs[k] = src[k] + ((len + k) & 15);
+            call_ref(dst0 + (len & 15), srcs, nb_srcs, len);
+            call_new(dst1 + (len & 15), srcs, nb_srcs, len);
+            if (memcmp(dst0, dst1, sizeof dst0))
+                fail();
+        }
+        for (unsigned int k = 0; k < NUM_SOURCES; k++)
+            srcs[k] = src[k];
+        call_ref(dst0, srcs, NUM_SOURCES, NUM_SAMPLES);
+        call_new(dst1, srcs, NUM_SOURCES, NUM_SAMPLES);
+        if (memcmp(dst0, dst1, sizeof dst0))
+            fail();
+        checkasm_set_bench_units(NUM_SAMPLES * NUM_SOURCES, "byte");
+        bench_new(dst1, srcs, NUM_SOURCES, NUM_SAMPLES);
+    }
+    report("rtp_fec_xor");
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "upipe/ucpu.h"
+#include "lib/upipe-modules/upipe_htons_swap.h"
+
+/* 10 ms of 16 channels of 48 kHz 16-bit PCM */
+#define NUM_SAMPLES 15360
+
+static void randomize_buffers(uint8_t *src0, uint8_t *src1)
+{
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        uint8_t byte = rnd();
+        src0[i] = byte;
+        src1[i] = byte;
+    }
+}
+
+void checkasm_check_htons_input(void)
+{
+    struct {
+        void (*swap)(uint8_t *buf, uintptr_t len);
+    } s = {
+        .swap = upipe_htons_swap_c,
+    };
+    uint32_t cpu_flags = checkasm_get_ucpu_flags();
+
+    s.swap = (__typeof__(s.swap))
+        ucpu_kernel_find(&upipe_htons_swap_kernel, cpu_flags)->func;
+
+    if (check_func(s.swap, "htons_swap")) {
+        uint8_t src0[NUM_SAMPLES];
+        uint8_t src1[NUM_SAMPLES];
+        declare_func(void, uint8_t *buf, uintptr_t len);
+
+        randomize_buffers(src0, src1);
+        /* cover every tail length and misalignment */
+        for (uintptr_t len = 0; len <= 256; len++) {
+            call_ref(src0 + (len & 15), len);
+            call_new(src1 + (len & 15), len);
+            if (memcmp(src0, src1, sizeof src0))
+                fail();
+        }
+        call_ref(src0, NUM_SAMPLES);
+        call_new(src1, NUM_SAMPLES);
+        if (memcmp(src0, src1, sizeof src0))
+            fail();
+        checkasm_set_bench_units(NUM_SAMPLES, "byte");
+        bench_new(src1, NUM_SAMPLES);
+    }
+    report("htons_swap");
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "lib/upipe-hbrmt/sdidec.h"
+#include "lib/upipe-hbrmt/sdienc.h"
+
+/* largest line tested, in pixels */
+#define MAX_PIXELS 256
+/* the SIMD kernels may write past the end of the line */
+#define PADDING 64
+
+static void randomize_samples(uint16_t *src, int samples)
+{
+    for (int i = 0; i < samples; i++)
+        src[i] = rnd() & 0x3ff;
+}
+
+/* Unlike sdi_input and uyvy_input, this covers the block sizes seen by
+ * upipe_pack10bit and upipe_unpack10bit, which are not a multiple of the
+ * vector size, and checks that unpacking reverses packing. */
+void checkasm_check_pack10bit_input(void)
+{
+    struct {
+        void (*pack)(uint8_t *dst, const uint8_t *y, uintptr_t pixels);
+        void (*unpack)(const uint8_t *src, uint16_t *y, uintptr_t pixels);
+    } s = {
+#ifdef HAVE_BITSTREAM_COMMON_H
+        .pack = upipe_uyvy_to_sdi_c,
+        .unpack = upipe_sdi_to_uyvy_c,
+#endif
+    };
+
+#ifdef HAVE_X86ASM
+#ifdef HAVE_BITSTREAM_COMMON_H
+    int cpu_flags = av_get_cpu_flags();
+
+    if (cpu_flags & AV_CPU_FLAG_AVX2) {
+        s.pack = upipe_uyvy_to_sdi_avx2;
+        s.unpack = upipe_sdi_to_uyvy_avx2;
+    }
+#ifdef AV_CPU_FLAG_AVX512
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.pack = upipe_uyvy_to_sdi_avx512;
+        s.unpack = upipe_sdi_to_uyvy_avx512;
+    }
+#endif
+#endif
+#endif
+
+#if ARCH_AARCH64
+#ifdef HAVE_BITSTREAM_COMMON_H
+    if (av_get_cpu_flags() & AV_CPU_FLAG_NEON) {
+        s.pack = upipe_uyvy_to_sdi_neon;
+        s.unpack = upipe_sdi_to_uyvy_neon;
+    }
+#endif
+#endif
+
+    uint16_t samples[2 * MAX_PIXELS];
+    uint8_t packed0[MAX_PIXELS * 5 / 2 + PADDING];
+    uint8_t packed1[MAX_PIXELS * 5 / 2 + PADDING];
+    uint16_t unpacked0[2 * MAX_PIXELS + PADDING];
+    uint16_t unpacked1[2 * MAX_PIXELS + PADDING];
+
+    randomize_samples(samples, 2 * MAX_PIXELS);
+
+    if (check_func(s.pack, "pack10bit")) {
+        declare_func(void, uint8_t *dst, const uint8_t *y, uintptr_t pixels);
+
+        /* the kernels handle pairs of pixels (5 octets) */
+        for (uintptr_t pixels = 2; pixels <= MAX_PIXELS; pixels += 2) {
+            call_ref(packed0, (const uint8_t *)samples, pixels);
+            call_new(packed1, (const uint8_t *)samples, pixels);
+            if (memcmp(packed0, packed1, pixels * 5 / 2))
+                fail();
+        }
+        checkasm_set_bench_units(MAX_PIXELS, "pixel");
+        bench_new(packed1, (const uint8_t *)samples, MAX_PIXELS);
+    }
+    report("pack10bit");
+
+    if (check_func(s.unpack, "unpack10bit")) {
+        declare_func(void, const uint8_t *src, uint16_t *y, uintptr_t pixels);
+
+        upipe_uyvy_to_sdi_c(packed0, (const uint8_t *)samples, MAX_PIXELS);
+        for (uintptr_t pixels = 2; pixels <= MAX_PIXELS; pixels += 2) {
+            call_ref(packed0, unpacked0, pixels);
+            call_new(packed0, unpacked1, pixels);
+            if (memcmp(unpacked0, unpacked1, pixels * 2 * sizeof(uint16_t)) ||
+                memcmp(unpacked1, samples, pixels * 2 * sizeof(uint16_t)))
+                fail();
+        }
+        checkasm_set_bench_units(MAX_PIXELS, "pixel");
+        bench_new(packed0, unpacked1, MAX_PIXELS);
+    }
+    report("unpack10bit");
+}
@@ -49,6 +49,17 @@ void checkasm_check_planar10_input(void)
     if (cpu_flags & AV_CPU_FLAG_AVX2) {
        s.v210  = upipe_planar_to_v210_10_avx2;
     }
+#ifdef AV_CPU_FLAG_AVX512
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+       s.v210  = upipe_planar_to_v210_10_avx512;
+    }
+#endif
+#endif
+
+#if ARCH_AARCH64
+    if (av_get_cpu_flags() & AV_CPU_FLAG_NEON) {
+       s.v210  = upipe_planar_to_v210_10_neon;
+    }
 #endif
 
     if (check_func(s.v210, "planar_to_v210_10")) {
@@ -74,6 +85,7 @@ void checkasm_check_planar10_input(void)
                 || memcmp(u0, u1, sizeof u0)
                 || memcmp(v0, v1, sizeof v0))
             fail();
+        checkasm_set_bench_units(pixels, "pixel");
         bench_new(y1, u1, v1, dst1, pixels);
     }
     report("planar_to_v210_10");
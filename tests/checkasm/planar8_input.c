@@ -79,6 +79,7 @@ void checkasm_check_planar8_input(void)
                 || memcmp(u0, u1, sizeof u0)
                 || memcmp(v0, v1, sizeof v0))
             fail();
+        checkasm_set_bench_units(pixels, "pixel");
         bench_new(y1, u1, v1, dst1, pixels);
     }
     report("planar_to_v210_8");
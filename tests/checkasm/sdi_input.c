@@ -54,6 +54,19 @@ void checkasm_check_sdi_input(void)
     if (cpu_flags & AV_CPU_FLAG_AVX2) {
         s.uyvy = upipe_sdi_to_uyvy_avx2;
     }
+#ifdef AV_CPU_FLAG_AVX512
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.uyvy = upipe_sdi_to_uyvy_avx512;
+    }
+#endif
+#endif
+#endif
+
+#if ARCH_AARCH64
+#ifdef HAVE_BITSTREAM_COMMON_H
+    if (av_get_cpu_flags() & AV_CPU_FLAG_NEON) {
+        s.uyvy = upipe_sdi_to_uyvy_neon;
+    }
 #endif
 #endif
 
@@ -70,6 +83,7 @@ void checkasm_check_sdi_input(void)
         if (memcmp(src0, src1, sizeof src0)
                 || memcmp(dst0, dst1, NUM_SAMPLES * sizeof dst0[0]))
             fail();
+        checkasm_set_bench_units(NUM_SAMPLES / 2, "pixel");
         bench_new(src1, dst1, NUM_SAMPLES / 2);
     }
     report("sdi_to_uyvy");
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+#include <string.h>
+
+#include "checkasm.h"
+#include "upipe/ucpu.h"
+#include "upipe/ubuf_sound_interleave.h"
+
+/* 1 ms of 16 channels of 48 kHz 32-bit PCM, plus a tail */
+#define MAX_CHANNELS 16
+#define SAMPLES 51
+
+void checkasm_check_sound_input(void)
+{
+    struct {
+        void (*deinterleave_16)(uint8_t *const *dst, const uint8_t *src,
+                                uint8_t channels, uintptr_t samples);
+        void (*deinterleave_32)(uint8_t *const *dst, const uint8_t *src,
+                                uint8_t channels, uintptr_t samples);
+    } s = {
+        .deinterleave_16 = ubuf_sound_deinterleave_16_c,
+        .deinterleave_32 = ubuf_sound_deinterleave_32_c,
+    };
+    uint32_t cpu_flags = checkasm_get_ucpu_flags();
+
+    s.deinterleave_16 = (__typeof__(s.deinterleave_16))
+        ucpu_kernel_find(&ubuf_sound_deinterleave_16_kernel, cpu_flags)->func;
+    s.deinterleave_32 = (__typeof__(s.deinterleave_32))
+        ucpu_kernel_find(&ubuf_sound_deinterleave_32_kernel, cpu_flags)->func;
+
+    uint8_t src[MAX_CHANNELS * SAMPLES * 4];
+    uint8_t planes0[MAX_CHANNELS][SAMPLES * 4];
+    uint8_t planes1[MAX_CHANNELS][SAMPLES * 4];
+    uint8_t *dst0[MAX_CHANNELS], *dst1[MAX_CHANNELS];
+
+    for (unsigned i = 0; i < sizeof src; i++)
+        src[i] = rnd();
+
+    for (int size = 2; size <= 4; size += 2) {
+        const char *name = size == 2 ? "deinterleave_16" : "deinterleave_32";
+        if (check_func(size == 2 ? s.deinterleave_16 : s.deinterleave_32,
+                       "%s", name)) {
+            declare_func(void, uint8_t *const *dst, const uint8_t *src,
+                         uint8_t channels, uintptr_t samples);
+
+            for (int channels = 1; channels <= MAX_CHANNELS; channels++) {
+                /* skip one channel out of three */
+                for (int c = 0; c < channels; c++) {
+                    int skip = c % 3 == 2;
+                    dst0[c] = skip ? NULL : planes0[c];
+                    dst1[c] = skip ? NULL : planes1[c];
+                }
+                memset(planes0, 0, sizeof planes0);
+                memset(planes1, 0, sizeof planes1);
+                call_ref(dst0, src, channels, SAMPLES);
+                call_new(dst1, src, channels, SAMPLES);
+                if (memcmp(planes0, planes1, sizeof planes0))
+                    fail();
+            }
+            for (int c = 0; c < MAX_CHANNELS; c++)
+                dst1[c] = planes1[c];
+            checkasm_set_bench_units(MAX_CHANNELS * SAMPLES, "sample");
+            bench_new(dst1, src, MAX_CHANNELS, SAMPLES);
+        }
+        report("%s", name);
+    }
+}
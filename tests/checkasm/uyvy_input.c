@@ -58,6 +58,19 @@ void checkasm_check_uyvy_input(void)
     if (cpu_flags & AV_CPU_FLAG_AVX2) {
         s.sdi = upipe_uyvy_to_sdi_avx2;
     }
+#ifdef AV_CPU_FLAG_AVX512
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.sdi = upipe_uyvy_to_sdi_avx512;
+    }
+#endif
+#endif
+#endif
+
+#if ARCH_AARCH64
+#ifdef HAVE_BITSTREAM_COMMON_H
+    if (av_get_cpu_flags() & AV_CPU_FLAG_NEON) {
+        s.sdi = upipe_uyvy_to_sdi_neon;
+    }
 #endif
 #endif
 
@@ -74,6 +87,7 @@ void checkasm_check_uyvy_input(void)
         if (memcmp(src0, src1, sizeof src0)
                 || memcmp(dst0, dst1, NUM_SAMPLES * 10 / 8))
             fail();
+        checkasm_set_bench_units(NUM_SAMPLES / 2, "pixel");
         bench_new(dst1, (const uint8_t*)src1, NUM_SAMPLES / 2);
     }
     report("uyvy_to_sdi");
@@ -71,6 +71,17 @@ void checkasm_check_v210_input(void)
         s.planar_10 = upipe_v210_to_planar_10_avx2;
         s.planar_8  = upipe_v210_to_planar_8_avx2;
     }
+#ifdef AV_CPU_FLAG_AVX512
+    if (cpu_flags & AV_CPU_FLAG_AVX512) {
+        s.planar_10 = upipe_v210_to_planar_10_avx512;
+    }
+#endif
+#endif
+
+#if ARCH_AARCH64
+    if (av_get_cpu_flags() & AV_CPU_FLAG_NEON) {
+        s.planar_10 = upipe_v210_to_planar_10_neon;
+    }
 #endif
 
     if (check_func(s.planar_8, "v210_to_planar8")) {
@@ -93,6 +104,7 @@ void checkasm_check_v210_input(void)
                 || memcmp(u0, u1, pixels/2)
                 || memcmp(v0, v1, pixels/2))
             fail();
+        checkasm_set_bench_units(pixels, "pixel");
         bench_new(src1, y1, u1, v1, pixels);
     }
     report("v210_to_planar8");
@@ -117,6 +129,7 @@ void checkasm_check_v210_input(void)
                 || memcmp(u0, u1, pixels/2 * sizeof u0[0])
                 || memcmp(v0, v1, pixels/2 * sizeof v0[0]))
             fail();
+        checkasm_set_bench_units(pixels, "pixel");
         bench_new(src1, y1, u1, v1, pixels);
     }
     report("v210_to_planar10");
@@ -46,6 +46,89 @@
 #define UBUF_ALIGN          16
 #define UBUF_ALIGN_OFFSET   0
 #define UBUF_SIZE           188
+#define UBUF_BATCH          40
+
+/** tests blocks allocated in slabs */
+static void test_slab(struct umem_mgr *umem_mgr)
+{
+    struct ubuf_mgr *mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                    UBUF_POOL_DEPTH, umem_mgr,
+                                                    UBUF_PREPEND,
+                                                    UBUF_APPEND,
+                                                    UBUF_ALIGN,
+                                                    UBUF_ALIGN_OFFSET);
+    assert(mgr != NULL);
+    ubase_assert(ubuf_block_mem_mgr_set_slab_size(mgr, UBUF_SIZE));
+
+    struct ubuf *ubuf1 = ubuf_block_alloc(mgr, UBUF_SIZE);
+    assert(ubuf1 != NULL);
+    uint8_t *w;
+    int wsize = -1;
+    ubase_assert(ubuf_block_write(ubuf1, 0, &wsize, &w));
+    assert(wsize == UBUF_SIZE);
+    assert(!(((uintptr_t)w + UBUF_ALIGN_OFFSET) % UBUF_ALIGN));
+    for (int i = 0; i < wsize; i++)
+        w[i] = i;
+    ubase_assert(ubuf_block_unmap(ubuf1, 0));
+
+    /* the slab outlives its ubuf structure */
+    struct ubuf *ubuf2 = ubuf_dup(ubuf1);
+    assert(ubuf2 != NULL);
+    ubase_nassert(ubuf_control(ubuf1, UBUF_SINGLE));
+    wsize = -1;
+    ubase_nassert(ubuf_block_write(ubuf2, 0, &wsize, &w));
+    ubuf_free(ubuf1);
+    ubase_assert(ubuf_control(ubuf2, UBUF_SINGLE));
+    wsize = -1;
+    ubase_assert(ubuf_block_write(ubuf2, 0, &wsize, &w));
+    assert(wsize == UBUF_SIZE);
+    ubase_assert(ubuf_block_unmap(ubuf2, 0));
+    size_t slab_tailroom;
+    ubase_assert(ubuf_block_tailroom(ubuf2, &slab_tailroom));
+    assert(slab_tailroom >= UBUF_APPEND);
+    uint8_t buf[UBUF_SIZE];
+    ubase_assert(ubuf_block_extract(ubuf2, 0, -1, buf));
+    for (int i = 0; i < UBUF_SIZE; i++)
+        assert(buf[i] == i);
+    ubuf_free(ubuf2);
+
+    /* larger blocks use umem */
+    ubuf1 = ubuf_block_alloc(mgr, UBUF_SIZE + 1);
+    assert(ubuf1 != NULL);
+    size_t tailroom;
+    ubase_assert(ubuf_block_tailroom(ubuf1, &tailroom));
+    assert(tailroom >= UBUF_APPEND);
+    ubase_assert(ubuf_block_resize(ubuf1, 0, UBUF_SIZE));
+    ubase_assert(ubuf_block_tailroom(ubuf1, &tailroom));
+    assert(tailroom >= UBUF_APPEND + 1);
+    ubuf_free(ubuf1);
+
+    struct ubuf *ubufs[UBUF_BATCH];
+    assert(ubuf_block_alloc_batch(mgr, UBUF_SIZE, ubufs, UBUF_BATCH) ==
+           UBUF_BATCH);
+    for (int i = 0; i < UBUF_BATCH; i++) {
+        size_t size;
+        ubase_assert(ubuf_block_size(ubufs[i], &size));
+        assert(size == UBUF_SIZE);
+        ubuf_free(ubufs[i]);
+    }
+
+    /* pooled slabs are reallocated when the slab size grows */
+    ubuf1 = ubuf_block_alloc(mgr, 1);
+    assert(ubuf1 != NULL);
+    ubase_assert(ubuf_block_mem_mgr_set_slab_size(mgr, 1316));
+    ubuf_free(ubuf1);
+    ubuf1 = ubuf_block_alloc(mgr, 1316);
+    assert(ubuf1 != NULL);
+    wsize = -1;
+    ubase_assert(ubuf_block_write(ubuf1, 0, &wsize, &w));
+    assert(wsize == 1316);
+    memset(w, 0xff, wsize);
+    ubase_assert(ubuf_block_unmap(ubuf1, 0));
+    ubuf_free(ubuf1);
+
+    ubuf_mgr_release(mgr);
+}
 
 int main(int argc, char **argv)
 {
@@ -271,6 +354,44 @@ int main(int argc, char **argv)
     ubase_assert(ubuf_block_find(ubuf1, &offset, 2, 2, 3));
     assert(offset == 2);
 
+    /* test ubuf_block_find_startcode, with a start code spanning three
+     * segments */
+    ubuf2 = ubuf_block_alloc(mgr, 40);
+    assert(ubuf2 != NULL);
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf2, 0, &wanted, &w));
+    memset(w, 0x42, wanted);
+    w[wanted - 1] = 0;
+    ubase_assert(ubuf_block_unmap(ubuf2, 0));
+    ubuf3 = ubuf_block_alloc(mgr, 1);
+    assert(ubuf3 != NULL);
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf3, 0, &wanted, &w));
+    w[0] = 0;
+    ubase_assert(ubuf_block_unmap(ubuf3, 0));
+    ubase_assert(ubuf_block_append(ubuf2, ubuf3));
+    ubuf3 = ubuf_block_alloc(mgr, 40);
+    assert(ubuf3 != NULL);
+    wanted = -1;
+    ubase_assert(ubuf_block_write(ubuf3, 0, &wanted, &w));
+    memset(w, 0x42, wanted);
+    w[0] = 1;
+    w[30] = w[31] = 0;
+    w[32] = 1;
+    w[wanted - 1] = 0;
+    ubase_assert(ubuf_block_unmap(ubuf3, 0));
+    ubase_assert(ubuf_block_append(ubuf2, ubuf3));
+    offset = 0;
+    ubase_assert(ubuf_block_find_startcode(ubuf2, &offset));
+    assert(offset == 39);
+    offset++;
+    ubase_assert(ubuf_block_find(ubuf2, &offset, 3, 0, 0, 1));
+    assert(offset == 71);
+    offset++;
+    ubase_nassert(ubuf_block_find_startcode(ubuf2, &offset));
+    assert(offset == 80);
+    ubuf_free(ubuf2);
+
     /* test ubuf_block_stream */
     struct ubuf_block_stream s;
     ubuf_block_stream_init(&s, ubuf1, 0);
@@ -313,6 +434,8 @@ int main(int argc, char **argv)
     ubuf_free(ubuf2);
 
     ubuf_mgr_release(mgr);
+
+    test_slab(umem_mgr);
     umem_mgr_release(umem_mgr);
     return 0;
 }
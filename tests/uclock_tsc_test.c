@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for uclock_tsc
+ */
+
+#undef NDEBUG
+
+#include "upipe/uclock.h"
+#include "upipe/uclock_std.h"
+#include "upipe/uclock_tsc.h"
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <time.h>
+#include <assert.h>
+
+#define TIME_SAMPLE 1429627742
+#define NB_LOOPS 100000
+/** maximum difference with the system clock */
+#define TOLERANCE (UCLOCK_FREQ / 1000)
+
+static void check(struct uclock *uclock, struct uclock *uclock_std)
+{
+    uint64_t before = uclock_now(uclock_std);
+    uint64_t now = uclock_now(uclock);
+    uint64_t after = uclock_now(uclock_std);
+    printf("TSC: %"PRIu64" Std: %"PRIu64"\n", now, before);
+    assert(now + TOLERANCE >= before);
+    assert(now <= after + TOLERANCE);
+}
+
+int main(int argc, char **argv)
+{
+    struct uclock *uclock = uclock_tsc_alloc(0);
+    if (uclock == NULL) {
+        printf("no invariant counter, skipping\n");
+        return 77;
+    }
+    struct uclock *uclock_cal = uclock_tsc_alloc(UCLOCK_FLAG_REALTIME);
+    assert(uclock_cal);
+    struct uclock *uclock_std = uclock_std_alloc(0);
+    assert(uclock_std);
+
+    check(uclock, uclock_std);
+
+    uint64_t last = uclock_now(uclock);
+    for (int i = 0; i < NB_LOOPS; i++) {
+        uint64_t now = uclock_now(uclock);
+        assert(now >= last);
+        last = now;
+    }
+
+    /* go through at least one correction */
+    struct timespec ts = { .tv_sec = 1, .tv_nsec = 200000000 };
+    while (nanosleep(&ts, &ts) == -1);
+    check(uclock, uclock_std);
+
+    assert(uclock_to_real(uclock_cal, (uint64_t)TIME_SAMPLE * UCLOCK_FREQ) ==
+           TIME_SAMPLE * UCLOCK_FREQ);
+    assert(uclock_from_real(uclock_cal, (uint64_t)TIME_SAMPLE * UCLOCK_FREQ) ==
+           TIME_SAMPLE * UCLOCK_FREQ);
+    uint64_t real = uclock_to_real(uclock, last);
+    assert(uclock_from_real(uclock, real) + TOLERANCE >= last);
+    assert(uclock_from_real(uclock, real) <= last + TOLERANCE);
+
+    uclock_release(uclock);
+    uclock_release(uclock_cal);
+    uclock_release(uclock_std);
+    return 0;
+}
@@ -33,6 +33,7 @@
 #include "upipe/umem_alloc.h"
 #include "upipe/udict.h"
 #include "upipe/udict_inline.h"
+#include "upipe/udict_key.h"
 #include "upipe/udict_dump.h"
 #include "upipe/uprobe.h"
 #include "upipe/uprobe_stdio.h"
@@ -47,6 +48,196 @@
 
 #define SALUTATION "Hello everyone, this is just some padding to make the structure bigger, if you don't mind."
 
+#define NB_ATTRS 40
+
+/** counts the attributes of a udict */
+static unsigned int count_attrs(struct udict *udict)
+{
+    const char *name = NULL;
+    enum udict_type type = UDICT_TYPE_END;
+    unsigned int count = 0;
+    for (;;) {
+        ubase_assert(udict_iterate(udict, &name, &type));
+        if (type == UDICT_TYPE_END)
+            break;
+        count++;
+    }
+    return count;
+}
+
+/** checks the attributes set by test_index */
+static void check_index(struct udict *udict)
+{
+    for (unsigned int i = 0; i < NB_ATTRS; i++) {
+        char name[16];
+        uint64_t u;
+        snprintf(name, sizeof(name), "x.attr%u", i);
+        if (i % 3)
+            ubase_assert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED,
+                                            name));
+        else
+            ubase_nassert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED,
+                                             name));
+        if (i % 3)
+            assert(u == i);
+    }
+    const char *string;
+    ubase_assert(udict_get_string(udict, &string, UDICT_TYPE_FLOW_DEF, NULL));
+    assert(!strcmp(string, "block.mpegts."));
+    ubase_assert(udict_get_void(udict, NULL, UDICT_TYPE_BLOCK_END, NULL));
+    assert(count_attrs(udict) == NB_ATTRS - (NB_ATTRS + 2) / 3 + 2);
+}
+
+/** tests the indexed mode with tombstone deletes */
+static void test_index(struct umem_mgr *umem_mgr)
+{
+    struct udict_mgr *mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr,
+                                                   -1, -1);
+    assert(mgr != NULL);
+    ubase_assert(udict_inline_mgr_set_index_threshold(mgr, 4));
+
+    struct udict *udict = udict_alloc(mgr, 0);
+    assert(udict != NULL);
+    ubase_assert(udict_set_void(udict, NULL, UDICT_TYPE_BLOCK_END, NULL));
+    for (unsigned int i = 0; i < NB_ATTRS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "x.attr%u", i);
+        ubase_assert(udict_set_unsigned(udict, i, UDICT_TYPE_UNSIGNED, name));
+    }
+    ubase_assert(udict_set_string(udict, "block.", UDICT_TYPE_FLOW_DEF, NULL));
+    for (unsigned int i = 0; i < NB_ATTRS; i += 3) {
+        char name[16];
+        snprintf(name, sizeof(name), "x.attr%u", i);
+        ubase_assert(udict_delete(udict, UDICT_TYPE_UNSIGNED, name));
+        ubase_nassert(udict_delete(udict, UDICT_TYPE_UNSIGNED, name));
+    }
+    /* replaced with a bigger value, tombstone followed by append */
+    ubase_assert(udict_set_string(udict, "block.mpegts.", UDICT_TYPE_FLOW_DEF,
+                                  NULL));
+    check_index(udict);
+
+    struct udict *udict2 = udict_dup(udict);
+    assert(udict2 != NULL);
+    check_index(udict2);
+    udict_free(udict2);
+
+    /* interned keys */
+    char plain[] = "x.attr4";
+    const char *key = udict_key_intern(plain);
+    assert(key != plain);
+    assert(!strcmp(key, plain));
+    assert(udict_key_intern("x.attr4") == key);
+    assert(udict_key_get(key) != NULL);
+    assert(udict_key_get(plain) == NULL);
+    uint64_t u;
+    ubase_assert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED, key));
+    assert(u == 4);
+    ubase_nassert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED,
+                                     udict_key_intern("x.attr3")));
+    ubase_assert(udict_set_unsigned(udict, 42, UDICT_TYPE_UNSIGNED,
+                                    udict_key_intern("x.interned")));
+    ubase_assert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED,
+                                    "x.interned"));
+    assert(u == 42);
+    ubase_assert(udict_delete(udict, UDICT_TYPE_UNSIGNED, "x.interned"));
+
+    /* force compaction */
+    ubase_assert(udict_set_string(udict, SALUTATION SALUTATION SALUTATION,
+                                  UDICT_TYPE_STRING, "x.salutation"));
+    ubase_assert(udict_delete(udict, UDICT_TYPE_STRING, "x.salutation"));
+    check_index(udict);
+
+    udict_free(udict);
+    udict_mgr_release(mgr);
+}
+
+/** tests the sharing of buffers between duplicated udicts */
+static void test_cow(struct umem_mgr *umem_mgr)
+{
+    struct udict_mgr *mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr,
+                                                   -1, -1);
+    assert(mgr != NULL);
+
+    struct udict *udict = udict_alloc(mgr, 0);
+    assert(udict != NULL);
+    ubase_assert(udict_set_unsigned(udict, 1, UDICT_TYPE_UNSIGNED, "x.a"));
+    ubase_assert(udict_set_string(udict, "block.", UDICT_TYPE_FLOW_DEF, NULL));
+
+    struct udict *udict2 = udict_dup(udict);
+    assert(udict2 != NULL);
+    struct udict *udict3 = udict_dup(udict2);
+    assert(udict3 != NULL);
+
+    const char *def1, *def2;
+    ubase_assert(udict_get_string(udict, &def1, UDICT_TYPE_FLOW_DEF, NULL));
+    ubase_assert(udict_get_string(udict2, &def2, UDICT_TYPE_FLOW_DEF, NULL));
+    assert(def1 == def2);
+
+    /* writes to a duplicate do not show in the others */
+    ubase_assert(udict_set_unsigned(udict2, 2, UDICT_TYPE_UNSIGNED, "x.a"));
+    ubase_assert(udict_set_unsigned(udict2, 3, UDICT_TYPE_UNSIGNED, "x.b"));
+    ubase_assert(udict_get_string(udict2, &def2, UDICT_TYPE_FLOW_DEF, NULL));
+    assert(def1 != def2);
+    uint64_t u;
+    ubase_assert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED, "x.a"));
+    assert(u == 1);
+    ubase_nassert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED, "x.b"));
+    ubase_assert(udict_get_unsigned(udict2, &u, UDICT_TYPE_UNSIGNED, "x.a"));
+    assert(u == 2);
+
+    ubase_assert(udict_delete(udict3, UDICT_TYPE_UNSIGNED, "x.a"));
+    ubase_nassert(udict_get_unsigned(udict3, &u, UDICT_TYPE_UNSIGNED, "x.a"));
+    ubase_assert(udict_get_unsigned(udict, &u, UDICT_TYPE_UNSIGNED, "x.a"));
+    assert(u == 1);
+
+    /* the last owner of a buffer writes in place */
+    struct udict *udict4 = udict_dup(udict);
+    assert(udict4 != NULL);
+    udict_free(udict);
+    ubase_assert(udict_get_string(udict4, &def2, UDICT_TYPE_FLOW_DEF, NULL));
+    assert(def1 == def2);
+    ubase_assert(udict_set_unsigned(udict4, 4, UDICT_TYPE_UNSIGNED, "x.a"));
+    ubase_assert(udict_get_string(udict4, &def2, UDICT_TYPE_FLOW_DEF, NULL));
+    assert(def1 == def2);
+
+    udict_free(udict4);
+    udict_free(udict3);
+    udict_free(udict2);
+    udict_mgr_release(mgr);
+}
+
+/** tests the allocation statistics of the manager */
+static void test_stats(struct umem_mgr *umem_mgr)
+{
+    struct udict_mgr *mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH, umem_mgr,
+                                                   -1, -1);
+    assert(mgr != NULL);
+
+    struct udict *udict1 = udict_alloc(mgr, 0);
+    assert(udict1 != NULL);
+    struct udict *udict2 = udict_alloc(mgr, 0);
+    assert(udict2 != NULL);
+    udict_free(udict1);
+    udict_free(udict2);
+    udict1 = udict_alloc(mgr, 0);
+    assert(udict1 != NULL);
+
+    struct ualloc_stats stats;
+    ubase_assert(udict_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == 1);
+    assert(stats.misses == 2);
+    assert(stats.overflows == 1);
+    assert(stats.retained == 0);
+    assert(stats.high_water == 1);
+
+    udict_free(udict1);
+    ubase_assert(udict_mgr_get_stats(mgr, &stats));
+    assert(stats.retained == 1);
+    assert(stats.retained_bytes > 0);
+
+    udict_mgr_release(mgr);
+}
+
 int main(int argc, char **argv)
 {
     struct uprobe *uprobe = uprobe_stdio_alloc(NULL, stdout, UPROBE_LOG_DEBUG);
@@ -148,6 +339,10 @@ int main(int argc, char **argv)
     udict_free(udict1);
     udict_mgr_release(mgr);
 
+    test_index(umem_mgr);
+    test_cow(umem_mgr);
+    test_stats(umem_mgr);
+
     umem_mgr_release(umem_mgr);
     uprobe_release(uprobe);
     return 0;
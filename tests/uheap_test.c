@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for uheap implementation
+ */
+
+#undef NDEBUG
+
+#include "upipe/ubase.h"
+#include "upipe/uheap.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+struct item {
+    struct uheap_node node;
+    bool in;
+};
+
+UBASE_FROM_TO(item, uheap_node, node, node)
+
+/** checks that the top of the heap is the lowest key */
+static void check_top(struct uheap *uheap, struct item *items, unsigned nb)
+{
+    uint64_t min = UINT64_MAX;
+    unsigned count = 0;
+    for (unsigned i = 0; i < nb; i++) {
+        assert(uheap_node_is_in(&items[i].node) == items[i].in);
+        if (!items[i].in)
+            continue;
+        count++;
+        if (items[i].node.key < min)
+            min = items[i].node.key;
+    }
+    assert(uheap_size(uheap) == count);
+    struct uheap_node *top = uheap_peek(uheap);
+    if (!count)
+        assert(top == NULL);
+    else
+        assert(top != NULL && top->key == min);
+}
+
+int main(int argc, char **argv)
+{
+    struct uheap uheap;
+    struct item items[1024];
+
+    uheap_init(&uheap);
+    assert(uheap_peek(&uheap) == NULL);
+    for (unsigned i = 0; i < UBASE_ARRAY_SIZE(items); i++) {
+        uheap_node_init(&items[i].node);
+        items[i].in = false;
+    }
+
+    /* insertion in decreasing order */
+    for (unsigned i = 0; i < UBASE_ARRAY_SIZE(items); i++) {
+        assert(uheap_update(&uheap, &items[i].node,
+                            UBASE_ARRAY_SIZE(items) - i));
+        items[i].in = true;
+        assert(uheap_peek(&uheap) == &items[i].node);
+    }
+    check_top(&uheap, items, UBASE_ARRAY_SIZE(items));
+
+    /* popping yields increasing keys */
+    uint64_t last = 0;
+    while (uheap_peek(&uheap) != NULL) {
+        struct item *item = item_from_node(uheap_peek(&uheap));
+        assert(item->node.key >= last);
+        last = item->node.key;
+        uheap_delete(&uheap, &item->node);
+        item->in = false;
+    }
+    check_top(&uheap, items, UBASE_ARRAY_SIZE(items));
+
+    /* random insertions, updates and deletions */
+    srand(42);
+    for (unsigned n = 0; n < 100000; n++) {
+        struct item *item = &items[rand() % UBASE_ARRAY_SIZE(items)];
+        if (item->in && rand() % 3 == 0) {
+            uheap_delete(&uheap, &item->node);
+            item->in = false;
+        } else {
+            assert(uheap_update(&uheap, &item->node, rand() % 10000));
+            item->in = true;
+        }
+        if (n % 97 == 0)
+            check_top(&uheap, items, UBASE_ARRAY_SIZE(items));
+    }
+    check_top(&uheap, items, UBASE_ARRAY_SIZE(items));
+
+    uheap_clean(&uheap);
+    for (unsigned i = 0; i < UBASE_ARRAY_SIZE(items); i++)
+        assert(!uheap_node_is_in(&items[i].node));
+    return 0;
+}
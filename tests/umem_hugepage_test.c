@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umem hugepage manager
+ */
+
+#undef NDEBUG
+
+#include "upipe/umem.h"
+#include "upipe/umem_hugepage.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static void test_mgr(struct umem_mgr *mgr)
+{
+    struct umem umem;
+    assert(umem_alloc(mgr, &umem, 42));
+    uint8_t *p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(!((uintptr_t)p % 64));
+    memset(p, 0x42, 42);
+
+    assert(umem_realloc(&umem, 64));
+    assert(umem_buffer(&umem) == p);
+
+    assert(umem_realloc(&umem, 4096));
+    p = umem_buffer(&umem);
+    assert(p != NULL);
+    assert(!((uintptr_t)p % 4096));
+    assert(p[0] == 0x42);
+    assert(p[41] == 0x42);
+    umem_free(&umem);
+
+    assert(umem_alloc(mgr, &umem, 4000));
+    assert(umem_buffer(&umem) == p);
+    umem_free(&umem);
+
+    /* pools underflow and oversized buffers revert to malloc() */
+    struct umem umems[3];
+    for (unsigned int i = 0; i < 3; i++) {
+        assert(umem_alloc(mgr, &umems[i], 4096));
+        memset(umem_buffer(&umems[i]), i, 4096);
+    }
+    for (unsigned int i = 0; i < 3; i++)
+        umem_free(&umems[i]);
+
+    assert(umem_alloc(mgr, &umem, 1024 * 1024));
+    memset(umem_buffer(&umem), 0, 1024 * 1024);
+    umem_free(&umem);
+}
+
+int main(int argc, char **argv)
+{
+    /* normal pages */
+    struct umem_mgr *mgr = umem_hugepage_mgr_alloc(0, -1, 64, 7,
+                                                   4, 4, 4, 4, 4, 4, 2);
+    assert(mgr != NULL);
+    test_mgr(mgr);
+    umem_mgr_release(mgr);
+    printf("Passed 1\n");
+
+    /* hugepages, falling back to normal pages if none are reserved, on the
+     * first NUMA node */
+    mgr = umem_hugepage_mgr_alloc(UMEM_HUGEPAGE_2M, 0, 64, 7,
+                                  4, 4, 4, 4, 4, 4, 2);
+    assert(mgr != NULL);
+    test_mgr(mgr);
+    umem_mgr_release(mgr);
+    printf("Passed 2\n");
+    return 0;
+}
@@ -35,7 +35,27 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdbool.h>
 #include <assert.h>
+#include <pthread.h>
+
+#define NB_BUFFERS 64
+
+static uint8_t *buffers[NB_BUFFERS];
+
+/** thread releasing buffers allocated by the main thread */
+static void *release_thread(void *_mgr)
+{
+    struct umem_mgr *mgr = _mgr;
+    for (unsigned int i = 0; i < NB_BUFFERS; i++) {
+        struct umem umem;
+        umem.mgr = mgr;
+        umem.buffer = buffers[i];
+        umem.size = umem.real_size = 4096;
+        umem_free(&umem);
+    }
+    return NULL;
+}
 
 int main(int argc, char **argv)
 {
@@ -87,6 +107,78 @@ int main(int argc, char **argv)
     umem_free(&umem);
     printf("Passed 6\n");
 
+    struct ualloc_stats stats;
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits == 1);
+    assert(stats.misses == 3);
+    assert(stats.overflows == 0);
+    assert(stats.retained == 3);
+    assert(stats.high_water == 3);
+    assert(stats.retained_bytes == 64 + 8192 + 128);
+    umem_mgr_vacuum(mgr);
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.retained == 0);
+    assert(stats.retained_bytes == 0);
+    printf("Passed stats\n");
+
+    umem_mgr_release(mgr);
+
+    mgr = umem_pool_mgr_alloc_simple_cached(32, 4);
+    assert(mgr != NULL);
+
+    assert(umem_alloc(mgr, &umem, 42));
+    p = umem_buffer(&umem);
+    umem_free(&umem);
+    assert(umem_alloc(mgr, &umem, 64));
+    assert(umem_buffer(&umem) == p);
+    umem_free(&umem);
+    printf("Passed 7\n");
+
+    for (unsigned int i = 0; i < NB_BUFFERS; i++) {
+        assert(umem_alloc(mgr, &umem, 4096));
+        buffers[i] = umem_buffer(&umem);
+        memset(buffers[i], i, 4096);
+    }
+    pthread_t thread;
+    assert(!pthread_create(&thread, NULL, release_thread, mgr));
+    assert(!pthread_join(thread, NULL));
+    printf("Passed 8\n");
+
+    /* buffers released by the other thread went back to the shared pool */
+    assert(umem_alloc(mgr, &umem, 4096));
+    bool found = false;
+    for (unsigned int i = 0; i < NB_BUFFERS; i++)
+        if (umem_buffer(&umem) == buffers[i])
+            found = true;
+    assert(found);
+    umem_free(&umem);
+    printf("Passed 9\n");
+
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits + stats.misses == 2 + NB_BUFFERS + 1);
+    /* the shared pool of 4 KiB buffers only keeps 32 of them */
+    assert(stats.retained == 1 + 32);
+    assert(stats.overflows == NB_BUFFERS - 32);
+    printf("Passed cached stats\n");
+
+    /* threads created one after the other take over the cache of the
+     * previous one, and keep its counters */
+    uint64_t nb_allocs = stats.hits + stats.misses;
+    uint64_t nb_overflows = stats.overflows;
+    for (unsigned int j = 0; j < 4; j++) {
+        for (unsigned int i = 0; i < NB_BUFFERS; i++) {
+            assert(umem_alloc(mgr, &umem, 4096));
+            buffers[i] = umem_buffer(&umem);
+        }
+        assert(!pthread_create(&thread, NULL, release_thread, mgr));
+        assert(!pthread_join(thread, NULL));
+    }
+    ubase_assert(umem_mgr_get_stats(mgr, &stats));
+    assert(stats.hits + stats.misses == nb_allocs + 4 * NB_BUFFERS);
+    assert(stats.retained == 1 + 32);
+    assert(stats.overflows == nb_overflows + 4 * (NB_BUFFERS - 32));
+    printf("Passed 10\n");
+
     umem_mgr_release(mgr);
     return 0;
 }
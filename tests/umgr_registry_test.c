@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the registry of shared managers
+ */
+
+#undef NDEBUG
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/umem.h"
+#include "upipe/udict.h"
+#include "upipe/uref.h"
+#include "upipe/upipe.h"
+#include "upipe/umgr_registry.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define NB_THREADS 8
+
+static int nb_allocs = 0;
+static int nb_frees = 0;
+
+/** helper phony manager */
+struct test_mgr {
+    struct urefcount urefcount;
+    struct upipe_mgr mgr;
+};
+
+/** helper phony manager */
+static void test_mgr_free(struct urefcount *urefcount)
+{
+    struct test_mgr *test_mgr =
+        container_of(urefcount, struct test_mgr, urefcount);
+    urefcount_clean(urefcount);
+    free(test_mgr);
+    __atomic_add_fetch(&nb_frees, 1, __ATOMIC_SEQ_CST);
+}
+
+/** helper phony manager */
+static struct upipe_mgr *test_mgr_alloc(void)
+{
+    struct test_mgr *test_mgr = malloc(sizeof(struct test_mgr));
+    assert(test_mgr != NULL);
+    urefcount_init(&test_mgr->urefcount, test_mgr_free);
+    test_mgr->mgr.refcount = &test_mgr->urefcount;
+    __atomic_add_fetch(&nb_allocs, 1, __ATOMIC_SEQ_CST);
+    return &test_mgr->mgr;
+}
+
+static void *thread(void *arg)
+{
+    struct uref_mgr **uref_mgr_p = arg;
+    *uref_mgr_p = umgr_registry_uref_mgr();
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t threads[NB_THREADS];
+    struct uref_mgr *uref_mgrs[NB_THREADS];
+    for (int i = 0; i < NB_THREADS; i++)
+        assert(!pthread_create(&threads[i], NULL, thread, &uref_mgrs[i]));
+    for (int i = 0; i < NB_THREADS; i++)
+        assert(!pthread_join(threads[i], NULL));
+
+    /* all threads share the same manager */
+    for (int i = 0; i < NB_THREADS; i++) {
+        assert(uref_mgrs[i] != NULL);
+        assert(uref_mgrs[i] == uref_mgrs[0]);
+    }
+    struct uref *uref = uref_alloc(uref_mgrs[0]);
+    assert(uref != NULL);
+    uref_free(uref);
+
+    struct udict_mgr *udict_mgr = umgr_registry_udict_mgr();
+    assert(udict_mgr != NULL);
+    assert(udict_mgr == uref_mgrs[0]->udict_mgr);
+    udict_mgr_release(udict_mgr);
+
+    /* managers are allocated on first use only */
+    assert(nb_allocs == 0);
+    struct upipe_mgr *mgr1 = umgr_registry_upipe_mgr("test", test_mgr_alloc);
+    struct upipe_mgr *mgr2 = umgr_registry_upipe_mgr("test", test_mgr_alloc);
+    assert(mgr1 != NULL);
+    assert(mgr1 == mgr2);
+    assert(nb_allocs == 1);
+    upipe_mgr_release(mgr2);
+
+    /* the managers still in use survive the registry */
+    umgr_registry_clean();
+    assert(nb_frees == 0);
+    upipe_mgr_release(mgr1);
+    assert(nb_frees == 1);
+
+    mgr1 = umgr_registry_upipe_mgr("test", test_mgr_alloc);
+    assert(mgr1 != NULL);
+    assert(nb_allocs == 2);
+    upipe_mgr_release(mgr1);
+
+    for (int i = 0; i < NB_THREADS; i++)
+        uref_mgr_release(uref_mgrs[i]);
+    umgr_registry_clean();
+    assert(nb_frees == 2);
+    return 0;
+}
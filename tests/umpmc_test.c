@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for umpmc
+ */
+
+#undef NDEBUG
+
+#include "upipe/ubase.h"
+#include "upipe/uatomic.h"
+#include "upipe/umpmc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define UMPMC_LENGTH 1000
+#define NB_THREADS 4
+#define NB_LOOPS 100000
+#define BATCH_SIZE 16
+
+static struct umpmc umpmc;
+static uatomic_uint32_t popped;
+static uint64_t sums[NB_THREADS];
+
+static void *push_thread(void *_thread)
+{
+    uintptr_t thread = (uintptr_t)_thread;
+    uintptr_t i = 1;
+    while (i <= NB_LOOPS) {
+        void *opaques[BATCH_SIZE];
+        unsigned int nb = 0;
+        while (nb < BATCH_SIZE && i + nb <= NB_LOOPS) {
+            opaques[nb] = (void *)((i + nb) * NB_THREADS + thread);
+            nb++;
+        }
+        if (thread % 2)
+            i += umpmc_push_batch(&umpmc, opaques, nb);
+        else if (umpmc_push(&umpmc, opaques[0]))
+            i++;
+    }
+    return NULL;
+}
+
+static void *pop_thread(void *_thread)
+{
+    uintptr_t thread = (uintptr_t)_thread;
+    uintptr_t last[NB_THREADS] = { 0 };
+    while (uatomic_load(&popped) < NB_THREADS * NB_LOOPS) {
+        void *opaques[BATCH_SIZE];
+        unsigned int nb;
+        if (thread % 2)
+            nb = umpmc_pop_batch(&umpmc, opaques, BATCH_SIZE);
+        else {
+            opaques[0] = umpmc_pop(&umpmc, void *);
+            nb = opaques[0] != NULL ? 1 : 0;
+        }
+        for (unsigned int j = 0; j < nb; j++) {
+            uintptr_t value = (uintptr_t)opaques[j];
+            uintptr_t producer = value % NB_THREADS;
+            /* elements of a producer are seen in order by any consumer */
+            assert(value / NB_THREADS > last[producer]);
+            last[producer] = value / NB_THREADS;
+            sums[thread] += value;
+        }
+        if (nb)
+            uatomic_fetch_add(&popped, nb);
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    void *extra = malloc(umpmc_sizeof(UMPMC_LENGTH));
+    assert(extra != NULL);
+    umpmc_init(&umpmc, UMPMC_LENGTH, extra);
+    assert(umpmc_length(&umpmc) == 1024);
+
+    /* single thread */
+    uintptr_t i;
+    for (i = 1; i <= 1024; i++)
+        assert(umpmc_push(&umpmc, (void *)i));
+    assert(!umpmc_push(&umpmc, (void *)i));
+    for (i = 1; i <= 1000; i++)
+        assert(umpmc_pop(&umpmc, uintptr_t) == i);
+
+    void *opaques[BATCH_SIZE * 4];
+    for (i = 0; i < BATCH_SIZE * 4; i++)
+        opaques[i] = (void *)(i + 2000);
+    unsigned int nb, count = 0;
+    while ((nb = umpmc_push_batch(&umpmc, opaques, BATCH_SIZE * 4)) ==
+           BATCH_SIZE * 4)
+        count += nb;
+    assert(count + nb == 1000);
+    assert(umpmc_push_batch(&umpmc, opaques, 1) == 0);
+    assert(umpmc_pop_batch(&umpmc, opaques, BATCH_SIZE) == BATCH_SIZE);
+    assert((uintptr_t)opaques[0] == 1001);
+    for (i = 0; i < 1024 - BATCH_SIZE; i++)
+        assert(umpmc_pop(&umpmc, void *) != NULL);
+    assert(umpmc_pop(&umpmc, void *) == NULL);
+    assert(umpmc_pop_batch(&umpmc, opaques, BATCH_SIZE) == 0);
+
+    /* multiple producers and consumers */
+    uatomic_init(&popped, 0);
+    pthread_t pushers[NB_THREADS], poppers[NB_THREADS];
+    for (i = 0; i < NB_THREADS; i++) {
+        assert(!pthread_create(&poppers[i], NULL, pop_thread, (void *)i));
+        assert(!pthread_create(&pushers[i], NULL, push_thread, (void *)i));
+    }
+    uint64_t sum = 0;
+    for (i = 0; i < NB_THREADS; i++) {
+        assert(!pthread_join(pushers[i], NULL));
+        assert(!pthread_join(poppers[i], NULL));
+        sum += sums[i];
+    }
+    assert(umpmc_pop(&umpmc, void *) == NULL);
+
+    uint64_t expected = 0;
+    for (i = 1; i <= NB_LOOPS; i++)
+        for (uintptr_t thread = 0; thread < NB_THREADS; thread++)
+            expected += i * NB_THREADS + thread;
+    assert(sum == expected);
+
+    uatomic_clean(&popped);
+    umpmc_clean(&umpmc);
+    free(extra);
+    return 0;
+}
@@ -34,6 +34,8 @@
 #include "upipe/udict.h"
 #include "upipe/udict_inline.h"
 #include "upipe/uref.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_clock.h"
 #include "upipe/uref_pic_flow.h"
 #include "upipe/uref_sound_flow.h"
 #include "upipe/uref_std.h"
@@ -53,6 +55,7 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static bool got_uref = false;
+static struct uref *pictures[2] = { NULL, NULL };
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
@@ -86,7 +89,10 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     upipe_dbg(upipe, "===> received input uref");
     uref_dump(uref, upipe->uprobe);
-    uref_free(uref);
+    /* keep the last two pictures */
+    uref_free(pictures[0]);
+    pictures[0] = pictures[1];
+    pictures[1] = uref;
     got_uref = true;
 }
 
@@ -181,12 +187,48 @@ int main(int argc, char **argv)
 
     uref = uref_alloc(uref_mgr);
     assert(uref);
+    uref_clock_set_pts_prog(uref, UCLOCK_FREQ);
     ubase_assert(uref_amax_set_amplitude(uref, 0.8, 0));
     ubase_assert(uref_amax_set_amplitude(uref, 0.6, 1));
     /* Now send uref */
     upipe_input(audiobar, uref, NULL);
     assert(got_uref);
 
+    /* peaks have fallen back */
+    uref = uref_alloc(uref_mgr);
+    assert(uref);
+    uref_clock_set_pts_prog(uref, 10 * UCLOCK_FREQ);
+    ubase_assert(uref_amax_set_amplitude(uref, 0.8, 0));
+    ubase_assert(uref_amax_set_amplitude(uref, 0.6, 1));
+    upipe_input(audiobar, uref, NULL);
+
+    /* the right bar grows, while the previous picture is still held */
+    uref = uref_alloc(uref_mgr);
+    assert(uref);
+    uref_clock_set_pts_prog(uref, 10 * UCLOCK_FREQ + UCLOCK_FREQ / 25);
+    ubase_assert(uref_amax_set_amplitude(uref, 0.1, 0));
+    ubase_assert(uref_amax_set_amplitude(uref, 0.9, 1));
+    upipe_input(audiobar, uref, NULL);
+    assert(pictures[0] != NULL && pictures[1] != NULL);
+
+    const uint8_t *y[2];
+    size_t stride;
+    for (int i = 0; i < 2; i++) {
+        ubase_assert(uref_pic_plane_read(pictures[i], "y8", 0, 0, -1, -1,
+                                         &y[i]));
+        ubase_assert(uref_pic_plane_size(pictures[i], "y8", &stride,
+                                         NULL, NULL, NULL));
+    }
+    assert(y[0] != y[1]);
+    /* dim then bright red on the right bar, unchanged left bar */
+    assert(y[0][5 * stride + 75] == 37);
+    assert(y[1][5 * stride + 75] == 76);
+    assert(y[0][60 * stride + 25] == y[1][60 * stride + 25]);
+    for (int i = 0; i < 2; i++) {
+        ubase_assert(uref_pic_plane_unmap(pictures[i], "y8", 0, 0, -1, -1));
+        uref_free(pictures[i]);
+    }
+
     upipe_release(audiobar);
     test_free(audiobar_test);
 
@@ -62,6 +62,8 @@
 #define OUTPUT_SIZE             1024
 
 static uint64_t last_pts = 0;
+static uint16_t in_sample = 0;
+static uint16_t out_sample = 0;
 
 struct sink {
     struct upipe upipe;
@@ -114,6 +116,16 @@ static void sink_input(struct upipe *upipe, struct uref *uref,
     size_t size;
     ubase_assert(uref_sound_size(uref, &size, NULL));
     assert(size == OUTPUT_SIZE);
+    /* samples must come out in order, whether sliced or copied */
+    const int16_t *l, *r;
+    ubase_assert(uref_sound_plane_read_int16_t(uref, "l", 0, -1, &l));
+    ubase_assert(uref_sound_plane_read_int16_t(uref, "r", 0, -1, &r));
+    for (size_t i = 0; i < size; i++, out_sample++) {
+        assert((uint16_t)l[i] == out_sample);
+        assert((uint16_t)r[i] == (uint16_t)~out_sample);
+    }
+    uref_sound_plane_unmap(uref, "l", 0, -1);
+    uref_sound_plane_unmap(uref, "r", 0, -1);
     uint64_t pts;
     ubase_assert(uref_clock_get_pts_prog(uref, &pts));
     assert(pts > last_pts);
@@ -159,6 +171,21 @@ static int sink_control(struct upipe *upipe,
     return UBASE_ERR_UNHANDLED;
 }
 
+static void fill_in(struct uref *uref)
+{
+    size_t size;
+    ubase_assert(uref_sound_size(uref, &size, NULL));
+    int16_t *l, *r;
+    ubase_assert(uref_sound_plane_write_int16_t(uref, "l", 0, -1, &l));
+    ubase_assert(uref_sound_plane_write_int16_t(uref, "r", 0, -1, &r));
+    for (size_t i = 0; i < size; i++, in_sample++) {
+        l[i] = in_sample;
+        r[i] = ~in_sample;
+    }
+    uref_sound_plane_unmap(uref, "l", 0, -1);
+    uref_sound_plane_unmap(uref, "r", 0, -1);
+}
+
 static struct upipe_mgr sink_mgr = {
     .refcount = NULL,
     .signature = 0,
@@ -180,7 +207,10 @@ int main(int argc, char *argv[])
 
     struct ubuf_mgr *ubuf_mgr =
         ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
-                                 umem_mgr, 4 * 2, 4 * 2);
+                                 umem_mgr, 2, 4 * 2);
+    assert(ubuf_mgr);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(ubuf_mgr, "l"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(ubuf_mgr, "r"));
 
     struct uref_mgr *uref_mgr =
         uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
@@ -221,7 +251,7 @@ int main(int argc, char *argv[])
     upipe_release(sink);
 
     flow_def =
-        uref_sound_flow_alloc_def(uref_mgr, "s16.", CHANNELS, 2 * CHANNELS);
+        uref_sound_flow_alloc_def(uref_mgr, "s16.", CHANNELS, 2);
     assert(flow_def);
     ubase_assert(uref_sound_flow_set_rate(flow_def, RATE));
     ubase_assert(uref_sound_flow_set_planes(flow_def, 2));
@@ -233,12 +263,14 @@ int main(int argc, char *argv[])
         size_t size = 3 * OUTPUT_SIZE + (OUTPUT_SIZE / LIMIT) + (i ? 0 : 1);
         struct uref *uref = uref_sound_alloc(uref_mgr, ubuf_mgr,
                                              3 * OUTPUT_SIZE + (OUTPUT_SIZE / LIMIT) + (i ? 0 : 1));
+        fill_in(uref);
         uref_clock_set_pts_prog(uref, pts);
         pts += 1000 + (UCLOCK_FREQ * size / RATE);
         upipe_input(upipe_audio_copy, uref, NULL);
     }
 
     upipe_release(upipe_audio_copy);
+    in_sample = out_sample = 0;
 
 
     flow_def =
@@ -280,7 +312,7 @@ int main(int argc, char *argv[])
     upipe_release(sink);
 
     flow_def =
-        uref_sound_flow_alloc_def(uref_mgr, "s16.", CHANNELS, 2 * CHANNELS);
+        uref_sound_flow_alloc_def(uref_mgr, "s16.", CHANNELS, 2);
     assert(flow_def);
     ubase_assert(uref_sound_flow_set_rate(flow_def, RATE));
     ubase_assert(uref_sound_flow_set_planes(flow_def, 2));
@@ -291,6 +323,7 @@ int main(int argc, char *argv[])
         size_t size = 3 * OUTPUT_SIZE + (OUTPUT_SIZE / LIMIT);
         struct uref *uref = uref_sound_alloc(
             uref_mgr, ubuf_mgr, size);
+        fill_in(uref);
         uref_clock_set_pts_prog(uref, pts);
         pts += (i ? 3 : 4) * UCLOCK_FREQ;
         upipe_input(upipe_audio_copy, uref, NULL);
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the native loudness pipe
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_ubuf_mem.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_sound.h"
+#include "upipe/uref_sound_flow.h"
+#include "upipe/upipe.h"
+#include "upipe/ubuf_sound_mem.h"
+#include "upipe-filters/upipe_audio_loudness.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    5
+#define UREF_POOL_DEPTH     5
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL    UPROBE_LOG_DEBUG
+#define RATE                48000
+#define SAMPLES             1024
+#define DURATION            10
+#define FREQUENCY           997.
+#define LOUDNESS            -23.
+#define QUIET               -33.
+
+static unsigned int nb_urefs = 0;
+static uint8_t nb_programs = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    upipe_throw_ready(upipe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    double value;
+    for (uint8_t i = 0; i < nb_programs; i++) {
+        ubase_assert(uref_aloud_get_momentary(uref, &value, i));
+        ubase_assert(uref_aloud_get_short_term(uref, &value, i));
+        ubase_assert(uref_aloud_get_lra(uref, &value, i));
+        ubase_assert(uref_aloud_get_global(uref, &value, i));
+    }
+    ubase_nassert(uref_aloud_get_global(uref, &value, nb_programs));
+    nb_urefs++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_throw_dead(upipe);
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** returns a sample of a sine at the given loudness */
+static double sine(uint64_t sample, double loudness)
+{
+    return pow(10., loudness / 20.) *
+           sin(2. * M_PI * FREQUENCY * sample / RATE);
+}
+
+/** checks the loudness of a program */
+static void check(struct upipe *upipe, uint8_t program, double loudness)
+{
+    double momentary, short_term, lra, global;
+    ubase_assert(upipe_aloud_get_loudness(upipe, program, &momentary,
+                                          &short_term, &lra, &global));
+    printf("program %"PRIu8": M %f S %f LRA %f I %f\n", program,
+           momentary, short_term, lra, global);
+    assert(fabs(momentary - loudness) < .1);
+    assert(fabs(short_term - loudness) < .1);
+    assert(fabs(global - loudness) < .1);
+    assert(lra < .5);
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+
+    struct ubuf_mgr *planar_mgr = ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, sizeof(float), 0);
+    assert(planar_mgr != NULL);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(planar_mgr, "l"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(planar_mgr, "r"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(planar_mgr, "L"));
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(planar_mgr, "R"));
+    struct ubuf_mgr *packed_mgr = ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 2 * sizeof(int16_t), 0);
+    assert(packed_mgr != NULL);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(packed_mgr, "lr"));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    struct upipe *test = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "test"));
+    assert(test != NULL);
+
+    struct upipe_mgr *upipe_aloud_mgr = upipe_aloud_mgr_alloc();
+    assert(upipe_aloud_mgr != NULL);
+
+    /* two planar stereo programs */
+    struct upipe *aloud = upipe_void_alloc(upipe_aloud_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "planar"));
+    assert(aloud != NULL);
+    ubase_assert(upipe_set_output(aloud, test));
+    struct uref *flow_def =
+        uref_sound_flow_alloc_def(uref_mgr, "f32.", 4, sizeof(float));
+    assert(flow_def != NULL);
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "l"));
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "r"));
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "L"));
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "R"));
+    ubase_assert(uref_sound_flow_set_rate(flow_def, RATE));
+    ubase_assert(upipe_set_flow_def(aloud, flow_def));
+    uref_free(flow_def);
+    ubase_nassert(upipe_aloud_set_program_channels(aloud, 3));
+    ubase_assert(upipe_aloud_set_program_channels(aloud, 2));
+    nb_programs = 2;
+
+    uint64_t sample = 0;
+    while (sample < DURATION * RATE) {
+        struct uref *uref = uref_sound_alloc(uref_mgr, planar_mgr, SAMPLES);
+        assert(uref != NULL);
+        float *buffers[4];
+        ubase_assert(uref_sound_write_float(uref, 0, -1, buffers, 4));
+        for (int i = 0; i < SAMPLES; i++) {
+            buffers[0][i] = buffers[1][i] = sine(sample + i, LOUDNESS);
+            buffers[2][i] = buffers[3][i] = sine(sample + i, QUIET);
+        }
+        ubase_assert(uref_sound_unmap(uref, 0, -1, 4));
+        sample += SAMPLES;
+        upipe_input(aloud, uref, NULL);
+    }
+    assert(nb_urefs == (DURATION * RATE + SAMPLES - 1) / SAMPLES);
+    check(aloud, 0, LOUDNESS);
+    check(aloud, 1, QUIET);
+    ubase_nassert(upipe_aloud_get_loudness(aloud, 2, NULL, NULL, NULL, NULL));
+    upipe_release(aloud);
+
+    /* one packed stereo program */
+    aloud = upipe_void_alloc(upipe_aloud_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "packed"));
+    assert(aloud != NULL);
+    ubase_assert(upipe_set_output(aloud, test));
+    flow_def = uref_sound_flow_alloc_def(uref_mgr, "s16.", 2,
+                                         2 * sizeof(int16_t));
+    assert(flow_def != NULL);
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "lr"));
+    ubase_assert(uref_sound_flow_set_rate(flow_def, RATE));
+    ubase_assert(upipe_set_flow_def(aloud, flow_def));
+    uref_free(flow_def);
+    nb_programs = 1;
+
+    sample = 0;
+    while (sample < DURATION * RATE) {
+        struct uref *uref = uref_sound_alloc(uref_mgr, packed_mgr, SAMPLES);
+        assert(uref != NULL);
+        int16_t *buffer;
+        ubase_assert(uref_sound_plane_write_int16_t(uref, "lr", 0, -1,
+                                                    &buffer));
+        for (int i = 0; i < SAMPLES; i++)
+            buffer[2 * i] = buffer[2 * i + 1] =
+                lrint(sine(sample + i, LOUDNESS) * INT16_MAX);
+        ubase_assert(uref_sound_plane_unmap(uref, "lr", 0, -1));
+        sample += SAMPLES;
+        upipe_input(aloud, uref, NULL);
+    }
+    check(aloud, 0, LOUDNESS);
+    upipe_release(aloud);
+
+    test_free(test);
+    upipe_mgr_release(upipe_aloud_mgr); // no-op
+    ubuf_mgr_release(planar_mgr);
+    ubuf_mgr_release(packed_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
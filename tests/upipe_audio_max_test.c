@@ -55,6 +55,7 @@
 #define ALIGN               0
 
 static bool got_urequest = false;
+static bool check_stats = false;
 static bool got_input = false;
 
 /** definition of our uprobe */
@@ -95,6 +96,13 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(amplitude == (SAMPLES - 1) * 1. / INT16_MAX);
     ubase_assert(uref_amax_get_amplitude(uref, &amplitude, 1));
     assert(amplitude == (SAMPLES * 2 - 1) * 1. / INT16_MAX);
+    if (check_stats) {
+        double rms, true_peak;
+        ubase_assert(uref_amax_get_rms(uref, &rms, 0));
+        assert(rms > 0. && rms < amplitude);
+        ubase_assert(uref_amax_get_true_peak(uref, &true_peak, 1));
+        assert(true_peak >= amplitude);
+    }
 
     uref_free(uref);
     got_input = true;
@@ -139,9 +147,8 @@ static int provide_urequest(struct urequest *urequest, va_list args)
     assert(channels == 2);
     uint8_t planes;
     ubase_assert(uref_sound_flow_get_planes(flow_format, &planes));
-    assert(planes == 2);
-    ubase_assert(uref_sound_flow_check_channel(flow_format, "l"));
-    ubase_assert(uref_sound_flow_check_channel(flow_format, "r"));
+    assert(planes == 1);
+    ubase_assert(uref_sound_flow_check_channel(flow_format, "lr"));
     got_urequest = true;
     uref_free(flow_format);
     return UBASE_ERR_NONE;
@@ -233,6 +240,34 @@ int main(int argc, char **argv)
     upipe_input(amax, uref, NULL);
     assert(got_input);
 
+    /* interleaved input, with RMS and true-peak */
+    ubase_assert(upipe_amax_set_rms(amax, true));
+    ubase_assert(upipe_amax_set_true_peak(amax, true));
+    check_stats = true;
+    flow_def = uref_sound_flow_alloc_def(uref_mgr, "s16.", 2, 2 * 2);
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "lr"));
+    ubase_assert(upipe_set_flow_def(amax, flow_def));
+    uref_free(flow_def);
+
+    struct ubuf_mgr *interleaved_mgr =
+        ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH, umem_mgr,
+                                 2 * 2, ALIGN);
+    assert(interleaved_mgr);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(interleaved_mgr, "lr"));
+    uref = uref_sound_alloc(uref_mgr, interleaved_mgr, SAMPLES);
+    assert(uref != NULL);
+    int16_t *buffer;
+    ubase_assert(uref_sound_plane_write_int16_t(uref, "lr", 0, -1, &buffer));
+    for (int x = 0; x < SAMPLES; x++) {
+        buffer[2 * x] = x;
+        buffer[2 * x + 1] = SAMPLES + x;
+    }
+    ubase_assert(uref_sound_plane_unmap(uref, "lr", 0, -1));
+    got_input = false;
+    upipe_input(amax, uref, NULL);
+    assert(got_input);
+    ubuf_mgr_release(interleaved_mgr);
+
     /* release pipe */
     upipe_release(amax);
     test_free(test);
@@ -246,6 +246,9 @@ static void *thread_start(void *_thread)
     thread->avcenc = build_pipeline("mpeg2video.pic.", upump_mgr, thread->num,
                                     flow);
     uref_free(flow);
+    if (thread->num % 2)
+        /* encode from a dedicated thread */
+        ubase_assert(upipe_avcenc_set_async(thread->avcenc, 4));
     thread->limit = FRAMES_LIMIT;
 
     struct upump *source = upump_alloc_idler(upump_mgr, source_idler, thread,
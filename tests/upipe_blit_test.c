@@ -54,6 +54,17 @@
 #define BGSIZE              (2 * SUBSIZE)
 #define UPROBE_LOG_LEVEL UPROBE_LOG_VERBOSE
 
+/** expected values of the four quadrants of the output pictures */
+static const uint8_t quadrants[][4] = {
+    { 0, 0, 0, 0 },
+    { 1, 2, 3, 0 },
+    { 1, 2, 3, 0 },
+    { 4, 2, 3, 0 },
+    { 4, 0, 3, 0 },
+};
+/** luma buffer of the last output picture */
+static const uint8_t *last_buffer = NULL;
+
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
                  int event, va_list args)
@@ -196,38 +207,25 @@ static void test_input(struct upipe *upipe, struct uref *uref,
 
     uint64_t priv;
     ubase_assert(uref_attr_get_priv(uref, &priv));
-    switch (priv) {
-        case 0:
-            check_chroma(uref, "y8", 0);
-            check_chroma(uref, "u8", 0);
-            check_chroma(uref, "v8", 0);
-            break;
-        case 1:
-            uref_pic_resize(uref, 0, 0, SUBSIZE, SUBSIZE);
-            check_chroma(uref, "y8", 1);
-            check_chroma(uref, "u8", 1);
-            check_chroma(uref, "v8", 1);
-            uref_pic_resize(uref, 0, 0, BGSIZE, BGSIZE);
-
-            uref_pic_resize(uref, SUBSIZE, 0, SUBSIZE, SUBSIZE);
-            check_chroma(uref, "y8", 2);
-            check_chroma(uref, "u8", 2);
-            check_chroma(uref, "v8", 2);
-            uref_pic_resize(uref, -SUBSIZE, 0, BGSIZE, BGSIZE);
-
-            uref_pic_resize(uref, 0, SUBSIZE, SUBSIZE, SUBSIZE);
-            check_chroma(uref, "y8", 3);
-            check_chroma(uref, "u8", 3);
-            check_chroma(uref, "v8", 3);
-            uref_pic_resize(uref, 0, -SUBSIZE, BGSIZE, BGSIZE);
-
-            uref_pic_resize(uref, SUBSIZE, SUBSIZE, SUBSIZE, SUBSIZE);
-            check_chroma(uref, "y8", 0);
-            check_chroma(uref, "u8", 0);
-            check_chroma(uref, "v8", 0);
-            break;
+    assert(priv < sizeof (quadrants) / sizeof (quadrants[0]));
+    for (int i = 0; i < 4; i++) {
+        int hoffset = (i % 2) * SUBSIZE;
+        int voffset = (i / 2) * SUBSIZE;
+        uref_pic_resize(uref, hoffset, voffset, SUBSIZE, SUBSIZE);
+        check_chroma(uref, "y8", quadrants[priv][i]);
+        check_chroma(uref, "u8", quadrants[priv][i]);
+        check_chroma(uref, "v8", quadrants[priv][i]);
+        uref_pic_resize(uref, -hoffset, -voffset, BGSIZE, BGSIZE);
     }
 
+    /* unchanged backgrounds are composed in place */
+    const uint8_t *buffer;
+    ubase_assert(uref_pic_plane_read(uref, "y8", 0, 0, -1, -1, &buffer));
+    uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1);
+    if (priv >= 2)
+        assert(buffer == last_buffer);
+    last_buffer = buffer;
+
     uref_free(uref);
 }
 
@@ -365,12 +363,42 @@ int main(int argc, char **argv)
     fill_in(uref, "u8", 0);
     fill_in(uref, "v8", 0);
     uref_attr_set_priv(uref, 1);
+    struct uref *background = uref_dup(uref);
+    assert(background != NULL);
     upipe_input(blit, uref, NULL);
     ubase_assert(upipe_blit_prepare(blit, NULL));
 
+    /* nothing changed */
+    uref = uref_dup(background);
+    assert(uref != NULL);
+    uref_attr_set_priv(uref, 2);
+    upipe_input(blit, uref, NULL);
+    ubase_assert(upipe_blit_prepare(blit, NULL));
+
+    /* one subpicture changed */
+    uref = uref_pic_alloc(uref_mgr, pic_mgr, SUBSIZE, SUBSIZE);
+    assert(uref != NULL);
+    fill_in(uref, "y8", 4);
+    fill_in(uref, "u8", 4);
+    fill_in(uref, "v8", 4);
+    upipe_input(subpipe1, uref, NULL);
+    uref = uref_dup(background);
+    assert(uref != NULL);
+    uref_attr_set_priv(uref, 3);
+    upipe_input(blit, uref, NULL);
+    ubase_assert(upipe_blit_prepare(blit, NULL));
+
+    /* one subpicture removed */
+    upipe_release(subpipe2);
+    uref = uref_dup(background);
+    assert(uref != NULL);
+    uref_attr_set_priv(uref, 4);
+    upipe_input(blit, uref, NULL);
+    ubase_assert(upipe_blit_prepare(blit, NULL));
+    uref_free(background);
+
     /* release blit pipe and subpipes */
     upipe_release(subpipe1);
-    upipe_release(subpipe2);
     upipe_release(subpipe3);
     upipe_release(blit);
     test_free(test);
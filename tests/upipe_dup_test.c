@@ -42,9 +42,12 @@
 #include "upipe/uref_block_flow.h"
 #include "upipe/uref_dump.h"
 #include "upipe/upipe.h"
+#include "upipe/upipe_stats.h"
 #include "upipe-modules/upipe_dup.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include <assert.h>
 
 #define UDICT_POOL_DEPTH 0
@@ -54,6 +57,11 @@
 static int counter = 0;
 static int flow_foo_counter = 0;
 static int flow_bar_counter = 0;
+static int trace_counter = 0;
+/** uref expected by the sinks when the original is passed through */
+static struct uref *original_uref = NULL;
+/** true if the last uref received by a sink was the original */
+static bool got_original = false;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -68,6 +76,24 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
         case UPROBE_NEW_FLOW_DEF:
         case UPROBE_SOURCE_END:
             break;
+        case UPROBE_TRACE: {
+            struct uref *uref = va_arg(args, struct uref *);
+            const uint8_t *trace;
+            size_t size, offset = 0, stage_len;
+            const char *stage;
+            uint64_t date;
+            ubase_assert(uref_stats_get_trace(uref, &trace, &size));
+            assert(upipe_stats_trace_iterate(trace, size, &offset,
+                                             &stage, &stage_len, &date));
+            assert(stage_len == 3 && !strncmp(stage, "dup", 3));
+            assert(upipe_stats_trace_iterate(trace, size, &offset,
+                                             &stage, &stage_len, &date));
+            assert(stage_len == 4 && !strncmp(stage, "sink", 4));
+            assert(!upipe_stats_trace_iterate(trace, size, &offset,
+                                              &stage, &stage_len, &date));
+            trace_counter++;
+            break;
+        }
     }
     return UBASE_ERR_NONE;
 }
@@ -88,6 +114,7 @@ static void test_input(struct upipe *upipe, struct uref *uref,
 {
     assert(uref != NULL);
     counter++;
+    got_original = uref == original_uref;
     uref_free(uref);
 }
 
@@ -163,6 +190,11 @@ int main(int argc, char *argv[])
     ubase_assert(upipe_set_flow_def(upipe_dup, uref));
     uref_free(uref);
 
+    struct upipe_stats stats;
+    ubase_nassert(upipe_get_stats(upipe_dup, &stats));
+    ubase_assert(upipe_stats_enable(upipe_dup, 0));
+    ubase_assert(upipe_stats_enable(upipe_sink0, 0));
+
     struct upipe *upipe_dup_output0 = upipe_void_alloc_sub(upipe_dup,
             uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
                              "dup output 0"));
@@ -171,8 +203,12 @@ int main(int argc, char *argv[])
 
     uref = uref_alloc(uref_mgr);
     assert(uref != NULL);
+    original_uref = uref;
     upipe_input(upipe_dup, uref, NULL);
     assert(counter == 1);
+    /* a single output receives the original uref */
+    assert(got_original);
+    original_uref = NULL;
     counter = 0;
 
     struct upipe *upipe_dup_output1 = upipe_void_alloc_sub(upipe_dup,
@@ -194,6 +230,25 @@ int main(int argc, char *argv[])
     assert(flow_foo_counter == 1);
     assert(flow_bar_counter == 2);
 
+    ubase_assert(upipe_get_stats(upipe_dup, &stats));
+    assert(stats.urefs == 2);
+    assert(stats.octets == 0);
+    assert(stats.children_time <= stats.time);
+    assert(stats.max_time <= stats.time);
+    assert(stats.queue_length == UINT64_MAX);
+    ubase_assert(upipe_stats_collect(upipe_sink0, &stats));
+    assert(stats.urefs == 2);
+    assert(stats.children_time == 0);
+
+    ubase_assert(upipe_stats_trace(upipe_dup, "dup", 1, false));
+    ubase_assert(upipe_stats_trace(upipe_sink0, "sink", 0, true));
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    upipe_input(upipe_dup, uref, NULL);
+    assert(trace_counter == 1);
+    upipe_stats_disable(upipe_dup);
+    ubase_nassert(upipe_get_stats(upipe_dup, &stats));
+
     upipe_release(upipe_dup);
     upipe_release(upipe_dup_output0);
     upipe_release(upipe_dup_output1);
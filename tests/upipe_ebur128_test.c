@@ -132,6 +132,12 @@ int main(int argc, char **argv)
 
     uref_free(flow);
 
+    /* momentary loudness every second, the others only on query */
+    ubase_assert(upipe_ebur128_set_intervals(r128, UCLOCK_FREQ,
+                                             UPIPE_EBUR128_ON_QUERY,
+                                             UPIPE_EBUR128_ON_QUERY));
+    ubase_nassert(upipe_ebur128_set_program_channels(r128, CHANNELS + 1));
+
     printf("packets duration : %"PRIu64"\n", DURATION);
 
     /* now send reference urefs */
@@ -164,6 +170,12 @@ int main(int argc, char **argv)
         upipe_input(r128, uref, NULL);
     }
 
+    double momentary, lra, global;
+    ubase_assert(upipe_ebur128_get_loudness(r128, 0, &momentary, &lra,
+                                            &global));
+    ubase_nassert(upipe_ebur128_get_loudness(r128, 1, &momentary, NULL,
+                                             NULL));
+
     /* release pipe */
     upipe_release(r128);
 
@@ -62,12 +62,14 @@
 #define UPUMP_POOL 0
 #define UPUMP_BLOCKER_POOL 0
 #define READ_SIZE 4096
+#define READAHEAD_SIZE 65536
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-d <delay>] [-a|-o] <source file> <sink file>\n", argv0);
+    fprintf(stdout, "Usage: %s [-d <delay>] [-a|-o] [-m] <source file> <sink file>\n", argv0);
     fprintf(stdout, "-a : append\n");
     fprintf(stdout, "-o : overwrite\n");
+    fprintf(stdout, "-m : memory-mapped source\n");
     exit(EXIT_FAILURE);
 }
 
@@ -93,8 +95,9 @@ int main(int argc, char *argv[])
     const char *src_file, *sink_file;
     int64_t delay = 0;
     enum upipe_fsink_mode mode = UPIPE_FSINK_CREATE;
+    bool mmap = false;
     int opt;
-    while ((opt = getopt(argc, argv, "d:ao")) != -1) {
+    while ((opt = getopt(argc, argv, "d:aom")) != -1) {
         switch (opt) {
             case 'd':
                 delay = atoi(optarg);
@@ -105,6 +108,9 @@ int main(int argc, char *argv[])
             case 'o':
                 mode = UPIPE_FSINK_OVERWRITE;
                 break;
+            case 'm':
+                mmap = true;
+                break;
             default:
                 usage(argv[0]);
         }
@@ -151,6 +157,8 @@ int main(int argc, char *argv[])
                              UPROBE_LOG_LEVEL, "file source"));
     assert(upipe_fsrc != NULL);
     ubase_assert(upipe_set_output_size(upipe_fsrc, READ_SIZE));
+    if (mmap)
+        ubase_assert(upipe_fsrc_set_mmap(upipe_fsrc, true, READAHEAD_SIZE));
     ubase_assert(upipe_set_uri(upipe_fsrc, src_file));
     uint64_t size;
     if (ubase_check(upipe_src_get_size(upipe_fsrc, &size)))
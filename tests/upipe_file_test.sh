@@ -10,3 +10,5 @@ trap cleanup EXIT
 
 "$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test Makefile "$TMP"/test
 cmp --quiet "$TMP"/test Makefile
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_file_test -m Makefile "$TMP"/test_mmap
+cmp --quiet "$TMP"/test_mmap Makefile
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for fused pipes
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uref.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+#include "upipe-modules/upipe_noclock.h"
+#include "upipe-modules/upipe_setrap.h"
+#include "upipe-modules/upipe_setflowdef.h"
+#include "upipe-modules/upipe_fused.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+static unsigned int nb_packets = 0;
+static unsigned int nb_flow_defs = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_LOG:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    uint64_t date;
+    ubase_assert(uref_clock_get_cr_sys(uref, &date));
+    assert(date == 2 * (uint64_t)UINT32_MAX);
+    ubase_assert(uref_clock_get_rap_sys(uref, &date));
+    assert(date == UINT32_MAX);
+    uref_free(uref);
+    nb_packets++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, "internal."));
+            uint64_t id;
+            ubase_assert(uref_flow_get_id(flow_def, &id));
+            assert(id == 42);
+            nb_flow_defs++;
+            return UBASE_ERR_NONE;
+        }
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(uprobe_stdio));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_noclock_mgr = upipe_noclock_mgr_alloc();
+    assert(upipe_noclock_mgr != NULL);
+    struct upipe *upipe_noclock = upipe_void_alloc(upipe_noclock_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "noclock"));
+    assert(upipe_noclock != NULL);
+
+    struct upipe_mgr *upipe_setrap_mgr = upipe_setrap_mgr_alloc();
+    assert(upipe_setrap_mgr != NULL);
+    struct upipe *upipe_setrap = upipe_void_alloc(upipe_setrap_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "setrap"));
+    assert(upipe_setrap != NULL);
+    ubase_assert(upipe_setrap_set_rap(upipe_setrap, UINT32_MAX));
+
+    struct upipe_mgr *upipe_setflowdef_mgr = upipe_setflowdef_mgr_alloc();
+    assert(upipe_setflowdef_mgr != NULL);
+    struct upipe *upipe_setflowdef = upipe_void_alloc(upipe_setflowdef_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "setflowdef"));
+    assert(upipe_setflowdef != NULL);
+    struct uref *uref = uref_alloc_control(uref_mgr);
+    assert(uref != NULL);
+    ubase_assert(uref_flow_set_id(uref, 42));
+    ubase_assert(upipe_setflowdef_set_dict(upipe_setflowdef, uref));
+    uref_free(uref);
+
+    struct upipe_mgr *upipe_fused_mgr = upipe_fused_mgr_alloc();
+    assert(upipe_fused_mgr != NULL);
+    struct upipe *upipe_fused = upipe_void_alloc(upipe_fused_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "fused"));
+    assert(upipe_fused != NULL);
+    ubase_assert(upipe_fused_add_stage(upipe_fused, upipe_noclock));
+    ubase_assert(upipe_fused_add_stage(upipe_fused, upipe_setrap));
+
+    /* pipes without an in-place process function are refused */
+    ubase_nassert(upipe_fused_add_stage(upipe_fused, upipe_fused));
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    ubase_assert(uref_flow_set_def(uref, "internal."));
+    ubase_assert(upipe_set_flow_def(upipe_fused, uref));
+    uref_free(uref);
+    ubase_assert(upipe_set_output(upipe_fused, upipe_sink));
+    assert(nb_flow_defs == 0);
+
+    /* adding a stage rebuilds the output flow definition */
+    ubase_assert(upipe_fused_add_stage(upipe_fused, upipe_setflowdef));
+    assert(nb_flow_defs == 0);
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_cr_prog(uref, 2 * (uint64_t)UINT32_MAX);
+    upipe_input(upipe_fused, uref, NULL);
+    assert(nb_flow_defs == 1);
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_cr_prog(uref, 2 * (uint64_t)UINT32_MAX);
+    upipe_input(upipe_fused, uref, NULL);
+
+    assert(nb_packets == 2);
+    assert(nb_flow_defs == 1);
+
+    /* stages are kept by the fused pipe */
+    upipe_release(upipe_noclock);
+    upipe_release(upipe_setrap);
+    upipe_release(upipe_setflowdef);
+    upipe_release(upipe_fused);
+    upipe_mgr_release(upipe_fused_mgr); // nop
+    upipe_mgr_release(upipe_setflowdef_mgr); // nop
+    upipe_mgr_release(upipe_setrap_mgr); // nop
+    upipe_mgr_release(upipe_noclock_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
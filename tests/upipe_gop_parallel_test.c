@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for gop parallel pipes
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ulist.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/upipe.h"
+#include "upipe-modules/upipe_gop_parallel.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define SEGMENT_SIZE 3
+#define NB_ENCODERS 2
+#define NB_PICTURES 14
+
+static uint64_t next_number = 0;
+static unsigned int nb_flow_defs = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony encoder, holding pictures until flushed */
+struct test_enc {
+    struct urefcount urefcount;
+    struct upipe *output;
+    struct uchain urefs;
+    struct upipe upipe;
+};
+
+/** helper phony encoder */
+static void test_enc_free(struct urefcount *urefcount)
+{
+    struct test_enc *enc = container_of(urefcount, struct test_enc,
+                                        urefcount);
+    /* no buffer must be lost */
+    assert(ulist_empty(&enc->urefs));
+    upipe_release(enc->output);
+    upipe_clean(&enc->upipe);
+    urefcount_clean(urefcount);
+    free(enc);
+}
+
+/** helper phony encoder */
+static struct upipe *test_enc_alloc(struct upipe_mgr *mgr,
+                                    struct uprobe *uprobe,
+                                    uint32_t signature, va_list args)
+{
+    struct test_enc *enc = malloc(sizeof(struct test_enc));
+    assert(enc != NULL);
+    upipe_init(&enc->upipe, mgr, uprobe);
+    urefcount_init(&enc->urefcount, test_enc_free);
+    enc->upipe.refcount = &enc->urefcount;
+    enc->output = NULL;
+    ulist_init(&enc->urefs);
+    return &enc->upipe;
+}
+
+/** helper phony encoder */
+static void test_enc_input(struct upipe *upipe, struct uref *uref,
+                           struct upump **upump_p)
+{
+    struct test_enc *enc = container_of(upipe, struct test_enc, upipe);
+    uint64_t number;
+    ubase_assert(uref_pic_get_number(uref, &number));
+    if (!(number % SEGMENT_SIZE))
+        ubase_assert(uref_pic_get_key(uref));
+    else
+        ubase_nassert(uref_pic_get_key(uref));
+    ulist_add(&enc->urefs, uref_to_uchain(uref));
+}
+
+/** helper phony encoder */
+static void test_enc_flush(struct upipe *upipe)
+{
+    struct test_enc *enc = container_of(upipe, struct test_enc, upipe);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&enc->urefs)) != NULL)
+        upipe_input(enc->output, uref_from_uchain(uchain), NULL);
+}
+
+/** helper phony encoder */
+static int test_enc_control(struct upipe *upipe, int command, va_list args)
+{
+    struct test_enc *enc = container_of(upipe, struct test_enc, upipe);
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF));
+            struct uref *flow_def_enc =
+                uref_block_flow_alloc_def(flow_def->mgr, "h264.pic.");
+            assert(flow_def_enc != NULL);
+            ubase_assert(upipe_set_flow_def(enc->output, flow_def_enc));
+            uref_free(flow_def_enc);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_OUTPUT: {
+            struct upipe *output = va_arg(args, struct upipe *);
+            upipe_release(enc->output);
+            enc->output = upipe_use(output);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony encoder */
+static struct upipe_mgr test_enc_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_enc_alloc,
+    .upipe_input = test_enc_input,
+    .upipe_control = test_enc_control
+};
+
+/** helper phony sink */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony sink, checking the output order */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    uint64_t number;
+    ubase_assert(uref_pic_get_number(uref, &number));
+    assert(number == next_number);
+    next_number++;
+    uref_free(uref);
+}
+
+/** helper phony sink */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, "block.h264."));
+            nb_flow_defs++;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony sink */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony sink */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_gopp_mgr = upipe_gopp_mgr_alloc();
+    assert(upipe_gopp_mgr != NULL);
+    struct upipe *upipe_gopp = upipe_void_alloc(upipe_gopp_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "gopp"));
+    assert(upipe_gopp != NULL);
+    ubase_assert(upipe_gopp_set_segment_size(upipe_gopp, SEGMENT_SIZE));
+    unsigned int segment_size;
+    ubase_assert(upipe_gopp_get_segment_size(upipe_gopp, &segment_size));
+    assert(segment_size == SEGMENT_SIZE);
+    ubase_assert(upipe_set_output(upipe_gopp, upipe_sink));
+
+    struct upipe *encoders[NB_ENCODERS];
+    for (int i = 0; i < NB_ENCODERS; i++) {
+        encoders[i] = upipe_void_alloc(&test_enc_mgr, uprobe_use(logger));
+        assert(encoders[i] != NULL);
+        ubase_assert(upipe_gopp_add_encoder(upipe_gopp, encoders[i]));
+    }
+
+    struct uref *uref = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_gopp, uref));
+    uref_free(uref);
+
+    for (uint64_t i = 0; i < NB_PICTURES; i++) {
+        uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        ubase_assert(uref_pic_set_number(uref, i));
+        upipe_input(upipe_gopp, uref, NULL);
+
+        /* the second encoder is faster than the first one */
+        if (i == 2 * SEGMENT_SIZE - 1) {
+            test_enc_flush(encoders[1]);
+            assert(next_number == 0);
+            test_enc_flush(encoders[0]);
+            assert(next_number == 2 * SEGMENT_SIZE);
+        }
+    }
+    ubase_nassert(upipe_gopp_add_encoder(upipe_gopp, encoders[0]));
+
+    test_enc_flush(encoders[1]);
+    assert(next_number == 2 * SEGMENT_SIZE);
+    test_enc_flush(encoders[0]);
+    assert(next_number == NB_PICTURES);
+    assert(nb_flow_defs == 1);
+
+    for (int i = 0; i < NB_ENCODERS; i++)
+        upipe_release(encoders[i]);
+    upipe_release(upipe_gopp);
+    upipe_mgr_release(upipe_gopp_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
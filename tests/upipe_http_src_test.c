@@ -80,12 +80,19 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 int main(int argc, char *argv[])
 {
     const char *url;
+    unsigned int parallel = 0;
+    uint64_t chunk_size = 0;
 
     if (argc < 2) {
-        fprintf(stdout, "Usage: %s <url>\n", argv[0]);
+        fprintf(stdout, "Usage: %s <url> [<parallel> <chunk size>]\n",
+                argv[0]);
         exit(EXIT_FAILURE);
     }
     url = argv[1];
+    if (argc >= 4) {
+        parallel = strtoul(argv[2], NULL, 10);
+        chunk_size = strtoull(argv[3], NULL, 10);
+    }
 
     struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
     assert(umem_mgr != NULL);
@@ -125,6 +132,9 @@ int main(int argc, char *argv[])
                              "http"));
     assert(upipe_http_src != NULL);
     assert(upipe_set_output_size(upipe_http_src, READ_SIZE));
+    if (parallel)
+        ubase_assert(upipe_http_src_set_parallel(upipe_http_src, parallel,
+                                                 chunk_size));
     assert(upipe_set_uri(upipe_http_src, url));
     assert(upipe_set_output(upipe_http_src, upipe_null));
     upipe_release(upipe_null);
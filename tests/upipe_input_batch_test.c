@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for batched uref input
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ulist.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define NB_UREFS 5
+
+static unsigned int nb_inputs = 0;
+static unsigned int nb_batches = 0;
+static unsigned int nb_urefs = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    nb_inputs++;
+    nb_urefs++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static void test_input_batch(struct upipe *upipe, struct uchain *urefs,
+                             struct upump **upump_p)
+{
+    nb_batches++;
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(urefs)) != NULL) {
+        nb_urefs++;
+        uref_free(uref_from_uchain(uchain));
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe without batch input */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = NULL
+};
+
+/** helper phony pipe with batch input */
+static struct upipe_mgr test_batch_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = NULL,
+    .upipe_input_batch = test_input_batch
+};
+
+/** fills a list with urefs */
+static void fill(struct uref_mgr *uref_mgr, struct uchain *urefs)
+{
+    for (int i = 0; i < NB_UREFS; i++) {
+        struct uref *uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        ulist_add(urefs, uref_to_uchain(uref));
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct uchain urefs;
+    ulist_init(&urefs);
+
+    /* pipes without batch input receive the urefs one by one */
+    struct upipe *upipe = upipe_void_alloc(&test_mgr, uprobe_use(logger));
+    assert(upipe != NULL);
+    fill(uref_mgr, &urefs);
+    upipe_input_batch(upipe, &urefs, NULL);
+    assert(ulist_empty(&urefs));
+    assert(nb_inputs == NB_UREFS);
+    assert(nb_batches == 0);
+    assert(nb_urefs == NB_UREFS);
+    test_free(upipe);
+
+    /* other pipes receive the whole list */
+    nb_inputs = nb_urefs = 0;
+    upipe = upipe_void_alloc(&test_batch_mgr, uprobe_use(logger));
+    assert(upipe != NULL);
+    fill(uref_mgr, &urefs);
+    upipe_input_batch(upipe, &urefs, NULL);
+    assert(ulist_empty(&urefs));
+    assert(nb_inputs == 0);
+    assert(nb_batches == 1);
+    assert(nb_urefs == NB_UREFS);
+
+    /* empty lists are not sent */
+    upipe_input_batch(upipe, &urefs, NULL);
+    assert(nb_batches == 1);
+    test_free(upipe);
+
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
@@ -82,6 +82,11 @@ static struct upump *idler;
 static uint64_t rotate = 0;
 static uint64_t rotate_offset = 0;
 static uint64_t gen_systime = 0;
+static bool async = false;
+static bool map = false;
+static const char *index_file = NULL;
+static const char *rap_file = NULL;
+static uint64_t msrc_systime = 0;
 
 static void sig_handler(int sig)
 {
@@ -90,7 +95,7 @@ static void sig_handler(int sig)
 }
 
 static void usage(const char *argv0) {
-    fprintf(stdout, "Usage: %s [-r <rotate> [-O <rotate offset>]] <dest dir> <suffix>\n", argv0);
+    fprintf(stdout, "Usage: %s [-a] [-m] [-i <index file>] [-k <RAP index file>] [-r <rotate> [-O <rotate offset>]] <dest dir> <suffix>\n", argv0);
     exit(EXIT_FAILURE);
 }
 
@@ -152,20 +157,19 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     upipe_dbg(upipe, "===> received input uref");
     uref_dump(uref, upipe->uprobe);
 
-    static uint64_t systime = 0;
     uint64_t cr_sys;
     uref_clock_get_cr_sys(uref, &cr_sys);
-    assert(cr_sys == systime);
+    assert(cr_sys == msrc_systime);
 
     int size = -1;
     const uint8_t *buf;
     ubase_assert(uref_block_read(uref, 0, &size, &buf));
     assert(size == sizeof(uint64_t));
     cr_sys = upipe_genaux_ntoh64(buf);
-    assert(cr_sys == systime);
+    assert(cr_sys == msrc_systime);
     ubase_assert(uref_block_unmap(uref, 0));
     uref_free(uref);
-    systime += rotate/UREF_PER_SLICE;
+    msrc_systime += rotate/UREF_PER_SLICE;
 }
 
 /** helper phony pipe */
@@ -212,8 +216,20 @@ int main(int argc, char *argv[])
 
     signal (SIGINT, sig_handler);
 
-    while ((opt = getopt(argc, argv, "r:O:")) != -1) {
+    while ((opt = getopt(argc, argv, "ami:k:r:O:")) != -1) {
         switch (opt) {
+            case 'a':
+                async = true;
+                break;
+            case 'm':
+                map = true;
+                break;
+            case 'i':
+                index_file = optarg;
+                break;
+            case 'k':
+                rap_file = optarg;
+                break;
             case 'r':
                 rotate = strtoull(optarg, NULL, 0);
                 break;
@@ -285,7 +301,15 @@ int main(int argc, char *argv[])
         upipe_multicat_sink_get_rotate(multicat_sink, &rotate, &rotate_offset);
     }
     ubase_assert(upipe_multicat_sink_set_mode(multicat_sink, UPIPE_FSINK_OVERWRITE));
+    if (async) {
+        ubase_assert(upipe_fsink_set_async(multicat_sink, 2, READ_SIZE, true));
+        ubase_assert(upipe_multicat_sink_set_preallocate(multicat_sink, true));
+    }
     ubase_assert(upipe_multicat_sink_set_path(multicat_sink, dirpath, suffix));
+    if (index_file != NULL) {
+        unlink(index_file);
+        ubase_assert(upipe_multicat_sink_set_index(multicat_sink, index_file));
+    }
 
     // idler - packet generator
     idler = upump_alloc_idler(upump_mgr, genpacket_idler, NULL, NULL);
@@ -317,6 +341,8 @@ int main(int argc, char *argv[])
             assert(val == systime);
             systime += rotate/UREF_PER_SLICE;
         }
+        uint8_t buf[8];
+        assert(read(fd, buf, sizeof(buf)) == 0);
         printf("Ok.\n");
         close(fd);
     }
@@ -335,17 +361,46 @@ int main(int argc, char *argv[])
     ubase_assert(uref_msrc_flow_set_aux(flow, suffix));
     ubase_assert(uref_msrc_flow_set_rotate(flow, rotate));
     ubase_assert(uref_msrc_flow_set_offset(flow, rotate_offset));
+    if (index_file != NULL)
+        ubase_assert(uref_msrc_flow_set_index(flow, index_file));
+
+    // fire ! reading starts from the last uref before the position
+    uint64_t position = rotate_offset + 3 * rotate + rotate / 2;
+    msrc_systime = position - rotate / UREF_PER_SLICE;
+
+    if (rap_file != NULL) {
+        /* one random access point at the start of each file, and one in the
+         * file containing the position */
+        uint64_t rap = rotate_offset + 3 * rotate +
+                       2 * rotate / UREF_PER_SLICE;
+        fd = open(rap_file, O_TRUNC|O_CREAT|O_WRONLY, 0644);
+        assert(fd != -1);
+        for (i = 0; i < SLICES_NUM; i++) {
+            uint8_t buf[8];
+            upipe_genaux_hton64(buf, rotate_offset + i * rotate);
+            assert(write(fd, buf, sizeof(buf)) == sizeof(buf));
+            if (i == 3) {
+                upipe_genaux_hton64(buf, rap);
+                assert(write(fd, buf, sizeof(buf)) == sizeof(buf));
+            }
+        }
+        close(fd);
+        ubase_assert(uref_msrc_flow_set_rap(flow, rap_file));
+        msrc_systime = rap - rotate / UREF_PER_SLICE;
+    }
     ubase_assert(upipe_set_flow_def(msrc, flow));
     uref_free(flow);
     ubase_assert(upipe_set_output_size(msrc, sizeof(uint64_t)));
+    if (map)
+        ubase_assert(upipe_msrc_set_mmap(msrc, true));
 
     struct upipe *test = upipe_void_alloc(&test_mgr, uprobe_use(logger));
     assert(test != NULL);
     ubase_assert(upipe_set_output(msrc, test));
 
-    // fire !
-    ubase_assert(upipe_src_set_position(msrc, 0));
+    ubase_assert(upipe_src_set_position(msrc, position));
     upump_mgr_run(upump_mgr, NULL);
+    assert(msrc_systime == SLICES_NUM * rotate + rotate_offset);
 
     // release everything
     upipe_release(msrc);
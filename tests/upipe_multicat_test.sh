@@ -9,3 +9,7 @@ cleanup() { rm -rf "$TMP"; }
 trap cleanup EXIT
 
 "$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_multicat_test -r 270000000 -O 135000000 "$TMP"/ .bar
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_multicat_test -a -r 270000000 -O 135000000 "$TMP"/ .baz
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_multicat_test -i "$TMP"/index -r 270000000 -O 135000000 "$TMP"/ .idx
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_multicat_test -k "$TMP"/rap -r 270000000 -O 135000000 "$TMP"/ .rap
+"$srcdir"/valgrind_wrapper.sh "$srcdir" ./upipe_multicat_test -m -r 270000000 -O 135000000 "$TMP"/ .map
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for parallel pipes
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ulist.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/upipe.h"
+#include "upipe-modules/upipe_parallel.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define NB_WORKERS 3
+#define NB_FRAMES 9
+#define DROPPED_FRAME 4
+
+static uint64_t next_number = 0;
+static unsigned int nb_frames = 0;
+static unsigned int nb_flow_defs = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony worker, holding frames until flushed */
+struct test_worker {
+    struct urefcount urefcount;
+    struct upipe *output;
+    struct uchain urefs;
+    unsigned int nb_urefs;
+    struct upipe upipe;
+};
+
+/** helper phony worker */
+static void test_worker_free(struct urefcount *urefcount)
+{
+    struct test_worker *worker = container_of(urefcount, struct test_worker,
+                                              urefcount);
+    assert(ulist_empty(&worker->urefs));
+    upipe_release(worker->output);
+    upipe_clean(&worker->upipe);
+    urefcount_clean(urefcount);
+    free(worker);
+}
+
+/** helper phony worker */
+static struct upipe *test_worker_alloc(struct upipe_mgr *mgr,
+                                       struct uprobe *uprobe,
+                                       uint32_t signature, va_list args)
+{
+    struct test_worker *worker = malloc(sizeof(struct test_worker));
+    assert(worker != NULL);
+    upipe_init(&worker->upipe, mgr, uprobe);
+    urefcount_init(&worker->urefcount, test_worker_free);
+    worker->upipe.refcount = &worker->urefcount;
+    worker->output = NULL;
+    ulist_init(&worker->urefs);
+    worker->nb_urefs = 0;
+    return &worker->upipe;
+}
+
+/** helper phony worker, dropping one frame */
+static void test_worker_input(struct upipe *upipe, struct uref *uref,
+                              struct upump **upump_p)
+{
+    struct test_worker *worker = container_of(upipe, struct test_worker,
+                                              upipe);
+    uint64_t number;
+    ubase_assert(uref_pic_get_number(uref, &number));
+    worker->nb_urefs++;
+    if (number == DROPPED_FRAME) {
+        uref_free(uref);
+        return;
+    }
+    ulist_add(&worker->urefs, uref_to_uchain(uref));
+}
+
+/** helper phony worker */
+static void test_worker_flush(struct upipe *upipe)
+{
+    struct test_worker *worker = container_of(upipe, struct test_worker,
+                                              upipe);
+    struct uchain *uchain;
+    while ((uchain = ulist_pop(&worker->urefs)) != NULL)
+        upipe_input(worker->output, uref_from_uchain(uchain), NULL);
+    worker->nb_urefs = 0;
+}
+
+/** helper phony worker */
+static int test_worker_control(struct upipe *upipe, int command, va_list args)
+{
+    struct test_worker *worker = container_of(upipe, struct test_worker,
+                                              upipe);
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF));
+            ubase_assert(upipe_set_flow_def(worker->output, flow_def));
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_OUTPUT: {
+            struct upipe *output = va_arg(args, struct upipe *);
+            upipe_release(worker->output);
+            worker->output = upipe_use(output);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony worker */
+static struct upipe_mgr test_worker_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_worker_alloc,
+    .upipe_input = test_worker_input,
+    .upipe_control = test_worker_control
+};
+
+/** helper phony sink */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony sink, checking the output order */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    uint64_t number;
+    ubase_assert(uref_pic_get_number(uref, &number));
+    if (next_number == DROPPED_FRAME)
+        next_number++;
+    assert(number == next_number);
+    next_number++;
+    nb_frames++;
+    uref_free(uref);
+}
+
+/** helper phony sink */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, UREF_PIC_FLOW_DEF));
+            nb_flow_defs++;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony sink */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony sink */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_par_mgr = upipe_par_mgr_alloc();
+    assert(upipe_par_mgr != NULL);
+    struct upipe *upipe_par = upipe_void_alloc(upipe_par_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL, "par"));
+    assert(upipe_par != NULL);
+    enum upipe_par_mode mode;
+    ubase_assert(upipe_par_get_mode(upipe_par, &mode));
+    assert(mode == UPIPE_PAR_ROUND_ROBIN);
+    ubase_assert(upipe_set_output(upipe_par, upipe_sink));
+
+    struct uref *uref = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_par, uref));
+    uref_free(uref);
+
+    struct upipe *workers[NB_WORKERS];
+    for (int i = 0; i < NB_WORKERS; i++) {
+        workers[i] = upipe_void_alloc(&test_worker_mgr, uprobe_use(logger));
+        assert(workers[i] != NULL);
+        ubase_assert(upipe_par_add_worker(upipe_par, workers[i]));
+    }
+
+    for (uint64_t i = 0; i < NB_FRAMES; i++) {
+        uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        ubase_assert(uref_pic_set_number(uref, i));
+        upipe_input(upipe_par, uref, NULL);
+    }
+    for (int i = 0; i < NB_WORKERS; i++)
+        assert(container_of(workers[i], struct test_worker,
+                            upipe)->nb_urefs == NB_FRAMES / NB_WORKERS);
+
+    /* the last workers are faster than the first one */
+    test_worker_flush(workers[2]);
+    test_worker_flush(workers[1]);
+    assert(nb_frames == 0);
+    test_worker_flush(workers[0]);
+    assert(nb_frames == NB_FRAMES - 1);
+    assert(next_number == NB_FRAMES);
+    assert(nb_flow_defs == 1);
+
+    /* least loaded mode */
+    ubase_assert(upipe_par_set_mode(upipe_par, UPIPE_PAR_LEAST_LOADED));
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    ubase_assert(uref_pic_set_number(uref, next_number));
+    upipe_input(upipe_par, uref, NULL);
+    for (int i = 1; i < NB_WORKERS; i++) {
+        uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        ubase_assert(uref_pic_set_number(uref, next_number + i));
+        upipe_input(upipe_par, uref, NULL);
+        assert(container_of(workers[i], struct test_worker,
+                            upipe)->nb_urefs == 1);
+    }
+    test_worker_flush(workers[1]);
+    test_worker_flush(workers[0]);
+    assert(nb_frames == NB_FRAMES + 1);
+    test_worker_flush(workers[2]);
+    assert(nb_frames == NB_FRAMES + 2);
+
+    for (int i = 0; i < NB_WORKERS; i++)
+        upipe_release(workers[i]);
+    upipe_release(upipe_par);
+    upipe_mgr_release(upipe_par_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
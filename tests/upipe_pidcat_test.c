@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for pidcat sink and source pipes (using upump_virtual)
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_uref_mgr.h"
+#include "upipe/uprobe_upump_mgr.h"
+#include "upipe/uprobe_ubuf_mem.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block_mem.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uclock.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upump-virtual/upump_virtual.h"
+#include "upipe-modules/upipe_pidcat_sink.h"
+#include "upipe-modules/upipe_pidcat_source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define TS_SIZE 188
+#define PACKETS_PER_UREF 7
+#define NB_UREFS 20
+
+static const unsigned int pids[] = { 0, 100, 200 };
+#define NB_PIDS (sizeof(pids) / sizeof(pids[0]))
+
+static struct uref_mgr *uref_mgr;
+static struct ubuf_mgr *ubuf_mgr;
+static unsigned int next_packet = 0;
+static int only_pid = -1;
+static unsigned int nb_output_urefs = 0;
+static unsigned int source_end = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_SOURCE_END:
+            source_end++;
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe checking the packets in the order of the capture */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size && !(size % TS_SIZE));
+    uint64_t cr_sys;
+    ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
+
+    for (size_t offset = 0; offset < size; offset += TS_SIZE) {
+        while (only_pid != -1 &&
+               pids[next_packet % NB_PIDS] != (unsigned int)only_pid)
+            next_packet++;
+
+        uint8_t ts[TS_SIZE];
+        ubase_assert(uref_block_extract(uref, offset, TS_SIZE, ts));
+        assert(ts[0] == 0x47);
+        assert((((ts[1] & 0x1f) << 8) | ts[2]) ==
+               pids[next_packet % NB_PIDS]);
+        assert(ts[4] == (next_packet & 0xff));
+        assert(ts[5] == (next_packet >> 8));
+        assert(cr_sys == (next_packet / PACKETS_PER_UREF) * UCLOCK_FREQ);
+        next_packet++;
+    }
+    nb_output_urefs++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr pidcat_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** writes urefs of interleaved packets to a pidcat sink */
+static void capture(struct upipe *sink, unsigned int first_uref,
+                    unsigned int nb_urefs)
+{
+    for (unsigned int i = first_uref; i < first_uref + nb_urefs; i++) {
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                             PACKETS_PER_UREF * TS_SIZE);
+        assert(uref != NULL);
+        uint8_t *buffer;
+        int size = -1;
+        ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+        for (unsigned int j = 0; j < PACKETS_PER_UREF; j++) {
+            unsigned int packet = i * PACKETS_PER_UREF + j;
+            uint8_t *ts = buffer + j * TS_SIZE;
+            memset(ts, 0xff, TS_SIZE);
+            ts[0] = 0x47;
+            ts[1] = pids[packet % NB_PIDS] >> 8;
+            ts[2] = pids[packet % NB_PIDS] & 0xff;
+            ts[3] = 0x10;
+            ts[4] = packet & 0xff;
+            ts[5] = packet >> 8;
+        }
+        uref_block_unmap(uref, 0);
+        uref_clock_set_cr_sys(uref, i * UCLOCK_FREQ);
+        upipe_input(sink, uref, NULL);
+    }
+}
+
+/** reads a capture with a pidcat source */
+static void replay(struct upump_mgr *upump_mgr, struct uprobe *logger,
+                   const char *path, int pid, uint64_t position)
+{
+    struct upipe *sink = upipe_void_alloc(&pidcat_test_mgr,
+                                          uprobe_use(logger));
+    assert(sink != NULL);
+    struct upipe_mgr *upipe_pidcat_src_mgr = upipe_pidcat_src_mgr_alloc();
+    assert(upipe_pidcat_src_mgr != NULL);
+    struct upipe *pidcat_src = upipe_void_alloc(upipe_pidcat_src_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "pidcat src"));
+    assert(pidcat_src != NULL);
+    ubase_assert(upipe_set_output(pidcat_src, sink));
+    if (pid != -1)
+        ubase_assert(upipe_pidcat_src_add_pid(pidcat_src, pid));
+    ubase_assert(upipe_set_uri(pidcat_src, path));
+    if (position) {
+        ubase_assert(upipe_src_set_position(pidcat_src, position));
+        uint64_t next;
+        ubase_assert(upipe_src_get_position(pidcat_src, &next));
+        assert(next == position);
+    }
+
+    only_pid = pid;
+    next_packet = position / UCLOCK_FREQ * PACKETS_PER_UREF;
+    nb_output_urefs = 0;
+    source_end = 0;
+    upump_mgr_run(upump_mgr, NULL);
+    assert(source_end == 1);
+
+    upipe_release(pidcat_src);
+    upipe_mgr_release(upipe_pidcat_src_mgr); // nop
+    test_free(sink);
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                        umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct upump_mgr *upump_mgr = upump_virtual_mgr_alloc(UPUMP_POOL,
+                                                          UPUMP_BLOCKER_POOL,
+                                                          0);
+    assert(upump_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    char tmpdir[] = "/tmp/upipe_pidcat_test.XXXXXX";
+    assert(mkdtemp(tmpdir) != NULL);
+    char path[sizeof(tmpdir) + 16];
+    snprintf(path, sizeof(path), "%s/capture", tmpdir);
+
+    /* capture, in two sessions appended to each other */
+    struct upipe_mgr *upipe_pidcat_sink_mgr = upipe_pidcat_sink_mgr_alloc();
+    assert(upipe_pidcat_sink_mgr != NULL);
+    for (unsigned int session = 0; session < 2; session++) {
+        struct upipe *pidcat_sink = upipe_void_alloc(upipe_pidcat_sink_mgr,
+                uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                 "pidcat sink"));
+        assert(pidcat_sink != NULL);
+        struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr,
+                                                          "mpegts.");
+        assert(flow_def != NULL);
+        ubase_assert(upipe_set_flow_def(pidcat_sink, flow_def));
+        uref_free(flow_def);
+        ubase_assert(upipe_set_uri(pidcat_sink, path));
+        capture(pidcat_sink, session * NB_UREFS / 2, NB_UREFS / 2);
+        upipe_release(pidcat_sink);
+    }
+    upipe_mgr_release(upipe_pidcat_sink_mgr); // nop
+
+    /* whole multiplex */
+    replay(upump_mgr, logger, path, -1, 0);
+    assert(next_packet == NB_UREFS * PACKETS_PER_UREF);
+    assert(nb_output_urefs == NB_UREFS);
+
+    /* a single PID */
+    replay(upump_mgr, logger, path, pids[1], 0);
+    /* the last packet of the capture belongs to this PID */
+    assert(next_packet == NB_UREFS * PACKETS_PER_UREF);
+
+    /* from a given date */
+    replay(upump_mgr, logger, path, -1, 5 * UCLOCK_FREQ);
+    assert(next_packet == NB_UREFS * PACKETS_PER_UREF);
+    assert(nb_output_urefs == NB_UREFS - 5);
+
+    for (unsigned int i = 0; i < NB_PIDS; i++) {
+        char file[sizeof(path) + 16];
+        snprintf(file, sizeof(file), "%s/%u" UPIPE_PIDCAT_DATA_SUFFIX,
+                 path, pids[i]);
+        assert(!unlink(file));
+        snprintf(file, sizeof(file), "%s/%u" UPIPE_PIDCAT_INDEX_SUFFIX,
+                 path, pids[i]);
+        assert(!unlink(file));
+    }
+    assert(!rmdir(path));
+    assert(!rmdir(tmpdir));
+
+    upump_mgr_release(upump_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
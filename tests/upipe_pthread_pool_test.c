@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for upipe_pthread_pool (using upump_ev)
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/ubase.h"
+#include "upipe/uatomic.h"
+#include "upipe/urefcount.h"
+#include "upipe/upump.h"
+#include "upump-ev/upump_ev.h"
+#include "upipe-modules/upipe_transfer.h"
+#include "upipe-pthread/uprobe_pthread_upump_mgr.h"
+#include "upipe-pthread/upipe_pthread_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+#define XFER_QUEUE 255
+#define XFER_POOL 1
+#define NB_THREADS 4
+#define NB_PIPELINES 12
+
+/** index (starting at 1) of the pool thread running the current code */
+static pthread_key_t thread_key;
+static uatomic_uint32_t nb_loops;
+static uatomic_uint32_t nb_exited;
+static uatomic_uint32_t nb_freed;
+static uatomic_uint32_t dispatched[NB_THREADS];
+
+/** called when a pool thread exits */
+static void thread_exit(void *index)
+{
+    uatomic_fetch_add(&nb_exited, 1);
+}
+
+/** upump manager allocator, run in each pool thread */
+static struct upump_mgr *test_upump_mgr_alloc(uint16_t upump_pool_depth,
+                                              uint16_t upump_blocker_pool_depth)
+{
+    uint32_t index = uatomic_fetch_add(&nb_loops, 1);
+    assert(index < NB_THREADS);
+    assert(!pthread_setspecific(thread_key, (void *)(uintptr_t)(index + 1)));
+    return upump_ev_mgr_alloc_loop(upump_pool_depth,
+                                   upump_blocker_pool_depth);
+}
+
+/** returns the index of the pool thread running the current code */
+static unsigned int thread_index(void)
+{
+    uintptr_t index = (uintptr_t)pthread_getspecific(thread_key);
+    assert(index > 0 && index <= NB_THREADS);
+    return index - 1;
+}
+
+/** helper phony pipe */
+struct test_pipe {
+    struct urefcount urefcount;
+    struct upipe upipe;
+    /** index of the thread the pipe was attached to */
+    unsigned int thread;
+};
+
+/** helper phony pipe */
+static void test_free(struct urefcount *urefcount)
+{
+    struct test_pipe *test_pipe =
+        container_of(urefcount, struct test_pipe, urefcount);
+    /* the pipe is released on the thread it was transferred to */
+    assert(thread_index() == test_pipe->thread);
+    uatomic_fetch_add(&nb_freed, 1);
+    urefcount_clean(&test_pipe->urefcount);
+    upipe_clean(&test_pipe->upipe);
+    free(test_pipe);
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr,
+                                struct uprobe *uprobe, uint32_t signature,
+                                va_list args)
+{
+    struct test_pipe *test_pipe = malloc(sizeof(struct test_pipe));
+    assert(test_pipe != NULL);
+    upipe_init(&test_pipe->upipe, mgr, uprobe);
+    urefcount_init(&test_pipe->urefcount, test_free);
+    test_pipe->upipe.refcount = &test_pipe->urefcount;
+    test_pipe->thread = NB_THREADS;
+    return &test_pipe->upipe;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    struct test_pipe *test_pipe =
+        container_of(upipe, struct test_pipe, upipe);
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR:
+            assert(test_pipe->thread == NB_THREADS);
+            test_pipe->thread = thread_index();
+            uatomic_fetch_add(&dispatched[test_pipe->thread], 1);
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = NULL,
+    .upipe_control = test_control
+};
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe, int event,
+                 va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_mgr *upump_mgr =
+        upump_ev_mgr_alloc_default(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+
+    assert(!pthread_key_create(&thread_key, thread_exit));
+    uatomic_init(&nb_loops, 0);
+    uatomic_init(&nb_exited, 0);
+    uatomic_init(&nb_freed, 0);
+    for (unsigned int i = 0; i < NB_THREADS; i++)
+        uatomic_init(&dispatched[i], 0);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_DEBUG);
+    assert(logger != NULL);
+    logger = uprobe_pthread_upump_mgr_alloc(logger);
+    assert(logger != NULL);
+    uprobe_pthread_upump_mgr_set(logger, upump_mgr);
+
+    assert(upipe_pthread_pool_alloc(0, XFER_QUEUE, XFER_POOL,
+                                    uprobe_use(logger), test_upump_mgr_alloc,
+                                    UPUMP_POOL, UPUMP_BLOCKER_POOL,
+                                    NULL, NULL, NULL) == NULL);
+
+    struct upipe_pthread_pool *pool =
+        upipe_pthread_pool_alloc(NB_THREADS, XFER_QUEUE, XFER_POOL,
+                                 uprobe_use(logger), test_upump_mgr_alloc,
+                                 UPUMP_POOL, UPUMP_BLOCKER_POOL,
+                                 NULL, NULL, "pool");
+    assert(pool != NULL);
+    assert(upipe_pthread_pool_get_nb_threads(pool) == NB_THREADS);
+
+    struct upipe *handles[NB_PIPELINES];
+    for (unsigned int i = 0; i < NB_PIPELINES; i++) {
+        struct upipe_mgr *xfer_mgr = upipe_pthread_pool_get_xfer_mgr(pool);
+        assert(xfer_mgr != NULL);
+
+        struct upipe *upipe_test = upipe_void_alloc(&test_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_VERBOSE,
+                                    "test %u", i));
+        assert(upipe_test != NULL);
+        handles[i] = upipe_xfer_alloc(xfer_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_VERBOSE,
+                                    "xfer %u", i),
+                upipe_test);
+        /* from now on upipe_test shouldn't be accessed from this thread */
+        assert(handles[i] != NULL);
+        ubase_assert(upipe_attach_upump_mgr(handles[i]));
+        upipe_mgr_release(xfer_mgr);
+    }
+
+    /* the threads exit once the pool and all their pipes are released */
+    upipe_pthread_pool_release(pool);
+    for (unsigned int i = 0; i < NB_PIPELINES; i++)
+        upipe_release(handles[i]);
+
+    upump_mgr_run(upump_mgr, NULL);
+
+    /* all the threads were joined */
+    assert(uatomic_load(&nb_loops) == NB_THREADS);
+    assert(uatomic_load(&nb_exited) == NB_THREADS);
+    assert(uatomic_load(&nb_freed) == NB_PIPELINES);
+
+    /* the pipelines were spread over all the threads; a thread which had not
+     * started yet may be counted with one extra reference during placement */
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < NB_THREADS; i++) {
+        unsigned int count = uatomic_load(&dispatched[i]);
+        assert(count + 1 >= NB_PIPELINES / NB_THREADS);
+        assert(count <= NB_PIPELINES / NB_THREADS + 1);
+        total += count;
+    }
+    assert(total == NB_PIPELINES);
+
+    uprobe_release(logger);
+    upump_mgr_release(upump_mgr);
+    assert(!pthread_key_delete(thread_key));
+    return 0;
+}
@@ -42,6 +42,7 @@
 #include "upipe/uref_std.h"
 #include "upipe/uref_block_flow.h"
 #include "upipe/upump.h"
+#include "upipe/uclock.h"
 #include "upump-ev/upump_ev.h"
 #include "upipe-modules/upipe_queue_source.h"
 #include "upipe-modules/upipe_queue_sink.h"
@@ -202,6 +203,8 @@ int main(int argc, char *argv[])
                              "queue source"), QUEUE_LENGTH);
     assert(upipe_qsrc != NULL);
     ubase_assert(upipe_set_output(upipe_qsrc, upipe_sink));
+    ubase_nassert(upipe_qsrc_set_batch(upipe_qsrc, 0, 0));
+    ubase_assert(upipe_qsrc_set_batch(upipe_qsrc, QUEUE_LENGTH, UCLOCK_FREQ));
 
     struct upipe_mgr *upipe_qsink_mgr = upipe_qsink_mgr_alloc();
     assert(upipe_qsink_mgr != NULL);
@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ */
+
+/** @file
+ * @short unit tests for SMPTE ST 2110-20 pack and unpack modules
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_ubuf_mem.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_pic_mem.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_pic.h"
+#include "upipe/uref_pic_flow.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+#include "upipe-hbrmt/upipe_rtp_2110_20_pack.h"
+#include "upipe-hbrmt/upipe_rtp_2110_20_unpack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <bitstream/ietf/rtp.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+
+#define CHROMA "u10y10v10y10"
+#define WIDTH 720
+#define HEIGHT 16
+#define PAYLOAD_SIZE 1200
+#define CR_SYS (UCLOCK_FREQ * 10)
+#define DURATION (UCLOCK_FREQ / 25)
+
+/** reference picture */
+static struct uref *reference = NULL;
+/** number of packets received */
+static unsigned int nb_packets = 0;
+/** number of pixels carried by the packets */
+static unsigned int nb_pixels = 0;
+/** number of marker bits received */
+static unsigned int nb_markers = 0;
+/** date of the previous packet */
+static uint64_t last_cr_sys = 0;
+/** number of pictures received */
+static unsigned int nb_pictures = 0;
+/** unpack pipe fed by the packet checker */
+static struct upipe *unpack = NULL;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_CLOCK_TS:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe checking packets */
+static void packet_input(struct upipe *upipe, struct uref *uref,
+                         struct upump **upump_p)
+{
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size <= RTP_HEADER_SIZE + PAYLOAD_SIZE);
+
+    uint8_t header[RTP_HEADER_SIZE + PAYLOAD_SIZE];
+    ubase_assert(uref_block_extract(uref, 0, size, header));
+    assert(rtp_check_hdr(header));
+    assert(rtp_get_type(header) == 96);
+    assert(rtp_get_seqnum(header) == nb_packets);
+    assert(header[RTP_HEADER_SIZE] == 0 && header[RTP_HEADER_SIZE + 1] == 0);
+    if (rtp_check_marker(header))
+        nb_markers++;
+
+    /* sample row data headers */
+    const uint8_t *srd = header + RTP_HEADER_SIZE + 2;
+    size_t length = RTP_HEADER_SIZE + 2;
+    do {
+        length += 6 + ((srd[0] << 8) | srd[1]);
+        nb_pixels += ((srd[0] << 8) | srd[1]) / 5 * 2;
+        srd += 6;
+    } while (srd[-2] & 0x80);
+    assert(length == size);
+
+    /* packets are spread over the active period of the frame */
+    uint64_t cr_sys;
+    ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
+    assert(cr_sys >= CR_SYS);
+    assert(cr_sys < CR_SYS + DURATION);
+    assert(!nb_packets || cr_sys > last_cr_sys);
+    last_cr_sys = cr_sys;
+    nb_packets++;
+
+    upipe_input(unpack, uref, upump_p);
+}
+
+/** helper phony pipe checking pictures */
+static void picture_input(struct upipe *upipe, struct uref *uref,
+                          struct upump **upump_p)
+{
+    size_t hsize, vsize, stride, ref_stride;
+    ubase_assert(uref_pic_size(uref, &hsize, &vsize, NULL));
+    assert(hsize == WIDTH);
+    assert(vsize == HEIGHT);
+    ubase_assert(uref_pic_get_progressive(uref));
+
+    const uint8_t *buf, *ref;
+    ubase_assert(uref_pic_plane_size(uref, CHROMA, &stride, NULL, NULL,
+                                     NULL));
+    ubase_assert(uref_pic_plane_size(reference, CHROMA, &ref_stride, NULL,
+                                     NULL, NULL));
+    ubase_assert(uref_pic_plane_read(uref, CHROMA, 0, 0, -1, -1, &buf));
+    ubase_assert(uref_pic_plane_read(reference, CHROMA, 0, 0, -1, -1, &ref));
+    for (int y = 0; y < HEIGHT; y++)
+        assert(!memcmp(buf + y * stride, ref + y * ref_stride,
+                       WIDTH * 2 * sizeof(uint16_t)));
+    uref_pic_plane_unmap(uref, CHROMA, 0, 0, -1, -1);
+    uref_pic_plane_unmap(reference, CHROMA, 0, 0, -1, -1);
+
+    nb_pictures++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe checking packets */
+static struct upipe_mgr packet_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = packet_input,
+    .upipe_control = test_control
+};
+
+/** helper phony pipe checking pictures */
+static struct upipe_mgr picture_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = picture_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *pic_mgr = ubuf_pic_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                      UBUF_POOL_DEPTH,
+                                                      umem_mgr, 2,
+                                                      0, 0, 0, 0, 32, 0);
+    assert(pic_mgr != NULL);
+    ubase_assert(ubuf_pic_mem_mgr_add_plane(pic_mgr, CHROMA, 1, 1, 8));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+    uprobe_stdio = uprobe_ubuf_mem_alloc(uprobe_stdio, umem_mgr,
+            UBUF_POOL_DEPTH, UBUF_POOL_DEPTH);
+    assert(uprobe_stdio != NULL);
+
+    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 2);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 8, CHROMA));
+    ubase_assert(uref_pic_flow_set_hsize(flow_def, WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(flow_def, HEIGHT));
+    ubase_assert(uref_pic_flow_set_fps(flow_def,
+                                       (struct urational){ 25, 1 }));
+    ubase_assert(uref_pic_set_progressive(flow_def));
+
+    struct upipe_mgr *pack_mgr = upipe_rtp_2110_20_pack_mgr_alloc();
+    assert(pack_mgr != NULL);
+    struct upipe *pack = upipe_void_alloc(pack_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "pack"));
+    assert(pack != NULL);
+    ubase_assert(upipe_rtp_2110_20_pack_set_payload_size(pack,
+                                                         PAYLOAD_SIZE));
+    ubase_assert(upipe_set_flow_def(pack, flow_def));
+    uref_free(flow_def);
+
+    struct upipe *packet_sink = upipe_void_alloc(&packet_mgr,
+                                                 uprobe_use(uprobe_stdio));
+    assert(packet_sink != NULL);
+    ubase_assert(upipe_set_output(pack, packet_sink));
+
+    struct upipe_mgr *unpack_mgr = upipe_rtp_2110_20_unpack_mgr_alloc();
+    assert(unpack_mgr != NULL);
+    unpack = upipe_void_alloc(unpack_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "unpack"));
+    assert(unpack != NULL);
+    ubase_assert(upipe_get_flow_def(pack, &flow_def));
+    ubase_assert(upipe_set_flow_def(unpack, flow_def));
+
+    struct upipe *picture_sink = upipe_void_alloc(&picture_mgr,
+                                                  uprobe_use(uprobe_stdio));
+    assert(picture_sink != NULL);
+    ubase_assert(upipe_set_output(unpack, picture_sink));
+
+    reference = uref_pic_alloc(uref_mgr, pic_mgr, WIDTH, HEIGHT);
+    assert(reference != NULL);
+    uint8_t *buf;
+    size_t stride;
+    ubase_assert(uref_pic_plane_size(reference, CHROMA, &stride, NULL, NULL,
+                                     NULL));
+    ubase_assert(uref_pic_plane_write(reference, CHROMA, 0, 0, -1, -1, &buf));
+    for (int y = 0; y < HEIGHT; y++) {
+        uint16_t *line = (uint16_t *)(buf + y * stride);
+        for (int x = 0; x < WIDTH * 2; x++)
+            line[x] = (x * 7 + y * 13) & 0x3ff;
+    }
+    uref_pic_plane_unmap(reference, CHROMA, 0, 0, -1, -1);
+    uref_pic_set_progressive(reference);
+    uref_clock_set_cr_sys(reference, CR_SYS);
+    uref_clock_set_pts_prog(reference, UCLOCK_FREQ);
+    uref_clock_set_duration(reference, DURATION);
+
+    upipe_input(pack, uref_dup(reference), NULL);
+    assert(nb_pixels == WIDTH * HEIGHT);
+    assert(nb_markers == 1);
+    assert(nb_pictures == 1);
+
+    upipe_release(pack);
+    upipe_release(unpack);
+    test_free(packet_sink);
+    test_free(picture_sink);
+    uref_free(reference);
+
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(pic_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+
+    return 0;
+}
@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for rtp_pcm_pack pipes
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_ubuf_mem.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_sound_mem.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_sound.h"
+#include "upipe/uref_sound_flow.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_std.h"
+#include "upipe-modules/upipe_rtp_pcm_pack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    0
+#define UREF_POOL_DEPTH     0
+#define UBUF_POOL_DEPTH     0
+#define UPROBE_LOG_LEVEL    UPROBE_LOG_DEBUG
+#define CHANNELS            2
+#define RATE                48000
+#define PACKET_SAMPLES      6
+#define RTP_TYPE            98
+#define CR_SYS              (UCLOCK_FREQ * 10)
+
+static bool rtp;
+static unsigned int nb_packets = 0;
+static unsigned int next_sample = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    size_t header_size = rtp ? 12 : 0;
+    size_t size;
+    ubase_assert(uref_block_size(uref, &size));
+    assert(size == header_size + PACKET_SAMPLES * CHANNELS * 3);
+
+    uint8_t buffer[size];
+    ubase_assert(uref_block_extract(uref, 0, size, buffer));
+    if (rtp) {
+        assert(buffer[0] == 0x80);
+        assert(buffer[1] == RTP_TYPE);
+        assert(((buffer[2] << 8) | buffer[3]) == nb_packets);
+        uint32_t timestamp = (buffer[4] << 24) | (buffer[5] << 16) |
+                             (buffer[6] << 8) | buffer[7];
+        assert(timestamp == next_sample);
+    }
+
+    for (unsigned int i = 0; i < PACKET_SAMPLES * CHANNELS; i++) {
+        const uint8_t *sample = buffer + header_size + 3 * i;
+        unsigned int value = next_sample * CHANNELS + i;
+        assert(sample[0] == ((value >> 16) & 0xff));
+        assert(sample[1] == ((value >> 8) & 0xff));
+        assert(sample[2] == (value & 0xff));
+    }
+
+    /* each packet is dated from its first sample */
+    uint64_t cr_sys, duration;
+    ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
+    int64_t expected = CR_SYS + (uint64_t)next_sample * UCLOCK_FREQ / RATE;
+    assert((int64_t)cr_sys - expected <= 1 && expected - (int64_t)cr_sys <= 1);
+    ubase_assert(uref_clock_get_duration(uref, &duration));
+    assert(duration == PACKET_SAMPLES * UCLOCK_FREQ / RATE);
+
+    next_sample += PACKET_SAMPLES;
+    nb_packets++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            ubase_assert(uref_flow_match_def(flow_def, rtp ?
+                        "block.rtp.s24be.sound." : "block.s24be.sound."));
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_REGISTER_REQUEST: {
+            struct urequest *urequest = va_arg(args, struct urequest *);
+            return upipe_throw_provide_request(upipe, urequest);
+        }
+        case UPIPE_UNREGISTER_REQUEST:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr rtp_pcm_pack_test_mgr = {
+    .refcount = NULL,
+    .signature = 0,
+
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+static void test_run(struct uref_mgr *uref_mgr, struct ubuf_mgr *sound_mgr,
+                     struct uprobe *logger)
+{
+    /* sizes not aligned on packets, so that samples are carried over */
+    static const size_t sizes[] = { 10, 7, 13, 2, 4 };
+    nb_packets = 0;
+    next_sample = 0;
+
+    struct uref *flow_def = uref_sound_flow_alloc_def(uref_mgr, "s32.",
+                                                      CHANNELS,
+                                                      4 * CHANNELS);
+    assert(flow_def != NULL);
+    ubase_assert(uref_sound_flow_add_plane(flow_def, "all"));
+    ubase_assert(uref_sound_flow_set_rate(flow_def, RATE));
+
+    struct upipe_mgr *upipe_rtp_pcm_pack_mgr = upipe_rtp_pcm_pack_mgr_alloc();
+    assert(upipe_rtp_pcm_pack_mgr != NULL);
+    struct upipe *upipe_rtp_pcm_pack = upipe_void_alloc(upipe_rtp_pcm_pack_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "rtp_pcm_pack"));
+    assert(upipe_rtp_pcm_pack != NULL);
+    if (rtp) {
+        ubase_assert(upipe_rtp_pcm_pack_set_packet_time(upipe_rtp_pcm_pack,
+                    UPIPE_RTP_PCM_PACK_PTIME_125US));
+        ubase_assert(upipe_rtp_pcm_pack_set_type(upipe_rtp_pcm_pack,
+                                                 RTP_TYPE));
+    } else
+        ubase_assert(upipe_set_option(upipe_rtp_pcm_pack, "output-samples",
+                                      "6"));
+
+    struct upipe *upipe_sink = upipe_void_alloc(&rtp_pcm_pack_test_mgr,
+                                                uprobe_use(logger));
+    assert(upipe_sink != NULL);
+    ubase_assert(upipe_set_output(upipe_rtp_pcm_pack, upipe_sink));
+    ubase_assert(upipe_set_flow_def(upipe_rtp_pcm_pack, flow_def));
+    uref_free(flow_def);
+    if (rtp)
+        ubase_nassert(upipe_rtp_pcm_pack_set_packet_time(upipe_rtp_pcm_pack,
+                    UPIPE_RTP_PCM_PACK_PTIME_1MS));
+
+    unsigned int sample = 0;
+    for (unsigned int i = 0; i < UBASE_ARRAY_SIZE(sizes); i++) {
+        struct uref *uref = uref_sound_alloc(uref_mgr, sound_mgr, sizes[i]);
+        assert(uref != NULL);
+        int32_t *buffer;
+        ubase_assert(uref_sound_plane_write_int32_t(uref, "all", 0, -1,
+                                                    &buffer));
+        for (unsigned int j = 0; j < sizes[i] * CHANNELS; j++)
+            buffer[j] = (int32_t)((sample * CHANNELS + j) << 8);
+        uref_sound_plane_unmap(uref, "all", 0, -1);
+
+        uint64_t date = (uint64_t)sample * UCLOCK_FREQ / RATE;
+        uref_clock_set_pts_prog(uref, date);
+        uref_clock_set_cr_sys(uref, CR_SYS + date);
+        sample += sizes[i];
+        upipe_input(upipe_rtp_pcm_pack, uref, NULL);
+        assert(nb_packets == sample / PACKET_SAMPLES);
+    }
+    assert(nb_packets == 6);
+
+    upipe_release(upipe_rtp_pcm_pack);
+    upipe_mgr_release(upipe_rtp_pcm_pack_mgr);
+    test_free(upipe_sink);
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *sound_mgr = ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 4 * CHANNELS, 0);
+    assert(sound_mgr != NULL);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(sound_mgr, "all"));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    rtp = false;
+    test_run(uref_mgr, sound_mgr, logger);
+    rtp = true;
+    test_run(uref_mgr, sound_mgr, logger);
+
+    ubuf_mgr_release(sound_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
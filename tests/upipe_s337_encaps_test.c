@@ -43,6 +43,7 @@
 #include "upipe/uref_std.h"
 #include "upipe/uref_dump.h"
 #include "upipe-modules/upipe_s337_encaps.h"
+#include "upipe-framers/uref_s337.h"
 
 #include "upipe/upipe_helper_upipe.h"
 
@@ -145,6 +146,14 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     /* unmap */
     uref_sound_unmap(uref, 0, -1, 1);
 
+    /* burst attributes */
+    uint8_t data_type;
+    uint64_t length;
+    ubase_assert(uref_s337_get_data_type(uref, &data_type));
+    assert(data_type == S337_TYPE_A52);
+    ubase_assert(uref_s337_get_length(uref, &length));
+    assert(length == PACKET_SIZE * 8);
+
     /* keep uref */
     if (s337_encaps_test->entry) {
         uref_free(s337_encaps_test->entry);
@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for timeshift pipes
+ */
+
+#undef NDEBUG
+
+#include "upump-ev/upump_ev.h"
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_upump_mgr.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/upump.h"
+#include "upipe/upipe.h"
+#include "upipe-modules/upipe_timeshift.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCK_POOL 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define NB_UREFS 20
+#define DURATION (10 * UCLOCK_FREQ)
+
+static int counter = 0;
+static uint64_t last_date = 0;
+static int flow_foo_counter = 0;
+static int flow_bar_counter = 0;
+static int source_end_counter = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_SOURCE_END:
+            source_end_counter++;
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe to test upipe_timeshift */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    uint64_t date;
+    ubase_assert(uref_clock_get_cr_sys(uref, &date));
+    if (counter)
+        assert(date == last_date + UCLOCK_FREQ);
+    last_date = date;
+    counter++;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            if (ubase_check(uref_flow_match_def(flow_def, "block.foo.")))
+                flow_foo_counter++;
+            else if (ubase_check(uref_flow_match_def(flow_def, "block.bar.")))
+                flow_bar_counter++;
+            else
+                abort();
+            return UBASE_ERR_NONE;
+        }
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr timeshift_test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc_default(UPUMP_POOL,
+                                                             UPUMP_BLOCK_POOL);
+    assert(upump_mgr != NULL);
+    struct uref *uref;
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *logger = uprobe_stdio_alloc(&uprobe, stdout,
+                                               UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_upump_mgr_alloc(logger, upump_mgr);
+    assert(logger != NULL);
+
+    struct upipe *upipe_sink0 = upipe_void_alloc(&timeshift_test_mgr,
+                                                 uprobe_use(logger));
+    assert(upipe_sink0 != NULL);
+
+    struct upipe *upipe_sink1 = upipe_void_alloc(&timeshift_test_mgr,
+                                                 uprobe_use(logger));
+    assert(upipe_sink1 != NULL);
+
+    struct upipe_mgr *upipe_timeshift_mgr = upipe_timeshift_mgr_alloc();
+    assert(upipe_timeshift_mgr != NULL);
+    struct upipe *upipe_timeshift = upipe_void_alloc(upipe_timeshift_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "timeshift"));
+    assert(upipe_timeshift != NULL);
+    ubase_assert(upipe_timeshift_set_limits(upipe_timeshift, DURATION,
+                                            UINT64_MAX));
+    uint64_t duration, size;
+    ubase_assert(upipe_timeshift_get_limits(upipe_timeshift, &duration,
+                                            &size));
+    assert(duration == DURATION);
+    assert(size == UINT64_MAX);
+    uint64_t first, last;
+    ubase_nassert(upipe_timeshift_get_range(upipe_timeshift, &first, &last));
+
+    uref = uref_block_flow_alloc_def(uref_mgr, "foo.");
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_timeshift, uref));
+    uref_free(uref);
+
+    /* live reader */
+    struct upipe *upipe_timeshift_output0 = upipe_void_alloc_sub(
+            upipe_timeshift,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "timeshift output 0"));
+    assert(upipe_timeshift_output0 != NULL);
+    ubase_assert(upipe_set_output(upipe_timeshift_output0, upipe_sink0));
+
+    for (int i = 0; i < NB_UREFS; i++) {
+        if (i == NB_UREFS / 2) {
+            uref = uref_block_flow_alloc_def(uref_mgr, "bar.");
+            assert(uref != NULL);
+            ubase_assert(upipe_set_flow_def(upipe_timeshift, uref));
+            uref_free(uref);
+        }
+        uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        uref_clock_set_cr_sys(uref, i * UCLOCK_FREQ);
+        if (!(i % 5))
+            uref_flow_set_random(uref);
+        upipe_input(upipe_timeshift, uref, NULL);
+        upump_mgr_run(upump_mgr, NULL);
+    }
+    assert(counter == NB_UREFS);
+    assert(last_date == (NB_UREFS - 1) * UCLOCK_FREQ);
+    assert(flow_foo_counter == 1);
+    assert(flow_bar_counter == 1);
+
+    /* the ring only keeps the last 10 seconds */
+    ubase_assert(upipe_timeshift_get_range(upipe_timeshift, &first, &last));
+    assert(first == (NB_UREFS - 1) * UCLOCK_FREQ - DURATION);
+    assert(last == (NB_UREFS - 1) * UCLOCK_FREQ);
+
+    /* timeshifted reader, restarting from the previous random access */
+    struct upipe *upipe_timeshift_output1 = upipe_void_alloc_sub(
+            upipe_timeshift,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "timeshift output 1"));
+    assert(upipe_timeshift_output1 != NULL);
+    uint64_t position;
+    ubase_assert(upipe_src_get_position(upipe_timeshift_output1, &position));
+    assert(position == UPIPE_TIMESHIFT_LIVE);
+    ubase_assert(upipe_src_set_position(upipe_timeshift_output1,
+                                        12 * UCLOCK_FREQ));
+    ubase_assert(upipe_src_get_position(upipe_timeshift_output1, &position));
+    assert(position == 10 * UCLOCK_FREQ);
+
+    counter = 0;
+    ubase_assert(upipe_set_output(upipe_timeshift_output1, upipe_sink1));
+    upump_mgr_run(upump_mgr, NULL);
+    assert(counter == NB_UREFS - 10);
+    assert(last_date == (NB_UREFS - 1) * UCLOCK_FREQ);
+    ubase_assert(upipe_src_get_position(upipe_timeshift_output1, &position));
+    assert(position == UPIPE_TIMESHIFT_LIVE);
+
+    /* before the first random access, the first one after is used */
+    ubase_assert(upipe_src_set_position(upipe_timeshift_output1, 0));
+    ubase_assert(upipe_src_get_position(upipe_timeshift_output1, &position));
+    assert(position == 10 * UCLOCK_FREQ);
+    ubase_assert(upipe_src_set_position(upipe_timeshift_output1,
+                                        UPIPE_TIMESHIFT_LIVE));
+
+    /* readers end once they have output the whole ring */
+    upipe_release(upipe_timeshift);
+    upump_mgr_run(upump_mgr, NULL);
+    assert(source_end_counter == 2);
+
+    upipe_release(upipe_timeshift_output0);
+    upipe_release(upipe_timeshift_output1);
+    upipe_mgr_release(upipe_timeshift_mgr); // nop
+
+    test_free(upipe_sink0);
+    test_free(upipe_sink1);
+
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+
+    uprobe_release(logger);
+    uprobe_clean(&uprobe);
+    return 0;
+}
@@ -125,6 +125,11 @@ static void *thread(void *_upipe_xfer_mgr)
     assert(upump_mgr != NULL);
 
     ubase_assert(upipe_xfer_mgr_attach(upipe_xfer_mgr, upump_mgr));
+#ifdef __linux__
+    struct upipe_xfer_thread_stats stats;
+    ubase_assert(upipe_xfer_mgr_get_thread_stats(upipe_xfer_mgr, &stats));
+    assert(stats.thread != 0);
+#endif
     upipe_mgr_release(upipe_xfer_mgr);
 
     upump_mgr_run(upump_mgr, NULL);
@@ -261,6 +261,61 @@ int main(int argc, char *argv[])
     assert(count_subpic == 0);
     count_pic = 0;
 
+    /* keyframe-only mode */
+    struct urational threshold;
+    uint64_t interval;
+    ubase_assert(upipe_trickp_set_keyframe(upipe_trickp,
+                                           (struct urational){ 2, 1 }, 10));
+    ubase_assert(upipe_trickp_get_keyframe(upipe_trickp, &threshold,
+                                           &interval));
+    assert(threshold.num == 2 && threshold.den == 1);
+    assert(interval == 10);
+    ubase_assert(upipe_trickp_set_rate(upipe_trickp,
+                                       (struct urational){ 4, 1 }));
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 100);
+    uref_flow_set_random(uref);
+    upipe_input(upipe_trickp_pic, uref, NULL);
+    assert(count_pic == 42);
+
+    /* not a keyframe */
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 104);
+    upipe_input(upipe_trickp_pic, uref, NULL);
+    assert(count_pic == 42);
+
+    /* keyframe too close to the previous one */
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 108);
+    uref_flow_set_random(uref);
+    upipe_input(upipe_trickp_pic, uref, NULL);
+    assert(count_pic == 42);
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 140);
+    uref_flow_set_random(uref);
+    upipe_input(upipe_trickp_pic, uref, NULL);
+    assert(count_pic == 42 + 52);
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 140);
+    upipe_input(upipe_trickp_sound, uref, NULL);
+    assert(count_sound == 0);
+
+    uref = uref_alloc(uref_mgr);
+    assert(uref != NULL);
+    uref_clock_set_pts_prog(uref, (uint64_t)UINT32_MAX + 140);
+    upipe_input(upipe_trickp_subpic, uref, NULL);
+    assert(count_subpic == 52);
+    count_pic = 0;
+    count_subpic = 0;
+
     upipe_release(upipe_trickp);
     upipe_release(upipe_trickp_pic);
     upipe_release(upipe_trickp_sound);
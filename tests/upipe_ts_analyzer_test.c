@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for ts_analyzer pipes
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/ubuf_block_mem.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+#include "upipe-ts/upipe_ts_analyzer.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+#define PMT_PID 0x100
+#define ES_PID 0x101
+#define NB_PACKETS 7
+#define MS (UCLOCK_FREQ / 1000)
+
+static struct uref_mgr *uref_mgr;
+static struct ubuf_mgr *ubuf_mgr;
+static struct upipe *upipe_ts_analyzer;
+static uint8_t buffer[NB_PACKETS * TS_SIZE];
+static unsigned int events[UPIPE_TS_ANALYZER_ERROR_MAX];
+static unsigned int last_pid = 0;
+static unsigned int nb_urefs = 0;
+static uint8_t pat_cc = 0, pmt_cc = 0, es_cc = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+        case UPROBE_TS_ANALYZER_ERROR: {
+            UBASE_SIGNATURE_CHECK(args, UPIPE_TS_ANALYZER_SIGNATURE)
+            unsigned int error = va_arg(args, unsigned int);
+            unsigned int pid = va_arg(args, unsigned int);
+            assert(error < UPIPE_TS_ANALYZER_ERROR_MAX);
+            events[error]++;
+            last_pid = pid;
+            break;
+        }
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    uref_free(uref);
+    nb_urefs++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** initializes a TS packet with a payload */
+static uint8_t *put_packet(unsigned int i, uint16_t pid, uint8_t *cc_p)
+{
+    uint8_t *ts = buffer + i * TS_SIZE;
+    memset(ts, 0xff, TS_SIZE);
+    ts_init(ts);
+    ts_set_pid(ts, pid);
+    ts_set_cc(ts, *cc_p);
+    ts_set_payload(ts);
+    *cc_p = (*cc_p + 1) & 0xf;
+    return ts;
+}
+
+/** puts a PAT announcing a single program */
+static uint8_t *put_pat(unsigned int i)
+{
+    uint8_t *ts = put_packet(i, 0, &pat_cc);
+    ts_set_unitstart(ts);
+    uint8_t *payload = ts_payload(ts);
+    *payload++ = 0; /* pointer_field */
+    pat_init(payload);
+    pat_set_length(payload, PAT_PROGRAM_SIZE);
+    pat_set_tsid(payload, 1);
+    psi_set_version(payload, 0);
+    psi_set_current(payload);
+    psi_set_section(payload, 0);
+    psi_set_lastsection(payload, 0);
+    uint8_t *program = pat_get_program(payload, 0);
+    patn_init(program);
+    patn_set_program(program, 1);
+    patn_set_pid(program, PMT_PID);
+    psi_set_crc(payload);
+    return ts;
+}
+
+/** puts an empty PMT */
+static uint8_t *put_pmt(unsigned int i)
+{
+    uint8_t *ts = put_packet(i, PMT_PID, &pmt_cc);
+    ts_set_unitstart(ts);
+    uint8_t *payload = ts_payload(ts);
+    *payload++ = 0; /* pointer_field */
+    pmt_init(payload);
+    pmt_set_length(payload, 0);
+    pmt_set_program(payload, 1);
+    psi_set_version(payload, 0);
+    psi_set_current(payload);
+    psi_set_section(payload, 0);
+    psi_set_lastsection(payload, 0);
+    pmt_set_pcrpid(payload, ES_PID);
+    pmt_set_desclength(payload, 0);
+    psi_set_crc(payload);
+    return ts;
+}
+
+/** puts an elementary stream packet, with a PCR if pcr is not UINT64_MAX */
+static uint8_t *put_es(unsigned int i, uint64_t pcr)
+{
+    uint8_t *ts = put_packet(i, ES_PID, &es_cc);
+    if (pcr != UINT64_MAX) {
+        ts_set_adaptation(ts, TS_HEADER_SIZE_PCR - TS_HEADER_SIZE - 1);
+        tsaf_set_pcr(ts, pcr / 300);
+        tsaf_set_pcrext(ts, pcr % 300);
+    }
+    return ts;
+}
+
+/** fills the buffer with elementary stream packets from packet i */
+static void put_es_all(unsigned int i)
+{
+    for ( ; i < NB_PACKETS; i++)
+        put_es(i, UINT64_MAX);
+}
+
+/** sends the first nb packets of the buffer in a single block */
+static void send(unsigned int nb, uint64_t sys)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr, nb * TS_SIZE);
+    assert(uref != NULL);
+    uint8_t *w;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &w));
+    assert(size == nb * TS_SIZE);
+    memcpy(w, buffer, size);
+    uref_block_unmap(uref, 0);
+    uref_clock_set_cr_sys(uref, sys);
+    upipe_input(upipe_ts_analyzer, uref, NULL);
+}
+
+/** returns the total number of reported errors */
+static unsigned int nb_events(void)
+{
+    unsigned int nb = 0;
+    for (int i = 0; i < UPIPE_TS_ANALYZER_ERROR_MAX; i++)
+        nb += events[i];
+    return nb;
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH, UBUF_POOL_DEPTH,
+                                        umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(uprobe_stdio));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_ts_analyzer_mgr = upipe_ts_analyzer_mgr_alloc();
+    assert(upipe_ts_analyzer_mgr != NULL);
+    upipe_ts_analyzer = upipe_void_alloc(upipe_ts_analyzer_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts analyzer"));
+    assert(upipe_ts_analyzer != NULL);
+    struct uref *uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_analyzer, uref));
+    ubase_assert(upipe_set_output(upipe_ts_analyzer, upipe_sink));
+    uref_free(uref);
+
+    /* valid stream */
+    put_pat(0);
+    put_pmt(1);
+    put_es(2, 0);
+    put_es_all(3);
+    send(NB_PACKETS, 0);
+    put_es(0, 20 * MS);
+    put_es_all(1);
+    send(NB_PACKETS, 20 * MS);
+    put_es(0, 40 * MS);
+    put_es_all(1);
+    send(NB_PACKETS, 45 * MS);
+    assert(nb_urefs == 3);
+    assert(nb_events() == 0);
+
+    struct upipe_ts_analyzer_stats stats;
+    ubase_assert(upipe_ts_analyzer_get_stats(upipe_ts_analyzer, &stats));
+    assert(stats.packets == 3 * NB_PACKETS);
+    assert(stats.pcr_jitter_max == 5 * MS);
+
+    /* continuity errors, a single duplicate is allowed */
+    put_es_all(0);
+    ts_set_cc(buffer + TS_SIZE, 0xf & (ts_get_cc(buffer) + 2));
+    send(2, 50 * MS);
+    assert(events[UPIPE_TS_ANALYZER_CC] == 1);
+    assert(last_pid == ES_PID);
+    memcpy(buffer + TS_SIZE, buffer, TS_SIZE);
+    send(2, 55 * MS);
+    assert(events[UPIPE_TS_ANALYZER_CC] == 2);
+    send(1, 60 * MS);
+    assert(events[UPIPE_TS_ANALYZER_CC] == 3);
+    es_cc = (ts_get_cc(buffer) + 1) & 0xf;
+
+    /* sync errors */
+    put_es_all(0);
+    buffer[0] = 0;
+    send(NB_PACKETS, 65 * MS);
+    assert(events[UPIPE_TS_ANALYZER_SYNC_BYTE] == 1);
+    assert(events[UPIPE_TS_ANALYZER_SYNC_LOSS] == 0);
+    assert(events[UPIPE_TS_ANALYZER_CC] == 4);
+    put_es_all(0);
+    buffer[TS_SIZE] = buffer[2 * TS_SIZE] = 0;
+    send(NB_PACKETS, 70 * MS);
+    assert(events[UPIPE_TS_ANALYZER_SYNC_BYTE] == 3);
+    assert(events[UPIPE_TS_ANALYZER_SYNC_LOSS] == 1);
+    assert(events[UPIPE_TS_ANALYZER_CC] == 5);
+
+    /* transport errors */
+    put_es_all(0);
+    buffer[1] |= 0x80; /* transport_error_indicator */
+    send(1, 75 * MS);
+    assert(events[UPIPE_TS_ANALYZER_TRANSPORT] == 1);
+
+    /* missing PSI and PCR */
+    assert(nb_events() == 10);
+    put_es_all(0);
+    send(NB_PACKETS, 600 * MS);
+    assert(events[UPIPE_TS_ANALYZER_PAT] == 1);
+    assert(events[UPIPE_TS_ANALYZER_PMT] == 1);
+    assert(events[UPIPE_TS_ANALYZER_PCR_REPETITION] == 1);
+    assert(events[UPIPE_TS_ANALYZER_CC] == 6);
+    assert(nb_events() == 14);
+
+    /* wrong table_id and PCR discontinuity */
+    put_pat(0);
+    psi_set_tableid(ts_payload(buffer) + 1, 0x42);
+    put_pmt(1);
+    put_es(2, 700 * MS);
+    send(3, 700 * MS);
+    assert(events[UPIPE_TS_ANALYZER_PAT] == 2);
+    assert(nb_events() == 15);
+    put_es(0, 900 * MS);
+    send(1, 720 * MS);
+    assert(events[UPIPE_TS_ANALYZER_PCR_DISCONTINUITY] == 1);
+    assert(nb_events() == 16);
+
+    /* packets spanning several segments */
+    put_pat(0);
+    put_es(1, 920 * MS);
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 100);
+    assert(uref != NULL);
+    struct ubuf *ubuf = ubuf_block_alloc(ubuf_mgr, 2 * TS_SIZE - 100);
+    assert(ubuf != NULL);
+    uint8_t *w;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &w));
+    memcpy(w, buffer, size);
+    uref_block_unmap(uref, 0);
+    size = -1;
+    ubase_assert(ubuf_block_write(ubuf, 0, &size, &w));
+    memcpy(w, buffer + 100, size);
+    ubuf_block_unmap(ubuf, 0);
+    ubase_assert(uref_block_append(uref, ubuf));
+    uref_clock_set_cr_sys(uref, 740 * MS);
+    ubase_assert(upipe_ts_analyzer_get_stats(upipe_ts_analyzer, &stats));
+    uint64_t packets = stats.packets;
+    upipe_input(upipe_ts_analyzer, uref, NULL);
+    ubase_assert(upipe_ts_analyzer_get_stats(upipe_ts_analyzer, &stats));
+    assert(stats.packets == packets + 2);
+    assert(nb_events() == 16);
+    assert(stats.errors[UPIPE_TS_ANALYZER_CC] == 6);
+    assert(stats.errors[UPIPE_TS_ANALYZER_SYNC_BYTE] == 3);
+
+    ubase_assert(upipe_ts_analyzer_reset_stats(upipe_ts_analyzer));
+    ubase_assert(upipe_ts_analyzer_get_stats(upipe_ts_analyzer, &stats));
+    assert(!stats.packets);
+    assert(!stats.errors[UPIPE_TS_ANALYZER_CC]);
+
+    upipe_release(upipe_ts_analyzer);
+    upipe_mgr_release(upipe_ts_analyzer_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -0,0 +1,669 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short throughput benchmark for TS demux and mux modules
+ *
+ * A synthetic MPTS made of MPEG-1 layer II audio elementary streams is
+ * generated in memory, then fed through ts_demux and ts_mux. All programs
+ * share the same PCR timeline, so that system timestamps may be derived from
+ * program timestamps.
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_uref_mgr.h"
+#include "upipe/uprobe_ubuf_mem.h"
+#include "upipe/umem.h"
+#include "upipe/umem_pool.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block_mem.h"
+#include "upipe/uclock.h"
+#include "upipe/uclock_std.h"
+#include "upipe/uref.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+#include "upipe-ts/upipe_ts_demux.h"
+#include "upipe-ts/upipe_ts_mux.h"
+#include "upipe-framers/upipe_auto_framer.h"
+#include "upipe-modules/upipe_noclock.h"
+#include "upipe-modules/upipe_even.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <assert.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include <bitstream/mpeg/ts.h>
+#include <bitstream/mpeg/psi.h>
+#include <bitstream/mpeg/pes.h>
+
+#define UDICT_POOL_DEPTH 50
+#define UREF_POOL_DEPTH 50
+#define UBUF_POOL_DEPTH 50
+#define UMEM_POOL_DEPTH 50
+#define UPROBE_LOG_LEVEL UPROBE_LOG_WARNING
+/** number of TS packets per input block */
+#define BLOCK_PACKETS 7
+/** MPEG-1 layer II header, 192 kbi/s, 48 kHz, stereo */
+#define MPGA_HEADER 0xff, 0xfd, 0xa4, 0x00
+/** size of an MPEG-1 layer II frame */
+#define MPGA_FRAME_SIZE 576
+/** duration of an MPEG-1 layer II frame */
+#define MPGA_FRAME_DURATION (UCLOCK_FREQ * 1152 / 48000)
+/** interval between PSI tables, in frames */
+#define PSI_INTERVAL 4
+/** delay between the PCR and the PTS */
+#define PTS_DELAY (UCLOCK_FREQ / 5)
+/** PID of the first PMT */
+#define PMT_PID_BASE 32
+/** maximum number of programs, so that the PAT fits in one TS packet */
+#define MAX_PROGRAMS 40
+/** maximum number of elementary streams, so that a PMT fits in one packet */
+#define MAX_ES 30
+
+static unsigned int nb_programs = 8;
+static unsigned int nb_es = 4;
+static unsigned int duration = 60;
+
+static uint8_t *stream = NULL;
+static size_t stream_packets = 0;
+static size_t stream_alloc = 0;
+static uint8_t pat_cc = 0;
+static uint8_t pmt_cc[MAX_PROGRAMS];
+static uint8_t es_cc[MAX_PROGRAMS][MAX_ES];
+
+static struct upipe_mgr *upipe_noclock_mgr;
+static struct upipe *upipe_even;
+
+static struct uprobe *logger;
+static struct uprobe uprobe_demux_output_s;
+static struct uprobe uprobe_demux_program_s;
+
+/** generic probe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    if (event == UPROBE_FATAL) {
+        fprintf(stderr, "fatal error, aborting benchmark\n");
+        exit(EXIT_FAILURE);
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** probe to catch events from the TS demux outputs */
+static int catch_ts_demux_output(struct uprobe *uprobe,
+                                 struct upipe *upipe,
+                                 int event, va_list args)
+{
+    if (event == UPROBE_SOURCE_END) {
+        upipe_release(upipe);
+        return UBASE_ERR_NONE;
+    }
+
+    return uprobe_throw_next(uprobe, upipe, event, args);
+}
+
+/** probe to catch events from the TS demux programs */
+static int catch_ts_demux_program(struct uprobe *uprobe,
+                                  struct upipe *upipe,
+                                  int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_SOURCE_END:
+            upipe_release(upipe);
+            return UBASE_ERR_NONE;
+
+        case UPROBE_SPLIT_UPDATE: {
+            struct uref *flow_def = NULL;
+            while (ubase_check(upipe_split_iterate(upipe, &flow_def)) &&
+                   flow_def != NULL) {
+                uint64_t flow_id;
+                ubase_assert(uref_flow_get_id(flow_def, &flow_id));
+
+                struct upipe *output = NULL;
+                bool found = false;
+                while (ubase_check(upipe_iterate_sub(upipe, &output)) &&
+                       output != NULL) {
+                    struct uref *flow_def2;
+                    uint64_t id2;
+                    if (ubase_check(upipe_get_flow_def(output, &flow_def2)) &&
+                        ubase_check(uref_flow_get_id(flow_def2, &id2)) &&
+                        flow_id == id2) {
+                        /* We already have an output. */
+                        found = true;
+                        break;
+                    }
+                }
+                if (found)
+                    continue;
+
+                output = upipe_flow_alloc_sub(upipe,
+                    uprobe_pfx_alloc_va(&uprobe_demux_output_s,
+                                        UPROBE_LOG_LEVEL,
+                                        "ts demux output %"PRIu64,
+                                        flow_id), flow_def);
+                assert(output != NULL);
+                output = upipe_void_chain_output(output, upipe_noclock_mgr,
+                    uprobe_pfx_alloc_va(uprobe_use(logger),
+                                        UPROBE_LOG_LEVEL,
+                                        "noclock %"PRIu64, flow_id));
+                assert(output != NULL);
+                output = upipe_void_chain_output_sub(output, upipe_even,
+                    uprobe_pfx_alloc_va(uprobe_use(logger),
+                                        UPROBE_LOG_LEVEL,
+                                        "even %"PRIu64, flow_id));
+                assert(output != NULL);
+
+                struct upipe *upipe_ts_mux_program;
+                ubase_assert(upipe_get_output(upipe, &upipe_ts_mux_program));
+                output = upipe_void_chain_output_sub(output,
+                        upipe_ts_mux_program,
+                        uprobe_pfx_alloc_va(uprobe_use(logger),
+                                            UPROBE_LOG_LEVEL,
+                                            "mux input %"PRIu64, flow_id));
+                assert(output != NULL);
+                upipe_release(output);
+            }
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return uprobe_throw_next(uprobe, upipe, event, args);
+    }
+}
+
+/** probe to catch events from the TS demux */
+static int catch_ts_demux(struct uprobe *uprobe, struct upipe *upipe,
+                          int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_SPLIT_UPDATE: {
+            struct uref *flow_def = NULL;
+            while (ubase_check(upipe_split_iterate(upipe, &flow_def)) &&
+                   flow_def != NULL) {
+                uint64_t flow_id;
+                ubase_assert(uref_flow_get_id(flow_def, &flow_id));
+
+                struct upipe *program = NULL;
+                bool found = false;
+                while (ubase_check(upipe_iterate_sub(upipe, &program)) &&
+                       program != NULL) {
+                    struct uref *flow_def2;
+                    uint64_t id2;
+                    if (ubase_check(upipe_get_flow_def(program, &flow_def2)) &&
+                        ubase_check(uref_flow_get_id(flow_def2, &id2)) &&
+                        flow_id == id2) {
+                        /* We already have a program */
+                        found = true;
+                        break;
+                    }
+                }
+                if (found)
+                    continue;
+
+                program = upipe_flow_alloc_sub(upipe,
+                    uprobe_pfx_alloc_va(&uprobe_demux_program_s,
+                                        UPROBE_LOG_LEVEL,
+                                        "ts demux program %"PRIu64,
+                                        flow_id), flow_def);
+                assert(program != NULL);
+
+                struct upipe *upipe_ts_mux;
+                ubase_assert(upipe_get_output(upipe, &upipe_ts_mux));
+                assert(upipe_ts_mux != NULL);
+
+                program = upipe_void_alloc_output_sub(program,
+                        upipe_ts_mux,
+                        uprobe_pfx_alloc_va(uprobe_use(logger),
+                                            UPROBE_LOG_LEVEL,
+                                            "ts mux program %"PRIu64, flow_id));
+                assert(program != NULL);
+                upipe_release(program);
+            }
+            return UBASE_ERR_NONE;
+        }
+        default:
+            return uprobe_throw_next(uprobe, upipe, event, args);
+    }
+}
+
+/** helper phony pipe counting output packets */
+struct bench_sink {
+    uint64_t nb_packets;
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+static struct upipe *bench_sink_alloc(struct upipe_mgr *mgr,
+                                      struct uprobe *uprobe,
+                                      uint32_t signature, va_list args)
+{
+    struct bench_sink *sink = malloc(sizeof(struct bench_sink));
+    assert(sink != NULL);
+    upipe_init(&sink->upipe, mgr, uprobe);
+    sink->nb_packets = 0;
+    return &sink->upipe;
+}
+
+/** helper phony pipe */
+static void bench_sink_input(struct upipe *upipe, struct uref *uref,
+                             struct upump **upump_p)
+{
+    struct bench_sink *sink = container_of(upipe, struct bench_sink, upipe);
+    size_t size;
+    if (ubase_check(uref_block_size(uref, &size)))
+        sink->nb_packets += size / TS_SIZE;
+    uref_free(uref);
+}
+
+/** helper phony pipe */
+static int bench_sink_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+            return upipe_control_provide_request(upipe, command, args);
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void bench_sink_free(struct upipe *upipe)
+{
+    struct bench_sink *sink = container_of(upipe, struct bench_sink, upipe);
+    upipe_clean(upipe);
+    free(sink);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr bench_sink_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = bench_sink_alloc,
+    .upipe_input = bench_sink_input,
+    .upipe_control = bench_sink_control
+};
+
+/** appends a stuffed TS packet to the synthetic stream */
+static uint8_t *stream_append(uint16_t pid, uint8_t *cc_p)
+{
+    if (stream_packets == stream_alloc) {
+        stream_alloc = stream_alloc ? stream_alloc * 2 : 4096;
+        stream = realloc(stream, stream_alloc * TS_SIZE);
+        assert(stream != NULL);
+    }
+    uint8_t *ts = stream + stream_packets++ * TS_SIZE;
+    memset(ts, 0xff, TS_SIZE);
+    ts_init(ts);
+    ts_set_pid(ts, pid);
+    ts_set_cc(ts, *cc_p);
+    ts_set_payload(ts);
+    *cc_p = (*cc_p + 1) & 0xf;
+    return ts;
+}
+
+/** appends the PAT and the PMTs to the synthetic stream */
+static void stream_put_psi(void)
+{
+    uint8_t *ts = stream_append(0, &pat_cc);
+    ts_set_unitstart(ts);
+    uint8_t *payload = ts_payload(ts);
+    *payload++ = 0; /* pointer_field */
+    pat_init(payload);
+    pat_set_length(payload, nb_programs * PAT_PROGRAM_SIZE);
+    pat_set_tsid(payload, 1);
+    psi_set_version(payload, 0);
+    psi_set_current(payload);
+    psi_set_section(payload, 0);
+    psi_set_lastsection(payload, 0);
+    for (unsigned int i = 0; i < nb_programs; i++) {
+        uint8_t *pat_program = pat_get_program(payload, i);
+        patn_init(pat_program);
+        patn_set_program(pat_program, i + 1);
+        patn_set_pid(pat_program, PMT_PID_BASE * (i + 1));
+    }
+    psi_set_crc(payload);
+
+    for (unsigned int i = 0; i < nb_programs; i++) {
+        uint16_t pmt_pid = PMT_PID_BASE * (i + 1);
+        ts = stream_append(pmt_pid, &pmt_cc[i]);
+        ts_set_unitstart(ts);
+        payload = ts_payload(ts);
+        *payload++ = 0; /* pointer_field */
+        pmt_init(payload);
+        pmt_set_length(payload, nb_es * PMT_ES_SIZE);
+        pmt_set_program(payload, i + 1);
+        psi_set_version(payload, 0);
+        psi_set_current(payload);
+        psi_set_section(payload, 0);
+        psi_set_lastsection(payload, 0);
+        pmt_set_pcrpid(payload, pmt_pid + 1);
+        pmt_set_desclength(payload, 0);
+        for (unsigned int j = 0; j < nb_es; j++) {
+            uint8_t *pmt_es = pmt_get_es(payload, j);
+            pmtn_init(pmt_es);
+            pmtn_set_pid(pmt_es, pmt_pid + 1 + j);
+            pmtn_set_streamtype(pmt_es, PMT_STREAMTYPE_AUDIO_MPEG1);
+            pmtn_set_desclength(pmt_es, 0);
+        }
+        psi_set_crc(payload);
+    }
+}
+
+/** appends an audio frame in a PES to the synthetic stream */
+static void stream_put_pes(uint16_t pid, uint8_t *cc_p, uint64_t pcr,
+                           uint64_t pts)
+{
+    static const uint8_t header[] = { MPGA_HEADER };
+    uint8_t pes[PES_HEADER_SIZE_PTS + MPGA_FRAME_SIZE];
+    pes_init(pes);
+    pes_set_streamid(pes, PES_STREAM_ID_AUDIO_MPEG);
+    pes_set_length(pes, sizeof(pes) - PES_HEADER_SIZE);
+    pes_set_headerlength(pes, PES_HEADER_SIZE_PTS - PES_HEADER_SIZE_NOPTS);
+    pes_set_dataalignment(pes);
+    pes_set_pts(pes, pts / 300);
+    uint8_t *payload = pes_payload(pes);
+    memcpy(payload, header, sizeof(header));
+    memset(payload + sizeof(header), 0, MPGA_FRAME_SIZE - sizeof(header));
+
+    size_t offset = 0;
+    while (offset < sizeof(pes)) {
+        uint8_t *ts = stream_append(pid, cc_p);
+        size_t room = TS_SIZE - TS_HEADER_SIZE;
+        bool has_pcr = pcr != UINT64_MAX && !offset;
+        if (has_pcr)
+            room -= TS_HEADER_SIZE_PCR - TS_HEADER_SIZE;
+        size_t size = sizeof(pes) - offset;
+        if (size > room)
+            size = room;
+        if (!offset)
+            ts_set_unitstart(ts);
+        if (has_pcr || size < TS_SIZE - TS_HEADER_SIZE)
+            ts_set_adaptation(ts, TS_SIZE - TS_HEADER_SIZE - 1 - size);
+        if (has_pcr) {
+            tsaf_set_pcr(ts, pcr / 300);
+            tsaf_set_pcrext(ts, pcr % 300);
+        }
+        memcpy(ts_payload(ts), pes + offset, size);
+        offset += size;
+    }
+}
+
+/** generates the synthetic stream */
+static void stream_generate(void)
+{
+    uint64_t nb_frames = (uint64_t)duration * UCLOCK_FREQ /
+                         MPGA_FRAME_DURATION;
+    for (uint64_t frame = 0; frame < nb_frames; frame++) {
+        uint64_t pcr = UCLOCK_FREQ + frame * MPGA_FRAME_DURATION;
+        if (!(frame % PSI_INTERVAL))
+            stream_put_psi();
+        for (unsigned int i = 0; i < nb_programs; i++) {
+            uint16_t pmt_pid = PMT_PID_BASE * (i + 1);
+            for (unsigned int j = 0; j < nb_es; j++)
+                stream_put_pes(pmt_pid + 1 + j, &es_cc[i][j],
+                               j ? UINT64_MAX : pcr, pcr + PTS_DELAY);
+        }
+    }
+}
+
+#ifdef __linux__
+/** opens a hardware counter of cache misses for this thread */
+static int perf_open(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+/** returns the number of system allocations of the managers */
+static uint64_t get_misses(struct umem_mgr *umem_mgr,
+                           struct udict_mgr *udict_mgr)
+{
+    struct ualloc_stats stats;
+    ualloc_stats_init(&stats);
+    uint64_t misses = 0;
+    if (ubase_check(umem_mgr_get_stats(umem_mgr, &stats)))
+        misses += stats.misses;
+    ualloc_stats_init(&stats);
+    if (ubase_check(udict_mgr_get_stats(udict_mgr, &stats)))
+        misses += stats.misses;
+    return misses;
+}
+
+static void usage(const char *argv0) {
+    fprintf(stdout, "Usage: %s [-p <programs>] [-e <PIDs per program>] "
+            "[-d <duration in s>]\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:e:d:")) != -1) {
+        switch (opt) {
+            case 'p':
+                nb_programs = atoi(optarg);
+                break;
+            case 'e':
+                nb_es = atoi(optarg);
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (!nb_programs || nb_programs > MAX_PROGRAMS ||
+        !nb_es || nb_es > MAX_ES || !duration)
+        usage(argv[0]);
+
+    memset(pmt_cc, 0, sizeof(pmt_cc));
+    memset(es_cc, 0, sizeof(es_cc));
+    stream_generate();
+
+    struct umem_mgr *umem_mgr = umem_pool_mgr_alloc_simple(UMEM_POOL_DEPTH);
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uclock *uclock = uclock_std_alloc(0);
+    assert(uclock != NULL);
+
+    struct uprobe uprobe_s;
+    uprobe_init(&uprobe_s, catch, NULL);
+    logger = uprobe_stdio_alloc(&uprobe_s, stdout, UPROBE_LOG_LEVEL);
+    assert(logger != NULL);
+    logger = uprobe_uref_mgr_alloc(logger, uref_mgr);
+    assert(logger != NULL);
+    logger = uprobe_ubuf_mem_alloc(logger, umem_mgr, UBUF_POOL_DEPTH,
+                                   UBUF_POOL_DEPTH);
+    assert(logger != NULL);
+
+    upipe_noclock_mgr = upipe_noclock_mgr_alloc();
+    assert(upipe_noclock_mgr != NULL);
+
+    struct upipe_mgr *upipe_even_mgr = upipe_even_mgr_alloc();
+    assert(upipe_even_mgr != NULL);
+    upipe_even = upipe_void_alloc(upipe_even_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger),
+                             UPROBE_LOG_LEVEL, "even"));
+    assert(upipe_even != NULL);
+    upipe_mgr_release(upipe_even_mgr);
+
+    /* TS demux */
+    uprobe_init(&uprobe_demux_output_s, catch_ts_demux_output,
+                uprobe_use(logger));
+    uprobe_init(&uprobe_demux_program_s, catch_ts_demux_program,
+                uprobe_use(logger));
+    struct uprobe uprobe_ts_demux_s;
+    uprobe_init(&uprobe_ts_demux_s, catch_ts_demux, uprobe_use(logger));
+
+    struct upipe_mgr *upipe_autof_mgr = upipe_autof_mgr_alloc();
+    assert(upipe_autof_mgr != NULL);
+    struct upipe_mgr *upipe_ts_demux_mgr = upipe_ts_demux_mgr_alloc();
+    assert(upipe_ts_demux_mgr != NULL);
+    ubase_assert(upipe_ts_demux_mgr_set_autof_mgr(upipe_ts_demux_mgr,
+                                                  upipe_autof_mgr));
+
+    struct upipe *upipe_ts_demux = upipe_void_alloc(upipe_ts_demux_mgr,
+            uprobe_pfx_alloc(&uprobe_ts_demux_s,
+                             UPROBE_LOG_LEVEL, "ts demux"));
+    assert(upipe_ts_demux != NULL);
+    struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(flow_def != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_demux, flow_def));
+    uref_free(flow_def);
+    upipe_mgr_release(upipe_ts_demux_mgr);
+    upipe_mgr_release(upipe_autof_mgr);
+    ubase_assert(upipe_ts_demux_set_conformance(upipe_ts_demux,
+                                                UPIPE_TS_CONFORMANCE_ISO));
+
+    /* TS mux */
+    struct upipe_mgr *upipe_ts_mux_mgr = upipe_ts_mux_mgr_alloc();
+    assert(upipe_ts_mux_mgr != NULL);
+    struct upipe *upipe_ts_mux = upipe_void_alloc_output(upipe_ts_demux,
+            upipe_ts_mux_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "ts mux"));
+    assert(upipe_ts_mux != NULL);
+    upipe_mgr_release(upipe_ts_mux_mgr);
+    ubase_assert(upipe_ts_mux_set_mode(upipe_ts_mux,
+                                       UPIPE_TS_MUX_MODE_CAPPED));
+    ubase_assert(upipe_ts_mux_set_cr_prog(upipe_ts_mux, 0));
+
+    struct upipe *upipe_sink = upipe_void_alloc(&bench_sink_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                             "sink"));
+    assert(upipe_sink != NULL);
+    ubase_assert(upipe_set_output(upipe_ts_mux, upipe_sink));
+    upipe_release(upipe_ts_mux);
+
+    int perf_fd = -1;
+#ifdef __linux__
+    perf_fd = perf_open();
+    if (perf_fd != -1) {
+        ioctl(perf_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    uint64_t misses = get_misses(umem_mgr, udict_mgr);
+    uint64_t start = uclock_now(uclock);
+
+    for (size_t i = 0; i < stream_packets; i += BLOCK_PACKETS) {
+        size_t nb = stream_packets - i < BLOCK_PACKETS ?
+                    stream_packets - i : BLOCK_PACKETS;
+        struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                             nb * TS_SIZE);
+        assert(uref != NULL);
+        uint8_t *buffer;
+        int size = -1;
+        ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+        assert(size == (int)(nb * TS_SIZE));
+        memcpy(buffer, stream + i * TS_SIZE, size);
+        uref_block_unmap(uref, 0);
+        upipe_input(upipe_ts_demux, uref, NULL);
+    }
+    upipe_release(upipe_ts_demux);
+
+    uint64_t elapsed = uclock_now(uclock) - start;
+    misses = get_misses(umem_mgr, udict_mgr) - misses;
+    uint64_t cache_misses = 0;
+#ifdef __linux__
+    if (perf_fd != -1) {
+        ioctl(perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(perf_fd, &cache_misses, sizeof(cache_misses)) !=
+                sizeof(cache_misses))
+            perf_fd = -1;
+        close(perf_fd);
+    }
+#endif
+
+    struct bench_sink *sink = container_of(upipe_sink, struct bench_sink,
+                                           upipe);
+    double ns = (double)elapsed * 1000 / (UCLOCK_FREQ / 1000000);
+    printf("programs: %u, PIDs per program: %u, duration: %u s\n",
+           nb_programs, nb_es, duration);
+    printf("input packets: %zu, output packets: %"PRIu64"\n",
+           stream_packets, sink->nb_packets);
+    printf("packets/s: %.0f\n", stream_packets * 1e9 / ns);
+    printf("ns/packet: %.1f\n", ns / stream_packets);
+    printf("allocations/packet: %.3f\n", (double)misses / stream_packets);
+    if (perf_fd != -1)
+        printf("cache misses/packet: %.2f\n",
+               (double)cache_misses / stream_packets);
+    else
+        printf("cache misses/packet: unavailable\n");
+
+    upipe_release(upipe_even);
+    bench_sink_free(upipe_sink);
+    free(stream);
+
+    uclock_release(uclock);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+    uprobe_clean(&uprobe_demux_output_s);
+    uprobe_clean(&uprobe_demux_program_s);
+    uprobe_clean(&uprobe_ts_demux_s);
+    uprobe_clean(&uprobe_s);
+
+    return 0;
+}
@@ -57,6 +57,8 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static unsigned int nb_packets = 0;
+static int nb_urefs = 0;
+static bool packed = false;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -91,16 +93,20 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
-    assert(size == TS_SIZE);
+    assert(size && !(size % TS_SIZE));
+    assert(packed || size == TS_SIZE);
 
-    const uint8_t *buffer;
-    int rsize = 1;
-    ubase_assert(uref_block_read(uref, 0, &rsize, &buffer));
-    assert(rsize == 1);
-    assert(ts_validate(buffer));
-    uref_block_unmap(uref, 0);
+    for (int offset = 0; offset < (int)size; offset += TS_SIZE) {
+        const uint8_t *buffer;
+        int rsize = 1;
+        ubase_assert(uref_block_read(uref, offset, &rsize, &buffer));
+        assert(rsize == 1);
+        assert(ts_validate(buffer));
+        uref_block_unmap(uref, offset);
+        nb_packets--;
+    }
     uref_free(uref);
-    nb_packets--;
+    nb_urefs--;
 }
 
 /** helper phony pipe */
@@ -210,6 +216,42 @@ int main(int argc, char *argv[])
     upipe_input(upipe_ts_check, uref, NULL);
     assert(!nb_packets);
 
+    /* packed mode */
+    ubase_assert(upipe_ts_check_set_packed(upipe_ts_check, true));
+    bool packed_mode;
+    ubase_assert(upipe_ts_check_get_packed(upipe_ts_check, &packed_mode));
+    assert(packed_mode);
+    packed = true;
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 7 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 7 * TS_SIZE);
+    for (i = 0; i < 7; i++)
+        ts_pad(buffer + i * TS_SIZE);
+    uref_block_unmap(uref, 0);
+    nb_packets = 7;
+    nb_urefs = 1;
+    upipe_input(upipe_ts_check, uref, NULL);
+    assert(!nb_packets);
+    assert(!nb_urefs);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 7 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 7 * TS_SIZE);
+    for (i = 0; i < 7; i++)
+        ts_pad(buffer + i * TS_SIZE);
+    buffer[3 * TS_SIZE] = 0xff;
+    uref_block_unmap(uref, 0);
+    nb_packets = 3;
+    nb_urefs = 1;
+    upipe_input(upipe_ts_check, uref, NULL);
+    assert(!nb_packets);
+    assert(!nb_urefs);
+
     upipe_release(upipe_ts_check);
     upipe_mgr_release(upipe_ts_check_mgr); // nop
 
@@ -64,6 +64,7 @@ static int transporterror = UBASE_ERR_INVALID;
 static int discontinuity = UBASE_ERR_NONE;
 static int start = UBASE_ERR_NONE;
 static size_t payload_size = 184;
+static uint64_t lost = 0;
 
 /** definition of our uprobe */
 static int catch(struct uprobe *uprobe, struct upipe *upipe,
@@ -86,6 +87,9 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
             pcr = 0;
             break;
         }
+        case UPROBE_DISCONTINUITY:
+            lost += va_arg(args, uint64_t);
+            break;
     }
     return UBASE_ERR_NONE;
 }
@@ -235,6 +239,7 @@ int main(int argc, char *argv[])
     upipe_input(upipe_ts_decaps, uref, NULL);
     assert(!nb_packets);
     assert(!pcr);
+    assert(lost == 1);
 
     upipe_release(upipe_ts_decaps);
     upipe_mgr_release(upipe_ts_decaps_mgr); // nop
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for TS PCR interpolator module in multiplex mode
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block_mem.h"
+#include "upipe/uref.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+#include "upipe-ts/upipe_ts_pcr_interpolator.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+/** number of TS packets per block */
+#define BLOCK_PACKETS 7
+/** PCR PID */
+#define PCR_PID 100
+/** PCR increment between two PCR packets, every two blocks */
+#define PCR_DELTA 54000
+/** expected octetrate */
+#define OCTETRATE (2 * BLOCK_PACKETS * TS_SIZE * UINT64_C(27000000) / PCR_DELTA)
+/** 2^33 * 300 */
+#define PCR_WRAP (UINT64_C(8589934592) * 300)
+
+static unsigned int nb_packets = 0;
+static uint64_t expected_cr = 0;
+static bool expected_discontinuity = true;
+static uint64_t octetrate = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_CLOCK_TS:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    uint64_t cr_prog;
+    ubase_assert(uref_clock_get_cr_prog(uref, &cr_prog));
+    assert(cr_prog == expected_cr);
+    assert(ubase_check(uref_flow_get_discontinuity(uref)) ==
+           expected_discontinuity);
+    expected_discontinuity = false;
+    uref_free(uref);
+    nb_packets++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_SET_FLOW_DEF: {
+            struct uref *flow_def = va_arg(args, struct uref *);
+            uref_block_flow_get_octetrate(flow_def, &octetrate);
+            return UBASE_ERR_NONE;
+        }
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** sends a block of TS packets, the first one carrying a PCR if pcr != 0 */
+static void send_block(struct upipe *upipe, struct uref_mgr *uref_mgr,
+                       struct ubuf_mgr *ubuf_mgr, uint64_t pcr)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                         BLOCK_PACKETS * TS_SIZE);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == BLOCK_PACKETS * TS_SIZE);
+    for (int i = 0; i < BLOCK_PACKETS; i++) {
+        uint8_t *ts = buffer + i * TS_SIZE;
+        ts_init(ts);
+        ts_set_payload(ts);
+        ts_set_pid(ts, i ? PCR_PID + 1 : PCR_PID);
+        if (!i && pcr) {
+            ts_set_adaptation(ts, TS_HEADER_SIZE_PCR - TS_HEADER_SIZE - 1);
+            tsaf_set_pcr(ts, (pcr % PCR_WRAP) / 300);
+            tsaf_set_pcrext(ts, (pcr % PCR_WRAP) % 300);
+        }
+    }
+    uref_block_unmap(uref, 0);
+    upipe_input(upipe, uref, NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(uprobe_stdio));
+    assert(upipe_sink != NULL);
+
+    struct uref *uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+
+    struct upipe_mgr *upipe_ts_pcr_interpolator_mgr =
+        upipe_ts_pcr_interpolator_mgr_alloc();
+    assert(upipe_ts_pcr_interpolator_mgr != NULL);
+    struct upipe *upipe_ts_pcr_interpolator =
+        upipe_void_alloc(upipe_ts_pcr_interpolator_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts pcr interpolator"));
+    assert(upipe_ts_pcr_interpolator != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_pcr_interpolator, uref));
+    ubase_assert(upipe_set_output(upipe_ts_pcr_interpolator, upipe_sink));
+    uref_free(uref);
+
+    ubase_nassert(upipe_ts_pcr_interpolator_set_pcr_pid(
+                upipe_ts_pcr_interpolator, 8193));
+    ubase_assert(upipe_ts_pcr_interpolator_set_pcr_pid(
+                upipe_ts_pcr_interpolator, 8192));
+
+    /* start close to the wraparound to check PCR unwrapping */
+    uint64_t pcr = PCR_WRAP - 3 * PCR_DELTA;
+    for (int i = 0; i < 16; i++) {
+        if (i % 2 == 0)
+            expected_cr = pcr + (i / 2) * PCR_DELTA;
+        else
+            expected_cr = pcr + (i / 2) * PCR_DELTA + PCR_DELTA / 2;
+        send_block(upipe_ts_pcr_interpolator, uref_mgr, ubuf_mgr,
+                   i % 2 ? 0 : expected_cr);
+    }
+    /* the first PCR interval is needed to compute the rate */
+    assert(nb_packets == 14);
+    assert(octetrate == OCTETRATE);
+
+    struct urational bitrate;
+    ubase_assert(upipe_ts_pcr_interpolator_get_bitrate(
+                upipe_ts_pcr_interpolator, &bitrate));
+    assert(bitrate.num == 2 * BLOCK_PACKETS * TS_SIZE * 8);
+    assert(bitrate.den == PCR_DELTA);
+
+    upipe_release(upipe_ts_pcr_interpolator);
+    upipe_mgr_release(upipe_ts_pcr_interpolator_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
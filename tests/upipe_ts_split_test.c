@@ -91,6 +91,8 @@ static int catch(struct uprobe *uprobe, struct upipe *upipe,
 struct test {
     uint16_t pid;
     bool got_packet;
+    unsigned int nb_urefs;
+    unsigned int nb_packets;
     struct upipe upipe;
 };
 
@@ -105,6 +107,8 @@ static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
     assert(test != NULL);
     upipe_init(&test->upipe, mgr, uprobe);
     test->got_packet = false;
+    test->nb_urefs = 0;
+    test->nb_packets = 0;
     test->pid = pid;
     return &test->upipe;
 }
@@ -116,13 +120,20 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     struct test *test = container_of(upipe, struct test, upipe);
     assert(uref != NULL);
     test->got_packet = true;
-    const uint8_t *buffer;
-    int size = -1;
-    ubase_assert(uref_block_read(uref, 0, &size, &buffer));
-    assert(size == TS_SIZE); //because of the way we allocated it
-    assert(ts_validate(buffer));
-    assert(ts_get_pid(buffer) == test->pid);
-    uref_block_unmap(uref, 0);
+    test->nb_urefs++;
+    size_t total;
+    ubase_assert(uref_block_size(uref, &total));
+    assert(total && !(total % TS_SIZE));
+    for (int offset = 0; offset < (int)total; offset += TS_SIZE) {
+        const uint8_t *buffer;
+        int size = TS_SIZE;
+        ubase_assert(uref_block_read(uref, offset, &size, &buffer));
+        assert(size == TS_SIZE); //because of the way we allocated it
+        assert(ts_validate(buffer));
+        assert(ts_get_pid(buffer) == test->pid);
+        uref_block_unmap(uref, offset);
+        test->nb_packets++;
+    }
     uref_free(uref);
 }
 
@@ -232,6 +243,28 @@ int main(int argc, char *argv[])
     uref_block_unmap(uref, 0);
     upipe_input(upipe_ts_split, uref, NULL);
 
+    struct test *test68 = container_of(upipe_sink68, struct test, upipe);
+    struct test *test69 = container_of(upipe_sink69, struct test, upipe);
+    assert(test68->nb_urefs == 1 && test68->nb_packets == 1);
+    assert(test69->nb_urefs == 1 && test69->nb_packets == 1);
+
+    /* multi-packet block: runs of the same PID are output at once */
+    static const uint16_t pids[] = { 68, 68, 69, 68, 68, 68, 70 };
+    int nb_pids = sizeof(pids) / sizeof(pids[0]);
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, nb_pids * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == nb_pids * TS_SIZE);
+    for (int i = 0; i < nb_pids; i++) {
+        ts_pad(buffer + i * TS_SIZE);
+        ts_set_pid(buffer + i * TS_SIZE, pids[i]);
+    }
+    uref_block_unmap(uref, 0);
+    upipe_input(upipe_ts_split, uref, NULL);
+    assert(test68->nb_urefs == 3 && test68->nb_packets == 6);
+    assert(test69->nb_urefs == 2 && test69->nb_packets == 2);
+
     upipe_release(upipe_ts_split_output68);
     upipe_release(upipe_ts_split_output69);
     upipe_release(upipe_ts_split);
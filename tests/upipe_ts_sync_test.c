@@ -57,6 +57,8 @@
 #define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
 
 static unsigned int nb_packets = 0;
+static int nb_urefs = 0;
+static bool packed = false;
 static int expect_loss = -1;
 
 /** definition of our uprobe */
@@ -96,16 +98,20 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     size_t size;
     ubase_assert(uref_block_size(uref, &size));
-    assert(size == TS_SIZE);
+    assert(size && !(size % TS_SIZE));
+    assert(packed || size == TS_SIZE);
 
-    const uint8_t *buffer;
-    int rsize = 1;
-    ubase_assert(uref_block_read(uref, 0, &rsize, &buffer));
-    assert(rsize == 1);
-    assert(ts_validate(buffer));
-    uref_block_unmap(uref, 0);
+    for (int offset = 0; offset < (int)size; offset += TS_SIZE) {
+        const uint8_t *buffer;
+        int rsize = 1;
+        ubase_assert(uref_block_read(uref, offset, &rsize, &buffer));
+        assert(rsize == 1);
+        assert(ts_validate(buffer));
+        uref_block_unmap(uref, offset);
+        nb_packets--;
+    }
     uref_free(uref);
-    nb_packets--;
+    nb_urefs--;
 }
 
 /** helper phony pipe */
@@ -236,6 +242,43 @@ int main(int argc, char *argv[])
     nb_packets++;
     upipe_release(upipe_ts_sync);
     assert(!nb_packets);
+
+    /* packed mode */
+    upipe_ts_sync = upipe_void_alloc(upipe_ts_sync_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts sync packed"));
+    assert(upipe_ts_sync != NULL);
+    ubase_assert(upipe_ts_sync_set_packed(upipe_ts_sync, true));
+    bool packed_mode;
+    ubase_assert(upipe_ts_sync_get_packed(upipe_ts_sync, &packed_mode));
+    assert(packed_mode);
+    packed = true;
+    uref = uref_block_flow_alloc_def(uref_mgr, NULL);
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_sync, uref));
+    ubase_assert(upipe_set_output(upipe_ts_sync, upipe_sink));
+    uref_free(uref);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, 7 * TS_SIZE);
+    assert(uref != NULL);
+    size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == 7 * TS_SIZE);
+    for (int i = 0; i < 7; i++)
+        ts_pad(buffer + i * TS_SIZE);
+    uref_block_unmap(uref, 0);
+    /* the last packet waits for the next sync word */
+    nb_packets = 6;
+    nb_urefs = 1;
+    upipe_input(upipe_ts_sync, uref, NULL);
+    assert(!nb_packets);
+    assert(!nb_urefs);
+
+    nb_packets = 1;
+    nb_urefs = 1;
+    upipe_release(upipe_ts_sync);
+    assert(!nb_packets);
+    assert(!nb_urefs);
     upipe_mgr_release(upipe_ts_sync_mgr); // nop
 
     test_free(upipe_sink);
@@ -0,0 +1,297 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for TS variant module
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block_mem.h"
+#include "upipe/uref.h"
+#include "upipe/uref_flow.h"
+#include "upipe/uref_block_flow.h"
+#include "upipe/uref_block.h"
+#include "upipe/uref_std.h"
+#include "upipe/upipe.h"
+#include "upipe-ts/upipe_ts_variant.h"
+#include "upipe-ts/uref_ts_flow.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <bitstream/mpeg/ts.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UBUF_POOL_DEPTH 0
+#define UPROBE_LOG_LEVEL UPROBE_LOG_DEBUG
+/** number of TS packets per block */
+#define BLOCK_PACKETS 7
+/** size of the variant section */
+#define SECTION_SIZE 200
+
+static const uint16_t pids[BLOCK_PACKETS] = {
+    0, 100, 8191, 100, 0, 8191, 8191
+};
+static unsigned int nb_packets = 0;
+static struct ubuf *expected_ubuf = NULL;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    switch (event) {
+        default:
+            assert(0);
+            break;
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    assert(uref != NULL);
+    const uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_read(uref, 0, &size, &buffer));
+    assert(size == BLOCK_PACKETS * TS_SIZE);
+
+    if (expected_ubuf != NULL) {
+        /* nothing to rewrite, the buffer must be shared */
+        assert(uref->ubuf == expected_ubuf);
+        for (int i = 0; i < BLOCK_PACKETS; i++)
+            assert(ts_get_pid(buffer + i * TS_SIZE) == 100);
+    } else {
+        /* first part of the section in place of the input PAT */
+        const uint8_t *ts = buffer;
+        assert(ts_get_pid(ts) == 0);
+        assert(ts_get_unitstart(ts));
+        assert(ts_get_cc(ts) == 1);
+        assert(ts[TS_HEADER_SIZE] == 0);
+        for (int i = TS_HEADER_SIZE + 1; i < TS_SIZE; i++)
+            assert(ts[i] == 0x42);
+
+        assert(ts_get_pid(buffer + TS_SIZE) == 100);
+        assert(buffer[TS_SIZE + TS_HEADER_SIZE] == 0xaa);
+
+        /* second part in place of the first padding packet */
+        ts = buffer + 2 * TS_SIZE;
+        assert(ts_get_pid(ts) == 0);
+        assert(!ts_get_unitstart(ts));
+        assert(ts_get_cc(ts) == 2);
+        int remaining = SECTION_SIZE - (TS_SIZE - TS_HEADER_SIZE - 1);
+        for (int i = 0; i < TS_SIZE - TS_HEADER_SIZE; i++)
+            assert(ts[TS_HEADER_SIZE + i] == (i < remaining ? 0x42 : 0xff));
+
+        assert(ts_get_pid(buffer + 3 * TS_SIZE) == 100);
+        /* input PAT without variant data becomes padding */
+        assert(ts_get_pid(buffer + 4 * TS_SIZE) == 8191);
+        assert(buffer[4 * TS_SIZE + TS_HEADER_SIZE] == 0xff);
+        assert(ts_get_pid(buffer + 5 * TS_SIZE) == 8191);
+        assert(ts_get_pid(buffer + 6 * TS_SIZE) == 8191);
+    }
+    uref_block_unmap(uref, 0);
+    uref_free(uref);
+    nb_packets++;
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    switch (command) {
+        case UPIPE_REGISTER_REQUEST:
+        case UPIPE_UNREGISTER_REQUEST:
+        case UPIPE_SET_FLOW_DEF:
+            return UBASE_ERR_NONE;
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+/** allocates a block of TS packets with the given PIDs */
+static struct uref *alloc_block(struct uref_mgr *uref_mgr,
+                                struct ubuf_mgr *ubuf_mgr,
+                                const uint16_t *block_pids)
+{
+    struct uref *uref = uref_block_alloc(uref_mgr, ubuf_mgr,
+                                         BLOCK_PACKETS * TS_SIZE);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    assert(size == BLOCK_PACKETS * TS_SIZE);
+    for (int i = 0; i < BLOCK_PACKETS; i++) {
+        uint8_t *ts = buffer + i * TS_SIZE;
+        if (block_pids[i] == 8191) {
+            ts_pad(ts);
+            continue;
+        }
+        ts_init(ts);
+        ts_set_payload(ts);
+        ts_set_pid(ts, block_pids[i]);
+        memset(ts + TS_HEADER_SIZE, 0xaa, TS_SIZE - TS_HEADER_SIZE);
+    }
+    uref_block_unmap(uref, 0);
+    return uref;
+}
+
+int main(int argc, char *argv[])
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, 0, 0, -1, 0);
+    assert(ubuf_mgr != NULL);
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_stdio = uprobe_stdio_alloc(&uprobe, stdout,
+                                                     UPROBE_LOG_LEVEL);
+    assert(uprobe_stdio != NULL);
+
+    struct upipe *upipe_sink = upipe_void_alloc(&test_mgr,
+                                                uprobe_use(uprobe_stdio));
+    assert(upipe_sink != NULL);
+
+    struct upipe_mgr *upipe_ts_variant_mgr = upipe_ts_variant_mgr_alloc();
+    assert(upipe_ts_variant_mgr != NULL);
+    struct upipe *upipe_ts_variant = upipe_void_alloc(upipe_ts_variant_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts variant"));
+    assert(upipe_ts_variant != NULL);
+
+    struct uref *uref = uref_block_flow_alloc_def(uref_mgr, "mpegts.");
+    assert(uref != NULL);
+    ubase_assert(upipe_set_flow_def(upipe_ts_variant, uref));
+    ubase_assert(upipe_set_output(upipe_ts_variant, upipe_sink));
+    uref_free(uref);
+
+    struct upipe *upipe_ts_variant_sub = upipe_void_alloc_sub(upipe_ts_variant,
+            uprobe_pfx_alloc(uprobe_use(uprobe_stdio), UPROBE_LOG_LEVEL,
+                             "ts variant pat"));
+    assert(upipe_ts_variant_sub != NULL);
+    uref = uref_block_flow_alloc_def(uref_mgr, "mpegtspsi.mpegtspat.");
+    assert(uref != NULL);
+    ubase_nassert(upipe_set_flow_def(upipe_ts_variant_sub, uref));
+    ubase_assert(uref_ts_flow_set_pid(uref, 0));
+    ubase_assert(upipe_set_flow_def(upipe_ts_variant_sub, uref));
+    uref_free(uref);
+
+    uref = uref_block_alloc(uref_mgr, ubuf_mgr, SECTION_SIZE);
+    assert(uref != NULL);
+    uint8_t *buffer;
+    int size = -1;
+    ubase_assert(uref_block_write(uref, 0, &size, &buffer));
+    memset(buffer, 0x42, size);
+    uref_block_unmap(uref, 0);
+    upipe_input(upipe_ts_variant_sub, uref, NULL);
+
+    /* the input buffer is shared with another variant */
+    uref = alloc_block(uref_mgr, ubuf_mgr, pids);
+    struct uref *shared = uref_dup(uref);
+    assert(shared != NULL);
+    upipe_input(upipe_ts_variant, uref, NULL);
+    assert(nb_packets == 1);
+
+    const uint8_t *read_buffer;
+    size = -1;
+    ubase_assert(uref_block_read(shared, 0, &size, &read_buffer));
+    for (int i = 0; i < BLOCK_PACKETS; i++)
+        assert(ts_get_pid(read_buffer + i * TS_SIZE) == pids[i]);
+    assert(read_buffer[TS_HEADER_SIZE] == 0xaa);
+    uref_block_unmap(shared, 0);
+    uref_free(shared);
+
+    static const uint16_t es_pids[BLOCK_PACKETS] = {
+        100, 100, 100, 100, 100, 100, 100
+    };
+    uref = alloc_block(uref_mgr, ubuf_mgr, es_pids);
+    expected_ubuf = uref->ubuf;
+    upipe_input(upipe_ts_variant, uref, NULL);
+    assert(nb_packets == 2);
+
+    upipe_release(upipe_ts_variant_sub);
+    upipe_release(upipe_ts_variant);
+    upipe_mgr_release(upipe_ts_variant_mgr); // nop
+
+    test_free(upipe_sink);
+
+    uref_mgr_release(uref_mgr);
+    ubuf_mgr_release(ubuf_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(uprobe_stdio);
+    uprobe_clean(&uprobe);
+
+    return 0;
+}
@@ -48,6 +48,7 @@
 #include "upipe/uref.h"
 #include "upipe/uref_block.h"
 #include "upipe/uref_block_flow.h"
+#include "upipe/uref_clock.h"
 #include "upipe/uref_std.h"
 #include "upipe/upump.h"
 #include "upump-ev/upump_ev.h"
@@ -145,6 +146,8 @@ static void test_input(struct upipe *upipe, struct uref *uref,
     const uint8_t *rbuf;
     struct udpsrc_test *udpsrc_test = udpsrc_test_from_upipe(upipe);
     assert(uref != NULL);
+    uint64_t cr_sys;
+    ubase_assert(uref_clock_get_cr_sys(uref, &cr_sys));
 
     if ((rbuf = uref_block_peek(uref, 0, -1, buf))) {
         upipe_dbg_va(upipe, "Received string: %s", rbuf);
@@ -334,6 +337,38 @@ int main(int argc, char *argv[])
     close(sockfd);
     upump_free(write_pump);
 
+    /* several sources may share a port with the reuseport option */
+    struct upipe *upipe_udpsrc_shards[2];
+    for (i = 0; i < 2; i++) {
+        upipe_udpsrc_shards[i] = upipe_void_alloc(upipe_udpsrc_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(logger), UPROBE_LOG_LEVEL,
+                                    "udp shard %d", i));
+        assert(upipe_udpsrc_shards[i] != NULL);
+    }
+    for (i = 0; i < 10; i++) {
+        port = ((rand() % 40000) + 1024);
+        snprintf(udp_uri, sizeof(udp_uri), "@127.0.0.1:%d/reuseport", port);
+        printf("Trying uri: %s ...\n", udp_uri);
+        if (( ret = ubase_check(upipe_set_uri(upipe_udpsrc_shards[0],
+                                              udp_uri)) )) {
+            break;
+        }
+    }
+    assert(ret);
+    ubase_assert(upipe_set_uri(upipe_udpsrc_shards[1], udp_uri));
+#ifdef SO_REUSEPORT
+    for (i = 0; i < 2; i++) {
+        int fd, reuseport = 0;
+        socklen_t len = sizeof(reuseport);
+        ubase_assert(upipe_udpsrc_get_fd(upipe_udpsrc_shards[i], &fd));
+        assert(getsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &reuseport,
+                          &len) == 0);
+        assert(reuseport);
+    }
+#endif
+    for (i = 0; i < 2; i++)
+        upipe_release(upipe_udpsrc_shards[i]);
+
     /* now test upipe_udp_sink */
     struct uref *flow_def = uref_block_flow_alloc_def(uref_mgr, "bar");
     struct upipe_mgr *upipe_udpsink_mgr = upipe_udpsink_mgr_alloc();
@@ -356,6 +391,26 @@ int main(int argc, char *argv[])
     }
     assert(ret);
     ubase_assert(upipe_set_uri(upipe_udpsink, udp_uri+1));
+#ifdef UPIPE_HAVE_RECVMMSG
+    ubase_nassert(upipe_udpsrc_set_batch_size(upipe_udpsrc, 0));
+    ubase_assert(upipe_udpsrc_set_batch_size(upipe_udpsrc, 8));
+    unsigned int batch_size;
+    ubase_assert(upipe_udpsrc_get_batch_size(upipe_udpsrc, &batch_size));
+    assert(batch_size == 8);
+#endif
+#ifdef UPIPE_HAVE_LINUX_NET_TSTAMP_H
+    ubase_nassert(upipe_udpsrc_set_timestamping(upipe_udpsrc, 42));
+    ubase_assert(upipe_udpsrc_set_timestamping(upipe_udpsrc,
+                UPIPE_UDPSRC_TIMESTAMPING_SOFTWARE));
+    enum upipe_udpsrc_timestamping timestamping;
+    ubase_assert(upipe_udpsrc_get_timestamping(upipe_udpsrc, &timestamping));
+    assert(timestamping == UPIPE_UDPSRC_TIMESTAMPING_SOFTWARE);
+#endif
+    /* datagrams which are not made of TS packets go through the filter */
+    ubase_nassert(upipe_udpsrc_add_pid(upipe_udpsrc, 68));
+    ubase_assert(upipe_udpsrc_set_pid_filter(upipe_udpsrc, true));
+    ubase_nassert(upipe_udpsrc_add_pid(upipe_udpsrc, 8192));
+    ubase_assert(upipe_udpsrc_add_pid(upipe_udpsrc, 68));
 
     /* redefine write pump */
     write_pump = upump_alloc_idler(upump_mgr, genpackets2, NULL, NULL);
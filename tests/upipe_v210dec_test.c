@@ -51,6 +51,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include <assert.h>
 
 #define UDICT_POOL_DEPTH    0
@@ -61,7 +62,7 @@
 #define UBUF_ALIGN 32
 
 #define TEST_WIDTH 1920
-#define TEST_HEIGHT 1
+#define TEST_HEIGHT 4
 
 const char *v210_chroma = "u10y10v10y10u10y10v10y10u10y10v10y10";
 
@@ -119,7 +120,7 @@ static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
     return upipe;
 }
 
-bool test_sucessful = false;
+unsigned int nb_tested = 0;
 
 /** helper phony pipe */
 static void test_input(struct upipe *upipe, struct uref *uref,
@@ -150,7 +151,7 @@ static void test_input(struct upipe *upipe, struct uref *uref,
 
         upipe_dbg(upipe, "y8 plane tested correctly");
         uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1);
-        test_sucessful = true;
+        nb_tested++;
     }
 
     else if (ubase_check(uref_pic_plane_read(uref, "y10l", 0, 0, -1, -1, &buffer)) &&
@@ -168,7 +169,25 @@ static void test_input(struct upipe *upipe, struct uref *uref,
 
         upipe_dbg(upipe, "y10 plane tested correctly");
         uref_pic_plane_unmap(uref, "y10l", 0, 0, -1, -1);
-        test_sucessful = true;
+
+        /* test u10 plane, 4:2:2 or 4:2:0 */
+        uint8_t hsub, vsub;
+        ubase_assert(uref_pic_plane_read(uref, "u10l", 0, 0, -1, -1, &buffer));
+        ubase_assert(uref_pic_plane_size(uref, "u10l", &stride, &hsub, &vsub,
+                                         NULL));
+        for (int y = 0; y < h / vsub; y++) {
+            const uint16_t *src = (uint16_t*)buffer;
+            for (int x = 0; x < w / hsub - 2; x += 3) {
+                assert(src[x] == 256);
+                assert(src[x + 1] == 512);
+                assert(src[x + 2] == 768);
+            }
+            buffer += stride;
+        }
+
+        upipe_dbg_va(upipe, "u10 plane (vsub %"PRIu8") tested correctly", vsub);
+        uref_pic_plane_unmap(uref, "u10l", 0, 0, -1, -1);
+        nb_tested++;
     }
 
     else {
@@ -277,6 +296,14 @@ int main(int argc, char **argv)
     ubase_assert(uref_pic_flow_set_hsize(out_flow_10, TEST_WIDTH));
     ubase_assert(uref_pic_flow_set_vsize(out_flow_10, TEST_HEIGHT));
 
+    struct uref *out_flow_420_10 = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(out_flow_420_10);
+    ubase_assert(uref_pic_flow_add_plane(out_flow_420_10, 1, 1, 2, "y10l"));
+    ubase_assert(uref_pic_flow_add_plane(out_flow_420_10, 2, 2, 2, "u10l"));
+    ubase_assert(uref_pic_flow_add_plane(out_flow_420_10, 2, 2, 2, "v10l"));
+    ubase_assert(uref_pic_flow_set_hsize(out_flow_420_10, TEST_WIDTH));
+    ubase_assert(uref_pic_flow_set_vsize(out_flow_420_10, TEST_HEIGHT));
+
     /* create a probe */
     struct uprobe uprobe;
     uprobe_init(&uprobe, catch, NULL);
@@ -315,13 +342,26 @@ int main(int argc, char **argv)
     struct uref *pic = uref_dup(input_uref);
     assert(pic);
     upipe_input(v210dec, pic, 0);
+    upipe_release(v210dec);
+    assert(nb_tested == 1);
+
+    /* same with a 4:2:0 output */
+    v210dec = upipe_flow_alloc(upipe_v210dec_mgr, uprobe_use(logger_v210),
+                               out_flow_420_10);
+    assert(v210dec);
+    ubase_assert(upipe_set_output(v210dec, test));
+    ubase_assert(upipe_set_flow_def(v210dec, in_flow_def));
+    pic = uref_dup(input_uref);
+    assert(pic);
+    upipe_input(v210dec, pic, 0);
+    upipe_release(v210dec);
+    assert(nb_tested == 2);
 
     uref_free(in_flow_def);
     uref_free(out_flow_8);
     uref_free(out_flow_10);
-    /* release v210dec pipe */
+    uref_free(out_flow_420_10);
     uref_free(input_uref);
-    upipe_release(v210dec);
     test_free(test);
 
     /* release managers */
@@ -335,5 +375,5 @@ int main(int argc, char **argv)
     uprobe_release(logger);
     uprobe_clean(&uprobe);
 
-    return !test_sucessful;
+    return nb_tested != 2;
 }
@@ -36,6 +36,8 @@
 #include "upipe/uref_std.h"
 #include "upipe/uref_void_flow.h"
 #include "upipe/uref_pic_flow.h"
+#include "upipe/uref_pic.h"
+#include "upipe/ubuf_pic.h"
 #include "upipe/uref_dump.h"
 #include "upipe/umem.h"
 #include "upipe/umem_alloc.h"
@@ -66,6 +68,7 @@ struct sink {
     struct upipe upipe;
     struct urefcount urefcount;
     uint64_t count;
+    const uint8_t *buffer;
 };
 
 UPIPE_HELPER_UPIPE(sink, upipe, 0);
@@ -96,6 +99,7 @@ static struct upipe *sink_alloc(struct upipe_mgr *mgr,
 
     struct sink *sink = sink_from_upipe(upipe);
     sink->count = 0;
+    sink->buffer = NULL;
 
     upipe_throw_ready(upipe);
 
@@ -111,6 +115,15 @@ static void sink_input(struct upipe *upipe, struct uref *uref,
     assert(sink->count <= LIMIT);
     uref_dump(uref, upipe->uprobe);
     assert(uref->ubuf);
+
+    /* the blank picture is allocated and cleared once, then shared */
+    const uint8_t *buffer;
+    ubase_assert(uref_pic_plane_read(uref, "y8", 0, 0, -1, -1, &buffer));
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+    assert(!sink->buffer || sink->buffer == buffer);
+    sink->buffer = buffer;
+    assert(!ubase_check(ubuf_pic_plane_write(uref->ubuf, "y8", 0, 0, -1, -1,
+                                             (uint8_t **)&buffer)));
     uref_free(uref);
 }
 
@@ -190,6 +203,9 @@ int main(int argc, char *argv[])
     struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
     ubase_assert(uref_pic_flow_set_hsize(flow_def, 10));
     ubase_assert(uref_pic_flow_set_vsize(flow_def, 10));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "u8"));
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 2, 2, 1, "v8"));
     assert(flow_def);
 
     struct upipe *source = upipe_flow_alloc(upipe_vblk_mgr,
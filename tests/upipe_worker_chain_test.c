@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for upipe_worker_chain (using upump_ev)
+ */
+
+#undef NDEBUG
+
+#include "upipe/ubase.h"
+#include "upipe/urefcount.h"
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_stdio.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe-pthread/uprobe_pthread_upump_mgr.h"
+#include "upipe-pthread/uprobe_pthread_assert.h"
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/upump.h"
+#include "upump-ev/upump_ev.h"
+#include "upipe-modules/upipe_worker_chain.h"
+#include "upipe-modules/upipe_transfer.h"
+#include "upipe-modules/upipe_null.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 0
+#define UREF_POOL_DEPTH 0
+#define UPUMP_POOL 0
+#define UPUMP_BLOCKER_POOL 0
+#define XFER_QUEUE 255
+#define XFER_POOL 1
+#define WCHAIN_QUEUE 1
+#define NB_STAGES 2
+#define NB_PACKETS 10
+
+static struct uprobe *logger;
+static pthread_t stage_thread_id[NB_STAGES];
+static unsigned int nb_transferred = 0;
+static unsigned int nb_packets[NB_STAGES];
+
+/** helper phony pipe */
+struct test_pipe {
+    struct urefcount urefcount;
+    unsigned int stage;
+    bool transferred;
+    struct upipe *output;
+    struct upipe upipe;
+};
+
+/** helper phony pipe */
+static void test_free(struct urefcount *urefcount)
+{
+    struct test_pipe *test_pipe =
+        container_of(urefcount, struct test_pipe, urefcount);
+    upipe_dbg(&test_pipe->upipe, "dead");
+    upipe_release(test_pipe->output);
+    urefcount_clean(&test_pipe->urefcount);
+    upipe_clean(&test_pipe->upipe);
+    free(test_pipe);
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr,
+                                struct uprobe *uprobe, uint32_t signature,
+                                va_list args)
+{
+    struct test_pipe *test_pipe = malloc(sizeof(struct test_pipe));
+    assert(test_pipe != NULL);
+    upipe_init(&test_pipe->upipe, mgr, uprobe);
+    urefcount_init(&test_pipe->urefcount, test_free);
+    test_pipe->upipe.refcount = &test_pipe->urefcount;
+    test_pipe->stage = 0;
+    test_pipe->transferred = false;
+    test_pipe->output = NULL;
+    return &test_pipe->upipe;
+}
+
+/** helper phony pipe */
+static void test_check_thread(struct test_pipe *test_pipe)
+{
+    assert(pthread_equal(pthread_self(),
+                         stage_thread_id[test_pipe->stage]));
+}
+
+/** helper phony pipe */
+static void test_input(struct upipe *upipe, struct uref *uref,
+                       struct upump **upump_p)
+{
+    struct test_pipe *test_pipe = container_of(upipe, struct test_pipe, upipe);
+    upipe_dbg(upipe, "input");
+    test_check_thread(test_pipe);
+    nb_packets[test_pipe->stage]--;
+    upipe_input(test_pipe->output, uref, upump_p);
+}
+
+/** helper phony pipe */
+static int test_control(struct upipe *upipe, int command, va_list args)
+{
+    struct test_pipe *test_pipe = container_of(upipe, struct test_pipe, upipe);
+    switch (command) {
+        case UPIPE_ATTACH_UPUMP_MGR: {
+            upipe_dbg(upipe, "attached");
+            test_check_thread(test_pipe);
+            test_pipe->transferred = true;
+            nb_transferred++;
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_GET_OUTPUT: {
+            struct upipe **p = va_arg(args, struct upipe **);
+            *p = test_pipe->output;
+            if (test_pipe->transferred)
+                test_check_thread(test_pipe);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_OUTPUT: {
+            upipe_dbg(upipe, "output set");
+            struct upipe *output = va_arg(args, struct upipe *);
+            assert(output != NULL);
+            upipe_release(test_pipe->output);
+            test_pipe->output = upipe_use(output);
+            if (test_pipe->transferred)
+                test_check_thread(test_pipe);
+            return UBASE_ERR_NONE;
+        }
+        case UPIPE_SET_FLOW_DEF: {
+            upipe_dbg(upipe, "flow_def set");
+            test_check_thread(test_pipe);
+            struct uref *flow_def = va_arg(args, struct uref *);
+            return upipe_set_flow_def(test_pipe->output, flow_def);
+        }
+        default:
+            assert(0);
+            return UBASE_ERR_UNHANDLED;
+    }
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .upipe_alloc = test_alloc,
+    .upipe_input = test_input,
+    .upipe_control = test_control
+};
+
+static void *thread(void *_upipe_xfer_mgr)
+{
+    struct upipe_mgr *upipe_xfer_mgr = (struct upipe_mgr *)_upipe_xfer_mgr;
+
+    struct upump_mgr *upump_mgr = upump_ev_mgr_alloc_loop(UPUMP_POOL,
+                                                          UPUMP_BLOCKER_POOL);
+    assert(upump_mgr != NULL);
+    uprobe_pthread_upump_mgr_set(logger, upump_mgr);
+
+    ubase_assert(upipe_xfer_mgr_attach(upipe_xfer_mgr, upump_mgr));
+    upipe_mgr_release(upipe_xfer_mgr);
+
+    upump_mgr_run(upump_mgr, NULL);
+
+    upump_mgr_release(upump_mgr);
+
+    return NULL;
+}
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe, int event, va_list args)
+{
+    switch (event) {
+        case UPROBE_READY:
+        case UPROBE_DEAD:
+        case UPROBE_NEW_FLOW_DEF:
+        case UPROBE_NEED_UPUMP_MGR:
+        case UPROBE_SOURCE_END:
+        case UPROBE_STALLED:
+            break;
+        default:
+            assert(0);
+            break;
+    }
+    return UBASE_ERR_NONE;
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_mgr *upump_mgr =
+        upump_ev_mgr_alloc_default(UPUMP_POOL, UPUMP_BLOCKER_POOL);
+
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH, udict_mgr,
+                                                   0);
+    assert(uref_mgr != NULL);
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    logger = uprobe_stdio_alloc(&uprobe, stdout, UPROBE_LOG_VERBOSE);
+    assert(logger != NULL);
+    logger = uprobe_pthread_upump_mgr_alloc(logger);
+    uprobe_pthread_upump_mgr_set(logger, upump_mgr);
+    assert(logger != NULL);
+    struct uprobe *uprobe_main =
+        uprobe_pthread_assert_alloc(uprobe_use(logger));
+    assert(uprobe_main != NULL);
+    uprobe_pthread_assert_set(uprobe_main, pthread_self());
+
+    struct upipe_wchain_stage stages[NB_STAGES];
+    for (unsigned int i = 0; i < NB_STAGES; i++) {
+        struct uprobe *uprobe_remote =
+            uprobe_pthread_assert_alloc(uprobe_use(logger));
+        assert(uprobe_remote != NULL);
+
+        struct upipe *upipe_test = upipe_void_alloc(&test_mgr,
+                uprobe_pfx_alloc_va(uprobe_use(uprobe_remote),
+                                    UPROBE_LOG_VERBOSE, "test %u", i));
+        assert(upipe_test != NULL);
+        container_of(upipe_test, struct test_pipe, upipe)->stage = i;
+
+        struct upipe_mgr *upipe_xfer_mgr =
+            upipe_xfer_mgr_alloc(XFER_QUEUE, XFER_POOL, NULL);
+        assert(upipe_xfer_mgr != NULL);
+        upipe_mgr_use(upipe_xfer_mgr);
+        assert(pthread_create(&stage_thread_id[i], NULL, thread,
+                              upipe_xfer_mgr) == 0);
+        uprobe_pthread_assert_set(uprobe_remote, stage_thread_id[i]);
+
+        stages[i].upipe = upipe_test;
+        stages[i].uprobe = uprobe_pfx_alloc_va(uprobe_remote,
+                UPROBE_LOG_VERBOSE, "wchain_x %u", i);
+        stages[i].xfer_mgr = upipe_xfer_mgr;
+        stages[i].queue_length = WCHAIN_QUEUE;
+        nb_packets[i] = 0;
+    }
+
+    struct upipe_mgr *upipe_wchain_mgr = upipe_wchain_mgr_alloc();
+    assert(upipe_wchain_mgr != NULL);
+
+    uprobe_throw(uprobe_main, NULL, UPROBE_FREEZE_UPUMP_MGR);
+    struct upipe *upipe_handle = upipe_wchain_alloc(upipe_wchain_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_main), UPROBE_LOG_VERBOSE,
+                             "wchain"),
+            stages, NB_STAGES, WCHAIN_QUEUE);
+    /* from now on the test pipes shouldn't be accessed from this thread */
+    assert(upipe_handle != NULL);
+    upipe_mgr_release(upipe_wchain_mgr);
+    for (unsigned int i = 0; i < NB_STAGES; i++)
+        upipe_mgr_release(stages[i].xfer_mgr);
+    uprobe_throw(uprobe_main, NULL, UPROBE_THAW_UPUMP_MGR);
+    upipe_attach_upump_mgr(upipe_handle);
+
+    struct upipe_mgr *upipe_null_mgr = upipe_null_mgr_alloc();
+    assert(upipe_null_mgr != NULL);
+    struct upipe *null = upipe_void_alloc(upipe_null_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_main), UPROBE_LOG_VERBOSE,
+                             "null"));
+    assert(null != NULL);
+    upipe_mgr_release(upipe_null_mgr);
+    upipe_set_output(upipe_handle, null);
+    upipe_release(null);
+
+    struct uref *uref = uref_alloc(uref_mgr);
+    ubase_assert(uref_flow_set_def(uref, "void."));
+    ubase_assert(upipe_set_flow_def(upipe_handle, uref));
+    uref_free(uref);
+
+    for (unsigned int i = 0; i < NB_PACKETS; i++) {
+        for (unsigned int j = 0; j < NB_STAGES; j++)
+            nb_packets[j]++;
+        uref = uref_alloc(uref_mgr);
+        assert(uref != NULL);
+        upipe_input(upipe_handle, uref, NULL);
+    }
+    upipe_release(upipe_handle);
+
+    upump_mgr_run(upump_mgr, NULL);
+
+    uprobe_err(logger, NULL, "joining");
+    for (unsigned int i = 0; i < NB_STAGES; i++)
+        assert(!pthread_join(stage_thread_id[i], NULL));
+    uprobe_err(logger, NULL, "joined");
+    assert(nb_transferred == NB_STAGES);
+    for (unsigned int i = 0; i < NB_STAGES; i++)
+        assert(!nb_packets[i]);
+
+    uprobe_release(uprobe_main);
+    upump_mgr_release(upump_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    uprobe_release(logger);
+
+    return 0;
+}
@@ -257,6 +257,7 @@ int main(int argc, char **argv)
     ubase_assert(upipe_x264_set_default_preset(x264, "faster", NULL));
     ubase_assert(upipe_x264_set_profile(x264, "high"));
     ubase_assert(upipe_x264_set_default(x264));
+    ubase_assert(upipe_enc_set_latency(x264, UPIPE_ENC_LATENCY_LOW));
 
     /* encoding test */
     for (counter = 0; counter < LIMIT; counter ++) {
@@ -259,6 +259,7 @@ int main(int argc, char **argv)
     ubase_assert(upipe_x265_set_profile(x265, "mainstillpicture"));
     ubase_assert(upipe_x265_set_default(x265, 0));
     ubase_assert(upipe_x265_set_default_preset(x265, "ultrafast", NULL));
+    ubase_assert(upipe_enc_set_latency(x265, UPIPE_ENC_LATENCY_ZERO));
 
     /* disable assembly (not valgrind safe) */
     ubase_assert(upipe_set_option(x265, "asm", "0"));
@@ -51,7 +51,9 @@
 #include "upipe/uref_dump.h"
 #include "upipe/upipe.h"
 #include "upipe/uref_pic_flow.h"
+#include "upipe/uref_pic.h"
 
+#include "upipe-filters/upipe_zoneplate.h"
 #include "upipe-filters/upipe_zoneplate_source.h"
 
 #include "upump-ev/upump_ev.h"
@@ -74,6 +76,9 @@ UPIPE_HELPER_UREFCOUNT(sink, urefcount, sink_free);
 
 static struct upipe *upipe_zpsrc = NULL;
 static int counter = 0;
+static bool frozen = false;
+static const uint8_t *frozen_buf = NULL;
+static struct uref *frozen_uref = NULL;
 
 /** helper phony pipe */
 static struct upipe *sink_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
@@ -105,7 +110,20 @@ static void sink_input(struct upipe *upipe, struct uref *uref,
     assert(uref != NULL);
     assert(uref->ubuf != NULL);
     counter++;
-    uref_free(uref);
+
+    const uint8_t *buf;
+    ubase_assert(uref_pic_plane_read(uref, "y8", 0, 0, -1, -1, &buf));
+    ubase_assert(uref_pic_plane_unmap(uref, "y8", 0, 0, -1, -1));
+    if (frozen) {
+        /* the same picture is output for every frame, even while the
+         * previous one is still in use */
+        assert(frozen_buf == NULL || frozen_buf == buf);
+        frozen_buf = buf;
+        if (frozen_uref)
+            uref_free(frozen_uref);
+        frozen_uref = uref;
+    } else
+        uref_free(uref);
 
     if (counter >= 5) {
         upipe_release(upipe_zpsrc);
@@ -170,40 +188,48 @@ int main(int argc, char *argv[])
     logger = uprobe_uclock_alloc(logger, uclock);
     assert(logger);
 
-    struct upipe *sink =
-        upipe_void_alloc(&sink_mgr,
-                         uprobe_pfx_alloc(
-                             uprobe_use(logger),
-                             UPROBE_LOG_VERBOSE, "sink"));
-    assert(sink != NULL);
-
-    struct upipe_mgr *upipe_zpsrc_mgr = upipe_zpsrc_mgr_alloc();
-    struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
-    assert(flow_def != NULL);
-    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
-    struct urational fps;
-    fps.num = 25;
-    fps.den = 1;
-    ubase_assert(uref_pic_flow_set_fps(flow_def, fps));
-    ubase_assert(uref_pic_flow_set_hsize(flow_def, 1920));
-    ubase_assert(uref_pic_flow_set_vsize(flow_def, 1080));
-    upipe_zpsrc = upipe_flow_alloc(
-        upipe_zpsrc_mgr,
-        uprobe_pfx_alloc(uprobe_use(logger),
-                         UPROBE_LOG_VERBOSE, "zpsrc"),
-        flow_def);
-    assert(upipe_zpsrc);
-    uref_free(flow_def);
-    upipe_mgr_release(upipe_zpsrc_mgr);
+    for (int i = 0; i < 2; i++) {
+        frozen = i;
+        counter = 0;
+        struct upipe *sink =
+            upipe_void_alloc(&sink_mgr,
+                             uprobe_pfx_alloc(
+                                 uprobe_use(logger),
+                                 UPROBE_LOG_VERBOSE, "sink"));
+        assert(sink != NULL);
+
+        struct upipe_mgr *upipe_zpsrc_mgr = upipe_zpsrc_mgr_alloc();
+        struct uref *flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+        assert(flow_def != NULL);
+        ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+        struct urational fps;
+        fps.num = 25;
+        fps.den = 1;
+        ubase_assert(uref_pic_flow_set_fps(flow_def, fps));
+        ubase_assert(uref_pic_flow_set_hsize(flow_def, 1920));
+        ubase_assert(uref_pic_flow_set_vsize(flow_def, 1080));
+        upipe_zpsrc = upipe_flow_alloc(
+            upipe_zpsrc_mgr,
+            uprobe_pfx_alloc(uprobe_use(logger),
+                             UPROBE_LOG_VERBOSE, "zpsrc"),
+            flow_def);
+        assert(upipe_zpsrc);
+        uref_free(flow_def);
+        upipe_mgr_release(upipe_zpsrc_mgr);
+
+        if (frozen)
+            ubase_assert(upipe_zp_set_static(upipe_zpsrc, true));
+        ubase_assert(upipe_set_output(upipe_zpsrc, sink));
+        upipe_release(sink);
+
+        upump_mgr_run(upump_mgr, NULL);
+
+        assert(!upipe_zpsrc);
+    }
+    assert(frozen_buf != NULL);
+    uref_free(frozen_uref);
     uprobe_release(logger);
 
-    ubase_assert(upipe_set_output(upipe_zpsrc, sink));
-    upipe_release(sink);
-
-    upump_mgr_run(upump_mgr, NULL);
-
-    assert(!upipe_zpsrc);
-
     uclock_release(uclock);
     uref_mgr_release(uref_mgr);
     udict_mgr_release(udict_mgr);
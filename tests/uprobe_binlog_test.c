@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for uprobe_binlog implementation
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_binlog.h"
+#include "upipe/uprobe_prefix.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define RING_SIZE 16384
+#define NB_MESSAGES 2000
+
+static const char *expected[] = {
+    "error: This is an error",
+    "warning: This is a composite warning with 66",
+    "notice: [pfx] 18446744073709551615 | 3.14|x|%|abc|   42|-7|0x1234",
+    "info: [pfx] [sub] nested prefixes",
+    "warning: [pfx] unsupported %n is written formatted",
+};
+
+/** dumps the log file and returns the lines without their dates */
+static unsigned int dump(const char *path, char lines[][128],
+                         unsigned int max)
+{
+    FILE *file = tmpfile();
+    assert(file != NULL);
+    ubase_assert(uprobe_binlog_dump(path, file));
+    rewind(file);
+
+    unsigned int nb = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        assert(nb < max);
+        char *msg = strchr(line, ' ');
+        assert(msg != NULL);
+        msg++;
+        msg[strcspn(msg, "\n")] = '\0';
+        strncpy(lines[nb], msg, sizeof(lines[nb]) - 1);
+        lines[nb][sizeof(lines[nb]) - 1] = '\0';
+        nb++;
+    }
+    fclose(file);
+    return nb;
+}
+
+int main(int argc, char **argv)
+{
+    char path[] = "/tmp/uprobe_binlog_test.XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    static char lines[NB_MESSAGES][128];
+
+    struct uprobe *uprobe = uprobe_binlog_alloc(NULL, path, RING_SIZE,
+                                                UPROBE_LOG_INFO);
+    assert(uprobe != NULL);
+    struct uprobe *pfx = uprobe_pfx_alloc(uprobe_use(uprobe),
+                                          UPROBE_LOG_VERBOSE, "pfx");
+    assert(pfx != NULL);
+    struct uprobe *sub = uprobe_pfx_alloc(uprobe_use(pfx),
+                                          UPROBE_LOG_VERBOSE, "sub");
+    assert(sub != NULL);
+
+    uprobe_err(uprobe, NULL, "This is an error");
+    uprobe_warn_va(uprobe, NULL, "This is a %s warning with %d", "composite",
+                   0x42);
+    uprobe_dbg(uprobe, NULL, "This is a debug that you shouldn't see");
+    uprobe_notice_va(pfx, NULL, "%"PRIu64" |%5.2f|%c|%%|%.*s|%*zu|%hd|%p",
+                     UINT64_MAX, 3.14159, 'x', 3, "abcdef", 5, (size_t)42,
+                     (short)-7, (void *)0x1234);
+    uprobe_info(sub, NULL, "nested prefixes");
+    int written;
+    uprobe_warn_va(pfx, NULL, "unsupported %%n is written formatted%n",
+                   &written);
+
+    unsigned int nb = dump(path, lines, NB_MESSAGES);
+    assert(nb == UBASE_ARRAY_SIZE(expected));
+    for (unsigned int i = 0; i < nb; i++) {
+        if (strcmp(lines[i], expected[i]))
+            fprintf(stderr, "got \"%s\"\nexpected \"%s\"\n",
+                    lines[i], expected[i]);
+        assert(!strcmp(lines[i], expected[i]));
+    }
+
+    /* the oldest messages are overwritten */
+    for (unsigned int i = 0; i < NB_MESSAGES; i++)
+        uprobe_notice_va(pfx, NULL, "message %u", i);
+    nb = dump(path, lines, NB_MESSAGES);
+    assert(nb > 100 && nb < NB_MESSAGES);
+    for (unsigned int i = 0; i < nb; i++) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "notice: [pfx] message %u",
+                 NB_MESSAGES - nb + i);
+        assert(!strcmp(lines[i], msg));
+    }
+
+    uprobe_release(sub);
+    uprobe_release(pfx);
+    uprobe_release(uprobe);
+
+    /* the file remains readable once the probe is gone */
+    assert(dump(path, lines, NB_MESSAGES) == nb);
+    unlink(path);
+    return 0;
+}
@@ -38,6 +38,7 @@
 #include "upipe/udict.h"
 #include "upipe/udict_inline.h"
 #include "upipe/uref.h"
+#include "upipe/uclock.h"
 #include "upipe/uref_clock.h"
 #include "upipe/uref_std.h"
 
@@ -111,6 +112,40 @@ int main(int argc, char **argv)
     ubase_assert(uref_clock_get_pts_sys(uref, &pts));
     assert(pts == systime + 2002);
 
+    uprobe_release(uprobe_dejitter);
+
+    /* adaptive latency: one reference out of ten is 1 ms late */
+    uprobe_dejitter = uprobe_dejitter_alloc(uprobe_use(logger), true, 1);
+    assert(uprobe_dejitter != NULL);
+    uprobe_dejitter_set_adaptive(uprobe_dejitter, 95, 0, UCLOCK_FREQ);
+    struct uprobe_dejitter *dejitter =
+        uprobe_dejitter_from_uprobe(uprobe_dejitter);
+    test_pipe.uprobe = uprobe_dejitter;
+
+    systime = UINT32_MAX;
+    clock = 0;
+    for (int i = 0; i < 1000; i++) {
+        uref_clock_set_cr_sys(uref, systime + clock +
+                              (i % 10 ? 0 : UCLOCK_FREQ / 1000));
+        upipe_throw_clock_ref(upipe, uref, clock, !i);
+        clock += UCLOCK_FREQ / 25;
+    }
+    assert(dejitter->margin > UCLOCK_FREQ / 1000 * 8 / 10);
+    assert(dejitter->margin < UCLOCK_FREQ / 1000);
+
+    /* the jitter disappears: the margin shrinks at the standard drift */
+    double margin = dejitter->margin;
+    for (int i = 0; i < 1000; i++) {
+        uref_clock_set_cr_sys(uref, systime + clock);
+        upipe_throw_clock_ref(upipe, uref, clock, 0);
+        clock += UCLOCK_FREQ / 25;
+        assert(dejitter->margin <= margin);
+        assert(margin - dejitter->margin <=
+               (double)UCLOCK_FREQ / 25 * 25 / 1000000 + 1);
+        margin = dejitter->margin;
+    }
+    assert(margin < UCLOCK_FREQ / 1000 / 2);
+
     uref_free(uref);
     uprobe_release(uprobe_dejitter);
     uprobe_release(logger);
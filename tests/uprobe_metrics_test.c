@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for uprobe_metrics implementation
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe/uprobe_metrics.h"
+#include "upipe/upipe.h"
+#include "upipe/upipe_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static unsigned int nb_events = 0;
+
+/** definition of our uprobe */
+static int catch(struct uprobe *uprobe, struct upipe *upipe,
+                 int event, va_list args)
+{
+    if (event != UPROBE_LOG)
+        nb_events++;
+    return UBASE_ERR_NONE;
+}
+
+/** helper phony pipe */
+static struct upipe *test_alloc(struct upipe_mgr *mgr, struct uprobe *uprobe,
+                                uint32_t signature, va_list args)
+{
+    struct upipe *upipe = malloc(sizeof(struct upipe));
+    assert(upipe != NULL);
+    upipe_init(upipe, mgr, uprobe);
+    return upipe;
+}
+
+/** helper phony pipe */
+static void test_free(struct upipe *upipe)
+{
+    upipe_clean(upipe);
+    free(upipe);
+}
+
+/** helper phony pipe */
+static struct upipe_mgr test_mgr = {
+    .refcount = NULL,
+    .signature = UBASE_FOURCC('t','e','s','t'),
+    .upipe_alloc = test_alloc,
+    .upipe_input = NULL,
+    .upipe_control = NULL
+};
+
+int main(int argc, char **argv)
+{
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch, NULL);
+    struct uprobe *uprobe_metrics = uprobe_metrics_alloc(uprobe_use(&uprobe));
+    assert(uprobe_metrics != NULL);
+
+    struct upipe *upipe_foo = upipe_void_alloc(&test_mgr,
+            uprobe_pfx_alloc(uprobe_use(uprobe_metrics), UPROBE_LOG_VERBOSE,
+                             "foo"));
+    assert(upipe_foo != NULL);
+    struct upipe *upipe_bar = upipe_void_alloc(&test_mgr,
+                                               uprobe_use(uprobe_metrics));
+    assert(upipe_bar != NULL);
+
+    unsigned int nb_thrown = nb_events;
+    upipe_throw_sync_lost(upipe_foo);
+    upipe_throw_sync_lost(upipe_foo);
+    upipe_throw_sync_lost(upipe_bar);
+    upipe_throw_discontinuity(upipe_foo, 3);
+    upipe_throw_discontinuity(upipe_foo, 4);
+    upipe_warn(upipe_foo, "warning");
+    upipe_dbg(upipe_foo, "debug");
+
+    struct upipe_stats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.urefs = 10;
+    stats.octets = 1880;
+    stats.time = 27000;
+    upipe_throw_stats(upipe_bar, &stats);
+    upipe_throw_stats(upipe_bar, &stats);
+    /* every event is forwarded */
+    assert(nb_events == nb_thrown + 7);
+
+    char *buffer = NULL;
+    size_t size = 0;
+    FILE *file = open_memstream(&buffer, &size);
+    assert(file != NULL);
+    ubase_assert(uprobe_metrics_print(uprobe_metrics, file));
+    fclose(file);
+    printf("%s", buffer);
+
+    assert(strstr(buffer, "# TYPE upipe_sync_lost_total counter\n"));
+    assert(strstr(buffer, "upipe_sync_lost_total{pipe=\"foo\"} 2\n"));
+    assert(strstr(buffer, "upipe_sync_lost_total{pipe=\"test\"} 1\n"));
+    assert(strstr(buffer, "upipe_discontinuities_total{pipe=\"foo\"} 2\n"));
+    assert(strstr(buffer, "upipe_lost_units_total{pipe=\"foo\"} 7\n"));
+    assert(strstr(buffer, "upipe_log_warnings_total{pipe=\"foo\"} 1\n"));
+    assert(strstr(buffer, "upipe_input_urefs_total{pipe=\"test\"} 20\n"));
+    assert(strstr(buffer, "upipe_input_octets_total{pipe=\"test\"} 3760\n"));
+    assert(strstr(buffer,
+                  "upipe_input_seconds_total{pipe=\"test\"} 0.002000\n"));
+    assert(!strstr(buffer, "upipe_errors_total"));
+    assert(strstr(buffer, "upipe_metrics_overflows_total 0\n"));
+    free(buffer);
+
+    test_free(upipe_foo);
+    test_free(upipe_bar);
+    uprobe_release(uprobe_metrics);
+    uprobe_clean(&uprobe);
+    return 0;
+}
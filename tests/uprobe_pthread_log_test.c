@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for uprobe_pthread_log implementation
+ */
+
+#undef NDEBUG
+
+#include "upipe/uprobe.h"
+#include "upipe/uprobe_prefix.h"
+#include "upipe-pthread/uprobe_pthread_log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <pthread.h>
+
+#define NB_THREADS 8
+#define NB_MSGS 1000
+
+static struct uprobe *uprobe;
+
+/** thread function logging messages */
+static void *thread(void *_id)
+{
+    unsigned int id = (uintptr_t)_id;
+    for (unsigned int i = 0; i < NB_MSGS; i++) {
+        uprobe_notice_va(uprobe, NULL, "thread %u message %u", id, i);
+        uprobe_dbg_va(uprobe, NULL, "thread %u filtered %u", id, i);
+    }
+    return NULL;
+}
+
+/** logs from several threads and returns the number of dropped messages */
+static unsigned int run(unsigned int ring_length)
+{
+    FILE *stream = tmpfile();
+    assert(stream != NULL);
+    uprobe = uprobe_pthread_log_alloc(NULL, stream, UPROBE_LOG_NOTICE,
+                                      ring_length);
+    assert(uprobe != NULL);
+
+    /* multiline messages are split, with the prefix on each line */
+    struct uprobe *uprobe_pfx = uprobe_pfx_alloc(uprobe_use(uprobe),
+                                                 UPROBE_LOG_NOTICE, "pfx");
+    assert(uprobe_pfx != NULL);
+    uprobe_warn(uprobe_pfx, NULL, "first\nsecond");
+    uprobe_release(uprobe_pfx);
+
+    pthread_t threads[NB_THREADS];
+    for (uintptr_t i = 0; i < NB_THREADS; i++)
+        assert(pthread_create(&threads[i], NULL, thread, (void *)i) == 0);
+    for (unsigned int i = 0; i < NB_THREADS; i++)
+        assert(pthread_join(threads[i], NULL) == 0);
+
+    /* flushes the pending records */
+    uprobe_release(uprobe);
+
+    rewind(stream);
+    char line[256];
+    unsigned int nb_pfx = 0, nb_msgs = 0, nb_dropped = 0;
+    while (fgets(line, sizeof(line), stream) != NULL) {
+        uint32_t dropped;
+        unsigned int id, i;
+        if (!strcmp(line, "warning: [pfx] first\n") ||
+            !strcmp(line, "warning: [pfx] second\n"))
+            nb_pfx++;
+        else if (sscanf(line, "notice: thread %u message %u", &id, &i) == 2) {
+            assert(id < NB_THREADS);
+            assert(i < NB_MSGS);
+            nb_msgs++;
+        } else if (sscanf(line, "warning: [uprobe_pthread_log] %"SCNu32,
+                          &dropped) == 1)
+            nb_dropped += dropped;
+        else {
+            fprintf(stderr, "unexpected line: %s", line);
+            assert(0);
+        }
+    }
+    fclose(stream);
+    assert(nb_pfx == 2);
+    assert(nb_msgs + nb_dropped == NB_THREADS * NB_MSGS);
+    return nb_dropped;
+}
+
+int main(int argc, char **argv)
+{
+    assert(uprobe_pthread_log_alloc(NULL, stdout, UPROBE_LOG_NOTICE,
+                                    0) == NULL);
+    /* rings large enough to hold all the messages of a thread */
+    assert(run(NB_MSGS) == 0);
+    /* rings overflowing */
+    run(16);
+    return 0;
+}
@@ -42,6 +42,7 @@
 #include "upipe/ubuf.h"
 #include "upipe/ubuf_pic.h"
 #include "upipe/urequest.h"
+#include "upipe/ualloc_stats.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -51,6 +52,8 @@
 #define UDICT_POOL_DEPTH 0
 #define UREF_POOL_DEPTH 0
 #define UBUF_POOL_DEPTH 0
+#define ADAPTIVE_POOL_DEPTH 64
+#define ADAPTIVE_BURST 16
 
 static struct uref *flow_def;
 static void (*test_mgr)(struct ubuf_mgr *);
@@ -160,6 +163,31 @@ static void test_YUYV(struct ubuf_mgr *mgr)
     ubuf_free(ubuf);
 }
 
+static struct ubuf_mgr *adaptive_ubuf_mgr = NULL;
+
+static void test_adaptive(struct ubuf_mgr *mgr)
+{
+    adaptive_ubuf_mgr = ubuf_mgr_use(mgr);
+}
+
+/** allocates and frees a burst of pictures, and returns the number of
+ * structures retained in the pools afterwards */
+static uint64_t adaptive_burst(unsigned int nb)
+{
+    struct ubuf *ubufs[ADAPTIVE_BURST];
+    for (unsigned int i = 0; i < nb; i++) {
+        ubufs[i] = ubuf_pic_alloc(adaptive_ubuf_mgr, 32, 32);
+        assert(ubufs[i] != NULL);
+    }
+    for (unsigned int i = 0; i < nb; i++)
+        ubuf_free(ubufs[i]);
+
+    struct ualloc_stats stats;
+    ualloc_stats_init(&stats);
+    ubase_assert(ubuf_mgr_get_stats(adaptive_ubuf_mgr, &stats));
+    return stats.retained;
+}
+
 /** helper phony pipe to test uprobe_ubuf_mem_pool */
 static int uprobe_test_provide_ubuf_mgr(struct urequest *urequest, va_list args)
 {
@@ -261,6 +289,59 @@ int main(int argc, char **argv)
     uref_free(flow_def);
     previous_ubuf_mgr = NULL;
 
+    uprobe_release(uprobe);
+
+    /* adaptive pools, with a ubuf and a shared pool per manager */
+    uprobe = uprobe_ubuf_mem_pool_alloc(NULL, umem_mgr,
+            ADAPTIVE_POOL_DEPTH, ADAPTIVE_POOL_DEPTH);
+    assert(uprobe != NULL);
+    uprobe_ubuf_mem_pool_set_adaptive(uprobe, UINT64_MAX, 10);
+
+    test_mgr = test_adaptive;
+    flow_def = uref_pic_flow_alloc_def(uref_mgr, 1);
+    assert(flow_def != NULL);
+    ubase_assert(uref_pic_flow_add_plane(flow_def, 1, 1, 1, "y8"));
+    upipe = upipe_void_alloc(&uprobe_test_mgr, uprobe_use(uprobe));
+    struct urequest request;
+    urequest_init_ubuf_mgr(&request, flow_def, uprobe_test_provide_ubuf_mgr,
+                           NULL);
+    ubase_assert(upipe_throw_provide_request(upipe, &request));
+    urequest_clean(&request);
+    uprobe_test_free(upipe);
+    previous_ubuf_mgr = NULL;
+    assert(adaptive_ubuf_mgr != NULL);
+
+    /* pools start small and grow while allocations miss */
+    assert(adaptive_burst(ADAPTIVE_BURST) == 2 * 4);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 1);
+    assert(adaptive_burst(ADAPTIVE_BURST) == 2 * 8);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 2);
+    assert(adaptive_burst(ADAPTIVE_BURST) == 2 * 16);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 3);
+    assert(adaptive_burst(ADAPTIVE_BURST) == 2 * 16);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 4);
+    assert(adaptive_burst(ADAPTIVE_BURST) == 2 * 16);
+
+    /* idle pools are released after the timeout */
+    uprobe_ubuf_mem_pool_adapt(uprobe, 5);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 10);
+    assert(adaptive_burst(0) == 2 * 16);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 15);
+    assert(adaptive_burst(0) == 0);
+
+    /* released pools grow again from the minimal depth */
+    assert(adaptive_burst(ADAPTIVE_BURST) == 0);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 16);
+    assert(adaptive_burst(ADAPTIVE_BURST) == 2 * 4);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 17);
+    assert(adaptive_burst(ADAPTIVE_BURST) == 2 * 8);
+
+    /* pools shrink while the budget is exceeded */
+    uprobe_ubuf_mem_pool_set_adaptive(uprobe, 1, 10);
+    uprobe_ubuf_mem_pool_adapt(uprobe, 18);
+    assert(adaptive_burst(0) == 2 * 4);
+
+    ubuf_mgr_release(adaptive_ubuf_mgr);
     uprobe_release(uprobe);
     uref_mgr_release(uref_mgr);
     udict_mgr_release(udict_mgr);
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for upump manager with io_uring event loop
+ */
+
+#undef NDEBUG
+
+#include "upipe/upump.h"
+#include "upump-uring/upump_uring.h"
+#include "upump_common_test.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+
+static const char message[] = "io_uring";
+static char buffer[sizeof(message)];
+static unsigned int reads = 0;
+static unsigned int writes = 0;
+
+static void write_cb(struct upump *upump)
+{
+    ssize_t result;
+    ubase_assert(upump_uring_get_result(upump, &result));
+    assert(result == sizeof(message));
+    writes++;
+    upump_stop(upump);
+}
+
+static void read_cb(struct upump *upump)
+{
+    ssize_t result;
+    ubase_assert(upump_uring_get_result(upump, &result));
+    assert(result == sizeof(message));
+    assert(!memcmp(buffer, message, sizeof(message)));
+    memset(buffer, 0, sizeof(buffer));
+    if (++reads < 2) {
+        /* rearm the read for the second datagram */
+        upump_restart(upump);
+        return;
+    }
+    upump_stop(upump);
+}
+
+static void recvmsg_cb(struct upump *upump)
+{
+    ssize_t result;
+    ubase_assert(upump_uring_get_result(upump, &result));
+    assert(result == sizeof(message));
+    assert(!memcmp(buffer, message, sizeof(message)));
+    reads++;
+    upump_stop(upump);
+}
+
+static void run_requests(struct upump_mgr *mgr)
+{
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) == 0);
+
+    struct upump *write_pump =
+        upump_uring_alloc_write(mgr, write_cb, NULL, NULL, fds[0],
+                                message, sizeof(message), -1);
+    assert(write_pump != NULL);
+    struct upump *read_pump =
+        upump_uring_alloc_read(mgr, read_cb, NULL, NULL, fds[1],
+                               buffer, sizeof(buffer), -1);
+    assert(read_pump != NULL);
+    upump_start(read_pump);
+    upump_start(write_pump);
+
+    /* the read receives this datagram and the one sent by the write
+     * request */
+    assert(write(fds[0], message, sizeof(message)) == sizeof(message));
+    upump_mgr_run(mgr, NULL);
+    assert(reads == 2 && writes == 1);
+    upump_free(write_pump);
+    upump_free(read_pump);
+
+    struct iovec iov = { .iov_base = buffer, .iov_len = sizeof(buffer) };
+    struct msghdr msghdr;
+    memset(&msghdr, 0, sizeof(msghdr));
+    msghdr.msg_iov = &iov;
+    msghdr.msg_iovlen = 1;
+    struct upump *recvmsg_pump =
+        upump_uring_alloc_recvmsg(mgr, recvmsg_cb, NULL, NULL, fds[1],
+                                  &msghdr, 0);
+    assert(recvmsg_pump != NULL);
+    ssize_t result;
+    assert(!ubase_check(upump_uring_set_buffer(recvmsg_pump, buffer,
+                                               sizeof(buffer), -1)));
+    upump_start(recvmsg_pump);
+    assert(write(fds[0], message, sizeof(message)) == sizeof(message));
+    upump_mgr_run(mgr, NULL);
+    assert(reads == 3);
+    ubase_assert(upump_uring_get_result(recvmsg_pump, &result));
+    assert(result == sizeof(message));
+
+    /* a pending request is cancelled when the pump is freed */
+    upump_restart(recvmsg_pump);
+    upump_free(recvmsg_pump);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_mgr *mgr = upump_uring_mgr_alloc(UPUMP_POOL,
+                                                  UPUMP_BLOCKER_POOL);
+    assert(mgr != NULL);
+    run_requests(mgr);
+    run(mgr);
+    return 0;
+}
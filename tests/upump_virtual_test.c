@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for upump manager running on virtual time
+ */
+
+#undef NDEBUG
+
+#include "upipe/uclock.h"
+#include "upipe/uprobe.h"
+#include "upipe/upump.h"
+#include "upump-virtual/upump_virtual.h"
+#include "upump_common_test.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <signal.h>
+#include <assert.h>
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+#define START_TIME (UCLOCK_FREQ * 1000)
+
+static struct uclock *uclock;
+static unsigned int order = 0;
+static unsigned int ticks = 0;
+
+static void first_cb(struct upump *upump)
+{
+    assert(uclock_now(uclock) == START_TIME + UCLOCK_HOUR);
+    assert(order++ == 0);
+}
+
+static void second_cb(struct upump *upump)
+{
+    assert(uclock_now(uclock) == START_TIME + UCLOCK_HOUR);
+    assert(order++ == 1);
+}
+
+static void tick_cb(struct upump *upump)
+{
+    assert(uclock_now(uclock) == START_TIME + UCLOCK_HOUR +
+                                 ++ticks * UCLOCK_SECOND);
+    if (ticks == 3600)
+        upump_stop(upump);
+}
+
+static unsigned int slow = 0;
+static uint64_t slow_duration = 0;
+static uint64_t slow_lag = 0;
+
+static int catch_slow(struct uprobe *uprobe, struct upipe *upipe,
+                      int event, va_list args)
+{
+    assert(event == UPROBE_SLOW_UPUMP);
+    assert(upipe == NULL);
+    slow++;
+    slow_duration = va_arg(args, uint64_t);
+    slow_lag = va_arg(args, uint64_t);
+    return UBASE_ERR_NONE;
+}
+
+static void busy_cb(struct upump *upump)
+{
+    /* pretend the callback takes three seconds */
+    ubase_assert(upump_virtual_mgr_set_time(upump->mgr,
+                                            uclock_now(uclock) +
+                                            3 * UCLOCK_SECOND));
+}
+
+static void late_cb(struct upump *upump)
+{
+    assert(slow == 1);
+    assert(slow_duration == 3 * UCLOCK_SECOND);
+    assert(slow_lag == 0);
+}
+
+static void run_monitor(struct upump_mgr *mgr)
+{
+    struct upump_mgr_health health;
+    assert(!ubase_check(upump_mgr_get_health(mgr, &health)));
+
+    struct uprobe uprobe;
+    uprobe_init(&uprobe, catch_slow, NULL);
+    ubase_assert(upump_mgr_set_monitor(mgr, UCLOCK_SECOND, &uprobe));
+
+    /* the busy callback delays the next timer by two seconds */
+    struct upump *busy = upump_alloc_timer(mgr, busy_cb, NULL, NULL,
+                                           UCLOCK_SECOND, 0);
+    struct upump *late = upump_alloc_timer(mgr, late_cb, NULL, NULL,
+                                           2 * UCLOCK_SECOND, 0);
+    assert(busy != NULL && late != NULL);
+    upump_start(busy);
+    upump_start(late);
+    ubase_assert(upump_mgr_run(mgr, NULL));
+    assert(slow == 2);
+    assert(slow_duration == 0);
+    assert(slow_lag == 2 * UCLOCK_SECOND);
+
+    ubase_assert(upump_mgr_get_health(mgr, &health));
+    assert(health.dispatches == 2);
+    assert(health.time == 3 * UCLOCK_SECOND);
+    assert(health.max_time == 3 * UCLOCK_SECOND);
+    assert(health.slow == 2);
+    assert(health.timers == 2);
+    assert(health.lag == 2 * UCLOCK_SECOND);
+    assert(health.max_lag == 2 * UCLOCK_SECOND);
+
+    ubase_assert(upump_mgr_set_monitor(mgr, 0, NULL));
+    upump_free(busy);
+    upump_free(late);
+    uprobe_clean(&uprobe);
+}
+
+static void run_virtual(struct upump_mgr *mgr)
+{
+    ubase_assert(upump_virtual_mgr_get_uclock(mgr, &uclock));
+    assert(uclock_now(uclock) == 0);
+    ubase_assert(upump_virtual_mgr_set_time(mgr, START_TIME));
+    assert(!ubase_check(upump_virtual_mgr_set_time(mgr, 0)));
+    assert(uclock_now(uclock) == START_TIME);
+
+    /* timers with the same deadline fire in the order they were started */
+    struct upump *first = upump_alloc_timer(mgr, first_cb, NULL, NULL,
+                                            UCLOCK_HOUR, 0);
+    struct upump *second = upump_alloc_timer(mgr, second_cb, NULL, NULL,
+                                             UCLOCK_HOUR, 0);
+    struct upump *tick = upump_alloc_timer(mgr, tick_cb, NULL, NULL,
+                                           UCLOCK_HOUR + UCLOCK_SECOND,
+                                           UCLOCK_SECOND);
+    assert(first != NULL && second != NULL && tick != NULL);
+    upump_start(first);
+    upump_start(second);
+    upump_start(tick);
+
+    /* two virtual hours must not take any real time */
+    time_t begin = time(NULL);
+    ubase_assert(upump_mgr_run(mgr, NULL));
+    assert(time(NULL) - begin < 10);
+    assert(order == 2);
+    assert(ticks == 3600);
+    uint64_t now;
+    ubase_assert(upump_virtual_mgr_get_time(mgr, &now));
+    assert(now == START_TIME + 2 * UCLOCK_HOUR);
+
+    upump_free(first);
+    upump_free(second);
+    upump_free(tick);
+
+    /* signals cannot be replayed */
+    assert(upump_alloc_signal(mgr, first_cb, NULL, NULL, SIGUSR1) == NULL);
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_mgr *mgr = upump_virtual_mgr_alloc(UPUMP_POOL,
+                                                    UPUMP_BLOCKER_POOL, 0);
+    assert(mgr != NULL);
+    run_virtual(mgr);
+    run_monitor(mgr);
+    run(mgr);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+/** @file
+ * @short unit tests for the timer wheel of the common upump layer
+ */
+
+#undef NDEBUG
+
+#include "upipe/uclock.h"
+#include "upipe/upump.h"
+#include "upump-virtual/upump_virtual.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#define UPUMP_POOL 1
+#define UPUMP_BLOCKER_POOL 1
+#define NB_TIMERS 1000
+#define NB_REPEATS 5
+#define START_TIME (UCLOCK_FREQ * 3600)
+#define US (UCLOCK_FREQ / 1000000)
+
+struct test_timer {
+    struct upump *upump;
+    uint64_t deadline;
+    uint64_t repeat;
+    unsigned int count;
+};
+
+static struct test_timer timers[NB_TIMERS];
+static struct uclock *uclock;
+static unsigned int expired = 0;
+static unsigned int stopped = 0;
+
+static void timer_cb(struct upump *upump)
+{
+    struct test_timer *timer = upump->opaque;
+    assert(uclock_now(uclock) == timer->deadline);
+    expired++;
+    if (!timer->repeat)
+        return;
+    if (++timer->count == NB_REPEATS) {
+        upump_stop(upump);
+        return;
+    }
+    timer->deadline += timer->repeat;
+}
+
+static void stop_cb(struct upump *upump)
+{
+    /* stops the next timer, which must then never trigger */
+    struct test_timer *timer = upump->opaque;
+    upump_stop((timer + 1)->upump);
+    stopped++;
+}
+
+int main(int argc, char **argv)
+{
+    struct upump_mgr *mgr = upump_virtual_mgr_alloc(UPUMP_POOL,
+                                                    UPUMP_BLOCKER_POOL,
+                                                    START_TIME);
+    assert(mgr != NULL);
+    ubase_assert(upump_virtual_mgr_get_uclock(mgr, &uclock));
+
+    /* delays from one microsecond to two hours, to use all levels */
+    srand(42);
+    unsigned int nb_expected = 0;
+    for (unsigned int i = 0; i < NB_TIMERS; i++) {
+        uint64_t after = (uint64_t)(rand() % 1000 + 1) <<
+                         (rand() % 33);
+        if (after > UCLOCK_HOUR * 2 / US)
+            after %= UCLOCK_HOUR * 2 / US;
+        after = (after + 1) * US;
+        uint64_t repeat = i % 3 ? 0 : (uint64_t)(rand() % 100000 + 1) * US;
+        upump_cb cb = timer_cb;
+        if (i % 10 == 9 && i + 1 < NB_TIMERS) {
+            /* triggers before the next one */
+            cb = stop_cb;
+            repeat = 0;
+            after = 1 * US;
+        }
+        timers[i].deadline = START_TIME + after;
+        timers[i].repeat = repeat;
+        timers[i].count = 0;
+        timers[i].upump = upump_alloc_wheel_timer(mgr, cb, &timers[i], NULL,
+                                                  after, repeat);
+        assert(timers[i].upump != NULL);
+        upump_start(timers[i].upump);
+        if (cb == stop_cb || (i && i % 10 == 0))
+            continue;
+        nb_expected += repeat ? NB_REPEATS : 1;
+    }
+    ubase_assert(upump_mgr_run(mgr, NULL));
+    printf("%u timers expired, %u stopped\n", expired, stopped);
+    assert(stopped == NB_TIMERS / 10 - 1);
+    assert(expired == nb_expected);
+
+    /* restarted timers are rearmed from the current time */
+    uint64_t now = uclock_now(uclock);
+    timers[0].repeat = 0;
+    struct upump *upump = upump_alloc_wheel_timer(mgr, timer_cb, &timers[0],
+                                                  NULL, 20 * US, 0);
+    assert(upump != NULL);
+    upump_start(upump);
+    ubase_assert(upump_virtual_mgr_set_time(mgr, now + 5 * US));
+    upump_restart(upump);
+    timers[0].deadline = now + 25 * US;
+    expired = 0;
+    ubase_assert(upump_mgr_run(mgr, NULL));
+    assert(expired == 1);
+    upump_free(upump);
+
+    for (unsigned int i = 0; i < NB_TIMERS; i++)
+        upump_free(timers[i].upump);
+    upump_mgr_release(mgr);
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the FIFO of sound urefs
+ */
+
+#undef NDEBUG
+
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uclock.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_clock.h"
+#include "upipe/uref_sound.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_sound.h"
+#include "upipe/ubuf_sound_mem.h"
+#include "upipe/uref_sound_fifo.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH    1
+#define UREF_POOL_DEPTH     1
+#define UBUF_POOL_DEPTH     1
+#define RATE                48000
+#define CHANNELS            2
+
+static int16_t counter = 0;
+
+/** allocates a uref of consecutive samples */
+static struct uref *alloc_sound(struct uref_mgr *uref_mgr,
+                                struct ubuf_mgr *ubuf_mgr, size_t samples)
+{
+    struct uref *uref = uref_sound_alloc(uref_mgr, ubuf_mgr, samples);
+    assert(uref != NULL);
+    int16_t *buf;
+    ubase_assert(uref_sound_plane_write_int16_t(uref, "lr", 0, -1, &buf));
+    for (size_t i = 0; i < samples; i++) {
+        buf[CHANNELS * i] = counter;
+        buf[CHANNELS * i + 1] = -counter;
+        counter++;
+    }
+    ubase_assert(uref_sound_plane_unmap(uref, "lr", 0, -1));
+    uref_clock_set_pts_sys(uref, (counter - samples) * UCLOCK_FREQ / RATE);
+    return uref;
+}
+
+/** checks that a uref holds the given consecutive samples */
+static void check_sound(struct uref *uref, int16_t first, size_t samples,
+                        size_t valid)
+{
+    size_t size;
+    ubase_assert(uref_sound_size(uref, &size, NULL));
+    assert(size == samples);
+    const int16_t *buf;
+    ubase_assert(uref_sound_plane_read_int16_t(uref, "lr", 0, -1, &buf));
+    for (size_t i = 0; i < samples; i++) {
+        int16_t value = i < valid ? first + i : 0;
+        assert(buf[CHANNELS * i] == value);
+        assert(buf[CHANNELS * i + 1] == -value);
+    }
+    ubase_assert(uref_sound_plane_unmap(uref, "lr", 0, -1));
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                   udict_mgr, 0);
+    assert(uref_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_sound_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, CHANNELS * sizeof(int16_t), 0);
+    assert(ubuf_mgr != NULL);
+    ubase_assert(ubuf_sound_mem_mgr_add_plane(ubuf_mgr, "lr"));
+
+    struct uref_sound_fifo fifo;
+    uref_sound_fifo_init(&fifo, RATE);
+    assert(uref_sound_fifo_peek(&fifo) == NULL);
+    assert(uref_sound_fifo_pop(&fifo, NULL, 10) == NULL);
+
+    ubase_assert(uref_sound_fifo_push(&fifo,
+                alloc_sound(uref_mgr, ubuf_mgr, 100)));
+    ubase_assert(uref_sound_fifo_push(&fifo,
+                alloc_sound(uref_mgr, ubuf_mgr, 30)));
+    ubase_assert(uref_sound_fifo_push(&fifo,
+                alloc_sound(uref_mgr, ubuf_mgr, 50)));
+    assert(uref_sound_fifo_samples(&fifo) == 180);
+
+    /* within the first uref, the buffer is shared */
+    struct uref *head = uref_sound_fifo_peek(&fifo);
+    struct uref *uref = uref_sound_fifo_pop(&fifo, NULL, 60);
+    assert(uref != NULL);
+    check_sound(uref, 0, 60, 60);
+    const int16_t *r1, *r2;
+    ubase_assert(uref_sound_plane_read_int16_t(uref, "lr", 0, -1, &r1));
+    ubase_assert(uref_sound_plane_read_int16_t(head, "lr", 0, -1, &r2));
+    assert(r2 == r1 + 60 * CHANNELS);
+    uref_sound_plane_unmap(uref, "lr", 0, -1);
+    uref_sound_plane_unmap(head, "lr", 0, -1);
+    uint64_t pts;
+    ubase_assert(uref_clock_get_pts_sys(head, &pts));
+    assert(pts == 60 * UCLOCK_FREQ / RATE);
+    uref_free(uref);
+    assert(uref_sound_fifo_samples(&fifo) == 120);
+
+    /* contiguous views */
+    const uint8_t *view;
+    ubase_assert(uref_sound_fifo_read(&fifo, 40, &view, 1));
+    assert(((const int16_t *)view)[0] == 60);
+    ubase_assert(uref_sound_fifo_unmap(&fifo, 40, 1));
+    ubase_nassert(uref_sound_fifo_read(&fifo, 41, &view, 1));
+
+    /* across urefs, samples are copied */
+    uref = uref_sound_fifo_pop(&fifo, NULL, 60);
+    assert(uref != NULL);
+    check_sound(uref, 60, 60, 60);
+    ubase_assert(uref_clock_get_pts_sys(uref, &pts));
+    assert(pts == 60 * UCLOCK_FREQ / RATE);
+    uref_free(uref);
+    assert(uref_sound_fifo_samples(&fifo) == 60);
+
+    /* dropping samples */
+    uref_sound_fifo_drop(&fifo, 20);
+    assert(uref_sound_fifo_samples(&fifo) == 40);
+
+    /* exact size, the uref is returned as is */
+    head = uref_sound_fifo_peek(&fifo);
+    uref = uref_sound_fifo_pop(&fifo, NULL, 40);
+    assert(uref == head);
+    check_sound(uref, 140, 40, 40);
+    uref_free(uref);
+
+    /* running short pads with zeros */
+    ubase_assert(uref_sound_fifo_push(&fifo,
+                alloc_sound(uref_mgr, ubuf_mgr, 10)));
+    uref = uref_sound_fifo_pop(&fifo, ubuf_mgr, 30);
+    assert(uref != NULL);
+    check_sound(uref, 180, 30, 10);
+    uref_free(uref);
+    assert(uref_sound_fifo_samples(&fifo) == 0);
+
+    /* urefs of silence share a buffer */
+    struct uref *silence1 = uref_sound_fifo_silence(&fifo, uref_mgr,
+                                                    ubuf_mgr, 100);
+    struct uref *silence2 = uref_sound_fifo_silence(&fifo, uref_mgr,
+                                                    ubuf_mgr, 50);
+    assert(silence1 != NULL && silence2 != NULL);
+    check_sound(silence1, 0, 100, 0);
+    check_sound(silence2, 0, 50, 0);
+    ubase_assert(uref_sound_plane_read_int16_t(silence1, "lr", 0, -1, &r1));
+    ubase_assert(uref_sound_plane_read_int16_t(silence2, "lr", 0, -1, &r2));
+    assert(r1 == r2);
+    uref_sound_plane_unmap(silence1, "lr", 0, -1);
+    uref_sound_plane_unmap(silence2, "lr", 0, -1);
+    uref_free(silence1);
+    uref_free(silence2);
+
+    ubase_assert(uref_sound_fifo_push(&fifo,
+                alloc_sound(uref_mgr, ubuf_mgr, 10)));
+    uref_sound_fifo_clean(&fifo);
+
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(uref_mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
@@ -35,12 +35,18 @@
 #include "upipe/udict_inline.h"
 #include "upipe/uref.h"
 #include "upipe/uref_std.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block_mem.h"
+#include "upipe/uref_block.h"
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 #define UDICT_POOL_DEPTH 1
 #define UREF_POOL_DEPTH 1
+#define UBUF_POOL_DEPTH 1
+#define BATCH_SIZE 100
 
 int main(int argc, char **argv)
 {
@@ -70,6 +76,40 @@ int main(int argc, char **argv)
     assert(uref1 != NULL);
     uref_free(uref1);
 
+    struct uref *urefs[BATCH_SIZE];
+    assert(uref_alloc_batch(mgr, urefs, BATCH_SIZE) == BATCH_SIZE);
+    assert(urefs[0] == uref2); // from the pool
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        assert(urefs[i]->ubuf == NULL);
+        assert(urefs[i]->udict == NULL);
+        uref_free(urefs[i]);
+    }
+
+    struct ubuf_mgr *ubuf_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+                                                         UBUF_POOL_DEPTH,
+                                                         umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mgr != NULL);
+    assert(uref_block_alloc_batch(mgr, ubuf_mgr, 1316, urefs, BATCH_SIZE) ==
+           BATCH_SIZE);
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        size_t size;
+        uint8_t *w;
+        int wsize = -1;
+        ubase_assert(uref_block_size(urefs[i], &size));
+        assert(size == 1316);
+        ubase_assert(uref_block_write(urefs[i], 0, &wsize, &w));
+        memset(w, i, wsize);
+        ubase_assert(uref_block_unmap(urefs[i], 0));
+    }
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        uint8_t buf[1316];
+        ubase_assert(uref_block_extract(urefs[i], 0, -1, buf));
+        assert(buf[0] == i && buf[1315] == i);
+        uref_free(urefs[i]);
+    }
+    assert(uref_block_alloc_batch(mgr, ubuf_mgr, -1, urefs, BATCH_SIZE) == 0);
+    ubuf_mgr_release(ubuf_mgr);
+
     uref_mgr_release(mgr);
     udict_mgr_release(udict_mgr);
     umem_mgr_release(umem_mgr);
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2014 OpenHeadend S.A.R.L.
+ *
+ * Authors: Christophe Massiot
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for tracking uref and ubuf managers
+ */
+
+#undef NDEBUG
+
+#include "upipe/umem.h"
+#include "upipe/umem_alloc.h"
+#include "upipe/udict.h"
+#include "upipe/udict_inline.h"
+#include "upipe/uref.h"
+#include "upipe/uref_std.h"
+#include "upipe/uref_track.h"
+#include "upipe/uref_block.h"
+#include "upipe/ubuf.h"
+#include "upipe/ubuf_block.h"
+#include "upipe/ubuf_block_mem.h"
+#include "upipe/ubuf_track.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+
+#define UDICT_POOL_DEPTH 1
+#define UREF_POOL_DEPTH 1
+#define UBUF_POOL_DEPTH 1
+#define NB_UREFS 100
+
+/** returns the number of live sampled objects printed by a dump */
+static uint64_t live(FILE *file)
+{
+    char line[256];
+    uint64_t nb = UINT64_MAX;
+    rewind(file);
+    assert(fgets(line, sizeof(line), file) != NULL);
+    assert(sscanf(line, "live %*s %"SCNu64, &nb) == 1);
+    rewind(file);
+    return nb;
+}
+
+int main(int argc, char **argv)
+{
+    struct umem_mgr *umem_mgr = umem_alloc_mgr_alloc();
+    assert(umem_mgr != NULL);
+    struct udict_mgr *udict_mgr = udict_inline_mgr_alloc(UDICT_POOL_DEPTH,
+                                                         umem_mgr, -1, -1);
+    assert(udict_mgr != NULL);
+    struct uref_mgr *uref_std_mgr = uref_std_mgr_alloc(UREF_POOL_DEPTH,
+                                                       udict_mgr, 0);
+    assert(uref_std_mgr != NULL);
+    struct uref_mgr *mgr = uref_track_mgr_alloc(uref_std_mgr, 1);
+    assert(mgr != NULL);
+    uref_mgr_release(uref_std_mgr);
+    struct ubuf_mgr *ubuf_mem_mgr = ubuf_block_mem_mgr_alloc(UBUF_POOL_DEPTH,
+            UBUF_POOL_DEPTH, umem_mgr, 0, 0, 0, 0);
+    assert(ubuf_mem_mgr != NULL);
+    struct ubuf_mgr *ubuf_mgr = ubuf_track_mgr_alloc(ubuf_mem_mgr, 1);
+    assert(ubuf_mgr != NULL);
+    ubuf_mgr_release(ubuf_mem_mgr);
+
+    FILE *file = tmpfile();
+    assert(file != NULL);
+    ubase_assert(uref_track_mgr_dump(mgr, file));
+    assert(live(file) == 0);
+
+    /* allocations, duplicates and batches are tracked */
+    struct uref *urefs[NB_UREFS];
+    for (int i = 0; i < NB_UREFS / 2; i++) {
+        urefs[i] = uref_block_alloc(mgr, ubuf_mgr, 1316);
+        assert(urefs[i] != NULL);
+        assert(urefs[i]->mgr == mgr);
+        assert(urefs[i]->ubuf->mgr == ubuf_mgr);
+        uint8_t *w;
+        int wsize = -1;
+        ubase_assert(uref_block_write(urefs[i], 0, &wsize, &w));
+        assert(wsize == 1316);
+        memset(w, 1, wsize);
+        ubase_assert(uref_block_unmap(urefs[i], 0));
+    }
+    for (int i = NB_UREFS / 2; i < NB_UREFS; i++) {
+        urefs[i] = uref_dup(urefs[i - NB_UREFS / 2]);
+        assert(urefs[i] != NULL);
+        assert(urefs[i]->mgr == mgr);
+        assert(urefs[i]->ubuf->mgr == ubuf_mgr);
+    }
+    ubase_assert(uref_track_mgr_dump(mgr, file));
+    assert(live(file) == NB_UREFS);
+    ubase_assert(ubuf_track_mgr_dump(ubuf_mgr, file));
+    assert(live(file) == NB_UREFS);
+
+    /* the wrapped manager still handles the ubufs */
+    uint8_t buf[100];
+    ubase_assert(uref_block_extract(urefs[NB_UREFS - 1], 16, 100, buf));
+    assert(buf[0] == 1 && buf[99] == 1);
+    struct ubuf *ubuf = ubuf_block_splice(urefs[0]->ubuf, 16, 100);
+    assert(ubuf != NULL);
+    assert(ubuf->mgr == ubuf_mgr);
+    size_t size;
+    ubase_assert(ubuf_block_size(ubuf, &size));
+    assert(size == 100);
+    ubuf_free(ubuf);
+
+    for (int i = 0; i < NB_UREFS; i++)
+        uref_free(urefs[i]);
+    ubase_assert(uref_track_mgr_dump(mgr, file));
+    assert(live(file) == 0);
+    ubase_assert(ubuf_track_mgr_dump(ubuf_mgr, file));
+    assert(live(file) == 0);
+
+    /* sampling keeps about one object out of the period */
+    struct uref_mgr *sampled_mgr = uref_track_mgr_alloc(mgr, 4);
+    assert(sampled_mgr != NULL);
+    for (int i = 0; i < NB_UREFS; i++) {
+        urefs[i] = uref_alloc(sampled_mgr);
+        assert(urefs[i] != NULL);
+    }
+    ubase_assert(uref_track_mgr_dump(sampled_mgr, file));
+    uint64_t nb = live(file);
+    assert(nb > 0 && nb < NB_UREFS);
+    for (int i = 0; i < NB_UREFS; i++)
+        uref_free(urefs[i]);
+    ubase_assert(uref_track_mgr_dump(sampled_mgr, file));
+    assert(live(file) == 0);
+    uref_mgr_release(sampled_mgr);
+
+    fclose(file);
+    ubuf_mgr_release(ubuf_mgr);
+    uref_mgr_release(mgr);
+    udict_mgr_release(udict_mgr);
+    umem_mgr_release(umem_mgr);
+    return 0;
+}
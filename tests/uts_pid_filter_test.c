@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for the bitmap of TS PIDs
+ */
+
+#undef NDEBUG
+
+#include "upipe/uts_pid_filter.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#define NB_PACKETS 7
+
+static void fill(uint8_t *buffer, const uint16_t *pids, unsigned int nb)
+{
+    for (unsigned int i = 0; i < nb; i++) {
+        uint8_t *packet = buffer + i * UTS_PID_FILTER_PACKET_SIZE;
+        memset(packet, i, UTS_PID_FILTER_PACKET_SIZE);
+        packet[0] = UTS_PID_FILTER_SYNC;
+        packet[1] = pids[i] >> 8;
+        packet[2] = pids[i] & 0xff;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    struct uts_pid_filter filter;
+    uts_pid_filter_init(&filter);
+    assert(!uts_pid_filter_check(&filter, 0));
+    uts_pid_filter_add(&filter, 0);
+    uts_pid_filter_add(&filter, 68);
+    uts_pid_filter_add(&filter, 8191);
+    assert(uts_pid_filter_check(&filter, 0));
+    assert(uts_pid_filter_check(&filter, 68));
+    assert(!uts_pid_filter_check(&filter, 69));
+    assert(uts_pid_filter_check(&filter, 8191));
+    uts_pid_filter_del(&filter, 8191);
+    assert(!uts_pid_filter_check(&filter, 8191));
+
+    static const uint16_t pids[NB_PACKETS] = { 68, 69, 0, 69, 68, 8191, 68 };
+    uint8_t buffer[NB_PACKETS * UTS_PID_FILTER_PACKET_SIZE];
+    fill(buffer, pids, NB_PACKETS);
+    size_t size = uts_pid_filter_compact(&filter, buffer, sizeof(buffer));
+    assert(size == 4 * UTS_PID_FILTER_PACKET_SIZE);
+    /* the selected packets are kept in order */
+    static const uint8_t kept[] = { 0, 2, 4, 6 };
+    for (int i = 0; i < 4; i++) {
+        uint8_t *packet = buffer + i * UTS_PID_FILTER_PACKET_SIZE;
+        assert(packet[0] == UTS_PID_FILTER_SYNC);
+        assert(((packet[1] << 8) | packet[2]) == pids[kept[i]]);
+        assert(packet[UTS_PID_FILTER_PACKET_SIZE - 1] == kept[i]);
+    }
+
+    /* no selected packet */
+    static const uint16_t others[2] = { 69, 100 };
+    fill(buffer, others, 2);
+    assert(!uts_pid_filter_compact(&filter, buffer,
+                                   2 * UTS_PID_FILTER_PACKET_SIZE));
+
+    /* not TS, left untouched */
+    fill(buffer, others, 2);
+    assert(uts_pid_filter_compact(&filter, buffer,
+                                  2 * UTS_PID_FILTER_PACKET_SIZE + 12) ==
+           2 * UTS_PID_FILTER_PACKET_SIZE + 12);
+    buffer[UTS_PID_FILTER_PACKET_SIZE] = 0;
+    assert(uts_pid_filter_compact(&filter, buffer,
+                                  2 * UTS_PID_FILTER_PACKET_SIZE) ==
+           2 * UTS_PID_FILTER_PACKET_SIZE);
+    assert(buffer[1] == 0 && buffer[2] == 69);
+    return 0;
+}
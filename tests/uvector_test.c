@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 EasyTools S.A.S.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/** @file
+ * @short unit tests for uvector and its helper
+ */
+
+#undef NDEBUG
+
+#include "upipe/ubase.h"
+#include "upipe/uvector.h"
+#include "upipe/uvector_helper.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define NB_ITEMS 100
+
+struct item {
+    unsigned int value;
+};
+
+struct container {
+    struct uvector items;
+};
+
+UVECTOR_HELPER(container, items, item)
+
+int main(int argc, char **argv)
+{
+    struct item items[NB_ITEMS];
+    for (unsigned int i = 0; i < NB_ITEMS; i++)
+        items[i].value = i;
+
+    struct uvector uvector;
+    uvector_init(&uvector);
+    assert(uvector_empty(&uvector));
+    assert(uvector_peek(&uvector) == NULL);
+    assert(uvector_pop(&uvector) == NULL);
+
+    /* use as a queue, wrapping around the ring */
+    for (unsigned int i = 0; i < 3; i++)
+        assert(uvector_add(&uvector, &items[i]));
+    assert(uvector_pop(&uvector) == &items[0]);
+    assert(uvector_pop(&uvector) == &items[1]);
+    for (unsigned int i = 3; i < 6; i++)
+        assert(uvector_add(&uvector, &items[i]));
+    assert(uvector_size(&uvector) == 4);
+    for (unsigned int i = 0; i < 4; i++)
+        assert(uvector_at(&uvector, i) == &items[i + 2]);
+    assert(uvector_peek_last(&uvector) == &items[5]);
+
+    /* grow while wrapped */
+    for (unsigned int i = 6; i < NB_ITEMS; i++)
+        assert(uvector_add(&uvector, &items[i]));
+    assert(uvector_size(&uvector) == NB_ITEMS - 2);
+    unsigned int index;
+    struct item *item;
+    uvector_foreach (&uvector, index, item)
+        assert(item == &items[index + 2]);
+
+    /* deletion keeps the order */
+    assert(uvector_delete(&uvector, &items[50]));
+    assert(!uvector_delete(&uvector, &items[50]));
+    uvector_delete_at(&uvector, 0);
+    assert(uvector_size(&uvector) == NB_ITEMS - 4);
+    unsigned int expected = 3;
+    while ((item = uvector_pop(&uvector)) != NULL) {
+        if (expected == 50)
+            expected++;
+        assert(item->value == expected++);
+    }
+    assert(expected == NB_ITEMS);
+    uvector_clean(&uvector);
+
+    /* helper */
+    struct container container;
+    container_init_items(&container);
+    for (unsigned int i = 0; i < NB_ITEMS; i++)
+        ubase_assert(container_add_items(&container, &items[i]));
+    assert(container_size_items(&container) == NB_ITEMS);
+    assert(container_peek_items(&container) == &items[0]);
+    assert(container_at_items(&container, 10) == &items[10]);
+    assert(container_delete_items(&container, &items[0]));
+    unsigned int count = 0;
+    uvector_helper_foreach (container, items, &container, item) {
+        assert(uvector_idx == count);
+        assert(item == &items[count + 1]);
+        count++;
+    }
+    assert(count == NB_ITEMS - 1);
+    assert(container_pop_items(&container) == &items[1]);
+    container_clean_items(&container);
+    assert(container_size_items(&container) == 0);
+    return 0;
+}